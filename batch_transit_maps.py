@@ -30,6 +30,7 @@ from typing import List, Optional
 import partridge as ptg
 
 from magga_style import MaggaStyle
+from thread_budget import available_cores
 
 SCRIPT_DIR = Path(__file__).resolve().parent
 
@@ -70,6 +71,9 @@ def run_generate_all_stops(
     workers: int = 1,
     skip_top_n: int = 0,
     flat_labels: bool = False,
+    cores: int = 0,
+    queue: Optional[str] = None,
+    stage_cache_dir: Optional[str] = None,
 ) -> int:
     out_dir.mkdir(parents=True, exist_ok=True)
     style_path = out_dir / "_profile_style.json"
@@ -119,10 +123,16 @@ def run_generate_all_stops(
         cmd.append("--all-station-labels")
     if workers > 1:
         cmd.extend(["--workers", str(workers)])
+    if cores > 0:
+        cmd.extend(["--cores", str(cores)])
     if skip_top_n > 0:
         cmd.extend(["--skip-top-n", str(skip_top_n)])
     if flat_labels:
         cmd.append("--flat-labels")
+    if queue:
+        cmd.extend(["--queue", queue])
+    if stage_cache_dir:
+        cmd.extend(["--stage-cache-dir", stage_cache_dir])
 
     print(" ".join(cmd), file=sys.stderr)
     return subprocess.call(cmd)
@@ -158,6 +168,11 @@ def cmd_stops(args: argparse.Namespace) -> int:
     workers = max(1, getattr(args, "workers", 1))
     parallel_langs = getattr(args, "parallel_langs", True)
 
+    # concurrent language batches split the core budget between them
+    cores = getattr(args, "cores", 0) or available_cores()
+    if len(runs) > 1 and parallel_langs:
+        cores = max(1, cores // len(runs))
+
     def run_one_lang(item: tuple[str, Path, bool]) -> int:
         lang, feed, indic = item
         if not feed.is_file():
@@ -183,6 +198,9 @@ def cmd_stops(args: argparse.Namespace) -> int:
                 workers=workers,
                 skip_top_n=getattr(args, "skip_top_n", 0),
                 flat_labels=getattr(args, "flat_labels", False),
+                cores=cores,
+                queue=getattr(args, "queue", None),
+                stage_cache_dir=getattr(args, "stage_cache_dir", None),
             )
             inner = inner or r
         return inner
@@ -364,6 +382,16 @@ def main() -> None:
         metavar="N",
         help="Parallel stop jobs per feed (passed to generate_all_stops). Try 4–8 on M2 Pro.",
     )
+    ps.add_argument(
+        "--cores",
+        type=int,
+        default=0,
+        metavar="N",
+        help=(
+            "CPU budget of the whole batch, split between concurrent feeds and "
+            "their stop jobs (default 0: all available cores)."
+        ),
+    )
     ps.add_argument(
         "--parallel-langs",
         action=argparse.BooleanOptionalAction,
@@ -382,6 +410,19 @@ def main() -> None:
         action="store_true",
         help="No tier split / no progressive variants (pass-through to generate_all_stops).",
     )
+    ps.add_argument(
+        "--queue",
+        metavar="DIR",
+        help=(
+            "Shard the stop jobs to workers on other nodes through the shared job "
+            "queue DIR (generate_all_stops.py --queue-worker DIR)."
+        ),
+    )
+    ps.add_argument(
+        "--stage-cache-dir",
+        metavar="DIR",
+        help="Stage cache shared by all jobs (pass-through to generate_all_stops).",
+    )
     ps.set_defaults(func=cmd_stops)
 
     pr = sub.add_parser("routes", help="process_transit_map.sh route families")
@@ -0,0 +1,32 @@
+# CMake module to search for the zstd compression library
+#
+# Once done this will define
+#
+#  ZSTD_FOUND - system has the zstd library
+#  ZSTD_INCLUDE_DIRS - the zstd include directories
+#  ZSTD_LIBRARY - Link this to use the zstd library
+
+FIND_PATH(ZSTD_INCLUDE_DIR
+  zstd.h
+  "$ENV{LIB_DIR}/include"
+  "$ENV{INCLUDE}"
+  /usr/local/include
+  /usr/include
+)
+
+FIND_LIBRARY(ZSTD_LIBRARY NAMES zstd PATHS "$ENV{LIB_DIR}/lib" "$ENV{LIB}" /usr/local/lib /usr/lib )
+
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(Zstd DEFAULT_MSG
+                                  ZSTD_LIBRARY ZSTD_INCLUDE_DIR)
+
+SET(ZSTD_INCLUDE_DIRS ${ZSTD_INCLUDE_DIR})
+MARK_AS_ADVANCED(ZSTD_LIBRARY ZSTD_INCLUDE_DIR ZSTD_INCLUDE_DIRS)
+
+IF (ZSTD_FOUND)
+  MESSAGE(STATUS "Found zstd: ${ZSTD_LIBRARY}")
+ELSE (ZSTD_FOUND)
+  SET(ZSTD_LIBRARY "")
+  SET(ZSTD_INCLUDE_DIR "")
+  MESSAGE(STATUS "Could not find zstd")
+ENDIF (ZSTD_FOUND)
@@ -15,6 +15,7 @@ import hashlib
 import json
 import os
 from typing import List, Optional
+import shlex
 import shutil
 import subprocess
 import sys
@@ -36,6 +37,8 @@ from stop_importance import (
     get_hf_corridor_routes,
     terminus_stop_ids,
 )
+from thread_budget import job_threads, stage_threads, thread_env, threads_flag
+import work_queue
 from svg_layers import add_svg_layers, apply_progressive_hiding, compose_with_backdrop
 from stop_groups import build_stop_name_groups, sort_groups_rare_first
 
@@ -60,6 +63,11 @@ def build_tier_data_from_frame(
 STOP_IMPORTANCE_CSV = "_stop_importance.csv"
 STOP_IMPORTANCE_CACHE_META = "_stop_importance.cache.json"
 
+# share of the pipeline timeout after which topo, loom and octi stop
+# optimizing and write their best result so far, so slow maps still render
+# instead of being killed at the timeout
+DEADLINE_SHARE = 0.8
+
 
 def build_importance_cache_key(gtfs_path: Path, style: MaggaStyle) -> dict:
     """Fingerprint for when _stop_importance.csv is still valid."""
@@ -128,6 +136,9 @@ def run_pipeline(
     tool_dir: str = "",
     timeout_sec: int = 300,
     loom_extra: str = "",
+    tm_extra: str = "",
+    octi_extra: str = "",
+    drawing_only: bool = False,
 ) -> bool:
     """Run the C++ pipeline to generate a single SVG map.
 
@@ -139,25 +150,91 @@ def run_pipeline(
         tool_dir: Directory containing C++ tools (prepended to PATH).
         timeout_sec: Subprocess wall-clock limit (large HF backdrops need more).
         loom_extra: Extra CLI args for loom (e.g. "--ilp-time-limit 900").
+        tm_extra: Extra CLI args for transitmap (e.g. "--emit-display-list f").
+        octi_extra: Extra CLI args for octi (e.g. "--prev-drawing f").
+        drawing_only: If True, stop after octi and write its schematic
+            drawing (JSON) to output_svg instead of rendering it.
 
     Returns:
         True if pipeline succeeded, False otherwise.
     """
-    env = os.environ.copy()
-    if tool_dir:
-        env["PATH"] = f"{tool_dir}:{env.get('PATH', '')}"
+    env = _tool_env(tool_dir)
 
     topo_flags = style.to_topo_flags()
-    tm_flags = style.to_transitmap_flags()
+    tm_flags = f"{style.to_transitmap_flags()} {tm_extra}".strip()
     g2g_flags = style.to_gtfs2graph_flags()
 
+    # thread budget of this job, set by main() when running parallel workers
+    t = threads_flag(stage_threads())
+    if t:
+        g2g_flags = f"{t} {g2g_flags}"
+        topo_flags = f"{t} {topo_flags}"
+        tm_flags = f"{t} {tm_flags}"
+        loom_extra = f"{t} {loom_extra}"
+
+    octi_flags = f"{t} {octi_extra}".strip()
+
+    # same variable as process_transit_map.sh
+    cache_dir = os.environ.get("STAGE_CACHE_DIR")
+    if cache_dir:
+        cache = f"--stage-cache-dir {shlex.quote(cache_dir)}"
+        topo_flags = f"{cache} {topo_flags}"
+        loom_extra = f"{cache} {loom_extra}"
+        octi_flags = f"{cache} {octi_flags}"
+
+    if timeout_sec > 0:
+        deadline = f"--deadline {timeout_sec * DEADLINE_SHARE:g}"
+        topo_flags = f"{deadline} {topo_flags}"
+        loom_extra = f"{deadline} {loom_extra}"
+        octi_flags = f"{deadline} {octi_flags}"
+
     loom_part = f"loom {loom_extra}".strip() if loom_extra.strip() else "loom"
+    octi_part = f"octi {octi_flags}".strip()
 
-    if schematic:
-        cmd = f"gtfs2graph {g2g_flags} {gtfs_zip} | topo {topo_flags} | {loom_part} | octi | transitmap {tm_flags}"
+    if drawing_only:
+        cmd = f"gtfs2graph {g2g_flags} {gtfs_zip} | topo {topo_flags} | {loom_part} | {octi_part}"
+    elif schematic:
+        cmd = f"gtfs2graph {g2g_flags} {gtfs_zip} | topo {topo_flags} | {loom_part} | {octi_part} | transitmap {tm_flags}"
     else:
         cmd = f"gtfs2graph {g2g_flags} {gtfs_zip} | topo {topo_flags} | {loom_part} | transitmap {tm_flags}"
 
+    return _run_to_file(cmd, output_svg, env, timeout_sec)
+
+
+def render_with_backdrop(
+    display_list: str,
+    backdrop_list: str,
+    output_svg: str,
+    style: MaggaStyle,
+    tool_dir: str = "",
+    timeout_sec: int = 300,
+) -> bool:
+    """Re-render a map from its display list over a shared backdrop.
+
+    Only transitmap runs: both display lists are already prepared, and
+    transitmap writes just the backdrop parts within the map's viewport, as
+    the ``layer-backdrop`` group at ``style.backdrop_opacity``.
+
+    Returns:
+        True if rendering succeeded, False otherwise.
+    """
+    t = threads_flag(stage_threads())
+    cmd = (
+        f"transitmap {t} {style.to_transitmap_flags()} "
+        f"--from-display-list {display_list} --backdrop {backdrop_list} "
+        f"--backdrop-opacity {style.backdrop_opacity}"
+    )
+    return _run_to_file(cmd, output_svg, _tool_env(tool_dir), timeout_sec)
+
+
+def _tool_env(tool_dir: str) -> dict:
+    env = os.environ.copy()
+    if tool_dir:
+        env["PATH"] = f"{tool_dir}:{env.get('PATH', '')}"
+    return env
+
+
+def _run_to_file(cmd: str, output_svg: str, env: dict, timeout_sec: int) -> bool:
     try:
         result = subprocess.run(
             cmd,
@@ -184,6 +261,34 @@ def run_pipeline(
         return False
 
 
+def generate_shared_drawing(
+    gtfs_path: str,
+    output_dir: Path,
+    style: MaggaStyle,
+    tool_dir: str,
+) -> Optional[Path]:
+    """Draw the schematic of the full network once.
+
+    The schematic stop maps pass it to octi with --prev-subset, which keeps
+    its positions and routes for the lines of the stop.
+    """
+    print("Drawing the full network schematic...", file=sys.stderr)
+    path = output_dir / "_full_schematic.json"
+    if not run_pipeline(
+        gtfs_path,
+        str(path),
+        style,
+        schematic=True,
+        tool_dir=tool_dir,
+        timeout_sec=7200,
+        drawing_only=True,
+    ):
+        print("  Full network schematic failed, drawing every map on its own",
+              file=sys.stderr)
+        return None
+    return path
+
+
 def generate_hf_backdrop(
     gtfs_path: str,
     output_dir: Path,
@@ -194,7 +299,8 @@ def generate_hf_backdrop(
 ) -> dict:
     """Generate the shared HF corridor backdrop SVGs.
 
-    Returns dict with keys 'geographic' and/or 'schematic' mapping to paths.
+    Returns dict with keys 'geographic' and/or 'schematic' mapping to paths,
+    and 'geographic_display_list' mapping to the prepared geographic backdrop.
     """
     print("Generating HF corridor backdrop...", file=sys.stderr)
     feed = ptg.load_feed(gtfs_path)
@@ -234,6 +340,9 @@ def generate_hf_backdrop(
 
     if geographic:
         geo_path = str(output_dir / "_hf_corridor_geographic.svg")
+        # geographic maps share the coordinates of the feed, so the prepared
+        # backdrop can be drawn under every stop map by transitmap directly
+        geo_dl = str(output_dir / "_hf_corridor_geographic.tmdl")
         if run_pipeline(
             hf_subset_path,
             geo_path,
@@ -242,8 +351,10 @@ def generate_hf_backdrop(
             tool_dir=tool_dir,
             timeout_sec=hf_timeout,
             loom_extra=hf_loom,
+            tm_extra=f"--emit-display-list {geo_dl}",
         ):
             results["geographic"] = Path(geo_path)
+            results["geographic_display_list"] = Path(geo_dl)
             print(f"  Created {geo_path}", file=sys.stderr)
 
     if schematic:
@@ -282,6 +393,7 @@ def process_single_stop(
     all_station_labels: bool = False,
     flat_labels: bool = False,
     gtfs_analyzer: Optional[GTFSAnalyzer] = None,
+    native_tiers: bool = False,
 ) -> bool:
     """Generate all map variants for one focal stop or a merged same-name group.
 
@@ -289,6 +401,10 @@ def process_single_stop(
     trips serving any of them). Defaults to ``[stop_id]``. Tier distances use
     the nearest of these focal stops.
 
+    ``native_tiers`` — transitmap assigns the label tiers itself from the
+    station counts in the graph (see ``MaggaStyle.to_tier_flags``), instead of
+    ``tier_data``. The route counts are those of the subset.
+
     Returns True if at least one map was generated successfully (or skipped).
     """
     focal_ids = [str(x) for x in (focal_stop_ids if focal_stop_ids is not None else [stop_id])]
@@ -331,8 +447,32 @@ def process_single_stop(
         raw_svg = str(stop_dir / f"_{map_name}_raw.svg")
         layered_svg = str(stop_dir / f"{map_name}.svg")
 
+        # A prepared backdrop is composited by transitmap from this map's
+        # display list, otherwise the backdrop SVG is merged in afterwards
+        backdrop_dl = backdrop_paths.get(f"{map_name}_display_list")
+        if not (backdrop_dl and backdrop_dl.exists()):
+            backdrop_dl = None
+        map_dl = str(stop_dir / f"_{map_name}.tmdl")
+        tm_extra = f"--emit-display-list {map_dl}" if backdrop_dl else ""
+        if native_tiers and not (all_station_labels or flat_labels):
+            tm_extra = f"{tm_extra} {style.to_tier_flags(focal_ids)}".strip()
+
+        # schematic maps of subsets keep the shared drawing of the network
+        octi_extra = ""
+        drawing = backdrop_paths.get("schematic_drawing")
+        if is_schematic and drawing and drawing.exists():
+            octi_extra = f"--prev-drawing {drawing} --prev-subset"
+
         # Run C++ pipeline
-        if not run_pipeline(subset_path, raw_svg, style, schematic=is_schematic, tool_dir=tool_dir):
+        if not run_pipeline(
+            subset_path,
+            raw_svg,
+            style,
+            schematic=is_schematic,
+            tool_dir=tool_dir,
+            tm_extra=tm_extra,
+            octi_extra=octi_extra,
+        ):
             continue
 
         # Apply text shrink
@@ -361,7 +501,7 @@ def process_single_stop(
         success = True
 
         # Generate progressive hiding variants (needs tier split)
-        if progressive and tier_data and not flat_labels:
+        if progressive and (tier_data or native_tiers) and not flat_labels:
             try:
                 apply_progressive_hiding(layered_svg, stop_dir, base_name=map_name)
             except Exception as e:
@@ -369,7 +509,29 @@ def process_single_stop(
 
         # Compose with backdrop
         backdrop_svg = backdrop_paths.get(map_name)
-        if backdrop_svg and backdrop_svg.exists():
+        if backdrop_dl:
+            composed_path = str(stop_dir / f"{map_name}_with_backdrop.svg")
+            bd_raw = str(stop_dir / f"_{map_name}_backdrop_raw.svg")
+            if render_with_backdrop(map_dl, str(backdrop_dl), bd_raw, style, tool_dir):
+                try:
+                    adjust_svg_text_sizes(bd_raw, bd_raw, style.text_shrink)
+                    add_svg_layers(
+                        bd_raw,
+                        composed_path,
+                        tier_data=tier_data,
+                        style=style,
+                        default_unmatched_station_tier=(
+                            1 if (all_station_labels or flat_labels) else 4
+                        ),
+                    )
+                except Exception as e:
+                    print(f"  Backdrop composition failed for {stop_id}/{map_name}: {e}", file=sys.stderr)
+            for tmp in [bd_raw, map_dl]:
+                try:
+                    os.remove(tmp)
+                except OSError:
+                    pass
+        elif backdrop_svg and backdrop_svg.exists():
             composed_path = str(stop_dir / f"{map_name}_with_backdrop.svg")
             try:
                 compose_with_backdrop(layered_svg, str(backdrop_svg), composed_path, style)
@@ -434,19 +596,20 @@ def _parallel_process_job(payload: dict) -> tuple[int, str, bool]:
     importance_df = pd.read_csv(payload["importance_csv"], dtype={"stop_id": str})
     focal = payload.get("focal_stop_ids")
     sid = str(payload["stop_id"])
-    distance_df = compute_distances_from(
-        importance_df, focal if focal is not None else [sid]
-    )
-    tier_df = assign_tiers(importance_df, distance_df, style)
-    terminus_ids_w: set = set()
-    tp = payload.get("terminus_path")
-    if tp and Path(tp).is_file():
-        terminus_ids_w = set(Path(tp).read_text().split())
-    if payload.get("terminus_on", True) and terminus_ids_w:
-        tier_df = apply_terminus_tier_override(tier_df, terminus_ids_w)
-    if payload.get("flat_labels"):
+    native_tiers = payload.get("native_tiers", False)
+    if native_tiers or payload.get("flat_labels"):
         tier_data = None
     else:
+        distance_df = compute_distances_from(
+            importance_df, focal if focal is not None else [sid]
+        )
+        tier_df = assign_tiers(importance_df, distance_df, style)
+        terminus_ids_w: set = set()
+        tp = payload.get("terminus_path")
+        if tp and Path(tp).is_file():
+            terminus_ids_w = set(Path(tp).read_text().split())
+        if payload.get("terminus_on", True) and terminus_ids_w:
+            tier_df = apply_terminus_tier_override(tier_df, terminus_ids_w)
         tier_data = build_tier_data_from_frame(
             tier_df, all_station_labels=payload["all_station_labels"]
         )
@@ -474,10 +637,117 @@ def _parallel_process_job(payload: dict) -> tuple[int, str, bool]:
         all_station_labels=payload["all_station_labels"],
         flat_labels=payload.get("flat_labels", False),
         gtfs_analyzer=_WORKER_SHARED_ANALYZER,
+        native_tiers=native_tiers,
     )
     return (int(payload["index"]), str(payload["label"]), ok)
 
 
+def _run_parallel_jobs(
+    jobs: List[dict], total: int, args: argparse.Namespace, gtfs_path: Path
+) -> int:
+    """Run the job payloads in a local process pool, or through the job queue
+    with ``--queue``. Returns the number of successful jobs."""
+    success_count = 0
+
+    def report(j: dict, ok: bool) -> None:
+        nonlocal success_count
+        if ok:
+            success_count += 1
+            print(f"\n[{j['index']}/{total}] {j['label']}  Done.", file=sys.stderr)
+        else:
+            print(f"\n[{j['index']}/{total}] {j['label']}  Failed.", file=sys.stderr)
+
+    if args.queue:
+        # ids are unique per output directory, so several batches can share
+        # one queue and one pool of workers
+        run = hashlib.sha1(str(Path(args.output_dir).resolve()).encode()).hexdigest()
+        by_id = {f"{run[:12]}-{j['index']:06d}": j for j in jobs}
+        work_queue.submit(
+            Path(args.queue), by_id.items(), max_attempts=args.queue_attempts
+        )
+        print(
+            f"  Queued {len(by_id)} jobs, waiting for workers "
+            f"(generate_all_stops.py --queue-worker {args.queue})",
+            file=sys.stderr,
+        )
+
+        def on_result(job_id: str, r: dict) -> None:
+            if not r.get("ok") and r.get("error"):
+                print(
+                    f"\n  Worker error ({by_id[job_id]['label']}): {r['error']}",
+                    file=sys.stderr,
+                )
+            report(by_id[job_id], bool(r.get("ok")))
+
+        work_queue.wait(
+            Path(args.queue), list(by_id), on_result=on_result,
+            lease_sec=args.queue_lease,
+        )
+        return success_count
+
+    with ProcessPoolExecutor(
+        max_workers=args.workers,
+        initializer=_parallel_pool_init,
+        initargs=(str(gtfs_path),),
+    ) as ex:
+        futures = {ex.submit(_parallel_process_job, j): j for j in jobs}
+        for fut in as_completed(futures):
+            j = futures[fut]
+            try:
+                _, _, ok = fut.result()
+            except Exception as e:
+                print(
+                    f"\n  Worker error ({j.get('label', '?')}): {e}",
+                    file=sys.stderr,
+                )
+                ok = False
+            report(j, ok)
+    return success_count
+
+
+_WORKER_GTFS_PATH: Optional[str] = None
+
+
+def _queue_job(payload: dict) -> tuple[bool, dict]:
+    """Run a queued job on this node (``run_worker`` handler)."""
+    global _WORKER_GTFS_PATH
+    if payload["gtfs_path"] != _WORKER_GTFS_PATH:
+        _parallel_pool_init(payload["gtfs_path"])
+        _WORKER_GTFS_PATH = payload["gtfs_path"]
+    # the tools may live elsewhere on this node
+    payload = dict(payload, tool_dir=find_pipeline_tools())
+    _, label, ok = _parallel_process_job(payload)
+    return ok, {"label": label}
+
+
+def _queue_worker_loop(queue: str, idle_sec: float, lease_sec: float) -> int:
+    return work_queue.run_worker(
+        Path(queue),
+        _queue_job,
+        idle_sec=idle_sec,
+        lease_sec=lease_sec,
+        log=lambda s: print(f"  {s}", file=sys.stderr),
+    )
+
+
+def run_queue_workers(args: argparse.Namespace) -> int:
+    """Serve the job queue with ``--workers`` local worker processes."""
+    print(
+        f"Serving job queue {args.queue_worker} with {args.workers} worker(s)",
+        file=sys.stderr,
+    )
+    loop_args = (args.queue_worker, args.queue_idle_exit, args.queue_lease)
+    if args.workers == 1:
+        n = _queue_worker_loop(*loop_args)
+    else:
+        with ProcessPoolExecutor(max_workers=args.workers) as ex:
+            futs = [ex.submit(_queue_worker_loop, *loop_args)
+                    for _ in range(args.workers)]
+            n = sum(f.result() for f in futs)
+    print(f"Queue idle, ran {n} jobs", file=sys.stderr)
+    return 0
+
+
 def _backdrop_paths_payload(backdrop_paths: dict) -> dict:
     return {k: (str(v) if v else None) for k, v in backdrop_paths.items()}
 
@@ -516,7 +786,9 @@ Produces geographic and/or schematic SVGs with:
         formatter_class=argparse.RawDescriptionHelpFormatter,
     )
 
-    parser.add_argument("gtfs_file", help="Path to input GTFS zip file")
+    parser.add_argument(
+        "gtfs_file", nargs="?", help="Path to input GTFS zip file"
+    )
 
     # Output
     out_group = parser.add_argument_group("output")
@@ -596,6 +868,14 @@ Produces geographic and/or schematic SVGs with:
         "--schematic-only", action="store_true",
         help="Skip geographic maps",
     )
+    feat_group.add_argument(
+        "--shared-schematic", action="store_true",
+        help=(
+            "Draw the schematic of the full network once and derive the "
+            "schematic stop maps from it (faster, and overlapping maps look "
+            "alike)"
+        ),
+    )
     feat_group.add_argument(
         "--indic-font-fallback",
         action="store_true",
@@ -621,6 +901,25 @@ Produces geographic and/or schematic SVGs with:
             "Useful on multi-core machines; default 1 keeps memory lower."
         ),
     )
+    feat_group.add_argument(
+        "--cores",
+        type=int,
+        default=0,
+        metavar="N",
+        help=(
+            "CPU budget shared by all workers; each pipeline gets N / --workers "
+            "threads (default 0: all available cores)."
+        ),
+    )
+    feat_group.add_argument(
+        "--native-tiers",
+        action="store_true",
+        help=(
+            "Let transitmap assign the label tiers from the station trip and "
+            "route counts of the graph, and skip tier 4 labels, instead of "
+            "computing the tiers here. Route counts are those of the subset."
+        ),
+    )
     feat_group.add_argument(
         "--flat-labels",
         action="store_true",
@@ -652,6 +951,60 @@ Produces geographic and/or schematic SVGs with:
         ),
     )
 
+    dist_group = parser.add_argument_group(
+        "distributed runs",
+        "All nodes need the feed, the output directory, the queue and the stage "
+        "cache at the same paths, e.g. on a shared mount.",
+    )
+    dist_group.add_argument(
+        "--queue",
+        metavar="DIR",
+        help=(
+            "Put the stop jobs into the shared job queue DIR instead of running "
+            "them locally, and wait for --queue-worker nodes to run them"
+        ),
+    )
+    dist_group.add_argument(
+        "--queue-worker",
+        metavar="DIR",
+        help=(
+            "Run jobs from the job queue DIR with --workers processes until it "
+            "has been idle for --queue-idle-exit seconds (no GTFS file needed)"
+        ),
+    )
+    dist_group.add_argument(
+        "--queue-attempts",
+        type=int,
+        default=work_queue.MAX_ATTEMPTS,
+        metavar="N",
+        help=f"Runs of a failing job before it counts as failed (default {work_queue.MAX_ATTEMPTS})",
+    )
+    dist_group.add_argument(
+        "--queue-lease",
+        type=float,
+        default=work_queue.LEASE_SEC,
+        metavar="SEC",
+        help=(
+            "Jobs of workers silent for SEC seconds are run again elsewhere "
+            f"(default {work_queue.LEASE_SEC:g})"
+        ),
+    )
+    dist_group.add_argument(
+        "--queue-idle-exit",
+        type=float,
+        default=300.0,
+        metavar="SEC",
+        help="Workers exit after SEC seconds without jobs, 0 never (default 300)",
+    )
+    dist_group.add_argument(
+        "--stage-cache-dir",
+        metavar="DIR",
+        help=(
+            "Reuse topo, loom and octi outputs of identical runs from DIR "
+            "(default $STAGE_CACHE_DIR); share it between the workers"
+        ),
+    )
+
     parser.epilog = """
 examples:
   # Generate maps for all stops
@@ -669,6 +1022,10 @@ examples:
   # Save default style for editing
   %(prog)s city_transit.zip --save-style -n 1
 
+  # Distribute the stops over several nodes sharing /mnt/batch
+  %(prog)s city_transit.zip -o /mnt/batch/out --queue /mnt/batch/queue
+  %(prog)s --queue-worker /mnt/batch/queue --workers 8   # on every node
+
 notes:
   - C++ tools (gtfs2graph, topo, loom, octi, transitmap) must be built first
   - SVG layers are Inkscape-compatible (Edit → Layers panel)
@@ -688,6 +1045,29 @@ For more information: https://github.com/pvnkmrksk/magga
         print("Error: --workers must be >= 1", file=sys.stderr)
         sys.exit(1)
 
+    if args.queue and args.queue_worker:
+        print("Error: use only one of --queue and --queue-worker", file=sys.stderr)
+        sys.exit(1)
+    if args.queue_attempts < 1:
+        print("Error: --queue-attempts must be >= 1", file=sys.stderr)
+        sys.exit(1)
+    if args.queue_lease <= 0:
+        print("Error: --queue-lease must be > 0", file=sys.stderr)
+        sys.exit(1)
+
+    # Child pipelines inherit the environment, so each job stays within its
+    # share of the cores instead of every stage using all of them
+    if args.workers > 1 or args.cores > 0:
+        os.environ.update(thread_env(job_threads(args.workers, args.cores)))
+    if args.stage_cache_dir:
+        os.environ["STAGE_CACHE_DIR"] = str(Path(args.stage_cache_dir).resolve())
+
+    if args.queue_worker:
+        sys.exit(run_queue_workers(args))
+
+    if not args.gtfs_file:
+        parser.error("the following arguments are required: gtfs_file")
+
     # Validate input
     if not Path(args.gtfs_file).exists():
         print(f"Error: {args.gtfs_file} not found", file=sys.stderr)
@@ -874,20 +1254,28 @@ For more information: https://github.com/pvnkmrksk/magga
             schematic=do_schematic,
         )
 
+    if args.shared_schematic and do_schematic:
+        drawing = generate_shared_drawing(args.gtfs_file, output_dir, style, tool_dir)
+        if drawing:
+            backdrop_paths["schematic_drawing"] = drawing
+
     worker_style_path: Optional[str] = None
-    if args.workers > 1:
+    if args.workers > 1 or args.queue:
         if args.style and Path(args.style).exists():
             worker_style_path = str(Path(args.style).resolve())
         else:
             worker_style_path = str(output_dir / "_worker_style.json")
             style.save(worker_style_path)
-        print(f"  Parallel workers: {args.workers}", file=sys.stderr)
+        if args.queue:
+            print(f"  Job queue: {args.queue}", file=sys.stderr)
+        else:
+            print(f"  Parallel workers: {args.workers}", file=sys.stderr)
 
     # Process each stop or merged group
     success_count = 0
     if merge_groups is not None:
         total = len(merge_groups)
-        if args.workers > 1 and worker_style_path is not None:
+        if worker_style_path is not None:
             jobs = []
             for i, grp in enumerate(merge_groups, 1):
                 jobs.append(
@@ -909,6 +1297,7 @@ For more information: https://github.com/pvnkmrksk/magga
                         "indic_font_fallback": args.indic_font_fallback,
                         "all_station_labels": use_all_labels,
                         "flat_labels": flat_labels,
+                        "native_tiers": args.native_tiers,
                         "terminus_path": str(terminus_path.resolve()),
                         "terminus_on": terminus_on,
                         "stop_id": grp.rep_stop_id,
@@ -916,27 +1305,7 @@ For more information: https://github.com/pvnkmrksk/magga
                         "focal_stop_ids": grp.stop_ids,
                     }
                 )
-            with ProcessPoolExecutor(
-                max_workers=args.workers,
-                initializer=_parallel_pool_init,
-                initargs=(str(gtfs_path),),
-            ) as ex:
-                futures = {ex.submit(_parallel_process_job, j): j for j in jobs}
-                for fut in as_completed(futures):
-                    j = futures[fut]
-                    try:
-                        idx, label, ok = fut.result()
-                    except Exception as e:
-                        print(
-                            f"\n  Worker error ({j.get('label', '?')}): {e}",
-                            file=sys.stderr,
-                        )
-                        ok = False
-                    if ok:
-                        success_count += 1
-                        print(f"\n[{idx}/{total}] {label}  Done.", file=sys.stderr)
-                    else:
-                        print(f"\n[{idx}/{total}] {label}  Failed.", file=sys.stderr)
+            success_count += _run_parallel_jobs(jobs, total, args, gtfs_path)
         else:
             for i, grp in enumerate(merge_groups, 1):
                 print(
@@ -944,16 +1313,18 @@ For more information: https://github.com/pvnkmrksk/magga
                     f"({len(grp.stop_ids)} stops, min_trips={grp.min_trip_count})",
                     file=sys.stderr,
                 )
-                distance_df = compute_distances_from(importance_df, grp.stop_ids)
-                tier_data = _tier_data_for_maps(
-                    importance_df,
-                    distance_df,
-                    style,
-                    all_station_labels=use_all_labels,
-                    flat_labels=flat_labels,
-                    terminus_on=terminus_on,
-                    terminus_ids=terminus_ids,
-                )
+                tier_data = None
+                if not args.native_tiers:
+                    distance_df = compute_distances_from(importance_df, grp.stop_ids)
+                    tier_data = _tier_data_for_maps(
+                        importance_df,
+                        distance_df,
+                        style,
+                        all_station_labels=use_all_labels,
+                        flat_labels=flat_labels,
+                        terminus_on=terminus_on,
+                        terminus_ids=terminus_ids,
+                    )
 
                 ok = process_single_stop(
                     gtfs_path=args.gtfs_file,
@@ -973,6 +1344,7 @@ For more information: https://github.com/pvnkmrksk/magga
                     indic_font_fallback=args.indic_font_fallback,
                     all_station_labels=use_all_labels,
                     flat_labels=flat_labels,
+                    native_tiers=args.native_tiers,
                 )
                 if ok:
                     success_count += 1
@@ -985,7 +1357,7 @@ For more information: https://github.com/pvnkmrksk/magga
         )
     else:
         total = len(stops_to_process)
-        if args.workers > 1 and worker_style_path is not None:
+        if worker_style_path is not None:
             jobs = []
             for i, (idx, row) in enumerate(stops_to_process.iterrows(), 1):
                 stop_id = str(row["stop_id"])
@@ -1008,6 +1380,7 @@ For more information: https://github.com/pvnkmrksk/magga
                         "indic_font_fallback": args.indic_font_fallback,
                         "all_station_labels": use_all_labels,
                         "flat_labels": flat_labels,
+                        "native_tiers": args.native_tiers,
                         "terminus_path": str(terminus_path.resolve()),
                         "terminus_on": terminus_on,
                         "stop_id": stop_id,
@@ -1015,43 +1388,25 @@ For more information: https://github.com/pvnkmrksk/magga
                         "focal_stop_ids": None,
                     }
                 )
-            with ProcessPoolExecutor(
-                max_workers=args.workers,
-                initializer=_parallel_pool_init,
-                initargs=(str(gtfs_path),),
-            ) as ex:
-                futures = {ex.submit(_parallel_process_job, j): j for j in jobs}
-                for fut in as_completed(futures):
-                    j = futures[fut]
-                    try:
-                        idx, label, ok = fut.result()
-                    except Exception as e:
-                        print(
-                            f"\n  Worker error ({j.get('label', '?')}): {e}",
-                            file=sys.stderr,
-                        )
-                        ok = False
-                    if ok:
-                        success_count += 1
-                        print(f"\n[{idx}/{total}] {label}  Done.", file=sys.stderr)
-                    else:
-                        print(f"\n[{idx}/{total}] {label}  Failed.", file=sys.stderr)
+            success_count += _run_parallel_jobs(jobs, total, args, gtfs_path)
         else:
             for i, (idx, row) in enumerate(stops_to_process.iterrows(), 1):
                 stop_id = str(row["stop_id"])
                 stop_name = row["stop_name"]
                 print(f"\n[{i}/{total}] {stop_name} ({stop_id})", file=sys.stderr)
 
-                distance_df = compute_distances_from(importance_df, [stop_id])
-                tier_data = _tier_data_for_maps(
-                    importance_df,
-                    distance_df,
-                    style,
-                    all_station_labels=use_all_labels,
-                    flat_labels=flat_labels,
-                    terminus_on=terminus_on,
-                    terminus_ids=terminus_ids,
-                )
+                tier_data = None
+                if not args.native_tiers:
+                    distance_df = compute_distances_from(importance_df, [stop_id])
+                    tier_data = _tier_data_for_maps(
+                        importance_df,
+                        distance_df,
+                        style,
+                        all_station_labels=use_all_labels,
+                        flat_labels=flat_labels,
+                        terminus_on=terminus_on,
+                        terminus_ids=terminus_ids,
+                    )
 
                 ok = process_single_stop(
                     gtfs_path=args.gtfs_file,
@@ -1070,6 +1425,7 @@ For more information: https://github.com/pvnkmrksk/magga
                     indic_font_fallback=args.indic_font_fallback,
                     all_station_labels=use_all_labels,
                     flat_labels=flat_labels,
+                    native_tiers=args.native_tiers,
                 )
 
                 if ok:
@@ -6,6 +6,7 @@ License: GPL-3.0 — see LICENSE file.
 """
 
 import json
+import shlex
 from dataclasses import dataclass, field, asdict
 from pathlib import Path
 from typing import List, Optional, Union
@@ -89,6 +90,20 @@ class MaggaStyle:
             f"--labels --tight-stations --render-dir-markers"
         )
 
+    def to_tier_flags(self, focal_stop_ids: List[str]) -> str:
+        """transitmap flags computing the label tiers around the focal stops.
+
+        transitmap then assigns the tiers of :func:`stop_importance.assign_tiers`
+        from the station trip and route counts in the graph, drops tier 4
+        labels and marks each label with its tier (``data-tier``).
+        """
+        d1, d2, d3 = self.tier_distances
+        return (
+            f"--focus-stations {shlex.quote(','.join(focal_stop_ids))} "
+            f"--tier-distances {d1},{d2},{d3} "
+            f"--tier-min-routes {self.tier2_min_routes},{self.tier3_min_routes}"
+        )
+
     def to_topo_flags(self) -> str:
         """Generate command-line flags for the C++ topo tool."""
         return f"--smooth {self.smoothing} -d {self.max_aggr_dist}"
@@ -67,17 +67,8 @@ print_output_tree() {
     echo "├── Intermediate Files:"
     echo "│   └── ${basename}_loom.json"
     echo "└── Final Maps:"
-    if [ "$DEBUG" = true ]; then
-        echo "    ├── Geographic Maps:"
-        echo "    │   ├── ${basename}_geographic.svg"
-        echo "    │   └── ${basename}_geographic_adjusted.svg"
-        echo "    └── Schematic Maps:"
-        echo "        ├── ${basename}_schematic.svg"
-        echo "        └── ${basename}_schematic_adjusted.svg"
-    else
-        echo "    ├── ${basename}_geographic.svg"
-        echo "    └── ${basename}_schematic.svg"
-    fi
+    echo "    ├── ${basename}_geographic.svg"
+    echo "    └── ${basename}_schematic.svg"
 }
 
 # @description Print usage information and help text
@@ -120,6 +111,7 @@ Options:
   Loom (line arrangement):
     -lt, --loom-time-limit <s> Seconds for loom ILP (--ilp-time-limit). Omit for
                               unbounded (can take a very long time on large feeds).
+                              The ILP is then warm-started (--ilp-warm-start).
 
 Examples:
     # Basic usage with default settings
@@ -150,7 +142,21 @@ Notes:
       limit by default; use -lt 600 or filter to a smaller GTFS subset
     - Python: subset step uses \$MAGGA_PYTHON if set, else python3 (needs partridge).
       Example: export MAGGA_PYTHON=\$PWD/.venv/bin/python
-    - Kannada/Indic labels: final SVGs get a Noto-first font fix for station names.
+    - Loom reuses component orderings from \$LOOM_CACHE_DIR if set (--cache-dir),
+      which speeds up repeated runs on overlapping subsets of the same feed.
+    - topo, loom and octi reuse their complete output from \$STAGE_CACHE_DIR if
+      set (--stage-cache-dir) when input and arguments are unchanged.
+    - topo and octi reuse the results of unchanged components from
+      \$COMP_CACHE_DIR if set (--comp-cache-dir), so reruns after a small
+      feed change only recompute the components it touches.
+    - If \$COMPRESS is set to gzip or zstd, the intermediate loom JSON is
+      written compressed (--compress), the tools read it either way.
+    - If \$TRACE_DIR is set, every tool writes a Chrome trace there (--trace),
+      merged into \$TRACE_DIR/trace.json (open in https://ui.perfetto.dev).
+    - If \$METRICS_DIR is set, every tool writes its per-phase wall time, CPU
+      time and peak memory there as JSON (--metrics-out).
+    - Kannada/Indic labels: transitmap writes station labels with a Noto-first
+      font stack, text sizes are scaled by transitmap itself.
 
     https://github.com/pvnkmrksk/magga
 EOF
@@ -280,7 +286,55 @@ PYTHON_CMD="${MAGGA_PYTHON:-python3}"
 
 LOOM_EXTRA_ARGS=""
 if [ -n "$LOOM_TIME_LIMIT" ]; then
-    LOOM_EXTRA_ARGS="--ilp-time-limit $LOOM_TIME_LIMIT"
+    LOOM_EXTRA_ARGS="--ilp-time-limit $LOOM_TIME_LIMIT --ilp-warm-start"
+fi
+if [ -n "$LOOM_CACHE_DIR" ]; then
+    LOOM_EXTRA_ARGS="$LOOM_EXTRA_ARGS --cache-dir $LOOM_CACHE_DIR"
+fi
+TOPO_EXTRA_ARGS=""
+OCTI_EXTRA_ARGS=""
+if [ -n "$STAGE_CACHE_DIR" ]; then
+    TOPO_EXTRA_ARGS="--stage-cache-dir $STAGE_CACHE_DIR"
+    LOOM_EXTRA_ARGS="$LOOM_EXTRA_ARGS --stage-cache-dir $STAGE_CACHE_DIR"
+    OCTI_EXTRA_ARGS="--stage-cache-dir $STAGE_CACHE_DIR"
+fi
+if [ -n "$COMP_CACHE_DIR" ]; then
+    TOPO_EXTRA_ARGS="$TOPO_EXTRA_ARGS --comp-cache-dir $COMP_CACHE_DIR"
+    OCTI_EXTRA_ARGS="$OCTI_EXTRA_ARGS --comp-cache-dir $COMP_CACHE_DIR"
+fi
+
+LOOM_JSON_EXT=""
+case "$COMPRESS" in
+    "") ;;
+    gzip) LOOM_JSON_EXT=".gz" ;;
+    zstd) LOOM_JSON_EXT=".zst" ;;
+    *) log_error "Unknown COMPRESS=$COMPRESS, must be gzip or zstd"; exit 1 ;;
+esac
+if [ -n "$COMPRESS" ]; then
+    LOOM_EXTRA_ARGS="$LOOM_EXTRA_ARGS --compress $COMPRESS"
+fi
+
+GTFS2GRAPH_EXTRA_ARGS=""
+GEO_TRANSITMAP_EXTRA_ARGS=""
+SCHEM_TRANSITMAP_EXTRA_ARGS=""
+if [ -n "$TRACE_DIR" ]; then
+    mkdir -p "$TRACE_DIR"
+    GTFS2GRAPH_EXTRA_ARGS="--trace $TRACE_DIR/gtfs2graph.json"
+    TOPO_EXTRA_ARGS="$TOPO_EXTRA_ARGS --trace $TRACE_DIR/topo.json"
+    LOOM_EXTRA_ARGS="$LOOM_EXTRA_ARGS --trace $TRACE_DIR/loom.json"
+    OCTI_EXTRA_ARGS="$OCTI_EXTRA_ARGS --trace $TRACE_DIR/octi.json"
+    GEO_TRANSITMAP_EXTRA_ARGS="--trace $TRACE_DIR/transitmap_geographic.json"
+    SCHEM_TRANSITMAP_EXTRA_ARGS="--trace $TRACE_DIR/transitmap_schematic.json"
+fi
+
+if [ -n "$METRICS_DIR" ]; then
+    mkdir -p "$METRICS_DIR"
+    GTFS2GRAPH_EXTRA_ARGS="$GTFS2GRAPH_EXTRA_ARGS --metrics-out $METRICS_DIR/gtfs2graph.json"
+    TOPO_EXTRA_ARGS="$TOPO_EXTRA_ARGS --metrics-out $METRICS_DIR/topo.json"
+    LOOM_EXTRA_ARGS="$LOOM_EXTRA_ARGS --metrics-out $METRICS_DIR/loom.json"
+    OCTI_EXTRA_ARGS="$OCTI_EXTRA_ARGS --metrics-out $METRICS_DIR/octi.json"
+    GEO_TRANSITMAP_EXTRA_ARGS="$GEO_TRANSITMAP_EXTRA_ARGS --metrics-out $METRICS_DIR/transitmap_geographic.json"
+    SCHEM_TRANSITMAP_EXTRA_ARGS="$SCHEM_TRANSITMAP_EXTRA_ARGS --metrics-out $METRICS_DIR/transitmap_schematic.json"
 fi
 
 # Create output directory
@@ -347,13 +401,18 @@ COMMON_PARAMS="--line-width $LINE_WIDTH \
     --padding $PADDING \
     --labels \
     --tight-stations \
-    --render-dir-markers"
+    --render-dir-markers \
+    --label-text-scale $TEXT_SHRINK \
+    --station-label-font 'Noto Sans Kannada, Noto Sans, sans-serif' \
+    --line-label-font 'Ubuntu, Noto Sans, sans-serif' \
+    --svg-lang kn \
+    --svg-layers"
 
 # Run common pipeline once and save intermediate result
 log_section "Generating Maps"
 log_info "Running gtfs2graph → topo → loom (no log output until loom finishes; large subsets can take many minutes — see -lt / process CPU)"
-LOOM_JSON="$OUTPUT_DIR/${BASENAME}_loom.json"
-PIPELINE_CMD="gtfs2graph -m bus $SUBSET_GTFS | topo --smooth $SMOOTHING -d $MAX_AGGR_DIST | loom $LOOM_EXTRA_ARGS > $LOOM_JSON"
+LOOM_JSON="$OUTPUT_DIR/${BASENAME}_loom.json${LOOM_JSON_EXT}"
+PIPELINE_CMD="gtfs2graph -m bus $GTFS2GRAPH_EXTRA_ARGS $SUBSET_GTFS | topo --smooth $SMOOTHING -d $MAX_AGGR_DIST $TOPO_EXTRA_ARGS | loom $LOOM_EXTRA_ARGS > $LOOM_JSON"
 log_cmd "$PIPELINE_CMD"
 if ! eval "$PIPELINE_CMD"; then
     log_error "gtfs2graph/topo/loom pipeline failed"
@@ -366,14 +425,14 @@ if [ ! -s "$LOOM_JSON" ]; then
 fi
 
 # Save a debug copy of the loom JSON
-cp "$LOOM_JSON" "debug_loom.json"
+cp "$LOOM_JSON" "debug_loom.json${LOOM_JSON_EXT}"
 
-log_info "Created intermediate file: ${BASENAME}_loom.json"
-log_info "Debug copy: debug_loom.json"
+log_info "Created intermediate file: ${BASENAME}_loom.json${LOOM_JSON_EXT}"
+log_info "Debug copy: debug_loom.json${LOOM_JSON_EXT}"
 
 # Generate geographic map from loom output
 log_info "Generating geographic map"
-GEOGRAPHIC_CMD="cat $LOOM_JSON | transitmap $COMMON_PARAMS > $OUTPUT_DIR/${BASENAME}_geographic.svg"
+GEOGRAPHIC_CMD="cat $LOOM_JSON | transitmap $COMMON_PARAMS $GEO_TRANSITMAP_EXTRA_ARGS > $OUTPUT_DIR/${BASENAME}_geographic.svg"
 log_cmd "$GEOGRAPHIC_CMD"
 if ! eval "$GEOGRAPHIC_CMD"; then
     log_error "transitmap (geographic) failed"
@@ -382,41 +441,18 @@ fi
 
 # Generate schematic map from loom output
 log_info "Generating schematic map"
-SCHEMATIC_CMD="cat $LOOM_JSON | octi | transitmap $COMMON_PARAMS > $OUTPUT_DIR/${BASENAME}_schematic.svg"
+SCHEMATIC_CMD="cat $LOOM_JSON | octi $OCTI_EXTRA_ARGS | transitmap $COMMON_PARAMS $SCHEM_TRANSITMAP_EXTRA_ARGS > $OUTPUT_DIR/${BASENAME}_schematic.svg"
 log_cmd "$SCHEMATIC_CMD"
 if ! eval "$SCHEMATIC_CMD"; then
     log_error "octi/transitmap (schematic) failed"
     exit 1
 fi
 
-# Create adjusted SVG files with shrunk text
-log_section "Post-Processing"
-log_info "Adjusting text sizes"
-GEOGRAPHIC_ADJUSTED="${OUTPUT_DIR}/${BASENAME}_geographic_adjusted.svg"
-SCHEMATIC_ADJUSTED="${OUTPUT_DIR}/${BASENAME}_schematic_adjusted.svg"
-
-"$PYTHON_CMD" "$SCRIPT_DIR/adjust_svg.py" "$OUTPUT_DIR/${BASENAME}_geographic.svg" "$GEOGRAPHIC_ADJUSTED" "$TEXT_SHRINK"
-log_info "Created: ${BASENAME}_geographic_adjusted.svg"
-"$PYTHON_CMD" "$SCRIPT_DIR/adjust_svg.py" "$OUTPUT_DIR/${BASENAME}_schematic.svg" "$SCHEMATIC_ADJUSTED" "$TEXT_SHRINK"
-log_info "Created: ${BASENAME}_schematic_adjusted.svg"
-
-# Clean up unadjusted SVGs unless in verbose mode
-if [ "$DEBUG" = false ]; then
-    rm -f "$OUTPUT_DIR/${BASENAME}_geographic.svg"
-    rm -f "$OUTPUT_DIR/${BASENAME}_schematic.svg"
-    # Rename adjusted files to be the main files
-    mv "$GEOGRAPHIC_ADJUSTED" "$OUTPUT_DIR/${BASENAME}_geographic.svg"
-    mv "$SCHEMATIC_ADJUSTED" "$OUTPUT_DIR/${BASENAME}_schematic.svg"
-fi
-
-# Kannada/Indic: station labels must use Noto Sans Kannada first (Ubuntu Condensed breaks conjuncts)
-if [ -f "$SCRIPT_DIR/svg_indic_font_fallback.py" ]; then
-    log_info "Applying Indic-friendly font stack (station labels)"
-    if ! "$PYTHON_CMD" "$SCRIPT_DIR/svg_indic_font_fallback.py" \
-        "$OUTPUT_DIR/${BASENAME}_geographic.svg" \
-        "$OUTPUT_DIR/${BASENAME}_schematic.svg"; then
-        log_error "svg_indic_font_fallback.py failed"
-        exit 1
+if [ -n "$TRACE_DIR" ]; then
+    if "$PYTHON_CMD" "$SCRIPT_DIR/scripts/merge_traces.py" -o "$TRACE_DIR/trace.json" \
+        "$TRACE_DIR"/gtfs2graph.json "$TRACE_DIR"/topo.json "$TRACE_DIR"/loom.json \
+        "$TRACE_DIR"/octi.json "$TRACE_DIR"/transitmap_*.json; then
+        log_info "Trace: $TRACE_DIR/trace.json"
     fi
 fi
 
@@ -429,7 +465,7 @@ else
     echo "├── GTFS Subset:"
     echo "│   └── ${BASENAME}.zip"
     echo "├── Intermediate Files:"
-    echo "│   └── ${BASENAME}_loom.json"
+    echo "│   └── ${BASENAME}_loom.json${LOOM_JSON_EXT}"
     echo "└── Final Maps:"
     echo "    ├── ${BASENAME}_geographic.svg"
     echo "    └── ${BASENAME}_schematic.svg"
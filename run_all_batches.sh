@@ -22,6 +22,16 @@ SKIP_ARGS=()
 if [[ "${SKIP_TOP_N}" != "0" ]]; then
   SKIP_ARGS=(--skip-top-n "${SKIP_TOP_N}")
 fi
+# QUEUE_DIR shards the stop jobs to other nodes, which run
+#   python generate_all_stops.py --queue-worker "$QUEUE_DIR" --workers N
+# with the same paths (shared mount). STAGE_CACHE_DIR is shared by all jobs.
+DIST_ARGS=()
+if [[ -n "${QUEUE_DIR:-}" ]]; then
+  DIST_ARGS+=(--queue "${QUEUE_DIR}")
+fi
+if [[ -n "${STAGE_CACHE_DIR:-}" ]]; then
+  DIST_ARGS+=(--stage-cache-dir "${STAGE_CACHE_DIR}")
+fi
 
 if [[ ! -f "$EN" ]]; then echo "Missing EN feed: $EN" >&2; exit 1; fi
 if [[ ! -f "$KN" ]]; then echo "Warning: no KN feed at $KN — EN-only for stops batches" >&2; KN=""; fi
@@ -31,33 +41,33 @@ echo "=== $(date -Iseconds) stops merged g50 (EN+KN), profiles default compact =
 if [[ -n "$KN" ]]; then
   python batch_transit_maps.py stops --en-feed "$EN" --kn-feed "$KN" --out "$OUT" \
     --merge-names --max-groups 50 --profiles default compact --skip-existing \
-    --workers "$WORKERS" "${SKIP_ARGS[@]}" "${FLAT_ARGS[@]}"
+    --workers "$WORKERS" "${SKIP_ARGS[@]}" "${FLAT_ARGS[@]}" "${DIST_ARGS[@]}"
 else
   python batch_transit_maps.py stops --en-feed "$EN" --out "$OUT" \
     --merge-names --max-groups 50 --profiles default compact --skip-existing \
-    --workers "$WORKERS" "${SKIP_ARGS[@]}" "${FLAT_ARGS[@]}"
+    --workers "$WORKERS" "${SKIP_ARGS[@]}" "${FLAT_ARGS[@]}" "${DIST_ARGS[@]}"
 fi
 
 echo "=== $(date -Iseconds) stops merged g100 → ${OUT}_merged_g100 ==="
 if [[ -n "$KN" ]]; then
   python batch_transit_maps.py stops --en-feed "$EN" --kn-feed "$KN" --out "${OUT}_merged_g100" \
     --merge-names --max-groups 100 --profiles default compact --skip-existing \
-    --workers "$WORKERS" "${SKIP_ARGS[@]}" "${FLAT_ARGS[@]}"
+    --workers "$WORKERS" "${SKIP_ARGS[@]}" "${FLAT_ARGS[@]}" "${DIST_ARGS[@]}"
 else
   python batch_transit_maps.py stops --en-feed "$EN" --out "${OUT}_merged_g100" \
     --merge-names --max-groups 100 --profiles default compact --skip-existing \
-    --workers "$WORKERS" "${SKIP_ARGS[@]}" "${FLAT_ARGS[@]}"
+    --workers "$WORKERS" "${SKIP_ARGS[@]}" "${FLAT_ARGS[@]}" "${DIST_ARGS[@]}"
 fi
 
 echo "=== $(date -Iseconds) stops least-first g100 → ${OUT}_least_g100 ==="
 if [[ -n "$KN" ]]; then
   python batch_transit_maps.py stops --en-feed "$EN" --kn-feed "$KN" --out "${OUT}_least_g100" \
     --least-first --max-groups 100 --profiles default compact --skip-existing \
-    --workers "$WORKERS" "${SKIP_ARGS[@]}" "${FLAT_ARGS[@]}"
+    --workers "$WORKERS" "${SKIP_ARGS[@]}" "${FLAT_ARGS[@]}" "${DIST_ARGS[@]}"
 else
   python batch_transit_maps.py stops --en-feed "$EN" --out "${OUT}_least_g100" \
     --least-first --max-groups 100 --profiles default compact --skip-existing \
-    --workers "$WORKERS" "${SKIP_ARGS[@]}" "${FLAT_ARGS[@]}"
+    --workers "$WORKERS" "${SKIP_ARGS[@]}" "${FLAT_ARGS[@]}" "${DIST_ARGS[@]}"
 fi
 
 echo "=== $(date -Iseconds) routes: 314* prefix + regex ^31[0-9] ==="
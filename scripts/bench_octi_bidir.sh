@@ -0,0 +1,37 @@
+#!/usr/bin/env bash
+# Benchmark octi's bidirectional routing of long comb edges against the
+# unidirectional grid search on the example graphs. Prints the wall time of
+# both runs per example and whether the resulting drawings are identical.
+# Drawings may differ between equally cheap routes.
+#
+# Usage: scripts/bench_octi_bidir.sh [min dist in cells (=8)] [octi options...]
+set -euo pipefail
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+OCTI="${OCTI:-${ROOT}/build/octi}"
+DIST="${1:-8}"
+shift || true
+TMP="$(mktemp -d)"
+trap 'rm -rf "$TMP"' EXIT
+
+if [[ ! -x "$OCTI" ]]; then echo "Missing octi binary: $OCTI" >&2; exit 1; fi
+
+run() {
+  local out="$1"
+  shift
+  local start end
+  start=$(date +%s.%N)
+  "$OCTI" "$@" > "$out" 2> /dev/null
+  end=$(date +%s.%N)
+  echo "$end - $start" | bc
+}
+
+printf "%-16s %12s %12s %8s %s\n" "example" "unidir (s)" "bidir (s)" "speedup" "identical"
+for f in "$ROOT"/examples/*.json; do
+  name="$(basename "$f" .json)"
+  tu=$(run "$TMP/$name.unidir.json" --bidir-route-dist 0 "$@" < "$f")
+  tb=$(run "$TMP/$name.bidir.json" --bidir-route-dist "$DIST" "$@" < "$f")
+  same="yes"
+  cmp -s "$TMP/$name.unidir.json" "$TMP/$name.bidir.json" || same="no"
+  printf "%-16s %12.2f %12.2f %8.2f %s\n" "$name" "$tu" "$tb" \
+    "$(echo "$tu / $tb" | bc -l)" "$same"
+done
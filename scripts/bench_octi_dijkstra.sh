@@ -0,0 +1,34 @@
+#!/usr/bin/env bash
+# Benchmark octi's specialized grid shortest path search against the generic
+# util::graph::Dijkstra on the example graphs. Prints the wall time of both
+# runs per example and whether the resulting drawings are identical.
+#
+# Usage: scripts/bench_octi_dijkstra.sh [octi options...]
+set -euo pipefail
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+OCTI="${OCTI:-${ROOT}/build/octi}"
+TMP="$(mktemp -d)"
+trap 'rm -rf "$TMP"' EXIT
+
+if [[ ! -x "$OCTI" ]]; then echo "Missing octi binary: $OCTI" >&2; exit 1; fi
+
+run() {
+  local out="$1"
+  shift
+  local start end
+  start=$(date +%s.%N)
+  "$OCTI" "$@" > "$out" 2> /dev/null
+  end=$(date +%s.%N)
+  echo "$end - $start" | bc
+}
+
+printf "%-16s %12s %12s %8s %s\n" "example" "generic (s)" "grid (s)" "speedup" "identical"
+for f in "$ROOT"/examples/*.json; do
+  name="$(basename "$f" .json)"
+  tg=$(run "$TMP/$name.generic.json" --generic-dijkstra "$@" < "$f")
+  tf=$(run "$TMP/$name.grid.json" "$@" < "$f")
+  same="yes"
+  cmp -s "$TMP/$name.generic.json" "$TMP/$name.grid.json" || same="no"
+  printf "%-16s %12.2f %12.2f %8.2f %s\n" "$name" "$tg" "$tf" \
+    "$(echo "$tg / $tf" | bc -l)" "$same"
+done
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""End-to-end benchmark of the pipeline stages on example line graphs.
+
+Every stage is run separately on each example: topo, loom for each
+optimization method, octi for each base graph type and transitmap with
+the SVG and the MVT render engine. For each run, the wall time, the peak
+RSS and (if the alloccount library is given) the number of allocations
+are recorded. The results are written as JSON.
+
+Usage (normally invoked via the "bench" CMake target):
+
+    scripts/bench_pipeline.py --bin-dir build --alloc-lib build/liballoccount.so \\
+        --out bench.json examples/*.json
+"""
+
+import argparse
+import json
+import os
+import platform
+import subprocess
+import sys
+import tempfile
+import time
+
+LOOM_METHODS = ["comb", "hillc", "anneal", "greedy", "greedy-lookahead", "null"]
+OCTI_BASE_GRAPHS = ["ortholinear", "octilinear", "orthoradial", "quadtree",
+                    "octihanan"]
+
+
+def run_stage(cmd, inp, out, alloc_lib, timeout):
+    """Run a single stage, return a dict with its measurements."""
+    env = dict(os.environ)
+    fd, alloc_out = tempfile.mkstemp(suffix=".json")
+    os.close(fd)
+    if alloc_lib:
+        env["LD_PRELOAD"] = alloc_lib
+        env["LOOM_ALLOC_COUNT_OUT"] = alloc_out
+
+    res = {"cmd": " ".join(cmd)}
+
+    with open(inp, "rb") as fin, open(out, "wb") as fout:
+        start = time.perf_counter()
+        proc = subprocess.Popen(cmd, stdin=fin, stdout=fout,
+                                stderr=subprocess.DEVNULL, env=env)
+        timed_out = False
+        while True:
+            pid, status, rusage = os.wait4(proc.pid, os.WNOHANG)
+            if pid != 0:
+                break
+            if time.perf_counter() - start > timeout:
+                proc.kill()
+                timed_out = True
+                pid, status, rusage = os.wait4(proc.pid, 0)
+                break
+            time.sleep(0.005)
+        wall = time.perf_counter() - start
+
+    res["wall-ms"] = wall * 1000
+    # ru_maxrss is in kilobytes on Linux, but in bytes on macOS
+    rss = rusage.ru_maxrss
+    res["peak-rss-bytes"] = rss if platform.system() == "Darwin" else rss * 1024
+    res["exit-code"] = os.waitstatus_to_exitcode(status)
+    res["timed-out"] = timed_out
+
+    try:
+        with open(alloc_out) as f:
+            res.update(json.load(f))
+    except (OSError, ValueError):
+        pass
+    os.unlink(alloc_out)
+
+    return res
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("examples", nargs="+", help="input line graphs")
+    parser.add_argument("--bin-dir", default="build",
+                        help="directory containing the tool binaries")
+    parser.add_argument("--alloc-lib", default=None,
+                        help="path of the alloccount preload library")
+    parser.add_argument("--out", default="-", help="output JSON file")
+    parser.add_argument("--timeout", type=float, default=900,
+                        help="timeout per stage in seconds")
+    parser.add_argument("--loom-methods", default=",".join(LOOM_METHODS))
+    parser.add_argument("--octi-base-graphs",
+                        default=",".join(OCTI_BASE_GRAPHS))
+    args = parser.parse_args()
+
+    def tool(name):
+        return os.path.join(args.bin_dir, name)
+
+    results = []
+    tmp = tempfile.mkdtemp(prefix="loom-bench-")
+
+    def stage(example, name, variant, cmd, inp, out):
+        sys.stderr.write("%s: %s %s\n" % (example, name, variant))
+        r = run_stage(cmd, inp, out, args.alloc_lib, args.timeout)
+        r.update({"example": example, "stage": name, "variant": variant})
+        results.append(r)
+        return r["exit-code"] == 0
+
+    for ex in args.examples:
+        name = os.path.splitext(os.path.basename(ex))[0]
+
+        def p(suffix):
+            return os.path.join(tmp, "%s.%s" % (name, suffix))
+
+        if not stage(name, "topo", "", [tool("topo")], ex, p("topo.json")):
+            continue
+
+        for m in args.loom_methods.split(","):
+            stage(name, "loom", m, [tool("loom"), "-m", m], p("topo.json"),
+                  p("loom-%s.json" % m))
+
+        loom_out = p("loom-comb.json")
+        if not os.path.exists(loom_out) or os.path.getsize(loom_out) == 0:
+            loom_out = p("topo.json")
+
+        for b in args.octi_base_graphs.split(","):
+            stage(name, "octi", b, [tool("octi"), "-b", b], loom_out,
+                  p("octi-%s.json" % b))
+
+        stage(name, "transitmap", "svg",
+              [tool("transitmap"), "--render-engine=svg"], loom_out,
+              p("map.svg"))
+
+        mvt_dir = p("mvt")
+        os.makedirs(mvt_dir, exist_ok=True)
+        stage(name, "transitmap", "mvt",
+              [tool("transitmap"), "--render-engine=mvt", "--mvt-path",
+               mvt_dir], loom_out, p("mvt.out"))
+
+    report = {
+        "timestamp": int(time.time()),
+        "host": platform.node(),
+        "procs": os.cpu_count(),
+        "results": results,
+    }
+
+    if args.out == "-":
+        json.dump(report, sys.stdout, indent=2)
+        sys.stdout.write("\n")
+    else:
+        with open(args.out, "w") as f:
+            json.dump(report, f, indent=2)
+        sys.stderr.write("Wrote %d results to %s\n" % (len(results), args.out))
+
+
+if __name__ == "__main__":
+    main()
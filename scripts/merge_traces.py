@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+"""Merge Chrome trace files written with --trace into a single trace.
+
+All tools write timestamps in microseconds since the epoch and tag their
+events with their process id, so the events of a pipeline run can be
+combined as they are. The merged trace can be opened in chrome://tracing
+or https://ui.perfetto.dev.
+
+Usage:
+
+    scripts/merge_traces.py -o trace.json topo.json loom.json octi.json
+"""
+
+import argparse
+import json
+import sys
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("traces", nargs="+", help="trace files to merge")
+    parser.add_argument("-o", "--out", default="-",
+                        help="output file, - for stdout (default)")
+    args = parser.parse_args()
+
+    events = []
+    for path in args.traces:
+        try:
+            with open(path) as f:
+                events.extend(json.load(f)["traceEvents"])
+        except (OSError, ValueError, KeyError) as e:
+            print("Skipping %s: %s" % (path, e), file=sys.stderr)
+
+    res = {"traceEvents": events, "displayTimeUnit": "ms"}
+
+    if args.out == "-":
+        json.dump(res, sys.stdout)
+    else:
+        with open(args.out, "w") as f:
+            json.dump(res, f)
+
+
+if __name__ == "__main__":
+    main()
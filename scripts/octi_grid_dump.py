@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""Read the tiled binary grid graph dumps written by octi.
+
+octi writes them with --print-mode gridgraph --grid-format bin, the format is
+described in src/octi/basegraph/GridDump.h. Only the tile index is read up
+front, tiles are read and decoded when they are needed, so a window of a
+huge grid can be looked at without decoding the rest.
+
+Usage:
+
+    octi --print-mode gridgraph --grid-format bin < graph.json > grid.bin
+    scripts/octi_grid_dump.py grid.bin --info
+    scripts/octi_grid_dump.py grid.bin --window 7.80,47.98,7.87,48.01 \\
+        -o grid.json
+"""
+
+import argparse
+import json
+import math
+import struct
+import sys
+
+MAGIC = b"OGDF"
+VERSION = 1
+COORD_RES = 10.0
+
+ND_SETTLED = 1
+ND_CLOSED = 2
+EDG_CLOSED = 1
+EDG_SECONDARY = 2
+
+WEB_MERC_EXT = 20037508.3427892
+
+
+class _Dec:
+    def __init__(self, buf, pos=0):
+        self.buf = buf
+        self.pos = pos
+
+    def varint(self):
+        ret = 0
+        shift = 0
+        while True:
+            b = self.buf[self.pos]
+            self.pos += 1
+            ret |= (b & 0x7F) << shift
+            if b < 0x80:
+                return ret
+            shift += 7
+
+    def zigzag(self):
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+    def coords(self, n):
+        ret = []
+        prev = 0
+        for _ in range(n):
+            prev += self.zigzag()
+            ret.append(prev / COORD_RES)
+        return ret
+
+    def bytes(self, n):
+        ret = self.buf[self.pos:self.pos + n]
+        self.pos += n
+        return ret
+
+
+def lat_lng(x, y):
+    """Web mercator to [lng, lat]."""
+    lng = x / WEB_MERC_EXT * 180.0
+    lat = math.degrees(2 * math.atan(math.exp(y / WEB_MERC_EXT * math.pi))
+                       - math.pi / 2)
+    return [lng, lat]
+
+
+def web_merc(lng, lat):
+    """[lng, lat] to web mercator."""
+    x = lng / 180.0 * WEB_MERC_EXT
+    y = math.log(math.tan(math.pi / 4 + math.radians(lat) / 2))
+    return x, y / math.pi * WEB_MERC_EXT
+
+
+class GridDump:
+    """A grid dump file, with lazily decoded tiles."""
+
+    def __init__(self, path):
+        self._f = open(path, "rb")
+        d = _Dec(self._f.read(24))
+        if d.bytes(4) != MAGIC:
+            raise ValueError("%s is not a grid dump" % path)
+        version = d.varint()
+        if version > VERSION:
+            raise ValueError("unsupported grid dump version %d" % version)
+
+        n = d.varint()
+        self._f.seek(d.pos)
+        self.props = json.loads(self._f.read(n) or b"{}")
+
+        pos = d.pos + n
+        d = _Dec(self._f.read(20))
+        self.tile_size = d.varint() / COORD_RES
+        num_tiles = d.varint()
+
+        # every index entry has at most 4 varints of 10 bytes
+        pos += d.pos
+        self._f.seek(pos)
+        idx = _Dec(self._f.read(num_tiles * 40))
+        self.tiles = []
+        for _ in range(num_tiles):
+            x, y = idx.zigzag(), idx.zigzag()
+            self.tiles.append((x, y, idx.varint(), idx.varint()))
+        self._data = pos + idx.pos
+
+    def close(self):
+        self._f.close()
+
+    def tiles_in(self, box):
+        """The index entries of the tiles intersecting a web mercator box
+        (minx, miny, maxx, maxy)."""
+        s = self.tile_size
+        return [t for t in self.tiles
+                if t[0] * s <= box[2] and (t[0] + 1) * s >= box[0]
+                and t[1] * s <= box[3] and (t[1] + 1) * s >= box[1]]
+
+    def read(self, tile):
+        """Decode the tile of an index entry into (nodes, edges)."""
+        self._f.seek(self._data + tile[2])
+        d = _Dec(self._f.read(tile[3]))
+
+        n = d.varint()
+        xs, ys = d.coords(n), d.coords(n)
+        gx = [d.varint() for _ in range(n)]
+        gy = [d.varint() for _ in range(n)]
+        flags = d.bytes(n)
+        nds = [{"pos": (xs[i], ys[i]), "x": gx[i], "y": gy[i],
+                "settled": bool(flags[i] & ND_SETTLED),
+                "closed": bool(flags[i] & ND_CLOSED)} for i in range(n)]
+
+        m = d.varint()
+        fx, fy, tx, ty = d.coords(m), d.coords(m), d.coords(m), d.coords(m)
+        costs = struct.unpack("<%df" % m, d.bytes(4 * m))
+        used = d.bytes(m)
+        flags = d.bytes(m)
+        edgs = [{"from": (fx[i], fy[i]), "to": (tx[i], ty[i]),
+                 "cost": costs[i], "res_edges": used[i],
+                 "closed": bool(flags[i] & EDG_CLOSED),
+                 "secondary": bool(flags[i] & EDG_SECONDARY)}
+                for i in range(m)]
+
+        return nds, edgs
+
+
+def to_geojson(dump, tiles, box=None):
+    """GeoJSON of the given tiles, clipped to the web mercator box."""
+
+    def inside(p):
+        return (box is None or
+                box[0] <= p[0] <= box[2] and box[1] <= p[1] <= box[3])
+
+    feats = []
+    for t in tiles:
+        nds, edgs = dump.read(t)
+        for nd in nds:
+            if not inside(nd["pos"]):
+                continue
+            feats.append({
+                "type": "Feature",
+                "geometry": {"type": "Point",
+                             "coordinates": lat_lng(*nd["pos"])},
+                "properties": {"x": nd["x"], "y": nd["y"],
+                               "settled": int(nd["settled"]),
+                               "closed": int(nd["closed"])}})
+        for e in edgs:
+            if not inside(e["from"]) and not inside(e["to"]):
+                continue
+            cost = "inf" if math.isinf(e["cost"]) else e["cost"]
+            feats.append({
+                "type": "Feature",
+                "geometry": {"type": "LineString",
+                             "coordinates": [lat_lng(*e["from"]),
+                                             lat_lng(*e["to"])]},
+                "properties": {"cost": cost, "res_edges": e["res_edges"],
+                               "closed": int(e["closed"]),
+                               "secondary": int(e["secondary"])}})
+
+    return {"type": "FeatureCollection", "properties": dump.props,
+            "features": feats}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("dump", help="grid dump written by octi")
+    parser.add_argument("--window",
+                        help="minlng,minlat,maxlng,maxlat, default all")
+    parser.add_argument("--info", action="store_true",
+                        help="only print the tile index")
+    parser.add_argument("-o", "--out", default="-",
+                        help="output file, - for stdout (default)")
+    args = parser.parse_args()
+
+    dump = GridDump(args.dump)
+
+    if args.info:
+        print("tile size: %g m, %d tiles" % (dump.tile_size, len(dump.tiles)))
+        for x, y, _, n in dump.tiles:
+            print("  %d,%d: %d bytes" % (x, y, n))
+        return
+
+    box = None
+    tiles = dump.tiles
+    if args.window:
+        c = [float(v) for v in args.window.split(",")]
+        if len(c) != 4:
+            parser.error("--window requires minlng,minlat,maxlng,maxlat")
+        box = web_merc(c[0], c[1]) + web_merc(c[2], c[3])
+        tiles = dump.tiles_in(box)
+
+    res = to_geojson(dump, tiles, box)
+
+    if args.out == "-":
+        json.dump(res, sys.stdout)
+    else:
+        with open(args.out, "w") as f:
+            json.dump(res, f)
+
+
+if __name__ == "__main__":
+    main()
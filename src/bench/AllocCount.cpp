@@ -0,0 +1,85 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+// Allocation counter, meant to be preloaded (LD_PRELOAD) into the pipeline
+// tools by scripts/bench_pipeline.py. Counts all calls to operator new and
+// the number of requested bytes. On exit, the counts are written as JSON to
+// the file given in the environment variable LOOM_ALLOC_COUNT_OUT. The
+// current count is also exported as loomAllocCount(), which the tools use
+// for their per-phase metrics (--metrics-out).
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<unsigned long long> allocs(0);
+std::atomic<unsigned long long> allocBytes(0);
+
+// _____________________________________________________________________________
+void* countedAlloc(size_t size) {
+  allocs.fetch_add(1, std::memory_order_relaxed);
+  allocBytes.fetch_add(size, std::memory_order_relaxed);
+  if (size == 0) size = 1;
+  void* p = std::malloc(size);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+struct Reporter {
+  ~Reporter() {
+    const char* path = std::getenv("LOOM_ALLOC_COUNT_OUT");
+    if (!path) return;
+    FILE* f = std::fopen(path, "w");
+    if (!f) return;
+    std::fprintf(f, "{\"allocs\": %llu, \"alloc-bytes\": %llu}\n",
+                 allocs.load(), allocBytes.load());
+    std::fclose(f);
+  }
+} reporter;
+
+}  // namespace
+
+// _____________________________________________________________________________
+extern "C" unsigned long long loomAllocCount() {
+  return allocs.load(std::memory_order_relaxed);
+}
+
+// _____________________________________________________________________________
+void* operator new(size_t size) { return countedAlloc(size); }
+
+// _____________________________________________________________________________
+void* operator new[](size_t size) { return countedAlloc(size); }
+
+// _____________________________________________________________________________
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return countedAlloc(size);
+  } catch (...) {
+    return 0;
+  }
+}
+
+// _____________________________________________________________________________
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return countedAlloc(size);
+  } catch (...) {
+    return 0;
+  }
+}
+
+// _____________________________________________________________________________
+void operator delete(void* p) noexcept { std::free(p); }
+
+// _____________________________________________________________________________
+void operator delete[](void* p) noexcept { std::free(p); }
+
+// _____________________________________________________________________________
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// _____________________________________________________________________________
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
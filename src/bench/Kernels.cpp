@@ -0,0 +1,251 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "bench/MicroBench.h"
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/OptGraphScorer.h"
+#include "octi/Octilinearizer.h"
+#include "octi/basegraph/GeoPens.h"
+#include "octi/basegraph/GridGraph.h"
+#include "octi/basegraph/OctiGridGraph.h"
+#include "shared/rendergraph/RenderGraph.h"
+#include "topo/config/TopoConfig.h"
+#include "topo/mapconstructor/MapConstructor.h"
+#include "transitmap/config/TransitMapConfig.h"
+#include "transitmap/graph/GraphBuilder.h"
+#include "transitmap/label/Labeller.h"
+#ifdef PROTOBUF_FOUND
+#include "transitmap/output/MvtRenderer.h"
+#endif
+
+using bench::Kernel;
+using bench::Sample;
+using shared::linegraph::LineGraph;
+using shared::rendergraph::RenderGraph;
+
+namespace {
+// _____________________________________________________________________________
+// A* searches between random pairs of far apart sinks of an n x n octilinear
+// grid, with random geo course penalties on all grid edges
+Sample octiDijkstra(size_t n, size_t reps, uint64_t seed) {
+  using octi::basegraph::GeoPens;
+  using octi::basegraph::GridEdge;
+  using octi::basegraph::GridGraphHeur;
+  using octi::basegraph::GridNode;
+
+  std::mt19937_64 rng(seed);
+  double cell = bench::SYNTH_SPACING;
+  octi::basegraph::OctiGridGraph gg(
+      util::geo::DBox(util::geo::DPoint(0, 0),
+                      util::geo::DPoint(cell * (n - 1), cell * (n - 1))),
+      cell, cell / 4, octi::basegraph::Penalties());
+  gg.init();
+
+  std::uniform_real_distribution<float> pen(0, 2);
+  std::vector<std::pair<uint32_t, float>> pens;
+  for (auto nd : gg.getNds()) {
+    for (auto e : nd->getAdjListOut()) {
+      pens.push_back({e->pl().getId(), pen(rng)});
+    }
+  }
+  GeoPens geoPens;
+  geoPens.build(&pens);
+
+  std::vector<GridNode*> sinks;
+  for (auto nd : gg.getNds()) {
+    if (nd->pl().isSink()) sinks.push_back(nd);
+  }
+
+  std::vector<std::pair<GridNode*, GridNode*>> pairs;
+  std::uniform_int_distribution<size_t> pick(0, sinks.size() - 1);
+  while (pairs.size() < 16) {
+    auto fr = sinks[pick(rng)];
+    auto to = sinks[pick(rng)];
+    size_t dx = std::max(fr->pl().getX(), to->pl().getX()) -
+                std::min(fr->pl().getX(), to->pl().getX());
+    size_t dy = std::max(fr->pl().getY(), to->pl().getY()) -
+                std::min(fr->pl().getY(), to->pl().getY());
+    if (std::max(dx, dy) >= std::max<size_t>(n / 2, 1)) {
+      pairs.push_back({fr, to});
+    }
+  }
+
+  octi::GridCostGeoPen cost(std::numeric_limits<float>::infinity(), &geoPens);
+
+  double ns = bench::nsPerOp(
+      reps, pairs.size(), [] {},
+      [&] {
+        for (const auto& p : pairs) {
+          std::vector<GridEdge*> eL;
+          std::vector<GridNode*> nL;
+          std::set<GridNode*> fr{p.first}, to{p.second};
+          gg.openSinkFr(p.first, 0);
+          gg.openSinkTo(p.second, 0);
+          GridGraphHeur heur(&gg, to);
+          gg.getGridDijkstra()->shortestPath(fr, to, cost, heur, &eL, &nL);
+          gg.closeSinkFr(p.first);
+          gg.closeSinkTo(p.second);
+        }
+      });
+
+  return {"octi-dijkstra", n, pairs.size(), ns};
+}
+
+// _____________________________________________________________________________
+// crossing scores of random line orderings on the optimization graph of the
+// shared-edge network
+Sample loomCrossings(size_t n, size_t reps, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  RenderGraph rg(5, 1, 5);
+  bench::buildNetwork(n, false, &rng, &rg);
+
+  loom::optim::OptGraphScorer scorer(
+      shared::rendergraph::Penalties{1, 2, 3, 4, 5, 6, 7, 8, true, true});
+  loom::optim::OptGraph og(&scorer);
+  og.build(&rg);
+
+  std::vector<loom::optim::OptOrderCfg> cfgs(8);
+  for (auto& cfg : cfgs) {
+    for (auto nd : og.getNds()) {
+      for (auto e : nd->getAdjList()) {
+        if (e->getFrom() != nd) continue;
+        for (const auto& lo : e->pl().getLines()) cfg[e].push_back(lo.line);
+        std::shuffle(cfg[e].begin(), cfg[e].end(), rng);
+      }
+    }
+  }
+
+  volatile double sink = 0;
+  double ns = bench::nsPerOp(reps, cfgs.size(), [] {}, [&] {
+    for (const auto& cfg : cfgs) {
+      sink = sink + scorer.getCrossingScore(&og, cfg);
+    }
+  });
+
+  return {"loom-crossings", n, cfgs.size(), ns};
+}
+
+// _____________________________________________________________________________
+// collapsing of the split network, which is dominated by the candidate node
+// snapping of MapConstructor. An operation is one input edge.
+Sample topoCollapse(size_t n, size_t reps, uint64_t seed) {
+  topo::config::TopoConfig cfg;
+  std::unique_ptr<LineGraph> g;
+  size_t edgs = 0;
+
+  double ns = bench::nsPerOp(
+      reps, 1,
+      [&] {
+        std::mt19937_64 rng(seed);
+        g.reset(new LineGraph());
+        bench::buildNetwork(n, true, &rng, g.get());
+        edgs = g->numEdgs();
+      },
+      [&] {
+        topo::MapConstructor mc(&cfg, g.get());
+        mc.collapseShrdSegs(cfg.maxAggrDistance, 50, cfg.segmentLength);
+      });
+
+  return {"topo-collapse", n, edgs, ns / std::max<size_t>(edgs, 1)};
+}
+
+// _____________________________________________________________________________
+// station and line labelling of the shared-edge network, which is dominated
+// by the overlap tests of the label candidates. An operation is one station.
+Sample transitmapLabels(size_t n, size_t reps, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  transitmapper::config::Config cfg;
+  RenderGraph g(cfg.lineWidth, cfg.outlineWidth, cfg.lineSpacing);
+  bench::buildNetwork(n, false, &rng, &g);
+
+  transitmapper::graph::GraphBuilder b(&cfg);
+  b.writeNodeFronts(&g);
+  b.expandOverlappinFronts(&g);
+  g.createMetaNodes();
+
+  size_t stations = 0;
+  for (auto nd : g.getNds()) stations += nd->pl().stops().size() > 0;
+
+  std::unique_ptr<transitmapper::label::Labeller> l;
+  double ns = bench::nsPerOp(
+      reps, stations,
+      [&] { l.reset(new transitmapper::label::Labeller(&cfg)); },
+      [&] { l->label(g, false); });
+
+  return {"transitmap-labels", n, stations, ns};
+}
+
+#ifdef PROTOBUF_FOUND
+// _____________________________________________________________________________
+// encoding of n * 16 random walk line features into a single zoom 14 tile
+Sample mvtFeatures(size_t n, size_t reps, uint64_t seed) {
+  using transitmapper::output::MvtLineFeature;
+  using transitmapper::output::MvtTileDict;
+
+  const double EXT = 20037508.3427892;
+  const size_t z = 14;
+  double tw = (EXT * 2.0) / static_cast<double>(1 << z);
+
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> start(0, tw);
+  std::uniform_real_distribution<double> step(-tw / 64, tw / 64);
+
+  // the tile containing the origin of the synthetic networks
+  size_t x = std::floor((bench::SYNTH_ORIGIN_X + EXT) / tw);
+  size_t y = std::floor((bench::SYNTH_ORIGIN_Y + EXT) / tw);
+  util::geo::DPoint o(x * tw - EXT, y * tw - EXT);
+
+  std::vector<MvtLineFeature> feats;
+  for (size_t i = 0; i < n * 16; i++) {
+    util::geo::DLine line;
+    line.push_back({o.getX() + start(rng), o.getY() + start(rng)});
+    for (size_t j = 1; j < 64; j++) {
+      line.push_back({line.back().getX() + step(rng),
+                      line.back().getY() + step(rng)});
+    }
+    feats.push_back({line, transitmapper::output::MVT_LINES, {}});
+  }
+
+  transitmapper::config::Config cfg;
+  transitmapper::output::MvtRenderer r(&cfg, z);
+  std::unique_ptr<vector_tile::Tile> tile;
+  MvtTileDict dict;
+
+  double ns = bench::nsPerOp(
+      reps, feats.size(),
+      [&] {
+        tile.reset(new vector_tile::Tile());
+        dict.init(0, 0);
+      },
+      [&] {
+        auto layer = tile->add_layers();
+        for (const auto& f : feats) r.printFeature(f, z, x, y, layer, &dict);
+      });
+
+  return {"mvt-features", n, feats.size(), ns};
+}
+#endif
+}  // namespace
+
+// _____________________________________________________________________________
+std::vector<Kernel> bench::kernels() {
+  return {
+      {"octi-dijkstra", "grid A* search between two sinks", octiDijkstra},
+      {"loom-crossings", "crossing score of a line ordering", loomCrossings},
+      {"topo-collapse", "input edge collapsed", topoCollapse},
+      {"transitmap-labels", "station labelled", transitmapLabels},
+#ifdef PROTOBUF_FOUND
+      {"mvt-features", "line feature encoded", mvtFeatures},
+#endif
+  };
+}
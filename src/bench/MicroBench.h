@@ -0,0 +1,70 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef BENCH_MICROBENCH_H_
+#define BENCH_MICROBENCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "shared/linegraph/LineGraph.h"
+
+namespace bench {
+
+// the timing of one kernel on a synthetic input of a given size
+struct Sample {
+  std::string kernel;
+  size_t size;
+  size_t ops;  // operations per repetition
+  double nsPerOp;
+};
+
+// a kernel, run reps times on a synthetic input of the given size built
+// from the seed
+struct Kernel {
+  std::string name;
+  std::string op;  // what a single operation is
+  Sample (*run)(size_t size, size_t reps, uint64_t seed);
+};
+
+// all kernels available in this build
+std::vector<Kernel> kernels();
+
+// the fastest of reps runs of f, which does ops operations, in ns per op.
+// setup is called untimed before each run.
+template <typename S, typename F>
+double nsPerOp(size_t reps, size_t ops, S setup, F f) {
+  double best = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < reps; i++) {
+    setup();
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    best = std::min(best, ns);
+  }
+  return best / std::max<size_t>(ops, 1);
+}
+
+// A synthetic network on an n x n grid of stations: two lines along every
+// row and every column, and n staircase lines which alternately share row
+// and column edges with them. If split is set, every line runs on its own
+// slightly offset edges and nodes, like topo input, otherwise the lines
+// share the edges between the stations.
+void buildNetwork(size_t n, bool split, std::mt19937_64* rng,
+                  shared::linegraph::LineGraph* g);
+
+// spacing and lower left of the synthetic grid in web mercator meters
+const static double SYNTH_SPACING = 200;
+const static double SYNTH_ORIGIN_X = 868000;
+const static double SYNTH_ORIGIN_Y = 6100000;
+
+}  // namespace bench
+
+#endif  // BENCH_MICROBENCH_H_
@@ -0,0 +1,172 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+// Micro-benchmarks of the hot kernels of the tools on deterministic synthetic
+// inputs. For every kernel and size, the fastest of --reps runs is reported
+// in ns per operation, together with the scaling exponent against the
+// previous size (1 means linear in the grid side length n).
+
+#include <getopt.h>
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "3rdparty/json.hpp"
+#include "bench/MicroBench.h"
+#include "util/String.h"
+
+using bench::Kernel;
+using bench::Sample;
+
+namespace {
+// _____________________________________________________________________________
+void help(const char* bin) {
+  std::cout << std::setfill(' ') << std::left << "Usage: " << bin
+            << " [options]\n\n"
+            << "Allowed options:\n\n"
+            << std::setw(32) << "  -h [ --help ]"
+            << "show this help message\n"
+            << std::setw(32) << "  -l [ --list ]"
+            << "list the kernels\n"
+            << std::setw(32) << "  -k [ --kernels ] arg"
+            << "comma separated kernels to run, default all\n"
+            << std::setw(32) << "  -s [ --sizes ] arg (=8,16,32)"
+            << "comma separated grid side lengths (>= 2)\n"
+            << std::setw(32) << "  -r [ --reps ] arg (=5)"
+            << "repetitions per size, the fastest counts\n"
+            << std::setw(32) << "  --seed arg (=1)"
+            << "seed of the synthetic inputs\n"
+            << std::setw(32) << "  --json arg"
+            << "also write the samples as JSON to this file\n";
+}
+}  // namespace
+
+// _____________________________________________________________________________
+int main(int argc, char** argv) {
+  std::set<std::string> only;
+  std::vector<size_t> sizes = {8, 16, 32};
+  size_t reps = 5;
+  uint64_t seed = 1;
+  std::string jsonPath;
+
+  struct option ops[] = {{"help", no_argument, 0, 'h'},
+                         {"list", no_argument, 0, 'l'},
+                         {"kernels", required_argument, 0, 'k'},
+                         {"sizes", required_argument, 0, 's'},
+                         {"reps", required_argument, 0, 'r'},
+                         {"seed", required_argument, 0, 1},
+                         {"json", required_argument, 0, 2},
+                         {0, 0, 0, 0}};
+
+  int c;
+  while ((c = getopt_long(argc, argv, ":hlk:s:r:", ops, 0)) != -1) {
+    switch (c) {
+      case 'h':
+        help(argv[0]);
+        return 0;
+      case 'l':
+        for (const auto& k : bench::kernels()) {
+          std::cout << std::setfill(' ') << std::left << std::setw(20)
+                    << k.name << "op: " << k.op << "\n";
+        }
+        return 0;
+      case 'k':
+        for (const auto& k : util::split(optarg, ',')) only.insert(k);
+        break;
+      case 's':
+        sizes.clear();
+        for (const auto& s : util::split(optarg, ',')) {
+          sizes.push_back(atoi(s.c_str()));
+          if (sizes.back() < 2) {
+            std::cerr << "Sizes must be at least 2." << std::endl;
+            return 1;
+          }
+        }
+        break;
+      case 'r':
+        reps = std::max(1, atoi(optarg));
+        break;
+      case 1:
+        seed = strtoull(optarg, 0, 10);
+        break;
+      case 2:
+        jsonPath = optarg;
+        break;
+      case ':':
+        std::cerr << argv[optind - 1] << " requires an argument" << std::endl;
+        return 1;
+      case '?':
+        std::cerr << argv[optind - 1] << " option unknown" << std::endl;
+        return 1;
+      default:
+        std::cerr << "Error while parsing arguments" << std::endl;
+        return 1;
+    }
+  }
+
+  std::vector<Kernel> run;
+  for (const auto& k : bench::kernels()) {
+    if (only.empty() || only.count(k.name)) run.push_back(k);
+    only.erase(k.name);
+  }
+
+  if (!only.empty()) {
+    std::cerr << "Unknown kernel " << *only.begin() << ", see --list"
+              << std::endl;
+    return 1;
+  }
+
+  std::cout << std::setfill(' ') << std::left << std::setw(20) << "kernel"
+            << std::right << std::setw(8) << "size" << std::setw(10) << "ops"
+            << std::setw(16) << "ns/op" << std::setw(8) << "exp"
+            << "\n";
+
+  nlohmann::json out = nlohmann::json::array();
+
+  for (const auto& k : run) {
+    Sample prev{k.name, 0, 0, 0};
+    for (size_t size : sizes) {
+      Sample s = k.run(size, reps, seed);
+
+      std::cout << std::left << std::setw(20) << s.kernel << std::right
+                << std::setw(8) << s.size << std::setw(10) << s.ops
+                << std::setw(16) << std::fixed << std::setprecision(1)
+                << s.nsPerOp << std::setw(8);
+
+      nlohmann::json j = {{"kernel", s.kernel},
+                          {"size", s.size},
+                          {"ops", s.ops},
+                          {"ns_per_op", s.nsPerOp}};
+
+      if (prev.size && prev.nsPerOp > 0 && s.size != prev.size) {
+        double e = std::log(s.nsPerOp / prev.nsPerOp) /
+                   std::log(static_cast<double>(s.size) / prev.size);
+        std::cout << std::setprecision(2) << e;
+        j["exp"] = e;
+      } else {
+        std::cout << "-";
+      }
+      std::cout << std::endl;
+
+      out.push_back(j);
+      prev = s;
+    }
+  }
+
+  if (jsonPath.size()) {
+    std::ofstream f(jsonPath);
+    if (!f.good()) {
+      std::cerr << "Could not write " << jsonPath << std::endl;
+      return 1;
+    }
+    f << out.dump(2) << "\n";
+  }
+
+  return 0;
+}
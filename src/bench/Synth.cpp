@@ -0,0 +1,129 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench/MicroBench.h"
+#include "util/geo/Geo.h"
+
+using bench::SYNTH_ORIGIN_X;
+using bench::SYNTH_ORIGIN_Y;
+using bench::SYNTH_SPACING;
+using shared::linegraph::Line;
+using shared::linegraph::LineEdge;
+using shared::linegraph::LineGraph;
+using shared::linegraph::LineNode;
+using shared::linegraph::Station;
+using util::geo::DPoint;
+
+namespace {
+typedef std::vector<std::pair<size_t, size_t>> Path;
+
+// _____________________________________________________________________________
+std::vector<std::pair<Line*, Path>> linePaths(size_t n) {
+  std::vector<std::pair<Line*, Path>> ret;
+  const char* colors[] = {"e41a1c", "377eb8", "4daf4a", "984ea3", "ff7f00"};
+
+  auto add = [&](const std::string& id, const Path& p) {
+    if (p.size() < 2) return;
+    ret.push_back({new Line(id, id, colors[ret.size() % 5]), p});
+  };
+
+  for (size_t i = 0; i < n; i++) {
+    Path row, col;
+    for (size_t j = 0; j < n; j++) {
+      row.push_back({j, i});
+      col.push_back({i, j});
+    }
+    add("r" + std::to_string(i) + "a", row);
+    add("r" + std::to_string(i) + "b", row);
+    add("c" + std::to_string(i) + "a", col);
+    add("c" + std::to_string(i) + "b", col);
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    // alternately one step right and one step up, until the border
+    Path stairs{{0, i}};
+    for (size_t step = 0;; step++) {
+      auto p = stairs.back();
+      if (step % 2 == 0) p.first++;
+      else p.second++;
+      if (p.first >= n || p.second >= n) break;
+      stairs.push_back(p);
+    }
+    add("s" + std::to_string(i), stairs);
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::string statId(size_t x, size_t y) {
+  return std::to_string(x) + "-" + std::to_string(y);
+}
+}  // namespace
+
+// _____________________________________________________________________________
+void bench::buildNetwork(size_t n, bool split, std::mt19937_64* rng,
+                         LineGraph* g) {
+  std::uniform_real_distribution<double> jitter(-1, 1);
+  auto pos = [&](size_t x, size_t y, double off) {
+    return DPoint(SYNTH_ORIGIN_X + x * SYNTH_SPACING + off + jitter(*rng),
+                  SYNTH_ORIGIN_Y + y * SYNTH_SPACING + off + jitter(*rng));
+  };
+
+  auto paths = linePaths(n);
+  for (const auto& lp : paths) g->addLine(lp.first);
+
+  if (split) {
+    for (size_t i = 0; i < paths.size(); i++) {
+      // well within the aggregation distance of topo
+      double off = (static_cast<double>(i % 7) - 3) * 4;
+      LineNode* prev = 0;
+      for (const auto& p : paths[i].second) {
+        auto nd = g->addNd(pos(p.first, p.second, off));
+        g->expandBBox(*nd->pl().getGeom());
+        nd->pl().addStop(Station(statId(p.first, p.second),
+                                 "Station " + statId(p.first, p.second),
+                                 *nd->pl().getGeom()));
+        if (prev) {
+          auto e = g->addEdg(prev, nd,
+                             util::geo::PolyLine<double>(
+                                 *prev->pl().getGeom(), *nd->pl().getGeom()));
+          e->pl().addLine(paths[i].first, 0);
+        }
+        prev = nd;
+      }
+    }
+    return;
+  }
+
+  std::vector<std::vector<LineNode*>> nds(n, std::vector<LineNode*>(n));
+  for (size_t x = 0; x < n; x++) {
+    for (size_t y = 0; y < n; y++) {
+      nds[x][y] = g->addNd(pos(x, y, 0));
+      g->expandBBox(*nds[x][y]->pl().getGeom());
+      nds[x][y]->pl().addStop(Station(statId(x, y), "Station " + statId(x, y),
+                                      *nds[x][y]->pl().getGeom()));
+    }
+  }
+
+  std::map<std::pair<LineNode*, LineNode*>, LineEdge*> edgs;
+  for (const auto& lp : paths) {
+    for (size_t i = 1; i < lp.second.size(); i++) {
+      auto a = nds[lp.second[i - 1].first][lp.second[i - 1].second];
+      auto b = nds[lp.second[i].first][lp.second[i].second];
+      auto& e = edgs[{a, b}];
+      if (!e) {
+        e = g->addEdg(a, b,
+                      util::geo::PolyLine<double>(*a->pl().getGeom(),
+                                                  *b->pl().getGeom()));
+      }
+      e->pl().addLine(lp.first, 0);
+    }
+  }
+}
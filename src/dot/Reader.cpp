@@ -0,0 +1,294 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include "dot/Reader.h"
+
+using dot::parser::AttrKey;
+using dot::parser::Reader;
+using dot::parser::Stmt;
+
+static const size_t BLOCK_SIZE = 1 << 20;
+
+// _____________________________________________________________________________
+Reader::Reader(std::istream* is)
+    : _is(is),
+      _buf(BLOCK_SIZE),
+      _pos(0),
+      _end(0),
+      _level(std::numeric_limits<size_t>::max()),
+      _hasPeek(false) {
+  _ret.graphType = GRAPH;
+}
+
+// _____________________________________________________________________________
+bool Reader::has() { return _level > 0; }
+
+// _____________________________________________________________________________
+const Stmt& Reader::get() {
+  compact();
+
+  _ret.ids.clear();
+  _ret.type = EMPTY;
+  _ret.present = 0;
+  _idOffs.clear();
+
+  if (_level == std::numeric_limits<size_t>::max()) {
+    readHeader();
+    _level = 1;
+  }
+
+  while (true) {
+    _ret.level = _level;
+    Tok t = next();
+
+    if (t.type == T_EOF) err("Syntax error.");
+
+    if (t.type == T_CHAR) {
+      if (t.c == ';') continue;
+      if (t.c == '{') {
+        _level++;
+        continue;
+      }
+      if (t.c == '}') {
+        if (--_level == 0) return _ret;
+        continue;
+      }
+      err("Expected statement");
+    }
+
+    if (t.type != T_ID) err("Expected statement");
+
+    auto id = view(t);
+
+    if (id == "subgraph") {
+      if (peek().type == T_ID) next();
+      const auto& o = next();
+      if (o.type != T_CHAR || o.c != '{') err("Expected opening {");
+      _level++;
+      continue;
+    }
+
+    if (id == "graph") _ret.type = ATTR_GRAPH;
+    if (id == "node") _ret.type = ATTR_NODE;
+    if (id == "edge") _ret.type = ATTR_EDGE;
+
+    _idOffs.push_back({t.off, t.len});
+
+    if (peek().type == T_CHAR && peek().c == '=') {
+      if (_ret.type != EMPTY) err("Syntax error.");
+      next();
+      const auto& v = next();
+      if (v.type != T_ID) err("Expected ID");
+      _idOffs.push_back({v.off, v.len});
+      _ret.type = ATTR;
+    } else {
+      while (peek().type == T_EDGE_OP) {
+        if (_ret.type != EMPTY && _ret.type != EDGE) err("Syntax error.");
+        bool directed = next().c == '>';
+        bool digraph =
+            _ret.graphType == STRICT_DIGRAPH || _ret.graphType == DIGRAPH;
+        if (directed && !digraph) {
+          err("No directed edges allowed in undirected graph.");
+        }
+        if (!directed && digraph) {
+          err("No undirected edges allowed in directed graph.");
+        }
+        _ret.type = EDGE;
+
+        const auto& v = next();
+        if (v.type == T_CHAR && v.c == '{') {
+          err("Subgraphs in edge statements not yet supported.");
+        }
+        if (v.type != T_ID) err("Expected ID");
+        _idOffs.push_back({v.off, v.len});
+      }
+
+      while (peek().type == T_CHAR && peek().c == '[') {
+        next();
+        readAttrs();
+      }
+
+      if (_ret.type == EMPTY) _ret.type = NODE;
+    }
+
+    for (const auto& o : _idOffs) {
+      _ret.ids.push_back(std::string_view(_buf.data() + o.first, o.second));
+    }
+
+    for (size_t k = 0; k < NUM_ATTR_KEYS; k++) {
+      if (!_ret.has(AttrKey(k))) continue;
+      _ret.attrs[k] = std::string_view(_buf.data() + _attrOffs[k].first,
+                                       _attrOffs[k].second);
+    }
+
+    return _ret;
+  }
+}
+
+// _____________________________________________________________________________
+void Reader::readHeader() {
+  Tok t = next();
+  if (t.type != T_ID) err("Expected keywords 'strict', 'graph' or 'digraph'");
+
+  std::string kw(view(t));
+  for (auto& c : kw) c = std::tolower(c);
+
+  bool strict = false;
+  if (kw == "strict") {
+    strict = true;
+    t = next();
+    if (t.type != T_ID) err("Expected keyword 'graph' or 'digraph'");
+    kw = view(t);
+    for (auto& c : kw) c = std::tolower(c);
+  }
+
+  if (kw == "graph") {
+    _ret.graphType = strict ? STRICT_GRAPH : GRAPH;
+  } else if (kw == "digraph") {
+    _ret.graphType = strict ? STRICT_DIGRAPH : DIGRAPH;
+  } else {
+    err("Expected keywords 'strict', 'graph' or 'digraph'");
+  }
+
+  t = next();
+  if (t.type == T_ID) t = next();
+  if (t.type != T_CHAR || t.c != '{') err("Expected graph id or opening {");
+}
+
+// _____________________________________________________________________________
+void Reader::readAttrs() {
+  while (true) {
+    Tok t = next();
+    if (t.type == T_CHAR && t.c == ']') return;
+    if (t.type == T_CHAR && (t.c == ';' || t.c == ',')) continue;
+    if (t.type != T_ID) err("Expected attribute key");
+
+    AttrKey k = getKey(view(t));
+
+    t = next();
+    if (t.type != T_CHAR || t.c != '=') err("Expected '='");
+
+    t = next();
+    if (t.type != T_ID) err("Expected attribute value");
+
+    if (k != NUM_ATTR_KEYS) {
+      _attrOffs[k] = {t.off, t.len};
+      _ret.present |= 1 << k;
+    }
+  }
+}
+
+// _____________________________________________________________________________
+Reader::Tok Reader::next() {
+  if (_hasPeek) {
+    _hasPeek = false;
+    return _peek;
+  }
+
+  int c;
+  while ((c = peekc()) != -1 && std::isspace(c)) _pos++;
+
+  if (c == -1) return {T_EOF, 0, 0, 0};
+
+  if (c == '"') {
+    _pos++;
+    size_t start = _pos;
+    int prev = 0;
+    while ((c = peekc()) != '"' || prev == '\\') {
+      if (c == -1) err("Syntax error.");
+      prev = c;
+      _pos++;
+    }
+    _pos++;
+    return {T_ID, start, _pos - 1 - start, 0};
+  }
+
+  if (isIDChar(c)) {
+    size_t start = _pos;
+    while ((c = peekc()) != -1 && isIDChar(c)) _pos++;
+    return {T_ID, start, _pos - start, 0};
+  }
+
+  _pos++;
+
+  if (c == '-') {
+    c = peekc();
+    if (c != '-' && c != '>') err("Expected edge operator");
+    _pos++;
+    return {T_EDGE_OP, 0, 0, char(c)};
+  }
+
+  return {T_CHAR, 0, 0, char(c)};
+}
+
+// _____________________________________________________________________________
+const Reader::Tok& Reader::peek() {
+  if (!_hasPeek) {
+    _peek = next();
+    _hasPeek = true;
+  }
+  return _peek;
+}
+
+// _____________________________________________________________________________
+std::string_view Reader::view(const Tok& t) const {
+  return std::string_view(_buf.data() + t.off, t.len);
+}
+
+// _____________________________________________________________________________
+int Reader::peekc() {
+  if (_pos == _end && !fill()) return -1;
+  return static_cast<unsigned char>(_buf[_pos]);
+}
+
+// _____________________________________________________________________________
+bool Reader::fill() {
+  // grow the buffer if a single statement does not fit
+  if (_end == _buf.size()) _buf.resize(_buf.size() * 2);
+
+  _is->read(_buf.data() + _end, _buf.size() - _end);
+  _end += _is->gcount();
+
+  return _pos < _end;
+}
+
+// _____________________________________________________________________________
+void Reader::compact() {
+  // no views into the buffer are alive between statements, move the unread
+  // rest (and a peeked token) to the front
+  size_t from = _pos;
+  if (_hasPeek && _peek.type == T_ID) from = std::min(from, _peek.off);
+  if (from == 0) return;
+
+  memmove(_buf.data(), _buf.data() + from, _end - from);
+  _end -= from;
+  _pos -= from;
+  if (_hasPeek && _peek.type == T_ID) _peek.off -= from;
+}
+
+// _____________________________________________________________________________
+bool Reader::isIDChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+}
+
+// _____________________________________________________________________________
+AttrKey Reader::getKey(std::string_view k) {
+  if (k == "pos") return POS;
+  if (k == "station_id") return STATION_ID;
+  if (k == "label") return LABEL;
+  if (k == "id") return ID;
+  if (k == "color") return COLOR;
+  return NUM_ATTR_KEYS;
+}
+
+// _____________________________________________________________________________
+void Reader::err(const char* msg) {
+  std::cerr << msg << std::endl;
+  exit(1);
+}
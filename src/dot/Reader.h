@@ -0,0 +1,90 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef DOT_READER_H_
+#define DOT_READER_H_
+
+#include <stdint.h>
+#include <istream>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "dot/Parser.h"
+
+namespace dot {
+namespace parser {
+
+// attribute keys understood by the graph readers
+enum AttrKey { POS, STATION_ID, LABEL, ID, COLOR, NUM_ATTR_KEYS };
+
+struct Stmt {
+  EntityType type;
+  std::vector<std::string_view> ids;
+
+  // values of the known attributes, valid if the bit of the key is set in
+  // present
+  std::string_view attrs[NUM_ATTR_KEYS];
+  uint8_t present;
+
+  GraphType graphType;
+  size_t level;
+
+  bool has(AttrKey k) const { return present & (1 << k); }
+};
+
+// Buffered single-pass DOT reader accepting the same statements as Parser.
+// The input is read in large blocks, ids and attribute values are views into
+// the read buffer and stay valid until the next call of get(). Attributes
+// not in AttrKey are skipped without being copied.
+class Reader {
+ public:
+  explicit Reader(std::istream* s);
+  const Stmt& get();
+
+  bool has();
+
+ private:
+  enum TokType { T_EOF, T_ID, T_EDGE_OP, T_CHAR };
+
+  struct Tok {
+    TokType type;
+    size_t off, len;
+    char c;
+  };
+
+  std::istream* _is;
+  std::vector<char> _buf;
+  size_t _pos, _end;
+
+  Stmt _ret;
+  size_t _level;
+
+  bool _hasPeek;
+  Tok _peek;
+
+  // token offsets of the current statement, converted to views once the
+  // statement is complete, as the buffer may grow while reading it
+  std::vector<std::pair<size_t, size_t>> _idOffs;
+  std::pair<size_t, size_t> _attrOffs[NUM_ATTR_KEYS];
+
+  int peekc();
+  bool fill();
+  void compact();
+
+  Tok next();
+  const Tok& peek();
+  std::string_view view(const Tok& t) const;
+
+  void readHeader();
+  void readAttrs();
+
+  static bool isIDChar(char c);
+  static AttrKey getKey(std::string_view k);
+  [[noreturn]] static void err(const char* msg);
+};
+
+}  // namespace parser
+}  // namespace dot
+
+#endif  // DOT_READER_H_
@@ -0,0 +1,261 @@
+// Copyright 2017
+// University of Freiburg - Chair of Algorithms and Datastructures
+// Author: Patrick Brosi
+
+#include <sys/stat.h>
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ad/cppgtfs/Parser.h"
+#include "ad/cppgtfs/gtfs/Service.h"
+#include "gtfs2graph/Gtfs2Graph.h"
+#include "gtfs2graph/builder/Builder.h"
+#include "gtfs2graph/config/ConfigReader.h"
+#include "gtfs2graph/config/GraphBuilderConfig.h"
+#include "gtfs2graph/feed/FeedFilter.h"
+#include "gtfs2graph/graph/BuildGraph.h"
+#include "gtfs2graph/graph/EdgePL.h"
+#include "gtfs2graph/graph/NodePL.h"
+#include "gtfs2graph/stats/NetworkStats.h"
+#include "shared/io/CompressedStream.h"
+#include "shared/linegraph/BinGraph.h"
+#include "shared/threads/ThreadBudget.h"
+#include "shared/trace/Metrics.h"
+#include "shared/trace/Trace.h"
+#include "util/String.h"
+#include "util/geo/output/GeoGraphJsonOutput.h"
+#include "util/log/Log.h"
+
+using namespace gtfs2graph;
+using shared::linegraph::BIN_GRAPH_NONE;
+using shared::linegraph::BinGraphWriter;
+using shared::linegraph::LineBands;
+using std::string;
+
+namespace {
+// _____________________________________________________________________________
+void printBin(const graph::BuildGraph& g, std::ostream* out) {
+  BinGraphWriter w(out);
+  std::unordered_map<const graph::Node*, uint32_t> ids;
+
+  // the lines are added with their time bands before the connection
+  // exceptions refer to them
+  for (const auto nd : g.getNds()) {
+    for (const auto e : nd->getAdjListOut()) {
+      if (!e->pl().getRefETG()) continue;
+      for (const auto& r : e->pl().getRefETG()->getTripsUnordered()) {
+        w.addLine(util::toString(r.route), r.route->getShortName(),
+                  r.route->getColorString(),
+                  r.bands ? *r.bands : LineBands());
+      }
+    }
+  }
+
+  for (const auto nd : g.getNds()) {
+    ids[nd] = w.addNd(nd->pl().getPos(), BIN_GRAPH_NONE);
+    if (nd->pl().getStops().size() > 0) {
+      const auto* st = *nd->pl().getStops().begin();
+      w.addStation(ids[nd], nd->pl().getStationId(), st->getName(),
+                   nd->pl().getNumTrips(), nd->pl().getNumRoutes());
+    }
+  }
+
+  for (const auto nd : g.getNds()) {
+    for (const auto& ex : nd->pl().getExcludedConnections()) {
+      auto l = w.addLine(util::toString(ex.route), ex.route->getShortName(),
+                         ex.route->getColorString());
+      w.addConnExc(ids[nd], l, ids[ex.from], ids[ex.to]);
+    }
+
+    for (const auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+
+      util::geo::DLine geom;
+      if (e->pl().getGeom()) {
+        geom = *e->pl().getGeom();
+      } else {
+        geom = {e->getFrom()->pl().getPos(), e->getTo()->pl().getPos()};
+      }
+
+      auto eid = w.addEdg(ids[e->getFrom()], ids[e->getTo()], geom,
+                          BIN_GRAPH_NONE, false);
+
+      if (!e->pl().getRefETG()) continue;
+
+      for (const auto& r : e->pl().getRefETG()->getTripsUnordered()) {
+        auto l = w.addLine(util::toString(r.route), r.route->getShortName(),
+                           r.route->getColorString());
+        w.addLineOcc(eid, l, r.direction ? ids[r.direction] : BIN_GRAPH_NONE,
+                     "", "");
+      }
+    }
+  }
+
+  w.flush();
+}
+
+// _____________________________________________________________________________
+void writeGraph(const graph::BuildGraph& g, const config::Config& cfg,
+                std::ostream* out) {
+  if (cfg.outputFormat == "bin") {
+    printBin(g, out);
+  } else {
+    util::geo::output::GeoGraphJsonOutput json;
+    json.printLatLng(g, *out);
+  }
+}
+
+// _____________________________________________________________________________
+int writeModes(const config::Config& cfg,
+               const std::vector<const ad::cppgtfs::gtfs::Feed*>& feeds) {
+  mkdir(cfg.outDir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+
+  std::vector<std::string> errors(cfg.modes.size());
+
+  TRACE_PHASE("build modes");
+
+  // each mode has its own builder and graph, the feeds are only read
+#pragma omp parallel for schedule(dynamic) num_threads(cfg.threads) \
+    if (cfg.modes.size() > 1)
+  for (size_t i = 0; i < cfg.modes.size(); i++) {
+    const auto& mode = cfg.modes[i];
+
+    // feed MOTs given with #MOTS are restricted to the mode
+    auto in = cfg.inputFeeds;
+    for (auto& f : in) {
+      std::set<ad::cppgtfs::gtfs::flat::Route::TYPE> mots;
+      for (auto mot : f.mots) {
+        if (mode.mots.count(mot)) mots.insert(mot);
+      }
+      f.mots = mots;
+    }
+
+    graph::BuildGraph g;
+    Builder b(&cfg);
+    b.consume(feeds, in, &g);
+    b.simplify(&g);
+
+    std::string path = cfg.outDir + "/" + mode.name + "." + cfg.outputFormat;
+    if (cfg.compress == shared::io::CODEC_GZIP) path += ".gz";
+    if (cfg.compress == shared::io::CODEC_ZSTD) path += ".zst";
+
+    std::ofstream fOut(path, std::ios::binary);
+    if (!fOut.good()) {
+      errors[i] = "Could not open " + path;
+      continue;
+    }
+
+    {
+      std::ostream* out = &fOut;
+      shared::io::CompressedOut zOut(cfg.compress, 1, &out);
+      writeGraph(g, cfg, out);
+    }
+
+    if (!fOut.good()) errors[i] = "Could not write " + path;
+  }
+
+  int ret = 0;
+  for (const auto& err : errors) {
+    if (err.empty()) continue;
+    LOG(ERROR) << err;
+    ret = 1;
+  }
+
+  return ret;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+int gtfs2graph::run(int argc, char** argv, std::ostream* outStr) {
+  config::Config cfg;
+
+  config::ConfigReader cr;
+  cr.read(&cfg, argc, argv);
+
+  shared::threads::setBudget(cfg.threadBudget);
+
+  shared::trace::Trace::open(cfg.tracePath, "gtfs2graph");
+  shared::trace::Metrics::open(cfg.metricsPath, "gtfs2graph");
+
+  shared::io::CompressedOut zOut(cfg.compress, cfg.threadBudget, &outStr);
+
+  if (!cfg.inputFeedPath.empty()) {
+    std::vector<std::unique_ptr<ad::cppgtfs::gtfs::Feed>> feeds;
+    std::vector<std::string> errors(cfg.inputFeeds.size());
+    for (size_t i = 0; i < cfg.inputFeeds.size(); i++) {
+      feeds.emplace_back(new ad::cppgtfs::gtfs::Feed());
+    }
+
+    {
+      TRACE_PHASE("read feed");
+
+      // the feeds are independent of each other and parsed concurrently
+#pragma omp parallel for schedule(dynamic) num_threads(cfg.threads) \
+    if (feeds.size() > 1)
+      for (size_t i = 0; i < feeds.size(); i++) {
+        const auto& path = cfg.inputFeeds[i].path;
+        try {
+          // statistics are always computed on the complete feed
+          std::unique_ptr<feed::FeedFilter> filter;
+          if (cfg.statsPath.empty()) {
+            filter.reset(new feed::FeedFilter(path, &cfg));
+          }
+
+          ad::cppgtfs::Parser parser(filter ? filter->getPath() : path);
+          parser.parse(feeds[i].get());
+        } catch (const ad::cppgtfs::ParserException& ex) {
+          errors[i] = ex.what();
+        }
+      }
+    }
+
+    for (size_t i = 0; i < errors.size(); i++) {
+      if (errors[i].empty()) continue;
+      LOG(ERROR) << "Could not parse input GTFS feed "
+                 << cfg.inputFeeds[i].path << ", reason was:";
+      std::cerr << errors[i] << std::endl;
+      exit(1);
+    }
+
+    if (!cfg.statsPath.empty()) {
+      stats::NetworkStats st(&cfg);
+      st.consume(*feeds.front());
+      return st.write(cfg.statsPath) ? 0 : 1;
+    }
+
+    std::vector<const ad::cppgtfs::gtfs::Feed*> fs;
+    for (const auto& f : feeds) fs.push_back(f.get());
+
+    if (!cfg.outDir.empty()) return writeModes(cfg, fs);
+
+    gtfs2graph::graph::BuildGraph g;
+    Builder b(&cfg);
+
+    {
+      TRACE_PHASE("build graph");
+      b.consume(fs, cfg.inputFeeds, &g);
+    }
+
+    {
+      TRACE_PHASE("simplify");
+      b.simplify(&g);
+    }
+
+    if (shared::trace::Metrics::enabled()) {
+      size_t numEdgs = 0;
+      for (auto nd : g.getNds()) numEdgs += nd->getAdjListOut().size();
+      shared::trace::Metrics::count("nodes", g.getNds().size());
+      shared::trace::Metrics::count("edges", numEdgs);
+    }
+
+    TRACE_PHASE("write");
+    writeGraph(g, cfg, outStr);
+  }
+
+  return 0;
+}
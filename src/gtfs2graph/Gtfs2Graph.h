@@ -0,0 +1,18 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef GTFS2GRAPH_GTFS2GRAPH_H_
+#define GTFS2GRAPH_GTFS2GRAPH_H_
+
+#include <iostream>
+
+namespace gtfs2graph {
+
+// Run gtfs2graph with the given command line arguments, the line graph of
+// the GTFS feed given in the arguments is written to outStr.
+int run(int argc, char** argv, std::ostream* outStr);
+
+}  // namespace gtfs2graph
+
+#endif  // GTFS2GRAPH_GTFS2GRAPH_H_
@@ -2,6 +2,18 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <fnmatch.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 #include "ad/cppgtfs/gtfs/Feed.h"
 #include "gtfs2graph/builder/Builder.h"
 #include "gtfs2graph/graph/BuildGraph.h"
@@ -19,6 +31,7 @@ using util::geo::DBox;
 using util::geo::DPoint;
 using util::geo::extendBox;
 using util::geo::Grid;
+using util::geo::LinePoint;
 using util::geo::Point;
 using util::geo::PolyLine;
 using util::geo::SharedSegments;
@@ -27,72 +40,470 @@ using graph::Edge;
 using graph::Node;
 
 using ad::cppgtfs::gtfs::Feed;
+using ad::cppgtfs::gtfs::ServiceDate;
 using ad::cppgtfs::gtfs::Shape;
 using ad::cppgtfs::gtfs::Stop;
 using ad::cppgtfs::gtfs::StopTime;
 using ad::cppgtfs::gtfs::Trip;
 
+// the minimum length of the shape part behind the previous stop which is
+// searched for the next stop, in web mercator units
+static const double SHAPE_LOOKAHEAD = 1000;
+
+// _____________________________________________________________________________
+// a trip runs in [from, to) if it departs from its first stop before the end
+// and arrives at its last stop after the start, -1 means open
+static bool runsIn(const Trip* t, int from, int to) {
+  int dep = t->getStopTimes().begin()->getDepartureTime().seconds();
+  int arr = t->getStopTimes().rbegin()->getArrivalTime().seconds();
+  if (to >= 0 && dep >= to) return false;
+  if (from >= 0 && arr < from) return false;
+  return true;
+}
+
 // _____________________________________________________________________________
 Builder::Builder(const config::Config* cfg) : _cfg(cfg) {}
 
 // _____________________________________________________________________________
 void Builder::consume(const Feed& f, BuildGraph* g) {
-  DBox graphBox(getProjP(f.getMinLat(), f.getMinLon()),
-                getProjP(f.getMaxLat(), f.getMaxLon()));
+  consume({&f}, {{_cfg->inputFeedPath, _cfg->useMots, ""}}, g);
+}
+
+// _____________________________________________________________________________
+void Builder::consume(const std::vector<const Feed*>& feeds,
+                      const std::vector<config::InputFeed>& in,
+                      BuildGraph* g) {
+  // the grid covers all feeds, stops are snapped across feeds through it
+  DBox graphBox;
+  for (auto f : feeds) {
+    graphBox = extendBox(getProjP(f->getMinLat(), f->getMinLon()), graphBox);
+    graphBox = extendBox(getProjP(f->getMaxLat(), f->getMaxLon()), graphBox);
+  }
 
   NodeGrid ngrid(2000, 2000, graphBox);
 
-  size_t i = 0;
+  for (size_t i = 0; i < feeds.size(); i++) {
+    _feed = i;
+    _idPrefix = in[i].idPrefix;
+    projectStops(*feeds[i]);
+    consumeFeed(*feeds[i], in[i], g, &ngrid);
+  }
+
+  _stopPos.clear();
+}
+
+// _____________________________________________________________________________
+void Builder::projectStops(const Feed& f) {
+  std::vector<const Stop*> stops;
+  for (auto s = f.getStops().begin(); s != f.getStops().end(); ++s) {
+    stops.push_back(s->second);
+  }
+
+  std::vector<DPoint> pos(stops.size());
+
+#pragma omp parallel for schedule(static) num_threads(_cfg->threads)
+  for (size_t i = 0; i < stops.size(); i++) {
+    pos[i] = getProjP(stops[i]->getLat(), stops[i]->getLng());
+  }
+
+  _stopPos.clear();
+  _stopPos.reserve(stops.size());
+  for (size_t i = 0; i < stops.size(); i++) _stopPos[stops[i]] = pos[i];
+}
+
+// _____________________________________________________________________________
+DPoint Builder::getStopPos(const Stop* s) const {
+  auto it = _stopPos.find(s);
+  if (it != _stopPos.end()) return it->second;
+  return getProjP(s->getLat(), s->getLng());
+}
+
+// _____________________________________________________________________________
+void Builder::consumeFeed(const Feed& f, const config::InputFeed& in,
+                          BuildGraph* g, NodeGrid* ngrid) {
+  // trips with the same route, shape and stop sequence form a pattern,
+  // which is only processed once, its first trip stands for all of them
+  std::vector<std::vector<Trip*>> patterns;
+  std::map<std::tuple<const void*, const void*, std::vector<const Stop*>>,
+           size_t>
+      patternIdx;
+  const auto& trips = filterTrips(f, in.mots);
+  countBands(trips);
+
+  for (auto t : trips) {
+    if (!_cfg->collapsePatterns) {
+      patterns.push_back({t});
+      continue;
+    }
+
+    std::vector<const Stop*> stops;
+    for (const auto& st : t->getStopTimes()) stops.push_back(st.getStop());
+
+    std::tuple<const void*, const void*, std::vector<const Stop*>> key(
+        t->getRoute(), t->getShape(), std::move(stops));
+    auto it = patternIdx.find(key);
+    if (it != patternIdx.end()) {
+      patterns[it->second].push_back(t);
+    } else {
+      patternIdx[key] = patterns.size();
+      patterns.push_back({t});
+    }
+  }
+
+  LOGTO(DEBUG, std::cerr) << trips.size() << " trips form " << patterns.size()
+                          << " trip patterns";
+
+  // process the patterns grouped by shape, in the order in which the shapes
+  // first occur, so every shape is projected once and can be dropped after
+  // its last use
+  std::unordered_map<Shape*, size_t> shapeRank;
+  for (const auto& pattern : patterns) {
+    shapeRank.insert({pattern.front()->getShape(), shapeRank.size()});
+  }
+
+  std::stable_sort(patterns.begin(), patterns.end(),
+                   [&shapeRank](const std::vector<Trip*>& a,
+                                const std::vector<Trip*>& b) {
+                     return shapeRank.find(a.front()->getShape())->second <
+                            shapeRank.find(b.front()->getShape())->second;
+                   });
+
+  std::unordered_map<Shape*, size_t> lastUse;
+  for (size_t i = 0; i < patterns.size(); i++) {
+    lastUse[patterns[i].front()->getShape()] = i;
+  }
+
+  // with multiple threads, the trip geometries of a batch of patterns are
+  // cut in parallel, and then added to the graph one pattern after the
+  // other, in the same order as without threads
+  size_t BATCH_SIZE = _cfg->threads > 1 ? 10000 : 1;
+  std::vector<std::vector<PolyLine<double>>> geoms;
+  std::vector<const ShapeGeom*> shapes;
+
+  for (size_t batch = 0; batch < patterns.size(); batch += BATCH_SIZE) {
+    size_t batchEnd = std::min(batch + BATCH_SIZE, patterns.size());
+
+    // project the shapes beforehand, the cache is not thread safe
+    shapes.clear();
+    for (size_t i = batch; i < batchEnd; i++) {
+      auto s = patterns[i].front()->getShape();
+      shapes.push_back(s ? &getShapeGeom(s) : 0);
+    }
+
+    geoms.clear();
+    geoms.resize(batchEnd - batch);
+#pragma omp parallel for schedule(dynamic, 64) num_threads(_cfg->threads)
+    for (size_t i = batch; i < batchEnd; i++) {
+      geoms[i - batch] = getTripGeoms(patterns[i].front(), shapes[i - batch]);
+    }
+
+    for (size_t i = batch; i < batchEnd; i++) {
+      auto t = patterns[i].front();
+      size_t geomI = 0;
+
+      auto st = t->getStopTimes().begin();
+
+      auto prev = *st;
+      const Edge* prevEdge = 0;
+      std::set<Node*> visited{addStop(prev.getStop(), g, ngrid)};
+      ++st;
+
+      if ((i + 1) % 100 == 0)
+        LOGTO(DEBUG, std::cerr)
+            << "@ pattern " << (i + 1) << "/" << patterns.size();
+
+      for (; st != t->getStopTimes().end(); ++st) {
+        const auto& cur = *st;
+
+        Node* fromNode = getNodeByStop(g, prev.getStop());
+        Node* toNode = addStop(cur.getStop(), g, ngrid);
+        visited.insert(toNode);
+
+        // TODO: we should also allow this, for round-trips
+        if (fromNode == toNode) continue;
+
+        Edge* exE = g->getEdg(fromNode, toNode);
+
+        if (!exE) {
+          exE = g->addEdg(fromNode, toNode, EdgePL());
+          exE->pl().setEdge(exE);
+        }
+
+        Node* directionNode = toNode;
+
+        if (prevEdge) {
+          fromNode->pl().connOccurs(t->getRoute(), prevEdge, exE);
+        }
+
+        exE->pl().addTrips(patterns[i], std::move(geoms[i - batch][geomI++]),
+                           directionNode);
+
+        prev = cur;
+        prevEdge = exE;
+      }
+
+      // a trip stopping twice at a station is counted once there
+      for (auto nd : visited) {
+        nd->pl().addTrips(t->getRoute(), patterns[i].size());
+      }
+    }
+
+    for (size_t i = batch; i < batchEnd; i++) {
+      auto s = patterns[i].front()->getShape();
+      if (s && lastUse[s] == i) evictShape(s);
+    }
+
+    trimShapeCache();
+  }
+}
+
+// _____________________________________________________________________________
+std::vector<Trip*> Builder::filterTrips(
+    const Feed& f,
+    const std::set<ad::cppgtfs::gtfs::flat::Route::TYPE>& mots) const {
+  std::vector<Trip*> ret;
+
+  ServiceDate day(_cfg->serviceDate % 100, (_cfg->serviceDate / 100) % 100,
+                  _cfg->serviceDate / 10000);
 
   for (auto t = f.getTrips().begin(); t != f.getTrips().end(); ++t) {
-    i++;
     // ignore trips with only one stop
     if (t->second->getStopTimes().size() < 2) continue;
-    if (!_cfg->useMots.count(t->second->getRoute()->getType())) continue;
+    auto r = t->second->getRoute();
+    if (!mots.count(r->getType())) continue;
 
-    auto st = t->second->getStopTimes().begin();
+    if (_cfg->serviceDate && !t->second->getService()->isActiveOn(day)) {
+      continue;
+    }
 
-    auto prev = *st;
-    const Edge* prevEdge = 0;
-    addStop(prev.getStop(), g, &ngrid);
-    ++st;
+    if (!runsIn(t->second, _cfg->timeFrom, _cfg->timeTo)) continue;
 
-    if (i % 100 == 0)
-      LOGTO(DEBUG, std::cerr) << "@ trip " << i << "/" << f.getTrips().size();
+    if (_cfg->bands.size() &&
+        std::none_of(_cfg->bands.begin(), _cfg->bands.end(),
+                     [&t](const config::TimeBand& b) {
+                       return runsIn(t->second, b.from, b.to);
+                     })) {
+      continue;
+    }
 
-    for (; st != t->second->getStopTimes().end(); ++st) {
-      const auto& cur = *st;
+    if (_cfg->routeIds.size() && !_cfg->routeIds.count(r->getId())) continue;
 
-      Node* fromNode = getNodeByStop(g, prev.getStop());
-      Node* toNode = addStop(cur.getStop(), g, &ngrid);
+    if (_cfg->routePatterns.size()) {
+      bool match = false;
+      for (const auto& pat : _cfg->routePatterns) {
+        if (fnmatch(pat.c_str(), r->getShortName().c_str(), 0) == 0) {
+          match = true;
+          break;
+        }
+      }
+      if (!match) continue;
+    }
 
-      // TODO: we should also allow this, for round-trips
-      if (fromNode == toNode) continue;
+    if (_cfg->stopIds.size()) {
+      bool serves = false;
+      for (const auto& st : t->second->getStopTimes()) {
+        auto stop = st.getStop();
+        if (_cfg->stopIds.count(stop->getId()) ||
+            (stop->getParentStation() &&
+             _cfg->stopIds.count(stop->getParentStation()->getId()))) {
+          serves = true;
+          break;
+        }
+      }
+      if (!serves) continue;
+    }
 
-      Edge* exE = g->getEdg(fromNode, toNode);
+    ret.push_back(t->second);
+  }
 
-      if (!exE) {
-        exE = g->addEdg(fromNode, toNode, EdgePL());
-        exE->pl().setEdge(exE);
-      }
+  if (_cfg->minTrips == 0 && _cfg->topRoutes == 0 && _cfg->minFrequency <= 0)
+    return ret;
+
+  // the frequency filter is a trip count over the hours of the time window
+  double hours = 24;
+  if (_cfg->timeFrom >= 0 || _cfg->timeTo >= 0) {
+    int from = std::max(0, _cfg->timeFrom);
+    int to = _cfg->timeTo >= 0 ? _cfg->timeTo : std::max(24 * 3600, from);
+    hours = std::max(0, to - from) / 3600.0;
+  }
+
+  size_t minTrips = std::max<size_t>(
+      _cfg->minTrips, std::ceil(_cfg->minFrequency * hours - 1e-9));
+
+  // route filters on the number of trips left per route
+  std::map<std::string, size_t> routeTrips;
+  for (auto t : ret) routeTrips[t->getRoute()->getId()]++;
+
+  std::vector<std::pair<size_t, std::string>> ranked;
+  for (const auto& rt : routeTrips) {
+    if (rt.second < minTrips) continue;
+    ranked.push_back({rt.second, rt.first});
+  }
+
+  // most trips first, ties broken by route id
+  std::sort(ranked.begin(), ranked.end(),
+            [](const std::pair<size_t, std::string>& a,
+               const std::pair<size_t, std::string>& b) {
+              if (a.first != b.first) return a.first > b.first;
+              return a.second < b.second;
+            });
+
+  if (_cfg->topRoutes > 0 && ranked.size() > _cfg->topRoutes) {
+    ranked.resize(_cfg->topRoutes);
+  }
 
-      Node* directionNode = toNode;
+  std::set<std::string> keep;
+  for (const auto& rt : ranked) keep.insert(rt.second);
 
-      std::pair<bool, PolyLine<double>> edgeGeom;
-      edgeGeom = getSubPolyLine(prev.getStop(), cur.getStop(), t->second,
-                                prev.getShapeDistanceTravelled(),
-                                cur.getShapeDistanceTravelled());
+  ret.erase(std::remove_if(ret.begin(), ret.end(),
+                           [&keep](const Trip* t) {
+                             return !keep.count(t->getRoute()->getId());
+                           }),
+            ret.end());
 
-      if (prevEdge) {
-        fromNode->pl().connOccurs(t->second->getRoute(), prevEdge, exE);
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<PolyLine<double>> Builder::getTripGeoms(
+    Trip* t, const ShapeGeom* shape) const {
+  std::vector<PolyLine<double>> ret;
+
+  auto st = t->getStopTimes().begin();
+  auto prev = *st;
+  ++st;
+
+  DPoint prevP = getStopPos(prev.getStop());
+
+  if (shape && shape->pl.getLine().size() < 2) shape = 0;
+
+  // the position of the previous stop on the shape, the shape is only
+  // walked forward from it
+  LinePoint<double> prevPos;
+
+  auto project = [&](const DPoint& p, double lookahead) {
+    auto pos = projectAfter(*shape, p, prevPos, lookahead);
+    // nothing near within the lookahead, search the rest of the shape
+    if (util::geo::dist(p, pos.p) > lookahead) {
+      pos = projectAfter(*shape, p, prevPos,
+                         std::numeric_limits<double>::infinity());
+    }
+    return pos;
+  };
+
+  if (shape) {
+    prevPos = LinePoint<double>(0, 0, shape->pl.getLine().front());
+    prevPos = project(prevP, SHAPE_LOOKAHEAD);
+  }
+
+  for (; st != t->getStopTimes().end(); ++st) {
+    const auto& cur = *st;
+
+    // every stop has its own node, see consume()
+    if (prev.getStop() == cur.getStop()) continue;
+
+    DPoint curP = getStopPos(cur.getStop());
+
+    if (!shape) {
+      ret.push_back(PolyLine<double>(prevP, curP));
+    } else {
+      LinePoint<double> curPos;
+      double distA = prev.getShapeDistanceTravelled();
+      double distB = cur.getShapeDistanceTravelled();
+
+      if (shape->dists.size() && distA >= 0 && distB >= distA) {
+        prevPos = getPointAtShapeDist(*shape, distA);
+        curPos = getPointAtShapeDist(*shape, distB);
+      } else {
+        curPos = project(curP, 3 * util::geo::dist(prevP, curP) +
+                                   SHAPE_LOOKAHEAD);
       }
 
-      exE->pl().addTrip(t->second, edgeGeom.second, directionNode);
+      ret.push_back(shape->pl.getSegment(prevPos, curPos));
+      prevPos = curPos;
+    }
+
+    prev = cur;
+    prevP = curP;
+  }
+
+  return ret;
+}
 
-      prev = cur;
-      prevEdge = exE;
+// _____________________________________________________________________________
+LinePoint<double> Builder::projectAfter(const ShapeGeom& s, const DPoint& p,
+                                        const LinePoint<double>& after,
+                                        double lookahead) const {
+  const auto& l = s.pl.getLine();
+  double len = s.lens.back();
+
+  LinePoint<double> best = after;
+  double bestD = util::geo::dist(p, after.p);
+  double walked = 0;
+
+  for (size_t i = after.lastIndex; i + 1 < l.size() && walked <= lookahead;
+       i++) {
+    const DPoint& a = i == after.lastIndex ? after.p : l[i];
+    const DPoint& b = l[i + 1];
+
+    double dx = b.getX() - a.getX();
+    double dy = b.getY() - a.getY();
+    double segLen = sqrt(dx * dx + dy * dy);
+    walked += segLen;
+    if (segLen == 0) continue;
+
+    double f = ((p.getX() - a.getX()) * dx + (p.getY() - a.getY()) * dy) /
+               (segLen * segLen);
+    f = std::min(1.0, std::max(0.0, f));
+
+    DPoint q(a.getX() + f * dx, a.getY() + f * dy);
+    double d = util::geo::dist(p, q);
+
+    if (d < bestD) {
+      bestD = d;
+      double pos = s.lens[i] + util::geo::dist(l[i], q);
+      best = LinePoint<double>(i, len > 0 ? pos / len : 0, q);
     }
   }
+
+  return best;
+}
+
+// _____________________________________________________________________________
+LinePoint<double> Builder::getPointAtShapeDist(const ShapeGeom& s,
+                                               double d) const {
+  const auto& ds = s.dists;
+  double frac = ds.back().second;
+
+  auto it = std::upper_bound(
+      ds.begin(), ds.end(), d,
+      [](double v, const std::pair<double, double>& p) { return v < p.first; });
+
+  if (it == ds.begin()) {
+    frac = ds.front().second;
+  } else if (it != ds.end()) {
+    auto pr = std::prev(it);
+    double span = it->first - pr->first;
+    frac = pr->second;
+    if (span > 0) {
+      frac += (it->second - pr->second) * (d - pr->first) / span;
+    }
+  }
+
+  // locate the fraction on the (possibly simplified) polyline
+  const auto& l = s.pl.getLine();
+  double tgt = frac * s.lens.back();
+  size_t i = std::upper_bound(s.lens.begin(), s.lens.end(), tgt) -
+             s.lens.begin();
+  i = std::min(l.size() - 1, std::max<size_t>(1, i)) - 1;
+
+  double segLen = s.lens[i + 1] - s.lens[i];
+  double f = segLen > 0 ? std::min(1.0, (tgt - s.lens[i]) / segLen) : 0;
+
+  DPoint q(l[i].getX() + f * (l[i + 1].getX() - l[i].getX()),
+           l[i].getY() + f * (l[i + 1].getY() - l[i].getY()));
+
+  return LinePoint<double>(i, frac, q);
 }
 
 // _____________________________________________________________________________
@@ -110,7 +521,7 @@ void Builder::simplify(BuildGraph* g) {
       if (e->getFrom() != n) continue;
       for (auto& etg : *e->pl().getEdgeTripGeoms()) {
         for (auto& r : *etg.getTripsUnordered()) {
-          avg += r.trips.size();
+          avg += r.numTrips;
           c++;
         }
       }
@@ -120,58 +531,124 @@ void Builder::simplify(BuildGraph* g) {
   avg /= c;
 
   // try to merge both-direction edges into a single one
-  // also prune edges with few trips
+  // also prune edges with few trips. Each edge only changes its own
+  // payload, so the edges are simplified in parallel
+  std::vector<Edge*> edgs;
   for (auto n : g->getNds()) {
     for (auto e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
-      e->pl().simplify(avg * _cfg->pruneThreshold);
+      edgs.push_back(e);
     }
   }
 
+#pragma omp parallel for schedule(dynamic, 64) num_threads(_cfg->threads)
+  for (size_t i = 0; i < edgs.size(); i++) {
+    edgs[i]->pl().simplify(avg * _cfg->pruneThreshold);
+  }
+
   // delete edges without a reference ETG
   std::vector<Edge*> toDel;
+  for (auto e : edgs) {
+    if (!e->pl().getRefETG()) toDel.push_back(e);
+  }
+
+  for (auto e : toDel) g->delEdg(e->getFrom(), e->getTo());
+
+  if (_bands.empty()) return;
+
   for (auto n : g->getNds()) {
     for (auto e : n->getAdjList()) {
-      if (e->getFrom() != n) continue;
-      if (!e->pl().getRefETG()) toDel.push_back(e);
+      if (e->getFrom() != n || !e->pl().getRefETG()) continue;
+      for (auto& r : *e->pl().getRefETG()->getTripsUnordered()) {
+        r.bands = &_bands[r.route];
+      }
     }
   }
-
-  for (auto e : toDel) g->delEdg(e->getFrom(), e->getTo());
 }
 
 // _____________________________________________________________________________
-std::pair<bool, PolyLine<double>> Builder::getSubPolyLine(const Stop* a,
-                                                          const Stop* b,
-                                                          Trip* t, double distA,
-                                                          double distB) {
-  UNUSED(distA);
-  UNUSED(distB);
-  DPoint ap = getProjP(a->getLat(), a->getLng());
-  DPoint bp = getProjP(b->getLat(), b->getLng());
+void Builder::countBands(const std::vector<Trip*>& trips) {
+  if (_cfg->bands.empty()) return;
+
+  // bands without trips are kept with a count of 0, so every route lists
+  // all bands
+  for (auto t : trips) {
+    auto& counts = _bands[t->getRoute()];
+    for (const auto& b : _cfg->bands) {
+      counts[b.name] += runsIn(t, b.from, b.to);
+    }
+  }
+}
 
-  if (!t->getShape()) {
-    return std::pair<bool, PolyLine<double>>(false, PolyLine<double>(ap, bp));
+// _____________________________________________________________________________
+const ShapeGeom& Builder::getShapeGeom(Shape* s) {
+  auto it = _shapeCacheIdx.find(s);
+  if (it != _shapeCacheIdx.end()) {
+    // mark as recently used
+    _shapeCache.splice(_shapeCache.end(), _shapeCache, it->second);
+    return it->second->second;
   }
 
-  auto pl = _polyLines.find(t->getShape());
-  if (pl == _polyLines.end()) {
-    // generate polyline for this shape
-    pl = _polyLines
-             .insert(std::pair<Shape*, PolyLine<double>>(t->getShape(),
-                                                         PolyLine<double>()))
-             .first;
+  // generate polyline for this shape
+  ShapeGeom geom;
+  PolyLine<double>& pl = geom.pl;
+  for (const auto& sp : s->getPoints()) pl << getProjP(sp.lat, sp.lng);
+
+  // the shape distances are only usable if they are given for all points
+  // and do not decrease
+  bool useDists = s->getPoints().size() > 1;
+  double prevDist = 0;
+  for (const auto& sp : s->getPoints()) {
+    if (sp.travelDist < prevDist) useDists = false;
+    prevDist = sp.travelDist;
+  }
 
-    for (const auto& sp : t->getShape()->getPoints()) {
-      pl->second << getProjP(sp.lat, sp.lng);
+  if (useDists &&
+      s->getPoints().back().travelDist > s->getPoints().front().travelDist) {
+    const auto& l = pl.getLine();
+    double len = 0;
+    for (size_t i = 0; i < l.size(); i++) {
+      if (i) len += util::geo::dist(l[i - 1], l[i]);
+      geom.dists.push_back({s->getPoints()[i].travelDist, len});
+    }
+    if (len > 0) {
+      for (auto& d : geom.dists) d.second /= len;
+    } else {
+      geom.dists.clear();
     }
   }
 
-  PolyLine<double> p;
+  if (_cfg->shapeSimplify > 0) pl.simplify(_cfg->shapeSimplify);
+
+  const auto& l = pl.getLine();
+  geom.lens.resize(l.size(), 0);
+  for (size_t i = 1; i < l.size(); i++) {
+    geom.lens[i] = geom.lens[i - 1] + util::geo::dist(l[i - 1], l[i]);
+  }
+
+  _shapeCachePoints += l.size() + geom.dists.size();
+  _shapeCache.push_back({s, std::move(geom)});
+  _shapeCacheIdx[s] = std::prev(_shapeCache.end());
+
+  return _shapeCache.back().second;
+}
 
-  p = pl->second.getSegment(ap, bp);
+// _____________________________________________________________________________
+void Builder::evictShape(Shape* s) {
+  auto it = _shapeCacheIdx.find(s);
+  if (it == _shapeCacheIdx.end()) return;
+
+  _shapeCachePoints -= it->second->second.pl.getLine().size() +
+                       it->second->second.dists.size();
+  _shapeCache.erase(it->second);
+  _shapeCacheIdx.erase(it);
+}
 
-  return std::pair<bool, PolyLine<double>>(true, p);
+// _____________________________________________________________________________
+void Builder::trimShapeCache() {
+  while (_shapeCache.size() && _shapeCachePoints > _cfg->shapeCacheSize) {
+    evictShape(_shapeCache.front().first);
+  }
 }
 
 // _____________________________________________________________________________
@@ -179,16 +656,34 @@ Node* Builder::addStop(const Stop* curStop, BuildGraph* g, NodeGrid* grid) {
   Node* n = getNodeByStop(g, curStop);
   if (n) return n;
 
-  DPoint p = getProjP(curStop->getLat(), curStop->getLng());
+  DPoint p = getStopPos(curStop);
+
+  // snap to the nearest stop node of a previous feed. The stop is not added
+  // to that node, so its station keeps the id of the feed it came from
+  if (_feed > 0 && _cfg->feedSnapDist > 0) {
+    std::set<Node*> cands;
+    grid->get(p, _cfg->feedSnapDist, &cands);
+
+    double best = _cfg->feedSnapDist;
+    for (auto cand : cands) {
+      if (_ndFeed[cand] == _feed) continue;
+      double d = util::geo::dist(p, cand->pl().getPos());
+      if (d < best || (!n && d <= best)) {
+        best = d;
+        n = cand;
+      }
+    }
+  }
 
   if (n) {
-    n->pl().addStop(curStop);
     _stopNodes[curStop] = n;
   } else {
     n = g->addNd(NodePL(p, curStop));
     n->pl().setNode(n);
+    n->pl().setStationIdPrefix(_idPrefix);
     grid->add(n->pl().getPos(), n);
     _stopNodes[curStop] = n;
+    _ndFeed[n] = _feed;
   }
 
   return n;
@@ -196,13 +691,18 @@ Node* Builder::addStop(const Stop* curStop, BuildGraph* g, NodeGrid* grid) {
 
 // _____________________________________________________________________________
 Node* Builder::getNodeByStop(const BuildGraph* g, const gtfs::Stop* s) const {
-  if (_stopNodes.find(s) != _stopNodes.end()) return _stopNodes.find(s)->second;
+  UNUSED(g);
+  auto it = _stopNodes.find(s);
+  if (it != _stopNodes.end()) return it->second;
 
+#ifndef NDEBUG
+  // every stop node is added through addStop(), and nodes are never
+  // merged or deleted, so no node may hold a stop missing from the map
   for (const auto n : g->getNds()) {
-    if (n->pl().getStops().find(const_cast<gtfs::Stop*>(s)) !=
-        n->pl().getStops().end()) {
-      return n;
-    }
+    assert(n->pl().getStops().find(const_cast<gtfs::Stop*>(s)) ==
+           n->pl().getStops().end());
   }
+#endif
+
   return 0;
 }
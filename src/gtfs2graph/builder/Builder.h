@@ -6,10 +6,15 @@
 #define GTFS2GRAPH_BUILDER_BUILDER_H_
 
 #include <algorithm>
+#include <list>
+#include <set>
+#include <string>
 #include <unordered_map>
+#include <vector>
 #include "ad/cppgtfs/gtfs/Feed.h"
 #include "gtfs2graph/config/GraphBuilderConfig.h"
 #include "gtfs2graph/graph/BuildGraph.h"
+#include "shared/linegraph/Line.h"
 #include "util/geo/Geo.h"
 #include "util/geo/Grid.h"
 #include "util/geo/PolyLine.h"
@@ -24,6 +29,7 @@ using util::geo::DLine;
 using util::geo::DPoint;
 using util::geo::Grid;
 using util::geo::Line;
+using util::geo::LinePoint;
 using util::geo::Point;
 using util::geo::PolyLine;
 using util::geo::SharedSegment;
@@ -33,6 +39,19 @@ typedef Grid<Edge*, Line, double> EdgeGrid;
 
 namespace gtfs2graph {
 
+// a projected shape, prepared for cutting it at the stops of its trips
+struct ShapeGeom {
+  PolyLine<double> pl;
+
+  // the length of pl up to each of its points
+  std::vector<double> lens;
+
+  // the shape_dist_traveled of each shape point, with the position of the
+  // point along pl as a fraction of its length. Empty if the shape has no
+  // usable distances
+  std::vector<std::pair<double, double>> dists;
+};
+
 class Builder {
  public:
   Builder(const config::Config* cfg);
@@ -40,22 +59,86 @@ class Builder {
   // build a BuildGraph from a gtfs feed
   void consume(const ad::cppgtfs::gtfs::Feed& f, BuildGraph* g);
 
-  // simplify the BuildGraph
+  // build a BuildGraph from several gtfs feeds, in order, feeds[i] was read
+  // from in[i]
+  void consume(const std::vector<const ad::cppgtfs::gtfs::Feed*>& feeds,
+               const std::vector<config::InputFeed>& in, BuildGraph* g);
+
+  // simplify the BuildGraph, the route occurrences of the result point to
+  // the per-band trip counts of their routes, which are owned by the builder
   void simplify(BuildGraph* g);
 
  private:
   const config::Config* _cfg;
 
-  std::map<const ad::cppgtfs::gtfs::Stop*, Node*> _stopNodes;
+  // the node of every stop added so far, the only stop to node index
+  std::unordered_map<const ad::cppgtfs::gtfs::Stop*, Node*> _stopNodes;
+
+  // the feed currently consumed, and the feed each node was created from
+  size_t _feed = 0;
+  std::string _idPrefix;
+  std::unordered_map<const Node*, size_t> _ndFeed;
+
+  // the number of trips of each route in each time band of the config
+  std::unordered_map<const ad::cppgtfs::gtfs::Route*,
+                     shared::linegraph::LineBands>
+      _bands;
+
+  // projected shape polylines, least recently used first
+  std::list<std::pair<ad::cppgtfs::gtfs::Shape*, ShapeGeom>> _shapeCache;
+  std::unordered_map<ad::cppgtfs::gtfs::Shape*,
+                     decltype(_shapeCache)::iterator>
+      _shapeCacheIdx;
+  size_t _shapeCachePoints = 0;
 
-  // map of compiled polylines, to avoid calculating them each time
-  std::unordered_map<ad::cppgtfs::gtfs::Shape*, PolyLine<double>> _polyLines;
+  // the projected positions of the stops of the feed currently consumed
+  std::unordered_map<const ad::cppgtfs::gtfs::Stop*, DPoint> _stopPos;
 
   DPoint getProjP(double lat, double lng) const;
 
-  std::pair<bool, PolyLine<double>> getSubPolyLine(
-      const ad::cppgtfs::gtfs::Stop* a, const ad::cppgtfs::gtfs::Stop* b,
-      ad::cppgtfs::gtfs::Trip* t, double distA, double distB);
+  // project all stops of a feed once, in parallel
+  void projectStops(const ad::cppgtfs::gtfs::Feed& f);
+
+  // the projected position of a stop, from the precomputed positions if
+  // possible
+  DPoint getStopPos(const ad::cppgtfs::gtfs::Stop* s) const;
+
+  void consumeFeed(const ad::cppgtfs::gtfs::Feed& f,
+                   const config::InputFeed& in, BuildGraph* g,
+                   NodeGrid* ngrid);
+
+  // the trips to build the graph from, in feed order
+  std::vector<ad::cppgtfs::gtfs::Trip*> filterTrips(
+      const ad::cppgtfs::gtfs::Feed& f,
+      const std::set<ad::cppgtfs::gtfs::flat::Route::TYPE>& mots) const;
+
+  // add the trips to the per-band trip counts of their routes
+  void countBands(const std::vector<ad::cppgtfs::gtfs::Trip*>& trips);
+
+  // the projected geometry of a shape, stays valid until the next call of
+  // evictShape() or trimShapeCache()
+  const ShapeGeom& getShapeGeom(ad::cppgtfs::gtfs::Shape* s);
+  void evictShape(ad::cppgtfs::gtfs::Shape* s);
+
+  // drop least recently used shapes until the cache is within its bound
+  void trimShapeCache();
+
+  // the geometries between consecutive stops of a trip, as consumed by
+  // consume(), shape may be 0. If both stops of a pair have a
+  // shape_dist_traveled, the shape is cut there. Otherwise, each stop is
+  // projected onto the shape after the position of the previous stop
+  std::vector<PolyLine<double>> getTripGeoms(ad::cppgtfs::gtfs::Trip* t,
+                                             const ShapeGeom* shape) const;
+
+  // the nearest point to p on the shape which is not before after. Only the
+  // part of the shape up to lookahead behind after is searched
+  LinePoint<double> projectAfter(const ShapeGeom& s, const DPoint& p,
+                                 const LinePoint<double>& after,
+                                 double lookahead) const;
+
+  // the point of the shape at a shape_dist_traveled, s.dists must not be
+  // empty
+  LinePoint<double> getPointAtShapeDist(const ShapeGeom& s, double d) const;
 
   Node* addStop(const ad::cppgtfs::gtfs::Stop* curStop, BuildGraph* g,
                 NodeGrid* grid);
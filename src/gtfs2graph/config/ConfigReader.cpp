@@ -5,13 +5,16 @@
 #include <float.h>
 #include <getopt.h>
 
+#include <cstring>
 #include <exception>
+#include <set>
 #include <iostream>
 #include <string>
 
 #include "ad/cppgtfs/gtfs/flat/Route.h"
 #include "gtfs2graph/_config.h"
 #include "gtfs2graph/config/ConfigReader.h"
+#include "shared/io/CompressedStream.h"
 #include "util/String.h"
 #include "util/log/Log.h"
 
@@ -36,7 +39,10 @@ void ConfigReader::help(const char* bin) const {
       << VERSION_FULL << "\n(built " << __DATE__ << " " << __TIME__ << ")"
       << "\n\n(C) 2017-" << YEAR << " " << COPY << "\n"
       << "Authors: " << AUTHORS << "\n\n"
-      << "Usage: " << bin << " <GTFS FEED>\n\n"
+      << "Usage: " << bin << " <GTFS FEED>[#MOTS] [<GTFS FEED>[#MOTS] ...]"
+      << "\n\nSeveral feeds are merged into one graph. MOTS override --mots"
+      << "\nfor a single feed, station ids are then prefixed with the feed"
+      << "\nnumber.\n\n"
       << "Allowed options:\n\n"
       << "General:\n"
       << std::setw(36) << "  -v [ --version ]"
@@ -62,7 +68,67 @@ void ConfigReader::help(const char* bin) const {
       << "  funicular, coach} or as GTFS mot codes\n"
       << std::setw(36) << "  -p [ --prune-threshold ] arg (=0)"
       << "Threshold for pruning of seldomly occuring\n"
-      << std::setw(36) << " " << "  lines, between 0 and 1\n";
+      << std::setw(36) << " " << "  lines, between 0 and 1\n"
+      << std::setw(36) << "  --format arg (=json)"
+      << "output format, either json or bin\n"
+      << std::setw(36) << "  --out-dir arg"
+      << "write one graph per comma sep. MOT of --mots\n"
+      << std::setw(36) << " " << "  to <arg>/<MOT>.<format>, parsing the\n"
+      << std::setw(36) << " " << "  feeds only once\n"
+      << std::setw(36) << "  --compress arg (=none)"
+      << "compress the output, none, gzip or zstd\n"
+      << std::setw(36) << "  -t [ --threads ] arg (=1)"
+      << "number of threads used to parse feeds and\n"
+      << std::setw(36) << " " << "  to cut trip geometries, also caps all\n"
+      << std::setw(36) << " " << "  other threads\n"
+      << std::setw(36) << "  --no-pattern-collapse"
+      << "process every trip on its own, not once per\n"
+      << std::setw(36) << " " << "  route, shape and stop sequence\n"
+      << std::setw(36) << "  --shape-cache-size arg (=1000000)"
+      << "max number of shape points kept in memory\n"
+      << std::setw(36) << "  --shape-simplify arg (=0)"
+      << "simplify shapes with this tolerance, in meters\n"
+      << std::setw(36) << "  --trace arg"
+      << "write a Chrome trace of the run to this file\n"
+      << std::setw(36) << "  --metrics-out arg"
+      << "write per-phase resource usage to this JSON file\n"
+      << std::setw(36) << "  --snap-dist arg (=50)"
+      << "merge stops of different feeds within this\n"
+      << std::setw(36) << " " << "  distance in meters into one station\n\n"
+      << "Filters:\n"
+      << std::setw(36) << "  --stops arg"
+      << "only trips serving one of these stops or\n"
+      << std::setw(36) << " " << "  stations, comma sep. stop ids\n"
+      << std::setw(36) << "  --routes arg"
+      << "only routes with a short name matching one\n"
+      << std::setw(36) << " " << "  of these comma sep. wildcards\n"
+      << std::setw(36) << "  --route-ids arg"
+      << "only routes with these comma sep. ids\n"
+      << std::setw(36) << "  --min-trips arg (=0)"
+      << "only routes with at least this many trips\n"
+      << std::setw(36) << "  --top-routes arg (=0)"
+      << "only this many routes with the most trips\n"
+      << std::setw(36) << "  --date arg"
+      << "only trips running on this day, YYYYMMDD\n"
+      << std::setw(36) << "  --time-from arg"
+      << "only trips running at or after HH:MM[:SS]\n"
+      << std::setw(36) << "  --time-to arg"
+      << "only trips running before HH:MM[:SS]\n"
+      << std::setw(36) << "  --min-frequency arg (=0)"
+      << "only routes with at least this many trips\n"
+      << std::setw(36) << " " << "  per hour in the time window\n"
+      << std::setw(36) << "  --bands arg"
+      << "count the trips of each line in these comma\n"
+      << std::setw(36) << " " << "  sep. time bands name=HH:MM-HH:MM, only\n"
+      << std::setw(36) << " " << "  trips in one of the bands are used\n\n"
+      << "Statistics:\n"
+      << std::setw(36) << "  --stats arg"
+      << "write stop and route statistics CSVs to\n"
+      << std::setw(36) << " " << "  dir <arg> instead of a graph\n"
+      << std::setw(36) << "  --trip-weight arg (=0.4)"
+      << "weight of trip count in stop importance\n"
+      << std::setw(36) << "  --route-weight arg (=0.6)"
+      << "weight of route count in stop importance\n";
 }
 
 // _____________________________________________________________________________
@@ -74,10 +140,33 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
                          {"help", no_argument, 0, 'h'},
                          {"mots", required_argument, 0, 'm'},
                          {"prune-threshold", required_argument, 0, 'p'},
+                         {"format", required_argument, 0, 1},
+                         {"threads", required_argument, 0, 't'},
+                         {"no-pattern-collapse", no_argument, 0, 2},
+                         {"shape-cache-size", required_argument, 0, 3},
+                         {"shape-simplify", required_argument, 0, 4},
+                         {"stops", required_argument, 0, 5},
+                         {"routes", required_argument, 0, 6},
+                         {"route-ids", required_argument, 0, 7},
+                         {"min-trips", required_argument, 0, 8},
+                         {"top-routes", required_argument, 0, 9},
+                         {"stats", required_argument, 0, 10},
+                         {"trip-weight", required_argument, 0, 11},
+                         {"route-weight", required_argument, 0, 12},
+                         {"trace", required_argument, 0, 13},
+                         {"metrics-out", required_argument, 0, 14},
+                         {"snap-dist", required_argument, 0, 15},
+                         {"date", required_argument, 0, 16},
+                         {"time-from", required_argument, 0, 17},
+                         {"time-to", required_argument, 0, 18},
+                         {"min-frequency", required_argument, 0, 19},
+                         {"compress", required_argument, 0, 20},
+                         {"out-dir", required_argument, 0, 21},
+                         {"bands", required_argument, 0, 22},
                          {0, 0, 0, 0}};
 
   int c;
-  while ((c = getopt_long(argc, argv, ":hvim:p:", ops, 0)) != -1) {
+  while ((c = getopt_long(argc, argv, ":hvim:p:t:", ops, 0)) != -1) {
     switch (c) {
       case 'h':
         help(argv[0]);
@@ -91,6 +180,93 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
       case 'p':
         pruneThreshold = atof(optarg);
         break;
+      case 1:
+        cfg->outputFormat = optarg;
+        break;
+      case 't':
+        cfg->threads = atoi(optarg);
+        cfg->threadBudget = cfg->threads;
+        break;
+      case 2:
+        cfg->collapsePatterns = false;
+        break;
+      case 3:
+        cfg->shapeCacheSize = atol(optarg);
+        break;
+      case 4:
+        cfg->shapeSimplify = atof(optarg);
+        break;
+      case 5:
+        for (const auto& id : util::split(optarg, ',')) {
+          cfg->stopIds.insert(id);
+        }
+        break;
+      case 6:
+        for (const auto& pat : util::split(optarg, ',')) {
+          cfg->routePatterns.push_back(pat);
+        }
+        break;
+      case 7:
+        for (const auto& id : util::split(optarg, ',')) {
+          cfg->routeIds.insert(id);
+        }
+        break;
+      case 8:
+        cfg->minTrips = atol(optarg);
+        break;
+      case 9:
+        cfg->topRoutes = atol(optarg);
+        break;
+      case 10:
+        cfg->statsPath = optarg;
+        break;
+      case 11:
+        cfg->importanceTripWeight = atof(optarg);
+        break;
+      case 12:
+        cfg->importanceRouteWeight = atof(optarg);
+        break;
+      case 13:
+        cfg->tracePath = optarg;
+        break;
+      case 14:
+        cfg->metricsPath = optarg;
+        break;
+      case 15:
+        cfg->feedSnapDist = atof(optarg);
+        break;
+      case 16:
+        cfg->serviceDate = atol(optarg);
+        if (strlen(optarg) != 8 || cfg->serviceDate % 100 < 1 ||
+            cfg->serviceDate % 100 > 31 || (cfg->serviceDate / 100) % 100 < 1 ||
+            (cfg->serviceDate / 100) % 100 > 12) {
+          std::cerr << "Invalid date " << optarg << ", must be YYYYMMDD."
+                    << std::endl;
+          exit(1);
+        }
+        break;
+      case 17:
+        cfg->timeFrom = parseTime(optarg);
+        break;
+      case 18:
+        cfg->timeTo = parseTime(optarg);
+        break;
+      case 19:
+        cfg->minFrequency = atof(optarg);
+        break;
+      case 20:
+        if (!shared::io::parseCodec(optarg, &cfg->compress)) {
+          std::cerr << "Unknown compression " << optarg
+                    << ", must be one of {none, gzip, zstd}" << std::endl;
+          exit(1);
+        }
+        break;
+      case 21:
+        cfg->outDir = optarg;
+        break;
+      case 22:
+        cfg->bands = parseBands(optarg);
+        break;
       case ':':
         std::cerr << argv[optind - 1];
         std::cerr << " requires an argument" << std::endl;
@@ -112,13 +288,140 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
     exit(1);
   }
 
-  cfg->inputFeedPath = argv[optind];
+  if (cfg->threads < 1) {
+    std::cerr << "Number of threads must be at least 1." << std::endl;
+    exit(1);
+  }
+
+  if (cfg->outputFormat != "json" && cfg->outputFormat != "bin") {
+    std::cerr << "Unknown output format " << cfg->outputFormat
+              << ", must be either json or bin." << std::endl;
+    exit(1);
+  }
+
+  if (!shared::io::hasCodec(cfg->compress)) {
+    std::cerr << shared::io::codecName(cfg->compress)
+              << " compression was not compiled in" << std::endl;
+    exit(1);
+  }
+
+  if (cfg->timeFrom >= 0 && cfg->timeTo >= 0 &&
+      cfg->timeTo <= cfg->timeFrom) {
+    std::cerr << "--time-to must be after --time-from." << std::endl;
+    exit(1);
+  }
+
+  if (!cfg->statsPath.empty() && argc - optind > 1) {
+    std::cerr << "Statistics can only be written for a single feed."
+              << std::endl;
+    exit(1);
+  }
+
+  if (!cfg->statsPath.empty() && !cfg->outDir.empty()) {
+    std::cerr << "--stats and --out-dir cannot be combined." << std::endl;
+    exit(1);
+  }
+
   cfg->pruneThreshold = pruneThreshold;
+  cfg->useMots = parseMots(motStr);
+
+  if (!cfg->outDir.empty()) {
+    for (const auto& name : util::split(motStr, ',')) {
+      auto mots = parseMots(name);
+      if (mots.empty()) {
+        std::cerr << "Unknown MOT " << name << "." << std::endl;
+        exit(1);
+      }
+      cfg->modes.push_back({name, mots});
+    }
+  }
+
+  for (int i = optind; i < argc; i++) {
+    std::string arg = argv[i];
+    gtfs2graph::config::InputFeed in{arg, cfg->useMots, ""};
+
+    size_t pos = arg.rfind('#');
+    if (pos != std::string::npos) {
+      in.path = arg.substr(0, pos);
+      in.mots = parseMots(arg.substr(pos + 1));
+    }
 
+    if (argc - optind > 1) in.idPrefix = std::to_string(i - optind) + ":";
+
+    cfg->inputFeeds.push_back(in);
+  }
+
+  cfg->inputFeedPath = cfg->inputFeeds.front().path;
+}
+
+// _____________________________________________________________________________
+std::set<ad::cppgtfs::gtfs::flat::Route::TYPE> ConfigReader::parseMots(
+    const std::string& motStr) const {
+  std::set<ad::cppgtfs::gtfs::flat::Route::TYPE> ret;
   for (auto sMotStr : util::split(motStr, ',')) {
     for (auto mot :
          ad::cppgtfs::gtfs::flat::Route::getTypesFromString(sMotStr)) {
-      cfg->useMots.insert(mot);
+      ret.insert(mot);
     }
   }
+  return ret;
+}
+
+// _____________________________________________________________________________
+int ConfigReader::parseTime(const std::string& str) const {
+  // GTFS times may be past 24:00 for trips running after midnight
+  auto parts = util::split(str, ':');
+  if (parts.size() < 2 || parts.size() > 3) {
+    std::cerr << "Invalid time " << str << ", must be HH:MM[:SS]."
+              << std::endl;
+    exit(1);
+  }
+
+  int ret = 0;
+  for (size_t i = 0; i < 3; i++) {
+    int v = i < parts.size() ? atoi(parts[i].c_str()) : 0;
+    if (v < 0 || (i > 0 && v > 59)) {
+      std::cerr << "Invalid time " << str << ", must be HH:MM[:SS]."
+                << std::endl;
+      exit(1);
+    }
+    ret = ret * 60 + v;
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<gtfs2graph::config::TimeBand> ConfigReader::parseBands(
+    const std::string& str) const {
+  std::vector<TimeBand> ret;
+  std::set<std::string> names;
+
+  for (const auto& band : util::split(str, ',')) {
+    size_t eq = band.find('=');
+    size_t dash = band.find('-', eq);
+    if (eq == 0 || eq == std::string::npos || dash == std::string::npos) {
+      std::cerr << "Invalid time band " << band
+                << ", must be name=HH:MM-HH:MM." << std::endl;
+      exit(1);
+    }
+
+    TimeBand tb{band.substr(0, eq),
+                parseTime(band.substr(eq + 1, dash - eq - 1)),
+                parseTime(band.substr(dash + 1))};
+
+    if (tb.to <= tb.from) {
+      std::cerr << "Time band " << tb.name << " must end after its start."
+                << std::endl;
+      exit(1);
+    }
+
+    if (!names.insert(tb.name).second) {
+      std::cerr << "Time band " << tb.name << " given twice." << std::endl;
+      exit(1);
+    }
+
+    ret.push_back(tb);
+  }
+
+  return ret;
 }
@@ -5,6 +5,9 @@
 #ifndef gtfs2graph_CONFIG_CONFIGREADER_H_
 #define gtfs2graph_CONFIG_CONFIGREADER_H_
 
+#include <set>
+#include <string>
+
 #include "gtfs2graph/config/GraphBuilderConfig.h"
 
 namespace gtfs2graph {
@@ -16,6 +19,17 @@ class ConfigReader {
   void read(Config* targetConfig, int argc, char** argv) const;
  private:
   void help(const char* bin) const;
+
+  // MOTs from a comma separated list of names or GTFS codes
+  std::set<ad::cppgtfs::gtfs::flat::Route::TYPE> parseMots(
+      const std::string& motStr) const;
+
+  // seconds since midnight from HH:MM[:SS], exits on malformed input
+  int parseTime(const std::string& str) const;
+
+  // time bands from a comma separated list of name=HH:MM-HH:MM, exits on
+  // malformed input
+  std::vector<TimeBand> parseBands(const std::string& str) const;
 };
 }
 }
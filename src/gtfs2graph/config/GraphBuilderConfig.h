@@ -5,18 +5,107 @@
 #ifndef GTFS2GRAPH_CONFIG_GTFS2GEOCONFIG_H_
 #define GTFS2GRAPH_CONFIG_GTFS2GEOCONFIG_H_
 
+#include <stdint.h>
+#include <set>
 #include <string>
+#include <vector>
 #include "ad/cppgtfs/gtfs/flat/Route.h"
+#include "shared/io/CompressedStream.h"
 
 namespace gtfs2graph {
 namespace config {
 
+// an input GTFS feed and the MOTs used from it
+struct InputFeed {
+  std::string path;
+  std::set<ad::cppgtfs::gtfs::flat::Route::TYPE> mots;
+
+  // prepended to the station ids of this feed, empty for a single feed
+  std::string idPrefix;
+};
+
+// a mode of a multi-mode run, written to <outDir>/<name>.<format>
+struct OutputMode {
+  std::string name;
+  std::set<ad::cppgtfs::gtfs::flat::Route::TYPE> mots;
+};
+
+// a named time band [from, to), in seconds since midnight of the service day
+struct TimeBand {
+  std::string name;
+  int from, to;
+};
+
 struct Config {
+  // the first input feed
   std::string inputFeedPath;
 
+  std::vector<InputFeed> inputFeeds;
+
+  // stops of different feeds closer than this are merged into one node
+  double feedSnapDist = 50;
+
   double pruneThreshold;
 
   std::set<ad::cppgtfs::gtfs::flat::Route::TYPE> useMots;
+
+  std::string outputFormat = "json";
+
+  // if set, one graph per comma separated entry of --mots is written to
+  // this directory, from a single parse of the feeds
+  std::string outDir = "";
+  std::vector<OutputMode> modes;
+
+  // compression of the output
+  shared::io::Codec compress = shared::io::CODEC_NONE;
+
+  size_t threads = 1;
+
+  // thread budget of the whole run if given with -t, 0 otherwise
+  size_t threadBudget = 0;
+
+  bool collapsePatterns = true;
+
+  // max number of projected shape points kept in memory
+  size_t shapeCacheSize = 1000000;
+
+  // Douglas-Peucker tolerance for projected shapes, 0 = none
+  double shapeSimplify = 0;
+
+  // trip filters, empty or 0 means no filter
+  std::set<std::string> stopIds;
+  std::vector<std::string> routePatterns;
+  std::set<std::string> routeIds;
+  size_t minTrips = 0;
+  size_t topRoutes = 0;
+
+  // service day as YYYYMMDD, 0 means all days
+  uint32_t serviceDate = 0;
+
+  // only trips running inside [timeFrom, timeTo), in seconds since midnight
+  // of the service day, -1 means open
+  int timeFrom = -1;
+  int timeTo = -1;
+
+  // only routes with at least this many trips per hour inside the time
+  // window (or the whole day)
+  double minFrequency = 0;
+
+  // if given, the lines carry their number of trips in each band, and only
+  // trips running in at least one of the bands are used
+  std::vector<TimeBand> bands;
+
+  // if set, write network statistics tables to this directory instead of
+  // building a graph
+  std::string statsPath = "";
+  double importanceTripWeight = 0.4;
+  double importanceRouteWeight = 0.6;
+
+  // write a Chrome trace of the run to this file, empty if disabled
+  std::string tracePath = "";
+
+  // write per-phase resource usage as JSON to this file, empty if disabled
+  std::string metricsPath = "";
 };
 
 }  // namespace config
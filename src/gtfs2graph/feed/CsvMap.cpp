@@ -0,0 +1,139 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "gtfs2graph/feed/CsvMap.h"
+
+using gtfs2graph::feed::CsvMap;
+
+namespace {
+// _____________________________________________________________________________
+std::string_view trim(std::string_view v) {
+  while (!v.empty() && (v.front() == ' ' || v.front() == '\t')) {
+    v.remove_prefix(1);
+  }
+  while (!v.empty() && (v.back() == ' ' || v.back() == '\t')) {
+    v.remove_suffix(1);
+  }
+  return v;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+CsvMap::CsvMap(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return;
+  }
+
+  _size = st.st_size;
+
+  if (_size > 0) {
+    void* p = mmap(0, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      close(fd);
+      return;
+    }
+    madvise(p, _size, MADV_SEQUENTIAL);
+    _data = static_cast<const char*>(p);
+    _mapped = true;
+  }
+
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+  _good = true;
+
+  // skip an UTF-8 byte order mark
+  if (_size >= 3 && memcmp(_data, "\xEF\xBB\xBF", 3) == 0) _pos = 3;
+
+  _header = readRow();
+  _row = _header;
+  for (size_t i = 0; i < _ends.size(); i++) _cols.push_back(field(i));
+  _row = std::string_view();
+  _ends.clear();
+}
+
+// _____________________________________________________________________________
+CsvMap::~CsvMap() {
+  if (_mapped) munmap(const_cast<char*>(_data), _size);
+}
+
+// _____________________________________________________________________________
+size_t CsvMap::col(const std::string& name) const {
+  for (size_t i = 0; i < _cols.size(); i++) {
+    if (_cols[i] == name) return i;
+  }
+  return NONE;
+}
+
+// _____________________________________________________________________________
+bool CsvMap::next() {
+  while (_pos < _size) {
+    _row = readRow();
+    if (!_row.empty()) return true;
+  }
+
+  _row = std::string_view();
+  _ends.clear();
+  return false;
+}
+
+// _____________________________________________________________________________
+std::string CsvMap::field(size_t i) const {
+  if (i >= _ends.size()) return "";
+
+  size_t from = i == 0 ? 0 : _ends[i - 1] + 1;
+  auto v = trim(_row.substr(from, _ends[i] - from));
+
+  if (v.empty() || v.front() != '"') return std::string(v);
+
+  // quoted value, quotes inside are doubled
+  std::string ret;
+  size_t end = v.size() > 1 && v.back() == '"' ? v.size() - 1 : v.size();
+  for (size_t j = 1; j < end; j++) {
+    if (v[j] == '"' && j + 1 < end && v[j + 1] == '"') j++;
+    ret.push_back(v[j]);
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::string_view CsvMap::readRow() {
+  _ends.clear();
+
+  size_t start = _pos;
+  size_t i = _pos;
+  bool quoted = false;
+
+  // line breaks and separators inside quotes belong to the value
+  for (; i < _size; i++) {
+    char c = _data[i];
+    if (c == '"') {
+      quoted = !quoted;
+    } else if (!quoted && c == ',') {
+      _ends.push_back(i - start);
+    } else if (!quoted && c == '\n') {
+      break;
+    }
+  }
+
+  _pos = i < _size ? i + 1 : _size;
+
+  size_t end = i;
+  if (end > start && _data[end - 1] == '\r') end--;
+  _ends.push_back(end - start);
+
+  return std::string_view(_data + start, end - start);
+}
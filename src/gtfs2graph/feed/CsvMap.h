@@ -0,0 +1,65 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef GTFS2GRAPH_FEED_CSVMAP_H_
+#define GTFS2GRAPH_FEED_CSVMAP_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gtfs2graph {
+namespace feed {
+
+// A CSV file mapped into memory and read row by row. Only the field
+// boundaries of a row are determined, values are only copied out for the
+// columns which are actually requested.
+class CsvMap {
+ public:
+  static const size_t NONE = -1;
+
+  explicit CsvMap(const std::string& path);
+  ~CsvMap();
+
+  CsvMap(const CsvMap& other) = delete;
+  CsvMap& operator=(const CsvMap& other) = delete;
+
+  // false if the file could not be opened or mapped
+  bool good() const { return _good; }
+
+  // index of the column with this name, or NONE
+  size_t col(const std::string& name) const;
+
+  // advance to the next non-empty row, false at the end of the file
+  bool next();
+
+  // the unquoted value of column i in the current row, empty if the row
+  // has fewer columns
+  std::string field(size_t i) const;
+
+  // the raw current row and the raw header row, without the line break
+  std::string_view row() const { return _row; }
+  std::string_view header() const { return _header; }
+
+ private:
+  const char* _data = 0;
+  size_t _size = 0;
+  size_t _pos = 0;
+  bool _good = false;
+  bool _mapped = false;
+
+  std::vector<std::string> _cols;
+  std::string_view _header;
+  std::string_view _row;
+
+  // offsets of the field separators in _row, plus the row end
+  std::vector<size_t> _ends;
+
+  std::string_view readRow();
+};
+
+}  // namespace feed
+}  // namespace gtfs2graph
+
+#endif  // GTFS2GRAPH_FEED_CSVMAP_H_
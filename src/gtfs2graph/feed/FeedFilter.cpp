@@ -0,0 +1,209 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <dirent.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+#include "gtfs2graph/feed/CsvMap.h"
+#include "gtfs2graph/feed/FeedFilter.h"
+#include "util/log/Log.h"
+
+using gtfs2graph::feed::CsvMap;
+using gtfs2graph::feed::FeedFilter;
+
+// _____________________________________________________________________________
+FeedFilter::FeedFilter(const std::string& path, const config::Config* cfg)
+    : _cfg(cfg), _path(path) {
+  if (_cfg->routeIds.empty() && _cfg->routePatterns.empty()) return;
+
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) return;
+
+  char* real = realpath(path.c_str(), 0);
+  if (!real) return;
+  std::string dir(real);
+  free(real);
+
+  if (!readRoutes(dir) || !readTrips(dir)) return;
+
+  if (!writeFeed(dir)) {
+    LOGTO(DEBUG, std::cerr) << "Could not write filtered feed, parsing "
+                            << path << " completely";
+    clear();
+    return;
+  }
+
+  _path = _tmpDir;
+
+  LOGTO(DEBUG, std::cerr) << "Route filters keep " << _trips.size()
+                          << " trips of " << _routes.size() << " routes";
+}
+
+// _____________________________________________________________________________
+FeedFilter::~FeedFilter() { clear(); }
+
+// _____________________________________________________________________________
+bool FeedFilter::readRoutes(const std::string& dir) {
+  CsvMap routes(dir + "/routes.txt");
+
+  size_t idCol = routes.col("route_id");
+  size_t nameCol = routes.col("route_short_name");
+  if (!routes.good() || idCol == CsvMap::NONE) return false;
+
+  while (routes.next()) {
+    auto id = routes.field(idCol);
+    if (_cfg->routeIds.size() && !_cfg->routeIds.count(id)) continue;
+
+    if (_cfg->routePatterns.size()) {
+      auto name = routes.field(nameCol);
+      bool match = false;
+      for (const auto& pat : _cfg->routePatterns) {
+        if (fnmatch(pat.c_str(), name.c_str(), 0) == 0) {
+          match = true;
+          break;
+        }
+      }
+      if (!match) continue;
+    }
+
+    _routes.insert(id);
+  }
+
+  return true;
+}
+
+// _____________________________________________________________________________
+bool FeedFilter::readTrips(const std::string& dir) {
+  CsvMap trips(dir + "/trips.txt");
+
+  size_t routeCol = trips.col("route_id");
+  size_t tripCol = trips.col("trip_id");
+  size_t shapeCol = trips.col("shape_id");
+  if (!trips.good() || routeCol == CsvMap::NONE || tripCol == CsvMap::NONE) {
+    return false;
+  }
+
+  while (trips.next()) {
+    if (!_routes.count(trips.field(routeCol))) continue;
+    _trips.insert(trips.field(tripCol));
+
+    auto shape = trips.field(shapeCol);
+    if (!shape.empty()) _shapes.insert(shape);
+  }
+
+  return true;
+}
+
+// _____________________________________________________________________________
+bool FeedFilter::writeFeed(const std::string& dir) {
+  const char* tmp = getenv("TMPDIR");
+  std::string tmpl = std::string(tmp && *tmp ? tmp : "/tmp") +
+                     "/gtfs2graph-XXXXXX";
+
+  std::vector<char> buf(tmpl.begin(), tmpl.end());
+  buf.push_back(0);
+  if (!mkdtemp(buf.data())) return false;
+  _tmpDir = buf.data();
+
+  DIR* d = opendir(dir.c_str());
+  if (!d) return false;
+
+  bool ok = true;
+
+  while (ok) {
+    struct dirent* ent = readdir(d);
+    if (!ent) break;
+
+    std::string name(ent->d_name);
+    if (name == "." || name == "..") continue;
+
+    bool filtered = false;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0) {
+      ok = filterFile(dir, name, &filtered);
+    }
+
+    if (ok && !filtered) {
+      ok = symlink((dir + "/" + name).c_str(),
+                   (_tmpDir + "/" + name).c_str()) == 0;
+    }
+  }
+
+  closedir(d);
+
+  return ok;
+}
+
+// _____________________________________________________________________________
+bool FeedFilter::filterFile(const std::string& dir, const std::string& name,
+                            bool* filtered) const {
+  *filtered = false;
+
+  CsvMap f(dir + "/" + name);
+  if (!f.good()) return true;
+
+  // the kept values of each checked column, empty values are always kept
+  std::vector<std::pair<size_t, const std::unordered_set<std::string>*>> chk;
+
+  if (name == "trips.txt") {
+    chk.push_back({f.col("route_id"), &_routes});
+  } else if (name == "shapes.txt") {
+    chk.push_back({f.col("shape_id"), &_shapes});
+  } else {
+    for (const auto& col : {"trip_id", "from_trip_id", "to_trip_id"}) {
+      chk.push_back({f.col(col), &_trips});
+    }
+  }
+
+  chk.erase(std::remove_if(chk.begin(), chk.end(),
+                           [](const std::pair<size_t, const void*>& c) {
+                             return c.first == CsvMap::NONE;
+                           }),
+            chk.end());
+
+  if (chk.empty()) return true;
+
+  std::ofstream out(_tmpDir + "/" + name);
+  out << f.header() << "\n";
+
+  while (f.next()) {
+    bool keep = true;
+    for (const auto& c : chk) {
+      auto v = f.field(c.first);
+      if (!v.empty() && !c.second->count(v)) {
+        keep = false;
+        break;
+      }
+    }
+    if (keep) out << f.row() << "\n";
+  }
+
+  *filtered = true;
+  return out.good();
+}
+
+// _____________________________________________________________________________
+void FeedFilter::clear() {
+  if (_tmpDir.empty()) return;
+
+  DIR* d = opendir(_tmpDir.c_str());
+  if (d) {
+    struct dirent* ent;
+    while ((ent = readdir(d))) {
+      std::string name(ent->d_name);
+      if (name == "." || name == "..") continue;
+      unlink((_tmpDir + "/" + name).c_str());
+    }
+    closedir(d);
+  }
+
+  rmdir(_tmpDir.c_str());
+  _tmpDir.clear();
+}
@@ -0,0 +1,58 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef GTFS2GRAPH_FEED_FEEDFILTER_H_
+#define GTFS2GRAPH_FEED_FEEDFILTER_H_
+
+#include <string>
+#include <unordered_set>
+
+#include "gtfs2graph/config/GraphBuilderConfig.h"
+
+namespace gtfs2graph {
+namespace feed {
+
+// Restricts an unzipped GTFS feed to the trips of the routes which pass the
+// route id and route name filters, before it is handed to the parser. The
+// routes and trips are read from memory mapped files, only the id, name and
+// shape columns are looked at. Files referring to trips, and the shapes,
+// are written to a temporary directory with the rows of the kept trips and
+// shapes only, all other files are linked. The temporary directory is
+// removed again on destruction.
+class FeedFilter {
+ public:
+  FeedFilter(const std::string& path, const config::Config* cfg);
+  ~FeedFilter();
+
+  FeedFilter(const FeedFilter& other) = delete;
+  FeedFilter& operator=(const FeedFilter& other) = delete;
+
+  // the feed to parse, the original path if nothing was filtered
+  const std::string& getPath() const { return _path; }
+
+  bool filtered() const { return !_tmpDir.empty(); }
+
+ private:
+  const config::Config* _cfg;
+  std::string _path;
+  std::string _tmpDir;
+
+  std::unordered_set<std::string> _routes, _trips, _shapes;
+
+  bool readRoutes(const std::string& dir);
+  bool readTrips(const std::string& dir);
+  bool writeFeed(const std::string& dir);
+
+  // write the kept rows of the feed file name, if it refers to trips or
+  // shapes, filtered is set accordingly. False on a write error.
+  bool filterFile(const std::string& dir, const std::string& name,
+                  bool* filtered) const;
+
+  void clear();
+};
+
+}  // namespace feed
+}  // namespace gtfs2graph
+
+#endif  // GTFS2GRAPH_FEED_FEEDFILTER_H_
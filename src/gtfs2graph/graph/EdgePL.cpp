@@ -28,11 +28,17 @@ void EdgePL::setEdge(const Edge* e) { _e = e; }
 
 // _____________________________________________________________________________
 bool EdgePL::addTrip(gtfs::Trip* t, PolyLine<double> pl, Node* toNode) {
+  return addTrips({t}, pl, toNode);
+}
+
+// _____________________________________________________________________________
+bool EdgePL::addTrips(const std::vector<gtfs::Trip*>& ts, PolyLine<double> pl,
+                      Node* toNode) {
   assert(toNode == _e->getFrom() || toNode == _e->getTo());
   bool inserted = false;
   for (auto& e : _tripsContained) {
     if (e.getGeom().equals(pl, 10)) {
-      e.addTrip(t, toNode, pl);
+      e.addTrips(ts, toNode, pl);
       inserted = true;
       break;
     }
@@ -40,7 +46,7 @@ bool EdgePL::addTrip(gtfs::Trip* t, PolyLine<double> pl, Node* toNode) {
 
   if (!inserted) {
     EdgeTripGeom etg(pl, toNode);
-    etg.addTrip(t, toNode);
+    etg.addTrips(ts, toNode);
     addEdgeTripGeom(etg);
   }
 
@@ -92,7 +98,7 @@ void EdgePL::simplify(double pruneThreshold) {
     auto etg = *eit;
     auto it = etg.getTripsUnordered()->begin();
     while (it != etg.getTripsUnordered()->end()) {
-      if (it->trips.size() < pruneThreshold) {
+      if (it->numTrips < pruneThreshold) {
         it = etg.getTripsUnordered()->erase(it);
       } else {
         it++;
@@ -130,11 +136,7 @@ void EdgePL::averageCombineGeom() {
   EdgeTripGeom combined(pl, _e->getTo());
 
   for (auto& et : _tripsContained) {
-    for (auto& r : *et.getTripsUnordered()) {
-      for (auto& t : r.trips) {
-        combined.addTrip(t, r.direction);
-      }
-    }
+    for (const auto& r : *et.getTripsUnordered()) combined.addRouteOcc(r);
   }
 
   _tripsContained.clear();
@@ -153,10 +155,8 @@ void EdgePL::combineIncludedGeoms() {
       if (toCheckAgainst.getGeom().getLength() > et->getGeom().getLength() &&
           toCheckAgainst.getGeom().contains(et->getGeom(), 50) &&
           !et->getGeom().contains(toCheckAgainst.getGeom(), 50)) {
-        for (auto& r : *et->getTripsUnordered()) {
-          for (auto& t : r.trips) {
-            toCheckAgainst.addTrip(t, r.direction);
-          }
+        for (const auto& r : *et->getTripsUnordered()) {
+          toCheckAgainst.addRouteOcc(r);
         }
         combined = true;
         break;
@@ -194,6 +194,14 @@ util::json::Dict EdgePL::getAttrs() const {
       route["direction"] = util::toString(r.direction);
     }
 
+    route["trips"] = r.numTrips;
+
+    if (r.bands) {
+      util::json::Dict bands;
+      for (const auto& b : *r.bands) bands[b.first] = b.second;
+      route["bands"] = bands;
+    }
+
     lines.push_back(route);
   }
   obj["lines"] = lines;
@@ -27,6 +27,10 @@ class EdgePL : public util::geograph::GeoEdgePL<double> {
 
   bool addTrip(gtfs::Trip* t, util::geo::PolyLine<double> pl, Node* toNode);
 
+  // add trips of the same pattern, i.e. with the same geometry
+  bool addTrips(const std::vector<gtfs::Trip*>& ts,
+                util::geo::PolyLine<double> pl, Node* toNode);
+
   void setEdge(const Edge* e);
 
   const std::vector<EdgeTripGeom>& getEdgeTripGeoms() const;
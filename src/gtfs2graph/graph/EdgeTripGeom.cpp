@@ -37,7 +37,40 @@ void EdgeTripGeom::addTrip(gtfs::Trip* t, const Node* dirNode) {
     _routeOccs.push_back(RouteOccurance(t->getRoute()));
     to = &_routeOccs.back();
   }
-  to->addTrip(t, dirNode);
+  to->addTrips(1, dirNode);
+}
+
+// _____________________________________________________________________________
+void EdgeTripGeom::addTrips(const std::vector<gtfs::Trip*>& ts,
+                            const Node* dirNode, PolyLine<double>& pl) {
+  if (dirNode != _geomDir) pl.reverse();
+
+  setGeom(PolyLine<double>::average({&_geom, &pl}));
+
+  addTrips(ts, dirNode);
+}
+
+// _____________________________________________________________________________
+void EdgeTripGeom::addTrips(const std::vector<gtfs::Trip*>& ts,
+                            const Node* dirNode) {
+  if (ts.empty()) return;
+  RouteOccurance* to = getRouteOcc(ts.front()->getRoute());
+  if (!to) {
+    _routeOccs.push_back(RouteOccurance(ts.front()->getRoute()));
+    to = &_routeOccs.back();
+  }
+  to->addTrips(ts.size(), dirNode);
+}
+
+// _____________________________________________________________________________
+void EdgeTripGeom::addRouteOcc(const RouteOccurance& r) {
+  RouteOccurance* to = getRouteOcc(r.route);
+  if (!to) {
+    _routeOccs.push_back(RouteOccurance(r.route));
+    to = &_routeOccs.back();
+    to->bands = r.bands;
+  }
+  to->addTrips(r.numTrips, r.direction);
 }
 
 // _____________________________________________________________________________
@@ -74,7 +107,7 @@ bool EdgeTripGeom::containsRoute(gtfs::Route* r) const {
 size_t EdgeTripGeom::getTripCardinality() const {
   size_t ret = 0;
 
-  for (auto& t : _routeOccs) ret += t.trips.size();
+  for (auto& t : _routeOccs) ret += t.numTrips;
 
   return ret;
 }
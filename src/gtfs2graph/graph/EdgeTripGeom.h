@@ -9,24 +9,32 @@
 #include "ad/cppgtfs/gtfs/Route.h"
 #include "ad/cppgtfs/gtfs/Trip.h"
 #include "gtfs2graph/graph/BuildGraph.h"
+#include "shared/linegraph/Line.h"
 #include "util/geo/PolyLine.h"
 
 namespace gtfs2graph {
 namespace graph {
 
+// the trips of a route on an edge, only their number is kept
 struct RouteOccurance {
-  RouteOccurance(ad::cppgtfs::gtfs::Route* r) : route(r), direction(0) {}
-  void addTrip(ad::cppgtfs::gtfs::Trip* t, const Node* dirNode) {
-    if (trips.size() == 0) {
+  RouteOccurance(ad::cppgtfs::gtfs::Route* r)
+      : route(r), numTrips(0), direction(0), bands(0) {}
+  // add n trips, which all have the same direction (0 for both)
+  void addTrips(size_t n, const Node* dirNode) {
+    if (!n) return;
+    if (numTrips == 0) {
       direction = dirNode;
     } else {
       if (direction && direction != dirNode) direction = 0;
     }
-    trips.push_back(t);
+    numTrips += n;
   }
   ad::cppgtfs::gtfs::Route* route;
-  std::vector<ad::cppgtfs::gtfs::Trip*> trips;
+  size_t numTrips;
   const Node* direction;  // 0 if in both directions
+
+  // the trips of the route in each time band, 0 without time bands
+  const shared::linegraph::LineBands* bands;
 };
 
 typedef std::pair<RouteOccurance*, size_t> TripOccWithPos;
@@ -38,6 +46,13 @@ class EdgeTripGeom {
   void addTrip(ad::cppgtfs::gtfs::Trip* t, const Node* dirNode,
                util::geo::PolyLine<double>& pl);
   void addTrip(ad::cppgtfs::gtfs::Trip* t, const Node* dirNode);
+  void addTrips(const std::vector<ad::cppgtfs::gtfs::Trip*>& ts,
+                const Node* dirNode, util::geo::PolyLine<double>& pl);
+  void addTrips(const std::vector<ad::cppgtfs::gtfs::Trip*>& ts,
+                const Node* dirNode);
+
+  // add the trips of a route occurrence of another EdgeTripGeom
+  void addRouteOcc(const RouteOccurance& r);
 
   const std::vector<RouteOccurance>& getTripsUnordered() const;
   std::vector<RouteOccurance>* getTripsUnordered();
@@ -38,9 +38,21 @@ NodePL::NodePL(double x, double y, const gtfs::Stop* s) : _pos(x, y) {
 // _____________________________________________________________________________
 void NodePL::addStop(const gtfs::Stop* s) { _stops.insert(s); }
 
+// _____________________________________________________________________________
+void NodePL::addTrips(const gtfs::Route* r, size_t n) {
+  _trips += n;
+  _routes.insert(r);
+}
+
 // _____________________________________________________________________________
 const std::set<const gtfs::Stop*>& NodePL::getStops() const { return _stops; }
 
+// _____________________________________________________________________________
+std::string NodePL::getStationId() const {
+  if (_stops.empty()) return "";
+  return _idPrefix + (*_stops.begin())->getId();
+}
+
 // _____________________________________________________________________________
 const DPoint& NodePL::getPos() const { return _pos; }
 
@@ -101,14 +113,8 @@ const util::geo::DPoint* NodePL::getGeom() const { return &getPos(); }
 void NodePL::setNode(const Node* n) { _n = n; }
 
 // _____________________________________________________________________________
-util::json::Dict NodePL::getAttrs() const {
-  util::json::Dict obj;
-  if (getStops().size() > 0) {
-    obj["station_id"] = (*getStops().begin())->getId();
-    obj["station_label"] = (*getStops().begin())->getName();
-  }
-
-  auto arr = util::json::Array();
+std::vector<ExcludedConnection> NodePL::getExcludedConnections() const {
+  std::vector<ExcludedConnection> ret;
 
   for (const graph::Edge* e : _n->getAdjList()) {
     if (!e->pl().getRefETG()) continue;
@@ -122,19 +128,38 @@ util::json::Dict NodePL::getAttrs() const {
                (r.direction == _n && rr.direction != _n) ||
                (r.direction != _n && rr.direction == _n)) &&
               !isConnOccuring(r.route, e, f)) {
-            auto obj = util::json::Dict();
-            obj["line"] = util::toString(r.route);
-            obj["node_from"] =
-                util::toString(e->getFrom() == _n ? e->getTo() : e->getFrom());
-            obj["node_to"] =
-                util::toString(f->getFrom() == _n ? f->getTo() : f->getFrom());
-            arr.push_back(obj);
+            ret.push_back(ExcludedConnection(
+                r.route, e->getFrom() == _n ? e->getTo() : e->getFrom(),
+                f->getFrom() == _n ? f->getTo() : f->getFrom()));
           }
         }
       }
     }
   }
 
+  return ret;
+}
+
+// _____________________________________________________________________________
+util::json::Dict NodePL::getAttrs() const {
+  util::json::Dict obj;
+  if (getStops().size() > 0) {
+    obj["station_id"] = getStationId();
+    obj["station_label"] = (*getStops().begin())->getName();
+    obj["station_trips"] = static_cast<int>(_trips);
+    obj["station_routes"] = static_cast<int>(_routes.size());
+  }
+
+  auto arr = util::json::Array();
+
+  for (const auto& ex : getExcludedConnections()) {
+    auto obj = util::json::Dict();
+    obj["line"] = util::toString(ex.route);
+    obj["node_from"] = util::toString(ex.from);
+    obj["node_to"] = util::toString(ex.to);
+    arr.push_back(obj);
+  }
+
   if (arr.size()) obj["excluded_conn"] = arr;
   return obj;
 }
@@ -6,6 +6,7 @@
 #define GTFS2GRAPH_GRAPH_NODE_H_
 
 #include <set>
+#include <string>
 
 #include "ad/cppgtfs/gtfs/Route.h"
 #include "ad/cppgtfs/gtfs/Stop.h"
@@ -26,6 +27,14 @@ struct OccuringConnection {
   const Edge* to;
 };
 
+struct ExcludedConnection {
+  ExcludedConnection(const gtfs::Route* r, const Node* from, const Node* to)
+      : route(r), from(from), to(to) {}
+  const gtfs::Route* route;
+  const Node* from;
+  const Node* to;
+};
+
 class NodePL : util::geograph::GeoNodePL<double> {
  public:
   NodePL(){};
@@ -50,16 +59,31 @@ class NodePL : util::geograph::GeoNodePL<double> {
   const std::map<const gtfs::Route*, std::vector<OccuringConnection> >&
   getOccuringConnections() const;
 
+  // connections between adjacent edges which are never taken by a route
+  std::vector<ExcludedConnection> getExcludedConnections() const;
+
   const util::geo::DPoint* getGeom() const;
   util::json::Dict getAttrs() const;
 
   void setNode(const Node* n);
 
+  // the id of the first stop, with the prefix of its feed
+  std::string getStationId() const;
+  void setStationIdPrefix(const std::string& prefix) { _idPrefix = prefix; }
+
+  // count n trips of route r stopping here, each trip once
+  void addTrips(const gtfs::Route* r, size_t n);
+  size_t getNumTrips() const { return _trips; }
+  size_t getNumRoutes() const { return _routes.size(); }
+
  private:
   DPoint _pos;
   const Node* _n;  // backpointer to node
 
   std::set<const gtfs::Stop*> _stops;
+  std::string _idPrefix;
+  size_t _trips = 0;
+  std::set<const gtfs::Route*> _routes;
   std::map<const gtfs::Route*, std::vector<OccuringConnection> > _occConns;
 };
 }  // namespace graph
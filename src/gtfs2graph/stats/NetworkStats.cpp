@@ -0,0 +1,259 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "gtfs2graph/stats/NetworkStats.h"
+#include "util/log/Log.h"
+
+using ad::cppgtfs::gtfs::Feed;
+using ad::cppgtfs::gtfs::Route;
+using ad::cppgtfs::gtfs::Stop;
+using gtfs2graph::stats::NetworkStats;
+
+namespace {
+// _____________________________________________________________________________
+std::string csv(const std::string& s) {
+  if (s.find_first_of(",\"\r\n") == std::string::npos) return s;
+  std::string ret = "\"";
+  for (char c : s) {
+    if (c == '"') ret += '"';
+    ret += c;
+  }
+  return ret + "\"";
+}
+
+// _____________________________________________________________________________
+const char* pyBool(bool b) { return b ? "True" : "False"; }
+
+// _____________________________________________________________________________
+std::vector<size_t> ranksDesc(const std::vector<size_t>& vals) {
+  // 1 + the number of greater values, like pandas rank(ascending=False,
+  // method="min")
+  std::vector<size_t> sorted(vals);
+  std::sort(sorted.begin(), sorted.end());
+
+  std::vector<size_t> ret;
+  for (auto v : vals) {
+    ret.push_back(1 + (sorted.end() -
+                       std::upper_bound(sorted.begin(), sorted.end(), v)));
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<double> pctiles(const std::vector<size_t>& vals) {
+  // share of values not greater than v, like pandas rank(pct=True,
+  // method="max") * 100
+  std::vector<size_t> sorted(vals);
+  std::sort(sorted.begin(), sorted.end());
+
+  std::vector<double> ret;
+  for (auto v : vals) {
+    size_t le = std::upper_bound(sorted.begin(), sorted.end(), v) -
+                sorted.begin();
+    ret.push_back(100.0 * le / vals.size());
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::string absPath(const std::string& path) {
+  char buf[PATH_MAX];
+  if (realpath(path.c_str(), buf)) return buf;
+  return path;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+void NetworkStats::consume(const Feed& f) {
+  std::unordered_map<const Stop*, uint32_t> stopIdx;
+  std::unordered_map<const Route*, uint32_t> routeIdx;
+
+  for (auto s = f.getStops().begin(); s != f.getStops().end(); ++s) {
+    stopIdx[s->second] = _stops.size();
+    _stops.push_back({s->second, 0, 0});
+  }
+
+  for (auto r = f.getRoutes().begin(); r != f.getRoutes().end(); ++r) {
+    routeIdx[r->second] = _routes.size();
+    _routes.push_back({r->second, 0});
+  }
+
+  // (stop, route) pairs already counted
+  std::unordered_set<uint64_t> stopRoutes;
+  std::vector<uint32_t> tripStops;
+
+  for (auto t = f.getTrips().begin(); t != f.getTrips().end(); ++t) {
+    auto rit = routeIdx.find(t->second->getRoute());
+    if (rit == routeIdx.end()) continue;
+    uint64_t r = rit->second;
+
+    _routes[r].trips++;
+    _totTrips++;
+
+    // a trip visiting a stop twice counts once
+    tripStops.clear();
+    for (const auto& st : t->second->getStopTimes()) {
+      auto sit = stopIdx.find(st.getStop());
+      if (sit != stopIdx.end()) tripStops.push_back(sit->second);
+    }
+    std::sort(tripStops.begin(), tripStops.end());
+    tripStops.erase(std::unique(tripStops.begin(), tripStops.end()),
+                    tripStops.end());
+
+    for (uint64_t s : tripStops) {
+      _stops[s].trips++;
+      if (stopRoutes.insert((s << 32) | r).second) _stops[s].routes++;
+    }
+  }
+}
+
+// _____________________________________________________________________________
+bool NetworkStats::write(const std::string& dir) const {
+  mkdir(dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+
+  const std::string routesPath = dir + "/routes_trip_frequency.csv";
+  const std::string stopsPath = dir + "/stops_junction_ranking.csv";
+  const std::string importancePath = dir + "/_stop_importance.csv";
+
+  std::ofstream routes(routesPath), stops(stopsPath);
+  std::ofstream importance(importancePath);
+  std::ofstream meta(dir + "/_network_stats_meta.txt");
+
+  if (!routes.good() || !stops.good() || !importance.good() || !meta.good()) {
+    LOG(ERROR) << "Could not write network statistics to " << dir;
+    return false;
+  }
+
+  writeRoutes(&routes);
+  writeStops(&stops);
+  writeImportance(&importance);
+
+  meta << "feed: " << absPath(_cfg->inputFeedPath) << "\n"
+       << "n_routes: " << _routes.size() << "\n"
+       << "n_stops: " << _stops.size() << "\n"
+       << "total_trips: " << _totTrips << "\n"
+       << "routes_csv: " << absPath(routesPath) << "\n"
+       << "stops_csv: " << absPath(stopsPath) << "\n";
+
+  return routes.good() && stops.good() && importance.good() && meta.good();
+}
+
+// _____________________________________________________________________________
+void NetworkStats::writeRoutes(std::ostream* out) const {
+  // busiest routes first, ties by ID
+  std::vector<RouteStats> rs(_routes);
+  std::sort(rs.begin(), rs.end(), [](const RouteStats& a, const RouteStats& b) {
+    if (a.trips != b.trips) return a.trips > b.trips;
+    return a.route->getId() < b.route->getId();
+  });
+
+  std::vector<size_t> trips;
+  for (const auto& r : rs) trips.push_back(r.trips);
+  const auto& pct = pctiles(trips);
+
+  double tot = _totTrips ? _totTrips : 1;
+
+  *out << std::setprecision(12);
+  *out << "route_id,agency_id,route_short_name,route_long_name,route_desc,"
+          "route_type,route_url,route_color,route_text_color,trip_count,"
+          "trip_share_of_network,rank_by_trips,pctile_by_trips,"
+          "is_top_decile_trips,is_top_quartile_trips\n";
+
+  for (size_t i = 0; i < rs.size(); i++) {
+    const auto* r = rs[i].route;
+    *out << csv(r->getId()) << ","
+         << csv(r->getAgency() ? r->getAgency()->getId() : "") << ","
+         << csv(r->getShortName()) << "," << csv(r->getLongName()) << ","
+         << csv(r->getDesc()) << "," << static_cast<int>(r->getType()) << ","
+         << csv(r->getUrl()) << "," << csv(r->getColorString()) << ","
+         << csv(r->getTextColorString()) << "," << rs[i].trips << ","
+         << rs[i].trips / tot << "," << i + 1 << "," << pct[i] << ","
+         << pyBool(pct[i] >= 90) << "," << pyBool(pct[i] >= 75) << "\n";
+  }
+}
+
+// _____________________________________________________________________________
+void NetworkStats::writeStops(std::ostream* out) const {
+  // junction order: more distinct routes first, then more trips, ties by ID
+  std::vector<StopStats> ss(_stops);
+  std::sort(ss.begin(), ss.end(), [](const StopStats& a, const StopStats& b) {
+    if (a.routes != b.routes) return a.routes > b.routes;
+    if (a.trips != b.trips) return a.trips > b.trips;
+    return a.stop->getId() < b.stop->getId();
+  });
+
+  std::vector<size_t> trips, routes;
+  for (const auto& s : ss) {
+    trips.push_back(s.trips);
+    routes.push_back(s.routes);
+  }
+
+  const auto& tripRanks = ranksDesc(trips);
+  const auto& routeRanks = ranksDesc(routes);
+  const auto& tripPct = pctiles(trips);
+  const auto& routePct = pctiles(routes);
+
+  *out << std::setprecision(12);
+  *out << "stop_id,stop_name,stop_lat,stop_lon,trip_count,route_count,"
+          "rank_by_unique_trips,rank_by_routes,junction_order,pctile_routes,"
+          "pctile_trips,hub_score,is_top_decile_hub\n";
+
+  for (size_t i = 0; i < ss.size(); i++) {
+    const auto* s = ss[i].stop;
+    double hub = (routePct[i] + tripPct[i]) / 2;
+    *out << csv(s->getId()) << "," << csv(s->getName()) << "," << s->getLat()
+         << "," << s->getLng() << "," << ss[i].trips << "," << ss[i].routes
+         << "," << tripRanks[i] << "," << routeRanks[i] << "," << i + 1 << ","
+         << routePct[i] << "," << tripPct[i] << "," << hub << ","
+         << pyBool(hub >= 90) << "\n";
+  }
+}
+
+// _____________________________________________________________________________
+void NetworkStats::writeImportance(std::ostream* out) const {
+  size_t maxTrips = 0, maxRoutes = 0;
+  for (const auto& s : _stops) {
+    maxTrips = std::max(maxTrips, s.trips);
+    maxRoutes = std::max(maxRoutes, s.routes);
+  }
+
+  std::vector<std::pair<double, const StopStats*>> imp;
+  for (const auto& s : _stops) {
+    double v = 0;
+    if (maxTrips) v += _cfg->importanceTripWeight * s.trips / maxTrips;
+    if (maxRoutes) v += _cfg->importanceRouteWeight * s.routes / maxRoutes;
+    imp.push_back({v, &s});
+  }
+
+  std::sort(imp.begin(), imp.end(),
+            [](const std::pair<double, const StopStats*>& a,
+               const std::pair<double, const StopStats*>& b) {
+              if (a.first != b.first) return a.first > b.first;
+              return a.second->stop->getId() < b.second->stop->getId();
+            });
+
+  *out << std::setprecision(12);
+  *out << "stop_id,stop_name,stop_lat,stop_lon,trip_count,route_count,"
+          "importance\n";
+
+  for (const auto& i : imp) {
+    const auto* s = i.second->stop;
+    *out << csv(s->getId()) << "," << csv(s->getName()) << "," << s->getLat()
+         << "," << s->getLng() << "," << i.second->trips << ","
+         << i.second->routes << "," << i.first << "\n";
+  }
+}
@@ -0,0 +1,60 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef GTFS2GRAPH_STATS_NETWORKSTATS_H_
+#define GTFS2GRAPH_STATS_NETWORKSTATS_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "ad/cppgtfs/gtfs/Feed.h"
+#include "gtfs2graph/config/GraphBuilderConfig.h"
+
+namespace gtfs2graph {
+namespace stats {
+
+struct StopStats {
+  const ad::cppgtfs::gtfs::Stop* stop;
+  size_t trips;
+  size_t routes;
+};
+
+struct RouteStats {
+  const ad::cppgtfs::gtfs::Route* route;
+  size_t trips;
+};
+
+// Per-stop and per-route trip counts of a feed, computed in a single pass
+// over the stop times. Written as the CSV tables of network_stats.py
+// (routes_trip_frequency.csv, stops_junction_ranking.csv) and
+// stop_importance.py (_stop_importance.csv).
+class NetworkStats {
+ public:
+  explicit NetworkStats(const config::Config* cfg) : _cfg(cfg) {}
+
+  void consume(const ad::cppgtfs::gtfs::Feed& f);
+
+  // false if the tables could not be written
+  bool write(const std::string& dir) const;
+
+  const std::vector<StopStats>& getStops() const { return _stops; }
+  const std::vector<RouteStats>& getRoutes() const { return _routes; }
+
+ private:
+  const config::Config* _cfg;
+
+  std::vector<StopStats> _stops;
+  std::vector<RouteStats> _routes;
+  size_t _totTrips = 0;
+
+  void writeRoutes(std::ostream* out) const;
+  void writeStops(std::ostream* out) const;
+  void writeImportance(std::ostream* out) const;
+};
+
+}  // namespace stats
+}  // namespace gtfs2graph
+
+#endif  // GTFS2GRAPH_STATS_NETWORKSTATS_H_
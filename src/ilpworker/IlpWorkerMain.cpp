@@ -0,0 +1,78 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+// Solves a single ILP request of shared::optim::RemoteSolver read from stdin
+// and writes the response to stdout, e.g. on a solver host with
+//
+//   loom --ilp-solver remote --ilp-remote-cmd 'ssh host ilpworker'
+
+#include <getopt.h>
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "shared/optim/ILPSolvProv.h"
+#include "shared/optim/RemoteSolver.h"
+#include "util/log/Log.h"
+
+namespace {
+// _____________________________________________________________________________
+void help(const char* bin) {
+  std::cout << std::setfill(' ') << std::left << "Usage: " << bin
+            << " [options] < request > response\n\n"
+            << "Allowed options:\n\n"
+            << std::setw(32) << "  -h [ --help ]"
+            << "show this help message\n"
+            << std::setw(32) << "  --solver arg (=gurobi)"
+            << "ILP solver, either glpk, cbc, gurobi or\n"
+            << std::setw(32) << " "
+            << " portfolio, will fall back if not available\n";
+}
+}  // namespace
+
+// _____________________________________________________________________________
+int main(int argc, char** argv) {
+  // disable output buffering for standard output
+  setbuf(stdout, NULL);
+
+  std::string solver = "gurobi";
+
+  struct option ops[] = {{"help", no_argument, 0, 'h'},
+                         {"solver", required_argument, 0, 1},
+                         {0, 0, 0, 0}};
+
+  int c;
+  while ((c = getopt_long(argc, argv, ":h", ops, 0)) != -1) {
+    switch (c) {
+      case 'h':
+        help(argv[0]);
+        return 0;
+      case 1:
+        solver = optarg;
+        break;
+      case ':':
+        std::cerr << argv[optind - 1] << " requires an argument" << std::endl;
+        return 1;
+      case '?':
+        std::cerr << argv[optind - 1] << " option unknown" << std::endl;
+        return 1;
+      default:
+        std::cerr << "Error while parsing arguments" << std::endl;
+        return 1;
+    }
+  }
+
+  try {
+    if (!shared::optim::serveRemote(&std::cin, &std::cout, solver)) {
+      LOG(ERROR) << "Malformed ILP request.";
+      return 1;
+    }
+  } catch (const shared::optim::ILPProviderErr& e) {
+    LOG(ERROR) << e.what();
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,247 @@
+// Copyright 2016
+// University of Freiburg - Chair of Algorithms and Datastructures
+// Author: Patrick Brosi
+
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include "loom/Loom.h"
+#include "loom/_config.h"
+#include "loom/config/ConfigReader.h"
+#include "loom/config/LoomConfig.h"
+#include "loom/optim/AutoOptimizer.h"
+#include "loom/optim/BranchBoundOptimizer.h"
+#include "loom/optim/CombOptimizer.h"
+#include "loom/optim/GreedyOptimizer.h"
+#include "loom/optim/ILPEdgeOrderOptimizer.h"
+#include "loom/optim/ReplicaExchangeOptimizer.h"
+#include "loom/optim/TabuOptimizer.h"
+#include "loom/optim/TreeDPOptimizer.h"
+#include "shared/cache/StageCache.h"
+#include "shared/io/CompressedStream.h"
+#include "shared/linegraph/BinGraph.h"
+#include "shared/linegraph/JsonGraph.h"
+#include "shared/linegraph/TopoJsonGraph.h"
+#include "shared/optim/RemoteSolver.h"
+#include "shared/rendergraph/Penalties.h"
+#include "shared/rendergraph/RenderGraph.h"
+#include "shared/threads/Cancel.h"
+#include "shared/threads/ThreadBudget.h"
+#include "shared/trace/Metrics.h"
+#include "shared/trace/Progress.h"
+#include "shared/trace/Trace.h"
+#include "util/geo/PolyLine.h"
+#include "util/log/Log.h"
+
+using namespace loom;
+
+// _____________________________________________________________________________
+int loom::run(int argc, char** argv, std::istream* inStr,
+              std::ostream* outStr) {
+  config::Config cfg;
+
+  config::ConfigReader cr;
+  cr.read(&cfg, argc, argv);
+
+  shared::threads::setBudget(cfg.threadBudget);
+  shared::threads::setDeadline(cfg.deadline);
+  shared::optim::setRemoteCmd(cfg.ilpRemoteCmd);
+
+  shared::trace::Trace::open(cfg.tracePath, "loom");
+  shared::trace::Metrics::open(cfg.metricsPath, "loom");
+  shared::trace::Progress::open(cfg.progressFd, "loom");
+
+  // declared before the cache, so cached output is compressed as well
+  shared::io::CompressedIn zIn(&inStr);
+  shared::io::CompressedOut zOut(cfg.compress, cfg.threadBudget, &outStr);
+
+  shared::cache::StageCache cache(cfg.stageCacheDir,
+                                  std::string("loom ") + VERSION_FULL,
+                                  "--stage-cache-dir", argc, argv, &inStr,
+                                  &outStr);
+  if (cache.hit()) return 0;
+
+  LOGTO(DEBUG, std::cerr) << "Reading graph...";
+  shared::rendergraph::RenderGraph g(5, 1, 5);
+
+  // the optimizers only need the topology and the lines
+  g.setIndexed(false);
+
+  {
+    TRACE_PHASE("read");
+    if (cfg.fromDot) {
+      g.readFromDot(inStr);
+    } else if (shared::linegraph::isBinGraph(inStr)) {
+      g.readFromBin(inStr);
+    } else {
+      g.readFromJson(inStr);
+    }
+  }
+
+  if (cfg.snapOrphanStations) {
+    g.buildIndex();
+    g.snapOrphanStations();
+  }
+
+  shared::trace::Metrics::count("nodes", g.numNds());
+  shared::trace::Metrics::count("edges", g.numEdgs());
+  shared::trace::Metrics::count("lines", g.numLines());
+
+  LOGTO(DEBUG, std::cerr) << "Optimizing...";
+
+  double maxCrossPen =
+      g.maxDeg() * std::max(cfg.crossPenMultiSameSeg,
+                            std::max(cfg.crossPenMultiDiffSeg,
+                                     std::max(cfg.stationCrossWeightSameSeg,
+                                              cfg.stationCrossWeightDiffSeg)));
+  double maxSepPen = g.maxDeg() * std::max(cfg.separationPenWeight,
+                                           cfg.stationSeparationWeight);
+
+  // TODO move this into configuration, at least partially
+  shared::rendergraph::Penalties pens{maxCrossPen,
+                                      maxSepPen,
+                                      cfg.crossPenMultiSameSeg,
+                                      cfg.crossPenMultiDiffSeg,
+                                      cfg.separationPenWeight,
+                                      cfg.stationCrossWeightSameSeg,
+                                      cfg.stationCrossWeightDiffSeg,
+                                      cfg.stationSeparationWeight,
+                                      true,
+                                      true};
+  loom::optim::OptResStats stats;
+
+  shared::trace::Phase optPhase("optimize");
+
+  if (cfg.optimMethod == "ilp-naive") {
+    optim::ILPOptimizer ilpOptim(&cfg, pens);
+    stats = ilpOptim.optimize(&g);
+  } else if (cfg.optimMethod == "ilp") {
+    optim::ILPEdgeOrderOptimizer ilpEoOptim(&cfg, pens);
+    stats = ilpEoOptim.optimize(&g);
+  } else if (cfg.optimMethod == "auto") {
+    optim::AutoOptimizer autoOptim(&cfg, pens);
+    stats = autoOptim.optimize(&g);
+  } else if (cfg.optimMethod == "comb") {
+    optim::CombOptimizer ilpCombiOptim(&cfg, pens);
+    stats = ilpCombiOptim.optimize(&g);
+  } else if (cfg.optimMethod == "exhaust") {
+    optim::ExhaustiveOptimizer exhausOptim(&cfg, pens);
+    stats = exhausOptim.optimize(&g);
+  } else if (cfg.optimMethod == "exhaust-bnb") {
+    optim::BranchBoundOptimizer bnbOptim(&cfg, pens);
+    stats = bnbOptim.optimize(&g);
+  } else if (cfg.optimMethod == "tree-dp") {
+    optim::TreeDPOptimizer treeOptim(&cfg, pens);
+    stats = treeOptim.optimize(&g);
+  } else if (cfg.optimMethod == "hillc") {
+    optim::HillClimbOptimizer hillcOptim(&cfg, pens, false);
+    stats = hillcOptim.optimize(&g);
+  } else if (cfg.optimMethod == "hillc-random") {
+    optim::HillClimbOptimizer hillcOptim(&cfg, pens, true);
+    stats = hillcOptim.optimize(&g);
+  } else if (cfg.optimMethod == "anneal") {
+    optim::SimulatedAnnealingOptimizer annealOptim(&cfg, pens, false);
+    stats = annealOptim.optimize(&g);
+  } else if (cfg.optimMethod == "anneal-random") {
+    optim::SimulatedAnnealingOptimizer annealOptim(&cfg, pens, true);
+    stats = annealOptim.optimize(&g);
+  } else if (cfg.optimMethod == "anneal-rex") {
+    optim::ReplicaExchangeOptimizer rexOptim(&cfg, pens, false);
+    stats = rexOptim.optimize(&g);
+  } else if (cfg.optimMethod == "anneal-rex-random") {
+    optim::ReplicaExchangeOptimizer rexOptim(&cfg, pens, true);
+    stats = rexOptim.optimize(&g);
+  } else if (cfg.optimMethod == "tabu") {
+    optim::TabuOptimizer tabuOptim(&cfg, pens);
+    stats = tabuOptim.optimize(&g);
+  } else if (cfg.optimMethod == "greedy") {
+    optim::GreedyOptimizer greedyOptim(&cfg, pens, false);
+    stats = greedyOptim.optimize(&g);
+  } else if (cfg.optimMethod == "greedy-lookahead") {
+    optim::GreedyOptimizer greedyOptim(&cfg, pens, true);
+    stats = greedyOptim.optimize(&g);
+  } else if (cfg.optimMethod == "null") {
+    optim::NullOptimizer nullOptim(&cfg, pens);
+    stats = nullOptim.optimize(&g);
+  } else {
+    LOG(ERROR) << "Unknown optimization method " << cfg.optimMethod
+               << std::endl;
+    exit(1);
+  }
+
+  optPhase.done();
+
+  if (shared::threads::cancelled()) {
+    LOGTO(WARN, std::cerr) << "Optimization cancelled ("
+                           << shared::threads::cancelReason()
+                           << "), writing the best orderings found";
+  }
+
+  shared::trace::Metrics::count("components", stats.numCompsOrig);
+
+  TRACE_PHASE("write");
+  util::json::Dict jsonStats;
+
+  if (cfg.writeStats) {
+    jsonStats = {
+        {"statistics",
+         util::json::Dict{
+             {"input_num_nodes", stats.numNodesOrig},
+             {"input_num_stations", stats.numStationsOrig},
+             {"input_num_edges", stats.numEdgesOrig},
+             {"input_max_number_lines", stats.maxLineCardOrig},
+             {"input_max_deg", stats.maxDegOrig},
+             {"input_num_lines", stats.numLinesOrig},
+             {"input_solution_space_size", stats.solutionSpaceSizeOrig},
+             {"input_num_comps", stats.numCompsOrig},
+             {"optgraph_num_nodes", stats.numNodes},
+             {"optgraph_num_stations", stats.numStations},
+             {"optgraph_num_edges", stats.numEdges},
+             {"optgraph_max_number_lines", stats.maxLineCard},
+             {"optgraph_solution_space_size", stats.solutionSpaceSize},
+             {"optgraph_nontrivial_comps", stats.nonTrivialComponents},
+             {"optgraph_nontrivial_comps_searchspace_one",
+              stats.numCompsSolSpaceOne},
+             {"optgraph_max_num_nodes_in_comps", stats.maxNumNodesPerComp},
+             {"optgraph_max_num_edges_in_comps", stats.maxNumEdgesPerComp},
+             {"optgraph_max_number_lines_in_comps", stats.maxCardPerComp},
+             {"optraph_max_solution_space_size_in_comps", stats.maxCompSolSpace},
+             {"runs", stats.runs},
+             {"max_num_cols_in_comp", stats.maxNumColsPerComp},
+             {"max_num_rows_in_comp", stats.maxNumRowsPerComp},
+             {"avg_solve_time", stats.avgSolveTime},
+             {"avg_score", stats.avgScore},
+             {"avg_num_same_seg_crossings", stats.avgSameSegCross},
+             {"avg_num_diff_seg_crossings", stats.avgDiffSegCross},
+             {"avg_num_crossings", stats.avgCross},
+             {"avg_num_separations", stats.avgSeps},
+             {"best_num_same_seg_crossings", stats.sameSegCrossings},
+             {"best_num_diff_seg_crossings", stats.diffSegCrossings},
+             {"best_num_separations", stats.separations},
+             {"line_graph_simplification_time", stats.simplificationTime},
+             {"best_score", stats.score}}}};
+
+    if (stats.autoMethods.size()) {
+      util::json::Dict methods;
+      for (const auto& m : stats.autoMethods) methods[m.first] = m.second;
+      jsonStats["auto_methods"] = methods;
+    }
+  }
+
+  if (cfg.outputFormat == "bin") {
+    shared::linegraph::BinGraphWriter bout(outStr, jsonStats);
+    bout.add(g);
+    bout.flush();
+  } else if (cfg.outputFormat == "topojson") {
+    shared::linegraph::TopoJsonGraphWriter tout(outStr, jsonStats);
+    tout.add(g);
+    tout.flush();
+  } else {
+    shared::linegraph::JsonGraphWriter jout(outStr, jsonStats);
+    jout.add(g);
+    jout.flush();
+  }
+
+  return (0);
+}
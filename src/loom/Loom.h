@@ -0,0 +1,19 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_LOOM_H_
+#define LOOM_LOOM_H_
+
+#include <iostream>
+
+namespace loom {
+
+// Run loom with the given command line arguments. The input line graph is
+// read from inStr, the graph with optimized line orderings is written to
+// outStr.
+int run(int argc, char** argv, std::istream* inStr, std::ostream* outStr);
+
+}  // namespace loom
+
+#endif  // LOOM_LOOM_H_
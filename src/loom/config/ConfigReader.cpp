@@ -10,6 +10,7 @@
 #include "loom/_config.h"
 #include "loom/config/ConfigReader.h"
 #include "loom/config/LoomConfig.h"
+#include "shared/io/CompressedStream.h"
 #include "util/log/Log.h"
 
 using loom::config::ConfigReader;
@@ -43,12 +44,24 @@ void ConfigReader::help(const char* bin) const {
             << "Don't apply untangling rules\n"
             << std::setw(41) << "  --no-prune"
             << "Don't apply pruning rules\n"
+            << std::setw(41) << "  --bundle-lines arg (=0)"
+            << "Optimize lines sharing this fraction of their\n"
+            << std::setw(41) << " "
+            << " edges as bundles first, 0 disables\n"
+            << std::setw(41) << "  --snap-orphan-stations"
+            << "Connect stations without edges to edges\n"
+            << std::setw(41) << " "
+            << " passing through them\n"
             << std::setw(41) << "  -m [ --optim-method ] arg (=comb)"
             << "Optimization method, one of ilp-naive, ilp,\n"
             << std::setw(41) << " "
-            << " comb, exhaust, hillc, hillc-random, anneal,\n"
+            << " auto, comb, exhaust, exhaust-bnb, tree-dp,\n"
+            << std::setw(41) << " "
+            << " hillc, hillc-random, anneal, anneal-random,\n"
+            << std::setw(41) << " "
+            << " anneal-rex, anneal-rex-random, tabu, greedy,\n"
             << std::setw(41) << " "
-            << " anneal-random, greedy, greedy-lookahead, null\n"
+            << " greedy-lookahead, null\n"
             << std::setw(41) << "  --same-seg-cross-pen arg (=4)"
             << "Penalty for same-segment crossings\n"
             << std::setw(41) << "  --diff-seg-cross-pen arg (=1)"
@@ -60,7 +73,27 @@ void ConfigReader::help(const char* bin) const {
             << std::setw(41) << "  --sep-pen arg (=3)"
             << "Penalty for separations\n"
             << std::setw(41) << "  --in-stat-sep-pen arg (=9)"
-            << "Penalty for separations at stations\n\n"
+            << "Penalty for separations at stations\n"
+            << std::setw(41) << "  -t [ --threads ] arg (=1)"
+            << "Number of components optimized in parallel,\n"
+            << std::setw(41) << " "
+            << "also caps all other threads, incl. the ILP solver\n"
+            << std::setw(41) << "  --multi-start arg (=1)"
+            << "Number of random starts per component for\n"
+            << std::setw(41) << " "
+            << " hillc-random and anneal-random\n"
+            << std::setw(41) << "  --replicas arg (=8)"
+            << "Number of replicas for anneal-rex\n"
+            << std::setw(41) << "  --tabu-tenure arg (=10)"
+            << "Iterations a reordered line pair stays tabu\n"
+            << std::setw(41) << "  --tabu-iters arg (=1000)"
+            << "Iterations without improvement after which\n"
+            << std::setw(41) << " "
+            << " tabu search stops\n"
+            << std::setw(41) << "  --seed arg (=-1)"
+            << "Seed of the randomized optimizers, -1 for a\n"
+            << std::setw(41) << " "
+            << " random seed\n\n"
             << "Misc:\n"
             << std::setw(41) << "  -D [ --from-dot ]"
             << "input is in dot format\n"
@@ -68,16 +101,70 @@ void ConfigReader::help(const char* bin) const {
             << "Print stats to stdout\n"
             << std::setw(41) << "  --write-stats"
             << "Write stats to output\n"
+            << std::setw(41) << "  --format arg (=json)"
+            << "Output format, either json, topojson or bin\n"
+            << std::setw(41) << "  --compress arg (=none)"
+            << "Compress the output, either none, gzip or zstd\n"
             << std::setw(41) << "  --ilp-solver arg (=gurobi)"
             << "Preferred ILP solver, either glpk, cbc, or gurobi.\n"
             << std::setw(41) << " "
-            << "Will fall back if not available.\n"
+            << "Will fall back if not available. portfolio\n"
+            << std::setw(41) << " "
+            << "races all available solvers, remote sends\n"
+            << std::setw(41) << " "
+            << "the ILPs to --ilp-remote-cmd.\n"
+            << std::setw(41) << "  --ilp-remote-cmd arg"
+            << "Command solving ILPs for --ilp-solver remote,\n"
+            << std::setw(41) << " "
+            << " e.g. 'ssh host ilpworker'\n"
             << std::setw(41) << "  --ilp-num-threads arg (=0)"
             << "Number of threads to use by ILP solver,\n"
             << std::setw(41) << " "
             << " 0 means solver default\n"
             << std::setw(41) << "  --ilp-time-limit arg (=-1)"
             << "ILP solve time limit (seconds), -1 for infinite\n"
+            << std::setw(41) << "  --time-budget arg (=-1)"
+            << "Total optimization time budget (seconds),\n"
+            << std::setw(41) << " "
+            << " -1 for infinite\n"
+            << std::setw(41) << "  --deadline arg (=0)"
+            << "Stop optimizing after this many seconds and\n"
+            << std::setw(41) << " "
+            << " write the best orderings so far, 0 for none\n"
+            << std::setw(41) << "  --ilp-warm-start"
+            << "Start ILP solver from hill climbing solution\n"
+            << std::setw(41) << "  --ilp-lazy"
+            << "Add crossing constraints of the edge order\n"
+            << std::setw(41) << " "
+            << " ILP only where needed, re-solve until none\n"
+            << std::setw(41) << " "
+            << " is violated\n"
+            << std::setw(41) << "  --ilp-batch-size arg (=0)"
+            << "Pack small component ILPs into ILPs of up to\n"
+            << std::setw(41) << " "
+            << " this many position variables, 0 disables\n"
+            << std::setw(41) << "  --cache-dir arg"
+            << "Cache optimized component orderings in this\n"
+            << std::setw(41) << " "
+            << " directory and reuse them\n"
+            << std::setw(41) << "  --cache-max-size arg (=1024)"
+            << "Size limit of the order cache in MB\n"
+            << std::setw(41) << "  --from-reference arg"
+            << "Keep the orderings of this loom result of a\n"
+            << std::setw(41) << " "
+            << " superset of the lines where they still apply\n"
+            << std::setw(41) << "  --stage-cache-dir arg"
+            << "Reuse the output of identical runs from this\n"
+            << std::setw(41) << " "
+            << " directory\n"
+            << std::setw(41) << "  --trace arg"
+            << "Write a Chrome trace of the run to this file\n"
+            << std::setw(41) << "  --metrics-out arg"
+            << "Write per-phase resource usage to this JSON file\n"
+            << std::setw(41) << "  --progress-fd arg"
+            << "Write progress as JSON lines to this file\n"
+            << std::setw(41) << " "
+            << " descriptor\n"
             << std::setw(41) << "  --dbg-output-path arg (=.)"
             << "Path used for debug output\n"
             << std::setw(41) << "  --output-optgraph"
@@ -107,10 +194,33 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
       {"dbg-output-path", required_argument, 0, 14},
       {"output-optgraph", required_argument, 0, 15},
       {"write-stats", no_argument, 0, 16},
+      {"format", required_argument, 0, 17},
+      {"ilp-warm-start", no_argument, 0, 18},
+      {"cache-dir", required_argument, 0, 19},
+      {"cache-max-size", required_argument, 0, 20},
+      {"time-budget", required_argument, 0, 21},
+      {"multi-start", required_argument, 0, 22},
+      {"replicas", required_argument, 0, 23},
+      {"stage-cache-dir", required_argument, 0, 24},
+      {"ilp-batch-size", required_argument, 0, 25},
+      {"trace", required_argument, 0, 26},
+      {"metrics-out", required_argument, 0, 27},
+      {"snap-orphan-stations", no_argument, 0, 28},
+      {"bundle-lines", required_argument, 0, 29},
+      {"ilp-lazy", no_argument, 0, 30},
+      {"seed", required_argument, 0, 31},
+      {"deadline", required_argument, 0, 32},
+      {"progress-fd", required_argument, 0, 33},
+      {"from-reference", required_argument, 0, 34},
+      {"ilp-remote-cmd", required_argument, 0, 35},
+      {"compress", required_argument, 0, 36},
+      {"tabu-tenure", required_argument, 0, 37},
+      {"tabu-iters", required_argument, 0, 38},
+      {"threads", required_argument, 0, 't'},
       {0, 0, 0, 0}};
 
   int c;
-  while ((c = getopt_long(argc, argv, ":hvm:D", ops, 0)) != -1) {
+  while ((c = getopt_long(argc, argv, ":hvm:Dt:", ops, 0)) != -1) {
     switch (c) {
       case 'h':
         help(argv[0]);
@@ -169,9 +279,83 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
       case 16:
         cfg->writeStats = true;
         break;
+      case 17:
+        cfg->outputFormat = optarg;
+        break;
+      case 18:
+        cfg->ilpWarmStart = true;
+        break;
+      case 19:
+        cfg->cacheDir = optarg;
+        break;
+      case 20:
+        cfg->cacheMaxSize = atol(optarg);
+        break;
+      case 21:
+        cfg->timeBudget = atof(optarg);
+        break;
+      case 22:
+        cfg->multiStart = atoi(optarg);
+        break;
+      case 23:
+        cfg->replicas = atoi(optarg);
+        break;
+      case 24:
+        cfg->stageCacheDir = optarg;
+        break;
+      case 25:
+        cfg->ilpBatchSize = atoi(optarg);
+        break;
+      case 26:
+        cfg->tracePath = optarg;
+        break;
+      case 27:
+        cfg->metricsPath = optarg;
+        break;
+      case 28:
+        cfg->snapOrphanStations = true;
+        break;
+      case 29:
+        cfg->bundleShare = atof(optarg);
+        break;
+      case 30:
+        cfg->ilpLazy = true;
+        break;
+      case 31:
+        cfg->seed = atoll(optarg);
+        break;
+      case 32:
+        cfg->deadline = atof(optarg);
+        break;
+      case 33:
+        cfg->progressFd = atoi(optarg);
+        break;
+      case 34:
+        cfg->referencePath = optarg;
+        break;
+      case 35:
+        cfg->ilpRemoteCmd = optarg;
+        break;
+      case 36:
+        if (!shared::io::parseCodec(optarg, &cfg->compress)) {
+          std::cerr << "Unknown compression " << optarg
+                    << ", must be one of {none, gzip, zstd}" << std::endl;
+          exit(1);
+        }
+        break;
+      case 37:
+        cfg->tabuTenure = atoi(optarg);
+        break;
+      case 38:
+        cfg->tabuIters = atoi(optarg);
+        break;
       case 'D':
         cfg->fromDot = true;
         break;
+      case 't':
+        cfg->threads = atoi(optarg);
+        cfg->threadBudget = cfg->threads;
+        break;
       case ':':
         std::cerr << argv[optind - 1];
         std::cerr << " requires an argument" << std::endl;
@@ -187,4 +371,46 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
         break;
     }
   }
+
+  if (cfg->outputFormat != "json" && cfg->outputFormat != "topojson" &&
+      cfg->outputFormat != "bin") {
+    std::cerr << "Unknown output format " << cfg->outputFormat << std::endl;
+    exit(1);
+  }
+
+  if (!shared::io::hasCodec(cfg->compress)) {
+    std::cerr << shared::io::codecName(cfg->compress)
+              << " compression was not compiled in" << std::endl;
+    exit(1);
+  }
+
+  if (cfg->threads < 1) {
+    std::cerr << "Number of threads must be at least 1" << std::endl;
+    exit(1);
+  }
+
+  // the ILP solver stays within the thread budget, unless set explicitly
+  if (cfg->threadBudget > 0 && cfg->ilpNumThreads == 0) {
+    cfg->ilpNumThreads = cfg->threadBudget;
+  }
+
+  if (cfg->multiStart < 1) {
+    std::cerr << "Number of starts must be at least 1" << std::endl;
+    exit(1);
+  }
+
+  if (cfg->bundleShare < 0 || cfg->bundleShare > 1) {
+    std::cerr << "Bundle share must be between 0 and 1" << std::endl;
+    exit(1);
+  }
+
+  if (cfg->replicas < 2) {
+    std::cerr << "Number of replicas must be at least 2" << std::endl;
+    exit(1);
+  }
+
+  if (cfg->tabuIters < 1) {
+    std::cerr << "Number of tabu iterations must be at least 1" << std::endl;
+    exit(1);
+  }
 }
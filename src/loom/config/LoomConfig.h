@@ -5,8 +5,11 @@
 #ifndef LOOM_CONFIG_LOOMCONFIG_H_
 #define LOOM_CONFIG_LOOMCONFIG_H_
 
+#include <cstdint>
 #include <string>
 
+#include "shared/io/CompressedStream.h"
+
 namespace loom {
 namespace config {
 
@@ -20,6 +23,29 @@ struct Config {
 
   size_t optimRuns = 1;
 
+  // seed of the randomized optimizers, a random seed is drawn if negative.
+  // Each run and component gets its own seed derived from it, so results do
+  // not depend on the number of threads
+  int64_t seed = -1;
+
+  // number of components optimized concurrently
+  size_t threads = 1;
+
+  // thread budget of the whole run if given with -t, 0 otherwise
+  size_t threadBudget = 0;
+
+  // number of independent random starts per component for hillc-random and
+  // anneal-random, run in parallel
+  size_t multiStart = 1;
+
+  // number of replicas for replica exchange annealing
+  size_t replicas = 8;
+
+  // iterations a changed line pair stays tabu, and iterations without
+  // improvement after which the tabu search stops
+  size_t tabuTenure = 10;
+  size_t tabuIters = 1000;
+
   bool outOptGraph = false;
 
   bool outputStats = false;
@@ -27,11 +53,35 @@ struct Config {
   bool pruneGraph = true;
 
   bool untangleGraph = true;
+
+  // lines sharing at least this fraction of their edges are bundled for a
+  // first, coarse optimization, 0 disables bundling
+  double bundleShare = 0;
   bool fromDot = false;
+  bool snapOrphanStations = false;
 
   int ilpTimeLimit = -1;
+
+  // wall clock budget in seconds for the optimization of all components,
+  // -1 for none
+  double timeBudget = -1;
+
+  // seconds from the start after which the run is cancelled and the best
+  // orderings found so far are written, 0 for none
+  double deadline = 0;
   int ilpNumThreads = 0;
 
+  // pass a heuristic solution to the ILP solver as a starting point
+  bool ilpWarmStart = false;
+
+  // start the edge order ILP without the crossing constraints of the nodes
+  // and add them for nodes where the solution has crossings, then re-solve
+  bool ilpLazy = false;
+
+  // components whose ILPs have fewer position variables are packed into
+  // ILPs of at most this many position variables, 0 disables this
+  size_t ilpBatchSize = 0;
+
   double crossPenMultiSameSeg = 4;
   double crossPenMultiDiffSeg = 1;
   double separationPenWeight = 3;
@@ -42,6 +92,36 @@ struct Config {
   std::string worldFilePath;
 
   std::string ilpSolver;
+
+  // command for --ilp-solver remote, see shared::optim::RemoteSolver
+  std::string ilpRemoteCmd;
+
+  // directory of the component order cache, empty if disabled
+  std::string cacheDir;
+
+  // size limit of the order cache in MB
+  size_t cacheMaxSize = 1024;
+
+  // loom result of a superset of the input lines, components whose edges
+  // all match it keep its orderings, empty if disabled
+  std::string referencePath;
+
+  // directory of the stage output cache, empty if disabled
+  std::string stageCacheDir;
+
+  // write a Chrome trace of the run to this file, empty if disabled
+  std::string tracePath;
+
+  // write per-phase resource usage as JSON to this file, empty if disabled
+  std::string metricsPath;
+
+  // write the progress as JSON lines to this file descriptor, -1 if disabled
+  int progressFd = -1;
+
+  std::string outputFormat = "json";
+
+  // compression of the output, the input is decompressed if needed
+  shared::io::Codec compress = shared::io::CODEC_NONE;
 };
 
 }  // namespace config
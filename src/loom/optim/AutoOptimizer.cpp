@@ -0,0 +1,109 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cmath>
+#include "loom/optim/AutoOptimizer.h"
+#include "util/log/Log.h"
+
+using loom::optim::AutoOptimizer;
+using loom::optim::Optimizer;
+using shared::rendergraph::HierarOrderCfg;
+
+namespace {
+// rough per-unit costs in ms, only their magnitudes matter
+const double MS_PER_LEAF_EXHAUST = 1e-2;
+const double MS_PER_DP_STEP = 1e-4;
+const double MS_PER_BNB_NODE = 1e-3;
+const double MS_ILP_ROWS_FACTOR = 1e-3;
+
+// visited nodes after which branch-and-bound aborts, see
+// BranchBoundOptimizer
+const double BNB_MAX_NODES = 50000000;
+}  // namespace
+
+// _____________________________________________________________________________
+double AutoOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
+                                   HierarOrderCfg* hc, size_t depth,
+                                   OptResStats& stats) const {
+  double budget = stats.hasDeadline ? timeLeft(stats) : _maxExactMs;
+  const Optimizer* opt = getOptimizer(g, budget);
+
+  LOGTO(DEBUG, std::cerr) << prefix(depth) << "(AutoOptimizer) Optimizing comp "
+                          << "with " << g.size() << " nodes, max card "
+                          << maxCard(g) << ", sol space size "
+                          << solutionSpaceSize(g) << " with "
+                          << opt->getName() << ", estimated "
+                          << estimateCost(opt, g) << " ms of " << budget
+                          << " ms";
+
+  stats.autoMethods[opt->getName()]++;
+
+  return opt->optimizeComp(og, g, hc, depth + 1, stats);
+}
+
+// _____________________________________________________________________________
+size_t AutoOptimizer::ilpBatchSize(const std::set<OptNode*>& g) const {
+  if (getOptimizer(g, _maxExactMs) != &_ilpOpt) return 0;
+  return _ilpOpt.ilpBatchSize(g);
+}
+
+// _____________________________________________________________________________
+const Optimizer* AutoOptimizer::getOptimizer(const std::set<OptNode*>& g,
+                                             double budget) const {
+  const Optimizer* comb = CombOptimizer::getOptimizer(g);
+
+  // null, exhaustive and tree DP are only picked for cheap components
+  if (comb != &_bnbOpt && comb != &_ilpOpt) return comb;
+
+  const Optimizer* exact = &_bnbOpt;
+#if defined GUROBI_FOUND || defined GLPK_FOUND || defined COIN_FOUND
+  if (estimateCost(&_ilpOpt, g) < estimateCost(&_bnbOpt, g)) exact = &_ilpOpt;
+#endif
+
+  if (estimateCost(exact, g) <= budget) return exact;
+  return &_hillcOpt;
+}
+
+// _____________________________________________________________________________
+double AutoOptimizer::estimateCost(const Optimizer* o,
+                                   const std::set<OptNode*>& g) const {
+  if (o == &_nullOpt) return 0;
+
+  if (o == &_exhausOpt) return solutionSpaceSize(g) * MS_PER_LEAF_EXHAUST;
+
+  if (o == &_treeOpt) return TreeDPOptimizer::dpCost(g) * MS_PER_DP_STEP;
+
+  if (o == &_bnbOpt) {
+    return std::min(solutionSpaceSize(g), BNB_MAX_NODES) * MS_PER_BNB_NODE;
+  }
+
+  if (o == &_ilpOpt) {
+    // the crossing constraints dominate the model, one per pair of lines
+    // continuing from an edge into another at a node
+    double rows = 0;
+    for (OptNode* n : g) {
+      for (OptEdge* a : n->getAdjList()) {
+        for (OptEdge* b : n->getAdjList()) {
+          if (a >= b) continue;
+          double c = std::min(a->pl().getCardinality(),
+                              b->pl().getCardinality());
+          rows += c * c;
+        }
+      }
+    }
+    return std::pow(rows, 1.5) * MS_ILP_ROWS_FACTOR;
+  }
+
+  // hill climbing, linear in the number of line swaps per round
+  double swaps = 0;
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      double c = e->pl().getCardinality();
+      swaps += c * c;
+    }
+  }
+  return swaps * MS_PER_BNB_NODE;
+}
@@ -0,0 +1,55 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_AUTOOPTIMIZER_H_
+#define LOOM_OPTIM_AUTOOPTIMIZER_H_
+
+#include <string>
+#include "loom/config/LoomConfig.h"
+#include "loom/optim/CombOptimizer.h"
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/Optimizer.h"
+#include "shared/rendergraph/OrderCfg.h"
+
+namespace loom {
+namespace optim {
+
+// Picks the optimizer of each component from a coarse estimate of its
+// running time. Components which are cheap to solve exactly are optimized
+// as by CombOptimizer. For the others, the cheaper of branch-and-bound and
+// the ILP is used if its estimate fits into the time left for the component
+// (or into maxExactMs if there is no time budget), the greedy ordering
+// improved by hill climbing otherwise.
+class AutoOptimizer : public CombOptimizer {
+ public:
+  AutoOptimizer(const config::Config* cfg,
+                const shared::rendergraph::Penalties& pens)
+      : CombOptimizer(cfg, pens), _maxExactMs(10000){};
+
+  AutoOptimizer(const config::Config* cfg,
+                const shared::rendergraph::Penalties& pens, double maxExactMs)
+      : CombOptimizer(cfg, pens), _maxExactMs(maxExactMs){};
+
+  double optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
+                      shared::rendergraph::HierarOrderCfg* c, size_t depth,
+                      OptResStats& stats) const;
+
+  virtual std::string getName() const { return "auto"; }
+
+  virtual size_t ilpBatchSize(const std::set<OptNode*>& g) const;
+
+  // estimated milliseconds optimizer o needs for component g
+  double estimateCost(const Optimizer* o, const std::set<OptNode*>& g) const;
+
+ private:
+  double _maxExactMs;
+
+  // the optimizer used for component g if at most budget ms are available
+  const Optimizer* getOptimizer(const std::set<OptNode*>& g,
+                                double budget) const;
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_AUTOOPTIMIZER_H_
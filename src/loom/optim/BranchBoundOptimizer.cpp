@@ -0,0 +1,163 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <chrono>
+#include "loom/optim/BranchBoundOptimizer.h"
+#include "loom/optim/GreedyOptimizer.h"
+#include "loom/optim/OptGraphDeltaScorer.h"
+#include "shared/threads/Cancel.h"
+#include "util/log/Log.h"
+
+using loom::optim::BranchBoundOptimizer;
+using loom::optim::DenseOrderCfg;
+using loom::optim::OptGraphDeltaScorer;
+using shared::rendergraph::HierarOrderCfg;
+
+namespace {
+struct SearchState {
+  OptGraphDeltaScorer* delta;
+  const std::vector<size_t>* order;
+
+  DenseOrderCfg best;
+  double bestScore;
+
+  size_t nodes;
+  size_t maxNodes;
+  bool aborted;
+
+  const loom::optim::OptResStats* stats;
+
+  // reused permutation buffers, one per depth
+  std::vector<std::vector<DenseOrderCfg::LineId>> perms;
+};
+
+// _____________________________________________________________________________
+void search(SearchState* s, size_t d) {
+  if (s->aborted || s->bestScore == 0) return;
+
+  if (++s->nodes > s->maxNodes) {
+    s->aborted = true;
+    return;
+  }
+
+  if (s->nodes % 4096 == 0 &&
+      (shared::threads::cancelled() ||
+       (s->stats->hasDeadline &&
+        std::chrono::steady_clock::now() > s->stats->deadline))) {
+    s->aborted = true;
+    return;
+  }
+
+  if (d == s->order->size()) {
+    double score = s->delta->getScore();
+    if (score < s->bestScore) {
+      s->bestScore = score;
+      s->best = s->delta->getCfg();
+    }
+    return;
+  }
+
+  size_t e = (*s->order)[d];
+  auto& perm = s->perms[d];
+
+  // start with the ordering of the best known solution, it is likely to be
+  // good and leads to early pruning
+  perm.assign(s->best.begin(e), s->best.end(e));
+  const auto start = perm;
+
+  s->delta->setAssigned(e, true);
+
+  do {
+    s->delta->setOrder(e, perm.data());
+    if (s->delta->getLowerBound() < s->bestScore) search(s, d + 1);
+    if (s->aborted || s->bestScore == 0) break;
+    // wraps around to the sorted permutation after the last one
+    std::next_permutation(perm.begin(), perm.end());
+  } while (perm != start);
+
+  s->delta->setAssigned(e, false);
+}
+}  // namespace
+
+// _____________________________________________________________________________
+double BranchBoundOptimizer::optimizeComp(OptGraph* og,
+                                          const std::set<OptNode*>& g,
+                                          HierarOrderCfg* hc, size_t depth,
+                                          OptResStats& stats) const {
+  UNUSED(og);
+  T_START(1);
+
+  // seed with the greedy ordering, improved by hill climbing
+  OptOrderCfg cur;
+  GreedyOptimizer greedy(_cfg, _scorer.getPens(), true);
+  greedy.getFlatConfig(g, &cur);
+
+  OptGraphDeltaScorer delta(_optScorer, g, DenseOrderCfg(g, cur));
+  hillClimb(&delta);
+
+  auto order = assignOrder(delta.getCfg());
+
+  SearchState s{&delta, &order, delta.getCfg(), delta.getScore(), 0,
+                _maxNodes, false, &stats, {}};
+  s.perms.resize(order.size());
+
+  LOGTO(DEBUG, std::cerr) << prefix(depth) << "(BranchBoundOptimizer) "
+                          << order.size() << " edges to assign, seed score "
+                          << s.bestScore;
+
+  for (auto e : order) delta.setAssigned(e, false);
+  search(&s, 0);
+
+  if (s.aborted) {
+    LOGTO(WARN, std::cerr) << prefix(depth) << "(BranchBoundOptimizer) "
+                           << "Search aborted after " << s.nodes
+                           << " nodes, result may not be optimal";
+  }
+
+  LOGTO(DEBUG, std::cerr) << prefix(depth) << "(BranchBoundOptimizer) "
+                          << "Visited " << s.nodes << " nodes, best score "
+                          << s.bestScore;
+
+  s.best.writeOptOrderCfg(&cur);
+  writeHierarch(&cur, hc);
+
+  return T_STOP(1);
+}
+
+// _____________________________________________________________________________
+std::vector<size_t> BranchBoundOptimizer::assignOrder(
+    const DenseOrderCfg& cfg) const {
+  // edges with a single line have only one ordering and stay assigned
+  std::vector<size_t> ret;
+  std::vector<bool> done(cfg.numEdgs(), false);
+  std::vector<bool> frontier(cfg.numEdgs(), false);
+
+  size_t todo = 0;
+  for (size_t e = 0; e < cfg.numEdgs(); e++)
+    if (cfg.size(e) > 1) todo++;
+
+  while (ret.size() < todo) {
+    // prefer the frontier edge with maximum cardinality, if the frontier is
+    // empty, start a new region with the global maximum
+    size_t next = cfg.numEdgs();
+    for (bool front : {true, false}) {
+      for (size_t e = 0; e < cfg.numEdgs(); e++) {
+        if (done[e] || cfg.size(e) < 2 || (front && !frontier[e])) continue;
+        if (next == cfg.numEdgs() || cfg.size(e) > cfg.size(next)) next = e;
+      }
+      if (next != cfg.numEdgs()) break;
+    }
+
+    done[next] = true;
+    ret.push_back(next);
+
+    auto edg = cfg.getEdg(next);
+    for (auto n : {edg->getFrom(), edg->getTo()}) {
+      for (auto adj : n->getAdjList()) frontier[cfg.getEdgIdx(adj)] = true;
+    }
+  }
+
+  return ret;
+}
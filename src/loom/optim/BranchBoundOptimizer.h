@@ -0,0 +1,51 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_BRANCHBOUNDOPTIMIZER_H_
+#define LOOM_OPTIM_BRANCHBOUNDOPTIMIZER_H_
+
+#include "loom/config/LoomConfig.h"
+#include "loom/optim/HillClimbOptimizer.h"
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/Optimizer.h"
+#include "shared/rendergraph/OrderCfg.h"
+
+namespace loom {
+namespace optim {
+
+// Exhaustive search with branch-and-bound. Edges are assigned one after
+// another, starting with the edge of maximum cardinality and always continuing
+// with the adjacent edge of maximum cardinality. Partial assignments whose
+// lower bound (from the crossings and separations between already assigned
+// edges) is not below the best known score are pruned. The best known score
+// is seeded with the greedy ordering, improved by hill climbing.
+//
+// If more than maxNodes search nodes are visited, the search is aborted and
+// the best ordering found so far is used.
+class BranchBoundOptimizer : public HillClimbOptimizer {
+ public:
+  BranchBoundOptimizer(const config::Config* cfg,
+                       const shared::rendergraph::Penalties& pens)
+      : HillClimbOptimizer(cfg, pens, false), _maxNodes(50000000){};
+
+  BranchBoundOptimizer(const config::Config* cfg,
+                       const shared::rendergraph::Penalties& pens,
+                       size_t maxNodes)
+      : HillClimbOptimizer(cfg, pens, false), _maxNodes(maxNodes){};
+
+  virtual double optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
+                           shared::rendergraph::HierarOrderCfg* c, size_t depth,
+                           OptResStats& stats) const;
+
+  virtual std::string getName() const { return "exhaust-bnb"; }
+
+ private:
+  size_t _maxNodes;
+
+  std::vector<size_t> assignOrder(const DenseOrderCfg& cfg) const;
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_BRANCHBOUNDOPTIMIZER_H_
@@ -31,16 +31,38 @@ double CombOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
                           << " nodes, max card " << maxC << ", sol space size "
                           << solSp;
 
-  if (maxC == 1) {
-    return _nullOpt.optimizeComp(og, g, hc, depth + 1, stats);
-  } else if (solSp < 500) {
-    return _exhausOpt.optimizeComp(og, g, hc, depth + 1, stats);
+  return getOptimizer(g)->optimizeComp(og, g, hc, depth + 1, stats);
+}
+
+// _____________________________________________________________________________
+size_t CombOptimizer::ilpBatchSize(const std::set<OptNode*>& g) const {
+  if (getOptimizer(g) != &_ilpOpt) return 0;
+  return _ilpOpt.ilpBatchSize(g);
+}
+
+// _____________________________________________________________________________
+const loom::optim::Optimizer* CombOptimizer::getOptimizer(
+    const std::set<OptNode*>& g) const {
+  if (maxCard(g) == 1) {
+    return &_nullOpt;
+  } else if (!_forceILP && _treeOpt.canOptimize(g)) {
+    // acyclic components are solved exactly by dynamic programming
+    return &_treeOpt;
+  } else if (solutionSpaceSize(g) < 50000) {
+    // the exhaustive search rescores a single edge per configuration and
+    // runs on the threads left by the component scheduling
+    return &_exhausOpt;
   } else {
-    if (_forceILP) return _ilpOpt.optimizeComp(og, g, hc, depth + 1, stats);
+    if (_forceILP) return &_ilpOpt;
 #if defined GUROBI_FOUND || defined GLPK_FOUND || defined COIN_FOUND
-    return _ilpOpt.optimizeComp(og, g, hc, depth + 1, stats);
+    // mid-sized components are solved exactly without the ILP overhead, the
+    // search cannot exceed its node budget for these
+    if (solutionSpaceSize(g) < 1000000) return &_bnbOpt;
+    return &_ilpOpt;
 #else
-    return _hillcOpt.optimizeComp(og, g, hc, depth + 1, stats);
+    // without a solver, branch-and-bound gives exact results if the search
+    // is not aborted, and falls back to the hill climbing result otherwise
+    return &_bnbOpt;
 #endif
   }
 }
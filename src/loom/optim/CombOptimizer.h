@@ -6,6 +6,7 @@
 #define LOOM_OPTIM_COMBOPTIMIZER_H_
 
 #include "loom/config/LoomConfig.h"
+#include "loom/optim/BranchBoundOptimizer.h"
 #include "loom/optim/ExhaustiveOptimizer.h"
 #include "loom/optim/HillClimbOptimizer.h"
 #include "loom/optim/ILPEdgeOrderOptimizer.h"
@@ -13,6 +14,7 @@
 #include "loom/optim/OptGraph.h"
 #include "loom/optim/Optimizer.h"
 #include "loom/optim/SimulatedAnnealingOptimizer.h"
+#include "loom/optim/TreeDPOptimizer.h"
 #include "shared/rendergraph/OrderCfg.h"
 
 namespace loom {
@@ -27,7 +29,9 @@ class CombOptimizer : public Optimizer {
         _nullOpt(cfg, pens),
         _exhausOpt(cfg, pens),
         _hillcOpt(cfg, pens, false),
+        _bnbOpt(cfg, pens),
         _annealOpt(cfg, pens, false),
+        _treeOpt(cfg, pens),
         _forceILP(false){};
 
   CombOptimizer(const config::Config* cfg,
@@ -37,7 +41,9 @@ class CombOptimizer : public Optimizer {
         _nullOpt(cfg, pens),
         _exhausOpt(cfg, pens),
         _hillcOpt(cfg, pens, false),
+        _bnbOpt(cfg, pens),
         _annealOpt(cfg, pens, false),
+        _treeOpt(cfg, pens),
         _forceILP(forceILP){};
 
   double optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
@@ -46,14 +52,21 @@ class CombOptimizer : public Optimizer {
 
   virtual std::string getName() const { return "comb";}
 
- private:
+  virtual size_t ilpBatchSize(const std::set<OptNode*>& g) const;
+
+ protected:
   const ILPEdgeOrderOptimizer _ilpOpt;
   const NullOptimizer _nullOpt;
   const ExhaustiveOptimizer _exhausOpt;
   const HillClimbOptimizer _hillcOpt;
+  const BranchBoundOptimizer _bnbOpt;
   const SimulatedAnnealingOptimizer _annealOpt;
+  const TreeDPOptimizer _treeOpt;
 
   const bool _forceILP;
+
+  // the optimizer used for component g
+  const Optimizer* getOptimizer(const std::set<OptNode*>& g) const;
 };
 }  // namespace optim
 }  // namespace loom
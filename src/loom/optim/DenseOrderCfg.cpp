@@ -0,0 +1,57 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cassert>
+#include <limits>
+#include "loom/optim/DenseOrderCfg.h"
+#include "shared/linegraph/Line.h"
+
+using loom::optim::DenseOrderCfg;
+using loom::optim::OptOrderCfg;
+
+// _____________________________________________________________________________
+DenseOrderCfg::DenseOrderCfg(const std::set<OptNode*>& g) {
+  _offs.push_back(0);
+
+  for (auto n : g) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      size_t card = e->pl().getLines().size();
+      assert(card <= std::numeric_limits<LineId>::max());
+
+      _edgIdx[e] = _edgs.size();
+      _edgs.push_back(e);
+      for (size_t i = 0; i < card; i++) _perm.push_back(i);
+      _offs.push_back(_perm.size());
+    }
+  }
+}
+
+// _____________________________________________________________________________
+DenseOrderCfg::DenseOrderCfg(const std::set<OptNode*>& g, const OptOrderCfg& c)
+    : DenseOrderCfg(g) {
+  for (size_t e = 0; e < _edgs.size(); e++) {
+    const auto& lines = _edgs[e]->pl().getLines();
+    const auto& ce = c.at(_edgs[e]);
+    assert(ce.size() == size(e));
+
+    for (size_t p = 0; p < ce.size(); p++) {
+      for (size_t i = 0; i < lines.size(); i++) {
+        if (lines[i].line == ce[p]) {
+          begin(e)[p] = i;
+          break;
+        }
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void DenseOrderCfg::writeOptOrderCfg(OptOrderCfg* c) const {
+  for (size_t e = 0; e < _edgs.size(); e++) {
+    auto& ce = (*c)[_edgs[e]];
+    ce.resize(size(e));
+    for (size_t p = 0; p < size(e); p++) ce[p] = getLine(e, p);
+  }
+}
@@ -0,0 +1,60 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_DENSEORDERCFG_H_
+#define LOOM_OPTIM_DENSEORDERCFG_H_
+
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "loom/optim/OptGraph.h"
+
+namespace loom {
+namespace optim {
+
+// Dense line ordering configuration of a single optim graph component.
+// Edges are numbered, and the ordering of each edge is stored as a
+// permutation of its local line ids (indices into OptEdgePL::getLines()) in
+// one contiguous buffer. Copying and assigning configurations of the same
+// component does not allocate once the buffer exists.
+//
+// Conversion from and to OptOrderCfg is meant to happen only at the
+// boundaries of an optimizer.
+class DenseOrderCfg {
+ public:
+  typedef uint16_t LineId;
+
+  // ordering of each edge is the order of its line occurrences
+  explicit DenseOrderCfg(const std::set<OptNode*>& g);
+  DenseOrderCfg(const std::set<OptNode*>& g, const OptOrderCfg& c);
+
+  size_t numEdgs() const { return _edgs.size(); }
+  OptEdge* getEdg(size_t e) const { return _edgs[e]; }
+  size_t getEdgIdx(const OptEdge* e) const { return _edgIdx.at(e); }
+
+  // number of lines on edge e
+  size_t size(size_t e) const { return _offs[e + 1] - _offs[e]; }
+
+  LineId* begin(size_t e) { return _perm.data() + _offs[e]; }
+  LineId* end(size_t e) { return _perm.data() + _offs[e + 1]; }
+  const LineId* begin(size_t e) const { return _perm.data() + _offs[e]; }
+  const LineId* end(size_t e) const { return _perm.data() + _offs[e + 1]; }
+
+  const shared::linegraph::Line* getLine(size_t e, size_t pos) const {
+    return _edgs[e]->pl().getLines()[begin(e)[pos]].line;
+  }
+
+  void writeOptOrderCfg(OptOrderCfg* c) const;
+
+ private:
+  std::vector<OptEdge*> _edgs;
+  std::vector<size_t> _offs;
+  std::vector<LineId> _perm;
+  std::unordered_map<const OptEdge*, size_t> _edgIdx;
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_DENSEORDERCFG_H_
@@ -3,9 +3,15 @@
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
 #include <algorithm>
-#include <unordered_map>
+#include <atomic>
+#include <limits>
+#include <memory>
 #include <random>
+#include <thread>
+#include <unordered_map>
+#include "loom/optim/DenseOrderCfg.h"
 #include "loom/optim/ExhaustiveOptimizer.h"
+#include "loom/optim/OptGraphDeltaScorer.h"
 #include "shared/linegraph/Line.h"
 #include "util/log/Log.h"
 
@@ -15,106 +21,224 @@ using loom::optim::ExhaustiveOptimizer;
 using shared::linegraph::Line;
 using shared::rendergraph::HierarOrderCfg;
 
+namespace {
+// configurations enumerated per chunk at least, smaller search spaces are
+// not split
+const uint64_t MIN_CHUNK_SIZE = 4096;
+
+// chunks per thread, for load balancing
+const size_t CHUNKS_PER_THREAD = 16;
+
+// Enumerates the configurations of a component in the order of a reflected
+// mixed-radix Gray code over the edges with more than one line. The digit
+// of each edge is the lexicographic rank of its permutation, and successive
+// configurations differ in the permutation of a single edge, which is its
+// next or previous permutation. The delta scorer thus only re-evaluates the
+// pairs involving this edge in each step.
+class GrayEnum {
+ public:
+  explicit GrayEnum(const DenseOrderCfg& c) : _size(1) {
+    for (size_t e = 0; e < c.numEdgs(); e++) {
+      if (c.size(e) < 2) continue;
+      uint64_t f = 1;
+      for (size_t i = 2; i <= c.size(e); i++) f *= i;
+      _edgs.push_back(e);
+      _radix.push_back(f);
+      _size *= f;
+    }
+    _digit.resize(_edgs.size());
+    _dir.resize(_edgs.size());
+  }
+
+  // number of configurations
+  uint64_t size() const { return _size; }
+
+  // set the configuration of s to the one at position rank
+  void seek(uint64_t rank, OptGraphDeltaScorer* s) {
+    const auto& c = s->getCfg();
+    uint64_t q = rank;
+    std::vector<DenseOrderCfg::LineId> perm, left;
+
+    for (size_t i = 0; i < _edgs.size(); i++) {
+      uint64_t d = q % _radix[i];
+      q /= _radix[i];
+
+      // the digit runs backwards if the higher digits form an odd number
+      _dir[i] = (q % 2) ? -1 : 1;
+      _digit[i] = (q % 2) ? _radix[i] - 1 - d : d;
+
+      // the permutation of lexicographic rank _digit[i], from its factorial
+      // number representation
+      size_t k = c.size(_edgs[i]);
+      uint64_t f = _radix[i];
+      uint64_t r = _digit[i];
+      left.resize(k);
+      for (size_t j = 0; j < k; j++) left[j] = j;
+      perm.clear();
+      for (size_t j = k; j > 0; j--) {
+        f /= j;
+        perm.push_back(left[r / f]);
+        left.erase(left.begin() + r / f);
+        r %= f;
+      }
+      s->setOrder(_edgs[i], perm.data());
+    }
+  }
+
+  // advance s to the next configuration, false if there is none
+  bool next(OptGraphDeltaScorer* s) {
+    for (size_t i = 0; i < _edgs.size(); i++) {
+      if (_dir[i] > 0 && _digit[i] + 1 < _radix[i]) {
+        _digit[i]++;
+        s->nextPermutation(_edgs[i]);
+        return true;
+      }
+      if (_dir[i] < 0 && _digit[i] > 0) {
+        _digit[i]--;
+        s->prevPermutation(_edgs[i]);
+        return true;
+      }
+      _dir[i] = -_dir[i];
+    }
+    return false;
+  }
+
+ private:
+  std::vector<size_t> _edgs;
+  std::vector<uint64_t> _radix;
+  std::vector<uint64_t> _digit;
+  std::vector<int> _dir;
+  uint64_t _size;
+};
+
+// best configuration found by a single thread
+struct ChunkBest {
+  double score = std::numeric_limits<double>::infinity();
+  uint64_t rank = std::numeric_limits<uint64_t>::max();
+  std::unique_ptr<DenseOrderCfg> cfg;
+};
+}  // namespace
+
 // _____________________________________________________________________________
 double ExhaustiveOptimizer::optimizeComp(OptGraph* og,
                                          const std::set<OptNode*>& g,
                                          HierarOrderCfg* hc, size_t depth,
                                          OptResStats& stats) const {
   UNUSED(og);
-  UNUSED(stats);
   LOGTO(DEBUG, std::cerr) << prefix(depth)
                           << "(ExhaustiveOptimizer) Optimizing component with "
                           << g.size() << " nodes.";
 
   T_START(1);
 
-  OptOrderCfg best, cur, null;
-  double bestScore = DBL_MAX;
+  double solSp = solutionSpaceSize(g);
+  size_t threads = std::max<size_t>(stats.threads, 1);
 
-  // fixed order list of optim graph edges
-  std::vector<OptEdge*> edges;
+  // don't try if it is pointless, assuming we can make 50.000 iterations
+  // per second and thread
+  if ((solSp / (50000 * threads)) > (60 * 60 * 6)) {
+    std::stringstream ss;
+    ss << "Exhaustive search would take too long (over "
+       << ((solSp / (50000 * threads)) / (60 * 60))
+       << " hours even assuming we can check 50.000 configurations per second"
+       << " on each of " << threads << " threads";
+    throw std::runtime_error(ss.str());
+  }
 
-  for (auto n : g)
-    for (auto e : n->getAdjList())
-      if (n == e->getFrom()) edges.push_back(e);
+  const DenseOrderCfg init(g);
+  const uint64_t size = GrayEnum(init).size();
 
-  // this guarantees that all the orderings are sorted, which we need for
-  // std::next_permutation below!
-  initialConfig(g, &null, true);
-  cur = null;
+  // the search space is split into chunks of consecutive ranks, claimed by
+  // the threads in rank order. Ties are broken by the lowest rank, so the
+  // result does not depend on the number of threads.
+  uint64_t numChunks = (size + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE;
+  numChunks = std::min<uint64_t>(numChunks, threads * CHUNKS_PER_THREAD);
+  numChunks = std::max<uint64_t>(numChunks, 1);
+  threads = std::min<size_t>(threads, numChunks);
 
-  double iters = 0;
-  double last = 0;
-  bool running = true;
+  std::atomic<uint64_t> nextChunk(0);
+  std::atomic<uint64_t> iters(0);
+  std::atomic<bool> timeout(false);
 
-  double curScore = _optScorer.getCrossingScore(g, cur);
-  if (_optScorer.optimizeSep())
-    curScore += _optScorer.getSeparationScore(g, cur);
+  // lowest rank with a score of 0, ranks above it need not be checked
+  std::atomic<uint64_t> zeroRank(std::numeric_limits<uint64_t>::max());
 
-  bestScore = curScore;
-  best = cur;
+  std::vector<ChunkBest> bests(threads);
 
-  double solSp = solutionSpaceSize(g);
+  auto worker = [&](size_t t) {
+    OptGraphDeltaScorer cur(_optScorer, g, init);
+    GrayEnum en(init);
+    auto& best = bests[t];
+    uint64_t its = 0;
 
-  // don't try if it is pointless, assuming we can make 100.000
-  // iterations per second
-  if ((solSp / 50000) > (60 * 60 * 6)) {
-    std::stringstream ss;
-    ss << "Exhaustive search would take too long (over "
-       << ((solSp / 50000) / (60 * 60))
-       << " hours even assuming we can check 50.000 configurations per second";
-    throw std::runtime_error(ss.str());
-  }
+    for (uint64_t c = nextChunk++; c < numChunks && !timeout;
+         c = nextChunk++) {
+      uint64_t lo = size * c / numChunks;
+      uint64_t hi = size * (c + 1) / numChunks;
+      if (lo > zeroRank) break;
 
-  double itTime = 0;
+      en.seek(lo, &cur);
 
-  while (true) {
-    T_START(iter);
-    if (bestScore == 0) {
-      LOGTO(DEBUG, std::cerr)
-          << prefix(depth) << "Found optimal score 0 prematurely after "
-          << iters << " iterations!";
-      writeHierarch(&best, hc);
-      return 0;
-    }
+      for (uint64_t rank = lo; rank < hi; rank++) {
+        if (rank > lo) en.next(&cur);
 
-    iters++;
+        double score = cur.getScore();
+        if (score < best.score) {
+          best.score = score;
+          best.rank = rank;
+          if (best.cfg) {
+            *best.cfg = cur.getCfg();
+          } else {
+            best.cfg.reset(new DenseOrderCfg(cur.getCfg()));
+          }
+        }
 
-    if (fabs((iters - last) - 10000) < 1) {
-      LOGTO(DEBUG, std::cerr)
-          << prefix(depth) << "@ " << iters << "/" << solSp << " ("
-          << int(((1.0 * iters) / (1.0 * solSp)) * 100) << "%, "
-          << (10000 / (itTime / 1000)) << " its/s)";
-      last = iters;
-      itTime = 0;
-    }
+        if (score == 0) {
+          uint64_t z = zeroRank;
+          while (rank < z && !zeroRank.compare_exchange_weak(z, rank)) {
+          }
+          break;
+        }
 
-    for (size_t i = 0; i < edges.size(); i++) {
-      if (std::next_permutation(cur[edges[i]].begin(), cur[edges[i]].end())) {
-        break;
-      } else if (i == edges.size() - 1) {
-        running = false;
+        if (++its % 1000 == 0) {
+          if (timeLeft(stats) <= 0) timeout = true;
+          if (timeout || rank > zeroRank) break;
+        }
       }
     }
 
-    if (!running) break;
+    iters += its;
+  };
 
-    if (_optScorer.optimizeSep())
-      curScore = _optScorer.getTotalScore(g, cur);
-    else
-      curScore = _optScorer.getCrossingScore(g, cur);
+  if (threads == 1) {
+    worker(0);
+  } else {
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+  }
 
-    if (curScore < bestScore) {
-      bestScore = curScore;
-      best = cur;
+  const ChunkBest* best = &bests.front();
+  for (const auto& b : bests) {
+    if (b.score < best->score ||
+        (b.score == best->score && b.rank < best->rank)) {
+      best = &b;
     }
-    itTime += T_STOP(iter);
+  }
+
+  if (timeout) {
+    LOGTO(DEBUG, std::cerr) << prefix(depth) << "Time budget exhausted after "
+                            << iters << " iterations";
   }
 
   LOGTO(DEBUG, std::cerr) << prefix(depth) << "Found optimal score "
-                          << bestScore << " after " << iters << " iterations!";
+                          << best->score << " after " << iters
+                          << " iterations on " << threads << " thread(s)!";
 
-  writeHierarch(&best, hc);
+  OptOrderCfg res;
+  best->cfg->writeOptOrderCfg(&res);
+  writeHierarch(&res, hc);
 
   return T_STOP(1);
 }
@@ -128,6 +252,12 @@ void ExhaustiveOptimizer::initialConfig(const std::set<OptNode*>& g,
 // _____________________________________________________________________________
 void ExhaustiveOptimizer::initialConfig(const std::set<OptNode*>& g,
                                         OptOrderCfg* cfg, bool sorted) const {
+  if (!sorted) {
+    std::mt19937 rng(std::random_device{}());
+    initialConfig(g, cfg, &rng);
+    return;
+  }
+
   for (OptNode* n : g) {
     for (OptEdge* e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
@@ -138,44 +268,22 @@ void ExhaustiveOptimizer::initialConfig(const std::set<OptNode*>& g,
         p++;
       }
 
-      if (sorted) {
-        std::sort((*cfg)[e].begin(), (*cfg)[e].end());
-      } else {
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle((*cfg)[e].begin(), (*cfg)[e].end(), g);
-      }
+      std::sort((*cfg)[e].begin(), (*cfg)[e].end());
     }
   }
 }
 
 // _____________________________________________________________________________
-void ExhaustiveOptimizer::writeHierarch(OptOrderCfg* cfg,
-                                        HierarOrderCfg* hc) const {
-  for (auto ep : *cfg) {
-    auto e = ep.first;
-
-    for (auto lnEdgPart : e->pl().lnEdgParts) {
-      if (lnEdgPart.wasCut) continue;
-      for (auto r : ep.second) {
-        // get the corresponding route occurance in the opt graph edge
-        // TODO: replace this as soon as a lookup function is present in OptLO
-        OptLO optRO;
-        for (auto ro : e->pl().getLines()) {
-          if (r == ro.line) optRO = ro;
-        }
-
-        for (auto rel : optRO.relatives) {
-          // retrieve the original line pos
-          size_t p = lnEdgPart.lnEdg->pl().linePos(rel);
-          if (!(lnEdgPart.dir ^ e->pl().lnEdgParts.front().dir)) {
-            (*hc)[lnEdgPart.lnEdg][lnEdgPart.order].insert(
-                (*hc)[lnEdgPart.lnEdg][lnEdgPart.order].begin(), p);
-          } else {
-            (*hc)[lnEdgPart.lnEdg][lnEdgPart.order].push_back(p);
-          }
-        }
-      }
+void ExhaustiveOptimizer::initialConfig(const std::set<OptNode*>& g,
+                                        OptOrderCfg* cfg,
+                                        std::mt19937* rng) const {
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      auto& order = (*cfg)[e];
+      order.clear();
+      for (const auto& lo : e->pl().getLines()) order.push_back(lo.line);
+      std::shuffle(order.begin(), order.end(), *rng);
     }
   }
 }
@@ -5,6 +5,7 @@
 #ifndef LOOM_OPTIM_EXHAUSTIVEOPTIMIZER_H_
 #define LOOM_OPTIM_EXHAUSTIVEOPTIMIZER_H_
 
+#include <random>
 #include "loom/config/LoomConfig.h"
 #include "loom/optim/OptGraph.h"
 #include "loom/optim/OptGraphScorer.h"
@@ -15,6 +16,8 @@
 namespace loom {
 namespace optim {
 
+// Scores every configuration of a component. The search space is split into
+// chunks searched in parallel, on the threads given by OptResStats::threads.
 class ExhaustiveOptimizer : public Optimizer {
  public:
   ExhaustiveOptimizer(const config::Config* cfg,
@@ -31,8 +34,10 @@ class ExhaustiveOptimizer : public Optimizer {
   void initialConfig(const std::set<OptNode*>& g, OptOrderCfg* cfg) const;
   void initialConfig(const std::set<OptNode*>& g, OptOrderCfg* cfg,
                      bool sorted) const;
-  void writeHierarch(OptOrderCfg* cfg,
-                     shared::rendergraph::HierarOrderCfg* c) const;
+
+  // random ordering of g drawn from rng
+  void initialConfig(const std::set<OptNode*>& g, OptOrderCfg* cfg,
+                     std::mt19937* rng) const;
 };
 }  // namespace optim
 }  // namespace loom
@@ -3,6 +3,9 @@
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
 #include <algorithm>
+#include <numeric>
+#include <queue>
+#include <tuple>
 #include <unordered_map>
 #include "loom/optim/GreedyOptimizer.h"
 #include "shared/linegraph/Line.h"
@@ -11,7 +14,6 @@
 using namespace loom;
 using namespace optim;
 using loom::optim::GreedyOptimizer;
-using loom::optim::SettledEdgs;
 using shared::linegraph::Line;
 using shared::rendergraph::HierarOrderCfg;
 
@@ -37,20 +39,20 @@ double GreedyOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
 // _____________________________________________________________________________
 void GreedyOptimizer::getFlatConfig(const std::set<OptNode*>& g,
                                    OptOrderCfg* cfg) const {
-  const OptEdge* e = 0;
-  SettledEdgs settled;
-
-  while ((e = getNextEdge(g, &settled))) {
-    Cmp left, right;
-
-    // build cmp function for left
-    for (const auto& lo1 : e->pl().getLines()) {
-      for (const auto& lo2 : e->pl().getLines()) {
-        if (lo1.line == lo2.line) continue;
-        left[{lo1.line, lo2.line}] =
-            guess(lo1.line, lo2.line, e, e->getFrom(), *cfg);
-        right[{lo1.line, lo2.line}] =
-            guess(lo1.line, lo2.line, e, e->getTo(), *cfg);
+  for (auto e : getEdgeOrder(g)) {
+    const auto& lines = e->pl().getLines();
+    size_t n = lines.size();
+
+    // guessed pairwise orderings at both ends, indexed by local line ids
+    std::vector<std::pair<bool, double>> left(n * n), right(n * n);
+
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = 0; j < n; j++) {
+        if (i == j) continue;
+        left[i * n + j] =
+            guess(lines[i].line, lines[j].line, e, e->getFrom(), *cfg);
+        right[i * n + j] =
+            guess(lines[i].line, lines[j].line, e, e->getTo(), *cfg);
       }
     }
 
@@ -58,68 +60,83 @@ void GreedyOptimizer::getFlatConfig(const std::set<OptNode*>& g,
     double costRight = 0;
 
     // which one is cheaper?
-    for (const auto& lo1 : e->pl().getLines()) {
-      for (const auto& lo2 : e->pl().getLines()) {
-        if (lo1.line == lo2.line) continue;
-        if (left[{lo1.line, lo2.line}].first ==
-            right[{lo1.line, lo2.line}].first) {
-          costLeft += right[{lo1.line, lo2.line}].second;
-          costRight += left[{lo1.line, lo2.line}].second;
-        }
+    for (size_t i = 0; i < n * n; i++) {
+      if (i / n == i % n) continue;
+      if (left[i].first == right[i].first) {
+        costLeft += right[i].second;
+        costRight += left[i].second;
       }
     }
 
-    // build cmp function for right
-
-    LineCmp cmp({}, false);
-    if (costLeft < costRight) {
-      cmp = LineCmp(left, false);
-    } else {
-      cmp = LineCmp(right, true);
-    }
-
-    // fill lines into empty config
-    for (const auto& lo : e->pl().getLines()) {
-      (*cfg)[e].push_back(lo.line);
-    }
+    bool rev = !(costLeft < costRight);
+    const auto& cmp = rev ? right : left;
 
-    std::sort((*cfg)[e].begin(), (*cfg)[e].end(), cmp);
+    std::vector<size_t> ids(n);
+    std::iota(ids.begin(), ids.end(), 0);
 
-    settled.insert(e);
-  }
-}
+    std::sort(ids.begin(), ids.end(), [&cmp, n, rev](size_t a, size_t b) {
+      return a != b && (cmp[a * n + b].first ^ rev);
+    });
 
-// _____________________________________________________________________________
-const OptEdge* GreedyOptimizer::getNextEdge(const std::set<OptNode*>& g,
-                                            SettledEdgs* settled) const {
-  if (settled->size() == 0) return getInitialEdge(g);
-
-  // else, use some unsettled edge adjacent to the settled set
-  for (auto eid : *settled) {
-    for (auto adj : eid->getFrom()->getAdjList()) {
-      if (!settled->count(adj)) return adj;
-    }
-    for (auto adj : eid->getTo()->getAdjList()) {
-      if (!settled->count(adj)) return adj;
-    }
+    // fill lines into empty config
+    auto& ordering = (*cfg)[e];
+    for (auto i : ids) ordering.push_back(lines[i].line);
   }
-
-  return 0;
 }
 
 // _____________________________________________________________________________
-const OptEdge* GreedyOptimizer::getInitialEdge(
+std::vector<const OptEdge*> GreedyOptimizer::getEdgeOrder(
     const std::set<OptNode*>& g) const {
-  const OptEdge* ret = 0;
+  std::vector<const OptEdge*> edgs;
+  std::unordered_map<const OptEdge*, size_t> edgIdx;
 
   for (auto n : g) {
     for (auto e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
-      if (!ret || e->pl().getCardinality() > ret->pl().getCardinality() ||
-          (e->pl().getCardinality() == ret->pl().getCardinality() &&
-           e->getTo()->getDeg() + e->getFrom()->getDeg() >
-               ret->getTo()->getDeg() + ret->getFrom()->getDeg())) {
-        ret = e;
+      edgIdx[e] = edgs.size();
+      edgs.push_back(e);
+    }
+  }
+
+  // the larger the better, earlier edges win ties
+  auto prio = [&edgs](size_t i) {
+    const OptEdge* e = edgs[i];
+    return std::make_tuple(e->pl().getCardinality(),
+                           e->getFrom()->getDeg() + e->getTo()->getDeg(),
+                           edgs.size() - i);
+  };
+
+  // restart points if the frontier runs empty, only happens if g is not
+  // connected
+  std::vector<size_t> byPrio(edgs.size());
+  std::iota(byPrio.begin(), byPrio.end(), 0);
+  std::sort(byPrio.begin(), byPrio.end(),
+            [&prio](size_t a, size_t b) { return prio(a) > prio(b); });
+
+  std::priority_queue<std::tuple<size_t, size_t, size_t>> frontier;
+  std::vector<bool> queued(edgs.size(), false);
+  size_t nextStart = 0;
+
+  std::vector<const OptEdge*> ret;
+  ret.reserve(edgs.size());
+
+  while (ret.size() < edgs.size()) {
+    if (frontier.empty()) {
+      while (queued[byPrio[nextStart]]) nextStart++;
+      queued[byPrio[nextStart]] = true;
+      frontier.push(prio(byPrio[nextStart]));
+    }
+
+    const OptEdge* e = edgs[edgs.size() - std::get<2>(frontier.top())];
+    frontier.pop();
+    ret.push_back(e);
+
+    for (auto nd : {e->getFrom(), e->getTo()}) {
+      for (auto adj : nd->getAdjList()) {
+        auto it = edgIdx.find(adj);
+        if (it == edgIdx.end() || queued[it->second]) continue;
+        queued[it->second] = true;
+        frontier.push(prio(it->second));
       }
     }
   }
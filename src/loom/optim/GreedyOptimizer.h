@@ -5,7 +5,8 @@
 #ifndef LOOM_OPTIM_GREEDYOPTIMIZER_H_
 #define LOOM_OPTIM_GREEDYOPTIMIZER_H_
 
-#include <map>
+#include <set>
+#include <vector>
 #include "loom/config/LoomConfig.h"
 #include "loom/optim/ExhaustiveOptimizer.h"
 #include "loom/optim/ILPEdgeOrderOptimizer.h"
@@ -18,24 +19,6 @@
 namespace loom {
 namespace optim {
 
-typedef std::set<const OptEdge*> SettledEdgs;
-typedef std::map<
-    std::pair<const shared::linegraph::Line*, const shared::linegraph::Line*>,
-    std::pair<bool, double>>
-    Cmp;
-
-struct LineCmp {
-  LineCmp(const Cmp& cmp, bool rev) : _map(cmp), _rev(rev){};
-
-  bool operator()(const shared::linegraph::Line* a,
-                  const shared::linegraph::Line* b) {
-    return _map.find({a, b})->second.first ^ _rev;
-  }
-
-  Cmp _map;
-  bool _rev;
-};
-
 class GreedyOptimizer : public ExhaustiveOptimizer {
  public:
   GreedyOptimizer(const config::Config* cfg,
@@ -52,9 +35,11 @@ class GreedyOptimizer : public ExhaustiveOptimizer {
  private:
   bool _lookAhead;
 
-  const OptEdge* getNextEdge(const std::set<OptNode*>& g,
-                             SettledEdgs* settled) const;
-  const OptEdge* getInitialEdge(const std::set<OptNode*>& g) const;
+  // the order in which the edges of g are settled: starting with the edge
+  // with the most lines, always the unsettled edge with the most lines
+  // adjacent to an already settled one, ties are broken by the sum of the
+  // node degrees
+  std::vector<const OptEdge*> getEdgeOrder(const std::set<OptNode*>& g) const;
 
   std::pair<bool, double> guess(const shared::linegraph::Line* a,
                                 const shared::linegraph::Line* b,
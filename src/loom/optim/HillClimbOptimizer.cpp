@@ -3,9 +3,11 @@
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
 #include <algorithm>
+#include <random>
 #include <unordered_map>
 #include "loom/optim/GreedyOptimizer.h"
 #include "loom/optim/HillClimbOptimizer.h"
+#include "loom/optim/OptGraphDeltaScorer.h"
 #include "shared/linegraph/Line.h"
 #include "util/log/Log.h"
 
@@ -19,70 +21,94 @@ using shared::rendergraph::HierarOrderCfg;
 double HillClimbOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
                                      HierarOrderCfg* hc, size_t depth,
                                      OptResStats& stats) const {
-  UNUSED(stats);
+  UNUSED(og);
   UNUSED(depth);
   T_START(1);
   OptOrderCfg cur;
+  getFlatConfig(g, &cur, stats.seed);
 
-  // fixed order list of optim graph edges
-  std::vector<OptEdge*> edges;
+  writeHierarch(&cur, hc);
+  return T_STOP(1);
+}
 
-  for (auto n : g)
-    for (auto e : n->getAdjList())
-      if (n == e->getFrom() && e->pl().getCardinality() > 1) edges.push_back(e);
+// _____________________________________________________________________________
+void HillClimbOptimizer::getFlatConfig(const std::set<OptNode*>& g,
+                                       OptOrderCfg* cfg) const {
+  getFlatConfig(g, cfg, std::random_device{}());
+}
 
-  if (_randomStart) {
-    // this is the starting ordering, which is random
-    initialConfig(g, &cur, false);
-  } else {
+// _____________________________________________________________________________
+void HillClimbOptimizer::getFlatConfig(const std::set<OptNode*>& g,
+                                       OptOrderCfg* cfg, uint64_t seed) const {
+  if (!_randomStart) {
     // take the greedy optimized ordering as a starting point
     GreedyOptimizer greedy(_cfg, _scorer.getPens(), true);
-    greedy.getFlatConfig(g, &cur);
+    greedy.getFlatConfig(g, cfg);
+    improve(g, cfg);
+    return;
   }
 
+  // independent random starts, keep the best local optimum
+  size_t starts = std::max<size_t>(_cfg->multiStart, 1);
+  std::vector<OptOrderCfg> cfgs(starts);
+  std::vector<double> scores(starts);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(_cfg->threads)
+  for (size_t i = 0; i < starts; i++) {
+    // this is the starting ordering, which is random
+    std::mt19937 rng(seedFor(seed, i));
+    initialConfig(g, &cfgs[i], &rng);
+
+    OptGraphDeltaScorer delta(_optScorer, g, DenseOrderCfg(g, cfgs[i]));
+    hillClimb(&delta);
+    delta.getCfg().writeOptOrderCfg(&cfgs[i]);
+    scores[i] = delta.getScore();
+  }
+
+  size_t best =
+      std::min_element(scores.begin(), scores.end()) - scores.begin();
+  for (const auto& o : cfgs[best]) (*cfg)[o.first] = o.second;
+}
+
+// _____________________________________________________________________________
+void HillClimbOptimizer::improve(const std::set<OptNode*>& g,
+                                 OptOrderCfg* cfg) const {
+  OptGraphDeltaScorer delta(_optScorer, g, DenseOrderCfg(g, *cfg));
+  hillClimb(&delta);
+  delta.getCfg().writeOptOrderCfg(cfg);
+}
+
+// _____________________________________________________________________________
+void HillClimbOptimizer::hillClimb(OptGraphDeltaScorer* delta) const {
+  const auto& dense = delta->getCfg();
+
+  // fixed order list of optim graph edges
+  std::vector<size_t> edges;
+
+  for (size_t e = 0; e < dense.numEdgs(); e++)
+    if (dense.size(e) > 1) edges.push_back(e);
+
   while (true) {
     double bestChange = 0;
-    OptEdge* bestEdge = 0;
-    std::vector<const Line*> bestOrder;
-
-    for (size_t i = 0; i < edges.size(); i++) {
-      double oldScore = getScore(og, edges[i], cur);
-
-      for (size_t p1 = 0; p1 < cur[edges[i]].size(); p1++) {
-        for (size_t p2 = p1; p2 < cur[edges[i]].size(); p2++) {
-          // switch p1 and p2
-          auto tmp = cur[edges[i]][p1];
-          cur[edges[i]][p1] = cur[edges[i]][p2];
-          cur[edges[i]][p2] = tmp;
-
-          double s = getScore(og, edges[i], cur);
-          if (s < oldScore && oldScore - s > bestChange) {
-            bestChange = oldScore - s;
-            bestEdge = edges[i];
-            bestOrder = cur[edges[i]];
-          }
+    size_t bestEdge = 0, bestP1 = 0, bestP2 = 0;
 
-          // switch back
-          tmp = cur[edges[i]][p1];
-          cur[edges[i]][p1] = cur[edges[i]][p2];
-          cur[edges[i]][p2] = tmp;
+    for (auto e : edges) {
+      for (size_t p1 = 0; p1 < dense.size(e); p1++) {
+        for (size_t p2 = p1 + 1; p2 < dense.size(e); p2++) {
+          // score change if p1 and p2 are switched
+          double d = delta->scoreDelta(e, p1, p2);
+          if (d < 0 && -d > bestChange) {
+            bestChange = -d;
+            bestEdge = e;
+            bestP1 = p1;
+            bestP2 = p2;
+          }
         }
       }
     }
 
-    if (bestEdge == 0) break;
+    if (bestChange == 0) break;
 
-    cur[bestEdge] = bestOrder;
+    delta->swap(bestEdge, bestP1, bestP2);
   }
-
-  writeHierarch(&cur, hc);
-  return T_STOP(1);
-}
-
-// _____________________________________________________________________________
-double HillClimbOptimizer::getScore(OptGraph* og, OptEdge* e,
-                                    OptOrderCfg& cur) const {
-  UNUSED(og);
-  if (_optScorer.optimizeSep()) return _optScorer.getTotalScore(e, cur);
-  return _optScorer.getCrossingScore(e, cur);
 }
@@ -10,6 +10,7 @@
 #include "loom/optim/ILPEdgeOrderOptimizer.h"
 #include "loom/optim/NullOptimizer.h"
 #include "loom/optim/OptGraph.h"
+#include "loom/optim/OptGraphDeltaScorer.h"
 #include "loom/optim/Optimizer.h"
 #include "shared/rendergraph/OrderCfg.h"
 
@@ -27,8 +28,25 @@ class HillClimbOptimizer : public ExhaustiveOptimizer {
                            shared::rendergraph::HierarOrderCfg* c, size_t depth,
                            OptResStats& stats) const;
 
+  // the hill climbing optimized ordering of component g. With random starts,
+  // the best of _cfg->multiStart independent climbs, run in parallel.
+  void getFlatConfig(const std::set<OptNode*>& g, OptOrderCfg* cfg) const;
+
+  // same as above, random starts are drawn from seed
+  void getFlatConfig(const std::set<OptNode*>& g, OptOrderCfg* cfg,
+                     uint64_t seed) const;
+
+  // improve the given ordering of component g by hill climbing
+  void improve(const std::set<OptNode*>& g, OptOrderCfg* cfg) const;
+
+  virtual std::string getName() const {
+    return _randomStart ? "hillc-random" : "hillc";
+  }
+
  protected:
-  double getScore(OptGraph* og, OptEdge* e, OptOrderCfg& cur) const;
+  // improve the configuration of delta by best-improvement line swaps until
+  // no swap improves the score
+  void hillClimb(OptGraphDeltaScorer* delta) const;
 
   bool _randomStart;
 };
@@ -2,7 +2,12 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
+#include <cassert>
 #include <fstream>
+#include <map>
+#include <sstream>
+#include "loom/optim/HillClimbOptimizer.h"
 #include "loom/optim/ILPEdgeOrderOptimizer.h"
 #include "loom/optim/OptGraph.h"
 #include "shared/optim/ILPSolvProv.h"
@@ -12,38 +17,231 @@
 
 using namespace loom;
 using namespace optim;
+using shared::linegraph::Line;
+using shared::optim::IdxStarterSol;
+using shared::optim::ILPModel;
 using shared::optim::ILPSolver;
 using shared::rendergraph::HierarOrderCfg;
 
+namespace {
+// _____________________________________________________________________________
+size_t lineIdx(const OptEdge* e, const Line* l) {
+  const auto& lines = e->pl().getLines();
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (lines[i].line == l) return i;
+  }
+  assert(false);
+  return 0;
+}
+
+// _____________________________________________________________________________
+size_t pairIdx(size_t a, size_t b, size_t card) {
+  if (a > b) std::swap(a, b);
+  return a * card - a * (a + 1) / 2 + (b - a - 1);
+}
+
+// _____________________________________________________________________________
+std::pair<const Line*, const Line*> linePairAt(const OptEdge* e, size_t k,
+                                               bool unique) {
+  // same order as Optimizer::getLinePairs()
+  const auto& lines = e->pl().getLines();
+  size_t i = unique ? k : k / 2;
+  for (size_t a = 0; a < lines.size(); a++) {
+    if (i < lines.size() - a - 1) {
+      const Line* la = lines[a].line;
+      const Line* lb = lines[a + 1 + i].line;
+      bool swap = unique ? lb < la : k % 2;
+      return swap ? std::make_pair(lb, la) : std::make_pair(la, lb);
+    }
+    i -= lines.size() - a - 1;
+  }
+  assert(false);
+  return {0, 0};
+}
+
+// _____________________________________________________________________________
+std::string posVarName(const OptEdge* e, const Line* l, size_t p) {
+  std::stringstream varName;
+  varName << "x_(" << e->pl().getStrRepr() << ",l=" << l << ",p<=" << p << ")";
+  return varName.str();
+}
+
+// _____________________________________________________________________________
+std::string smallerVarName(const OptEdge* e, const Line* a, const Line* b) {
+  std::stringstream ss;
+  ss << "x_(" << e->pl().getStrRepr() << "," << a << "<" << b << ")";
+  return ss.str();
+}
+
+// _____________________________________________________________________________
+std::string nearVarName(const OptEdge* e, const Line* a, const Line* b) {
+  std::stringstream ss;
+  ss << "x_(" << e->pl().getStrRepr() << "," << a << "<T>" << b << ")";
+  return ss.str();
+}
+}  // namespace
+
+// _____________________________________________________________________________
+int ILPEdgeOrderOptimizer::EdgeCols::smallerVar(size_t a, size_t b) const {
+  return smaller + 2 * pairIdx(a, b, card) + (a > b);
+}
+
+// _____________________________________________________________________________
+int ILPEdgeOrderOptimizer::EdgeCols::nearVar(size_t a, size_t b) const {
+  assert(near > -1);
+  return near + pairIdx(a, b, card);
+}
+
+// _____________________________________________________________________________
+ILPEdgeOrderOptimizer::EdgeColIdx ILPEdgeOrderOptimizer::getEdgeCols(
+    const std::set<OptNode*>& g) const {
+  // first the position variables of all edges, then the line pair variables
+  // of all edges, see createProblem() and writeCrossingOracle()
+  EdgeColIdx ret;
+  int cur = 0;
+
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      size_t c = e->pl().getCardinality();
+      ret[e] = {cur, -1, -1, c};
+      cur += c * c;
+    }
+  }
+
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      auto& ec = ret[e];
+      ec.smaller = cur;
+      cur += ec.card * (ec.card - 1);
+      if (separationOpt() && ec.card > 2) {
+        ec.near = cur;
+        cur += ec.card * (ec.card - 1) / 2;
+      }
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<ILPEdgeOrderOptimizer::SymClass>
+ILPEdgeOrderOptimizer::getSymClasses(const std::set<OptNode*>& g) const {
+  std::vector<const OptEdge*> edgs;
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() == n) edgs.push_back(e);
+    }
+  }
+
+  // signature of each line: the edges it occurs on with the number of its
+  // relatives there, followed by the edge pairs it continues over
+  std::map<const Line*, std::vector<size_t>> sigs;
+  std::vector<const Line*> lines;
+
+  for (size_t i = 0; i < edgs.size(); i++) {
+    for (const auto& lo : edgs[i]->pl().getLines()) {
+      auto& sig = sigs[lo.line];
+      if (sig.empty()) lines.push_back(lo.line);
+      sig.push_back(i);
+      sig.push_back(lo.relatives().size());
+    }
+  }
+
+  size_t k = 0;
+  for (OptNode* n : g) {
+    const auto& adj = n->getAdjList();
+    size_t a = 0;
+    for (OptEdge* segA : adj) {
+      for (const auto& lo : segA->pl().getLines()) {
+        auto* lnEdg = OptGraph::getAdjEdg(segA, n);
+        auto* dir = lnEdg->pl().lineOcc(lo.line).direction;
+        auto& sig = sigs[lo.line];
+        size_t b = 0;
+        for (OptEdge* segB : adj) {
+          if (segB != segA &&
+              OptGraph::hasCtdLineIn(lo.line, dir, segA, segB)) {
+            // offset the node marker so it cannot be confused with an edge
+            sig.push_back(edgs.size() + k);
+            sig.push_back(a);
+            sig.push_back(b);
+          }
+          b++;
+        }
+      }
+      a++;
+    }
+    k++;
+  }
+
+  std::map<std::vector<size_t>, std::vector<const Line*>> groups;
+  for (const Line* l : lines) groups[sigs[l]].push_back(l);
+
+  std::vector<SymClass> ret;
+  for (auto& grp : groups) {
+    if (grp.second.size() < 2) continue;
+    // all lines of a class occur on the same edges
+    const OptEdge* ref = edgs[grp.first.front()];
+    std::sort(grp.second.begin(), grp.second.end(),
+              [ref](const Line* a, const Line* b) {
+                return lineIdx(ref, a) < lineIdx(ref, b);
+              });
+    ret.push_back({ref, grp.second});
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void ILPEdgeOrderOptimizer::writeSymmetryBreaking(
+    const std::vector<SymClass>& syms, const EdgeColIdx& idx,
+    ILPModel* m) const {
+  // every ordering stays reachable: relabeling the lines of a class in all
+  // edges by their order on the reference edge gives the same score
+  for (const auto& sym : syms) {
+    const auto& ec = idx.at(sym.ref);
+    int row = m->addRows(sym.lines.size() - 1, 0, shared::optim::FIX);
+    m->setRowNames(row, sym.lines.size() - 1, [=](size_t i) {
+      std::stringstream rowName;
+      rowName << "sym(" << sym.ref->pl().getStrRepr() << ","
+              << sym.lines[i] << "<" << sym.lines[i + 1] << ")";
+      return rowName.str();
+    });
+
+    for (size_t i = 0; i + 1 < sym.lines.size(); i++) {
+      // x_(e,A<B) is 1 if A is behind B
+      m->addColToRow(row + i,
+                     ec.smallerVar(lineIdx(sym.ref, sym.lines[i]),
+                                   lineIdx(sym.ref, sym.lines[i + 1])),
+                     1);
+    }
+  }
+}
+
 // _____________________________________________________________________________
 void ILPEdgeOrderOptimizer::getConfigurationFromSolution(
     ILPSolver* lp, HierarOrderCfg* hc, const std::set<OptNode*>& g) const {
+  auto idx = getEdgeCols(g);
+
   for (OptNode* n : g) {
     for (OptEdge* e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
+      const auto& ec = idx.at(e);
 
       for (auto lnEdgPart : e->pl().lnEdgParts) {
         if (lnEdgPart.wasCut) continue;
         for (size_t tp = 0; tp < e->pl().getCardinality(); tp++) {
           bool found = false;
 
-          for (auto ro : e->pl().getLines()) {
+          for (size_t r = 0; r < e->pl().getLines().size(); r++) {
+            const auto& ro = e->pl().getLines()[r];
             // check if this route (r) switches from 0 to 1 at tp-1 and tp
             double valPrev = 0;
-            std::stringstream varName;
 
-            if (tp > 0) {
-              varName << "x_(" << e->pl().getStrRepr() << ",l=" << ro.line
-                      << ",p<=" << tp - 1 << ")";
+            if (tp > 0) valPrev = lp->getVarVal(ec.posVar(r, tp - 1));
 
-              valPrev = lp->getVarVal(varName.str());
-            }
-
-            varName.str("");
-            varName << "x_(" << e->pl().getStrRepr() << ",l=" << ro.line
-                    << ",p<=" << tp << ")";
-
-            double val = lp->getVarVal(varName.str());
+            double val = lp->getVarVal(ec.posVar(r, tp));
 
             if (valPrev < 0.5 && val > 0.5) {
               // first time p is eq/greater, so it is this p
@@ -51,7 +249,7 @@ void ILPEdgeOrderOptimizer::getConfigurationFromSolution(
               // put this into a method in the pl()! (there, the [0] lnEdgeP is
               // already taken as a ref). THIS IS A POTENTIAL BUG HERE
 
-              for (auto rel : ro.relatives) {
+              for (auto rel : ro.relatives()) {
                 // retrieve the original route pos
                 size_t p = lnEdgPart.lnEdg->pl().linePos(rel);
 
@@ -75,147 +273,367 @@ void ILPEdgeOrderOptimizer::getConfigurationFromSolution(
   }
 }
 
+// _____________________________________________________________________________
+void ILPEdgeOrderOptimizer::setStarter(ILPSolver* lp,
+                                       const std::set<OptNode*>& g,
+                                       const OptOrderCfg& cfg) const {
+  // the position and line pair variables follow directly from the ordering,
+  // the crossing variables are left to the solver
+  auto idx = getEdgeCols(g);
+  IdxStarterSol sol;
+
+  // relabel the lines of each symmetry class to respect the order fixed by
+  // writeSymmetryBreaking()
+  std::map<const Line*, const Line*> relabel;
+  for (const auto& sym : getSymClasses(g)) {
+    size_t i = 0;
+    for (const Line* l : cfg.at(sym.ref)) {
+      if (std::find(sym.lines.begin(), sym.lines.end(), l) == sym.lines.end())
+        continue;
+      relabel[l] = sym.lines[i++];
+    }
+  }
+
+  std::vector<size_t> pos;
+
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      const auto& ec = idx.at(e);
+      const auto& order = cfg.at(e);
+
+      pos.resize(ec.card);
+      for (size_t p = 0; p < ec.card; p++) {
+        auto rl = relabel.find(order[p]);
+        const Line* l = rl == relabel.end() ? order[p] : rl->second;
+        pos[lineIdx(e, l)] = p;
+      }
+
+      for (size_t l = 0; l < ec.card; l++) {
+        for (size_t p = 0; p < ec.card; p++) {
+          sol.push_back({ec.posVar(l, p), pos[l] <= p});
+        }
+      }
+
+      for (size_t a = 0; a < ec.card; a++) {
+        for (size_t b = 0; b < ec.card; b++) {
+          if (a == b) continue;
+          // x_(e,A<B) is forced to 1 if A is behind B
+          sol.push_back({ec.smallerVar(a, b), pos[a] > pos[b]});
+          if (ec.near > -1 && a < b) {
+            size_t d = pos[a] > pos[b] ? pos[a] - pos[b] : pos[b] - pos[a];
+            sol.push_back({ec.nearVar(a, b), d > 1});
+          }
+        }
+      }
+    }
+  }
+
+  lp->setStarter(sol);
+}
+
+// _____________________________________________________________________________
+double ILPEdgeOrderOptimizer::optimizeComp(OptGraph* og,
+                                           const std::set<OptNode*>& g,
+                                           HierarOrderCfg* hc, size_t depth,
+                                           OptResStats& stats) const {
+  // small search spaces are handled by ILPOptimizer::optimizeComp()
+  if (!_cfg->ilpLazy || solutionSpaceSize(g) < 500) {
+    return ILPOptimizer::optimizeComp(og, g, hc, depth, stats);
+  }
+
+  return optimizeCompLazy(g, hc, stats);
+}
+
+// _____________________________________________________________________________
+double ILPEdgeOrderOptimizer::optimizeCompLazy(const std::set<OptNode*>& g,
+                                               HierarOrderCfg* hc,
+                                               OptResStats& stats) const {
+  // without any node constraints, the objective is 0 for every ordering. If
+  // the solution of a relaxed problem has no crossings or separations at the
+  // nodes left out, it is optimal for the complete problem
+  std::set<OptNode*> active;
+  OptOrderCfg cur;
+  double solveT = 0;
+
+  if (_cfg->ilpWarmStart) {
+    HillClimbOptimizer hillc(_cfg, _scorer.getPens(), false);
+    hillc.getFlatConfig(g, &cur);
+  }
+
+  for (size_t round = 0;; round++) {
+    T_START(build);
+    auto lp = createProblem(g, active);
+    double buildT = T_STOP(build);
+
+    if (lp->getNumVars() > static_cast<int>(stats.maxNumColsPerComp))
+      stats.maxNumColsPerComp = lp->getNumVars();
+    if (lp->getNumConstrs() > static_cast<int>(stats.maxNumRowsPerComp))
+      stats.maxNumRowsPerComp = lp->getNumConstrs();
+
+    if (cur.size()) setStarter(lp, g, cur);
+    setSolverParams(lp, stats);
+
+    T_START(solve);
+    auto status = lp->solve();
+    solveT += T_STOP(solve);
+
+    if (status == shared::optim::SolveType::INF) {
+      LOG(WARN) << "No solution found for ILP problem (most likely because of "
+                   "a time limit)!";
+      delete lp;
+      break;
+    }
+
+    cur.clear();
+    getOptOrderCfg(lp, g, &cur);
+
+    size_t added = 0;
+    for (OptNode* n : g) {
+      if (active.count(n)) continue;
+      if (_scorer.getCrossingScore(n, cur) > 0 ||
+          (separationOpt() && _scorer.getSeparationScore(n, cur) > 0)) {
+        active.insert(n);
+        added++;
+      }
+    }
+
+    LOGTO(DEBUG, std::cerr) << "(stats) lazy ILP round " << round
+                            << ": obj = " << lp->getObjVal() << ", "
+                            << lp->getNumConstrs() << " rows, build time "
+                            << buildT << " ms, " << added
+                            << " nodes added";
+
+    // a timed out solve is not refined further
+    if (!added || status != shared::optim::SolveType::OPTIM ||
+        (stats.hasDeadline && timeLeft(stats) <= 0)) {
+      getConfigurationFromSolution(lp, hc, g);
+      delete lp;
+      break;
+    }
+
+    delete lp;
+  }
+
+  LOGTO(DEBUG, std::cerr) << "(stats) ILP solve time = " << solveT << " ms, "
+                          << active.size() << " of " << g.size()
+                          << " nodes constrained";
+
+  return solveT;
+}
+
+// _____________________________________________________________________________
+void ILPEdgeOrderOptimizer::getOptOrderCfg(ILPSolver* lp,
+                                           const std::set<OptNode*>& g,
+                                           OptOrderCfg* cfg) const {
+  auto idx = getEdgeCols(g);
+
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      const auto& ec = idx.at(e);
+      auto& order = (*cfg)[e];
+      order.resize(ec.card);
+
+      for (size_t l = 0; l < ec.card; l++) {
+        // x_(e,l,p<=) switches to 1 at the position of l
+        size_t p = 0;
+        while (p + 1 < ec.card && lp->getVarVal(ec.posVar(l, p)) < 0.5) p++;
+        order[p] = e->pl().getLines()[l].line;
+      }
+    }
+  }
+}
+
 // _____________________________________________________________________________
 ILPSolver* ILPEdgeOrderOptimizer::createProblem(
     OptGraph* og, const std::set<OptNode*>& g) const {
   UNUSED(og);
+  return createProblem(g, g);
+}
+
+// _____________________________________________________________________________
+ILPSolver* ILPEdgeOrderOptimizer::createProblem(
+    const std::set<OptNode*>& g, const std::set<OptNode*>& active) const {
   ILPSolver* lp = shared::optim::getSolver(_cfg->ilpSolver, shared::optim::MIN);
 
-  std::set<OptEdge*> processed;
+  // names are only needed if the problem is written to a file
+  ILPModel m(_cfg->MPSOutputPath.size() > 0);
+  auto idx = getEdgeCols(g);
 
   for (OptNode* n : g) {
     for (OptEdge* e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
+      const auto& ec = idx.at(e);
+      size_t card = ec.card;
+
       // constraint: the sum of all x_sl<=p over the set of lines
       // must be p+1
-
-      size_t rowA = lp->getNumConstrs();
-      for (size_t p = 0; p < e->pl().getCardinality(); p++) {
+      int rowA = m.getNumRows();
+      for (size_t p = 0; p < card; p++) m.addRow(p + 1, shared::optim::FIX);
+      m.setRowNames(rowA, card, [e](size_t p) {
         std::stringstream rowName;
         rowName << "sum(" << e->pl().getStrRepr() << ",<=" << p << ")";
-        lp->addRow(rowName.str(), p + 1, shared::optim::FIX);
-      }
+        return rowName.str();
+      });
+
+      int first = m.addCols(card * card, shared::optim::BIN, 0);
+      assert(first == ec.pos);
+      UNUSED(first);
+      m.setColNames(ec.pos, card * card, [e, card](size_t i) {
+        return posVarName(e, e->pl().getLines()[i / card].line, i % card);
+      });
+
+      for (size_t r = 0; r < card; r++) {
+        const Line* line = e->pl().getLines()[r].line;
+        int rowB = m.addRows(card - 1, 0, shared::optim::LO);
+        m.setRowNames(rowB, card - 1, [e, line](size_t i) {
+          std::stringstream rowName;
+          rowName << "sum(" << e->pl().getStrRepr() << ",r=" << line
+                  << ",p<=" << i + 1 << ")";
+          return rowName.str();
+        });
 
-      for (auto r : e->pl().getLines()) {
-        for (size_t p = 0; p < e->pl().getCardinality(); p++) {
-          std::stringstream varName;
-          varName << "x_(" << e->pl().getStrRepr() << ",l=" << r.line
-                  << ",p<=" << p << ")";
-          int curCol = lp->addCol(varName.str(), shared::optim::BIN, 0);
+        for (size_t p = 0; p < card; p++) {
+          int curCol = ec.posVar(r, p);
 
           // coefficients for constraint from above
-          lp->addColToRow(rowA + p, curCol, 1);
+          m.addColToRow(rowA + p, curCol, 1);
 
           if (p > 0) {
-            std::stringstream rowName;
-            rowName << "sum(" << e->pl().getStrRepr() << ",r=" << r.line
-                    << ",p<=" << p << ")";
-
-            int row = lp->addRow(rowName.str(), 0, shared::optim::LO);
-
-            lp->addColToRow(row, curCol, 1);
-            lp->addColToRow(row, curCol - 1, -1);
+            m.addColToRow(rowB + p - 1, curCol, 1);
+            m.addColToRow(rowB + p - 1, curCol - 1, -1);
           }
         }
       }
     }
   }
 
-  lp->update();
+  writeCrossingOracle(g, active, idx, &m);
+  writeDiffSegConstraintsImpr(active, idx, &m);
 
-  writeCrossingOracle(g, lp);
-  writeDiffSegConstraintsImpr(g, lp);
+  auto syms = getSymClasses(g);
+  writeSymmetryBreaking(syms, idx, &m);
+  LOGTO(DEBUG, std::cerr) << "(stats) " << syms.size()
+                          << " symmetric line classes";
+
+  lp->loadModel(m);
+  lp->update();
 
   return lp;
 }
 
 // _____________________________________________________________________________
-void ILPEdgeOrderOptimizer::writeCrossingOracle(const std::set<OptNode*>& g,
-                                                ILPSolver* lp) const {
+void ILPEdgeOrderOptimizer::writeNodeParts(
+    const std::set<OptNode*>& g, ILPModel* m,
+    const std::function<void(OptNode*, ILPModel*)>& f) const {
+  std::vector<OptNode*> nds(g.begin(), g.end());
+
+  // all parts may reference the columns already in m
+  std::vector<ILPModel> parts;
+  parts.reserve(nds.size());
+  for (size_t i = 0; i < nds.size(); i++) {
+    parts.emplace_back(m->keepsNames(), m->getNumCols());
+  }
+
+#pragma omp parallel for schedule(dynamic, 16) num_threads(_cfg->threads) \
+    if (nds.size() > 64)
+  for (size_t i = 0; i < nds.size(); i++) f(nds[i], &parts[i]);
+
+  // append in node order, the model does not depend on the number of threads
+  size_t cols = 0, rows = 0, coefs = 0;
+  for (const auto& part : parts) {
+    cols += part.getNumCols();
+    rows += part.getNumRows();
+    coefs += part.getNumCoefs();
+  }
+  m->reserve(m->getNumCols() + cols, m->getNumRows() + rows,
+             m->getNumCoefs() + coefs);
+
+  for (const auto& part : parts) m->append(part);
+}
+
+// _____________________________________________________________________________
+void ILPEdgeOrderOptimizer::writeCrossingOracle(
+    const std::set<OptNode*>& g, const std::set<OptNode*>& active,
+    const EdgeColIdx& idx, ILPModel* m) const {
   // do everything iteratively, otherwise it would be unreadable
 
-  size_t m = 0;
+  size_t maxC = 0;
 
   // introduce crossing constraint variables
   for (OptNode* node : g) {
     for (OptEdge* segment : node->getAdjList()) {
       if (segment->getFrom() != node) continue;
-      if (segment->pl().getCardinality() > m) {
-        m = segment->pl().getCardinality();
-      }
+      const auto& ec = idx.at(segment);
+      size_t c = ec.card;
+      if (c > maxC) maxC = c;
+
+      int first = m->addCols(c * (c - 1), shared::optim::BIN, 0);
+      assert(first == ec.smaller);
+      UNUSED(first);
+      m->setColNames(ec.smaller, c * (c - 1), [segment](size_t k) {
+        auto pr = linePairAt(segment, k, false);
+        return smallerVarName(segment, pr.first, pr.second);
+      });
 
-      size_t rowDistanceRangeKeeper = 0;
-      size_t c = segment->pl().getCardinality();
       // constraint is only needed for segments with more than 2 lines
       if (separationOpt() && c > 2) {
-        std::stringstream rowName;
-        rowName << "sum_distancorRangeKeeper(e=" << segment->pl().getStrRepr()
-                << ")";
-
-        size_t max = getLinePairs(segment).size() - (2 * c - 2);
+        size_t max = c * (c - 1) - (2 * c - 2);
         assert(max % 2 == 0);
         max = max / 2;
 
-        rowDistanceRangeKeeper =
-            lp->addRow(rowName.str(), max, shared::optim::UP);
-      }
-
-      // iterate over all possible line pairs in this segment
-      for (LinePair linepair : getLinePairs(segment)) {
-        // variable to check if position of line A (first) is < than
-        // position of line B (second) in segment
-        std::stringstream ss;
-        ss << "x_(" << segment->pl().getStrRepr() << "," << linepair.first.line
-           << "<" << linepair.second.line << ")";
-
-        lp->addCol(ss.str(), shared::optim::BIN, 0);
-      }
-
-      // iterate over all possible line pairs in this segment
-      for (LinePair linepair : getLinePairs(segment, true)) {
-        if (separationOpt() && c > 2) {
-          std::stringstream ss;
-          // variable to check if distance between position of A and position
-          // of B is > 1
-          ss << "x_(" << segment->pl().getStrRepr() << ","
-             << linepair.first.line << "<T>" << linepair.second.line << ")";
-
-          size_t dist1Var = lp->addCol(ss.str(), shared::optim::BIN, 0);
-          lp->addColToRow(rowDistanceRangeKeeper, dist1Var, 1);
+        int rowDistanceRangeKeeper = m->addRow(max, shared::optim::UP);
+        m->setRowNames(rowDistanceRangeKeeper, 1, [segment](size_t) {
+          std::stringstream rowName;
+          rowName << "sum_distancorRangeKeeper(e="
+                  << segment->pl().getStrRepr() << ")";
+          return rowName.str();
+        });
+
+        // variable to check if distance between position of A and position
+        // of B is > 1
+        first = m->addCols(c * (c - 1) / 2, shared::optim::BIN, 0);
+        assert(first == ec.near);
+        m->setColNames(ec.near, c * (c - 1) / 2, [segment](size_t k) {
+          auto pr = linePairAt(segment, k, true);
+          return nearVarName(segment, pr.first, pr.second);
+        });
+
+        for (size_t k = 0; k < c * (c - 1) / 2; k++) {
+          m->addColToRow(rowDistanceRangeKeeper, ec.near + k, 1);
         }
       }
     }
   }
 
-  lp->update();
-
   // write constraints for the A>B variable, both can never be 1...
   for (OptNode* node : g) {
     for (OptEdge* segment : node->getAdjList()) {
       if (segment->getFrom() != node) continue;
-      // iterate over all possible line pairs in this segment
-      for (LinePair linepair : getLinePairs(segment)) {
-        std::stringstream ss;
-        ss << "x_(" << segment->pl().getStrRepr() << "," << linepair.first.line
-           << "<" << linepair.second.line << ")";
-
-        int smaller = lp->getVarByName(ss.str());
-        assert(smaller > -1);
-
-        std::stringstream ss2;
-        ss2 << "x_(" << segment->pl().getStrRepr() << ","
-            << linepair.second.line << "<" << linepair.first.line << ")";
-
-        int bigger = lp->getVarByName(ss2.str());
-        assert(bigger > -1);
+      const auto& ec = idx.at(segment);
+      size_t c = ec.card;
 
+      int rowA = m->addRows(c * (c - 1), 1, shared::optim::FIX);
+      m->setRowNames(rowA, c * (c - 1), [segment](size_t k) {
+        auto pr = linePairAt(segment, k, false);
         std::stringstream rowName;
-        rowName << "sum(" << ss.str() << "," << ss2.str() << ")";
-
-        int row = lp->addRow(rowName.str(), 1, shared::optim::FIX);
-
-        lp->addColToRow(row, smaller, 1);
-        lp->addColToRow(row, bigger, 1);
+        rowName << "sum(" << smallerVarName(segment, pr.first, pr.second)
+                << "," << smallerVarName(segment, pr.second, pr.first) << ")";
+        return rowName.str();
+      });
+
+      // same order as getLinePairs(segment)
+      size_t k = 0;
+      for (size_t a = 0; a < c; a++) {
+        for (size_t b = a + 1; b < c; b++) {
+          m->addColToRow(rowA + k, ec.smallerVar(a, b), 1);
+          m->addColToRow(rowA + k, ec.smallerVar(b, a), 1);
+          k++;
+          m->addColToRow(rowA + k, ec.smallerVar(b, a), 1);
+          m->addColToRow(rowA + k, ec.smallerVar(a, b), 1);
+          k++;
+        }
       }
     }
   }
@@ -224,39 +642,29 @@ void ILPEdgeOrderOptimizer::writeCrossingOracle(const std::set<OptNode*>& g,
   for (OptNode* node : g) {
     for (OptEdge* segment : node->getAdjList()) {
       if (segment->getFrom() != node) continue;
-      for (LinePair linepair : getLinePairs(segment)) {
+      const auto& ec = idx.at(segment);
+      size_t c = ec.card;
+
+      int rowA = m->addRows(c * (c - 1), 0, shared::optim::LO);
+      m->setRowNames(rowA, c * (c - 1), [segment](size_t k) {
+        auto pr = linePairAt(segment, k, false);
         std::stringstream rowName;
         rowName << "sum_crossor(e=" << segment->pl().getStrRepr()
-                << ",A=" << linepair.first.line << ",B=" << linepair.second.line
-                << ")";
-        int rowSmallerThan = lp->addRow(rowName.str(), 0, shared::optim::LO);
-
-        std::stringstream ss;
-        ss << "x_(" << segment->pl().getStrRepr() << "," << linepair.first.line
-           << "<" << linepair.second.line << ")";
-
-        int decVar = lp->getVarByName(ss.str());
-        assert(decVar > -1);
+                << ",A=" << pr.first << ",B=" << pr.second << ")";
+        return rowName.str();
+      });
 
-        lp->addColToRow(rowSmallerThan, decVar, m);
-
-        for (size_t p = 0; p < segment->pl().getCardinality(); ++p) {
-          std::stringstream ss;
-          ss << "x_(" << segment->pl().getStrRepr()
-             << ",l=" << linepair.first.line << ",p<=" << p << ")";
-
-          int first = lp->getVarByName(ss.str());
-          assert(first > -1);
-
-          std::stringstream ss2;
-          ss2 << "x_(" << segment->pl().getStrRepr()
-              << ",l=" << linepair.second.line << ",p<=" << p << ")";
+      size_t k = 0;
+      for (LinePair linepair : getLinePairs(segment)) {
+        int rowSmallerThan = rowA + k++;
+        size_t a = lineIdx(segment, linepair.first.line);
+        size_t b = lineIdx(segment, linepair.second.line);
 
-          int second = lp->getVarByName(ss2.str());
-          assert(second > -1);
+        m->addColToRow(rowSmallerThan, ec.smallerVar(a, b), maxC);
 
-          lp->addColToRow(rowSmallerThan, first, 1);
-          lp->addColToRow(rowSmallerThan, second, -1);
+        for (size_t p = 0; p < c; ++p) {
+          m->addColToRow(rowSmallerThan, ec.posVar(a, p), 1);
+          m->addColToRow(rowSmallerThan, ec.posVar(b, p), -1);
         }
       }
     }
@@ -266,236 +674,196 @@ void ILPEdgeOrderOptimizer::writeCrossingOracle(const std::set<OptNode*>& g,
   for (OptNode* node : g) {
     for (OptEdge* segment : node->getAdjList()) {
       if (segment->getFrom() != node) continue;
-      for (LinePair linepair : getLinePairs(segment, true)) {
-        std::stringstream rowName;
-
-        int rowDistance1 = 0;
-        int rowDistance2 = 0;
-        if (separationOpt() && segment->pl().getCardinality() > 2) {
-          rowName.str("");
-          rowName << "sum_distancor1(e=" << segment->pl().getStrRepr()
-                  << ",A=" << linepair.first.line
-                  << ",B=" << linepair.second.line << ")";
+      const auto& ec = idx.at(segment);
+      size_t c = ec.card;
+      if (!separationOpt() || c <= 2) continue;
 
-          rowDistance1 = lp->addRow(rowName.str(), 1, shared::optim::UP);
-
-          rowName.str("");
-          rowName << "sum_distancor2(e=" << segment->pl().getStrRepr()
-                  << ",A=" << linepair.first.line
-                  << ",B=" << linepair.second.line << ")";
-
-          rowDistance2 = lp->addRow(rowName.str(), 1, shared::optim::UP);
-
-          std::stringstream sss;
-          sss << "x_(" << segment->pl().getStrRepr() << ","
-              << linepair.first.line << "<T>" << linepair.second.line << ")";
-
-          int decVarDistance = lp->getVarByName(sss.str());
-          assert(decVarDistance > -1);
-
-          lp->addColToRow(rowDistance1, decVarDistance, -static_cast<int>(m));
-          lp->addColToRow(rowDistance2, decVarDistance, -static_cast<int>(m));
+      int rowA = m->addRows(c * (c - 1), 1, shared::optim::UP);
+      m->setRowNames(rowA, c * (c - 1), [segment](size_t k) {
+        auto pr = linePairAt(segment, k / 2, true);
+        std::stringstream rowName;
+        rowName << (k % 2 ? "sum_distancor2(e=" : "sum_distancor1(e=")
+                << segment->pl().getStrRepr() << ",A=" << pr.first
+                << ",B=" << pr.second << ")";
+        return rowName.str();
+      });
 
-          for (size_t p = 0; p < segment->pl().getCardinality(); ++p) {
-            std::stringstream ss;
-            ss << "x_(" << segment->pl().getStrRepr()
-               << ",l=" << linepair.first.line << ",p<=" << p << ")";
+      size_t k = 0;
+      for (LinePair linepair : getLinePairs(segment, true)) {
+        int rowDistance1 = rowA + k++;
+        int rowDistance2 = rowA + k++;
+        size_t a = lineIdx(segment, linepair.first.line);
+        size_t b = lineIdx(segment, linepair.second.line);
 
-            int first = lp->getVarByName(ss.str());
-            assert(first > -1);
+        int decVarDistance = ec.nearVar(a, b);
 
-            std::stringstream ss2;
-            ss2 << "x_(" << segment->pl().getStrRepr()
-                << ",l=" << linepair.second.line << ",p<=" << p << ")";
+        m->addColToRow(rowDistance1, decVarDistance, -static_cast<int>(maxC));
+        m->addColToRow(rowDistance2, decVarDistance, -static_cast<int>(maxC));
 
-            int second = lp->getVarByName(ss2.str());
-            assert(second > -1);
+        for (size_t p = 0; p < c; ++p) {
+          int first = ec.posVar(a, p);
+          int second = ec.posVar(b, p);
 
-            lp->addColToRow(rowDistance1, first, 1);
-            lp->addColToRow(rowDistance1, second, -1);
+          m->addColToRow(rowDistance1, first, 1);
+          m->addColToRow(rowDistance1, second, -1);
 
-            lp->addColToRow(rowDistance2, first, -1);
-            lp->addColToRow(rowDistance2, second, 1);
-          }
+          m->addColToRow(rowDistance2, first, -1);
+          m->addColToRow(rowDistance2, second, 1);
         }
       }
     }
   }
 
-  // crossing constraints
-  for (OptNode* node : g) {
-    std::set<OptEdge*> processed;
-    for (OptEdge* segmentA : node->getAdjList()) {
-      processed.insert(segmentA);
-
-      // iterate over all possible line pairs in this segment
-      for (LinePair linepair : getLinePairs(segmentA, true)) {
-        // iterate over all edges this
-        // pair traverses to _TOGETHER_
-        // (its possible that there are multiple edges if a line continues
-        //  in more then 1 segment)
-        for (OptEdge* segmentB : getEdgePartners(node, segmentA, linepair)) {
-          if (processed.find(segmentB) != processed.end()) continue;
-
-          // introduce dec var
+  // crossing constraints, independent for each node
+  writeNodeParts(active, m, [this, &idx](OptNode* node, ILPModel* part) {
+    writeCrossingOracle(node, idx, part);
+  });
+}
+
+// _____________________________________________________________________________
+void ILPEdgeOrderOptimizer::writeCrossingOracle(OptNode* node,
+                                                const EdgeColIdx& idx,
+                                                ILPModel* m) const {
+  std::set<OptEdge*> processed;
+  for (OptEdge* segmentA : node->getAdjList()) {
+    processed.insert(segmentA);
+    const auto& ecA = idx.at(segmentA);
+
+    // iterate over all possible line pairs in this segment
+    for (LinePair linepair : getLinePairs(segmentA, true)) {
+      const Line* lineA = linepair.first.line;
+      const Line* lineB = linepair.second.line;
+      size_t aInA = lineIdx(segmentA, lineA);
+      size_t bInA = lineIdx(segmentA, lineB);
+
+      // iterate over all edges this
+      // pair traverses to _TOGETHER_
+      // (its possible that there are multiple edges if a line continues
+      //  in more then 1 segment)
+      for (OptEdge* segmentB : getEdgePartners(node, segmentA, linepair)) {
+        if (processed.find(segmentB) != processed.end()) continue;
+        const auto& ecB = idx.at(segmentB);
+        size_t aInB = lineIdx(segmentB, lineA);
+        size_t bInB = lineIdx(segmentB, lineB);
+
+        // introduce dec var
+        int decisionVar = m->addCol(
+            shared::optim::BIN,
+            getCrossingPenaltySameSeg(node)
+                // multiply the penalty with the number of collapsed lines!
+                * (linepair.first.relatives().size()) *
+                (linepair.second.relatives().size()));
+        m->setColNames(decisionVar, 1, [=](size_t) {
           std::stringstream ss;
           ss << "x_dec(" << segmentA->pl().getStrRepr() << ","
              << segmentA->pl().getStrRepr() << segmentB->pl().getStrRepr()
-             << "," << linepair.first.line << "(" << linepair.first.line->id()
-             << ")," << linepair.second.line << "("
-             << linepair.second.line->id() << ")," << node << ")";
-
-          int decisionVar = lp->addCol(
-              ss.str(), shared::optim::BIN,
-              getCrossingPenaltySameSeg(node)
-                  // multiply the penalty with the number of collapsed lines!
-                  * (linepair.first.relatives.size()) *
-                  (linepair.second.relatives.size()));
-
-          int aSmallerBinL1 = 0;
-          int aSmallerBinL2 = 0;
-          int bSmallerAinL2 = 0;
-
-          std::stringstream aSmBStr;
-          aSmBStr << "x_(" << segmentA->pl().getStrRepr() << ","
-                  << linepair.first.line << "<" << linepair.second.line << ")";
-          aSmallerBinL1 = lp->getVarByName(aSmBStr.str());
-
-          assert(aSmallerBinL1 > -1);
-
-          std::stringstream aBgBStr;
-          aBgBStr << "x_(" << segmentB->pl().getStrRepr() << ","
-                  << linepair.first.line << "<" << linepair.second.line << ")";
-          aSmallerBinL2 = lp->getVarByName(aBgBStr.str());
-
-          assert(aSmallerBinL2 > -1);
-
-          std::stringstream bBgAStr;
-          bBgAStr << "x_(" << segmentB->pl().getStrRepr() << ","
-                  << linepair.second.line << "<" << linepair.first.line << ")";
-          bSmallerAinL2 = lp->getVarByName(bBgAStr.str());
-
-          assert(bSmallerAinL2 > -1);
-
+             << "," << lineA << "(" << lineA->id() << ")," << lineB << "("
+             << lineB->id() << ")," << node << ")";
+          return ss.str();
+        });
+
+        int aSmallerBinL1 = ecA.smallerVar(aInA, bInA);
+        int aSmallerBinL2 = ecB.smallerVar(aInB, bInB);
+        int bSmallerAinL2 = ecB.smallerVar(bInB, aInB);
+
+        int row = m->addRow(0, shared::optim::LO);
+        int row2 = m->addRow(0, shared::optim::LO);
+        m->setRowNames(row, 2, [=](size_t k) {
           std::stringstream rowName;
-          rowName << "sum_dec(e1=" << segmentA->pl().getStrRepr()
-                  << ",e2=" << segmentB->pl().getStrRepr()
-                  << ",A=" << linepair.first.line
-                  << ",B=" << linepair.second.line << ",n=" << node << ")";
-
-          int row = lp->addRow(rowName.str(), 0, shared::optim::LO);
-
-          std::stringstream rowName2;
-          rowName2 << "sum_dec2(e1=" << segmentA->pl().getStrRepr()
-                   << ",e2=" << segmentB->pl().getStrRepr()
-                   << ",A=" << linepair.first.line
-                   << ",B=" << linepair.second.line << ",n=" << node << ")";
-
-          int row2 = lp->addRow(rowName2.str(), 0, shared::optim::LO);
-
-          bool otherWayA = (segmentA->getFrom() != node) ^
-                           segmentA->pl().lnEdgParts.front().dir;
-          bool otherWayB = (segmentB->getFrom() != node) ^
-                           segmentB->pl().lnEdgParts.front().dir;
-
-          if (otherWayA ^ otherWayB) {
-          } else {
-            aSmallerBinL2 = bSmallerAinL2;
-          }
+          rowName << (k ? "sum_dec2(e1=" : "sum_dec(e1=")
+                  << segmentA->pl().getStrRepr()
+                  << ",e2=" << segmentB->pl().getStrRepr() << ",A=" << lineA
+                  << ",B=" << lineB << ",n=" << node << ")";
+          return rowName.str();
+        });
+
+        bool otherWayA = (segmentA->getFrom() != node) ^
+                         segmentA->pl().lnEdgParts.front().dir;
+        bool otherWayB = (segmentB->getFrom() != node) ^
+                         segmentB->pl().lnEdgParts.front().dir;
+
+        if (otherWayA ^ otherWayB) {
+        } else {
+          aSmallerBinL2 = bSmallerAinL2;
+        }
 
-          lp->addColToRow(row, aSmallerBinL1, -1);
-          lp->addColToRow(row, aSmallerBinL2, 1);
-          lp->addColToRow(row, decisionVar, 1);
+        m->addColToRow(row, aSmallerBinL1, -1);
+        m->addColToRow(row, aSmallerBinL2, 1);
+        m->addColToRow(row, decisionVar, 1);
 
-          lp->addColToRow(row2, aSmallerBinL1, 1);
-          lp->addColToRow(row2, aSmallerBinL2, -1);
-          lp->addColToRow(row2, decisionVar, 1);
-        }
+        m->addColToRow(row2, aSmallerBinL1, 1);
+        m->addColToRow(row2, aSmallerBinL2, -1);
+        m->addColToRow(row2, decisionVar, 1);
       }
+    }
 
-      // iterate over all unique possible line pairs in this segment
-      for (LinePair linepair : getLinePairs(segmentA, true)) {
-        // iterate over all edges this
-        // pair traverses to _TOGETHER_
-        // (its possible that there are multiple edges if a line continues
-        //  in more then 1 segment)
-        for (OptEdge* segmentB : getEdgePartners(node, segmentA, linepair)) {
-          if (processed.find(segmentB) != processed.end()) continue;
-
-          // introduce dec var for distance 1 between lines changes
-          if (separationOpt()) {
-            if (segmentA->pl().getCardinality() > 2 &&
-                segmentB->pl().getCardinality() > 2) {
-              // the interesting case where the line continue together from
-              // segment A to segment B and the cardinality of both A and B
-              // is > 2 (that is, it is possible in A or B that the two lines
-              // won't be together)
+    // iterate over all unique possible line pairs in this segment
+    for (LinePair linepair : getLinePairs(segmentA, true)) {
+      const Line* lineA = linepair.first.line;
+      const Line* lineB = linepair.second.line;
+
+      // iterate over all edges this
+      // pair traverses to _TOGETHER_
+      // (its possible that there are multiple edges if a line continues
+      //  in more then 1 segment)
+      for (OptEdge* segmentB : getEdgePartners(node, segmentA, linepair)) {
+        if (processed.find(segmentB) != processed.end()) continue;
+
+        // introduce dec var for distance 1 between lines changes
+        if (separationOpt()) {
+          if (segmentA->pl().getCardinality() > 2 &&
+              segmentB->pl().getCardinality() > 2) {
+            // the interesting case where the line continue together from
+            // segment A to segment B and the cardinality of both A and B
+            // is > 2 (that is, it is possible in A or B that the two lines
+            // won't be together)
+            int decisionVarDist1Change =
+                m->addCol(shared::optim::BIN, getSeparationPenalty(node));
+            m->setColNames(decisionVarDist1Change, 1, [=](size_t) {
               std::stringstream sss;
               sss << "x_decT(" << segmentA->pl().getStrRepr() << ","
-                  << segmentA->pl().getStrRepr() << segmentB->pl().getStrRepr()
-                  << "," << linepair.first.line << "("
-                  << linepair.first.line->id() << ")," << linepair.second.line
-                  << "(" << linepair.second.line->id() << ")," << node << ")";
-
-              int decisionVarDist1Change = lp->addCol(
-                  sss.str(), shared::optim::BIN, getSeparationPenalty(node));
-
-              int aNearBinL1 = 0;
-              int aNearBinL2 = 0;
-
-              std::stringstream aNearBL1Str;
-              aNearBL1Str << "x_(" << segmentA->pl().getStrRepr() << ","
-                          << linepair.first.line << "<T>"
-                          << linepair.second.line << ")";
-              aNearBinL1 = lp->getVarByName(aNearBL1Str.str());
-              assert(aNearBinL1 > -1);
-
-              std::stringstream aNearBL2Str;
-              aNearBL2Str << "x_(" << segmentB->pl().getStrRepr() << ","
-                          << linepair.first.line << "<T>"
-                          << linepair.second.line << ")";
-              aNearBinL2 = lp->getVarByName(aNearBL2Str.str());
-              assert(aNearBinL2 > -1);
-
+                  << segmentA->pl().getStrRepr()
+                  << segmentB->pl().getStrRepr() << "," << lineA << "("
+                  << lineA->id() << ")," << lineB << "(" << lineB->id()
+                  << ")," << node << ")";
+              return sss.str();
+            });
+
+            int aNearBinL1 = ecA.nearVar(lineIdx(segmentA, lineA),
+                                         lineIdx(segmentA, lineB));
+            int aNearBinL2 = idx.at(segmentB).nearVar(
+                lineIdx(segmentB, lineA), lineIdx(segmentB, lineB));
+
+            int rowT = m->addRow(0, shared::optim::LO);
+            int rowT2 = m->addRow(0, shared::optim::LO);
+            m->setRowNames(rowT, 2, [=](size_t k) {
               std::stringstream rowTName;
-              rowTName << "sum_decT(e1=" << segmentA->pl().getStrRepr()
+              rowTName << (k ? "sum_decT2(e1=" : "sum_decT(e1=")
+                       << segmentA->pl().getStrRepr()
                        << ",e2=" << segmentB->pl().getStrRepr()
-                       << ",A=" << linepair.first.line
-                       << ",B=" << linepair.second.line << ",n=" << node << ")";
-
-              int rowT = lp->addRow(rowTName.str(), 0, shared::optim::LO);
-
-              std::stringstream rowTName2;
-              rowTName2 << "sum_decT2(e1=" << segmentA->pl().getStrRepr()
-                        << ",e2=" << segmentB->pl().getStrRepr()
-                        << ",A=" << linepair.first.line
-                        << ",B=" << linepair.second.line << ",n=" << node
-                        << ")";
-
-              int rowT2 = lp->addRow(rowTName2.str(), 0, shared::optim::LO);
-
-              lp->addColToRow(rowT, aNearBinL1, -1);
-              lp->addColToRow(rowT, aNearBinL2, 1);
-              lp->addColToRow(rowT, decisionVarDist1Change, 1);
-
-              lp->addColToRow(rowT2, aNearBinL1, 1);
-              lp->addColToRow(rowT2, aNearBinL2, -1);
-              lp->addColToRow(rowT2, decisionVarDist1Change, 1);
-            } else if ((segmentA->pl().getCardinality() == 2) ^
-                       (segmentB->pl().getCardinality() == 2)) {
-              // the trivial case where one of the two segments only has
-              // cardinality = 2, so the lines will always be together
-
-              OptEdge* segment =
-                  segmentA->pl().getCardinality() != 2 ? segmentA : segmentB;
-
-              std::stringstream aNearBStr;
-              aNearBStr << "x_(" << segment->pl().getStrRepr() << ","
-                        << linepair.first.line << "<T>" << linepair.second.line
-                        << ")";
-
-              lp->setObjCoef(aNearBStr.str(), getSeparationPenalty(node));
-            }
+                       << ",A=" << lineA << ",B=" << lineB << ",n=" << node
+                       << ")";
+              return rowTName.str();
+            });
+
+            m->addColToRow(rowT, aNearBinL1, -1);
+            m->addColToRow(rowT, aNearBinL2, 1);
+            m->addColToRow(rowT, decisionVarDist1Change, 1);
+
+            m->addColToRow(rowT2, aNearBinL1, 1);
+            m->addColToRow(rowT2, aNearBinL2, -1);
+            m->addColToRow(rowT2, decisionVarDist1Change, 1);
+          } else if ((segmentA->pl().getCardinality() == 2) ^
+                     (segmentB->pl().getCardinality() == 2)) {
+            // the trivial case where one of the two segments only has
+            // cardinality = 2, so the lines will always be together
+
+            OptEdge* segment =
+                segmentA->pl().getCardinality() != 2 ? segmentA : segmentB;
+
+            m->setObjCoef(idx.at(segment).nearVar(lineIdx(segment, lineA),
+                                                  lineIdx(segment, lineB)),
+                          getSeparationPenalty(node));
           }
         }
       }
@@ -505,68 +873,77 @@ void ILPEdgeOrderOptimizer::writeCrossingOracle(const std::set<OptNode*>& g,
 
 // _____________________________________________________________________________
 void ILPEdgeOrderOptimizer::writeDiffSegConstraintsImpr(
-    const std::set<OptNode*>& g, ILPSolver* lp) const {
+    const std::set<OptNode*>& active, const EdgeColIdx& idx,
+    ILPModel* m) const {
   // go into nodes and build crossing constraints for adjacent
-  for (OptNode* node : g) {
-    std::set<OptEdge*> processed;
-    for (OptEdge* segmentA : node->getAdjList()) {
-      processed.insert(segmentA);
-      // iterate over all possible line pairs in this segment
-      for (LinePair linepair : getLinePairs(segmentA, true)) {
-        for (EdgePair segments :
-             getEdgePartnerPairs(node, segmentA, linepair)) {
-          // try all position combinations
-
-          // introduce dec var
+  writeNodeParts(active, m, [this, &idx](OptNode* node, ILPModel* part) {
+    writeDiffSegConstraintsImpr(node, idx, part);
+  });
+}
+
+// _____________________________________________________________________________
+void ILPEdgeOrderOptimizer::writeDiffSegConstraintsImpr(OptNode* node,
+                                                        const EdgeColIdx& idx,
+                                                        ILPModel* m) const {
+  std::set<OptEdge*> processed;
+  for (OptEdge* segmentA : node->getAdjList()) {
+    processed.insert(segmentA);
+    const auto& ecA = idx.at(segmentA);
+
+    // iterate over all possible line pairs in this segment
+    for (LinePair linepair : getLinePairs(segmentA, true)) {
+      const Line* lineA = linepair.first.line;
+      const Line* lineB = linepair.second.line;
+      size_t aInA = lineIdx(segmentA, lineA);
+      size_t bInA = lineIdx(segmentA, lineB);
+
+      for (EdgePair segments :
+           getEdgePartnerPairs(node, segmentA, linepair)) {
+        // try all position combinations
+
+        // introduce dec var
+        int decisionVar = m->addCol(
+            shared::optim::BIN,
+            getCrossingPenaltyDiffSeg(node)
+                // multiply the penalty with the number of collapsed lines!
+                * (linepair.first.relatives().size()) *
+                (linepair.second.relatives().size()));
+        m->setColNames(decisionVar, 1, [=](size_t) {
           std::stringstream ss;
           ss << "x_dec(" << segmentA->pl().getStrRepr() << ","
              << segments.first->pl().getStrRepr()
-             << segments.second->pl().getStrRepr() << "," << linepair.first.line
-             << "(" << linepair.first.line->id() << ")," << linepair.second.line
-             << "(" << linepair.second.line->id() << ")," << node << ")";
-
-          int decisionVar = lp->addCol(
-              ss.str(), shared::optim::BIN,
-              getCrossingPenaltyDiffSeg(node)
-                  // multiply the penalty with the number of collapsed lines!
-                  * (linepair.first.relatives.size()) *
-                  (linepair.second.relatives.size()));
-
-          for (PosCom poscomb : getPositionCombinations(segmentA)) {
-            if (crosses(node, segmentA, segments, poscomb)) {
-              int testVar = 0;
-
-              if (poscomb.first > poscomb.second) {
-                std::stringstream bBgAStr;
-                bBgAStr << "x_(" << segmentA->pl().getStrRepr() << ","
-                        << linepair.first.line << "<" << linepair.second.line
-                        << ")";
-                testVar = lp->getVarByName(bBgAStr.str());
-              } else {
-                std::stringstream bBgAStr;
-                bBgAStr << "x_(" << segmentA->pl().getStrRepr() << ","
-                        << linepair.second.line << "<" << linepair.first.line
-                        << ")";
-                testVar = lp->getVarByName(bBgAStr.str());
-              }
+             << segments.second->pl().getStrRepr() << "," << lineA << "("
+             << lineA->id() << ")," << lineB << "(" << lineB->id() << "),"
+             << node << ")";
+          return ss.str();
+        });
+
+        for (PosCom poscomb : getPositionCombinations(segmentA)) {
+          if (crosses(node, segmentA, segments, poscomb)) {
+            int testVar = 0;
+
+            if (poscomb.first > poscomb.second) {
+              testVar = ecA.smallerVar(aInA, bInA);
+            } else {
+              testVar = ecA.smallerVar(bInA, aInA);
+            }
 
-              assert(testVar);
+            int row = m->addRow(0, shared::optim::FIX);
+            m->setRowNames(row, 1, [=](size_t) {
               std::stringstream ss;
               ss << "dec_sum(" << segmentA->pl().getStrRepr() << ","
                  << segments.first->pl().getStrRepr()
-                 << segments.second->pl().getStrRepr() << ","
-                 << linepair.first.line << "," << linepair.second.line
-                 << "pa=" << poscomb.first << ",pb=" << poscomb.second
-                 << ",n=" << node << ")";
-
-              int row = lp->addRow(ss.str(), 0, shared::optim::FIX);
+                 << segments.second->pl().getStrRepr() << "," << lineA << ","
+                 << lineB << "pa=" << poscomb.first
+                 << ",pb=" << poscomb.second << ",n=" << node << ")";
+              return ss.str();
+            });
 
-              lp->addColToRow(row, testVar, 1);
-              lp->addColToRow(row, decisionVar, -1);
+            m->addColToRow(row, testVar, 1);
+            m->addColToRow(row, decisionVar, -1);
 
-              // one cross is enough...
-              break;
-            }
+            // one cross is enough...
+            break;
           }
         }
       }
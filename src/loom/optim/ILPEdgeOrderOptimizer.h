@@ -5,10 +5,13 @@
 #ifndef LOOM_OPTIM_ILPEDGEORDEROPTIMIZER_H_
 #define LOOM_OPTIM_ILPEDGEORDEROPTIMIZER_H_
 
+#include <functional>
+#include <unordered_map>
 #include "loom/config/LoomConfig.h"
 #include "loom/optim/ILPOptimizer.h"
 #include "loom/optim/OptGraph.h"
 #include "loom/optim/Optimizer.h"
+#include "shared/optim/ILPModel.h"
 #include "shared/rendergraph/OrderCfg.h"
 
 namespace loom {
@@ -24,21 +27,98 @@ class ILPEdgeOrderOptimizer : public ILPOptimizer {
                         const shared::rendergraph::Penalties& pens)
       : ILPOptimizer(cfg, pens){};
 
+  virtual double optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
+                              shared::rendergraph::HierarOrderCfg* c,
+                              size_t depth, OptResStats& stats) const;
+
   virtual std::string getName() const { return "ilp_impr";}
 
  private:
+  // column ids of the position and line pair variables of an edge. The
+  // columns are numbered in a fixed layout (see getEdgeCols()), so they can
+  // be addressed without names while building the model and when reading
+  // the solution.
+  struct EdgeCols {
+    // x_(e,l,p<=), card * card columns
+    int pos;
+    // x_(e,A<B) for all ordered line pairs
+    int smaller;
+    // x_(e,A<T>B) for all unordered line pairs, or -1
+    int near;
+    size_t card;
+
+    // arguments are local line ids (indices into OptEdgePL::getLines())
+    int posVar(size_t l, size_t p) const { return pos + l * card + p; }
+    int smallerVar(size_t a, size_t b) const;
+    int nearVar(size_t a, size_t b) const;
+  };
+
+  typedef std::unordered_map<const OptEdge*, EdgeCols> EdgeColIdx;
+
+  // lines which are interchangeable in the model of a component: they occur
+  // on the same edges with the same number of relatives and continue over
+  // the same edge pairs. Lines are in the order of ref->pl().getLines().
+  struct SymClass {
+    const OptEdge* ref;
+    std::vector<const shared::linegraph::Line*> lines;
+  };
+
   virtual shared::optim::ILPSolver* createProblem(
       OptGraph* og, const std::set<OptNode*>& g) const;
 
+  // the problem with the crossing and separation constraints of the nodes
+  // in active only
+  shared::optim::ILPSolver* createProblem(
+      const std::set<OptNode*>& g, const std::set<OptNode*>& active) const;
+
+  // solve g with lazily added node constraints, see Config::ilpLazy
+  double optimizeCompLazy(const std::set<OptNode*>& g,
+                          shared::rendergraph::HierarOrderCfg* c,
+                          OptResStats& stats) const;
+
+  // the line orderings of a solution
+  void getOptOrderCfg(shared::optim::ILPSolver* lp,
+                      const std::set<OptNode*>& g, OptOrderCfg* cfg) const;
+
   virtual void getConfigurationFromSolution(
       shared::optim::ILPSolver* lp, shared::rendergraph::HierarOrderCfg* c,
       const std::set<OptNode*>& g) const;
 
+  virtual void setStarter(shared::optim::ILPSolver* lp,
+                          const std::set<OptNode*>& g,
+                          const OptOrderCfg& cfg) const;
+
+  EdgeColIdx getEdgeCols(const std::set<OptNode*>& g) const;
+
+  std::vector<SymClass> getSymClasses(const std::set<OptNode*>& g) const;
+
+  // fix the order of each symmetry class on its reference edge, this keeps
+  // (a relabeling of) every ordering
+  void writeSymmetryBreaking(const std::vector<SymClass>& syms,
+                             const EdgeColIdx& idx,
+                             shared::optim::ILPModel* m) const;
+
+  // the node constraints are only written for the nodes in active
   void writeCrossingOracle(const std::set<OptNode*>& g,
-                           shared::optim::ILPSolver* lp) const;
+                           const std::set<OptNode*>& active,
+                           const EdgeColIdx& idx,
+                           shared::optim::ILPModel* m) const;
+
+  void writeDiffSegConstraintsImpr(const std::set<OptNode*>& active,
+                                   const EdgeColIdx& idx,
+                                   shared::optim::ILPModel* m) const;
+
+  // the constraints of a single node, which only reference the edge columns
+  void writeCrossingOracle(OptNode* node, const EdgeColIdx& idx,
+                           shared::optim::ILPModel* m) const;
+  void writeDiffSegConstraintsImpr(OptNode* node, const EdgeColIdx& idx,
+                                   shared::optim::ILPModel* m) const;
 
-  void writeDiffSegConstraintsImpr(const std::set<OptNode*>& g,
-                                   shared::optim::ILPSolver* lp) const;
+  // call f for each node of g with a part model of m, in parallel, and
+  // append the parts to m in node order
+  void writeNodeParts(
+      const std::set<OptNode*>& g, shared::optim::ILPModel* m,
+      const std::function<void(OptNode*, shared::optim::ILPModel*)>& f) const;
 };
 }  // namespace optim
 }  // namespace loom
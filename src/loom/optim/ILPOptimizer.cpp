@@ -2,10 +2,12 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdio>
 #include <fstream>
 #include <thread>
+#include "loom/optim/HillClimbOptimizer.h"
 #include "loom/optim/ILPOptimizer.h"
 #include "loom/optim/OptGraph.h"
 #include "shared/optim/ILPSolvProv.h"
@@ -19,6 +21,7 @@ using namespace loom;
 using namespace optim;
 using shared::linegraph::Line;
 using shared::optim::ILPSolver;
+using shared::optim::StarterSol;
 using shared::rendergraph::HierarOrderCfg;
 
 // _____________________________________________________________________________
@@ -42,17 +45,35 @@ double ILPOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
   if (lp->getNumConstrs() > static_cast<int>(stats.maxNumRowsPerComp))
     stats.maxNumRowsPerComp = lp->getNumConstrs();
 
+  if (_cfg->ilpWarmStart) {
+    // start from the hill climbing solution, which is usually close to the
+    // optimum, so a time limited solve still yields a good ordering
+    T_START(heur);
+    OptOrderCfg start;
+    HillClimbOptimizer hillc(_cfg, _scorer.getPens(), false);
+    hillc.getFlatConfig(g, &start);
+    setStarter(lp, g, start);
+    LOGTO(DEBUG, std::cerr) << "(stats) ILP starter score = "
+                            << _scorer.getTotalScore(g, start) << ", took "
+                            << T_STOP(heur) << " ms";
+  }
+
   if (_cfg->MPSOutputPath.size()) {
     lp->writeMps(_cfg->MPSOutputPath);
   }
 
-  if (_cfg->ilpTimeLimit >= 0) lp->setTimeLim(_cfg->ilpTimeLimit);
-  if (_cfg->ilpNumThreads != 0) lp->setNumThreads(_cfg->ilpNumThreads);
+  setSolverParams(lp, stats);
 
   LOGTO(DEBUG, std::cerr) << "Solving ILP problem...";
 
   T_START(solve);
 
+  lp->setIncumbentCb([&](double obj, const std::vector<double>& vals) {
+    UNUSED(vals);
+    LOGTO(DEBUG, std::cerr) << "New incumbent with objective " << obj
+                            << " after " << T_STOP(solve) << " ms";
+  });
+
   auto status = lp->solve();
 
   double solveT = T_STOP(solve);
@@ -76,6 +97,36 @@ double ILPOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
   return solveT;
 }
 
+// _____________________________________________________________________________
+void ILPOptimizer::setSolverParams(ILPSolver* lp,
+                                   const OptResStats& stats) const {
+  int timeLim = _cfg->ilpTimeLimit;
+  if (stats.hasDeadline) {
+    // the solver time limit is in full seconds
+    int left = std::max(1, static_cast<int>(timeLeft(stats) / 1000));
+    if (timeLim < 0 || left < timeLim) timeLim = left;
+  }
+
+  if (timeLim >= 0) lp->setTimeLim(timeLim);
+  if (_cfg->ilpNumThreads != 0) lp->setNumThreads(_cfg->ilpNumThreads);
+}
+
+// _____________________________________________________________________________
+size_t ILPOptimizer::ilpBatchSize(const std::set<OptNode*>& g) const {
+  // see optimizeComp()
+  if (solutionSpaceSize(g) < 500) return 0;
+
+  size_t ret = 0;
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      ret += e->pl().getCardinality() * e->pl().getCardinality();
+    }
+  }
+
+  return ret;
+}
+
 // _____________________________________________________________________________
 int ILPOptimizer::getCrossingPenaltySameSeg(const OptNode* n) const {
   return _scorer.getCrossingPenSameSeg(n);
@@ -110,7 +161,7 @@ void ILPOptimizer::getConfigurationFromSolution(
             double val = lp->getVarVal(varName);
 
             if (val > 0.5) {
-              for (auto rel : lo.relatives) {
+              for (auto rel : lo.relatives()) {
                 // retrieve the original route pos
                 size_t p = lnEdgPart.lnEdg->pl().linePos(rel);
 
@@ -133,6 +184,29 @@ void ILPOptimizer::getConfigurationFromSolution(
   }
 }
 
+// _____________________________________________________________________________
+void ILPOptimizer::setStarter(ILPSolver* lp, const std::set<OptNode*>& g,
+                              const OptOrderCfg& cfg) const {
+  // only the position variables are given, the solver has to complete the
+  // crossing and separation variables
+  StarterSol sol;
+
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      const auto& order = cfg.at(e);
+
+      for (auto lo : e->pl().getLines()) {
+        for (size_t p = 0; p < e->pl().getCardinality(); p++) {
+          sol[getILPVarName(e, lo.line, p)] = order[p] == lo.line;
+        }
+      }
+    }
+  }
+
+  lp->setStarter(sol);
+}
+
 // _____________________________________________________________________________
 ILPSolver* ILPOptimizer::createProblem(OptGraph* og,
                                        const std::set<OptNode*>& g) const {
@@ -210,8 +284,8 @@ void ILPOptimizer::writeSameSegConstraints(OptGraph* og,
               ss.str(), shared::optim::BIN,
               getCrossingPenaltySameSeg(node)
                   // multiply the penalty with the number of collapsed lines!
-                  * (linepair.first.relatives.size()) *
-                  (linepair.second.relatives.size()));
+                  * (linepair.first.relatives().size()) *
+                  (linepair.second.relatives().size()));
 
           // introduce dec var for sep
           std::stringstream sss;
@@ -327,8 +401,8 @@ void ILPOptimizer::writeDiffSegConstraints(OptGraph* og,
               ss.str(), shared::optim::BIN,
               getCrossingPenaltyDiffSeg(node)
                   // multiply the penalty with the number of collapsed lines!
-                  * (linepair.first.relatives.size()) *
-                  (linepair.second.relatives.size()));
+                  * (linepair.first.relatives().size()) *
+                  (linepair.second.relatives().size()));
 
           for (PosCom poscomb : getPositionCombinations(segmentA)) {
             if (crosses(node, segmentA, segments, poscomb)) {
@@ -28,6 +28,8 @@ class ILPOptimizer : public Optimizer {
 
   virtual std::string getName() const { return "ilp";}
 
+  virtual size_t ilpBatchSize(const std::set<OptNode*>& g) const;
+
  protected:
   const loom::optim::ExhaustiveOptimizer _exhausOpt;
   virtual shared::optim::ILPSolver* createProblem(
@@ -37,6 +39,15 @@ class ILPOptimizer : public Optimizer {
       shared::optim::ILPSolver* lp, shared::rendergraph::HierarOrderCfg* c,
       const std::set<OptNode*>& g) const;
 
+  // pass ordering cfg of component g to lp as a starter solution
+  virtual void setStarter(shared::optim::ILPSolver* lp,
+                          const std::set<OptNode*>& g,
+                          const OptOrderCfg& cfg) const;
+
+  // set the time limit and the number of threads of lp
+  void setSolverParams(shared::optim::ILPSolver* lp,
+                       const OptResStats& stats) const;
+
   std::string getILPVarName(OptEdge* e, const shared::linegraph::Line* r,
                             size_t p) const;
 
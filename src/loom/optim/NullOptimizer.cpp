@@ -26,7 +26,7 @@ double NullOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
       for (auto lnEdgPart : e->pl().lnEdgParts) {
         if (lnEdgPart.wasCut) continue;
         for (auto ro : e->pl().getLines()) {
-          for (auto rel : ro.relatives) {
+          for (auto rel : ro.relatives()) {
             // retrieve the original line pos
             size_t p = lnEdgPart.lnEdg->pl().linePos(rel);
             if (!(lnEdgPart.dir ^ e->pl().lnEdgParts.front().dir)) {
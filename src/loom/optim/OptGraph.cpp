@@ -2,17 +2,21 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
+#include <map>
+#include <mutex>
 #include <set>
+#include <unordered_map>
 #include "loom/optim/OptGraph.h"
 #include "loom/optim/OptGraphScorer.h"
 #include "shared/linegraph/Line.h"
 #include "shared/linegraph/LineGraph.h"
 #include "shared/rendergraph/RenderGraph.h"
 #include "util/String.h"
-#include "util/graph/Algorithm.h"
 #include "util/log/Log.h"
 
 using loom::optim::LnEdgPart;
+using loom::optim::OptCrossTable;
 using loom::optim::OptEdge;
 using loom::optim::OptEdgePL;
 using loom::optim::OptGraph;
@@ -28,10 +32,25 @@ using shared::linegraph::LineNode;
 using shared::linegraph::LineOcc;
 using shared::rendergraph::RenderGraph;
 using util::Nullable;
-using util::graph::Algorithm;
 
 const static double DO = 100;
 
+// _____________________________________________________________________________
+void OptLO::setRelatives(const std::vector<const Line*>& rels) {
+  if (rels.size() == 1 && rels.front() == line) {
+    _rels = 0;
+    return;
+  }
+
+  // the table is shared by the components optimized in parallel and lives
+  // as long as the process, its entries are only ever added
+  static std::mutex relsMutex;
+  static std::set<std::vector<const Line*>> relsTable;
+
+  std::lock_guard<std::mutex> lock(relsMutex);
+  _rels = &*relsTable.insert(rels).first;
+}
+
 // _____________________________________________________________________________
 void OptGraph::upFirstLastEdg(OptEdge* optEdg) {
   size_t i = 0;
@@ -168,11 +187,11 @@ std::map<const LineNode*, OptNode*> OptGraph::build(RenderGraph* rg) {
 }
 
 // _____________________________________________________________________________
-void OptGraph::terminusDetach() {
+void OptGraph::terminusDetach(const std::set<OptNode*>& nds) {
   std::vector<std::pair<OptEdge*, OptNode*>> toDetach;
 
   // collect edges to cut
-  for (OptNode* n : getNds()) {
+  for (OptNode* n : nds) {
     for (OptEdge* e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
 
@@ -221,11 +240,11 @@ void OptGraph::terminusDetach() {
 }
 
 // _____________________________________________________________________________
-void OptGraph::splitSingleLineEdgs() {
+void OptGraph::splitSingleLineEdgs(const std::set<OptNode*>& nds) {
   std::vector<OptEdge*> toCut;
 
   // collect edges to cut
-  for (OptNode* n : getNds()) {
+  for (OptNode* n : nds) {
     for (OptEdge* e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
 
@@ -280,9 +299,10 @@ void OptGraph::partnerLines() {
       while (it != e->pl().getLines().end()) {
         auto& ro = *it;
         if (ro == *p.partners.begin()) {
-          ro.relatives.clear();
-          for (auto partner : p.partners) ro.relatives.push_back(partner.line);
-          if (p.inv[i]) std::reverse(ro.relatives.begin(), ro.relatives.end());
+          std::vector<const Line*> rels;
+          for (auto partner : p.partners) rels.push_back(partner.line);
+          if (p.inv[i]) std::reverse(rels.begin(), rels.end());
+          ro.setRelatives(rels);
         } else if (p.partners.count(ro)) {
           it = e->pl().getLines().erase(it);
           continue;
@@ -293,6 +313,158 @@ void OptGraph::partnerLines() {
   }
 }
 
+// _____________________________________________________________________________
+size_t OptGraph::bundleLines(double minShare) {
+  // edges of each line and number of shared edges of each pair of lines
+  std::unordered_map<const Line*, std::vector<OptEdge*>> lineEdgs;
+  std::map<std::pair<const Line*, const Line*>, size_t> numShared;
+  std::vector<const Line*> lines;
+
+  for (auto n : getNds()) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      const auto& los = e->pl().getLines();
+      for (size_t i = 0; i < los.size(); i++) {
+        auto& edgs = lineEdgs[los[i].line];
+        if (edgs.empty()) lines.push_back(los[i].line);
+        edgs.push_back(e);
+        for (size_t j = i + 1; j < los.size(); j++) {
+          numShared[{std::min(los[i].line, los[j].line),
+                     std::max(los[i].line, los[j].line)}]++;
+        }
+      }
+    }
+  }
+
+  std::unordered_map<const Line*, std::set<const Line*>> near;
+  for (const auto& p : numShared) {
+    double un = lineEdgs[p.first.first].size() +
+                lineEdgs[p.first.second].size() - p.second;
+    if (p.second / un < minShare) continue;
+    near[p.first.first].insert(p.first.second);
+    near[p.first.second].insert(p.first.first);
+  }
+
+  // greedy grouping, lines with many edges first. A line joins the first
+  // bundle all of whose lines are near to it.
+  std::stable_sort(lines.begin(), lines.end(),
+                   [&lineEdgs](const Line* a, const Line* b) {
+                     return lineEdgs[a].size() > lineEdgs[b].size();
+                   });
+
+  std::vector<std::vector<const Line*>> bundles;
+  std::unordered_map<const Line*, size_t> bundleOf;
+
+  for (auto l : lines) {
+    const auto& nearL = near[l];
+    std::set<size_t> cands;
+    for (auto m : nearL) {
+      auto it = bundleOf.find(m);
+      if (it != bundleOf.end()) cands.insert(it->second);
+    }
+
+    size_t bundle = bundles.size();
+    for (auto b : cands) {
+      if (std::all_of(bundles[b].begin(), bundles[b].end(),
+                      [&nearL](const Line* m) { return nearL.count(m); })) {
+        bundle = b;
+        break;
+      }
+    }
+
+    if (bundle == bundles.size()) bundles.push_back({});
+    bundles[bundle].push_back(l);
+    bundleOf[l] = bundle;
+  }
+
+  size_t ret = 0;
+
+  for (const auto& b : bundles) {
+    if (b.size() < 2) continue;
+
+    // the edges on which all lines of the bundle occur in the same direction
+    std::vector<OptEdge*> edgs;
+    for (auto e : lineEdgs[b.front()]) {
+      auto dir = e->pl().getLineOcc(b.front())->dir;
+      bool all = true;
+      for (auto l : b) {
+        auto lo = e->pl().getLineOcc(l);
+        if (!lo || lo->dir != dir) {
+          all = false;
+          break;
+        }
+      }
+      if (all) edgs.push_back(e);
+    }
+
+    if (edgs.empty()) continue;
+    ret++;
+
+    // like for partner paths, the relatives are ordered in the direction the
+    // bundle travels through an edge. The direction is propagated over the
+    // bundled edges, starting at any of them.
+    std::unordered_map<const OptEdge*, bool> inv;
+    for (size_t i = 0; i < edgs.size(); i++) inv[edgs[i]] = false;
+    std::unordered_map<const OptEdge*, bool> visited;
+
+    for (auto start : edgs) {
+      if (visited[start]) continue;
+      visited[start] = true;
+      std::vector<OptEdge*> stack{start};
+
+      while (!stack.empty()) {
+        auto e = stack.back();
+        stack.pop_back();
+
+        OptNode* exit = inv[e] ? e->getFrom() : e->getTo();
+        OptNode* entry = e->getOtherNd(exit);
+
+        for (auto adj : exit->getAdjList()) {
+          if (adj == e || !inv.count(adj) || visited[adj]) continue;
+          visited[adj] = true;
+          inv[adj] = adj->getTo() == exit;
+          stack.push_back(adj);
+        }
+
+        for (auto adj : entry->getAdjList()) {
+          if (adj == e || !inv.count(adj) || visited[adj]) continue;
+          visited[adj] = true;
+          inv[adj] = adj->getFrom() == entry;
+          stack.push_back(adj);
+        }
+      }
+    }
+
+    for (auto e : edgs) {
+      // the relatives of partner lines are already ordered for this edge,
+      // only the order of the bundled lines depends on the direction
+      std::vector<std::vector<const Line*>> blocks;
+      for (auto l : b) {
+        auto rels = e->pl().getLineOcc(l)->relatives();
+        blocks.push_back({rels.begin(), rels.end()});
+      }
+      if (inv[e]) std::reverse(blocks.begin(), blocks.end());
+
+      std::vector<const Line*> rels;
+      for (const auto& block : blocks)
+        rels.insert(rels.end(), block.begin(), block.end());
+
+      std::vector<OptLO> los;
+      for (auto lo : e->pl().getLines()) {
+        if (lo.line == b.front()) {
+          lo.setRelatives(rels);
+        } else if (std::find(b.begin(), b.end(), lo.line) != b.end()) {
+          continue;
+        }
+        los.push_back(lo);
+      }
+      e->pl().getLines() = los;
+    }
+  }
+
+  return ret;
+}
+
 // _____________________________________________________________________________
 std::set<const Line*> OptGraph::getLines() const {
   std::set<const Line*> lines;
@@ -319,31 +491,62 @@ Nullable<const OptLO> OptGraph::getLO(const OptEdge* a, const Line* r) {
 std::vector<PartnerPath> OptGraph::getPartnerLines() const {
   std::vector<PartnerPath> ret;
 
-  for (auto rt : getLines()) {
-    // create connected components w.r.t. route (each component consists only of
-    // edges containing route rt)
+  // number all line occurrences, the occurrences of an edge are consecutive
+  std::unordered_map<const OptEdge*, size_t> offs;
+  std::vector<const OptEdge*> occEdgs;
+  for (auto n : getNds()) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      offs[e] = occEdgs.size();
+      occEdgs.insert(occEdgs.end(), e->pl().getLines().size(), e);
+    }
+  }
 
-    struct Check : public Algorithm::EdgeCheckFunc<OptNodePL, OptEdgePL> {
-      Check(const Line* l) : rt(l){};
-      const Line* rt;
-      virtual bool operator()(const OptNode* frNd, const OptEdge* edg) const {
-        UNUSED(frNd);
-        // TODO: this will put lines not continueing over a particular edge
-        // in one component, as only the lines' presence on the edge is checked.
-        // Later on, we then cannot follow the edge through the entire path,
-        // which may lead to collapsing opportunities being missed.
-        auto ro = getLO(edg, rt);
-        return !ro.isNull();
-      };
-    };
+  auto occIdx = [&offs](const OptEdge* e, const OptLO* lo) {
+    return offs.find(e)->second + (lo - e->pl().getLines().data());
+  };
 
-    const auto& comps = Algorithm::connectedComponents(*this, Check(rt));
+  std::vector<size_t> parent(occEdgs.size());
+  for (size_t i = 0; i < parent.size(); i++) parent[i] = i;
 
-    for (const auto& comp : comps) {
-      if (comp.size() < 2) continue;
-      auto p = pathFromComp(comp);
-      if (p.partners.size() && p.path.size()) ret.push_back(p);
+  auto find = [&parent](size_t i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
     }
+    return i;
+  };
+
+  // the components of a line consist of the edges it continues between, not
+  // just of adjacent edges it occurs on - otherwise, a line ending in a node
+  // would prevent collapsing it on either side
+  for (auto n : getNds()) {
+    for (auto a : n->getAdjList()) {
+      for (auto b : n->getAdjList()) {
+        if (a == b) continue;
+        for (const auto& lo : getCtdLinesIn(a, b)) {
+          size_t ra = find(occIdx(a, a->pl().getLineOcc(lo.line)));
+          size_t rb = find(occIdx(b, b->pl().getLineOcc(lo.line)));
+          if (ra != rb) parent[ra] = rb;
+        }
+      }
+    }
+  }
+
+  std::map<size_t, std::set<OptNode*>> comps;
+  for (size_t i = 0; i < occEdgs.size(); i++) {
+    auto& comp = comps[find(i)];
+    comp.insert(occEdgs[i]->getFrom());
+    comp.insert(occEdgs[i]->getTo());
+  }
+
+  // lines with the same components yield the same partner paths
+  std::set<std::set<OptNode*>> done;
+
+  for (const auto& comp : comps) {
+    if (!done.insert(comp.second).second) continue;
+    auto p = pathFromComp(comp.second);
+    if (p.partners.size() && p.path.size()) ret.push_back(p);
   }
 
   return ret;
@@ -441,28 +644,105 @@ PartnerPath OptGraph::pathFromComp(const std::set<OptNode*>& comp) const {
 
 // _____________________________________________________________________________
 void OptGraph::contractDeg2Nds() {
-  while (contractDeg2Step()) {
+  std::set<OptNode*> nds = getNds();
+  contractDeg2Nds(&nds);
+}
+
+// _____________________________________________________________________________
+void OptGraph::contractDeg2Nds(std::set<OptNode*>* nds) {
+  while (contractDeg2Step(nds)) {
   }
 }
 
 // _____________________________________________________________________________
 void OptGraph::untangle() {
-  untangleDoubleStump();
+  std::set<OptNode*> nds = getNds();
+  untangle(&nds);
+}
 
-  untangleOuterStump();
+// _____________________________________________________________________________
+void OptGraph::untangle(std::set<OptNode*>* nds) {
+  untangleDoubleStump(*nds);
+
+  untangleOuterStump(*nds);
+  prune(nds);
 
-  while (untangleFullX()) {
+  while (untangleFullX(*nds)) {
   }
 
-  untangleY();
+  untangleY(*nds);
+  prune(nds);
 
-  untanglePartialY();
+  untanglePartialY(*nds);
+  prune(nds);
 
-  untangleDogBone();
+  untangleDogBone(*nds);
+  prune(nds);
 
-  untanglePartialDogBone();
+  untanglePartialDogBone(*nds);
+  prune(nds);
 
-  untangleInnerStump();
+  untangleInnerStump(*nds);
+  prune(nds);
+}
+
+// _____________________________________________________________________________
+void OptGraph::splitSingleLineEdgs() { splitSingleLineEdgs(getNds()); }
+
+// _____________________________________________________________________________
+void OptGraph::terminusDetach() { terminusDetach(getNds()); }
+
+// _____________________________________________________________________________
+size_t OptGraph::simplify(size_t maxRounds) {
+  // in the first round, every node is a candidate
+  _dirty = getNds();
+
+  size_t rounds = 0;
+  while (!_dirty.empty() && rounds < maxRounds) {
+    std::set<OptNode*> nds = popDirtyNbh();
+    rounds++;
+
+    untangle(&nds);
+
+    contractDeg2Nds(&nds);
+
+    splitSingleLineEdgs(nds);
+
+    terminusDetach(nds);
+  }
+
+  _dirty.clear();
+
+  return rounds;
+}
+
+// _____________________________________________________________________________
+std::set<OptNode*> OptGraph::popDirtyNbh() {
+  // the rules look at a node, its adjacent edges, and the adjacent edges of
+  // its neighbors, so a change at n may enable a rule up to 2 hops away
+  std::set<OptNode*> ret;
+  for (auto n : _dirty) {
+    if (!getNds().count(n)) continue;  // deleted in the meantime
+    ret.insert(n);
+    for (auto e : n->getAdjList()) {
+      auto m = e->getOtherNd(n);
+      ret.insert(m);
+      for (auto f : m->getAdjList()) ret.insert(f->getOtherNd(m));
+    }
+  }
+
+  _dirty.clear();
+  return ret;
+}
+
+// _____________________________________________________________________________
+void OptGraph::prune(std::set<OptNode*>* nds) const {
+  for (auto it = nds->begin(); it != nds->end();) {
+    if (!getNds().count(*it))
+      it = nds->erase(it);
+    else
+      it++;
+  }
 }
 
 // _____________________________________________________________________________
@@ -553,8 +833,8 @@ bool OptGraph::contractCheaper(const OptNode* cont, const OptNode* cheaper,
 }
 
 // _____________________________________________________________________________
-bool OptGraph::contractDeg2Step() {
-  for (OptNode* n : getNds()) {
+bool OptGraph::contractDeg2Step(std::set<OptNode*>* nds) {
+  for (OptNode* n : *nds) {
     if (n->getDeg() == 2) {
       OptEdge* first = n->getAdjList().front();
       OptEdge* second = n->getAdjList().back();
@@ -627,6 +907,7 @@ bool OptGraph::contractDeg2Step() {
         assert(newFrom != n);
         assert(newTo != n);
 
+        nds->erase(n);
         delNd(n);
 
         updateEdgeOrder(newFrom);
@@ -707,8 +988,8 @@ util::json::Dict OptEdgePL::getAttrs() {
   std::string lines;
 
   for (const auto& r : getLines()) {
-    if (r.relatives.size() > 1)
-      lines += r.line->label() + "(x" + util::toString(r.relatives.size()) +
+    if (r.relatives().size() > 1)
+      lines += r.line->label() + "(x" + util::toString(r.relatives().size()) +
                ")" + "[" + r.line->color() + ", -> " + util::toString(r.dir) +
                "], ";
     else
@@ -727,8 +1008,8 @@ util::json::Dict OptEdgePL::getAttrs() {
 std::string OptEdgePL::toStr() const {
   std::string lines;
   for (const auto& r : getLines()) {
-    if (r.relatives.size() > 1)
-      lines += r.line->label() + "(x" + util::toString(r.relatives.size()) +
+    if (r.relatives().size() > 1)
+      lines += r.line->label() + "(x" + util::toString(r.relatives().size()) +
                ")" + "[" + r.line->color() + ", -> " + util::toString(r.dir) +
                "], ";
     else
@@ -796,8 +1077,22 @@ std::pair<OptEdge*, OptEdge*> OptGraph::isFullX(OptNode* n) const {
 }
 
 // _____________________________________________________________________________
-bool OptGraph::untangleFullX() {
-  for (OptNode* n : getNds()) {
+bool OptGraph::untangleFullX(const std::set<OptNode*>& nds) {
+  // untangling a cross changes the adjacent nodes, so each match is checked
+  // again before it is untangled
+  std::vector<OptNode*> cands(nds.begin(), nds.end());
+  std::vector<char> match(cands.size(), 0);
+
+#pragma omp parallel for schedule(dynamic, 64) num_threads(_threads) \
+    if (_threads > 1 && cands.size() > 256)
+  for (size_t i = 0; i < cands.size(); i++) {
+    match[i] = isFullX(cands[i]).first != 0;
+  }
+
+  bool ret = false;
+  for (size_t i = 0; i < cands.size(); i++) {
+    if (!match[i]) continue;
+    OptNode* n = cands[i];
     std::pair<OptEdge*, OptEdge*> cross;
     if ((cross = isFullX(n)).first) {
       LOGTO(DEBUG, std::cerr)
@@ -836,10 +1131,59 @@ bool OptGraph::untangleFullX() {
       updateEdgeOrder(sa);
       updateEdgeOrder(sb);
 
-      return true;
+      ret = true;
     }
   }
-  return false;
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<OptEdge*> OptGraph::findEdgs(
+    const std::set<OptNode*>& nds,
+    const std::function<bool(OptEdge*)>& pred) const {
+  std::vector<OptEdge*> cands;
+  for (OptNode* n : nds) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() == n) cands.push_back(e);
+    }
+  }
+
+  std::vector<char> match(cands.size(), 0);
+
+#pragma omp parallel for schedule(dynamic, 64) num_threads(_threads) \
+    if (_threads > 1 && cands.size() > 256)
+  for (size_t i = 0; i < cands.size(); i++) match[i] = pred(cands[i]);
+
+  std::vector<OptEdge*> ret;
+  for (size_t i = 0; i < cands.size(); i++) {
+    if (match[i]) ret.push_back(cands[i]);
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<OptEdge*> OptGraph::findTermEdgs(
+    const std::set<OptNode*>& nds,
+    const std::function<bool(OptEdge*, OptNode*)>& pred) const {
+  std::vector<OptNode*> cands;
+  for (OptNode* n : nds) {
+    if (n->getDeg() == 1) cands.push_back(n);
+  }
+
+  std::vector<char> match(cands.size(), 0);
+
+#pragma omp parallel for schedule(dynamic, 64) num_threads(_threads) \
+    if (_threads > 1 && cands.size() > 256)
+  for (size_t i = 0; i < cands.size(); i++) {
+    OptEdge* e = cands[i]->getAdjList().front();
+    match[i] = pred(e, e->getOtherNd(cands[i]));
+  }
+
+  std::vector<OptEdge*> ret;
+  for (size_t i = 0; i < cands.size(); i++) {
+    if (match[i]) ret.push_back(cands[i]->getAdjList().front());
+  }
+  return ret;
 }
 
 // _____________________________________________________________________________
@@ -856,26 +1200,10 @@ std::vector<OptNode*> OptGraph::explodeNodeAlong(
 }
 
 // _____________________________________________________________________________
-void OptGraph::untanglePartialY() {
-  std::vector<OptEdge*> toUntangle;
-
-  for (OptNode* na : getNds()) {
-    if (na->getDeg() != 1) continue;  // only look at terminus nodes
-
-    // the only outgoing edge
-    OptEdge* ea = na->getAdjList().front();
-    OptNode* nb = ea->getOtherNd(na);
-
-    if (isPartialYAt(ea, nb)) {
-      assert(nb->pl().node);
-      assert(na->pl().node);
-
-      LOGTO(DEBUG, std::cerr)
-          << "Found partial Y at node " << nb << " with main leg " << ea << " ("
-          << ea->pl().toStr() << ")";
-      toUntangle.push_back(ea);
-    }
-  }
+void OptGraph::untanglePartialY(const std::set<OptNode*>& nds) {
+  auto toUntangle = findTermEdgs(nds, [this](OptEdge* ea, OptNode* nb) {
+    return isPartialYAt(ea, nb);
+  });
 
   for (auto ea : toUntangle) {
     // the only outgoing edge
@@ -888,6 +1216,10 @@ void OptGraph::untanglePartialY() {
     assert(nb->pl().node);
     assert(na->pl().node);
 
+    LOGTO(DEBUG, std::cerr) << "Found partial Y at node " << nb
+                            << " with main leg " << ea << " ("
+                            << ea->pl().toStr() << ")";
+
     // the geometry of the main leg
     util::geo::PolyLine<double> pl(*nb->pl().getGeom(), *na->pl().getGeom());
     double bandW = (nb->getDeg() - 1) * (DO / (ea->pl().depth + 1));
@@ -1000,25 +1332,15 @@ std::pair<OptEdge*, bool> OptGraph::isOuterStumpAt(OptEdge* mainLeg,
 }
 
 // _____________________________________________________________________________
-void OptGraph::untangleDoubleStump() {
-  std::vector<OptEdge*> toUntangle;
-
-  for (OptNode* n : getNds()) {
-    for (OptEdge* mainLeg : n->getAdjList()) {
-      if (mainLeg->getFrom() != n) continue;
-
-      const OptLO* stump;
-      if ((stump = isDoubleStump(mainLeg))) {
-        LOGTO(DEBUG, std::cerr)
-            << "Found double stump with main leg " << mainLeg << " ("
-            << mainLeg->pl().toStr() << ") with stump " << stump->line->id();
-        toUntangle.push_back(mainLeg);
-      }
-    }
-  }
+void OptGraph::untangleDoubleStump(const std::set<OptNode*>& nds) {
+  auto toUntangle = findEdgs(
+      nds, [this](OptEdge* mainLeg) { return isDoubleStump(mainLeg) != 0; });
 
   for (auto mainLeg : toUntangle) {
     const OptLO* stump = isDoubleStump(mainLeg);
+    LOGTO(DEBUG, std::cerr)
+        << "Found double stump with main leg " << mainLeg << " ("
+        << mainLeg->pl().toStr() << ") with stump " << stump->line->id();
     OptEdgePL plMain = getPartialViewExcl(mainLeg, stump, 0);
     OptEdgePL plStump =
         getPartialView(mainLeg, stump, plMain.getLines().size());
@@ -1028,30 +1350,20 @@ void OptGraph::untangleDoubleStump() {
     auto stNdA = addNd(mainLeg->getFrom()->pl());
     auto stNdB = addNd(mainLeg->getTo()->pl());
     addEdg(stNdA, stNdB, plStump);
+
+    _dirty.insert(mainLeg->getFrom());
+    _dirty.insert(mainLeg->getTo());
+    _dirty.insert(stNdA);
+    _dirty.insert(stNdB);
   }
 }
 
 // _____________________________________________________________________________
-void OptGraph::untangleOuterStump() {
-  std::set<OptEdge*> toUntangle;
-
-  for (OptNode* n : getNds()) {
-    for (OptEdge* mainLeg : n->getAdjList()) {
-      if (mainLeg->getFrom() != n) continue;
-
-      std::pair<OptEdge*, bool> stumpEdgPair;
-      if ((stumpEdgPair = isOuterStump(mainLeg)).first) {
-        LOGTO(DEBUG, std::cerr)
-            << "Found outer stump with main leg " << mainLeg << " ("
-            << mainLeg->pl().toStr() << ") at node " << stumpEdgPair.second
-            << " with stump " << stumpEdgPair.first << " ("
-            << stumpEdgPair.first->pl().toStr() << ")";
-        assert(mainLeg->getFrom());
-        assert(mainLeg->getTo());
-        toUntangle.insert(mainLeg);
-      }
-    }
-  }
+void OptGraph::untangleOuterStump(const std::set<OptNode*>& nds) {
+  auto found = findEdgs(nds, [this](OptEdge* mainLeg) {
+    return isOuterStump(mainLeg).first != 0;
+  });
+  std::set<OptEdge*> toUntangle(found.begin(), found.end());
 
   for (auto mainLeg : toUntangle) {
     auto stumpEdgPair = isOuterStump(mainLeg);
@@ -1059,6 +1371,11 @@ void OptGraph::untangleOuterStump() {
     // only 2 lines on it in a previous outer stump untangle, this should be
     // explicitely checked above
     if (!stumpEdgPair.first) continue;
+    LOGTO(DEBUG, std::cerr)
+        << "Found outer stump with main leg " << mainLeg << " ("
+        << mainLeg->pl().toStr() << ") at node " << stumpEdgPair.second
+        << " with stump " << stumpEdgPair.first << " ("
+        << stumpEdgPair.first->pl().toStr() << ")";
     OptEdge* stumpEdg = stumpEdgPair.first;
     bool clockw = stumpEdgPair.second;
     OptNode* stumpN = sharedNode(mainLeg, stumpEdg);
@@ -1191,25 +1508,10 @@ void OptGraph::untangleOuterStump() {
 }
 
 // _____________________________________________________________________________
-void OptGraph::untangleY() {
-  std::vector<OptEdge*> toUntangle;
-
-  for (OptNode* na : getNds()) {
-    if (na->getDeg() != 1) continue;  // only look at terminus nodes
-
-    // the only outgoing edge
-    OptEdge* ea = na->getAdjList().front();
-    OptNode* nb = ea->getOtherNd(na);
-
-    if (isYAt(ea, nb)) {
-      assert(nb->pl().node);
-      assert(na->pl().node);
-      LOGTO(DEBUG, std::cerr)
-          << "Found full Y at node " << nb << " with main leg " << ea << " ("
-          << ea->pl().toStr() << ")";
-      toUntangle.push_back(ea);
-    }
-  }
+void OptGraph::untangleY(const std::set<OptNode*>& nds) {
+  auto toUntangle = findTermEdgs(nds, [this](OptEdge* ea, OptNode* nb) {
+    return isYAt(ea, nb);
+  });
 
   for (auto ea : toUntangle) {
     // the only outgoing edge
@@ -1219,6 +1521,10 @@ void OptGraph::untangleY() {
     assert(na->getDeg() == 1);
     OptNode* nb = ea->getOtherNd(na);
 
+    LOGTO(DEBUG, std::cerr) << "Found full Y at node " << nb
+                            << " with main leg " << ea << " ("
+                            << ea->pl().toStr() << ")";
+
     // the geometry of the main leg
     util::geo::PolyLine<double> pl(*nb->pl().getGeom(), *na->pl().getGeom());
     double bandW = (nb->getDeg() - 1) * (DO / (ea->pl().depth + 1));
@@ -1403,27 +1709,17 @@ OptEdgePL OptGraph::getPartialView(OptEdge* parent, OptEdge* leg,
 }
 
 // _____________________________________________________________________________
-void OptGraph::untanglePartialDogBone() {
-  std::vector<OptEdge*> toUntangle;
-
-  for (OptNode* na : getNds()) {
-    if (na->getDeg() < 3) continue;  // only look at nodes with deg > 2
-
-    for (OptEdge* mainLeg : na->getAdjList()) {
-      if (mainLeg->getFrom() != na) continue;
-      OptNode* notPartN = 0;
-      if ((notPartN = isPartialDogBone(mainLeg))) {
-        LOGTO(DEBUG, std::cerr)
-            << "Found partial dog bone with main leg " << mainLeg << " ("
-            << mainLeg->pl().toStr() << ") at node " << notPartN;
-
-        toUntangle.push_back(mainLeg);
-      }
-    }
-  }
+void OptGraph::untanglePartialDogBone(const std::set<OptNode*>& nds) {
+  // only look at nodes with deg > 2
+  auto toUntangle = findEdgs(nds, [this](OptEdge* mainLeg) {
+    return mainLeg->getFrom()->getDeg() > 2 && isPartialDogBone(mainLeg);
+  });
 
   for (auto mainLeg : toUntangle) {
     OptNode* notPartN = isPartialDogBone(mainLeg);
+    LOGTO(DEBUG, std::cerr)
+        << "Found partial dog bone with main leg " << mainLeg << " ("
+        << mainLeg->pl().toStr() << ") at node " << notPartN;
     OptNode* partN = mainLeg->getOtherNd(notPartN);
 
     // the geometry of the main leg
@@ -1494,22 +1790,13 @@ void OptGraph::untanglePartialDogBone() {
 }
 
 // _____________________________________________________________________________
-void OptGraph::untangleInnerStump() {
-  std::vector<OptEdge*> toUntangle;
-
-  for (OptNode* na : getNds()) {
-    for (OptEdge* mainLeg : na->getAdjList()) {
-      if (mainLeg->getFrom() != na) continue;
-      if (isInnerStump(mainLeg)) {
-        LOGTO(DEBUG, std::cerr) << "Found inner stump with main leg " << mainLeg
-                                << " (" << mainLeg->pl().toStr() << ")";
-
-        toUntangle.push_back(mainLeg);
-      }
-    }
-  }
+void OptGraph::untangleInnerStump(const std::set<OptNode*>& nds) {
+  auto toUntangle = findEdgs(
+      nds, [this](OptEdge* mainLeg) { return isInnerStump(mainLeg); });
 
   for (auto mainLeg : toUntangle) {
+    LOGTO(DEBUG, std::cerr) << "Found inner stump with main leg " << mainLeg
+                            << " (" << mainLeg->pl().toStr() << ")";
     auto na = mainLeg->getFrom();
     OptNode* nb = mainLeg->getOtherNd(na);
 
@@ -1655,23 +1942,13 @@ void OptGraph::untangleInnerStump() {
 }
 
 // _____________________________________________________________________________
-void OptGraph::untangleDogBone() {
-  std::vector<OptEdge*> toUntangle;
-
-  for (OptNode* na : getNds()) {
-    for (OptEdge* mainLeg : na->getAdjList()) {
-      if (mainLeg->getFrom() != na) continue;
-      if (isDogBone(mainLeg)) {
-        LOGTO(DEBUG, std::cerr)
-            << "Found full dog bone with main leg " << mainLeg << " ("
-            << mainLeg->pl().toStr() << ")";
-
-        toUntangle.push_back(mainLeg);
-      }
-    }
-  }
+void OptGraph::untangleDogBone(const std::set<OptNode*>& nds) {
+  auto toUntangle = findEdgs(
+      nds, [this](OptEdge* mainLeg) { return isDogBone(mainLeg); });
 
   for (auto mainLeg : toUntangle) {
+    LOGTO(DEBUG, std::cerr) << "Found full dog bone with main leg " << mainLeg
+                            << " (" << mainLeg->pl().toStr() << ")";
     auto na = mainLeg->getFrom();
     OptNode* nb = mainLeg->getOtherNd(na);
     // the geometry of the main leg
@@ -1787,6 +2064,7 @@ size_t OptNodePL::circOrder(OptEdge* e) const {
 
 // _____________________________________________________________________________
 void OptGraph::updateEdgeOrder(OptNode* n) {
+  _dirty.insert(n);
   n->pl().circOrdering.clear();
 
   if (n->getDeg() == 1) {
@@ -2144,6 +2422,76 @@ std::vector<OptEdge*> OptGraph::clockwEdges(const OptEdge* noon,
   return clockwise;
 }
 
+// _____________________________________________________________________________
+size_t OptCrossTable::idx(const OptEdge* e) const {
+  // node degrees are small, a linear scan beats any map here
+  return std::find(edges.begin(), edges.end(), e) - edges.begin();
+}
+
+// _____________________________________________________________________________
+bool OptCrossTable::isCtd(size_t i, size_t j, const Line* l) const {
+  const auto& lines = ctd[i * edges.size() + j];
+  return std::binary_search(lines.begin(), lines.end(), l);
+}
+
+// _____________________________________________________________________________
+void OptGraph::buildCrossTables() {
+  for (auto n : getNds()) n->pl().crossTable = buildCrossTable(n);
+}
+
+// _____________________________________________________________________________
+const OptCrossTable& OptGraph::getCrossTable(OptNode* n, OptCrossTable* tmp) {
+  if (!n->pl().crossTable.empty()) return n->pl().crossTable;
+  *tmp = buildCrossTable(n);
+  return *tmp;
+}
+
+// _____________________________________________________________________________
+OptCrossTable OptGraph::buildCrossTable(OptNode* n) {
+  OptCrossTable ret;
+  ret.edges.assign(n->getAdjList().begin(), n->getAdjList().end());
+  size_t deg = ret.edges.size();
+
+  for (auto e : ret.edges) {
+    ret.rev.push_back((e->getFrom() != n) ^ e->pl().lnEdgParts.front().dir);
+    ret.circ.push_back(n->pl().circOrder(e));
+
+    ret.clockw.push_back({});
+    for (auto eb : clockwEdges(e, n)) ret.clockw.back().push_back(ret.idx(eb));
+  }
+
+  ret.ctd.resize(deg * deg);
+
+  if (!n->pl().node) return ret;
+
+  for (size_t i = 0; i < deg; i++) {
+    auto ea = ret.edges[i];
+    auto lnEdgA = getAdjEdg(ea, n);
+    for (size_t j = 0; j < deg; j++) {
+      if (i == j) continue;
+      auto eb = ret.edges[j];
+      auto lnEdgB = getAdjEdg(eb, n);
+      auto& lines = ret.ctd[i * deg + j];
+
+      for (const auto& eaLo : ea->pl().getLines()) {
+        const auto* ebLo = eb->pl().getLineOcc(eaLo.line);
+        if (!ebLo || !lnEdgA || !lnEdgB) continue;
+
+        if ((eaLo.dir == 0 || ebLo->dir == 0 ||
+             (eaLo.dir == n->pl().node && ebLo->dir != n->pl().node) ||
+             (eaLo.dir != n->pl().node && ebLo->dir == n->pl().node)) &&
+            n->pl().node->pl().connOccurs(eaLo.line, lnEdgA, lnEdgB)) {
+          lines.push_back(eaLo.line);
+        }
+      }
+
+      std::sort(lines.begin(), lines.end());
+    }
+  }
+
+  return ret;
+}
+
 // _____________________________________________________________________________
 std::vector<OptEdge*> OptGraph::partialClockwEdges(const OptEdge* noon,
                                                    const OptNode* n) {
@@ -5,8 +5,11 @@
 #ifndef LOOM_GRAPH_OPTIM_OPTGRAPH_H_
 #define LOOM_GRAPH_OPTIM_OPTGRAPH_H_
 
+#include <functional>
 #include <set>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "shared/linegraph/LineGraph.h"
 #include "shared/rendergraph/RenderGraph.h"
@@ -29,17 +32,41 @@ typedef std::map<const loom::optim::OptEdge*,
                  std::vector<const shared::linegraph::Line*>>
     OptOrderCfg;
 
+// Lines bundled into a single OptLO, a view into the interned relatives
+// table or onto the OptLO's own line. Only valid as long as the OptLO is.
+class OptLORelatives {
+ public:
+  typedef const shared::linegraph::Line* const* const_iterator;
+
+  OptLORelatives(const_iterator begin, const_iterator end)
+      : _begin(begin), _end(end) {}
+
+  const_iterator begin() const { return _begin; }
+  const_iterator end() const { return _end; }
+  size_t size() const { return _end - _begin; }
+
+ private:
+  const_iterator _begin, _end;
+};
+
+// Line occurrence in the optimization graph. This is copied a lot during
+// simplification and scoring, so it is a trivially copyable value: the
+// relatives are interned in a table shared by all graphs, an OptLO without
+// partners has only its own line as relative and needs no table entry.
 struct OptLO {
-  OptLO() : line(0), dir(0) {}
+  OptLO() : line(0), dir(0), _rels(0) {}
   OptLO(const shared::linegraph::Line* r,
         const shared::linegraph::LineNode* dir)
-      : line(r), dir(dir) {
-    relatives.push_back(r);
-  }
+      : line(r), dir(dir), _rels(0) {}
   const shared::linegraph::Line* line;
   const shared::linegraph::LineNode* dir;  // 0 if in both directions
 
-  std::vector<const shared::linegraph::Line*> relatives;
+  // the lines bundled into this one, at least line itself
+  OptLORelatives relatives() const {
+    if (!_rels) return OptLORelatives(&line, &line + 1);
+    return OptLORelatives(_rels->data(), _rels->data() + _rels->size());
+  }
+  void setRelatives(const std::vector<const shared::linegraph::Line*>& rels);
 
   bool operator==(const shared::linegraph::Line* b) const { return b == line; }
   bool operator<(const shared::linegraph::Line* b) const { return b < line; }
@@ -52,8 +79,15 @@ struct OptLO {
   bool operator==(const shared::linegraph::LineOcc& b) const {
     return b.line == line;
   }
+
+ private:
+  // interned, 0 if the only relative is line
+  const std::vector<const shared::linegraph::Line*>* _rels;
 };
 
+static_assert(std::is_trivially_copyable<OptLO>::value,
+              "OptLO is copied a lot and must not allocate");
+
 struct PartnerPath {
   // Important: OptLOs with the same route are r equivalent to each other and
   // to the original route, see above
@@ -110,6 +144,31 @@ struct OptEdgePL {
   util::json::Dict getAttrs();
 };
 
+// Crossing lookup table of a node. Everything in here is independent of the
+// line orderings, so the crossing checks of the optimizers and the scorer
+// only have to combine it with the positions of a configuration. Edges are
+// referred to by their index in edges.
+struct OptCrossTable {
+  std::vector<OptEdge*> edges;
+
+  // whether the line order of the edge is reversed as seen from the node
+  std::vector<char> rev;
+
+  // position of the edge in the circular ordering of the node
+  std::vector<size_t> circ;
+
+  // the other edges in clockwise order, starting after edge i
+  std::vector<std::vector<size_t>> clockw;
+
+  // the lines continuing from edge i into edge j which are considered for
+  // crossings there, at i * edges.size() + j, sorted
+  std::vector<std::vector<const shared::linegraph::Line*>> ctd;
+
+  bool empty() const { return edges.empty(); }
+  size_t idx(const OptEdge* e) const;
+  bool isCtd(size_t i, size_t j, const shared::linegraph::Line* l) const;
+};
+
 struct OptNodePL {
   OptNodePL(util::geo::Point<double> p) : node(0), p(p){};
   OptNodePL(const shared::linegraph::LineNode* node)
@@ -128,6 +187,9 @@ struct OptNodePL {
   // on the geometry in the original graph
   std::vector<OptEdge*> circOrdering;
   std::map<OptEdge*, size_t> circOrderMap;
+
+  // filled by OptGraph::buildCrossTables(), empty if not yet built
+  OptCrossTable crossTable;
 };
 
 class OptGraph : public util::graph::UndirGraph<OptNodePL, OptEdgePL> {
@@ -150,6 +212,23 @@ class OptGraph : public util::graph::UndirGraph<OptNodePL, OptEdgePL> {
   void untangle();
   void partnerLines();
 
+  // bundle lines which share at least minShare of their edges (relative to
+  // the union of their edges) into a single line occurrence on the edges they
+  // all occur on in the same direction, like partner lines. Unlike partners,
+  // bundled lines may diverge elsewhere, so an ordering of the bundled graph
+  // is only a coarse one. Returns the number of bundles.
+  size_t bundleLines(double minShare);
+
+  // apply the untangling, contraction and splitting rules until a fixed point
+  // is reached, but for at most maxRounds rounds. After the first round, the
+  // rules are only checked near the nodes changed in the previous round.
+  // Returns the number of rounds.
+  size_t simplify(size_t maxRounds);
+
+  // threads used to detect untangling rule matches, they are always applied
+  // serially
+  void setThreads(size_t n) { _threads = n ? n : 1; }
+
   std::vector<PartnerPath> getPartnerLines() const;
   PartnerPath pathFromComp(const std::set<OptNode*>& comp) const;
 
@@ -182,21 +261,57 @@ class OptGraph : public util::graph::UndirGraph<OptNodePL, OptEdgePL> {
   void splitSingleLineEdgs();
   void terminusDetach();
 
+  // build the crossing tables of all nodes, must be called again if the graph
+  // changes afterwards
+  void buildCrossTables();
+
+  // the crossing table of n, computed into tmp if it was not built yet
+  static const OptCrossTable& getCrossTable(OptNode* n, OptCrossTable* tmp);
+  static OptCrossTable buildCrossTable(OptNode* n);
+
  private:
   const OptGraphScorer* _scorer;
+
+  // threads used to detect untangling rule matches
+  size_t _threads = 1;
+
+  // nodes changed since the last simplification round
+  std::set<OptNode*> _dirty;
+
   void writeEdgeOrder();
   void updateEdgeOrder(OptNode* n);
-  bool contractDeg2Step();
-
-  bool untangleFullX();
-  void untangleY();
-  void untanglePartialY();
-  void untangleDogBone();
-  void untanglePartialDogBone();
 
-  void untangleOuterStump();
-  void untangleInnerStump();
-  void untangleDoubleStump();
+  std::set<OptNode*> popDirtyNbh();
+  void prune(std::set<OptNode*>* nds) const;
+
+  // the rules below only check the candidate nodes nds
+  void contractDeg2Nds(std::set<OptNode*>* nds);
+  bool contractDeg2Step(std::set<OptNode*>* nds);
+  void untangle(std::set<OptNode*>* nds);
+  void splitSingleLineEdgs(const std::set<OptNode*>& nds);
+  void terminusDetach(const std::set<OptNode*>& nds);
+
+  // the edges leaving nodes in nds / the edges of the terminus nodes in nds
+  // (with the node at their other end) for which pred holds, in the order of
+  // nds. The rules detect their matches with these before changing the
+  // graph, pred is checked in parallel and must not change the graph.
+  std::vector<OptEdge*> findEdgs(
+      const std::set<OptNode*>& nds,
+      const std::function<bool(OptEdge*)>& pred) const;
+  std::vector<OptEdge*> findTermEdgs(
+      const std::set<OptNode*>& nds,
+      const std::function<bool(OptEdge*, OptNode*)>& pred) const;
+
+  // untangle all full crosses among nds, true if there was any
+  bool untangleFullX(const std::set<OptNode*>& nds);
+  void untangleY(const std::set<OptNode*>& nds);
+  void untanglePartialY(const std::set<OptNode*>& nds);
+  void untangleDogBone(const std::set<OptNode*>& nds);
+  void untanglePartialDogBone(const std::set<OptNode*>& nds);
+
+  void untangleOuterStump(const std::set<OptNode*>& nds);
+  void untangleInnerStump(const std::set<OptNode*>& nds);
+  void untangleDoubleStump(const std::set<OptNode*>& nds);
 
   std::vector<OptNode*> explodeNodeAlong(OptNode* nd,
                                          const util::geo::PolyLine<double>& pl,
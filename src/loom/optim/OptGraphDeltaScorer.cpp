@@ -0,0 +1,374 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include "loom/optim/OptGraphDeltaScorer.h"
+#include "shared/linegraph/Line.h"
+#include "util/Misc.h"
+
+using loom::optim::OptGraphDeltaScorer;
+using shared::linegraph::Line;
+
+namespace {
+// _____________________________________________________________________________
+int32_t localId(const loom::optim::OptEdge* e, const Line* l) {
+  const auto& lines = e->pl().getLines();
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (lines[i].line == l) return i;
+  }
+  return -1;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+OptGraphDeltaScorer::OptGraphDeltaScorer(const OptGraphScorer& scorer,
+                                         const std::set<OptNode*>& g,
+                                         const DenseOrderCfg& c)
+    : _cfg(c),
+      _edgs(c.numEdgs()),
+      _assigned(c.numEdgs(), true),
+      _lbTotal(0) {
+  for (size_t e = 0; e < _cfg.numEdgs(); e++) {
+    _edgs[e].pos.resize(_cfg.size(e));
+    updatePos(e);
+  }
+
+  for (auto n : g) {
+    if (!n->pl().node) continue;
+
+    _nds.push_back(NodeState());
+    auto& ns = _nds.back();
+
+    OptCrossTable tmp;
+    const auto& tbl = OptGraph::getCrossTable(n, &tmp);
+    const auto& adj = tbl.edges;
+
+    ns.deg = adj.size();
+    for (size_t a = 0; a < ns.deg; a++) {
+      ns.edgs.push_back(_cfg.getEdgIdx(adj[a]));
+      ns.rev.push_back(tbl.rev[a]);
+    }
+
+    ns.conn.resize(ns.deg * ns.deg);
+    ns.clockw = tbl.clockw;
+
+    for (size_t a = 0; a < ns.deg; a++) {
+      auto ea = adj[a];
+      for (size_t b = 0; b < ns.deg; b++) {
+        if (a == b) continue;
+        auto eb = adj[b];
+        auto& conn = ns.conn[a * ns.deg + b];
+        conn.resize(eb->pl().getLines().size(), -1);
+
+        for (size_t lidB = 0; lidB < conn.size(); lidB++) {
+          const auto* l = eb->pl().getLines()[lidB].line;
+          if (!tbl.isCtd(a, b, l)) continue;
+          conn[lidB] = localId(ea, l);
+        }
+      }
+    }
+
+    ns.penSame = scorer.getCrossingPenSameSeg(n);
+    ns.penDiff = scorer.getCrossingPenDiffSeg(n);
+    ns.penSep = scorer.getSeparationPen(n);
+
+    ns.cross.resize(ns.deg * ns.deg, 0);
+    ns.sep.resize(ns.deg * ns.deg, 0);
+    ns.diff.resize(ns.deg, 0);
+    ns.sumCross = 0;
+    ns.sumSep = 0;
+    ns.sumDiff = 0;
+
+    for (size_t a = 0; a < ns.deg; a++) {
+      for (size_t b = 0; b < ns.deg; b++) {
+        if (a == b) continue;
+        auto r = evalPair(ns, a, b);
+        ns.cross[a * ns.deg + b] = r.first;
+        ns.sep[a * ns.deg + b] = r.second;
+        ns.sumCross += r.first;
+        ns.sumSep += r.second;
+      }
+      if (ns.deg > 2) {
+        ns.diff[a] = evalDiff(ns, a);
+        ns.sumDiff += ns.diff[a];
+      }
+    }
+  }
+
+  for (size_t i = 0; i < _nds.size(); i++) {
+    for (size_t k = 0; k < _nds[i].deg; k++) {
+      _edgs[_nds[i].edgs[k]].ends.push_back({i, k});
+    }
+    _nds[i].lb = nodeLowerBound(_nds[i]);
+    _lbTotal += _nds[i].lb;
+  }
+}
+
+// _____________________________________________________________________________
+std::pair<size_t, size_t> OptGraphDeltaScorer::evalPair(const NodeState& ns,
+                                                        size_t a, size_t b) {
+  const size_t NONE = std::numeric_limits<size_t>::max();
+
+  const auto& posA = _edgs[ns.edgs[a]].pos;
+  const auto* atB = _cfg.begin(ns.edgs[b]);
+  size_t sizeB = _cfg.size(ns.edgs[b]);
+  const auto& conn = ns.conn[a * ns.deg + b];
+
+  bool rev = !(ns.rev[a] ^ ns.rev[b]);
+
+  _relOrderCross.clear();
+  _relOrderSep.clear();
+
+  for (size_t q = 0; q < sizeB; q++) {
+    int32_t la = conn[atB[q]];
+    if (la < 0) {
+      // placeholder for separations
+      _relOrderSep.push_back(NONE);
+      continue;
+    }
+    size_t p = posA[la];
+    size_t v = rev ? posA.size() - 1 - p : p;
+    _relOrderCross.push_back(v);
+    _relOrderSep.push_back(v);
+  }
+
+  size_t seps = 0;
+
+  for (size_t i = 1; i < _relOrderSep.size(); i++) {
+    if (_relOrderSep[i - 1] < NONE && _relOrderSep[i] < NONE) {
+      if (_relOrderSep[i] > _relOrderSep[i - 1] &&
+          _relOrderSep[i] - _relOrderSep[i - 1] > 1)
+        seps++;
+      if (_relOrderSep[i] < _relOrderSep[i - 1] &&
+          _relOrderSep[i - 1] - _relOrderSep[i] > 1)
+        seps++;
+    }
+  }
+
+  return {util::inversions(_relOrderCross), seps};
+}
+
+// _____________________________________________________________________________
+size_t OptGraphDeltaScorer::evalDiff(const NodeState& ns, size_t a) {
+  const auto& posA = _edgs[ns.edgs[a]].pos;
+  bool revA = ns.rev[a];
+
+  _relOrderCross.clear();
+
+  for (size_t b : ns.clockw[a]) {
+    const auto* atB = _cfg.begin(ns.edgs[b]);
+    size_t sizeB = _cfg.size(ns.edgs[b]);
+    const auto& conn = ns.conn[a * ns.deg + b];
+    bool revB = ns.rev[b];
+
+    for (size_t i = 0; i < sizeB; i++) {
+      int32_t la = conn[atB[!revB ? sizeB - 1 - i : i]];
+      if (la < 0) continue;
+      size_t p = posA[la];
+      _relOrderCross.push_back(revA ? posA.size() - 1 - p : p);
+    }
+  }
+
+  return util::inversions(_relOrderCross);
+}
+
+// _____________________________________________________________________________
+double OptGraphDeltaScorer::nodeScore(const NodeState& ns, size_t sumCross,
+                                      size_t sumSep, size_t sumDiff) const {
+  // same seg crossings are counted twice
+  size_t same = sumCross / 2;
+  size_t diff = ns.deg > 2 ? sumDiff - same : 0;
+
+  return same * ns.penSame + diff * ns.penDiff + sumSep * ns.penSep;
+}
+
+// _____________________________________________________________________________
+double OptGraphDeltaScorer::update(size_t e, bool keep) {
+  double delta = 0;
+
+  for (const auto& end : _edgs[e].ends) {
+    auto& ns = _nds[end.first];
+    size_t k = end.second;
+
+    // unsigned wrap-around cancels out in the sums
+    size_t sumCross = ns.sumCross;
+    size_t sumSep = ns.sumSep;
+    size_t sumDiff = ns.sumDiff;
+
+    for (size_t b = 0; b < ns.deg; b++) {
+      if (b == k) continue;
+      for (size_t idx : {k * ns.deg + b, b * ns.deg + k}) {
+        auto r = evalPair(ns, idx / ns.deg, idx % ns.deg);
+        sumCross += r.first - ns.cross[idx];
+        sumSep += r.second - ns.sep[idx];
+        if (keep) {
+          ns.cross[idx] = r.first;
+          ns.sep[idx] = r.second;
+        }
+      }
+    }
+
+    if (ns.deg > 2) {
+      // e is either a itself or one of the clockwise edges of a
+      for (size_t a = 0; a < ns.deg; a++) {
+        size_t d = evalDiff(ns, a);
+        sumDiff += d - ns.diff[a];
+        if (keep) ns.diff[a] = d;
+      }
+    }
+
+    delta += nodeScore(ns, sumCross, sumSep, sumDiff) -
+             nodeScore(ns, ns.sumCross, ns.sumSep, ns.sumDiff);
+
+    if (keep) {
+      ns.sumCross = sumCross;
+      ns.sumSep = sumSep;
+      ns.sumDiff = sumDiff;
+    }
+  }
+
+  if (keep) updateLowerBound(e);
+
+  return delta;
+}
+
+// _____________________________________________________________________________
+double OptGraphDeltaScorer::nodeLowerBound(const NodeState& ns) const {
+  bool all = true;
+  for (auto e : ns.edgs) all = all && _assigned[e];
+  if (all) return nodeScore(ns, ns.sumCross, ns.sumSep, ns.sumDiff);
+
+  // all counts are non-negative, and the diff seg crossings are at least the
+  // same seg crossings, so the counts between assigned edges are a bound
+  size_t cross = 0, sep = 0;
+  for (size_t a = 0; a < ns.deg; a++) {
+    if (!_assigned[ns.edgs[a]]) continue;
+    for (size_t b = 0; b < ns.deg; b++) {
+      if (a == b || !_assigned[ns.edgs[b]]) continue;
+      cross += ns.cross[a * ns.deg + b];
+      sep += ns.sep[a * ns.deg + b];
+    }
+  }
+
+  return (cross / 2) * ns.penSame + sep * ns.penSep;
+}
+
+// _____________________________________________________________________________
+void OptGraphDeltaScorer::updateLowerBound(size_t e) {
+  for (const auto& end : _edgs[e].ends) {
+    auto& ns = _nds[end.first];
+    double lb = nodeLowerBound(ns);
+    _lbTotal += lb - ns.lb;
+    ns.lb = lb;
+  }
+}
+
+// _____________________________________________________________________________
+void OptGraphDeltaScorer::setAssigned(size_t e, bool assigned) {
+  if (_assigned[e] == assigned) return;
+  _assigned[e] = assigned;
+  updateLowerBound(e);
+}
+
+// _____________________________________________________________________________
+void OptGraphDeltaScorer::setOrder(size_t e,
+                                   const DenseOrderCfg::LineId* perm) {
+  std::copy(perm, perm + _cfg.size(e), _cfg.begin(e));
+  updatePos(e);
+  update(e, true);
+}
+
+// _____________________________________________________________________________
+void OptGraphDeltaScorer::swapLocal(size_t e, size_t i, size_t j) {
+  auto* at = _cfg.begin(e);
+  auto& pos = _edgs[e].pos;
+  std::swap(at[i], at[j]);
+  pos[at[i]] = i;
+  pos[at[j]] = j;
+}
+
+// _____________________________________________________________________________
+void OptGraphDeltaScorer::moveLocal(size_t e, size_t i, size_t len,
+                                    size_t j) {
+  auto* at = _cfg.begin(e);
+  if (j < i) {
+    std::rotate(at + j, at + i, at + i + len);
+  } else {
+    std::rotate(at + i, at + i + len, at + j + len);
+  }
+  updatePos(e);
+}
+
+// _____________________________________________________________________________
+void OptGraphDeltaScorer::updatePos(size_t e) {
+  const auto* at = _cfg.begin(e);
+  auto& pos = _edgs[e].pos;
+  for (size_t p = 0; p < pos.size(); p++) pos[at[p]] = p;
+}
+
+// _____________________________________________________________________________
+double OptGraphDeltaScorer::scoreDelta(size_t e, size_t i, size_t j) {
+  if (i == j) return 0;
+
+  swapLocal(e, i, j);
+  double delta = update(e, false);
+  swapLocal(e, i, j);
+
+  return delta;
+}
+
+// _____________________________________________________________________________
+void OptGraphDeltaScorer::swap(size_t e, size_t i, size_t j) {
+  if (i == j) return;
+
+  swapLocal(e, i, j);
+  update(e, true);
+}
+
+// _____________________________________________________________________________
+double OptGraphDeltaScorer::moveDelta(size_t e, size_t i, size_t len,
+                                      size_t j) {
+  if (i == j || len == 0) return 0;
+
+  moveLocal(e, i, len, j);
+  double delta = update(e, false);
+  moveLocal(e, j, len, i);
+
+  return delta;
+}
+
+// _____________________________________________________________________________
+void OptGraphDeltaScorer::move(size_t e, size_t i, size_t len, size_t j) {
+  if (i == j || len == 0) return;
+
+  moveLocal(e, i, len, j);
+  update(e, true);
+}
+
+// _____________________________________________________________________________
+bool OptGraphDeltaScorer::nextPermutation(size_t e) {
+  bool ret = std::next_permutation(_cfg.begin(e), _cfg.end(e));
+  updatePos(e);
+  update(e, true);
+  return ret;
+}
+
+// _____________________________________________________________________________
+bool OptGraphDeltaScorer::prevPermutation(size_t e) {
+  bool ret = std::prev_permutation(_cfg.begin(e), _cfg.end(e));
+  updatePos(e);
+  update(e, true);
+  return ret;
+}
+
+// _____________________________________________________________________________
+double OptGraphDeltaScorer::getScore() const {
+  double ret = 0;
+  for (const auto& ns : _nds) {
+    ret += nodeScore(ns, ns.sumCross, ns.sumSep, ns.sumDiff);
+  }
+  return ret;
+}
@@ -0,0 +1,125 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_OPTGRAPHDELTASCORER_H_
+#define LOOM_OPTIM_OPTGRAPHDELTASCORER_H_
+
+#include <set>
+#include <vector>
+#include "loom/optim/DenseOrderCfg.h"
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/OptGraphScorer.h"
+
+namespace loom {
+namespace optim {
+
+// Incremental scoring of ordering changes of a single OptEdge, for the local
+// search and exhaustive optimizers. The crossing and separation counts of
+// every pair of adjacent edges at each node are cached. Changing the ordering
+// of an edge only changes the counts of the pairs involving this edge at its
+// two end nodes, only those are re-evaluated.
+//
+// Which lines of an edge continue into an adjacent edge (and whether this
+// connection occurs) does not depend on the ordering and is precomputed.
+//
+// The scores are the same as OptGraphScorer::getTotalScore() (or
+// getCrossingScore() if separations are not optimized).
+class OptGraphDeltaScorer {
+ public:
+  OptGraphDeltaScorer(const OptGraphScorer& scorer, const std::set<OptNode*>& g,
+                      const DenseOrderCfg& c);
+
+  // score difference if lines at positions i and j of edge e were swapped
+  double scoreDelta(size_t e, size_t i, size_t j);
+
+  // swap lines at positions i and j of edge e
+  void swap(size_t e, size_t i, size_t j);
+
+  // score difference if the block of len lines starting at position i of
+  // edge e was moved to start at position j
+  double moveDelta(size_t e, size_t i, size_t len, size_t j);
+
+  // move the block of len lines starting at position i of edge e to start
+  // at position j
+  void move(size_t e, size_t i, size_t len, size_t j);
+
+  // advance the ordering of edge e to its next permutation, semantics as in
+  // std::next_permutation
+  bool nextPermutation(size_t e);
+
+  // as above, semantics as in std::prev_permutation
+  bool prevPermutation(size_t e);
+
+  // set the ordering of edge e to the permutation perm of its local line ids
+  void setOrder(size_t e, const DenseOrderCfg::LineId* perm);
+
+  double getScore() const;
+
+  // for partial configurations: edges may be marked as unassigned (initially,
+  // all edges are assigned). getLowerBound() is then a lower bound for the
+  // score of every configuration which agrees on the assigned edges, and
+  // equal to getScore() if all edges are assigned.
+  void setAssigned(size_t e, bool assigned);
+  double getLowerBound() const { return _lbTotal; }
+
+  const DenseOrderCfg& getCfg() const { return _cfg; }
+
+ private:
+  struct EdgeState {
+    // local line id -> position
+    std::vector<DenseOrderCfg::LineId> pos;
+
+    // (node state, local adjacent edge index) of both end nodes
+    std::vector<std::pair<size_t, size_t>> ends;
+  };
+
+  struct NodeState {
+    size_t deg;
+
+    // adjacent edges by local index
+    std::vector<size_t> edgs;
+    std::vector<bool> rev;
+
+    // for each ordered pair (a, b) (index a * deg + b) and each local line id
+    // in b, the local line id in a the line is connected to, or -1
+    std::vector<std::vector<int32_t>> conn;
+
+    // for each a, the other edges in clockwise order
+    std::vector<std::vector<size_t>> clockw;
+
+    std::vector<size_t> cross, sep;
+    std::vector<size_t> diff;
+    size_t sumCross, sumSep, sumDiff;
+
+    double penSame, penDiff, penSep;
+
+    // lower bound for the node score
+    double lb;
+  };
+
+  DenseOrderCfg _cfg;
+
+  std::vector<EdgeState> _edgs;
+  std::vector<bool> _assigned;
+  double _lbTotal;
+  std::vector<NodeState> _nds;
+
+  // reused buffers
+  std::vector<size_t> _relOrderCross, _relOrderSep;
+
+  std::pair<size_t, size_t> evalPair(const NodeState& ns, size_t a, size_t b);
+  size_t evalDiff(const NodeState& ns, size_t a);
+  double nodeScore(const NodeState& ns, size_t sumCross, size_t sumSep,
+                   size_t sumDiff) const;
+  double update(size_t e, bool keep);
+  void updateLowerBound(size_t e);
+  double nodeLowerBound(const NodeState& ns) const;
+  void swapLocal(size_t e, size_t i, size_t j);
+  void moveLocal(size_t e, size_t i, size_t len, size_t j);
+  void updatePos(size_t e);
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_OPTGRAPHDELTASCORER_H_
@@ -9,6 +9,7 @@
 #include "shared/linegraph/Line.h"
 #include "shared/rendergraph/Penalties.h"
 
+using loom::optim::OptCrossTable;
 using loom::optim::OptGraphScorer;
 using shared::linegraph::Line;
 using shared::linegraph::LineEdge;
@@ -156,16 +157,20 @@ std::pair<size_t, size_t> OptGraphScorer::getNumCrossings(
 std::pair<std::pair<size_t, size_t>, size_t> OptGraphScorer::getNumCrossSeps(
     OptNode* n, const OptOrderCfg& c) const {
   std::pair<std::pair<size_t, size_t>, size_t> ret = {{0, 0}, 0};
-  for (auto ea : n->getAdjList()) {
-    auto cur = getNumCrossSeps(n, ea, c);
+
+  OptCrossTable tmp;
+  const auto& tbl = OptGraph::getCrossTable(n, &tmp);
+
+  for (size_t ea = 0; ea < tbl.edges.size(); ea++) {
+    auto cur = getNumCrossSeps(tbl, ea, c);
     ret.first.first += cur.first.first;
     ret.second += cur.second;
   }
 
   if (n->getDeg() > 2) {
     // diff seg crossings
-    for (auto ea : n->getAdjList()) {
-      size_t cur = getNumCrossDiffSeg(n, ea, c);
+    for (size_t ea = 0; ea < tbl.edges.size(); ea++) {
+      size_t cur = getNumCrossDiffSeg(tbl, ea, c);
       ret.first.second += cur;
     }
 
@@ -181,11 +186,19 @@ std::pair<std::pair<size_t, size_t>, size_t> OptGraphScorer::getNumCrossSeps(
 // _____________________________________________________________________________
 size_t OptGraphScorer::getNumCrossDiffSeg(OptNode* n, OptEdge* ea,
                                           const OptOrderCfg& c) const {
+  OptCrossTable tmp;
+  const auto& tbl = OptGraph::getCrossTable(n, &tmp);
+  return getNumCrossDiffSeg(tbl, tbl.idx(ea), c);
+}
+
+// _____________________________________________________________________________
+size_t OptGraphScorer::getNumCrossDiffSeg(const OptCrossTable& tbl, size_t ea,
+                                          const OptOrderCfg& c) const {
   std::map<const Line*, size_t> ordering;
 
-  bool revA = (ea->getFrom() != n) ^ ea->pl().lnEdgParts.front().dir;
+  bool revA = tbl.rev[ea];
 
-  const auto& cea = c.at(ea);
+  const auto& cea = c.at(tbl.edges[ea]);
 
   for (size_t i = 0; i < cea.size(); i++) {
     const auto& l = cea[i];
@@ -194,9 +207,9 @@ size_t OptGraphScorer::getNumCrossDiffSeg(OptNode* n, OptEdge* ea,
 
   std::vector<size_t> relOrderCross;
 
-  for (const auto& eb : OptGraph::clockwEdges(ea, n)) {
-    const auto& ceb = c.at(eb);
-    bool revB = (eb->getFrom() != n) ^ eb->pl().lnEdgParts.front().dir;
+  for (size_t eb : tbl.clockw[ea]) {
+    const auto& ceb = c.at(tbl.edges[eb]);
+    bool revB = tbl.rev[eb];
 
     for (size_t i = 0; i < ceb.size(); i++) {
       const auto& thisLine = ceb[!revB ? ceb.size() - 1 - i : i];
@@ -204,20 +217,8 @@ size_t OptGraphScorer::getNumCrossDiffSeg(OptNode* n, OptEdge* ea,
       auto otherIt = ordering.find(thisLine);
       if (otherIt == ordering.end()) continue;
 
-      const auto* eaLo = ea->pl().getLineOcc(otherIt->first);
-      const auto* ebLo = eb->pl().getLineOcc(thisLine);
-
-      assert(eaLo);
-      assert(ebLo);
-
-      if ((eaLo->dir == 0 || ebLo->dir == 0 ||
-           (eaLo->dir == n->pl().node && ebLo->dir != n->pl().node) ||
-           (eaLo->dir != n->pl().node && ebLo->dir == n->pl().node)) &&
-          (n->pl().node->pl().connOccurs(eaLo->line, OptGraph::getAdjEdg(ea, n),
-                                         OptGraph::getAdjEdg(eb, n)))) {
-        // connection occurs, consider for crossings
-        relOrderCross.push_back(otherIt->second);
-      }
+      // connection occurs, consider for crossings
+      if (tbl.isCtd(ea, eb, thisLine)) relOrderCross.push_back(otherIt->second);
     }
   }
 
@@ -227,17 +228,23 @@ size_t OptGraphScorer::getNumCrossDiffSeg(OptNode* n, OptEdge* ea,
 // _____________________________________________________________________________
 std::pair<std::pair<size_t, size_t>, size_t> OptGraphScorer::getNumCrossSeps(
     OptNode* n, OptEdge* ea, OptEdge* eb, const OptOrderCfg& c) const {
+  OptCrossTable tmp;
+  const auto& tbl = OptGraph::getCrossTable(n, &tmp);
+  return getNumCrossSeps(tbl, tbl.idx(ea), tbl.idx(eb), c);
+}
+
+// _____________________________________________________________________________
+std::pair<std::pair<size_t, size_t>, size_t> OptGraphScorer::getNumCrossSeps(
+    const OptCrossTable& tbl, size_t ea, size_t eb,
+    const OptOrderCfg& c) const {
   std::pair<std::pair<size_t, size_t>, size_t> ret{{0, 0}, 0};
 
   std::map<const Line*, size_t> ordering;
 
-  bool revA = (ea->getFrom() != n) ^ ea->pl().lnEdgParts.front().dir;
-  bool revB = (eb->getFrom() != n) ^ eb->pl().lnEdgParts.front().dir;
-
-  bool rev = !(revA ^ revB);
+  bool rev = !(tbl.rev[ea] ^ tbl.rev[eb]);
 
-  const auto& cea = c.at(ea);
-  const auto& ceb = c.at(eb);
+  const auto& cea = c.at(tbl.edges[ea]);
+  const auto& ceb = c.at(tbl.edges[eb]);
 
   for (size_t i = 0; i < cea.size(); i++) {
     ordering[cea[i]] = rev ? cea.size() - 1 - i : i;
@@ -249,28 +256,12 @@ std::pair<std::pair<size_t, size_t>, size_t> OptGraphScorer::getNumCrossSeps(
     const auto& thisLine = ceb[i];
 
     auto otherIt = ordering.find(thisLine);
-    if (otherIt == ordering.end()) {
-      // insert a placeholder for separations, otherwise ignore
-      relOrderSep.push_back(std::numeric_limits<size_t>::max());
-      continue;
-    }
-
-    const auto* eaLo = ea->pl().getLineOcc(otherIt->first);
-    const auto* ebLo = eb->pl().getLineOcc(thisLine);
-
-    assert(eaLo);
-    assert(ebLo);
-
-    if ((eaLo->dir == 0 || ebLo->dir == 0 ||
-         (eaLo->dir == n->pl().node && ebLo->dir != n->pl().node) ||
-         (eaLo->dir != n->pl().node && ebLo->dir == n->pl().node)) &&
-        (n->pl().node->pl().connOccurs(eaLo->line, OptGraph::getAdjEdg(ea, n),
-                                       OptGraph::getAdjEdg(eb, n)))) {
+    if (otherIt != ordering.end() && tbl.isCtd(ea, eb, thisLine)) {
       // connection occurs, consider for crossings
       relOrderCross.push_back(otherIt->second);
       relOrderSep.push_back(otherIt->second);
     } else {
-      // otherwise insert a placeholder
+      // otherwise insert a placeholder for separations
       relOrderSep.push_back(std::numeric_limits<size_t>::max());
     }
   }
@@ -299,10 +290,18 @@ std::pair<std::pair<size_t, size_t>, size_t> OptGraphScorer::getNumCrossSeps(
 // _____________________________________________________________________________
 std::pair<std::pair<size_t, size_t>, size_t> OptGraphScorer::getNumCrossSeps(
     OptNode* n, OptEdge* ea, const OptOrderCfg& c) const {
+  OptCrossTable tmp;
+  const auto& tbl = OptGraph::getCrossTable(n, &tmp);
+  return getNumCrossSeps(tbl, tbl.idx(ea), c);
+}
+
+// _____________________________________________________________________________
+std::pair<std::pair<size_t, size_t>, size_t> OptGraphScorer::getNumCrossSeps(
+    const OptCrossTable& tbl, size_t ea, const OptOrderCfg& c) const {
   std::pair<std::pair<size_t, size_t>, size_t> ret = {{0, 0}, 0};
-  for (auto eb : n->getAdjList()) {
+  for (size_t eb = 0; eb < tbl.edges.size(); eb++) {
     if (eb == ea) continue;
-    auto cur = getNumCrossSeps(n, ea, eb, c);
+    auto cur = getNumCrossSeps(tbl, ea, eb, c);
     ret.first.first += cur.first.first;
     ret.first.second += cur.first.second;
     ret.second += cur.second;
@@ -70,6 +70,15 @@ class OptGraphScorer {
 
  private:
   shared::rendergraph::Penalties _pens;
+
+  // same as above, edges given by their index in the crossing table
+  std::pair<std::pair<size_t, size_t>, size_t> getNumCrossSeps(
+      const OptCrossTable& tbl, size_t ea, const OptOrderCfg& c) const;
+  std::pair<std::pair<size_t, size_t>, size_t> getNumCrossSeps(
+      const OptCrossTable& tbl, size_t ea, size_t eb,
+      const OptOrderCfg& c) const;
+  size_t getNumCrossDiffSeg(const OptCrossTable& tbl, size_t ea,
+                            const OptOrderCfg& c) const;
 };
 }  // namespace optim
 }  // namespace loom
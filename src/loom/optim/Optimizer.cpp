@@ -2,19 +2,34 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <fstream>
+#include <limits>
 #include <numeric>
+#include <random>
+#include "loom/optim/GreedyOptimizer.h"
+#include "loom/optim/HillClimbOptimizer.h"
 #include "loom/optim/NullOptimizer.h"
 #include "loom/optim/OptGraph.h"
 #include "loom/optim/OptGraphScorer.h"
 #include "loom/optim/Optimizer.h"
+#include "loom/optim/RefOrdering.h"
+#include "shared/linegraph/BinGraph.h"
+#include "shared/threads/Cancel.h"
+#include "shared/trace/Progress.h"
+#include "shared/trace/Trace.h"
 #include "util/Misc.h"
 #include "util/geo/output/GeoGraphJsonOutput.h"
 #include "util/graph/Algorithm.h"
 #include "util/log/Log.h"
 
 using loom::optim::EdgePair;
+using loom::optim::HillClimbOptimizer;
 using loom::optim::LinePair;
+using loom::optim::LnEdgPart;
+using loom::optim::OptLO;
 using loom::optim::NullOptimizer;
 using loom::optim::OptEdge;
 using loom::optim::OptGraph;
@@ -65,28 +80,32 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
   optResStats.solutionSpaceSizeOrig = solSp;
   optResStats.maxLineCardOrig = maxC;
 
+  size_t numBundles = 0;
+
   if (_cfg->untangleGraph) {
+    TRACE_ZONE("untangle");
     T_START(1);
     // do full untangling
     LOGTO(DEBUG, std::cerr) << "Untangling graph...";
     g.partnerLines();
+    numBundles = bundleLines(&g);
 
-    for (size_t i = 0; i <= maxC + 1; i++) {
-      g.untangle();
-      g.contractDeg2Nds();
-      g.splitSingleLineEdgs();
-      g.terminusDetach();
-    }
+    // rules applied in one round only become visible to the candidate
+    // checks of the next round, allow twice the rounds of full sweeps
+    g.setThreads(_cfg->threads);
+    size_t rounds = g.simplify(2 * (maxC + 2));
 
     optResStats.simplificationTime = T_STOP(1);
 
-    LOGTO(DEBUG, std::cerr)
-        << "Done (" << optResStats.simplificationTime << " ms)";
+    LOGTO(DEBUG, std::cerr) << "Done after " << rounds << " round(s) ("
+                            << optResStats.simplificationTime << " ms)";
   } else if (_cfg->pruneGraph) {
     // only apply core graph rules
+    TRACE_ZONE("prune");
     T_START(1);
     LOGTO(DEBUG, std::cerr) << "Creating core optimization graph...";
     g.partnerLines();
+    numBundles = bundleLines(&g);
     // not necessary here, but avoids an excessive number of single edges...
     g.contractDeg2Nds();
     g.splitSingleLineEdgs();
@@ -97,8 +116,13 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
 
     LOGTO(DEBUG, std::cerr)
         << "Done (" << optResStats.simplificationTime << " ms)";
+  } else {
+    numBundles = bundleLines(&g);
   }
 
+  // the graph is final from here on
+  g.buildCrossTables();
+
   if (_cfg->outOptGraph) {
     LOGTO(INFO, std::cerr) << "Outputting optimization graph to "
                            << _cfg->dbgPath << "/optgraph.json";
@@ -153,75 +177,293 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
   double bestScore = std::numeric_limits<double>::infinity();
   OrderCfg bestCfg;
 
+  // schedule the components with the biggest solution spaces first, so that
+  // a single giant component does not end up as the tail of the run
+  std::vector<size_t> order(comps.size());
+  std::vector<double> compSolSp(comps.size());
+  for (size_t i = 0; i < comps.size(); i++) {
+    order[i] = i;
+    compSolSp[i] = solutionSpaceSize(comps[i]);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&compSolSp](size_t a, size_t b) {
+                     return compSolSp[a] > compSolSp[b];
+                   });
+
+  // components with small ILPs are packed into a single block-diagonal ILP,
+  // which avoids a solver start-up for each of them. Each entry of jobs is
+  // optimized at once, the result is written to its first component.
+  std::vector<std::vector<size_t>> jobs;
+  std::vector<size_t> batch;
+  size_t batchSize = 0;
+  size_t numBatched = 0;
+
+  for (size_t comp : order) {
+    size_t size = 0;
+    if (_cfg->ilpBatchSize && maxC > 1 && comps[comp].size() > 2) {
+      size = ilpBatchSize(comps[comp]);
+    }
+
+    if (size == 0 || size >= _cfg->ilpBatchSize) {
+      jobs.push_back({comp});
+      continue;
+    }
+
+    if (batchSize + size > _cfg->ilpBatchSize) {
+      jobs.push_back(batch);
+      batch.clear();
+      batchSize = 0;
+    }
+
+    batch.push_back(comp);
+    batchSize += size;
+    numBatched++;
+  }
+
+  if (batch.size()) jobs.push_back(batch);
+
+  if (numBatched) {
+    LOGTO(DEBUG, std::cerr) << "Packed " << numBatched
+                            << " small ILP component(s) into "
+                            << numBatched + jobs.size() - order.size()
+                            << " ILP(s)";
+  }
+
+  // the time budget covers all runs
+  auto budgetEnd = std::chrono::steady_clock::now() +
+                   std::chrono::duration_cast<
+                       std::chrono::steady_clock::duration>(
+                       std::chrono::duration<double>(_cfg->timeBudget));
+
+  // the final orderings are only scored on the unsimplified optim graph if
+  // runs have to be compared, bundles refined or stats are requested
+  bool rescore =
+      runs > 1 || numBundles || _cfg->outputStats || _cfg->writeStats;
+
+  // unsimplified optim graph, shared by all runs
+  OptGraph gg(&_scorer);
+  std::map<const shared::linegraph::LineNode*, OptNode*> ndMap;
+  if (rescore) {
+    ndMap = gg.build(rg);
+    gg.buildCrossTables();
+  }
+
+  // orderings of the reference result for the opt graph edges, see
+  // getRefOrderCfg()
+  HierarOrderCfg refCfg;
+  if (_cfg->referencePath.size()) getRefHierarch(g, rg, &refCfg);
+  size_t numRefComps = 0;
+
+  double maxCompSolSpace = 0;
+  size_t maxCompC = 0;
+  size_t maxNumNodes = 0;
+  size_t maxNumEdges = 0;
+  size_t numM1Comps = 0;
+
+  for (const auto& nds : comps) {
+    if (_cfg->outputStats) {
+      size_t maxC = maxCard(nds);
+      double solSp = solutionSpaceSize(nds);
+
+      // skip trivial components
+      if (nds.size() > 2) {
+        if (maxC > maxCompC) maxCompC = maxC;
+        if (solSp > maxCompSolSpace) maxCompSolSpace = solSp;
+        if (solSp == 1) numM1Comps++;
+        if (nds.size() > maxNumNodes) maxNumNodes = nds.size();
+        if (numEdges(nds) > maxNumEdges) maxNumEdges = numEdges(nds);
+
+        LOGTO(INFO, std::cerr)
+            << " (stats) Optimizing subgraph of size " << nds.size()
+            << " with max cardinality = " << maxC
+            << " and solution space size = " << solSp;
+      }
+    }
+  }
+
+  optResStats.nonTrivialComponents = nonTrivialComponents;
+  optResStats.numCompsSolSpaceOne = numM1Comps;
+  optResStats.maxNumNodesPerComp = maxNumNodes;
+  optResStats.maxNumEdgesPerComp = maxNumEdges;
+  optResStats.maxCardPerComp = maxCompC;
+  optResStats.maxCompSolSpace = maxCompSolSpace;
+  optResStats.maxNumRowsPerComp = 0;
+  optResStats.maxNumColsPerComp = 0;
+
+  if (_cfg->outputStats) {
+    LOGTO(INFO, std::cerr) << "(stats) Number of nontrivial components: "
+                           << optResStats.nonTrivialComponents;
+    LOGTO(INFO, std::cerr)
+        << "(stats) Number of nontrivial components with sol space size 1: "
+        << optResStats.numCompsSolSpaceOne;
+    LOGTO(INFO, std::cerr)
+        << "(stats) Max number of nodes of all nontrivial components: "
+        << optResStats.maxNumNodesPerComp;
+    LOGTO(INFO, std::cerr)
+        << "(stats) Max number of edges of all nontrivial components: "
+        << optResStats.maxNumEdgesPerComp;
+    LOGTO(INFO, std::cerr)
+        << "(stats) Max cardinality of all nontrivial components: "
+        << optResStats.maxCardPerComp;
+    LOGTO(INFO, std::cerr)
+        << "(stats) Max solution space size of all nontrivial components: "
+        << optResStats.maxCompSolSpace;
+  }
+
+  // every run and component gets its own seed, the results do not depend
+  // on the order in which they are optimized
+  uint64_t seed = _cfg->seed < 0 ? std::random_device{}()
+                                 : static_cast<uint64_t>(_cfg->seed);
+  LOGTO(DEBUG, std::cerr) << "Random seed is " << seed;
+
+  // the runs and the components share nothing, optimize all of them
+  // concurrently. Each component of each run writes into its own
+  // configuration, which are merged in component order afterwards.
+  std::vector<std::vector<HierarOrderCfg>> compCfgs(
+      runs, std::vector<HierarOrderCfg>(comps.size()));
+  std::vector<std::vector<OptResStats>> compStats(
+      runs, std::vector<OptResStats>(comps.size(), optResStats));
+  std::vector<std::vector<double>> compT(runs,
+                                         std::vector<double>(comps.size(), 0));
+
+  // with fewer components than threads, the remaining threads are left to
+  // the component optimizers
+  size_t threads = std::max<size_t>(_cfg->threads, 1);
+  size_t compThreads =
+      threads / std::max<size_t>(1, std::min(threads, runs * jobs.size()));
+
+  for (size_t run = 0; run < runs; run++) {
+    for (size_t comp = 0; comp < comps.size(); comp++) {
+      compStats[run][comp].seed = seedFor(seedFor(seed, run), comp);
+      compStats[run][comp].threads = compThreads;
+    }
+  }
+
+  // with a time budget, each component gets a share of the remaining
+  // budget proportional to its estimated difficulty, the logarithm of its
+  // solution space size. Up to _cfg->threads components run at once.
+  std::vector<double> weight(comps.size(), 0);
+  double weightLeft = 0;
+  for (const auto& job : jobs) {
+    size_t comp = job.front();
+    for (size_t c : job) {
+      if (maxC < 2 || comps[c].size() < 3) continue;
+      weight[comp] += std::log2(std::max(compSolSp[c], 1.0)) + 1;
+    }
+    weightLeft += weight[comp] * runs;
+  }
+
+  shared::trace::Progress::comps(runs * jobs.size());
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(_cfg->threads)
+  for (size_t k = 0; k < runs * jobs.size(); k++) {
+    TRACE_ZONE("component");
+    size_t run = k / jobs.size();
+    size_t i = k % jobs.size();
+    size_t comp = jobs[i].front();
+    auto& stats = compStats[run][comp];
+
+    // the components of a batch are disjoint and unconnected, so their
+    // union is optimized like a single component
+    std::set<OptNode*> batchNds;
+    if (jobs[i].size() > 1) {
+      for (size_t c : jobs[i]) {
+        batchNds.insert(comps[c].begin(), comps[c].end());
+      }
+    }
+    const auto& nds = jobs[i].size() > 1 ? batchNds : comps[comp];
+
+    if (_cfg->timeBudget >= 0 && weight[comp] > 0) {
+#pragma omp critical(loomTimeBudget)
+      {
+        auto now = std::chrono::steady_clock::now();
+        auto left = budgetEnd > now ? budgetEnd - now
+                                    : std::chrono::steady_clock::duration(0);
+        double share = std::min(
+            1.0, weight[comp] * std::max<size_t>(_cfg->threads, 1) /
+                     weightLeft);
+        weightLeft -= weight[comp];
+        stats.hasDeadline = true;
+        stats.deadline =
+            now + std::chrono::duration_cast<
+                      std::chrono::steady_clock::duration>(left * share);
+      }
+    }
+
+    // the run deadline bounds every component, once the run is cancelled
+    // the remaining components get their greedy orderings
+    double runLeft = shared::threads::secondsLeft();
+    if (runLeft >= 0 && weight[comp] > 0) {
+      auto runEnd = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<
+                        std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(runLeft));
+      if (!stats.hasDeadline || runEnd < stats.deadline) {
+        stats.hasDeadline = true;
+        stats.deadline = runEnd;
+      }
+    }
+
+    // components which are unchanged against the reference keep its
+    // orderings
+    OptOrderCfg ref;
+    if (refCfg.size() && getOptOrderCfg(refCfg, nds, &ref)) {
+      writeHierarch(&ref, &compCfgs[run][comp]);
+#pragma omp atomic
+      numRefComps++;
+    } else if (maxC > 1 && nds.size() > 2) {
+      // this is the implementation of the single edge pruning described in
+      // the publication - simple skip such components
+      // we also skip components with only single edges
+      compT[run][comp] =
+          optimizeComp(&g, nds, &compCfgs[run][comp], stats);
+    } else {
+      compT[run][comp] =
+          nullOpt.optimizeComp(&g, nds, &compCfgs[run][comp], 0, stats);
+    }
+
+    shared::trace::Progress::compDone();
+  }
+
+  if (refCfg.size()) {
+    LOGTO(DEBUG, std::cerr) << "Kept the reference orderings of "
+                            << numRefComps << " of " << runs * jobs.size()
+                            << " component(s)";
+  }
+
   for (size_t run = 0; run < runs; run++) {
     OrderCfg c;
     HierarOrderCfg hc;
 
     double t = 0;
-    double maxCompSolSpace = 0;
-    size_t maxCompC = 0;
-    size_t maxNumNodes = 0;
-    size_t maxNumEdges = 0;
-    size_t numM1Comps = 0;
-
-    optResStats.maxNumRowsPerComp = 0;
-    optResStats.maxNumColsPerComp = 0;
-
-    for (const auto& nds : comps) {
-      if (_cfg->outputStats) {
-        size_t maxC = maxCard(nds);
-        double solSp = solutionSpaceSize(nds);
-
-        // skip trivial components
-        if (nds.size() > 2) {
-          if (maxC > maxCompC) maxCompC = maxC;
-          if (solSp > maxCompSolSpace) maxCompSolSpace = solSp;
-          if (solSp == 1) numM1Comps++;
-          if (nds.size() > maxNumNodes) maxNumNodes = nds.size();
-          if (numEdges(nds) > maxNumEdges) maxNumEdges = numEdges(nds);
-
-          LOGTO(INFO, std::cerr)
-              << " (stats) Optimizing subgraph of size " << nds.size()
-              << " with max cardinality = " << maxC
-              << " and solution space size = " << solSp;
+
+    for (size_t comp = 0; comp < comps.size(); comp++) {
+      t += compT[run][comp];
+      for (const auto& kv : compCfgs[run][comp]) {
+        for (const auto& ordering : kv.second) {
+          hc[kv.first][ordering.first] = ordering.second;
         }
       }
 
-      // this is the implementation of the single edge pruning described in the
-      // publication - simple skip such components
-      // we also skip components with only single edges
-      if (maxC > 1 && nds.size() > 2) {
-        t += optimizeComp(&g, nds, &hc, optResStats);
-      } else {
-        t += nullOpt.optimizeComp(&g, nds, &hc, 0, optResStats);
+      const auto& stats = compStats[run][comp];
+      if (stats.maxNumRowsPerComp > optResStats.maxNumRowsPerComp)
+        optResStats.maxNumRowsPerComp = stats.maxNumRowsPerComp;
+      if (stats.maxNumColsPerComp > optResStats.maxNumColsPerComp)
+        optResStats.maxNumColsPerComp = stats.maxNumColsPerComp;
+      for (const auto& m : stats.autoMethods) {
+        optResStats.autoMethods[m.first] += m.second;
       }
     }
 
-    optResStats.nonTrivialComponents = nonTrivialComponents;
-    optResStats.numCompsSolSpaceOne = numM1Comps;
-    optResStats.maxNumNodesPerComp = maxNumNodes;
-    optResStats.maxNumEdgesPerComp = maxNumEdges;
-    optResStats.maxCardPerComp = maxCompC;
-    optResStats.maxCompSolSpace = maxCompSolSpace;
+    // the configurations of this run are not needed anymore
+    compCfgs[run].clear();
 
-    if (_cfg->outputStats) {
-      LOGTO(INFO, std::cerr) << "(stats) Number of nontrivial components: "
-                             << optResStats.nonTrivialComponents;
-      LOGTO(INFO, std::cerr)
-          << "(stats) Number of nontrivial components with sol space size 1: "
-          << optResStats.numCompsSolSpaceOne;
-      LOGTO(INFO, std::cerr)
-          << "(stats) Max number of nodes of all nontrivial components: "
-          << optResStats.maxNumNodesPerComp;
-      LOGTO(INFO, std::cerr)
-          << "(stats) Max number of edges of all nontrivial components: "
-          << optResStats.maxNumEdgesPerComp;
-      LOGTO(INFO, std::cerr)
-          << "(stats) Max cardinality of all nontrivial components: "
-          << optResStats.maxCardPerComp;
-      LOGTO(INFO, std::cerr)
-          << "(stats) Max solution space size of all nontrivial components: "
-          << optResStats.maxCompSolSpace;
+    tSum += t;
+
+    if (!rescore) {
+      // a single run, edges not in hc keep their input ordering
+      rg->writePermutation(hc);
+      continue;
     }
 
     hc.writeFlatCfg(&c);
@@ -239,26 +481,34 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
       }
     }
 
-    tSum += t;
-
-    OptGraph gg(&_scorer);
-    auto ndMap = gg.build(rg);
+    if (numBundles) refineBundles(ndMap, &gg, &c);
 
     auto optCfg = getOptOrderCfg(c, ndMap, &gg);
 
-    double score = _scorer.getCrossingScore(&gg, optCfg);
-
-    if (_scorer.optimizeSep()) score += _scorer.getSeparationScore(&gg, optCfg);
+    // score, crossings and separations in a single pass over the nodes
+    double score = 0;
+    std::pair<size_t, size_t> crossings = {0, 0};
+    size_t separations = 0;
+
+    for (auto n : gg.getNds()) {
+      auto num = _scorer.getNumCrossSeps(n, optCfg);
+      crossings.first += num.first.first;
+      crossings.second += num.first.second;
+      separations += num.second;
+
+      if (!n->pl().node) continue;
+      score += num.first.first * _scorer.getCrossingPenSameSeg(n) +
+               num.first.second * _scorer.getCrossingPenDiffSeg(n);
+      if (_scorer.optimizeSep())
+        score += num.second * _scorer.getSeparationPen(n);
+    }
 
     scoreSum += score;
 
-    auto crossings = _scorer.getNumCrossings(&gg, optCfg);
     crossSumSame += crossings.first;
     crossSumDiff += crossings.second;
     crossSum += crossings.first + crossings.second;
 
-    size_t separations = _scorer.getNumSeparations(&gg, optCfg);
-
     sepSum += separations;
 
     if (score < bestScore) {
@@ -272,7 +522,7 @@ OptResStats Optimizer::optimize(RenderGraph* rg) const {
     }
   }
 
-  rg->writePermutation(bestCfg);
+  if (rescore) rg->writePermutation(bestCfg);
 
   optResStats.runs = runs;
   optResStats.avgSolveTime = tSum / (1.0 * runs);
@@ -337,8 +587,16 @@ std::vector<LinePair> Optimizer::getLinePairs(OptEdge* segment, bool unique) {
 // _____________________________________________________________________________
 bool Optimizer::crosses(OptNode* node, OptEdge* segA, OptEdge* segB,
                         PosComPair poscom) {
-  bool revA = (segA->getFrom() != node) ^ segA->pl().lnEdgParts.front().dir;
-  bool revB = (segB->getFrom() != node) ^ segB->pl().lnEdgParts.front().dir;
+  const auto& tbl = node->pl().crossTable;
+
+  bool revA, revB;
+  if (tbl.empty()) {
+    revA = (segA->getFrom() != node) ^ segA->pl().lnEdgParts.front().dir;
+    revB = (segB->getFrom() != node) ^ segB->pl().lnEdgParts.front().dir;
+  } else {
+    revA = tbl.rev[tbl.idx(segA)];
+    revB = tbl.rev[tbl.idx(segB)];
+  }
 
   size_t carA = segA->pl().getCardinality();
   size_t carB = segB->pl().getCardinality();
@@ -354,17 +612,29 @@ bool Optimizer::crosses(OptNode* node, OptEdge* segA, OptEdge* segB,
 // _____________________________________________________________________________
 bool Optimizer::crosses(OptNode* node, OptEdge* segA, EdgePair segments,
                         PosCom poscomb) {
-  bool revA = (segA->getFrom() != node) ^ segA->pl().lnEdgParts.front().dir;
+  const auto& tbl = node->pl().crossTable;
+
+  bool revA;
+  size_t pSegA, pEdgeA, pEdgeB;
+
+  if (tbl.empty()) {
+    revA = (segA->getFrom() != node) ^ segA->pl().lnEdgParts.front().dir;
+    pSegA = node->pl().circOrder(segA);
+    pEdgeA = node->pl().circOrder(segments.first);
+    pEdgeB = node->pl().circOrder(segments.second);
+  } else {
+    size_t iSegA = tbl.idx(segA);
+    revA = tbl.rev[iSegA];
+    pSegA = tbl.circ[iSegA];
+    pEdgeA = tbl.circ[tbl.idx(segments.first)];
+    pEdgeB = tbl.circ[tbl.idx(segments.second)];
+  }
 
   size_t carA = segA->pl().getCardinality();
 
   size_t pAinA = revA ? carA - 1 - poscomb.first : poscomb.first;
   size_t pBinA = revA ? carA - 1 - poscomb.second : poscomb.second;
 
-  size_t pSegA = node->pl().circOrder(segA);
-  size_t pEdgeA = node->pl().circOrder(segments.first);
-  size_t pEdgeB = node->pl().circOrder(segments.second);
-
   // make position relative to segment A
   if (pEdgeA > pSegA)
     pEdgeA = pEdgeA - pSegA;
@@ -483,7 +753,204 @@ double Optimizer::solutionSpaceSize(const std::set<OptNode*>& g) {
 // _____________________________________________________________________________
 double Optimizer::optimizeComp(OptGraph* g, const std::set<OptNode*>& cmp,
                                HierarOrderCfg* c, OptResStats& stats) const {
-  return optimizeComp(g, cmp, c, 0, stats);
+  if (!_cache && !stats.hasDeadline) return optimizeComp(g, cmp, c, 0, stats);
+
+  OrderCacheKey key;
+  OptOrderCfg cfg;
+
+  if (_cache) {
+    key = _cache->getKey(cmp, _scorer, getName());
+    if (_cache->get(key, &cfg)) {
+      LOGTO(DEBUG, std::cerr) << "Order cache hit for component " << key.hash;
+      writeHierarch(&cfg, c);
+      return 0;
+    }
+  }
+
+  // optimize into a separate configuration, so only this component is
+  // read back for the cache
+  HierarOrderCfg hc;
+  double t;
+  bool fallback = false;
+
+  if (stats.hasDeadline) {
+    fallback = optimizeCompBudget(g, cmp, &hc, stats, &t);
+  } else {
+    t = optimizeComp(g, cmp, &hc, 0, stats);
+  }
+
+  // don't cache orderings which were cut short by the time budget
+  if (_cache && !fallback && timeLeft(stats) > 0 &&
+      getOptOrderCfg(hc, cmp, &cfg)) {
+    _cache->put(key, cfg);
+  }
+
+  for (const auto& kv : hc) {
+    for (const auto& ordering : kv.second) {
+      (*c)[kv.first][ordering.first] = ordering.second;
+    }
+  }
+
+  return t;
+}
+
+// _____________________________________________________________________________
+bool Optimizer::optimizeCompBudget(OptGraph* g, const std::set<OptNode*>& cmp,
+                                   HierarOrderCfg* c, OptResStats& stats,
+                                   double* t) const {
+  T_START(1);
+
+  // the greedy ordering is cheap and always valid
+  OptOrderCfg fallback;
+  GreedyOptimizer greedy(_cfg, _scorer.getPens(), true);
+  greedy.getFlatConfig(cmp, &fallback);
+
+  auto score = [this, &cmp](const OptOrderCfg& cfg) {
+    if (_scorer.optimizeSep()) return _scorer.getTotalScore(cmp, cfg);
+    return _scorer.getCrossingScore(cmp, cfg);
+  };
+
+  if (timeLeft(stats) > 0) {
+    HierarOrderCfg hc;
+    optimizeComp(g, cmp, &hc, 0, stats);
+
+    OptOrderCfg res;
+    if (getOptOrderCfg(hc, cmp, &res) && score(res) <= score(fallback)) {
+      for (const auto& kv : hc) {
+        for (const auto& ordering : kv.second) {
+          (*c)[kv.first][ordering.first] = ordering.second;
+        }
+      }
+      *t = T_STOP(1);
+      return false;
+    }
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Using greedy ordering for component of size "
+                          << cmp.size() << " (time budget)";
+  writeHierarch(&fallback, c);
+  *t = T_STOP(1);
+  return true;
+}
+
+// _____________________________________________________________________________
+double Optimizer::timeLeft(const OptResStats& stats) {
+  if (shared::threads::cancelled()) return 0;
+  if (!stats.hasDeadline) return std::numeric_limits<double>::infinity();
+  return std::chrono::duration<double, std::milli>(
+             stats.deadline - std::chrono::steady_clock::now())
+      .count();
+}
+
+// _____________________________________________________________________________
+uint64_t Optimizer::seedFor(uint64_t seed, uint64_t i) {
+  // splitmix64 finalizer of the i-th element of the sequence
+  uint64_t z = seed + (i + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// _____________________________________________________________________________
+void Optimizer::getRefHierarch(const OptGraph& g, const RenderGraph* rg,
+                               HierarOrderCfg* hc) const {
+  RenderGraph ref(5, 1, 5);
+
+  std::ifstream in(_cfg->referencePath);
+  if (!in.good()) {
+    LOG(ERROR) << "Could not read reference " << _cfg->referencePath;
+    exit(1);
+  }
+
+  if (shared::linegraph::isBinGraph(&in)) {
+    ref.readFromBin(&in);
+  } else {
+    ref.readFromJson(&in);
+  }
+
+  OrderCfg flat;
+  getRefOrderCfg(ref, *rg, REF_MAX_DIST, &flat);
+
+  LOGTO(DEBUG, std::cerr) << "Matched " << flat.size() << " of "
+                          << rg->numEdgs() << " edge(s) to the reference";
+
+  // restrict the flat orderings to the lines of each part, see
+  // writeHierarch()
+  for (auto n : g.getNds()) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+
+      for (const auto& part : e->pl().lnEdgParts) {
+        if (part.wasCut) continue;
+        auto it = flat.find(part.lnEdg);
+        if (it == flat.end()) continue;
+
+        auto& pos = (*hc)[part.lnEdg][part.order];
+        for (size_t p : it->second) {
+          const Line* l = part.lnEdg->pl().lineOccAtPos(p).line;
+          for (const auto& lo : e->pl().getLines()) {
+            const auto& rels = lo.relatives();
+            if (std::find(rels.begin(), rels.end(), l) != rels.end()) {
+              pos.push_back(p);
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+bool Optimizer::getOptOrderCfg(const HierarOrderCfg& hc,
+                               const std::set<OptNode*>& g, OptOrderCfg* cfg) {
+  for (OptNode* n : g) {
+    for (OptEdge* e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+
+      const LnEdgPart* part = 0;
+      for (const auto& lnEdgPart : e->pl().lnEdgParts) {
+        if (lnEdgPart.wasCut) continue;
+        part = &lnEdgPart;
+        break;
+      }
+      if (!part) return false;
+
+      auto i = hc.find(part->lnEdg);
+      if (i == hc.end()) return false;
+      auto j = i->second.find(part->order);
+      if (j == i->second.end()) return false;
+
+      std::vector<size_t> pos = j->second;
+
+      // see writeHierarch()
+      if (!(part->dir ^ e->pl().lnEdgParts.front().dir)) {
+        std::reverse(pos.begin(), pos.end());
+      }
+
+      auto& order = (*cfg)[e];
+      order.clear();
+
+      for (size_t p : pos) {
+        const Line* l = part->lnEdg->pl().lineOccAtPos(p).line;
+        const OptLO* lo = 0;
+        for (const auto& optLo : e->pl().getLines()) {
+          const auto& rels = optLo.relatives();
+          if (std::find(rels.begin(), rels.end(), l) != rels.end()) {
+            lo = &optLo;
+          }
+        }
+        if (!lo) return false;
+        if (order.empty() || order.back() != lo->line) {
+          order.push_back(lo->line);
+        }
+      }
+
+      if (order.size() != e->pl().getCardinality()) return false;
+    }
+  }
+
+  return true;
 }
 
 // _____________________________________________________________________________
@@ -508,9 +975,72 @@ OptOrderCfg Optimizer::getOptOrderCfg(
   return ret;
 }
 
+// _____________________________________________________________________________
+size_t Optimizer::bundleLines(OptGraph* g) const {
+  if (_cfg->bundleShare <= 0) return 0;
+
+  TRACE_ZONE("bundle");
+  size_t ret = g->bundleLines(_cfg->bundleShare);
+  LOGTO(DEBUG, std::cerr) << "Bundled lines into " << ret << " bundle(s)";
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void Optimizer::refineBundles(const std::map<const LineNode*, OptNode*>& ndMap,
+                              OptGraph* g, OrderCfg* c) const {
+  TRACE_ZONE("refine bundles");
+  auto optCfg = getOptOrderCfg(*c, ndMap, g);
+
+  // the unbundled graph is not simplified, its components are the
+  // components of the line graph
+  HillClimbOptimizer hillc(_cfg, _scorer.getPens(), false);
+  for (const auto& nds : util::graph::Algorithm::connectedComponents(*g)) {
+    hillc.improve(nds, &optCfg);
+  }
+
+  HierarOrderCfg hc;
+  writeHierarch(&optCfg, &hc);
+
+  OrderCfg refined;
+  hc.writeFlatCfg(&refined);
+  for (const auto& o : refined) (*c)[o.first] = o.second;
+}
+
 // _____________________________________________________________________________
 std::string Optimizer::prefix(size_t depth) {
   std::stringstream ret;
   for (size_t i = 0; i < depth * 2 + 1; i++) ret << " ";
   return ret.str();
 }
+
+// _____________________________________________________________________________
+void Optimizer::writeHierarch(const OptOrderCfg* cfg,
+                              HierarOrderCfg* hc) const {
+  for (auto ep : *cfg) {
+    auto e = ep.first;
+
+    for (auto lnEdgPart : e->pl().lnEdgParts) {
+      if (lnEdgPart.wasCut) continue;
+      for (auto r : ep.second) {
+        // get the corresponding route occurance in the opt graph edge
+        // TODO: replace this as soon as a lookup function is present in OptLO
+        OptLO optRO;
+        for (auto ro : e->pl().getLines()) {
+          if (r == ro.line) optRO = ro;
+        }
+
+        for (auto rel : optRO.relatives()) {
+          // retrieve the original line pos
+          size_t p = lnEdgPart.lnEdg->pl().linePos(rel);
+          if (!(lnEdgPart.dir ^ e->pl().lnEdgParts.front().dir)) {
+            (*hc)[lnEdgPart.lnEdg][lnEdgPart.order].insert(
+                (*hc)[lnEdgPart.lnEdg][lnEdgPart.order].begin(), p);
+          } else {
+            (*hc)[lnEdgPart.lnEdg][lnEdgPart.order].push_back(p);
+          }
+        }
+      }
+    }
+  }
+}
@@ -2,11 +2,18 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
 #include "loom/config/LoomConfig.h"
 #include "loom/optim/OptGraph.h"
 #include "loom/optim/OptGraphScorer.h"
+#include "loom/optim/OrderCache.h"
 #include "shared/rendergraph/OrderCfg.h"
 #include "shared/rendergraph/RenderGraph.h"
+#include "util/Misc.h"
 
 #ifndef LOOM_OPTIM_OPTIMIZER_H_
 #define LOOM_OPTIM_OPTIMIZER_H_
@@ -30,15 +37,41 @@ struct OptResStats {
   size_t diffSegCrossings;
   size_t separations;
   double score;
+
+  // deadline for the component currently optimized, set if a global time
+  // budget is given. Optimizers which can stop early return their best
+  // solution once it has passed.
+  bool hasDeadline = false;
+  std::chrono::steady_clock::time_point deadline;
+
+  // seed for the random number generators of the component currently
+  // optimized
+  uint64_t seed = 0;
+
+  // threads the optimizer of the component currently optimized may use on
+  // its own, the share of the components optimized concurrently
+  size_t threads = 1;
+
+  // number of components the auto method picked each optimizer for, summed
+  // over all runs
+  std::map<std::string, size_t> autoMethods;
 };
 
 class Optimizer {
  public:
   Optimizer(const config::Config* cfg,
             const shared::rendergraph::Penalties& pens)
-      : _cfg(cfg), _scorer(pens){};
+      : _cfg(cfg),
+        _scorer(pens),
+        _cache(cfg->cacheDir.size()
+                   ? std::make_shared<OrderCache>(
+                         cfg->cacheDir, cfg->cacheMaxSize * 1024 * 1024)
+                   : nullptr){};
 
   virtual OptResStats optimize(shared::rendergraph::RenderGraph* rg) const;
+
+  // optimize a component, replays the ordering from the order cache if
+  // present
   double optimizeComp(OptGraph* g, const std::set<OptNode*>& cmp,
                    shared::rendergraph::HierarOrderCfg* c,
                    OptResStats& stats) const;
@@ -72,13 +105,62 @@ class Optimizer {
 
   virtual std::string getName() const = 0;
 
+  // number of ILP position variables of component g if this optimizer would
+  // solve g as an ILP, 0 otherwise. Components with small ILPs are packed
+  // into a single ILP, see config::Config::ilpBatchSize.
+  virtual size_t ilpBatchSize(const std::set<OptNode*>& g) const {
+    UNUSED(g);
+    return 0;
+  }
+
  protected:
   const config::Config* _cfg;
   const OptGraphScorer _scorer;
 
   static std::string prefix(size_t depth);
 
+  // milliseconds until the component deadline, infinity if there is none,
+  // 0 once the run was cancelled
+  static double timeLeft(const OptResStats& stats);
+
+  // the i-th seed derived from seed, for independent random streams
+  static uint64_t seedFor(uint64_t seed, uint64_t i);
+
+  void writeHierarch(const OptOrderCfg* cfg,
+                     shared::rendergraph::HierarOrderCfg* c) const;
+
+  // inverse of writeHierarch() for the edges of component g, false if the
+  // ordering of an edge cannot be recovered from c
+  static bool getOptOrderCfg(const shared::rendergraph::HierarOrderCfg& c,
+                             const std::set<OptNode*>& g, OptOrderCfg* cfg);
+
+  // the orderings of the reference result for the edges of g built from rg,
+  // in the format of writeHierarch(). Edges which cannot be matched to the
+  // reference are left out.
+  void getRefHierarch(const OptGraph& g,
+                      const shared::rendergraph::RenderGraph* rg,
+                      shared::rendergraph::HierarOrderCfg* hc) const;
+
  private:
+  std::shared_ptr<const OrderCache> _cache;
+
+  // optimize a component within its deadline, falls back to the greedy
+  // ordering if no (or a worse) ordering was found in time. Returns true if
+  // the fallback was used.
+  bool optimizeCompBudget(OptGraph* g, const std::set<OptNode*>& cmp,
+                          shared::rendergraph::HierarOrderCfg* c,
+                          OptResStats& stats, double* t) const;
+
+  // bundle the lines of g if bundling is enabled, returns the number of
+  // bundles
+  size_t bundleLines(OptGraph* g) const;
+
+  // order the lines inside the bundles of an ordering found on a bundled
+  // graph, by hill climbing on the unbundled graph g
+  void refineBundles(
+      const std::map<const shared::linegraph::LineNode*, OptNode*>& ndMap,
+      OptGraph* g, shared::rendergraph::OrderCfg* c) const;
+
   static OptOrderCfg getOptOrderCfg(
       const shared::rendergraph::OrderCfg&,
       const std::map<const shared::linegraph::LineNode*, OptNode*>& ndMap,
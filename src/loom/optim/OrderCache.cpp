@@ -0,0 +1,290 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include "loom/optim/OrderCache.h"
+#include "shared/linegraph/Line.h"
+#include "util/log/Log.h"
+
+using loom::optim::OptEdge;
+using loom::optim::OptGraph;
+using loom::optim::OptLO;
+using loom::optim::OptNode;
+using loom::optim::OptOrderCfg;
+using loom::optim::OrderCache;
+using loom::optim::OrderCacheKey;
+
+namespace {
+// _____________________________________________________________________________
+uint64_t fnv1a(const std::string& s) {
+  uint64_t h = 14695981039346656037ull;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+// _____________________________________________________________________________
+int dirCode(const OptLO* lo, const OptEdge* e) {
+  if (!lo->dir) return 0;
+  if (lo->dir == e->getFrom()->pl().node) return 1;
+  if (lo->dir == e->getTo()->pl().node) return 2;
+  return 3;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+std::vector<const OptLO*> OrderCache::sortedLines(const OptEdge* e) {
+  std::vector<const OptLO*> ret;
+  for (const auto& lo : e->pl().getLines()) ret.push_back(&lo);
+  std::sort(ret.begin(), ret.end(), [](const OptLO* a, const OptLO* b) {
+    return a->line->id() < b->line->id();
+  });
+  return ret;
+}
+
+// _____________________________________________________________________________
+OrderCacheKey OrderCache::getKey(const std::set<OptNode*>& g,
+                                 const OptGraphScorer& scorer,
+                                 const std::string& method) const {
+  OrderCacheKey ret;
+
+  // nodes, sorted by their description
+  std::vector<std::pair<std::string, OptNode*>> nds;
+  for (auto n : g) {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3) << n->pl().p.getX() << ","
+       << n->pl().p.getY() << (n->pl().node ? "" : "*") << ","
+       << scorer.getCrossingPenSameSeg(n) << ","
+       << scorer.getCrossingPenDiffSeg(n) << ","
+       << scorer.getSeparationPen(n);
+    nds.push_back({ss.str(), n});
+  }
+
+  std::sort(nds.begin(), nds.end());
+
+  std::map<const OptNode*, size_t> ndIdx;
+  for (size_t i = 0; i < nds.size(); i++) {
+    // no canonical form for indistinguishable nodes
+    if (i > 0 && nds[i].first == nds[i - 1].first) return ret;
+    ndIdx[nds[i].second] = i;
+  }
+
+  // edges, sorted by their end nodes and lines
+  std::vector<std::pair<std::string, OptEdge*>> edgs;
+  for (auto n : g) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      std::stringstream ss;
+      ss << std::setw(10) << std::setfill('0') << ndIdx[e->getFrom()] << "-"
+         << std::setw(10) << ndIdx[e->getTo()] << ","
+         << e->pl().lnEdgParts.front().dir;
+
+      const auto& lines = sortedLines(e);
+      for (size_t i = 0; i < lines.size(); i++) {
+        if (i > 0 && lines[i]->line->id() == lines[i - 1]->line->id()) {
+          return ret;
+        }
+        std::vector<std::string> rels;
+        for (auto rel : lines[i]->relatives()) rels.push_back(rel->id());
+        std::sort(rels.begin(), rels.end());
+
+        ss << "[" << lines[i]->line->id() << ":" << dirCode(lines[i], e);
+        for (const auto& rel : rels) ss << ":" << rel;
+        ss << "]";
+      }
+      edgs.push_back({ss.str(), e});
+    }
+  }
+
+  std::sort(edgs.begin(), edgs.end());
+
+  std::map<const OptEdge*, size_t> edgIdx;
+  for (size_t i = 0; i < edgs.size(); i++) {
+    if (i > 0 && edgs[i].first == edgs[i - 1].first) return ret;
+    edgIdx[edgs[i].second] = i;
+  }
+
+  std::stringstream repr;
+  const auto& pens = scorer.getPens();
+  repr << method << ";" << pens.inStatCrossPenDegTwo << ","
+       << pens.inStatSplitPenDegTwo << "," << pens.sameSegCrossPen << ","
+       << pens.diffSegCrossPen << "," << pens.splitPen << ","
+       << pens.inStatCrossPenSameSeg << "," << pens.inStatCrossPenDiffSeg << ","
+       << pens.inStatSplitPen << "," << pens.crossAdjPen << ","
+       << pens.splitAdjPen << "," << scorer.optimizeSep() << "\n";
+
+  for (const auto& n : nds) repr << n.first << "\n";
+  for (const auto& e : edgs) repr << e.first << "\n";
+
+  // circular orderings and line connections at the nodes
+  for (const auto& nd : nds) {
+    auto n = nd.second;
+    const auto& circ = n->pl().circOrdering;
+    repr << ndIdx[n] << ":";
+    for (auto e : circ) repr << edgIdx[e] << ",";
+
+    if (n->pl().node) {
+      for (auto ea : circ) {
+        for (auto eb : circ) {
+          if (ea == eb) continue;
+          repr << ";";
+          for (auto lo : sortedLines(ea)) {
+            if (!eb->pl().getLineOcc(lo->line)) continue;
+            repr << n->pl().node->pl().connOccurs(lo->line,
+                                                  OptGraph::getAdjEdg(ea, n),
+                                                  OptGraph::getAdjEdg(eb, n));
+          }
+        }
+      }
+    }
+    repr << "\n";
+  }
+
+  std::stringstream hash;
+  hash << std::hex << std::setw(16) << std::setfill('0') << fnv1a(repr.str())
+       << "-" << repr.str().size();
+
+  ret.hash = hash.str();
+  ret.edgs.resize(edgs.size());
+  for (size_t i = 0; i < edgs.size(); i++) ret.edgs[i] = edgs[i].second;
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::string OrderCache::getPath(const OrderCacheKey& key) const {
+  return _dir + "/" + key.hash + ".ord";
+}
+
+// _____________________________________________________________________________
+bool OrderCache::get(const OrderCacheKey& key, OptOrderCfg* cfg) const {
+  if (key.hash.empty()) return false;
+
+  std::string path = getPath(key);
+  std::ifstream fs(path);
+  if (!fs.good()) return false;
+
+  size_t numEdgs;
+  if (!(fs >> numEdgs) || numEdgs != key.edgs.size()) return false;
+
+  OptOrderCfg ret;
+
+  for (auto e : key.edgs) {
+    const auto& lines = sortedLines(e);
+    size_t card;
+    if (!(fs >> card) || card != lines.size()) return false;
+
+    std::vector<bool> seen(card, false);
+    auto& order = ret[e];
+
+    for (size_t p = 0; p < card; p++) {
+      size_t i;
+      if (!(fs >> i) || i >= card || seen[i]) return false;
+      seen[i] = true;
+      order.push_back(lines[i]->line);
+    }
+  }
+
+  // mark as recently used
+  utime(path.c_str(), 0);
+
+  for (auto& o : ret) (*cfg)[o.first] = o.second;
+
+  return true;
+}
+
+// _____________________________________________________________________________
+void OrderCache::put(const OrderCacheKey& key, const OptOrderCfg& cfg) const {
+  if (key.hash.empty()) return;
+
+  std::stringstream ss;
+  ss << key.edgs.size() << "\n";
+
+  for (auto e : key.edgs) {
+    auto it = cfg.find(e);
+    if (it == cfg.end()) return;
+
+    const auto& lines = sortedLines(e);
+    if (it->second.size() != lines.size()) return;
+
+    ss << lines.size();
+    for (auto l : it->second) {
+      size_t i = 0;
+      while (i < lines.size() && lines[i]->line != l) i++;
+      if (i == lines.size()) return;
+      ss << " " << i;
+    }
+    ss << "\n";
+  }
+
+  mkdir(_dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+
+  // write to a temporary file first, so concurrent readers never see
+  // partial entries
+  std::string path = getPath(key);
+  std::stringstream tmpPath;
+  tmpPath << path << ".tmp" << getpid() << "-" << &cfg;
+
+  {
+    std::ofstream fs(tmpPath.str());
+    fs << ss.str();
+    if (!fs.good()) {
+      LOGTO(WARN, std::cerr) << "Could not write order cache entry " << path;
+      std::remove(tmpPath.str().c_str());
+      return;
+    }
+  }
+
+  if (std::rename(tmpPath.str().c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.str().c_str());
+    return;
+  }
+
+  evict();
+}
+
+// _____________________________________________________________________________
+void OrderCache::evict() const {
+#pragma omp critical(loomOrderCacheEvict)
+  {
+    std::vector<std::pair<time_t, std::string>> entries;
+    size_t total = 0;
+
+    DIR* dir = opendir(_dir.c_str());
+    if (dir) {
+      struct dirent* ent;
+      while ((ent = readdir(dir))) {
+        std::string name = ent->d_name;
+        if (name.size() < 4 || name.substr(name.size() - 4) != ".ord") continue;
+        std::string path = _dir + "/" + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) continue;
+        total += st.st_size;
+        entries.push_back({st.st_mtime, path});
+      }
+      closedir(dir);
+    }
+
+    // remove least recently used entries first
+    std::sort(entries.begin(), entries.end());
+    for (const auto& ent : entries) {
+      if (total <= _maxSize) break;
+      struct stat st;
+      if (stat(ent.second.c_str(), &st) != 0) continue;
+      if (unlink(ent.second.c_str()) == 0) total -= st.st_size;
+    }
+  }
+}
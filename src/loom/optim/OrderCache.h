@@ -0,0 +1,65 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_ORDERCACHE_H_
+#define LOOM_OPTIM_ORDERCACHE_H_
+
+#include <set>
+#include <string>
+#include <vector>
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/OptGraphScorer.h"
+
+namespace loom {
+namespace optim {
+
+struct OrderCacheKey {
+  // empty if the component has no canonical form
+  std::string hash;
+
+  // the edges of the component in canonical order
+  std::vector<OptEdge*> edgs;
+};
+
+// On-disk cache of optimized line orderings of optim graph components.
+//
+// Components are addressed by a hash of a canonical description which
+// contains everything the ordering score depends on: the node positions,
+// the lines (with their directions and partner lines) on each edge, the
+// circular edge orderings and line connections at each node, the node
+// penalties and the optimization method. Pointer values are never part of
+// the description, so identical components of different runs (or of
+// different, overlapping inputs) get the same key.
+//
+// Orderings are stored as permutations of the canonically sorted lines of
+// each edge, one file per key. If the total size of the cache directory
+// exceeds the size limit after a write, the least recently used entries
+// are removed.
+class OrderCache {
+ public:
+  // maxSize in bytes
+  OrderCache(const std::string& dir, size_t maxSize)
+      : _dir(dir), _maxSize(maxSize){};
+
+  OrderCacheKey getKey(const std::set<OptNode*>& g,
+                       const OptGraphScorer& scorer,
+                       const std::string& method) const;
+
+  // false on a miss
+  bool get(const OrderCacheKey& key, OptOrderCfg* cfg) const;
+  void put(const OrderCacheKey& key, const OptOrderCfg& cfg) const;
+
+ private:
+  std::string _dir;
+  size_t _maxSize;
+
+  std::string getPath(const OrderCacheKey& key) const;
+  void evict() const;
+
+  static std::vector<const OptLO*> sortedLines(const OptEdge* e);
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_ORDERCACHE_H_
@@ -0,0 +1,84 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "loom/optim/RefOrdering.h"
+#include "util/geo/PolyLine.h"
+
+using shared::linegraph::Line;
+using shared::linegraph::LineEdge;
+using shared::rendergraph::OrderCfg;
+using shared::rendergraph::Ordering;
+using shared::rendergraph::RenderGraph;
+using util::geo::DPoint;
+
+// _____________________________________________________________________________
+void loom::optim::getRefOrderCfg(const RenderGraph& ref, const RenderGraph& g,
+                                 double maxDist, OrderCfg* cfg) {
+  for (auto nd : g.getNds()) {
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+
+      const auto& pl = e->pl().getPolyline();
+      if (pl.getLength() == 0) continue;
+
+      // the reference lines of the edge, by their position on the edge
+      std::vector<const Line*> lines;
+      for (const auto& lo : e->pl().getLines()) {
+        lines.push_back(ref.getLine(lo.line->id()));
+        if (!lines.back()) break;
+      }
+      if (lines.empty() || !lines.back()) continue;
+
+      DPoint a = pl.getPointAt(0.25).p;
+      DPoint m = pl.getPointAt(0.5).p;
+      DPoint b = pl.getPointAt(0.75).p;
+
+      std::set<LineEdge*> cands;
+      ref.getEdgGrid().get(*e->pl().getGeom(), maxDist, &cands);
+
+      const LineEdge* best = 0;
+      double bestDist = std::numeric_limits<double>::infinity();
+      bool rev = false;
+
+      for (auto r : cands) {
+        bool all = true;
+        for (auto l : lines) all = all && r->pl().hasLine(l);
+        if (!all) continue;
+
+        const auto& rpl = r->pl().getPolyline();
+        double d = util::geo::dist(m, *r->pl().getGeom());
+        if (d > maxDist || d >= bestDist) continue;
+        if (util::geo::dist(a, *r->pl().getGeom()) > maxDist) continue;
+        if (util::geo::dist(b, *r->pl().getGeom()) > maxDist) continue;
+
+        // the direction of the edge along the reference edge
+        double pa = rpl.projectOn(a).totalPos;
+        double pb = rpl.projectOn(b).totalPos;
+        if (pa == pb) continue;
+
+        best = r;
+        bestDist = d;
+        rev = pa > pb;
+      }
+
+      if (!best) continue;
+
+      Ordering& o = (*cfg)[e];
+      o.resize(lines.size());
+      for (size_t i = 0; i < o.size(); i++) o[i] = i;
+
+      std::sort(o.begin(), o.end(), [&](size_t i, size_t j) {
+        size_t pi = best->pl().linePos(lines[i]);
+        size_t pj = best->pl().linePos(lines[j]);
+        return rev ? pi > pj : pi < pj;
+      });
+    }
+  }
+}
@@ -0,0 +1,32 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_REFORDERING_H_
+#define LOOM_OPTIM_REFORDERING_H_
+
+#include "shared/rendergraph/OrderCfg.h"
+#include "shared/rendergraph/RenderGraph.h"
+
+namespace loom {
+namespace optim {
+
+// max distance between an edge and the reference edge it is matched to
+static const double REF_MAX_DIST = 50;
+
+// Line orderings of a reference loom result, typically of the full network,
+// for an input graph whose lines are a subset of the reference lines.
+//
+// Each edge of g is matched to the nearest reference edge which lies within
+// maxDist of it and carries all its lines (matched by line id). The ordering
+// of the edge is the reference ordering restricted to its lines, flipped if
+// the reference edge runs the other way. Edges without a match are not in
+// cfg.
+void getRefOrderCfg(const shared::rendergraph::RenderGraph& ref,
+                    const shared::rendergraph::RenderGraph& g, double maxDist,
+                    shared::rendergraph::OrderCfg* cfg);
+
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_REFORDERING_H_
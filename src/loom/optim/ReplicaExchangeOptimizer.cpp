@@ -0,0 +1,111 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include "loom/optim/OptGraphDeltaScorer.h"
+#include "loom/optim/ReplicaExchangeOptimizer.h"
+#include "util/log/Log.h"
+
+using loom::optim::OptGraphDeltaScorer;
+using loom::optim::ReplicaExchangeOptimizer;
+using shared::rendergraph::HierarOrderCfg;
+
+// _____________________________________________________________________________
+double ReplicaExchangeOptimizer::optimizeComp(OptGraph* og,
+                                              const std::set<OptNode*>& g,
+                                              HierarOrderCfg* hc, size_t depth,
+                                              OptResStats& stats) const {
+  T_START(1);
+  UNUSED(og);
+
+  const double T_MAX = 100.0;
+  const double T_MIN = 0.1;
+  const size_t ABORT_AFTER_UNCH = 50;
+  const size_t MAX_SWEEPS = 5000;
+
+  size_t n = std::max<size_t>(_cfg->replicas, 2);
+
+  // temperature of slot i, slot 0 is the hottest
+  std::vector<double> temps(n);
+  for (size_t i = 0; i < n; i++) {
+    temps[i] = T_MAX * std::pow(T_MIN / T_MAX, i / (n - 1.0));
+  }
+
+  std::vector<std::unique_ptr<OptGraphDeltaScorer>> reps(n);
+  std::vector<std::mt19937> rngs(n);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(_cfg->threads)
+  for (size_t i = 0; i < n; i++) {
+    OptOrderCfg start;
+    rngs[i].seed(seedFor(stats.seed, i));
+    startConfig(g, &start, &rngs[i]);
+    reps[i].reset(new OptGraphDeltaScorer(_optScorer, g,
+                                          DenseOrderCfg(g, start)));
+  }
+
+  // replica at each temperature slot
+  std::vector<size_t> at(n);
+  for (size_t i = 0; i < n; i++) at[i] = i;
+
+  std::vector<double> scores(n);
+  for (size_t i = 0; i < n; i++) scores[i] = reps[i]->getScore();
+
+  size_t bestRep =
+      std::min_element(scores.begin(), scores.end()) - scores.begin();
+  double bestScore = scores[bestRep];
+  DenseOrderCfg best = reps[bestRep]->getCfg();
+
+  std::mt19937 rng(seedFor(stats.seed, n));
+  std::uniform_real_distribution<double> unif(0, 1);
+
+  size_t sweeps = 0;
+  size_t k = 0;
+
+  while (sweeps < MAX_SWEEPS) {
+    sweeps++;
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(_cfg->threads)
+    for (size_t i = 0; i < n; i++) {
+      sweep(reps[at[i]].get(), temps[i], &rngs[at[i]]);
+      scores[at[i]] = reps[at[i]]->getScore();
+    }
+
+    for (size_t i = 0; i < n; i++) {
+      if (scores[i] < bestScore) {
+        bestScore = scores[i];
+        best = reps[i]->getCfg();
+        k = sweeps;
+      }
+    }
+
+    // exchange neighboring temperature slots, alternating between even and
+    // odd pairs
+    for (size_t i = sweeps % 2; i + 1 < n; i += 2) {
+      double ea = scores[at[i]];
+      double eb = scores[at[i + 1]];
+      double p = std::exp((1.0 / temps[i + 1] - 1.0 / temps[i]) * (eb - ea));
+      if (p >= 1 || unif(rng) < p) std::swap(at[i], at[i + 1]);
+    }
+
+    if (sweeps - k > ABORT_AFTER_UNCH) break;
+    if (timeLeft(stats) <= 0) break;
+  }
+
+  LOGTO(DEBUG, std::cerr) << prefix(depth) << "(ReplicaExchangeOptimizer) "
+                          << n << " replicas stopped after " << sweeps
+                          << " sweeps, best score " << bestScore;
+
+  // the best configuration may not be a local optimum
+  OptGraphDeltaScorer delta(_optScorer, g, best);
+  hillClimb(&delta);
+
+  OptOrderCfg cur;
+  delta.getCfg().writeOptOrderCfg(&cur);
+
+  writeHierarch(&cur, hc);
+  return T_STOP(1);
+}
@@ -0,0 +1,41 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_REPLICAEXCHANGEOPTIMIZER_H_
+#define LOOM_OPTIM_REPLICAEXCHANGEOPTIMIZER_H_
+
+#include "loom/config/LoomConfig.h"
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/Optimizer.h"
+#include "loom/optim/SimulatedAnnealingOptimizer.h"
+#include "shared/rendergraph/OrderCfg.h"
+
+namespace loom {
+namespace optim {
+
+// Replica exchange (parallel tempering) variant of simulated annealing.
+// _cfg->replicas configurations are annealed concurrently at fixed, geometric
+// spaced temperatures. After each sweep, configurations at neighboring
+// temperatures are swapped with the Metropolis probability of the exchange,
+// so good configurations migrate to the cold end while hot replicas keep
+// exploring. The best configuration seen is finally hill climbed.
+class ReplicaExchangeOptimizer : public SimulatedAnnealingOptimizer {
+ public:
+  ReplicaExchangeOptimizer(const config::Config* cfg,
+                           const shared::rendergraph::Penalties& pens,
+                           bool randomStart)
+      : SimulatedAnnealingOptimizer(cfg, pens, randomStart){};
+
+  virtual double optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
+                              shared::rendergraph::HierarOrderCfg* c,
+                              size_t depth, OptResStats& stats) const;
+
+  virtual std::string getName() const {
+    return _randomStart ? "anneal-rex-random" : "anneal-rex";
+  }
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_REPLICAEXCHANGEOPTIMIZER_H_
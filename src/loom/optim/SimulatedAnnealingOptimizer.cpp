@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <unordered_map>
 #include "loom/optim/GreedyOptimizer.h"
+#include "loom/optim/OptGraphDeltaScorer.h"
 #include "loom/optim/SimulatedAnnealingOptimizer.h"
 #include "util/log/Log.h"
 
@@ -23,72 +24,98 @@ double SimulatedAnnealingOptimizer::optimizeComp(OptGraph* og,
                                               OptResStats& stats) const {
   T_START(1);
   UNUSED(depth);
-  UNUSED(stats);
-  OptOrderCfg cur;
+  UNUSED(og);
+
+  // independent random starts, keep the best result
+  size_t starts = _randomStart ? std::max<size_t>(_cfg->multiStart, 1) : 1;
+  std::vector<OptOrderCfg> cfgs(starts);
+  std::vector<double> scores(starts);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(_cfg->threads)
+  for (size_t i = 0; i < starts; i++) {
+    std::mt19937 rng(seedFor(stats.seed, i));
+    startConfig(g, &cfgs[i], &rng);
+    scores[i] = anneal(g, &cfgs[i], stats, &rng);
+  }
 
-  // fixed order list of optim graph edges
-  std::vector<OptEdge*> edges;
+  size_t best =
+      std::min_element(scores.begin(), scores.end()) - scores.begin();
 
-  for (auto n : g)
-    for (auto e : n->getAdjList())
-      if (n == e->getFrom()) edges.push_back(e);
+  writeHierarch(&cfgs[best], hc);
+  return T_STOP(1);
+}
 
+// _____________________________________________________________________________
+void SimulatedAnnealingOptimizer::startConfig(const std::set<OptNode*>& g,
+                                              OptOrderCfg* cfg,
+                                              std::mt19937* rng) const {
   if (_randomStart) {
     // this is the starting ordering, which is random
-    initialConfig(g, &cur, false);
+    initialConfig(g, cfg, rng);
   } else {
     // take the greedy optimized ordering as a starting point
     GreedyOptimizer greedy(_cfg, _scorer.getPens(), true);
-    greedy.getFlatConfig(g, &cur);
+    greedy.getFlatConfig(g, cfg);
   }
+}
 
+// _____________________________________________________________________________
+double SimulatedAnnealingOptimizer::anneal(const std::set<OptNode*>& g,
+                                           OptOrderCfg* cfg,
+                                           const OptResStats& stats,
+                                           std::mt19937* rng) const {
   size_t iters = 0;
 
   size_t k = 0;
 
   size_t ABORT_AFTER_UNCH = 5;
 
+  OptGraphDeltaScorer delta(_optScorer, g, DenseOrderCfg(g, *cfg));
+
   while (true) {
     iters++;
 
     double temp = 1000.0 / iters;
 
-    for (size_t i = 0; i < edges.size(); i++) {
-      double oldScore = getScore(og, edges[i], cur);
-
-      for (size_t p1 = 0; p1 < cur[edges[i]].size(); p1++) {
-        for (size_t p2 = p1; p2 < cur[edges[i]].size(); p2++) {
-          // switch p1 and p2
-          auto tmp = cur[edges[i]][p1];
-          cur[edges[i]][p1] = cur[edges[i]][p2];
-          cur[edges[i]][p2] = tmp;
-
-          double s = getScore(og, edges[i], cur);
-
-          double r = rand() / (RAND_MAX + 1.0);
-          double e = exp(-(1.0 * (s - oldScore)) / temp);
-
-          if (s < oldScore) {
-            // found a better solution, keep it, update score
-            oldScore = s;
-            k = iters;
-          } else if (s != oldScore && e > r) {
-            // keep solution, despite not bringing any local gain, update score
-            oldScore = s;
-            k = iters;
-          } else {
-            // switch back
-            tmp = cur[edges[i]][p1];
-            cur[edges[i]][p1] = cur[edges[i]][p2];
-            cur[edges[i]][p2] = tmp;
-          }
+    if (sweep(&delta, temp, rng)) k = iters;
+
+    if (iters - k > ABORT_AFTER_UNCH) break;
+    if (timeLeft(stats) <= 0) break;
+  }
+
+  delta.getCfg().writeOptOrderCfg(cfg);
+
+  return delta.getScore();
+}
+
+// _____________________________________________________________________________
+bool SimulatedAnnealingOptimizer::sweep(OptGraphDeltaScorer* delta,
+                                        double temp, std::mt19937* rng) const {
+  const auto& dense = delta->getCfg();
+  std::uniform_real_distribution<double> unif(0, 1);
+  bool changed = false;
+
+  for (size_t i = 0; i < dense.numEdgs(); i++) {
+    for (size_t p1 = 0; p1 < dense.size(i); p1++) {
+      for (size_t p2 = p1 + 1; p2 < dense.size(i); p2++) {
+        // score change if p1 and p2 are switched
+        double d = delta->scoreDelta(i, p1, p2);
+
+        double r = unif(*rng);
+        double e = exp(-(1.0 * d) / temp);
+
+        if (d < 0) {
+          // found a better solution, keep it
+          delta->swap(i, p1, p2);
+          changed = true;
+        } else if (d != 0 && e > r) {
+          // keep solution, despite not bringing any local gain
+          delta->swap(i, p1, p2);
+          changed = true;
         }
       }
     }
-
-    if (iters - k > ABORT_AFTER_UNCH) break;
   }
 
-  writeHierarch(&cur, hc);
-  return T_STOP(1);
+  return changed;
 }
@@ -5,6 +5,7 @@
 #ifndef LOOM_OPTIM_SIMULATEDANNEALINGOPTIMIZER_H_
 #define LOOM_OPTIM_SIMULATEDANNEALINGOPTIMIZER_H_
 
+#include <random>
 #include "loom/config/LoomConfig.h"
 #include "loom/optim/HillClimbOptimizer.h"
 #include "loom/optim/ILPEdgeOrderOptimizer.h"
@@ -27,6 +28,23 @@ class SimulatedAnnealingOptimizer : public HillClimbOptimizer {
   virtual double optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
                            shared::rendergraph::HierarOrderCfg* c,
                            size_t depth, OptResStats& stats) const;
+
+  virtual std::string getName() const {
+    return _randomStart ? "anneal-random" : "anneal";
+  }
+
+ protected:
+  // starting ordering of g, random (drawn from rng) or greedy
+  void startConfig(const std::set<OptNode*>& g, OptOrderCfg* cfg,
+                   std::mt19937* rng) const;
+
+  // anneal a single configuration, starting at cfg, returns the final score
+  double anneal(const std::set<OptNode*>& g, OptOrderCfg* cfg,
+                const OptResStats& stats, std::mt19937* rng) const;
+
+  // one Metropolis pass over all line swaps of all edges at temperature
+  // temp, returns true if a swap was kept
+  bool sweep(OptGraphDeltaScorer* delta, double temp, std::mt19937* rng) const;
 };
 }  // namespace optim
 }  // namespace loom
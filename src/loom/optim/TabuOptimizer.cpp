@@ -0,0 +1,191 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "loom/optim/DenseOrderCfg.h"
+#include "loom/optim/GreedyOptimizer.h"
+#include "loom/optim/OptGraphDeltaScorer.h"
+#include "loom/optim/TabuOptimizer.h"
+#include "util/log/Log.h"
+
+using loom::optim::DenseOrderCfg;
+using loom::optim::OptEdge;
+using loom::optim::OptGraphDeltaScorer;
+using loom::optim::OptNode;
+using loom::optim::OptOrderCfg;
+using loom::optim::OptResStats;
+using loom::optim::TabuOptimizer;
+using shared::rendergraph::HierarOrderCfg;
+
+namespace {
+// improvements below this are rounding noise of the accumulated score
+const double TABU_EPS = 1e-9;
+
+struct TabuMove {
+  // move the block of len lines at position i to position j
+  size_t i, len, j;
+  double delta;
+};
+
+// _____________________________________________________________________________
+void scoreMoves(OptGraphDeltaScorer* delta, size_t e,
+                std::vector<TabuMove>* moves) {
+  size_t k = delta->getCfg().size(e);
+  moves->clear();
+
+  for (size_t len = 1; len <= loom::optim::TABU_MAX_BLOCK && len < k; len++) {
+    for (size_t i = 0; i + len <= k; i++) {
+      for (size_t j = 0; j + len <= k; j++) {
+        // shifting a block of len lines by d positions is the same as
+        // shifting the d lines it passes by len positions the other way
+        size_t d = i < j ? j - i : i - j;
+        if (d == 0 || d < len) continue;
+        moves->push_back({i, len, j, delta->moveDelta(e, i, len, j)});
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+template <typename F>
+void forFlippedPairs(const DenseOrderCfg& c, size_t e, const TabuMove& m,
+                     F f) {
+  // the lines of the block change their relative order to the lines it
+  // passes, and only to these
+  size_t from = m.j < m.i ? m.j : m.i + m.len;
+  size_t to = m.j < m.i ? m.i : m.j + m.len;
+  const auto* at = c.begin(e);
+  for (size_t b = m.i; b < m.i + m.len; b++) {
+    for (size_t p = from; p < to; p++) {
+      if (!f(at[b], at[p])) return;
+    }
+  }
+}
+}  // namespace
+
+// _____________________________________________________________________________
+double TabuOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
+                                   HierarOrderCfg* hc, size_t depth,
+                                   OptResStats& stats) const {
+  UNUSED(og);
+  T_START(1);
+
+  LOGTO(DEBUG, std::cerr) << prefix(depth)
+                          << "(TabuOptimizer) Optimizing component with "
+                          << g.size() << " nodes.";
+
+  // take the greedy optimized ordering as a starting point
+  OptOrderCfg cfg;
+  GreedyOptimizer greedy(_cfg, _scorer.getPens(), true);
+  greedy.getFlatConfig(g, &cfg);
+
+  OptGraphDeltaScorer delta(_optScorer, g, DenseOrderCfg(g, cfg));
+  double start = delta.getScore();
+
+  DenseOrderCfg best = delta.getCfg();
+  size_t iters = 0;
+  double score = search(&delta, stats, &best, &iters);
+
+  LOGTO(DEBUG, std::cerr) << prefix(depth) << "Improved score from " << start
+                          << " to " << score << " in " << iters
+                          << " iterations";
+
+  best.writeOptOrderCfg(&cfg);
+  writeHierarch(&cfg, hc);
+
+  return T_STOP(1);
+}
+
+// _____________________________________________________________________________
+double TabuOptimizer::search(OptGraphDeltaScorer* delta,
+                             const OptResStats& stats, DenseOrderCfg* best,
+                             size_t* iters) const {
+  const auto& c = delta->getCfg();
+  size_t numEdgs = c.numEdgs();
+
+  // edges sharing a node with each edge, including the edge itself, the
+  // scores of their moves change if the edge is moved
+  std::vector<std::vector<size_t>> nbs(numEdgs);
+  for (size_t e = 0; e < numEdgs; e++) {
+    const OptEdge* edg = c.getEdg(e);
+    for (const OptNode* n : {edg->getFrom(), edg->getTo()}) {
+      for (const OptEdge* f : n->getAdjList()) nbs[e].push_back(c.getEdgIdx(f));
+    }
+    std::sort(nbs[e].begin(), nbs[e].end());
+    nbs[e].erase(std::unique(nbs[e].begin(), nbs[e].end()), nbs[e].end());
+  }
+
+  // iteration until which the relative order of a pair of local line ids
+  // of an edge must not be changed back, by a * size + b with a < b
+  std::vector<std::vector<size_t>> tabu(numEdgs);
+  for (size_t e = 0; e < numEdgs; e++) tabu[e].resize(c.size(e) * c.size(e));
+
+  std::vector<std::vector<TabuMove>> moves(numEdgs);
+  std::vector<bool> dirty(numEdgs, true);
+
+  double cur = delta->getScore();
+  double bestScore = cur;
+  *best = c;
+
+  size_t sinceBest = 0;
+  size_t it = 0;
+
+  for (; sinceBest < std::max<size_t>(_cfg->tabuIters, 1); it++) {
+    if (bestScore == 0) break;
+    if (it % 100 == 0 && timeLeft(stats) <= 0) break;
+
+    for (size_t e = 0; e < numEdgs; e++) {
+      if (!dirty[e]) continue;
+      scoreMoves(delta, e, &moves[e]);
+      dirty[e] = false;
+    }
+
+    // the best move which is not tabu, or leads to a new best score
+    size_t bestE = numEdgs;
+    const TabuMove* bestM = 0;
+    for (size_t e = 0; e < numEdgs; e++) {
+      size_t k = c.size(e);
+      for (const auto& m : moves[e]) {
+        if (bestM && m.delta >= bestM->delta) continue;
+
+        bool isTabu = false;
+        forFlippedPairs(c, e, m, [&](size_t a, size_t b) {
+          isTabu = tabu[e][std::min(a, b) * k + std::max(a, b)] > it;
+          return !isTabu;
+        });
+
+        if (isTabu && cur + m.delta >= bestScore - TABU_EPS) continue;
+
+        bestE = e;
+        bestM = &m;
+      }
+    }
+
+    if (!bestM) break;
+
+    size_t k = c.size(bestE);
+    forFlippedPairs(c, bestE, *bestM, [&](size_t a, size_t b) {
+      tabu[bestE][std::min(a, b) * k + std::max(a, b)] =
+          it + 1 + _cfg->tabuTenure;
+      return true;
+    });
+
+    cur += bestM->delta;
+    delta->move(bestE, bestM->i, bestM->len, bestM->j);
+    for (size_t f : nbs[bestE]) dirty[f] = true;
+
+    if (cur < bestScore - TABU_EPS) {
+      bestScore = cur;
+      *best = c;
+      sinceBest = 0;
+    } else {
+      sinceBest++;
+    }
+  }
+
+  *iters = it;
+  return bestScore;
+}
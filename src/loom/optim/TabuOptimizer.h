@@ -0,0 +1,55 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_TABUOPTIMIZER_H_
+#define LOOM_OPTIM_TABUOPTIMIZER_H_
+
+#include <set>
+#include <string>
+#include "loom/config/LoomConfig.h"
+#include "loom/optim/ExhaustiveOptimizer.h"
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/OptGraphDeltaScorer.h"
+#include "loom/optim/Optimizer.h"
+#include "shared/rendergraph/OrderCfg.h"
+
+namespace loom {
+namespace optim {
+
+// longest block of lines moved at once
+static const size_t TABU_MAX_BLOCK = 3;
+
+// Tabu search, starting at the greedy ordering. Each iteration applies the
+// best move of all edges, even if it makes the score worse. A move shifts a
+// block of up to TABU_MAX_BLOCK lines of an edge to another position, which
+// includes adjacent swaps. Moves that undo the relative order of a line
+// pair changed during the last _cfg->tabuTenure iterations are tabu, unless
+// they lead to a new best score. The search stops after _cfg->tabuIters
+// iterations without improvement.
+//
+// The scores of all moves are cached, after a move only the moves of the
+// edges sharing a node with the moved edge are scored again.
+class TabuOptimizer : public ExhaustiveOptimizer {
+ public:
+  TabuOptimizer(const config::Config* cfg,
+                const shared::rendergraph::Penalties& pens)
+      : ExhaustiveOptimizer(cfg, pens){};
+
+  virtual double optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
+                              shared::rendergraph::HierarOrderCfg* c,
+                              size_t depth, OptResStats& stats) const;
+
+  virtual std::string getName() const { return "tabu"; }
+
+ protected:
+  // tabu search starting at the configuration of delta, the best
+  // configuration found is written to best. Returns its score, the number
+  // of iterations is written to iters.
+  double search(OptGraphDeltaScorer* delta, const OptResStats& stats,
+                DenseOrderCfg* best, size_t* iters) const;
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_TABUOPTIMIZER_H_
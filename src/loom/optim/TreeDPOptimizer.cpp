@@ -0,0 +1,181 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "loom/optim/TreeDPOptimizer.h"
+#include "shared/linegraph/Line.h"
+#include "util/log/Log.h"
+
+using loom::optim::OptEdge;
+using loom::optim::OptNode;
+using loom::optim::OptOrderCfg;
+using loom::optim::TreeDPOptimizer;
+using shared::linegraph::Line;
+using shared::rendergraph::HierarOrderCfg;
+
+// _____________________________________________________________________________
+double TreeDPOptimizer::optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
+                                     HierarOrderCfg* hc, size_t depth,
+                                     OptResStats& stats) const {
+  if (!canOptimize(g)) {
+    LOGTO(DEBUG, std::cerr) << prefix(depth)
+                            << "(TreeDPOptimizer) Component is not a tree or "
+                               "too expensive, using branch-and-bound.";
+    return _bnbOpt.optimizeComp(og, g, hc, depth + 1, stats);
+  }
+
+  LOGTO(DEBUG, std::cerr) << prefix(depth)
+                          << "(TreeDPOptimizer) Optimizing tree with "
+                          << g.size() << " nodes, DP cost " << dpCost(g);
+
+  T_START(1);
+
+  // root the tree, nodes in BFS order together with the edge to their parent
+  OptNode* root = *g.begin();
+  std::vector<OptNode*> order{root};
+  std::unordered_map<const OptNode*, OptEdge*> parent{{root, 0}};
+
+  for (size_t i = 0; i < order.size(); i++) {
+    for (auto e : order[i]->getAdjList()) {
+      auto o = e->getOtherNd(order[i]);
+      if (parent.count(o)) continue;
+      parent[o] = e;
+      order.push_back(o);
+    }
+  }
+
+  // all orderings of each edge
+  std::unordered_map<const OptEdge*, std::vector<std::vector<const Line*>>>
+      perms;
+
+  for (auto n : order) {
+    auto e = parent[n];
+    if (!e) continue;
+    std::vector<const Line*> o;
+    for (const auto& lo : e->pl().getLines()) o.push_back(lo.line);
+    std::sort(o.begin(), o.end());
+    do {
+      perms[e].push_back(o);
+    } while (std::next_permutation(o.begin(), o.end()));
+  }
+
+  // best score of the subtree below an edge, for each ordering of the edge
+  std::unordered_map<const OptEdge*, std::vector<double>> score;
+
+  // for each node and each ordering of its parent edge, the orderings of its
+  // child edges achieving the best subtree score
+  std::unordered_map<const OptNode*, std::vector<std::vector<size_t>>> choice;
+
+  double bestScore = 0;
+  OptOrderCfg cfg;
+
+  for (size_t i = order.size(); i > 0; i--) {
+    auto n = order[i - 1];
+    auto pe = parent[n];
+
+    std::vector<OptEdge*> chld;
+    for (auto e : n->getAdjList()) {
+      if (e != pe) chld.push_back(e);
+    }
+
+    size_t numP = pe ? perms[pe].size() : 1;
+    std::vector<double> best(numP, std::numeric_limits<double>::infinity());
+    std::vector<std::vector<size_t>> bestC(numP);
+    std::vector<size_t> idx(chld.size());
+
+    for (size_t p = 0; p < numP; p++) {
+      if (pe) cfg[pe] = perms[pe][p];
+      for (size_t j = 0; j < chld.size(); j++) {
+        idx[j] = 0;
+        cfg[chld[j]] = perms[chld[j]][0];
+      }
+
+      while (true) {
+        double sub = 0;
+        for (size_t j = 0; j < chld.size(); j++) sub += score[chld[j]][idx[j]];
+
+        // node scores are non-negative, so the combination cannot be better
+        // if its subtrees alone are not
+        if (sub < best[p]) {
+          double s = sub + _optScorer.getTotalScore(n, cfg);
+          if (s < best[p]) {
+            best[p] = s;
+            bestC[p] = idx;
+          }
+        }
+
+        // next combination of child orderings
+        size_t j = 0;
+        for (; j < chld.size(); j++) {
+          if (++idx[j] < perms[chld[j]].size()) {
+            cfg[chld[j]] = perms[chld[j]][idx[j]];
+            break;
+          }
+          idx[j] = 0;
+          cfg[chld[j]] = perms[chld[j]][0];
+        }
+        if (j == chld.size()) break;
+      }
+    }
+
+    if (pe) {
+      score[pe] = best;
+    } else {
+      bestScore = best[0];
+    }
+    choice[n] = bestC;
+  }
+
+  // top-down reconstruction of the best orderings
+  OptOrderCfg res;
+  std::unordered_map<const OptEdge*, size_t> sel;
+
+  for (auto n : order) {
+    auto pe = parent[n];
+    const auto& c = choice[n][pe ? sel[pe] : 0];
+    size_t j = 0;
+    for (auto e : n->getAdjList()) {
+      if (e == pe) continue;
+      sel[e] = c[j];
+      res[e] = perms[e][c[j]];
+      j++;
+    }
+  }
+
+  LOGTO(DEBUG, std::cerr) << prefix(depth) << "Found optimal score "
+                          << bestScore;
+
+  writeHierarch(&res, hc);
+
+  return T_STOP(1);
+}
+
+// _____________________________________________________________________________
+bool TreeDPOptimizer::canOptimize(const std::set<OptNode*>& g) const {
+  return isTree(g) && dpCost(g) <= _maxCost;
+}
+
+// _____________________________________________________________________________
+bool TreeDPOptimizer::isTree(const std::set<OptNode*>& g) {
+  return g.size() && numEdges(g) == g.size() - 1;
+}
+
+// _____________________________________________________________________________
+double TreeDPOptimizer::dpCost(const std::set<OptNode*>& g) {
+  // independent of the root, each node enumerates the orderings of all its
+  // adjacent edges
+  double ret = 0;
+  for (const auto* n : g) {
+    double cur = 1;
+    for (const auto* e : n->getAdjList()) {
+      for (size_t i = 2; i <= e->pl().getCardinality(); i++) cur *= i;
+    }
+    ret += cur;
+  }
+  return ret;
+}
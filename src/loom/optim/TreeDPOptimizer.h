@@ -0,0 +1,59 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_OPTIM_TREEDPOPTIMIZER_H_
+#define LOOM_OPTIM_TREEDPOPTIMIZER_H_
+
+#include "loom/config/LoomConfig.h"
+#include "loom/optim/BranchBoundOptimizer.h"
+#include "loom/optim/OptGraph.h"
+#include "loom/optim/OptGraphScorer.h"
+#include "loom/optim/Optimizer.h"
+#include "shared/rendergraph/OrderCfg.h"
+
+namespace loom {
+namespace optim {
+
+// Exact optimizer for acyclic components. The tree is rooted at an arbitrary
+// node and processed bottom-up: for each node and each ordering of the edge
+// to its parent, the best orderings of the edges to its children follow from
+// the score of the node itself and the best subtree scores of the children,
+// which are already known. Each node enumerates the orderings of all its
+// adjacent edges, see dpCost().
+//
+// Components which are not trees or for which the DP would be too expensive
+// are optimized with branch-and-bound instead.
+class TreeDPOptimizer : public Optimizer {
+ public:
+  TreeDPOptimizer(const config::Config* cfg,
+                  const shared::rendergraph::Penalties& pens)
+      : Optimizer(cfg, pens),
+        _optScorer(pens),
+        _bnbOpt(cfg, pens),
+        _maxCost(1000000){};
+
+  virtual double optimizeComp(OptGraph* og, const std::set<OptNode*>& g,
+                              shared::rendergraph::HierarOrderCfg* c,
+                              size_t depth, OptResStats& stats) const;
+
+  virtual std::string getName() const { return "tree-dp"; }
+
+  // true if g can be optimized by the DP within the cost limit
+  bool canOptimize(const std::set<OptNode*>& g) const;
+
+  // true if the (connected) component g has no cycles
+  static bool isTree(const std::set<OptNode*>& g);
+
+  // number of node scorings the DP over component g needs
+  static double dpCost(const std::set<OptNode*>& g);
+
+ private:
+  OptGraphScorer _optScorer;
+  const BranchBoundOptimizer _bnbOpt;
+  double _maxCost;
+};
+}  // namespace optim
+}  // namespace loom
+
+#endif  // LOOM_OPTIM_TREEDPOPTIMIZER_H_
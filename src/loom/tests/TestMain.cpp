@@ -5,9 +5,15 @@
 #include <vector>
 
 #include "loom/config/LoomConfig.h"
+#include "loom/optim/AutoOptimizer.h"
+#include "loom/optim/BranchBoundOptimizer.h"
 #include "loom/optim/CombOptimizer.h"
+#include "loom/optim/OptGraphDeltaScorer.h"
+#include "loom/optim/RefOrdering.h"
+#include "loom/optim/TreeDPOptimizer.h"
 #include "shared/optim/ILPSolvProv.h"
 #include "shared/rendergraph/RenderGraph.h"
+#include "util/graph/Algorithm.h"
 
 struct FileTest {
   std::string fname;
@@ -427,6 +433,8 @@ int main(int argc, char** argv) {
   baseCfg.untangleGraph = false;
   baseCfg.pruneGraph = false;
   baseCfg.optimRuns = 1;
+  // the tests check the scores of the results
+  baseCfg.writeStats = true;
 
   shared::rendergraph::Penalties pens{1, 0, 1, 1, 0, 1, 1, 0, false, false};
 
@@ -442,16 +450,29 @@ int main(int argc, char** argv) {
   configs.push_back(baseCfg);
 
   for (const auto& cfg : configs) {
+    // the exhaustive search of single components is split over the threads
+    loom::config::Config parCfg = cfg;
+    parCfg.threads = 4;
+
     loom::optim::ExhaustiveOptimizer exhausOptim(&cfg, pens);
+    loom::optim::ExhaustiveOptimizer exhausParOptim(&parCfg, pens);
+    loom::optim::BranchBoundOptimizer bnbOptim(&cfg, pens);
+    loom::optim::TreeDPOptimizer treeOptim(&cfg, pens);
     loom::optim::ILPOptimizer ilpOptim(&cfg, pens);
     loom::optim::ILPEdgeOrderOptimizer ilpImprOptim(&cfg, pens);
     loom::optim::CombOptimizer combOptim(&cfg, pens, true);
+    // without a time limit, every component is solved exactly
+    loom::optim::AutoOptimizer autoOptim(&cfg, pens, 1e12);
 
     std::vector<loom::optim::Optimizer*> optimizers;
     optimizers.push_back(&exhausOptim);
+    optimizers.push_back(&exhausParOptim);
+    optimizers.push_back(&bnbOptim);
+    optimizers.push_back(&treeOptim);
     optimizers.push_back(&ilpOptim);
     optimizers.push_back(&ilpImprOptim);
     optimizers.push_back(&combOptim);
+    optimizers.push_back(&autoOptim);
 
     for (auto optim : optimizers) {
       for (const auto& test : fileTests) {
@@ -466,6 +487,10 @@ int main(int argc, char** argv) {
         TEST(g.numNds(true), ==, test.numTopoNds);
 
         if (optim == &exhausOptim && g.searchSpaceSize() > 50000) continue;
+        if (optim == &exhausParOptim && g.searchSpaceSize() > 200000) continue;
+        if (optim == &bnbOptim && g.searchSpaceSize() > 1000000) continue;
+        if (optim == &treeOptim && g.searchSpaceSize() > 1000000) continue;
+        if (optim == &autoOptim && g.searchSpaceSize() > 1000000) continue;
         if (optim == &ilpOptim && g.searchSpaceSize() > 500000) continue;
         if (optim == &ilpImprOptim && g.searchSpaceSize() > 1e+50) continue;
 
@@ -759,4 +784,139 @@ int main(int argc, char** argv) {
       }
     }
   }
+
+  // delta scoring
+  {
+    shared::rendergraph::Penalties pensLoc{1, 2, 3, 4, 5, 6, 7, 8, true, true};
+    loom::optim::OptGraphScorer scorer(pensLoc);
+
+    std::vector<std::string> fnames;
+    for (const auto& test : fileTests) fnames.push_back(test.fname);
+    fnames.push_back("../src/loom/tests/datasets/freiburg-tram.json");
+
+    for (const auto& fname : fnames) {
+      shared::rendergraph::RenderGraph rg(5, 1, 5);
+
+      std::ifstream input;
+      input.open(fname);
+      rg.readFromJson(&input, true);
+
+      loom::optim::OptGraph og(&scorer);
+      og.build(&rg);
+
+      for (const auto& comp :
+           util::graph::Algorithm::connectedComponents(og)) {
+        loom::optim::OptOrderCfg cfg;
+        for (auto n : comp) {
+          for (auto e : n->getAdjList()) {
+            if (e->getFrom() != n) continue;
+            for (const auto& lo : e->pl().getLines()) cfg[e].push_back(lo.line);
+          }
+        }
+
+        loom::optim::OptGraphDeltaScorer delta(
+            scorer, comp, loom::optim::DenseOrderCfg(comp, cfg));
+        TEST(fabs(delta.getScore() - scorer.getTotalScore(comp, cfg)), <,
+             0.0001);
+
+        const auto& dense = delta.getCfg();
+
+        for (size_t e = 0; e < dense.numEdgs(); e++) {
+          for (size_t p1 = 0; p1 < dense.size(e); p1++) {
+            for (size_t p2 = p1 + 1; p2 < dense.size(e); p2++) {
+              double before = delta.getScore();
+              double d = delta.scoreDelta(e, p1, p2);
+
+              // apply every other swap, to also check the updates
+              if ((p1 + p2) % 2) {
+                delta.swap(e, p1, p2);
+                dense.writeOptOrderCfg(&cfg);
+                TEST(fabs(scorer.getTotalScore(comp, cfg) - before - d), <,
+                     0.0001);
+                TEST(fabs(delta.getScore() - scorer.getTotalScore(comp, cfg)),
+                     <, 0.0001);
+              } else {
+                auto swapped = dense;
+                std::swap(swapped.begin(e)[p1], swapped.begin(e)[p2]);
+                swapped.writeOptOrderCfg(&cfg);
+                TEST(fabs(scorer.getTotalScore(comp, cfg) - before - d), <,
+                     0.0001);
+              }
+            }
+          }
+
+          // the next permutation must also be scored correctly
+          delta.nextPermutation(e);
+          dense.writeOptOrderCfg(&cfg);
+          TEST(fabs(delta.getScore() - scorer.getTotalScore(comp, cfg)), <,
+               0.0001);
+
+          delta.prevPermutation(e);
+          dense.writeOptOrderCfg(&cfg);
+          TEST(fabs(delta.getScore() - scorer.getTotalScore(comp, cfg)), <,
+               0.0001);
+
+          // block moves of up to 3 lines
+          for (size_t len = 1; len <= 3 && len < dense.size(e); len++) {
+            for (size_t i = 0; i + len <= dense.size(e); i++) {
+              for (size_t j = 0; j + len <= dense.size(e); j++) {
+                double before = delta.getScore();
+                double d = delta.moveDelta(e, i, len, j);
+                delta.move(e, i, len, j);
+                dense.writeOptOrderCfg(&cfg);
+                TEST(fabs(scorer.getTotalScore(comp, cfg) - before - d), <,
+                     0.0001);
+                TEST(fabs(delta.getScore() - scorer.getTotalScore(comp, cfg)),
+                     <, 0.0001);
+              }
+            }
+          }
+        }
+      }
+
+      // the precomputed crossing tables must not change any score
+      loom::optim::OptOrderCfg cfg;
+      for (auto n : og.getNds()) {
+        for (auto e : n->getAdjList()) {
+          if (e->getFrom() != n) continue;
+          for (const auto& lo : e->pl().getLines()) cfg[e].push_back(lo.line);
+        }
+      }
+
+      auto cross = scorer.getNumCrossings(&og, cfg);
+      size_t seps = scorer.getNumSeparations(&og, cfg);
+
+      og.buildCrossTables();
+
+      TEST(scorer.getNumCrossings(&og, cfg).first, ==, cross.first);
+      TEST(scorer.getNumCrossings(&og, cfg).second, ==, cross.second);
+      TEST(scorer.getNumSeparations(&og, cfg), ==, seps);
+    }
+  }
+
+  // reference orderings
+  {
+    std::string fname = "../src/loom/tests/datasets/freiburg-tram.json";
+    shared::rendergraph::RenderGraph ref(5, 1, 5), g(5, 1, 5);
+
+    std::ifstream input;
+    input.open(fname);
+    ref.readFromJson(&input, true);
+    input.close();
+    input.open(fname);
+    g.readFromJson(&input, true);
+
+    shared::rendergraph::OrderCfg cfg;
+    loom::optim::getRefOrderCfg(ref, g, loom::optim::REF_MAX_DIST, &cfg);
+
+    TEST(cfg.size(), >, 0);
+
+    // against itself, every edge keeps its ordering
+    for (const auto& kv : cfg) {
+      TEST(kv.second.size(), ==, kv.first->pl().getLines().size());
+      for (size_t i = 0; i < kv.second.size(); i++) {
+        TEST(kv.second[i], ==, i);
+      }
+    }
+  }
 }
@@ -0,0 +1,171 @@
+// Copyright 2023
+// University of Freiburg - Chair of Algorithms and Datastructures
+// Author: Patrick Brosi
+
+#include <getopt.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtfs2graph/Gtfs2Graph.h"
+#include "loom/Loom.h"
+#include "magga/Pipeline.h"
+#include "magga/config/ConfigReader.h"
+#include "magga/config/MaggaConfig.h"
+#include "magga/server/MapServer.h"
+#include "octi/Octi.h"
+#include "topo/Topo.h"
+#include "transitmap/TransitMap.h"
+#include "util/Misc.h"
+#include "util/log/Log.h"
+
+using magga::runStage;
+using magga::stageArgs;
+
+namespace {
+// _____________________________________________________________________________
+void runOrExit(const std::string& name, const std::string& args,
+               const std::vector<std::string>& forced,
+               const magga::Stage& stage) {
+  int ret = runStage(name, args, forced, stage);
+  if (ret != 0) exit(ret);
+}
+
+// _____________________________________________________________________________
+void openOutput(const std::string& path, std::ofstream* out) {
+  out->open(path);
+  if (!out->good()) {
+    LOG(ERROR) << "Could not open " << path;
+    exit(1);
+  }
+}
+
+// _____________________________________________________________________________
+void replaceOutput(const std::string& tmp, const std::string& path) {
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    LOG(ERROR) << "Could not write " << path;
+    exit(1);
+  }
+}
+
+// _____________________________________________________________________________
+void writeMaps(const magga::config::Config& cfg, const std::string& gtfsGraph,
+               bool preview) {
+  // intermediate graphs are handed over in memory, in the binary graph
+  // format
+  const std::vector<std::string> BIN = {"--format", "bin"};
+
+  std::stringstream loomGraph;
+
+  {
+    std::stringstream in(gtfsGraph), topoGraph;
+
+    runOrExit("topo", stageArgs("topo", cfg.topoArgs, preview), BIN,
+              [&](int c, char** v) {
+                return topo::run(c, v, &in, &topoGraph);
+              });
+
+    runOrExit("loom", stageArgs("loom", cfg.loomArgs, preview), BIN,
+              [&](int c, char** v) {
+                return loom::run(c, v, &topoGraph, &loomGraph);
+              });
+  }
+
+  const auto tmArgs = stageArgs("transitmap", cfg.transitmapArgs, preview);
+
+  // the loom result is used for both the geographic and the schematic map.
+  // Maps are written to a temporary file first, so a map written before (by
+  // a preview) is replaced at once
+
+  if (!cfg.noGeo) {
+    const std::string path = cfg.outputPrefix + "-geo.svg";
+    std::ofstream out;
+    openOutput(path + ".tmp", &out);
+
+    loomGraph.clear();
+    loomGraph.seekg(0);
+    runOrExit("transitmap", tmArgs, {}, [&](int c, char** v) {
+      return transitmapper::run(c, v, &loomGraph, &out);
+    });
+
+    out.close();
+    replaceOutput(path + ".tmp", path);
+  }
+
+  if (!cfg.noSchem) {
+    std::stringstream octiGraph;
+
+    loomGraph.clear();
+    loomGraph.seekg(0);
+    runOrExit("octi", stageArgs("octi", cfg.octiArgs, preview), BIN,
+              [&](int c, char** v) {
+                return octi::run(c, v, &loomGraph, &octiGraph);
+              });
+
+    const std::string path = cfg.outputPrefix + "-schem.svg";
+    std::ofstream out;
+    openOutput(path + ".tmp", &out);
+
+    runOrExit("transitmap", tmArgs, {}, [&](int c, char** v) {
+      return transitmapper::run(c, v, &octiGraph, &out);
+    });
+
+    out.close();
+    replaceOutput(path + ".tmp", path);
+  }
+}
+}  // namespace
+
+// _____________________________________________________________________________
+int main(int argc, char** argv) {
+  // disable output buffering for standard output
+  setbuf(stdout, NULL);
+
+  // initialize randomness
+  srand(time(NULL) + rand());
+
+  magga::config::Config cfg;
+
+  magga::config::ConfigReader cr;
+  cr.read(&cfg, argc, argv);
+
+  std::stringstream gtfsGraph;
+
+  runOrExit("gtfs2graph", cfg.gtfs2graphArgs,
+            {"--format", "bin", cfg.inputFeedPath}, [&](int c, char** v) {
+              return gtfs2graph::run(c, v, &gtfsGraph);
+            });
+
+  if (!cfg.serverSocket.empty()) {
+    // keep the topo graph resident and render maps on request, topo is
+    // only run once and never in preview mode
+    std::stringstream topoGraph;
+    runOrExit("topo", cfg.topoArgs, {"--format", "bin"}, [&](int c, char** v) {
+      return topo::run(c, v, &gtfsGraph, &topoGraph);
+    });
+
+    gtfsGraph.str("");
+
+    magga::server::MapServer server(&cfg, &topoGraph);
+    return server.run(cfg.serverSocket);
+  }
+
+  const std::string gtfs = gtfsGraph.str();
+  gtfsGraph.str("");
+
+  if (cfg.preview) {
+    T_START(preview);
+    writeMaps(cfg, gtfs, true);
+    LOG(INFO) << "Wrote preview maps in " << T_STOP(preview) << "ms";
+  }
+
+  if (!cfg.preview || cfg.progressive) writeMaps(cfg, gtfs, false);
+
+  return 0;
+}
@@ -0,0 +1,69 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <getopt.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "magga/Pipeline.h"
+#include "util/Misc.h"
+#include "util/log/Log.h"
+
+namespace {
+// a single collapse iteration on coarse samples, a greedy line ordering, a
+// coarse octilinear grid without local search and no labels
+const std::map<std::string, std::string> PREVIEW_ARGS = {
+    {"topo", "--collapse-iters 1 --sample-dist 25 --no-infer-restrs"},
+    {"loom", "-m greedy"},
+    {"octi", "-g 200% --loc-search-max-iters 0"},
+    {"transitmap", "--no-labels"}};
+
+// _____________________________________________________________________________
+std::vector<std::string> splitArgs(const std::string& str) {
+  std::vector<std::string> ret;
+  std::stringstream ss(str);
+  std::string arg;
+  while (ss >> arg) ret.push_back(arg);
+  return ret;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+int magga::runStage(const std::string& name, const std::string& args,
+                    const std::vector<std::string>& forced,
+                    const Stage& stage) {
+  std::vector<std::string> strs{name};
+  for (const auto& arg : splitArgs(args)) strs.push_back(arg);
+
+  // forced arguments come last, so they win over the user arguments
+  strs.insert(strs.end(), forced.begin(), forced.end());
+
+  std::vector<char*> argv;
+  for (auto& s : strs) argv.push_back(&s[0]);
+  argv.push_back(0);
+
+  // each stage parses its own arguments, restart getopt
+  optind = 0;
+
+  LOGTO(DEBUG, std::cerr) << "Running " << name << "...";
+  T_START(stage);
+  int ret = stage(argv.size() - 1, argv.data());
+  LOGTO(DEBUG, std::cerr) << "Done. (" << T_STOP(stage) << "ms)";
+
+  if (ret != 0) LOG(ERROR) << name << " failed";
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::string magga::stageArgs(const std::string& name, const std::string& args,
+                             bool preview) {
+  if (!preview) return args;
+  auto it = PREVIEW_ARGS.find(name);
+  if (it == PREVIEW_ARGS.end()) return args;
+  return it->second + " " + args;
+}
@@ -0,0 +1,28 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef MAGGA_PIPELINE_H_
+#define MAGGA_PIPELINE_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace magga {
+
+typedef std::function<int(int, char**)> Stage;
+
+// run a single tool with the given (space separated) user arguments, followed
+// by the forced arguments. Returns the return value of the tool.
+int runStage(const std::string& name, const std::string& args,
+             const std::vector<std::string>& forced, const Stage& stage);
+
+// the user arguments of a stage. In preview mode they are preceded by
+// arguments trading quality for latency, which the user arguments override
+std::string stageArgs(const std::string& name, const std::string& args,
+                      bool preview);
+
+}  // namespace magga
+
+#endif  // MAGGA_PIPELINE_H_
@@ -0,0 +1,163 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <getopt.h>
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "magga/_config.h"
+#include "magga/config/ConfigReader.h"
+
+using magga::config::ConfigReader;
+
+static const char* YEAR = &__DATE__[7];
+static const char* COPY =
+    "University of Freiburg - Chair of Algorithms and Data Structures";
+static const char* AUTHORS = "Patrick Brosi <brosi@informatik.uni-freiburg.de>";
+
+// _____________________________________________________________________________
+ConfigReader::ConfigReader() {}
+
+// _____________________________________________________________________________
+void ConfigReader::help(const char* bin) const {
+  std::cout << std::setfill(' ') << std::left << "magga (part of LOOM) "
+            << VERSION_FULL << "\n(built " << __DATE__ << " " << __TIME__ << ")"
+            << "\n\n(C) 2017-" << YEAR << " " << COPY << "\n"
+            << "Authors: " << AUTHORS << "\n\n"
+            << "Usage: " << bin << " <GTFS FEED>\n\n"
+            << "Runs gtfs2graph, topo, loom, octi and transitmap in a single\n"
+            << "process and writes a geographic and a schematic map.\n\n"
+            << "Allowed options:\n\n"
+            << "General:\n"
+            << std::setw(36) << "  -v [ --version ]"
+            << "print version\n"
+            << std::setw(36) << "  -h [ --help ]"
+            << "show this help message\n"
+            << std::setw(36) << "  -o [ --output-prefix ] arg (=map)"
+            << "write maps to <arg>-geo.svg, <arg>-schem.svg\n"
+            << std::setw(36) << "  --no-geo"
+            << "don't write the geographic map\n"
+            << std::setw(36) << "  --no-schem"
+            << "don't write the schematic map\n"
+            << std::setw(36) << "  --preview"
+            << "fast preview maps at a lower quality\n"
+            << std::setw(36) << "  --progressive"
+            << "write preview maps, then replace them by the\n"
+            << std::setw(36) << " " << "exact maps\n"
+            << std::setw(36) << "  --server arg"
+            << "serve maps on UNIX socket <arg>\n"
+            << std::setw(36) << "  -t [ --threads ] arg (=0)"
+            << "thread budget passed to every stage\n"
+            << "Stages:\n"
+            << std::setw(36) << "  --gtfs2graph-args arg"
+            << "arguments passed to gtfs2graph\n"
+            << std::setw(36) << "  --topo-args arg"
+            << "arguments passed to topo\n"
+            << std::setw(36) << "  --loom-args arg"
+            << "arguments passed to loom\n"
+            << std::setw(36) << "  --octi-args arg"
+            << "arguments passed to octi\n"
+            << std::setw(36) << "  --transitmap-args arg"
+            << "arguments passed to transitmap\n";
+}
+
+// _____________________________________________________________________________
+void ConfigReader::read(Config* cfg, int argc, char** argv) const {
+  struct option ops[] = {{"version", no_argument, 0, 'v'},
+                         {"help", no_argument, 0, 'h'},
+                         {"output-prefix", required_argument, 0, 'o'},
+                         {"no-geo", no_argument, 0, 1},
+                         {"no-schem", no_argument, 0, 2},
+                         {"gtfs2graph-args", required_argument, 0, 3},
+                         {"topo-args", required_argument, 0, 4},
+                         {"loom-args", required_argument, 0, 5},
+                         {"octi-args", required_argument, 0, 6},
+                         {"transitmap-args", required_argument, 0, 7},
+                         {"server", required_argument, 0, 8},
+                         {"preview", no_argument, 0, 9},
+                         {"progressive", no_argument, 0, 10},
+                         {"threads", required_argument, 0, 't'},
+                         {0, 0, 0, 0}};
+
+  int c;
+  while ((c = getopt_long(argc, argv, ":hvo:t:", ops, 0)) != -1) {
+    switch (c) {
+      case 'h':
+        help(argv[0]);
+        exit(0);
+      case 'v':
+        std::cout << "magga - (LOOM " << VERSION_FULL << ")" << std::endl;
+        exit(0);
+      case 'o':
+        cfg->outputPrefix = optarg;
+        break;
+      case 1:
+        cfg->noGeo = true;
+        break;
+      case 2:
+        cfg->noSchem = true;
+        break;
+      case 3:
+        cfg->gtfs2graphArgs = optarg;
+        break;
+      case 4:
+        cfg->topoArgs = optarg;
+        break;
+      case 5:
+        cfg->loomArgs = optarg;
+        break;
+      case 6:
+        cfg->octiArgs = optarg;
+        break;
+      case 7:
+        cfg->transitmapArgs = optarg;
+        break;
+      case 8:
+        cfg->serverSocket = optarg;
+        break;
+      case 9:
+        cfg->preview = true;
+        break;
+      case 10:
+        cfg->preview = true;
+        cfg->progressive = true;
+        break;
+      case 't':
+        cfg->threads = atoi(optarg);
+        break;
+      case ':':
+        std::cerr << argv[optind - 1];
+        std::cerr << " requires an argument" << std::endl;
+        exit(1);
+      case '?':
+        std::cerr << argv[optind - 1];
+        std::cerr << " option unknown" << std::endl;
+        exit(1);
+        break;
+      default:
+        std::cerr << "Error while parsing arguments" << std::endl;
+        exit(1);
+        break;
+    }
+  }
+
+  if (optind == argc) {
+    std::cerr << "No input GTFS feed specified." << std::endl;
+    exit(1);
+  }
+
+  cfg->inputFeedPath = argv[optind];
+
+  // the budget comes first, so a -t in the stage arguments wins
+  if (cfg->threads > 0) {
+    std::string t = "-t " + std::to_string(cfg->threads) + " ";
+    cfg->gtfs2graphArgs = t + cfg->gtfs2graphArgs;
+    cfg->topoArgs = t + cfg->topoArgs;
+    cfg->loomArgs = t + cfg->loomArgs;
+    cfg->octiArgs = t + cfg->octiArgs;
+    cfg->transitmapArgs = t + cfg->transitmapArgs;
+  }
+}
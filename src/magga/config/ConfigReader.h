@@ -0,0 +1,23 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef MAGGA_CONFIG_CONFIGREADER_H_
+#define MAGGA_CONFIG_CONFIGREADER_H_
+
+#include "magga/config/MaggaConfig.h"
+
+namespace magga {
+namespace config {
+
+class ConfigReader {
+ public:
+  ConfigReader();
+  void read(Config* targetConfig, int argc, char** argv) const;
+
+ private:
+  void help(const char* bin) const;
+};
+}  // namespace config
+}  // namespace magga
+#endif  // MAGGA_CONFIG_CONFIGREADER_H_
@@ -0,0 +1,42 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef MAGGA_CONFIG_MAGGACONFIG_H_
+#define MAGGA_CONFIG_MAGGACONFIG_H_
+
+#include <string>
+
+namespace magga {
+namespace config {
+
+struct Config {
+  std::string inputFeedPath;
+  std::string outputPrefix = "map";
+
+  // additional arguments for the single stages
+  std::string gtfs2graphArgs = "";
+  std::string topoArgs = "";
+  std::string loomArgs = "";
+  std::string octiArgs = "";
+  std::string transitmapArgs = "";
+
+  // thread budget passed to every stage with -t, 0 if not given
+  int threads = 0;
+
+  bool noGeo = false;
+  bool noSchem = false;
+
+  // trade quality for latency, see magga::stageArgs(). With progressive,
+  // the preview maps are replaced by the exact maps once they are done
+  bool preview = false;
+  bool progressive = false;
+
+  // if set, serve maps on this UNIX socket instead of writing them
+  std::string serverSocket = "";
+};
+
+}  // namespace config
+}  // namespace magga
+
+#endif  // MAGGA_CONFIG_MAGGACONFIG_H_
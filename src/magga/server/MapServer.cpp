@@ -0,0 +1,253 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <errno.h>
+#include <fnmatch.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "loom/Loom.h"
+#include "magga/Pipeline.h"
+#include "magga/server/MapServer.h"
+#include "octi/Octi.h"
+#include "shared/linegraph/BinGraph.h"
+#include "transitmap/TransitMap.h"
+#include "util/log/Log.h"
+
+using magga::server::MapServer;
+using shared::linegraph::Line;
+
+// max size of a single request, in bytes
+static const size_t MAX_REQ_SIZE = 1024 * 1024;
+
+namespace {
+// _____________________________________________________________________________
+std::set<std::string> strSet(const nlohmann::json& req, const char* key) {
+  std::set<std::string> ret;
+  if (!req.count(key)) return ret;
+  for (const auto& v : req.at(key)) ret.insert(v.get<std::string>());
+  return ret;
+}
+
+// _____________________________________________________________________________
+void sendAll(int fd, const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return;
+    sent += n;
+  }
+}
+}  // namespace
+
+// _____________________________________________________________________________
+MapServer::MapServer(const config::Config* cfg, std::istream* topoGraph)
+    : _cfg(cfg) {
+  _g.readFromBin(topoGraph);
+}
+
+// _____________________________________________________________________________
+int MapServer::run(const std::string& socketPath) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+
+  if (socketPath.size() >= sizeof(addr.sun_path)) {
+    LOG(ERROR) << "Socket path " << socketPath << " is too long";
+    return 1;
+  }
+  strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0) {
+    LOG(ERROR) << "Could not create socket: " << strerror(errno);
+    return 1;
+  }
+
+  // remove a stale socket of an earlier run
+  unlink(socketPath.c_str());
+
+  if (bind(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+      listen(sock, 16) < 0) {
+    LOG(ERROR) << "Could not listen on " << socketPath << ": "
+               << strerror(errno);
+    close(sock);
+    return 1;
+  }
+
+  LOG(INFO) << "Serving maps on " << socketPath;
+
+  while (true) {
+    int conn = accept(sock, 0, 0);
+    if (conn < 0) {
+      if (errno == EINTR) continue;
+      LOG(ERROR) << "Could not accept connection: " << strerror(errno);
+      break;
+    }
+
+    std::string req;
+    char buf[4096];
+    while (req.find('\n') == std::string::npos && req.size() < MAX_REQ_SIZE) {
+      ssize_t n = read(conn, buf, sizeof(buf));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) break;
+      req.append(buf, n);
+    }
+
+    std::string res;
+    handle(req.substr(0, req.find('\n')), &res);
+    sendAll(conn, res);
+    close(conn);
+  }
+
+  close(sock);
+  unlink(socketPath.c_str());
+  return 1;
+}
+
+// _____________________________________________________________________________
+void MapServer::handle(const std::string& req, std::string* res) const {
+  T_START(request);
+
+  std::set<const Line*> lines;
+  bool schem = false;
+  bool preview = _cfg->preview;
+
+  try {
+    auto json = nlohmann::json::parse(req);
+    if (!json.is_object()) {
+      *res = "ERROR request is not a JSON object\n";
+      return;
+    }
+
+    if (json.count("map")) {
+      auto map = json.at("map").get<std::string>();
+      if (map != "geo" && map != "schem") {
+        *res = "ERROR unknown map type " + map + "\n";
+        return;
+      }
+      schem = map == "schem";
+    }
+
+    if (json.count("preview")) preview = json.at("preview").get<bool>();
+
+    lines = selectLines(json);
+  } catch (const std::exception& ex) {
+    *res = std::string("ERROR invalid request: ") + ex.what() + "\n";
+    return;
+  }
+
+  if (lines.empty()) {
+    *res = "ERROR no lines selected\n";
+    return;
+  }
+
+  std::string svg;
+  if (!render(lines, schem, preview, &svg)) {
+    *res = "ERROR could not render map\n";
+    return;
+  }
+
+  *res = "OK " + std::to_string(svg.size()) + "\n" + svg;
+
+  LOGTO(INFO, std::cerr) << "Rendered " << lines.size() << " lines in "
+                         << T_STOP(request) << "ms";
+}
+
+// _____________________________________________________________________________
+std::set<const Line*> MapServer::selectLines(const nlohmann::json& req) const {
+  const auto& stops = strSet(req, "stops");
+  const auto& routes = strSet(req, "routes");
+
+  // lines served at one of the stops
+  std::set<const Line*> atStops;
+  for (auto nd : _g.getNds()) {
+    bool wanted = false;
+    for (const auto& st : nd->pl().stops()) {
+      if (stops.count(st.id)) wanted = true;
+    }
+    if (!wanted) continue;
+
+    for (auto e : nd->getAdjList()) {
+      for (const auto& lo : e->pl().getLines()) {
+        if (nd->pl().lineServed(lo.line)) atStops.insert(lo.line);
+      }
+    }
+  }
+
+  std::set<const Line*> ret;
+  for (auto nd : _g.getNds()) {
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      for (const auto& lo : e->pl().getLines()) {
+        if (stops.size() && !atStops.count(lo.line)) continue;
+
+        if (routes.size()) {
+          bool match = false;
+          for (const auto& pat : routes) {
+            if (fnmatch(pat.c_str(), lo.line->label().c_str(), 0) == 0) {
+              match = true;
+              break;
+            }
+          }
+          if (!match) continue;
+        }
+
+        ret.insert(lo.line);
+      }
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+bool MapServer::render(const std::set<const Line*>& lines, bool schem,
+                       bool preview, std::string* svg) const {
+  const std::vector<std::string> BIN = {"--format", "bin"};
+
+  std::stringstream sub, loomGraph, octiGraph, out;
+
+  shared::linegraph::BinGraphWriter w(&sub);
+  w.add(_g, lines);
+  w.flush();
+
+  const auto loomArgs = stageArgs("loom", _cfg->loomArgs, preview);
+  const auto octiArgs = stageArgs("octi", _cfg->octiArgs, preview);
+  const auto tmArgs = stageArgs("transitmap", _cfg->transitmapArgs, preview);
+
+  if (runStage("loom", loomArgs, BIN, [&](int c, char** v) {
+        return loom::run(c, v, &sub, &loomGraph);
+      }) != 0) {
+    return false;
+  }
+
+  std::istream* toRender = &loomGraph;
+
+  if (schem) {
+    if (runStage("octi", octiArgs, BIN, [&](int c, char** v) {
+          return octi::run(c, v, &loomGraph, &octiGraph);
+        }) != 0) {
+      return false;
+    }
+    toRender = &octiGraph;
+  }
+
+  if (runStage("transitmap", tmArgs, {}, [&](int c, char** v) {
+        return transitmapper::run(c, v, toRender, &out);
+      }) != 0) {
+    return false;
+  }
+
+  *svg = out.str();
+  return true;
+}
@@ -0,0 +1,59 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef MAGGA_SERVER_MAPSERVER_H_
+#define MAGGA_SERVER_MAPSERVER_H_
+
+#include <istream>
+#include <set>
+#include <string>
+
+#include "3rdparty/json.hpp"
+#include "magga/config/MaggaConfig.h"
+#include "shared/linegraph/Line.h"
+#include "shared/linegraph/LineGraph.h"
+
+namespace magga {
+namespace server {
+
+// Serves maps of parts of a resident topo graph on a UNIX socket.
+//
+// Each connection sends a single request, a JSON object on one line:
+//
+//   {"stops": ["<stop id>", ...], "routes": ["<wildcard>", ...],
+//    "map": "geo", "preview": false}
+//
+// Only lines served at one of the stops and with a label matching one of
+// the wildcards are drawn, a missing or empty filter matches every line.
+// "map" is either "geo" (the default) or "schem". Only the carved out part
+// of the graph is handed to loom, octi and transitmap. With "preview", they
+// run in preview mode, the default is --preview of the server. A client
+// may request a preview first and the exact map after it.
+//
+// The response is "OK <length>\n" followed by the SVG, or "ERROR <reason>\n".
+// Requests are handled one after the other.
+class MapServer {
+ public:
+  MapServer(const config::Config* cfg, std::istream* topoGraph);
+
+  // serve requests until the socket fails, returns the exit code
+  int run(const std::string& socketPath);
+
+ private:
+  const config::Config* _cfg;
+  shared::linegraph::LineGraph _g;
+
+  void handle(const std::string& req, std::string* res) const;
+
+  std::set<const shared::linegraph::Line*> selectLines(
+      const nlohmann::json& req) const;
+
+  bool render(const std::set<const shared::linegraph::Line*>& lines,
+              bool schem, bool preview, std::string* svg) const;
+};
+
+}  // namespace server
+}  // namespace magga
+
+#endif  // MAGGA_SERVER_MAPSERVER_H_
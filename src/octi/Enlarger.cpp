@@ -1,43 +1,127 @@
+// Copyright 2020, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
 #include "octi/Enlarger.h"
 #include "util/log/Log.h"
-#include "octi/combgraph/CombGraph.h"
-#include "util/geo/QuadTree.h"
 
 using octi::Enlarger;
-using util::geo::QuadTree;
-using util::geo::QuadNode;
-using util::geo::QuadValue;
-using util::geo::DBox;
-using octi::combgraph::CombGraph;
-using octi::combgraph::CombNode;
-using octi::combgraph::CombEdge;
+using shared::linegraph::LineGraph;
+using util::geo::DPoint;
+using util::geo::DPolygon;
+using util::geo::PolyLine;
+
+// _____________________________________________________________________________
+Enlarger::Enlarger(const LineGraph& g, double theta) {
+  theta = std::max(0.0, std::min(theta, 0.95));
+
+  LOGTO(DEBUG, std::cerr) << "Enlarging dense areas with theta=" << theta;
+
+  std::vector<double> xs, ys;
+  for (auto nd : g.getNds()) {
+    xs.push_back(nd->pl().getGeom()->getX());
+    ys.push_back(nd->pl().getGeom()->getY());
+  }
+
+  const auto& box = g.getBBox();
+  borders(xs, box.getLowerLeft().getX(), box.getUpperRight().getX(), theta,
+          &_xOrig, &_xEnl);
+  borders(ys, box.getLowerLeft().getY(), box.getUpperRight().getY(), theta,
+          &_yOrig, &_yEnl);
+}
 
 // _____________________________________________________________________________
-void Enlarger::enlarge(CombGraph& cg, double theta) const {
-  LOGTO(DEBUG, std::cerr) << "Enlarging input graph with theta=" << theta << std::endl;
+void Enlarger::borders(const std::vector<double>& coords, double lo,
+                       double hi, double theta, std::vector<double>* orig,
+                       std::vector<double>* enl) {
+  orig->clear();
+  enl->clear();
+  if (!(hi > lo) || coords.empty()) return;
 
-  auto bbox = util::geo::getBoundingRect(cg.getBBox());
+  double w = (hi - lo) / ENLARGE_BINS;
 
-struct SplitFunc : util::geo::SplitFunc<const CombNode*, double> {
-  SplitFunc(double theta) : _theta(theta) {}
-  virtual bool operator()(const QuadNode<double>& nd,
-                       const QuadValue<const CombNode*, double>& newVal) const {
-    UNUSED(newVal);
-    double l = nd.bbox.getUpperRight().getX() - nd.bbox.getLowerLeft().getX();
+  std::vector<double> cnt(ENLARGE_BINS, 0);
+  for (double c : coords) {
+    int64_t i = std::floor((c - lo) / w);
+    cnt[std::max<int64_t>(0, std::min<int64_t>(i, ENLARGE_BINS - 1))]++;
+  }
 
-    return nd.numEls > 0 && l > _theta;
+  // smooth the counts, so neighboring slabs are scaled alike
+  std::vector<double> smooth(ENLARGE_BINS, 0);
+  for (size_t i = 0; i < ENLARGE_BINS; i++) {
+    double l = cnt[i > 0 ? i - 1 : i];
+    double r = cnt[i + 1 < ENLARGE_BINS ? i + 1 : i];
+    smooth[i] = (l + 2 * cnt[i] + r) / 4;
   }
-  double _theta;
-} sFunc(theta);
 
-  QuadTree<const CombNode*, double> qt(1024, sFunc, bbox);
+  double tot = 0;
+  for (double c : smooth) tot += c;
 
-  // write nodes to quadtree
-  for (auto cNd : cg.getNds()) {
-    qt.insert(cNd, *cNd->pl().getGeom());
+  orig->push_back(lo);
+  enl->push_back(lo);
+  for (size_t i = 0; i < ENLARGE_BINS; i++) {
+    double share = (1 - theta) / ENLARGE_BINS + theta * smooth[i] / tot;
+    orig->push_back(lo + (i + 1) * w);
+    enl->push_back(enl->back() + share * (hi - lo));
   }
 
-  qt.print(std::cout);
+  // against rounding errors, the box is kept
+  orig->back() = hi;
+  enl->back() = hi;
+}
+
+// _____________________________________________________________________________
+double Enlarger::interp(const std::vector<double>& fr,
+                        const std::vector<double>& to, double v) {
+  if (fr.empty()) return v;
+  if (v <= fr.front()) return to.front() + (v - fr.front());
+  if (v >= fr.back()) return to.back() + (v - fr.back());
+
+  size_t i = std::upper_bound(fr.begin(), fr.end(), v) - fr.begin();
+  double t = (v - fr[i - 1]) / (fr[i] - fr[i - 1]);
+  return to[i - 1] + t * (to[i] - to[i - 1]);
+}
 
-  exit(1);
+// _____________________________________________________________________________
+DPoint Enlarger::enlarge(const DPoint& p) const {
+  return {interp(_xOrig, _xEnl, p.getX()), interp(_yOrig, _yEnl, p.getY())};
+}
+
+// _____________________________________________________________________________
+DPoint Enlarger::shrink(const DPoint& p) const {
+  return {interp(_xEnl, _xOrig, p.getX()), interp(_yEnl, _yOrig, p.getY())};
+}
+
+// _____________________________________________________________________________
+void Enlarger::enlarge(LineGraph* g) const { apply(g, false); }
+
+// _____________________________________________________________________________
+void Enlarger::shrink(LineGraph* g) const { apply(g, true); }
+
+// _____________________________________________________________________________
+void Enlarger::enlarge(std::vector<DPolygon>* polys) const {
+  for (auto& poly : *polys) {
+    for (auto& p : poly.getOuter()) p = enlarge(p);
+  }
+}
+
+// _____________________________________________________________________________
+void Enlarger::apply(LineGraph* g, bool inverse) const {
+  auto map = [this, inverse](const DPoint& p) {
+    return inverse ? shrink(p) : enlarge(p);
+  };
+
+  for (auto nd : g->getNds()) {
+    nd->pl().setGeom(map(*nd->pl().getGeom()));
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      util::geo::DLine l;
+      l.reserve(e->pl().getGeom()->size());
+      for (const auto& p : *e->pl().getGeom()) l.push_back(map(p));
+      e->pl().setPolyline(PolyLine<double>(l));
+    }
+  }
 }
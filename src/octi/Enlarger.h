@@ -5,15 +5,53 @@
 #ifndef OCTI_ENLARGER_H_
 #define OCTI_ENLARGER_H_
 
+#include <vector>
 #include "shared/linegraph/LineGraph.h"
-#include "octi/combgraph/CombGraph.h"
+#include "util/geo/Geo.h"
 
 namespace octi {
 
+// number of slabs per axis the node density is measured in
+static const size_t ENLARGE_BINS = 64;
+
+// Density-equalizing distortion of the input, so that a coarse grid still
+// resolves dense areas. The bounding box of the graph is cut into
+// ENLARGE_BINS vertical and horizontal slabs, and each slab is scaled
+// according to the number of nodes in it: with strength theta, a slab gets
+// the share (1 - theta) / ENLARGE_BINS + theta * nodes / total nodes of the
+// width (or height) of the box. Dense slabs are enlarged, sparse ones
+// shrunk, the bounding box itself stays the same.
+//
+// The mapping is separable and piecewise linear per axis, shrink() undoes
+// enlarge(). Horizontal and vertical segments of a drawing stay axis
+// parallel under shrink(), diagonals change their angle slightly where the
+// slab widths differ.
 class Enlarger {
  public:
-  Enlarger() {}
-  void enlarge(octi::combgraph::CombGraph& lg, double theta) const;
+  // theta in [0, 1), 0 is the identity
+  Enlarger(const shared::linegraph::LineGraph& g, double theta);
+
+  void enlarge(shared::linegraph::LineGraph* g) const;
+  void enlarge(std::vector<util::geo::DPolygon>* polys) const;
+  void shrink(shared::linegraph::LineGraph* g) const;
+
+  util::geo::DPoint enlarge(const util::geo::DPoint& p) const;
+  util::geo::DPoint shrink(const util::geo::DPoint& p) const;
+
+ private:
+  // slab borders in the original and in the enlarged space, per axis
+  std::vector<double> _xOrig, _xEnl, _yOrig, _yEnl;
+
+  void apply(shared::linegraph::LineGraph* g, bool inverse) const;
+
+  // piecewise linear interpolation of v from the borders fr to to, slope 1
+  // outside of them
+  static double interp(const std::vector<double>& fr,
+                       const std::vector<double>& to, double v);
+
+  static void borders(const std::vector<double>& coords, double lo,
+                      double hi, double theta, std::vector<double>* orig,
+                      std::vector<double>* enl);
 };
 
 }  // namespace octi
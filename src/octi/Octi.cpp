@@ -0,0 +1,953 @@
+// Copyright 2017
+// University of Freiburg - Chair of Algorithms and Datastructures
+// Author: Patrick Brosi <brosi@cs.uni-freiburg.de>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include "3rdparty/json.hpp"
+#include "octi/Enlarger.h"
+#include "octi/Octi.h"
+#include "octi/Octilinearizer.h"
+#include "octi/_config.h"
+#include "octi/basegraph/BaseGraph.h"
+#include "octi/basegraph/GridDump.h"
+#include "octi/combgraph/CombGraph.h"
+#include "octi/config/ConfigReader.h"
+#include "shared/cache/CompCache.h"
+#include "shared/cache/StageCache.h"
+#include "shared/io/CompressedStream.h"
+#include "shared/linegraph/BinGraph.h"
+#include "shared/linegraph/JsonGraph.h"
+#include "shared/linegraph/TopoJsonGraph.h"
+#include "shared/linegraph/LineGraph.h"
+#include "shared/optim/RemoteSolver.h"
+#include "shared/threads/Cancel.h"
+#include "shared/threads/ThreadBudget.h"
+#include "shared/trace/Metrics.h"
+#include "shared/trace/Progress.h"
+#include "shared/trace/Trace.h"
+#include "util/Misc.h"
+#include "util/geo/Geo.h"
+#include "util/geo/output/GeoGraphJsonOutput.h"
+#include "util/graph/BiDijkstra.h"
+#include "util/json/Writer.h"
+#include "util/log/Log.h"
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_num_procs() 1
+#define omp_set_max_active_levels(x) (void)(x)
+#endif
+
+using std::string;
+using namespace octi;
+
+using octi::Enlarger;
+using octi::Octilinearizer;
+using octi::basegraph::BaseGraph;
+using util::geo::dist;
+using util::geo::DPolygon;
+
+namespace {
+struct TotalScore {
+  Score score;
+  octi::ilp::ILPStats ilpstats;
+
+  size_t gridgraphNumNds = 0;
+  size_t gridgraphNumEdgs = 0;
+  size_t combgraphNumNds = 0;
+  size_t combgraphNumEdgs = 0;
+  size_t inputgraphNumNds = 0;
+  size_t inputgraphNumEdgs = 0;
+  size_t inputgraphMaxDeg = 0;
+  size_t numNoEmbeddingFound = 0;
+  double timeMs = 0;
+};
+
+// _____________________________________________________________________________
+inline TotalScore operator+(const TotalScore& lh, const TotalScore& rh) {
+  TotalScore ret;
+  ret.score = lh.score + rh.score;
+  ret.ilpstats = lh.ilpstats + rh.ilpstats;
+  ret.gridgraphNumNds = lh.gridgraphNumNds + rh.gridgraphNumNds;
+  ret.gridgraphNumEdgs = lh.gridgraphNumEdgs + rh.gridgraphNumEdgs;
+  ret.combgraphNumNds = lh.combgraphNumNds + rh.combgraphNumNds;
+  ret.combgraphNumEdgs = lh.combgraphNumEdgs + rh.combgraphNumEdgs;
+  ret.inputgraphNumNds = lh.inputgraphNumNds + rh.inputgraphNumNds;
+  ret.inputgraphNumEdgs = lh.inputgraphNumEdgs + rh.inputgraphNumEdgs;
+  ret.inputgraphMaxDeg = std::max(lh.inputgraphMaxDeg, rh.inputgraphMaxDeg);
+  ret.numNoEmbeddingFound = lh.numNoEmbeddingFound + rh.numNoEmbeddingFound;
+  ret.timeMs = lh.timeMs + rh.timeMs;
+  return ret;
+}
+
+// results of a single component, merged in component order after all
+// components have been drawn
+struct CompResult {
+  util::json::Array jsonScores;
+  std::vector<LineGraph*> resultGraphs;
+  std::vector<BaseGraph*> resultGridGraphs;
+  TotalScore totScore;
+};
+
+// _____________________________________________________________________________
+double avgStatDist(const LineGraph& g) {
+  double avg = 0;
+  size_t i = 0;
+  for (const auto nd : g.getNds()) {
+    if (nd->getDeg() == 0) continue;
+    i++;
+    double loc = 0;
+    for (const auto edg : nd->getAdjList()) {
+      loc += dist(*nd->pl().getGeom(), *edg->getOtherNd(nd)->pl().getGeom());
+    }
+    avg += loc / nd->getAdjList().size();
+  }
+  avg /= i++;
+  return avg;
+}
+
+// _____________________________________________________________________________
+const CombNode* getCenterNd(const CombGraph* cg) {
+  const CombNode* ret = 0;
+  for (auto nd : cg->getNds()) {
+    if (!ret || LineGraph::getLDeg(nd->pl().getParent()) >
+                    LineGraph::getLDeg(ret->pl().getParent())) {
+      ret = nd;
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<DPolygon> readObstacleFile(const std::string& p) {
+  std::vector<DPolygon> ret;
+  std::ifstream s;
+  s.open(p);
+  nlohmann::json j;
+  s >> j;
+
+  if (j["type"] == "FeatureCollection") {
+    for (auto feature : j["features"]) {
+      auto geom = feature["geometry"];
+      if (geom["type"] == "Polygon") {
+        std::vector<std::vector<double>> coords = geom["coordinates"][0];
+        util::geo::Line<double> l;
+        for (auto coord : coords) {
+          l.push_back({coord[0], coord[1]});
+        }
+        ret.push_back(DPolygon(l));
+      }
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+double getGridSize(double avgDist, const config::Config& cfg) {
+  if (util::trim(cfg.gridSize).back() == '%') {
+    double perc = atof(cfg.gridSize.c_str()) / 100;
+    return avgDist * perc;
+  }
+
+  return atof(cfg.gridSize.c_str());
+}
+
+// a single drawing of a component
+struct CompDrawing {
+  LineGraph* res = 0;
+  BaseGraph* gg = 0;
+  Score sc;
+  octi::ilp::ILPStats ilpstats;
+  double time = 0;
+  util::geo::DBox box;
+};
+
+// _____________________________________________________________________________
+util::geo::DBox prepareComp(LineGraph& tg, double gridSize,
+                            const config::Config& cfg) {
+  Octilinearizer oct(cfg.baseGraphType);
+
+  // contract degree 2 nodes without any significance (no station, no
+  // exception, no change in lines
+  tg.contractStrayNds();
+
+  // heuristic: contract all edges shorter than half the grid size
+  tg.contractEdges(gridSize / 2);
+
+  auto box = tg.getBBox();
+
+  // split nodes that have a larger degree than the max degree of the grid
+  // graph to allow drawing
+  tg.splitNodes(oct.maxNodeDeg());
+
+  return box;
+}
+
+// _____________________________________________________________________________
+void fitGridMem(const CombGraph& cg, const util::geo::DBox& box,
+                const config::Config& cfg, octi::basegraph::BaseGraphType* t,
+                double* gridSize) {
+  // fit a single base graph into the budget: full octilinear grids are first
+  // replaced by buffered ones, then the grid is coarsened
+  using octi::basegraph::BaseGraphType;
+  double budget = cfg.maxGridMem * 1024 * 1024;
+
+  auto estimate = [&]() {
+    return Octilinearizer::estimateGrid(*t, cfg.sparseGrid, cg,
+                                        util::geo::pad(box, *gridSize + 1),
+                                        *gridSize, cfg.maxGrDist);
+  };
+
+  auto est = estimate();
+
+  LOGTO(DEBUG, std::cerr) << "Estimated grid graph size: " << est.nds
+                          << " nodes, " << est.edgs << " edges, "
+                          << util::readableSize(est.bytes);
+
+  if (est.bytes <= budget) return;
+
+  if ((*t == BaseGraphType::OCTIGRID ||
+       *t == BaseGraphType::CONVEXHULLOCTIGRID) &&
+      cfg.sparseGrid == 0) {
+    *t = BaseGraphType::BUFFEREDOCTIGRID;
+    est = estimate();
+    LOGTO(WARN, std::cerr) << "Grid graph exceeds --max-grid-mem, using a "
+                              "buffered octilinear grid ("
+                           << util::readableSize(est.bytes) << ")";
+  }
+
+  double origGridSize = *gridSize;
+  for (size_t i = 0; i < 32 && est.bytes > budget; i++) {
+    *gridSize *= std::max(1.05, sqrt(est.bytes / budget));
+    est = estimate();
+  }
+
+  if (*gridSize != origGridSize) {
+    LOGTO(WARN, std::cerr) << "Grid graph exceeds --max-grid-mem, coarsened "
+                              "grid size from "
+                           << origGridSize << " to " << *gridSize << " ("
+                           << util::readableSize(est.bytes) << ")";
+  }
+}
+
+// _____________________________________________________________________________
+CompDrawing drawCompOnGrid(const CombGraph& cg, util::geo::DBox box,
+                           double gridSize, const config::Config& cfg,
+                           const std::atomic<bool>* cancel) {
+  TRACE_ZONE("draw on grid");
+  CompDrawing ret;
+
+  Drawing d;
+
+  auto baseGraphType = cfg.baseGraphType;
+  double gridMemLimit = cfg.gridMemLimit;
+
+  if (cfg.maxGridMem > 0) {
+    fitGridMem(cg, box, cfg, &baseGraphType, &gridSize);
+    // further grid copies for parallel jobs have to fit as well
+    if (gridMemLimit <= 0 || gridMemLimit > cfg.maxGridMem) {
+      gridMemLimit = cfg.maxGridMem;
+    }
+  }
+
+  Octilinearizer oct(baseGraphType, cfg.jobs, gridMemLimit, cfg.gridDijkstra,
+                     cfg.sparseGrid);
+  oct.setCancel(cancel);
+  oct.setBidirDist(cfg.bidirRouteDist);
+  oct.setRouteRegions(cfg.routeRegions);
+  oct.setPrevDrawing(cfg.prevDrawing.get(), cfg.prevRadius, cfg.prevSubset);
+
+  octi::basegraph::QuadTreeParams qtParams;
+  qtParams.maxLeafPts = cfg.quadTreeMaxLeafPts;
+  qtParams.minCellSize = cfg.quadTreeMinCellSize;
+  qtParams.edgeSampleDist = cfg.quadTreeEdgeSampleDist;
+  oct.setQuadTreeParams(qtParams);
+
+  LOGTO(DEBUG, std::cerr) << "Grid size " << gridSize;
+
+  box = util::geo::pad(box, gridSize + 1);
+
+  if (baseGraphType == octi::basegraph::BaseGraphType::ORTHORADIAL ||
+      baseGraphType == octi::basegraph::BaseGraphType::PSEUDOORTHORADIAL) {
+    auto centerNd = getCenterNd(&cg);
+
+    LOGTO(DEBUG, std::cerr) << "Orthoradial center node is "
+                            << centerNd->pl().getParent()->pl().toString();
+
+    auto cgCtr = *centerNd->pl().getGeom();
+    auto newBox = util::geo::DBox();
+
+    newBox = extendBox(box, newBox);
+    newBox = extendBox(rotate(convexHull(box), 180, cgCtr), newBox);
+    box = newBox;
+  }
+
+  ret.box = box;
+  ret.res = new LineGraph();
+
+  try {
+    if (cfg.optMode == "ilp") {
+      // a running solve is not interrupted, but limited to the run deadline
+      int timeLimit = cfg.ilpTimeLimit;
+      double left = shared::threads::secondsLeft();
+      if (left >= 0) {
+        int l = std::max(1, static_cast<int>(left));
+        timeLimit = timeLimit < 0 ? l : std::min(timeLimit, l);
+      }
+
+      T_START(octi);
+      ret.sc = oct.drawILP(
+          cg, box, ret.res, &ret.gg, &d, cfg.pens, gridSize, cfg.borderRad,
+          cfg.maxGrDist, cfg.orderMethod, cfg.ilpNoSolve, cfg.enfGeoPen,
+          cfg.hananIters, timeLimit, cfg.ilpCacheDir,
+          cfg.ilpCacheThreshold, cfg.ilpNumThreads, &ret.ilpstats,
+          cfg.ilpSolver, cfg.ilpPath, cfg.ilpWindow, cfg.ilpCorridor,
+          cfg.ilpCacheModel);
+      ret.time = T_STOP(octi);
+      LOGTO(DEBUG, std::cerr) << "Schematized using ILP in " << ret.time
+                              << " ms, score " << ret.sc.full;
+    } else if ((cfg.optMode == "heur")) {
+      T_START(octi);
+      ret.sc = oct.draw(cg, box, ret.res, &ret.gg, &d, cfg.pens, gridSize,
+                        cfg.borderRad, cfg.maxGrDist, cfg.orderMethod,
+                        cfg.restrLocSearch, cfg.enfGeoPen, cfg.hananIters,
+                        cfg.obstacles, cfg.heurLocSearchIters,
+                        cfg.abortAfter, cfg.coarseFactor);
+      ret.time = T_STOP(octi);
+
+      LOGTO(DEBUG, std::cerr) << "Schematized using heur approach in "
+                              << ret.time << " ms, score " << ret.sc.full;
+    }
+  } catch (const NoEmbeddingFoundExc& exc) {
+    delete ret.res;
+    throw;
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void freeCompDrawing(CompDrawing* d) {
+  delete d->res;
+  delete d->gg;
+  d->res = 0;
+  d->gg = 0;
+}
+
+// _____________________________________________________________________________
+void writeComp(const LineGraph& tg, const CombGraph& cg, double avgDist,
+               CompDrawing* d, util::json::Array& jsonScores,
+               std::vector<LineGraph*>& resultGraphs,
+               std::vector<BaseGraph*>& resultGridGraphs, TotalScore& totScore,
+               const config::Config& cfg) {
+  const auto& sc = d->sc;
+  const auto& ilpstats = d->ilpstats;
+  const auto& box = d->box;
+  double time = d->time;
+  BaseGraph* gg = d->gg;
+
+  if (cfg.writeStats) {
+    size_t maxRss = util::getPeakRSS();
+    size_t numEdgs = 0;
+    size_t numEdgsComb = 0;
+    size_t numEdgsTg = 0;
+    for (auto nd : gg->getNds()) {
+      numEdgs += nd->getDeg();
+    }
+    for (auto nd : cg.getNds()) {
+      numEdgsComb += nd->getDeg();
+    }
+    for (auto nd : tg.getNds()) {
+      numEdgsTg += nd->getDeg();
+    }
+
+    // total score
+    totScore.score = totScore.score + sc;
+    totScore.ilpstats = totScore.ilpstats + ilpstats;
+
+    totScore.gridgraphNumNds += gg->getNds().size();
+    totScore.gridgraphNumEdgs += numEdgs / 2;
+    totScore.combgraphNumNds += cg.getNds().size();
+    totScore.combgraphNumEdgs += numEdgsComb / 2;
+    totScore.inputgraphNumNds += tg.getNds().size();
+    totScore.inputgraphNumEdgs += numEdgsTg / 2;
+    totScore.inputgraphMaxDeg =
+        std::max(totScore.inputgraphMaxDeg, tg.maxDeg());
+    totScore.timeMs += time;
+
+    // translate score to JSON
+    util::json::Dict jsonScore = util::json::Dict{
+        {"scores",
+         util::json::Dict{{"total-score", sc.full},
+                          {"topo-violations", util::json::Int(sc.violations)},
+                          {"density-score", sc.dense},
+                          {"bend-score", sc.bend},
+                          {"hop-score", sc.hop},
+                          {"move-score", sc.move}}},
+        {"pens",
+         util::json::Dict{
+             {"density-pen", cfg.pens.densityPen},
+             {"diag-pen", cfg.pens.diagonalPen},
+             {"hori-pen", cfg.pens.horizontalPen},
+             {"vert-pen", cfg.pens.verticalPen},
+             {"180-turn-pen", cfg.pens.p_0},
+             {"135-turn-pen", cfg.pens.p_135},
+             {"90-turn-pen", cfg.pens.p_90},
+             {"45-turn-pen", cfg.pens.p_45},
+         }},
+        {"gridgraph-size", util::json::Dict{{"nodes", gg->getNds().size()},
+                                            {"edges", numEdgs / 2}}},
+        {"combgraph-size", util::json::Dict{{"nodes", cg.getNds().size()},
+                                            {"edges", numEdgsComb / 2}}},
+        {"input-graph-size", util::json::Dict{{"nodes", tg.getNds().size()},
+                                              {"edges", numEdgsTg / 2},
+                                              {"max-deg", tg.maxDeg()}}},
+        {"input-graph-avg-node-dist",
+         avgDist * webMercDistFactor(box.getLowerLeft())},
+        {"area", dist(box.getLowerRight(), box.getLowerLeft()) *
+                     webMercDistFactor(box.getLowerRight()) *
+                     dist(box.getLowerRight(), box.getUpperRight()) *
+                     webMercDistFactor(box.getLowerRight())},
+        {"misc", util::json::Dict{{"method", cfg.optMode},
+                                  {"deg2heur", cfg.deg2Heur},
+                                  {"max-grid-dist", cfg.maxGrDist}}},
+        {"time-ms", time},
+        {"iterations", sc.iters},
+        {"procs", omp_get_num_procs()},
+        {"peak-memory", util::readableSize(maxRss)},
+        {"peak-memory-bytes", maxRss},
+        {"timestamp", util::json::Int(std::time(0))}};
+
+    if (cfg.optMode == "ilp") {
+      jsonScore["ilp"] = util::json::Dict{
+          {"size",
+           util::json::Dict{{"rows", ilpstats.rows}, {"cols", ilpstats.cols}}},
+          {"solve-time", ilpstats.time},
+          {"optimal", util::json::Bool{ilpstats.optimal}}};
+    }
+
+    jsonScores.push_back(jsonScore);
+  }
+
+  resultGraphs.push_back(d->res);
+
+  if (cfg.printMode == "gridgraph") {
+    resultGridGraphs.push_back(gg);
+  } else {
+    delete gg;
+  }
+
+  d->res = 0;
+  d->gg = 0;
+}
+
+// _____________________________________________________________________________
+util::json::Dict scoreDict(const Score& sc) {
+  return util::json::Dict{{"total-score", sc.full},
+                          {"topo-violations", util::json::Int(sc.violations)},
+                          {"density-score", sc.dense},
+                          {"bend-score", sc.bend},
+                          {"hop-score", sc.hop},
+                          {"move-score", sc.move}};
+}
+
+// _____________________________________________________________________________
+Score scoreFromProps(const nlohmann::json::object_t& props) {
+  Score sc;
+  if (!props.count("comp-score")) return sc;
+  const auto& s = props.at("comp-score");
+  sc.full = s.value("total-score", sc.full);
+  sc.violations = s.value("topo-violations", sc.violations);
+  sc.dense = s.value("density-score", sc.dense);
+  sc.bend = s.value("bend-score", sc.bend);
+  sc.hop = s.value("hop-score", sc.hop);
+  sc.move = s.value("move-score", sc.move);
+  return sc;
+}
+
+// _____________________________________________________________________________
+bool drawCompSpeculative(const CombGraph& cg, const util::geo::DBox& box,
+                         const std::vector<double>& gridSizes,
+                         const config::Config& cfg, CompDrawing* out) {
+  // grid sizes are tried in rounds of retryJobs concurrent drawings, the
+  // largest grid size that embeds wins
+  size_t k = cfg.retryJobs;
+
+  config::Config tryCfg = cfg;
+  tryCfg.jobs = std::max<size_t>(1, cfg.jobs / k);
+
+  for (size_t r = 0; r < gridSizes.size(); r += k) {
+    size_t n = std::min(k, gridSizes.size() - r);
+
+    std::vector<CompDrawing> draws(n);
+    std::vector<char> ok(n, 0);
+    std::unique_ptr<std::atomic<bool>[]> cancel(new std::atomic<bool>[n]);
+    for (size_t j = 0; j < n; j++) cancel[j] = false;
+
+#pragma omp parallel for schedule(static, 1) num_threads(n)
+    for (size_t j = 0; j < n; j++) {
+      try {
+        draws[j] =
+            drawCompOnGrid(cg, box, gridSizes[r + j], tryCfg, &cancel[j]);
+        if (cancel[j]) continue;
+        ok[j] = 1;
+
+        // smaller grid sizes are not needed anymore
+        for (size_t l = j + 1; l < n; l++) cancel[l] = true;
+      } catch (const NoEmbeddingFoundExc& exc) {
+      }
+    }
+
+    size_t best = n;
+    for (size_t j = 0; j < n && best == n; j++) {
+      if (ok[j]) best = j;
+    }
+
+    for (size_t j = 0; j < n; j++) {
+      if (j != best) freeCompDrawing(&draws[j]);
+    }
+
+    if (best < n) {
+      *out = draws[best];
+      return true;
+    }
+
+    if (r + n < gridSizes.size()) {
+      LOGTO(WARN, std::cerr) << "Retrying with grid sizes "
+                             << gridSizes[r + n] << " to "
+                             << gridSizes[std::min(gridSizes.size(), r + 2 * n)
+                                          - 1];
+    }
+  }
+
+  return false;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+int octi::run(int argc, char** argv, std::istream* inStr,
+              std::ostream* outStr) {
+  config::Config cfg;
+
+  config::ConfigReader cr;
+  cr.read(&cfg, argc, argv);
+
+  shared::threads::setBudget(cfg.threadBudget);
+  shared::threads::setDeadline(cfg.deadline);
+  shared::optim::setRemoteCmd(cfg.ilpRemoteCmd);
+
+  shared::trace::Trace::open(cfg.tracePath, "octi");
+  shared::trace::Metrics::open(cfg.metricsPath, "octi");
+  shared::trace::Progress::open(cfg.progressFd, "octi");
+
+  // declared before the cache, so cached output is compressed as well
+  shared::io::CompressedIn zIn(&inStr);
+  shared::io::CompressedOut zOut(cfg.compress, cfg.threadBudget, &outStr);
+
+  shared::cache::StageCache cache(cfg.stageCacheDir,
+                                  std::string("octi ") + VERSION_FULL,
+                                  "--stage-cache-dir", argc, argv, &inStr,
+                                  &outStr);
+  if (cache.hit()) return 0;
+
+  // grid graphs are not cached, so they can't be printed for cached results
+  shared::cache::CompCache compCache(
+      cfg.printMode == "gridgraph" ? "" : cfg.compCacheDir,
+      std::string("octi ") + VERSION_FULL,
+      {"--comp-cache-dir", "--stage-cache-dir"}, argc, argv);
+
+  util::geo::output::GeoGraphJsonOutput out;
+
+  if (cfg.obstaclePath.size()) {
+    LOGTO(DEBUG, std::cerr) << "Reading obstacle file...";
+    cfg.obstacles = readObstacleFile(cfg.obstaclePath);
+    LOGTO(DEBUG, std::cerr) << "Done. (" << cfg.obstacles.size() << " obst.)";
+  }
+
+  // with an enlargement, the geometries are moved after reading, so the
+  // spatial indices are only built afterwards
+  std::shared_ptr<LineGraph> prev;
+  if (cfg.prevDrawingPath.size()) {
+    LOGTO(DEBUG, std::cerr) << "Reading previous drawing...";
+    prev = std::make_shared<LineGraph>();
+    if (cfg.enlarge > 0) prev->setIndexed(false);
+    std::ifstream s;
+    s.open(cfg.prevDrawingPath);
+    prev->readFromJson(&s);
+    cfg.prevDrawing = prev;
+    LOGTO(DEBUG, std::cerr) << "Done. (" << prev->getNds().size() << " nodes)";
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Reading graph file...";
+  T_START(read);
+  LineGraph lg;
+  if (cfg.enlarge > 0) lg.setIndexed(false);
+
+  {
+    TRACE_PHASE("read");
+    if (cfg.fromDot)
+      lg.readFromDot(inStr);
+    else if (shared::linegraph::isBinGraph(inStr))
+      lg.readFromBin(inStr);
+    else
+      lg.readFromJson(inStr);
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Done. (" << T_STOP(read) << "ms)";
+
+  // everything is drawn in the enlarged space, the drawings are shrunk back
+  std::unique_ptr<Enlarger> enlarger;
+  if (cfg.enlarge > 0) {
+    enlarger.reset(new Enlarger(lg, cfg.enlarge));
+    enlarger->enlarge(&lg);
+    lg.buildIndex();
+    enlarger->enlarge(&cfg.obstacles);
+    if (prev) {
+      enlarger->enlarge(prev.get());
+      prev->buildIndex();
+    }
+  }
+
+  if (cfg.snapOrphanStations) lg.snapOrphanStations();
+
+  shared::trace::Metrics::count("nodes", lg.numNds());
+  shared::trace::Metrics::count("edges", lg.numEdgs());
+
+  LOGTO(DEBUG, std::cerr) << "Planarizing graph...";
+  T_START(planarize);
+  {
+    TRACE_PHASE("planarize");
+    lg.topologizeIsects();
+  }
+  LOGTO(DEBUG, std::cerr) << "Done. (" << T_STOP(planarize) << "ms)";
+
+  std::vector<LineGraph> comps = lg.splitDistConnectedComponents(10000, false);
+
+  shared::trace::Metrics::count("components", comps.size());
+
+  util::json::Array jsonScores;
+  std::vector<LineGraph*> resultGraphs;
+  std::vector<BaseGraph*> resultGridGraphs;
+
+  LOGTO(DEBUG, std::cerr) << "Broke input graph into " << comps.size()
+                          << " components";
+
+  TotalScore totScore;
+
+  // components are drawn concurrently, the heuristic jobs are divided among
+  // them so that the total number of threads stays the same
+  size_t totJobs = cfg.jobs;
+  if (totJobs == 0) totJobs = std::max(1u, std::thread::hardware_concurrency());
+
+  size_t compJobs = std::max<size_t>(1, std::min(totJobs, comps.size()));
+
+  config::Config compCfg = cfg;
+  compCfg.jobs = std::max<size_t>(1, totJobs / compJobs);
+
+  // drawings of a component may run in parallel, speculative retries add
+  // another level
+  size_t levels = 1 + (compJobs > 1) + (cfg.retryOnError && cfg.retryJobs > 1);
+  if (levels > 1) omp_set_max_active_levels(levels);
+
+  LOGTO(DEBUG, std::cerr) << "Drawing " << compJobs
+                          << " component(s) in parallel, " << compCfg.jobs
+                          << " job(s) each";
+
+  // biggest components first, for better load balancing
+  std::vector<size_t> order(comps.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&comps](size_t a, size_t b) {
+    return comps[a].getNds().size() > comps[b].getNds().size();
+  });
+
+  std::vector<CompResult> compRes(comps.size());
+
+  // without statistics, the output header does not depend on the drawings, and
+  // finished components are written (and freed) as soon as all components
+  // before them are done
+  bool stream = !cfg.writeStats && cfg.printMode != "gridgraph";
+  std::unique_ptr<shared::linegraph::BinGraphWriter> binOut;
+  std::unique_ptr<shared::linegraph::JsonGraphWriter> jsonOut;
+  std::unique_ptr<shared::linegraph::TopoJsonGraphWriter> topoOut;
+  if (stream && cfg.outputFormat == "bin") {
+    binOut.reset(
+        new shared::linegraph::BinGraphWriter(outStr, util::json::Dict()));
+  } else if (stream && cfg.outputFormat == "topojson") {
+    topoOut.reset(new shared::linegraph::TopoJsonGraphWriter(outStr));
+  } else if (stream) {
+    jsonOut.reset(new shared::linegraph::JsonGraphWriter(outStr));
+  }
+  std::vector<char> compDone(comps.size(), 0);
+  size_t nextOut = 0;
+
+  // mark component i as done and write all done components before the
+  // first one still running
+  auto writeDone = [&](size_t i) {
+#pragma omp critical(octi_out)
+    {
+      compDone[i] = 1;
+      for (; nextOut < comps.size() && compDone[nextOut]; nextOut++) {
+        for (auto res : compRes[nextOut].resultGraphs) {
+          if (binOut) binOut->add(*res);
+          if (jsonOut) jsonOut->add(*res);
+          if (topoOut) topoOut->add(*res);
+          delete res;
+        }
+        compRes[nextOut].resultGraphs.clear();
+      }
+    }
+  };
+
+  std::atomic<size_t> cachedComps(0);
+
+  shared::trace::Phase drawPhase("draw");
+  shared::trace::Progress::comps(order.size());
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(compJobs)
+  for (size_t j = 0; j < order.size(); j++) {
+    TRACE_ZONE("component");
+    size_t i = order[j];
+    auto& tg = comps[i];
+    auto& cr = compRes[i];
+
+    LOGTO(DEBUG, std::cerr) << "@ component " << i;
+
+    // the drawing also depends on the number of jobs per component
+    uint64_t key = 0;
+    if (compCache.enabled()) {
+      key = compCache.key(tg, "jobs " + std::to_string(compCfg.jobs));
+      auto res = new LineGraph();
+      if (compCache.get(key, res)) {
+        auto sc = scoreFromProps(res->getGraphProps());
+        if (enlarger) enlarger->shrink(res);
+        cr.resultGraphs.push_back(res);
+        if (cfg.writeStats) {
+          cr.totScore.score = cr.totScore.score + sc;
+          cr.jsonScores.push_back(util::json::Dict{
+              {"scores", scoreDict(sc)},
+              {"cached", util::json::Bool{true}}});
+        }
+        cachedComps++;
+        shared::trace::Progress::compDone(sc.full);
+        if (stream) writeDone(i);
+        continue;
+      }
+      delete res;
+    }
+
+    double avgDist = avgStatDist(tg);
+
+    size_t MAX_TRIES = 10;
+
+    LOGTO(DEBUG, std::cerr) << "Average adj. node distance is " << avgDist;
+
+    // on retries, the grid size is reduced to 85% each time
+    std::vector<double> gridSizes;
+    double curDist = avgDist;
+    for (size_t t = 0; t < (cfg.retryOnError ? MAX_TRIES : 1); t++) {
+      gridSizes.push_back(getGridSize(curDist, compCfg));
+      curDist *= 0.85;
+    }
+
+    // contraction and the comb graph are the same for all tries, the
+    // contraction of a smaller grid size would not change the graph
+    // contracted for the largest one
+    auto box = prepareComp(tg, gridSizes.front(), compCfg);
+    CombGraph cg(&tg, compCfg.deg2Heur);
+
+    CompDrawing d;
+    bool drawn = false;
+
+    if (cfg.retryOnError && cfg.retryJobs > 1) {
+      drawn = drawCompSpeculative(cg, box, gridSizes, compCfg, &d);
+    } else {
+      for (size_t t = 0; t < gridSizes.size() && !drawn; t++) {
+        try {
+          d = drawCompOnGrid(cg, box, gridSizes[t], compCfg, 0);
+          drawn = true;
+        } catch (const NoEmbeddingFoundExc& exc) {
+          if (t + 1 < gridSizes.size()) {
+            LOGTO(WARN, std::cerr)
+                << "Retrying with grid size " << gridSizes[t + 1];
+          }
+        }
+      }
+    }
+
+    if (drawn) {
+      compCache.put(key, *d.res, {{"comp-score", scoreDict(d.sc)}});
+      if (enlarger) enlarger->shrink(d.res);
+      shared::trace::Progress::compDone(d.sc.full);
+      writeComp(tg, cg, avgDist, &d, cr.jsonScores, cr.resultGraphs,
+                cr.resultGridGraphs, cr.totScore, compCfg);
+    } else if (cfg.skipOnError) {
+      shared::trace::Progress::compDone();
+      cr.totScore.numNoEmbeddingFound += 1;
+      cr.jsonScores.push_back(util::json::Dict());
+      LOGTO(WARN, std::cerr) << NoEmbeddingFoundExc().what();
+    } else {
+      LOG(ERROR) << NoEmbeddingFoundExc().what();
+      exit(1);
+    }
+
+    if (stream) writeDone(i);
+  }
+
+  drawPhase.done();
+
+  if (compCache.enabled()) {
+    LOGTO(DEBUG, std::cerr) << "Took " << cachedComps << " of " << comps.size()
+                            << " components from the component cache";
+    shared::trace::Metrics::count("cached-components", cachedComps);
+  }
+
+  if (shared::threads::cancelled()) {
+    LOGTO(WARN, std::cerr) << "Drawing cancelled ("
+                           << shared::threads::cancelReason()
+                           << "), writing the best drawings found";
+  }
+
+  for (auto& cr : compRes) {
+    totScore = totScore + cr.totScore;
+    jsonScores.insert(jsonScores.end(), cr.jsonScores.begin(),
+                      cr.jsonScores.end());
+    resultGraphs.insert(resultGraphs.end(), cr.resultGraphs.begin(),
+                        cr.resultGraphs.end());
+    resultGridGraphs.insert(resultGridGraphs.end(),
+                            cr.resultGridGraphs.begin(),
+                            cr.resultGridGraphs.end());
+  }
+
+  TRACE_PHASE("write");
+
+  size_t maxRss = util::getPeakRSS();
+
+  // translate score to JSON
+  util::json::Dict totalScore = util::json::Dict{
+      {"scores", util::json::Dict{{"total-score", totScore.score.full},
+                                  {"topo-violations",
+                                   util::json::Int(totScore.score.violations)},
+                                  {"density-score", totScore.score.dense},
+                                  {"bend-score", totScore.score.bend},
+                                  {"hop-score", totScore.score.hop},
+                                  {"move-score", totScore.score.move}}},
+      {"pens",
+       util::json::Dict{
+           {"density-pen", cfg.pens.densityPen},
+           {"diag-pen", cfg.pens.diagonalPen},
+           {"hori-pen", cfg.pens.horizontalPen},
+           {"vert-pen", cfg.pens.verticalPen},
+           {"180-turn-pen", cfg.pens.p_0},
+           {"135-turn-pen", cfg.pens.p_135},
+           {"90-turn-pen", cfg.pens.p_90},
+           {"45-turn-pen", cfg.pens.p_45},
+       }},
+
+      {"gridgraph-size",
+       util::json::Dict{{"nodes", totScore.gridgraphNumNds},
+                        {"edges", totScore.gridgraphNumEdgs}}},
+      {"combgraph-size",
+       util::json::Dict{{"nodes", totScore.combgraphNumNds},
+                        {"edges", totScore.combgraphNumEdgs}}},
+      {"input-graph-size",
+       util::json::Dict{{"nodes", totScore.inputgraphNumNds},
+                        {"edges", totScore.inputgraphNumEdgs},
+                        {"max-deg", totScore.inputgraphMaxDeg}}},
+      {"misc", util::json::Dict{{"method", cfg.optMode},
+                                {"deg2heur", cfg.deg2Heur},
+                                {"max-grid-dist", cfg.maxGrDist}}},
+      {"num-comps-no-embedding-found", totScore.numNoEmbeddingFound},
+      {"num-comps", comps.size()},
+      {"time-ms", totScore.timeMs},
+      {"iterations", totScore.score.iters},
+      {"procs", omp_get_num_procs()},
+      {"peak-memory", util::readableSize(maxRss)},
+      {"peak-memory-bytes", maxRss},
+      {"timestamp", util::json::Int(std::time(0))}};
+
+  if (cfg.optMode == "ilp") {
+    totalScore["ilp"] = util::json::Dict{
+        {"size", util::json::Dict{{"rows", totScore.ilpstats.rows},
+                                  {"cols", totScore.ilpstats.cols}}},
+        {"solve-time", totScore.ilpstats.time},
+        {"optimal", util::json::Bool{totScore.ilpstats.optimal}}};
+  }
+
+  if (cfg.printMode == "gridgraph") {
+    util::json::Dict props;
+    if (cfg.writeStats) {
+      props = util::json::Dict{{"statistics", totalScore},
+                               {"component-statistics", jsonScores}};
+    }
+
+    octi::basegraph::GridDump dump(cfg.gridDumpFilter, cfg.gridDumpWindow,
+                                   cfg.gridDumpTileSize);
+    for (auto gg : resultGridGraphs) {
+      dump.add(*gg);
+      delete gg;
+    }
+    resultGridGraphs.clear();
+
+    LOGTO(DEBUG, std::cerr) << "Printing " << dump.numNds()
+                            << " grid nodes and " << dump.numEdgs()
+                            << " grid edges";
+
+    if (cfg.gridDumpFormat == "bin") {
+      std::stringstream ss;
+      util::json::Writer wr(&ss, 10);
+      wr.val(props);
+      wr.closeAll();
+      dump.writeBin(outStr, ss.str());
+    } else {
+      util::geo::output::GeoJsonOutput out(*outStr, props);
+      dump.printLatLng(&out);
+      out.flush();
+    }
+  } else if (binOut) {
+    binOut->flush();
+  } else if (jsonOut) {
+    jsonOut->flush();
+  } else if (topoOut) {
+    topoOut->flush();
+  } else if (cfg.outputFormat == "bin") {
+    util::json::Dict props;
+    if (cfg.writeStats) {
+      props = util::json::Dict{{"statistics", totalScore},
+                               {"component-statistics", jsonScores}};
+    }
+    shared::linegraph::BinGraphWriter out(outStr, props);
+    for (auto res : resultGraphs) out.add(*res);
+    out.flush();
+  } else if (cfg.outputFormat == "topojson") {
+    util::json::Dict props;
+    if (cfg.writeStats) {
+      props = util::json::Dict{{"statistics", totalScore},
+                               {"component-statistics", jsonScores}};
+    }
+    shared::linegraph::TopoJsonGraphWriter out(outStr, props);
+    for (auto res : resultGraphs) out.add(*res);
+    out.flush();
+  } else {
+    util::json::Dict props;
+    if (cfg.writeStats) {
+      props = util::json::Dict{{"statistics", totalScore},
+                               {"component-statistics", jsonScores}};
+    }
+    shared::linegraph::JsonGraphWriter out(outStr, props);
+    for (auto res : resultGraphs) out.add(*res);
+    out.flush();
+  }
+
+  return 0;
+}
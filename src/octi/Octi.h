@@ -0,0 +1,18 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef OCTI_OCTI_H_
+#define OCTI_OCTI_H_
+
+#include <iostream>
+
+namespace octi {
+
+// Run octi with the given command line arguments. The input line graph is
+// read from inStr, the schematized graph is written to outStr.
+int run(int argc, char** argv, std::istream* inStr, std::ostream* outStr);
+
+}  // namespace octi
+
+#endif  // OCTI_OCTI_H_
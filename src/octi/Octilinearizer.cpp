@@ -3,7 +3,9 @@
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
 #include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <random>
 #include <thread>
 #include "ilp/ILPGridOptimizer.h"
 #include "octi/Octilinearizer.h"
@@ -17,7 +19,9 @@
 #include "octi/basegraph/OctiQuadTree.h"
 #include "octi/basegraph/OrthoRadialGraph.h"
 #include "octi/basegraph/PseudoOrthoRadialGraph.h"
+#include "octi/basegraph/SparseOctiGridGraph.h"
 #include "octi/combgraph/Drawing.h"
+#include "shared/threads/Cancel.h"
 #include "util/Misc.h"
 #include "util/geo/output/GeoGraphJsonOutput.h"
 #include "util/graph/BiDijkstra.h"
@@ -34,6 +38,7 @@ using octi::combgraph::Drawing;
 using octi::config::OrderMethod;
 using octi::ilp::ILPStats;
 using util::geo::DBox;
+using util::geo::DLine;
 using util::geo::dist;
 using util::geo::DPoint;
 using util::geo::DPolygon;
@@ -43,6 +48,270 @@ using util::geo::Polygon;
 using util::graph::BiDijkstra;
 using util::graph::Dijkstra;
 
+namespace {
+typedef std::set<std::string> LineIds;
+
+// _____________________________________________________________________________
+void addLineIds(const LineEdge* e, LineIds* ids) {
+  for (const auto& lo : e->pl().getLines()) ids->insert(lo.line->id());
+}
+
+// _____________________________________________________________________________
+LineIds lineIds(const LineNode* nd) {
+  LineIds ret;
+  for (auto e : nd->getAdjList()) addLineIds(e, &ret);
+  return ret;
+}
+
+// _____________________________________________________________________________
+LineIds lineIds(const CombEdge* ce) {
+  LineIds ret;
+  for (auto e : ce->pl().getChilds()) addLineIds(e, &ret);
+  return ret;
+}
+
+// _____________________________________________________________________________
+// true if the lines prev of the previous drawing match the lines ids, either
+// exactly or, if the input is a subset of the previous drawing, as a superset
+bool linesMatch(const LineIds& prev, const LineIds& ids, bool subset) {
+  if (!subset) return prev == ids;
+  return std::includes(prev.begin(), prev.end(), ids.begin(), ids.end());
+}
+
+// _____________________________________________________________________________
+// the edge at nd other than e which carries all lines ids, 0 if there is
+// none or more than one
+const LineEdge* nextCarrying(const LineNode* nd, const LineEdge* e,
+                             const LineIds& ids) {
+  const LineEdge* ret = 0;
+  for (auto f : nd->getAdjList()) {
+    if (f == e) continue;
+    LineIds fIds;
+    addLineIds(f, &fIds);
+    if (!linesMatch(fIds, ids, true)) continue;
+    if (ret) return 0;
+    ret = f;
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+// the geometry of a chain of edges from a to b over degree 2 nodes which
+// carries exactly the lines ids, empty if there is none. If subset is set,
+// every edge of the chain has to carry at least the lines ids, and the chain
+// may pass nodes of higher degree where it continues unambiguously.
+DLine getChain(const LineNode* a, const LineNode* b, const LineIds& ids,
+               bool subset) {
+  for (const LineEdge* e : a->getAdjList()) {
+    DLine geom;
+    LineIds chainIds;
+    const LineNode* cur = a;
+
+    while (true) {
+      if (subset) {
+        LineIds eIds;
+        addLineIds(e, &eIds);
+        if (!linesMatch(eIds, ids, true)) break;
+      }
+
+      addLineIds(e, &chainIds);
+      const auto& l = *e->pl().getGeom();
+      if (e->getFrom() == cur) {
+        geom.insert(geom.end(), l.begin(), l.end());
+      } else {
+        geom.insert(geom.end(), l.rbegin(), l.rend());
+      }
+
+      cur = e->getOtherNd(cur);
+      if (cur == a || cur == b) break;
+
+      if (subset) {
+        e = nextCarrying(cur, e, ids);
+        if (!e) break;
+        continue;
+      }
+
+      if (cur->getDeg() != 2) break;
+      e = cur->getAdjList().front() == e ? cur->getAdjList().back()
+                                         : cur->getAdjList().front();
+    }
+
+    if (cur == b && linesMatch(chainIds, ids, subset)) return geom;
+  }
+
+  return {};
+}
+
+// distance between neighboured route regions, in grid cells
+const double REGION_BUFFER = 4;
+
+// _____________________________________________________________________________
+// remove the grid nodes outside of region from nds
+void restrictToRegion(std::set<GridNode*>* nds, const DBox& region) {
+  for (auto it = nds->begin(); it != nds->end();) {
+    if (util::geo::contains(*(*it)->pl().getGeom(), region)) {
+      it++;
+    } else {
+      it = nds->erase(it);
+    }
+  }
+}
+}  // namespace
+
+// _____________________________________________________________________________
+Octilinearizer::Octilinearizer(BaseGraphType baseGraphType, size_t jobs,
+                               double gridMemLimit, bool gridDijkstra,
+                               size_t sparseGrid)
+    : _baseGraphType(baseGraphType),
+      _jobs(jobs),
+      _gridMemLimit(gridMemLimit),
+      _gridDijkstra(gridDijkstra),
+      _sparseGrid(sparseGrid) {
+  if (_jobs == 0) _jobs = std::max(1u, std::thread::hardware_concurrency());
+}
+
+// _____________________________________________________________________________
+size_t Octilinearizer::numJobs(const BaseGraph* gg) const {
+  if (_gridMemLimit <= 0) return _jobs;
+
+  // rough estimate of the memory footprint of a single grid graph copy
+  size_t numEdgs = 0;
+  for (auto nd : gg->getNds()) numEdgs += nd->getAdjList().size();
+  numEdgs /= 2;
+
+  double mem = gridMem(gg->getNds().size(), numEdgs);
+
+  size_t maxJobs = std::max(1.0, (_gridMemLimit * 1024 * 1024) / mem);
+
+  return std::min(_jobs, maxJobs);
+}
+
+// _____________________________________________________________________________
+double Octilinearizer::gridMem(size_t nds, size_t edgs) {
+  return nds * sizeof(GridNode) +
+         edgs * (sizeof(GridEdge) + 2 * sizeof(GridEdge*));
+}
+
+// _____________________________________________________________________________
+GridEstimate Octilinearizer::estimateGrid(BaseGraphType t, size_t sparseGrid,
+                                          const CombGraph& cg, const DBox& box,
+                                          double cellSize, double maxGrDist) {
+  size_t deg = 8;
+  if (t == GRID || t == ORTHORADIAL || t == PSEUDOORTHORADIAL) deg = 4;
+  if (t == HEXGRID) deg = 6;
+
+  double w = box.getUpperRight().getX() - box.getLowerLeft().getX();
+  double h = box.getUpperRight().getY() - box.getLowerLeft().getY();
+
+  // the radial grids cover the box rotated around its center
+  if (t == ORTHORADIAL || t == PSEUDOORTHORADIAL) w = h = std::max(w, h);
+
+  double cells = (ceil(w / cellSize) + 1) * (ceil(h / cellSize) + 1);
+
+  size_t rad = sparseGrid;
+  if (t == BUFFEREDOCTIGRID) rad = std::max<size_t>(ceil(maxGrDist), rad);
+
+  if (rad > 0 && (t == OCTIGRID || t == CONVEXHULLOCTIGRID ||
+                  t == BUFFEREDOCTIGRID)) {
+    // cells at most rad cells away from the input geometries
+    double buffered = 0;
+    for (auto nd : cg.getNds()) {
+      buffered += (2 * rad + 1) * (2 * rad + 1);
+      for (auto e : nd->getAdjList()) {
+        if (e->getFrom() != nd) continue;
+        for (auto chld : e->pl().getChilds()) {
+          buffered += (len(*chld->pl().getGeom()) / cellSize) * (2 * rad + 1);
+        }
+      }
+    }
+    cells = std::min(cells, buffered);
+  }
+
+  // a sink and deg ports per cell, sink edges and in-node edges in both
+  // directions, and deg outgoing grid edges
+  GridEstimate ret;
+  ret.nds = cells * (deg + 1);
+  ret.edgs = cells * (2 * deg + deg * (deg - 1) + deg);
+  ret.bytes = gridMem(ret.nds, ret.edgs);
+  return ret;
+}
+
+// _____________________________________________________________________________
+void Octilinearizer::writeGeoCoursePens(BaseGraph* gg,
+                                        const std::vector<CombEdge*>& edges,
+                                        double pen,
+                                        GeoPensMap* target) const {
+  // create all entries beforehand, the map is not modified afterwards and
+  // each comb edge writes into its own entry
+  std::vector<GeoPens*> pens(edges.size());
+  for (size_t i = 0; i < edges.size(); i++) pens[i] = &(*target)[edges[i]];
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(_jobs)
+  for (size_t i = 0; i < edges.size(); i++) {
+    gg->writeGeoCoursePens(edges[i], pens[i], pen);
+  }
+}
+
+// _____________________________________________________________________________
+bool Octilinearizer::useBidir(const std::set<GridNode*>& frGrNds,
+                              const std::set<GridNode*>& toGrNds) const {
+  if (_bidirDist <= 0 || frGrNds.empty() || toGrNds.empty()) return false;
+
+  // the candidate sets are small and close together, the first nodes are
+  // representative
+  const auto* fr = *frGrNds.begin();
+  const auto* to = *toGrNds.begin();
+
+  double dx = static_cast<double>(fr->pl().getX()) - to->pl().getX();
+  double dy = static_cast<double>(fr->pl().getY()) - to->pl().getY();
+
+  return sqrt(dx * dx + dy * dy) >= _bidirDist;
+}
+
+// _____________________________________________________________________________
+template <typename CostF>
+void Octilinearizer::shortestPath(BaseGraph* gg,
+                                  const std::set<GridNode*>& frGrNds,
+                                  const std::set<GridNode*>& toGrNds,
+                                  const CostF& cost, GrEdgList* eL,
+                                  GrNdList* nL) const {
+  auto heur = gg->getHeur(toGrNds);
+  auto router = _gridDijkstra ? gg->getGridDijkstra() : 0;
+
+  if (router) {
+    // use the concrete heuristic type if possible to allow inlining
+    auto gridHeur = dynamic_cast<const GridGraphHeur*>(heur);
+    if (gridHeur && useBidir(frGrNds, toGrNds)) {
+      GridGraphHeur revHeur(gridHeur->g, frGrNds, true);
+      router->shortestPathBidir(frGrNds, toGrNds, cost, *gridHeur, revHeur, eL,
+                                nL);
+    } else if (gridHeur) {
+      router->shortestPath(frGrNds, toGrNds, cost, *gridHeur, eL, nL);
+    } else {
+      router->shortestPath(frGrNds, toGrNds, cost, *heur, eL, nL);
+    }
+  } else {
+    Dijkstra::shortestPath(frGrNds, toGrNds, cost, *heur, eL, nL);
+  }
+
+  delete heur;
+}
+
+// _____________________________________________________________________________
+template <typename CostF>
+void Octilinearizer::shortestPath(BaseGraph* gg,
+                                  const std::set<GridNode*>& frGrNds,
+                                  const std::set<GridNode*>& toGrNds,
+                                  const CostF& cost, const DBox* region,
+                                  GrEdgList* eL, GrNdList* nL) const {
+  if (region) {
+    shortestPath(gg, frGrNds, toGrNds, GridCostRegion<CostF>(cost, region), eL,
+                 nL);
+  } else {
+    shortestPath(gg, frGrNds, toGrNds, cost, eL, nL);
+  }
+}
+
 // _____________________________________________________________________________
 Score Octilinearizer::drawILP(
     const CombGraph& cg, const util::geo::DBox& box, LineGraph* outTg,
@@ -51,7 +320,8 @@ Score Octilinearizer::drawILP(
     double enfGeoPen, size_t hananIters, int timeLim,
     const std::string& cacheDir, double cacheThreshold, int numThreads,
     octi::ilp::ILPStats* stats, const std::string& solverStr,
-    const std::string& path) {
+    const std::string& path, size_t ilpWindow, size_t ilpCorridor,
+    bool ilpCacheModel) {
   BaseGraph* gg;
   Drawing drawing;
 
@@ -67,12 +337,14 @@ Score Octilinearizer::drawILP(
     // important: always use restrLocSearch here!
     auto score = draw(cg, box, &tmpOutTg, &gg, &drawing, pensCpy, gridSize,
                       borderRad, maxGrDist, orderMethod, true, enfGeoPen,
-                      hananIters, {}, 100, std::numeric_limits<size_t>::max());
+                      hananIters, {}, 100, std::numeric_limits<size_t>::max(),
+                      0);
     if (score.violations) throw NoEmbeddingFoundExc();
     LOGTO(DEBUG, std::cerr) << "Presolving finished.";
   } catch (const NoEmbeddingFoundExc& exc) {
     LOGTO(DEBUG, std::cerr) << "Presolve was not successful.";
-    gg = newBaseGraph(box, cg, gridSize, borderRad, hananIters, pensCpy);
+    gg = newBaseGraph(box, cg, gridSize, borderRad, hananIters, maxGrDist,
+                      pensCpy);
     gg->init();
     drawing = Drawing(gg);
   }
@@ -84,9 +356,7 @@ Score Octilinearizer::drawILP(
     auto edges = getOrdering(cg, OrderMethod::NUM_LINES);
     LOGTO(DEBUG, std::cerr) << "Writing geopens for " << edges.size() << " edges";
     T_START(geopens);
-    for (auto cmbEdg : edges) {
-      gg->writeGeoCoursePens(cmbEdg, &enfGeoPens, enfGeoPen);
-    }
+    writeGeoCoursePens(gg, edges, enfGeoPen, &enfGeoPens);
     LOGTO(DEBUG, std::cerr) << "Done. (" << T_STOP(geopens) << "ms)";
     geoPens = &enfGeoPens;
   }
@@ -102,9 +372,13 @@ Score Octilinearizer::drawILP(
 
   ilp::ILPGridOptimizer ilpoptim;
 
-  *stats =
-      ilpoptim.optimize(gg, cg, &drawing, maxGrDist, noSolve, geoPens, timeLim,
-                        cacheDir, cacheThreshold, numThreads, solverStr, path);
+  // with ilpWindow set, the presolved drawing is improved by small ILPs over
+  // windows of ilpWindow x ilpWindow cells, with ilpCorridor set, the single
+  // ILP only considers cells at most ilpCorridor cells away from it
+  *stats = ilpoptim.optimize(gg, cg, &drawing, maxGrDist, noSolve, geoPens,
+                             timeLim, cacheDir, cacheThreshold, numThreads,
+                             solverStr, path, ilpWindow, ilpCorridor, _jobs,
+                             ilpCacheModel);
 
   drawing.getLineGraph(outTg);
   *retGg = gg;
@@ -124,19 +398,29 @@ Score Octilinearizer::draw(const CombGraph& cg, const DBox& box,
                            OrderMethod orderMethod, bool restrLocSearch,
                            double enfGeoPen, size_t hananIters,
                            const std::vector<Polygon<double>>& obstacles,
-                           size_t locSearchIters, size_t abortAfter) {
-  size_t jobs = 4;
-  std::vector<BaseGraph*> ggs(jobs);
-
+                           size_t locSearchIters, size_t abortAfter,
+                           double coarseFactor) {
   LOGTO(DEBUG, std::cerr) << "Creating grid graphs... ";
   T_START(ggraph);
-#pragma omp parallel for
-  for (size_t i = 0; i < jobs; i++) {
-    ggs[i] = newBaseGraph(box, cg, gridSize, borderRad, hananIters, pens);
+
+  // build the first grid graph alone to get an estimate of its size
+  BaseGraph* firstGg =
+      newBaseGraph(box, cg, gridSize, borderRad, hananIters, maxGrDist, pens);
+  firstGg->init();
+
+  size_t jobs = numJobs(firstGg);
+  std::vector<BaseGraph*> ggs(jobs);
+  ggs[0] = firstGg;
+
+#pragma omp parallel for num_threads(jobs)
+  for (size_t i = 1; i < jobs; i++) {
+    ggs[i] = newBaseGraph(box, cg, gridSize, borderRad, hananIters,
+                          maxGrDist, pens);
     ggs[i]->init();
   }
 
-  LOGTO(DEBUG, std::cerr) << "Done. (" << T_STOP(ggraph) << "ms)";
+  LOGTO(DEBUG, std::cerr) << "Done. (" << T_STOP(ggraph) << "ms, " << jobs
+                          << " job(s))";
 
   LOGTO(DEBUG, std::cerr) << "Grid graph has " << ggs[0]->getNds().size()
                           << " nodes";
@@ -153,12 +437,7 @@ Score Octilinearizer::draw(const CombGraph& cg, const DBox& box,
   if (enfGeoPen > 0) {
     LOGTO(DEBUG, std::cerr) << "Writing geopens for " << edges.size() << " edges";
     T_START(geopens);
-    size_t i = 0;
-    for (auto cmbEdg : edges) {
-      i++;
-      LOGTO(DEBUG, std::cerr) << "@ " << i << "/" << edges.size();
-      ggs[0]->writeGeoCoursePens(cmbEdg, &enfGeoPens, enfGeoPen);
-    }
+    writeGeoCoursePens(ggs[0], edges, enfGeoPen, &enfGeoPens);
     LOGTO(DEBUG, std::cerr) << "Done. (" << T_STOP(geopens) << "ms)";
     geoPens = &enfGeoPens;
   }
@@ -166,11 +445,26 @@ Score Octilinearizer::draw(const CombGraph& cg, const DBox& box,
   if (obstacles.size()) {
     LOGTO(DEBUG, std::cerr) << "Writing obstacles... ";
     T_START(obstacles);
-    for (auto gg : ggs)
-      for (const auto& obst : obstacles) gg->addObstacle(obst);
+    // all grid copies share the same layout and thus the same mask
+    auto mask = std::make_shared<const basegraph::ObstacleMask>(
+        ggs[0]->getObstacleMask(obstacles));
+    for (auto gg : ggs) gg->setObstacleMask(mask);
     LOGTO(DEBUG, std::cerr) << "Done. (" << T_STOP(obstacles) << "ms)";
   }
 
+  Corridor corridor;
+  const Corridor* corr = 0;
+
+  if (_prev && getPrevCorridor(cg, ggs[0], maxGrDist, &corridor)) {
+    corr = &corridor;
+  } else if (coarseFactor > 1 &&
+             getCorridor(cg, box, ggs[0], pens, gridSize * coarseFactor,
+                         borderRad, maxGrDist, orderMethod, restrLocSearch,
+                         enfGeoPen, hananIters, obstacles, locSearchIters,
+                         &corridor)) {
+    corr = &corridor;
+  }
+
   // this is the best drawing
   Drawing drawing(ggs[0]);
 
@@ -185,44 +479,91 @@ Score Octilinearizer::draw(const CombGraph& cg, const DBox& box,
     methods = {orderMethod};
   }
 
-  std::vector<std::vector<OrderMethod>> batches(jobs);
+  // with route regions, the ordering methods are tried one after another,
+  // the jobs draw the regions of each. Only if this fails, the tries below
+  // are used
+  bool regions =
+      _routeRegions > 1 && abortAfter == std::numeric_limits<size_t>::max();
+
+  // each try is an ordering method and a seed, 0 means an unchanged ordering
+  std::vector<std::vector<std::pair<OrderMethod, size_t>>> batches(jobs);
   for (size_t i = 0; i < methods.size(); i++) {
-    batches[i % jobs].push_back(methods[i]);
+    batches[i % jobs].push_back({methods[i], 0});
+  }
+
+  // spare jobs try perturbed variants of the orderings
+  if (abortAfter == std::numeric_limits<size_t>::max()) {
+    for (size_t i = methods.size(); i < jobs; i++) {
+      batches[i].push_back({methods[i % methods.size()], i});
+    }
   }
 
   LOGTO(DEBUG, std::cerr) << "Searching initial drawing... ";
 
-#pragma omp parallel for
-  for (size_t btch = 0; btch < jobs; btch++) {
-    for (OrderMethod meth : batches[btch]) {
+  while (true) {
+    // the score of the best drawing found so far, running tries are
+    // aborted once they cannot beat it anymore
+    std::atomic<double> bestScore(drawing.score());
+
+    for (size_t i = 0; regions && i < methods.size(); i++) {
       T_START(draw);
-      Drawing drawingCp(ggs[btch]);
+      Drawing drawingCp(ggs[0]);
 
-      // get a randomized ordering
-      std::vector<CombEdge*> iterOrder = getOrdering(cg, meth);
+      auto status = drawRegions(getOrdering(cg, methods[i]), box, ggs,
+                                &drawingCp, maxGrDist, geoPens, corr);
 
-      double bestScoreSoFar = 0;
+      statLine(status, std::string("Regions ") + std::to_string(methods[i]),
+               drawingCp, T_STOP(draw), "*");
 
-#pragma omp critical
-      { bestScoreSoFar = drawing.score(); }
+      if (status == DRAWN && drawingCp.score() < drawing.score()) {
+        drawing = drawingCp;
+      }
+    }
+
+    if (regions && drawing.score() == INF && !cancelled()) {
+      LOGTO(DEBUG, std::cerr) << "No drawing in regions, retrying without...";
+      regions = false;
+    }
+
+#pragma omp parallel for num_threads(jobs)
+    for (size_t btch = 0; btch < jobs; btch++) {
+      if (regions) continue;
+      for (const auto& tr : batches[btch]) {
+        OrderMethod meth = tr.first;
+        T_START(draw);
+        Drawing drawingCp(ggs[btch]);
 
-      auto status = draw(iterOrder, ggs[btch], &drawingCp, bestScoreSoFar,
-                         maxGrDist, geoPens, abortAfter);
+        std::vector<CombEdge*> iterOrder = getOrdering(cg, meth);
+        if (tr.second) perturbOrdering(&iterOrder, tr.second);
 
-      drawingCp.eraseFromGrid(ggs[btch]);
+        auto status = draw(iterOrder, ggs[btch], &drawingCp, bestScore,
+                           maxGrDist, geoPens, corr, abortAfter, &bestScore);
 
-      statLine(status, std::string("Try ") + std::to_string(meth), drawingCp,
-               T_STOP(draw), "*");
+        drawingCp.eraseFromGrid(ggs[btch]);
+
+        statLine(status,
+                 std::string("Try ") + std::to_string(meth) +
+                     (tr.second ? "/" + std::to_string(tr.second) : ""),
+                 drawingCp, T_STOP(draw), "*");
 
 #pragma omp critical
-      {
-        if (status == DRAWN && drawingCp.score() < drawing.score()) {
-          drawing = drawingCp;
-        } else {
-          drawingCp.crumble();
+        {
+          if (status == DRAWN && drawingCp.score() < drawing.score()) {
+            drawing = drawingCp;
+            bestScore = drawing.score();
+          } else {
+            drawingCp.crumble();
+          }
         }
       }
     }
+
+    if (drawing.score() != INF || !corr || cancelled()) break;
+
+    // the corridor was too narrow, search on the full grid
+    LOGTO(DEBUG, std::cerr) << "No drawing inside corridor, retrying on full "
+                               "grid...";
+    corr = 0;
   }
 
   if (drawing.score() == INF) throw NoEmbeddingFoundExc();
@@ -244,21 +585,32 @@ Score Octilinearizer::draw(const CombGraph& cg, const DBox& box,
   size_t c = 0;
   for (auto nd : cg.getNds()) {
     if (nd->getDeg() == 0) continue;
+    if (corr && corr->fixed.count(nd)) continue;
     batchesLoc[c % jobs].push_back(nd);
     c++;
   }
 
   for (; iters < LOCAL_SEARCH_ITERS; iters++) {
+    // the drawing is valid after every iteration, a cancelled run keeps it
+    if (cancelled() || shared::threads::cancelled()) break;
     T_START(iter);
-    std::vector<Drawing> bestFrIters(jobs);
 
-#pragma omp parallel for
+    // the best improving move found for each node, per batch
+    std::vector<std::vector<LocMove>> moves(jobs);
+
+#pragma omp parallel for num_threads(jobs)
     for (size_t btch = 0; btch < jobs; btch++) {
+      // a single working copy per batch, all changes made while testing a
+      // node are rolled back afterwards
+      Drawing drawingCp = drawing;
+
+      // use the batches grid graph
+      drawingCp.setBaseGraph(ggs[btch]);
+
       for (auto a : batchesLoc[btch]) {
-        Drawing drawingCp = drawing;
+        LocMove best{a, 0, drawing.score(), DBox()};
 
-        // use the batches grid graph
-        drawingCp.setBaseGraph(ggs[btch]);
+        drawingCp.begin();
 
         // reverting a
         std::vector<CombEdge*> test;
@@ -288,52 +640,94 @@ Score Octilinearizer::draw(const CombGraph& cg, const DBox& box,
             if (gridD >= maxDis) continue;
           }
 
-          Drawing run = drawingCp;
+          drawingCp.begin();
+
+          // we can use best.score as the limit for the shortest path
+          // computation, as we can already do at least as good.
+          auto error = draw(test, p, ggs[btch], &drawingCp, best.score,
+                            maxGrDist, geoPens, corr,
+                            std::numeric_limits<size_t>::max());
 
-          // we can use bestFromIter.score() as the limit for the shortest
-          // path computation, as we can already do at least as good.
-          auto error =
-              draw(test, p, ggs[btch], &run, bestFrIters[btch].score(),
-                   maxGrDist, geoPens, std::numeric_limits<size_t>::max());
+          if (!error && best.score > drawingCp.score()) {
+            best.grNd = n->pl().getId();
+            best.score = drawingCp.score();
 
-          if (!error && bestFrIters[btch].score() > run.score()) {
-            bestFrIters[btch] = run;
+            // the grid region touched by this move, before and after
+            best.box = DBox();
+            extendByPaths(drawing, a, ggs[btch], &best.box);
+            extendByPaths(drawingCp, a, ggs[btch], &best.box);
+            best.box = util::geo::pad(best.box, ggs[btch]->getCellSize());
           }
 
           // reset grid
-          for (auto ce : a->getAdjList()) run.eraseFromGrid(ce, ggs[btch]);
+          for (auto ce : a->getAdjList())
+            drawingCp.eraseFromGrid(ce, ggs[btch]);
           if (ggs[btch]->isSettled(a)) ggs[btch]->unSettleNd(a);
+
+          drawingCp.rollback();
         }
 
+        drawingCp.rollback();
+
         ggs[btch]->settleNd(const_cast<GridNode*>(ggs[btch]->getGrNdById(
                                 drawing.getGrNd(a)->pl().getId())),
                             a);
 
         // re-settle edges
         for (auto ce : a->getAdjList()) drawing.applyToGrid(ce, ggs[btch]);
+
+        if (best.score < drawing.score()) moves[btch].push_back(best);
       }
     }
 
-    size_t bestCore = 0;
-    double bestScore = std::numeric_limits<double>::infinity();
-    for (size_t i = 0; i < jobs; i++) {
-      if (bestFrIters[i].score() < bestScore) {
-        bestScore = bestFrIters[i].score();
-        bestCore = i;
+    // commit as many non-conflicting moves as possible, best first. Two
+    // moves conflict if the nodes are adjacent or share a neighbor, or if
+    // the grid regions they touch overlap.
+    std::vector<LocMove> allMoves;
+    for (const auto& m : moves) {
+      allMoves.insert(allMoves.end(), m.begin(), m.end());
+    }
+    std::sort(allMoves.begin(), allMoves.end(),
+              [](const LocMove& a, const LocMove& b) {
+                return a.score < b.score;
+              });
+
+    Drawing prev = drawing;
+    std::set<const CombNode*> blocked;
+    std::vector<DBox> touched;
+    size_t committed = 0;
+
+    for (const auto& m : allMoves) {
+      if (blocked.count(m.nd)) continue;
+
+      bool conflict = false;
+      for (auto ce : m.nd->getAdjList()) {
+        if (blocked.count(ce->getOtherNd(m.nd))) conflict = true;
       }
+      for (const auto& b : touched) {
+        if (conflict) break;
+        conflict = util::geo::intersects(b, m.box);
+      }
+      if (conflict) continue;
+
+      if (!applyMove(m, ggs[0], &drawing, maxGrDist, geoPens, corr)) continue;
+
+      committed++;
+      touched.push_back(m.box);
+      blocked.insert(m.nd);
+      for (auto ce : m.nd->getAdjList()) blocked.insert(ce->getOtherNd(m.nd));
     }
 
-    double imp = (drawing.score() - bestFrIters[bestCore].score());
+    double imp = (prev.score() - drawing.score());
     LOGTO(DEBUG, std::cerr)
-        << " ++ Iter " << iters << ", prev " << drawing.score() << ", next "
-        << bestFrIters[bestCore].score() << " (" << (imp >= 0 ? "+" : "") << imp
-        << ", " << T_STOP(iter) << " ms)";
+        << " ++ Iter " << iters << ", prev " << prev.score() << ", next "
+        << drawing.score() << " (" << (imp >= 0 ? "+" : "") << imp << ", "
+        << committed << " move(s), " << T_STOP(iter) << " ms)";
 
-    for (size_t i = 0; i < jobs; i++) {
-      drawing.eraseFromGrid(ggs[i]);
-      bestFrIters[bestCore].applyToGrid(ggs[i]);
+    for (size_t i = 1; i < jobs; i++) {
+      prev.eraseFromGrid(ggs[i]);
+      drawing.applyToGrid(ggs[i]);
     }
-    drawing = bestFrIters[bestCore];
 
     if (imp < CONVERGENCE_THRESHOLD) break;
   }
@@ -352,10 +746,238 @@ Score Octilinearizer::draw(const CombGraph& cg, const DBox& box,
   // the drawing might still have another internal grid graph, make sure they
   // match (this is important for drawILP)
   dOut->setBaseGraph(ggs[0]);
+
+  // only the first grid graph is handed out
+  for (size_t i = 1; i < jobs; i++) delete ggs[i];
   fullScore.iters = iters;
   return fullScore;
 }
 
+// _____________________________________________________________________________
+void Octilinearizer::extendByPaths(const Drawing& d, const CombNode* nd,
+                                   const BaseGraph* gg, DBox* box) const {
+  for (auto ce : nd->getAdjList()) {
+    auto it = d.getEdgPaths().find(ce);
+    if (it == d.getEdgPaths().end()) continue;
+    for (const auto& e : it->second) {
+      *box = util::geo::extendBox(*gg->getGrNdById(e.first)->pl().getGeom(),
+                                  *box);
+      *box = util::geo::extendBox(*gg->getGrNdById(e.second)->pl().getGeom(),
+                                  *box);
+    }
+  }
+}
+
+// _____________________________________________________________________________
+bool Octilinearizer::applyMove(const LocMove& m, BaseGraph* gg,
+                               Drawing* drawing, double maxGrDist,
+                               const GeoPensMap* geoPens,
+                               const Corridor* corr) {
+  auto a = m.nd;
+  double before = drawing->score();
+
+  drawing->begin();
+
+  std::vector<CombEdge*> test;
+  for (auto ce : a->getAdjList()) {
+    test.push_back(ce);
+
+    drawing->eraseFromGrid(ce, gg);
+    drawing->erase(ce);
+  }
+
+  auto oldGrNdId = drawing->getGrNd(a)->pl().getId();
+
+  drawing->erase(a);
+  gg->unSettleNd(a);
+
+  SettledPos p;
+  p[a] = gg->getGrNdById(m.grNd);
+
+  // earlier moves in this iteration may have changed the surroundings, so
+  // the move is only kept if it still improves the drawing
+  auto error = draw(test, p, gg, drawing, before, maxGrDist, geoPens, corr,
+                    std::numeric_limits<size_t>::max());
+
+  if (!error && drawing->score() < before) {
+    drawing->commit();
+    return true;
+  }
+
+  for (auto ce : a->getAdjList()) drawing->eraseFromGrid(ce, gg);
+  if (gg->isSettled(a)) gg->unSettleNd(a);
+
+  drawing->rollback();
+
+  gg->settleNd(gg->getGrNdById(oldGrNdId), a);
+  for (auto ce : a->getAdjList()) drawing->applyToGrid(ce, gg);
+
+  return false;
+}
+
+// _____________________________________________________________________________
+bool Octilinearizer::getCorridor(
+    const CombGraph& cg, const DBox& box, BaseGraph* gg, const Penalties& pens,
+    double coarseSize, double borderRad, double maxGrDist,
+    OrderMethod orderMethod, bool restrLocSearch, double enfGeoPen,
+    size_t hananIters, const std::vector<Polygon<double>>& obstacles,
+    size_t locSearchIters, Corridor* corr) {
+  LOGTO(DEBUG, std::cerr) << "Drawing on coarse grid with cell size "
+                          << coarseSize << "...";
+  T_START(coarse);
+
+  LineGraph tmpOutTg;
+  BaseGraph* coarseGg = 0;
+  Drawing coarseDrawing;
+
+  try {
+    draw(cg, box, &tmpOutTg, &coarseGg, &coarseDrawing, pens, coarseSize,
+         borderRad, maxGrDist, orderMethod, restrLocSearch, enfGeoPen,
+         hananIters, obstacles, locSearchIters,
+         std::numeric_limits<size_t>::max(), 0);
+  } catch (const NoEmbeddingFoundExc& exc) {
+    LOGTO(DEBUG, std::cerr) << "No coarse drawing found, using full grid.";
+    return false;
+  }
+
+  // nodes may move by one coarse cell, edges may leave their coarse route by
+  // one coarse cell
+  double cellSize = gg->getCellSize();
+  corr->ndRad = ceil(coarseSize / cellSize) + 1;
+  double maxD = coarseSize + cellSize;
+
+  for (auto nd : cg.getNds()) {
+    if (nd->getDeg() == 0) continue;
+    corr->ndPos[nd] = *coarseDrawing.getGrNd(nd)->pl().getGeom();
+  }
+
+  // create all entries beforehand, see writeGeoCoursePens()
+  std::vector<std::pair<GeoPens*, util::geo::DLine>> edgs;
+  for (const auto& ep : coarseDrawing.getEdgPaths()) {
+    edgs.push_back({&corr->edgs[ep.first],
+                    coarseGg->geomFromPath(ep.second).getLine()});
+  }
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(_jobs)
+  for (size_t i = 0; i < edgs.size(); i++) {
+    gg->writeCorridor(edgs[i].second, maxD, edgs[i].first);
+  }
+
+  delete coarseGg;
+
+  LOGTO(DEBUG, std::cerr) << "Done. (" << T_STOP(coarse) << "ms)";
+
+  return true;
+}
+
+// _____________________________________________________________________________
+bool Octilinearizer::getPrevCorridor(const CombGraph& cg, BaseGraph* gg,
+                                     double maxGrDist, Corridor* corr) const {
+  LOGTO(DEBUG, std::cerr) << "Matching against previous drawing...";
+  T_START(prev);
+
+  double cellSize = gg->getCellSize();
+
+  std::map<std::string, const LineNode*> prevStats;
+  for (auto nd : _prev->getNds()) {
+    for (const auto& st : nd->pl().stops()) {
+      if (st.id.size()) prevStats[st.id] = nd;
+    }
+  }
+
+  // the previous node of each comb node is the one with the same station id,
+  // or the nearest one with the same lines around its input position
+  std::map<const CombNode*, const LineNode*> prevNds;
+  std::vector<DPoint> changes;
+
+  for (auto nd : cg.getNds()) {
+    if (nd->getDeg() == 0) continue;
+    auto ln = nd->pl().getParent();
+    auto ids = lineIds(ln);
+    const LineNode* match = 0;
+
+    for (const auto& st : ln->pl().stops()) {
+      auto it = prevStats.find(st.id);
+      if (it != prevStats.end()) match = it->second;
+      if (match) break;
+    }
+
+    if (!match) {
+      std::set<LineNode*> cands;
+      double maxD = cellSize * maxGrDist;
+      _prev->getNdGrid().get(*nd->pl().getGeom(), maxD, &cands);
+      for (auto cand : cands) {
+        double d = dist(*cand->pl().getGeom(), *nd->pl().getGeom());
+        if (d > maxD || !linesMatch(lineIds(cand), ids, _prevSubset)) continue;
+        maxD = d;
+        match = cand;
+      }
+    }
+
+    if (match && linesMatch(lineIds(match), ids, _prevSubset)) {
+      prevNds[nd] = match;
+    } else {
+      changes.push_back(*nd->pl().getGeom());
+    }
+  }
+
+  // previous routes of the comb edges
+  std::map<const CombEdge*, DLine> prevEdgs;
+
+  for (auto nd : cg.getNds()) {
+    for (auto ce : nd->getAdjList()) {
+      if (ce->getFrom() != nd) continue;
+      auto a = prevNds.find(ce->getFrom());
+      auto b = prevNds.find(ce->getTo());
+      if (a != prevNds.end() && b != prevNds.end()) {
+        auto geom =
+            getChain(a->second, b->second, lineIds(ce), _prevSubset);
+        if (geom.size()) {
+          prevEdgs[ce] = geom;
+          continue;
+        }
+      }
+      changes.push_back(*ce->getFrom()->pl().getGeom());
+      changes.push_back(*ce->getTo()->pl().getGeom());
+    }
+  }
+
+  // nodes near a change are redrawn, but start at their previous position
+  double rad = cellSize * _prevRad;
+
+  for (const auto& p : prevNds) {
+    corr->ndPos[p.first] = *p.second->pl().getGeom();
+
+    bool changed = false;
+    for (const auto& c : changes) {
+      if (dist(c, *p.first->pl().getGeom()) > rad) continue;
+      changed = true;
+      break;
+    }
+
+    if (!changed) corr->fixed.insert(p.first);
+  }
+
+  // create all entries beforehand, see writeGeoCoursePens()
+  std::vector<std::pair<GeoPens*, const DLine*>> edgs;
+  for (const auto& pe : prevEdgs) {
+    if (!corr->fixed.count(pe.first->getFrom())) continue;
+    if (!corr->fixed.count(pe.first->getTo())) continue;
+    edgs.push_back({&corr->edgs[pe.first], &pe.second});
+  }
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(_jobs)
+  for (size_t i = 0; i < edgs.size(); i++) {
+    gg->writeCorridor(*edgs[i].second, cellSize, edgs[i].first);
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Done. (" << T_STOP(prev) << "ms, keeping "
+                          << corr->fixed.size() << " of " << cg.getNds().size()
+                          << " nodes and " << edgs.size() << " edges)";
+
+  return corr->fixed.size();
+}
+
 // _____________________________________________________________________________
 void Octilinearizer::settleRes(GridNode* frGrNd, GridNode* toGrNd,
                                BaseGraph* gg, CombNode* from, CombNode* to,
@@ -386,10 +1008,12 @@ void Octilinearizer::writeNdCosts(GridNode* n, CombNode* origNode, CombEdge* e,
 Undrawable Octilinearizer::draw(const std::vector<CombEdge*>& order,
                                 BaseGraph* gg, Drawing* drawing, double cutoff,
                                 double maxGrDist, const GeoPensMap* geoPensMap,
-                                size_t abortAfter) {
+                                const Corridor* corr, size_t abortAfter,
+                                const std::atomic<double>* bestScore,
+                                const DBox* region) {
   SettledPos emptyPos;
   return draw(order, emptyPos, gg, drawing, cutoff, maxGrDist, geoPensMap,
-              abortAfter);
+              corr, abortAfter, bestScore, region);
 }
 
 // _____________________________________________________________________________
@@ -397,12 +1021,23 @@ Undrawable Octilinearizer::draw(const std::vector<CombEdge*>& ord,
                                 const SettledPos& settled, BaseGraph* gg,
                                 Drawing* drawing, double globCutoff,
                                 double maxGrDist, const GeoPensMap* geoPensMap,
-                                size_t abortAfter) {
+                                const Corridor* corr, size_t abortAfter,
+                                const std::atomic<double>* bestScore,
+                                const DBox* region) {
   SettledPos retPos;
 
   size_t i = 0;
 
   for (auto cmbEdg : ord) {
+    if (cancelled()) return NO_PATH;
+
+    if (bestScore) {
+      // another drawing may have finished in the meantime, edge costs are
+      // non-negative, so the partial score is a lower bound of the final one
+      globCutoff = std::min(globCutoff, bestScore->load());
+      if (drawing->score() >= globCutoff) return NO_PATH;
+    }
+
     double cutoff = globCutoff - drawing->score();
     i++;
     if (drawing->score() == std::numeric_limits<double>::infinity()) {
@@ -415,7 +1050,12 @@ Undrawable Octilinearizer::draw(const std::vector<CombEdge*>& ord,
     std::set<GridNode*> frGrNds, toGrNds;
 
     std::tie(frGrNds, toGrNds) =
-        getRtPair(frCmbNd, toCmbNd, settled, gg, maxGrDist);
+        getRtPair(frCmbNd, toCmbNd, settled, gg, maxGrDist, corr);
+
+    if (region) {
+      restrictToRegion(&frGrNds, *region);
+      restrictToRegion(&toGrNds, *region);
+    }
 
     if (frGrNds.size() == 0 || toGrNds.size() == 0) return NO_CANDS;
 
@@ -480,20 +1120,23 @@ Undrawable Octilinearizer::draw(const std::vector<CombEdge*>& ord,
     GridNode* toGrNd = 0;
     GridNode* frGrNd = 0;
 
-    auto heur = gg->getHeur(toGrNds);
-
-    if (geoPensMap) {
+    if (corr && corr->edgs.count(cmbEdg)) {
+      // only route inside the corridor
+      auto cost = GridCostCorridor(
+          cutoff + costOffsetTo + costOffsetFrom,
+          &corr->edgs.find(cmbEdg)->second,
+          geoPensMap ? &geoPensMap->find(cmbEdg)->second : 0);
+      shortestPath(gg, frGrNds, toGrNds, cost, region, &eL, &nL);
+    } else if (geoPensMap) {
       // init cost function with geo distance penalties
       auto cost = GridCostGeoPen(cutoff + costOffsetTo + costOffsetFrom,
                                  &geoPensMap->find(cmbEdg)->second);
-      Dijkstra::shortestPath(frGrNds, toGrNds, cost, *heur, &eL, &nL);
+      shortestPath(gg, frGrNds, toGrNds, cost, region, &eL, &nL);
     } else {
       auto cost = GridCost(cutoff + costOffsetTo + costOffsetFrom);
-      Dijkstra::shortestPath(frGrNds, toGrNds, cost, *heur, &eL, &nL);
+      shortestPath(gg, frGrNds, toGrNds, cost, region, &eL, &nL);
     }
 
-    delete heur;
-
     if (!nL.size()) {
       // cleanup
       for (auto n : toGrNds) gg->closeSinkTo(n);
@@ -527,6 +1170,124 @@ Undrawable Octilinearizer::draw(const std::vector<CombEdge*>& ord,
   return DRAWN;
 }
 
+// _____________________________________________________________________________
+Undrawable Octilinearizer::drawRegions(const std::vector<CombEdge*>& order,
+                                       const DBox& box,
+                                       const std::vector<BaseGraph*>& ggs,
+                                       Drawing* drawing, double maxGrDist,
+                                       const GeoPensMap* geoPensMap,
+                                       const Corridor* corr) {
+  size_t n = _routeRegions;
+  size_t jobs = ggs.size();
+  double cellSize = ggs[0]->getCellSize();
+  double w = (box.getUpperRight().getX() - box.getLowerLeft().getX()) / n;
+  double h = (box.getUpperRight().getY() - box.getLowerLeft().getY()) / n;
+  double buff = REGION_BUFFER * cellSize / 2;
+
+  std::vector<DBox> regions;
+  for (size_t x = 0; x < n; x++) {
+    for (size_t y = 0; y < n; y++) {
+      DPoint ll(box.getLowerLeft().getX() + x * w + buff,
+                box.getLowerLeft().getY() + y * h + buff);
+      DPoint ur(ll.getX() + w - 2 * buff, ll.getY() + h - 2 * buff);
+      regions.push_back(DBox(ll, ur));
+    }
+  }
+
+  // an edge lies inside a region if all candidate grid nodes of its end
+  // points do
+  double rad = (std::max<double>(maxGrDist, corr ? corr->ndRad : 0) + 1) *
+               cellSize;
+
+  std::vector<std::vector<CombEdge*>> inner(regions.size());
+  for (auto e : order) {
+    DBox fp;
+    for (auto nd : {e->getFrom(), e->getTo()}) {
+      if (corr && corr->ndPos.count(nd)) {
+        fp = util::geo::extendBox(corr->ndPos.find(nd)->second, fp);
+      } else {
+        fp = util::geo::extendBox(*nd->pl().getGeom(), fp);
+      }
+    }
+    fp = util::geo::pad(fp, rad);
+
+    for (size_t i = 0; i < regions.size(); i++) {
+      if (util::geo::contains(fp, regions[i])) {
+        inner[i].push_back(e);
+        break;
+      }
+    }
+  }
+
+  // distribute the regions over the jobs, biggest first
+  std::vector<size_t> bySize(regions.size());
+  for (size_t i = 0; i < regions.size(); i++) bySize[i] = i;
+  std::sort(bySize.begin(), bySize.end(), [&inner](size_t a, size_t b) {
+    return inner[a].size() > inner[b].size();
+  });
+
+  std::vector<std::vector<size_t>> batches(jobs);
+  std::vector<size_t> load(jobs, 0);
+  for (auto i : bySize) {
+    if (inner[i].empty()) break;
+    size_t j = std::min_element(load.begin(), load.end()) - load.begin();
+    batches[j].push_back(i);
+    load[j] += inner[i].size();
+  }
+
+  std::vector<Drawing> drawings(regions.size());
+  std::vector<Undrawable> status(regions.size(), NO_PATH);
+
+#pragma omp parallel for num_threads(jobs)
+  for (size_t btch = 0; btch < jobs; btch++) {
+    for (auto i : batches[btch]) {
+      drawings[i] = Drawing(ggs[btch]);
+      status[i] = draw(inner[i], ggs[btch], &drawings[i], INF, maxGrDist,
+                       geoPensMap, corr, std::numeric_limits<size_t>::max(),
+                       0, &regions[i]);
+
+      // the edges of regions which could not be drawn are left to the
+      // serial pass
+      if (status[i] != DRAWN) {
+        drawings[i].eraseFromGrid(ggs[btch]);
+        drawings[i].crumble();
+      }
+    }
+
+    for (auto i : batches[btch]) drawings[i].eraseFromGrid(ggs[btch]);
+  }
+
+  for (size_t i = 0; i < regions.size(); i++) {
+    if (status[i] == DRAWN) drawing->merge(drawings[i]);
+  }
+
+  std::vector<CombEdge*> rest;
+  for (auto e : order) {
+    if (!drawing->drawn(e)) rest.push_back(e);
+  }
+
+  LOGTO(DEBUG, std::cerr) << order.size() - rest.size() << " edges drawn in "
+                          << regions.size() << " regions, " << rest.size()
+                          << " remaining";
+
+  drawing->applyToGrid(ggs[0]);
+  auto ret = draw(rest, ggs[0], drawing, INF, maxGrDist, geoPensMap, corr,
+                  std::numeric_limits<size_t>::max());
+  drawing->eraseFromGrid(ggs[0]);
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void Octilinearizer::perturbOrdering(std::vector<CombEdge*>* order,
+                                     size_t seed) {
+  std::mt19937 rng(seed);
+  std::bernoulli_distribution swap(0.25);
+  for (size_t i = 1; i < order->size(); i++) {
+    if (swap(rng)) std::swap((*order)[i - 1], (*order)[i]);
+  }
+}
+
 // _____________________________________________________________________________
 std::vector<CombEdge*> Octilinearizer::getOrdering(
     const CombGraph& cg, config::OrderMethod method) const {
@@ -564,11 +1325,11 @@ std::vector<CombEdge*> Octilinearizer::getOrdering(
 // _____________________________________________________________________________
 RtPair Octilinearizer::getRtPair(CombNode* frCmbNd, CombNode* toCmbNd,
                                  const SettledPos& preSettled, BaseGraph* gg,
-                                 double maxGrDist) {
+                                 double maxGrDist, const Corridor* corr) {
   // shortcut
   if (gg->getSettled(frCmbNd) && gg->getSettled(toCmbNd)) {
-    return {getCands(frCmbNd, preSettled, gg, 0),
-            getCands(toCmbNd, preSettled, gg, 0)};
+    return {getCands(frCmbNd, preSettled, gg, 0, corr),
+            getCands(toCmbNd, preSettled, gg, 0, corr)};
   }
 
   std::set<GridNode*> frGrNds, toGrNds;
@@ -576,8 +1337,8 @@ RtPair Octilinearizer::getRtPair(CombNode* frCmbNd, CombNode* toCmbNd,
   size_t i = 0;
 
   while ((!frGrNds.size() || !toGrNds.size()) && i < 10) {
-    auto frCands = getCands(frCmbNd, preSettled, gg, maxGrDist);
-    auto toCands = getCands(toCmbNd, preSettled, gg, maxGrDist);
+    auto frCands = getCands(frCmbNd, preSettled, gg, maxGrDist, corr);
+    auto toCands = getCands(toCmbNd, preSettled, gg, maxGrDist, corr);
 
     std::set<GridNode*> isect;
     std::set_intersection(frCands.begin(), frCands.end(), toCands.begin(),
@@ -608,7 +1369,8 @@ RtPair Octilinearizer::getRtPair(CombNode* frCmbNd, CombNode* toCmbNd,
 // _____________________________________________________________________________
 std::set<GridNode*> Octilinearizer::getCands(CombNode* cmbNd,
                                              const SettledPos& preSettled,
-                                             BaseGraph* gg, size_t maxGrDist) {
+                                             BaseGraph* gg, size_t maxGrDist,
+                                             const Corridor* corr) {
   std::set<GridNode*> ret;
 
   const auto& settled = gg->getSettled(cmbNd);
@@ -618,6 +1380,11 @@ std::set<GridNode*> Octilinearizer::getCands(CombNode* cmbNd,
   } else if (preSettled.count(cmbNd)) {
     auto nd = preSettled.find(cmbNd)->second->pl().getParent();
     if (nd && !nd->pl().isClosed()) ret.insert(nd);
+  } else if (corr && corr->ndPos.count(cmbNd)) {
+    // fixed nodes are placed at the grid node at their position
+    size_t rad = std::max(maxGrDist, corr->ndRad);
+    if (corr->fixed.count(cmbNd)) rad = 1;
+    ret = gg->getGrNdCands(cmbNd, corr->ndPos.find(cmbNd)->second, rad);
   } else {
     ret = gg->getGrNdCands(cmbNd, maxGrDist);
   }
@@ -628,14 +1395,27 @@ std::set<GridNode*> Octilinearizer::getCands(CombNode* cmbNd,
 // _____________________________________________________________________________
 BaseGraph* Octilinearizer::newBaseGraph(const DBox& bbox, const CombGraph& cg,
                                         double cellSize, double spacer,
-                                        size_t hananIters,
+                                        size_t hananIters, double maxGrDist,
                                         const Penalties& pens) const {
   switch (_baseGraphType) {
     case OCTIGRID:
+      if (_sparseGrid) {
+        return new SparseOctiGridGraph(util::geo::convexHull(bbox), cg, bbox,
+                                       cellSize, spacer, _sparseGrid, pens);
+      }
       return new OctiGridGraph(bbox, cellSize, spacer, pens);
     case CONVEXHULLOCTIGRID:
+      if (_sparseGrid) {
+        return new SparseOctiGridGraph(hull(cg), cg, bbox, cellSize, spacer,
+                                       _sparseGrid, pens);
+      }
       return new ConvexHullOctiGridGraph(hull(cg), bbox, cellSize, spacer,
                                          pens);
+    case BUFFEREDOCTIGRID:
+      // cells at most maxGrDist cells away from the input geometries
+      return new SparseOctiGridGraph(
+          util::geo::convexHull(bbox), cg, bbox, cellSize, spacer,
+          std::max<size_t>(ceil(maxGrDist), _sparseGrid), pens);
     case GRID:
       return new GridGraph(bbox, cellSize, spacer, pens);
     case ORTHORADIAL:
@@ -645,7 +1425,8 @@ BaseGraph* Octilinearizer::newBaseGraph(const DBox& bbox, const CombGraph& cg,
     case OCTIHANANGRID:
       return new OctiHananGraph(bbox, cg, cellSize, spacer, hananIters, pens);
     case OCTIQUADTREE:
-      return new OctiQuadTree(bbox, cg, cellSize, spacer, pens);
+      return new OctiQuadTree(bbox, cg, cellSize, spacer, pens,
+                              _quadTreeParams);
     case HEXGRID:
       return new HexGridGraph(bbox, cellSize, spacer, pens);
     default:
@@ -693,6 +1474,8 @@ size_t Octilinearizer::maxNodeDeg() const {
       return 8;
     case CONVEXHULLOCTIGRID:
       return 8;
+    case BUFFEREDOCTIGRID:
+      return 8;
     case GRID:
       return 4;
     case ORTHORADIAL:
@@ -5,12 +5,14 @@
 #ifndef OCTI_OCTILINEARIZER_H_
 #define OCTI_OCTILINEARIZER_H_
 
+#include <atomic>
 #include <unordered_set>
 #include <vector>
 
 #include "ilp/ILPGridOptimizer.h"
 #include "octi/basegraph/BaseGraph.h"
 #include "octi/basegraph/GridGraph.h"
+#include "octi/basegraph/OctiQuadTree.h"
 #include "octi/combgraph/CombGraph.h"
 #include "octi/combgraph/Drawing.h"
 #include "octi/config/OctiConfig.h"
@@ -130,7 +132,7 @@ struct GraphMeasures {
   size_t maxDeg;
 };
 
-struct GridCost
+struct GridCost final
     : public util::graph::Dijkstra::CostFunc<GridNodePL, GridEdgePL, float> {
   GridCost(float inf) : _inf(inf) {}
   virtual float operator()(const GridNode* from, const GridEdge* e,
@@ -145,7 +147,7 @@ struct GridCost
   virtual float inf() const { return _inf; }
 };
 
-struct GridCostGeoPen
+struct GridCostGeoPen final
     : public Dijkstra::CostFunc<GridNodePL, GridEdgePL, float> {
   GridCostGeoPen(float inf, const GeoPens* geoPens)
       : _inf(inf), _geoPens(geoPens) {}
@@ -157,8 +159,8 @@ struct GridCostGeoPen
     // ignore geopens for secondary edges
     if (e->pl().isSecondary()) return e->pl().cost();
 
-    auto i = (*_geoPens).find(e->pl().getId());
-    if (i != _geoPens->end()) return e->pl().cost() + i->second;
+    auto pen = _geoPens->find(e->pl().getId());
+    if (pen) return e->pl().cost() + *pen;
 
     // if no geopen was present for grid edge, we assume SOFT_INF penalty
     return e->pl().cost() + octi::basegraph::SOFT_INF;
@@ -170,18 +172,111 @@ struct GridCostGeoPen
   virtual float inf() const { return _inf; }
 };
 
+struct GridCostCorridor final
+    : public Dijkstra::CostFunc<GridNodePL, GridEdgePL, float> {
+  GridCostCorridor(float inf, const GeoPens* corridor, const GeoPens* geoPens)
+      : _inf(inf), _corridor(corridor), _geoPens(geoPens) {}
+  virtual float operator()(const GridNode* from, const GridEdge* e,
+                           const GridNode* to) const {
+    UNUSED(from);
+    UNUSED(to);
+
+    if (e->pl().isSecondary()) return e->pl().cost();
+
+    // grid edges outside the corridor are never used
+    if (!_corridor->find(e->pl().getId())) return _inf;
+
+    if (!_geoPens) return e->pl().cost();
+
+    auto pen = _geoPens->find(e->pl().getId());
+    if (pen) return e->pl().cost() + *pen;
+
+    return e->pl().cost() + octi::basegraph::SOFT_INF;
+  }
+
+  float _inf;
+  const GeoPens* _corridor;
+  const GeoPens* _geoPens;
+
+  virtual float inf() const { return _inf; }
+};
+
+// restriction of the cost function CostF to a region of the grid, grid edges
+// with an end outside of it are never used
+template <typename CostF>
+struct GridCostRegion final
+    : public Dijkstra::CostFunc<GridNodePL, GridEdgePL, float> {
+  GridCostRegion(const CostF& cost, const util::geo::DBox* region)
+      : _cost(cost), _region(region) {}
+  virtual float operator()(const GridNode* from, const GridEdge* e,
+                           const GridNode* to) const {
+    if (!e->pl().isSecondary() &&
+        (!util::geo::contains(*from->pl().getGeom(), *_region) ||
+         !util::geo::contains(*to->pl().getGeom(), *_region))) {
+      return _cost.inf();
+    }
+
+    return _cost(from, e, to);
+  }
+
+  const CostF& _cost;
+  const util::geo::DBox* _region;
+
+  virtual float inf() const { return _cost.inf(); }
+};
+
+// restriction of the search space to the surroundings of a drawing on a
+// coarser grid or of a previous drawing: comb nodes are placed at most ndRad
+// cells around their position in ndPos, comb edges in edgs are routed inside
+// a band around their previous route. Nodes in fixed are placed at the grid
+// node at their position and are not moved by the local search.
+struct Corridor {
+  std::map<const CombNode*, util::geo::DPoint> ndPos;
+  size_t ndRad = 0;
+  GeoPensMap edgs;
+  std::set<const CombNode*> fixed;
+};
+
+// a local search move of a comb node to grid node grNd, resulting in a
+// drawing with the given score. box is the grid region touched by the move.
+struct LocMove {
+  CombNode* nd;
+  size_t grNd;
+  double score;
+  util::geo::DBox box;
+};
+
+// expected size of a single base graph
+struct GridEstimate {
+  size_t nds = 0;
+  size_t edgs = 0;
+  double bytes = 0;
+};
+
 class Octilinearizer {
  public:
   Octilinearizer(basegraph::BaseGraphType baseGraphType)
-      : _baseGraphType(baseGraphType) {}
-
+      : Octilinearizer(baseGraphType, 0, 0, true, 0) {}
+
+  // jobs is the number of parallel workers, 0 means hardware concurrency.
+  // gridMemLimit (in MB) caps the memory used by the per-worker grid graph
+  // copies, 0 means no limit. If gridDijkstra is set, base graphs which
+  // support it are routed with the specialized grid shortest path search.
+  // If sparseGrid is > 0, octilinear grids only contain the nodes at most
+  // sparseGrid cells away from the input graph
+  Octilinearizer(basegraph::BaseGraphType baseGraphType, size_t jobs,
+                 double gridMemLimit, bool gridDijkstra, size_t sparseGrid);
+
+  // if coarseFactor > 1, the graph is first drawn on a grid with a cell size
+  // of coarseFactor * gridSize, and the drawing on the final grid is
+  // restricted to a corridor around the coarse drawing
   Score draw(const CombGraph& cg, const util::geo::DBox& box, LineGraph* out,
              basegraph::BaseGraph** gg, Drawing* d, const Penalties& pens,
              double gridSize, double borderRad, double maxGrDist,
              config::OrderMethod orderMethod, bool restrLocSearch,
              double enfGeoCourse, size_t hananIters,
              const std::vector<util::geo::Polygon<double>>& obstacles,
-             size_t locsearchIters, size_t abortAfter);
+             size_t locsearchIters, size_t abortAfter, double coarseFactor);
 
   Score drawILP(const CombGraph& cg, const util::geo::DBox& box, LineGraph* out,
                 basegraph::BaseGraph** gg, Drawing* d, const Penalties& pens,
@@ -190,16 +285,100 @@ class Octilinearizer {
                 double enfGeoPens, size_t hananIters, int timeLim,
                 const std::string& cacheDir, double cacheThreshold,
                 int numThreads, octi::ilp::ILPStats* stats,
-                const std::string& solverStr, const std::string& path);
+                const std::string& solverStr, const std::string& path,
+                size_t ilpWindow, size_t ilpCorridor, bool ilpCacheModel);
 
   size_t maxNodeDeg() const;
 
+  // estimate the size of a single base graph of type t for cg in box, without
+  // building it. For the Hanan grid and the quadtree, this is the size of the
+  // full octilinear grid, an upper bound
+  static GridEstimate estimateGrid(basegraph::BaseGraphType t,
+                                   size_t sparseGrid, const CombGraph& cg,
+                                   const util::geo::DBox& box, double cellSize,
+                                   double maxGrDist);
+
+  // rough memory footprint in bytes of a grid graph of the given size
+  static double gridMem(size_t nds, size_t edgs);
+
+  // once *cancel is set, the heuristic drawing stops as soon as possible and
+  // its result is meaningless, the ILP is not cancelled
+  void setCancel(const std::atomic<bool>* cancel) { _cancel = cancel; }
+
+  // comb edges whose end points are at least d grid cells apart are routed
+  // with a bidirectional search on grid graphs, 0 disables this
+  void setBidirDist(double d) { _bidirDist = d; }
+
+  // if n > 1, the initial drawing first routes the comb edges lying inside
+  // one of n x n regions of the map in parallel, one region per job, and
+  // then the remaining edges crossing region borders
+  void setRouteRegions(size_t n) { _routeRegions = n; }
+
+  // incremental drawing: if prev is set, the heuristic drawing keeps the
+  // positions and routes of all parts of the input which are unchanged
+  // compared to the previous octi output prev and which are more than rad
+  // grid cells away from any change. If subset is set, the input is a
+  // subset of the lines of prev (for example the lines of a single stop),
+  // and nodes and edges are unchanged if prev carries at least their lines.
+  void setPrevDrawing(const LineGraph* prev, size_t rad, bool subset) {
+    _prev = prev;
+    _prevRad = rad;
+    _prevSubset = subset;
+  }
+
+  // split criteria of the quadtree base graph
+  void setQuadTreeParams(const basegraph::QuadTreeParams& params) {
+    _quadTreeParams = params;
+  }
+
  private:
   basegraph::BaseGraphType _baseGraphType;
+  size_t _jobs;
+  double _gridMemLimit;
+  bool _gridDijkstra;
+  size_t _sparseGrid;
+
+  const std::atomic<bool>* _cancel = 0;
+
+  double _bidirDist = 0;
+
+  size_t _routeRegions = 0;
+
+  const LineGraph* _prev = 0;
+  size_t _prevRad = 0;
+  bool _prevSubset = false;
+
+  basegraph::QuadTreeParams _quadTreeParams;
+
+  bool cancelled() const { return _cancel && *_cancel; }
+
+  bool useBidir(const std::set<basegraph::GridNode*>& frGrNds,
+                const std::set<basegraph::GridNode*>& toGrNds) const;
+
+  size_t numJobs(const basegraph::BaseGraph* gg) const;
+
+  void writeGeoCoursePens(basegraph::BaseGraph* gg,
+                          const std::vector<CombEdge*>& edges, double pen,
+                          GeoPensMap* target) const;
+
+  template <typename CostF>
+  void shortestPath(basegraph::BaseGraph* gg,
+                    const std::set<GridNode*>& frGrNds,
+                    const std::set<GridNode*>& toGrNds, const CostF& cost,
+                    GrEdgList* eL, GrNdList* nL) const;
+
+  // as above, but only route inside region if it is given
+  template <typename CostF>
+  void shortestPath(basegraph::BaseGraph* gg,
+                    const std::set<GridNode*>& frGrNds,
+                    const std::set<GridNode*>& toGrNds, const CostF& cost,
+                    const util::geo::DBox* region, GrEdgList* eL,
+                    GrNdList* nL) const;
 
   basegraph::BaseGraph* newBaseGraph(const util::geo::DBox& bbox,
                                      const CombGraph& cg, double cellSize,
                                      double spacer, size_t hananIters,
+                                     double maxGrDist,
                                      const Penalties& pens) const;
 
   util::geo::Polygon<double> hull(const CombGraph& cg) const;
@@ -216,23 +395,75 @@ class Octilinearizer {
   std::vector<CombEdge*> getOrdering(const CombGraph& cg,
                                      octi::config::OrderMethod method) const;
 
+  // if bestScore is given, the cutoff is lowered to it before each edge, and
+  // the drawing is aborted (NO_PATH) once it cannot beat it anymore. If
+  // region is given, comb nodes are only placed and comb edges only routed
+  // inside of it
   Undrawable draw(const std::vector<CombEdge*>& order, basegraph::BaseGraph* gg,
                   Drawing* drawing, double cutoff, double maxGrDist,
-                  const GeoPensMap* geoPensMap, size_t abortAfter);
+                  const GeoPensMap* geoPensMap, const Corridor* corr,
+                  size_t abortAfter,
+                  const std::atomic<double>* bestScore = 0,
+                  const util::geo::DBox* region = 0);
   Undrawable draw(const std::vector<CombEdge*>& order,
                   const SettledPos& settled, basegraph::BaseGraph* gg,
                   Drawing* drawing, double cutoff, double maxGrDist,
-                  const GeoPensMap* geoPensMap, size_t abortAfter);
+                  const GeoPensMap* geoPensMap, const Corridor* corr,
+                  size_t abortAfter,
+                  const std::atomic<double>* bestScore = 0,
+                  const util::geo::DBox* region = 0);
+
+  // draw the edges in order into the empty drawing, first the edges inside
+  // the _routeRegions x _routeRegions regions of box in parallel, each job
+  // on its own grid of ggs, then the remaining edges on ggs[0]. Regions are
+  // separated by a buffer, so their drawings never collide. All grids are
+  // left unchanged.
+  Undrawable drawRegions(const std::vector<CombEdge*>& order,
+                         const util::geo::DBox& box,
+                         const std::vector<basegraph::BaseGraph*>& ggs,
+                         Drawing* drawing, double maxGrDist,
+                         const GeoPensMap* geoPensMap, const Corridor* corr);
+
+  // randomly swap neighboured edges in an ordering, for the extra initial
+  // orderings tried on spare jobs
+  static void perturbOrdering(std::vector<CombEdge*>* order, size_t seed);
+
+  // draw cg on a grid with cell size coarseSize and write the corridor
+  // around the result for grid gg, false if there is no coarse drawing
+  bool getCorridor(const CombGraph& cg, const util::geo::DBox& box,
+                   basegraph::BaseGraph* gg, const Penalties& pens,
+                   double coarseSize, double borderRad, double maxGrDist,
+                   config::OrderMethod orderMethod, bool restrLocSearch,
+                   double enfGeoPen, size_t hananIters,
+                   const std::vector<util::geo::Polygon<double>>& obstacles,
+                   size_t locSearchIters, Corridor* corr);
+
+  // write the corridor of the unchanged parts of the previous drawing _prev,
+  // returns false if nothing of it can be kept
+  bool getPrevCorridor(const CombGraph& cg, basegraph::BaseGraph* gg,
+                       double maxGrDist, Corridor* corr) const;
+
+  // re-draw the edges of m.nd with m.nd at its new position on gg, keep the
+  // result if it improves the drawing
+  bool applyMove(const LocMove& m, basegraph::BaseGraph* gg, Drawing* drawing,
+                 double maxGrDist, const GeoPensMap* geoPens,
+                 const Corridor* corr);
+
+  // extend box by the grid paths of all edges adjacent to nd in d
+  void extendByPaths(const Drawing& d, const CombNode* nd,
+                     const basegraph::BaseGraph* gg,
+                     util::geo::DBox* box) const;
 
   SettledPos neigh(const SettledPos& pos, const std::vector<CombNode*>&,
                    size_t i) const;
 
   RtPair getRtPair(CombNode* frCmbNd, CombNode* toCmbNd,
                    const SettledPos& settled, basegraph::BaseGraph* gg,
-                   double maxGrDist);
+                   double maxGrDist, const Corridor* corr);
 
   std::set<GridNode*> getCands(CombNode* cmBnd, const SettledPos& settled,
-                               basegraph::BaseGraph* gg, size_t maxGridDis);
+                               basegraph::BaseGraph* gg, size_t maxGridDis,
+                               const Corridor* corr);
 
   void statLine(Undrawable status, const std::string& msg,
                 const Drawing& drawing, double ms,
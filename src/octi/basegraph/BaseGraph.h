@@ -4,9 +4,12 @@
 #ifndef OCTI_BASEGRAPH_BASEGRAPH_H_
 #define OCTI_BASEGRAPH_BASEGRAPH_H_
 
+#include <memory>
 #include <queue>
 #include <set>
 #include <unordered_map>
+#include "octi/basegraph/GeoPens.h"
+#include "octi/basegraph/GridDijkstra.h"
 #include "octi/basegraph/GridEdgePL.h"
 #include "octi/basegraph/GridNodePL.h"
 #include "octi/basegraph/NodeCost.h"
@@ -40,7 +43,8 @@ enum BaseGraphType {
   ORTHORADIAL,
   PSEUDOORTHORADIAL,
   OCTIHANANGRID,
-  OCTIQUADTREE
+  OCTIQUADTREE,
+  BUFFEREDOCTIGRID
 };
 
 typedef util::graph::Node<GridNodePL, GridEdgePL> GridNode;
@@ -49,10 +53,11 @@ typedef util::graph::Edge<GridNodePL, GridEdgePL> GridEdge;
 typedef std::pair<const GridEdge*, const GridEdge*> EdgPair;
 typedef std::vector<std::pair<EdgPair, EdgPair>> CrossEdgPairs;
 
-// edge-id -> pen
-typedef std::unordered_map<uint32_t, float> GeoPens;
 typedef std::map<const CombEdge*, GeoPens> GeoPensMap;
 
+// grid edges blocked by obstacles, as sorted pairs of grid node ids
+typedef std::vector<std::pair<size_t, size_t>> ObstacleMask;
+
 struct Candidate {
   Candidate(GridNode* n, double d) : n(n), d(d){};
 
@@ -93,6 +98,10 @@ class BaseGraph : public DirGraph<GridNodePL, GridEdgePL> {
   virtual const util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float>*
   getHeur(const std::set<GridNode*>& to) const = 0;
 
+  // base graphs may opt into the specialized grid shortest path search by
+  // returning their (per-graph) search instance here
+  virtual GridDijkstra* getGridDijkstra() { return 0; }
+
   virtual std::priority_queue<Candidate> getGridNdCands(
       const util::geo::DPoint& p, size_t maxGrD) const = 0;
 
@@ -111,6 +120,11 @@ class BaseGraph : public DirGraph<GridNodePL, GridEdgePL> {
 
   virtual std::set<GridNode*> getGrNdCands(CombNode* n, size_t maxDis) = 0;
 
+  // candidates for n around p instead of around the position of n
+  virtual std::set<GridNode*> getGrNdCands(CombNode* n,
+                                           const util::geo::DPoint& p,
+                                           size_t maxDis) = 0;
+
   virtual void settleNd(GridNode* n, CombNode* cn) = 0;
   virtual void settleEdg(GridNode* a, GridNode* b, CombEdge* e) = 0;
 
@@ -138,12 +152,25 @@ class BaseGraph : public DirGraph<GridNodePL, GridEdgePL> {
   virtual std::set<CombEdge*> getResEdgs(const GridEdge* ge) const = 0;
   virtual std::set<CombEdge*> getResEdgsDirInd(const GridEdge* ge) const = 0;
 
-  virtual void writeGeoCoursePens(const CombEdge* ce, GeoPensMap* target,
+  virtual void writeGeoCoursePens(const CombEdge* ce, GeoPens* target,
                                   double pen) = 0;
 
-  virtual CrossEdgPairs getCrossEdgPairs() const = 0;
+  // write all grid edges with both ends at most maxD away from line into
+  // target, with a penalty of 0
+  virtual void writeCorridor(const util::geo::DLine& line, double maxD,
+                             GeoPens* target) = 0;
+
+  virtual const CrossEdgPairs& getCrossEdgPairs() const = 0;
+
+  // the mask only depends on the grid layout, it can be computed once and
+  // shared by all base graphs built with the same parameters
+  virtual ObstacleMask getObstacleMask(
+      const std::vector<util::geo::Polygon<double>>& obsts) const = 0;
+
+  // block the masked edges, again after every reset()
+  virtual void setObstacleMask(
+      const std::shared_ptr<const ObstacleMask>& mask) = 0;
 
-  virtual void addObstacle(const util::geo::Polygon<double>& obst) = 0;
   virtual PolyLine<double> geomFromPath(
       const std::vector<std::pair<size_t, size_t>>& res) const = 0;
 };
@@ -52,6 +52,7 @@ void ConvexHullOctiGridGraph::init() {
 
   writeInitialCosts();
   prunePorts();
+  writeCrossTable();
 }
 
 // _____________________________________________________________________________
@@ -75,7 +76,7 @@ GridNode* ConvexHullOctiGridGraph::writeNd(size_t x, size_t y) {
   double yPos = _bbox.getLowerLeft().getY() + y * _cellSize;
 
   GridNode* n = addNd(DPoint(xPos, yPos));
-  n->pl().setId(_nds.size());
+  n->pl().setId(_nds.size(), &_nds);
   _nds.push_back(n);
   _ndIdx[x * _grid.getYHeight() + y] = _nds.size();
   n->pl().setSink();
@@ -90,7 +91,7 @@ GridNode* ConvexHullOctiGridGraph::writeNd(size_t x, size_t y) {
     yi /= abs(abs(yi) - 1) + 1;
 
     GridNode* nn = addNd(DPoint(xPos + xi * _spacer, yPos + yi * _spacer));
-    nn->pl().setId(_nds.size());
+    nn->pl().setId(_nds.size(), &_nds);
     _nds.push_back(nn);
     nn->pl().setParent(n);
     n->pl().setPort(i, nn);
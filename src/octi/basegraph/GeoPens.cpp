@@ -0,0 +1,45 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include "octi/basegraph/GeoPens.h"
+
+using octi::basegraph::GeoPens;
+
+// _____________________________________________________________________________
+void GeoPens::build(std::vector<std::pair<uint32_t, float>>* pens) {
+  _bits.clear();
+  _rank.clear();
+  _pens.clear();
+  _off = 0;
+
+  if (pens->empty()) return;
+
+  std::sort(pens->begin(), pens->end());
+  pens->erase(std::unique(pens->begin(), pens->end(),
+                          [](const std::pair<uint32_t, float>& a,
+                             const std::pair<uint32_t, float>& b) {
+                            return a.first == b.first;
+                          }),
+              pens->end());
+
+  _off = pens->front().first;
+  size_t range = pens->back().first - _off + 1;
+
+  _bits.resize((range + 63) / 64, 0);
+  _rank.resize(_bits.size(), 0);
+  _pens.reserve(pens->size());
+
+  for (const auto& p : *pens) {
+    size_t i = p.first - _off;
+    _bits[i >> 6] |= uint64_t(1) << (i & 63);
+    _pens.push_back(p.second);
+  }
+
+  uint32_t cnt = 0;
+  for (size_t w = 0; w < _bits.size(); w++) {
+    _rank[w] = cnt;
+    cnt += __builtin_popcountll(_bits[w]);
+  }
+}
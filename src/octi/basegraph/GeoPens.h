@@ -0,0 +1,52 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef OCTI_BASEGRAPH_GEOPENS_H_
+#define OCTI_BASEGRAPH_GEOPENS_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace octi {
+namespace basegraph {
+
+// Geo course penalties of a single comb edge, keyed by grid edge id. As grid
+// edge ids are dense, the penalties are stored as a bitmap over the range of
+// ids which have a penalty, together with a packed array of the penalties in
+// id order. A lookup is a bit test plus a popcount, no hashing.
+class GeoPens {
+ public:
+  GeoPens() : _off(0) {}
+
+  // build from (grid edge id, penalty) pairs in arbitrary order. The vector
+  // is sorted in place, of duplicate ids only the lowest penalty is kept.
+  void build(std::vector<std::pair<uint32_t, float>>* pens);
+
+  // pointer to the penalty for grid edge id, 0 if there is none
+  const float* find(uint32_t id) const {
+    if (id < _off) return 0;
+    size_t i = id - _off;
+    size_t w = i >> 6;
+    if (w >= _bits.size()) return 0;
+    uint64_t mask = uint64_t(1) << (i & 63);
+    if (!(_bits[w] & mask)) return 0;
+    return &_pens[_rank[w] + __builtin_popcountll(_bits[w] & (mask - 1))];
+  }
+
+  size_t size() const { return _pens.size(); }
+
+ private:
+  uint32_t _off;
+  std::vector<uint64_t> _bits;
+
+  // number of penalties before each bitmap word
+  std::vector<uint32_t> _rank;
+  std::vector<float> _pens;
+};
+
+}  // namespace basegraph
+}  // namespace octi
+
+#endif  // OCTI_BASEGRAPH_GEOPENS_H_
@@ -0,0 +1,43 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include "octi/basegraph/GridDijkstra.h"
+
+using octi::basegraph::GridDijkstra;
+
+// _____________________________________________________________________________
+void GridDijkstra::newRound() {
+  _round++;
+  if (_round == 0) {
+    // counter overflow, invalidate all stale state
+    std::fill(_seen.begin(), _seen.end(), 0);
+    std::fill(_settled.begin(), _settled.end(), 0);
+    std::fill(_seenB.begin(), _seenB.end(), 0);
+    std::fill(_settledB.begin(), _settledB.end(), 0);
+    _round = 1;
+  }
+}
+
+// _____________________________________________________________________________
+void GridDijkstra::grow(size_t id) {
+  if (id < _seen.size()) return;
+  size_t size = std::max(id + 1, _seen.size() * 2);
+  _seen.resize(size, 0);
+  _settled.resize(size, 0);
+  _dist.resize(size, 0);
+  _pred.resize(size, 0);
+  _seenB.resize(size, 0);
+  _settledB.resize(size, 0);
+  _distB.resize(size, 0);
+  _succ.resize(size, 0);
+}
+
+// _____________________________________________________________________________
+bool GridDijkstra::isSeen(size_t id) const { return _seen[id] == _round; }
+
+// _____________________________________________________________________________
+bool GridDijkstra::isSettled(size_t id) const {
+  return _settled[id] == _round;
+}
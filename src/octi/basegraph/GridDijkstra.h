@@ -0,0 +1,312 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef OCTI_BASEGRAPH_GRIDDIJKSTRA_H_
+#define OCTI_BASEGRAPH_GRIDDIJKSTRA_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <vector>
+#include "octi/basegraph/GridEdgePL.h"
+#include "octi/basegraph/GridNodePL.h"
+#include "util/graph/Edge.h"
+#include "util/graph/Node.h"
+
+namespace octi {
+namespace basegraph {
+
+// A* shortest path search specialized for grid graphs. In contrast to the
+// generic util::graph::Dijkstra, the search state is kept in flat arrays
+// indexed by GridNodePL::getId() which are reused between searches, and the
+// cost and heuristic functions are template parameters, so their calls can
+// be inlined if the concrete types are final.
+//
+// The interface and the result layout (nodes and edges from the target back
+// to the source) are the same as for util::graph::Dijkstra::shortestPath().
+class GridDijkstra {
+ public:
+  GridDijkstra() : _round(0) {}
+
+  template <typename CostF, typename HeurF>
+  float shortestPath(const std::set<GridNode*>& from,
+                     const std::set<GridNode*>& to, const CostF& cost,
+                     const HeurF& heur,
+                     std::vector<GridEdge*>* resEdges,
+                     std::vector<GridNode*>* resNodes);
+
+  // Bidirectional A*. A forward search from "from" with heur towards "to"
+  // and a backward search over the reversed edges from "to" with revHeur
+  // towards "from" are expanded alternately, always on the side with the
+  // smaller queue. The search stops once the best path found so far is not
+  // more expensive than the smallest key of either queue, which is optimal
+  // for the same (consistent) heuristics shortestPath() needs.
+  template <typename CostF, typename HeurF, typename RevHeurF>
+  float shortestPathBidir(const std::set<GridNode*>& from,
+                          const std::set<GridNode*>& to, const CostF& cost,
+                          const HeurF& heur, const RevHeurF& revHeur,
+                          std::vector<GridEdge*>* resEdges,
+                          std::vector<GridNode*>* resNodes);
+
+ private:
+  struct QueueEntry {
+    QueueEntry(GridNode* n, GridEdge* e, float d, float h)
+        : n(n), e(e), d(d), h(h) {}
+    GridNode* n;
+    GridEdge* e;
+    float d, h;
+
+    bool operator<(const QueueEntry& o) const { return h > o.h; }
+  };
+
+  // per-node search state, only valid if _seen[id] == _round
+  std::vector<uint32_t> _seen;
+  std::vector<uint32_t> _settled;
+  std::vector<float> _dist;
+  std::vector<GridEdge*> _pred;
+
+  std::vector<QueueEntry> _heap;
+
+  // state of the backward search of shortestPathBidir(), _succ holds the
+  // edge towards the target
+  std::vector<uint32_t> _seenB;
+  std::vector<uint32_t> _settledB;
+  std::vector<float> _distB;
+  std::vector<GridEdge*> _succ;
+
+  std::vector<QueueEntry> _heapB;
+
+  uint32_t _round;
+
+  void newRound();
+  void grow(size_t id);
+  bool isSeen(size_t id) const;
+  bool isSettled(size_t id) const;
+
+  // settle the front of one queue of shortestPathBidir() and relax its
+  // edges, *best and *meet are updated if both searches meet
+  template <bool Rev, typename CostF, typename HeurF>
+  void bidirStep(const std::set<GridNode*>& target, const CostF& cost,
+                 const HeurF& heur, float* best, GridNode** meet);
+};
+
+// _____________________________________________________________________________
+template <typename CostF, typename HeurF>
+float GridDijkstra::shortestPath(const std::set<GridNode*>& from,
+                                 const std::set<GridNode*>& to,
+                                 const CostF& cost, const HeurF& heur,
+                                 std::vector<GridEdge*>* resEdges,
+                                 std::vector<GridNode*>* resNodes) {
+  if (from.size() == 0 || to.size() == 0) return cost.inf();
+
+  newRound();
+
+  // the heap vector is reused between searches to avoid reallocations
+  auto& pq = _heap;
+  pq.clear();
+
+  for (auto n : from) {
+    size_t id = n->pl().getId();
+    grow(id);
+    _seen[id] = _round;
+    _dist[id] = 0;
+    _pred[id] = 0;
+    pq.emplace_back(n, static_cast<GridEdge*>(0), 0, 0);
+    std::push_heap(pq.begin(), pq.end());
+  }
+
+  GridNode* found = 0;
+  float foundD = cost.inf();
+
+  while (!pq.empty()) {
+    if (cost.inf() <= pq.front().h) break;
+
+    std::pop_heap(pq.begin(), pq.end());
+    QueueEntry cur = pq.back();
+    pq.pop_back();
+
+    size_t curId = cur.n->pl().getId();
+    if (isSettled(curId)) continue;
+
+    _settled[curId] = _round;
+    _dist[curId] = cur.d;
+    _pred[curId] = cur.e;
+
+    if (to.find(cur.n) != to.end()) {
+      found = cur.n;
+      foundD = cur.d;
+      break;
+    }
+
+    for (auto e : cur.n->getAdjListOut()) {
+      auto toNd = e->getTo();
+      size_t toId = toNd->pl().getId();
+      grow(toId);
+
+      if (isSettled(toId)) continue;
+
+      float newD = cur.d + cost(cur.n, e, toNd);
+      if (cost.inf() <= newD) continue;
+
+      // a cheaper (or equally cheap) entry for this node is already queued
+      if (isSeen(toId) && _dist[toId] <= newD) continue;
+
+      _seen[toId] = _round;
+      _dist[toId] = newD;
+
+      pq.emplace_back(toNd, e, newD, newD + heur(toNd, to));
+      std::push_heap(pq.begin(), pq.end());
+    }
+  }
+
+  if (!found) return cost.inf();
+
+  GridNode* curN = found;
+  while (true) {
+    if (resNodes) resNodes->push_back(curN);
+    GridEdge* e = _pred[curN->pl().getId()];
+    if (!e) break;
+    if (resEdges) resEdges->push_back(e);
+    curN = e->getFrom();
+  }
+
+  return foundD;
+}
+
+// _____________________________________________________________________________
+template <typename CostF, typename HeurF, typename RevHeurF>
+float GridDijkstra::shortestPathBidir(const std::set<GridNode*>& from,
+                                      const std::set<GridNode*>& to,
+                                      const CostF& cost, const HeurF& heur,
+                                      const RevHeurF& revHeur,
+                                      std::vector<GridEdge*>* resEdges,
+                                      std::vector<GridNode*>* resNodes) {
+  if (from.size() == 0 || to.size() == 0) return cost.inf();
+
+  newRound();
+
+  _heap.clear();
+  _heapB.clear();
+
+  float best = cost.inf();
+  GridNode* meet = 0;
+
+  for (auto n : from) {
+    size_t id = n->pl().getId();
+    grow(id);
+    _seen[id] = _round;
+    _dist[id] = 0;
+    _pred[id] = 0;
+    _heap.emplace_back(n, static_cast<GridEdge*>(0), 0, 0);
+    std::push_heap(_heap.begin(), _heap.end());
+  }
+
+  for (auto n : to) {
+    size_t id = n->pl().getId();
+    grow(id);
+    _seenB[id] = _round;
+    _distB[id] = 0;
+    _succ[id] = 0;
+    _heapB.emplace_back(n, static_cast<GridEdge*>(0), 0, 0);
+    std::push_heap(_heapB.begin(), _heapB.end());
+
+    if (isSeen(id)) {
+      best = 0;
+      meet = n;
+    }
+  }
+
+  while (!_heap.empty() && !_heapB.empty()) {
+    // no path through the remaining nodes of either queue can be cheaper
+    if (best <= std::max(_heap.front().h, _heapB.front().h)) break;
+
+    if (_heap.size() <= _heapB.size()) {
+      bidirStep<false>(to, cost, heur, &best, &meet);
+    } else {
+      bidirStep<true>(from, cost, revHeur, &best, &meet);
+    }
+  }
+
+  if (!meet) return cost.inf();
+
+  // edges from the meeting node to the target
+  std::vector<GridEdge*> tail;
+  for (GridEdge* e = _succ[meet->pl().getId()]; e;
+       e = _succ[e->getTo()->pl().getId()]) {
+    tail.push_back(e);
+  }
+
+  for (size_t i = tail.size(); i > 0; i--) {
+    if (resNodes) resNodes->push_back(tail[i - 1]->getTo());
+    if (resEdges) resEdges->push_back(tail[i - 1]);
+  }
+
+  GridNode* curN = meet;
+  while (true) {
+    if (resNodes) resNodes->push_back(curN);
+    GridEdge* e = _pred[curN->pl().getId()];
+    if (!e) break;
+    if (resEdges) resEdges->push_back(e);
+    curN = e->getFrom();
+  }
+
+  return best;
+}
+
+// _____________________________________________________________________________
+template <bool Rev, typename CostF, typename HeurF>
+void GridDijkstra::bidirStep(const std::set<GridNode*>& target,
+                             const CostF& cost, const HeurF& heur,
+                             float* best, GridNode** meet) {
+  auto& pq = Rev ? _heapB : _heap;
+  auto& seen = Rev ? _seenB : _seen;
+  auto& settled = Rev ? _settledB : _settled;
+  auto& dist = Rev ? _distB : _dist;
+  auto& pred = Rev ? _succ : _pred;
+
+  const auto& oSeen = Rev ? _seen : _seenB;
+  const auto& oDist = Rev ? _dist : _distB;
+
+  std::pop_heap(pq.begin(), pq.end());
+  QueueEntry cur = pq.back();
+  pq.pop_back();
+
+  size_t curId = cur.n->pl().getId();
+  if (settled[curId] == _round) return;
+  settled[curId] = _round;
+
+  const auto& adj = Rev ? cur.n->getAdjListIn() : cur.n->getAdjListOut();
+
+  for (auto e : adj) {
+    auto nd = Rev ? e->getFrom() : e->getTo();
+    size_t id = nd->pl().getId();
+    grow(id);
+
+    if (settled[id] == _round) continue;
+
+    float newD = cur.d + (Rev ? cost(nd, e, cur.n) : cost(cur.n, e, nd));
+    if (cost.inf() <= newD) continue;
+
+    // a cheaper (or equally cheap) entry for this node is already queued
+    if (seen[id] == _round && dist[id] <= newD) continue;
+
+    seen[id] = _round;
+    dist[id] = newD;
+    pred[id] = e;
+
+    if (oSeen[id] == _round && newD + oDist[id] < *best) {
+      *best = newD + oDist[id];
+      *meet = nd;
+    }
+
+    pq.emplace_back(nd, e, newD, newD + heur(nd, target));
+    std::push_heap(pq.begin(), pq.end());
+  }
+}
+
+}  // namespace basegraph
+}  // namespace octi
+
+#endif  // OCTI_BASEGRAPH_GRIDDIJKSTRA_H_
@@ -0,0 +1,209 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "octi/basegraph/GridDump.h"
+#include "util/String.h"
+
+using octi::basegraph::BaseGraph;
+using octi::basegraph::GridDump;
+using octi::basegraph::GridDumpEdg;
+using octi::basegraph::GridDumpFilter;
+using octi::basegraph::GridDumpNd;
+using octi::basegraph::GridDumpTile;
+using util::geo::DBox;
+using util::geo::DPoint;
+
+namespace {
+
+// _____________________________________________________________________________
+void putVarint(std::string* buf, uint64_t v) {
+  while (v >= 0x80) {
+    buf->push_back(static_cast<char>((v & 0x7F) | 0x80));
+    v >>= 7;
+  }
+  buf->push_back(static_cast<char>(v));
+}
+
+// _____________________________________________________________________________
+void putZigzag(std::string* buf, int64_t v) {
+  putVarint(buf,
+            (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+}
+
+// _____________________________________________________________________________
+void putFloat(std::string* buf, float f) {
+  uint32_t v;
+  std::memcpy(&v, &f, sizeof(v));
+  for (size_t i = 0; i < 4; i++) {
+    buf->push_back(static_cast<char>(v >> (8 * i)));
+  }
+}
+
+// _____________________________________________________________________________
+// one coordinate column, as quantized deltas
+template <typename F>
+void putCoords(std::string* buf, size_t n, F coord) {
+  int64_t prev = 0;
+  for (size_t i = 0; i < n; i++) {
+    int64_t c = std::llround(coord(i) * octi::basegraph::GRID_DUMP_COORD_RES);
+    putZigzag(buf, c - prev);
+    prev = c;
+  }
+}
+
+// _____________________________________________________________________________
+std::string encTile(const GridDumpTile& t) {
+  std::string buf;
+  const auto& nds = t.nds;
+  const auto& edgs = t.edgs;
+
+  putVarint(&buf, nds.size());
+  putCoords(&buf, nds.size(), [&](size_t i) { return nds[i].pos.getX(); });
+  putCoords(&buf, nds.size(), [&](size_t i) { return nds[i].pos.getY(); });
+  for (const auto& nd : nds) putVarint(&buf, nd.x);
+  for (const auto& nd : nds) putVarint(&buf, nd.y);
+  for (const auto& nd : nds) buf.push_back(static_cast<char>(nd.flags));
+
+  putVarint(&buf, edgs.size());
+  putCoords(&buf, edgs.size(), [&](size_t i) { return edgs[i].from.getX(); });
+  putCoords(&buf, edgs.size(), [&](size_t i) { return edgs[i].from.getY(); });
+  putCoords(&buf, edgs.size(), [&](size_t i) { return edgs[i].to.getX(); });
+  putCoords(&buf, edgs.size(), [&](size_t i) { return edgs[i].to.getY(); });
+  for (const auto& e : edgs) putFloat(&buf, e.cost);
+  for (const auto& e : edgs) buf.push_back(static_cast<char>(e.resEdgs));
+  for (const auto& e : edgs) buf.push_back(static_cast<char>(e.flags));
+
+  return buf;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________
+GridDump::GridDump(GridDumpFilter filter, const DBox& window, double tileSize)
+    : _filter(filter),
+      _window(window),
+      _hasWindow(window.getLowerLeft().getX() <=
+                 window.getUpperRight().getX()),
+      _tileSize(tileSize) {}
+
+// _____________________________________________________________________________
+bool GridDump::inWindow(const DPoint& p) const {
+  return !_hasWindow || util::geo::contains(p, _window);
+}
+
+// _____________________________________________________________________________
+GridDumpTile& GridDump::tileOf(const DPoint& p) {
+  return _tiles[{static_cast<int64_t>(std::floor(p.getY() / _tileSize)),
+                 static_cast<int64_t>(std::floor(p.getX() / _tileSize))}];
+}
+
+// _____________________________________________________________________________
+void GridDump::add(const BaseGraph& gg) {
+  for (auto nd : gg.getNds()) {
+    if (!nd->pl().isSink()) continue;
+    if (_filter != GRID_DUMP_ALL && !nd->pl().isSettled()) continue;
+    const auto& pos = *nd->pl().getGeom();
+    if (!inWindow(pos)) continue;
+
+    uint8_t flags = 0;
+    if (nd->pl().isSettled()) flags |= GRID_DUMP_ND_SETTLED;
+    if (nd->pl().isClosed()) flags |= GRID_DUMP_ND_CLOSED;
+
+    tileOf(pos).nds.push_back({pos, static_cast<uint32_t>(nd->pl().getX()),
+                               static_cast<uint32_t>(nd->pl().getY()), flags});
+    _numNds++;
+  }
+
+  for (auto nd : gg.getNds()) {
+    auto fr = nd->pl().getParent();
+    for (auto e : nd->getAdjListOut()) {
+      auto to = e->getTo()->pl().getParent();
+
+      // port to port edges inside a grid node, and sink edges
+      if (!fr || !to || fr == to) continue;
+
+      // only one direction of each hop edge
+      if (fr->pl().getId() > to->pl().getId()) continue;
+
+      bool used = e->pl().resEdgs() > 0;
+      if (_filter == GRID_DUMP_USED && !used) continue;
+      if (_filter == GRID_DUMP_SETTLED && !used && !fr->pl().isSettled() &&
+          !to->pl().isSettled()) {
+        continue;
+      }
+
+      const auto& a = *nd->pl().getGeom();
+      const auto& b = *e->getTo()->pl().getGeom();
+      DPoint mid((a.getX() + b.getX()) / 2, (a.getY() + b.getY()) / 2);
+      if (!inWindow(mid)) continue;
+
+      uint8_t flags = 0;
+      if (e->pl().closed()) flags |= GRID_DUMP_EDG_CLOSED;
+      if (e->pl().isSecondary()) flags |= GRID_DUMP_EDG_SECONDARY;
+
+      tileOf(mid).edgs.push_back(
+          {a, b, static_cast<float>(e->pl().cost()),
+           static_cast<uint8_t>(e->pl().resEdgs()), flags});
+      _numEdgs++;
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void GridDump::printLatLng(util::geo::output::GeoJsonOutput* out) const {
+  for (const auto& t : _tiles) {
+    for (const auto& nd : t.second.nds) {
+      out->printLatLng(
+          nd.pos,
+          util::json::Dict{
+              {"x", util::json::Int(nd.x)},
+              {"y", util::json::Int(nd.y)},
+              {"settled", (nd.flags & GRID_DUMP_ND_SETTLED) ? "1" : "0"},
+              {"closed", (nd.flags & GRID_DUMP_ND_CLOSED) ? "1" : "0"}});
+    }
+
+    for (const auto& e : t.second.edgs) {
+      out->printLatLng(
+          util::geo::DLine{e.from, e.to},
+          util::json::Dict{
+              {"cost", std::isinf(e.cost) ? "inf" : util::toString(e.cost)},
+              {"res_edges", util::json::Int(e.resEdgs)},
+              {"closed", (e.flags & GRID_DUMP_EDG_CLOSED) ? "1" : "0"},
+              {"secondary", (e.flags & GRID_DUMP_EDG_SECONDARY) ? "1" : "0"}});
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void GridDump::writeBin(std::ostream* out, const std::string& props) const {
+  std::vector<std::string> tiles;
+  std::string idx;
+  size_t off = 0;
+
+  for (const auto& t : _tiles) {
+    tiles.push_back(encTile(t.second));
+    putZigzag(&idx, t.first.second);
+    putZigzag(&idx, t.first.first);
+    putVarint(&idx, off);
+    putVarint(&idx, tiles.back().size());
+    off += tiles.back().size();
+  }
+
+  std::string head(GRID_DUMP_MAGIC, 4);
+  putVarint(&head, GRID_DUMP_VERSION);
+  putVarint(&head, props.size());
+  head += props;
+  putVarint(&head, std::llround(_tileSize * GRID_DUMP_COORD_RES));
+  putVarint(&head, tiles.size());
+
+  out->write(head.data(), head.size());
+  out->write(idx.data(), idx.size());
+  for (const auto& t : tiles) out->write(t.data(), t.size());
+  out->flush();
+}
@@ -0,0 +1,110 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef OCTI_BASEGRAPH_GRIDDUMP_H_
+#define OCTI_BASEGRAPH_GRIDDUMP_H_
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "octi/basegraph/BaseGraph.h"
+#include "util/geo/Geo.h"
+#include "util/geo/output/GeoJsonOutput.h"
+
+namespace octi {
+namespace basegraph {
+
+// Compact debug dump of base graphs. Only the grid nodes (the sinks) and the
+// hop edges between them are kept, the ports, sink edges and bend edges
+// inside a grid node are left out, as is one of the two directions of every
+// hop edge. The dump can be restricted to the settled and used parts of the
+// grid and to a window.
+//
+// The binary format is split into square tiles of web mercator coordinates,
+// with an index of all tiles in front, so readers only decode the tiles they
+// need (see scripts/octi_grid_dump.py). All integers are varints, signed ones
+// zig-zag encoded, coordinates are stored as deltas quantized to
+// GRID_DUMP_COORD_RES, separately for x and y:
+//
+//   magic "OGDF", version, props (JSON)
+//   tile size (in 1 / GRID_DUMP_COORD_RES), number of tiles
+//   per tile: x, y (signed), byte offset behind the index, byte length
+//   per tile: number of nodes, node x and y columns, grid x, grid y, flags
+//             number of edges, from x, from y, to x and to y columns,
+//             costs (little endian float32), used by, flags
+
+static const char GRID_DUMP_MAGIC[4] = {'O', 'G', 'D', 'F'};
+static const uint64_t GRID_DUMP_VERSION = 1;
+static const double GRID_DUMP_COORD_RES = 10;
+
+// node flags
+static const uint8_t GRID_DUMP_ND_SETTLED = 1;
+static const uint8_t GRID_DUMP_ND_CLOSED = 2;
+
+// edge flags
+static const uint8_t GRID_DUMP_EDG_CLOSED = 1;
+static const uint8_t GRID_DUMP_EDG_SECONDARY = 2;
+
+enum GridDumpFilter {
+  GRID_DUMP_ALL = 0,
+  // settled nodes, and edges which are used or adjacent to a settled node
+  GRID_DUMP_SETTLED = 1,
+  // settled nodes and used edges
+  GRID_DUMP_USED = 2
+};
+
+struct GridDumpNd {
+  util::geo::DPoint pos;
+  uint32_t x, y;
+  uint8_t flags;
+};
+
+struct GridDumpEdg {
+  util::geo::DPoint from, to;
+  float cost;
+  uint8_t resEdgs;
+  uint8_t flags;
+};
+
+struct GridDumpTile {
+  std::vector<GridDumpNd> nds;
+  std::vector<GridDumpEdg> edgs;
+};
+
+class GridDump {
+ public:
+  // an empty window means the whole grid
+  GridDump(GridDumpFilter filter, const util::geo::DBox& window,
+           double tileSize);
+
+  void add(const BaseGraph& gg);
+
+  size_t numNds() const { return _numNds; }
+  size_t numEdgs() const { return _numEdgs; }
+
+  void printLatLng(util::geo::output::GeoJsonOutput* out) const;
+  void writeBin(std::ostream* out, const std::string& props) const;
+
+ private:
+  GridDumpFilter _filter;
+  util::geo::DBox _window;
+  bool _hasWindow;
+  double _tileSize;
+
+  size_t _numNds = 0, _numEdgs = 0;
+
+  // keyed by (y, x), so the tiles are ordered by row
+  std::map<std::pair<int64_t, int64_t>, GridDumpTile> _tiles;
+
+  bool inWindow(const util::geo::DPoint& p) const;
+  GridDumpTile& tileOf(const util::geo::DPoint& p);
+};
+
+}  // namespace basegraph
+}  // namespace octi
+
+#endif  // OCTI_BASEGRAPH_GRIDDUMP_H_
@@ -4,6 +4,8 @@
 
 #include <algorithm>
 #include <fstream>
+#include <limits>
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -15,6 +17,12 @@
 #include "util/geo/output/GeoGraphJsonOutput.h"
 #include "util/graph/Node.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_in_parallel() 0
+#endif
+
 using namespace octi::basegraph;
 using octi::basegraph::GridGraph;
 using octi::basegraph::NodeCost;
@@ -50,13 +58,30 @@ GridGraph::GridGraph(const DBox& bbox, double cellSize, double spacer,
 
 // _____________________________________________________________________________
 void GridGraph::init() {
-  // write nodes
-  for (size_t x = 0; x < _grid.getXWidth(); x++) {
-    for (size_t y = 0; y < _grid.getYHeight(); y++) {
-      writeNd(x, y);
+  size_t w = _grid.getXWidth();
+  size_t h = _grid.getYHeight();
+
+  // write nodes, their ids follow the cell order
+  for (size_t x = 0; x < w; x++) {
+    for (size_t y = 0; y < h; y++) {
+      writeNdNds(x, y);
     }
   }
 
+  // write the edges inside the cells in bands of grid columns. All cells
+  // have the same number of edges, so the ids are the same as if the cells
+  // were written one after another. Grid copies are already built in
+  // parallel, don't nest.
+  size_t firstId = _edgeCount;
+  size_t numEdgs = numNdEdgs();
+#pragma omp parallel for schedule(static) if (!omp_in_parallel())
+  for (size_t x = 0; x < w; x++) {
+    for (size_t y = 0; y < h; y++) {
+      writeNdEdgs(getNode(x, y), firstId + (x * h + y) * numEdgs);
+    }
+  }
+  _edgeCount = firstId + w * h * numEdgs;
+
   // write grid edges
   for (size_t x = 0; x < _grid.getXWidth(); x++) {
     for (size_t y = 0; y < _grid.getYHeight(); y++) {
@@ -77,6 +102,7 @@ void GridGraph::init() {
 
   writeInitialCosts();
   prunePorts();
+  writeCrossTable();
 }
 
 // _____________________________________________________________________________
@@ -146,84 +172,242 @@ void GridGraph::unSettleEdg(CombEdge* ce, GridNode* a, GridNode* b) {
 }
 
 // _____________________________________________________________________________
-CrossEdgPairs GridGraph::getCrossEdgPairs() const { return {}; }
+const CrossEdgPairs& GridGraph::getCrossEdgPairs() const { return _crossPairs; }
+
+// _____________________________________________________________________________
+CrossEdgPairs GridGraph::computeCrossEdgPairs() const { return {}; }
+
+// _____________________________________________________________________________
+void GridGraph::writeCrossTable() {
+  _crossPairs = computeCrossEdgPairs();
+
+  _crossOffs.assign(_edgeCount + 1, 0);
+  _crossPartners.clear();
+
+  for (const auto& cp : _crossPairs) {
+    for (auto e : {cp.first.first, cp.first.second, cp.second.first,
+                   cp.second.second}) {
+      _crossOffs[e->pl().getId() + 1] += 2;
+    }
+  }
+
+  for (size_t i = 1; i < _crossOffs.size(); i++) {
+    _crossOffs[i] += _crossOffs[i - 1];
+  }
+
+  _crossPartners.resize(_crossOffs.back());
+  std::vector<size_t> pos(_crossOffs.begin(), _crossOffs.end() - 1);
+
+  auto add = [&](const EdgPair& a, const EdgPair& b) {
+    for (auto e : {a.first, a.second}) {
+      _crossPartners[pos[e->pl().getId()]++] = const_cast<GridEdge*>(b.first);
+      _crossPartners[pos[e->pl().getId()]++] = const_cast<GridEdge*>(b.second);
+    }
+  };
+
+  for (const auto& cp : _crossPairs) {
+    add(cp.first, cp.second);
+    add(cp.second, cp.first);
+  }
+}
 
 // _____________________________________________________________________________
-void GridGraph::addObstacle(const util::geo::Polygon<double>& obst) {
-  _obstacles.push_back(obst);
-  writeObstacleCost(obst);
+void GridGraph::setCrossBlocked(const GridEdge* ge, bool blocked) {
+  size_t id = ge->pl().getId();
+  if (id + 1 >= _crossOffs.size()) return;
+
+  for (size_t i = _crossOffs[id]; i < _crossOffs[id + 1]; i++) {
+    if (blocked) {
+      _crossPartners[i]->pl().block();
+    } else {
+      _crossPartners[i]->pl().unblock();
+    }
+  }
 }
 
 // _____________________________________________________________________________
-void GridGraph::writeObstacleCost(const util::geo::Polygon<double>& obst) {
-  for (size_t x = 0; x < _grid.getXWidth(); x++) {
-    for (size_t y = 0; y < _grid.getYHeight(); y++) {
-      auto grNdA = getNode(x, y);
+ObstacleMask GridGraph::getObstacleMask(
+    const std::vector<util::geo::Polygon<double>>& obsts) const {
+  ObstacleMask ret;
+
+  // an edge crossing an obstacle starts at most this far away from it
+  double maxLen = 0;
+  for (auto nd : getNds()) {
+    for (auto e : nd->getAdjListOut()) {
+      maxLen = std::max(maxLen, dist(*e->getFrom()->pl().getGeom(),
+                                     *e->getTo()->pl().getGeom()));
+    }
+  }
 
-      for (size_t i = 0; i < maxDeg(); i++) {
-        auto grNeigh = neigh(x, y, i);
-        if (!grNeigh) continue;
-        auto ge = getNEdg(grNdA, grNeigh);
-
-        if (!ge) continue;
-
-        if (intersects(LineSegment<double>(*ge->getFrom()->pl().getGeom(),
-                                           *ge->getTo()->pl().getGeom()),
-                       obst) ||
-            contains(LineSegment<double>(*ge->getFrom()->pl().getGeom(),
-                                         *ge->getTo()->pl().getGeom()),
-                     obst)) {
-          ge->pl().setCost(std::numeric_limits<double>::infinity());
-        }
+#pragma omp parallel
+  {
+    ObstacleMask loc;
+#pragma omp for schedule(dynamic) nowait
+    for (size_t i = 0; i < obsts.size(); i++) {
+      writeObstacleMask(obsts[i], maxLen + getCellSize(), &loc);
+    }
+#pragma omp critical
+    ret.insert(ret.end(), loc.begin(), loc.end());
+  }
+
+  std::sort(ret.begin(), ret.end());
+  ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+  return ret;
+}
+
+// _____________________________________________________________________________
+void GridGraph::setObstacleMask(
+    const std::shared_ptr<const ObstacleMask>& mask) {
+  _obstMask = mask;
+  reWriteObstCosts();
+}
+
+// _____________________________________________________________________________
+void GridGraph::writeObstacleMask(const util::geo::Polygon<double>& obst,
+                                  double maxD, ObstacleMask* mask) const {
+  // only grid nodes near the obstacle are checked
+  auto obstBox = util::geo::getBoundingBox(obst);
+  std::set<GridNode*> cands;
+  _grid.get(util::geo::pad(obstBox, maxD), &cands);
+
+  for (auto grNdA : cands) {
+    for (size_t i = 0; i < maxDeg(); i++) {
+      auto grNeigh = neigh(grNdA, i);
+      if (!grNeigh) continue;
+      auto ge = getNEdg(grNdA, grNeigh);
+
+      if (!ge) continue;
+
+      LineSegment<double> seg(*ge->getFrom()->pl().getGeom(),
+                              *ge->getTo()->pl().getGeom());
+
+      DBox segBox = util::geo::extendBox(seg.second,
+                                         util::geo::extendBox(seg.first, DBox()));
+      if (!util::geo::intersects(segBox, obstBox)) continue;
+
+      if (intersects(seg, obst) || contains(seg, obst)) {
+        mask->push_back(
+            {ge->getFrom()->pl().getId(), ge->getTo()->pl().getId()});
       }
     }
   }
 }
 
+namespace {
 // _____________________________________________________________________________
-void GridGraph::writeGeoCoursePens(const CombEdge* ce, GeoPensMap* target,
-                                   double pen) {
-  std::set<GridNode*> neighs;
+double segDist(const DPoint& a, const DPoint& b, const DPoint& p) {
+  double dx = b.getX() - a.getX();
+  double dy = b.getY() - a.getY();
+  double l = dx * dx + dy * dy;
+  double t = 0;
+  if (l > 0) {
+    t = ((p.getX() - a.getX()) * dx + (p.getY() - a.getY()) * dy) / l;
+    t = std::max(0.0, std::min(1.0, t));
+  }
+  return dist(p, DPoint(a.getX() + t * dx, a.getY() + t * dy));
+}
+}  // namespace
 
-  DBox box;
+// _____________________________________________________________________________
+void GridGraph::writeGeoCoursePens(const CombEdge* ce, GeoPens* target,
+                                   double pen) {
+  // penalties above SOFT_INF are not written, so only grid nodes within
+  // maxD of a geometry are needed
+  double maxD = sqrt(SOFT_INF / pen) * getCellSize();
 
   std::vector<util::geo::DLine> geoms;
-
   for (auto orE : ce->pl().getChilds()) {
-    box = util::geo::extendBox(*orE->pl().getGeom(), box);
-
     // operate on simplified geometries
     geoms.push_back(util::geo::simplify(*orE->pl().getGeom(), 5));
   }
 
-  box = util::geo::pad(box, sqrt(SOFT_INF / pen) * getCellSize());
-  _grid.get(box, &neighs);
+  // banded distance transform: the distance of every grid node within maxD
+  // of a geometry to each of the geometries, in cell sizes. Every segment is
+  // rasterized into the grid cells of its padded bounding box, so nodes far
+  // from the geometry but inside its bounding box are never evaluated.
+  std::unordered_map<GridNode*, size_t> slot;
+  std::vector<float> dists;
 
-  for (auto grNdA : neighs) {
+  std::set<GridNode*> neighs;
+  for (size_t g = 0; g < geoms.size(); g++) {
+    const auto& geom = geoms[g];
+    // a single point is a segment of length 0
+    size_t numSegs = geom.size() > 1 ? geom.size() - 1 : geom.size();
+    for (size_t i = 0; i < numSegs; i++) {
+      const auto& a = geom[i];
+      const auto& b = geom[std::min(i + 1, geom.size() - 1)];
+
+      neighs.clear();
+      _grid.get(util::geo::pad(util::geo::getBoundingBox(
+                                   util::geo::DLine{a, b}),
+                               maxD),
+                &neighs);
+
+      for (auto grNd : neighs) {
+        auto it = slot.find(grNd);
+        if (it == slot.end()) {
+          it = slot.insert({grNd, dists.size()}).first;
+          dists.resize(dists.size() + geoms.size(),
+                       std::numeric_limits<float>::infinity());
+        }
+
+        float d = segDist(a, b, *grNd->pl().getGeom()) / getCellSize();
+        float& cur = dists[it->second + g];
+        if (d < cur) cur = d;
+      }
+    }
+  }
+
+  // a grid edge is as far from a geometry as its farther end
+  std::vector<std::pair<uint32_t, float>> pens;
+
+  for (const auto& s : slot) {
+    auto grNdA = s.first;
     for (size_t i = 0; i < maxDeg(); i++) {
       auto grNeigh = neigh(grNdA->pl().getX(), grNdA->pl().getY(), i);
       if (!grNeigh) continue;
-      auto ge = getNEdg(grNdA, grNeigh);
-
-      float d = std::numeric_limits<float>::infinity();
 
-      for (const auto& geom : geoms) {
-        double dLoc = fmax(
-            fmax(dist(geom, *ge->getFrom()->pl().getGeom()) / getCellSize(),
-                 dist(geom, util::geo::centroid(util::geo::MultiPoint<double>{
-                                *ge->getFrom()->pl().getGeom(),
-                                *ge->getFrom()->pl().getGeom()})) /
-                     getCellSize()),
-            dist(geom, *ge->getTo()->pl().getGeom()) / getCellSize());
+      auto sl = slot.find(grNeigh);
+      if (sl == slot.end()) continue;
 
+      float d = std::numeric_limits<float>::infinity();
+      for (size_t g = 0; g < geoms.size(); g++) {
+        float dLoc = std::max(dists[s.second + g], dists[sl->second + g]);
         if (dLoc < d) d = dLoc;
       }
 
       d *= pen * d;
 
-      if (d <= SOFT_INF) (*target)[ce][ge->pl().getId()] = d;
+      if (d <= SOFT_INF) {
+        pens.push_back({getNEdg(grNdA, grNeigh)->pl().getId(), d});
+      }
+    }
+  }
+
+  target->build(&pens);
+}
+
+// _____________________________________________________________________________
+void GridGraph::writeCorridor(const util::geo::DLine& line, double maxD,
+                              GeoPens* target) {
+  std::set<GridNode*> neighs;
+
+  auto box = util::geo::pad(util::geo::getBoundingBox(line), maxD);
+  _grid.get(box, &neighs);
+
+  std::vector<std::pair<uint32_t, float>> pens;
+
+  for (auto grNdA : neighs) {
+    if (dist(line, *grNdA->pl().getGeom()) > maxD) continue;
+    for (size_t i = 0; i < maxDeg(); i++) {
+      auto grNeigh = neigh(grNdA->pl().getX(), grNdA->pl().getY(), i);
+      if (!grNeigh) continue;
+      if (dist(line, *grNeigh->pl().getGeom()) > maxD) continue;
+      pens.push_back({getNEdg(grNdA, grNeigh)->pl().getId(), 0});
     }
   }
+
+  target->build(&pens);
 }
 
 // _____________________________________________________________________________
@@ -506,6 +690,8 @@ void GridGraph::addCostVec(GridNode* n, const NodeCost& addC) {
 
 // _____________________________________________________________________________
 void GridGraph::writeInitialCosts() {
+  // every cell only writes the costs of its outgoing grid edges
+#pragma omp parallel for schedule(static) if (!omp_in_parallel())
   for (size_t x = 0; x < _grid.getXWidth(); x++) {
     for (size_t y = 0; y < _grid.getYHeight(); y++) {
       auto n = getNode(x, y);
@@ -581,12 +767,27 @@ double GridGraph::heurCost(int64_t xa, int64_t ya, int64_t xb,
   return fmax(0, edgCost - _heurHopCost);
 }
 
+// _____________________________________________________________________________
+bool GridGraph::getHeurCoefs(HeurCoefs* c) const {
+  // see heurCost()
+  c->x = _c.horizontalPen + _heurHopCost;
+  c->y = _c.verticalPen + _heurHopCost;
+  c->diag = 0;
+  c->turn = _c.p_90;
+  c->hop = _heurHopCost;
+  c->diagTurn = true;
+  return true;
+}
+
 // _____________________________________________________________________________
 const util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float>*
 GridGraph::getHeur(const std::set<GridNode*>& to) const {
   return new GridGraphHeur(this, to);
 }
 
+// _____________________________________________________________________________
+GridDijkstra* GridGraph::getGridDijkstra() { return &_dijkstra; }
+
 // _____________________________________________________________________________
 void GridGraph::openTurns(GridNode* n) {
   if (!n->pl().isClosed()) return;
@@ -676,13 +877,20 @@ GridNode* GridGraph::getSettled(const CombNode* cnd) const {
 
 // _____________________________________________________________________________
 std::set<GridNode*> GridGraph::getGrNdCands(CombNode* n, size_t maxDis) {
+  return getGrNdCands(n, *n->pl().getGeom(), maxDis);
+}
+
+// _____________________________________________________________________________
+std::set<GridNode*> GridGraph::getGrNdCands(CombNode* n, const DPoint& p,
+                                            size_t maxDis) {
   std::set<GridNode*> tos;
   if (!isSettled(n)) {
-    auto cands = getGridNdCands(*n->pl().getGeom(), maxDis);
+    for (size_t id : getCachedCands(n, p, maxDis)) {
+      auto cand = _nds[id];
+      if (cand->pl().isClosed() || cand->pl().isSettled()) continue;
 
-    while (!cands.empty()) {
-      size_t x = cands.top().n->pl().getParent()->pl().getX();
-      size_t y = cands.top().n->pl().getParent()->pl().getY();
+      size_t x = cand->pl().getParent()->pl().getX();
+      size_t y = cand->pl().getParent()->pl().getY();
 
       // getGrNdDeg returns the maximum node degree of the grid node at this
       // position to prevent choosing nodes which cannot hold the CombNode
@@ -690,9 +898,7 @@ std::set<GridNode*> GridGraph::getGrNdCands(CombNode* n, size_t maxDis) {
       // If such nodes are chosen, the greedy heuristic algorithm will fall into
       // a local optimum which is a death valley - there is now way out
 
-      if (!cands.top().n->pl().isClosed() && getGrNdDeg(n, x, y) >= n->getDeg())
-        tos.insert(cands.top().n);
-      cands.pop();
+      if (getGrNdDeg(n, x, y) >= n->getDeg()) tos.insert(cand);
     }
   } else {
     tos.insert(_settled.find(n)->second);
@@ -701,6 +907,37 @@ std::set<GridNode*> GridGraph::getGrNdCands(CombNode* n, size_t maxDis) {
   return tos;
 }
 
+// _____________________________________________________________________________
+const std::vector<size_t>& GridGraph::getCachedCands(const CombNode* n,
+                                                     const DPoint& p,
+                                                     size_t maxDis) {
+  auto& entry = _candCache[n];
+  if (entry.valid && entry.maxDis == maxDis && entry.p == p) return entry.ids;
+
+  entry.valid = true;
+  entry.p = p;
+  entry.maxDis = maxDis;
+  entry.ids.clear();
+
+  std::set<GridNode*> neigh;
+  double maxD = getCellSize() * maxDis;
+
+  DBox b(DPoint(p.getX() - maxD, p.getY() - maxD),
+         DPoint(p.getX() + maxD, p.getY() + maxD));
+
+  _grid.get(b, &neigh);
+
+  for (auto cand : neigh) {
+    if (dist(*cand->pl().getGeom(), p) < maxD) {
+      entry.ids.push_back(cand->pl().getId());
+    }
+  }
+
+  std::sort(entry.ids.begin(), entry.ids.end());
+
+  return entry.ids;
+}
+
 // _____________________________________________________________________________
 void GridGraph::settleNd(GridNode* n, CombNode* cn) {
   _settled[cn] = n;
@@ -724,11 +961,25 @@ const GridEdge* GridGraph::getGrEdgById(std::pair<size_t, size_t> id) const {
 
 // _____________________________________________________________________________
 GridNode* GridGraph::writeNd(size_t x, size_t y) {
+  GridNode* n = writeNdNds(x, y);
+  writeNdEdgs(n, _edgeCount);
+  _edgeCount += numNdEdgs();
+  return n;
+}
+
+// _____________________________________________________________________________
+size_t GridGraph::numNdEdgs() const {
+  // sink edges in both directions, and all port pairs in both directions
+  return 2 * maxDeg() + maxDeg() * (maxDeg() - 1);
+}
+
+// _____________________________________________________________________________
+GridNode* GridGraph::writeNdNds(size_t x, size_t y) {
   double xPos = _bbox.getLowerLeft().getX() + x * _cellSize;
   double yPos = _bbox.getLowerLeft().getY() + y * _cellSize;
 
   GridNode* n = addNd(DPoint(xPos, yPos));
-  n->pl().setId(_nds.size());
+  n->pl().setId(_nds.size(), &_nds);
   _nds.push_back(n);
   n->pl().setSink();
   _grid.add(x, y, n);
@@ -753,18 +1004,29 @@ GridNode* GridGraph::writeNd(size_t x, size_t y) {
     }
 
     GridNode* nn = addNd(DPoint(xPos + xi * _spacer, yPos + yi * _spacer));
-    nn->pl().setId(_nds.size());
+    nn->pl().setId(_nds.size(), &_nds);
     _nds.push_back(nn);
     nn->pl().setParent(n);
     n->pl().setPort(i, nn);
+  }
+
+  return n;
+}
+
+// _____________________________________________________________________________
+void GridGraph::writeNdEdgs(GridNode* n, size_t firstId) {
+  size_t x = n->pl().getX();
+  size_t y = n->pl().getY();
+  size_t id = firstId;
+
+  for (size_t i = 0; i < 4; i++) {
+    auto nn = n->pl().getPort(i);
 
     auto e = addEdg(n, nn, GridEdgePL(INF, true, true));
-    e->pl().setId(_edgeCount);
-    _edgeCount++;
+    e->pl().setId(id++);
 
     e = addEdg(nn, n, GridEdgePL(INF, true, true));
-    e->pl().setId(_edgeCount);
-    _edgeCount++;
+    e->pl().setId(id++);
   }
 
   // in-node connections
@@ -779,17 +1041,13 @@ GridNode* GridGraph::writeNd(size_t x, size_t y) {
 
       auto e = addEdg(n->pl().getPort(i), n->pl().getPort(j),
                       GridEdgePL(pen, true, false));
-      e->pl().setId(_edgeCount);
-      _edgeCount++;
+      e->pl().setId(id++);
 
       e = addEdg(n->pl().getPort(j), n->pl().getPort(i),
                  GridEdgePL(pen, true, false));
-      e->pl().setId(_edgeCount);
-      _edgeCount++;
+      e->pl().setId(id++);
     }
   }
-
-  return n;
 }
 
 // _____________________________________________________________________________
@@ -833,7 +1091,12 @@ void GridGraph::reset() {
 
 // _____________________________________________________________________________
 void GridGraph::reWriteObstCosts() {
-  for (const auto& obst : _obstacles) writeObstacleCost(obst);
+  if (!_obstMask) return;
+  for (const auto& id : *_obstMask) {
+    getEdg(_nds[id.first], _nds[id.second])
+        ->pl()
+        .setCost(std::numeric_limits<double>::infinity());
+  }
 }
 
 // _____________________________________________________________________________
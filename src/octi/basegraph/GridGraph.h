@@ -5,9 +5,15 @@
 #ifndef OCTI_BASEGRAPH_GRIDGRAPH_H_
 #define OCTI_BASEGRAPH_GRIDGRAPH_H_
 
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
 #include <queue>
 #include <set>
 #include <unordered_map>
+#include <vector>
 #include "octi/basegraph/BaseGraph.h"
 #include "octi/basegraph/GridEdgePL.h"
 #include "octi/basegraph/GridNodePL.h"
@@ -30,6 +36,16 @@ using octi::combgraph::CombNode;
 namespace octi {
 namespace basegraph {
 
+// coefficients of a closed form heurCost() on grid coordinates, with
+// dx = |xb - xa|, dy = |yb - ya|:
+//   max(0, x * dx + y * dy + diag * min(dx, dy) + turn? - hop)
+// where turn is added if dx != 0 and dy != 0, unless diagTurn is false and
+// dx == dy (a straight diagonal)
+struct HeurCoefs {
+  float x, y, diag, turn, hop;
+  bool diagTurn;
+};
+
 class GridGraph : public BaseGraph {
  public:
   GridGraph(const util::geo::DBox& bbox, double cellSize, double spacer,
@@ -43,6 +59,9 @@ class GridGraph : public BaseGraph {
 
   virtual double heurCost(int64_t xa, int64_t ya, int64_t xb, int64_t yb) const;
 
+  // false if heurCost() has no closed form described by HeurCoefs
+  virtual bool getHeurCoefs(HeurCoefs* c) const;
+
   virtual std::priority_queue<Candidate> getGridNdCands(
       const util::geo::DPoint& p, size_t maxGrD) const;
 
@@ -59,6 +78,9 @@ class GridGraph : public BaseGraph {
   virtual size_t maxDeg() const;
 
   virtual std::set<GridNode*> getGrNdCands(CombNode* n, size_t maxGrDist);
+  virtual std::set<GridNode*> getGrNdCands(CombNode* n,
+                                           const util::geo::DPoint& p,
+                                           size_t maxGrDist);
 
   virtual void settleNd(GridNode* n, CombNode* cn);
   virtual void settleEdg(GridNode* a, GridNode* b, CombEdge* e);
@@ -85,16 +107,22 @@ class GridGraph : public BaseGraph {
   virtual std::set<CombEdge*> getResEdgs(const GridEdge* ge) const;
   virtual std::set<CombEdge*> getResEdgsDirInd(const GridEdge* ge) const;
 
-  virtual CrossEdgPairs getCrossEdgPairs() const;
+  virtual const CrossEdgPairs& getCrossEdgPairs() const;
 
-  virtual void writeGeoCoursePens(const CombEdge* ce, GeoPensMap* target,
+  virtual void writeGeoCoursePens(const CombEdge* ce, GeoPens* target,
                                   double pen);
+  virtual void writeCorridor(const util::geo::DLine& line, double maxD,
+                             GeoPens* target);
 
-  virtual void addObstacle(const util::geo::Polygon<double>& obst);
+  virtual ObstacleMask getObstacleMask(
+      const std::vector<util::geo::Polygon<double>>& obsts) const;
+  virtual void setObstacleMask(const std::shared_ptr<const ObstacleMask>& mask);
 
   virtual const util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float>*
   getHeur(const std::set<GridNode*>& to) const;
 
+  virtual GridDijkstra* getGridDijkstra();
+
   virtual PolyLine<double> geomFromPath(
       const std::vector<std::pair<size_t, size_t>>& res) const;
 
@@ -116,7 +144,31 @@ class GridGraph : public BaseGraph {
   // edge id counter
   size_t _edgeCount;
 
-  std::vector<util::geo::Polygon<double>> _obstacles;
+  std::shared_ptr<const ObstacleMask> _obstMask;
+
+  CrossEdgPairs _crossPairs;
+
+  // crossing partners of each grid edge by edge id, the partners of edge i
+  // are _crossPartners[_crossOffs[i]] up to _crossPartners[_crossOffs[i + 1]]
+  std::vector<size_t> _crossOffs;
+  std::vector<GridEdge*> _crossPartners;
+
+  GridDijkstra _dijkstra;
+
+  // grid nodes within the candidate radius of comb nodes, as sorted node
+  // ids. They only depend on the grid layout, the settled and closed state
+  // is checked on every lookup.
+  struct CandCacheEntry {
+    bool valid = false;
+    util::geo::DPoint p;
+    size_t maxDis = 0;
+    std::vector<size_t> ids;
+  };
+  std::unordered_map<const CombNode*, CandCacheEntry> _candCache;
+
+  const std::vector<size_t>& getCachedCands(const CombNode* n,
+                                            const util::geo::DPoint& p,
+                                            size_t maxDis);
 
   // may be multiple resident edges if hard constraints are relaxed
   std::unordered_map<GridEdge*, std::set<CombEdge*>> _resEdgs;
@@ -124,7 +176,19 @@ class GridGraph : public BaseGraph {
   const Grid<GridNode*, Point, double>& getGrid() const;
 
   virtual void writeInitialCosts();
-  virtual void writeObstacleCost(const util::geo::Polygon<double>& obst);
+
+  // the pairs of crossing grid edges, empty if edges cannot cross
+  virtual CrossEdgPairs computeCrossEdgPairs() const;
+
+  // build _crossPairs and the cross table, at the end of init()
+  void writeCrossTable();
+
+  // block or unblock both directions of all edges crossing ge
+  void setCrossBlocked(const GridEdge* ge, bool blocked);
+  // add the edges blocked by obst to mask, unsorted. No edge of a node
+  // farther than maxD away from obst may cross it.
+  virtual void writeObstacleMask(const util::geo::Polygon<double>& obst,
+                                 double maxD, ObstacleMask* mask) const;
   virtual void reWriteObstCosts();
 
   virtual double getBendPen(size_t origI, size_t targetI) const;
@@ -134,6 +198,16 @@ class GridGraph : public BaseGraph {
 
   virtual GridNode* writeNd(size_t x, size_t y);
 
+  // the sink node of cell (x, y) and its ports, without any edges
+  virtual GridNode* writeNdNds(size_t x, size_t y);
+
+  // the sink and in-node edges of sink n, with ids starting at firstId. They
+  // only touch the nodes of n's cell, so cells may be written concurrently
+  virtual void writeNdEdgs(GridNode* n, size_t firstId);
+
+  // number of edges written by writeNdEdgs()
+  size_t numNdEdgs() const;
+
   virtual GridNode* neigh(size_t cx, size_t cy, size_t i) const;
 
   virtual void getSettledAdjEdgs(GridNode* n, CombNode* origNd,
@@ -163,29 +237,36 @@ struct GridCost
   virtual float inf() const { return _inf; }
 };
 
-struct GridGraphHeur
+// The hull of the targets is stored as coordinate arrays. If the base graph
+// has a closed form heuristic, it is evaluated for all hull points in a
+// vectorized loop instead of calling heurCost() per point.
+struct GridGraphHeur final
     : public util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float> {
-  GridGraphHeur(const basegraph::GridGraph* g, const std::set<GridNode*>& to)
+  // if rev is set, the heuristic is for a backward search towards the
+  // source nodes "to", and the sink edges are leaving them
+  GridGraphHeur(const basegraph::GridGraph* g, const std::set<GridNode*>& to,
+                bool rev = false)
       : g(g) {
     cheapestSink = std::numeric_limits<float>::infinity();
+    closedForm = g->getHeurCoefs(&coefs);
 
     for (auto n : to) {
       assert(n->pl().getParent() == n);
       size_t i = 0;
       for (; i < g->maxDeg(); i++) {
         if (!n->pl().getPort(i)) continue;
-        float sinkCost = g->getEdg(n->pl().getPort(i), n)->pl().cost();
+        float sinkCost = sinkEdg(n, i, rev)->pl().cost();
         if (sinkCost < cheapestSink) cheapestSink = sinkCost;
         auto neigh = g->neigh(n, i);
         if (neigh && to.find(neigh) == to.end()) {
-          hull.push_back(n->pl().getX());
-          hull.push_back(n->pl().getY());
+          hullX.push_back(n->pl().getX());
+          hullY.push_back(n->pl().getY());
           break;
         }
       }
       for (size_t j = i; j < g->maxDeg(); j++) {
         if (!n->pl().getPort(j)) continue;
-        float sinkCost = g->getEdg(n->pl().getPort(j), n)->pl().cost();
+        float sinkCost = sinkEdg(n, j, rev)->pl().cost();
         if (sinkCost < cheapestSink) cheapestSink = sinkCost;
       }
     }
@@ -194,21 +275,55 @@ struct GridGraphHeur
   float operator()(const GridNode* from, const std::set<GridNode*>& to) const {
     if (to.count(from->pl().getParent())) return 0;
 
+    int32_t x = from->pl().getParent()->pl().getX();
+    int32_t y = from->pl().getParent()->pl().getY();
+
+    if (closedForm) return closedFormMin(x, y) + cheapestSink;
+
     float ret = std::numeric_limits<float>::infinity();
 
-    for (size_t i = 0; i < hull.size(); i += 2) {
-      float tmp = g->heurCost(from->pl().getParent()->pl().getX(),
-                              from->pl().getParent()->pl().getY(), hull[i],
-                              hull[i + 1]);
+    for (size_t i = 0; i < hullX.size(); i++) {
+      float tmp = g->heurCost(x, y, hullX[i], hullY[i]);
       if (tmp < ret) ret = tmp;
     }
 
     return ret + cheapestSink;
   }
 
-  const octi::basegraph::BaseGraph* g;
-  std::vector<size_t> hull;
+  const GridEdge* sinkEdg(GridNode* n, size_t i, bool rev) const {
+    if (rev) return g->getEdg(n, n->pl().getPort(i));
+    return g->getEdg(n->pl().getPort(i), n);
+  }
+
+  float closedFormMin(int32_t x, int32_t y) const {
+    const int32_t* hx = hullX.data();
+    const int32_t* hy = hullY.data();
+    size_t n = hullX.size();
+
+    const float cx = coefs.x, cy = coefs.y, cd = coefs.diag;
+    const float ct = coefs.turn, hop = coefs.hop;
+    const int32_t straightDiag = !coefs.diagTurn;
+
+    float ret = std::numeric_limits<float>::infinity();
+
+    // branch free, so the loop can be vectorized
+#pragma omp simd reduction(min : ret)
+    for (size_t i = 0; i < n; i++) {
+      int32_t dx = std::abs(hx[i] - x);
+      int32_t dy = std::abs(hy[i] - y);
+      int32_t turn = (dx != 0) & (dy != 0) & !(straightDiag & (dx == dy));
+      float c = cx * dx + cy * dy + cd * std::min(dx, dy) + ct * turn - hop;
+      ret = std::min(ret, std::max(c, 0.0f));
+    }
+
+    return ret;
+  }
+
+  const octi::basegraph::GridGraph* g;
+  std::vector<int32_t> hullX, hullY;
   float cheapestSink;
+  HeurCoefs coefs;
+  bool closedForm;
 };
 
 }  // namespace basegraph
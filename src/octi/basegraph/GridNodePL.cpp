@@ -2,6 +2,7 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <cassert>
 #include "octi/basegraph/GridNodePL.h"
 
 using util::geo::Point;
@@ -9,7 +10,16 @@ using namespace octi::basegraph;
 
 // _____________________________________________________________________________
 GridNodePL::GridNodePL(Point<double> pos)
-    : _pos(pos), _parent(0), _closed(false), _sink(false), _settled(false) {}
+    : _pos(pos),
+      _parent(0),
+      _nds(0),
+      _x(0),
+      _y(0),
+      _id(0),
+      _ports(0),
+      _closed(false),
+      _sink(false),
+      _settled(false) {}
 
 // _____________________________________________________________________________
 const Point<double>* GridNodePL::getGeom() const { return &_pos; }
@@ -34,10 +44,22 @@ GridNode* GridNodePL::getParent() const { return _parent; }
 void GridNodePL::setParent(GridNode* n) { _parent = n; }
 
 // _____________________________________________________________________________
-GridNode* GridNodePL::getPort(size_t i) const { return _ports[i]; }
+GridNode* GridNodePL::getPort(size_t i) const {
+  if (!(_ports & (1 << i))) return 0;
+  return (*_nds)[_id + 1 + i];
+}
 
 // _____________________________________________________________________________
-void GridNodePL::setPort(size_t p, GridNode* n) { _ports[p] = n; }
+void GridNodePL::setPort(size_t p, GridNode* n) {
+  assert(p < 8);
+  if (!n) {
+    _ports &= ~(1 << p);
+    return;
+  }
+  assert(n->pl().getId() == _id + 1 + p);
+  assert(_nds && (*_nds)[_id + 1 + p] == n);
+  _ports |= (1 << p);
+}
 
 // _____________________________________________________________________________
 void GridNodePL::setXY(size_t x, size_t y) {
@@ -46,7 +68,10 @@ void GridNodePL::setXY(size_t x, size_t y) {
 }
 
 // _____________________________________________________________________________
-void GridNodePL::setId(size_t id) { _id = id; }
+void GridNodePL::setId(size_t id, const std::vector<GridNode*>* nds) {
+  _id = id;
+  _nds = nds;
+}
 
 // _____________________________________________________________________________
 size_t GridNodePL::getId() const { return _id; }
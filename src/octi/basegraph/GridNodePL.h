@@ -5,6 +5,8 @@
 #ifndef OCTI_BASEGRAPH_GRIDNODEPL_H_
 #define OCTI_BASEGRAPH_GRIDNODEPL_H_
 
+#include <cstdint>
+#include <vector>
 #include "octi/basegraph/GridEdgePL.h"
 #include "util/geo/Geo.h"
 #include "util/geo/GeoGraph.h"
@@ -22,7 +24,16 @@ typedef util::graph::Edge<GridNodePL, GridEdgePL> GridEdge;
 
 class GridNodePL : util::geograph::GeoNodePL<double> {
  public:
-  GridNodePL(){};
+  GridNodePL()
+      : _parent(0),
+        _nds(0),
+        _x(0),
+        _y(0),
+        _id(0),
+        _ports(0),
+        _closed(false),
+        _sink(false),
+        _settled(false){};
   GridNodePL(Point<double> pos);
 
   const Point<double>* getGeom() const;
@@ -47,17 +58,24 @@ class GridNodePL : util::geograph::GeoNodePL<double> {
   bool isSettled() const;
   void setSettled(bool c);
 
-  void setId(size_t id);
+  // nds is the node array of the grid graph this node is stored in, indexed
+  // by node id
+  void setId(size_t id, const std::vector<GridNode*>* nds);
   size_t getId() const;
 
  private:
   Point<double> _pos;
 
   GridNode* _parent;
-  GridNode* _ports[8];
+
+  // ports are always stored directly behind their parent node in the grid
+  // graph's node array, so port i has id _id + 1 + i. Instead of 8 pointers
+  // we only keep a bitmask of the ports which exist.
+  const std::vector<GridNode*>* _nds;
 
   uint32_t _x, _y;
   uint32_t _id;
+  uint8_t _ports;
   bool _closed : 1;
   bool _sink : 1;
   bool _settled : 1;
@@ -184,7 +184,7 @@ GridNode* HexGridGraph::writeNd(size_t x, size_t y) {
 
   auto pos = DPoint(xPos, yPos);
   GridNode* n = addNd(pos);
-  n->pl().setId(_nds.size());
+  n->pl().setId(_nds.size(), &_nds);
   _nds.push_back(n);
   n->pl().setSink();
 
@@ -222,7 +222,7 @@ GridNode* HexGridGraph::writeNd(size_t x, size_t y) {
     }
 
     GridNode* nn = addNd(DPoint(xPos + xi * _spacer, yPos + yi * _spacer));
-    nn->pl().setId(_nds.size());
+    nn->pl().setId(_nds.size(), &_nds);
     _nds.push_back(nn);
     nn->pl().setParent(n);
     n->pl().setPort(i, nn);
@@ -12,6 +12,12 @@
 #include "util/geo/output/GeoGraphJsonOutput.h"
 #include "util/graph/Node.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_in_parallel() 0
+#endif
+
 using namespace octi::basegraph;
 using octi::basegraph::NodeCost;
 using octi::basegraph::OctiGridGraph;
@@ -55,22 +61,7 @@ void OctiGridGraph::unSettleEdg(CombEdge* ce, GridNode* a, GridNode* b) {
   }
 
   // unblock blocked diagonal edges crossing this edge
-  size_t dir = getDir(a, b);
-  if (dir % 2 != 0 && _resEdgs[ge].size() == 0) {
-    size_t x = a->pl().getX();
-    size_t y = a->pl().getY();
-
-    auto na = neigh(x, y, (dir + 7) % 8);
-    auto nb = neigh(x, y, (dir + 1) % 8);
-
-    if (na && nb) {
-      auto e = getNEdg(na, nb);
-      auto f = getNEdg(nb, na);
-
-      e->pl().unblock();
-      f->pl().unblock();
-    }
-  }
+  if (_resEdgs[ge].size() == 0) setCrossBlocked(ge, false);
 }
 
 // _____________________________________________________________________________
@@ -104,22 +95,7 @@ void OctiGridGraph::settleEdg(GridNode* a, GridNode* b, CombEdge* e) {
   closeTurns(b);
 
   // block diagonal edges crossing this edge
-  size_t dir = getDir(a, b);
-  if (dir % 2 != 0) {
-    size_t x = a->pl().getX();
-    size_t y = a->pl().getY();
-
-    auto na = neigh(x, y, (dir + 7) % 8);
-    auto nb = neigh(x, y, (dir + 1) % 8);
-
-    if (na && nb) {
-      auto e = getNEdg(na, nb);
-      auto f = getNEdg(nb, na);
-
-      e->pl().block();
-      f->pl().block();
-    }
-  }
+  setCrossBlocked(ge, true);
 }
 
 // _____________________________________________________________________________
@@ -153,7 +129,7 @@ size_t OctiGridGraph::getDir(const GridNode* a, const GridNode* b) const {
 }
 
 // _____________________________________________________________________________
-CrossEdgPairs OctiGridGraph::getCrossEdgPairs() const {
+CrossEdgPairs OctiGridGraph::computeCrossEdgPairs() const {
   CrossEdgPairs ret;
 
   for (const GridNode* n : getNds()) {
@@ -189,6 +165,8 @@ std::vector<double> OctiGridGraph::getCosts() const {
 
 // _____________________________________________________________________________
 void OctiGridGraph::writeInitialCosts() {
+  // every cell only writes the costs of its outgoing grid edges
+#pragma omp parallel for schedule(static) if (!omp_in_parallel())
   for (size_t x = 0; x < _grid.getXWidth(); x++) {
     for (size_t y = 0; y < _grid.getYHeight(); y++) {
       auto n = getNode(x, y);
@@ -231,12 +209,12 @@ GridEdge* OctiGridGraph::getNEdg(const GridNode* a, const GridNode* b) const {
 }
 
 // _____________________________________________________________________________
-GridNode* OctiGridGraph::writeNd(size_t x, size_t y) {
+GridNode* OctiGridGraph::writeNdNds(size_t x, size_t y) {
   double xPos = _bbox.getLowerLeft().getX() + x * _cellSize;
   double yPos = _bbox.getLowerLeft().getY() + y * _cellSize;
 
   GridNode* n = addNd(DPoint(xPos, yPos));
-  n->pl().setId(_nds.size());
+  n->pl().setId(_nds.size(), &_nds);
   _nds.push_back(n);
   n->pl().setSink();
   _grid.add(x, y, n);
@@ -250,18 +228,29 @@ GridNode* OctiGridGraph::writeNd(size_t x, size_t y) {
     yi /= abs(abs(yi) - 1) + 1;
 
     GridNode* nn = addNd(DPoint(xPos + xi * _spacer, yPos + yi * _spacer));
-    nn->pl().setId(_nds.size());
+    nn->pl().setId(_nds.size(), &_nds);
     _nds.push_back(nn);
     nn->pl().setParent(n);
     n->pl().setPort(i, nn);
+  }
+
+  return n;
+}
+
+// _____________________________________________________________________________
+void OctiGridGraph::writeNdEdgs(GridNode* n, size_t firstId) {
+  size_t x = n->pl().getX();
+  size_t y = n->pl().getY();
+  size_t id = firstId;
+
+  for (size_t i = 0; i < 8; i++) {
+    auto nn = n->pl().getPort(i);
 
     auto e = addEdg(n, nn, GridEdgePL(INF, true, true));
-    e->pl().setId(_edgeCount);
-    _edgeCount++;
+    e->pl().setId(id++);
 
     e = addEdg(nn, n, GridEdgePL(INF, true, true));
-    e->pl().setId(_edgeCount);
-    _edgeCount++;
+    e->pl().setId(id++);
   }
 
   // in-node connections
@@ -276,18 +265,14 @@ GridNode* OctiGridGraph::writeNd(size_t x, size_t y) {
         pen = INF;
 
       auto e = addEdg(n->pl().getPort(i), n->pl().getPort(j),
-                            GridEdgePL(pen, true, false));
-      e->pl().setId(_edgeCount);
-      _edgeCount++;
+                      GridEdgePL(pen, true, false));
+      e->pl().setId(id++);
 
       e = addEdg(n->pl().getPort(j), n->pl().getPort(i),
-                       GridEdgePL(pen, true, false));
-      e->pl().setId(_edgeCount);
-      _edgeCount++;
+                 GridEdgePL(pen, true, false));
+      e->pl().setId(id++);
     }
   }
-
-  return n;
 }
 
 // _____________________________________________________________________________
@@ -328,6 +313,18 @@ double OctiGridGraph::heurCost(int64_t xa, int64_t ya, int64_t xb,
   return fmax(0, edgeCost - _heurHopCost);
 }
 
+// _____________________________________________________________________________
+bool OctiGridGraph::getHeurCoefs(HeurCoefs* c) const {
+  // see heurCost()
+  c->x = _heurXCost;
+  c->y = _heurYCost;
+  c->diag = _heurDiagSave;
+  c->turn = _c.p_135;
+  c->hop = _heurHopCost;
+  c->diagTurn = false;
+  return true;
+}
+
 // _____________________________________________________________________________
 double OctiGridGraph::ndMovePen(const CombNode* cbNd,
                                 const GridNode* grNd) const {
@@ -53,16 +53,18 @@ class OctiGridGraph : public GridGraph {
 
   virtual void unSettleEdg(CombEdge* ce, GridNode* a, GridNode* b);
   virtual void settleEdg(GridNode* a, GridNode* b, CombEdge* e);
-  virtual CrossEdgPairs getCrossEdgPairs() const;
   virtual GridEdge* getNEdg(const GridNode* a, const GridNode* b) const;
   virtual size_t maxDeg() const;
   virtual double ndMovePen(const CombNode* cbNd, const GridNode* grNd) const;
   virtual size_t getDir(const GridNode* a, const GridNode* b) const;
   virtual std::vector<double> getCosts() const;
+  virtual bool getHeurCoefs(HeurCoefs* c) const;
 
  protected:
+  virtual CrossEdgPairs computeCrossEdgPairs() const;
   virtual void writeInitialCosts();
-  virtual GridNode* writeNd(size_t x, size_t y);
+  virtual GridNode* writeNdNds(size_t x, size_t y);
+  virtual void writeNdEdgs(GridNode* n, size_t firstId);
   virtual GridNode* neigh(size_t cx, size_t cy, size_t i) const;
   virtual GridNode* getNode(size_t x, size_t y) const;
   virtual double getBendPen(size_t i, size_t j) const;
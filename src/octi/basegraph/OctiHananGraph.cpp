@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include "octi/basegraph/NodeCost.h"
@@ -11,6 +12,7 @@
 #include "util/Misc.h"
 #include "util/geo/output/GeoGraphJsonOutput.h"
 #include "util/graph/Node.h"
+#include "util/log/Log.h"
 
 using namespace octi::basegraph;
 using octi::basegraph::NodeCost;
@@ -50,14 +52,7 @@ void OctiHananGraph::unSettleEdg(CombEdge* ce, GridNode* a, GridNode* b) {
   }
 
   // unblock blocked diagonal edges crossing this edge
-  if (getDir(a, b) % 2 != 0 && _resEdgs[ge].size() == 0) {
-    auto pairs = _edgePairs.find(ge);
-    if (pairs == _edgePairs.end()) return;
-    for (auto p : pairs->second) {
-      p.first->pl().unblock();
-      p.second->pl().unblock();
-    }
-  }
+  if (_resEdgs[ge].size() == 0) setCrossBlocked(ge, false);
 }
 
 // _____________________________________________________________________________
@@ -96,18 +91,11 @@ void OctiHananGraph::settleEdg(GridNode* a, GridNode* b, CombEdge* e) {
   closeTurns(b);
 
   // block diagonal edges crossing this edge
-  if (getDir(a, b) % 2 != 0) {
-    auto pairs = _edgePairs.find(ge);
-    if (pairs == _edgePairs.end()) return;
-    for (auto p : pairs->second) {
-      p.first->pl().block();
-      p.second->pl().block();
-    }
-  }
+  setCrossBlocked(ge, true);
 }
 
 // _____________________________________________________________________________
-CrossEdgPairs OctiHananGraph::getCrossEdgPairs() const {
+CrossEdgPairs OctiHananGraph::computeCrossEdgPairs() const {
   CrossEdgPairs ret;
   std::unordered_map<const GridEdge*, std::set<const GridEdge*>> have;
 
@@ -149,204 +137,120 @@ GridEdge* OctiHananGraph::getNEdg(const GridNode* a, const GridNode* b) const {
 
 // _____________________________________________________________________________
 void OctiHananGraph::init() {
-  std::vector<GridNode*> xSorted;
-  std::vector<GridNode*> ySorted;
-
   _ndIdx.resize(_grid.getXWidth() * _grid.getYHeight());
 
-  std::set<std::pair<size_t, size_t>> coords;
+  std::vector<std::pair<size_t, size_t>> coords;
 
   // get coords
   for (auto cNd : _cg.getNds()) {
     int x = _grid.getCellXFromX(cNd->pl().getGeom()->getX());
     int y = _grid.getCellYFromY(cNd->pl().getGeom()->getY());
-    coords.insert({x, y});
+    coords.push_back({x, y});
   }
 
-  // hanan iterations
-  for (size_t i = 1; i < _iters; i++)
-    coords = getIterCoords(coords);
-
-  // write nodes
-  for (auto coord : coords) {
-    int x = coord.first;
-    int y = coord.second;
+  std::sort(coords.begin(), coords.end());
+  coords.erase(std::unique(coords.begin(), coords.end()), coords.end());
 
-    auto nd = writeNd(x, y);
+  if (coords.size() == 0) return;
 
-    xSorted.push_back(nd);
-    ySorted.push_back(nd);
+  // hanan iterations, the lines of the last input coordinates are the lines
+  // the grid nodes are connected along
+  for (size_t i = 1; i < _iters; i++) {
+    coords = getIterCoords(coords);
+    LOGTO(DEBUG, std::cerr) << "Hanan iteration " << i << ": " << coords.size()
+                            << " nodes";
   }
 
-  struct {
-    bool operator()(const GridNode* a, const GridNode* b) {
-      return a->pl().getX() < b->pl().getX();
-    }
-  } sortByX;
-
-  struct {
-    bool operator()(const GridNode* a, const GridNode* b) {
-      return a->pl().getY() < b->pl().getY();
-    }
-  } sortByY;
-
-  if (xSorted.size() == 0) return;
+  auto lines = getHananLines(coords);
+  coords = getIterCoords(coords);
 
-  std::vector<std::vector<GridNode*>> yAct(_grid.getYHeight());
-  std::vector<std::vector<GridNode*>> xAct(_grid.getXWidth());
+  LOGTO(DEBUG, std::cerr) << "Hanan grid has " << coords.size() << " nodes";
 
-  std::vector<std::vector<GridNode*>> xyAct(_grid.getXWidth() +
-                                            _grid.getYHeight());
-  std::vector<std::vector<GridNode*>> yxAct(_grid.getXWidth() +
-                                            _grid.getYHeight());
-
-  for (auto nd : xSorted) {
-    yAct[nd->pl().getY()].push_back(nd);
-  }
+  // nodes per active line, as (line, position on line, node), sorted
+  typedef std::vector<std::tuple<size_t, size_t, GridNode*>> LineNds;
+  LineNds yAct, xAct, xyAct, yxAct;
 
-  for (auto nd : xSorted) {
-    xAct[nd->pl().getX()].push_back(nd);
-  }
+  for (auto coord : coords) {
+    size_t x = coord.first;
+    size_t y = coord.second;
+    size_t xi = x + (_grid.getYHeight() - 1 - y);
+    size_t yi = y + x;
 
-  for (auto nd : xSorted) {
-    xyAct[nd->pl().getX() + (_grid.getYHeight() - 1 - nd->pl().getY())]
-        .push_back(nd);
-  }
+    auto nd = writeNd(x, y);
 
-  for (auto nd : xSorted) {
-    yxAct[nd->pl().getY() + nd->pl().getX()].push_back(nd);
+    if (std::binary_search(lines.y.begin(), lines.y.end(), y))
+      yAct.push_back({y, x, nd});
+    if (std::binary_search(lines.x.begin(), lines.x.end(), x))
+      xAct.push_back({x, y, nd});
+    if (std::binary_search(lines.xy.begin(), lines.xy.end(), xi))
+      xyAct.push_back({xi, y, nd});
+    if (std::binary_search(lines.yx.begin(), lines.yx.end(), yi))
+      yxAct.push_back({yi, x, nd});
   }
 
-  for (size_t x = 0; x < _grid.getXWidth(); x++) {
-    if (!xAct[x].size()) continue;
-
-    for (size_t y = 0; y < _grid.getYHeight(); y++) {
-      if (!yAct[y].size()) continue;
-      if (getNode(x, y)) continue;
-      auto newNd = writeNd(x, y);
-      yAct[y].push_back(newNd);
-      xAct[x].push_back(newNd);
-    }
+  for (auto* act : {&yAct, &xAct, &xyAct, &yxAct}) {
+    std::sort(act->begin(), act->end());
   }
 
-  for (size_t x = 0; x < _grid.getXWidth(); x++) {
-    for (size_t y = 0; y < _grid.getYHeight(); y++) {
-      size_t xi = x + (_grid.getYHeight() - 1 - y);
-      size_t yi = y + x;
-      if ((xyAct[xi].size() &&
-           (yxAct[yi].size() || yAct[y].size() || xAct[x].size())) ||
-          (yxAct[yi].size() &&
-           (xyAct[xi].size() || yAct[y].size() || xAct[x].size()))) {
-        bool have = false;
-
-        auto newNd = getNode(x, y);
-
-        if (newNd) {
-          have = true;
-        }
-
-        if (!have) newNd = writeNd(x, y);
-
-        if (xyAct[xi].size()) {
-          xyAct[xi].push_back(newNd);
-        }
-
-        if (yxAct[yi].size()) {
-          yxAct[yi].push_back(newNd);
-        }
-
-        if (have) continue;
-
-        if (yAct[y].size()) {
-          yAct[y].push_back(newNd);
-        }
+  // init the _neighs size
+  _neighs.resize(_nds.size() * 8);
 
-        if (xAct[x].size()) {
-          xAct[x].push_back(newNd);
-        }
-      }
+  auto connect = [this](const LineNds& act, size_t dir) {
+    for (size_t i = 1; i < act.size(); i++) {
+      if (std::get<0>(act[i - 1]) != std::get<0>(act[i])) continue;
+      connectNodes(std::get<2>(act[i - 1]), std::get<2>(act[i]), dir);
     }
-  }
+  };
 
-  for (size_t x = 0; x < _grid.getXWidth(); x++) {
-    std::sort(xAct[x].begin(), xAct[x].end(), sortByY);
-  }
+  connect(yAct, 2);
+  connect(xAct, 0);
+  connect(xyAct, 1);
+  connect(yxAct, 3);
 
-  for (size_t y = 0; y < _grid.getYHeight(); y++) {
-    std::sort(yAct[y].begin(), yAct[y].end(), sortByX);
-  }
+  // diagonal intersections
+  for (size_t j = 1; j < xyAct.size(); j++) {
+    if (std::get<0>(xyAct[j - 1]) != std::get<0>(xyAct[j])) continue;
+    auto ndA = std::get<2>(xyAct[j - 1]);
+    auto ndB = std::get<2>(xyAct[j]);
 
-  for (size_t i = 0; i < _grid.getYHeight() + _grid.getXWidth(); i++) {
-    std::sort(xyAct[i].begin(), xyAct[i].end(), sortByY);
-    std::sort(yxAct[i].begin(), yxAct[i].end(), sortByX);
-  }
+    auto ea = getNEdg(ndA, ndB);
+    auto eb = getNEdg(ndB, ndA);
 
+    size_t yi = ndA->pl().getX() + ndA->pl().getY() + 1;
 
-  // init the _neighs size
-  _neighs.resize(_nds.size() * 8);
+    // the first node on diagonal yi with an x greater than ndA, and the
+    // node before it on the same diagonal
+    auto it = std::upper_bound(
+        yxAct.begin(), yxAct.end(),
+        std::make_pair(yi, static_cast<size_t>(ndA->pl().getX())),
+        [](const std::pair<size_t, size_t>& v,
+           const std::tuple<size_t, size_t, GridNode*>& e) {
+          return v < std::make_pair(std::get<0>(e), std::get<1>(e));
+        });
 
-  for (size_t y = 0; y < _grid.getYHeight(); y++) {
-    for (size_t i = 1; i < yAct[y].size(); i++) {
-      connectNodes(yAct[y][i - 1], yAct[y][i], 2);
-    }
-  }
+    if (it == yxAct.end() || it == yxAct.begin()) continue;
+    if (std::get<0>(*it) != yi || std::get<0>(*(it - 1)) != yi) continue;
 
-  for (size_t x = 0; x < _grid.getXWidth(); x++) {
-    for (size_t i = 1; i < xAct[x].size(); i++) {
-      connectNodes(xAct[x][i - 1], xAct[x][i], 0);
-    }
-  }
+    auto oNdA = std::get<2>(*(it - 1));
+    auto oNdB = std::get<2>(*it);
+    assert(oNdA != oNdB);
 
-  for (size_t xi = 0; xi < _grid.getXWidth() + _grid.getYHeight(); xi++) {
-    for (size_t i = 1; i < xyAct[xi].size(); i++) {
-      connectNodes(xyAct[xi][i - 1], xyAct[xi][i], 1);
-    }
-  }
+    auto fa = getNEdg(oNdA, oNdB);
+    auto fb = getNEdg(oNdB, oNdA);
 
-  for (size_t yi = 0; yi < _grid.getXWidth() + _grid.getYHeight(); yi++) {
-    for (size_t i = 1; i < yxAct[yi].size(); i++) {
-      connectNodes(yxAct[yi][i - 1], yxAct[yi][i], 3);
-    }
-  }
+    _edgePairs[ea].push_back({fa, fb});
+    _edgePairs[eb].push_back({fa, fb});
 
-  // diagonal intersections
-  for (size_t i = 0; i < _grid.getXWidth() + _grid.getYHeight(); i++) {
-    for (size_t j = 1; j < xyAct[i].size(); j++) {
-      auto ndA = xyAct[i][j - 1];
-      auto ndB = xyAct[i][j];
-      if (ndA == ndB) continue;  // there may be duplicates
-
-      auto ea = getNEdg(ndA, ndB);
-      auto eb = getNEdg(ndB, ndA);
-
-      size_t yi = ndA->pl().getX() + ndA->pl().getY() + 1;
-      if (yi < yxAct.size() && yxAct[yi].size()) {
-        auto it =
-            std::upper_bound(yxAct[yi].begin(), yxAct[yi].end(), ndA, sortByX);
-
-        if (it != yxAct[yi].end() && it != yxAct[yi].begin()) {
-          // it is the first element with an x greater than ndA, which means
-          // that the preceeding element at it-1 has a different x, so we are
-          // filtering out duplicates here automatically
-          auto oNdA = *(it - 1);
-          auto oNdB = *(it);
-          assert(oNdA != oNdB);
-
-          auto fa = getNEdg(oNdA, oNdB);
-          auto fb = getNEdg(oNdB, oNdA);
-
-          _edgePairs[ea].push_back({fa, fb});
-          _edgePairs[eb].push_back({fa, fb});
-
-          _edgePairs[fa].push_back({ea, eb});
-          _edgePairs[fb].push_back({ea, eb});
-        }
-      }
-    }
+    _edgePairs[fa].push_back({ea, eb});
+    _edgePairs[fb].push_back({ea, eb});
   }
 
   prunePorts();
   writeInitialCosts();
+  writeCrossTable();
+
+  // the crossings are now in the cross table
+  _edgePairs.clear();
 }
 
 // _____________________________________________________________________________
@@ -405,7 +309,7 @@ GridNode* OctiHananGraph::writeNd(size_t x, size_t y) {
   double yPos = _bbox.getLowerLeft().getY() + y * _cellSize;
 
   GridNode* n = addNd(DPoint(xPos, yPos));
-  n->pl().setId(_nds.size());
+  n->pl().setId(_nds.size(), &_nds);
   _nds.push_back(n);
   _ndIdx[x * _grid.getYHeight() + y] = _nds.size();
   n->pl().setSink();
@@ -420,7 +324,7 @@ GridNode* OctiHananGraph::writeNd(size_t x, size_t y) {
     yi /= abs(abs(yi) - 1) + 1;
 
     GridNode* nn = addNd(DPoint(xPos + xi * _spacer, yPos + yi * _spacer));
-    nn->pl().setId(_nds.size());
+    nn->pl().setId(_nds.size(), &_nds);
     _nds.push_back(nn);
     nn->pl().setParent(n);
     n->pl().setPort(i, nn);
@@ -508,68 +412,65 @@ double OctiHananGraph::ndMovePen(const CombNode* cbNd,
 }
 
 // _____________________________________________________________________________
-std::set<std::pair<size_t, size_t>> OctiHananGraph::getIterCoords(const std::set<std::pair<size_t, size_t>>& inCoords) const {
-
-  std::set<std::pair<size_t, size_t>> ret;
-
-  std::vector<std::pair<size_t, size_t>> xSorted;
-  std::vector<std::pair<size_t, size_t>> ySorted;
+HananLines OctiHananGraph::getHananLines(
+    const std::vector<std::pair<size_t, size_t>>& coords) const {
+  HananLines ret;
+
+  for (auto c : coords) {
+    ret.x.push_back(c.first);
+    ret.y.push_back(c.second);
+    ret.xy.push_back(c.first + (_grid.getYHeight() - 1 - c.second));
+    ret.yx.push_back(c.first + c.second);
+  }
 
-  // write nodes
-  for (auto coord : inCoords) {
-    xSorted.push_back(coord);
-    ySorted.push_back(coord);
+  for (auto* l : {&ret.x, &ret.y, &ret.xy, &ret.yx}) {
+    std::sort(l->begin(), l->end());
+    l->erase(std::unique(l->begin(), l->end()), l->end());
   }
 
-  std::vector<std::vector<std::pair<size_t, size_t>>> yAct(_grid.getYHeight());
-  std::vector<std::vector<std::pair<size_t, size_t>>> xAct(_grid.getXWidth());
+  return ret;
+}
 
-  std::vector<std::vector<std::pair<size_t, size_t>>> xyAct(_grid.getXWidth() +
-                                            _grid.getYHeight());
-  std::vector<std::vector<std::pair<size_t, size_t>>> yxAct(_grid.getXWidth() +
-                                            _grid.getYHeight());
+// _____________________________________________________________________________
+std::vector<std::pair<size_t, size_t>> OctiHananGraph::getIterCoords(
+    const std::vector<std::pair<size_t, size_t>>& inCoords) const {
+  // all crossings of an active row or column with an active row or column,
+  // and of an active diagonal with any other active line
+  auto lines = getHananLines(inCoords);
 
-  for (auto c : xSorted) {
-    yAct[c.second].push_back(c);
-  }
+  int64_t w = _grid.getXWidth();
+  int64_t h = _grid.getYHeight();
 
-  for (auto c : xSorted) {
-    xAct[c.first].push_back(c);
-  }
+  std::vector<std::pair<size_t, size_t>> ret;
+  ret.reserve(lines.x.size() * lines.y.size());
 
-  for (auto c : xSorted) {
-    xyAct[c.first + (_grid.getYHeight() - 1 - c.second)]
-        .push_back(c);
-  }
+  auto add = [&ret, w, h](int64_t x, int64_t y) {
+    if (x < 0 || y < 0 || x >= w || y >= h) return;
+    ret.push_back({x, y});
+  };
 
-  for (auto c : xSorted) {
-    yxAct[c.second + c.first].push_back(c);
+  for (int64_t x : lines.x) {
+    for (int64_t y : lines.y) add(x, y);
   }
 
-  for (size_t x = 0; x < _grid.getXWidth(); x++) {
-    if (!xAct[x].size()) continue;
-
-    for (size_t y = 0; y < _grid.getYHeight(); y++) {
-      if (!yAct[y].size()) continue;
-      if (ret.count({x, y})) continue;
-      ret.insert({x, y});
-      yAct[y].push_back({x, y});
-      xAct[x].push_back({x, y});
+  for (int64_t xi : lines.xy) {
+    // x - y = off on this diagonal
+    int64_t off = xi - (h - 1);
+    for (int64_t x : lines.x) add(x, x - off);
+    for (int64_t y : lines.y) add(y + off, y);
+    for (int64_t yi : lines.yx) {
+      if ((yi + off) % 2) continue;
+      add((yi + off) / 2, (yi - off) / 2);
     }
   }
 
-  for (size_t x = 0; x < _grid.getXWidth(); x++) {
-    for (size_t y = 0; y < _grid.getYHeight(); y++) {
-      size_t xi = x + (_grid.getYHeight() - 1 - y);
-      size_t yi = y + x;
-      if ((xyAct[xi].size() &&
-           (yxAct[yi].size() || yAct[y].size() || xAct[x].size())) ||
-          (yxAct[yi].size() &&
-           (xyAct[xi].size() || yAct[y].size() || xAct[x].size()))) {
-        if (!ret.count({x, y})) ret.insert({x, y});
-      }
-    }
+  for (int64_t yi : lines.yx) {
+    for (int64_t x : lines.x) add(x, yi - x);
+    for (int64_t y : lines.y) add(yi - y, y);
   }
 
+  std::sort(ret.begin(), ret.end());
+  ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+
   return ret;
 }
@@ -5,11 +5,19 @@
 #ifndef OCTI_BASEGRAPH_OCTIHANANGRAPH_H_
 #define OCTI_BASEGRAPH_OCTIHANANGRAPH_H_
 
+#include <utility>
+#include <vector>
 #include "octi/basegraph/OctiGridGraph.h"
 
 namespace octi {
 namespace basegraph {
 
+// sorted indices of the active rows, columns and diagonals of a set of grid
+// coordinates, diagonal xy of (x, y) is x + height - 1 - y, yx is x + y
+struct HananLines {
+  std::vector<size_t> x, y, xy, yx;
+};
+
 class OctiHananGraph : public OctiGridGraph {
  public:
   using OctiGridGraph::neigh;
@@ -20,13 +28,13 @@ class OctiHananGraph : public OctiGridGraph {
 
   virtual void unSettleEdg(CombEdge* ce, GridNode* a, GridNode* b);
   virtual void settleEdg(GridNode* a, GridNode* b, CombEdge* e);
-  virtual CrossEdgPairs getCrossEdgPairs() const;
   virtual GridEdge* getNEdg(const GridNode* a, const GridNode* b) const;
   virtual size_t maxDeg() const;
   virtual double ndMovePen(const CombNode* cbNd, const GridNode* grNd) const;
   virtual void init();
 
  protected:
+  virtual CrossEdgPairs computeCrossEdgPairs() const;
   virtual GridNode* writeNd(size_t x, size_t y);
   virtual GridNode* neigh(size_t cx, size_t cy, size_t i) const;
   virtual GridNode* getNode(size_t x, size_t y) const;
@@ -34,8 +42,12 @@ class OctiHananGraph : public OctiGridGraph {
   virtual size_t ang(size_t i, size_t j) const;
   virtual void connectNodes(GridNode* grNdA, GridNode* grNdB, size_t dir);
   virtual void writeInitialCosts();
-  std::set<std::pair<size_t, size_t>> getIterCoords(
-      const std::set<std::pair<size_t, size_t>>& inCoords) const;
+  HananLines getHananLines(
+      const std::vector<std::pair<size_t, size_t>>& coords) const;
+
+  // sorted coordinates of the next Hanan iteration
+  std::vector<std::pair<size_t, size_t>> getIterCoords(
+      const std::vector<std::pair<size_t, size_t>>& inCoords) const;
 
   const combgraph::CombGraph& _cg;
   size_t _iters;
@@ -12,6 +12,7 @@
 #include "util/geo/QuadTree.h"
 #include "util/geo/output/GeoGraphJsonOutput.h"
 #include "util/graph/Node.h"
+#include "util/log/Log.h"
 
 using namespace octi::basegraph;
 using octi::basegraph::NodeCost;
@@ -45,37 +46,7 @@ void OctiQuadTree::unSettleEdg(CombEdge* ce, GridNode* a, GridNode* b) {
   }
 
   // unblock diagonal edges crossing this edge
-
-  // for diagonal edges, x and y difference is equivalent
-  int len = labs((int)a->pl().getX() - (int)b->pl().getX());
-
-  size_t dir = getDir(a, b);
-
-  GridNode* aa = 0;
-  GridNode* bb = 0;
-
-  if (dir == 1) {
-    aa = getNode(a->pl().getX(), a->pl().getY() + len);
-    bb = getNode(a->pl().getX() + len, a->pl().getY());
-  } else if (dir == 3) {
-    aa = getNode(a->pl().getX() + len, a->pl().getY());
-    bb = getNode(a->pl().getX(), a->pl().getY() - len);
-  } else if (dir == 5) {
-    aa = getNode(a->pl().getX() - len, a->pl().getY());
-    bb = getNode(a->pl().getX(), a->pl().getY() - len);
-  } else if (dir == 7) {
-    aa = getNode(a->pl().getX() - len, a->pl().getY());
-    bb = getNode(a->pl().getX(), a->pl().getY() + len);
-  }
-
-  if (aa && bb && _resEdgs[ge].size() == 0) {
-    auto e = getNEdg(aa, bb);
-    auto f = getNEdg(bb, aa);
-    if (e && f) {
-      e->pl().unblock();
-      f->pl().unblock();
-    }
-  }
+  if (_resEdgs[ge].size() == 0) setCrossBlocked(ge, false);
 }
 
 // _____________________________________________________________________________
@@ -95,41 +66,11 @@ void OctiQuadTree::settleEdg(GridNode* a, GridNode* b, CombEdge* e) {
   closeTurns(b);
 
   // block diagonal edges crossing this edge
-  // for diagonal edges, x and y difference is equivalent
-  int len = labs((int)a->pl().getX() - (int)b->pl().getX());
-
-  size_t dir = getDir(a, b);
-
-  GridNode* aa = 0;
-  GridNode* bb = 0;
-
-  if (dir == 1) {
-    aa = getNode(a->pl().getX(), a->pl().getY() + len);
-    bb = getNode(a->pl().getX() + len, a->pl().getY());
-  } else if (dir == 3) {
-    aa = getNode(a->pl().getX() + len, a->pl().getY());
-    bb = getNode(a->pl().getX(), a->pl().getY() - len);
-  } else if (dir == 5) {
-    aa = getNode(a->pl().getX() - len, a->pl().getY());
-    bb = getNode(a->pl().getX(), a->pl().getY() - len);
-  } else if (dir == 7) {
-    aa = getNode(a->pl().getX() - len, a->pl().getY());
-    bb = getNode(a->pl().getX(), a->pl().getY() + len);
-  }
-
-  if (aa && bb) {
-    auto e = getNEdg(aa, bb);
-    auto f = getNEdg(bb, aa);
-
-    if (e && f) {
-      e->pl().block();
-      f->pl().block();
-    }
-  }
+  setCrossBlocked(ge, true);
 }
 
 // _____________________________________________________________________________
-CrossEdgPairs OctiQuadTree::getCrossEdgPairs() const {
+CrossEdgPairs OctiQuadTree::computeCrossEdgPairs() const {
   CrossEdgPairs ret;
   for (const GridNode* n : getNds()) {
     if (!n->pl().isSink()) continue;
@@ -187,16 +128,21 @@ void OctiQuadTree::init() {
   _bbox = newBox;
 
 struct SplitFunc : util::geo::SplitFunc<const CombNode*, double> {
-  SplitFunc(double cellSize) : _cellSize(cellSize) {}
+  SplitFunc(double minSize, size_t maxPts)
+      : _minSize(minSize), _maxPts(maxPts) {}
   virtual bool operator()(const QuadNode<double>& nd,
                        const QuadValue<const CombNode*, double>& newVal) const {
     UNUSED(newVal);
     double l = nd.bbox.getUpperRight().getX() - nd.bbox.getLowerLeft().getX();
 
-    return nd.numEls > 0 || l > _cellSize;
+    // the new value would exceed the points allowed in this cell, and the
+    // children are not smaller than the min cell size
+    return l > _minSize && static_cast<size_t>(nd.numEls + 1) > _maxPts;
   }
-  double _cellSize;
-} sFunc(_cellSize);
+  double _minSize;
+  size_t _maxPts;
+} sFunc((2 * std::max(1.0, _params.minCellSize) - 1) * _cellSize,
+        _params.maxLeafPts);
 
   QuadTree<const CombNode*, double> qt(maxDepth, sFunc, newBox);
 
@@ -210,6 +156,24 @@ struct SplitFunc : util::geo::SplitFunc<const CombNode*, double> {
     qt.insert(cNd, *cNd->pl().getGeom());
   }
 
+  // write edge samples to quadtree
+  if (_params.edgeSampleDist > 0) {
+    double step = _params.edgeSampleDist * _cellSize;
+    for (auto cNd : _cg.getNds()) {
+      for (auto cEdg : cNd->getAdjList()) {
+        if (cEdg->getFrom() != cNd) continue;
+        const auto& a = *cEdg->getFrom()->pl().getGeom();
+        const auto& b = *cEdg->getTo()->pl().getGeom();
+        size_t n = dist(a, b) / step;
+        for (size_t i = 1; i <= n; i++) {
+          double p = (i * step) / dist(a, b);
+          qt.insert(0, DPoint(a.getX() + p * (b.getX() - a.getX()),
+                              a.getY() + p * (b.getY() - a.getY())));
+        }
+      }
+    }
+  }
+
   struct SortByCellSize {
     SortByCellSize(const std::vector<QuadNode<double>>& qnds) : qnds(qnds) {}
     bool operator()(size_t aNid, size_t bNid) {
@@ -289,6 +253,11 @@ struct SplitFunc : util::geo::SplitFunc<const CombNode*, double> {
 
   prunePorts();
   writeInitialCosts();
+  writeCrossTable();
+
+  LOGTO(DEBUG, std::cerr) << "Quadtree grid has " << _nds.size()
+                          << " nodes and " << _edgeCount << " edges ("
+                          << sortedQdNds.size() << " quadtree cells)";
 }
 
 // _____________________________________________________________________________
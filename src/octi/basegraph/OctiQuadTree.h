@@ -10,18 +10,41 @@
 namespace octi {
 namespace basegraph {
 
+// split criteria of the quadtree cells
+struct QuadTreeParams {
+  // cells with at most this many points are not split further, 0 means
+  // every cell with a point is split down to minCellSize
+  size_t maxLeafPts = 0;
+
+  // cells are not split below this many grid cells
+  double minCellSize = 1;
+
+  // if > 0, comb edges are sampled every this many grid cells, and the
+  // samples count as points, which refines the cells along the edges
+  double edgeSampleDist = 0;
+};
+
 class OctiQuadTree : public OctiHananGraph {
  public:
   using OctiGridGraph::neigh;
   OctiQuadTree(const util::geo::DBox& bbox, const combgraph::CombGraph& cg,
                double cellSize, double spacer, const Penalties& pens)
       : OctiHananGraph(bbox, cg, cellSize, spacer, 1, pens) {}
+  OctiQuadTree(const util::geo::DBox& bbox, const combgraph::CombGraph& cg,
+               double cellSize, double spacer, const Penalties& pens,
+               const QuadTreeParams& params)
+      : OctiHananGraph(bbox, cg, cellSize, spacer, 1, pens), _params(params) {}
 
   virtual void unSettleEdg(CombEdge* ce, GridNode* a, GridNode* b);
   virtual void settleEdg(GridNode* a, GridNode* b, CombEdge* e);
-  virtual CrossEdgPairs getCrossEdgPairs() const;
   virtual double ndMovePen(const CombNode* cbNd, const GridNode* grNd) const;
   virtual void init();
+
+ protected:
+  virtual CrossEdgPairs computeCrossEdgPairs() const;
+
+ private:
+  QuadTreeParams _params;
 };
 }  // namespace basegraph
 }  // namespace octi
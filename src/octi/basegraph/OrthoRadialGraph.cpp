@@ -23,6 +23,19 @@ using util::geo::DPoint;
 
 // _____________________________________________________________________________
 void OrthoRadialGraph::init() {
+  _center = DPoint(
+      _bbox.getLowerLeft().getX() +
+          (_bbox.getUpperRight().getX() - _bbox.getLowerLeft().getX()) * 0.5,
+      _bbox.getLowerLeft().getY() +
+          (_bbox.getUpperRight().getY() - _bbox.getLowerLeft().getY()) * 0.5);
+
+  double angStep = 2.0 * M_PI / _numBeams;
+  _beamDirs.resize(_numBeams);
+  for (size_t x = 0; x < _numBeams; x++) {
+    double curAngle = -angStep * x + 0.5 * M_PI;
+    _beamDirs[x] = DPoint(cos(curAngle), sin(curAngle));
+  }
+
   // write nodes
   // TODO: we are only going from 1 because we have no center node
   for (size_t y = 1; y < _grid.getYHeight() / 2; y++) {
@@ -111,6 +124,17 @@ void OrthoRadialGraph::writeInitialCosts() {
     for (size_t y = 0; y < _grid.getYHeight() / 2; y++) {
       auto n = getNode(x, y);
       if (!n) continue;
+
+      // this is percentage the hop length is longer than the smallest cell
+      // size
+      double sX = (angStep * y) / angStep;
+
+      // here, the costs are normalized to always represent the map lengths
+      // exactly: vertical hops always have the same length, horizontal hops
+      // get bigger with higher y (= higher radius)
+      double vertCost = _c.verticalPen;
+      double horiCost = (_c.horizontalPen + c_0) * sX - c_0;
+
       for (size_t i = 0; i < maxDeg(); i++) {
         auto port = n->pl().getPort(i);
         auto neighbor = neigh(x, y, i);
@@ -120,19 +144,7 @@ void OrthoRadialGraph::writeInitialCosts() {
         auto oPort = neighbor->pl().getPort((i + maxDeg() / 2) % maxDeg());
         auto e = getEdg(port, oPort);
 
-        // this is percentage the hop length is longer than the smallest cell
-        // size
-        double sX = (angStep * y) / angStep;
-
-        // here, the costs are normalized to always
-        // represent the map lengths exactly
-        if (i % 2 == 0) {
-          // vertical hops always have the same length
-          e->pl().setCost((_c.verticalPen));
-        } else {
-          // horizontal hops get bigger with higher y (= higher radius)
-          e->pl().setCost((_c.horizontalPen + c_0) * sX - c_0);
-        }
+        e->pl().setCost(i % 2 == 0 ? vertCost : horiCost);
       }
     }
   }
@@ -168,27 +180,15 @@ double OrthoRadialGraph::ndMovePen(const CombNode* cbNd,
 
 // _____________________________________________________________________________
 GridNode* OrthoRadialGraph::writeNd(size_t x, size_t y) {
-  double origX =
-      _bbox.getLowerLeft().getX() +
-      (_bbox.getUpperRight().getX() - _bbox.getLowerLeft().getX()) * 0.5;
-
-  double origY =
-      _bbox.getLowerLeft().getY() +
-      (_bbox.getUpperRight().getY() - _bbox.getLowerLeft().getY()) * 0.5;
-
-  double angStep = 2.0 * M_PI / _numBeams;
-
-  double curAngle = -angStep * x + 0.5 * M_PI;
-
-  double xPos = origX + y * cos(curAngle) * _cellSize;
-  double yPos = origY + y * sin(curAngle) * _cellSize;
+  double xPos = _center.getX() + y * _beamDirs[x].getX() * _cellSize;
+  double yPos = _center.getY() + y * _beamDirs[x].getY() * _cellSize;
   auto pos = DPoint(xPos, yPos);
 
   double c_0 = _c.p_45 - _c.p_135;
   double c_90 = _c.p_45 - _c.p_135 + _c.p_90;
 
   GridNode* n = addNd(pos);
-  n->pl().setId(_nds.size());
+  n->pl().setId(_nds.size(), &_nds);
   _nds.push_back(n);
   n->pl().setSink();
   _grid.add(pos, n);
@@ -205,7 +205,7 @@ GridNode* OrthoRadialGraph::writeNd(size_t x, size_t y) {
     if (i == 3) xi = -1;
 
     GridNode* nn = addNd(DPoint(xPos + xi * _spacer, yPos + yi * _spacer));
-    nn->pl().setId(_nds.size());
+    nn->pl().setId(_nds.size(), &_nds);
     _nds.push_back(nn);
     nn->pl().setParent(n);
     n->pl().setPort(i, nn);
@@ -258,14 +258,6 @@ GridNode* OrthoRadialGraph::getNode(size_t x, size_t y) const {
 // _____________________________________________________________________________
 PolyLine<double> OrthoRadialGraph::geomFromPath(
     const std::vector<std::pair<size_t, size_t>>& res) const {
-  double origX =
-      _bbox.getLowerLeft().getX() +
-      (_bbox.getUpperRight().getX() - _bbox.getLowerLeft().getX()) * 0.5;
-
-  double origY =
-      _bbox.getLowerLeft().getY() +
-      (_bbox.getUpperRight().getY() - _bbox.getLowerLeft().getY()) * 0.5;
-
   PolyLine<double> pl;
   for (auto revIt = res.rbegin(); revIt != res.rend(); revIt++) {
     auto f = getEdg(getGrNdById(revIt->first), getGrNdById(revIt->second));
@@ -283,7 +275,7 @@ PolyLine<double> OrthoRadialGraph::geomFromPath(
         }
 
         CircularSegment<double> seg(*frPar->pl().getGeom(), -angStep,
-                                    {origX, origY});
+                                    _center);
         for (auto p : seg.render(10).getLine()) pl << p;
       }
 
@@ -40,6 +40,12 @@ class OrthoRadialGraph : public GridGraph {
 
  private:
   size_t _numBeams;
+
+  // center of the rings
+  util::geo::DPoint _center;
+
+  // unit directions of the beams
+  std::vector<util::geo::DPoint> _beamDirs;
 };
 
 struct OrthoRadialGraphHeur
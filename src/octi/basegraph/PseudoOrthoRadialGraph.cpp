@@ -29,8 +29,10 @@ int PseudoOrthoRadialGraph::multi(size_t y) const {
 }
 
 // _____________________________________________________________________________
-void PseudoOrthoRadialGraph::writeObstacleCost(
-    const util::geo::Polygon<double>& obst) {
+void PseudoOrthoRadialGraph::writeObstacleMask(
+    const util::geo::Polygon<double>& obst, double maxD,
+    ObstacleMask* mask) const {
+  UNUSED(maxD);
   for (size_t y = 1; y < _grid.getYHeight() / 2; y++) {
     for (size_t x = 0; x < _numBeams * multi(y); x++) {
       auto grNdA = getNode(x, y);
@@ -48,7 +50,8 @@ void PseudoOrthoRadialGraph::writeObstacleCost(
                 util::geo::LineSegment<double>(*ge->getFrom()->pl().getGeom(),
                                                *ge->getTo()->pl().getGeom()),
                 obst)) {
-          ge->pl().setCost(std::numeric_limits<double>::infinity());
+          mask->push_back(
+              {ge->getFrom()->pl().getId(), ge->getTo()->pl().getId()});
         }
       }
     }
@@ -56,54 +59,36 @@ void PseudoOrthoRadialGraph::writeObstacleCost(
 }
 
 // _____________________________________________________________________________
-void PseudoOrthoRadialGraph::writeGeoCoursePens(const CombEdge* ce,
-                                                GeoPensMap* target,
-                                                double pen) {
-  std::set<GridNode*> neighs;
-
-  DBox box;
-
-  std::vector<util::geo::DLine> geoms;
+void PseudoOrthoRadialGraph::writeTables() {
+  _center = DPoint(
+      _bbox.getLowerLeft().getX() +
+          (_bbox.getUpperRight().getX() - _bbox.getLowerLeft().getX()) * 0.5,
+      _bbox.getLowerLeft().getY() +
+          (_bbox.getUpperRight().getY() - _bbox.getLowerLeft().getY()) * 0.5);
 
-  for (auto orE : ce->pl().getChilds()) {
-    box = util::geo::extendBox(*orE->pl().getGeom(), box);
+  size_t rings = _grid.getYHeight() / 2;
 
-    // operate on simplified geometries
-    geoms.push_back(util::geo::simplify(*orE->pl().getGeom(), 5));
+  _ringOffs.assign(std::max<size_t>(rings, 1) + 1, 0);
+  for (size_t y = 2; y < _ringOffs.size(); y++) {
+    _ringOffs[y] = _ringOffs[y - 1] + _numBeams * multi(y - 1);
   }
 
-  box = util::geo::pad(box, sqrt(SOFT_INF / pen) * getCellSize());
-  _grid.get(box, &neighs);
+  // the beam counts of all rings divide the one of the outermost ring
+  size_t maxBeams = _numBeams;
+  if (rings > 1) maxBeams = _numBeams * multi(rings - 1);
 
-  for (auto grNdA : neighs) {
-    for (size_t i = 0; i < maxDeg(); i++) {
-      auto grNeigh = neigh(grNdA->pl().getX(), grNdA->pl().getY(), i);
-      if (!grNeigh) continue;
-      auto ge = getNEdg(grNdA, grNeigh);
-
-      double d = std::numeric_limits<double>::infinity();
-
-      for (const auto& geom : geoms) {
-        double dLoc = fmax(
-            fmax(dist(geom, *ge->getFrom()->pl().getGeom()) / getCellSize(),
-                 dist(geom, util::geo::centroid(util::geo::MultiPoint<double>{
-                                *ge->getFrom()->pl().getGeom(),
-                                *ge->getFrom()->pl().getGeom()})) /
-                     getCellSize()),
-            dist(geom, *ge->getTo()->pl().getGeom()) / getCellSize());
-
-        if (dLoc < d) d = dLoc;
-      }
-
-      d *= pen * d;
-
-      if (d <= SOFT_INF) (*target)[ce][ge->pl().getId()] = d;
-    }
+  double angStep = 2.0 * M_PI / maxBeams;
+  _beamDirs.resize(maxBeams);
+  for (size_t x = 0; x < maxBeams; x++) {
+    double curAngle = -angStep * x + 0.5 * M_PI;
+    _beamDirs[x] = DPoint(cos(curAngle), sin(curAngle));
   }
 }
 
 // _____________________________________________________________________________
 void PseudoOrthoRadialGraph::init() {
+  writeTables();
+
   // write nodes
   for (size_t y = 1; y < _grid.getYHeight() / 2; y++) {
     for (size_t x = 0; x < _numBeams * multi(y); x++) {
@@ -278,6 +263,20 @@ void PseudoOrthoRadialGraph::writeInitialCosts() {
     size_t n = _numBeams * multi(y);
     if (y == 0) n = 1;
     double angStepLoc = 2.0 * M_PI / n;
+
+    // this is the percentage the hop length is longer than the smallest
+    // cell size
+    double sX = (angStepLoc * y) / angStep;
+    if (y == 0) sX = 1;
+
+    // here, the costs are normalized to always represent the map lengths
+    // exactly: vertical hops always have the same length, horizontal hops
+    // get bigger with higher y (= higher radius)
+    double vertCost = _c.verticalPen;
+    double horiCost = (_c.horizontalPen + c_0) * sX - c_0;
+    assert(vertCost >= 0);
+    assert(horiCost >= 0);
+
     for (size_t x = 0; x < n; x++) {
       auto n = getNode(x, y);
       if (!n) continue;
@@ -292,22 +291,7 @@ void PseudoOrthoRadialGraph::writeInitialCosts() {
         if (neighbor->pl().getY() == 0) oPort = neighbor->pl().getPort(x / 2);
         auto e = getEdg(port, oPort);
 
-        // this is the percentage the hop length is longer than the smallest
-        // cell size
-        double sX = (angStepLoc * y) / angStep;
-        if (y == 0) sX = 1;
-
-        // here, the costs are normalized to always
-        // represent the map lengths exactly
-        if (i % 2 == 0) {
-          // vertical hops always have the same length
-          e->pl().setCost(_c.verticalPen);
-          assert(e->pl().cost() >= 0);
-        } else {
-          // horizontal hops get bigger with higher y (= higher radius)
-          e->pl().setCost((_c.horizontalPen + c_0) * sX - c_0);
-          assert(e->pl().cost() >= 0);
-        }
+        e->pl().setCost(i % 2 == 0 ? vertCost : horiCost);
       }
     }
   }
@@ -343,27 +327,22 @@ double PseudoOrthoRadialGraph::ndMovePen(const CombNode* cbNd,
 
 // _____________________________________________________________________________
 GridNode* PseudoOrthoRadialGraph::writeNd(size_t x, size_t y) {
-  double origX =
-      _bbox.getLowerLeft().getX() +
-      (_bbox.getUpperRight().getX() - _bbox.getLowerLeft().getX()) * 0.5;
-
-  double origY =
-      _bbox.getLowerLeft().getY() +
-      (_bbox.getUpperRight().getY() - _bbox.getLowerLeft().getY()) * 0.5;
-
-  double angStep = 2.0 * M_PI / (_numBeams * multi(y));
-
-  double curAngle = -angStep * x + 0.5 * M_PI;
-
-  double xPos = origX + y * cos(curAngle) * _cellSize;
-  double yPos = origY + y * sin(curAngle) * _cellSize;
+  double xPos = _center.getX();
+  double yPos = _center.getY();
+
+  if (y > 0) {
+    size_t beamStep = _beamDirs.size() / (_numBeams * multi(y));
+    const auto& dir = _beamDirs[x * beamStep];
+    xPos += y * dir.getX() * _cellSize;
+    yPos += y * dir.getY() * _cellSize;
+  }
   auto pos = DPoint(xPos, yPos);
 
   double c_0 = _c.p_45 - _c.p_135;
   double c_90 = _c.p_45 - _c.p_135 + _c.p_90;
 
   GridNode* n = addNd(pos);
-  n->pl().setId(_nds.size());
+  n->pl().setId(_nds.size(), &_nds);
   _nds.push_back(n);
   n->pl().setSink();
 
@@ -382,7 +361,7 @@ GridNode* PseudoOrthoRadialGraph::writeNd(size_t x, size_t y) {
     if (i == 3) xi = -1;
 
     GridNode* nn = addNd(DPoint(xPos + xi * _spacer, yPos + yi * _spacer));
-    nn->pl().setId(_nds.size());
+    nn->pl().setId(_nds.size(), &_nds);
     _nds.push_back(nn);
     nn->pl().setParent(n);
     n->pl().setPort(i, nn);
@@ -428,11 +407,10 @@ GridNode* PseudoOrthoRadialGraph::writeNd(size_t x, size_t y) {
 // _____________________________________________________________________________
 GridNode* PseudoOrthoRadialGraph::getNode(size_t x, size_t y) const {
   if (x == 0 && y == 0) return _nds[_nds.size() - 5];
-  int a = 0;
+  if (y == 0 || y >= _ringOffs.size()) return 0;
 
-  for (size_t i = 1; i < y; i++) a += _numBeams * multi(i);
+  size_t a = _ringOffs[y];
 
-  if (y == 0) return 0;
   if ((a + x) * 5 >= _nds.size() - 5) return 0;
   return _nds[(a + x) * 5];
 }
@@ -440,14 +418,6 @@ GridNode* PseudoOrthoRadialGraph::getNode(size_t x, size_t y) const {
 // _____________________________________________________________________________
 PolyLine<double> PseudoOrthoRadialGraph::geomFromPath(
     const std::vector<std::pair<size_t, size_t>>& res) const {
-  double origX =
-      _bbox.getLowerLeft().getX() +
-      (_bbox.getUpperRight().getX() - _bbox.getLowerLeft().getX()) * 0.5;
-
-  double origY =
-      _bbox.getLowerLeft().getY() +
-      (_bbox.getUpperRight().getY() - _bbox.getLowerLeft().getY()) * 0.5;
-
   PolyLine<double> pl;
   for (auto revIt = res.rbegin(); revIt != res.rend(); revIt++) {
     auto f = getEdg(getGrNdById(revIt->first), getGrNdById(revIt->second));
@@ -466,7 +436,7 @@ PolyLine<double> PseudoOrthoRadialGraph::geomFromPath(
         }
 
         CircularSegment<double> seg(*frPar->pl().getGeom(), -angStep,
-                                    {origX, origY});
+                                    _center);
         for (auto p : seg.render(10).getLine()) pl << p;
       }
 
@@ -479,6 +449,13 @@ PolyLine<double> PseudoOrthoRadialGraph::geomFromPath(
   return pl;
 }
 
+// _____________________________________________________________________________
+bool PseudoOrthoRadialGraph::getHeurCoefs(HeurCoefs* c) const {
+  // the radial distance wraps around, no closed form here
+  UNUSED(c);
+  return false;
+}
+
 // _____________________________________________________________________________
 double PseudoOrthoRadialGraph::heurCost(int64_t xa, int64_t ya, int64_t xb,
                                         int64_t yb) const {
@@ -28,12 +28,11 @@ class PseudoOrthoRadialGraph : public GridGraph {
   virtual const util::graph::Dijkstra::HeurFunc<GridNodePL, GridEdgePL, float>*
   getHeur(const std::set<GridNode*>& to) const;
   virtual double heurCost(int64_t xa, int64_t ya, int64_t xb, int64_t yb) const;
+  virtual bool getHeurCoefs(HeurCoefs* c) const;
 
   virtual PolyLine<double> geomFromPath(
       const std::vector<std::pair<size_t, size_t>>& res) const;
   virtual double ndMovePen(const CombNode* cbNd, const GridNode* grNd) const;
-  virtual void writeGeoCoursePens(const CombEdge* ce, GeoPensMap* target,
-                                  double pen);
 
  protected:
   virtual void writeInitialCosts();
@@ -42,12 +41,27 @@ class PseudoOrthoRadialGraph : public GridGraph {
   virtual GridNode* getNode(size_t x, size_t y) const;
   virtual void getSettledAdjEdgs(GridNode* n, CombNode* origNd,
                                  CombEdge* outgoing[8]);
-  virtual void writeObstacleCost(const util::geo::Polygon<double>& obst);
+  virtual void writeObstacleMask(const util::geo::Polygon<double>& obst,
+                                 double maxD, ObstacleMask* mask) const;
 
  private:
   virtual int multi(size_t y) const;
 
+  // build the lookup tables below
+  void writeTables();
+
   size_t _numBeams;
+
+  // center of the rings
+  util::geo::DPoint _center;
+
+  // number of nodes in the rings before ring y, for y up to the outermost
+  // ring + 1
+  std::vector<size_t> _ringOffs;
+
+  // unit directions of the beams of the outermost ring, beam x of a ring
+  // with n beams has direction x * (_beamDirs.size() / n)
+  std::vector<util::geo::DPoint> _beamDirs;
 };
 
 struct PseudoOrthoRadialGraphHeur
@@ -0,0 +1,64 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cmath>
+#include "octi/basegraph/SparseOctiGridGraph.h"
+
+using octi::basegraph::SparseOctiGridGraph;
+using util::geo::DBox;
+using util::geo::DPoint;
+
+// _____________________________________________________________________________
+SparseOctiGridGraph::SparseOctiGridGraph(const DPolygon& hull,
+                                         const combgraph::CombGraph& cg,
+                                         const DBox& bbox, double cellSize,
+                                         double spacer, size_t bufferRad,
+                                         const Penalties& pens)
+    : ConvexHullOctiGridGraph(hull, bbox, cellSize, spacer, pens),
+      _used(_grid.getXWidth() * _grid.getYHeight(), false) {
+  for (auto nd : cg.getNds()) {
+    markAround(*nd->pl().getGeom(), bufferRad);
+
+    for (auto ce : nd->getAdjList()) {
+      if (ce->getFrom() != nd) continue;
+      for (auto e : ce->pl().getChilds()) {
+        const auto& l = *e->pl().getGeom();
+
+        // sample each segment at least every half cell
+        for (size_t i = 1; i < l.size(); i++) {
+          double d = util::geo::dist(l[i - 1], l[i]);
+          size_t steps = ceil(2 * d / _cellSize);
+          for (size_t j = 1; j <= steps; j++) {
+            double t = static_cast<double>(j) / steps;
+            markAround({l[i - 1].getX() + t * (l[i].getX() - l[i - 1].getX()),
+                        l[i - 1].getY() + t * (l[i].getY() - l[i - 1].getY())},
+                       bufferRad);
+          }
+        }
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void SparseOctiGridGraph::markAround(const DPoint& p, size_t rad) {
+  int64_t cx = llround((p.getX() - _bbox.getLowerLeft().getX()) / _cellSize);
+  int64_t cy = llround((p.getY() - _bbox.getLowerLeft().getY()) / _cellSize);
+  int64_t r = rad;
+
+  for (int64_t x = std::max<int64_t>(0, cx - r);
+       x <= std::min<int64_t>(_grid.getXWidth() - 1, cx + r); x++) {
+    for (int64_t y = std::max<int64_t>(0, cy - r);
+         y <= std::min<int64_t>(_grid.getYHeight() - 1, cy + r); y++) {
+      if ((x - cx) * (x - cx) + (y - cy) * (y - cy) > r * r) continue;
+      _used[x * _grid.getYHeight() + y] = true;
+    }
+  }
+}
+
+// _____________________________________________________________________________
+bool SparseOctiGridGraph::skip(size_t x, size_t y) const {
+  if (!_used[x * _grid.getYHeight() + y]) return true;
+  return ConvexHullOctiGridGraph::skip(x, y);
+}
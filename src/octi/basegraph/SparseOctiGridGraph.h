@@ -0,0 +1,37 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef OCTI_BASEGRAPH_SPARSEOCTIGRIDGRAPH_H_
+#define OCTI_BASEGRAPH_SPARSEOCTIGRIDGRAPH_H_
+
+#include <vector>
+#include "octi/basegraph/ConvexHullOctiGridGraph.h"
+#include "octi/combgraph/CombGraph.h"
+
+namespace octi {
+namespace basegraph {
+
+// Octilinear grid graph which only materializes grid nodes at most bufferRad
+// cells away from the input network (and inside the hull). On sparse
+// networks spread over a large area, most of the bounding box is never
+// needed for routing.
+class SparseOctiGridGraph : public ConvexHullOctiGridGraph {
+ public:
+  using GridGraph::neigh;
+  SparseOctiGridGraph(const DPolygon& hull, const combgraph::CombGraph& cg,
+                      const util::geo::DBox& bbox, double cellSize,
+                      double spacer, size_t bufferRad, const Penalties& pens);
+
+ protected:
+  virtual bool skip(size_t x, size_t y) const;
+
+ private:
+  std::vector<bool> _used;
+
+  void markAround(const util::geo::DPoint& p, size_t rad);
+};
+}  // namespace basegraph
+}  // namespace octi
+
+#endif  // OCTI_BASEGRAPH_SPARSEOCTIGRIDGRAPH_H_
@@ -2,9 +2,14 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "octi/combgraph/CombGraph.h"
 
+using octi::combgraph::CombEdge;
 using octi::combgraph::CombGraph;
+using octi::combgraph::CombNode;
 using octi::combgraph::EdgeOrdering;
 using shared::linegraph::LineEdge;
 using shared::linegraph::LineGraph;
@@ -28,7 +33,8 @@ const util::geo::DBox& CombGraph::getBBox() const { return _bbox; }
 void CombGraph::build(const LineGraph* source) {
   auto nodes = source->getNds();
 
-  std::map<LineNode*, CombNode*> m;
+  std::unordered_map<LineNode*, CombNode*> m;
+  m.reserve(nodes.size());
 
   for (auto n : nodes) {
     CombNode* cn = addNd(n);
@@ -51,58 +57,93 @@ void CombGraph::build(const LineGraph* source) {
   }
 }
 
+// _____________________________________________________________________________
+CombEdge* CombGraph::otherEdg(const CombNode* n, const CombEdge* e) {
+  if (n->getAdjList().front() == e) return n->getAdjList().back();
+  return n->getAdjList().front();
+}
+
 // _____________________________________________________________________________
 void CombGraph::combineDeg2() {
+  // each chain of degree 2 nodes is walked once from one end to the other
+  // and replaced by a single edge. If that edge would turn the graph into a
+  // multigraph, the middle node of the chain is kept, cycles keep two nodes
+  // besides their start, so they stay triangles.
+  std::unordered_set<const CombNode*> marked;
   std::vector<CombNode*> toDel;
-  for (auto n : getNds()) {
-    if (n->getAdjList().size() == 2) toDel.push_back(n);
-  }
 
-  for (auto n : toDel) {
-    if (n->getAdjList().size() == 2) {
-      CombEdge* a = n->getAdjList().front();
-      CombEdge* b = n->getAdjList().back();
+  std::vector<CombNode*> chainNds;
+  std::vector<CombEdge*> chainEdgs;
 
-      // if this combination would turn our graph into a multigraph,
-      // dont do it!
-      if (getEdg(a->getOtherNd(n), b->getOtherNd(n))) continue;
+  for (auto n : getNds()) {
+    if (n->getAdjList().size() != 2 || marked.count(n)) continue;
+
+    // find one end of the chain, or n if the chain is a cycle
+    CombNode* start = n;
+    CombEdge* e = n->getAdjList().front();
+    while (true) {
+      CombNode* next = e->getOtherNd(start);
+      if (next == n) {
+        e = n->getAdjList().front();
+        break;
+      }
+      start = next;
+      if (next->getAdjList().size() != 2) break;
+      e = otherEdg(next, e);
+    }
 
-      auto pl = a->pl();
+    // the chain from start, nodes and edges alternating
+    chainNds.assign(1, start);
+    chainEdgs.clear();
+    while (true) {
+      CombNode* next = e->getOtherNd(chainNds.back());
+      chainEdgs.push_back(e);
+      chainNds.push_back(next);
+      if (next == start || next->getAdjList().size() != 2) break;
+      marked.insert(next);
+      e = otherEdg(next, e);
+    }
+    marked.insert(start);
+
+    size_t m = chainNds.size() - 1;
+
+    std::vector<size_t> keep{0};
+    if (chainNds.front() == chainNds.back()) {
+      // a cycle, either on its own or through start
+      if (m < 3) continue;
+      keep.push_back(m / 3);
+      keep.push_back(2 * m / 3);
+    } else if (getEdg(chainNds.front(), chainNds.back())) {
+      keep.push_back(m / 2);
+    }
+    keep.push_back(m);
 
-      // a is the reference
-      if (a->getTo() == n) {
-        if (b->getTo() != n) {
-          pl.getChilds().insert(pl.getChilds().end(),
-                                b->pl().getChilds().begin(),
-                                b->pl().getChilds().end());
-        } else {
-          pl.getChilds().insert(pl.getChilds().end(),
-                                b->pl().getChilds().rbegin(),
-                                b->pl().getChilds().rend());
-        }
+    for (size_t i = 1; i < keep.size(); i++) {
+      size_t fr = keep[i - 1], to = keep[i];
+      if (to == fr + 1) continue;
 
-        pl.setPolyLine(PolyLine<double>(*a->getFrom()->pl().getGeom(),
-                                        *b->getOtherNd(n)->pl().getGeom()));
-        addEdg(a->getFrom(), b->getOtherNd(n), pl);
-      } else {
-        if (b->getTo() == n) {
-          pl.getChilds().insert(pl.getChilds().begin(),
-                                b->pl().getChilds().begin(),
-                                b->pl().getChilds().end());
+      auto pl = chainEdgs[fr]->pl();
+      pl.getChilds().clear();
+
+      for (size_t j = fr; j < to; j++) {
+        const auto& childs = chainEdgs[j]->pl().getChilds();
+        if (chainEdgs[j]->getFrom() == chainNds[j]) {
+          pl.getChilds().insert(pl.getChilds().end(), childs.begin(),
+                                childs.end());
         } else {
-          pl.getChilds().insert(pl.getChilds().begin(),
-                                b->pl().getChilds().rbegin(),
-                                b->pl().getChilds().rend());
+          pl.getChilds().insert(pl.getChilds().end(), childs.rbegin(),
+                                childs.rend());
         }
-
-        pl.setPolyLine(PolyLine<double>(*b->getOtherNd(n)->pl().getGeom(),
-                                        *a->getTo()->pl().getGeom()));
-        addEdg(b->getOtherNd(n), a->getTo(), pl);
+        if (j > fr) toDel.push_back(chainNds[j]);
       }
 
-      delNd(n);
+      pl.setPolyLine(PolyLine<double>(*chainNds[fr]->pl().getGeom(),
+                                      *chainNds[to]->pl().getGeom()));
+      addEdg(chainNds[fr], chainNds[to], pl);
     }
   }
+
+  for (auto n : toDel) delNd(n);
 }
 
 // _____________________________________________________________________________
@@ -135,7 +176,9 @@ EdgeOrdering CombGraph::getEdgeOrderingForNode(CombNode* n) const {
 // _____________________________________________________________________________
 EdgeOrdering CombGraph::getEdgeOrderingForNode(CombNode* n,
                                                bool useOrigNextNode) const {
-  EdgeOrdering order;
+  std::vector<std::pair<CombEdge*, double>> edgs;
+  edgs.reserve(n->getAdjList().size());
+
   for (auto e : n->getAdjList()) {
     // take reference edge next to n
     auto r = e->pl().getChilds().front();
@@ -163,8 +206,9 @@ EdgeOrdering CombGraph::getEdgeOrderingForNode(CombNode* n,
     double deg = util::geo::angBetween(a, b) - M_PI / 2;
     if (deg <= 0) deg += M_PI * 2;
 
-    order.add(e, deg);
+    edgs.push_back({e, deg});
   }
 
-  return order;
+  // sorted once, not on every insertion
+  return EdgeOrdering(std::move(edgs));
 }
@@ -35,6 +35,9 @@ class CombGraph : public util::graph::UndirGraph<CombNodePL, CombEdgePL> {
   void combineDeg2();
   void writeEdgeOrdering();
   void writeMaxLineNum();
+
+  // the edge of the degree 2 node n which is not e
+  static CombEdge* otherEdg(const CombNode* n, const CombEdge* e);
 };
 
 }  // namespace combgraph
@@ -19,6 +19,7 @@ using octi::combgraph::Drawing;
 using octi::combgraph::GrPath;
 using octi::combgraph::Score;
 using shared::linegraph::LineEdge;
+using shared::linegraph::LineEdgePL;
 using shared::linegraph::LineGraph;
 using shared::linegraph::LineNode;
 using util::geo::BezierCurve;
@@ -40,14 +41,33 @@ uint64_t Drawing::violations() const { return _violations; }
 // _____________________________________________________________________________
 void Drawing::setBaseGraph(const BaseGraph* gg) { _gg = gg; }
 
+// _____________________________________________________________________________
+void Drawing::merge(const Drawing& d) {
+  if (d._c == std::numeric_limits<double>::infinity()) return;
+  if (_c == std::numeric_limits<double>::infinity()) _c = 0;
+
+  _c += d._c;
+  _bend += d._bend;
+  _move += d._move;
+  _hop += d._hop;
+  _dense += d._dense;
+  _violations += d._violations;
+
+  _nds.insert(d._nds.begin(), d._nds.end());
+  _edgs.insert(d._edgs.begin(), d._edgs.end());
+  _ndReachCosts.insert(d._ndReachCosts.begin(), d._ndReachCosts.end());
+  _ndBndCosts.insert(d._ndBndCosts.begin(), d._ndBndCosts.end());
+  _edgCosts.insert(d._edgCosts.begin(), d._edgCosts.end());
+  _vios.insert(d._vios.begin(), d._vios.end());
+  _springCosts.insert(d._springCosts.begin(), d._springCosts.end());
+  _ndPairBnds.insert(d._ndPairBnds.begin(), d._ndPairBnds.end());
+  _edgDirs.insert(d._edgDirs.begin(), d._edgDirs.end());
+}
+
 // _____________________________________________________________________________
 Score Drawing::fullScore() const {
-  Score ret{0, 0, 0, 0, 0, 0, 0};
+  Score ret{_bend, _move, _hop, _dense, 0, 0, 0};
 
-  for (auto c : _ndReachCosts) ret.move += c.second;
-  for (auto c : _ndBndCosts) ret.bend += c.second;
-  for (auto c : _edgCosts) ret.hop += c.second;
-  for (auto c : _springCosts) ret.dense += c.second;
   ret.full = _c + basegraph::SOFT_INF * violations();
   ret.violations = violations();
 
@@ -56,9 +76,19 @@ Score Drawing::fullScore() const {
 
 // _____________________________________________________________________________
 void Drawing::draw(CombEdge* ce, const GrEdgList& ges, bool rev) {
+  logEdg(ce);
+  logNd(ce->getFrom());
+  logNd(ce->getTo());
+
   if (_c == std::numeric_limits<double>::infinity()) _c = 0;
   if (_edgs.count(ce)) _edgs[ce].clear();
 
+  if (_edgDirs.count(ce)) {
+    _ndPairBnds[ce->getFrom()] -= pairBends(ce->getFrom(), ce);
+    _ndPairBnds[ce->getTo()] -= pairBends(ce->getTo(), ce);
+    _edgDirs.erase(ce);
+  }
+
   int l = 0;
 
   for (size_t i = 0; i < ges.size(); i++) {
@@ -97,27 +127,19 @@ void Drawing::draw(CombEdge* ce, const GrEdgList& ges, bool rev) {
 
     _c += edgeCost;
 
-    if (i == 0) {
-      if (!_ndReachCosts.count(rev ? ce->getFrom() : ce->getTo())) {
+    if (i == 0 || i == ges.size() - 1) {
+      const CombNode* nd = (i == 0) == rev ? ce->getFrom() : ce->getTo();
+      if (!_ndReachCosts.count(nd)) {
         // if the node was not settled before, this is the node move cost
-        _ndReachCosts[rev ? ce->getFrom() : ce->getTo()] = edgeCost;
-        _ndBndCosts[rev ? ce->getFrom() : ce->getTo()] = 0;
+        setCost(&_ndReachCosts, nd, edgeCost, &_move);
+        setCost(&_ndBndCosts, nd, 0.0, &_bend);
       } else {
         // otherwise it is the reach cost belonging to the edge
-        _ndBndCosts[rev ? ce->getFrom() : ce->getTo()] += edgeCost;
-      }
-    } else if (i == ges.size() - 1) {
-      if (!_ndReachCosts.count(rev ? ce->getTo() : ce->getFrom())) {
-        // if the node was not settled before, this is the node move cost
-        _ndReachCosts[rev ? ce->getTo() : ce->getFrom()] = edgeCost;
-        _ndBndCosts[rev ? ce->getTo() : ce->getFrom()] = 0;
-      } else {
-        // otherwise it is the reach cost belonging to the edge
-        _ndBndCosts[rev ? ce->getTo() : ce->getFrom()] += edgeCost;
+        setCost(&_ndBndCosts, nd, _ndBndCosts[nd] + edgeCost, &_bend);
       }
     } else {
       if (!ge->pl().isSecondary()) l++;
-      _edgCosts[ce] += edgeCost;
+      setCost(&_edgCosts, ce, _edgCosts[ce] + edgeCost, &_hop);
     }
 
     if (rev) {
@@ -148,6 +170,17 @@ void Drawing::draw(CombEdge* ce, const GrEdgList& ges, bool rev) {
     }
   }
 
+  // cache the port directions of the path at both nodes, and add the bends
+  // to the other drawn edges there
+  auto path = _edgs.find(ce);
+  if (path != _edgs.end() && path->second.size()) {
+    _edgDirs[ce] = {
+        portDir(_gg->getGrNdById(_nds[ce->getFrom()]), path->second),
+        portDir(_gg->getGrNdById(_nds[ce->getTo()]), path->second)};
+    _ndPairBnds[ce->getFrom()] += pairBends(ce->getFrom(), ce);
+    _ndPairBnds[ce->getTo()] += pairBends(ce->getTo(), ce);
+  }
+
   // variables named as in the EuroVis paper
   int k = ce->pl().getChilds().size() - 1;
 
@@ -159,12 +192,13 @@ void Drawing::draw(CombEdge* ce, const GrEdgList& ges, bool rev) {
   double pen = 0;
   if (F > 0) pen = E;
 
-  _springCosts[ce] = pen;
+  setCost(&_springCosts, ce, pen, &_dense);
   _c += _springCosts[ce];
 }
 
 // _____________________________________________________________________________
 const GridNode* Drawing::getGrNd(const CombNode* cn) {
+  logKey(_nds, &_log.nds, cn);
   return _gg->getGrNdById(_nds[cn]);
 }
 
@@ -199,7 +233,7 @@ void Drawing::getLineGraph(LineGraph* target) const {
       }
 
       // the image path...
-      auto pth = _edgs.find(f)->second;
+      const auto& pth = _edgs.find(f)->second;
       assert(_gg->getGrEdgById(pth.back()));
       assert(_gg->getGrEdgById(pth.front()));
       // ... and it's from and to grid nodes. We can be sure that that
@@ -236,7 +270,7 @@ void Drawing::getLineGraph(LineGraph* target) const {
       if (f->getFrom() != n) continue;
       if (_edgs.find(f) == _edgs.end()) continue;  // edge was not drawn
 
-      auto path = _edgs.find(f)->second;
+      const auto& path = _edgs.find(f)->second;
 
       std::set<CombEdge*> curResEdgs;
 
@@ -359,10 +393,10 @@ void Drawing::getLineGraph(LineGraph* target) const {
   std::vector<std::vector<LineEdge*>> segmentEdges(pathSegs.size());
 
   for (size_t segId = 0; segId < pathSegs.size(); segId++) {
-    auto seg = pathSegs[segId];
+    auto& seg = pathSegs[segId];
     std::sort(seg.nodes.begin(), seg.nodes.end());
 
-    std::set<shared::linegraph::LineEdge*> activeLineEdges;
+    segmentEdges[segId].reserve(seg.nodes.size() + 1);
 
     // first add new topological node at beginning of segment
     if (mm.find(seg.start) == mm.end()) {
@@ -383,7 +417,8 @@ void Drawing::getLineGraph(LineGraph* target) const {
         m[to] = target->addNd(payload);
       }
 
-      segmentEdges[segId].push_back(target->addEdg(from, m[to], geom));
+      segmentEdges[segId].push_back(
+          target->addEdg(from, m[to], LineEdgePL(std::move(geom))));
       from = m[to];
       lastProgr = seg.nodes[i].progr;
     }
@@ -392,8 +427,16 @@ void Drawing::getLineGraph(LineGraph* target) const {
     if (mm.find(seg.end) == mm.end())
       mm[seg.end] = target->addNd(seg.geom.back());
 
-    auto geom = seg.geom.getSegment(lastProgr, 1);
-    segmentEdges[segId].push_back(target->addEdg(from, mm[seg.end], geom));
+    // the segment geometry is not needed anymore, the last part takes it
+    // over if it spans the whole segment
+    if (lastProgr == 0) {
+      segmentEdges[segId].push_back(target->addEdg(
+          from, mm[seg.end], LineEdgePL(std::move(seg.geom))));
+    } else {
+      auto geom = seg.geom.getSegment(lastProgr, 1);
+      segmentEdges[segId].push_back(
+          target->addEdg(from, mm[seg.end], LineEdgePL(std::move(geom))));
+    }
   }
 
   // now go over all original comb edge segments and add line informations
@@ -410,10 +453,10 @@ void Drawing::getLineGraph(LineGraph* target) const {
       size_t segId = segPair.first;
       bool reverse = segPair.second;
 
-      auto sCopy = segmentEdges[segId];
-      if (reverse) std::reverse(sCopy.begin(), sCopy.end());
+      const auto& segEdgs = segmentEdges[segId];
 
-      for (auto edge : sCopy) {
+      for (size_t j = 0; j < segEdgs.size(); j++) {
+        auto edge = reverse ? segEdgs[segEdgs.size() - 1 - j] : segEdgs[j];
         auto from = reverse ? edge->getTo() : edge->getFrom();
         auto to = edge->getOtherNd(from);
 
@@ -468,7 +511,20 @@ void Drawing::getLineGraph(LineGraph* target) const {
 }
 // _____________________________________________________________________________
 void Drawing::crumble() {
+  if (_log.savePoints.size()) {
+    for (const auto& kv : _nds) logNd(kv.first);
+    for (const auto& kv : _ndBndCosts) logNd(kv.first);
+    for (const auto& kv : _ndReachCosts) logNd(kv.first);
+    for (const auto& kv : _edgs) logEdg(kv.first);
+    for (const auto& kv : _edgCosts) logEdg(kv.first);
+    for (const auto& kv : _vios) logEdg(kv.first);
+    for (const auto& kv : _springCosts) logEdg(kv.first);
+    for (const auto& kv : _ndPairBnds) logNd(kv.first);
+    for (const auto& kv : _edgDirs) logEdg(kv.first);
+  }
+
   _c = std::numeric_limits<double>::infinity();
+  _bend = _move = _hop = _dense = 0;
   _violations = 0;
   _nds.clear();
   _edgs.clear();
@@ -477,63 +533,54 @@ void Drawing::crumble() {
   _edgCosts.clear();
   _vios.clear();
   _springCosts.clear();
+  _ndPairBnds.clear();
+  _edgDirs.clear();
 }
 
 // _____________________________________________________________________________
-double Drawing::recalcBends(const CombNode* nd) {
-  double c = 0;
-
-  if (_nds.count(nd) == 0) return 0;
-  auto gnd = _gg->getGrNdById(_nds.find(nd)->second);
+size_t Drawing::portDir(const GridNode* gnd, const GrPath& path) const {
+  auto front = _gg->getGrEdgById(path.front());
+  auto back = _gg->getGrEdgById(path.back());
+
+  size_t dir = 0;
+  for (; dir < _gg->maxDeg(); dir++) {
+    auto port = gnd->pl().getPort(dir);
+    if (port == front->getFrom() || port == front->getTo() ||
+        port == back->getFrom() || port == back->getTo()) {
+      break;
+    }
+  }
 
-  // TODO: implement this better
+  assert(dir < _gg->maxDeg());
+  return dir;
+}
 
-  for (auto e : nd->getAdjList()) {
-    if (_edgs.count(e) == 0) {
-      continue;  // dont count edge that havent been drawn
-    }
-    auto ge = _edgs.find(e)->second;
-
-    size_t dirA = 0;
-    for (; dirA < _gg->maxDeg(); dirA++) {
-      if (gnd->pl().getPort(dirA) == _gg->getGrEdgById(ge.front())->getFrom() ||
-          gnd->pl().getPort(dirA) == _gg->getGrEdgById(ge.front())->getTo() ||
-          gnd->pl().getPort(dirA) == _gg->getGrEdgById(ge.back())->getFrom() ||
-          gnd->pl().getPort(dirA) == _gg->getGrEdgById(ge.back())->getTo()) {
-        break;
-      }
-    }
+// _____________________________________________________________________________
+double Drawing::pairBends(const CombNode* nd, const CombEdge* e) const {
+  // the bend costs between e and the other drawn edges at nd, each line
+  // shared by two edges is counted once in both directions, and halved
+  auto eDirs = _edgDirs.find(e);
+  if (eDirs == _edgDirs.end()) return 0;
+  size_t dirA =
+      e->getFrom() == nd ? eDirs->second.first : eDirs->second.second;
+  const auto& ePl = e->pl().getChilds().front()->pl();
 
-    assert(dirA < _gg->maxDeg());
+  double c = 0;
 
-    for (auto lo : e->pl().getChilds().front()->pl().getLines()) {
-      for (auto f : nd->getAdjList()) {
-        if (e == f) continue;
-        if (_edgs.count(f) == 0) {
-          continue;  // dont count edges that havent been drawn
-        }
-        auto gf = _edgs.find(f)->second;
-
-        if (f->pl().getChilds().front()->pl().hasLine(lo.line)) {
-          size_t dirB = 0;
-          for (; dirB < _gg->maxDeg(); dirB++) {
-            if (gnd->pl().getPort(dirB) ==
-                    _gg->getGrEdgById(gf.front())->getFrom() ||
-                gnd->pl().getPort(dirB) ==
-                    _gg->getGrEdgById(gf.front())->getTo() ||
-                gnd->pl().getPort(dirB) ==
-                    _gg->getGrEdgById(gf.back())->getFrom() ||
-                gnd->pl().getPort(dirB) ==
-                    _gg->getGrEdgById(gf.back())->getTo()) {
-              break;
-            }
-          }
+  for (auto f : nd->getAdjList()) {
+    if (e == f) continue;
+    auto fDirs = _edgDirs.find(f);
+    if (fDirs == _edgDirs.end()) continue;  // dont count undrawn edges
+    size_t dirB =
+        f->getFrom() == nd ? fDirs->second.first : fDirs->second.second;
+    const auto& fPl = f->pl().getChilds().front()->pl();
 
-          assert(dirB < _gg->maxDeg());
+    for (auto lo : ePl.getLines()) {
+      if (fPl.hasLine(lo.line)) c += _gg->getBendPen(dirA, dirB);
+    }
 
-          c += _gg->getBendPen(dirA, dirB);
-        }
-      }
+    for (auto lo : fPl.getLines()) {
+      if (ePl.hasLine(lo.line)) c += _gg->getBendPen(dirB, dirA);
     }
   }
 
@@ -550,19 +597,32 @@ const std::map<const CombEdge*, GrPath>& Drawing::getEdgPaths() const {
 
 // _____________________________________________________________________________
 void Drawing::erase(CombEdge* ce) {
+  logEdg(ce);
+  logNd(ce->getFrom());
+  logNd(ce->getTo());
+
+  // remove the bends of ce at both nodes, in O(deg)
+  _ndPairBnds[ce->getFrom()] -= pairBends(ce->getFrom(), ce);
+  _ndPairBnds[ce->getTo()] -= pairBends(ce->getTo(), ce);
+  _edgDirs.erase(ce);
+
   _edgs.erase(ce);
   _c -= _edgCosts[ce];
+  _hop -= _edgCosts[ce];
   _edgCosts.erase(ce);
 
   _c -= _springCosts[ce];
+  _dense -= _springCosts[ce];
   _springCosts.erase(ce);
 
   _c -= _ndBndCosts[ce->getFrom()];
   _c -= _ndBndCosts[ce->getTo()];
 
-  // update bend costs
-  _ndBndCosts[ce->getFrom()] = recalcBends(ce->getFrom());
-  _ndBndCosts[ce->getTo()] = recalcBends(ce->getTo());
+  // update bend costs, only the bends between the remaining drawn edges
+  // are kept
+  for (auto nd : {ce->getFrom(), ce->getTo()}) {
+    setCost(&_ndBndCosts, nd, _nds.count(nd) ? _ndPairBnds[nd] : 0.0, &_bend);
+  }
 
   _c += _ndBndCosts[ce->getTo()];
   _c += _ndBndCosts[ce->getFrom()];
@@ -573,11 +633,16 @@ void Drawing::erase(CombEdge* ce) {
 
 // _____________________________________________________________________________
 void Drawing::erase(CombNode* cn) {
+  logNd(cn);
+
   _nds.erase(cn);
   _c -= _ndReachCosts[cn];
   _c -= _ndBndCosts[cn];
+  _move -= _ndReachCosts[cn];
+  _bend -= _ndBndCosts[cn];
   _ndReachCosts.erase(cn);
   _ndBndCosts.erase(cn);
+  _ndPairBnds.erase(cn);
 }
 
 // _____________________________________________________________________________
@@ -613,6 +678,7 @@ void Drawing::eraseFromGrid(const CombNode* nd, BaseGraph* gg) {
 
 // _____________________________________________________________________________
 void Drawing::applyToGrid(const CombNode* nd, BaseGraph* gg) {
+  logKey(_nds, &_log.nds, nd);
   gg->settleNd(const_cast<GridNode*>(gg->getGrNdById(_nds[nd])),
                const_cast<CombNode*>(nd));
 }
@@ -646,3 +712,103 @@ double Drawing::getNdReachCost(const CombNode* n) const {
   if (_ndReachCosts.count(n)) return _ndReachCosts.find(n)->second;
   return 0;
 }
+
+// _____________________________________________________________________________
+void Drawing::begin() {
+  _log.savePoints.push_back(
+      {_c, _bend, _move, _hop, _dense, _violations, _log.nds.size(),
+       _log.edgs.size(), _log.ndReachCosts.size(), _log.ndBndCosts.size(),
+       _log.edgCosts.size(), _log.vios.size(), _log.springCosts.size(),
+       _log.ndPairBnds.size(), _log.edgDirs.size()});
+}
+
+// _____________________________________________________________________________
+void Drawing::commit() {
+  assert(_log.savePoints.size());
+  _log.savePoints.pop_back();
+
+  // the changes are now part of the enclosing transaction, if any
+  if (_log.savePoints.empty()) _log.clear();
+}
+
+// _____________________________________________________________________________
+void Drawing::rollback() {
+  assert(_log.savePoints.size());
+  const auto sp = _log.savePoints.back();
+  _log.savePoints.pop_back();
+
+  undo(&_nds, &_log.nds, sp.nds);
+  undo(&_edgs, &_log.edgs, sp.edgs);
+  undo(&_ndReachCosts, &_log.ndReachCosts, sp.ndReachCosts);
+  undo(&_ndBndCosts, &_log.ndBndCosts, sp.ndBndCosts);
+  undo(&_edgCosts, &_log.edgCosts, sp.edgCosts);
+  undo(&_vios, &_log.vios, sp.vios);
+  undo(&_springCosts, &_log.springCosts, sp.springCosts);
+  undo(&_ndPairBnds, &_log.ndPairBnds, sp.ndPairBnds);
+  undo(&_edgDirs, &_log.edgDirs, sp.edgDirs);
+
+  _c = sp.c;
+  _bend = sp.bend;
+  _move = sp.move;
+  _hop = sp.hop;
+  _dense = sp.dense;
+  _violations = sp.violations;
+}
+
+// _____________________________________________________________________________
+void Drawing::logNd(const CombNode* nd) {
+  if (_log.savePoints.empty()) return;
+  logKey(_nds, &_log.nds, nd);
+  logKey(_ndReachCosts, &_log.ndReachCosts, nd);
+  logKey(_ndBndCosts, &_log.ndBndCosts, nd);
+  logKey(_ndPairBnds, &_log.ndPairBnds, nd);
+}
+
+// _____________________________________________________________________________
+void Drawing::logEdg(const CombEdge* ce) {
+  if (_log.savePoints.empty()) return;
+  logKey(_edgs, &_log.edgs, ce);
+  logKey(_edgCosts, &_log.edgCosts, ce);
+  logKey(_vios, &_log.vios, ce);
+  logKey(_springCosts, &_log.springCosts, ce);
+  logKey(_edgDirs, &_log.edgDirs, ce);
+}
+
+// _____________________________________________________________________________
+template <typename K>
+void Drawing::setCost(std::map<K, double>* m,
+                      const typename std::map<K, double>::key_type& k,
+                      double v, double* sum) {
+  auto& c = (*m)[k];
+  *sum += v - c;
+  c = v;
+}
+
+// _____________________________________________________________________________
+template <typename K, typename V>
+void Drawing::logKey(const std::map<K, V>& m,
+                     std::vector<UndoEntry<K, V>>* log, const K& k) {
+  if (_log.savePoints.empty()) return;
+  auto it = m.find(k);
+  if (it == m.end()) {
+    log->push_back({k, false, V()});
+  } else {
+    log->push_back({k, true, it->second});
+  }
+}
+
+// _____________________________________________________________________________
+template <typename K, typename V>
+void Drawing::undo(std::map<K, V>* m, std::vector<UndoEntry<K, V>>* log,
+                   size_t to) {
+  // replay in reverse order, so the oldest logged value is restored last
+  while (log->size() > to) {
+    auto& e = log->back();
+    if (e.existed) {
+      (*m)[e.key] = std::move(e.val);
+    } else {
+      m->erase(e.key);
+    }
+    log->pop_back();
+  }
+}
@@ -2,8 +2,10 @@
 #define OCTI_COMBGRAPH_DRAWING_H_
 
 #include <map>
+#include <vector>
 #include "octi/basegraph/BaseGraph.h"
 #include "octi/combgraph/CombGraph.h"
+#include "util/Misc.h"
 #include "util/graph/Dijkstra.h"
 
 namespace octi {
@@ -71,12 +73,74 @@ struct Segment {
   std::set<CombEdge*> combEdges;
 };
 
+template <typename K, typename V>
+struct UndoEntry {
+  K key;
+  bool existed;
+  V val;
+};
+
+// undo log of a drawing, copying a drawing never copies its undo log
+struct UndoLog {
+  UndoLog() {}
+  UndoLog(const UndoLog& o) { UNUSED(o); }
+  UndoLog& operator=(const UndoLog& o) {
+    UNUSED(o);
+    clear();
+    return *this;
+  }
+
+  struct SavePoint {
+    double c, bend, move, hop, dense;
+    size_t violations;
+    size_t nds, edgs, ndReachCosts, ndBndCosts, edgCosts, vios, springCosts,
+        ndPairBnds, edgDirs;
+  };
+
+  std::vector<SavePoint> savePoints;
+
+  std::vector<UndoEntry<const CombNode*, size_t>> nds;
+  std::vector<UndoEntry<const CombEdge*, GrPath>> edgs;
+  std::vector<UndoEntry<const CombNode*, double>> ndReachCosts;
+  std::vector<UndoEntry<const CombNode*, double>> ndBndCosts;
+  std::vector<UndoEntry<const CombEdge*, double>> edgCosts;
+  std::vector<UndoEntry<const CombEdge*, int>> vios;
+  std::vector<UndoEntry<const CombEdge*, double>> springCosts;
+  std::vector<UndoEntry<const CombNode*, double>> ndPairBnds;
+  std::vector<UndoEntry<const CombEdge*, std::pair<size_t, size_t>>> edgDirs;
+
+  void clear() {
+    savePoints.clear();
+    nds.clear();
+    edgs.clear();
+    ndReachCosts.clear();
+    ndBndCosts.clear();
+    edgCosts.clear();
+    vios.clear();
+    springCosts.clear();
+    ndPairBnds.clear();
+    edgDirs.clear();
+  }
+};
+
 class Drawing {
  public:
   Drawing(const BaseGraph* gg)
-      : _c(std::numeric_limits<double>::infinity()), _gg(gg), _violations(0){};
+      : _c(std::numeric_limits<double>::infinity()),
+        _bend(0),
+        _move(0),
+        _hop(0),
+        _dense(0),
+        _gg(gg),
+        _violations(0){};
   Drawing()
-      : _c(std::numeric_limits<double>::infinity()), _gg(0), _violations(0){};
+      : _c(std::numeric_limits<double>::infinity()),
+        _bend(0),
+        _move(0),
+        _hop(0),
+        _dense(0),
+        _gg(0),
+        _violations(0){};
 
   double score() const;
   double rawScore() const;
@@ -108,8 +172,18 @@ class Drawing {
 
   void setBaseGraph(const BaseGraph* gg);
 
+  // add the nodes and edges of d, drawn on an identical grid. They must not
+  // be part of this drawing yet. This cannot be rolled back.
+  void merge(const Drawing& d);
+
   const std::map<const CombEdge*, GrPath>& getEdgPaths() const;
 
+  // transactions: all changes to the drawing after begin() are reverted by
+  // rollback() or kept by commit(). Transactions may be nested.
+  void begin();
+  void commit();
+  void rollback();
+
  private:
   std::map<const CombNode*, size_t> _nds;
   std::map<const CombEdge*, GrPath> _edgs;
@@ -119,12 +193,43 @@ class Drawing {
   std::map<const CombEdge*, double> _edgCosts;
   std::map<const CombEdge*, int> _vios;
   std::map<const CombEdge*, double> _springCosts;
+
+  // bend costs between the drawn edges at a node, as they would be
+  // recomputed from scratch after an adjacent edge was erased
+  std::map<const CombNode*, double> _ndPairBnds;
+
+  // port directions of drawn edges at their from and to node
+  std::map<const CombEdge*, std::pair<size_t, size_t>> _edgDirs;
+
   double _c;
+
+  // running sums of the cost maps above, for fullScore()
+  double _bend, _move, _hop, _dense;
+
   const BaseGraph* _gg;
 
   size_t _violations;
 
-  double recalcBends(const CombNode* nd);
+  UndoLog _log;
+
+  size_t portDir(const GridNode* gnd, const GrPath& path) const;
+  double pairBends(const CombNode* nd, const CombEdge* e) const;
+
+  // set m[k] to v, keeping the running sum of m up to date
+  template <typename K>
+  void setCost(std::map<K, double>* m,
+               const typename std::map<K, double>::key_type& k, double v,
+               double* sum);
+
+  void logNd(const CombNode* nd);
+  void logEdg(const CombEdge* ce);
+
+  template <typename K, typename V>
+  void logKey(const std::map<K, V>& m, std::vector<UndoEntry<K, V>>* log,
+              const K& k);
+
+  template <typename K, typename V>
+  void undo(std::map<K, V>* m, std::vector<UndoEntry<K, V>>* log, size_t to);
 };
 }  // namespace combgraph
 }  // namespace octi
@@ -9,6 +9,12 @@ using util::geo::Point;
 using octi::combgraph::EdgeOrdering;
 using octi::combgraph::CombEdge;
 
+// _____________________________________________________________________________
+EdgeOrdering::EdgeOrdering(std::vector<std::pair<CombEdge*, double>> edgs)
+    : _edgeOrder(std::move(edgs)) {
+  std::sort(_edgeOrder.begin(), _edgeOrder.end(), PairCmp());
+}
+
 // _____________________________________________________________________________
 void EdgeOrdering::add(CombEdge* e, double deg) {
   _edgeOrder.push_back(std::pair<CombEdge*, double>(e, deg));
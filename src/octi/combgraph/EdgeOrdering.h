@@ -39,6 +39,11 @@ struct PairCmp {
 
 class EdgeOrdering {
  public:
+  EdgeOrdering() {}
+
+  // all edges with their angles at once
+  explicit EdgeOrdering(std::vector<std::pair<CombEdge*, double>> edgs);
+
   void add(CombEdge* e, double deg);
   bool has(CombEdge* e) const;
   int64_t dist(CombEdge* a, CombEdge* b) const;
@@ -12,6 +12,9 @@
 
 #include "octi/_config.h"
 #include "octi/config/ConfigReader.h"
+#include "shared/io/CompressedStream.h"
+#include "util/String.h"
+#include "util/geo/Geo.h"
 #include "util/log/Log.h"
 
 using octi::config::ConfigReader;
@@ -47,23 +50,95 @@ void ConfigReader::help(const char* bin) const {
             << "optimization mode, 'heur' or 'ilp'\n"
             << std::setw(39) << "  --obstacles arg"
             << "GeoJSON file containing obstacle polygons\n"
+            << std::setw(39) << "  --prev-drawing arg"
+            << "previous octi output, unchanged parts of the\n"
+            << std::setw(39) << " "
+            << " input keep their drawing\n"
+            << std::setw(39) << "  --prev-radius arg (=2)"
+            << "grid cells around changes to the previous\n"
+            << std::setw(39) << " "
+            << " drawing which are redrawn\n"
+            << std::setw(39) << "  --prev-subset"
+            << "the input is a subset of the lines of the\n"
+            << std::setw(39) << " "
+            << " previous drawing, derive its drawing from it\n"
             << std::setw(39) << "  -g [ --grid-size ] arg (=100%)"
             << "grid cell length, either exact or a\n"
             << std::setw(39) << " "
             << " percentage of input adjacent station distance\n"
+            << std::setw(39) << "  --enlarge arg (=0)"
+            << "enlarge dense areas with this strength in\n"
+            << std::setw(39) << " "
+            << " [0, 1) before drawing, allows coarser grids\n"
             << std::setw(39) << "  -b [ -base-graph ] arg (=octilinear)"
             << "base graph, either ortholinear, octilinear,\n"
             << std::setw(39) << " "
-            << " orthoradial, quadtree, octihanan\n\n"
+            << " orthoradial, quadtree, octihanan,\n"
+            << std::setw(39) << " "
+            << " chulloctilinear, bufferoctilinear\n"
+            << std::setw(39) << "  --snap-orphan-stations"
+            << "connect stations without edges to edges\n"
+            << std::setw(39) << " "
+            << " passing through them\n\n"
             << "Misc:\n"
             << std::setw(39) << "  --retry-on-error"
             << "retry 85\% of grid size on error, 30 times\n"
+            << std::setw(39) << "  --retry-jobs arg (=1)"
+            << "number of grid sizes tried concurrently\n"
+            << std::setw(39) << " "
+            << " on retry, larger ones win\n"
             << std::setw(39) << "  --skip-on-error"
             << "skip graph on error\n"
             << std::setw(39) << "  --ilp-num-threads arg (=0)"
             << "number of threads to use by ILP solver,\n"
             << std::setw(39) << " "
             << " 0 means solver default\n"
+            << std::setw(39) << "  -j [ --jobs ] arg (=0)"
+            << "number of parallel jobs for heuristic,\n"
+            << std::setw(39) << " "
+            << " shared among components drawn in parallel,\n"
+            << std::setw(39) << " "
+            << " 0 means hardware concurrency\n"
+            << std::setw(39) << "  -t [ --threads ] arg (=0)"
+            << "thread budget, default for --jobs and\n"
+            << std::setw(39) << " "
+            << " --ilp-num-threads, also caps all other\n"
+            << std::setw(39) << " "
+            << " threads, 0 means no budget\n"
+            << std::setw(39) << "  --grid-mem-limit arg (=0)"
+            << "memory limit for per-job grid graphs (MB),\n"
+            << std::setw(39) << " "
+            << " limits the number of jobs, 0 means no limit\n"
+            << std::setw(39) << "  --max-grid-mem arg (=0)"
+            << "memory budget for the grid graphs of a\n"
+            << std::setw(39) << " "
+            << " component (MB), the grid is made sparser or\n"
+            << std::setw(39) << " "
+            << " coarser to fit, 0 means no budget\n"
+            << std::setw(39) << "  --generic-dijkstra"
+            << "don't use specialized grid shortest path search\n"
+            << std::setw(39) << "  --sparse-grid arg (=0)"
+            << "only build octilinear grid nodes this many\n"
+            << std::setw(39) << " "
+            << " cells around the input, 0 means full grid\n"
+            << std::setw(39) << "  --bidir-route-dist arg (=0)"
+            << "route edges at least this many cells long with\n"
+            << std::setw(39) << " "
+            << " a bidirectional search, 0 means never\n"
+            << std::setw(39) << "  --route-regions arg (=0)"
+            << "route the initial drawing in parallel in\n"
+            << std::setw(39) << " "
+            << " n x n map regions, 0 or 1 means no regions\n"
+            << std::setw(39) << "  --quadtree-max-leaf-pts arg (=0)"
+            << "don't split quadtree cells with at most this\n"
+            << std::setw(39) << " "
+            << " many points, 0 means split all non-empty cells\n"
+            << std::setw(39) << "  --quadtree-min-cell arg (=1)"
+            << "min quadtree cell size, in grid cells\n"
+            << std::setw(39) << "  --quadtree-edge-sample arg (=0)"
+            << "refine quadtree cells along input edges, with a\n"
+            << std::setw(39) << " "
+            << " sample every this many grid cells, 0 means off\n"
             << std::setw(39) << "  --hanan-iters arg (=1)"
             << "number of Hanan grid iterations\n"
             << std::setw(39) << "  --loc-search-max-iters arg (=100)"
@@ -72,16 +147,76 @@ void ConfigReader::help(const char* bin) const {
             << "ILP solve cache treshold\n"
             << std::setw(39) << "  --ilp-time-limit arg (=60)"
             << "ILP solve time limit (seconds), -1 for infinite\n"
+            << std::setw(39) << "  --deadline arg (=0)"
+            << "stop optimizing after this many seconds and\n"
+            << std::setw(39) << " "
+            << " write the best drawings so far, 0 for none\n"
             << std::setw(39) << "  --ilp-cache-dir arg (=.)"
             << "ILP cache dir\n"
+            << std::setw(39) << "  --ilp-cache-model"
+            << "cache the ILP constraints in the ILP cache dir,\n"
+            << std::setw(39) << " "
+            << " only penalties are rebuilt on reuse\n"
+            << std::setw(39) << "  --ilp-window arg (=0)"
+            << "improve the heuristic drawing with ILPs over\n"
+            << std::setw(39) << " "
+            << " windows of this many cells, 0 means a single ILP\n"
+            << std::setw(39) << "  --ilp-corridor arg (=0)"
+            << "restrict the ILP to cells at most this many cells\n"
+            << std::setw(39) << " "
+            << " away from the heuristic drawing, 0 means no\n"
+            << std::setw(39) << " "
+            << " restriction\n"
             << std::setw(39) << "  --ilp-solver arg (=gurobi)"
             << "Preferred ILP solver, either glpk, cbc, or gurobi,\n"
             << std::setw(39) << " "
-            << " will fall back if not available.\n"
+            << " will fall back if not available. portfolio\n"
+            << std::setw(39) << " "
+            << " races all available solvers, remote sends\n"
+            << std::setw(39) << " "
+            << " the ILPs to --ilp-remote-cmd.\n"
+            << std::setw(39) << "  --ilp-remote-cmd arg"
+            << "command solving ILPs for --ilp-solver remote,\n"
+            << std::setw(39) << " "
+            << " e.g. 'ssh host ilpworker'\n"
             << std::setw(39) << "  --write-stats"
             << "write stats to output graph\n"
+            << std::setw(39) << "  --format arg (=json)"
+            << "output format, either json, topojson or bin\n"
+            << std::setw(39) << "  --compress arg (=none)"
+            << "compress the output, either none, gzip or zstd\n"
+            << std::setw(39) << "  --stage-cache-dir arg"
+            << "reuse the output of identical runs from dir\n"
+            << std::setw(39) << "  --comp-cache-dir arg"
+            << "reuse the drawings of unchanged components\n"
+            << std::setw(39) << " "
+            << " from dir\n"
+            << std::setw(39) << "  --trace arg"
+            << "write a Chrome trace of the run to this file\n"
+            << std::setw(39) << "  --metrics-out arg"
+            << "write per-phase resource usage to this JSON file\n"
+            << std::setw(39) << "  --progress-fd arg"
+            << "write progress as JSON lines to this file\n"
+            << std::setw(39) << " "
+            << " descriptor\n"
             << std::setw(39) << "  -D [ --from-dot ]"
             << "input is in dot format\n"
+            << std::setw(39) << "  --print-mode arg (=linegraph)"
+            << "print the linegraph, or the gridgraph to debug\n"
+            << std::setw(39) << "  --grid-format arg (=geojson)"
+            << "gridgraph format, geojson or bin, a tiled\n"
+            << std::setw(39) << " "
+            << " dump, see scripts/octi_grid_dump.py\n"
+            << std::setw(39) << "  --grid-filter arg (=all)"
+            << "gridgraph parts printed, all, settled (settled\n"
+            << std::setw(39) << " "
+            << " nodes and their edges) or used\n"
+            << std::setw(39) << "  --grid-window arg"
+            << "only print the gridgraph within this box,\n"
+            << std::setw(39) << " "
+            << " given as minlng,minlat,maxlng,maxlat\n"
+            << std::setw(39) << "  --grid-tile-size arg (=10000)"
+            << "tile size of the bin gridgraph (web merc. m)\n"
             << std::setw(39) << "  --no-deg2-heur"
             << "don't contract degree 2 nodes\n"
             << std::setw(39) << "  --geo-pen arg (=0)"
@@ -90,6 +225,10 @@ void ConfigReader::help(const char* bin) const {
             << "max grid distance for station candidates\n"
             << std::setw(39) << "  --restr-loc-search"
             << "restrict local search to max grid distance\n"
+            << std::setw(39) << "  --coarse-grid arg (=0)"
+            << "first draw on a grid this many times coarser,\n"
+            << std::setw(39) << " "
+            << " then restrict heur to its surroundings\n"
             << std::setw(39) << "  --edge-order arg (=all)"
             << "method used for initial edge ordering for heur,\n"
             << std::setw(39) << " "
@@ -121,6 +260,7 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
   std::string VERSION_STR = " - unversioned - ";
   std::string baseGraphStr = "octilinear";
   std::string edgeOrderMethod = "all";
+  std::string gridFilterStr = "all";
 
   struct option ops[] = {{"version", no_argument, 0, 'v'},
                          {"help", no_argument, 0, 'h'},
@@ -154,11 +294,46 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
                          {"skip-on-error", no_argument, 0, 25},
                          {"retry-on-error", no_argument, 0, 26},
                          {"abort-after", required_argument, 0, 'a'},
+                         {"format", required_argument, 0, 27},
+                         {"jobs", required_argument, 0, 'j'},
+                         {"threads", required_argument, 0, 't'},
+                         {"grid-mem-limit", required_argument, 0, 28},
+                         {"generic-dijkstra", no_argument, 0, 29},
+                         {"stage-cache-dir", required_argument, 0, 30},
+                         {"retry-jobs", required_argument, 0, 31},
+                         {"coarse-grid", required_argument, 0, 32},
+                         {"sparse-grid", required_argument, 0, 33},
+                         {"ilp-window", required_argument, 0, 34},
+                         {"ilp-cache-model", no_argument, 0, 35},
+                         {"bidir-route-dist", required_argument, 0, 36},
+                         {"prev-drawing", required_argument, 0, 37},
+                         {"prev-radius", required_argument, 0, 38},
+                         {"trace", required_argument, 0, 39},
+                         {"metrics-out", required_argument, 0, 40},
+                         {"snap-orphan-stations", no_argument, 0, 41},
+                         {"quadtree-max-leaf-pts", required_argument, 0, 42},
+                         {"quadtree-min-cell", required_argument, 0, 43},
+                         {"quadtree-edge-sample", required_argument, 0, 44},
+                         {"max-grid-mem", required_argument, 0, 45},
+                         {"print-mode", required_argument, 0, 46},
+                         {"grid-format", required_argument, 0, 47},
+                         {"grid-filter", required_argument, 0, 48},
+                         {"grid-window", required_argument, 0, 49},
+                         {"grid-tile-size", required_argument, 0, 50},
+                         {"deadline", required_argument, 0, 51},
+                         {"progress-fd", required_argument, 0, 52},
+                         {"enlarge", required_argument, 0, 53},
+                         {"prev-subset", no_argument, 0, 54},
+                         {"ilp-remote-cmd", required_argument, 0, 55},
+                         {"compress", required_argument, 0, 56},
+                         {"ilp-corridor", required_argument, 0, 57},
+                         {"route-regions", required_argument, 0, 59},
+                         {"comp-cache-dir", required_argument, 0, 60},
                          {0, 0, 0, 0}};
 
   int c;
 
-  while ((c = getopt_long(argc, argv, ":hvm:Dg:b:", ops, 0)) != -1) {
+  while ((c = getopt_long(argc, argv, ":hvm:Dg:b:j:t:", ops, 0)) != -1) {
     switch (c) {
       case 'a':
         cfg->abortAfter = atoi(optarg);
@@ -247,6 +422,126 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
       case 26:
         cfg->retryOnError = true;
         break;
+      case 27:
+        cfg->outputFormat = optarg;
+        break;
+      case 'j':
+        cfg->jobs = atoi(optarg);
+        break;
+      case 't':
+        cfg->threadBudget = std::max(1, atoi(optarg));
+        break;
+      case 28:
+        cfg->gridMemLimit = atof(optarg);
+        break;
+      case 29:
+        cfg->gridDijkstra = false;
+        break;
+      case 30:
+        cfg->stageCacheDir = optarg;
+        break;
+      case 31:
+        cfg->retryJobs = std::max(1, atoi(optarg));
+        break;
+      case 32:
+        cfg->coarseFactor = atof(optarg);
+        break;
+      case 33:
+        cfg->sparseGrid = atoi(optarg);
+        break;
+      case 34:
+        cfg->ilpWindow = atoi(optarg);
+        break;
+      case 35:
+        cfg->ilpCacheModel = true;
+        break;
+      case 36:
+        cfg->bidirRouteDist = atof(optarg);
+        break;
+      case 37:
+        cfg->prevDrawingPath = optarg;
+        break;
+      case 38:
+        cfg->prevRadius = atoi(optarg);
+        break;
+      case 39:
+        cfg->tracePath = optarg;
+        break;
+      case 40:
+        cfg->metricsPath = optarg;
+        break;
+      case 41:
+        cfg->snapOrphanStations = true;
+        break;
+      case 42:
+        cfg->quadTreeMaxLeafPts = atoi(optarg);
+        break;
+      case 43:
+        cfg->quadTreeMinCellSize = atof(optarg);
+        break;
+      case 44:
+        cfg->quadTreeEdgeSampleDist = atof(optarg);
+        break;
+      case 45:
+        cfg->maxGridMem = atof(optarg);
+        break;
+      case 46:
+        cfg->printMode = optarg;
+        break;
+      case 47:
+        cfg->gridDumpFormat = optarg;
+        break;
+      case 48:
+        gridFilterStr = optarg;
+        break;
+      case 49: {
+        auto crds = util::split(optarg, ',');
+        if (crds.size() != 4) {
+          std::cerr << "--grid-window requires minlng,minlat,maxlng,maxlat"
+                    << std::endl;
+          exit(1);
+        }
+        cfg->gridDumpWindow = util::geo::DBox(
+            util::geo::latLngToWebMerc(util::geo::DPoint(
+                atof(crds[0].c_str()), atof(crds[1].c_str()))),
+            util::geo::latLngToWebMerc(util::geo::DPoint(
+                atof(crds[2].c_str()), atof(crds[3].c_str()))));
+        break;
+      }
+      case 50:
+        cfg->gridDumpTileSize = atof(optarg);
+        break;
+      case 51:
+        cfg->deadline = atof(optarg);
+        break;
+      case 52:
+        cfg->progressFd = atoi(optarg);
+        break;
+      case 53:
+        cfg->enlarge = atof(optarg);
+        break;
+      case 54:
+        cfg->prevSubset = true;
+        break;
+      case 55:
+        cfg->ilpRemoteCmd = optarg;
+        break;
+      case 56:
+        if (!shared::io::parseCodec(optarg, &cfg->compress)) {
+          LOG(ERROR) << "Unknown compression " << optarg
+                     << ", must be one of {none, gzip, zstd}";
+          exit(1);
+        }
+        break;
+      case 57:
+        cfg->ilpCorridor = atoi(optarg);
+        break;
+      case 59:
+        cfg->routeRegions = atoi(optarg);
+        break;
+      case 60:
+        cfg->compCacheDir = optarg;
+        break;
       case 'g':
         cfg->gridSize = optarg;
         break;
@@ -272,6 +567,60 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
     }
   }
 
+  // the heuristic and the ILP solver stay within the thread budget, unless
+  // set explicitly
+  if (cfg->threadBudget > 0) {
+    if (cfg->jobs == 0) cfg->jobs = cfg->threadBudget;
+    if (cfg->ilpNumThreads == 0) cfg->ilpNumThreads = cfg->threadBudget;
+  }
+
+  if (cfg->outputFormat != "json" && cfg->outputFormat != "topojson" &&
+      cfg->outputFormat != "bin") {
+    LOG(ERROR) << "Unknown output format " << cfg->outputFormat
+               << ", must be one of {json, topojson, bin}";
+    exit(1);
+  }
+
+  if (!shared::io::hasCodec(cfg->compress)) {
+    LOG(ERROR) << shared::io::codecName(cfg->compress)
+               << " compression was not compiled in";
+    exit(1);
+  }
+
+  if (cfg->printMode != "linegraph" && cfg->printMode != "gridgraph") {
+    LOG(ERROR) << "Unknown print mode " << cfg->printMode
+               << ", must be one of {linegraph, gridgraph}";
+    exit(1);
+  }
+
+  if (cfg->gridDumpFormat != "geojson" && cfg->gridDumpFormat != "bin") {
+    LOG(ERROR) << "Unknown grid format " << cfg->gridDumpFormat
+               << ", must be one of {geojson, bin}";
+    exit(1);
+  }
+
+  if (gridFilterStr == "all") {
+    cfg->gridDumpFilter = octi::basegraph::GRID_DUMP_ALL;
+  } else if (gridFilterStr == "settled") {
+    cfg->gridDumpFilter = octi::basegraph::GRID_DUMP_SETTLED;
+  } else if (gridFilterStr == "used") {
+    cfg->gridDumpFilter = octi::basegraph::GRID_DUMP_USED;
+  } else {
+    LOG(ERROR) << "Unknown grid filter " << gridFilterStr
+               << ", must be one of {all, settled, used}";
+    exit(1);
+  }
+
+  if (cfg->gridDumpTileSize <= 0) {
+    LOG(ERROR) << "Grid tile size must be positive";
+    exit(1);
+  }
+
+  if (cfg->enlarge < 0 || cfg->enlarge >= 1) {
+    LOG(ERROR) << "Enlargement strength must be in [0, 1)";
+    exit(1);
+  }
+
   if (edgeOrderMethod == "num-lines") {
     cfg->orderMethod = OrderMethod::NUM_LINES;
   } else if (edgeOrderMethod == "length") {
@@ -313,6 +662,8 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
     cfg->baseGraphType = BaseGraphType::OCTIHANANGRID;
   } else if (baseGraphStr == "octihanan") {
     cfg->baseGraphType = BaseGraphType::OCTIHANANGRID;
+  } else if (baseGraphStr == "bufferoctilinear") {
+    cfg->baseGraphType = BaseGraphType::BUFFEREDOCTIGRID;
   } else {
     LOG(ERROR) << "Unknown base graph type " << baseGraphStr << std::endl;
     exit(0);
@@ -5,9 +5,13 @@
 #ifndef OCTI_CONFIG_OCTICONFIG_H_
 #define OCTI_CONFIG_OCTICONFIG_H_
 
+#include <memory>
 #include <string>
 #include "octi/basegraph/BaseGraph.h"
+#include "octi/basegraph/GridDump.h"
 #include "octi/basegraph/GridGraph.h"
+#include "shared/io/CompressedStream.h"
+#include "shared/linegraph/LineGraph.h"
 #include "util/geo/Geo.h"
 
 namespace octi {
@@ -25,12 +29,29 @@ enum OrderMethod {
 
 struct Config {
   std::string gridSize = "100%";
+
+  // strength of the density-equalizing enlargement of the input, in [0, 1),
+  // 0 disables it, see octi/Enlarger.h
+  double enlarge = 0;
   double borderRad = 45;
 
   std::string printMode = "linegraph";
+
+  // dump of the grid graphs in print mode gridgraph, the window is in web
+  // mercator coordinates and empty if the whole grid is dumped
+  std::string gridDumpFormat = "geojson";
+  octi::basegraph::GridDumpFilter gridDumpFilter =
+      octi::basegraph::GRID_DUMP_ALL;
+  util::geo::DBox gridDumpWindow;
+  double gridDumpTileSize = 10000;
+  std::string outputFormat = "json";
+  // compression of the output, the input is decompressed if needed
+  shared::io::Codec compress = shared::io::CODEC_NONE;
+
   std::string optMode = "heur";
   std::string ilpPath;
   bool fromDot = false;
+  bool snapOrphanStations = false;
   bool deg2Heur = true;
   bool restrLocSearch = false;
   double enfGeoPen = 0;
@@ -39,25 +60,105 @@ struct Config {
   int ilpNumThreads = 0;
   double ilpCacheThreshold = DBL_MAX;
   std::string ilpSolver = "gurobi";
+  // command for --ilp-solver remote, see shared::optim::RemoteSolver
+  std::string ilpRemoteCmd;
   std::string ilpCacheDir = ".";
 
+  // size of the ILP windows in grid cells, 0 solves a single ILP
+  size_t ilpWindow = 0;
+
+  // restrict the ILP to the grid cells at most this many cells away from the
+  // presolved drawing, widened while infeasible. 0 uses the full grid
+  size_t ilpCorridor = 0;
+
+  // cache the ILP constraint skeleton in ilpCacheDir
+  bool ilpCacheModel = false;
+
   bool skipOnError = false;
   bool retryOnError = false;
+  size_t retryJobs = 1;
 
   double maxGrDist = 3;
 
+  // 0 disables the coarse-to-fine drawing
+  double coarseFactor = 0;
+
   int heurLocSearchIters = 100;
 
   size_t abortAfter = -1;
 
   size_t hananIters = 1;
+
+  // number of parallel jobs, 0 means hardware concurrency
+  size_t jobs = 0;
+
+  // thread budget of the whole run if given with -t, 0 otherwise
+  size_t threadBudget = 0;
+
+  // memory limit in MB for the per-job grid graphs, 0 means no limit
+  double gridMemLimit = 0;
+
+  // memory budget in MB for the grid graphs of a component, exceeding it
+  // switches to a sparser base graph, coarsens the grid and lowers the number
+  // of jobs. 0 means no budget
+  double maxGridMem = 0;
+
+  // use the specialized grid shortest path search if available
+  bool gridDijkstra = true;
+
+  // only build octilinear grid nodes this many cells around the input
+  // graph, 0 means the full grid
+  size_t sparseGrid = 0;
+
+  // route comb edges with a bidirectional search if their end points are
+  // at least this many grid cells apart, 0 means never
+  double bidirRouteDist = 0;
+
+  // route the initial drawing in parallel in routeRegions x routeRegions
+  // regions of the map, 0 or 1 means no regions
+  size_t routeRegions = 0;
+
+  // split criteria of the quadtree base graph
+  size_t quadTreeMaxLeafPts = 0;
+  double quadTreeMinCellSize = 1;
+  double quadTreeEdgeSampleDist = 0;
+
   bool writeStats = false;
 
   OrderMethod orderMethod;
 
   std::string obstaclePath;
+
+  // directory of the stage output cache, empty if disabled
+  std::string stageCacheDir;
+
+  // directory of the per-component result cache, empty if disabled
+  std::string compCacheDir;
+
+  // write a Chrome trace of the run to this file, empty if disabled
+  std::string tracePath;
+
+  // write per-phase resource usage as JSON to this file, empty if disabled
+  std::string metricsPath;
+
+  // write the progress as JSON lines to this file descriptor, -1 if disabled
+  int progressFd = -1;
+
+  // seconds from the start after which the local search and the ILP are cut
+  // short and the best drawings so far are written, 0 for none
+  double deadline = 0;
+
   std::vector<util::geo::DPolygon> obstacles;
 
+  // previous octi output for incremental drawing, see
+  // Octilinearizer::setPrevDrawing()
+  std::string prevDrawingPath;
+  size_t prevRadius = 2;
+
+  // the input is a subset of the lines of the previous drawing
+  bool prevSubset = false;
+  std::shared_ptr<const shared::linegraph::LineGraph> prevDrawing;
+
   octi::basegraph::BaseGraphType baseGraphType;
 
   octi::basegraph::Penalties pens;
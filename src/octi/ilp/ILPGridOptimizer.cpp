@@ -2,7 +2,15 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
+#include <iomanip>
+#include <limits>
 
 #include "octi/basegraph/BaseGraph.h"
 #include "octi/ilp/ILPGridOptimizer.h"
@@ -11,14 +19,47 @@
 #include "util/log/Log.h"
 
 using octi::basegraph::BaseGraph;
+using octi::basegraph::CrossEdgPairs;
 using octi::basegraph::GeoPensMap;
 using octi::basegraph::GridEdge;
 using octi::basegraph::GridNode;
 using octi::combgraph::Drawing;
 using octi::ilp::ILPGridOptimizer;
 using octi::ilp::ILPStats;
+using shared::optim::IdxStarterSol;
+using shared::optim::ILPModel;
 using shared::optim::ILPSolver;
 using shared::optim::StarterSol;
+using util::geo::DBox;
+
+namespace {
+// bump if the skeleton layout changes
+const uint64_t SKEL_VERSION = 1;
+
+const uint64_t FNV_OFFSET = 14695981039346656037ull;
+
+// _____________________________________________________________________________
+template <typename T>
+void hashVal(const T& v, uint64_t* h) {
+  const unsigned char* c = reinterpret_cast<const unsigned char*>(&v);
+  for (size_t i = 0; i < sizeof(T); i++) {
+    *h ^= c[i];
+    *h *= 1099511628211ull;
+  }
+}
+
+// _____________________________________________________________________________
+template <typename T>
+void writeVal(std::ostream* os, const T& v) {
+  os->write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+// _____________________________________________________________________________
+template <typename T>
+bool readVal(std::istream* is, T* v) {
+  return static_cast<bool>(is->read(reinterpret_cast<char*>(v), sizeof(T)));
+}
+}  // namespace
 
 // _____________________________________________________________________________
 ILPStats ILPGridOptimizer::optimize(BaseGraph* gg, const CombGraph& cg,
@@ -27,10 +68,27 @@ ILPStats ILPGridOptimizer::optimize(BaseGraph* gg, const CombGraph& cg,
                                     int timeLim, const std::string& cacheDir,
                                     double cacheThreshold, int numThreads,
                                     const std::string& solverStr,
-                                    const std::string& path) const {
-  // extract first feasible solution from gridgraph
+                                    const std::string& path,
+                                    size_t windowSize, size_t corridorSize,
+                                    size_t jobs, bool cacheModel) const {
   ILPStats s{std::numeric_limits<double>::infinity(), 0, 0, 0, 0};
-  StarterSol sol = extractFeasibleSol(d, gg, cg, maxGrDist);
+
+  // windows need a complete presolved drawing to start from
+  size_t numEdgs = 0;
+  for (auto nd : cg.getNds()) numEdgs += nd->getAdjListOut().size();
+  bool windows = windowSize > 0 && !noSolve && path.empty() &&
+                 d->getEdgPaths().size() == numEdgs;
+
+  // the full problem may be restricted to a corridor around a complete
+  // presolved drawing, the corridor holds the presolved solution
+  bool corridor = corridorSize > 0 && !windows &&
+                  d->getEdgPaths().size() == numEdgs;
+  std::unordered_set<const GridNode*> core;
+  if (corridor) core = corridorCore(gg, cg, d);
+
+  // extract first feasible solution from gridgraph
+  FeasibleSol sol;
+  if (!windows) sol = extractFeasibleSol(d, gg, cg, maxGrDist);
   gg->reset();
 
   for (auto nd : gg->getNds()) {
@@ -45,15 +103,31 @@ ILPStats ILPGridOptimizer::optimize(BaseGraph* gg, const CombGraph& cg,
     gg->closeSinkTo(nd);
   }
 
+  if (windows) {
+    return optimizeWindows(gg, cg, d, maxGrDist, geoPensMap, timeLim,
+                           numThreads, solverStr, windowSize, jobs);
+  }
+
   // clear drawing
   d->crumble();
 
-  auto lp = createProblem(gg, cg, geoPensMap, maxGrDist, solverStr);
+  std::unordered_set<const GridNode*> corr;
+  if (corridor) {
+    corr = getCorridor(gg, core, corridorSize);
+    LOGTO(DEBUG, std::cerr) << "Restricting the ILP to a corridor of "
+                            << corridorSize << " cells, " << corr.size()
+                            << " of " << gg->getNds().size() << " grid nodes";
+  }
+
+  VarIdx idx;
+  auto lp = createProblem(gg, cg, geoPensMap, maxGrDist, solverStr,
+                          path.size() > 0, 0, corridor ? &corr : 0,
+                          cacheModel ? cacheDir : "", &idx);
 
   s.cols = lp->getNumVars();
   s.rows = lp->getNumConstrs();
 
-  lp->setStarter(sol);
+  lp->setStarter(getStarter(sol, idx));
 
   if (path.size()) {
     std::string basename = path;
@@ -62,7 +136,7 @@ ILPStats ILPGridOptimizer::optimize(BaseGraph* gg, const CombGraph& cg,
 
     std::string outf = basename + ".sol";
     std::string solutionF = basename + ".mst";
-    lp->writeMst(solutionF, sol);
+    lp->writeMst(solutionF, getNamedStarter(sol));
     lp->writeMps(path);
   }
 
@@ -74,9 +148,46 @@ ILPStats ILPGridOptimizer::optimize(BaseGraph* gg, const CombGraph& cg,
     lp->setCacheThreshold(cacheThreshold);
     if (numThreads != 0) lp->setNumThreads(numThreads);
     T_START(ilp);
+    lp->setIncumbentCb([&](double obj, const std::vector<double>& vals) {
+      UNUSED(vals);
+      LOGTO(DEBUG, std::cerr) << "New incumbent with objective " << obj
+                              << " after " << T_STOP(ilp) << " ms";
+    });
     auto status = lp->solve();
     time = T_STOP(ilp);
 
+    // no solution in the corridor, widen it until it spans the whole grid
+    while (status == shared::optim::SolveType::INF && corridor) {
+      delete lp;
+      corridorSize *= 2;
+      size_t prev = corr.size();
+      corr = getCorridor(gg, core, corridorSize);
+      corridor = corr.size() > prev && corr.size() < gg->getNds().size();
+
+      LOGTO(DEBUG, std::cerr)
+          << "No solution in the corridor, retrying with "
+          << (corridor ? "a corridor of " + std::to_string(corridorSize) +
+                             " cells"
+                       : std::string("the full grid"));
+
+      idx = VarIdx();
+      lp = createProblem(gg, cg, geoPensMap, maxGrDist, solverStr, false, 0,
+                         corridor ? &corr : 0, cacheModel ? cacheDir : "",
+                         &idx);
+      s.cols = lp->getNumVars();
+      s.rows = lp->getNumConstrs();
+
+      lp->setStarter(getStarter(sol, idx));
+      if (timeLim >= 0) lp->setTimeLim(timeLim);
+      if (cacheDir.size()) lp->setCacheDir(cacheDir);
+      lp->setCacheThreshold(cacheThreshold);
+      if (numThreads != 0) lp->setNumThreads(numThreads);
+
+      T_START(retry);
+      status = lp->solve();
+      time += T_STOP(retry);
+    }
+
     if (status == shared::optim::SolveType::INF) {
       delete lp;
       throw std::runtime_error(
@@ -84,7 +195,7 @@ ILPStats ILPGridOptimizer::optimize(BaseGraph* gg, const CombGraph& cg,
           "limit)!");
     }
 
-    extractSolution(lp, gg, cg, d);
+    extractSolution(lp, idx, gg, cg, d, 0);
     shared::linegraph::LineGraph tg;
     d->getLineGraph(&tg);
 
@@ -99,261 +210,694 @@ ILPStats ILPGridOptimizer::optimize(BaseGraph* gg, const CombGraph& cg,
 }
 
 // _____________________________________________________________________________
-ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
-                                           const GeoPensMap* geoPensMap,
-                                           double maxGrDist,
-                                           const std::string& solverStr) const {
-  ILPSolver* lp = shared::optim::getSolver(solverStr, shared::optim::MIN);
+ILPStats ILPGridOptimizer::optimizeWindows(
+    BaseGraph* gg, const CombGraph& cg, Drawing* d, double maxGrDist,
+    const GeoPensMap* geoPensMap, int timeLim, int numThreads,
+    const std::string& solverStr, size_t windowSize, size_t jobs) const {
+  ILPStats s{0, 0, 0, 0, true};
 
-  // grid nodes that may potentially be a position for an
-  // input station
-  std::map<const CombNode*, std::set<const GridNode*>> cands;
+  const auto crossPairs = gg->getCrossEdgPairs();
+
+  std::vector<GridNode*> sinks;
+  for (auto n : gg->getNds()) {
+    if (n->pl().isSink()) sinks.push_back(n);
+  }
 
+  DBox box;
   for (auto nd : cg.getNds()) {
     if (nd->getDeg() == 0) continue;
-    std::stringstream oneAssignment;
-    // must sum up to 1
-    oneAssignment << "oneass(" << nd << ")";
-    int rowStat = lp->addRow(oneAssignment.str(), 1, shared::optim::FIX);
+    box = util::geo::extendBox(*d->getGrNd(nd)->pl().getGeom(), box);
+  }
 
-    for (const GridNode* n : gg->getNds()) {
-      if (!n->pl().isSink()) continue;
+  double winSize = gg->getCellSize() * windowSize;
+  double step = winSize / 2;
+  size_t numWins = 0;
 
-      // don't use nodes as candidates which cannot hold the comb node due to
-      // their degree
-      if (n->getDeg() < nd->getDeg()) {
-        continue;
+  // 4 sweeps with windows shifted by half their size, nodes at the border of
+  // a window in one sweep are in the interior of a window of another sweep
+  for (size_t sweep = 0; sweep < 4; sweep++) {
+    double x0 = box.getLowerLeft().getX() - (sweep % 2) * step;
+    double y0 = box.getLowerLeft().getY() - (sweep / 2) * step;
+
+    std::vector<DBox> tiles;
+    for (double x = x0; x <= box.getUpperRight().getX(); x += winSize) {
+      for (double y = y0; y <= box.getUpperRight().getY(); y += winSize) {
+        tiles.push_back(DBox({x, y}, {x + winSize, y + winSize}));
       }
+    }
 
-      double gridD = dist(*n->pl().getGeom(), *nd->pl().getGeom());
+    std::vector<bool> done(tiles.size(), false);
+    size_t left = tiles.size();
 
-      // threshold for speedup
-      double maxDis = gg->getCellSize() * maxGrDist;
-      if (gridD >= maxDis) {
-        continue;
+    while (left) {
+      // the windows of a round don't overlap and are solved in parallel
+      std::vector<Window> wins;
+      for (size_t i = 0; i < tiles.size(); i++) {
+        if (done[i]) continue;
+        auto w = getWindow(gg, cg, d, tiles[i], maxGrDist, sinks, crossPairs);
+
+        bool overlaps = false;
+        for (const auto& o : wins) {
+          if (util::geo::intersects(o.box, w.box)) {
+            overlaps = true;
+            break;
+          }
+        }
+        if (overlaps) continue;
+
+        done[i] = true;
+        left--;
+        if (w.free.size()) wins.push_back(w);
       }
 
-      cands[nd].insert(n);
+      std::vector<ILPSolver*> lps(wins.size());
+      std::vector<VarIdx> idxs(wins.size());
+      std::vector<shared::optim::SolveType> status(wins.size());
+      std::vector<double> times(wins.size());
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(jobs)
+      for (size_t i = 0; i < wins.size(); i++) {
+        lps[i] = createProblem(gg, cg, geoPensMap, maxGrDist, solverStr, false,
+                               &wins[i], 0, "", &idxs[i]);
+        lps[i]->setStarter(getStarter(wins[i], idxs[i]));
+        if (timeLim >= 0) lps[i]->setTimeLim(timeLim);
+        if (numThreads != 0) lps[i]->setNumThreads(numThreads);
+        T_START(ilp);
+        status[i] = lps[i]->solve();
+        times[i] = T_STOP(ilp);
+      }
 
-      gg->openSinkFr(const_cast<GridNode*>(n), 0);
-      gg->openSinkTo(const_cast<GridNode*>(n), 0);
+      // the solver starts from the current drawing, so a solution is never
+      // worse than it
+      for (size_t i = 0; i < wins.size(); i++) {
+        s.cols += lps[i]->getNumVars();
+        s.rows += lps[i]->getNumConstrs();
+        s.time += times[i];
+        s.optimal = s.optimal && status[i] == shared::optim::SolveType::OPTIM;
+
+        if (status[i] != shared::optim::SolveType::INF) {
+          for (auto edg : wins[i].edgs) d->erase(edg);
+          for (auto nd : wins[i].nds) {
+            if (wins[i].free.count(nd)) d->erase(nd);
+          }
+          extractSolution(lps[i], idxs[i], gg, cg, d, &wins[i]);
+        }
 
-      auto varName = getStatPosVar(n, nd);
+        delete lps[i];
+      }
 
-      int col = lp->addCol(varName, shared::optim::BIN, gg->ndMovePen(nd, n));
+      numWins += wins.size();
+    }
+  }
 
-      lp->addColToRow(rowStat, col, 1);
+  // write the final drawing to the grid graph
+  for (const auto& p : d->getEdgPaths()) {
+    for (auto eid : p.second) {
+      gg->addResEdg(const_cast<GridEdge*>(gg->getGrEdgById(eid)),
+                    const_cast<CombEdge*>(p.first));
     }
   }
 
-  // for every edge, we define a binary variable telling us whether this edge
-  // is used in a path for the original edge
+  LOGTO(DEBUG, std::cerr) << "Solved " << numWins << " ILP windows";
+
+  s.score = d->score();
+  return s;
+}
+
+// _____________________________________________________________________________
+ILPGridOptimizer::Window ILPGridOptimizer::getWindow(
+    BaseGraph* gg, const CombGraph& cg, Drawing* d, const DBox& tile,
+    double maxGrDist, const std::vector<GridNode*>& sinks,
+    const CrossEdgPairs& crossPairs) const {
+  Window w;
+
+  // nodes drawn inside the tile are free
   for (auto nd : cg.getNds()) {
+    if (nd->getDeg() == 0) continue;
+    auto n = d->getGrNd(nd);
+    w.pos[nd] = n;
+    if (util::geo::contains(*n->pl().getGeom(), tile)) {
+      w.free.insert(nd);
+      w.nds.push_back(nd);
+    }
+  }
+
+  if (w.free.empty()) return w;
+
+  // all edges adjacent to a free node are re-routed, their other nodes which
+  // are not free are fixed
+  std::set<const CombNode*> inWin = w.free;
+  for (size_t i = 0, n = w.nds.size(); i < n; i++) {
+    for (auto edg : w.nds[i]->getAdjList()) {
+      if (!w.edgSet.insert(edg).second) continue;
+      w.edgs.push_back(edg);
+      auto other = edg->getOtherNd(w.nds[i]);
+      if (inWin.insert(other).second) w.nds.push_back(other);
+    }
+  }
+
+  w.box = tile;
+  for (auto nd : w.nds) {
+    w.box = util::geo::extendBox(*w.pos[nd]->pl().getGeom(), w.box);
+  }
+
+  for (auto edg : w.edgs) {
+    auto& path = w.paths[edg];
+    for (auto eid : d->getEdgPaths().find(edg)->second) {
+      auto e = gg->getGrEdgById(eid);
+      path.insert(e);
+      w.box = util::geo::extendBox(
+          *e->getFrom()->pl().getParent()->pl().getGeom(), w.box);
+      w.box = util::geo::extendBox(
+          *e->getTo()->pl().getParent()->pl().getGeom(), w.box);
+    }
+  }
+
+  w.box = util::geo::pad(w.box, gg->getCellSize());
+
+  // grid nodes occupied by the drawing outside the window
+  std::unordered_set<const GridNode*> occ;
+  for (const auto& p : w.pos) {
+    if (!inWin.count(p.first)) occ.insert(p.second);
+  }
+
+  for (const auto& p : d->getEdgPaths()) {
+    if (w.edgSet.count(p.first)) continue;
+    for (auto eid : p.second) {
+      auto e = gg->getGrEdgById(eid);
+      auto fr = e->getFrom()->pl().getParent();
+      auto to = e->getTo()->pl().getParent();
+      if (!util::geo::contains(*fr->pl().getGeom(), w.box) &&
+          !util::geo::contains(*to->pl().getGeom(), w.box)) {
+        continue;
+      }
+      occ.insert(fr);
+      occ.insert(to);
+      w.blocked.insert(e);
+      w.blocked.insert(gg->getEdg(e->getTo(), e->getFrom()));
+    }
+  }
+
+  // the fixed nodes stay where they are
+  std::unordered_set<const GridNode*> fixedPos;
+  for (auto nd : w.nds) {
+    if (w.free.count(nd)) continue;
+    occ.erase(w.pos[nd]);
+    fixedPos.insert(w.pos[nd]);
+    w.cands[nd].insert(w.pos[nd]);
+  }
+
+  std::vector<const GridNode*> regSinks;
+  for (auto n : sinks) {
+    if (occ.count(n) || !util::geo::contains(*n->pl().getGeom(), w.box)) {
+      continue;
+    }
+    regSinks.push_back(n);
+    w.grNds.push_back(n);
+    w.grNdSet.insert(n);
+    for (size_t p = 0; p < gg->maxDeg(); p++) {
+      auto port = n->pl().getPort(p);
+      if (!port) continue;
+      w.grNds.push_back(port);
+      w.grNdSet.insert(port);
+    }
+  }
+
+  double maxDis = gg->getCellSize() * maxGrDist;
+  for (auto nd : w.nds) {
+    if (!w.free.count(nd)) continue;
+    w.cands[nd].insert(w.pos[nd]);
+    for (auto n : regSinks) {
+      if (fixedPos.count(n) || n->getDeg() < nd->getDeg()) continue;
+      if (dist(*n->pl().getGeom(), *nd->pl().getGeom()) >= maxDis) continue;
+      w.cands[nd].insert(n);
+    }
+  }
+
+  // crossings with fixed edges are forbidden
+  for (const auto& cp : crossPairs) {
+    if (!(w.grNdSet.count(cp.first.first->getFrom()) &&
+          w.grNdSet.count(cp.first.first->getTo())) &&
+        !(w.grNdSet.count(cp.second.first->getFrom()) &&
+          w.grNdSet.count(cp.second.first->getTo()))) {
+      continue;
+    }
+
+    if (w.blocked.count(cp.first.first) || w.blocked.count(cp.first.second)) {
+      w.blocked.insert(cp.second.first);
+      w.blocked.insert(cp.second.second);
+    }
+
+    if (w.blocked.count(cp.second.first) ||
+        w.blocked.count(cp.second.second)) {
+      w.blocked.insert(cp.first.first);
+      w.blocked.insert(cp.first.second);
+    }
+
+    w.crossPairs.push_back(cp);
+  }
+
+  // directions of the fixed edges at fixed nodes
+  for (auto nd : w.nds) {
+    if (w.free.count(nd) || nd->getDeg() < 2) continue;
+    auto n = w.pos[nd];
     for (auto edg : nd->getAdjList()) {
-      if (edg->getFrom() != nd) continue;
-      for (const GridNode* n : gg->getNds()) {
-        for (const GridEdge* e : n->getAdjList()) {
-          if (e->getFrom() != n) continue;
-          if (e->pl().cost() >= basegraph::SOFT_INF) {
-            // skip infinite edges, we cannot use them.
-            // this also skips sink edges of nodes not used as
-            // candidates
-            continue;
+      if (w.edgSet.count(edg)) continue;
+      for (auto eid : d->getEdgPaths().find(edg)->second) {
+        for (auto id : {eid.first, eid.second}) {
+          auto port = gg->getGrNdById(id);
+          if (port->pl().getParent() != n) continue;
+          for (size_t p = 0; p < gg->maxDeg(); p++) {
+            if (n->pl().getPort(p) == port) w.fixedDirs[{nd, edg}] = p;
           }
+        }
+      }
+    }
+  }
 
-          if (e->getFrom()->pl().isSink() &&
-              !cands[edg->getFrom()].count(e->getFrom())) {
-            continue;
-          }
+  return w;
+}
 
-          if (e->getTo()->pl().isSink() &&
-              !cands[edg->getTo()].count(e->getTo())) {
+// _____________________________________________________________________________
+int ILPGridOptimizer::VarIdx::edgUseCol(const GridEdge* e,
+                                        const CombEdge* cg) const {
+  auto i = edgUse.find(cg);
+  if (i == edgUse.end()) return -1;
+  auto j = i->second.find(e);
+  if (j == i->second.end()) return -1;
+  return j->second;
+}
+
+// _____________________________________________________________________________
+int ILPGridOptimizer::VarIdx::statPosCol(const GridNode* n,
+                                         const CombNode* cg) const {
+  auto i = statPos.find(cg);
+  if (i == statPos.end()) return -1;
+  auto j = i->second.find(n);
+  if (j == i->second.end()) return -1;
+  return j->second;
+}
+
+// _____________________________________________________________________________
+std::unordered_set<const GridNode*> ILPGridOptimizer::corridorCore(
+    BaseGraph* gg, const CombGraph& cg, Drawing* d) const {
+  std::unordered_set<const GridNode*> core;
+
+  for (auto nd : cg.getNds()) {
+    if (nd->getDeg() == 0) continue;
+    core.insert(d->getGrNd(nd));
+  }
+
+  for (const auto& p : d->getEdgPaths()) {
+    for (auto eid : p.second) {
+      auto e = gg->getGrEdgById(eid);
+      core.insert(e->getFrom()->pl().getParent());
+      core.insert(e->getTo()->pl().getParent());
+    }
+  }
+
+  return core;
+}
+
+// _____________________________________________________________________________
+std::unordered_set<const GridNode*> ILPGridOptimizer::getCorridor(
+    BaseGraph* gg, const std::unordered_set<const GridNode*>& core,
+    size_t cells) const {
+  std::vector<const GridNode*> sinks;
+  size_t w = 0, h = 0;
+  for (auto n : gg->getNds()) {
+    if (!n->pl().isSink()) continue;
+    sinks.push_back(n);
+    w = std::max(w, n->pl().getX() + 1);
+    h = std::max(h, n->pl().getY() + 1);
+  }
+
+  // chebyshev distance of each cell to the nearest core cell, computed in a
+  // forward and a backward pass over the cells
+  const size_t inf = std::numeric_limits<size_t>::max() - 1;
+  std::vector<size_t> dist(w * h, inf);
+  for (auto n : core) dist[n->pl().getX() * h + n->pl().getY()] = 0;
+
+  for (size_t x = 0; x < w; x++) {
+    for (size_t y = 0; y < h; y++) {
+      size_t& c = dist[x * h + y];
+      if (y > 0) c = std::min(c, dist[x * h + y - 1] + 1);
+      if (x == 0) continue;
+      c = std::min(c, dist[(x - 1) * h + y] + 1);
+      if (y > 0) c = std::min(c, dist[(x - 1) * h + y - 1] + 1);
+      if (y + 1 < h) c = std::min(c, dist[(x - 1) * h + y + 1] + 1);
+    }
+  }
+
+  for (size_t x = w; x-- > 0;) {
+    for (size_t y = h; y-- > 0;) {
+      size_t& c = dist[x * h + y];
+      if (y + 1 < h) c = std::min(c, dist[x * h + y + 1] + 1);
+      if (x + 1 == w) continue;
+      c = std::min(c, dist[(x + 1) * h + y] + 1);
+      if (y > 0) c = std::min(c, dist[(x + 1) * h + y - 1] + 1);
+      if (y + 1 < h) c = std::min(c, dist[(x + 1) * h + y + 1] + 1);
+    }
+  }
+
+  std::unordered_set<const GridNode*> corr;
+  for (auto n : sinks) {
+    if (dist[n->pl().getX() * h + n->pl().getY()] > cells) continue;
+    corr.insert(n);
+    for (size_t p = 0; p < gg->maxDeg(); p++) {
+      auto port = n->pl().getPort(p);
+      if (port) corr.insert(port);
+    }
+  }
+
+  return corr;
+}
+
+// _____________________________________________________________________________
+ILPSolver* ILPGridOptimizer::createProblem(
+    BaseGraph* gg, const CombGraph& cg, const GeoPensMap* geoPensMap,
+    double maxGrDist, const std::string& solverStr, bool names,
+    const Window* win, const std::unordered_set<const GridNode*>* corr,
+    const std::string& skelDir, VarIdx* idx) const {
+  ILPSolver* lp = shared::optim::getSolver(solverStr, shared::optim::MIN);
+
+  // the problem is built by index, the names are only generated if the
+  // problem is written to a file
+  Skeleton skel(names);
+
+  std::string skelPath;
+  std::vector<CombNode*> nds;
+  std::vector<CombEdge*> edgs;
+  if (!win && !corr && !names && skelDir.size()) {
+    skelPath = getSkeletonPath(gg, cg, maxGrDist, skelDir, &nds, &edgs);
+  }
+
+  if (skelPath.size() && readSkeleton(skelPath, gg, nds, edgs, &skel)) {
+    LOGTO(DEBUG, std::cerr) << "Using cached ILP skeleton " << skelPath;
+
+    // the candidate sinks are opened while building the skeleton
+    for (const auto& nd : skel.idx.statPos) {
+      for (const auto& col : nd.second) {
+        gg->openSinkFr(const_cast<GridNode*>(col.first), 0);
+        gg->openSinkTo(const_cast<GridNode*>(col.first), 0);
+      }
+    }
+
+    setObjective(gg, geoPensMap, &skel);
+  } else {
+    buildSkeleton(gg, cg, geoPensMap, maxGrDist, win, corr, &skel);
+    if (skelPath.size()) writeSkeleton(skelPath, nds, edgs, skel);
+  }
+
+  lp->loadModel(skel.m);
+  lp->update();
+
+  *idx = std::move(skel.idx);
+
+  return lp;
+}
+
+// _____________________________________________________________________________
+void ILPGridOptimizer::buildSkeleton(
+    BaseGraph* gg, const CombGraph& cg, const GeoPensMap* geoPensMap,
+    double maxGrDist, const Window* win,
+    const std::unordered_set<const GridNode*>* corr, Skeleton* skel) const {
+  ILPModel& m = skel->m;
+  VarIdx* idx = &skel->idx;
+
+  // the comb nodes, comb edges and grid nodes the problem is built over
+  std::vector<CombNode*> combNds;
+  std::vector<CombEdge*> combEdgs;
+  std::vector<GridNode*> grNds;
+
+  if (win) {
+    combNds = win->nds;
+    combEdgs = win->edgs;
+    grNds = win->grNds;
+  } else {
+    for (auto nd : cg.getNds()) {
+      combNds.push_back(nd);
+      for (auto edg : nd->getAdjList()) {
+        if (edg->getFrom() == nd) combEdgs.push_back(edg);
+      }
+    }
+    for (auto n : gg->getNds()) {
+      if (!corr || corr->count(n)) grNds.push_back(n);
+    }
+  }
+
+  // grid nodes that may potentially be a position for an
+  // input station
+  std::map<const CombNode*, std::set<const GridNode*>> cands;
+
+  for (auto nd : combNds) {
+    if (nd->getDeg() == 0) continue;
+    // must sum up to 1
+    int rowStat = m.addRow(1, shared::optim::FIX);
+    m.setRowNames(rowStat, 1, [nd](size_t) {
+      std::stringstream oneAssignment;
+      oneAssignment << "oneass(" << nd << ")";
+      return oneAssignment.str();
+    });
+
+    if (win) {
+      cands[nd] = win->cands.find(nd)->second;
+    } else {
+      for (const GridNode* n : grNds) {
+        if (!n->pl().isSink()) continue;
+
+        // don't use nodes as candidates which cannot hold the comb node due
+        // to their degree
+        if (n->getDeg() < nd->getDeg()) {
+          continue;
+        }
+
+        double gridD = dist(*n->pl().getGeom(), *nd->pl().getGeom());
+
+        // threshold for speedup
+        double maxDis = gg->getCellSize() * maxGrDist;
+        if (gridD >= maxDis) {
+          continue;
+        }
+
+        cands[nd].insert(n);
+
+        gg->openSinkFr(const_cast<GridNode*>(n), 0);
+        gg->openSinkTo(const_cast<GridNode*>(n), 0);
+      }
+    }
+
+    for (const GridNode* n : cands[nd]) {
+      int col = m.addCol(shared::optim::BIN, gg->ndMovePen(nd, n));
+      m.setColNames(col, 1, [this, n, nd](size_t) {
+        return getStatPosVar(n, nd);
+      });
+      idx->statPos[nd][n] = col;
+
+      m.addColToRow(rowStat, col, 1);
+    }
+  }
+
+  // for every edge, we define a binary variable telling us whether this edge
+  // is used in a path for the original edge
+  for (auto edg : combEdgs) {
+    for (const GridNode* n : grNds) {
+      for (const GridEdge* e : n->getAdjList()) {
+        if (e->getFrom() != n) continue;
+
+        bool sinkEdg = e->getFrom()->pl().isSink() || e->getTo()->pl().isSink();
+
+        if (win) {
+          if (!win->grNdSet.count(e->getTo()) || win->blocked.count(e)) {
             continue;
           }
 
-          auto edgeVarName = getEdgUseVar(e, edg);
+          // the sink edges are never opened for windows, they are only
+          // restricted to the candidates below
+          if (!sinkEdg && e->pl().cost() >= basegraph::SOFT_INF) continue;
+        } else if (e->pl().cost() >= basegraph::SOFT_INF) {
+          // skip infinite edges, we cannot use them.
+          // this also skips sink edges of nodes not used as
+          // candidates
+          continue;
+        } else if (corr && !corr->count(e->getTo())) {
+          continue;
+        }
 
-          double coef;
-          if (geoPensMap && !e->pl().isSecondary()) {
-            // add geo pen
-            auto thisMap = geoPensMap->find(edg)->second;
-            auto i = thisMap.find(e->pl().getId());
-            if (i != thisMap.end()) coef = e->pl().cost() + i->second;
+        if (e->getFrom()->pl().isSink() &&
+            !cands[edg->getFrom()].count(e->getFrom())) {
+          continue;
+        }
 
-            // if no geopen was present for grid edge, we assume SOFT_INF
-            // penalty
-            coef = e->pl().cost() + octi::basegraph::SOFT_INF;
-          } else {
-            coef = e->pl().cost();
-          }
-          lp->addCol(edgeVarName, shared::optim::BIN, coef);
+        if (e->getTo()->pl().isSink() &&
+            !cands[edg->getTo()].count(e->getTo())) {
+          continue;
         }
+
+        double coef = win && sinkEdg ? 0 : edgUseCoef(e, edg, geoPensMap);
+        int col = m.addCol(shared::optim::BIN, coef);
+        m.setColNames(col, 1, [this, e, edg](size_t) {
+          return getEdgUseVar(e, edg);
+        });
+        idx->edgUse[edg][e] = col;
       }
     }
   }
 
-  lp->update();
-
   // an edge can only be used a single time
   std::set<const GridEdge*> proced;
-  for (const GridNode* n : gg->getNds()) {
+  for (const GridNode* n : grNds) {
     for (const GridEdge* e : n->getAdjList()) {
       if (e->pl().isSecondary()) continue;
       if (proced.count(e)) continue;
+      if (corr && !corr->count(e->getTo())) continue;
       auto f = gg->getEdg(e->getTo(), e->getFrom());
       proced.insert(e);
       proced.insert(f);
 
-      std::stringstream constName;
-      constName << "ue(" << e->getFrom()->pl().getId() << ","
-                << e->getTo()->pl().getId() << ")";
-      int row = lp->addRow(constName.str(), 1, shared::optim::UP);
-
-      for (auto nd : cg.getNds()) {
-        for (auto edg : nd->getAdjList()) {
-          if (edg->getFrom() != nd) continue;
-          if (e->pl().cost() >= basegraph::SOFT_INF) continue;
-
-          auto eVarName = getEdgUseVar(e, edg);
-          auto fVarName = getEdgUseVar(f, edg);
-
-          int eCol = lp->getVarByName(eVarName);
-          if (eCol > -1) lp->addColToRow(row, eCol, 1);
-          int fCol = lp->getVarByName(fVarName);
-          if (fCol > -1) lp->addColToRow(row, fCol, 1);
-        }
+      int row = m.addRow(1, shared::optim::UP);
+      m.setRowNames(row, 1, [e](size_t) {
+        std::stringstream constName;
+        constName << "ue(" << e->getFrom()->pl().getId() << ","
+                  << e->getTo()->pl().getId() << ")";
+        return constName.str();
+      });
+
+      for (auto edg : combEdgs) {
+        if (e->pl().cost() >= basegraph::SOFT_INF) continue;
+
+        int eCol = idx->edgUseCol(e, edg);
+        if (eCol > -1) m.addColToRow(row, eCol, 1);
+        int fCol = idx->edgUseCol(f, edg);
+        if (fCol > -1) m.addColToRow(row, fCol, 1);
       }
     }
   }
 
   // for every node, the number of outgoing and incoming used edges must be
   // the same, except for the start and end node
-  for (const GridNode* n : gg->getNds()) {
-    if (nonInfDeg(n) == 0) continue;
-
-    for (auto nd : cg.getNds()) {
-      for (auto edg : nd->getAdjList()) {
-        if (edg->getFrom() != nd) continue;
+  for (const GridNode* n : grNds) {
+    // sink edges are closed for windows
+    if (!win && nonInfDeg(n) == 0) continue;
+
+    for (auto edg : combEdgs) {
+      // an upper bound is enough here
+      int row = m.addRow(0, shared::optim::UP);
+      m.setRowNames(row, 1, [n, edg](size_t) {
         std::stringstream constName;
         constName << "as(" << n->pl().getId() << "," << edg << ")";
+        return constName.str();
+      });
+
+      // normally, we count an incoming edge as 1 and an outgoing edge as -1
+      // later on, we make sure that each node has a some of all out and in
+      // edges of 0
+      int inCost = -1;
+      int outCost = 1;
+
+      // for sink nodes, we apply a trick: an outgoing edge counts as 2 here.
+      // this means that a sink node cannot make up for an outgoing edge
+      // with an incoming edge - it would need 2 incoming edges to achieve
+      // that.
+      // however, this would mean (as sink nodes are never adjacent) that 2
+      // ports
+      // have outgoing edges - which would mean the path "split" somewhere
+      // before
+      // the ports, which is impossible and forbidden by our other
+      // constraints.
+      // the only way a sink node can make up for in outgoin edge
+      // is thus if we add -2 if the sink is marked as the start station of
+      // this edge
+      if (n->pl().isSink()) {
+        // subtract the variable for this start node and edge, if used
+        // as a candidate
+        int ndColFrom = idx->statPosCol(n, edg->getFrom());
+        if (ndColFrom > -1) m.addColToRow(row, ndColFrom, -2);
+
+        // add the variable for this end node and edge, if used
+        // as a candidate
+        int ndColTo = idx->statPosCol(n, edg->getTo());
+        if (ndColTo > -1) m.addColToRow(row, ndColTo, 1);
+
+        outCost = 2;
+      }
 
-        // an upper bound is enough here
-        int row = lp->addRow(constName.str(), 0, shared::optim::UP);
-
-        // normally, we count an incoming edge as 1 and an outgoing edge as -1
-        // later on, we make sure that each node has a some of all out and in
-        // edges of 0
-        int inCost = -1;
-        int outCost = 1;
-
-        // for sink nodes, we apply a trick: an outgoing edge counts as 2 here.
-        // this means that a sink node cannot make up for an outgoing edge
-        // with an incoming edge - it would need 2 incoming edges to achieve
-        // that.
-        // however, this would mean (as sink nodes are never adjacent) that 2
-        // ports
-        // have outgoing edges - which would mean the path "split" somewhere
-        // before
-        // the ports, which is impossible and forbidden by our other
-        // constraints.
-        // the only way a sink node can make up for in outgoin edge
-        // is thus if we add -2 if the sink is marked as the start station of
-        // this edge
-        if (n->pl().isSink()) {
-          // subtract the variable for this start node and edge, if used
-          // as a candidate
-          int ndColFrom = lp->getVarByName(getStatPosVar(n, edg->getFrom()));
-          if (ndColFrom > -1) lp->addColToRow(row, ndColFrom, -2);
-
-          // add the variable for this end node and edge, if used
-          // as a candidate
-          int ndColTo = lp->getVarByName(getStatPosVar(n, edg->getTo()));
-          if (ndColTo > -1) lp->addColToRow(row, ndColTo, 1);
-
-          outCost = 2;
-        }
-
-        for (auto e : n->getAdjListIn()) {
-          int edgCol = lp->getVarByName(getEdgUseVar(e, edg));
-          if (edgCol < 0) continue;
-          lp->addColToRow(row, edgCol, inCost);
-        }
+      for (auto e : n->getAdjListIn()) {
+        int edgCol = idx->edgUseCol(e, edg);
+        if (edgCol < 0) continue;
+        m.addColToRow(row, edgCol, inCost);
+      }
 
-        for (auto e : n->getAdjListOut()) {
-          int edgCol = lp->getVarByName(getEdgUseVar(e, edg));
-          if (edgCol < 0) continue;
-          lp->addColToRow(row, edgCol, outCost);
-        }
+      for (auto e : n->getAdjListOut()) {
+        int edgCol = idx->edgUseCol(e, edg);
+        if (edgCol < 0) continue;
+        m.addColToRow(row, edgCol, outCost);
       }
     }
   }
 
-  lp->update();
-
   // only a single sink edge can be activated per input edge and settled grid
   // node
   // THIS RULE IS REDUNDANT AND IMPLICITELY ENFORCED BY OTHER RULES,
   // BUT SEEMS TO LEAD TO FASTER SOLUTION TIMES
-  for (GridNode* n : gg->getNds()) {
+  for (GridNode* n : grNds) {
     if (!n->pl().isSink()) continue;
 
-    for (auto nd : cg.getNds()) {
-      for (auto e : nd->getAdjList()) {
-        if (e->getFrom() != nd) continue;
-
+    for (auto e : combEdgs) {
+      int row = m.addRow(0, shared::optim::FIX);
+      m.setRowNames(row, 1, [n, e](size_t) {
         std::stringstream constName;
         constName << "ss(" << n->pl().getId() << "," << e << ")";
+        return constName.str();
+      });
 
-        int row = lp->addRow(constName.str(), 0, shared::optim::FIX);
+      if (!cands[e->getFrom()].count(n) && !cands[e->getTo()].count(n)) {
+        // node does not appear as start or end cand, so the number of
+        // sink edges for this node is 0
 
-        if (!cands[e->getFrom()].count(n) && !cands[e->getTo()].count(n)) {
-          // node does not appear as start or end cand, so the number of
-          // sink edges for this node is 0
-
-        } else {
-          if (cands[e->getTo()].count(n)) {
-            int ndColTo = lp->getVarByName(getStatPosVar(n, e->getTo()));
-            if (ndColTo > -1) lp->addColToRow(row, ndColTo, -1);
-          }
+      } else {
+        if (cands[e->getTo()].count(n)) {
+          int ndColTo = idx->statPosCol(n, e->getTo());
+          if (ndColTo > -1) m.addColToRow(row, ndColTo, -1);
+        }
 
-          if (cands[e->getFrom()].count(n)) {
-            int ndColFr = lp->getVarByName(getStatPosVar(n, e->getFrom()));
-            if (ndColFr > -1) lp->addColToRow(row, ndColFr, -1);
-          }
-        };
+        if (cands[e->getFrom()].count(n)) {
+          int ndColFr = idx->statPosCol(n, e->getFrom());
+          if (ndColFr > -1) m.addColToRow(row, ndColFr, -1);
+        }
+      };
 
-        for (size_t p = 0; p < gg->maxDeg(); p++) {
-          auto portNd = n->pl().getPort(p);
-          if (!portNd) continue;
-          auto varSinkTo = getEdgUseVar(gg->getEdg(portNd, n), e);
-          auto varSinkFr = getEdgUseVar(gg->getEdg(n, portNd), e);
+      for (size_t p = 0; p < gg->maxDeg(); p++) {
+        auto portNd = n->pl().getPort(p);
+        if (!portNd) continue;
 
-          int ndColTo = lp->getVarByName(varSinkTo);
-          if (ndColTo > -1) lp->addColToRow(row, ndColTo, 1);
+        int ndColTo = idx->edgUseCol(gg->getEdg(portNd, n), e);
+        if (ndColTo > -1) m.addColToRow(row, ndColTo, 1);
 
-          int ndColFr = lp->getVarByName(varSinkFr);
-          if (ndColFr > -1) lp->addColToRow(row, ndColFr, 1);
-        }
+        int ndColFr = idx->edgUseCol(gg->getEdg(n, portNd), e);
+        if (ndColFr > -1) m.addColToRow(row, ndColFr, 1);
       }
     }
   }
 
   // a grid node can either be an activated sink, or a single pass through
   // edge is used
-  for (GridNode* n : gg->getNds()) {
+  for (GridNode* n : grNds) {
     if (!n->pl().isSink()) continue;
 
-    std::stringstream constName;
-    constName << "iu(" << n->pl().getId() << ")";
-
-    int row = lp->addRow(constName.str(), 1, shared::optim::UP);
+    int row = m.addRow(1, shared::optim::UP);
+    m.setRowNames(row, 1, [n](size_t) {
+      std::stringstream constName;
+      constName << "iu(" << n->pl().getId() << ")";
+      return constName.str();
+    });
 
     // a meta grid node can either be a sink for a single input node, or
     // a pass-through
 
-    for (auto nd : cg.getNds()) {
-      int ndcolto = lp->getVarByName(getStatPosVar(n, nd).c_str());
-      if (ndcolto > -1) lp->addColToRow(row, ndcolto, 1);
+    for (auto nd : combNds) {
+      int ndcolto = idx->statPosCol(n, nd);
+      if (ndcolto > -1) m.addColToRow(row, ndcolto, 1);
     }
 
     // go over all ports
@@ -365,75 +909,95 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
         if (!to || from == to) continue;
 
         auto innerE = gg->getEdg(from, to);
-        for (auto nd : cg.getNds()) {
-          for (auto edg : nd->getAdjList()) {
-            if (edg->getFrom() != nd) continue;
-
-            int edgCol = lp->getVarByName(getEdgUseVar(innerE, edg));
-            if (edgCol < 0) continue;
-            lp->addColToRow(row, edgCol, 1);
-          }
+        for (auto edg : combEdgs) {
+          int edgCol = idx->edgUseCol(innerE, edg);
+          if (edgCol < 0) continue;
+          m.addColToRow(row, edgCol, 1);
         }
       }
     }
   }
 
-  lp->update();
-
   // dont allow crossing edges
-  size_t rowId = 0;
-  for (auto edgPair : gg->getCrossEdgPairs()) {
+  CrossEdgPairs corrPairs;
+  if (corr) {
+    auto inCorr = [corr](const GridEdge* e) {
+      return corr->count(e->getFrom()) && corr->count(e->getTo());
+    };
+    for (const auto& cp : gg->getCrossEdgPairs()) {
+      if (inCorr(cp.first.first) || inCorr(cp.second.first)) {
+        corrPairs.push_back(cp);
+      }
+    }
+  }
+  const auto& crossPairs =
+      win ? win->crossPairs : corr ? corrPairs : gg->getCrossEdgPairs();
+  int firstCrossRow = m.addRows(crossPairs.size(), 1, shared::optim::UP);
+  m.setRowNames(firstCrossRow, crossPairs.size(), [](size_t i) {
     std::stringstream constName;
-    constName << "nc(" << rowId << ")";
-    rowId++;
+    constName << "nc(" << i << ")";
+    return constName.str();
+  });
 
-    int row = lp->addRow(constName.str(), 1, shared::optim::UP);
+  int row = firstCrossRow;
+  for (auto edgPair : crossPairs) {
+    for (auto edg : combEdgs) {
+      int col = idx->edgUseCol(edgPair.first.first, edg);
+      if (col > -1) m.addColToRow(row, col, 1);
 
-    for (auto nd : cg.getNds()) {
-      for (auto edg : nd->getAdjList()) {
-        if (edg->getFrom() != nd) continue;
-
-        int col = lp->getVarByName(getEdgUseVar(edgPair.first.first, edg));
-        if (col > -1) lp->addColToRow(row, col, 1);
+      col = idx->edgUseCol(edgPair.first.second, edg);
+      if (col > -1) m.addColToRow(row, col, 1);
 
-        col = lp->getVarByName(getEdgUseVar(edgPair.first.second, edg));
-        if (col > -1) lp->addColToRow(row, col, 1);
+      col = idx->edgUseCol(edgPair.second.first, edg);
+      if (col > -1) m.addColToRow(row, col, 1);
 
-        col = lp->getVarByName(getEdgUseVar(edgPair.second.first, edg));
-        if (col > -1) lp->addColToRow(row, col, 1);
-
-        col = lp->getVarByName(getEdgUseVar(edgPair.second.second, edg));
-        if (col > -1) lp->addColToRow(row, col, 1);
-      }
+      col = idx->edgUseCol(edgPair.second.second, edg);
+      if (col > -1) m.addColToRow(row, col, 1);
     }
+    row++;
   }
 
-  lp->update();
-
   // for each input node N, define a var x_dirNE which tells the direction of
   // E at N
-  for (auto nd : cg.getNds()) {
+  std::map<std::pair<const CombNode*, const CombEdge*>, int> dirCols;
+  for (auto nd : combNds) {
     if (nd->getDeg() < 2) continue;  // we don't need this for deg 1 nodes
     for (auto edg : nd->getAdjList()) {
-      std::stringstream dirName;
-      dirName << "d(" << nd << "," << edg << ")";
-      int col =
-          lp->addCol(dirName.str(), shared::optim::INT, 0, 0, gg->maxDeg() - 1);
+      if (win && !win->edgSet.count(edg)) {
+        // edge outside the window, its direction is fixed
+        int fixedDir = win->fixedDirs.find({nd, edg})->second;
+        int col = m.addCol(shared::optim::INT, 0, fixedDir, fixedDir);
+        m.setColNames(col, 1, [nd, edg](size_t) {
+          std::stringstream dirName;
+          dirName << "d(" << nd << "," << edg << ")";
+          return dirName.str();
+        });
+        dirCols[{nd, edg}] = col;
+        continue;
+      }
 
-      std::stringstream constName;
-      constName << "dc(" << nd << "," << edg << ")";
+      int col = m.addCol(shared::optim::INT, 0, 0, gg->maxDeg() - 1);
+      m.setColNames(col, 1, [nd, edg](size_t) {
+        std::stringstream dirName;
+        dirName << "d(" << nd << "," << edg << ")";
+        return dirName.str();
+      });
+      dirCols[{nd, edg}] = col;
 
-      int row = lp->addRow(constName.str(), 0, shared::optim::FIX);
+      int row = m.addRow(0, shared::optim::FIX);
+      m.setRowNames(row, 1, [nd, edg](size_t) {
+        std::stringstream constName;
+        constName << "dc(" << nd << "," << edg << ")";
+        return constName.str();
+      });
 
-      lp->addColToRow(row, col, -1);
+      m.addColToRow(row, col, -1);
 
-      for (GridNode* n : gg->getNds()) {
+      for (GridNode* n : grNds) {
         if (!n->pl().isSink()) continue;
-
         // check if this grid node is used as a candidate for comb node
         // if not, we don't have to add the constraints
-        int ndColFrom = lp->getVarByName(getStatPosVar(n, nd));
-        if (ndColFrom == -1) continue;
+        if (idx->statPosCol(n, nd) == -1) continue;
 
         if (edg->getFrom() == nd) {
           // the 0 can be skipped here
@@ -441,8 +1005,8 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
             auto portNd = n->pl().getPort(i);
             if (!portNd) continue;
             auto e = gg->getEdg(n, portNd);
-            int col = lp->getVarByName(getEdgUseVar(e, edg));
-            if (col > -1) lp->addColToRow(row, col, i);
+            int col = idx->edgUseCol(e, edg);
+            if (col > -1) m.addColToRow(row, col, i);
           }
         } else {
           // the 0 can be skipped here
@@ -450,38 +1014,40 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
             auto portNd = n->pl().getPort(i);
             if (!portNd) continue;
             auto e = gg->getEdg(portNd, n);
-            int col = lp->getVarByName(getEdgUseVar(e, edg));
-            if (col > -1) lp->addColToRow(row, col, i);
+            int col = idx->edgUseCol(e, edg);
+            if (col > -1) m.addColToRow(row, col, i);
           }
         }
       }
     }
   }
 
-  lp->update();
-
   // for each input node N, make sure that the circular ordering of the final
   // drawing matches the input ordering
   int M = gg->maxDeg();
-  for (auto nd : cg.getNds()) {
+  for (auto nd : combNds) {
     // for degree < 3, the circular ordering cannot be violated
     if (nd->getDeg() < 3) continue;
 
-    std::stringstream vulnConstName;
-    vulnConstName << "vc(" << nd << ")";
     // an upper bound would also work here, at most one
     // of the vuln vars may be 1
-
-    int vulnRow = lp->addRow(vulnConstName.str(), 1, shared::optim::FIX);
-
-    for (size_t i = 0; i < nd->getDeg(); i++) {
+    int vulnRow = m.addRow(1, shared::optim::FIX);
+    m.setRowNames(vulnRow, 1, [nd](size_t) {
+      std::stringstream vulnConstName;
+      vulnConstName << "vc(" << nd << ")";
+      return vulnConstName.str();
+    });
+
+    int firstVuln = m.addCols(nd->getDeg(), shared::optim::BIN, 0);
+    m.setColNames(firstVuln, nd->getDeg(), [nd](size_t i) {
       std::stringstream n;
       n << "vuln(" << nd << "," << i << ")";
-      int col = lp->addCol(n.str(), shared::optim::BIN, 0);
-      lp->addColToRow(vulnRow, col, 1);
-    }
+      return n.str();
+    });
 
-    lp->update();
+    for (size_t i = 0; i < nd->getDeg(); i++) {
+      m.addColToRow(vulnRow, firstVuln + i, 1);
+    }
 
     auto order = nd->pl().getEdgeOrdering().getOrderedSet();
     assert(order.size() > 2);
@@ -496,38 +1062,32 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
 
       assert(edgA != edgB);
 
-      std::stringstream colNameA;
-      colNameA << "d(" << nd << "," << edgA << ")";
-      int colA = lp->getVarByName(colNameA.str());
-      assert(colA > -1);
+      assert(dirCols.count({nd, edgA}));
+      int colA = dirCols[{nd, edgA}];
 
-      std::stringstream colNameB;
-      colNameB << "d(" << nd << "," << edgB << ")";
-      int colB = lp->getVarByName(colNameB.str());
-      assert(colB > -1);
+      assert(dirCols.count({nd, edgB}));
+      int colB = dirCols[{nd, edgB}];
 
-      std::stringstream constName;
-      constName << "oc(" << nd << "," << i << ")";
-      int row = lp->addRow(constName.str(), 1, shared::optim::LO);
+      int row = m.addRow(1, shared::optim::LO);
+      m.setRowNames(row, 1, [nd, i](size_t) {
+        std::stringstream constName;
+        constName << "oc(" << nd << "," << i << ")";
+        return constName.str();
+      });
 
-      std::stringstream vulnColName;
-      vulnColName << "vuln(" << nd << "," << i << ")";
-      int vulnCol = lp->getVarByName(vulnColName.str());
-      assert(vulnCol > -1);
+      int vulnCol = firstVuln + i;
 
-      lp->addColToRow(row, colB, 1);
-      lp->addColToRow(row, colA, -1);
-      lp->addColToRow(row, vulnCol, M);
+      m.addColToRow(row, colB, 1);
+      m.addColToRow(row, colA, -1);
+      m.addColToRow(row, vulnCol, M);
     }
   }
 
-  lp->update();
-
   std::vector<double> pens = gg->getCosts();
 
   // for each adjacent edge pair, add variables telling the accuteness of the
   // angle between them
-  for (auto nd : cg.getNds()) {
+  for (auto nd : combNds) {
     for (size_t i = 0; i < nd->getAdjList().size(); i++) {
       auto edgA = nd->getAdjList()[i];
       for (size_t j = i + 1; j < nd->getAdjList().size(); j++) {
@@ -548,76 +1108,349 @@ ILPSolver* ILPGridOptimizer::createProblem(BaseGraph* gg, const CombGraph& cg,
 
         if (!sharedLines) continue;
 
-        std::stringstream negVar;
-        negVar << "negdist(" << edgA << "," << edgB << ")";
+        int colNeg = m.addCol(shared::optim::BIN, 0);
+        m.setColNames(colNeg, 1, [edgA, edgB](size_t) {
+          std::stringstream negVar;
+          negVar << "negdist(" << edgA << "," << edgB << ")";
+          return negVar.str();
+        });
+
+        int row1 = m.addRow(0, shared::optim::LO);
+        int row2 = m.addRow(gg->maxDeg() - 1, shared::optim::UP);
+        m.setRowNames(row1, 2, [edgA, edgB](size_t i) {
+          std::stringstream constName;
+          constName << "nc(" << edgA << "," << edgB << ")"
+                    << (i == 0 ? "lo" : "up");
+          return constName.str();
+        });
+
+        assert(dirCols.count({nd, edgA}));
+        int colA = dirCols[{nd, edgA}];
+        m.addColToRow(row1, colA, 1);
+        m.addColToRow(row2, colA, 1);
+
+        assert(dirCols.count({nd, edgB}));
+        int colB = dirCols[{nd, edgB}];
+        m.addColToRow(row1, colB, -1);
+        m.addColToRow(row2, colB, -1);
+
+        m.addColToRow(row1, colNeg, gg->maxDeg());
+        m.addColToRow(row2, colNeg, gg->maxDeg());
+
+        int rowAng = m.addRow(0, shared::optim::FIX);
+        m.setRowNames(rowAng, 1, [edgA, edgB](size_t) {
+          std::stringstream angConst;
+          angConst << "ac(" << edgA << "," << edgB << ")";
+          return angConst.str();
+        });
+
+        m.addColToRow(rowAng, colA, 1);
+        m.addColToRow(rowAng, colB, -1);
+        m.addColToRow(rowAng, colNeg, gg->maxDeg());
+
+        int rowSum = m.addRow(1, shared::optim::UP);
+        m.setRowNames(rowSum, 1, [edgA, edgB](size_t) {
+          std::stringstream sumConst;
+          sumConst << "asc(" << edgA << "," << edgB << ")";
+          return sumConst.str();
+        });
 
-        int colNeg = lp->addCol(negVar.str(), shared::optim::BIN, 0);
+        int N = gg->maxDeg() - 1;
+        int M = pens.size();
 
-        std::stringstream constName;
-        constName << "nc(" << edgA << "," << edgB << ")";
+        for (int k = 0; k < N; k++) {
+          size_t pp = pens.size() - 1 - k;
+          if (k >= M) pp = k + 1 - pens.size();
 
-        int row1 = lp->addRow(constName.str() + "lo", 0, shared::optim::LO);
-        int row2 = lp->addRow(constName.str() + "up", gg->maxDeg() - 1,
-                              shared::optim::UP);
+          // TODO: maybe multiply per shared lines - but this actually
+          // makes the drawings look worse.
+          int col = m.addCol(shared::optim::BIN, pens[pp]);
+          skel->angCols.push_back({col, pp});
+          m.setColNames(col, 1, [edgA, edgB, pp, prime = k >= M](size_t) {
+            std::stringstream var;
+            var << "d" << pp << (prime ? "'" : "") << "(" << edgA << ","
+                << edgB << ")";
+            return var.str();
+          });
+
+          m.addColToRow(rowAng, col, -(k + 1));
+          m.addColToRow(rowSum, col, 1);
+        }
+      }
+    }
+  }
 
-        std::stringstream dirNameA;
-        dirNameA << "d(" << nd << "," << edgA << ")";
-        std::stringstream dirNameB;
-        dirNameB << "d(" << nd << "," << edgB << ")";
+}
 
-        int colA = lp->getVarByName(dirNameA.str());
-        assert(colA > -1);
-        lp->addColToRow(row1, colA, 1);
-        lp->addColToRow(row2, colA, 1);
+// _____________________________________________________________________________
+double ILPGridOptimizer::edgUseCoef(const GridEdge* e, const CombEdge* edg,
+                                    const GeoPensMap* geoPensMap) const {
+  double coef;
+  if (geoPensMap && !e->pl().isSecondary()) {
+    // add geo pen
+    const auto& thisMap = geoPensMap->find(edg)->second;
+    auto pen = thisMap.find(e->pl().getId());
+    if (pen) coef = e->pl().cost() + *pen;
+
+    // if no geopen was present for grid edge, we assume SOFT_INF
+    // penalty
+    coef = e->pl().cost() + octi::basegraph::SOFT_INF;
+  } else {
+    coef = e->pl().cost();
+  }
 
-        int colB = lp->getVarByName(dirNameB.str());
-        assert(colB > -1);
-        lp->addColToRow(row1, colB, -1);
-        lp->addColToRow(row2, colB, -1);
+  return coef;
+}
 
-        lp->addColToRow(row1, colNeg, gg->maxDeg());
-        lp->addColToRow(row2, colNeg, gg->maxDeg());
+// _____________________________________________________________________________
+void ILPGridOptimizer::setObjective(BaseGraph* gg, const GeoPensMap* geoPensMap,
+                                    Skeleton* skel) const {
+  for (const auto& edg : skel->idx.edgUse) {
+    for (const auto& col : edg.second) {
+      skel->m.setObjCoef(col.second,
+                         edgUseCoef(col.first, edg.first, geoPensMap));
+    }
+  }
 
-        std::stringstream angConst;
-        angConst << "ac(" << edgA << "," << edgB << ")";
-        int rowAng = lp->addRow(angConst.str(), 0, shared::optim::FIX);
+  for (const auto& nd : skel->idx.statPos) {
+    for (const auto& col : nd.second) {
+      skel->m.setObjCoef(col.second, gg->ndMovePen(nd.first, col.first));
+    }
+  }
 
-        lp->addColToRow(rowAng, colA, 1);
-        lp->addColToRow(rowAng, colB, -1);
-        lp->addColToRow(rowAng, colNeg, gg->maxDeg());
+  std::vector<double> pens = gg->getCosts();
+  for (const auto& col : skel->angCols) {
+    skel->m.setObjCoef(col.first, pens[col.second]);
+  }
+}
 
-        std::stringstream sumConst;
-        sumConst << "asc(" << edgA << "," << edgB << ")";
+// _____________________________________________________________________________
+std::string ILPGridOptimizer::getSkeletonPath(
+    const BaseGraph* gg, const CombGraph& cg, double maxGrDist,
+    const std::string& dir, std::vector<CombNode*>* nds,
+    std::vector<CombEdge*>* edgs) const {
+  // comb nodes are identified by their position
+  nds->assign(cg.getNds().begin(), cg.getNds().end());
+  auto posLess = [](const CombNode* a, const CombNode* b) {
+    const auto& pa = *a->pl().getGeom();
+    const auto& pb = *b->pl().getGeom();
+    if (pa.getX() != pb.getX()) return pa.getX() < pb.getX();
+    return pa.getY() < pb.getY();
+  };
+  std::sort(nds->begin(), nds->end(), posLess);
+
+  std::unordered_map<const CombNode*, size_t> ndIdx;
+  for (size_t i = 0; i < nds->size(); i++) {
+    if (i && !posLess((*nds)[i - 1], (*nds)[i])) return "";
+    ndIdx[(*nds)[i]] = i;
+  }
 
-        int rowSum = lp->addRow(sumConst.str(), 1, shared::optim::UP);
+  edgs->clear();
+  for (auto nd : *nds) {
+    size_t first = edgs->size();
+    for (auto edg : nd->getAdjList()) {
+      if (edg->getFrom() == nd) edgs->push_back(edg);
+    }
+    std::sort(edgs->begin() + first, edgs->end(),
+              [&ndIdx](const CombEdge* a, const CombEdge* b) {
+                return ndIdx[a->getTo()] < ndIdx[b->getTo()];
+              });
+  }
 
-        int N = gg->maxDeg() - 1;
-        int M = pens.size();
+  std::unordered_map<const CombEdge*, size_t> edgIdx;
+  for (size_t i = 0; i < edgs->size(); i++) edgIdx[(*edgs)[i]] = i;
+
+  uint64_t h = FNV_OFFSET;
+  hashVal(SKEL_VERSION, &h);
+  hashVal(maxGrDist, &h);
+  hashVal(gg->getCellSize(), &h);
+  hashVal(gg->maxDeg(), &h);
+
+  std::vector<const GridNode*> grNds(gg->getNds().begin(), gg->getNds().end());
+  std::sort(grNds.begin(), grNds.end(),
+            [](const GridNode* a, const GridNode* b) {
+              return a->pl().getId() < b->pl().getId();
+            });
+
+  for (auto n : grNds) {
+    hashVal(n->pl().getId(), &h);
+    hashVal(n->pl().getGeom()->getX(), &h);
+    hashVal(n->pl().getGeom()->getY(), &h);
+    hashVal(n->pl().isSink(), &h);
+    if (n->pl().isSink()) {
+      for (size_t p = 0; p < gg->maxDeg(); p++) {
+        auto port = n->pl().getPort(p);
+        hashVal(port ? port->pl().getId() : 0, &h);
+      }
+    }
+    for (auto e : n->getAdjListOut()) {
+      hashVal(e->getTo()->pl().getId(), &h);
+      hashVal(e->pl().isSecondary(), &h);
+      hashVal(e->pl().cost() >= basegraph::SOFT_INF, &h);
+    }
+  }
 
-        for (int k = 0; k < N; k++) {
-          std::stringstream var;
-          size_t pp = pens.size() - 1 - k;
-          if (k >= M) {
-            pp = k + 1 - pens.size();
-            var << "d" << pp << "'(" << edgA << "," << edgB << ")";
-          } else {
-            var << "d" << pp << "(" << edgA << "," << edgB << ")";
-          }
+  for (auto nd : *nds) {
+    hashVal(nd->pl().getGeom()->getX(), &h);
+    hashVal(nd->pl().getGeom()->getY(), &h);
+    hashVal(nd->getDeg(), &h);
 
-          // TODO: maybe multiply per shared lines - but this actually
-          // makes the drawings look worse.
-          int col = lp->addCol(var.str(), shared::optim::BIN, pens[pp]);
+    for (const auto& o : nd->pl().getEdgeOrdering().getOrderedSet()) {
+      hashVal(edgIdx[o.first], &h);
+    }
 
-          lp->addColToRow(rowAng, col, -(k + 1));
-          lp->addColToRow(rowSum, col, 1);
+    const auto& adj = nd->getAdjList();
+    for (size_t i = 0; i < adj.size(); i++) {
+      hashVal(edgIdx[adj[i]], &h);
+      for (size_t j = i + 1; j < adj.size(); j++) {
+        bool hasShared = false;
+        for (auto lo : adj[i]->pl().getChilds().front()->pl().getLines()) {
+          if (adj[j]->pl().getChilds().front()->pl().hasLine(lo.line)) {
+            hasShared = true;
+            break;
+          }
         }
+        hashVal(hasShared, &h);
       }
     }
   }
 
-  lp->update();
+  for (auto edg : *edgs) {
+    hashVal(ndIdx[edg->getFrom()], &h);
+    hashVal(ndIdx[edg->getTo()], &h);
+  }
 
-  return lp;
+  std::stringstream path;
+  path << dir << "/" << std::hex << std::setw(16) << std::setfill('0') << h
+       << ".ilpskel";
+  return path.str();
+}
+
+// _____________________________________________________________________________
+bool ILPGridOptimizer::readSkeleton(const std::string& path, BaseGraph* gg,
+                                    const std::vector<CombNode*>& nds,
+                                    const std::vector<CombEdge*>& edgs,
+                                    Skeleton* skel) const {
+  std::ifstream fs(path, std::ios::binary);
+  if (!fs.good()) return false;
+
+  uint64_t version = 0;
+  if (!readVal(&fs, &version) || version != SKEL_VERSION) return false;
+  if (!skel->m.read(&fs)) return false;
+
+  int numCols = skel->m.getNumCols();
+  size_t numGrNds = gg->getNds().size();
+
+  uint64_t n = 0;
+  if (!readVal(&fs, &n)) return false;
+  for (uint64_t i = 0; i < n; i++) {
+    uint64_t nd, grNd;
+    int col;
+    if (!readVal(&fs, &nd) || !readVal(&fs, &grNd) || !readVal(&fs, &col)) {
+      return false;
+    }
+    if (nd >= nds.size() || grNd >= numGrNds || col < 0 || col >= numCols) {
+      return false;
+    }
+    skel->idx.statPos[nds[nd]][gg->getGrNdById(grNd)] = col;
+  }
+
+  if (!readVal(&fs, &n)) return false;
+  for (uint64_t i = 0; i < n; i++) {
+    uint64_t edg, fr, to;
+    int col;
+    if (!readVal(&fs, &edg) || !readVal(&fs, &fr) || !readVal(&fs, &to) ||
+        !readVal(&fs, &col)) {
+      return false;
+    }
+    if (edg >= edgs.size() || fr >= numGrNds || to >= numGrNds || col < 0 ||
+        col >= numCols) {
+      return false;
+    }
+    auto e = gg->getGrEdgById({fr, to});
+    if (!e) return false;
+    skel->idx.edgUse[edgs[edg]][e] = col;
+  }
+
+  if (!readVal(&fs, &n)) return false;
+  for (uint64_t i = 0; i < n; i++) {
+    int col;
+    uint64_t pen;
+    if (!readVal(&fs, &col) || !readVal(&fs, &pen)) return false;
+    if (col < 0 || col >= numCols || pen >= gg->getCosts().size()) {
+      return false;
+    }
+    skel->angCols.push_back({col, pen});
+  }
+
+  return true;
+}
+
+// _____________________________________________________________________________
+void ILPGridOptimizer::writeSkeleton(const std::string& path,
+                                     const std::vector<CombNode*>& nds,
+                                     const std::vector<CombEdge*>& edgs,
+                                     const Skeleton& skel) const {
+  std::unordered_map<const CombNode*, uint64_t> ndIdx;
+  for (size_t i = 0; i < nds.size(); i++) ndIdx[nds[i]] = i;
+  std::unordered_map<const CombEdge*, uint64_t> edgIdx;
+  for (size_t i = 0; i < edgs.size(); i++) edgIdx[edgs[i]] = i;
+
+  std::string dir = path.substr(0, path.find_last_of('/'));
+  mkdir(dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+
+  // write to a temporary file first, so concurrent readers never see
+  // partial entries
+  std::stringstream tmpPath;
+  tmpPath << path << ".tmp" << getpid() << "-" << this;
+
+  {
+    std::ofstream fs(tmpPath.str(), std::ios::binary);
+
+    writeVal(&fs, SKEL_VERSION);
+    skel.m.write(&fs);
+
+    uint64_t n = 0;
+    for (const auto& nd : skel.idx.statPos) n += nd.second.size();
+    writeVal(&fs, n);
+    for (const auto& nd : skel.idx.statPos) {
+      for (const auto& col : nd.second) {
+        writeVal(&fs, ndIdx[nd.first]);
+        writeVal(&fs, static_cast<uint64_t>(col.first->pl().getId()));
+        writeVal(&fs, col.second);
+      }
+    }
+
+    n = 0;
+    for (const auto& edg : skel.idx.edgUse) n += edg.second.size();
+    writeVal(&fs, n);
+    for (const auto& edg : skel.idx.edgUse) {
+      for (const auto& col : edg.second) {
+        uint64_t fr = col.first->getFrom()->pl().getId();
+        uint64_t to = col.first->getTo()->pl().getId();
+        writeVal(&fs, edgIdx[edg.first]);
+        writeVal(&fs, fr);
+        writeVal(&fs, to);
+        writeVal(&fs, col.second);
+      }
+    }
+
+    writeVal(&fs, static_cast<uint64_t>(skel.angCols.size()));
+    for (const auto& col : skel.angCols) {
+      writeVal(&fs, col.first);
+      writeVal(&fs, static_cast<uint64_t>(col.second));
+    }
+
+    if (!fs.good()) {
+      LOGTO(WARN, std::cerr) << "Could not write ILP skeleton " << path;
+      std::remove(tmpPath.str().c_str());
+      return;
+    }
+  }
+
+  if (std::rename(tmpPath.str().c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.str().c_str());
+  }
 }
 
 // _____________________________________________________________________________
@@ -640,95 +1473,115 @@ std::string ILPGridOptimizer::getStatPosVar(const GridNode* n,
 }
 
 // _____________________________________________________________________________
-void ILPGridOptimizer::extractSolution(ILPSolver* lp, BaseGraph* gg,
-                                       const CombGraph& cg,
-                                       combgraph::Drawing* d) const {
+void ILPGridOptimizer::extractSolution(ILPSolver* lp, const VarIdx& idx,
+                                       BaseGraph* gg, const CombGraph& cg,
+                                       combgraph::Drawing* d,
+                                       const Window* win) const {
   std::map<const CombNode*, const GridNode*> gridNds;
   std::map<const CombEdge*, std::set<const GridEdge*>> gridEdgs;
 
-  // write solution to grid graph
-  for (GridNode* n : gg->getNds()) {
-    for (GridEdge* e : n->getAdjList()) {
-      if (e->getFrom() != n) continue;
-
-      for (auto nd : cg.getNds()) {
-        for (auto edg : nd->getAdjList()) {
-          if (edg->getFrom() != nd) continue;
-          auto varName = getEdgUseVar(e, edg);
-
-          int i = lp->getVarByName(varName);
-          if (i > -1) {
-            double val = lp->getVarVal(i);
-            if (val > 0.5) {
-              gg->addResEdg(e, edg);
-              gridEdgs[edg].insert(e);
-            }
-          }
-        }
+  std::vector<CombNode*> combNds;
+  std::vector<CombEdge*> combEdgs;
+
+  if (win) {
+    combNds = win->nds;
+    combEdgs = win->edgs;
+  } else {
+    for (auto nd : cg.getNds()) {
+      combNds.push_back(nd);
+      for (auto edg : nd->getAdjList()) {
+        if (edg->getFrom() == nd) combEdgs.push_back(edg);
       }
     }
   }
 
-  for (GridNode* n : gg->getNds()) {
-    if (!n->pl().isSink()) continue;
-    for (auto nd : cg.getNds()) {
-      auto varName = getStatPosVar(n, nd);
-
-      int i = lp->getVarByName(varName);
-      if (i > -1) {
-        double val = lp->getVarVal(i);
-        if (val > 0.5) {
-          gridNds[nd] = n;
-        }
+  // write solution to grid graph
+  for (auto edg : combEdgs) {
+    auto i = idx.edgUse.find(edg);
+    if (i == idx.edgUse.end()) continue;
+    for (const auto& col : i->second) {
+      if (lp->getVarVal(col.second) > 0.5) {
+        // for windows, the residents are written after the last window
+        if (!win) gg->addResEdg(const_cast<GridEdge*>(col.first), edg);
+        gridEdgs[edg].insert(col.first);
       }
     }
   }
 
-  // draw solution
-  for (auto nd : cg.getNds()) {
-    for (auto edg : nd->getAdjList()) {
-      if (edg->getFrom() != nd) continue;
+  for (auto nd : combNds) {
+    auto i = idx.statPos.find(nd);
+    if (i == idx.statPos.end()) continue;
+    for (const auto& col : i->second) {
+      if (lp->getVarVal(col.second) > 0.5) gridNds[nd] = col.first;
+    }
+  }
 
-      std::vector<GridEdge*> edges(gridEdgs[edg].size());
+  // free window nodes which already got their move penalty
+  std::set<const CombNode*> reached;
 
-      assert(gridNds.count(edg->getFrom()));
-      assert(gridNds.count(edg->getTo()));
+  // draw solution
+  for (auto edg : combEdgs) {
+    std::vector<GridEdge*> edges(gridEdgs[edg].size());
 
-      // get the start and end grid nodes
-      auto grStart = gridNds[edg->getFrom()];
-      auto grEnd = gridNds[edg->getTo()];
+    assert(gridNds.count(edg->getFrom()));
+    assert(gridNds.count(edg->getTo()));
 
-      assert(grStart);
-      assert(grEnd);
+    // get the start and end grid nodes
+    auto grStart = gridNds[edg->getFrom()];
+    auto grEnd = gridNds[edg->getTo()];
 
-      auto curNode = grStart;
-      GridEdge* last = 0;
+    assert(grStart);
+    assert(grEnd);
 
-      size_t i = 0;
+    auto curNode = grStart;
+    GridEdge* last = 0;
 
-      while (curNode != grEnd) {
-        for (auto adj : curNode->getAdjList()) {
-          if (adj != last && gridEdgs[edg].count(adj)) {
-            last = adj;
-            i++;
-            assert(edges.size() >= i);
-            edges[edges.size() - i] = adj;
-            curNode = adj->getOtherNd(curNode);
-            break;
-          }
+    size_t i = 0;
+
+    while (curNode != grEnd) {
+      for (auto adj : curNode->getAdjList()) {
+        if (adj != last && gridEdgs[edg].count(adj)) {
+          last = adj;
+          i++;
+          assert(edges.size() >= i);
+          edges[edges.size() - i] = adj;
+          curNode = adj->getOtherNd(curNode);
+          break;
         }
       }
+    }
 
-      assert(i == edges.size());
-
+    assert(i == edges.size());
+
+    if (win) {
+      // sink edges are closed outside of the windows, open them for the
+      // drawing, the first edge reaching a free node carries its move
+      // penalty
+      for (auto nd : {edg->getFrom(), edg->getTo()}) {
+        auto n = const_cast<GridNode*>(gridNds[nd]);
+        double cost = 0;
+        if (win->free.count(nd) && reached.insert(nd).second) {
+          cost = gg->ndMovePen(nd, n);
+        }
+        gg->openSinkFr(n, cost);
+        gg->openSinkTo(n, cost);
+      }
+    } else {
       for (size_t i = 0; i < edges.size(); i++) {
         // TODO: delete
         if (!edges[i]->pl().isSecondary()) {
           assert(gg->getResEdgsDirInd(edges[i]).size());
         }
       }
+    }
+
+    d->draw(edg, edges, false);
 
-      d->draw(edg, edges, false);
+    if (win) {
+      for (auto nd : {edg->getFrom(), edg->getTo()}) {
+        gg->closeSinkFr(const_cast<GridNode*>(gridNds[nd]));
+        gg->closeSinkTo(const_cast<GridNode*>(gridNds[nd]));
+      }
     }
   }
 }
@@ -744,10 +1597,9 @@ size_t ILPGridOptimizer::nonInfDeg(const GridNode* g) const {
 }
 
 // _____________________________________________________________________________
-StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
-                                                const CombGraph& cg,
-                                                double maxGrDist) const {
-  StarterSol sol;
+ILPGridOptimizer::FeasibleSol ILPGridOptimizer::extractFeasibleSol(
+    Drawing* d, BaseGraph* gg, const CombGraph& cg, double maxGrDist) const {
+  FeasibleSol sol;
 
   for (auto nd : cg.getNds()) {
     if (nd->getDeg() == 0) continue;
@@ -761,9 +1613,8 @@ StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
       double maxDis = gg->getCellSize() * maxGrDist;
       if (gridD >= maxDis) continue;
 
-      auto varName = getStatPosVar(gnd, nd);
       if (gnd == settled) {
-        sol[varName] = 1;
+        sol.statPos[{gnd, nd}] = 1;
 
         // if settled, all bend edges are unused
         for (size_t p = 0; p < gg->maxDeg(); p++) {
@@ -773,13 +1624,12 @@ StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
             if (!bendEdg->pl().isSecondary()) continue;
             for (auto cEdg : nd->getAdjList()) {
               if (cEdg->getFrom() != nd) continue;
-              auto varName = getEdgUseVar(bendEdg, cEdg);
-              sol[varName] = 0;
+              sol.edgUse[{bendEdg, cEdg}] = 0;
             }
           }
         }
       } else {
-        sol[varName] = 0;
+        sol.statPos[{gnd, nd}] = 0;
 
         // if not settled, all sink edges are unused
         // for all input edges
@@ -787,8 +1637,7 @@ StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
           assert(sinkEdg->pl().isSecondary());
           for (auto cEdg : nd->getAdjList()) {
             if (cEdg->getFrom() != nd) continue;
-            auto varName = getEdgUseVar(sinkEdg, cEdg);
-            sol[varName] = 0;
+            sol.edgUse[{sinkEdg, cEdg}] = 0;
           }
         }
       }
@@ -803,8 +1652,7 @@ StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
       for (auto cNd : cg.getNds()) {
         for (auto cEdg : cNd->getAdjList()) {
           if (cEdg->getFrom() != cNd) continue;
-          auto varName = getEdgUseVar(grEdg, cEdg);
-          sol[varName] = 0;
+          sol.edgUse[{grEdg, cEdg}] = 0;
         }
       }
     }
@@ -816,8 +1664,7 @@ StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
     const auto& grEdgList = a.second;
     for (auto xy : grEdgList) {
       auto grEdg = gg->getGrEdgById(xy);
-      auto varName = getEdgUseVar(grEdg, cEdg);
-      sol[varName] = 1;
+      sol.edgUse[{grEdg, cEdg}] = 1;
     }
   }
 
@@ -825,3 +1672,62 @@ StarterSol ILPGridOptimizer::extractFeasibleSol(Drawing* d, BaseGraph* gg,
   // typically be filled by the solver using the information given above
   return sol;
 }
+
+// _____________________________________________________________________________
+IdxStarterSol ILPGridOptimizer::getStarter(const FeasibleSol& sol,
+                                           const VarIdx& idx) const {
+  IdxStarterSol ret;
+  ret.reserve(sol.statPos.size() + sol.edgUse.size());
+
+  // variables which were not created for the problem are skipped
+  for (const auto& v : sol.statPos) {
+    int col = idx.statPosCol(v.first.first, v.first.second);
+    if (col > -1) ret.push_back({col, v.second});
+  }
+
+  for (const auto& v : sol.edgUse) {
+    int col = idx.edgUseCol(v.first.first, v.first.second);
+    if (col > -1) ret.push_back({col, v.second});
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+IdxStarterSol ILPGridOptimizer::getStarter(const Window& win,
+                                           const VarIdx& idx) const {
+  IdxStarterSol ret;
+
+  for (const auto& nd : idx.statPos) {
+    auto pos = win.pos.find(nd.first)->second;
+    for (const auto& col : nd.second) {
+      ret.push_back({col.second, col.first == pos});
+    }
+  }
+
+  // bend and sink edges are left to the solver
+  for (const auto& edg : idx.edgUse) {
+    const auto& path = win.paths.find(edg.first)->second;
+    for (const auto& col : edg.second) {
+      if (col.first->pl().isSecondary()) continue;
+      ret.push_back({col.second, path.count(col.first) > 0});
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+StarterSol ILPGridOptimizer::getNamedStarter(const FeasibleSol& sol) const {
+  StarterSol ret;
+
+  for (const auto& v : sol.statPos) {
+    ret[getStatPosVar(v.first.first, v.first.second)] = v.second;
+  }
+
+  for (const auto& v : sol.edgUse) {
+    ret[getEdgUseVar(v.first.first, v.first.second)] = v.second;
+  }
+
+  return ret;
+}
@@ -5,10 +5,15 @@
 #ifndef OCTI_ILP_ILPGRIDOPTIMIZER_H_
 #define OCTI_ILP_ILPGRIDOPTIMIZER_H_
 
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "octi/basegraph/BaseGraph.h"
 #include "octi/combgraph/CombGraph.h"
 #include "octi/combgraph/Drawing.h"
+#include "shared/optim/ILPModel.h"
 #include "shared/optim/ILPSolver.h"
 
 using octi::basegraph::BaseGraph;
@@ -52,24 +57,145 @@ class ILPGridOptimizer {
                     const basegraph::GeoPensMap* geoPensMap, int timeLim,
                     const std::string& cacheDir, double cacheThreshold,
                     int numThreads, const std::string& solverStr,
-                    const std::string& path) const;
+                    const std::string& path, size_t windowSize,
+                    size_t corridorSize, size_t jobs, bool cacheModel) const;
 
  protected:
+  // column ids of the edge use and station position variables, used
+  // instead of name lookups while building the problem and reading the
+  // solution
+  struct VarIdx {
+    std::unordered_map<const CombEdge*,
+                       std::unordered_map<const GridEdge*, int>>
+        edgUse;
+    std::unordered_map<const CombNode*,
+                       std::unordered_map<const GridNode*, int>>
+        statPos;
+
+    // -1 if the variable does not exist
+    int edgUseCol(const GridEdge* e, const CombEdge* cg) const;
+    int statPosCol(const GridNode* n, const CombNode* cg) const;
+  };
+
+  // values of the edge use and station position variables of a feasible
+  // solution
+  struct FeasibleSol {
+    std::map<std::pair<const GridEdge*, const CombEdge*>, int> edgUse;
+    std::map<std::pair<const GridNode*, const CombNode*>, int> statPos;
+  };
+
+  // the constraint skeleton of a problem, which only depends on the base
+  // graph, the comb graph and maxGrDist. The objective coefficients of the
+  // edge use, station position and angle columns depend on the penalties.
+  struct Skeleton {
+    explicit Skeleton(bool names) : m(names) {}
+    shared::optim::ILPModel m;
+    VarIdx idx;
+
+    // angle columns and the index of their penalty in BaseGraph::getCosts()
+    std::vector<std::pair<int, size_t>> angCols;
+  };
+
+  // restriction of the problem to a spatial window of the grid. Only the
+  // comb edges in edgs are routed, over the grid nodes in grNdSet, and the
+  // comb nodes in nds are placed on their candidates. Comb edges not in edgs
+  // but adjacent to a node in nds keep their current direction at that node.
+  struct Window {
+    util::geo::DBox box;
+    std::vector<CombNode*> nds;
+    std::vector<CombEdge*> edgs;
+    std::set<const CombEdge*> edgSet;
+    std::vector<GridNode*> grNds;
+    std::unordered_set<const GridNode*> grNdSet;
+    std::map<const CombNode*, std::set<const GridNode*>> cands;
+    std::set<const GridEdge*> blocked;
+    std::map<std::pair<const CombNode*, const CombEdge*>, size_t> fixedDirs;
+    basegraph::CrossEdgPairs crossPairs;
+
+    // nodes which are free to move, the others are fixed boundary nodes
+    std::set<const CombNode*> free;
+
+    // the current drawing inside the window, used as a starting solution
+    std::map<const CombNode*, const GridNode*> pos;
+    std::map<const CombEdge*, std::set<const GridEdge*>> paths;
+  };
+
+  ILPStats optimizeWindows(BaseGraph* gg, const CombGraph& cg,
+                           combgraph::Drawing* d, double maxGrDist,
+                           const basegraph::GeoPensMap* geoPensMap,
+                           int timeLim, int numThreads,
+                           const std::string& solverStr, size_t windowSize,
+                           size_t jobs) const;
+
+  Window getWindow(BaseGraph* gg, const CombGraph& cg, combgraph::Drawing* d,
+                   const util::geo::DBox& tile, double maxGrDist,
+                   const std::vector<GridNode*>& sinks,
+                   const basegraph::CrossEdgPairs& crossPairs) const;
+
+  // grid nodes of the cells holding the stations and paths of the presolved
+  // drawing d
+  std::unordered_set<const GridNode*> corridorCore(
+      BaseGraph* gg, const CombGraph& cg, combgraph::Drawing* d) const;
+
+  // grid nodes of all cells at most cells cells away from a cell of core
+  std::unordered_set<const GridNode*> getCorridor(
+      BaseGraph* gg, const std::unordered_set<const GridNode*>& core,
+      size_t cells) const;
+
+  // if win is set, only the problem restricted to this window is built,
+  // without changing gg. If corr is set, the full problem is restricted to
+  // the grid nodes in corr. If skelDir is set, the skeleton of the full
+  // problem is cached in this directory and only the objective is
+  // recomputed on a hit.
   shared::optim::ILPSolver* createProblem(
       BaseGraph* gg, const CombGraph& cg,
       const basegraph::GeoPensMap* geoPensMap, double maxGrDist,
-      const std::string& solverStr) const;
+      const std::string& solverStr, bool names, const Window* win,
+      const std::unordered_set<const GridNode*>* corr,
+      const std::string& skelDir, VarIdx* idx) const;
+
+  void buildSkeleton(BaseGraph* gg, const CombGraph& cg,
+                     const basegraph::GeoPensMap* geoPensMap,
+                     double maxGrDist, const Window* win,
+                     const std::unordered_set<const GridNode*>* corr,
+                     Skeleton* skel) const;
+
+  // write the objective coefficients for the current penalties
+  void setObjective(BaseGraph* gg, const basegraph::GeoPensMap* geoPensMap,
+                    Skeleton* skel) const;
+
+  double edgUseCoef(const GridEdge* e, const CombEdge* edg,
+                    const basegraph::GeoPensMap* geoPensMap) const;
+
+  // the cache file of the skeleton, empty if the comb graph has no canonical
+  // node order. nds and edgs are the comb nodes and edges in canonical order.
+  std::string getSkeletonPath(const BaseGraph* gg, const CombGraph& cg,
+                              double maxGrDist, const std::string& dir,
+                              std::vector<CombNode*>* nds,
+                              std::vector<CombEdge*>* edgs) const;
+  bool readSkeleton(const std::string& path, BaseGraph* gg,
+                    const std::vector<CombNode*>& nds,
+                    const std::vector<CombEdge*>& edgs, Skeleton* skel) const;
+  void writeSkeleton(const std::string& path,
+                     const std::vector<CombNode*>& nds,
+                     const std::vector<CombEdge*>& edgs,
+                     const Skeleton& skel) const;
 
   std::string getEdgUseVar(const GridEdge* e, const CombEdge* cg) const;
   std::string getStatPosVar(const GridNode* e, const CombNode* cg) const;
 
-  void extractSolution(shared::optim::ILPSolver* lp, BaseGraph* gg,
-                       const CombGraph& cg, combgraph::Drawing* d) const;
+  void extractSolution(shared::optim::ILPSolver* lp, const VarIdx& idx,
+                       BaseGraph* gg, const CombGraph& cg,
+                       combgraph::Drawing* d, const Window* win) const;
 
-  shared::optim::StarterSol extractFeasibleSol(combgraph::Drawing* d,
-                                               BaseGraph* gg,
-                                               const CombGraph& cg,
-                                               double maxGrDist) const;
+  FeasibleSol extractFeasibleSol(combgraph::Drawing* d, BaseGraph* gg,
+                                 const CombGraph& cg, double maxGrDist) const;
+
+  shared::optim::IdxStarterSol getStarter(const FeasibleSol& sol,
+                                          const VarIdx& idx) const;
+  shared::optim::IdxStarterSol getStarter(const Window& win,
+                                          const VarIdx& idx) const;
+  shared::optim::StarterSol getNamedStarter(const FeasibleSol& sol) const;
 
   size_t nonInfDeg(const GridNode* g) const;
 };
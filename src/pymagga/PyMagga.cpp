@@ -0,0 +1,349 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+// The magga Python module, which runs the pipeline stages in-process.
+//
+//   import magga
+//   g = magga.topo(magga.gtfs2graph("city.zip", "-m bus"))
+//   for stop in stops:
+//       sub = magga.extract(g, stops=[stop])
+//       svg = magga.transitmap(magga.loom(sub))
+//
+// Graphs are opaque magga.Graph handles which stay in memory between calls,
+// in the binary graph format. The stages read their input graph from the
+// handle's buffer and never change it, so a handle can be passed to any
+// number of calls. Stages parse their arguments like the command line
+// tools, invalid arguments still end the process. A failing stage raises a
+// RuntimeError. The stages run one at a time, without holding the GIL.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtfs2graph/Gtfs2Graph.h"
+#include "loom/Loom.h"
+#include "magga/Pipeline.h"
+#include "octi/Octi.h"
+#include "topo/Topo.h"
+#include "transitmap/TransitMap.h"
+
+namespace {
+
+// the stages parse their arguments with getopt, which has global state
+std::mutex stageMutex;
+
+const std::vector<std::string> BIN = {"--format", "bin"};
+
+// methods with keyword arguments are registered as PyCFunction
+template <typename F>
+PyCFunction cfunc(F f) {
+  return reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(f));
+}
+
+struct GraphObject {
+  PyObject_HEAD std::string* data;
+};
+
+// _____________________________________________________________________________
+void graphDealloc(GraphObject* self) {
+  delete self->data;
+  Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+// _____________________________________________________________________________
+PyObject* graphNew(PyTypeObject* type, PyObject* args, PyObject* kwds) {
+  (void)args;
+  (void)kwds;
+  auto* self = reinterpret_cast<GraphObject*>(type->tp_alloc(type, 0));
+  if (self) self->data = new std::string();
+  return reinterpret_cast<PyObject*>(self);
+}
+
+// _____________________________________________________________________________
+PyObject* graphToBytes(GraphObject* self, PyObject* unused) {
+  (void)unused;
+  return PyBytes_FromStringAndSize(self->data->data(), self->data->size());
+}
+
+PyMethodDef graphMethods[] = {
+    {"to_bytes", cfunc(graphToBytes), METH_NOARGS,
+     "the graph in the binary graph format"},
+    {0, 0, 0, 0}};
+
+// the other fields are set in PyInit_magga()
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+PyTypeObject GraphType = {PyVarObject_HEAD_INIT(0, 0)};
+#pragma GCC diagnostic pop
+
+// _____________________________________________________________________________
+PyObject* newGraph(std::string&& data) {
+  auto* g = reinterpret_cast<GraphObject*>(graphNew(&GraphType, 0, 0));
+  if (g) *g->data = std::move(data);
+  return reinterpret_cast<PyObject*>(g);
+}
+
+// _____________________________________________________________________________
+bool runStage(const std::string& name, const std::string& args,
+              const std::vector<std::string>& forced,
+              const magga::Stage& stage) {
+  int ret = 1;
+  std::string err;
+
+  Py_BEGIN_ALLOW_THREADS;
+  {
+    std::lock_guard<std::mutex> lock(stageMutex);
+    try {
+      ret = magga::runStage(name, args, forced, stage);
+    } catch (const std::exception& e) {
+      err = e.what();
+    }
+  }
+  Py_END_ALLOW_THREADS;
+
+  if (ret == 0) return true;
+
+  if (err.empty()) err = "exit code " + std::to_string(ret);
+  PyErr_SetString(PyExc_RuntimeError, (name + " failed: " + err).c_str());
+  return false;
+}
+
+// _____________________________________________________________________________
+std::string joinList(PyObject* list, bool* ok) {
+  std::string ret;
+  *ok = true;
+  if (!list) return ret;
+
+  PyObject* seq = PySequence_Fast(list, "expected a list of strings");
+  if (!seq) {
+    *ok = false;
+    return ret;
+  }
+
+  for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); i++) {
+    const char* s = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(seq, i));
+    if (!s) {
+      *ok = false;
+      break;
+    }
+    if (ret.size()) ret += ",";
+    ret += s;
+  }
+
+  Py_DECREF(seq);
+  return ret;
+}
+
+// _____________________________________________________________________________
+PyObject* load(PyObject* self, PyObject* args) {
+  (void)self;
+  const char* path;
+  if (!PyArg_ParseTuple(args, "s", &path)) return 0;
+
+  std::ifstream f(path, std::ios::binary);
+  if (!f.good()) {
+    PyErr_SetFromErrnoWithFilename(PyExc_OSError, path);
+    return 0;
+  }
+
+  std::stringstream ss;
+  ss << f.rdbuf();
+  return newGraph(ss.str());
+}
+
+// _____________________________________________________________________________
+PyObject* gtfs2graph(PyObject* self, PyObject* args, PyObject* kwds) {
+  (void)self;
+  static const char* kwlist[] = {"feed", "args", 0};
+  const char* feed;
+  const char* stageArgs = "";
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|s",
+                                   const_cast<char**>(kwlist), &feed,
+                                   &stageArgs)) {
+    return 0;
+  }
+
+  std::stringstream out;
+  if (!runStage("gtfs2graph", stageArgs, {"--format", "bin", feed},
+                [&](int c, char** v) { return gtfs2graph::run(c, v, &out); }))
+    return 0;
+
+  return newGraph(out.str());
+}
+
+// _____________________________________________________________________________
+// a stage reading a graph and writing a graph
+template <int (*RUN)(int, char**, std::istream*, std::ostream*)>
+PyObject* graphStage(const char* name, PyObject* args, PyObject* kwds) {
+  static const char* kwlist[] = {"graph", "args", 0};
+  GraphObject* g;
+  const char* stageArgs = "";
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|s",
+                                   const_cast<char**>(kwlist), &GraphType, &g,
+                                   &stageArgs)) {
+    return 0;
+  }
+
+  std::stringstream in(*g->data);
+  std::stringstream out;
+  if (!runStage(name, stageArgs, BIN,
+                [&](int c, char** v) { return RUN(c, v, &in, &out); }))
+    return 0;
+
+  return newGraph(out.str());
+}
+
+// _____________________________________________________________________________
+PyObject* topo(PyObject* self, PyObject* args, PyObject* kwds) {
+  (void)self;
+  return graphStage<topo::run>("topo", args, kwds);
+}
+
+// _____________________________________________________________________________
+PyObject* loom(PyObject* self, PyObject* args, PyObject* kwds) {
+  (void)self;
+  return graphStage<loom::run>("loom", args, kwds);
+}
+
+// _____________________________________________________________________________
+PyObject* octi(PyObject* self, PyObject* args, PyObject* kwds) {
+  (void)self;
+  return graphStage<octi::run>("octi", args, kwds);
+}
+
+// _____________________________________________________________________________
+PyObject* extract(PyObject* self, PyObject* args, PyObject* kwds) {
+  (void)self;
+  static const char* kwlist[] = {"graph", "lines", "stops", 0};
+  GraphObject* g;
+  PyObject* lines = 0;
+  PyObject* stops = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|OO",
+                                   const_cast<char**>(kwlist), &GraphType, &g,
+                                   &lines, &stops)) {
+    return 0;
+  }
+
+  bool ok;
+  std::vector<std::string> forced = {"--extract", "--format", "bin"};
+
+  std::string l = joinList(lines, &ok);
+  if (!ok) return 0;
+  if (l.size()) forced.insert(forced.end(), {"--extract-lines", l});
+
+  std::string s = joinList(stops, &ok);
+  if (!ok) return 0;
+  if (s.size()) forced.insert(forced.end(), {"--extract-stops", s});
+
+  std::stringstream in(*g->data);
+  std::stringstream out;
+  if (!runStage("topo", "", forced,
+                [&](int c, char** v) { return topo::run(c, v, &in, &out); }))
+    return 0;
+
+  return newGraph(out.str());
+}
+
+// _____________________________________________________________________________
+PyObject* transitmap(PyObject* self, PyObject* args, PyObject* kwds) {
+  (void)self;
+  static const char* kwlist[] = {"graph", "args", "path", 0};
+  GraphObject* g;
+  const char* stageArgs = "";
+  const char* path = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|sz",
+                                   const_cast<char**>(kwlist), &GraphType, &g,
+                                   &stageArgs, &path)) {
+    return 0;
+  }
+
+  std::stringstream in(*g->data);
+
+  if (path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.good()) {
+      PyErr_SetFromErrnoWithFilename(PyExc_OSError, path);
+      return 0;
+    }
+
+    if (!runStage("transitmap", stageArgs, {}, [&](int c, char** v) {
+          return transitmapper::run(c, v, &in, &out);
+        }))
+      return 0;
+
+    Py_RETURN_NONE;
+  }
+
+  std::stringstream out;
+  if (!runStage("transitmap", stageArgs, {}, [&](int c, char** v) {
+        return transitmapper::run(c, v, &in, &out);
+      }))
+    return 0;
+
+  std::string res = out.str();
+  return PyBytes_FromStringAndSize(res.data(), res.size());
+}
+
+PyMethodDef moduleMethods[] = {
+    {"load", load, METH_VARARGS,
+     "load(path) -> Graph\n\nread a JSON or binary graph file"},
+    {"gtfs2graph", cfunc(gtfs2graph), METH_VARARGS | METH_KEYWORDS,
+     "gtfs2graph(feed, args='') -> Graph\n\nbuild the graph of a GTFS feed"},
+    {"topo", cfunc(topo), METH_VARARGS | METH_KEYWORDS,
+     "topo(graph, args='') -> Graph\n\ntopologize a graph"},
+    {"extract", cfunc(extract), METH_VARARGS | METH_KEYWORDS,
+     "extract(graph, lines=[], stops=[]) -> Graph\n\ncut the lines with the "
+     "given IDs or labels, or served at the given stops, out of a topo graph"},
+    {"loom", cfunc(loom), METH_VARARGS | METH_KEYWORDS,
+     "loom(graph, args='') -> Graph\n\noptimize the line orderings"},
+    {"octi", cfunc(octi), METH_VARARGS | METH_KEYWORDS,
+     "octi(graph, args='') -> Graph\n\noctilinearize a graph"},
+    {"transitmap", cfunc(transitmap), METH_VARARGS | METH_KEYWORDS,
+     "transitmap(graph, args='', path=None) -> bytes or None\n\nrender a "
+     "graph, to path if given, else to the returned bytes"},
+    {0, 0, 0, 0}};
+
+PyModuleDef moduleDef = {PyModuleDef_HEAD_INIT,
+                         "magga",
+                         "in-process magga pipeline stages",
+                         -1,
+                         moduleMethods,
+                         0,
+                         0,
+                         0,
+                         0};
+}  // namespace
+
+// _____________________________________________________________________________
+PyMODINIT_FUNC PyInit_magga() {
+  GraphType.tp_name = "magga.Graph";
+  GraphType.tp_basicsize = sizeof(GraphObject);
+  GraphType.tp_flags = Py_TPFLAGS_DEFAULT;
+  GraphType.tp_doc = "a graph, kept in memory in the binary graph format";
+  GraphType.tp_new = graphNew;
+  GraphType.tp_dealloc = reinterpret_cast<destructor>(graphDealloc);
+  GraphType.tp_methods = graphMethods;
+
+  if (PyType_Ready(&GraphType) < 0) return 0;
+
+  PyObject* m = PyModule_Create(&moduleDef);
+  if (!m) return 0;
+
+  Py_INCREF(&GraphType);
+  if (PyModule_AddObject(m, "Graph", reinterpret_cast<PyObject*>(&GraphType)) <
+      0) {
+    Py_DECREF(&GraphType);
+    Py_DECREF(m);
+    return 0;
+  }
+
+  return m;
+}
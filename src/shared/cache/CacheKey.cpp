@@ -0,0 +1,43 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <sstream>
+#include <string>
+
+#include "shared/cache/CacheKey.h"
+
+// _____________________________________________________________________________
+uint64_t shared::cache::fnv1a(const void* data, size_t len, uint64_t h) {
+  const unsigned char* c = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < len; i++) {
+    h ^= c[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+// _____________________________________________________________________________
+uint64_t shared::cache::fnv1a(const std::string& s, uint64_t h) {
+  return fnv1a(s.data(), s.size(), h);
+}
+
+// _____________________________________________________________________________
+std::string shared::cache::argsRepr(const std::string& tool,
+                                    const std::set<std::string>& skip,
+                                    int argc, char** argv) {
+  std::stringstream repr;
+  repr << tool;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (skip.count(arg)) {
+      // skip the value, too
+      i++;
+      continue;
+    }
+    if (skip.count(arg.substr(0, arg.find('=')))) continue;
+    repr << " " << arg;
+  }
+  repr << "\n";
+  return repr.str();
+}
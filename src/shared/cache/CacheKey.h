@@ -0,0 +1,31 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_CACHE_CACHEKEY_H_
+#define SHARED_CACHE_CACHEKEY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+
+namespace shared {
+namespace cache {
+
+const uint64_t FNV_OFFSET = 14695981039346656037ull;
+
+// FNV-1a hash of len bytes at data, continuing from h
+uint64_t fnv1a(const void* data, size_t len, uint64_t h);
+uint64_t fnv1a(const std::string& s, uint64_t h);
+
+// the tool name followed by the command line arguments, without the
+// options in skip and their values
+std::string argsRepr(const std::string& tool,
+                     const std::set<std::string>& skip, int argc,
+                     char** argv);
+
+}  // namespace cache
+}  // namespace shared
+
+#endif  // SHARED_CACHE_CACHEKEY_H_
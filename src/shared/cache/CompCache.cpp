@@ -0,0 +1,230 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "shared/cache/CacheKey.h"
+#include "shared/cache/CompCache.h"
+#include "shared/linegraph/BinGraph.h"
+#include "shared/threads/Cancel.h"
+#include "util/log/Log.h"
+
+using shared::cache::argsRepr;
+using shared::cache::CompCache;
+using shared::cache::fnv1a;
+using shared::cache::FNV_OFFSET;
+using shared::linegraph::BinGraphWriter;
+using shared::linegraph::Line;
+using shared::linegraph::LineEdge;
+using shared::linegraph::LineGraph;
+using shared::linegraph::LineNode;
+using util::geo::DPoint;
+
+namespace {
+// _____________________________________________________________________________
+template <typename T>
+void hashVal(const T& v, uint64_t* h) {
+  *h = fnv1a(&v, sizeof(T), *h);
+}
+
+// _____________________________________________________________________________
+void hashStr(const std::string& s, uint64_t* h) {
+  hashVal(s.size(), h);
+  *h = fnv1a(s, *h);
+}
+
+// _____________________________________________________________________________
+void hashPt(const DPoint& p, uint64_t* h) {
+  hashVal(p.getX(), h);
+  hashVal(p.getY(), h);
+}
+
+// _____________________________________________________________________________
+void hashLine(const Line* l, uint64_t* h) {
+  hashStr(l->id(), h);
+  hashStr(l->label(), h);
+  hashStr(l->color(), h);
+  hashVal(l->bands().size(), h);
+  for (const auto& b : l->bands()) {
+    hashStr(b.first, h);
+    hashVal(b.second, h);
+  }
+}
+
+// _____________________________________________________________________________
+uint64_t ndHash(const LineNode* nd) {
+  uint64_t h = FNV_OFFSET;
+  hashPt(*nd->pl().getGeom(), &h);
+  hashVal(nd->pl().getComponent(), &h);
+
+  for (const auto& st : nd->pl().stops()) {
+    hashStr(st.id, &h);
+    hashStr(st.name, &h);
+    hashPt(st.pos, &h);
+    hashVal(st.trips, &h);
+    hashVal(st.routes, &h);
+  }
+
+  // sets of pointers, sorted by their content
+  std::vector<uint64_t> sub;
+  for (auto l : nd->pl().getLinesNotServed()) {
+    uint64_t lh = FNV_OFFSET;
+    hashLine(l, &lh);
+    sub.push_back(lh);
+  }
+  std::sort(sub.begin(), sub.end());
+  for (auto s : sub) hashVal(s, &h);
+
+  sub.clear();
+  for (const auto& ro : nd->pl().getConnExc()) {
+    for (const auto& exFr : ro.second) {
+      for (const auto* exTo : exFr.second) {
+        auto shrd = LineGraph::sharedNode(exFr.first, exTo);
+        if (!shrd) continue;
+        uint64_t eh = FNV_OFFSET;
+        hashLine(ro.first, &eh);
+        hashPt(*exFr.first->getOtherNd(shrd)->pl().getGeom(), &eh);
+        hashPt(*exTo->getOtherNd(shrd)->pl().getGeom(), &eh);
+        sub.push_back(eh);
+      }
+    }
+  }
+  std::sort(sub.begin(), sub.end());
+  for (auto s : sub) hashVal(s, &h);
+
+  return h;
+}
+
+// _____________________________________________________________________________
+uint64_t edgHash(const LineEdge* e) {
+  uint64_t h = FNV_OFFSET;
+  hashPt(*e->getFrom()->pl().getGeom(), &h);
+  hashPt(*e->getTo()->pl().getGeom(), &h);
+  for (const auto& p : *e->pl().getGeom()) hashPt(p, &h);
+  hashVal(e->pl().getComponent(), &h);
+  hashVal(e->pl().dontContract(), &h);
+
+  for (const auto& lo : e->pl().getLines()) {
+    hashLine(lo.line, &h);
+    hashVal(lo.direction == 0, &h);
+    if (lo.direction) hashPt(*lo.direction->pl().getGeom(), &h);
+    hashVal(lo.style.isNull(), &h);
+    if (!lo.style.isNull()) {
+      hashStr(lo.style.get().getCss(), &h);
+      hashStr(lo.style.get().getOutlineCss(), &h);
+    }
+  }
+
+  return h;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+CompCache::CompCache(const std::string& dir, const std::string& tool,
+                     const std::set<std::string>& skipOpts, int argc,
+                     char** argv)
+    : _dir(dir), _argsHash(0) {
+  if (_dir.empty()) return;
+  _argsHash = fnv1a(argsRepr(tool, skipOpts, argc, argv), FNV_OFFSET);
+  mkdir(_dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+}
+
+// _____________________________________________________________________________
+uint64_t CompCache::contentHash(const LineGraph& g) {
+  std::vector<uint64_t> elems;
+  elems.reserve(g.numNds() + g.numEdgs());
+
+  for (auto nd : g.getNds()) {
+    elems.push_back(ndHash(nd));
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      // distinguish edges from nodes with the same hash
+      elems.push_back(~edgHash(e));
+    }
+  }
+
+  std::sort(elems.begin(), elems.end());
+
+  uint64_t h = FNV_OFFSET;
+  hashVal(g.numNds(), &h);
+  for (auto el : elems) hashVal(el, &h);
+  return h;
+}
+
+// _____________________________________________________________________________
+uint64_t CompCache::key(const LineGraph& g, const std::string& extra) const {
+  uint64_t h = _argsHash;
+  hashStr(extra, &h);
+  hashVal(contentHash(g), &h);
+  return h;
+}
+
+// _____________________________________________________________________________
+std::string CompCache::path(uint64_t key) const {
+  std::stringstream ret;
+  ret << _dir << "/" << std::hex << std::setw(16) << std::setfill('0') << key
+      << ".comp";
+  return ret.str();
+}
+
+// _____________________________________________________________________________
+bool CompCache::get(uint64_t key, LineGraph* res) const {
+  if (!enabled()) return false;
+
+  std::ifstream fs(path(key), std::ios::binary);
+  if (!fs.good()) return false;
+
+  try {
+    res->readFromBin(&fs);
+  } catch (const std::exception& e) {
+    LOGTO(WARN, std::cerr) << "Ignoring broken component cache entry "
+                           << path(key) << ": " << e.what();
+    return false;
+  }
+
+  return true;
+}
+
+// _____________________________________________________________________________
+void CompCache::put(uint64_t key, const LineGraph& res,
+                    const util::json::Dict& props) const {
+  if (!enabled()) return;
+
+  // the results of cancelled runs may be incomplete, don't reuse them
+  if (shared::threads::cancelled()) return;
+
+  // write to a temporary file first, so concurrent readers never see
+  // partial entries
+  std::stringstream tmpPath;
+  tmpPath << path(key) << ".tmp" << getpid() << "-"
+          << std::this_thread::get_id();
+
+  {
+    std::ofstream fs(tmpPath.str(), std::ios::binary);
+    BinGraphWriter out(&fs, props);
+    out.add(res);
+    out.flush();
+    if (!fs.good()) {
+      LOGTO(WARN, std::cerr) << "Could not write component cache entry "
+                             << path(key);
+      std::remove(tmpPath.str().c_str());
+      return;
+    }
+  }
+
+  if (std::rename(tmpPath.str().c_str(), path(key).c_str()) != 0) {
+    std::remove(tmpPath.str().c_str());
+  }
+}
@@ -0,0 +1,63 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_CACHE_COMPCACHE_H_
+#define SHARED_CACHE_COMPCACHE_H_
+
+#include <cstdint>
+#include <set>
+#include <string>
+
+#include "shared/linegraph/LineGraph.h"
+#include "util/json/Writer.h"
+
+namespace shared {
+namespace cache {
+
+// On-disk cache of the results of single components of a tool run.
+//
+// Entries are addressed by a hash of the tool name and version, the
+// command line arguments (without the options in skipOpts) and the content
+// of the input component. The content hash does not depend on the order of
+// the nodes and edges in memory, so an unchanged component has the same key
+// in every run, no matter what changed in the other components. As for the
+// StageCache, files referenced by the arguments are not part of the key.
+//
+// Results are stored as binary line graphs together with a dictionary of
+// graph properties, for example statistics of the component. Entries are
+// written atomically via rename, so concurrent runs can share a directory.
+class CompCache {
+ public:
+  // an empty dir disables the cache
+  CompCache(const std::string& dir, const std::string& tool,
+            const std::set<std::string>& skipOpts, int argc, char** argv);
+
+  bool enabled() const { return !_dir.empty(); }
+
+  // the key of the input component g, extra is added to the key
+  uint64_t key(const linegraph::LineGraph& g, const std::string& extra) const;
+
+  // read the result stored for key into the empty graph *res, false if
+  // there is none or it is broken, *res should be discarded then. The
+  // properties are available via res->getGraphProps()
+  bool get(uint64_t key, linegraph::LineGraph* res) const;
+
+  // store res with the properties props as the result for key
+  void put(uint64_t key, const linegraph::LineGraph& res,
+           const util::json::Dict& props) const;
+
+  // content hash of g, independent of the order of its nodes and edges
+  static uint64_t contentHash(const linegraph::LineGraph& g);
+
+ private:
+  std::string _dir;
+  uint64_t _argsHash;
+
+  std::string path(uint64_t key) const;
+};
+
+}  // namespace cache
+}  // namespace shared
+
+#endif  // SHARED_CACHE_COMPCACHE_H_
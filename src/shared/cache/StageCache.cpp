@@ -0,0 +1,91 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "shared/cache/CacheKey.h"
+#include "shared/cache/StageCache.h"
+#include "shared/threads/Cancel.h"
+#include "util/log/Log.h"
+
+using shared::cache::argsRepr;
+using shared::cache::fnv1a;
+using shared::cache::FNV_OFFSET;
+using shared::cache::StageCache;
+
+// _____________________________________________________________________________
+StageCache::StageCache(const std::string& dir, const std::string& tool,
+                       const std::string& cacheOpt, int argc, char** argv,
+                       std::istream** inStr, std::ostream** outStr)
+    : _dir(dir), _hit(false), _out(0) {
+  if (_dir.empty()) return;
+
+  std::string repr = argsRepr(tool, {cacheOpt}, argc, argv);
+
+  _inBuf << (*inStr)->rdbuf();
+  _inBuf.clear();
+
+  const std::string& in = _inBuf.str();
+  uint64_t h = fnv1a(in, fnv1a(repr, FNV_OFFSET));
+
+  std::stringstream path;
+  path << _dir << "/" << std::hex << std::setw(16) << std::setfill('0') << h
+       << "-" << std::dec << in.size() << ".stage";
+  _path = path.str();
+
+  *inStr = &_inBuf;
+
+  std::ifstream fs(_path, std::ios::binary);
+  if (fs.good()) {
+    if (fs.peek() != std::ifstream::traits_type::eof()) **outStr << fs.rdbuf();
+    _hit = true;
+    LOGTO(DEBUG, std::cerr) << "Using cached output " << _path;
+    return;
+  }
+
+  _out = *outStr;
+  *outStr = &_outBuf;
+}
+
+// _____________________________________________________________________________
+StageCache::~StageCache() {
+  if (!_out) return;
+
+  // the output of cancelled runs may be cut short, don't reuse it
+  if (!shared::threads::cancelled()) put();
+  const std::string& out = _outBuf.str();
+  _out->write(out.data(), out.size());
+}
+
+// _____________________________________________________________________________
+void StageCache::put() const {
+  mkdir(_dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+
+  // write to a temporary file first, so concurrent readers never see
+  // partial entries
+  std::stringstream tmpPath;
+  tmpPath << _path << ".tmp" << getpid() << "-" << this;
+
+  {
+    std::ofstream fs(tmpPath.str(), std::ios::binary);
+    fs << _outBuf.str();
+    if (!fs.good()) {
+      LOGTO(WARN, std::cerr) << "Could not write stage cache entry " << _path;
+      std::remove(tmpPath.str().c_str());
+      return;
+    }
+  }
+
+  if (std::rename(tmpPath.str().c_str(), _path.c_str()) != 0) {
+    std::remove(tmpPath.str().c_str());
+  }
+}
@@ -0,0 +1,53 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_CACHE_STAGECACHE_H_
+#define SHARED_CACHE_STAGECACHE_H_
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace shared {
+namespace cache {
+
+// On-disk cache of the complete output of a single tool run.
+//
+// Entries are addressed by a hash of the tool name and version, the
+// command line arguments (without the cache option itself) and the
+// complete input. Files referenced by the arguments (for example obstacle
+// files) are not part of the key.
+//
+// If a cache directory is given, the input is read into memory and *inStr
+// is pointed to this copy. On a hit, the stored output is written to
+// *outStr and hit() returns true. Otherwise *outStr is pointed to a buffer,
+// which is stored in the cache and written to the original output stream
+// once the StageCache is destroyed. Entries are written atomically via
+// rename, so concurrent runs can share a directory.
+class StageCache {
+ public:
+  StageCache(const std::string& dir, const std::string& tool,
+             const std::string& cacheOpt, int argc, char** argv,
+             std::istream** inStr, std::ostream** outStr);
+  ~StageCache();
+
+  StageCache(const StageCache&) = delete;
+  StageCache& operator=(const StageCache&) = delete;
+
+  bool hit() const { return _hit; }
+
+ private:
+  std::string _dir, _path;
+  bool _hit;
+
+  std::ostream* _out;
+  std::stringstream _inBuf, _outBuf;
+
+  void put() const;
+};
+
+}  // namespace cache
+}  // namespace shared
+
+#endif  // SHARED_CACHE_STAGECACHE_H_
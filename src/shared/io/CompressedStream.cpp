@@ -0,0 +1,430 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef ZLIB_FOUND
+#include <zlib.h>
+#endif
+
+#ifdef ZSTD_FOUND
+#include <zstd.h>
+#endif
+
+#include "shared/io/CompressedStream.h"
+#include "util/Misc.h"
+
+using shared::io::Codec;
+using shared::io::CompressBuf;
+using shared::io::CompressedIn;
+using shared::io::CompressedOut;
+using shared::io::DecompressBuf;
+
+namespace {
+static const size_t IO_BUF_SIZE = 1 << 18;
+static const int GZIP_LEVEL = 6;
+static const int ZSTD_LEVEL = 3;
+}  // namespace
+
+namespace shared {
+namespace io {
+
+class DecompressBuf : public std::streambuf {
+ public:
+  DecompressBuf(Codec codec, std::istream* src);
+  ~DecompressBuf();
+
+ protected:
+  int_type underflow() override;
+
+ private:
+  Codec _codec;
+  std::istream* _src;
+  std::vector<char> _in, _out;
+  size_t _inPos = 0, _inLen = 0;
+
+  // inside a gzip member or a zstd frame
+  bool _inFrame = false;
+
+  // the last decode() filled the output buffer, more output may be pending
+  bool _outFull = false;
+
+#ifdef ZLIB_FOUND
+  z_stream _z;
+#endif
+#ifdef ZSTD_FOUND
+  ZSTD_DStream* _zstd = 0;
+#endif
+
+  size_t decode();
+};
+
+class CompressBuf : public std::streambuf {
+ public:
+  CompressBuf(Codec codec, size_t threads, std::ostream* dst);
+  ~CompressBuf();
+
+  void finish();
+
+ protected:
+  int_type overflow(int_type c) override;
+
+ private:
+  Codec _codec;
+  std::ostream* _dst;
+  std::vector<char> _blk, _out;
+
+  std::deque<std::vector<char>> _queue;
+  std::mutex _m;
+  std::condition_variable _cv;
+  bool _done = false, _finished = false;
+  std::thread _thrd;
+
+#ifdef ZLIB_FOUND
+  z_stream _z;
+#endif
+#ifdef ZSTD_FOUND
+  ZSTD_CCtx* _zstd = 0;
+#endif
+
+  void handOff();
+  void compress();
+  void encode(const char* d, size_t n, bool last);
+};
+
+}  // namespace io
+}  // namespace shared
+
+// _____________________________________________________________________________
+bool shared::io::parseCodec(const std::string& name, Codec* c) {
+  if (name == "none") {
+    *c = CODEC_NONE;
+  } else if (name == "gzip") {
+    *c = CODEC_GZIP;
+  } else if (name == "zstd") {
+    *c = CODEC_ZSTD;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// _____________________________________________________________________________
+std::string shared::io::codecName(Codec c) {
+  if (c == CODEC_GZIP) return "gzip";
+  if (c == CODEC_ZSTD) return "zstd";
+  return "none";
+}
+
+// _____________________________________________________________________________
+bool shared::io::hasCodec(Codec c) {
+#ifdef ZLIB_FOUND
+  if (c == CODEC_GZIP) return true;
+#endif
+#ifdef ZSTD_FOUND
+  if (c == CODEC_ZSTD) return true;
+#endif
+  return c == CODEC_NONE;
+}
+
+// _____________________________________________________________________________
+Codec shared::io::codecOf(std::istream* s) {
+  int c = s->peek();
+  if (c == GZIP_MAGIC[0]) return CODEC_GZIP;
+  if (c == ZSTD_MAGIC[0]) return CODEC_ZSTD;
+  return CODEC_NONE;
+}
+
+// _____________________________________________________________________________
+DecompressBuf::DecompressBuf(Codec codec, std::istream* src)
+    : _codec(codec), _src(src), _in(IO_BUF_SIZE), _out(IO_BUF_SIZE) {
+#ifdef ZLIB_FOUND
+  if (_codec == CODEC_GZIP) {
+    _z = z_stream();
+    // 16 + MAX_WBITS: expect a gzip header
+    if (inflateInit2(&_z, 16 + MAX_WBITS) != Z_OK) {
+      throw std::runtime_error("Could not initialize gzip decompression.");
+    }
+  }
+#endif
+#ifdef ZSTD_FOUND
+  if (_codec == CODEC_ZSTD) _zstd = ZSTD_createDStream();
+#endif
+  setg(_out.data(), _out.data(), _out.data());
+}
+
+// _____________________________________________________________________________
+DecompressBuf::~DecompressBuf() {
+#ifdef ZLIB_FOUND
+  if (_codec == CODEC_GZIP) inflateEnd(&_z);
+#endif
+#ifdef ZSTD_FOUND
+  if (_zstd) ZSTD_freeDStream(_zstd);
+#endif
+}
+
+// _____________________________________________________________________________
+DecompressBuf::int_type DecompressBuf::underflow() {
+  if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+  size_t n = 0;
+  while (!n) {
+    if (_inPos == _inLen && !_outFull) {
+      _src->read(_in.data(), _in.size());
+      _inLen = _src->gcount();
+      _inPos = 0;
+      if (!_inLen) {
+        if (_inFrame) {
+          throw std::runtime_error("Truncated " + codecName(_codec) +
+                                   " input.");
+        }
+        return traits_type::eof();
+      }
+    }
+    n = decode();
+    _outFull = n == _out.size();
+  }
+
+  setg(_out.data(), _out.data(), _out.data() + n);
+  return traits_type::to_int_type(*gptr());
+}
+
+// _____________________________________________________________________________
+size_t DecompressBuf::decode() {
+#ifdef ZLIB_FOUND
+  if (_codec == CODEC_GZIP) {
+    // concatenated gzip members are read as one stream
+    if (!_inFrame && _inPos < _inLen) inflateReset(&_z);
+
+    _z.next_in = reinterpret_cast<Bytef*>(_in.data() + _inPos);
+    _z.avail_in = _inLen - _inPos;
+    _z.next_out = reinterpret_cast<Bytef*>(_out.data());
+    _z.avail_out = _out.size();
+
+    int r = inflate(&_z, Z_NO_FLUSH);
+    if (r != Z_OK && r != Z_STREAM_END && r != Z_BUF_ERROR) {
+      throw std::runtime_error("Corrupted gzip input.");
+    }
+
+    _inPos = _inLen - _z.avail_in;
+    if (r == Z_STREAM_END) _inFrame = false;
+    if (r == Z_OK) _inFrame = true;
+    return _out.size() - _z.avail_out;
+  }
+#endif
+#ifdef ZSTD_FOUND
+  if (_codec == CODEC_ZSTD) {
+    ZSTD_inBuffer in = {_in.data() + _inPos, _inLen - _inPos, 0};
+    ZSTD_outBuffer out = {_out.data(), _out.size(), 0};
+
+    size_t r = ZSTD_decompressStream(_zstd, &out, &in);
+    if (ZSTD_isError(r)) {
+      throw std::runtime_error(std::string("Corrupted zstd input: ") +
+                               ZSTD_getErrorName(r));
+    }
+
+    _inPos += in.pos;
+    _inFrame = r != 0;
+    return out.pos;
+  }
+#endif
+  throw std::runtime_error("No " + codecName(_codec) + " support.");
+}
+
+// _____________________________________________________________________________
+CompressBuf::CompressBuf(Codec codec, size_t threads, std::ostream* dst)
+    : _codec(codec), _dst(dst), _blk(COMPRESS_BLOCK_SIZE), _out(IO_BUF_SIZE) {
+#ifdef ZLIB_FOUND
+  if (_codec == CODEC_GZIP) {
+    _z = z_stream();
+    // 16 + MAX_WBITS: write a gzip header
+    if (deflateInit2(&_z, GZIP_LEVEL, Z_DEFLATED, 16 + MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      throw std::runtime_error("Could not initialize gzip compression.");
+    }
+  }
+#endif
+#ifdef ZSTD_FOUND
+  if (_codec == CODEC_ZSTD) {
+    if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+    _zstd = ZSTD_createCCtx();
+    ZSTD_CCtx_setParameter(_zstd, ZSTD_c_compressionLevel, ZSTD_LEVEL);
+    // fails without effect if libzstd was built without multithreading
+    ZSTD_CCtx_setParameter(_zstd, ZSTD_c_nbWorkers,
+                           static_cast<int>(threads));
+  }
+#else
+  UNUSED(threads);
+#endif
+  setp(_blk.data(), _blk.data() + _blk.size());
+  _thrd = std::thread(&CompressBuf::compress, this);
+}
+
+// _____________________________________________________________________________
+CompressBuf::~CompressBuf() {
+  finish();
+#ifdef ZLIB_FOUND
+  if (_codec == CODEC_GZIP) deflateEnd(&_z);
+#endif
+#ifdef ZSTD_FOUND
+  if (_zstd) ZSTD_freeCCtx(_zstd);
+#endif
+}
+
+// _____________________________________________________________________________
+CompressBuf::int_type CompressBuf::overflow(int_type c) {
+  handOff();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+// _____________________________________________________________________________
+void CompressBuf::handOff() {
+  if (pptr() == pbase()) return;
+  _blk.resize(pptr() - pbase());
+
+  {
+    std::unique_lock<std::mutex> lock(_m);
+    _cv.wait(lock, [this] { return _queue.size() < COMPRESS_MAX_QUEUED; });
+    _queue.push_back(std::move(_blk));
+  }
+  _cv.notify_all();
+
+  _blk = std::vector<char>(COMPRESS_BLOCK_SIZE);
+  setp(_blk.data(), _blk.data() + _blk.size());
+}
+
+// _____________________________________________________________________________
+void CompressBuf::finish() {
+  if (_finished) return;
+  _finished = true;
+
+  handOff();
+  {
+    std::unique_lock<std::mutex> lock(_m);
+    _done = true;
+  }
+  _cv.notify_all();
+  _thrd.join();
+}
+
+// _____________________________________________________________________________
+void CompressBuf::compress() {
+  while (true) {
+    std::vector<char> blk;
+    {
+      std::unique_lock<std::mutex> lock(_m);
+      _cv.wait(lock, [this] { return !_queue.empty() || _done; });
+      if (_queue.empty()) break;
+      blk = std::move(_queue.front());
+      _queue.pop_front();
+    }
+    _cv.notify_all();
+    encode(blk.data(), blk.size(), false);
+  }
+
+  encode(0, 0, true);
+  _dst->flush();
+}
+
+// _____________________________________________________________________________
+void CompressBuf::encode(const char* d, size_t n, bool last) {
+#ifdef ZLIB_FOUND
+  if (_codec == CODEC_GZIP) {
+    _z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(d));
+    _z.avail_in = n;
+
+    int r;
+    do {
+      _z.next_out = reinterpret_cast<Bytef*>(_out.data());
+      _z.avail_out = _out.size();
+      r = deflate(&_z, last ? Z_FINISH : Z_NO_FLUSH);
+      if (r == Z_STREAM_ERROR) {
+        _dst->setstate(std::ios::badbit);
+        return;
+      }
+      _dst->write(_out.data(), _out.size() - _z.avail_out);
+    } while (_z.avail_out == 0 || (last && r != Z_STREAM_END));
+    return;
+  }
+#endif
+#ifdef ZSTD_FOUND
+  if (_codec == CODEC_ZSTD) {
+    ZSTD_inBuffer in = {d, n, 0};
+
+    size_t r;
+    do {
+      ZSTD_outBuffer out = {_out.data(), _out.size(), 0};
+      r = ZSTD_compressStream2(_zstd, &out, &in,
+                               last ? ZSTD_e_end : ZSTD_e_continue);
+      if (ZSTD_isError(r)) {
+        _dst->setstate(std::ios::badbit);
+        return;
+      }
+      _dst->write(_out.data(), out.pos);
+    } while (last ? r != 0 : in.pos < in.size);
+    return;
+  }
+#endif
+  UNUSED(d);
+  UNUSED(n);
+  UNUSED(last);
+}
+
+// _____________________________________________________________________________
+CompressedIn::CompressedIn(std::istream** inStr) : _codec(codecOf(*inStr)) {
+  if (_codec == CODEC_NONE) return;
+
+  if (!hasCodec(_codec)) {
+    throw std::runtime_error("Input is " + codecName(_codec) +
+                             " compressed, but " + codecName(_codec) +
+                             " support was not compiled in.");
+  }
+
+  _buf.reset(new DecompressBuf(_codec, *inStr));
+  _str.reset(new std::istream(_buf.get()));
+
+  // let decompression errors through to the caller
+  _str->exceptions(std::ios::badbit);
+
+  *inStr = _str.get();
+}
+
+// _____________________________________________________________________________
+CompressedIn::~CompressedIn() {}
+
+// _____________________________________________________________________________
+CompressedOut::CompressedOut(Codec codec, size_t threads,
+                             std::ostream** outStr) {
+  if (codec == CODEC_NONE) return;
+
+  if (!hasCodec(codec)) {
+    throw std::runtime_error(codecName(codec) +
+                             " support was not compiled in.");
+  }
+
+  _buf.reset(new CompressBuf(codec, threads, *outStr));
+  _str.reset(new std::ostream(_buf.get()));
+  *outStr = _str.get();
+}
+
+// _____________________________________________________________________________
+CompressedOut::~CompressedOut() { finish(); }
+
+// _____________________________________________________________________________
+void CompressedOut::finish() {
+  if (!_buf) return;
+  _str->flush();
+  _buf->finish();
+}
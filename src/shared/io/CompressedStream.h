@@ -0,0 +1,87 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_IO_COMPRESSEDSTREAM_H_
+#define SHARED_IO_COMPRESSEDSTREAM_H_
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace shared {
+namespace io {
+
+// Transparent gzip and zstd compression of the tool input and output
+// streams. gzip needs zlib, zstd needs libzstd at build time, hasCodec()
+// tells which of them are available.
+
+enum Codec { CODEC_NONE = 0, CODEC_GZIP = 1, CODEC_ZSTD = 2 };
+
+static const unsigned char GZIP_MAGIC[2] = {0x1f, 0x8b};
+static const unsigned char ZSTD_MAGIC[4] = {0x28, 0xb5, 0x2f, 0xfd};
+
+// output is handed to the compression thread in blocks of this size
+static const size_t COMPRESS_BLOCK_SIZE = 1 << 20;
+
+// at most this many blocks wait for the compression thread
+static const size_t COMPRESS_MAX_QUEUED = 4;
+
+// "none", "gzip" or "zstd"
+bool parseCodec(const std::string& name, Codec* c);
+std::string codecName(Codec c);
+bool hasCodec(Codec c);
+
+// The codec of a stream, by its first byte. Neither JSON, dot nor binary
+// line graphs can start with one of the magic bytes, so peeking a single
+// character is enough to decide.
+Codec codecOf(std::istream* s);
+
+class DecompressBuf;
+class CompressBuf;
+
+// If *inStr is compressed, point it to a stream decompressing it on the fly.
+// Throws a std::runtime_error if the codec was not compiled in, or on
+// corrupted input.
+class CompressedIn {
+ public:
+  explicit CompressedIn(std::istream** inStr);
+  ~CompressedIn();
+
+  CompressedIn(const CompressedIn&) = delete;
+  CompressedIn& operator=(const CompressedIn&) = delete;
+
+  Codec codec() const { return _codec; }
+
+ private:
+  Codec _codec;
+  std::unique_ptr<DecompressBuf> _buf;
+  std::unique_ptr<std::istream> _str;
+};
+
+// Point *outStr to a stream compressing into the original output stream.
+// The compression runs in a separate thread, so the tool does not wait for
+// it. zstd compresses with the given number of worker threads (0 means one
+// per core), gzip is single threaded. The output is complete once the
+// CompressedOut is destroyed or finish() was called. Nothing is done for
+// CODEC_NONE.
+class CompressedOut {
+ public:
+  CompressedOut(Codec codec, size_t threads, std::ostream** outStr);
+  ~CompressedOut();
+
+  CompressedOut(const CompressedOut&) = delete;
+  CompressedOut& operator=(const CompressedOut&) = delete;
+
+  void finish();
+
+ private:
+  std::unique_ptr<CompressBuf> _buf;
+  std::unique_ptr<std::ostream> _str;
+};
+
+}  // namespace io
+}  // namespace shared
+
+#endif  // SHARED_IO_COMPRESSEDSTREAM_H_
@@ -0,0 +1,538 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+#include "shared/linegraph/BinGraph.h"
+#include "shared/linegraph/LineGraph.h"
+#include "util/json/Writer.h"
+
+using shared::linegraph::BinConnExc;
+using shared::linegraph::BinGraph;
+using shared::linegraph::BinGraphWriter;
+using shared::linegraph::BinLineOcc;
+using shared::linegraph::BinStation;
+using shared::linegraph::LineGraph;
+using shared::linegraph::LineNode;
+using util::geo::DPoint;
+
+namespace {
+
+// _____________________________________________________________________________
+void putVarint(std::string* buf, uint64_t v) {
+  while (v >= 0x80) {
+    buf->push_back(static_cast<char>((v & 0x7F) | 0x80));
+    v >>= 7;
+  }
+  buf->push_back(static_cast<char>(v));
+}
+
+// _____________________________________________________________________________
+void putSVarint(std::string* buf, int64_t v) {
+  putVarint(buf, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+}
+
+// _____________________________________________________________________________
+void putStr(std::string* buf, const std::string& s) {
+  putVarint(buf, s.size());
+  buf->append(s);
+}
+
+// _____________________________________________________________________________
+void putCoords(std::string* buf, const std::vector<DPoint>& pts) {
+  // x and y are stored as separate columns
+  int64_t prev = 0;
+  for (const auto& p : pts) {
+    int64_t cur = std::llround(p.getX() * shared::linegraph::BIN_GRAPH_COORD_RES);
+    putSVarint(buf, cur - prev);
+    prev = cur;
+  }
+
+  prev = 0;
+  for (const auto& p : pts) {
+    int64_t cur = std::llround(p.getY() * shared::linegraph::BIN_GRAPH_COORD_RES);
+    putSVarint(buf, cur - prev);
+    prev = cur;
+  }
+}
+
+// _____________________________________________________________________________
+void putOffsets(std::string* buf, const std::vector<uint32_t>& offs) {
+  // only the per-entry counts are stored
+  for (size_t i = 1; i < offs.size(); i++) putVarint(buf, offs[i] - offs[i - 1]);
+}
+
+// _____________________________________________________________________________
+class Dec {
+ public:
+  Dec(const std::string& buf) : _p(buf.data()), _end(buf.data() + buf.size()) {}
+
+  uint64_t varint() {
+    uint64_t ret = 0;
+    int shift = 0;
+    while (true) {
+      if (_p == _end || shift > 63) err();
+      uint8_t b = static_cast<uint8_t>(*_p++);
+      ret |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if (!(b & 0x80)) break;
+      shift += 7;
+    }
+    return ret;
+  }
+
+  uint32_t u32() {
+    uint64_t v = varint();
+    if (v > std::numeric_limits<uint32_t>::max()) err();
+    return static_cast<uint32_t>(v);
+  }
+
+  int64_t svarint() {
+    uint64_t v = varint();
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+  }
+
+  std::string str() {
+    uint64_t len = varint();
+    if (static_cast<uint64_t>(_end - _p) < len) err();
+    std::string ret(_p, len);
+    _p += len;
+    return ret;
+  }
+
+  void raw(char* out, size_t len) {
+    if (static_cast<size_t>(_end - _p) < len) err();
+    std::copy(_p, _p + len, out);
+    _p += len;
+  }
+
+  void coords(std::vector<DPoint>* pts) {
+    int64_t prev = 0;
+    for (auto& p : *pts) {
+      prev += svarint();
+      p.setX(prev / shared::linegraph::BIN_GRAPH_COORD_RES);
+    }
+
+    prev = 0;
+    for (auto& p : *pts) {
+      prev += svarint();
+      p.setY(prev / shared::linegraph::BIN_GRAPH_COORD_RES);
+    }
+  }
+
+  void offsets(std::vector<uint32_t>* offs, size_t n) {
+    offs->resize(n + 1);
+    (*offs)[0] = 0;
+    for (size_t i = 1; i <= n; i++) (*offs)[i] = (*offs)[i - 1] + u32();
+  }
+
+  // guard against absurd sizes from corrupted input before allocating
+  size_t count(size_t minBytesPerEntry) {
+    uint64_t n = varint();
+    if (n * minBytesPerEntry > static_cast<uint64_t>(_end - _p)) err();
+    return n;
+  }
+
+  [[noreturn]] void err() const {
+    throw(std::runtime_error("Corrupted binary line graph input."));
+  }
+
+ private:
+  const char* _p;
+  const char* _end;
+};
+
+// _____________________________________________________________________________
+template <typename T>
+void toCsr(std::vector<std::pair<uint32_t, T>>* in, size_t n,
+           std::vector<uint32_t>* offs, std::vector<T>* out) {
+  std::stable_sort(in->begin(), in->end(),
+                   [](const std::pair<uint32_t, T>& a,
+                      const std::pair<uint32_t, T>& b) {
+                     return a.first < b.first;
+                   });
+
+  offs->assign(n + 1, 0);
+  out->clear();
+  out->reserve(in->size());
+
+  for (const auto& e : *in) {
+    (*offs)[e.first + 1]++;
+    out->push_back(e.second);
+  }
+
+  for (size_t i = 1; i <= n; i++) (*offs)[i] += (*offs)[i - 1];
+}
+}  // namespace
+
+// _____________________________________________________________________________
+bool shared::linegraph::isBinGraph(std::istream* s) {
+  // JSON input will never start with the first magic byte, so peeking a single
+  // character is enough to decide
+  return s->peek() == BIN_GRAPH_MAGIC[0];
+}
+
+// _____________________________________________________________________________
+void shared::linegraph::writeBinGraph(const BinGraph& g, std::ostream* s) {
+  std::string buf;
+
+  buf.append(BIN_GRAPH_MAGIC, 4);
+  putVarint(&buf, BIN_GRAPH_VERSION);
+  putStr(&buf, g.props);
+
+  // lines
+  putVarint(&buf, g.lines.size());
+  for (const auto& l : g.lines) putStr(&buf, l.id);
+  for (const auto& l : g.lines) putStr(&buf, l.label);
+  for (const auto& l : g.lines) putStr(&buf, l.color);
+  for (const auto& l : g.lines) {
+    putVarint(&buf, l.bands.size());
+    for (const auto& b : l.bands) {
+      putStr(&buf, b.first);
+      putVarint(&buf, b.second);
+    }
+  }
+
+  // nodes
+  putVarint(&buf, g.ndPos.size());
+  putCoords(&buf, g.ndPos);
+  for (auto c : g.ndComp) putVarint(&buf, static_cast<uint32_t>(c + 1));
+
+  putOffsets(&buf, g.ndStatOffs);
+  for (const auto& st : g.stations) putStr(&buf, st.id);
+  for (const auto& st : g.stations) putStr(&buf, st.label);
+  for (const auto& st : g.stations) putVarint(&buf, st.trips);
+  for (const auto& st : g.stations) putVarint(&buf, st.routes);
+
+  putOffsets(&buf, g.ndNotServedOffs);
+  for (auto l : g.notServed) putVarint(&buf, l);
+
+  putOffsets(&buf, g.ndExcOffs);
+  for (const auto& ex : g.excs) putVarint(&buf, ex.line);
+  for (const auto& ex : g.excs) putVarint(&buf, ex.ndFrom);
+  for (const auto& ex : g.excs) putVarint(&buf, ex.ndTo);
+
+  // edges
+  putVarint(&buf, g.edgFr.size());
+  for (auto fr : g.edgFr) putVarint(&buf, fr);
+  for (auto to : g.edgTo) putVarint(&buf, to);
+  for (auto c : g.edgComp) putVarint(&buf, static_cast<uint32_t>(c + 1));
+  buf.append(reinterpret_cast<const char*>(g.edgDontContract.data()),
+             g.edgDontContract.size());
+
+  putOffsets(&buf, g.edgGeomOffs);
+  putCoords(&buf, g.geoms);
+
+  putOffsets(&buf, g.edgOccOffs);
+  for (const auto& lo : g.occs) putVarint(&buf, lo.line);
+  for (const auto& lo : g.occs) putVarint(&buf, static_cast<uint32_t>(lo.dir + 1));
+  for (const auto& lo : g.occs) putStr(&buf, lo.style);
+  for (const auto& lo : g.occs) putStr(&buf, lo.outlineStyle);
+
+  s->write(buf.data(), buf.size());
+  s->flush();
+}
+
+// _____________________________________________________________________________
+void shared::linegraph::readBinGraph(std::istream* s, BinGraph* g) {
+  std::string buf((std::istreambuf_iterator<char>(*s)),
+                  std::istreambuf_iterator<char>());
+  Dec d(buf);
+
+  char magic[4];
+  d.raw(magic, 4);
+  if (!std::equal(magic, magic + 4, BIN_GRAPH_MAGIC)) {
+    throw(std::runtime_error("Input is not a binary line graph."));
+  }
+
+  uint64_t version = d.varint();
+  if (version < 1 || version > BIN_GRAPH_VERSION) {
+    throw(std::runtime_error("Unsupported binary line graph version " +
+                             std::to_string(version)));
+  }
+
+  g->props = d.str();
+
+  // lines
+  g->lines.resize(d.count(3));
+  for (auto& l : g->lines) l.id = d.str();
+  for (auto& l : g->lines) l.label = d.str();
+  for (auto& l : g->lines) l.color = d.str();
+  if (version > 2) {
+    for (auto& l : g->lines) {
+      size_t n = d.count(2);
+      for (size_t i = 0; i < n; i++) {
+        std::string band = d.str();
+        l.bands[band] = d.u32();
+      }
+    }
+  }
+
+  // nodes
+  size_t numNds = d.count(2);
+  g->ndPos.resize(numNds);
+  d.coords(&g->ndPos);
+  g->ndComp.resize(numNds);
+  for (auto& c : g->ndComp) c = d.u32() - 1;
+
+  d.offsets(&g->ndStatOffs, numNds);
+  g->stations.resize(g->ndStatOffs.back());
+  for (auto& st : g->stations) st.id = d.str();
+  for (auto& st : g->stations) st.label = d.str();
+  for (auto& st : g->stations) st.trips = version > 1 ? d.u32() : 0;
+  for (auto& st : g->stations) st.routes = version > 1 ? d.u32() : 0;
+
+  d.offsets(&g->ndNotServedOffs, numNds);
+  g->notServed.resize(g->ndNotServedOffs.back());
+  for (auto& l : g->notServed) l = d.u32();
+
+  d.offsets(&g->ndExcOffs, numNds);
+  g->excs.resize(g->ndExcOffs.back());
+  for (auto& ex : g->excs) ex.line = d.u32();
+  for (auto& ex : g->excs) ex.ndFrom = d.u32();
+  for (auto& ex : g->excs) ex.ndTo = d.u32();
+
+  // edges
+  size_t numEdgs = d.count(4);
+  g->edgFr.resize(numEdgs);
+  g->edgTo.resize(numEdgs);
+  g->edgComp.resize(numEdgs);
+  g->edgDontContract.resize(numEdgs);
+  for (auto& fr : g->edgFr) fr = d.u32();
+  for (auto& to : g->edgTo) to = d.u32();
+  for (auto& c : g->edgComp) c = d.u32() - 1;
+  d.raw(reinterpret_cast<char*>(g->edgDontContract.data()), numEdgs);
+
+  d.offsets(&g->edgGeomOffs, numEdgs);
+  g->geoms.resize(g->edgGeomOffs.back());
+  d.coords(&g->geoms);
+
+  d.offsets(&g->edgOccOffs, numEdgs);
+  g->occs.resize(g->edgOccOffs.back());
+  for (auto& lo : g->occs) lo.line = d.u32();
+  for (auto& lo : g->occs) lo.dir = d.u32() - 1;
+  for (auto& lo : g->occs) lo.style = d.str();
+  for (auto& lo : g->occs) lo.outlineStyle = d.str();
+
+  // validate references
+  for (size_t i = 0; i < numEdgs; i++) {
+    if (g->edgFr[i] >= numNds || g->edgTo[i] >= numNds) d.err();
+  }
+  for (const auto& lo : g->occs) {
+    if (lo.line >= g->lines.size()) d.err();
+    if (lo.dir != BIN_GRAPH_NONE && lo.dir >= numNds) d.err();
+  }
+  for (auto l : g->notServed) {
+    if (l >= g->lines.size()) d.err();
+  }
+  for (const auto& ex : g->excs) {
+    if (ex.line >= g->lines.size() || ex.ndFrom >= numNds ||
+        ex.ndTo >= numNds)
+      d.err();
+  }
+}
+
+// _____________________________________________________________________________
+BinGraphWriter::BinGraphWriter(std::ostream* out) : _out(out) {}
+
+// _____________________________________________________________________________
+BinGraphWriter::BinGraphWriter(std::ostream* out,
+                               const util::json::Dict& props)
+    : _out(out) {
+  std::stringstream ss;
+  util::json::Writer wr(&ss, 10);
+  wr.val(props);
+  wr.closeAll();
+  _g.props = ss.str();
+}
+
+// _____________________________________________________________________________
+uint32_t BinGraphWriter::addLine(const std::string& id,
+                                 const std::string& label,
+                                 const std::string& color) {
+  return addLine(id, label, color, {});
+}
+
+// _____________________________________________________________________________
+uint32_t BinGraphWriter::addLine(
+    const std::string& id, const std::string& label, const std::string& color,
+    const std::map<std::string, uint32_t>& bands) {
+  auto it = _lineIds.find(id);
+  if (it != _lineIds.end()) return it->second;
+
+  uint32_t idx = _g.lines.size();
+  _g.lines.push_back({id, label, color, bands});
+  _lineIds[id] = idx;
+  return idx;
+}
+
+// _____________________________________________________________________________
+uint32_t BinGraphWriter::addNd(const DPoint& pos, uint32_t comp) {
+  _g.ndPos.push_back(pos);
+  _g.ndComp.push_back(comp);
+  return _g.ndPos.size() - 1;
+}
+
+// _____________________________________________________________________________
+void BinGraphWriter::addStation(uint32_t nd, const std::string& id,
+                                const std::string& label) {
+  addStation(nd, id, label, 0, 0);
+}
+
+// _____________________________________________________________________________
+void BinGraphWriter::addStation(uint32_t nd, const std::string& id,
+                                const std::string& label, uint32_t trips,
+                                uint32_t routes) {
+  _stations.push_back({nd, {id, label, trips, routes}});
+}
+
+// _____________________________________________________________________________
+void BinGraphWriter::addNotServed(uint32_t nd, uint32_t line) {
+  _notServed.push_back({nd, line});
+}
+
+// _____________________________________________________________________________
+void BinGraphWriter::addConnExc(uint32_t nd, uint32_t line, uint32_t ndFrom,
+                                uint32_t ndTo) {
+  _excs.push_back({nd, {line, ndFrom, ndTo}});
+}
+
+// _____________________________________________________________________________
+uint32_t BinGraphWriter::addEdg(uint32_t fr, uint32_t to,
+                                const util::geo::DLine& geom, uint32_t comp,
+                                bool dontContract) {
+  if (_g.edgGeomOffs.empty()) _g.edgGeomOffs.push_back(0);
+
+  _g.edgFr.push_back(fr);
+  _g.edgTo.push_back(to);
+  _g.edgComp.push_back(comp);
+  _g.edgDontContract.push_back(dontContract);
+  _g.geoms.insert(_g.geoms.end(), geom.begin(), geom.end());
+  _g.edgGeomOffs.push_back(_g.geoms.size());
+
+  return _g.edgFr.size() - 1;
+}
+
+// _____________________________________________________________________________
+void BinGraphWriter::addLineOcc(uint32_t edg, uint32_t line, uint32_t dir,
+                                const std::string& style,
+                                const std::string& outlineStyle) {
+  _occs.push_back({edg, {line, dir, style, outlineStyle}});
+}
+
+// _____________________________________________________________________________
+void BinGraphWriter::add(const LineGraph& g) { add(g, 0); }
+
+// _____________________________________________________________________________
+void BinGraphWriter::add(const LineGraph& g,
+                         const std::set<const Line*>& lines) {
+  add(g, &lines);
+}
+
+// _____________________________________________________________________________
+void BinGraphWriter::add(const LineGraph& g,
+                         const std::set<const Line*>* lines) {
+  // with a line filter, only edges with a wanted line are written
+  auto wanted = [lines](const LineEdge* e) {
+    if (!lines) return true;
+    for (const auto& lo : e->pl().getLines()) {
+      if (lines->count(lo.line)) return true;
+    }
+    return false;
+  };
+
+  std::unordered_map<const LineNode*, uint32_t> ndIdx;
+  ndIdx.reserve(g.getNds().size());
+
+  for (auto nd : g.getNds()) {
+    if (lines && std::none_of(nd->getAdjList().begin(),
+                              nd->getAdjList().end(), wanted)) {
+      continue;
+    }
+    ndIdx[nd] = addNd(*nd->pl().getGeom(), nd->pl().getComponent());
+  }
+
+  for (auto nd : g.getNds()) {
+    auto ndIt = ndIdx.find(nd);
+    if (ndIt == ndIdx.end()) continue;
+    uint32_t idx = ndIt->second;
+    for (const auto& st : nd->pl().stops()) {
+      addStation(idx, st.id, st.name, st.trips, st.routes);
+    }
+
+    for (auto l : nd->pl().getLinesNotServed()) {
+      if (lines && !lines->count(l)) continue;
+      addNotServed(idx,
+                   addLine(l->id(), l->label(), l->color(), l->bands()));
+    }
+
+    for (const auto& ro : nd->pl().getConnExc()) {
+      if (lines && !lines->count(ro.first)) continue;
+      uint32_t lIdx = addLine(ro.first->id(), ro.first->label(),
+                              ro.first->color(), ro.first->bands());
+      for (const auto& exFr : ro.second) {
+        for (const auto* exTo : exFr.second) {
+          if (exFr.first == exTo) continue;
+          auto shrd = LineGraph::sharedNode(exFr.first, exTo);
+          if (!shrd) continue;
+          if (!wanted(exFr.first) || !wanted(exTo)) continue;
+          uint32_t a = ndIdx[exFr.first->getOtherNd(shrd)];
+          uint32_t b = ndIdx[exTo->getOtherNd(shrd)];
+          // exceptions are stored in both directions, only write them once
+          if (a > b) continue;
+          addConnExc(idx, lIdx, a, b);
+        }
+      }
+    }
+  }
+
+  for (auto nd : g.getNds()) {
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      if (!wanted(e)) continue;
+      uint32_t eIdx = addEdg(ndIdx[e->getFrom()], ndIdx[e->getTo()],
+                             *e->pl().getGeom(), e->pl().getComponent(),
+                             e->pl().dontContract());
+
+      for (const auto& lo : e->pl().getLines()) {
+        if (lines && !lines->count(lo.line)) continue;
+        uint32_t lIdx = addLine(lo.line->id(), lo.line->label(),
+                                lo.line->color(), lo.line->bands());
+        uint32_t dir = lo.direction ? ndIdx[lo.direction] : BIN_GRAPH_NONE;
+        if (lo.style.isNull()) {
+          addLineOcc(eIdx, lIdx, dir, "", "");
+        } else {
+          addLineOcc(eIdx, lIdx, dir, lo.style.get().getCss(),
+                     lo.style.get().getOutlineCss());
+        }
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void BinGraphWriter::flush() {
+  size_t numNds = _g.ndPos.size();
+  size_t numEdgs = _g.edgFr.size();
+
+  toCsr(&_stations, numNds, &_g.ndStatOffs, &_g.stations);
+  toCsr(&_notServed, numNds, &_g.ndNotServedOffs, &_g.notServed);
+  toCsr(&_excs, numNds, &_g.ndExcOffs, &_g.excs);
+  toCsr(&_occs, numEdgs, &_g.edgOccOffs, &_g.occs);
+  if (_g.edgGeomOffs.empty()) _g.edgGeomOffs.push_back(0);
+
+  writeBinGraph(_g, _out);
+
+  std::string props = _g.props;
+  _g = BinGraph();
+  _g.props = props;
+  _lineIds.clear();
+  _stations.clear();
+  _notServed.clear();
+  _excs.clear();
+  _occs.clear();
+}
@@ -0,0 +1,138 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_LINEGRAPH_BINGRAPH_H_
+#define SHARED_LINEGRAPH_BINGRAPH_H_
+
+#include <istream>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "util/geo/Geo.h"
+#include "util/json/Writer.h"
+
+namespace shared {
+namespace linegraph {
+
+class Line;
+class LineGraph;
+
+// Compact binary interchange format for line graphs. The graph is stored
+// column-wise: a line table with interned line IDs, flat node and edge arrays
+// and per-edge line occurrence arrays. Coordinates are stored in web mercator
+// as zig-zag varint deltas quantized to BIN_GRAPH_COORD_RES.
+
+static const char BIN_GRAPH_MAGIC[4] = {'L', 'G', 'B', 'F'};
+static const uint64_t BIN_GRAPH_VERSION = 3;
+static const double BIN_GRAPH_COORD_RES = 1000;
+
+// index value used for "no node" (e.g. bidirectional line occurrences)
+static const uint32_t BIN_GRAPH_NONE = std::numeric_limits<uint32_t>::max();
+
+struct BinLine {
+  std::string id, label, color;
+  std::map<std::string, uint32_t> bands;  // not before version 3, empty
+};
+
+struct BinStation {
+  std::string id, label;
+  uint32_t trips, routes;  // not in version 1, read as 0
+};
+
+struct BinLineOcc {
+  uint32_t line;
+  uint32_t dir;  // index of the direction node, BIN_GRAPH_NONE if both
+  std::string style, outlineStyle;
+};
+
+struct BinConnExc {
+  uint32_t line, ndFrom, ndTo;
+};
+
+// columnar in-memory representation of a binary line graph, all offset
+// vectors hold one entry more than there are nodes or edges
+struct BinGraph {
+  std::string props;  // graph properties, serialized as JSON
+
+  std::vector<BinLine> lines;
+
+  std::vector<util::geo::DPoint> ndPos;
+  std::vector<uint32_t> ndComp;
+  std::vector<uint32_t> ndStatOffs;
+  std::vector<BinStation> stations;
+  std::vector<uint32_t> ndNotServedOffs;
+  std::vector<uint32_t> notServed;
+  std::vector<uint32_t> ndExcOffs;
+  std::vector<BinConnExc> excs;
+
+  std::vector<uint32_t> edgFr, edgTo, edgComp;
+  std::vector<uint8_t> edgDontContract;
+  std::vector<uint32_t> edgGeomOffs;
+  std::vector<util::geo::DPoint> geoms;
+  std::vector<uint32_t> edgOccOffs;
+  std::vector<BinLineOcc> occs;
+};
+
+// true if the stream starts with the binary line graph magic bytes, does not
+// consume any input
+bool isBinGraph(std::istream* s);
+
+void readBinGraph(std::istream* s, BinGraph* g);
+void writeBinGraph(const BinGraph& g, std::ostream* s);
+
+class BinGraphWriter {
+ public:
+  explicit BinGraphWriter(std::ostream* out);
+  BinGraphWriter(std::ostream* out, const util::json::Dict& props);
+
+  // add a complete line graph, may be called multiple times
+  void add(const LineGraph& g);
+
+  // add the part of a line graph used by the given lines: only these lines,
+  // the edges they occur on and the nodes of these edges
+  void add(const LineGraph& g, const std::set<const Line*>& lines);
+
+  // low-level interface for graphs which are not LineGraphs
+  uint32_t addLine(const std::string& id, const std::string& label,
+                   const std::string& color);
+  uint32_t addLine(const std::string& id, const std::string& label,
+                   const std::string& color,
+                   const std::map<std::string, uint32_t>& bands);
+  uint32_t addNd(const util::geo::DPoint& pos, uint32_t comp);
+  void addStation(uint32_t nd, const std::string& id, const std::string& label);
+  void addStation(uint32_t nd, const std::string& id, const std::string& label,
+                  uint32_t trips, uint32_t routes);
+  void addNotServed(uint32_t nd, uint32_t line);
+  void addConnExc(uint32_t nd, uint32_t line, uint32_t ndFrom, uint32_t ndTo);
+  uint32_t addEdg(uint32_t fr, uint32_t to, const util::geo::DLine& geom,
+                  uint32_t comp, bool dontContract);
+  void addLineOcc(uint32_t edg, uint32_t line, uint32_t dir,
+                  const std::string& style, const std::string& outlineStyle);
+
+  void flush();
+
+ private:
+  std::ostream* _out;
+  BinGraph _g;
+
+  std::unordered_map<std::string, uint32_t> _lineIds;
+
+  std::vector<std::pair<uint32_t, BinStation>> _stations;
+  std::vector<std::pair<uint32_t, uint32_t>> _notServed;
+  std::vector<std::pair<uint32_t, BinConnExc>> _excs;
+  std::vector<std::pair<uint32_t, BinLineOcc>> _occs;
+
+  void add(const LineGraph& g, const std::set<const Line*>* lines);
+};
+
+}  // namespace linegraph
+}  // namespace shared
+
+#endif  // SHARED_LINEGRAPH_BINGRAPH_H_
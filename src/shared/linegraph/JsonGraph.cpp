@@ -0,0 +1,387 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "shared/linegraph/JsonGraph.h"
+#include "shared/linegraph/LineGraph.h"
+
+using shared::linegraph::JsonGraphWriter;
+using shared::linegraph::LineEdge;
+using shared::linegraph::LineGraph;
+using shared::linegraph::LineNode;
+
+// features formatted by one task
+static const size_t CHUNK_SIZE = 1024;
+
+// chunks formatted before they are written, bounds the buffered output
+static const size_t WINDOW_SIZE = 256;
+
+// _____________________________________________________________________________
+JsonGraphWriter::JsonGraphWriter(std::ostream* out) : _out(out) {}
+
+// _____________________________________________________________________________
+JsonGraphWriter::JsonGraphWriter(std::ostream* out,
+                                 const util::json::Dict& props)
+    : _out(out) {
+  if (props.empty()) return;
+  std::stringstream ss;
+  util::json::Writer wr(&ss, 10);
+  wr.val(props);
+  wr.closeAll();
+  _props = ss.str();
+}
+
+// _____________________________________________________________________________
+void JsonGraphWriter::open() {
+  if (_open) return;
+  _open = true;
+  _first = true;
+  *_out << "{\"type\":\"FeatureCollection\",";
+  if (!_props.empty()) *_out << "\"properties\":" << _props << ",";
+  *_out << "\"features\":[";
+}
+
+// _____________________________________________________________________________
+void JsonGraphWriter::add(const LineGraph& g) {
+  open();
+
+  std::vector<const LineNode*> nds;
+  std::vector<const LineEdge*> edgs;
+  nds.reserve(g.getNds().size());
+
+  for (auto nd : g.getNds()) {
+    if (nd->pl().getGeom()) nds.push_back(nd);
+  }
+
+  for (auto nd : g.getNds()) {
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      // edges without geometry are drawn between their nodes, if possible
+      if ((!e->pl().getGeom() || e->pl().getGeom()->empty()) &&
+          (!e->getFrom()->pl().getGeom() || !e->getTo()->pl().getGeom()))
+        continue;
+      edgs.push_back(e);
+    }
+  }
+
+  size_t n = nds.size() + edgs.size();
+  size_t numChunks = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  std::vector<std::string> bufs(std::min(numChunks, WINDOW_SIZE));
+
+  for (size_t w = 0; w < numChunks; w += WINDOW_SIZE) {
+    size_t wEnd = std::min(w + WINDOW_SIZE, numChunks);
+
+#pragma omp parallel for schedule(dynamic) if (wEnd - w > 1)
+    for (size_t c = w; c < wEnd; c++) {
+      auto& buf = bufs[c - w];
+      buf.clear();
+      for (size_t i = c * CHUNK_SIZE; i < std::min(n, (c + 1) * CHUNK_SIZE);
+           i++) {
+        buf.push_back(',');
+        if (i < nds.size()) {
+          writeNd(nds[i], &buf);
+        } else {
+          writeEdg(edgs[i - nds.size()], &buf);
+        }
+      }
+    }
+
+    for (size_t c = w; c < wEnd; c++) {
+      const auto& buf = bufs[c - w];
+      if (buf.empty()) continue;
+      // every feature is preceded by a comma, except the very first one
+      if (_first) {
+        _out->write(buf.data() + 1, buf.size() - 1);
+        _first = false;
+      } else {
+        _out->write(buf.data(), buf.size());
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void JsonGraphWriter::flush() {
+  open();
+  *_out << "]}";
+  _out->flush();
+  _open = false;
+}
+
+// _____________________________________________________________________________
+void JsonGraphWriter::writeNd(const LineNode* nd, std::string* out) const {
+  out->append("{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+              "\"coordinates\":");
+  writeCoord(*nd->pl().getGeom(), out);
+  out->append("},\"properties\":");
+  writeNdProps(nd, out);
+  out->push_back('}');
+}
+
+// _____________________________________________________________________________
+void JsonGraphWriter::writeNdProps(const LineNode* nd, std::string* out) {
+  const auto& pl = nd->pl();
+
+  out->push_back('{');
+
+  // keys in the sorted order of util::json::Dict
+  if (pl.getComponent() != std::numeric_limits<uint32_t>::max()) {
+    out->append("\"component\":");
+    out->append(std::to_string(pl.getComponent()));
+    out->push_back(',');
+  }
+
+  out->append("\"deg\":\"");
+  out->append(std::to_string(nd->getDeg()));
+  out->append("\",\"deg_in\":\"");
+  out->append(std::to_string(nd->getInDeg()));
+  out->append("\",\"deg_out\":\"");
+  out->append(std::to_string(nd->getOutDeg()));
+  out->append("\",");
+
+  bool firstEx = true;
+  for (const auto& ro : pl.getConnExc()) {
+    for (const auto& exFr : ro.second) {
+      for (const auto* exTo : exFr.second) {
+        if (exFr.first == exTo) continue;
+        auto shrd = LineGraph::sharedNode(exFr.first, exTo);
+        if (!shrd) continue;
+        out->append(firstEx ? "\"excluded_conn\":[" : ",");
+        firstEx = false;
+        out->append("{\"line\":");
+        writeStr(ro.first->id(), out);
+        out->append(",\"node_from\":");
+        writeId(exFr.first->getOtherNd(shrd), out);
+        out->append(",\"node_to\":");
+        writeId(exTo->getOtherNd(shrd), out);
+        out->push_back('}');
+      }
+    }
+  }
+  if (!firstEx) out->append("],");
+
+  out->append("\"id\":");
+  writeId(nd, out);
+
+  if (pl.getLinesNotServed().size()) {
+    out->append(",\"not_serving\":[");
+    bool first = true;
+    for (const auto& no : pl.getLinesNotServed()) {
+      if (!first) out->push_back(',');
+      first = false;
+      writeStr(no->id(), out);
+    }
+    out->push_back(']');
+  }
+
+  if (pl.stops().size()) {
+    out->append(",\"station_id\":");
+    writeStr(pl.stops().front().id, out);
+    out->append(",\"station_label\":");
+    writeStr(pl.stops().front().name, out);
+    if (pl.stops().front().trips) {
+      out->append(",\"station_trips\":");
+      out->append(std::to_string(pl.stops().front().trips));
+      out->append(",\"station_routes\":");
+      out->append(std::to_string(pl.stops().front().routes));
+    }
+  }
+
+  out->push_back('}');
+}
+
+// _____________________________________________________________________________
+void JsonGraphWriter::writeEdg(const LineEdge* e, std::string* out) const {
+  const auto& pl = e->pl();
+
+  out->append("{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+              "\"coordinates\":[");
+  if (!pl.getGeom() || pl.getGeom()->empty()) {
+    writeCoord(*e->getFrom()->pl().getGeom(), out);
+    out->push_back(',');
+    writeCoord(*e->getTo()->pl().getGeom(), out);
+  } else {
+    for (size_t i = 0; i < pl.getGeom()->size(); i++) {
+      if (i) out->push_back(',');
+      writeCoord((*pl.getGeom())[i], out);
+    }
+  }
+  out->append("]},\"properties\":");
+  writeEdgProps(e, out);
+  out->push_back('}');
+}
+
+// _____________________________________________________________________________
+void JsonGraphWriter::writeEdgProps(const LineEdge* e, std::string* out) {
+  const auto& pl = e->pl();
+
+  out->push_back('{');
+
+  if (pl.getComponent() != std::numeric_limits<uint32_t>::max()) {
+    out->append("\"component\":");
+    out->append(std::to_string(pl.getComponent()));
+    out->push_back(',');
+  }
+
+  std::string dbgLines;
+  for (const auto& lo : pl.getLines()) {
+    if (!dbgLines.empty()) dbgLines.push_back(',');
+    dbgLines += lo.line->label();
+  }
+
+  out->append("\"dbg_lines\":");
+  writeStr(dbgLines, out);
+  out->append(",\"from\":");
+  writeId(e->getFrom(), out);
+  out->append(",\"id\":");
+  writeId(e, out);
+  out->append(",\"lines\":[");
+
+  bool first = true;
+  for (const auto& lo : pl.getLines()) {
+    if (!first) out->push_back(',');
+    first = false;
+    out->push_back('{');
+    if (!lo.line->bands().empty()) {
+      out->append("\"bands\":{");
+      for (const auto& b : lo.line->bands()) {
+        if (out->back() != '{') out->push_back(',');
+        writeStr(b.first, out);
+        out->push_back(':');
+        out->append(std::to_string(b.second));
+      }
+      out->append("},");
+    }
+    out->append("\"color\":");
+    writeStr(lo.line->color(), out);
+    if (lo.direction) {
+      out->append(",\"direction\":");
+      writeId(lo.direction, out);
+    }
+    out->append(",\"id\":");
+    writeStr(lo.line->id(), out);
+    out->append(",\"label\":");
+    writeStr(lo.line->label(), out);
+    if (!lo.style.isNull()) {
+      if (lo.style.get().getOutlineCss().size()) {
+        out->append(",\"outline-style\":");
+        writeStr(lo.style.get().getOutlineCss(), out);
+      }
+      if (lo.style.get().getCss().size()) {
+        out->append(",\"style\":");
+        writeStr(lo.style.get().getCss(), out);
+      }
+    }
+    out->push_back('}');
+  }
+
+  out->append("],\"to\":");
+  writeId(e->getTo(), out);
+  out->push_back('}');
+}
+
+// _____________________________________________________________________________
+void JsonGraphWriter::writeCoord(const util::geo::DPoint& p,
+                                 std::string* out) {
+  auto ll = util::geo::webMercToLatLng<double>(p.getX(), p.getY());
+  out->push_back('[');
+  writeNum(ll.getX(), out);
+  out->push_back(',');
+  writeNum(ll.getY(), out);
+  out->push_back(']');
+}
+
+// _____________________________________________________________________________
+void JsonGraphWriter::writeNum(double v, std::string* out) {
+  static const double SCALE = std::pow(10, JSON_GRAPH_COORD_PREC);
+
+  // larger values would overflow the fixed point representation
+  if (!std::isfinite(v) || fabs(v) * SCALE > 9e18) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*g", 17, std::isfinite(v) ? v : 0);
+    out->append(buf);
+    return;
+  }
+
+  uint64_t fixed = llround(fabs(v) * SCALE);
+  uint64_t scale = SCALE;
+  uint64_t intPart = fixed / scale;
+  uint64_t frac = fixed % scale;
+
+  if (v < 0 && fixed) out->push_back('-');
+
+  char buf[32];
+  size_t len = 0;
+  do {
+    buf[len++] = '0' + intPart % 10;
+    intPart /= 10;
+  } while (intPart);
+  while (len) out->push_back(buf[--len]);
+
+  if (!frac) return;
+
+  size_t digits = JSON_GRAPH_COORD_PREC;
+  while (frac % 10 == 0) {
+    frac /= 10;
+    digits--;
+  }
+
+  out->push_back('.');
+  for (size_t i = 0; i < digits; i++) {
+    buf[digits - 1 - i] = '0' + frac % 10;
+    frac /= 10;
+  }
+  out->append(buf, digits);
+}
+
+// _____________________________________________________________________________
+void JsonGraphWriter::writeStr(const std::string& s, std::string* out) {
+  static const char* HEX = "0123456789abcdef";
+  out->push_back('"');
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\n':
+        out->append("\\n");
+        break;
+      case '\r':
+        out->append("\\r");
+        break;
+      case '\t':
+        out->append("\\t");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out->append("\\u00");
+          out->push_back(HEX[(c >> 4) & 0xf]);
+          out->push_back(HEX[c & 0xf]);
+        } else {
+          out->push_back(c);
+        }
+    }
+  }
+  out->push_back('"');
+}
+
+// _____________________________________________________________________________
+void JsonGraphWriter::writeId(const void* p, std::string* out) {
+  // same as util::toString() of a pointer
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%p", p);
+  out->push_back('"');
+  out->append(buf);
+  out->push_back('"');
+}
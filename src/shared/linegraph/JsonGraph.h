@@ -0,0 +1,64 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_LINEGRAPH_JSONGRAPH_H_
+#define SHARED_LINEGRAPH_JSONGRAPH_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "shared/linegraph/LineGraph.h"
+#include "util/json/Writer.h"
+
+namespace shared {
+namespace linegraph {
+
+// decimals of written lat/lng coordinates, trailing zeros are dropped
+static const size_t JSON_GRAPH_COORD_PREC = 10;
+
+// Streaming GeoJSON writer for line graphs. The output has the same features
+// and properties as util::geo::output::GeoGraphJsonOutput: first the nodes,
+// then the edges of each added graph. Features are formatted in parallel
+// chunks and written in their original order.
+class JsonGraphWriter {
+ public:
+  explicit JsonGraphWriter(std::ostream* out);
+  JsonGraphWriter(std::ostream* out, const util::json::Dict& props);
+
+  // add a complete line graph, may be called multiple times
+  void add(const LineGraph& g);
+
+  // close the feature collection
+  void flush();
+
+  // append a web mercator point as [lng,lat]
+  static void writeCoord(const util::geo::DPoint& p, std::string* out);
+
+  // append a number with at most JSON_GRAPH_COORD_PREC decimals
+  static void writeNum(double v, std::string* out);
+
+  // append the GeoJSON properties object of a node / edge
+  static void writeNdProps(const LineNode* nd, std::string* out);
+  static void writeEdgProps(const LineEdge* e, std::string* out);
+
+ private:
+  std::ostream* _out;
+  std::string _props;
+  bool _open = false;
+  bool _first = true;
+
+  void open();
+
+  void writeNd(const LineNode* nd, std::string* out) const;
+  void writeEdg(const LineEdge* e, std::string* out) const;
+
+  static void writeStr(const std::string& s, std::string* out);
+  static void writeId(const void* p, std::string* out);
+};
+
+}  // namespace linegraph
+}  // namespace shared
+
+#endif  // SHARED_LINEGRAPH_JSONGRAPH_H_
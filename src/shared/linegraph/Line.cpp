@@ -2,9 +2,71 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <tuple>
+
 #include "shared/linegraph/Line.h"
 
 using shared::linegraph::Line;
+using shared::linegraph::LineBands;
+
+namespace {
+std::atomic<uint32_t> nextIdx(0);
+
+// _____________________________________________________________________________
+struct Registry {
+  std::mutex m;
+  std::deque<Line> lines;
+  std::map<std::tuple<std::string, std::string, std::string, LineBands>,
+           const Line*>
+      idx;
+};
+
+// _____________________________________________________________________________
+Registry& registry() {
+  static Registry r;
+  return r;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+Line::Line(const std::string& id, const std::string& label,
+           const std::string& color)
+    : _id(id), _label(label), _color(color), _idx(nextIdx++) {}
+
+// _____________________________________________________________________________
+Line::Line(const std::string& id, const std::string& label,
+           const std::string& color, const LineBands& bands)
+    : _id(id), _label(label), _color(color), _bands(bands), _idx(nextIdx++) {}
+
+// _____________________________________________________________________________
+const Line* Line::get(const std::string& id, const std::string& label,
+                      const std::string& color) {
+  return get(id, label, color, LineBands());
+}
+
+// _____________________________________________________________________________
+const Line* Line::get(const std::string& id, const std::string& label,
+                      const std::string& color, const LineBands& bands) {
+  auto& r = registry();
+  std::lock_guard<std::mutex> lock(r.m);
+
+  // keyed by the attributes the line was created with, a later setColor()
+  // does not change the key
+  auto key = std::make_tuple(id, label, color, bands);
+  auto it = r.idx.find(key);
+  if (it != r.idx.end()) return it->second;
+
+  r.lines.emplace_back(id, label, color, bands);
+  r.idx[key] = &r.lines.back();
+  return &r.lines.back();
+}
+
+// _____________________________________________________________________________
+size_t Line::numLines() { return nextIdx; }
 
 // _____________________________________________________________________________
 const std::string& Line::id() const { return _id; }
@@ -5,25 +5,52 @@
 #ifndef SHARED_LINEGRAPH_LINE_H_
 #define SHARED_LINEGRAPH_LINE_H_
 
+#include <cstdint>
+#include <map>
 #include <string>
 #include <vector>
 
 namespace shared {
 namespace linegraph {
 
+// the number of trips in each named time band
+typedef std::map<std::string, uint32_t> LineBands;
+
 class Line {
  public:
   Line(const std::string& id, const std::string& label,
-       const std::string& color)
-      : _id(id), _label(label), _color(color) {}
+       const std::string& color);
+  Line(const std::string& id, const std::string& label,
+       const std::string& color, const LineBands& bands);
+
+  // The line with this id, label and color from a registry shared by all
+  // graphs of the process, created on first use. Lines in the registry are
+  // never freed. Thread safe.
+  static const Line* get(const std::string& id, const std::string& label,
+                         const std::string& color);
+  static const Line* get(const std::string& id, const std::string& label,
+                         const std::string& color, const LineBands& bands);
+
+  // the number of lines created so far, an upper bound for idx()
+  static size_t numLines();
 
   const std::string& id() const;
   const std::string& label() const;
   const std::string& color() const;
   void setColor(const std::string& c) { _color = c; };
 
+  // the trips of the line in each time band of the graph, empty if the
+  // graph has no time bands
+  const LineBands& bands() const { return _bands; }
+
+  // dense process-wide index of the line, for per-line arrays. A copy of a
+  // line keeps the index of the original
+  uint32_t idx() const { return _idx; }
+
  private:
   std::string _id, _label, _color;
+  LineBands _bands;
+  uint32_t _idx;
 };
 }
 }
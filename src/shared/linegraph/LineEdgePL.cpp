@@ -15,6 +15,11 @@ using shared::linegraph::LineNode;
 using shared::linegraph::LineOcc;
 using util::geo::PolyLine;
 
+// below this number of lines, lines are looked up by a linear scan instead of
+// via the line index, which saves its allocations for the typical edge. The
+// index is dropped again if the edge shrinks to half of this.
+static const size_t LINE_IDX_MIN_SIZE = 16;
+
 // _____________________________________________________________________________
 LineEdgePL::LineEdgePL() : _dontContract(false) {}
 
@@ -22,9 +27,13 @@ LineEdgePL::LineEdgePL() : _dontContract(false) {}
 LineEdgePL::LineEdgePL(const PolyLine<double>& p)
     : _dontContract(false), _p(p) {}
 
+// _____________________________________________________________________________
+LineEdgePL::LineEdgePL(PolyLine<double>&& p)
+    : _dontContract(false), _p(std::move(p)) {}
+
 // _____________________________________________________________________________
 LineEdgePL::LineEdgePL(const LineEdgePL& other)
-    : _lineToIdx(other._lineToIdx),
+    : _lineToIdx(other._lineToIdx ? new LineIdx(*other._lineToIdx) : 0),
       _lines(other._lines),
       _dontContract(other._dontContract),
       _comp(other._comp),
@@ -60,9 +69,8 @@ void LineEdgePL::setPolyline(const PolyLine<double>& p) { _p = p; }
 // _____________________________________________________________________________
 void LineEdgePL::addLine(const Line* r, const LineNode* dir,
                          util::Nullable<shared::style::LineStyle> ls) {
-  auto f = _lineToIdx.find(r);
-  if (f != _lineToIdx.end()) {
-    size_t prevIdx = f->second;
+  size_t prevIdx = findLine(r);
+  if (prevIdx < _lines.size()) {
     const auto& prev = _lines[prevIdx];
     // the route is already present in both directions, ignore newly inserted
     if (prev.direction == 0) return;
@@ -76,9 +84,15 @@ void LineEdgePL::addLine(const Line* r, const LineNode* dir,
       return;
     }
   }
-  _lineToIdx[r] = _lines.size();
-  LineOcc occ(r, dir, ls);
-  _lines.push_back(occ);
+  if (_lineToIdx) (*_lineToIdx)[r] = _lines.size();
+  _lines.emplace_back(r, dir, ls);
+
+  if (!_lineToIdx && _lines.size() > LINE_IDX_MIN_SIZE) {
+    _lineToIdx.reset(new LineIdx(_lines.size()));
+    for (size_t i = 0; i < _lines.size(); i++) {
+      (*_lineToIdx)[_lines[i].line] = i;
+    }
+  }
 }
 
 // _____________________________________________________________________________
@@ -88,10 +102,32 @@ void LineEdgePL::addLine(const Line* r, const LineNode* dir) {
 
 // _____________________________________________________________________________
 void LineEdgePL::delLine(const Line* r) {
-  _lineToIdx[_lines.back().line] = _lineToIdx.find(r)->second;
-  _lines[_lineToIdx.find(r)->second] = _lines.back();
+  size_t idx = findLine(r);
+  _lines[idx] = _lines.back();
   _lines.resize(_lines.size() - 1);
-  _lineToIdx.erase(r);
+
+  if (_lineToIdx) {
+    if (_lines.size() <= LINE_IDX_MIN_SIZE / 2) {
+      _lineToIdx.reset();
+      return;
+    }
+    if (idx < _lines.size()) (*_lineToIdx)[_lines[idx].line] = idx;
+    _lineToIdx->erase(r);
+  }
+}
+
+// _____________________________________________________________________________
+size_t LineEdgePL::findLine(const Line* r) const {
+  if (_lineToIdx) {
+    auto it = _lineToIdx->find(r);
+    if (it == _lineToIdx->end()) return _lines.size();
+    return it->second;
+  }
+
+  for (size_t i = 0; i < _lines.size(); i++) {
+    if (_lines[i].line == r) return i;
+  }
+  return _lines.size();
 }
 
 // _____________________________________________________________________________
@@ -108,6 +144,11 @@ util::json::Dict LineEdgePL::getAttrs() const {
     line["id"] = r.line->id();
     line["label"] = r.line->label();
     line["color"] = r.line->color();
+    if (!r.line->bands().empty()) {
+      util::json::Dict bands;
+      for (const auto& b : r.line->bands()) bands[b.first] = b.second;
+      line["bands"] = bands;
+    }
     if (!r.style.isNull()) {
       if (r.style.get().getCss().size()) line["style"] = r.style.get().getCss();
       if (r.style.get().getOutlineCss().size())
@@ -133,11 +174,13 @@ util::json::Dict LineEdgePL::getAttrs() const {
 }
 
 // _____________________________________________________________________________
-bool LineEdgePL::hasLine(const Line* l) const { return _lineToIdx.count(l); }
+bool LineEdgePL::hasLine(const Line* l) const {
+  return findLine(l) < _lines.size();
+}
 
 // _____________________________________________________________________________
 const LineOcc& LineEdgePL::lineOcc(const Line* l) const {
-  return _lines[_lineToIdx.find(l)->second];
+  return _lines[findLine(l)];
 }
 
 // _____________________________________________________________________________
@@ -145,22 +188,22 @@ const LineOcc& LineEdgePL::lineOccAtPos(size_t i) const { return _lines[i]; }
 
 // _____________________________________________________________________________
 void LineEdgePL::updateLineOcc(const LineOcc& occ) {
-  _lines[_lineToIdx.find(occ.line)->second] = occ;
+  _lines[findLine(occ.line)] = occ;
 }
 
 // _____________________________________________________________________________
-void LineEdgePL::writePermutation(const std::vector<size_t> order) {
+void LineEdgePL::writePermutation(const std::vector<size_t>& order) {
   std::vector<LineOcc> linesNew(_lines.size());
   for (size_t i = 0; i < order.size(); i++) {
     linesNew[i] = _lines[order[i]];
-    _lineToIdx[_lines[order[i]].line] = i;
+    if (_lineToIdx) (*_lineToIdx)[_lines[order[i]].line] = i;
   }
-  _lines = linesNew;
+  _lines = std::move(linesNew);
 }
 
 // _____________________________________________________________________________
 size_t LineEdgePL::linePos(const Line* r) const {
-  auto it = _lineToIdx.find(r);
-  if (it == _lineToIdx.end()) return -1;
-  return it->second;
+  size_t idx = findLine(r);
+  if (idx == _lines.size()) return -1;
+  return idx;
 }
@@ -5,6 +5,7 @@
 #ifndef SHARED_LINEGRAPH_LINEEDGEPL_H_
 #define SHARED_LINEGRAPH_LINEEDGEPL_H_
 
+#include <memory>
 #include <unordered_map>
 
 #include "shared/linegraph/Line.h"
@@ -43,8 +44,11 @@ inline bool operator<(const LineOcc& x, const LineOcc& y) {
 
 class LineEdgePL : util::geograph::GeoEdgePL<double> {
  public:
+  typedef std::unordered_map<const Line*, size_t> LineIdx;
+
   LineEdgePL();
   LineEdgePL(const PolyLine<double>& p);
+  LineEdgePL(PolyLine<double>&& p);
   LineEdgePL(const LineEdgePL& other);
   LineEdgePL(LineEdgePL&& other);
 
@@ -58,7 +62,7 @@ class LineEdgePL : util::geograph::GeoEdgePL<double> {
   }
 
   LineEdgePL& operator=(const LineEdgePL& other) {
-    _lineToIdx = other._lineToIdx;
+    _lineToIdx.reset(other._lineToIdx ? new LineIdx(*other._lineToIdx) : 0);
     _lines = other._lines;
     _dontContract = other._dontContract;
     _comp = other._comp;
@@ -93,18 +97,23 @@ class LineEdgePL : util::geograph::GeoEdgePL<double> {
   uint32_t getComponent() const { return _comp; }
   void setComponent(uint32_t id) { _comp = id; }
 
-  void writePermutation(const std::vector<size_t> order);
+  void writePermutation(const std::vector<size_t>& order);
 
   void setDontContract(bool dontContract) { _dontContract = dontContract; }
-  bool dontContract() { return _dontContract; }
+  bool dontContract() const { return _dontContract; }
 
  private:
-  std::unordered_map<const Line*, size_t> _lineToIdx;
+  // only allocated for edges with many lines, see findLine(). The line order
+  // is the line ordering of the edge, so _lines cannot be kept sorted.
+  std::unique_ptr<LineIdx> _lineToIdx;
   std::vector<LineOcc> _lines;
   bool _dontContract;
   uint32_t _comp = std::numeric_limits<uint32_t>::max();
 
   PolyLine<double> _p;
+
+  // position of r in _lines, or _lines.size() if not present
+  size_t findLine(const Line* r) const;
 };
 }  // namespace linegraph
 }  // namespace shared
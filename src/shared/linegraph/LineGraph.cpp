@@ -3,7 +3,8 @@
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
 #include "3rdparty/json.hpp"
-#include "dot/Parser.h"
+#include "dot/Reader.h"
+#include "shared/linegraph/BinGraph.h"
 #include "shared/linegraph/LineEdgePL.h"
 #include "shared/linegraph/LineGraph.h"
 #include "shared/linegraph/LineNodePL.h"
@@ -15,10 +16,13 @@
 #include "util/graph/Node.h"
 #include "util/log/Log.h"
 
+using shared::linegraph::BIN_GRAPH_NONE;
+using shared::linegraph::BinGraph;
 using shared::linegraph::EdgeGrid;
 using shared::linegraph::EdgeOrdering;
 using shared::linegraph::ISect;
 using shared::linegraph::Line;
+using shared::linegraph::LineBands;
 using shared::linegraph::LineEdge;
 using shared::linegraph::LineGraph;
 using shared::linegraph::LineNode;
@@ -34,103 +38,108 @@ using util::graph::Algorithm;
 void LineGraph::readFromDot(std::istream* s) {
   _bbox = util::geo::Box<double>();
 
-  dot::parser::Parser dp(s);
-  std::map<std::string, LineNode*> idMap;
+  dot::parser::Reader dp(s);
+
+  // transparent comparator, lookups by string views don't allocate
+  std::map<std::string, LineNode*, std::less<>> idMap;
+  std::string coords;
 
   size_t eid = 0;
 
   while (dp.has()) {
-    auto ent = dp.get();
+    const auto& ent = dp.get();
 
     if (ent.type == dot::parser::EMPTY) {
       continue;
     } else if (ent.type == dot::parser::NODE) {
       // only use nodes with a position
-      if (ent.attrs.find("pos") == ent.attrs.end()) continue;
-      std::string coords = ent.attrs["pos"];
+      if (!ent.has(dot::parser::POS)) continue;
+      coords.assign(ent.attrs[dot::parser::POS]);
       std::replace(coords.begin(), coords.end(), ',', ' ');
 
-      std::stringstream ss;
-      ss << coords;
-
-      double x, y;
-
-      ss >> x;
-      ss >> y;
+      char* end;
+      double x = strtod(coords.c_str(), &end);
+      double y = strtod(end, 0);
 
       LineNode* n = 0;
-      if (idMap.find(ent.ids.front()) != idMap.end()) {
-        n = idMap[ent.ids.front()];
-      }
+      auto it = idMap.find(ent.ids.front());
+      if (it != idMap.end()) n = it->second;
 
       if (!n) {
         n = addNd({util::geo::Point<double>(x, y),
                    std::numeric_limits<uint32_t>::max()});
-        idMap[ent.ids[0]] = n;
+        idMap.emplace(ent.ids.front(), n);
       }
 
       expandBBox(*n->pl().getGeom());
 
       Station i("", "", *n->pl().getGeom());
-      if (ent.attrs.find("station_id") != ent.attrs.end() ||
-          ent.attrs.find("label") != ent.attrs.end()) {
-        if (ent.attrs.find("station_id") != ent.attrs.end())
-          i.id = ent.attrs["station_id"];
-        if (ent.attrs.find("label") != ent.attrs.end())
-          i.name = ent.attrs["label"];
+      if (ent.has(dot::parser::STATION_ID) || ent.has(dot::parser::LABEL)) {
+        if (ent.has(dot::parser::STATION_ID))
+          i.id = ent.attrs[dot::parser::STATION_ID];
+        if (ent.has(dot::parser::LABEL)) i.name = ent.attrs[dot::parser::LABEL];
         n->pl().addStop(i);
       }
     } else if (ent.type == dot::parser::EDGE) {
       eid++;
-      std::string prevId = ent.ids.front();
-      if (idMap.find(prevId) == idMap.end())
-        idMap[prevId] = addNd({util::geo::Point<double>(0, 0),
-                               std::numeric_limits<uint32_t>::max()});
-
-      for (size_t i = 1; i < ent.ids.size(); ++i) {
-        std::string curId = ent.ids[i];
-
-        if (idMap.find(curId) == idMap.end())
-          idMap[curId] = addNd({util::geo::Point<double>(0, 0),
-                                std::numeric_limits<uint32_t>::max()});
-        auto e = getEdg(idMap[prevId], idMap[curId]);
-
-        if (!e) {
-          PolyLine<double> pl;
-          e = addEdg(idMap[curId], idMap[prevId], pl);
-        }
 
-        std::string id;
-        if (ent.attrs.find("id") != ent.attrs.end()) {
-          id = ent.attrs["id"];
-        } else if (ent.attrs.find("label") != ent.attrs.end()) {
-          id = ent.attrs["label"];
-        } else if (ent.attrs.find("color") != ent.attrs.end()) {
-          id = ent.attrs["color"];
-        } else {
-          id = util::toString(eid);
-        }
+      std::string id;
+      if (ent.has(dot::parser::ID)) {
+        id = ent.attrs[dot::parser::ID];
+      } else if (ent.has(dot::parser::LABEL)) {
+        id = ent.attrs[dot::parser::LABEL];
+      } else if (ent.has(dot::parser::COLOR)) {
+        id = ent.attrs[dot::parser::COLOR];
+      } else {
+        id = util::toString(eid);
+      }
 
-        const Line* r = getLine(id);
-        if (!r) {
-          std::string label = ent.attrs.find("label") == ent.attrs.end()
-                                  ? ""
-                                  : ent.attrs["label"];
-          std::string color = ent.attrs.find("color") == ent.attrs.end()
-                                  ? ""
-                                  : ent.attrs["color"];
-          r = new Line(id, label, color);
-          addLine(r);
+      const Line* r = getLine(id);
+      if (!r) {
+        std::string label(ent.has(dot::parser::LABEL)
+                              ? ent.attrs[dot::parser::LABEL]
+                              : std::string_view());
+        std::string color(ent.has(dot::parser::COLOR)
+                              ? ent.attrs[dot::parser::COLOR]
+                              : std::string_view());
+        r = Line::get(id, label, color);
+        addLine(r);
+      }
+
+      // all further nodes are connected to the first one
+      LineNode* first = 0;
+
+      for (size_t i = 0; i < ent.ids.size(); ++i) {
+        auto it = idMap.find(ent.ids[i]);
+        if (it == idMap.end()) {
+          it = idMap
+                   .emplace(ent.ids[i],
+                            addNd({util::geo::Point<double>(0, 0),
+                                   std::numeric_limits<uint32_t>::max()}))
+                   .first;
         }
 
-        LineNode* dir = 0;
+        LineNode* cur = it->second;
 
-        if (ent.graphType == dot::parser::DIGRAPH ||
-            ent.graphType == dot::parser::STRICT_DIGRAPH) {
-          dir = idMap[curId];
-        }
+        if (first) {
+          auto e = getEdg(first, cur);
+
+          if (!e) {
+            PolyLine<double> pl;
+            e = addEdg(cur, first, pl);
+          }
+
+          LineNode* dir = 0;
+
+          if (ent.graphType == dot::parser::DIGRAPH ||
+              ent.graphType == dot::parser::STRICT_DIGRAPH) {
+            dir = cur;
+          }
 
-        e->pl().addLine(r, dir);
+          e->pl().addLine(r, dir);
+        } else {
+          first = cur;
+        }
       }
     }
   }
@@ -148,16 +157,89 @@ void LineGraph::readFromDot(std::istream* s) {
   }
 
   _bbox = util::geo::pad(_bbox, 100);
-  buildGrids();
+  if (_indexed) buildGrids();
 }
 // _____________________________________________________________________________
 void LineGraph::readFromTopoJson(nlohmann::json::array_t objects,
                                  nlohmann::json::array_t arcs,
                                  bool webMercCoords) {
-  UNUSED(objects);
-  UNUSED(arcs);
-  UNUSED(webMercCoords);
-  throw(std::runtime_error("TopoJSON input not yet implemented."));
+  readFromTopoJson(objects, arcs, nlohmann::json(), webMercCoords);
+}
+
+// _____________________________________________________________________________
+void LineGraph::readFromTopoJson(nlohmann::json::array_t geoms,
+                                 const nlohmann::json::array_t& arcs,
+                                 const nlohmann::json& transform,
+                                 bool webMercCoords) {
+  bool quantized = transform.is_object();
+  double sx = 1, sy = 1, tx = 0, ty = 0;
+  if (quantized) {
+    sx = transform["scale"][0].get<double>();
+    sy = transform["scale"][1].get<double>();
+    tx = transform["translate"][0].get<double>();
+    ty = transform["translate"][1].get<double>();
+  }
+
+  // quantized arc positions are deltas to the previous position
+  std::vector<std::vector<std::vector<double>>> lines(arcs.size());
+  for (size_t i = 0; i < arcs.size(); i++) {
+    double x = 0, y = 0;
+    for (const auto& pos : arcs[i]) {
+      if (quantized) {
+        x += pos[0].get<double>();
+        y += pos[1].get<double>();
+        lines[i].push_back({x * sx + tx, y * sy + ty});
+      } else {
+        lines[i].push_back({pos[0].get<double>(), pos[1].get<double>()});
+      }
+    }
+  }
+
+  nlohmann::json::array_t features;
+  features.reserve(geoms.size());
+
+  for (auto& geom : geoms) {
+    nlohmann::json coords;
+
+    if (geom["type"] == "Point") {
+      double x = geom["coordinates"][0].get<double>();
+      double y = geom["coordinates"][1].get<double>();
+      if (quantized) {
+        x = x * sx + tx;
+        y = y * sy + ty;
+      }
+      coords = {x, y};
+    } else if (geom["type"] == "LineString") {
+      coords = nlohmann::json::array();
+      for (const auto& a : geom["arcs"]) {
+        int64_t id = a.get<int64_t>();
+        bool rev = id < 0;
+        if (rev) id = ~id;
+        if (id >= static_cast<int64_t>(lines.size())) {
+          LOG(ERROR) << "Arc " << id << " not found.";
+          continue;
+        }
+        const auto& l = lines[id];
+        // consecutive arcs share their end points
+        size_t skip = coords.empty() ? 0 : 1;
+        for (size_t i = skip; i < l.size(); i++) {
+          coords.push_back(rev ? l[l.size() - 1 - i] : l[i]);
+        }
+      }
+    } else {
+      continue;
+    }
+
+    nlohmann::json props = geom["properties"];
+    if (props.is_null()) props = nlohmann::json::object();
+
+    features.push_back(
+        {{"type", "Feature"},
+         {"geometry", {{"type", geom["type"]}, {"coordinates", coords}}},
+         {"properties", props}});
+  }
+
+  readFromGeoJson(features, webMercCoords);
 }
 
 // _____________________________________________________________________________
@@ -178,243 +260,467 @@ void LineGraph::readFromGeoJson(nlohmann::json::array_t features,
 
   std::map<std::string, LineNode*> idMap;
 
+  // first pass, nodes
+  for (auto feature : features) addGeoJsonNode(&feature, webMercCoords, &idMap);
+
+  // second pass, edges
+  for (auto feature : features) addGeoJsonEdge(&feature, webMercCoords, &idMap);
+
+  // third pass, exceptions (TODO: do this in the first part, store in some
+  // data structure, add here!)
   for (auto feature : features) {
-    auto props = feature["properties"];
-    auto geom = feature["geometry"];
-    if (geom["type"] == "Point") {
-      std::string id;
-      if (props.count("id")) id = props["id"].get<std::string>();
+    addGeoJsonNodeProps(&feature, webMercCoords, &idMap);
+  }
 
-      std::vector<double> coords = geom["coordinates"];
+  _bbox = util::geo::pad(_bbox, 100);
 
-      util::geo::DPoint point(coords[0], coords[1]);
-      if (!webMercCoords) point = util::geo::latLngToWebMerc(point);
+  if (_indexed) buildGrids();
+}
 
-      if (id.empty()) {
-        id = std::to_string(static_cast<int>(point.getX())) + "|" +
-             std::to_string(static_cast<int>(point.getY()));
-      }
+// _____________________________________________________________________________
+void LineGraph::addGeoJsonNode(nlohmann::json* f, bool webMercCoords,
+                               std::map<std::string, LineNode*>* ids) {
+  auto& feature = *f;
+  auto& idMap = *ids;
 
-      if (idMap.count(id)) continue;
+  auto props = feature["properties"];
+  auto geom = feature["geometry"];
+  if (geom["type"] == "Point") {
+    std::string id;
+    if (props.count("id")) id = props["id"].get<std::string>();
 
-      LineNode* n = addNd({point, std::numeric_limits<uint32_t>::max()});
-      expandBBox(*n->pl().getGeom());
+    std::vector<double> coords = geom["coordinates"];
 
-      if (props["component"].is_number())
-        n->pl().setComponent(props["component"].get<size_t>());
+    util::geo::DPoint point(coords[0], coords[1]);
+    if (!webMercCoords) point = util::geo::latLngToWebMerc(point);
 
-      Station i("", "", *n->pl().getGeom());
+    if (id.empty()) {
+      id = std::to_string(static_cast<int>(point.getX())) + "|" +
+           std::to_string(static_cast<int>(point.getY()));
+    }
 
-      std::string sid = getStationId(props);
-      std::string label = getStationLabel(props);
-      if (!sid.empty() || !label.empty()) {
-        i.id = sid;
-        i.name = label;
+    if (idMap.count(id)) return;
 
-        n->pl().addStop(i);
-      }
+    LineNode* n = addNd({point, std::numeric_limits<uint32_t>::max()});
+    expandBBox(*n->pl().getGeom());
+
+    if (props["component"].is_number())
+      n->pl().setComponent(props["component"].get<size_t>());
+
+    Station i("", "", *n->pl().getGeom());
+
+    std::string sid = getStationId(props);
+    std::string label = getStationLabel(props);
+    if (!sid.empty() || !label.empty()) {
+      i.id = sid;
+      i.name = label;
+      if (props["station_trips"].is_number())
+        i.trips = props["station_trips"].get<size_t>();
+      if (props["station_routes"].is_number())
+        i.routes = props["station_routes"].get<size_t>();
 
-      idMap[id] = n;
+      n->pl().addStop(i);
     }
+
+    idMap[id] = n;
   }
+}
 
-  // second pass, edges
-  for (auto feature : features) {
-    auto props = feature["properties"];
-    auto geom = feature["geometry"];
-    if (geom["type"] == "LineString") {
-      std::string from =
-          props["from"].is_null() ? "" : props["from"].get<std::string>();
-      std::string to =
-          props["to"].is_null() ? "" : props["to"].get<std::string>();
+// _____________________________________________________________________________
+void LineGraph::addGeoJsonEdge(nlohmann::json* f, bool webMercCoords,
+                               std::map<std::string, LineNode*>* ids) {
+  auto& feature = *f;
+  auto& idMap = *ids;
+
+  auto props = feature["properties"];
+  auto geom = feature["geometry"];
+  if (geom["type"] == "LineString") {
+    std::string from =
+        props["from"].is_null() ? "" : props["from"].get<std::string>();
+    std::string to =
+        props["to"].is_null() ? "" : props["to"].get<std::string>();
+
+    if (geom["coordinates"].is_null()) return;
+
+    std::vector<std::vector<double>> coords = geom["coordinates"];
+
+    size_t component = std::numeric_limits<uint32_t>::max();
+
+    if (props["component"].is_number())
+      component = props["component"].get<size_t>();
+
+    PolyLine<double> pl;
+    for (auto coord : coords) {
+      double x = coord[0], y = coord[1];
+      Point<double> p(x, y);
+      if (!webMercCoords) p = util::geo::latLngToWebMerc(p);
+      pl << p;
+      expandBBox(p);
+    }
 
-      if (geom["coordinates"].is_null()) continue;
+    if (from.empty()) {
+      from = std::to_string(static_cast<int>(pl.front().getX())) + "|" +
+             std::to_string(static_cast<int>(pl.front().getY()));
+      if (!idMap.count(from))
+        idMap[from] = addNd({pl.getLine().front(), component});
+    }
 
-      std::vector<std::vector<double>> coords = geom["coordinates"];
+    if (to.empty()) {
+      to = std::to_string(static_cast<int>(pl.back().getX())) + "|" +
+           std::to_string(static_cast<int>(pl.back().getY()));
+      if (!idMap.count(to))
+        idMap[to] = addNd({pl.getLine().back(), component});
+    }
 
-      size_t component = std::numeric_limits<uint32_t>::max();
+    // pl.applyChaikinSmooth(3);
 
-      if (props["component"].is_number())
-        component = props["component"].get<size_t>();
+    LineNode* fromN = 0;
+    LineNode* toN = 0;
 
-      PolyLine<double> pl;
-      for (auto coord : coords) {
-        double x = coord[0], y = coord[1];
-        Point<double> p(x, y);
-        if (!webMercCoords) p = util::geo::latLngToWebMerc(p);
-        pl << p;
-        expandBBox(p);
+    if (from.size()) {
+      fromN = idMap[from];
+      if (!fromN) {
+        LOG(ERROR) << "Node \"" << from << "\" not found.";
+        return;
       }
+    } else {
+      fromN = addNd({pl.getLine().front(), component});
+    }
 
-      if (from.empty()) {
-        from = std::to_string(static_cast<int>(pl.front().getX())) + "|" +
-               std::to_string(static_cast<int>(pl.front().getY()));
-        if (!idMap.count(from))
-          idMap[from] = addNd({pl.getLine().front(), component});
+    if (to.size()) {
+      toN = idMap[to];
+      if (!toN) {
+        LOG(ERROR) << "Node \"" << to << "\" not found.";
+        return;
       }
+    } else {
+      toN = addNd({pl.getLine().back(), component});
+    }
 
-      if (to.empty()) {
-        to = std::to_string(static_cast<int>(pl.back().getX())) + "|" +
-             std::to_string(static_cast<int>(pl.back().getY()));
-        if (!idMap.count(to))
-          idMap[to] = addNd({pl.getLine().back(), component});
-      }
+    if (fromN == toN) {
+      LOGTO(DEBUG, std::cerr) << "Self edges are not supported, dropping...";
+      return;
+    }
+
+    LineEdge* e = addEdg(fromN, toN, pl);
+
+    e->pl().setComponent(component);
+
+    if (props["dontcontract"].is_number() && props["dontcontract"].get<int>())
+      e->pl().setDontContract(true);
+
+    extractLines(props, e, idMap);
+
+    // if no lines were extracted, completely delete edge
+    if (e->pl().getLines().empty()) delEdg(e->getFrom(), e->getTo());
+  }
+}
+
+// _____________________________________________________________________________
+void LineGraph::addGeoJsonNodeProps(nlohmann::json* f, bool webMercCoords,
+                                    std::map<std::string, LineNode*>* ids) {
+  auto& feature = *f;
+  auto& idMap = *ids;
+
+  auto props = feature["properties"];
+  auto geom = feature["geometry"];
+  if (geom["type"] == "Point") {
+    std::string id;
+    if (props.count("id")) id = props["id"].get<std::string>();
+
+    if (id.empty()) {
+      std::vector<double> coords = geom["coordinates"];
+
+      util::geo::DPoint point(coords[0], coords[1]);
+      if (!webMercCoords) point = util::geo::latLngToWebMerc(point);
+
+      id = std::to_string(static_cast<int>(point.getX())) + "|" +
+           std::to_string(static_cast<int>(point.getY()));
+    }
+
+    if (!idMap.count(id)) return;
+    LineNode* n = idMap[id];
 
-      // pl.applyChaikinSmooth(3);
+    if (!props["not_serving"].is_null()) {
+      for (auto excl : props["not_serving"]) {
+        std::string lid = excl.get<std::string>();
 
-      LineNode* fromN = 0;
-      LineNode* toN = 0;
+        const Line* r = getLine(lid);
 
-      if (from.size()) {
-        fromN = idMap[from];
-        if (!fromN) {
-          LOG(ERROR) << "Node \"" << from << "\" not found.";
+        if (!r) {
+          LOG(WARN) << "line " << lid << " marked as not served in in node "
+                    << id << ", but no such line exists.";
           continue;
         }
-      } else {
-        fromN = addNd({pl.getLine().front(), component});
+
+        n->pl().addLineNotServed(r);
       }
+    }
 
-      if (to.size()) {
-        toN = idMap[to];
-        if (!toN) {
-          LOG(ERROR) << "Node \"" << to << "\" not found.";
+    if (!props["excluded_conn"].is_null()) {
+      for (auto excl : props["excluded_conn"]) {
+        std::string lid = excl["line"].get<std::string>();
+        std::string nid1 = excl["node_from"].get<std::string>();
+        std::string nid2 = excl["node_to"].get<std::string>();
+
+        const Line* r = getLine(lid);
+
+        if (!r) {
+          LOG(WARN) << "line connection exclude defined in node " << id
+                    << " for line " << lid << ", but no such line exists.";
           continue;
         }
-      } else {
-        toN = addNd({pl.getLine().back(), component});
-      }
 
-      if (fromN == toN) {
-        LOGTO(DEBUG, std::cerr) << "Self edges are not supported, dropping...";
-        continue;
-      }
+        if (!idMap.count(nid1)) {
+          LOG(WARN) << "line connection exclude defined in node " << id
+                    << " for edge from " << nid1
+                    << ", but no such node exists.";
+          continue;
+        }
 
-      LineEdge* e = addEdg(fromN, toN, pl);
+        if (!idMap.count(nid2)) {
+          LOG(WARN) << "line connection exclude defined in node " << id
+                    << " for edge from " << nid2
+                    << ", but no such node exists.";
+          continue;
+        }
 
-      e->pl().setComponent(component);
+        LineNode* n1 = idMap[nid1];
+        LineNode* n2 = idMap[nid2];
 
-      if (props["dontcontract"].is_number() && props["dontcontract"].get<int>())
-        e->pl().setDontContract(true);
+        LineEdge* a = getEdg(n, n1);
+        LineEdge* b = getEdg(n, n2);
 
-      extractLines(props, e, idMap);
+        if (!a) {
+          LOG(WARN) << "line connection exclude defined in node " << id
+                    << " for edge from " << nid1
+                    << ", but no such edge exists.";
+          continue;
+        }
+
+        if (!b) {
+          LOG(WARN) << "line connection exclude defined in node " << id
+                    << " for edge from " << nid2
+                    << ", but no such edge exists.";
+          continue;
+        }
 
-      // if no lines were extracted, completely delete edge
-      if (e->pl().getLines().empty()) delEdg(e->getFrom(), e->getTo());
+        n->pl().addConnExc(r, a, b);
+      }
     }
   }
+}
 
-  // third pass, exceptions (TODO: do this in the first part, store in some
-  // data structure, add here!)
-  for (auto feature : features) {
-    auto props = feature["properties"];
-    auto geom = feature["geometry"];
-    if (geom["type"] == "Point") {
-      std::string id;
-      if (props.count("id")) id = props["id"].get<std::string>();
-
-      if (id.empty()) {
-        std::vector<double> coords = geom["coordinates"];
+// _____________________________________________________________________________
+bool LineGraph::isGeoJsonEdgeResolved(
+    nlohmann::json* f, const std::map<std::string, LineNode*>& idMap) {
+  auto& props = (*f)["properties"];
+
+  // edges without explicit end nodes get nodes at their end points, which
+  // may coincide with points which have not been read yet
+  for (auto key : {"from", "to"}) {
+    if (!props[key].is_string() || !idMap.count(props[key].get<std::string>()))
+      return false;
+  }
 
-        util::geo::DPoint point(coords[0], coords[1]);
-        if (!webMercCoords) point = util::geo::latLngToWebMerc(point);
+  auto resolved = [&idMap](const nlohmann::json& line) {
+    return !line.count("direction") || !line["direction"].is_string() ||
+           idMap.count(line["direction"].get<std::string>());
+  };
 
-        id = std::to_string(static_cast<int>(point.getX())) + "|" +
-             std::to_string(static_cast<int>(point.getY()));
-      }
+  if (!props.count("lines")) return resolved(props);
 
-      if (!idMap.count(id)) continue;
-      LineNode* n = idMap[id];
+  for (const auto& line : props["lines"]) {
+    if (!resolved(line)) return false;
+  }
 
-      if (!props["not_serving"].is_null()) {
-        for (auto excl : props["not_serving"]) {
-          std::string lid = excl.get<std::string>();
+  return true;
+}
 
-          const Line* r = getLine(lid);
+// _____________________________________________________________________________
+void LineGraph::readFromJson(std::istream* s) { return readFromJson(s, false); }
 
-          if (!r) {
-            LOG(WARN) << "line " << lid << " marked as not served in in node "
-                      << id << ", but no such line exists.";
-            continue;
-          }
+// _____________________________________________________________________________
+void LineGraph::readFromJson(std::istream* s, bool useWebMercCoords) {
+  _bbox = util::geo::Box<double>();
 
-          n->pl().addLineNotServed(r);
-        }
-      }
+  std::map<std::string, LineNode*> idMap;
 
-      if (!props["excluded_conn"].is_null()) {
-        for (auto excl : props["excluded_conn"]) {
-          std::string lid = excl["line"].get<std::string>();
-          std::string nid1 = excl["node_from"].get<std::string>();
-          std::string nid2 = excl["node_to"].get<std::string>();
+  // edges whose nodes have not been read yet, and points with exceptions,
+  // which need the edges
+  std::vector<nlohmann::json> deferredEdgs;
+  std::vector<nlohmann::json> nodeProps;
 
-          const Line* r = getLine(lid);
+  bool inFeatures = false;
 
-          if (!r) {
-            LOG(WARN) << "line connection exclude defined in node " << id
-                      << " for line " << lid << ", but no such line exists.";
-            continue;
-          }
+  // the features are added to the graph as soon as they are parsed, and are
+  // then dropped from the document
+  nlohmann::json::parser_callback_t cb =
+      [&](int depth, nlohmann::json::parse_event_t ev, nlohmann::json& parsed) {
+        if (depth == 1 && ev == nlohmann::json::parse_event_t::key) {
+          inFeatures = parsed == "features";
+          return true;
+        }
 
-          if (!idMap.count(nid1)) {
-            LOG(WARN) << "line connection exclude defined in node " << id
-                      << " for edge from " << nid1
-                      << ", but no such node exists.";
-            continue;
-          }
+        if (!inFeatures || depth != 2 ||
+            ev != nlohmann::json::parse_event_t::object_end)
+          return true;
+
+        auto& geom = parsed["geometry"];
+        if (geom["type"] == "Point") {
+          addGeoJsonNode(&parsed, useWebMercCoords, &idMap);
+          auto& props = parsed["properties"];
+          if (!props["not_serving"].is_null() ||
+              !props["excluded_conn"].is_null())
+            nodeProps.push_back(std::move(parsed));
+        } else if (geom["type"] == "LineString") {
+          if (isGeoJsonEdgeResolved(&parsed, idMap))
+            addGeoJsonEdge(&parsed, useWebMercCoords, &idMap);
+          else
+            deferredEdgs.push_back(std::move(parsed));
+        }
 
-          if (!idMap.count(nid2)) {
-            LOG(WARN) << "line connection exclude defined in node " << id
-                      << " for edge from " << nid2
-                      << ", but no such node exists.";
-            continue;
-          }
+        return false;
+      };
 
-          LineNode* n1 = idMap[nid1];
-          LineNode* n2 = idMap[nid2];
+  nlohmann::json j = nlohmann::json::parse(*s, cb);
 
-          LineEdge* a = getEdg(n, n1);
-          LineEdge* b = getEdg(n, n2);
+  if (j["type"] == "FeatureCollection") {
+    for (auto& feature : deferredEdgs) {
+      addGeoJsonEdge(&feature, useWebMercCoords, &idMap);
+    }
 
-          if (!a) {
-            LOG(WARN) << "line connection exclude defined in node " << id
-                      << " for edge from " << nid1
-                      << ", but no such edge exists.";
-            continue;
-          }
+    for (auto& feature : nodeProps) {
+      addGeoJsonNodeProps(&feature, useWebMercCoords, &idMap);
+    }
 
-          if (!b) {
-            LOG(WARN) << "line connection exclude defined in node " << id
-                      << " for edge from " << nid2
-                      << ", but no such edge exists.";
-            continue;
-          }
+    _bbox = util::geo::pad(_bbox, 100);
+    if (_indexed) buildGrids();
 
-          n->pl().addConnExc(r, a, b);
-        }
+    if (j.count("properties")) _graphProps = j["properties"];
+  }
+  if (j["type"] == "Topology") {
+    nlohmann::json::array_t geoms;
+    for (auto& obj : j["objects"]) {
+      if (obj["type"] == "GeometryCollection") {
+        for (auto& geom : obj["geometries"]) geoms.push_back(std::move(geom));
+      } else {
+        geoms.push_back(std::move(obj));
       }
     }
-  }
 
-  _bbox = util::geo::pad(_bbox, 100);
+    readFromTopoJson(geoms, j["arcs"], j["transform"], useWebMercCoords);
 
-  buildGrids();
+    if (j.count("properties")) _graphProps = j["properties"];
+  }
 }
 
 // _____________________________________________________________________________
-void LineGraph::readFromJson(std::istream* s) { return readFromJson(s, false); }
+void LineGraph::readFromBin(std::istream* s) {
+  std::vector<LineNode*> nds;
+  std::vector<LineEdge*> edgs;
+  readFromBin(s, &nds, &edgs);
+}
 
 // _____________________________________________________________________________
-void LineGraph::readFromJson(std::istream* s, bool useWebMercCoords) {
-  nlohmann::json j;
-  (*s) >> j;
+void LineGraph::readFromBin(std::istream* s, std::vector<LineNode*>* ndsOut,
+                            std::vector<LineEdge*>* edgsOut) {
+  _bbox = util::geo::Box<double>();
 
-  if (j["type"] == "FeatureCollection") {
-    readFromGeoJson(j["features"], useWebMercCoords);
-    if (j.count("properties")) _graphProps = j["properties"];
+  BinGraph bg;
+  readBinGraph(s, &bg);
+
+  if (!bg.props.empty()) _graphProps = nlohmann::json::parse(bg.props);
+
+  std::vector<const Line*> lines(bg.lines.size());
+  for (size_t i = 0; i < bg.lines.size(); i++) {
+    const auto& bl = bg.lines[i];
+    const Line* l = getLine(bl.id);
+    if (!l) {
+      l = Line::get(bl.id, bl.label, bl.color, bl.bands);
+      addLine(l);
+    }
+    lines[i] = l;
+  }
+
+  auto& nds = *ndsOut;
+  nds.assign(bg.ndPos.size(), 0);
+  edgsOut->assign(bg.edgFr.size(), 0);
+  for (size_t i = 0; i < bg.ndPos.size(); i++) {
+    nds[i] = addNd({bg.ndPos[i], bg.ndComp[i]});
+    expandBBox(bg.ndPos[i]);
+
+    for (size_t j = bg.ndStatOffs[i]; j < bg.ndStatOffs[i + 1]; j++) {
+      const auto& bs = bg.stations[j];
+      Station st(bs.id, bs.label, bg.ndPos[i]);
+      st.trips = bs.trips;
+      st.routes = bs.routes;
+      nds[i]->pl().addStop(st);
+    }
   }
-  if (j["type"] == "Topology")
-    readFromTopoJson(j["objects"], j["arcs"], useWebMercCoords);
+
+  for (size_t i = 0; i < bg.edgFr.size(); i++) {
+    auto fromN = nds[bg.edgFr[i]];
+    auto toN = nds[bg.edgTo[i]];
+
+    if (fromN == toN) {
+      LOGTO(DEBUG, std::cerr) << "Self edges are not supported, dropping...";
+      continue;
+    }
+
+    PolyLine<double> pl(util::geo::Line<double>(
+        bg.geoms.begin() + bg.edgGeomOffs[i],
+        bg.geoms.begin() + bg.edgGeomOffs[i + 1]));
+
+    for (const auto& p : pl.getLine()) expandBBox(p);
+
+    LineEdge* e = addEdg(fromN, toN, pl);
+    e->pl().setComponent(bg.edgComp[i]);
+    if (bg.edgDontContract[i]) e->pl().setDontContract(true);
+
+    for (size_t j = bg.edgOccOffs[i]; j < bg.edgOccOffs[i + 1]; j++) {
+      const auto& lo = bg.occs[j];
+      LineNode* dir = lo.dir == BIN_GRAPH_NONE ? 0 : nds[lo.dir];
+      if (lo.style.size() || lo.outlineStyle.size()) {
+        shared::style::LineStyle ls;
+        if (lo.style.size()) ls.setCss(lo.style);
+        if (lo.outlineStyle.size()) ls.setOutlineCss(lo.outlineStyle);
+        e->pl().addLine(lines[lo.line], dir, ls);
+      } else {
+        e->pl().addLine(lines[lo.line], dir);
+      }
+    }
+
+    // if no lines were extracted, completely delete edge
+    if (e->pl().getLines().empty())
+      delEdg(e->getFrom(), e->getTo());
+    else
+      (*edgsOut)[i] = e;
+  }
+
+  for (size_t i = 0; i < bg.ndPos.size(); i++) {
+    for (size_t j = bg.ndNotServedOffs[i]; j < bg.ndNotServedOffs[i + 1]; j++) {
+      nds[i]->pl().addLineNotServed(lines[bg.notServed[j]]);
+    }
+
+    for (size_t j = bg.ndExcOffs[i]; j < bg.ndExcOffs[i + 1]; j++) {
+      const auto& ex = bg.excs[j];
+      LineEdge* a = getEdg(nds[i], nds[ex.ndFrom]);
+      LineEdge* b = getEdg(nds[i], nds[ex.ndTo]);
+
+      if (!a || !b) {
+        LOG(WARN) << "line connection exclude defined in node "
+                  << nds[i]->pl().toString() << " for line "
+                  << lines[ex.line]->id() << ", but no such edge exists.";
+        continue;
+      }
+
+      nds[i]->pl().addConnExc(lines[ex.line], a, b);
+    }
+  }
+
+  _bbox = util::geo::pad(_bbox, 100);
+  if (_indexed) buildGrids();
 }
 
 // _____________________________________________________________________________
@@ -431,6 +737,13 @@ void LineGraph::buildGrids() {
   }
 }
 
+// _____________________________________________________________________________
+void LineGraph::buildIndex() {
+  if (_indexed) return;
+  _indexed = true;
+  buildGrids();
+}
+
 // _____________________________________________________________________________
 void LineGraph::expandBBox(const Point<double>& p) {
   _bbox = util::geo::extendBox(p, _bbox);
@@ -439,54 +752,116 @@ void LineGraph::expandBBox(const Point<double>& p) {
 // _____________________________________________________________________________
 const util::geo::DBox& LineGraph::getBBox() const { return _bbox; }
 
+// _____________________________________________________________________________
+void LineGraph::setBBox(const util::geo::DBox& box) { _bbox = box; }
+
 // _____________________________________________________________________________
 void LineGraph::topologizeIsects() {
-  proced.clear();
-  while (getNextIntersection().a) {
-    auto i = getNextIntersection();
-    auto x = addNd({i.bp.p, i.a->pl().getComponent()});
+  // all crossings are collected first, and every crossed edge is then split
+  // at all of its crossings at once
+
+  std::vector<LineEdge*> edgs;
+  std::unordered_map<const LineEdge*, size_t> edgIdx;
+
+  for (auto n : getNds()) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      edgIdx[e] = edgs.size();
+      edgs.push_back(e);
+    }
+  }
+
+  // split positions on an edge, with the node at this position
+  std::unordered_map<const LineEdge*, std::vector<std::pair<double, LineNode*>>>
+      cuts;
+
+  for (auto e1 : edgs) {
+    std::set<LineEdge*> neighbors;
+    _edgeGrid.getNeighbors(e1, 0, &neighbors);
+
+    for (auto e2 : neighbors) {
+      // check every pair only once
+      if (edgIdx.find(e2)->second <= edgIdx.find(e1)->second) continue;
 
-    double pa = i.a->pl().getPolyline().projectOn(i.bp.p).totalPos;
+      auto shrdNd = sharedNode(e1, e2);
+      std::vector<util::geo::DPoint> found;
+
+      const auto& pl1 = e1->pl().getPolyline();
+      const auto& pl2 = e2->pl().getPolyline();
+
+      for (const auto& is : pl1.getIntersections(pl2)) {
+        // if the intersection is near a shared node, ignore
+        if (shrdNd && util::geo::dist(*shrdNd->pl().getGeom(), is.p) < 100) {
+          continue;
+        }
+
+        // the same for intersections near an intersection of both edges
+        // which has already been found
+        bool near = false;
+        for (const auto& p : found) {
+          if (util::geo::dist(p, is.p) < 100) near = true;
+        }
+        if (near) continue;
+
+        double p1 = pl1.projectOn(is.p).totalPos;
+        double p2 = pl2.projectOn(is.p).totalPos;
+
+        if (p1 <= 0.001 || 1 - p1 <= 0.001) continue;
+        if (p2 <= 0.001 || 1 - p2 <= 0.001) continue;
+
+        found.push_back(is.p);
+
+        auto x = addNd({is.p, e1->pl().getComponent()});
+        cuts[e1].push_back({p1, x});
+        cuts[e2].push_back({p2, x});
+      }
+    }
+  }
 
-    auto ba = addEdg(i.b->getFrom(), x, i.b->pl());
-    ba->pl().setPolyline(i.b->pl().getPolyline().getSegment(0, i.bp.totalPos));
+  for (auto e : edgs) {
+    auto it = cuts.find(e);
+    if (it == cuts.end()) continue;
 
-    auto bb = addEdg(x, i.b->getTo(), i.b->pl());
-    bb->pl().setPolyline(i.b->pl().getPolyline().getSegment(i.bp.totalPos, 1));
+    auto& edgCuts = it->second;
+    std::sort(edgCuts.begin(), edgCuts.end(),
+              [](const std::pair<double, LineNode*>& a,
+                 const std::pair<double, LineNode*>& b) {
+                return a.first < b.first;
+              });
 
-    edgeRpl(i.b->getFrom(), i.b, ba);
-    edgeRpl(i.b->getTo(), i.b, bb);
+    auto fr = e->getFrom();
+    auto to = e->getTo();
 
-    nodeRpl(ba, i.b->getTo(), x);
-    nodeRpl(bb, i.b->getFrom(), x);
+    LineNode* lastNd = fr;
+    double lastPos = 0;
+    LineEdge* first = 0;
+    LineEdge* cur = 0;
 
-    _edgeGrid.add(*ba->pl().getGeom(), ba);
-    _edgeGrid.add(*bb->pl().getGeom(), bb);
+    for (size_t i = 0; i <= edgCuts.size(); i++) {
+      auto nd = i < edgCuts.size() ? edgCuts[i].second : to;
+      double pos = i < edgCuts.size() ? edgCuts[i].first : 1;
 
-    auto aa = addEdg(i.a->getFrom(), x, i.a->pl());
-    aa->pl().setPolyline(i.a->pl().getPolyline().getSegment(0, pa));
-    auto ab = addEdg(x, i.a->getTo(), i.a->pl());
-    ab->pl().setPolyline(i.a->pl().getPolyline().getSegment(pa, 1));
+      cur = addEdg(lastNd, nd, e->pl());
+      cur->pl().setPolyline(e->pl().getPolyline().getSegment(lastPos, pos));
 
-    edgeRpl(i.a->getFrom(), i.a, aa);
-    edgeRpl(i.a->getTo(), i.a, ab);
+      // line directions now point to the ends of the segment
+      nodeRpl(cur, to, nd);
+      nodeRpl(cur, fr, lastNd);
 
-    nodeRpl(aa, i.b->getTo(), x);
-    nodeRpl(ab, i.b->getFrom(), x);
+      _edgeGrid.add(*cur->pl().getGeom(), cur);
 
-    _edgeGrid.remove(aa);
-    _edgeGrid.remove(ab);
+      if (!first) first = cur;
+      lastNd = nd;
+      lastPos = pos;
+    }
 
-    _edgeGrid.add(*aa->pl().getGeom(), aa);
-    _edgeGrid.add(*ab->pl().getGeom(), ab);
+    edgeRpl(fr, e, first);
+    edgeRpl(to, e, cur);
 
-    _edgeGrid.remove(i.a);
-    _edgeGrid.remove(i.b);
+    _edgeGrid.remove(e);
 
-    assert(getEdg(i.a->getFrom(), i.a->getTo()));
-    assert(getEdg(i.b->getFrom(), i.b->getTo()));
-    delEdg(i.a->getFrom(), i.a->getTo());
-    delEdg(i.b->getFrom(), i.b->getTo());
+    assert(getEdg(fr, to));
+    delEdg(fr, to);
   }
 }
 
@@ -499,50 +874,6 @@ std::set<LineEdge*> LineGraph::getNeighborEdges(const util::geo::DLine& line,
   return neighbors;
 }
 
-// _____________________________________________________________________________
-ISect LineGraph::getNextIntersection() {
-  for (auto n1 : getNds()) {
-    for (auto e1 : n1->getAdjList()) {
-      if (e1->getFrom() != n1) continue;
-      if (proced.find(e1) != proced.end()) continue;
-
-      std::set<LineEdge*> neighbors;
-      _edgeGrid.getNeighbors(e1, 0, &neighbors);
-
-      for (auto e2 : neighbors) {
-        if (proced.find(e2) != proced.end()) continue;
-        if (e1 != e2) {
-          auto is =
-              e1->pl().getPolyline().getIntersections(e2->pl().getPolyline());
-
-          if (is.size()) {
-            ISect ret;
-            ret.a = e1;
-            ret.b = e2;
-            ret.bp = *is.begin();
-            // if the intersection is near a shared node, ignore
-            auto shrdNd = sharedNode(e1, e2);
-            if (shrdNd &&
-                util::geo::dist(*shrdNd->pl().getGeom(), ret.bp.p) < 100) {
-              continue;
-            }
-
-            if (ret.bp.totalPos > 0.001 && 1 - ret.bp.totalPos > 0.001) {
-              return ret;
-            }
-          }
-        }
-      }
-      proced.insert(e1);
-    }
-  }
-
-  ISect ret;
-  ret.a = 0;
-  ret.b = 0;
-  return ret;
-}
-
 // _____________________________________________________________________________
 void LineGraph::addLine(const Line* l) { _lines[l->id()] = l; }
 
@@ -1020,7 +1351,7 @@ void LineGraph::contractStrayNds() {
 }
 
 // _____________________________________________________________________________
-void LineGraph::contractEdge(LineEdge* e) {
+LineNode* LineGraph::contractEdge(LineEdge* e) {
   auto n1 = e->getFrom();
   auto n2 = e->getTo();
   auto otherP = n2->pl().getGeom();
@@ -1049,6 +1380,8 @@ void LineGraph::contractEdge(LineEdge* e) {
   }
 
   n->pl().setGeom(newGeom);
+
+  return n;
 }
 
 // _____________________________________________________________________________
@@ -1216,47 +1549,76 @@ void LineGraph::contractEdges(double d) { contractEdges(d, false); }
 
 // _____________________________________________________________________________
 void LineGraph::contractEdges(double d, bool onlyNonStatConns) {
-  // TODO: the problem here is that contractEdge(e) may delete and replace edges
-  // in the graph, which is why we cannot just build a list of edges eligible
-  // for contraction and iterate over it - we would have to record the changes
-  // made in contractEdge(e) and propagate it back.
-
-  std::vector<std::pair<size_t, LineEdge*>> cands;
-
-breakfor:
-  cands.clear();
+  // contractEdge(e) deletes and replaces the edges around the merged nodes,
+  // so the candidates are kept in an ordered set and the entries of all
+  // edges whose degrees or eligibility may change are removed before each
+  // contraction and re-evaluated afterwards. This always contracts the same
+  // edge as a full rescan after each contraction would.
+
+  // first contract edges with lower number of adjacent nodes, on ties use
+  // shorter edge
+  std::set<std::pair<size_t, LineEdge*>> cands;
+  std::unordered_map<LineEdge*, size_t> candKey;
+
+  auto add = [&](LineEdge* e) {
+    auto n1 = e->getFrom();
+    if (onlyNonStatConns && (e->getFrom()->pl().stops().size() ||
+                             e->getTo()->pl().stops().size()))
+      return;
+
+    if (!e->pl().dontContract() && e->pl().getPolyline().shorterThan(d)) {
+      if (e->getOtherNd(n1)->getAdjList().size() > 1 &&
+          (n1->pl().stops().size() == 0 || n1->getAdjList().size() > 1) &&
+          (n1->pl().stops().size() == 0 ||
+           e->getOtherNd(n1)->pl().stops().size() == 0 ||
+           n1->pl().stops().front().name ==
+               e->getOtherNd(n1)->pl().stops().front().name)) {
+        size_t key = e->getFrom()->getDeg() + e->getTo()->getDeg() +
+                     e->pl().getPolyline().getLength();
+        cands.insert({key, e});
+        candKey[e] = key;
+      }
+    }
+  };
+
+  auto remove = [&](LineEdge* e) {
+    auto it = candKey.find(e);
+    if (it == candKey.end()) return;
+    cands.erase({it->second, e});
+    candKey.erase(it);
+  };
+
+  // the merged nodes and their neighbors
+  auto around = [](std::initializer_list<LineNode*> nds) {
+    std::set<LineNode*> ret;
+    for (auto nd : nds) {
+      ret.insert(nd);
+      for (auto e : nd->getAdjList()) ret.insert(e->getOtherNd(nd));
+    }
+    return ret;
+  };
 
   for (auto n1 : getNds()) {
     for (auto e : n1->getAdjList()) {
       if (e->getFrom() != n1) continue;
-      if (onlyNonStatConns && (e->getFrom()->pl().stops().size() ||
-                               e->getTo()->pl().stops().size()))
-        continue;
-      if (onlyNonStatConns && (e->getFrom()->pl().stops().size() ||
-                               e->getTo()->pl().stops().size()))
-        continue;
-
-      if (!e->pl().dontContract() && e->pl().getPolyline().shorterThan(d)) {
-        if (e->getOtherNd(n1)->getAdjList().size() > 1 &&
-            (n1->pl().stops().size() == 0 || n1->getAdjList().size() > 1) &&
-            (n1->pl().stops().size() == 0 ||
-             e->getOtherNd(n1)->pl().stops().size() == 0 ||
-             n1->pl().stops().front().name ==
-                 e->getOtherNd(n1)->pl().stops().front().name)) {
-          // first contract edges with lower number of adjacent nodes,
-          // on ties use shorter edge
-          cands.push_back({e->getFrom()->getDeg() + e->getTo()->getDeg() +
-                               e->pl().getPolyline().getLength(),
-                           e});
-        }
-      }
+      add(e);
     }
   }
 
-  std::sort(cands.begin(), cands.end());
-  for (auto e : cands) {
-    contractEdge(e.second);
-    goto breakfor;
+  while (!cands.empty()) {
+    auto e = cands.begin()->second;
+
+    for (auto nd : around({e->getFrom(), e->getTo()})) {
+      for (auto f : nd->getAdjList()) remove(f);
+    }
+
+    auto n = contractEdge(e);
+
+    for (auto nd : around({n})) {
+      for (auto f : nd->getAdjList()) {
+        if (!candKey.count(f)) add(f);
+      }
+    }
   }
 }
 
@@ -1458,7 +1820,14 @@ void LineGraph::extractLine(const nlohmann::json::object_t& line, LineEdge* e,
 
   const Line* l = getLine(id);
   if (!l) {
-    l = new Line(id, label, color);
+    LineBands bands;
+    auto b = line.find("bands");
+    if (b != line.end() && b->second.is_object()) {
+      for (const auto& band : b->second.items()) {
+        bands[band.key()] = band.value().get<uint32_t>();
+      }
+    }
+    l = Line::get(id, label, color, bands);
     addLine(l);
   }
 
@@ -1480,6 +1849,73 @@ void LineGraph::extractLine(const nlohmann::json::object_t& line, LineEdge* e,
   }
 }
 
+// _____________________________________________________________________________
+std::vector<std::vector<LineNode*>> LineGraph::distComponents(double d) const {
+  // union-find over the nodes, the root of each set is its first node
+  std::vector<LineNode*> nds(getNds().begin(), getNds().end());
+  std::unordered_map<const LineNode*, size_t> ndIdx;
+  for (size_t i = 0; i < nds.size(); i++) ndIdx[nds[i]] = i;
+
+  std::vector<size_t> par(nds.size());
+  for (size_t i = 0; i < par.size(); i++) par[i] = i;
+
+  auto find = [&par](size_t i) {
+    while (par[i] != i) {
+      par[i] = par[par[i]];
+      i = par[i];
+    }
+    return i;
+  };
+
+  auto unite = [&par, &find](size_t a, size_t b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return;
+    if (a < b) {
+      par[b] = a;
+    } else {
+      par[a] = b;
+    }
+  };
+
+  for (size_t i = 0; i < nds.size(); i++) {
+    for (auto e : nds[i]->getAdjList()) {
+      if (e->getFrom() != nds[i]) continue;
+      unite(i, ndIdx.find(e->getTo())->second);
+    }
+  }
+
+  // connect each node with nodes within distance
+  for (size_t i = 0; i < nds.size(); i++) {
+    std::set<LineNode*> cands;
+    _nodeGrid.get(*nds[i]->pl().getGeom(), d, &cands);
+
+    for (auto cand : cands) {
+      auto j = ndIdx.find(cand);
+      if (j == ndIdx.end() || find(i) == find(j->second)) continue;
+      if (util::geo::dist(*nds[i]->pl().getGeom(), *cand->pl().getGeom()) <=
+          d) {
+        unite(i, j->second);
+      }
+    }
+  }
+
+  // components are ordered by their first node, as in connectedComponents()
+  std::vector<std::vector<LineNode*>> ret;
+  std::vector<size_t> compIdx(nds.size());
+
+  for (size_t i = 0; i < nds.size(); i++) {
+    size_t root = find(i);
+    if (root == i) {
+      compIdx[i] = ret.size();
+      ret.push_back({});
+    }
+    ret[compIdx[root]].push_back(nds[i]);
+  }
+
+  return ret;
+}
+
 // _____________________________________________________________________________
 std::vector<LineGraph> LineGraph::distConnectedComponents(double d,
                                                           bool write) {
@@ -1495,38 +1931,7 @@ std::vector<LineGraph> LineGraph::distConnectedComponents(double d, bool write,
 
   if (offset) idOffset = *offset;
 
-  // first pass, collect components
-  const auto& origComps = Algorithm::connectedComponents(*this);
-  std::unordered_map<LineNode*, size_t> ndToComp;
-  for (size_t comp = 0; comp < origComps.size(); comp++) {
-    for (auto nd : origComps[comp]) {
-      ndToComp[nd] = comp;
-    }
-  }
-
-  std::vector<LineEdge*> addedEdgs;
-
-  for (auto nd : getNds()) {
-    // connect each node with nodes within distance
-    std::set<LineNode*> cands;
-    _nodeGrid.get(*nd->pl().getGeom(), d, &cands);
-
-    for (auto cand : cands) {
-      if (cand != nd && !getEdg(nd, cand) && !getEdg(cand, nd) &&
-          ndToComp[nd] != ndToComp[cand] &&
-          util::geo::dist(*nd->pl().getGeom(), *cand->pl().getGeom()) <= d) {
-        addedEdgs.push_back(addEdg(nd, cand));
-      }
-    }
-  }
-
-  const auto& geoComps = Algorithm::connectedComponents(*this);
-
-  // delete the newly added edges
-  for (auto e : addedEdgs) {
-    _edgeGrid.remove(e);
-    delEdg(e->getFrom(), e->getTo());
-  }
+  const auto& geoComps = distComponents(d);
 
   ret.resize(geoComps.size());
 
@@ -1569,65 +1974,263 @@ std::vector<LineGraph> LineGraph::distConnectedComponents(double d, bool write,
   return ret;
 }
 
+// _____________________________________________________________________________
+std::vector<LineGraph> LineGraph::splitDistConnectedComponents(double d,
+                                                               bool write) {
+  const auto& geoComps = distComponents(d);
+
+  std::vector<LineGraph> ret(geoComps.size());
+
+  for (size_t comp = 0; comp < geoComps.size(); comp++) {
+    auto* tg = &ret[comp];
+
+    // edges without lines are not part of any component
+    std::vector<LineEdge*> empty;
+
+    for (auto nd : geoComps[comp]) {
+      for (auto edg : nd->getAdjList()) {
+        if (edg->getFrom() != nd) continue;
+        if (write) edg->pl().setComponent(comp);
+        if (edg->pl().getLines().size() == 0) {
+          empty.push_back(edg);
+          continue;
+        }
+
+        tg->expandBBox(edg->pl().getGeom()->front());
+        tg->expandBBox(edg->pl().getGeom()->back());
+      }
+    }
+
+    for (auto edg : empty) delEdg(edg->getFrom(), edg->getTo());
+
+    // node pointers stay the same, so the line directions and turn
+    // exceptions need no update
+    for (auto nd : geoComps[comp]) {
+      if (write) nd->pl().setComponent(comp);
+      tg->_nodes.insert(nd);
+      tg->expandBBox(*nd->pl().getGeom());
+    }
+  }
+
+  // the nodes are now owned by the components
+  _nodes.clear();
+  buildGrids();
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void LineGraph::absorb(LineGraph* g) {
+  for (auto nd : g->_nodes) {
+    _nodes.insert(nd);
+    expandBBox(*nd->pl().getGeom());
+    for (auto edg : nd->getAdjList()) {
+      if (edg->getFrom() != nd) continue;
+      expandBBox(edg->pl().getGeom()->front());
+      expandBBox(edg->pl().getGeom()->back());
+    }
+  }
+
+  // the nodes are now owned by this graph
+  g->_nodes.clear();
+  g->buildGrids();
+}
+
+// _____________________________________________________________________________
+void LineGraph::keepLines(const std::set<const Line*>& lines) {
+  std::vector<LineEdge*> toDelEdgs;
+
+  for (auto nd : getNds()) {
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+
+      std::vector<const Line*> toDel;
+      for (const auto& lo : e->pl().getLines()) {
+        if (!lines.count(lo.line)) toDel.push_back(lo.line);
+      }
+
+      for (auto del : toDel) {
+        for (auto other : e->getFrom()->getAdjList())
+          e->getFrom()->pl().delConnExc(del, e, other);
+        for (auto other : e->getTo()->getAdjList())
+          e->getTo()->pl().delConnExc(del, e, other);
+        e->pl().delLine(del);
+      }
+
+      if (e->pl().getLines().size() == 0) toDelEdgs.push_back(e);
+    }
+
+    std::vector<const Line*> notServedToDel;
+    for (auto l : nd->pl().getLinesNotServed()) {
+      if (!lines.count(l)) notServedToDel.push_back(l);
+    }
+    for (auto l : notServedToDel) nd->pl().delLineNotServed(l);
+  }
+
+  delEdgs(toDelEdgs);
+
+  std::vector<LineNode*> toDelNds;
+  for (auto nd : getNds()) {
+    if (nd->getDeg() == 0) toDelNds.push_back(nd);
+  }
+  for (auto nd : toDelNds) delNd(nd);
+}
+
+// _____________________________________________________________________________
+void LineGraph::clip(const util::geo::DBox& box) {
+  // with an index, only the candidates of the edge grid have to be checked
+  std::set<LineEdge*> cands;
+  if (_indexed) _edgeGrid.get(box, &cands);
+
+  std::vector<LineEdge*> toDelEdgs;
+  for (auto nd : getNds()) {
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      if ((!_indexed || cands.count(e)) &&
+          util::geo::intersects(*e->pl().getGeom(), box)) {
+        continue;
+      }
+      toDelEdgs.push_back(e);
+    }
+  }
+
+  delEdgs(toDelEdgs);
+
+  std::vector<LineNode*> toDelNds;
+  for (auto nd : getNds()) {
+    if (nd->getDeg() == 0 && !util::geo::contains(*nd->pl().getGeom(), box)) {
+      toDelNds.push_back(nd);
+    }
+  }
+  for (auto nd : toDelNds) delNd(nd);
+
+  _bbox = util::geo::DBox();
+  for (auto nd : getNds()) {
+    expandBBox(*nd->pl().getGeom());
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      _bbox = util::geo::extendBox(*e->pl().getGeom(), _bbox);
+    }
+  }
+
+  if (_indexed) buildGrids();
+}
+
+// _____________________________________________________________________________
+void LineGraph::delEdgs(const std::vector<LineEdge*>& edgs) {
+  for (auto e : edgs) {
+    // remove remaining restrictions referring to the edge
+    for (auto nd : {e->getFrom(), e->getTo()}) {
+      std::vector<const Line*> restrLines;
+      for (const auto& ex : nd->pl().getConnExc()) {
+        restrLines.push_back(ex.first);
+      }
+      for (auto l : restrLines) {
+        for (auto other : nd->getAdjList()) nd->pl().delConnExc(l, e, other);
+      }
+    }
+
+    delEdg(e->getFrom(), e->getTo());
+  }
+}
+
 // _____________________________________________________________________________
 void LineGraph::snapOrphanStations() {
   double MAXD = 1;
 
+  std::vector<LineNode*> orphans;
   for (auto nd : getNds()) {
     if (nd->getDeg() != 0 || nd->pl().stops().size() == 0) continue;
+    orphans.push_back(nd);
+  }
 
+  // the edges within MAXD of each orphan, in the order of the grid result
+  auto near = [this, MAXD](const LineNode* nd) {
     std::set<LineEdge*> cands;
-
     _edgeGrid.get(*nd->pl().getGeom(), MAXD * 2, &cands);
 
+    std::vector<LineEdge*> ret;
     for (auto e : cands) {
       if (util::geo::dist(*nd->pl().getGeom(), *e->pl().getGeom()) <= MAXD) {
-        double pa =
-            e->pl().getPolyline().projectOn(*nd->pl().getGeom()).totalPos;
-        if (getEdg(e->getFrom(), nd) || getEdg(nd, e->getTo())) continue;
+        ret.push_back(e);
+      }
+    }
+    return ret;
+  };
 
-        assert(e->getFrom() != nd);
-        assert(e->getTo() != nd);
+  std::vector<std::vector<LineEdge*>> nearEdgs(orphans.size());
 
-        auto ba = addEdg(e->getFrom(), nd, e->pl());
-        ba->pl().setPolyline(e->pl().getPolyline().getSegment(0, pa));
+#pragma omp parallel for schedule(dynamic, 16) if (orphans.size() > 64)
+  for (size_t i = 0; i < orphans.size(); i++) nearEdgs[i] = near(orphans[i]);
 
-        auto bb = addEdg(nd, e->getTo(), e->pl());
-        bb->pl().setPolyline(e->pl().getPolyline().getSegment(pa, 1));
+  // split edges are replaced by two parts which are not farther away from
+  // another orphan than the original edge, so the candidates of an orphan
+  // only have to be searched again if one of them was split
+  std::set<LineEdge*> split;
 
-        edgeRpl(e->getFrom(), e, ba);
-        edgeRpl(e->getTo(), e, bb);
+  for (size_t i = 0; i < orphans.size(); i++) {
+    auto nd = orphans[i];
 
-        nodeRpl(ba, e->getTo(), nd);
-        nodeRpl(bb, e->getFrom(), nd);
+    for (auto e : nearEdgs[i]) {
+      if (split.count(e)) {
+        nearEdgs[i] = near(nd);
+        break;
+      }
+    }
 
-        assert(ba != bb);
+    for (auto e : nearEdgs[i]) {
+      double pa =
+          e->pl().getPolyline().projectOn(*nd->pl().getGeom()).totalPos;
+      if (getEdg(e->getFrom(), nd) || getEdg(nd, e->getTo())) continue;
 
-        _edgeGrid.add(*ba->pl().getGeom(), ba);
-        _edgeGrid.add(*bb->pl().getGeom(), bb);
+      assert(e->getFrom() != nd);
+      assert(e->getTo() != nd);
 
-        _edgeGrid.remove(e);
+      auto ba = addEdg(e->getFrom(), nd, e->pl());
+      ba->pl().setPolyline(e->pl().getPolyline().getSegment(0, pa));
 
-        assert(getEdg(e->getFrom(), e->getTo()));
-        delEdg(e->getFrom(), e->getTo());
-      }
+      auto bb = addEdg(nd, e->getTo(), e->pl());
+      bb->pl().setPolyline(e->pl().getPolyline().getSegment(pa, 1));
+
+      edgeRpl(e->getFrom(), e, ba);
+      edgeRpl(e->getTo(), e, bb);
+
+      nodeRpl(ba, e->getTo(), nd);
+      nodeRpl(bb, e->getFrom(), nd);
+
+      assert(ba != bb);
+
+      _edgeGrid.add(*ba->pl().getGeom(), ba);
+      _edgeGrid.add(*bb->pl().getGeom(), bb);
+
+      _edgeGrid.remove(e);
+
+      assert(getEdg(e->getFrom(), e->getTo()));
+      delEdg(e->getFrom(), e->getTo());
+      split.insert(e);
     }
   }
 }
 
 // _____________________________________________________________________________
 void LineGraph::smooth(double smooth) {
+  std::vector<LineEdge*> edgs;
   for (auto n : getNds()) {
     for (auto e : n->getAdjList()) {
-      if (e->getFrom() != n) continue;
-      auto pl = e->pl().getPolyline();
-      pl.smoothenOutliers(50);
-      pl.simplify(smooth);
-      pl.applyChaikinSmooth(3);
-      pl.simplify(1);
-      e->pl().setPolyline(pl);
+      if (e->getFrom() == n) edgs.push_back(e);
     }
   }
+
+  // each edge is smoothed independently
+#pragma omp parallel for schedule(dynamic, 16) if (edgs.size() > 64)
+  for (size_t i = 0; i < edgs.size(); i++) {
+    auto pl = edgs[i]->pl().getPolyline();
+    pl.smoothenOutliers(50);
+    pl.simplify(smooth);
+    pl.applyChaikinSmooth(3);
+    pl.simplify(1);
+    edgs[i]->pl().setPolyline(pl);
+  }
 }
 
 // _____________________________________________________________________________
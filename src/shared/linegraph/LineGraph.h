@@ -47,10 +47,10 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
 
   LineGraph(LineGraph&& other) {
     _bbox = other._bbox;
-    proced = other.proced;
-    _lines = other._lines;
+    _lines = std::move(other._lines);
     _nodeGrid = std::move(other._nodeGrid);
     _edgeGrid = std::move(other._edgeGrid);
+    _indexed = other._indexed;
 
     _graphProps = std::move(other._graphProps);
 
@@ -62,10 +62,10 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
 
   LineGraph& operator=(LineGraph&& other) {
     _bbox = other._bbox;
-    proced = other.proced;
-    _lines = other._lines;
+    _lines = std::move(other._lines);
     _nodeGrid = std::move(other._nodeGrid);
     _edgeGrid = std::move(other._edgeGrid);
+    _indexed = other._indexed;
 
     _graphProps = std::move(other._graphProps);
 
@@ -85,11 +85,25 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
   virtual void readFromGeoJson(nlohmann::json::array_t, bool useWebMerc);
   virtual void readFromTopoJson(nlohmann::json::array_t objects,
                                 nlohmann::json::array_t arc, bool useWebMerc);
+
+  // read the Point and LineString geometries of a TopoJSON topology, with
+  // the properties of GeoJSON graph features. Arcs and points are quantized
+  // if transform is a TopoJSON transform object.
+  void readFromTopoJson(nlohmann::json::array_t geoms,
+                        const nlohmann::json::array_t& arcs,
+                        const nlohmann::json& transform, bool useWebMerc);
   virtual void readFromDot(std::istream* s);
+  virtual void readFromBin(std::istream* s);
+
+  // like readFromBin(), but also returns the created nodes and edges in the
+  // order of the binary graph, dropped edges are 0
+  void readFromBin(std::istream* s, std::vector<LineNode*>* nds,
+                   std::vector<LineEdge*>* edgs);
 
   void smooth(double smooth);
 
   const util::geo::Box<double>& getBBox() const;
+  void setBBox(const util::geo::Box<double>& box);
   void topologizeIsects();
 
   size_t maxDeg() const;
@@ -151,6 +165,14 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
   EdgeGrid* getEdgGrid();
   const EdgeGrid& getEdgGrid() const;
 
+  // if false, the readFrom* methods skip building the node and edge grids.
+  // Useful for tools which only need the topology and the lines, the grids
+  // can be built later with buildIndex()
+  void setIndexed(bool indexed) { _indexed = indexed; }
+
+  // build the node and edge grids if they were skipped while reading
+  void buildIndex();
+
   void splitNode(LineNode* n, size_t maxDeg);
   void splitNodes(size_t maxDeg);
 
@@ -158,7 +180,8 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
 
   void contractEdges(double d);
   void contractEdges(double d, bool onlyNonStatConns);
-  void contractEdge(LineEdge* e);
+  // returns the merged node
+  LineNode* contractEdge(LineEdge* e);
 
   double searchSpaceSize() const;
 
@@ -170,6 +193,27 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
   std::vector<LineGraph> distConnectedComponents(double d, bool write,
                                                  size_t* offset);
 
+  // like distConnectedComponents(), but moves all nodes and edges into the
+  // components instead of copying them, this graph is empty afterwards
+  std::vector<LineGraph> splitDistConnectedComponents(double d, bool write);
+
+  // move all nodes and edges of g into this graph, g is empty afterwards.
+  // The node and edge grids are not updated.
+  void absorb(LineGraph* g);
+
+  // drop all lines not in lines, together with their turn restrictions, and
+  // remove the edges left without lines and all unconnected nodes
+  void keepLines(const std::set<const Line*>& lines);
+
+  // drop all edges not intersecting box, together with their turn
+  // restrictions, and the unconnected nodes outside of box. The bounding
+  // box and, if the graph is indexed, the grids are updated.
+  void clip(const util::geo::DBox& box);
+
+  // the sets of nodes connected by edges or by a distance of at most d,
+  // ordered by their first node
+  std::vector<std::vector<LineNode*>> distComponents(double d) const;
+
   void fillMissingColors();
 
   void removeDeg1Nodes();
@@ -179,9 +223,25 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
  private:
   util::geo::Box<double> _bbox;
 
-  ISect getNextIntersection();
-
   void buildGrids();
+
+  // delete edges and the turn restrictions referring to them
+  void delEdgs(const std::vector<LineEdge*>& edgs);
+
+  // add a single GeoJSON feature, if it is a point (addGeoJsonNode) or a
+  // line string (addGeoJsonEdge), or the line exceptions of a point
+  // (addGeoJsonNodeProps, requires the edges)
+  void addGeoJsonNode(nlohmann::json* feature, bool webMercCoords,
+                      std::map<std::string, LineNode*>* idMap);
+  void addGeoJsonEdge(nlohmann::json* feature, bool webMercCoords,
+                      std::map<std::string, LineNode*>* idMap);
+  void addGeoJsonNodeProps(nlohmann::json* feature, bool webMercCoords,
+                           std::map<std::string, LineNode*>* idMap);
+
+  // true if all nodes a GeoJSON line string refers to are already known
+  static bool isGeoJsonEdgeResolved(
+      nlohmann::json* feature, const std::map<std::string, LineNode*>& idMap);
+
   void extractLines(const nlohmann::json::object_t& pars, LineEdge* e,
                     const std::map<std::string, LineNode*>& idMap);
   void extractLine(const nlohmann::json::object_t& pars, LineEdge* e,
@@ -194,12 +254,11 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
   std::string getStationLabel(const nlohmann::json::object_t& props);
   std::string getStationId(const nlohmann::json::object_t& props);
 
-  // TODO: remove this
-  std::set<LineEdge*> proced;
   std::map<std::string, const Line*> _lines;
 
   NodeGrid _nodeGrid;
   EdgeGrid _edgeGrid;
+  bool _indexed = true;
 
   nlohmann::json::object_t _graphProps;
 };
@@ -63,6 +63,10 @@ util::json::Dict LineNodePL::getAttrs() const {
   if (_is.size() > 0) {
     obj["station_id"] = _is.begin()->id;
     obj["station_label"] = _is.begin()->name;
+    if (_is.begin()->trips) {
+      obj["station_trips"] = static_cast<int>(_is.begin()->trips);
+      obj["station_routes"] = static_cast<int>(_is.begin()->routes);
+    }
   }
 
   auto arr = util::json::Array();
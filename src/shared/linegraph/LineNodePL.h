@@ -51,6 +51,10 @@ struct Station {
       : id(id), name(name), pos(pos) {}
   std::string id, name;
   util::geo::DPoint pos;
+
+  // the number of trips stopping here and of the routes they belong to, 0
+  // if unknown
+  size_t trips = 0, routes = 0;
 };
 
 struct ConnException {
@@ -93,7 +97,7 @@ class LineNodePL : util::geograph::GeoNodePL<double> {
   bool lineServed(const Line* r) const;
   void setNotServed(const NotServedLines& notServed);
 
-  const NotServedLines& getLinesNotServed() { return _notServed; }
+  const NotServedLines& getLinesNotServed() const { return _notServed; }
 
   void clearConnExc();
 
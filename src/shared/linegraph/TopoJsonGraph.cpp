@@ -0,0 +1,173 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "shared/linegraph/JsonGraph.h"
+#include "shared/linegraph/TopoJsonGraph.h"
+
+using shared::linegraph::JsonGraphWriter;
+using shared::linegraph::LineEdge;
+using shared::linegraph::LineGraph;
+using shared::linegraph::LineNode;
+using shared::linegraph::TopoJsonGraphWriter;
+
+// formatted geometries are written in blocks of this size
+static const size_t BUF_SIZE = 1 << 20;
+
+namespace {
+// _____________________________________________________________________________
+std::string key(const std::vector<std::pair<int64_t, int64_t>>& l) {
+  return std::string(reinterpret_cast<const char*>(l.data()),
+                     l.size() * sizeof(l[0]));
+}
+}  // namespace
+
+// _____________________________________________________________________________
+TopoJsonGraphWriter::TopoJsonGraphWriter(std::ostream* out) : _out(out) {}
+
+// _____________________________________________________________________________
+TopoJsonGraphWriter::TopoJsonGraphWriter(std::ostream* out,
+                                         const util::json::Dict& props)
+    : _out(out) {
+  if (props.empty()) return;
+  std::stringstream ss;
+  util::json::Writer wr(&ss, 10);
+  wr.val(props);
+  wr.closeAll();
+  _props = ss.str();
+}
+
+// _____________________________________________________________________________
+void TopoJsonGraphWriter::open() {
+  if (_open) return;
+  _open = true;
+  _first = true;
+  _arcs.clear();
+  _numArcs = 0;
+  _arcIds.clear();
+
+  *_out << "{\"type\":\"Topology\",";
+  if (!_props.empty()) *_out << "\"properties\":" << _props << ",";
+  *_out << "\"transform\":{\"scale\":[";
+  std::string num;
+  JsonGraphWriter::writeNum(TOPO_JSON_GRAPH_QUANT, &num);
+  *_out << num << "," << num << "],\"translate\":[0,0]},\"objects\":{\""
+        << TOPO_JSON_GRAPH_OBJECT
+        << "\":{\"type\":\"GeometryCollection\",\"geometries\":[";
+}
+
+// _____________________________________________________________________________
+std::pair<int64_t, int64_t> TopoJsonGraphWriter::quant(
+    const util::geo::DPoint& p) {
+  auto ll = util::geo::webMercToLatLng<double>(p.getX(), p.getY());
+  return {std::llround(ll.getX() / TOPO_JSON_GRAPH_QUANT),
+          std::llround(ll.getY() / TOPO_JSON_GRAPH_QUANT)};
+}
+
+// _____________________________________________________________________________
+int64_t TopoJsonGraphWriter::arc(const QuantLine& l) {
+  std::string k = key(l);
+  auto it = _arcIds.find(k);
+  if (it != _arcIds.end()) return it->second;
+
+  QuantLine rev(l.rbegin(), l.rend());
+  it = _arcIds.find(key(rev));
+  if (it != _arcIds.end()) return ~it->second;
+
+  _arcs.append(_numArcs ? ",[" : "[");
+  std::pair<int64_t, int64_t> prev{0, 0};
+  for (size_t i = 0; i < l.size(); i++) {
+    if (i) _arcs.push_back(',');
+    _arcs.push_back('[');
+    _arcs.append(std::to_string(l[i].first - prev.first));
+    _arcs.push_back(',');
+    _arcs.append(std::to_string(l[i].second - prev.second));
+    _arcs.push_back(']');
+    prev = l[i];
+  }
+  _arcs.push_back(']');
+
+  _arcIds[k] = _numArcs;
+  return _numArcs++;
+}
+
+// _____________________________________________________________________________
+void TopoJsonGraphWriter::add(const LineGraph& g) {
+  open();
+
+  std::string buf;
+
+  auto sep = [&]() {
+    if (!_first) buf.push_back(',');
+    _first = false;
+  };
+
+  auto spill = [&]() {
+    if (buf.size() < BUF_SIZE) return;
+    _out->write(buf.data(), buf.size());
+    buf.clear();
+  };
+
+  for (auto nd : g.getNds()) {
+    if (!nd->pl().getGeom()) continue;
+    auto q = quant(*nd->pl().getGeom());
+    sep();
+    buf.append("{\"type\":\"Point\",\"coordinates\":[");
+    buf.append(std::to_string(q.first));
+    buf.push_back(',');
+    buf.append(std::to_string(q.second));
+    buf.append("],\"properties\":");
+    JsonGraphWriter::writeNdProps(nd, &buf);
+    buf.push_back('}');
+    spill();
+  }
+
+  QuantLine l;
+  for (auto nd : g.getNds()) {
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+
+      l.clear();
+      const auto* geom = e->pl().getGeom();
+      if (geom && !geom->empty()) {
+        for (const auto& p : *geom) l.push_back(quant(p));
+      } else if (e->getFrom()->pl().getGeom() && e->getTo()->pl().getGeom()) {
+        // edges without geometry are drawn between their nodes
+        l.push_back(quant(*e->getFrom()->pl().getGeom()));
+        l.push_back(quant(*e->getTo()->pl().getGeom()));
+      } else {
+        continue;
+      }
+
+      // arcs need at least two positions
+      if (l.size() == 1) l.push_back(l.front());
+
+      sep();
+      buf.append("{\"type\":\"LineString\",\"arcs\":[");
+      buf.append(std::to_string(arc(l)));
+      buf.append("],\"properties\":");
+      JsonGraphWriter::writeEdgProps(e, &buf);
+      buf.push_back('}');
+      spill();
+    }
+  }
+
+  _out->write(buf.data(), buf.size());
+}
+
+// _____________________________________________________________________________
+void TopoJsonGraphWriter::flush() {
+  open();
+  *_out << "]}},\"arcs\":[";
+  _out->write(_arcs.data(), _arcs.size());
+  *_out << "]}";
+  _out->flush();
+  _open = false;
+  _arcs.clear();
+  _arcIds.clear();
+}
@@ -0,0 +1,70 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_LINEGRAPH_TOPOJSONGRAPH_H_
+#define SHARED_LINEGRAPH_TOPOJSONGRAPH_H_
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "shared/linegraph/LineGraph.h"
+#include "util/json/Writer.h"
+
+namespace shared {
+namespace linegraph {
+
+// quantization of written lat/lng coordinates in degrees (about 1 cm)
+static const double TOPO_JSON_GRAPH_QUANT = 1e-7;
+
+// name of the GeometryCollection holding the graph
+static const char TOPO_JSON_GRAPH_OBJECT[] = "graph";
+
+// Streaming TopoJSON writer for line graphs, with the same properties as
+// JsonGraphWriter. Nodes are Point and edges LineString geometries of the
+// single GeometryCollection TOPO_JSON_GRAPH_OBJECT. Coordinates are quantized
+// to TOPO_JSON_GRAPH_QUANT, the positions of the arcs are delta-encoded, and
+// edges with the same (or the reversed) geometry share an arc. Geometries are
+// written as they are added, the arcs are kept until flush().
+class TopoJsonGraphWriter {
+ public:
+  explicit TopoJsonGraphWriter(std::ostream* out);
+  TopoJsonGraphWriter(std::ostream* out, const util::json::Dict& props);
+
+  // add a complete line graph, may be called multiple times
+  void add(const LineGraph& g);
+
+  // write the arcs and close the topology
+  void flush();
+
+ private:
+  typedef std::vector<std::pair<int64_t, int64_t>> QuantLine;
+
+  std::ostream* _out;
+  std::string _props;
+  bool _open = false;
+  bool _first = true;
+
+  // formatted arcs, each preceded by a comma
+  std::string _arcs;
+  int64_t _numArcs = 0;
+
+  // arc index by the raw bytes of its quantized positions
+  std::unordered_map<std::string, int64_t> _arcIds;
+
+  void open();
+
+  // index of the arc of the positions, negative (one's complement) if the
+  // positions are those of an existing arc in reverse
+  int64_t arc(const QuantLine& l);
+
+  static std::pair<int64_t, int64_t> quant(const util::geo::DPoint& p);
+};
+
+}  // namespace linegraph
+}  // namespace shared
+
+#endif  // SHARED_LINEGRAPH_TOPOJSONGRAPH_H_
@@ -4,11 +4,19 @@
 
 #ifdef COIN_FOUND
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 // COIN includes
+#include "CbcEventHandler.hpp"
 #include "CbcSolver.hpp"
 #include "CoinPragma.hpp"
 #include "CoinWarmStart.hpp"
@@ -22,8 +30,53 @@
 
 using shared::optim::COINSolver;
 using shared::optim::DirType;
+using shared::optim::IncumbentFunc;
 using shared::optim::SolveType;
 
+namespace {
+// passes each new CBC incumbent to an incumbent callback, and stops CBC once
+// the stop flag is set
+class IncumbentHandler : public CbcEventHandler {
+ public:
+  IncumbentHandler(const IncumbentFunc& f, int numCols,
+                   const std::atomic<bool>* stopFlag)
+      : _f(f), _numCols(numCols), _stop(stopFlag) {}
+
+  CbcEventHandler* clone() const { return new IncumbentHandler(*this); }
+
+  CbcAction event(CbcEvent whichEvent) {
+    if (_stop && _stop->load()) return stop;
+
+    if (!_f || (whichEvent != solution && whichEvent != heuristicSolution)) {
+      return noAction;
+    }
+
+    // solutions of sub-problems solved by CBC itself are not incumbents
+    if (model_->specialOptions() & 2048) return noAction;
+
+    const double* sol = model_->bestSolution();
+    if (!sol) return noAction;
+
+    // the model may have been preprocessed, map back to the original columns
+    std::vector<double> vals(_numCols,
+                             std::numeric_limits<double>::quiet_NaN());
+    const int* orig = model_->originalColumns();
+    for (int i = 0; i < model_->getNumCols(); i++) {
+      int col = orig ? orig[i] : i;
+      if (col >= 0 && col < _numCols) vals[col] = sol[i];
+    }
+
+    _f(model_->getObjValue(), vals);
+    return noAction;
+  }
+
+ private:
+  IncumbentFunc _f;
+  int _numCols;
+  const std::atomic<bool>* _stop;
+};
+}  // namespace
+
 // _____________________________________________________________________________
 int callBack(CbcModel* model, int from) {
   int ret = 0;
@@ -50,6 +103,7 @@ COINSolver::COINSolver(DirType dir)
       _status(INF),
       _timeLimit(std::numeric_limits<int>::max()),
       _numThreads(0),
+      _mipGap(-1),
       _msgHandler(stderr) {
   _solver = &_solver1;
 
@@ -165,6 +219,39 @@ void COINSolver::addColToRow(int rowId, int colId, double coef) {
   _model.setElement(rowId, colId, coef);
 }
 
+// _____________________________________________________________________________
+void COINSolver::loadModel(const ILPModel& m) {
+  int colOff = _model.numberColumns();
+  int rowOff = _model.numberRows();
+
+  for (size_t i = 0; i < m.getNumCols(); i++) {
+    double lowBnd = m.getLowBnd(i);
+    double upBnd = m.getUpBnd(i);
+    if (lowBnd <= -std::numeric_limits<double>::max()) lowBnd = -COIN_DBL_MAX;
+    if (upBnd >= std::numeric_limits<double>::max()) upBnd = COIN_DBL_MAX;
+
+    _model.addCol(0, NULL, NULL, lowBnd, upBnd, m.getObjCoef(i), NULL,
+                  m.getColType(i) != CONT);
+  }
+
+  // rows are added with all their coefficients at once, which avoids the
+  // element lookups of setElement()
+  std::vector<int> rowBeg, colInd;
+  std::vector<double> vals;
+  m.getCSR(colOff, &rowBeg, &colInd, &vals);
+
+  for (size_t i = 0; i < m.getNumRows(); i++) {
+    double bnd = m.getRowBnd(i);
+    double lowBnd = m.getRowType(i) == UP ? -COIN_DBL_MAX : bnd;
+    double upBnd = m.getRowType(i) == LO ? COIN_DBL_MAX : bnd;
+
+    _model.addRow(rowBeg[i + 1] - rowBeg[i], colInd.data() + rowBeg[i],
+                  vals.data() + rowBeg[i], lowBnd, upBnd, NULL);
+  }
+
+  _lazyNames.append(m.getNames(), colOff, rowOff);
+}
+
 // _____________________________________________________________________________
 double COINSolver::getObjVal() const { return _solver->getObjValue(); }
 
@@ -190,19 +277,55 @@ SolveType COINSolver::solve() {
   // directly). To get this behavior with CBC, we simulate the process used by
   // the cbc command line interface and call CbcMain0 and CbcMain1. CbcMain1
   // expects exactly the same arguments (in array argv) as the command line
-  // interface. The code below therefor acts like if we call "cbc -solve
-  // -threads <N> ilp.mps" from the command line (verified by several tests on
-  // large ILPs which yield basically the same solution time and command line
-  // output).
+  // interface. The code below therefor acts like if we call "cbc ilp.mps
+  // -threads <N> -timeMode elapsed -seconds <T> -ratioGap <G> -solve -quit"
+  // from the command line.
 
   CbcSolverUsefulData solverData;
   CbcMain0(_cbcModel, solverData);
-  std::string numThreads = "4";
 
-  if (_numThreads > 0) numThreads = std::to_string(_numThreads);
+  if (_starterArr) {
+    // CBC matches MIP start values by column name, partial starts are
+    // completed by the solver
+    std::vector<std::pair<std::string, double>> mipStart;
+    for (int i = 0; i < getNumVars(); i++) {
+      if (std::isnan(_starterArr[i])) continue;
+      mipStart.push_back({_solver1.getColName(i), _starterArr[i]});
+    }
+    _cbcModel.setMIPStart(mipStart);
+  }
+
+  if (_incumbentCb || _stop) {
+    IncumbentHandler handler(_incumbentCb, getNumVars(), _stop);
+    _cbcModel.passInEventHandler(&handler);
+  }
+
+  // CbcMain0 resets the limits set on the model, they have to be given as
+  // arguments. All arguments are processed in order, so "-solve" is last.
+  // The first argument is the program name.
+  int numThreads = _numThreads;
+  if (numThreads <= 0) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  std::vector<std::string> args = {"cbc", "-threads",
+                                   std::to_string(numThreads), "-timeMode",
+                                   "elapsed"};
 
-  const char* argv2[] = {"-solve", "-threads", numThreads.c_str()};
-  CbcMain1(3, argv2, _cbcModel, callBack, solverData);
+  if (_timeLimit >= 0 && _timeLimit < std::numeric_limits<int>::max()) {
+    args.insert(args.end(), {"-seconds", std::to_string(_timeLimit)});
+  }
+
+  if (_mipGap >= 0) {
+    args.insert(args.end(), {"-ratioGap", util::toString(_mipGap)});
+  }
+
+  args.insert(args.end(), {"-solve", "-quit"});
+
+  std::vector<const char*> argv;
+  for (const auto& a : args) argv.push_back(a.c_str());
+
+  CbcMain1(argv.size(), argv.data(), _cbcModel, callBack, solverData);
   _solver = _cbcModel.solver();
 
   if (_cbcModel.isProvenOptimal())
@@ -257,8 +380,26 @@ int COINSolver::getNumVars() const { return _model.numberColumns(); }
 
 // _____________________________________________________________________________
 void COINSolver::setStarter(const StarterSol& starterSol) {
-  // TODO: not yet implemented
-  UNUSED(starterSol);
+  IdxStarterSol sol;
+  for (const auto& varVal : starterSol) {
+    sol.push_back({getVarByName(varVal.first), varVal.second});
+  }
+  setStarter(sol);
+}
+
+// _____________________________________________________________________________
+void COINSolver::setStarter(const IdxStarterSol& starterSol) {
+  // NaN marks variables without a starter value
+  if (!_starterArr) {
+    _starterArr = new double[getNumVars()];
+    std::fill_n(_starterArr, getNumVars(),
+                std::numeric_limits<double>::quiet_NaN());
+  }
+
+  for (const auto& varVal : starterSol) {
+    if (varVal.first < 0) continue;
+    _starterArr[varVal.first] = varVal.second;
+  }
 }
 
 // _____________________________________________________________________________
@@ -270,8 +411,21 @@ void COINSolver::setNumThreads(int n) {
 // _____________________________________________________________________________
 int COINSolver::getNumThreads() const { return _numThreads; }
 
+// _____________________________________________________________________________
+void COINSolver::setMipGap(double gap) { _mipGap = gap; }
+
+// _____________________________________________________________________________
+double COINSolver::getMipGap() const { return _mipGap; }
+
 // _____________________________________________________________________________
 void COINSolver::writeMps(const std::string& path) const {
+  _lazyNames.colNames([this](int id, const std::string& name) {
+    _model.setColumnName(id, name.c_str());
+  });
+  _lazyNames.rowNames([this](int id, const std::string& name) {
+    _model.setRowName(id, name.c_str());
+  });
+
   _model.writeMps(path.c_str());
 }
 
@@ -8,6 +8,7 @@
 #ifdef COIN_FOUND
 
 #include <vector>
+#include "shared/optim/ILPModel.h"
 #include "shared/optim/ILPSolver.h"
 
 // COIN includes
@@ -35,6 +36,8 @@ class COINSolver : public ILPSolver {
                    double coef);
   void addColToRow(int rowId, int colId, double coef);
 
+  void loadModel(const ILPModel& m);
+
   int getVarByName(const std::string& name) const;
   int getConstrByName(const std::string& name) const;
 
@@ -65,7 +68,11 @@ class COINSolver : public ILPSolver {
   void setNumThreads(int n);
   int getNumThreads() const;
 
+  void setMipGap(double gap);
+  double getMipGap() const;
+
   void setStarter(const StarterSol& starterSol);
+  void setStarter(const IdxStarterSol& starterSol);
   void writeMps(const std::string& path) const;
 
   double* getStarterArr() const;
@@ -79,11 +86,15 @@ class COINSolver : public ILPSolver {
 
   int _numThreads;
 
+  double _mipGap;
+
   OsiClpSolverInterface _solver1;
   OsiSolverInterface* _solver;
   mutable CoinModel _model;
   CbcModel _cbcModel;
-CoinMessageHandler _msgHandler;
+  CoinMessageHandler _msgHandler;
+
+  ILPNames _lazyNames;
 };
 
 }  // namespace optim
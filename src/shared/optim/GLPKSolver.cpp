@@ -6,6 +6,7 @@
 
 #include <glpk.h>
 #include <cassert>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
 #include "shared/optim/GLPKSolver.h"
@@ -17,11 +18,55 @@ using shared::optim::GLPKSolver;
 using shared::optim::SolveType;
 using shared::optim::VariableMatrix;
 
+namespace {
+// _____________________________________________________________________________
+int colKind(shared::optim::ColType colType) {
+  switch (colType) {
+    case shared::optim::INT:
+      return GLP_IV;
+    case shared::optim::BIN:
+      return GLP_BV;
+    case shared::optim::CONT:
+      return GLP_CV;
+  }
+  return GLP_CV;
+}
+
+// _____________________________________________________________________________
+int colBndType(double lowBnd, double upBnd) {
+  if (lowBnd <= -std::numeric_limits<double>::max() &&
+      upBnd >= std::numeric_limits<double>::max()) {
+    return GLP_FR;
+  } else if (lowBnd <= -std::numeric_limits<double>::max()) {
+    return GLP_UP;
+  } else if (upBnd >= std::numeric_limits<double>::max()) {
+    return GLP_LO;
+  } else if (lowBnd == upBnd) {
+    return GLP_FX;
+  }
+  return GLP_DB;
+}
+
+// _____________________________________________________________________________
+int rowBndType(shared::optim::RowType rowType) {
+  switch (rowType) {
+    case shared::optim::FIX:
+      return GLP_FX;
+    case shared::optim::UP:
+      return GLP_UP;
+    case shared::optim::LO:
+      return GLP_LO;
+  }
+  return GLP_FX;
+}
+}  // namespace
+
 // _____________________________________________________________________________
 GLPKSolver::GLPKSolver(DirType dir)
     : _starterArr(0),
       _status(INF),
-      _timeLimit(std::numeric_limits<int>::max()) {
+      _timeLimit(std::numeric_limits<int>::max()),
+      _mipGap(-1) {
   const char* ver = glp_version();
   LOGTO(DEBUG, std::cerr) << "Creating GLPK solver v" << ver << " instance...";
 
@@ -50,22 +95,9 @@ GLPKSolver::~GLPKSolver() {
 // _____________________________________________________________________________
 int GLPKSolver::addCol(const std::string& name, ColType colType,
                        double objCoef) {
-  int vtype = 0;
-  switch (colType) {
-    case INT:
-      vtype = GLP_IV;
-      break;
-    case BIN:
-      vtype = GLP_BV;
-      break;
-    case CONT:
-      vtype = GLP_CV;
-      break;
-  }
-
   int col = glp_add_cols(_prob, 1);
   glp_set_col_name(_prob, col, name.c_str());
-  glp_set_col_kind(_prob, col, vtype);
+  glp_set_col_kind(_prob, col, colKind(colType));
   glp_set_obj_coef(_prob, col, objCoef);
 
   return col - 1;
@@ -74,45 +106,18 @@ int GLPKSolver::addCol(const std::string& name, ColType colType,
 // _____________________________________________________________________________
 int GLPKSolver::addCol(const std::string& name, ColType colType, double objCoef,
                        double lowBnd, double upBnd) {
-  int rtype = 0;
-  if (lowBnd <= -std::numeric_limits<double>::max() &&
-      upBnd >= std::numeric_limits<double>::max()) {
-    rtype = GLP_FR;
-  } else if (lowBnd <= -std::numeric_limits<double>::max()) {
-    rtype = GLP_UP;
-  } else if (upBnd >= std::numeric_limits<double>::max()) {
-    rtype = GLP_LO;
-  } else if (lowBnd == upBnd) {
-    rtype = GLP_FX;
-  } else {
-    rtype = GLP_DB;
-  }
-
   int col = addCol(name, colType, objCoef);
-  glp_set_col_bnds(_prob, col + 1, rtype, lowBnd, upBnd);
+  glp_set_col_bnds(_prob, col + 1, colBndType(lowBnd, upBnd), lowBnd, upBnd);
 
   return col;
 }
 
 // _____________________________________________________________________________
 int GLPKSolver::addRow(const std::string& name, double bnd, RowType rowType) {
-  int rtype = 0;
-  switch (rowType) {
-    case FIX:
-      rtype = GLP_FX;
-      break;
-    case UP:
-      rtype = GLP_UP;
-      break;
-    case LO:
-      rtype = GLP_LO;
-      break;
-  }
-
   int row = glp_add_rows(_prob, 1);
   assert(row);
   glp_set_row_name(_prob, row, name.c_str());
-  glp_set_row_bnds(_prob, row, rtype, bnd, bnd);
+  glp_set_row_bnds(_prob, row, rowBndType(rowType), bnd, bnd);
 
   return row - 1;
 }
@@ -129,7 +134,7 @@ void GLPKSolver::addColToRow(const std::string& rowName,
     LOGTO(ERROR, std::cerr) << "Could not find constraint " << rowName;
   }
 
-  addColToRow(col, row, coef);
+  addColToRow(row, col, coef);
 }
 
 // _____________________________________________________________________________
@@ -151,6 +156,37 @@ void GLPKSolver::addColToRow(int rowId, int colId, double coef) {
   _vm.addVar(rowId + 1, colId + 1, coef);
 }
 
+// _____________________________________________________________________________
+void GLPKSolver::loadModel(const ILPModel& m) {
+  int colOff = glp_get_num_cols(_prob);
+  int rowOff = glp_get_num_rows(_prob);
+
+  if (m.getNumCols()) glp_add_cols(_prob, m.getNumCols());
+  if (m.getNumRows()) glp_add_rows(_prob, m.getNumRows());
+
+  for (size_t i = 0; i < m.getNumCols(); i++) {
+    int col = colOff + i + 1;
+    double lowBnd = m.getLowBnd(i);
+    double upBnd = m.getUpBnd(i);
+    glp_set_col_kind(_prob, col, colKind(m.getColType(i)));
+    glp_set_col_bnds(_prob, col, colBndType(lowBnd, upBnd), lowBnd, upBnd);
+    glp_set_obj_coef(_prob, col, m.getObjCoef(i));
+  }
+
+  for (size_t i = 0; i < m.getNumRows(); i++) {
+    glp_set_row_bnds(_prob, rowOff + i + 1, rowBndType(m.getRowType(i)),
+                     m.getRowBnd(i), m.getRowBnd(i));
+  }
+
+  _vm.reserve(_vm.getNumVars() + m.getNumCoefs());
+  for (size_t i = 0; i < m.getNumCoefs(); i++) {
+    _vm.addVar(rowOff + m.getCoefRows()[i] + 1,
+               colOff + m.getCoefCols()[i] + 1, m.getCoefVals()[i]);
+  }
+
+  _lazyNames.append(m.getNames(), colOff, rowOff);
+}
+
 // _____________________________________________________________________________
 double GLPKSolver::getObjVal() const { return glp_mip_obj_val(_prob); }
 
@@ -182,6 +218,7 @@ SolveType GLPKSolver::solve() {
   // params.binarize = GLP_OFF;
   params.ps_tm_lim = 60000;
   params.tm_lim = _timeLimit;
+  if (_mipGap >= 0) params.mip_gap = _mipGap;
   // params.fp_heur = GLP_ON;
   // params.ps_heur = GLP_ON;
 
@@ -206,6 +243,12 @@ void GLPKSolver::setTimeLim(int s) { _timeLimit = s * 1000; }
 // _____________________________________________________________________________
 int GLPKSolver::getTimeLim() const { return _timeLimit / 1000; }
 
+// _____________________________________________________________________________
+void GLPKSolver::setMipGap(double gap) { _mipGap = gap; }
+
+// _____________________________________________________________________________
+double GLPKSolver::getMipGap() const { return _mipGap; }
+
 // _____________________________________________________________________________
 void GLPKSolver::setCacheDir(const std::string& dir) {
   LOGTO(INFO, std::cerr) << "Setting cache dir to " << dir
@@ -232,12 +275,25 @@ double* GLPKSolver::getStarterArr() const { return _starterArr; }
 // _____________________________________________________________________________
 void GLPKSolver::optCb(glp_tree* tree, void* solver) {
   auto _this = reinterpret_cast<GLPKSolver*>(solver);
+  if (_this->stopRequested()) {
+    glp_ios_terminate(tree);
+    return;
+  }
+
   switch (glp_ios_reason(tree)) {
     case GLP_IHEUR:
       if (_this->getStarterArr()) {
         glp_ios_heur_sol(tree, _this->getStarterArr());
       }
       break;
+    case GLP_IBINGO:
+      // the new incumbent is available as the current MIP solution
+      if (_this->_incumbentCb) {
+        std::vector<double> vals(_this->getNumVars());
+        for (size_t i = 0; i < vals.size(); i++) vals[i] = _this->getVarVal(i);
+        _this->_incumbentCb(glp_mip_obj_val(_this->_prob), vals);
+      }
+      break;
     default:
       break;
   }
@@ -316,6 +372,23 @@ void GLPKSolver::setStarter(const StarterSol& starterSol) {
   }
 }
 
+// _____________________________________________________________________________
+void GLPKSolver::setStarter(const IdxStarterSol& starterSol) {
+  if (!_starterArr) _starterArr = new double[getNumVars() + 1]();
+
+  for (const auto& varVal : starterSol) {
+    if (varVal.first < 0) continue;
+    _starterArr[varVal.first + 1] = varVal.second;
+  }
+}
+
+// _____________________________________________________________________________
+void VariableMatrix::reserve(size_t n) {
+  rowNum.reserve(n);
+  colNum.reserve(n);
+  vals.reserve(n);
+}
+
 // _____________________________________________________________________________
 void VariableMatrix::addVar(int row, int col, double val) {
   rowNum.push_back(row);
@@ -347,6 +420,13 @@ void GLPKSolver::writeMps(const std::string& path) const {
   double* res = 0;
   _vm.getGLPKArrs(&ia, &ja, &res);
 
+  _lazyNames.colNames([this](int id, const std::string& name) {
+    glp_set_col_name(_prob, id + 1, name.c_str());
+  });
+  _lazyNames.rowNames([this](int id, const std::string& name) {
+    glp_set_row_name(_prob, id + 1, name.c_str());
+  });
+
   glp_load_matrix(_prob, _vm.getNumVars(), ia, ja, res);
   glp_write_mps(_prob, GLP_MPS_FILE, 0, path.c_str());
 
@@ -9,6 +9,7 @@
 
 #include <glpk.h>
 #include <vector>
+#include "shared/optim/ILPModel.h"
 #include "shared/optim/ILPSolver.h"
 #include "util/Misc.h"
 
@@ -21,6 +22,7 @@ struct VariableMatrix {
   std::vector<double> vals;
 
   void addVar(int row, int col, double val);
+  void reserve(size_t n);
   void getGLPKArrs(int** ia, int** ja, double** r) const;
   size_t getNumVars() const { return vals.size(); }
 };
@@ -39,6 +41,8 @@ class GLPKSolver : public ILPSolver {
                    double coef);
   void addColToRow(int rowId, int colId, double coef);
 
+  void loadModel(const ILPModel& m);
+
   int getVarByName(const std::string& name) const;
   int getConstrByName(const std::string& name) const;
 
@@ -60,6 +64,9 @@ class GLPKSolver : public ILPSolver {
   void setNumThreads(int n){UNUSED(n);};
   int getNumThreads() const {return 0;};
 
+  void setMipGap(double gap);
+  double getMipGap() const;
+
   void setTimeLim(int s);
   int getTimeLim() const;
 
@@ -70,6 +77,7 @@ class GLPKSolver : public ILPSolver {
   double getCacheThreshold() const;
 
   void setStarter(const StarterSol& starterSol);
+  void setStarter(const IdxStarterSol& starterSol);
   void writeMps(const std::string& path) const;
 
   double* getStarterArr() const;
@@ -77,6 +85,7 @@ class GLPKSolver : public ILPSolver {
  private:
   glp_prob* _prob;
   VariableMatrix _vm;
+  ILPNames _lazyNames;
 
   double* _starterArr;
 
@@ -84,6 +93,8 @@ class GLPKSolver : public ILPSolver {
 
   int _timeLimit;
 
+  double _mipGap;
+
   std::string _termBuf;
 
   static void optCb(glp_tree* tree, void* solver);
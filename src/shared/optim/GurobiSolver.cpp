@@ -4,8 +4,10 @@
 
 #ifdef GUROBI_FOUND
 
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 #include "gurobi_c.h"
 #include "shared/optim/GurobiSolver.h"
 #include "util/Misc.h"
@@ -55,7 +57,7 @@ GurobiSolver::GurobiSolver(DirType dir)
     throw std::runtime_error("Could not create gurobi model");
   }
 
-  error = GRBsetcallbackfunc(_model, termHook, &_logBuffer);
+  error = GRBsetcallbackfunc(_model, termHook, this);
 
   if (dir == MAX)
     GRBsetintattr(_model, GRB_INT_ATTR_MODELSENSE, GRB_MAXIMIZE);
@@ -135,7 +137,7 @@ void GurobiSolver::addColToRow(const std::string& rowName,
     LOGTO(ERROR, std::cerr) << "Could not find constraint " << rowName;
   }
 
-  addColToRow(col, row, coef);
+  addColToRow(row, col, coef);
 }
 
 // _____________________________________________________________________________
@@ -168,6 +170,71 @@ void GurobiSolver::addColToRow(int rowId, int colId, double coef) {
   }
 }
 
+// _____________________________________________________________________________
+void GurobiSolver::loadModel(const ILPModel& m) {
+  int colOff = _numVars;
+  int rowOff = _numRows;
+
+  std::vector<double> obj(m.getNumCols()), lb(m.getNumCols()),
+      ub(m.getNumCols());
+  std::vector<char> vtype(m.getNumCols());
+
+  for (size_t i = 0; i < m.getNumCols(); i++) {
+    obj[i] = m.getObjCoef(i);
+    lb[i] = std::max(m.getLowBnd(i), -GRB_INFINITY);
+    ub[i] = std::min(m.getUpBnd(i), GRB_INFINITY);
+    switch (m.getColType(i)) {
+      case INT:
+        vtype[i] = GRB_INTEGER;
+        break;
+      case BIN:
+        vtype[i] = GRB_BINARY;
+        break;
+      case CONT:
+        vtype[i] = GRB_CONTINUOUS;
+        break;
+    }
+  }
+
+  int error = GRBaddvars(_model, m.getNumCols(), 0, 0, 0, 0, obj.data(),
+                         lb.data(), ub.data(), vtype.data(), 0);
+  if (error) throw std::runtime_error("Could not add variables");
+  _numVars += m.getNumCols();
+
+  // the new variables are referenced by index below
+  GRBupdatemodel(_model);
+
+  std::vector<int> rowBeg, colInd;
+  std::vector<double> vals;
+  m.getCSR(colOff, &rowBeg, &colInd, &vals);
+
+  std::vector<char> sense(m.getNumRows());
+  std::vector<double> rhs(m.getNumRows());
+
+  for (size_t i = 0; i < m.getNumRows(); i++) {
+    rhs[i] = m.getRowBnd(i);
+    switch (m.getRowType(i)) {
+      case FIX:
+        sense[i] = GRB_EQUAL;
+        break;
+      case UP:
+        sense[i] = GRB_LESS_EQUAL;
+        break;
+      case LO:
+        sense[i] = GRB_GREATER_EQUAL;
+        break;
+    }
+  }
+
+  error = GRBaddconstrs(_model, m.getNumRows(), vals.size(), rowBeg.data(),
+                        colInd.data(), vals.data(), sense.data(), rhs.data(),
+                        0);
+  if (error) throw std::runtime_error("Could not add rows");
+  _numRows += m.getNumRows();
+
+  _lazyNames.append(m.getNames(), colOff, rowOff);
+}
+
 // _____________________________________________________________________________
 double GurobiSolver::getObjVal() const {
   double objVal;
@@ -193,6 +260,19 @@ void GurobiSolver::setStarter(const StarterSol& starterSol) {
   }
 }
 
+// _____________________________________________________________________________
+void GurobiSolver::setStarter(const IdxStarterSol& starterSol) {
+  if (!_starterArr) {
+    _starterArr = new double[getNumVars()];
+    std::fill_n(_starterArr, getNumVars(), GRB_UNDEFINED);
+  }
+
+  for (const auto& varVal : starterSol) {
+    if (varVal.first < 0) continue;
+    _starterArr[varVal.first] = varVal.second;
+  }
+}
+
 // _____________________________________________________________________________
 SolveType GurobiSolver::solve() {
   update();
@@ -327,6 +407,27 @@ int GurobiSolver::getNumThreads() const {
   return ret;
 }
 
+// _____________________________________________________________________________
+void GurobiSolver::setMipGap(double gap) {
+  if (gap < 0) return;
+  int error = GRBsetdblparam(GRBgetenv(_model), GRB_DBL_PAR_MIPGAP, gap);
+  if (error) {
+    throw std::runtime_error("Could not set MIP gap");
+  }
+}
+
+// _____________________________________________________________________________
+double GurobiSolver::getMipGap() const {
+  double ret;
+  int error = GRBgetdblparam(GRBgetenv(_model), GRB_DBL_PAR_MIPGAP, &ret);
+  if (error) {
+    std::stringstream ss;
+    ss << "Could not retrieve MIP gap";
+    throw std::runtime_error(ss.str());
+  }
+  return ret;
+}
+
 // _____________________________________________________________________________
 void GurobiSolver::setTimeLim(int s) {
   // set time limit
@@ -402,6 +503,14 @@ int GurobiSolver::getNumVars() const { return _numVars; }
 
 // _____________________________________________________________________________
 void GurobiSolver::writeMps(const std::string& path) const {
+  _lazyNames.colNames([this](int id, const std::string& name) {
+    GRBsetstrattrelement(_model, GRB_STR_ATTR_VARNAME, id, name.c_str());
+  });
+  _lazyNames.rowNames([this](int id, const std::string& name) {
+    GRBsetstrattrelement(_model, GRB_STR_ATTR_CONSTRNAME, id, name.c_str());
+  });
+  GRBupdatemodel(_model);
+
   int error = GRBwrite(_model, path.c_str());
   if (error) {
     std::stringstream ss;
@@ -412,14 +521,26 @@ void GurobiSolver::writeMps(const std::string& path) const {
 
 // _____________________________________________________________________________
 int GurobiSolver::termHook(GRBmodel* mod, void* cbdata, int where,
-                           void* buffPtr) {
+                           void* solver) {
   UNUSED(mod);
+  auto _this = reinterpret_cast<GurobiSolver*>(solver);
+
+  if (_this->stopRequested()) GRBterminate(_this->_model);
+
+  if (where == GRB_CB_MIPSOL && _this->_incumbentCb) {
+    double obj;
+    std::vector<double> vals(_this->getNumVars());
+    if (GRBcbget(cbdata, where, GRB_CB_MIPSOL_OBJ, &obj)) return 0;
+    if (GRBcbget(cbdata, where, GRB_CB_MIPSOL_SOL, vals.data())) return 0;
+    _this->_incumbentCb(obj, vals);
+  }
+
   if (where == GRB_CB_MESSAGE) {
     const char* msg;
     int error = GRBcbget(cbdata, where, GRB_CB_MSG_STRING, &msg);
     if (error) return 0;
 
-    std::string* buff = reinterpret_cast<std::string*>(buffPtr);
+    std::string* buff = &_this->_logBuffer;
     std::string s = msg;
     for (auto ch : s) {
       if (ch == '\n') {
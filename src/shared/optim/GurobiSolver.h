@@ -8,6 +8,7 @@
 #ifdef GUROBI_FOUND
 
 #include "gurobi_c.h"
+#include "shared/optim/ILPModel.h"
 #include "shared/optim/ILPSolver.h"
 
 namespace shared {
@@ -27,6 +28,8 @@ class GurobiSolver : public ILPSolver {
                    double coef);
   void addColToRow(int rowId, int colId, double coef);
 
+  void loadModel(const ILPModel& m);
+
   int getVarByName(const std::string& name) const;
   int getConstrByName(const std::string& name) const;
 
@@ -57,9 +60,13 @@ class GurobiSolver : public ILPSolver {
   void setNumThreads(int n);
   int getNumThreads() const;
 
+  void setMipGap(double gap);
+  double getMipGap() const;
+
   void writeMps(const std::string& path) const;
 
   void setStarter(const StarterSol& starterSol);
+  void setStarter(const IdxStarterSol& starterSol);
 
  private:
   GRBenv* _env;
@@ -71,6 +78,7 @@ class GurobiSolver : public ILPSolver {
   SolveType _status;
 
   int _numVars, _numRows;
+  ILPNames _lazyNames;
   std::string _logBuffer;
 
   static int termHook(GRBmodel* mod, void* cbdata, int where, void* solver);
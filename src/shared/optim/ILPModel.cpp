@@ -0,0 +1,217 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include "shared/optim/ILPModel.h"
+
+using shared::optim::ILPModel;
+using shared::optim::ILPNames;
+
+namespace {
+// _____________________________________________________________________________
+template <typename T>
+void writeVec(std::ostream* os, const std::vector<T>& v) {
+  uint64_t n = v.size();
+  os->write(reinterpret_cast<const char*>(&n), sizeof(n));
+  os->write(reinterpret_cast<const char*>(v.data()), n * sizeof(T));
+}
+
+// _____________________________________________________________________________
+template <typename T>
+bool readVec(std::istream* is, std::vector<T>* v) {
+  uint64_t n = 0;
+  if (!is->read(reinterpret_cast<char*>(&n), sizeof(n))) return false;
+  // guard against allocating garbage sizes
+  if (n > std::numeric_limits<int>::max()) return false;
+  v->resize(n);
+  return static_cast<bool>(
+      is->read(reinterpret_cast<char*>(v->data()), n * sizeof(T)));
+}
+}  // namespace
+
+// _____________________________________________________________________________
+void ILPNames::addCols(int first, size_t n, NameFunc f) {
+  _cols.push_back({first, n, f});
+}
+
+// _____________________________________________________________________________
+void ILPNames::addRows(int first, size_t n, NameFunc f) {
+  _rows.push_back({first, n, f});
+}
+
+// _____________________________________________________________________________
+void ILPNames::append(const ILPNames& other, int colOff, int rowOff) {
+  for (const auto& r : other._cols)
+    _cols.push_back({r.first + colOff, r.n, r.f});
+  for (const auto& r : other._rows)
+    _rows.push_back({r.first + rowOff, r.n, r.f});
+}
+
+// _____________________________________________________________________________
+int ILPModel::addCol(ColType colType, double objCoef) {
+  if (colType == BIN) return addCol(colType, objCoef, 0, 1);
+  return addCol(colType, objCoef, -std::numeric_limits<double>::max(),
+                std::numeric_limits<double>::max());
+}
+
+// _____________________________________________________________________________
+int ILPModel::addCol(ColType colType, double objCoef, double lowBnd,
+                     double upBnd) {
+  _colTypes.push_back(colType);
+  _objCoefs.push_back(objCoef);
+  _lowBnds.push_back(lowBnd);
+  _upBnds.push_back(upBnd);
+  return _extCols + _colTypes.size() - 1;
+}
+
+// _____________________________________________________________________________
+int ILPModel::addCols(size_t n, ColType colType, double objCoef) {
+  int first = _extCols + getNumCols();
+  for (size_t i = 0; i < n; i++) addCol(colType, objCoef);
+  return first;
+}
+
+// _____________________________________________________________________________
+int ILPModel::addRow(double bnd, RowType rowType) {
+  _rowTypes.push_back(rowType);
+  _rowBnds.push_back(bnd);
+  return _rowTypes.size() - 1;
+}
+
+// _____________________________________________________________________________
+int ILPModel::addRows(size_t n, double bnd, RowType rowType) {
+  int first = getNumRows();
+  _rowTypes.resize(first + n, rowType);
+  _rowBnds.resize(first + n, bnd);
+  return first;
+}
+
+// _____________________________________________________________________________
+void ILPModel::addColToRow(int rowId, int colId, double coef) {
+  assert(rowId >= 0 && static_cast<size_t>(rowId) < getNumRows());
+  assert(colId >= 0 && static_cast<size_t>(colId) < _extCols + getNumCols());
+  _coefRows.push_back(rowId);
+  _coefCols.push_back(colId);
+  _coefVals.push_back(coef);
+}
+
+// _____________________________________________________________________________
+void ILPModel::setObjCoef(int colId, double coef) {
+  if (static_cast<size_t>(colId) < _extCols) {
+    _extObjCoefs.push_back({colId, coef});
+    return;
+  }
+  _objCoefs[colId - _extCols] = coef;
+}
+
+// _____________________________________________________________________________
+void ILPModel::reserve(size_t cols, size_t rows, size_t coefs) {
+  _colTypes.reserve(cols);
+  _objCoefs.reserve(cols);
+  _lowBnds.reserve(cols);
+  _upBnds.reserve(cols);
+  _rowTypes.reserve(rows);
+  _rowBnds.reserve(rows);
+  _coefRows.reserve(coefs);
+  _coefCols.reserve(coefs);
+  _coefVals.reserve(coefs);
+}
+
+// _____________________________________________________________________________
+void ILPModel::append(const ILPModel& part) {
+  assert(part._extCols <= _extCols + getNumCols());
+
+  // own columns of the part are shifted behind the columns of this model
+  int colOff = _extCols + getNumCols() - part._extCols;
+  int rowOff = getNumRows();
+  int ext = part._extCols;
+
+  _colTypes.insert(_colTypes.end(), part._colTypes.begin(),
+                   part._colTypes.end());
+  _objCoefs.insert(_objCoefs.end(), part._objCoefs.begin(),
+                   part._objCoefs.end());
+  _lowBnds.insert(_lowBnds.end(), part._lowBnds.begin(), part._lowBnds.end());
+  _upBnds.insert(_upBnds.end(), part._upBnds.begin(), part._upBnds.end());
+
+  _rowTypes.insert(_rowTypes.end(), part._rowTypes.begin(),
+                   part._rowTypes.end());
+  _rowBnds.insert(_rowBnds.end(), part._rowBnds.begin(), part._rowBnds.end());
+
+  for (size_t i = 0; i < part.getNumCoefs(); i++) {
+    int col = part._coefCols[i];
+    _coefRows.push_back(part._coefRows[i] + rowOff);
+    _coefCols.push_back(col < ext ? col : col + colOff);
+    _coefVals.push_back(part._coefVals[i]);
+  }
+
+  // in the order they were set, as if the part had been built in place
+  for (const auto& oc : part._extObjCoefs) setObjCoef(oc.first, oc.second);
+
+  if (_keepNames) _names.append(part._names, colOff, rowOff);
+}
+
+// _____________________________________________________________________________
+void ILPModel::getCSR(int colOff, std::vector<int>* rowBeg,
+                      std::vector<int>* colInd,
+                      std::vector<double>* vals) const {
+  // counting sort of the triplets by row, stable within each row
+  rowBeg->assign(getNumRows() + 1, 0);
+  for (int r : _coefRows) (*rowBeg)[r + 1]++;
+  for (size_t i = 0; i < getNumRows(); i++) (*rowBeg)[i + 1] += (*rowBeg)[i];
+
+  colInd->resize(getNumCoefs());
+  vals->resize(getNumCoefs());
+
+  std::vector<int> next(rowBeg->begin(), rowBeg->end() - 1);
+  for (size_t i = 0; i < getNumCoefs(); i++) {
+    int pos = next[_coefRows[i]]++;
+    (*colInd)[pos] = _coefCols[i] + colOff;
+    (*vals)[pos] = _coefVals[i];
+  }
+}
+
+// _____________________________________________________________________________
+void ILPModel::write(std::ostream* os) const {
+  writeVec(os, _colTypes);
+  writeVec(os, _objCoefs);
+  writeVec(os, _lowBnds);
+  writeVec(os, _upBnds);
+  writeVec(os, _rowTypes);
+  writeVec(os, _rowBnds);
+  writeVec(os, _coefRows);
+  writeVec(os, _coefCols);
+  writeVec(os, _coefVals);
+}
+
+// _____________________________________________________________________________
+bool ILPModel::read(std::istream* is) {
+  if (!readVec(is, &_colTypes) || !readVec(is, &_objCoefs) ||
+      !readVec(is, &_lowBnds) || !readVec(is, &_upBnds) ||
+      !readVec(is, &_rowTypes) || !readVec(is, &_rowBnds) ||
+      !readVec(is, &_coefRows) || !readVec(is, &_coefCols) ||
+      !readVec(is, &_coefVals)) {
+    return false;
+  }
+
+  size_t cols = _colTypes.size();
+  size_t rows = _rowTypes.size();
+
+  if (_objCoefs.size() != cols || _lowBnds.size() != cols ||
+      _upBnds.size() != cols || _rowBnds.size() != rows ||
+      _coefCols.size() != _coefRows.size() ||
+      _coefVals.size() != _coefRows.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < _coefRows.size(); i++) {
+    if (_coefRows[i] < 0 || static_cast<size_t>(_coefRows[i]) >= rows ||
+        _coefCols[i] < 0 || static_cast<size_t>(_coefCols[i]) >= cols) {
+      return false;
+    }
+  }
+
+  return true;
+}
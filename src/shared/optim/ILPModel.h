@@ -0,0 +1,162 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_OPTIM_ILPMODEL_H_
+#define SHARED_OPTIM_ILPMODEL_H_
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "shared/optim/ILPSolver.h"
+
+namespace shared {
+namespace optim {
+
+// Names of columns and rows, generated on demand from name functions
+// registered for ranges of ids.
+class ILPNames {
+ public:
+  // called with the offset of the id into the range
+  typedef std::function<std::string(size_t)> NameFunc;
+
+  void addCols(int first, size_t n, NameFunc f);
+  void addRows(int first, size_t n, NameFunc f);
+
+  // append the names of other, with column and row ids shifted
+  void append(const ILPNames& other, int colOff, int rowOff);
+
+  // call f(id, name) for each named column / row
+  template <typename F>
+  void colNames(F f) const {
+    names(_cols, f);
+  }
+  template <typename F>
+  void rowNames(F f) const {
+    names(_rows, f);
+  }
+
+ private:
+  struct Range {
+    int first;
+    size_t n;
+    NameFunc f;
+  };
+
+  std::vector<Range> _cols, _rows;
+
+  template <typename F>
+  static void names(const std::vector<Range>& ranges, F f) {
+    for (const auto& r : ranges) {
+      for (size_t i = 0; i < r.n; i++) f(r.first + i, r.f(i));
+    }
+  }
+};
+
+// Index-based ILP model. Columns and rows are created in bulk, coefficients
+// are collected as (row, col, coef) triplets, and the whole model is passed
+// to a solver via ILPSolver::loadModel(). In contrast to the name-based
+// ILPSolver interface, no names are formatted or resolved while the model is
+// built - names may be attached to ranges of columns and rows, but they are
+// only generated when the model is written as an MPS file.
+//
+// If the model is not going to be written, the name functions can be
+// dropped right away by constructing it with names = false.
+//
+// Ids are indices into the model, which are also the solver ids if the
+// model is loaded into an empty solver. Every (row, col) pair may only get
+// a single coefficient.
+//
+// Independent parts of a model can be built separately (e.g. in parallel)
+// as part models and then added with append(). A part model constructed
+// with extCols = n may reference the first n columns of the model it is
+// appended to, in coefficients and in setObjCoef(). Its own columns are
+// numbered from n on. Part models can only be appended, not loaded.
+class ILPModel {
+ public:
+  ILPModel() : _keepNames(true), _extCols(0) {}
+  explicit ILPModel(bool names) : _keepNames(names), _extCols(0) {}
+  ILPModel(bool names, size_t extCols)
+      : _keepNames(names), _extCols(extCols) {}
+
+  int addCol(ColType colType, double objCoef);
+  int addCol(ColType colType, double objCoef, double lowBnd, double upBnd);
+  int addRow(double bnd, RowType rowType);
+
+  // add n columns / rows with the same attributes, returns the first id
+  int addCols(size_t n, ColType colType, double objCoef);
+  int addRows(size_t n, double bnd, RowType rowType);
+
+  void addColToRow(int rowId, int colId, double coef);
+  void setObjCoef(int colId, double coef);
+
+  void reserve(size_t cols, size_t rows, size_t coefs);
+
+  // append the columns, rows and coefficients of part model part, which
+  // must not reference more than the columns of this model
+  void append(const ILPModel& part);
+
+  // f(i) is the name of column / row first + i
+  template <typename F>
+  void setColNames(int first, size_t n, F f) {
+    if (_keepNames) _names.addCols(first, n, f);
+  }
+  template <typename F>
+  void setRowNames(int first, size_t n, F f) {
+    if (_keepNames) _names.addRows(first, n, f);
+  }
+  const ILPNames& getNames() const { return _names; }
+  bool keepsNames() const { return _keepNames; }
+
+  size_t getNumCols() const { return _colTypes.size(); }
+  size_t getNumRows() const { return _rowTypes.size(); }
+  size_t getNumCoefs() const { return _coefVals.size(); }
+
+  ColType getColType(int colId) const { return _colTypes[colId]; }
+  double getObjCoef(int colId) const { return _objCoefs[colId]; }
+  double getLowBnd(int colId) const { return _lowBnds[colId]; }
+  double getUpBnd(int colId) const { return _upBnds[colId]; }
+
+  RowType getRowType(int rowId) const { return _rowTypes[rowId]; }
+  double getRowBnd(int rowId) const { return _rowBnds[rowId]; }
+
+  // coefficients in insertion order
+  const std::vector<int>& getCoefRows() const { return _coefRows; }
+  const std::vector<int>& getCoefCols() const { return _coefCols; }
+  const std::vector<double>& getCoefVals() const { return _coefVals; }
+
+  // coefficient matrix in compressed sparse row format, the coefficients of
+  // row i are at [rowBeg[i], rowBeg[i + 1]), column ids are shifted by colOff
+  void getCSR(int colOff, std::vector<int>* rowBeg, std::vector<int>* colInd,
+              std::vector<double>* vals) const;
+
+  // binary (de)serialization of the columns, rows and coefficients, names
+  // are not written. read() returns false on malformed input and leaves the
+  // model in an unspecified state.
+  void write(std::ostream* os) const;
+  bool read(std::istream* is);
+
+ private:
+  std::vector<ColType> _colTypes;
+  std::vector<double> _objCoefs, _lowBnds, _upBnds;
+
+  std::vector<RowType> _rowTypes;
+  std::vector<double> _rowBnds;
+
+  std::vector<int> _coefRows, _coefCols;
+  std::vector<double> _coefVals;
+
+  bool _keepNames;
+  ILPNames _names;
+
+  // number of referenced columns of the model this part is appended to, and
+  // the objective coefficients set for them
+  size_t _extCols;
+  std::vector<std::pair<int, double>> _extObjCoefs;
+};
+
+}  // namespace optim
+}  // namespace shared
+
+#endif  // SHARED_OPTIM_ILPMODEL_H_
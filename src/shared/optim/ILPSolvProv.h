@@ -9,6 +9,8 @@
 #include "shared/optim/GLPKSolver.h"
 #include "shared/optim/GurobiSolver.h"
 #include "shared/optim/ILPSolver.h"
+#include "shared/optim/PortfolioSolver.h"
+#include "shared/optim/RemoteSolver.h"
 #include "util/log/Log.h"
 
 namespace shared {
@@ -23,6 +25,41 @@ class ILPProviderErr : public std::exception {
   std::string _msg;
 };
 
+// all available solvers, solving concurrently, see PortfolioSolver. If only
+// a single solver is available, it is returned directly.
+inline ILPSolver* getPortfolio(shared::optim::DirType dir) {
+  UNUSED(dir);
+  std::vector<std::pair<std::string, ILPSolver*>> solvers;
+
+#ifdef GUROBI_FOUND
+  try {
+    solvers.push_back({"gurobi", new shared::optim::GurobiSolver(dir)});
+  } catch (std::exception& e) {
+    LOG(ERROR) << e.what();
+  }
+#endif
+
+#if COIN_FOUND
+  try {
+    solvers.push_back({"cbc", new shared::optim::COINSolver(dir)});
+  } catch (std::exception& e) {
+    LOG(ERROR) << e.what();
+  }
+#endif
+
+#if GLPK_FOUND
+  try {
+    solvers.push_back({"glpk", new shared::optim::GLPKSolver(dir)});
+  } catch (std::exception& e) {
+    LOG(ERROR) << e.what();
+  }
+#endif
+
+  if (solvers.empty()) throw ILPProviderErr("No ILP solver found.");
+  if (solvers.size() == 1) return solvers.front().second;
+  return new shared::optim::PortfolioSolver(dir, solvers);
+}
+
 inline ILPSolver* getSolver(std::string wish, shared::optim::DirType dir) {
   UNUSED(dir);  // prevent warning if no ILP solver is present
   bool force = (wish.back() == '!');
@@ -37,6 +74,15 @@ inline ILPSolver* getSolver(std::string wish, shared::optim::DirType dir) {
   // aliases
   if (wish == "cbc") wish = "coin";
 
+  if (wish == "portfolio") return getPortfolio(dir);
+
+  if (wish == "remote") {
+    if (getRemoteCmd().size()) return new RemoteSolver(dir, getRemoteCmd());
+    if (force) {
+      throw ILPProviderErr("No command for the remote ILP solver configured");
+    }
+  }
+
   try {
 #ifdef GUROBI_FOUND
     if (wish == "gurobi") lp = new shared::optim::GurobiSolver(dir);
@@ -5,9 +5,13 @@
 #ifndef SHARED_OPTIM_ILPSOLVER_H_
 #define SHARED_OPTIM_ILPSOLVER_H_
 
+#include <atomic>
 #include <fstream>
+#include <functional>
 #include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace shared {
 namespace optim {
@@ -18,6 +22,13 @@ enum DirType { MAX, MIN };
 enum SolveType { OPTIM, INF, NON_OPTIM };
 
 typedef std::map<std::string, int> StarterSol;
+typedef std::vector<std::pair<int, int>> IdxStarterSol;
+
+class ILPModel;
+
+// called during solve() with the objective value and the column values of
+// each new incumbent, columns without a known value are NaN
+typedef std::function<void(double, const std::vector<double>&)> IncumbentFunc;
 
 class ILPSolver {
  public:
@@ -34,6 +45,12 @@ class ILPSolver {
                            const std::string& colName, double coef) = 0;
   virtual void addColToRow(int rowId, int colId, double coef) = 0;
 
+  // append the columns, rows and coefficients of an index-based model in
+  // bulk. The names of the model are only generated by writeMps(), so
+  // getVarByName() and getConstrByName() do not find these columns and rows
+  // before.
+  virtual void loadModel(const ILPModel& m) = 0;
+
   virtual int getVarByName(const std::string& name) const = 0;
   virtual int getConstrByName(const std::string& name) const = 0;
 
@@ -55,6 +72,18 @@ class ILPSolver {
   virtual void setNumThreads(int n) = 0;
   virtual int getNumThreads() const = 0;
 
+  // relative gap between the incumbent and the best bound at which solve()
+  // stops, negative values mean the solver default
+  virtual void setMipGap(double gap) = 0;
+  virtual double getMipGap() const = 0;
+
+  // the callback is called from the thread which runs solve()
+  void setIncumbentCb(const IncumbentFunc& f) { _incumbentCb = f; }
+
+  // once *stop is set (from any thread), solve() returns as soon as the
+  // solver checks it, with the best incumbent found so far
+  void setStopFlag(const std::atomic<bool>* stop) { _stop = stop; }
+
   virtual SolveType solve() = 0;
   virtual SolveType getStatus() = 0;
   virtual void update() = 0;
@@ -62,6 +91,7 @@ class ILPSolver {
   virtual double getObjVal() const = 0;
 
   virtual void setStarter(const StarterSol& starterSol) = 0;
+  virtual void setStarter(const IdxStarterSol& starterSol) = 0;
 
   virtual int getNumConstrs() const = 0;
   virtual int getNumVars() const = 0;
@@ -73,6 +103,12 @@ class ILPSolver {
 
     for (auto kv : sol) fo << kv.first << "\t" << kv.second << "\n";
   }
+
+ protected:
+  IncumbentFunc _incumbentCb;
+  const std::atomic<bool>* _stop = 0;
+
+  bool stopRequested() const { return _stop && _stop->load(); }
 };
 
 }  // namespace optim
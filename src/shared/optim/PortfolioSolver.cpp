@@ -0,0 +1,263 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include "shared/optim/PortfolioSolver.h"
+#include "util/log/Log.h"
+
+using shared::optim::ILPSolver;
+using shared::optim::PortfolioSolver;
+using shared::optim::SolveType;
+
+// _____________________________________________________________________________
+PortfolioSolver::PortfolioSolver(
+    DirType dir, const std::vector<std::pair<std::string, ILPSolver*>>& solvers)
+    : _dir(dir), _best(solvers.front().second), _status(INF), _numThreads(0) {
+  for (const auto& s : solvers) {
+    _names.push_back(s.first);
+    _solvers.emplace_back(s.second);
+  }
+}
+
+// _____________________________________________________________________________
+int PortfolioSolver::addCol(const std::string& name, ColType colType,
+                            double objCoef) {
+  int ret = -1;
+  for (auto& s : _solvers) {
+    int id = s->addCol(name, colType, objCoef);
+    if (ret < 0) ret = id;
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+int PortfolioSolver::addCol(const std::string& name, ColType colType,
+                            double objCoef, double lowBnd, double upBnd) {
+  int ret = -1;
+  for (auto& s : _solvers) {
+    int id = s->addCol(name, colType, objCoef, lowBnd, upBnd);
+    if (ret < 0) ret = id;
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+int PortfolioSolver::addRow(const std::string& name, double bnd,
+                            RowType rowType) {
+  int ret = -1;
+  for (auto& s : _solvers) {
+    int id = s->addRow(name, bnd, rowType);
+    if (ret < 0) ret = id;
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::addColToRow(const std::string& rowName,
+                                  const std::string& colName, double coef) {
+  for (auto& s : _solvers) s->addColToRow(rowName, colName, coef);
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::addColToRow(int rowId, int colId, double coef) {
+  for (auto& s : _solvers) s->addColToRow(rowId, colId, coef);
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::loadModel(const ILPModel& m) {
+  for (auto& s : _solvers) s->loadModel(m);
+}
+
+// _____________________________________________________________________________
+int PortfolioSolver::getVarByName(const std::string& name) const {
+  return _solvers.front()->getVarByName(name);
+}
+
+// _____________________________________________________________________________
+int PortfolioSolver::getConstrByName(const std::string& name) const {
+  return _solvers.front()->getConstrByName(name);
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::setObjCoef(const std::string& name, double coef) const {
+  for (auto& s : _solvers) s->setObjCoef(name, coef);
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::setObjCoef(int colId, double coef) const {
+  for (auto& s : _solvers) s->setObjCoef(colId, coef);
+}
+
+// _____________________________________________________________________________
+double PortfolioSolver::getVarVal(int colId) const {
+  return _best->getVarVal(colId);
+}
+
+// _____________________________________________________________________________
+double PortfolioSolver::getVarVal(const std::string& name) const {
+  return _best->getVarVal(name);
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::setTimeLim(int s) {
+  for (auto& slv : _solvers) slv->setTimeLim(s);
+}
+
+// _____________________________________________________________________________
+int PortfolioSolver::getTimeLim() const {
+  return _solvers.front()->getTimeLim();
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::setCacheDir(const std::string& dir) {
+  for (auto& s : _solvers) s->setCacheDir(dir);
+}
+
+// _____________________________________________________________________________
+std::string PortfolioSolver::getCacheDir() const {
+  return _solvers.front()->getCacheDir();
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::setCacheThreshold(double gb) {
+  for (auto& s : _solvers) s->setCacheThreshold(gb);
+}
+
+// _____________________________________________________________________________
+double PortfolioSolver::getCacheThreshold() const {
+  return _solvers.front()->getCacheThreshold();
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::setNumThreads(int n) {
+  _numThreads = n;
+  if (n <= 0) n = std::max(1u, std::thread::hardware_concurrency());
+
+  int share = std::max<int>(1, n / _solvers.size());
+  for (auto& s : _solvers) s->setNumThreads(share);
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::setMipGap(double gap) {
+  for (auto& s : _solvers) s->setMipGap(gap);
+}
+
+// _____________________________________________________________________________
+double PortfolioSolver::getMipGap() const {
+  return _solvers.front()->getMipGap();
+}
+
+// _____________________________________________________________________________
+bool PortfolioSolver::better(double a, double b) const {
+  return _dir == MIN ? a < b : a > b;
+}
+
+// _____________________________________________________________________________
+SolveType PortfolioSolver::solve() {
+  if (_numThreads == 0) setNumThreads(0);
+
+  std::atomic<bool> stop(false);
+  std::mutex m;
+  int winner = -1;
+
+  // the incumbent callback only sees improvements over all solvers
+  double bestObj = _dir == MIN ? std::numeric_limits<double>::infinity()
+                               : -std::numeric_limits<double>::infinity();
+
+  std::vector<SolveType> res(_solvers.size(), INF);
+  std::vector<std::thread> thrds;
+
+  for (size_t i = 0; i < _solvers.size(); i++) {
+    auto s = _solvers[i].get();
+    s->setStopFlag(&stop);
+    if (_incumbentCb) {
+      s->setIncumbentCb([&](double obj, const std::vector<double>& vals) {
+        std::lock_guard<std::mutex> lock(m);
+        if (!better(obj, bestObj)) return;
+        bestObj = obj;
+        _incumbentCb(obj, vals);
+      });
+    }
+
+    thrds.emplace_back([&, i, s]() {
+      try {
+        res[i] = s->solve();
+      } catch (const std::exception& e) {
+        LOG(ERROR) << e.what();
+        res[i] = INF;
+      }
+
+      if (res[i] == OPTIM) {
+        std::lock_guard<std::mutex> lock(m);
+        if (winner < 0) winner = i;
+        stop = true;
+      }
+    });
+  }
+
+  for (auto& t : thrds) t.join();
+
+  if (winner < 0) {
+    // no solver proved optimality, keep the best incumbent
+    for (size_t i = 0; i < _solvers.size(); i++) {
+      if (res[i] != NON_OPTIM) continue;
+      if (winner < 0 || better(_solvers[i]->getObjVal(),
+                               _solvers[winner]->getObjVal())) {
+        winner = i;
+      }
+    }
+  }
+
+  for (auto& s : _solvers) s->setStopFlag(0);
+
+  if (winner < 0) {
+    _best = _solvers.front().get();
+    _status = INF;
+  } else {
+    _best = _solvers[winner].get();
+    _status = res[winner];
+    LOGTO(DEBUG, std::cerr)
+        << "Using the " << (_status == OPTIM ? "optimal " : "")
+        << "solution of " << _names[winner] << " from the ILP portfolio";
+  }
+
+  return _status;
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::update() {
+  for (auto& s : _solvers) s->update();
+}
+
+// _____________________________________________________________________________
+double PortfolioSolver::getObjVal() const { return _best->getObjVal(); }
+
+// _____________________________________________________________________________
+void PortfolioSolver::setStarter(const StarterSol& starterSol) {
+  for (auto& s : _solvers) s->setStarter(starterSol);
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::setStarter(const IdxStarterSol& starterSol) {
+  for (auto& s : _solvers) s->setStarter(starterSol);
+}
+
+// _____________________________________________________________________________
+int PortfolioSolver::getNumConstrs() const {
+  return _solvers.front()->getNumConstrs();
+}
+
+// _____________________________________________________________________________
+int PortfolioSolver::getNumVars() const {
+  return _solvers.front()->getNumVars();
+}
+
+// _____________________________________________________________________________
+void PortfolioSolver::writeMps(const std::string& path) const {
+  _solvers.front()->writeMps(path);
+}
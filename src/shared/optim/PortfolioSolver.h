@@ -0,0 +1,99 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_OPTIM_PORTFOLIOSOLVER_H_
+#define SHARED_OPTIM_PORTFOLIOSOLVER_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "shared/optim/ILPModel.h"
+#include "shared/optim/ILPSolver.h"
+
+namespace shared {
+namespace optim {
+
+// Solves a model with several solvers at once. The model is passed to all
+// of them (an ILPModel is built once and loaded into each), solve() runs
+// them concurrently and stops the others as soon as one of them proves
+// optimality. Otherwise, the best incumbent of all solvers is kept. The
+// thread budget given with setNumThreads() is split between the solvers.
+//
+// All solvers must number the columns and rows in insertion order, the ids
+// returned are those of the first solver.
+class PortfolioSolver : public ILPSolver {
+ public:
+  // takes ownership of the solvers, which are given with their names
+  PortfolioSolver(
+      DirType dir,
+      const std::vector<std::pair<std::string, ILPSolver*>>& solvers);
+
+  int addCol(const std::string& name, ColType colType, double objCoef);
+  int addCol(const std::string& name, ColType colType, double objCoef,
+             double lowBnd, double upBnd);
+  int addRow(const std::string& name, double bnd, RowType rowType);
+
+  void addColToRow(const std::string& rowName, const std::string& colName,
+                   double coef);
+  void addColToRow(int rowId, int colId, double coef);
+
+  void loadModel(const ILPModel& m);
+
+  int getVarByName(const std::string& name) const;
+  int getConstrByName(const std::string& name) const;
+
+  void setObjCoef(const std::string& name, double coef) const;
+  void setObjCoef(int colId, double coef) const;
+
+  double getVarVal(int colId) const;
+  double getVarVal(const std::string& name) const;
+
+  void setTimeLim(int s);
+  int getTimeLim() const;
+
+  void setCacheDir(const std::string& dir);
+  std::string getCacheDir() const;
+
+  void setCacheThreshold(double gb);
+  double getCacheThreshold() const;
+
+  void setNumThreads(int n);
+  int getNumThreads() const { return _numThreads; }
+
+  void setMipGap(double gap);
+  double getMipGap() const;
+
+  SolveType solve();
+  SolveType getStatus() { return _status; }
+  void update();
+
+  double getObjVal() const;
+
+  void setStarter(const StarterSol& starterSol);
+  void setStarter(const IdxStarterSol& starterSol);
+
+  int getNumConstrs() const;
+  int getNumVars() const;
+
+  void writeMps(const std::string& path) const;
+
+ private:
+  DirType _dir;
+  std::vector<std::unique_ptr<ILPSolver>> _solvers;
+  std::vector<std::string> _names;
+
+  // the solver whose solution is read, the first one before solve()
+  const ILPSolver* _best;
+
+  SolveType _status;
+  int _numThreads;
+
+  bool better(double a, double b) const;
+};
+
+}  // namespace optim
+}  // namespace shared
+
+#endif  // SHARED_OPTIM_PORTFOLIOSOLVER_H_
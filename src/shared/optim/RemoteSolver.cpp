@@ -0,0 +1,369 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include "shared/optim/ILPSolvProv.h"
+#include "shared/optim/RemoteSolver.h"
+#include "util/Misc.h"
+#include "util/log/Log.h"
+
+using shared::optim::DirType;
+using shared::optim::IdxStarterSol;
+using shared::optim::ILPModel;
+using shared::optim::ILPSolver;
+using shared::optim::RemoteSolver;
+using shared::optim::SolveType;
+
+namespace {
+
+std::string remoteCmd;
+
+// _____________________________________________________________________________
+template <typename T>
+void writeVal(std::ostream* os, T v) {
+  os->write(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+// _____________________________________________________________________________
+template <typename T>
+bool readVal(std::istream* is, T* v) {
+  return static_cast<bool>(is->read(reinterpret_cast<char*>(v), sizeof(T)));
+}
+
+// _____________________________________________________________________________
+template <typename T>
+void writeVec(std::ostream* os, const std::vector<T>& v) {
+  writeVal<uint64_t>(os, v.size());
+  os->write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+}
+
+// _____________________________________________________________________________
+template <typename T>
+bool readVec(std::istream* is, std::vector<T>* v) {
+  uint64_t n = 0;
+  if (!readVal(is, &n)) return false;
+  // guard against allocating garbage sizes
+  if (n > std::numeric_limits<int>::max()) return false;
+  v->resize(n);
+  return static_cast<bool>(
+      is->read(reinterpret_cast<char*>(v->data()), n * sizeof(T)));
+}
+
+// _____________________________________________________________________________
+bool readMagic(std::istream* is, const char* magic) {
+  char buf[4];
+  uint32_t version = 0;
+  return is->read(buf, 4) && std::memcmp(buf, magic, 4) == 0 &&
+         readVal(is, &version) && version == shared::optim::REMOTE_VERSION;
+}
+
+// _____________________________________________________________________________
+void writeResp(std::ostream* out, SolveType status, double obj,
+               const std::vector<double>& vals) {
+  out->write(shared::optim::REMOTE_RESP_MAGIC, 4);
+  writeVal<uint32_t>(out, shared::optim::REMOTE_VERSION);
+  writeVal<uint8_t>(out, status);
+  writeVal(out, obj);
+  writeVec(out, vals);
+}
+
+// _____________________________________________________________________________
+std::string shellQuote(const std::string& s) {
+  std::string ret = "'";
+  for (char c : s) {
+    if (c == '\'') {
+      ret += "'\\''";
+    } else {
+      ret += c;
+    }
+  }
+  return ret + "'";
+}
+
+}  // namespace
+
+// _____________________________________________________________________________
+RemoteSolver::RemoteSolver(DirType dir, const std::string& cmd)
+    : _dir(dir),
+      _cmd(cmd),
+      _timeLimit(std::numeric_limits<int>::max()),
+      _numThreads(0),
+      _mipGap(-1),
+      _status(INF),
+      _obj(0) {}
+
+// _____________________________________________________________________________
+int RemoteSolver::addCol(const std::string& name, ColType colType,
+                         double objCoef) {
+  int id = _m.addCol(colType, objCoef);
+  _m.setColNames(id, 1, [name](size_t) { return name; });
+  _colIds[name] = id;
+  return id;
+}
+
+// _____________________________________________________________________________
+int RemoteSolver::addCol(const std::string& name, ColType colType,
+                         double objCoef, double lowBnd, double upBnd) {
+  int id = _m.addCol(colType, objCoef, lowBnd, upBnd);
+  _m.setColNames(id, 1, [name](size_t) { return name; });
+  _colIds[name] = id;
+  return id;
+}
+
+// _____________________________________________________________________________
+int RemoteSolver::addRow(const std::string& name, double bnd,
+                         RowType rowType) {
+  int id = _m.addRow(bnd, rowType);
+  _m.setRowNames(id, 1, [name](size_t) { return name; });
+  _rowIds[name] = id;
+  return id;
+}
+
+// _____________________________________________________________________________
+void RemoteSolver::addColToRow(const std::string& rowName,
+                               const std::string& colName, double coef) {
+  int rowId = getConstrByName(rowName);
+  int colId = getVarByName(colName);
+  if (rowId < 0 || colId < 0) return;
+  _m.addColToRow(rowId, colId, coef);
+}
+
+// _____________________________________________________________________________
+void RemoteSolver::addColToRow(int rowId, int colId, double coef) {
+  _m.addColToRow(rowId, colId, coef);
+}
+
+// _____________________________________________________________________________
+void RemoteSolver::loadModel(const ILPModel& m) { _m.append(m); }
+
+// _____________________________________________________________________________
+int RemoteSolver::getVarByName(const std::string& name) const {
+  auto it = _colIds.find(name);
+  if (it == _colIds.end()) return -1;
+  return it->second;
+}
+
+// _____________________________________________________________________________
+int RemoteSolver::getConstrByName(const std::string& name) const {
+  auto it = _rowIds.find(name);
+  if (it == _rowIds.end()) return -1;
+  return it->second;
+}
+
+// _____________________________________________________________________________
+void RemoteSolver::setObjCoef(const std::string& name, double coef) const {
+  int colId = getVarByName(name);
+  if (colId < 0) return;
+  setObjCoef(colId, coef);
+}
+
+// _____________________________________________________________________________
+void RemoteSolver::setObjCoef(int colId, double coef) const {
+  _m.setObjCoef(colId, coef);
+}
+
+// _____________________________________________________________________________
+double RemoteSolver::getVarVal(int colId) const {
+  if (colId < 0 || static_cast<size_t>(colId) >= _vals.size()) return 0;
+  return _vals[colId];
+}
+
+// _____________________________________________________________________________
+double RemoteSolver::getVarVal(const std::string& name) const {
+  return getVarVal(getVarByName(name));
+}
+
+// _____________________________________________________________________________
+void RemoteSolver::setCacheDir(const std::string& dir) { UNUSED(dir); }
+
+// _____________________________________________________________________________
+void RemoteSolver::setCacheThreshold(double gb) { UNUSED(gb); }
+
+// _____________________________________________________________________________
+void RemoteSolver::setStarter(const StarterSol& starterSol) {
+  for (const auto& kv : starterSol) {
+    int colId = getVarByName(kv.first);
+    if (colId >= 0) _starter.push_back({colId, kv.second});
+  }
+}
+
+// _____________________________________________________________________________
+void RemoteSolver::setStarter(const IdxStarterSol& starterSol) {
+  _starter.insert(_starter.end(), starterSol.begin(), starterSol.end());
+}
+
+// _____________________________________________________________________________
+void RemoteSolver::writeMps(const std::string& path) const {
+  std::unique_ptr<ILPSolver> lp(getSolver("gurobi", _dir));
+  lp->loadModel(_m);
+  lp->update();
+  lp->writeMps(path);
+}
+
+// _____________________________________________________________________________
+SolveType RemoteSolver::solve() {
+  if (!solveRemote()) {
+    LOG(ERROR) << "Remote ILP solver command failed, solving locally.";
+    solveLocal();
+  }
+  return _status;
+}
+
+// _____________________________________________________________________________
+bool RemoteSolver::solveRemote() {
+  if (_cmd.empty()) return false;
+
+  const char* tmp = getenv("TMPDIR");
+  std::string tmpl = std::string(tmp && *tmp ? tmp : "/tmp") + "/ilp-XXXXXX";
+
+  std::vector<char> buf(tmpl.begin(), tmpl.end());
+  buf.push_back(0);
+  if (!mkdtemp(buf.data())) return false;
+
+  std::string dir = buf.data();
+  std::string reqPath = dir + "/req";
+  std::string respPath = dir + "/resp";
+
+  bool ok = false;
+
+  std::ofstream req(reqPath, std::ios::binary);
+  writeRemoteReq(&req, _dir, _timeLimit, _mipGap, _numThreads, _starter, _m);
+  req.close();
+
+  if (req.good()) {
+    LOG(DEBUG) << "Sending ILP with " << getNumVars() << " cols and "
+               << getNumConstrs() << " rows to '" << _cmd << "'...";
+
+    std::string cmd = "(" + _cmd + ") < " + shellQuote(reqPath) + " > " +
+                      shellQuote(respPath);
+    int ret = std::system(cmd.c_str());
+
+    std::ifstream resp(respPath, std::ios::binary);
+    uint8_t status;
+    std::vector<double> vals;
+
+    if (ret == 0 && readMagic(&resp, REMOTE_RESP_MAGIC) &&
+        readVal(&resp, &status) && status <= NON_OPTIM &&
+        readVal(&resp, &_obj) && readVec(&resp, &vals) &&
+        (status == INF || vals.size() == _m.getNumCols())) {
+      _status = static_cast<SolveType>(status);
+      _vals = vals;
+      ok = true;
+    }
+  }
+
+  std::remove(reqPath.c_str());
+  std::remove(respPath.c_str());
+  rmdir(dir.c_str());
+
+  return ok;
+}
+
+// _____________________________________________________________________________
+void RemoteSolver::solveLocal() {
+  std::unique_ptr<ILPSolver> lp(getSolver("gurobi", _dir));
+  lp->loadModel(_m);
+  lp->setTimeLim(_timeLimit);
+  lp->setMipGap(_mipGap);
+  if (_numThreads > 0) lp->setNumThreads(_numThreads);
+  lp->setStarter(_starter);
+  lp->setStopFlag(_stop);
+  lp->setIncumbentCb(_incumbentCb);
+  lp->update();
+
+  _status = lp->solve();
+  _obj = 0;
+  _vals.clear();
+
+  if (_status == INF) return;
+
+  _obj = lp->getObjVal();
+  for (size_t i = 0; i < _m.getNumCols(); i++) {
+    _vals.push_back(lp->getVarVal(i));
+  }
+}
+
+// _____________________________________________________________________________
+void shared::optim::writeRemoteReq(std::ostream* out, DirType dir,
+                                   int timeLimit, double mipGap,
+                                   int numThreads, const IdxStarterSol& starter,
+                                   const ILPModel& m) {
+  out->write(REMOTE_REQ_MAGIC, 4);
+  writeVal<uint32_t>(out, REMOTE_VERSION);
+  writeVal<uint8_t>(out, dir);
+  writeVal<int32_t>(out, timeLimit);
+  writeVal(out, mipGap);
+  writeVal<int32_t>(out, numThreads);
+
+  std::vector<int32_t> sol;
+  for (const auto& s : starter) {
+    sol.push_back(s.first);
+    sol.push_back(s.second);
+  }
+  writeVec(out, sol);
+
+  m.write(out);
+}
+
+// _____________________________________________________________________________
+bool shared::optim::serveRemote(std::istream* in, std::ostream* out,
+                                const std::string& wish) {
+  uint8_t dir;
+  int32_t timeLimit, numThreads;
+  double mipGap;
+  std::vector<int32_t> sol;
+  ILPModel m(false);
+
+  if (!readMagic(in, REMOTE_REQ_MAGIC) || !readVal(in, &dir) || dir > MIN ||
+      !readVal(in, &timeLimit) || !readVal(in, &mipGap) ||
+      !readVal(in, &numThreads) || !readVec(in, &sol) || sol.size() % 2 ||
+      !m.read(in)) {
+    return false;
+  }
+
+  IdxStarterSol starter;
+  for (size_t i = 0; i + 1 < sol.size(); i += 2) {
+    if (sol[i] < 0 || static_cast<size_t>(sol[i]) >= m.getNumCols()) {
+      return false;
+    }
+    starter.push_back({sol[i], sol[i + 1]});
+  }
+
+  // never forward the request again
+  std::unique_ptr<ILPSolver> lp(getSolver(
+      wish == "remote" ? "gurobi" : wish, static_cast<DirType>(dir)));
+
+  lp->loadModel(m);
+  lp->setTimeLim(timeLimit);
+  lp->setMipGap(mipGap);
+  if (numThreads > 0) lp->setNumThreads(numThreads);
+  lp->setStarter(starter);
+  lp->update();
+
+  SolveType status = lp->solve();
+
+  std::vector<double> vals;
+  double obj = 0;
+  if (status != INF) {
+    obj = lp->getObjVal();
+    for (size_t i = 0; i < m.getNumCols(); i++) vals.push_back(lp->getVarVal(i));
+  }
+
+  writeResp(out, status, obj, vals);
+  out->flush();
+  return out->good();
+}
+
+// _____________________________________________________________________________
+void shared::optim::setRemoteCmd(const std::string& cmd) { remoteCmd = cmd; }
+
+// _____________________________________________________________________________
+const std::string& shared::optim::getRemoteCmd() { return remoteCmd; }
@@ -0,0 +1,135 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_OPTIM_REMOTESOLVER_H_
+#define SHARED_OPTIM_REMOTESOLVER_H_
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "shared/optim/ILPModel.h"
+#include "shared/optim/ILPSolver.h"
+
+namespace shared {
+namespace optim {
+
+static const char REMOTE_REQ_MAGIC[4] = {'L', 'I', 'L', 'P'};
+static const char REMOTE_RESP_MAGIC[4] = {'L', 'S', 'O', 'L'};
+static const uint32_t REMOTE_VERSION = 1;
+
+// Solves models with an external command, typically on a solver farm. The
+// model is collected into an ILPModel. solve() writes a request with the
+// model, the solver parameters and the starter solution to the standard
+// input of the command, which has to write the response to its standard
+// output. ilpworker answers requests, so "ssh farm ilpworker" or a service
+// in front of ilpworker (e.g. "curl -s --data-binary @- http://farm/solve")
+// work as commands. If the command fails, the model is solved locally.
+//
+// Request:  "LILP", version (uint32), direction (uint8), time limit in s
+//           (int32), MIP gap (double), threads (int32), starter (vector of
+//           int32 column, int32 value pairs), the model (ILPModel::write())
+// Response: "LSOL", version (uint32), status (uint8 SolveType), objective
+//           (double), column values (vector of double)
+//
+// Vectors are written as their uint64 length followed by the elements, all
+// numbers in host byte order.
+class RemoteSolver : public ILPSolver {
+ public:
+  RemoteSolver(DirType dir, const std::string& cmd);
+
+  int addCol(const std::string& name, ColType colType, double objCoef);
+  int addCol(const std::string& name, ColType colType, double objCoef,
+             double lowBnd, double upBnd);
+  int addRow(const std::string& name, double bnd, RowType rowType);
+
+  void addColToRow(const std::string& rowName, const std::string& colName,
+                   double coef);
+  void addColToRow(int rowId, int colId, double coef);
+
+  void loadModel(const ILPModel& m);
+
+  int getVarByName(const std::string& name) const;
+  int getConstrByName(const std::string& name) const;
+
+  void setObjCoef(const std::string& name, double coef) const;
+  void setObjCoef(int colId, double coef) const;
+
+  double getVarVal(int colId) const;
+  double getVarVal(const std::string& name) const;
+
+  void setTimeLim(int s) { _timeLimit = s; }
+  int getTimeLim() const { return _timeLimit; }
+
+  // models are not cached by the remote solver
+  void setCacheDir(const std::string& dir);
+  std::string getCacheDir() const { return ""; }
+
+  void setCacheThreshold(double gb);
+  double getCacheThreshold() const { return 0; }
+
+  void setNumThreads(int n) { _numThreads = n; }
+  int getNumThreads() const { return _numThreads; }
+
+  void setMipGap(double gap) { _mipGap = gap; }
+  double getMipGap() const { return _mipGap; }
+
+  SolveType solve();
+  SolveType getStatus() { return _status; }
+  void update() {}
+
+  double getObjVal() const { return _obj; }
+
+  void setStarter(const StarterSol& starterSol);
+  void setStarter(const IdxStarterSol& starterSol);
+
+  int getNumConstrs() const { return _m.getNumRows(); }
+  int getNumVars() const { return _m.getNumCols(); }
+
+  void writeMps(const std::string& path) const;
+
+ private:
+  DirType _dir;
+  std::string _cmd;
+
+  // the model is not changed by setObjCoef() in the interface sense
+  mutable ILPModel _m;
+  std::map<std::string, int> _colIds, _rowIds;
+
+  IdxStarterSol _starter;
+
+  int _timeLimit;
+  int _numThreads;
+  double _mipGap;
+
+  SolveType _status;
+  double _obj;
+  std::vector<double> _vals;
+
+  // false if the command failed or its response is malformed
+  bool solveRemote();
+
+  // solve the model with a local solver, used if the command failed
+  void solveLocal();
+};
+
+// write a request of the given model and parameters to out
+void writeRemoteReq(std::ostream* out, DirType dir, int timeLimit,
+                    double mipGap, int numThreads, const IdxStarterSol& starter,
+                    const ILPModel& m);
+
+// read a request from in, solve it with the ILP solver wish (see
+// getSolver()) and write the response to out. False if the request is
+// malformed.
+bool serveRemote(std::istream* in, std::ostream* out, const std::string& wish);
+
+// the command used by remote solvers, for --ilp-solver remote
+void setRemoteCmd(const std::string& cmd);
+const std::string& getRemoteCmd();
+
+}  // namespace optim
+}  // namespace shared
+
+#endif  // SHARED_OPTIM_REMOTESOLVER_H_
@@ -30,11 +30,16 @@ class HierarOrderCfg : public std::map<const shared::linegraph::LineEdge*,
                                        std::map<size_t, Ordering>> {
  public:
   void writeFlatCfg(OrderCfg* c) const {
-    for (auto kv : *this) {
-      for (auto ordering : kv.second) {
-        (*c)[kv.first].insert((*c)[kv.first].begin(), ordering.second.begin(),
-                              ordering.second.end());
-      }
+    for (const auto& kv : *this) writeFlatOrdering(kv.second, &(*c)[kv.first]);
+  }
+
+  // the flat ordering of the parts of an edge, replaces o. The parts are
+  // written in descending order.
+  static void writeFlatOrdering(const std::map<size_t, Ordering>& parts,
+                                Ordering* o) {
+    o->clear();
+    for (auto it = parts.rbegin(); it != parts.rend(); ++it) {
+      o->insert(o->end(), it->second.begin(), it->second.end());
     }
   }
 };
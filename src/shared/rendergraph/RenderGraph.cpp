@@ -2,7 +2,11 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <cmath>
+#include <deque>
+#include <limits>
 #include <set>
+#include <stack>
 #include <string>
 
 #include "3rdparty/json.hpp"
@@ -19,8 +23,10 @@ using shared::linegraph::LineNode;
 using shared::linegraph::LineOcc;
 using shared::linegraph::NodeFront;
 using shared::linegraph::Partner;
+using shared::rendergraph::HierarOrderCfg;
 using shared::rendergraph::InnerGeom;
 using shared::rendergraph::OrderCfg;
+using shared::rendergraph::Ordering;
 using shared::rendergraph::RenderGraph;
 using util::geo::BezierCurve;
 using util::geo::dist;
@@ -29,6 +35,20 @@ using util::geo::MultiLine;
 using util::geo::Polygon;
 using util::geo::PolyLine;
 
+namespace {
+// _____________________________________________________________________________
+bool sameCoords(const std::vector<double>& a, const std::vector<double>& b) {
+  // NaN separators never compare equal, compare them by position only
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i] != b[i] && !(std::isnan(a[i]) && std::isnan(b[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
 // _____________________________________________________________________________
 RenderGraph::RenderGraph(const shared::linegraph::LineGraph& lg,
                          double defLineWidth, double _defOutlineWidth,
@@ -70,6 +90,20 @@ void RenderGraph::writePermutation(const OrderCfg& c) {
   }
 }
 
+// _____________________________________________________________________________
+void RenderGraph::writePermutation(const HierarOrderCfg& c) {
+  Ordering o;
+  for (auto n : getNds()) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      auto it = c.find(e);
+      if (it == c.end()) continue;
+      HierarOrderCfg::writeFlatOrdering(it->second, &o);
+      e->pl().writePermutation(o);
+    }
+  }
+}
+
 // _____________________________________________________________________________
 bool RenderGraph::isTerminus(const LineNode* n) {
   if (n->getDeg() == 1) return true;
@@ -85,9 +119,65 @@ bool RenderGraph::isTerminus(const LineNode* n) {
   return false;
 }
 
+// _____________________________________________________________________________
+void RenderGraph::innerGeomState(const LineNode* n,
+                                 std::vector<const void*>* ptrs,
+                                 std::vector<double>* coords) {
+  for (const auto& nf : n->pl().fronts()) {
+    ptrs->push_back(nf.edge);
+    for (size_t j = 0; j < nf.edge->pl().getLines().size(); j++) {
+      ptrs->push_back(nf.edge->pl().lineOccAtPos(j).line);
+    }
+
+    for (const auto& p : nf.geom.getLine()) {
+      coords->push_back(p.getX());
+      coords->push_back(p.getY());
+    }
+
+    coords->push_back(std::numeric_limits<double>::quiet_NaN());
+
+    for (const auto& p : *nf.edge->pl().getGeom()) {
+      coords->push_back(p.getX());
+      coords->push_back(p.getY());
+    }
+
+    coords->push_back(std::numeric_limits<double>::quiet_NaN());
+  }
+}
+
 // _____________________________________________________________________________
 std::vector<InnerGeom> RenderGraph::innerGeoms(const LineNode* n,
                                                double prec) const {
+  std::vector<const void*> ptrs;
+  std::vector<double> coords;
+  innerGeomState(n, &ptrs, &coords);
+
+  bool hit = false;
+  std::vector<InnerGeom> ret;
+
+#pragma omp critical(renderGraphInnerGeoms)
+  {
+    auto it = _innerGeomCache.find(n);
+    if (it != _innerGeomCache.end() && it->second.prec == prec &&
+        it->second.ptrs == ptrs && sameCoords(it->second.coords, coords)) {
+      ret = it->second.geoms;
+      hit = true;
+    }
+  }
+
+  if (hit) return ret;
+
+  ret = computeInnerGeoms(n, prec);
+
+#pragma omp critical(renderGraphInnerGeoms)
+  _innerGeomCache[n] = {prec, ptrs, coords, ret};
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<InnerGeom> RenderGraph::computeInnerGeoms(const LineNode* n,
+                                                      double prec) const {
   std::vector<InnerGeom> ret;
   std::map<const Line*, std::set<const LineEdge*>> processed;
 
@@ -424,9 +514,80 @@ bool RenderGraph::notCompletelyServed(const LineNode* n) {
   return false;
 }
 
+// _____________________________________________________________________________
+void RenderGraph::stopGeomState(const LineNode* n,
+                                std::vector<const void*>* ptrs,
+                                std::vector<double>* coords) {
+  innerGeomState(n, ptrs, coords);
+
+  for (const auto& nf : n->pl().fronts()) {
+    for (const auto& p : nf.origGeom.getLine()) {
+      coords->push_back(p.getX());
+      coords->push_back(p.getY());
+    }
+    coords->push_back(std::numeric_limits<double>::quiet_NaN());
+  }
+
+  // the adjacent edges and their lines, fronts may not cover all of them
+  for (auto e : n->getAdjList()) {
+    ptrs->push_back(e);
+    for (const auto& lo : e->pl().getLines()) ptrs->push_back(lo.line);
+  }
+
+  ptrs->push_back(0);
+  for (auto l : n->pl().getLinesNotServed()) ptrs->push_back(l);
+}
+
 // _____________________________________________________________________________
 std::vector<Polygon<double>> RenderGraph::getStopGeoms(
     const LineNode* n, bool tight, size_t pointsPerCircle) const {
+  std::vector<const void*> ptrs;
+  std::vector<double> coords;
+  stopGeomState(n, &ptrs, &coords);
+
+  bool hit = false;
+  std::vector<Polygon<double>> ret;
+
+#pragma omp critical(renderGraphStopGeoms)
+  {
+    auto it = _stopGeomCache.find(n);
+    if (it != _stopGeomCache.end()) {
+      for (const auto& entry : it->second) {
+        if (entry.tight == tight && entry.pointsPerCircle == pointsPerCircle &&
+            entry.ptrs == ptrs && sameCoords(entry.coords, coords)) {
+          ret = entry.geoms;
+          hit = true;
+          break;
+        }
+      }
+    }
+  }
+
+  if (hit) return ret;
+
+  ret = computeStopGeoms(n, tight, pointsPerCircle);
+
+#pragma omp critical(renderGraphStopGeoms)
+  {
+    // one entry per parameter set, a stale entry is replaced
+    auto& entries = _stopGeomCache[n];
+    bool found = false;
+    for (auto& entry : entries) {
+      if (entry.tight == tight && entry.pointsPerCircle == pointsPerCircle) {
+        entry = {tight, pointsPerCircle, ptrs, coords, ret};
+        found = true;
+        break;
+      }
+    }
+    if (!found) entries.push_back({tight, pointsPerCircle, ptrs, coords, ret});
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<Polygon<double>> RenderGraph::computeStopGeoms(
+    const LineNode* n, bool tight, size_t pointsPerCircle) const {
   double d = _defWidth + (2 * _defOutlineWidth + _defSpacing) * 0.8;
   if (notCompletelyServed(n)) {
     // render each stop individually
@@ -568,8 +729,26 @@ double RenderGraph::getOutAngle(const LineNode* n, const LineEdge* e) {
 
 // _____________________________________________________________________________
 void RenderGraph::createMetaNodes() {
-  std::vector<NodeFront> cands;
-  while ((cands = getNextMetaNodeCand()).size() > 0) {
+  // every node is checked once as a clique seed, after a merge only the
+  // neighborhood of the new node has to be checked again
+  std::deque<LineNode*> work;
+  std::set<LineNode*> queued;
+
+  for (auto n : getNds()) {
+    work.push_back(n);
+    queued.insert(n);
+  }
+
+  while (!work.empty()) {
+    LineNode* seed = work.front();
+    work.pop_front();
+
+    // deleted in a previous merge
+    if (!queued.erase(seed)) continue;
+
+    auto cands = getMetaNodeCand(seed);
+    if (cands.empty()) continue;
+
     // remove all edges completely contained
     for (auto nf : cands) {
       auto onfs = getClosedNodeFronts(nf.n);
@@ -664,65 +843,94 @@ void RenderGraph::createMetaNodes() {
 
     // delete the nodes marked for deletion
     for (auto toDelNd : toDel) {
+      queued.erase(toDelNd);
       getNdGrid()->remove(toDelNd);
       delNd(toDelNd);
     }
+
+    // the fronts of the new node are now measured against its position, so
+    // only cliques reachable from its neighbors may have changed
+    std::stack<LineNode*> reach;
+    std::set<LineNode*> seen{ref};
+    reach.push(ref);
+
+    while (!reach.empty()) {
+      LineNode* n = reach.top();
+      reach.pop();
+
+      if (queued.insert(n).second) work.push_back(n);
+
+      for (auto e : n->getAdjList()) {
+        LineNode* m = e->getOtherNd(n);
+        if (seen.count(m)) continue;
+
+        // direct neighbors are always re-checked, beyond them only along
+        // closed fronts
+        bool closed = false;
+        if (n != ref) {
+          for (auto nf : getClosedNodeFronts(n)) {
+            if (nf.edge == e) closed = true;
+          }
+        }
+
+        if (n == ref || closed) {
+          seen.insert(m);
+          reach.push(m);
+        }
+      }
+    }
   }
 }
 
 // _____________________________________________________________________________
-std::vector<NodeFront> RenderGraph::getNextMetaNodeCand() const {
-  for (auto n : getNds()) {
-    if (n->pl().stops().size()) continue;
+std::vector<NodeFront> RenderGraph::getMetaNodeCand(const LineNode* n) const {
+  if (n->pl().stops().size()) return {};
 
-    // WHY?
-    if (getOpenNodeFronts(n).size() != 1) continue;
+  // WHY?
+  if (getOpenNodeFronts(n).size() != 1) return {};
 
-    std::set<const LineNode*> potClique;
+  std::set<const LineNode*> potClique;
 
-    std::stack<const LineNode*> nodeStack;
-    nodeStack.push(n);
+  std::stack<const LineNode*> nodeStack;
+  nodeStack.push(n);
 
-    while (!nodeStack.empty()) {
-      const LineNode* n = nodeStack.top();
-      nodeStack.pop();
+  while (!nodeStack.empty()) {
+    const LineNode* n = nodeStack.top();
+    nodeStack.pop();
 
-      if (n->pl().stops().size() == 0) {
-        potClique.insert(n);
-        for (auto nff : getClosedNodeFronts(n)) {
-          const LineNode* m;
+    if (n->pl().stops().size() == 0) {
+      potClique.insert(n);
+      for (auto nff : getClosedNodeFronts(n)) {
+        const LineNode* m;
 
-          if (nff.edge->getTo() == n) {
-            m = nff.edge->getFrom();
-          } else {
-            m = nff.edge->getTo();
-          }
+        if (nff.edge->getTo() == n) {
+          m = nff.edge->getFrom();
+        } else {
+          m = nff.edge->getTo();
+        }
 
-          if (potClique.find(m) == potClique.end()) {
-            nodeStack.push(m);
-          }
+        if (potClique.find(m) == potClique.end()) {
+          nodeStack.push(m);
         }
       }
     }
+  }
 
-    if (isClique(potClique)) {
-      std::vector<NodeFront> ret;
+  if (!isClique(potClique)) return {};
 
-      for (auto n : potClique) {
-        if (getOpenNodeFronts(n).size() > 0) {
-          ret.push_back(getOpenNodeFronts(n)[0]);
-        } else {
-          for (auto nf : getClosedNodeFronts(n)) {
-            ret.push_back(nf);
-          }
-        }
-      }
+  std::vector<NodeFront> ret;
 
-      return ret;
+  for (auto n : potClique) {
+    if (getOpenNodeFronts(n).size() > 0) {
+      ret.push_back(getOpenNodeFronts(n)[0]);
+    } else {
+      for (auto nf : getClosedNodeFronts(n)) {
+        ret.push_back(nf);
+      }
     }
   }
 
-  return std::vector<NodeFront>();
+  return ret;
 }
 
 // _____________________________________________________________________________
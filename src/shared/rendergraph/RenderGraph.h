@@ -7,6 +7,8 @@
 
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "shared/linegraph/Line.h"
 #include "shared/linegraph/LineGraph.h"
@@ -26,6 +28,25 @@ struct InnerGeom {
   size_t slotFrom, slotTo;
 };
 
+// memoized inner geometries of a node, together with the node state they
+// were computed from
+struct InnerGeomCacheEntry {
+  double prec;
+  std::vector<const void*> ptrs;
+  std::vector<double> coords;
+  std::vector<InnerGeom> geoms;
+};
+
+// memoized stop geometries of a node for one set of parameters, together
+// with the node state they were computed from
+struct StopGeomCacheEntry {
+  bool tight;
+  size_t pointsPerCircle;
+  std::vector<const void*> ptrs;
+  std::vector<double> coords;
+  std::vector<util::geo::Polygon<double>> geoms;
+};
+
 class RenderGraph : public shared::linegraph::LineGraph {
  public:
   RenderGraph() : _defWidth(5), _defOutlineWidth(1), _defSpacing(5){};
@@ -41,9 +62,17 @@ class RenderGraph : public shared::linegraph::LineGraph {
 
   void writePermutation(const OrderCfg&);
 
+  // write the orderings of c in a single pass, edges not in c keep their
+  // line order
+  void writePermutation(const HierarOrderCfg& c);
+
+  // cached, the cache entry of a node is recomputed if its fronts, the
+  // geometries of its adjacent edges or the line orderings changed
   std::vector<shared::rendergraph::InnerGeom> innerGeoms(
       const shared::linegraph::LineNode* n, double prec) const;
 
+  // cached like innerGeoms(), the node fronts and the lines not served by
+  // the node are also part of the cached state
   std::vector<util::geo::Polygon<double>> getStopGeoms(
       const shared::linegraph::LineNode* n, bool simple,
       size_t pointsPerCircle) const;
@@ -83,6 +112,29 @@ class RenderGraph : public shared::linegraph::LineGraph {
  private:
   double _defWidth, _defOutlineWidth, _defSpacing;
 
+  mutable std::unordered_map<const shared::linegraph::LineNode*,
+                             InnerGeomCacheEntry>
+      _innerGeomCache;
+
+  mutable std::unordered_map<const shared::linegraph::LineNode*,
+                             std::vector<StopGeomCacheEntry>>
+      _stopGeomCache;
+
+  std::vector<util::geo::Polygon<double>> computeStopGeoms(
+      const shared::linegraph::LineNode* n, bool tight,
+      size_t pointsPerCircle) const;
+
+  static void stopGeomState(const shared::linegraph::LineNode* n,
+                            std::vector<const void*>* ptrs,
+                            std::vector<double>* coords);
+
+  std::vector<shared::rendergraph::InnerGeom> computeInnerGeoms(
+      const shared::linegraph::LineNode* n, double prec) const;
+
+  static void innerGeomState(const shared::linegraph::LineNode* n,
+                             std::vector<const void*>* ptrs,
+                             std::vector<double>* coords);
+
   shared::rendergraph::InnerGeom getInnerBezier(
       const shared::linegraph::LineNode* n,
       const shared::linegraph::Partner& partnerFrom,
@@ -113,7 +165,9 @@ class RenderGraph : public shared::linegraph::LineGraph {
 
   bool isClique(std::set<const shared::linegraph::LineNode*> potClique) const;
 
-  std::vector<shared::linegraph::NodeFront> getNextMetaNodeCand() const;
+  // the node fronts of the meta node seeded at n, empty if there is none
+  std::vector<shared::linegraph::NodeFront> getMetaNodeCand(
+      const shared::linegraph::LineNode* n) const;
 };
 }  // namespace rendergraph
 }  // namespace shared
@@ -2,12 +2,16 @@
 // Author: Patrick Brosi
 
 #include <cassert>
+#include <sstream>
 #include <string>
 #include <vector>
+#include "shared/optim/ILPModel.h"
 #include "shared/optim/ILPSolver.h"
+#include "shared/optim/RemoteSolver.h"
 #include "shared/tests/ILPSolverTest.h"
 #include "util/Misc.h"
 
+using shared::optim::ILPModel;
 using shared::optim::ILPSolver;
 using util::approx;
 
@@ -37,6 +41,84 @@ using shared::optim::COINSolver;
 
 // _____________________________________________________________________________
 void ILPSolverTest::run() {
+  {
+    ILPModel m(false);
+    int col1 = m.addCol(shared::optim::BIN, 1);
+    int col2 = m.addCol(shared::optim::INT, 0.5, 2, 7);
+    int row1 = m.addRow(4, shared::optim::UP);
+    int row2 = m.addRow(1, shared::optim::FIX);
+    m.addColToRow(row1, col1, 1);
+    m.addColToRow(row1, col2, 2);
+    m.addColToRow(row2, col2, -3);
+
+    std::stringstream ss;
+    m.write(&ss);
+
+    ILPModel n(false);
+    TEST(n.read(&ss));
+
+    TEST(n.getNumCols(), ==, 2);
+    TEST(n.getNumRows(), ==, 2);
+    TEST(n.getNumCoefs(), ==, 3);
+    TEST(n.getColType(col2), ==, shared::optim::INT);
+    TEST(n.getObjCoef(col2), ==, approx(0.5));
+    TEST(n.getLowBnd(col2), ==, approx(2));
+    TEST(n.getUpBnd(col2), ==, approx(7));
+    TEST(n.getRowType(row2), ==, shared::optim::FIX);
+    TEST(n.getRowBnd(row1), ==, approx(4));
+    TEST(n.getCoefRows()[2], ==, row2);
+    TEST(n.getCoefCols()[2], ==, col2);
+    TEST(n.getCoefVals()[2], ==, approx(-3));
+
+    // truncated input is rejected
+    std::string str = ss.str();
+    std::stringstream trunc(str.substr(0, str.size() - 1));
+    ILPModel o(false);
+    TEST(!o.read(&trunc));
+  }
+  {
+    ILPModel m;
+    int col1 = m.addCols(2, shared::optim::BIN, 0);
+    int row1 = m.addRow(1, shared::optim::UP);
+    m.addColToRow(row1, col1, 1);
+
+    // a part referencing the two columns of m
+    ILPModel part(true, m.getNumCols());
+    int dec = part.addCol(shared::optim::BIN, 3);
+    TEST(dec, ==, 2);
+    int row2 = part.addRow(0, shared::optim::LO);
+    part.addColToRow(row2, col1 + 1, 1);
+    part.addColToRow(row2, dec, -1);
+    part.setObjCoef(col1, 5);
+    part.setColNames(dec, 1, [](size_t) { return std::string("dec"); });
+
+    ILPModel part2(true, m.getNumCols());
+    int dec2 = part2.addCol(shared::optim::BIN, 4);
+    int row3 = part2.addRow(1, shared::optim::FIX);
+    part2.addColToRow(row3, dec2, 1);
+
+    m.append(part);
+    m.append(part2);
+
+    TEST(m.getNumCols(), ==, 4);
+    TEST(m.getNumRows(), ==, 3);
+    TEST(m.getNumCoefs(), ==, 4);
+    TEST(m.getObjCoef(col1), ==, approx(5));
+    TEST(m.getObjCoef(2), ==, approx(3));
+    TEST(m.getObjCoef(3), ==, approx(4));
+    TEST(m.getRowType(1), ==, shared::optim::LO);
+    TEST(m.getCoefRows()[1], ==, 1);
+    TEST(m.getCoefCols()[1], ==, col1 + 1);
+    TEST(m.getCoefCols()[2], ==, 2);
+    TEST(m.getCoefRows()[3], ==, 2);
+    TEST(m.getCoefCols()[3], ==, 3);
+
+    std::string name;
+    m.getNames().colNames([&name](int id, const std::string& n) {
+      if (id == 2) name = n;
+    });
+    TEST(name, ==, "dec");
+  }
   {
     std::vector<ILPSolver*> solvers;
 
@@ -148,4 +230,104 @@ void ILPSolverTest::run() {
       TEST(s->getObjVal(), ==, approx(3));
     }
   }
+  {
+    std::vector<ILPSolver*> solvers;
+#ifdef GUROBI_FOUND
+    try {
+      solvers.push_back(new GurobiSolver(shared::optim::MAX));
+    } catch (const std::exception& e) {
+    }
+#endif
+
+#ifdef GLPK_FOUND
+    solvers.push_back(new GLPKSolver(shared::optim::MAX));
+#endif
+
+#ifdef COIN_FOUND
+    solvers.push_back(new COINSolver(shared::optim::MAX));
+#endif
+
+    for (auto s : solvers) {
+      ILPModel m;
+      int col1 = m.addCols(2, shared::optim::BIN, 1);
+      int col2 = col1 + 1;
+      int col3 = m.addCol(shared::optim::BIN, 2);
+
+      int row1 = m.addRow(4, shared::optim::UP);
+      m.addColToRow(row1, col1, 1);
+      m.addColToRow(row1, col2, 2);
+      m.addColToRow(row1, col3, 3);
+
+      int row2 = m.addRow(1, shared::optim::LO);
+      m.addColToRow(row2, col2, 1);
+      m.addColToRow(row2, col1, 1);
+
+      TEST(m.getNumCols(), ==, 3);
+      TEST(m.getNumRows(), ==, 2);
+      TEST(m.getNumCoefs(), ==, 5);
+
+      s->loadModel(m);
+      s->update();
+
+      TEST(s->getNumVars(), ==, 3);
+      TEST(s->getNumConstrs(), ==, 2);
+
+      auto ret = s->solve();
+
+      TEST(ret, ==, shared::optim::OPTIM);
+
+      TEST(s->getVarVal(col1), ==, approx(1));
+      TEST(s->getVarVal(col2), ==, approx(0));
+      TEST(s->getVarVal(col3), ==, approx(1));
+
+      TEST(s->getObjVal(), ==, approx(3));
+    }
+  }
+  {
+    std::stringstream req("LILP garbage");
+    std::stringstream resp;
+    TEST(!shared::optim::serveRemote(&req, &resp, "gurobi"));
+    TEST(resp.str().empty());
+  }
+#if defined(GUROBI_FOUND) || defined(GLPK_FOUND) || defined(COIN_FOUND)
+  {
+    ILPModel m;
+    int col1 = m.addCols(2, shared::optim::BIN, 1);
+    int col2 = col1 + 1;
+    int row1 = m.addRow(1, shared::optim::UP);
+    m.addColToRow(row1, col1, 1);
+    m.addColToRow(row1, col2, 1);
+    m.setObjCoef(col2, 2);
+
+    std::stringstream req;
+    shared::optim::writeRemoteReq(&req, shared::optim::MAX, 10, -1, 1,
+                                  {{col1, 1}}, m);
+
+    std::stringstream resp;
+    TEST(shared::optim::serveRemote(&req, &resp, "gurobi"));
+
+    std::string magic(4, ' ');
+    resp.read(&magic[0], 4);
+    TEST(magic, ==, "LSOL");
+
+    uint32_t version;
+    uint8_t status;
+    double obj;
+    uint64_t n;
+    resp.read(reinterpret_cast<char*>(&version), sizeof(version));
+    resp.read(reinterpret_cast<char*>(&status), sizeof(status));
+    resp.read(reinterpret_cast<char*>(&obj), sizeof(obj));
+    resp.read(reinterpret_cast<char*>(&n), sizeof(n));
+    std::vector<double> vals(n);
+    resp.read(reinterpret_cast<char*>(vals.data()), n * sizeof(double));
+
+    TEST(resp.good());
+    TEST(version, ==, shared::optim::REMOTE_VERSION);
+    TEST(status, ==, shared::optim::OPTIM);
+    TEST(obj, ==, approx(2));
+    TEST(n, ==, 2);
+    TEST(vals[0], ==, approx(0));
+    TEST(vals[1], ==, approx(1));
+  }
+#endif
 }
@@ -0,0 +1,442 @@
+// Copyright 2016
+// Author: Patrick Brosi
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "3rdparty/json.hpp"
+#include "shared/cache/CompCache.h"
+#include "shared/io/CompressedStream.h"
+#include "shared/linegraph/BinGraph.h"
+#include "shared/linegraph/JsonGraph.h"
+#include "shared/linegraph/LineGraph.h"
+#include "shared/linegraph/TopoJsonGraph.h"
+#include "shared/tests/LineGraphTest.h"
+#include "util/Misc.h"
+
+using shared::linegraph::LineGraph;
+
+// _____________________________________________________________________________
+void LineGraphTest::run() {
+  {
+    // the first edge and the exception at b come before their nodes and
+    // edges, the last edge has no explicit end nodes
+    std::string json =
+        "{\"type\":\"FeatureCollection\",\"properties\":{\"a\":1},"
+        "\"features\":["
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[0,0],[100,0]]},\"properties\":{\"from\":\"a\","
+        "\"to\":\"b\",\"lines\":[{\"id\":\"1\",\"direction\":\"b\"},"
+        "{\"id\":\"2\"}]}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+        "\"coordinates\":[100,0]},\"properties\":{\"id\":\"b\","
+        "\"station_id\":\"s\",\"excluded_conn\":[{\"line\":\"2\","
+        "\"node_from\":\"a\",\"node_to\":\"c\"}]}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+        "\"coordinates\":[0,0]},\"properties\":{\"id\":\"a\"}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+        "\"coordinates\":[200,0]},\"properties\":{\"id\":\"c\"}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[100,0],[200,0]]},\"properties\":{\"from\":\"b\","
+        "\"to\":\"c\",\"lines\":[{\"id\":\"1\"},{\"id\":\"2\"}]}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[200,0],[300,0]]},\"properties\":{"
+        "\"lines\":[{\"id\":\"3\"}]}}"
+        "]}";
+
+    std::stringstream ss(json);
+    LineGraph streamed;
+    streamed.readFromJson(&ss, true);
+
+    nlohmann::json j = nlohmann::json::parse(json);
+    LineGraph dom;
+    dom.readFromGeoJson(j["features"], true);
+
+    TEST(streamed.numNds(), ==, 5);
+    TEST(streamed.numNds(), ==, dom.numNds());
+    TEST(streamed.numNds(true), ==, dom.numNds(true));
+    TEST(streamed.numEdgs(), ==, 3);
+    TEST(streamed.numEdgs(), ==, dom.numEdgs());
+    TEST(streamed.numLines(), ==, 3);
+    TEST(streamed.numConnExcs(), >, 0);
+    TEST(streamed.numConnExcs(), ==, dom.numConnExcs());
+
+    // compressed input is detected by its magic bytes
+    for (auto codec : {shared::io::CODEC_GZIP, shared::io::CODEC_ZSTD}) {
+      if (!shared::io::hasCodec(codec)) continue;
+
+      std::stringstream comp;
+      {
+        std::ostream* out = &comp;
+        shared::io::CompressedOut zOut(codec, 2, &out);
+        *out << json;
+      }
+      TEST(comp.str().size(), >, 0);
+      TEST(shared::io::codecOf(&comp), ==, codec);
+
+      std::istream* in = &comp;
+      shared::io::CompressedIn zIn(&in);
+      TEST(zIn.codec(), ==, codec);
+
+      LineGraph fromComp;
+      fromComp.readFromJson(in, true);
+      TEST(fromComp.numNds(), ==, streamed.numNds());
+      TEST(fromComp.numEdgs(), ==, streamed.numEdgs());
+      TEST(fromComp.numConnExcs(), ==, streamed.numConnExcs());
+    }
+
+    std::stringstream plain(json);
+    std::istream* in = &plain;
+    shared::io::CompressedIn zIn(&in);
+    TEST(zIn.codec(), ==, shared::io::CODEC_NONE);
+    TEST(in == &plain);
+    TEST(streamed.getGraphProps().size(), ==, 1);
+  }
+
+  {
+    // one edge crossed by two others, all crossings are split at once
+    std::string json =
+        "{\"type\":\"FeatureCollection\",\"features\":["
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[0,0],[3000,0]]},\"properties\":{\"from\":\"a\","
+        "\"to\":\"b\",\"lines\":[{\"id\":\"1\",\"direction\":\"b\"}]}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[1000,-1000],[1000,1000]]},\"properties\":{"
+        "\"lines\":[{\"id\":\"2\"}]}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[2000,-1000],[2000,1000]]},\"properties\":{"
+        "\"lines\":[{\"id\":\"3\"}]}}"
+        "]}";
+
+    std::stringstream ss(json);
+    LineGraph g;
+    g.readFromJson(&ss, true);
+
+    TEST(g.numNds(), ==, 6);
+    TEST(g.numEdgs(), ==, 3);
+
+    g.topologizeIsects();
+
+    TEST(g.numNds(), ==, 8);
+    TEST(g.numEdgs(), ==, 7);
+
+    size_t deg4 = 0;
+    for (auto nd : g.getNds()) {
+      if (nd->getDeg() == 4) deg4++;
+
+      for (auto e : nd->getAdjList()) {
+        if (e->getFrom() != nd) continue;
+        for (const auto& lo : e->pl().getLines()) {
+          // line directions are moved to the ends of the segments
+          if (lo.direction) {
+            TEST(lo.direction == e->getFrom() || lo.direction == e->getTo());
+          }
+        }
+      }
+    }
+    TEST(deg4, ==, 2);
+  }
+
+  {
+    // line lookups, below and above the size of the line index
+    std::vector<shared::linegraph::Line> lines;
+    for (size_t i = 0; i < 40; i++) {
+      lines.push_back({std::to_string(i), std::to_string(i), "ff0000"});
+    }
+
+    for (size_t num : {3, 40}) {
+      shared::linegraph::LineEdgePL pl;
+      for (size_t i = 0; i < num; i++) pl.addLine(&lines[i], 0);
+
+      // adding a line twice is a no-op
+      pl.addLine(&lines[0], 0);
+      TEST(pl.getLines().size(), ==, num);
+
+      pl.delLine(&lines[1]);
+      TEST(pl.getLines().size(), ==, num - 1);
+      TEST(!pl.hasLine(&lines[1]));
+      TEST(pl.linePos(&lines[1]), ==, size_t(-1));
+
+      for (size_t i = 0; i < num; i++) {
+        if (i == 1) continue;
+        TEST(pl.hasLine(&lines[i]));
+        TEST(pl.lineOccAtPos(pl.linePos(&lines[i])).line, ==, &lines[i]);
+        TEST(pl.lineOcc(&lines[i]).line, ==, &lines[i]);
+      }
+    }
+  }
+
+  {
+    // two edges within distance form one component, a far edge another
+    std::string json =
+        "{\"type\":\"FeatureCollection\",\"features\":["
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[0,0],[100,0]]},\"properties\":{"
+        "\"lines\":[{\"id\":\"1\"}]}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[150,0],[250,0]]},\"properties\":{"
+        "\"lines\":[{\"id\":\"2\"}]}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[5000,0],[5100,0]]},\"properties\":{"
+        "\"lines\":[{\"id\":\"3\"}]}}"
+        "]}";
+
+    std::stringstream ss(json);
+    LineGraph g;
+    g.readFromJson(&ss, true);
+
+    const auto& copied = g.distConnectedComponents(100, false);
+    TEST(copied.size(), ==, 2);
+    TEST(g.numNds(), ==, 6);
+
+    std::vector<size_t> sizes;
+    for (const auto& comp : copied) sizes.push_back(comp.numNds());
+
+    const auto& split = g.splitDistConnectedComponents(100, false);
+    TEST(split.size(), ==, 2);
+    TEST(g.numNds(), ==, 0);
+
+    for (size_t i = 0; i < split.size(); i++) {
+      TEST(split[i].numNds(), ==, sizes[i]);
+      TEST(split[i].numEdgs(), ==, copied[i].numEdgs());
+    }
+
+    TEST(split[0].numNds() + split[1].numNds(), ==, 6);
+  }
+
+  {
+    // a chain with two short inner edges, these are contracted one after
+    // the other, the long outer edges are kept
+    shared::linegraph::Line l("1", "1", "ff0000");
+    LineGraph g;
+    std::vector<shared::linegraph::LineNode*> nds;
+    for (double x : {0, 1000, 1010, 1020, 2000}) {
+      nds.push_back(g.addNd(util::geo::DPoint(x, 0)));
+    }
+    for (size_t i = 1; i < nds.size(); i++) {
+      auto e = g.addEdg(nds[i - 1], nds[i],
+                        util::geo::PolyLine<double>(*nds[i - 1]->pl().getGeom(),
+                                                    *nds[i]->pl().getGeom()));
+      e->pl().addLine(&l, 0);
+    }
+
+    g.contractEdges(50);
+
+    TEST(g.numNds(), ==, 3);
+    TEST(g.numEdgs(), ==, 2);
+    for (auto nd : g.getNds()) {
+      TEST(nd->getDeg(), <=, 2);
+      for (auto e : nd->getAdjList()) TEST(e->pl().hasLine(&l));
+    }
+  }
+
+  {
+    // the JSON writer output is read back into the same graph
+    std::string json =
+        "{\"type\":\"FeatureCollection\",\"features\":["
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+        "\"coordinates\":[7.8,48]},\"properties\":{\"id\":\"a\","
+        "\"station_id\":\"s\",\"station_label\":\"A \\\"1\\\"\","
+        "\"station_trips\":12,\"station_routes\":2}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+        "\"coordinates\":[7.81,48]},\"properties\":{\"id\":\"b\"}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+        "\"coordinates\":[7.82,48.01]},\"properties\":{\"id\":\"c\","
+        "\"excluded_conn\":[{\"line\":\"2\",\"node_from\":\"b\","
+        "\"node_to\":\"d\"}]}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+        "\"coordinates\":[7.83,48.01]},\"properties\":{\"id\":\"d\"}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[7.8,48],[7.81,48]]},\"properties\":{"
+        "\"from\":\"a\",\"to\":\"b\",\"lines\":[{\"id\":\"1\","
+        "\"direction\":\"b\"},{\"id\":\"2\"}]}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[7.81,48],[7.815,48.005],[7.82,48.01]]},"
+        "\"properties\":{\"from\":\"b\",\"to\":\"c\",\"lines\":["
+        "{\"id\":\"1\"},{\"id\":\"2\"}]}},"
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[7.82,48.01],[7.83,48.01]]},\"properties\":{"
+        "\"from\":\"c\",\"to\":\"d\",\"lines\":[{\"id\":\"2\"}]}}"
+        "]}";
+
+    std::stringstream ss(json);
+    LineGraph g;
+    g.readFromJson(&ss);
+
+    std::stringstream out;
+    shared::linegraph::JsonGraphWriter wr(&out, util::json::Dict{{"a", 1}});
+    wr.add(g);
+    wr.flush();
+
+    auto j = nlohmann::json::parse(out.str());
+    TEST(j["properties"]["a"], ==, 1);
+    TEST(j["features"].size(), ==, 7);
+
+    LineGraph back;
+    back.readFromJson(&out);
+    TEST(back.numNds(), ==, g.numNds());
+    TEST(back.numNds(true), ==, 1);
+    TEST(back.numEdgs(), ==, g.numEdgs());
+    TEST(back.numLines(), ==, g.numLines());
+    TEST(back.numConnExcs(), ==, g.numConnExcs());
+
+    for (auto nd : back.getNds()) {
+      if (nd->pl().stops().empty()) continue;
+      TEST(nd->pl().stops().front().name, ==, "A \"1\"");
+      TEST(nd->pl().stops().front().trips, ==, 12);
+      TEST(nd->pl().stops().front().routes, ==, 2);
+    }
+
+    // the same graph as quantized TopoJSON
+    std::stringstream topo;
+    shared::linegraph::TopoJsonGraphWriter tw(&topo,
+                                              util::json::Dict{{"a", 1}});
+    tw.add(back);
+    tw.flush();
+
+    auto t = nlohmann::json::parse(topo.str());
+    TEST(t["type"], ==, "Topology");
+    TEST(t["properties"]["a"], ==, 1);
+    TEST(t["objects"]["graph"]["geometries"].size(), ==, 7);
+    TEST(t["arcs"].size(), ==, 3);
+
+    LineGraph fromTopo;
+    fromTopo.readFromJson(&topo);
+    TEST(fromTopo.numNds(), ==, g.numNds());
+    TEST(fromTopo.numNds(true), ==, 1);
+    TEST(fromTopo.numEdgs(), ==, g.numEdgs());
+    TEST(fromTopo.numLines(), ==, g.numLines());
+    TEST(fromTopo.numConnExcs(), ==, g.numConnExcs());
+
+    for (auto nd : fromTopo.getNds()) {
+      for (auto e : nd->getAdjList()) {
+        TEST(util::geo::dist(e->pl().getGeom()->front(),
+                             *e->getFrom()->pl().getGeom()),
+             <, 0.1);
+      }
+    }
+
+    // the station counts also survive the binary format
+    std::stringstream bin;
+    shared::linegraph::BinGraphWriter bw(&bin);
+    bw.add(back);
+    bw.flush();
+
+    LineGraph fromBin;
+    fromBin.readFromBin(&bin);
+    TEST(fromBin.numNds(true), ==, 1);
+    for (auto nd : fromBin.getNds()) {
+      if (nd->pl().stops().empty()) continue;
+      TEST(nd->pl().stops().front().trips, ==, 12);
+      TEST(nd->pl().stops().front().routes, ==, 2);
+    }
+
+    std::string num;
+    shared::linegraph::JsonGraphWriter::writeNum(-7.25, &num);
+    TEST(num, ==, "-7.25");
+    num.clear();
+    shared::linegraph::JsonGraphWriter::writeNum(48, &num);
+    TEST(num, ==, "48");
+    num.clear();
+    shared::linegraph::JsonGraphWriter::writeNum(0.00000000004, &num);
+    TEST(num, ==, "0");
+  }
+
+  {
+    // lines are interned, graphs read from the same input share them
+    std::string json =
+        "{\"type\":\"FeatureCollection\",\"features\":["
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[0,0],[100,0]]},\"properties\":{"
+        "\"lines\":[{\"id\":\"i1\",\"color\":\"ff0000\"},"
+        "{\"id\":\"i2\",\"color\":\"00ff00\"}]}}]}";
+
+    std::stringstream a(json), b(json);
+    LineGraph ga, gb;
+    ga.readFromJson(&a, true);
+    gb.readFromJson(&b, true);
+
+    TEST(ga.getLine("i1"));
+    TEST(ga.getLine("i1"), ==, gb.getLine("i1"));
+    TEST(ga.getLine("i2"), ==, gb.getLine("i2"));
+    TEST(ga.getLine("i1") != ga.getLine("i2"));
+    TEST(ga.getLine("i1")->idx() != ga.getLine("i2")->idx());
+    TEST(ga.getLine("i2")->idx(), <, shared::linegraph::Line::numLines());
+
+    LineGraph moved(std::move(ga));
+    TEST(moved.getLine("i1"), ==, gb.getLine("i1"));
+  }
+
+  {
+    // the trips per time band of a line survive the JSON and binary formats
+    std::string json =
+        "{\"type\":\"FeatureCollection\",\"features\":["
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[0,0],[100,0]]},\"properties\":{"
+        "\"lines\":[{\"id\":\"b1\",\"bands\":{\"am\":4,\"night\":0}},"
+        "{\"id\":\"b2\"}]}}]}";
+
+    std::stringstream ss(json);
+    LineGraph g;
+    g.readFromJson(&ss, true);
+
+    TEST(g.getLine("b1")->bands().size(), ==, 2);
+    TEST(g.getLine("b1")->bands().at("am"), ==, 4);
+    TEST(g.getLine("b1")->bands().at("night"), ==, 0);
+    TEST(g.getLine("b2")->bands().empty());
+
+    std::stringstream bin;
+    shared::linegraph::BinGraphWriter bw(&bin);
+    bw.add(g);
+    bw.flush();
+
+    LineGraph fromBin;
+    fromBin.readFromBin(&bin);
+    TEST(fromBin.getLine("b1"), ==, g.getLine("b1"));
+    TEST(fromBin.getLine("b2"), ==, g.getLine("b2"));
+
+    std::stringstream out;
+    shared::linegraph::JsonGraphWriter jw(&out);
+    jw.add(g);
+    jw.flush();
+
+    LineGraph fromJson;
+    fromJson.readFromJson(&out, true);
+    TEST(fromJson.getLine("b1"), ==, g.getLine("b1"));
+  }
+
+  {
+    // the content hash of a component does not depend on the order of its
+    // nodes and edges
+    std::string e1 =
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[0,0],[100,0]]},\"properties\":{"
+        "\"lines\":[{\"id\":\"h1\"}]}}";
+    std::string e2 =
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[100,0],[100,100]]},\"properties\":{"
+        "\"lines\":[{\"id\":\"h1\"},{\"id\":\"h2\"}]}}";
+    std::string e3 =
+        "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+        "\"coordinates\":[[100,0],[100,101]]},\"properties\":{"
+        "\"lines\":[{\"id\":\"h1\"},{\"id\":\"h2\"}]}}";
+    auto coll = [](const std::string& a, const std::string& b) {
+      return "{\"type\":\"FeatureCollection\",\"features\":[" + a + "," +
+             b + "]}";
+    };
+
+    std::stringstream a(coll(e1, e2)), b(coll(e2, e1)), c(coll(e1, e3));
+    LineGraph ga, gb, gc;
+    ga.readFromJson(&a, true);
+    gb.readFromJson(&b, true);
+    gc.readFromJson(&c, true);
+
+    using shared::cache::CompCache;
+    TEST(CompCache::contentHash(ga), ==, CompCache::contentHash(gb));
+    TEST(CompCache::contentHash(ga) != CompCache::contentHash(gc));
+
+    CompCache cache("", "test", {}, 0, 0);
+    TEST(!cache.enabled());
+    TEST(cache.key(ga, "a") != cache.key(ga, "b"));
+  }
+}
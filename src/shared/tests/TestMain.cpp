@@ -2,6 +2,7 @@
 // Author: Patrick Brosi
 
 #include "shared/tests/ILPSolverTest.h"
+#include "shared/tests/LineGraphTest.h"
 
 #include "util/Misc.h"
 
@@ -10,6 +11,8 @@ int main(int argc, char** argv) {
   UNUSED(argc);
   UNUSED(argv);
   ILPSolverTest gs;
+  LineGraphTest lgt;
 
   gs.run();
+  lgt.run();
 }
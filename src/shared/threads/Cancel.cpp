@@ -0,0 +1,104 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <signal.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include "shared/threads/Cancel.h"
+
+namespace {
+enum CancelState {
+  NOT_CANCELLED = 0,
+  BY_CALL = 1,
+  BY_SIGNAL = 2,
+  BY_DEADLINE = 3
+};
+
+std::atomic<int> state(NOT_CANCELLED);
+
+// deadline in nanoseconds of the steady clock, 0 if none
+std::atomic<int64_t> deadline(0);
+
+// _____________________________________________________________________________
+int64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// _____________________________________________________________________________
+void onSignal(int) {
+  // std::atomic<int> is lock free, which makes this async-signal-safe
+  int exp = NOT_CANCELLED;
+  state.compare_exchange_strong(exp, BY_SIGNAL);
+}
+}  // namespace
+
+// _____________________________________________________________________________
+void shared::threads::handleSignals() {
+  struct sigaction sa;
+  std::memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = onSignal;
+  sigemptyset(&sa.sa_mask);
+
+  // restore the default handler after the first signal
+  sa.sa_flags = SA_RESETHAND;
+
+  sigaction(SIGTERM, &sa, 0);
+  sigaction(SIGINT, &sa, 0);
+}
+
+// _____________________________________________________________________________
+void shared::threads::setDeadline(double seconds) {
+  if (seconds <= 0) {
+    deadline = 0;
+    return;
+  }
+  deadline = now() + static_cast<int64_t>(seconds * 1000000000.0);
+}
+
+// _____________________________________________________________________________
+void shared::threads::cancel() {
+  int exp = NOT_CANCELLED;
+  state.compare_exchange_strong(exp, BY_CALL);
+}
+
+// _____________________________________________________________________________
+bool shared::threads::cancelled() {
+  if (state.load(std::memory_order_relaxed) != NOT_CANCELLED) return true;
+
+  int64_t d = deadline.load(std::memory_order_relaxed);
+  if (d && now() >= d) {
+    int exp = NOT_CANCELLED;
+    state.compare_exchange_strong(exp, BY_DEADLINE);
+    return true;
+  }
+
+  return false;
+}
+
+// _____________________________________________________________________________
+std::string shared::threads::cancelReason() {
+  cancelled();
+  switch (state.load()) {
+    case BY_CALL:
+      return "cancel";
+    case BY_SIGNAL:
+      return "signal";
+    case BY_DEADLINE:
+      return "deadline";
+    default:
+      return "";
+  }
+}
+
+// _____________________________________________________________________________
+double shared::threads::secondsLeft() {
+  if (cancelled()) return 0;
+  int64_t d = deadline.load(std::memory_order_relaxed);
+  if (!d) return -1;
+  return (d - now()) / 1000000000.0;
+}
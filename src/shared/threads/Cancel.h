@@ -0,0 +1,40 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_THREADS_CANCEL_H_
+#define SHARED_THREADS_CANCEL_H_
+
+#include <string>
+
+namespace shared {
+namespace threads {
+
+// Process-wide cooperative cancellation. A run is cancelled once SIGTERM or
+// SIGINT was received (after handleSignals()) or once the deadline given to
+// setDeadline() has passed. The optimizers poll cancelled() and stop with
+// the best solution found so far, so the tools still write valid output.
+
+// Install the handlers for SIGTERM and SIGINT. Only the first signal
+// cancels the run, a second one terminates the process as usual.
+void handleSignals();
+
+// Cancel the run the given number of seconds from now, 0 means no deadline.
+void setDeadline(double seconds);
+
+// Cancel the run now.
+void cancel();
+
+bool cancelled();
+
+// "cancel", "signal", "deadline" or "" if the run was not cancelled
+std::string cancelReason();
+
+// Seconds left until the deadline, a negative value if there is none and 0
+// if the run was cancelled.
+double secondsLeft();
+
+}  // namespace threads
+}  // namespace shared
+
+#endif  // SHARED_THREADS_CANCEL_H_
@@ -0,0 +1,16 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include "shared/threads/ThreadBudget.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// _____________________________________________________________________________
+void shared::threads::setBudget(size_t n) {
+  if (n == 0) return;
+#ifdef _OPENMP
+  omp_set_num_threads(static_cast<int>(n));
+#endif
+}
@@ -0,0 +1,23 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_THREADS_THREADBUDGET_H_
+#define SHARED_THREADS_THREADBUDGET_H_
+
+#include <cstddef>
+
+namespace shared {
+namespace threads {
+
+// Limit the OpenMP loops without an explicit thread count (graph parsing,
+// rendering, grid graph setup) to n threads. Called by the tools if a
+// thread budget was given with -t, so that several tools running in
+// parallel do not each use all cores. Loops with an explicit thread count
+// are bounded by the tool configs.
+void setBudget(size_t n);
+
+}  // namespace threads
+}  // namespace shared
+
+#endif  // SHARED_THREADS_THREADBUDGET_H_
@@ -0,0 +1,170 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <sys/resource.h>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "shared/trace/Metrics.h"
+#include "shared/trace/Progress.h"
+#include "shared/trace/Trace.h"
+#include "util/Misc.h"
+#include "util/json/Writer.h"
+#include "util/log/Log.h"
+
+using shared::trace::Metrics;
+using shared::trace::Phase;
+
+// defined by the alloccount library, if it is preloaded
+extern "C" unsigned long long loomAllocCount() __attribute__((weak));
+
+namespace {
+struct PhaseRes {
+  const char* name;
+  double wallMs, cpuMs;
+  size_t peakRss;
+  int64_t allocs;
+};
+
+std::mutex metricsMutex;
+std::vector<PhaseRes> phases;
+std::map<std::string, size_t> counts;
+std::string metricsPath;
+std::string toolName;
+int64_t runStart;
+double runCpuStart;
+
+// _____________________________________________________________________________
+void closeAtExit() { Metrics::close(); }
+
+// _____________________________________________________________________________
+void writeAllocs(util::json::Writer* wr, int64_t allocs) {
+  if (allocs < 0) {
+    wr->keyVal("allocs", util::json::Null());
+  } else {
+    wr->keyVal("allocs", static_cast<uint64_t>(allocs));
+  }
+}
+}  // namespace
+
+std::atomic<bool> Metrics::_enabled(false);
+
+// _____________________________________________________________________________
+int64_t shared::trace::allocCount() {
+  if (!loomAllocCount) return -1;
+  return loomAllocCount();
+}
+
+// _____________________________________________________________________________
+double shared::trace::cpuTimeMs() {
+  struct rusage u;
+  getrusage(RUSAGE_SELF, &u);
+  return (u.ru_utime.tv_sec + u.ru_stime.tv_sec) * 1000.0 +
+         (u.ru_utime.tv_usec + u.ru_stime.tv_usec) / 1000.0;
+}
+
+// _____________________________________________________________________________
+void Metrics::open(const std::string& path, const std::string& tool) {
+  if (path.empty()) return;
+
+  std::lock_guard<std::mutex> lock(metricsMutex);
+  if (metricsPath.empty()) std::atexit(closeAtExit);
+  metricsPath = path;
+  toolName = tool;
+  runStart = Trace::now();
+  runCpuStart = cpuTimeMs();
+  _enabled = true;
+}
+
+// _____________________________________________________________________________
+void Metrics::close() {
+  std::lock_guard<std::mutex> lock(metricsMutex);
+  if (!_enabled) return;
+  _enabled = false;
+
+  std::ofstream out(metricsPath);
+  if (!out.good()) {
+    LOG(ERROR) << "Could not write metrics to " << metricsPath;
+    return;
+  }
+
+  util::json::Writer wr(&out, 3, true);
+  wr.obj();
+  wr.keyVal("tool", toolName);
+  wr.keyVal("wall-ms", (Trace::now() - runStart) / 1000.0);
+  wr.keyVal("cpu-ms", cpuTimeMs() - runCpuStart);
+  wr.keyVal("peak-rss-bytes", static_cast<uint64_t>(util::getPeakRSS()));
+  writeAllocs(&wr, allocCount());
+
+  wr.key("counts");
+  wr.obj();
+  for (const auto& c : counts) {
+    wr.keyVal(c.first, static_cast<uint64_t>(c.second));
+  }
+  wr.close();
+
+  wr.key("phases");
+  wr.arr();
+  for (const auto& p : phases) {
+    wr.obj();
+    wr.keyVal("name", p.name);
+    wr.keyVal("wall-ms", p.wallMs);
+    wr.keyVal("cpu-ms", p.cpuMs);
+    wr.keyVal("peak-rss-bytes", static_cast<uint64_t>(p.peakRss));
+    writeAllocs(&wr, p.allocs);
+    wr.close();
+  }
+  wr.close();
+
+  wr.closeAll();
+  out << std::endl;
+
+  phases.clear();
+  counts.clear();
+}
+
+// _____________________________________________________________________________
+void Metrics::count(const std::string& key, size_t v) {
+  std::lock_guard<std::mutex> lock(metricsMutex);
+  if (!_enabled) return;
+  counts[key] = v;
+}
+
+// _____________________________________________________________________________
+void Metrics::addPhase(const char* name, double wallMs, double cpuMs,
+                       int64_t allocs) {
+  // the peak RSS is monotonic, the value after the phase is its maximum
+  size_t rss = util::getPeakRSS();
+  std::lock_guard<std::mutex> lock(metricsMutex);
+  if (!_enabled) return;
+  phases.push_back({name, wallMs, cpuMs, rss, allocs});
+}
+
+// _____________________________________________________________________________
+Phase::Phase(const char* name) : _name(name), _done(false) {
+  Progress::phase(name);
+  bool on = Metrics::enabled() || Trace::enabled();
+  _start = on ? Trace::now() : 0;
+  _cpuStart = Metrics::enabled() ? cpuTimeMs() : 0;
+  _allocStart = Metrics::enabled() ? allocCount() : -1;
+}
+
+// _____________________________________________________________________________
+void Phase::done() {
+  if (_done) return;
+  _done = true;
+
+  if (!Metrics::enabled() && !Trace::enabled()) return;
+
+  int64_t dur = Trace::now() - _start;
+
+  if (Trace::enabled()) Trace::add(_name, _start, dur);
+
+  if (Metrics::enabled()) {
+    int64_t allocs = _allocStart < 0 ? -1 : allocCount() - _allocStart;
+    Metrics::addPhase(_name, dur / 1000.0, cpuTimeMs() - _cpuStart, allocs);
+  }
+}
@@ -0,0 +1,74 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_TRACE_METRICS_H_
+#define SHARED_TRACE_METRICS_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include "shared/trace/Trace.h"
+
+namespace shared {
+namespace trace {
+
+// Resource usage of a single tool run, written as JSON to the file given to
+// open() on close() or at exit. For the whole run and for each phase, the
+// wall time, the CPU time of all threads, the peak RSS and the number of
+// allocations are recorded. Allocations are only counted if the alloccount
+// library (src/bench) is preloaded. Element counts (nodes, edges, ...) are
+// added with count().
+class Metrics {
+ public:
+  static void open(const std::string& path, const std::string& tool);
+  static void close();
+
+  static bool enabled() { return _enabled; }
+
+  // set the element count key to v
+  static void count(const std::string& key, size_t v);
+
+ private:
+  static std::atomic<bool> _enabled;
+
+  friend class Phase;
+  static void addPhase(const char* name, double wallMs, double cpuMs,
+                       int64_t allocs);
+};
+
+// A phase of a tool run, recorded in the metrics, as a trace zone and in the
+// progress stream. Ends with done() or on destruction. Phases are meant to
+// be sequential and started on the main thread.
+class Phase {
+ public:
+  explicit Phase(const char* name);
+  ~Phase() { done(); }
+
+  Phase(const Phase&) = delete;
+  Phase& operator=(const Phase&) = delete;
+
+  void done();
+
+ private:
+  const char* _name;
+  bool _done;
+  int64_t _start;
+  double _cpuStart;
+  int64_t _allocStart;
+};
+
+// number of allocations so far, -1 if the alloccount library is not loaded
+int64_t allocCount();
+
+// CPU time of the process (all threads) in milliseconds
+double cpuTimeMs();
+
+}  // namespace trace
+}  // namespace shared
+
+// record the enclosing scope as a phase under name
+#define TRACE_PHASE(name) \
+  shared::trace::Phase TRACE_ZONE_CAT(_tracePhase, __LINE__)(name)
+
+#endif  // SHARED_TRACE_METRICS_H_
@@ -0,0 +1,120 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <unistd.h>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include "shared/threads/Cancel.h"
+#include "shared/trace/Progress.h"
+#include "shared/trace/Trace.h"
+#include "util/json/Writer.h"
+
+using shared::trace::Progress;
+using shared::trace::Trace;
+
+namespace {
+std::mutex progMutex;
+int progFd = -1;
+std::string toolName;
+std::string phaseName;
+int64_t runStart;
+size_t done = 0;
+size_t total = 0;
+double score = 0;
+bool hasScore = false;
+
+// _____________________________________________________________________________
+void closeAtExit() { Progress::close(); }
+
+// _____________________________________________________________________________
+void writeLine() {
+  std::stringstream ss;
+  util::json::Writer wr(&ss, 3);
+  wr.obj();
+  wr.keyVal("tool", toolName);
+  wr.keyVal("t", (Trace::now() - runStart) / 1000000.0);
+  wr.keyVal("phase", phaseName);
+  wr.keyVal("done", static_cast<uint64_t>(done));
+  wr.keyVal("total", static_cast<uint64_t>(total));
+  if (hasScore) wr.keyVal("score", score);
+  wr.keyVal("cancelled", shared::threads::cancelled());
+  wr.closeAll();
+  ss << "\n";
+
+  // a single write, so that lines of several writers do not interleave
+  std::string line = ss.str();
+  size_t off = 0;
+  while (off < line.size()) {
+    ssize_t n = ::write(progFd, line.data() + off, line.size() - off);
+    if (n <= 0) return;
+    off += n;
+  }
+}
+}  // namespace
+
+std::atomic<bool> Progress::_enabled(false);
+
+// _____________________________________________________________________________
+void Progress::open(int fd, const std::string& tool) {
+  if (fd < 0) return;
+
+  std::lock_guard<std::mutex> lock(progMutex);
+  if (progFd < 0) std::atexit(closeAtExit);
+  progFd = fd;
+  toolName = tool;
+  phaseName = "start";
+  runStart = Trace::now();
+  done = total = 0;
+  hasScore = false;
+  _enabled = true;
+  writeLine();
+}
+
+// _____________________________________________________________________________
+void Progress::close() {
+  std::lock_guard<std::mutex> lock(progMutex);
+  if (!_enabled) return;
+  _enabled = false;
+  phaseName = "end";
+  writeLine();
+}
+
+// _____________________________________________________________________________
+void Progress::phase(const char* name) {
+  if (!_enabled) return;
+  std::lock_guard<std::mutex> lock(progMutex);
+  phaseName = name;
+  done = total = 0;
+  hasScore = false;
+  writeLine();
+}
+
+// _____________________________________________________________________________
+void Progress::comps(size_t n) {
+  if (!_enabled) return;
+  std::lock_guard<std::mutex> lock(progMutex);
+  total = n;
+  done = 0;
+  writeLine();
+}
+
+// _____________________________________________________________________________
+void Progress::compDone() {
+  if (!_enabled) return;
+  std::lock_guard<std::mutex> lock(progMutex);
+  done++;
+  writeLine();
+}
+
+// _____________________________________________________________________________
+void Progress::compDone(double s) {
+  if (!_enabled) return;
+  std::lock_guard<std::mutex> lock(progMutex);
+  done++;
+  score = hasScore ? score + s : s;
+  hasScore = true;
+  writeLine();
+}
@@ -0,0 +1,53 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_TRACE_PROGRESS_H_
+#define SHARED_TRACE_PROGRESS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace shared {
+namespace trace {
+
+// Machine-readable progress of a tool run, written as one JSON object per
+// line to the file descriptor given to open(), for example
+//
+//   {"tool":"loom","t":1.52,"phase":"optimize","done":3,"total":12,
+//    "score":41.5,"cancelled":false}
+//
+// "t" is the number of seconds since open(), "done" and "total" count the
+// components of the current phase, "score" is the summed score of the done
+// components (lower is better), only present if the phase reports scores.
+// A line with the phase "end" is written on close() or at exit. Lines are
+// shorter than PIPE_BUF, so several tools of a pipeline may share one
+// descriptor.
+//
+// Phase objects (see Metrics.h) report their start automatically.
+class Progress {
+ public:
+  static void open(int fd, const std::string& tool);
+  static void close();
+
+  static bool enabled() { return _enabled; }
+
+  // start a new phase, resets the component counts and the score
+  static void phase(const char* name);
+
+  // the number of components of the current phase
+  static void comps(size_t total);
+
+  // a component of the current phase is done, with its score if it has one
+  static void compDone();
+  static void compDone(double score);
+
+ private:
+  static std::atomic<bool> _enabled;
+};
+
+}  // namespace trace
+}  // namespace shared
+
+#endif  // SHARED_TRACE_PROGRESS_H_
@@ -0,0 +1,109 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <vector>
+#include "shared/trace/Trace.h"
+#include "util/log/Log.h"
+
+using shared::trace::Trace;
+
+namespace {
+struct Event {
+  const char* name;
+  int64_t start, dur;
+  size_t tid;
+};
+
+std::mutex evMutex;
+std::vector<Event> events;
+std::string tracePath;
+std::string procName;
+
+std::atomic<size_t> nextTid(0);
+
+// _____________________________________________________________________________
+size_t threadId() {
+  thread_local size_t tid = nextTid++;
+  return tid;
+}
+
+// _____________________________________________________________________________
+void writeStr(std::ostream* out, const std::string& s) {
+  (*out) << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\') (*out) << '\\';
+    if (static_cast<unsigned char>(c) < 0x20) continue;
+    (*out) << c;
+  }
+  (*out) << '"';
+}
+
+// _____________________________________________________________________________
+void closeAtExit() { Trace::close(); }
+}  // namespace
+
+std::atomic<bool> Trace::_enabled(false);
+
+// _____________________________________________________________________________
+void Trace::open(const std::string& path, const std::string& process) {
+  if (path.empty()) return;
+
+  std::lock_guard<std::mutex> lock(evMutex);
+  if (tracePath.empty()) std::atexit(closeAtExit);
+  tracePath = path;
+  procName = process;
+  _enabled = true;
+}
+
+// _____________________________________________________________________________
+void Trace::close() {
+  std::lock_guard<std::mutex> lock(evMutex);
+  if (!_enabled) return;
+  _enabled = false;
+
+  std::ofstream out(tracePath);
+  if (!out.good()) {
+    LOG(ERROR) << "Could not write trace to " << tracePath;
+    return;
+  }
+
+  int pid = getpid();
+
+  out << "{\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":"
+      << pid << ",\"tid\":0,\"args\":{\"name\":";
+  writeStr(&out, procName);
+  out << "}}";
+
+  for (const auto& e : events) {
+    out << ",\n{\"name\":";
+    writeStr(&out, e.name);
+    out << ",\"ph\":\"X\",\"ts\":" << e.start << ",\"dur\":" << e.dur
+        << ",\"pid\":" << pid << ",\"tid\":" << e.tid << "}";
+  }
+
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+  events.clear();
+}
+
+// _____________________________________________________________________________
+void Trace::add(const char* name, int64_t start, int64_t dur) {
+  size_t tid = threadId();
+  std::lock_guard<std::mutex> lock(evMutex);
+  if (!_enabled) return;
+  events.push_back({name, start, dur, tid});
+}
+
+// _____________________________________________________________________________
+int64_t Trace::now() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
@@ -0,0 +1,66 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_TRACE_TRACE_H_
+#define SHARED_TRACE_TRACE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+namespace shared {
+namespace trace {
+
+// Process-wide recorder of timed zones, written as Chrome trace events (JSON
+// object format, readable by chrome://tracing and Perfetto) to the file
+// given to open(). Nothing is recorded unless open() was called.
+//
+// Timestamps are microseconds since the epoch and each event carries the
+// process id, so the traces of all tools of a pipeline run can be merged by
+// concatenating their "traceEvents" arrays, see scripts/merge_traces.py.
+class Trace {
+ public:
+  // start recording, the trace is written on close() or at exit
+  static void open(const std::string& path, const std::string& process);
+  static void close();
+
+  static bool enabled() { return _enabled; }
+
+  // record a complete event, times in microseconds since the epoch
+  static void add(const char* name, int64_t start, int64_t dur);
+
+  static int64_t now();
+
+ private:
+  static std::atomic<bool> _enabled;
+};
+
+// Records an event for its own lifetime.
+class Zone {
+ public:
+  explicit Zone(const char* name)
+      : _name(name), _start(Trace::enabled() ? Trace::now() : 0) {}
+  ~Zone() {
+    if (Trace::enabled()) Trace::add(_name, _start, Trace::now() - _start);
+  }
+
+  Zone(const Zone&) = delete;
+  Zone& operator=(const Zone&) = delete;
+
+ private:
+  const char* _name;
+  int64_t _start;
+};
+
+}  // namespace trace
+}  // namespace shared
+
+#define TRACE_ZONE_CAT_(a, b) a##b
+#define TRACE_ZONE_CAT(a, b) TRACE_ZONE_CAT_(a, b)
+
+// record the enclosing scope under name
+#define TRACE_ZONE(name) \
+  shared::trace::Zone TRACE_ZONE_CAT(_traceZone, __LINE__)(name)
+
+#endif  // SHARED_TRACE_TRACE_H_
@@ -0,0 +1,666 @@
+// Copyright 2016
+// University of Freiburg - Chair of Algorithms and Datastructures
+// Author: Patrick Brosi
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "shared/cache/CompCache.h"
+#include "shared/cache/StageCache.h"
+#include "shared/io/CompressedStream.h"
+#include "shared/linegraph/BinGraph.h"
+#include "shared/linegraph/JsonGraph.h"
+#include "shared/linegraph/TopoJsonGraph.h"
+#include "shared/linegraph/LineGraph.h"
+#include "shared/threads/Cancel.h"
+#include "shared/threads/ThreadBudget.h"
+#include "shared/trace/Metrics.h"
+#include "shared/trace/Progress.h"
+#include "shared/trace/Trace.h"
+#include "topo/Topo.h"
+#include "topo/_config.h"
+#include "topo/config/ConfigReader.h"
+#include "topo/config/TopoConfig.h"
+#include "topo/extract/Extractor.h"
+#include "topo/mapconstructor/MapConstructor.h"
+#include "topo/restr/RestrInferrer.h"
+#include "topo/statinserter/StatInserter.h"
+#include "topo/tiler/Tiler.h"
+#include "util/log/Log.h"
+
+namespace {
+struct CompStats {
+  size_t iters = 0;
+  double constrT = 0;
+  double restrT = 0;
+  double restrCheckT = 0;
+  double stationT = 0;
+  size_t maxMergedEdgs = 0;
+  size_t totMergedEdgs = 0;
+  size_t totSupportGraphEdgs = 0;
+  size_t numNdsAfter = 0;
+  size_t numStationsAfter = 0;
+  size_t numEdgsAfter = 0;
+  double lenAfter = 0;
+  size_t numConExc = 0;
+};
+
+// a component, or a tile of a component, processed on its own
+struct Part {
+  size_t comp;
+  bool tiled;
+  topo::Tile tile;
+};
+
+// _____________________________________________________________________________
+size_t compSize(const shared::linegraph::LineGraph& g) {
+  size_t ret = 0;
+  for (const auto& nd : g.getNds()) ret += nd->getAdjList().size();
+  return ret / 2;
+}
+
+// _____________________________________________________________________________
+void processComp(const topo::config::TopoConfig* cfg,
+                 shared::linegraph::LineGraph* tg, CompStats* stats) {
+  TRACE_ZONE("component");
+  topo::restr::RestrInferrer ri(cfg, tg);
+  topo::MapConstructor mc(cfg, tg);
+  topo::StatInserter si(cfg, tg);
+
+  size_t statFr = mc.freeze();
+
+  si.init();
+
+  mc.averageNodePositions();
+
+  // does preserve existing turn restrictions
+  mc.removeNodeArtifacts(false);
+
+  mc.cleanUpGeoms();
+
+  // only remove the artifacts after the restriction inferrer has been
+  // initialized, as these operations do not guarantee that the restrictions
+  // are preserved!
+
+  ri.init();
+  size_t restrFr = mc.freeze();
+
+  mc.removeEdgeArtifacts();
+
+  {
+    TRACE_ZONE("collapse shared segments");
+    T_START(construction);
+    stats->iters +=
+        mc.collapseShrdSegs(10, cfg->collapseIters, cfg->segmentLength);
+    stats->iters += mc.collapseShrdSegs(cfg->maxAggrDistance,
+                                        cfg->collapseIters, cfg->segmentLength);
+    stats->constrT += T_STOP(construction);
+  }
+
+  mc.removeNodeArtifacts(false);
+
+  if (cfg->outputStats) {
+    const auto& origEdgs = mc.freezeTrack(restrFr);
+    for (const auto& nd : tg->getNds()) {
+      for (const auto& e : nd->getAdjList()) {
+        if (e->getFrom() != nd) continue;
+        size_t cur = origEdgs.at(e).size();
+        if (cur > stats->maxMergedEdgs) stats->maxMergedEdgs = cur;
+        stats->totMergedEdgs += cur;
+        stats->totSupportGraphEdgs++;
+      }
+    }
+  }
+
+  mc.reconstructIntersections();
+
+  // infer restrictions
+  {
+    TRACE_ZONE("infer restrictions");
+    T_START(restrInf);
+    if (!cfg->noInferRestrs) {
+      ri.infer(mc.freezeTrack(restrFr));
+      stats->restrCheckT += ri.getCheckTime();
+    }
+    stats->restrT += T_STOP(restrInf);
+  }
+
+  // insert stations
+  {
+    TRACE_ZONE("insert stations");
+    T_START(stationIns);
+    si.insertStations(mc.freezeTrack(statFr));
+    stats->stationT += T_STOP(stationIns);
+  }
+
+  // remove orphan lines, which may be introduced by another station
+  // placement
+  mc.removeOrphanLines();
+
+  mc.removeNodeArtifacts(true);
+
+  mc.reconstructIntersections();
+
+  // remove orphan lines again
+  mc.removeOrphanLines();
+
+  if (cfg->outputStats) {
+    for (const auto& nd : tg->getNds()) {
+      stats->numNdsAfter++;
+      if (nd->pl().stops().size()) stats->numStationsAfter++;
+      for (const auto& e : nd->getAdjList()) {
+        if (e->getFrom() != nd) continue;
+        stats->lenAfter += e->pl().getPolyline().getLength();
+        stats->numEdgsAfter++;
+      }
+    }
+  }
+
+  stats->numConExc += tg->numConnExcs();
+
+  if (cfg->smooth > 0) tg->smooth(cfg->smooth);
+}
+
+// _____________________________________________________________________________
+util::json::Dict statsProps(const CompStats& st) {
+  return util::json::Dict{
+      {"comp-stats",
+       util::json::Dict{{"iters", st.iters},
+                        {"constr_t", st.constrT},
+                        {"restr_t", st.restrT},
+                        {"restr_check_t", st.restrCheckT},
+                        {"station_t", st.stationT},
+                        {"max_merged_edgs", st.maxMergedEdgs},
+                        {"tot_merged_edgs", st.totMergedEdgs},
+                        {"tot_support_graph_edgs", st.totSupportGraphEdgs},
+                        {"num_nds_after", st.numNdsAfter},
+                        {"num_stations_after", st.numStationsAfter},
+                        {"num_edgs_after", st.numEdgsAfter},
+                        {"len_after", st.lenAfter},
+                        {"num_con_exc", st.numConExc}}}};
+}
+
+// _____________________________________________________________________________
+CompStats statsFromProps(const nlohmann::json::object_t& props) {
+  CompStats st;
+  if (!props.count("comp-stats")) return st;
+  const auto& s = props.at("comp-stats");
+  st.iters = s.value("iters", st.iters);
+  st.constrT = s.value("constr_t", st.constrT);
+  st.restrT = s.value("restr_t", st.restrT);
+  st.restrCheckT = s.value("restr_check_t", st.restrCheckT);
+  st.stationT = s.value("station_t", st.stationT);
+  st.maxMergedEdgs = s.value("max_merged_edgs", st.maxMergedEdgs);
+  st.totMergedEdgs = s.value("tot_merged_edgs", st.totMergedEdgs);
+  st.totSupportGraphEdgs =
+      s.value("tot_support_graph_edgs", st.totSupportGraphEdgs);
+  st.numNdsAfter = s.value("num_nds_after", st.numNdsAfter);
+  st.numStationsAfter = s.value("num_stations_after", st.numStationsAfter);
+  st.numEdgsAfter = s.value("num_edgs_after", st.numEdgsAfter);
+  st.lenAfter = s.value("len_after", st.lenAfter);
+  st.numConExc = s.value("num_con_exc", st.numConExc);
+  return st;
+}
+
+// _____________________________________________________________________________
+// like processComp(), but the result for an unchanged input is taken from
+// the component cache, and new results are stored in it. Returns true if
+// the result was cached
+bool processComp(const topo::config::TopoConfig* cfg,
+                 const shared::cache::CompCache& cache,
+                 shared::linegraph::LineGraph* tg, CompStats* stats) {
+  if (!cache.enabled()) {
+    processComp(cfg, tg, stats);
+    return false;
+  }
+
+  uint64_t key = cache.key(*tg, "");
+
+  shared::linegraph::LineGraph res;
+  if (cache.get(key, &res)) {
+    *stats = statsFromProps(res.getGraphProps());
+    *tg = std::move(res);
+    return true;
+  }
+
+  processComp(cfg, tg, stats);
+  cache.put(key, *tg, statsProps(*stats));
+  return false;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+int topo::run(int argc, char** argv, std::istream* inStr,
+              std::ostream* outStr) {
+  topo::config::TopoConfig cfg;
+
+  size_t iters = 0;
+  double constrT = 0;
+  double restrT = 0;
+  double restrCheckT = 0;
+  double stationT = 0;
+
+  shared::linegraph::LineGraph lg;
+  // read config
+  topo::config::ConfigReader cr;
+  cr.read(&cfg, argc, argv);
+
+  shared::threads::setBudget(cfg.threadBudget);
+  shared::threads::setDeadline(cfg.deadline);
+
+  shared::trace::Trace::open(cfg.tracePath, "topo");
+  shared::trace::Metrics::open(cfg.metricsPath, "topo");
+  shared::trace::Progress::open(cfg.progressFd, "topo");
+
+  // declared before the cache, so cached output is compressed as well
+  shared::io::CompressedIn zIn(&inStr);
+  shared::io::CompressedOut zOut(cfg.compress, cfg.threadBudget, &outStr);
+
+  shared::cache::StageCache cache(cfg.stageCacheDir,
+                                  std::string("topo ") + VERSION_FULL,
+                                  "--stage-cache-dir", argc, argv, &inStr,
+                                  &outStr);
+  if (cache.hit()) return 0;
+
+  shared::cache::CompCache compCache(
+      cfg.compCacheDir, std::string("topo ") + VERSION_FULL,
+      {"--comp-cache-dir", "--stage-cache-dir"}, argc, argv);
+
+  // read input graph
+  {
+    TRACE_PHASE("read");
+    if (shared::linegraph::isBinGraph(inStr))
+      lg.readFromBin(inStr);
+    else
+      lg.readFromJson(inStr);
+  }
+
+  shared::trace::Metrics::count("input-nodes", lg.numNds());
+  shared::trace::Metrics::count("input-edges", lg.numEdgs());
+  shared::trace::Metrics::count("input-lines", lg.numLines());
+
+  if (cfg.extract) {
+    topo::Extractor ex(&cfg, &lg);
+    const auto& lines = ex.selectLines(cfg.extractLines, cfg.extractStops);
+    ex.extract(lines);
+
+    LOGTO(DEBUG, std::cerr) << "Extracted " << lines.size() << " lines, "
+                            << lg.numNds() << " nodes, " << lg.numEdgs()
+                            << " edges";
+
+    if (cfg.outputFormat == "bin") {
+      shared::linegraph::BinGraphWriter out(outStr);
+      out.add(lg);
+      out.flush();
+    } else if (cfg.outputFormat == "topojson") {
+      shared::linegraph::TopoJsonGraphWriter out(outStr);
+      out.add(lg);
+      out.flush();
+    } else {
+      shared::linegraph::JsonGraphWriter out(outStr);
+      out.add(lg);
+      out.flush();
+    }
+
+    return 0;
+  }
+
+  if (cfg.randomColors) lg.fillMissingColors();
+
+  // snap orphan stations
+  lg.snapOrphanStations();
+
+  size_t numNdsBef = 0;
+  size_t numEdgsBef = 0;
+  double lenBef = 0, lenAfter = 0;
+  size_t totMergedEdgs = 0;
+  size_t totSupportGraphEdgs = 0;
+  size_t maxMergedEdgs = 0;
+
+  if (cfg.outputStats) {
+    if (cfg.aggregateStats) {
+      const auto& props = lg.getGraphProps();
+      if (props.count("statistics")) {
+        const auto& stats =
+            props.at("statistics").get<nlohmann::json::object_t>();
+        if (stats.count("num_nds_in"))
+          numNdsBef = stats.at("num_nds_in").get<size_t>();
+        if (stats.count("num_edgs_in"))
+          numEdgsBef = stats.at("num_edgs_in").get<size_t>();
+        if (stats.count("len_before"))
+          lenBef = stats.at("len_before").get<double>();
+        if (stats.count("iters")) iters = stats.at("iters").get<size_t>();
+        if (stats.count("time_const"))
+          constrT = stats.at("time_const").get<double>();
+        if (stats.count("time_restr_inf"))
+          restrT = stats.at("time_restr_inf").get<double>();
+        if (stats.count("time_restr_inf_checks"))
+          restrCheckT = stats.at("time_restr_inf_checks").get<double>();
+        if (stats.count("time_station_insert"))
+          stationT = stats.at("time_station_insert").get<double>();
+        if (stats.count("max_merged_edgs"))
+          maxMergedEdgs = stats.at("max_merged_edgs").get<size_t>();
+        if (stats.count("tot_merged_edgs"))
+          totMergedEdgs = stats.at("tot_merged_edgs").get<size_t>();
+        if (stats.count("tot_support_graph_edgs"))
+          totSupportGraphEdgs =
+              stats.at("tot_support_graph_edgs").get<size_t>();
+      }
+    } else {
+      numNdsBef = lg.getNds().size();
+      for (const auto& nd : lg.getNds()) {
+        for (const auto& e : nd->getAdjList()) {
+          if (e->getFrom() != nd) continue;
+          numEdgsBef++;
+          lenBef += e->pl().getPolyline().getLength();
+        }
+      }
+    }
+  }
+
+  size_t numEdgsAfter = 0;
+  size_t numNdsAfter = 0;
+  size_t numStationsAfter = 0;
+
+  size_t numConExc = 0;
+
+  lg.removeDeg1Nodes();
+
+  LOGTO(DEBUG, std::cerr) << "Computing components...";
+  auto graphs = lg.splitDistConnectedComponents(cfg.connectedCompDist, false);
+
+  LOGTO(DEBUG, std::cerr) << "Broke up input into " << graphs.size()
+                          << " components (including single-node components)";
+
+  // components larger than the tile size are cut into tiles, which are
+  // processed like components of their own and stitched afterwards
+  std::vector<std::unique_ptr<topo::Tiler>> tilers(graphs.size());
+  std::vector<Part> parts;
+  for (size_t i = 0; i < graphs.size(); i++) {
+    const auto& box = graphs[i].getBBox();
+    if (cfg.tileSize > 0 &&
+        (box.getUpperRight().getX() - box.getLowerLeft().getX() >
+             cfg.tileSize ||
+         box.getUpperRight().getY() - box.getLowerLeft().getY() >
+             cfg.tileSize)) {
+      tilers[i].reset(new topo::Tiler(&cfg, &graphs[i]));
+      for (const auto& t : tilers[i]->tiles()) parts.push_back({i, true, t});
+    } else {
+      parts.push_back({i, false, topo::Tile()});
+    }
+  }
+
+  if (parts.size() > graphs.size()) {
+    LOGTO(DEBUG, std::cerr) << "Cut large components into " << parts.size()
+                            << " parts";
+  }
+
+  std::vector<CompStats> compStats(parts.size());
+
+  shared::trace::Metrics::count("components", graphs.size());
+
+  shared::trace::Phase compPhase("components");
+  shared::trace::Progress::comps(parts.size());
+
+  // process the parts in parallel, each part is fully independent of the
+  // others. The results are accumulated in component order afterwards,
+  // which keeps the output identical to the serial run.
+  std::vector<size_t> order(parts.size());
+  std::vector<size_t> sizes(parts.size());
+  for (size_t i = 0; i < parts.size(); i++) {
+    order[i] = i;
+    if (parts[i].tiled)
+      sizes[i] = tilers[parts[i].comp]->numEdgs(parts[i].tile);
+    else
+      sizes[i] = compSize(graphs[parts[i].comp]);
+  }
+
+  // start with the biggest parts to avoid a long tail
+  std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) {
+    return sizes[a] > sizes[b];
+  });
+
+  // the processed tiles, and their nodes which lost edges to other tiles
+  std::vector<shared::linegraph::LineGraph> tileGraphs(parts.size());
+  std::vector<std::vector<shared::linegraph::LineNode*>> seams(parts.size());
+
+  std::mutex budgetMutex;
+  std::condition_variable budgetCv;
+  size_t inFlight = 0;
+
+  std::atomic<size_t> cachedParts(0);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(cfg.threads)
+  for (size_t i = 0; i < order.size(); i++) {
+    size_t partI = order[i];
+    const auto& part = parts[partI];
+    size_t cost = sizes[partI];
+
+    if (cfg.maxInFlightEdgs > 0) {
+      // wait until the part fits into the budget. A part which exceeds the
+      // budget on its own is processed once nothing else is.
+      std::unique_lock<std::mutex> lock(budgetMutex);
+      budgetCv.wait(lock, [&] {
+        return inFlight == 0 || inFlight + cost <= cfg.maxInFlightEdgs;
+      });
+      inFlight += cost;
+    }
+
+    if (part.tiled) {
+      LOGTO(DEBUG, std::cerr) << "@ Component " << part.comp << ", tile ("
+                              << part.tile.x << ", " << part.tile.y << ")";
+
+      const auto& tiler = *tilers[part.comp];
+      tiler.cut(part.tile, &tileGraphs[partI]);
+      if (processComp(&cfg, compCache, &tileGraphs[partI], &compStats[partI]))
+        cachedParts++;
+      seams[partI] = tiler.clip(part.tile, &tileGraphs[partI]);
+    } else {
+      LOGTO(DEBUG, std::cerr) << "@ Component " << part.comp;
+
+      if (processComp(&cfg, compCache, &graphs[part.comp], &compStats[partI]))
+        cachedParts++;
+    }
+
+    if (cfg.maxInFlightEdgs > 0) {
+      {
+        std::lock_guard<std::mutex> lock(budgetMutex);
+        inFlight -= cost;
+      }
+      budgetCv.notify_all();
+    }
+
+    shared::trace::Progress::compDone();
+  }
+
+  // replace each tiled component by its stitched tiles
+  for (size_t compI = 0; compI < graphs.size(); compI++) {
+    if (!tilers[compI]) continue;
+
+    std::vector<shared::linegraph::LineGraph> tgs;
+    std::vector<std::vector<shared::linegraph::LineNode*>> tseams;
+    CompStats st;
+    for (size_t i = 0; i < parts.size(); i++) {
+      if (parts[i].comp != compI) continue;
+      tgs.push_back(std::move(tileGraphs[i]));
+      tseams.push_back(std::move(seams[i]));
+
+      st.iters += compStats[i].iters;
+      st.constrT += compStats[i].constrT;
+      st.restrT += compStats[i].restrT;
+      st.restrCheckT += compStats[i].restrCheckT;
+      st.stationT += compStats[i].stationT;
+      st.maxMergedEdgs = std::max(st.maxMergedEdgs, compStats[i].maxMergedEdgs);
+      st.totMergedEdgs += compStats[i].totMergedEdgs;
+      st.totSupportGraphEdgs += compStats[i].totSupportGraphEdgs;
+      compStats[i] = CompStats();
+    }
+
+    shared::linegraph::LineGraph stitched;
+    tilers[compI]->stitch(&tgs, tseams, &stitched);
+    tilers[compI].reset();
+
+    // free the input component, the tiles only hold copies of it
+    { shared::linegraph::LineGraph old(std::move(graphs[compI])); }
+
+    // contract the nodes left at the seams
+    topo::MapConstructor(&cfg, &stitched).removeNodeArtifacts(true);
+
+    graphs[compI] = std::move(stitched);
+
+    // the output stats of the clipped tiles are recomputed on the result
+    if (cfg.outputStats) {
+      for (const auto& nd : graphs[compI].getNds()) {
+        st.numNdsAfter++;
+        if (nd->pl().stops().size()) st.numStationsAfter++;
+        for (const auto& e : nd->getAdjList()) {
+          if (e->getFrom() != nd) continue;
+          st.lenAfter += e->pl().getPolyline().getLength();
+          st.numEdgsAfter++;
+        }
+      }
+    }
+    st.numConExc = graphs[compI].numConnExcs();
+
+    for (size_t i = 0; i < parts.size(); i++) {
+      if (parts[i].comp == compI) {
+        compStats[i] = st;
+        break;
+      }
+    }
+  }
+
+  compPhase.done();
+
+  if (compCache.enabled()) {
+    LOGTO(DEBUG, std::cerr) << "Took " << cachedParts << " of " << parts.size()
+                            << " parts from the component cache";
+    shared::trace::Metrics::count("cached-parts", cachedParts);
+  }
+
+  std::vector<LineGraph*> resultGraphs;
+
+  for (size_t partI = 0; partI < parts.size(); partI++) {
+    const auto& st = compStats[partI];
+    iters += st.iters;
+    constrT += st.constrT;
+    restrT += st.restrT;
+    restrCheckT += st.restrCheckT;
+    stationT += st.stationT;
+    if (st.maxMergedEdgs > maxMergedEdgs) maxMergedEdgs = st.maxMergedEdgs;
+    totMergedEdgs += st.totMergedEdgs;
+    totSupportGraphEdgs += st.totSupportGraphEdgs;
+    numNdsAfter += st.numNdsAfter;
+    numStationsAfter += st.numStationsAfter;
+    numEdgsAfter += st.numEdgsAfter;
+    lenAfter += st.lenAfter;
+    numConExc += st.numConExc;
+  }
+
+  for (size_t compI = 0; compI < graphs.size(); compI++) {
+    resultGraphs.push_back(&graphs[compI]);
+  }
+
+  if (shared::trace::Metrics::enabled()) {
+    size_t nds = 0, edgs = 0;
+    for (const auto& g : graphs) {
+      nds += g.numNds();
+      edgs += g.numEdgs();
+    }
+    shared::trace::Metrics::count("output-nodes", nds);
+    shared::trace::Metrics::count("output-edges", edgs);
+  }
+
+  int numComps = 0;
+
+  size_t offset = 0;
+
+  for (auto& tg : resultGraphs) {
+    if (tg->getNds().size() == 0) continue;
+    if (cfg.writeComponents || !cfg.componentsPath.empty()) {
+      size_t locOffset = offset;
+      const auto& graphs = tg->distConnectedComponents(
+          cfg.connectedCompDist, cfg.writeComponents, &offset);
+
+      numComps += graphs.size();
+
+      for (size_t comp = 0; comp < graphs.size(); comp++) {
+        std::ofstream f;
+        if (cfg.outputFormat == "bin") {
+          f.open(cfg.componentsPath + "/component-" +
+                     std::to_string(locOffset + comp) + ".bin",
+                 std::ios::binary);
+          shared::linegraph::BinGraphWriter bout(&f);
+          bout.add(graphs[comp]);
+          bout.flush();
+        } else if (cfg.outputFormat == "topojson") {
+          f.open(cfg.componentsPath + "/component-" +
+                 std::to_string(locOffset + comp) + ".topojson");
+          shared::linegraph::TopoJsonGraphWriter tout(&f);
+          tout.add(graphs[comp]);
+          tout.flush();
+        } else {
+          f.open(cfg.componentsPath + "/component-" +
+                 std::to_string(locOffset + comp) + ".json");
+          shared::linegraph::JsonGraphWriter jout(&f);
+          jout.add(graphs[comp]);
+          jout.flush();
+        }
+      }
+    }
+  }
+
+  // output
+  TRACE_PHASE("write");
+  util::json::Dict jsonStats;
+  if (cfg.outputStats) {
+    jsonStats = {
+        {"statistics",
+         util::json::Dict{
+             {"num_edgs_in", numEdgsBef},
+             {"num_nds_in", numNdsBef},
+             {"num_edgs_out", numEdgsAfter},
+             {"num_nds_out", numNdsAfter},
+             {"num_stations_out", numStationsAfter},
+             {"num_components", numComps},
+             {"time_const", constrT},
+             {"iters", iters},
+             {"time_const", constrT},
+             {"time_restr_inf", restrT},
+             {"time_restr_inf_checks", restrCheckT},
+             {"time_station_insert", stationT},
+             {"len_before", lenBef},
+             {"num_restrs", numConExc},
+             {"avg_merged_edgs", (static_cast<double>(totMergedEdgs) /
+                                  static_cast<double>(totSupportGraphEdgs))},
+             {"max_merged_edgs", maxMergedEdgs},
+             {"len_after", lenAfter},
+             {"tot_merged_edgs", totMergedEdgs},
+             {"tot_support_graph_edgs", totSupportGraphEdgs},
+         }}};
+  }
+
+  if (cfg.outputFormat == "bin") {
+    shared::linegraph::BinGraphWriter out(outStr, jsonStats);
+    for (auto gg : resultGraphs) out.add(*gg);
+    out.flush();
+  } else if (cfg.outputFormat == "topojson") {
+    shared::linegraph::TopoJsonGraphWriter out(outStr, jsonStats);
+    for (auto gg : resultGraphs) out.add(*gg);
+    out.flush();
+  } else {
+    shared::linegraph::JsonGraphWriter out(outStr, jsonStats);
+    for (auto gg : resultGraphs) out.add(*gg);
+    out.flush();
+  }
+
+  return (0);
+}
@@ -0,0 +1,18 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TOPO_TOPO_H_
+#define TOPO_TOPO_H_
+
+#include <iostream>
+
+namespace topo {
+
+// Run topo with the given command line arguments. The input line graph is
+// read from inStr, the result is written to outStr.
+int run(int argc, char** argv, std::istream* inStr, std::ostream* outStr);
+
+}  // namespace topo
+
+#endif  // TOPO_TOPO_H_
@@ -5,12 +5,15 @@
 #include <float.h>
 #include <getopt.h>
 
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <string>
 
+#include "shared/io/CompressedStream.h"
 #include "topo/_config.h"
 #include "topo/config/ConfigReader.h"
+#include "util/String.h"
 #include "util/log/Log.h"
 
 using topo::config::ConfigReader;
@@ -52,6 +55,8 @@ void ConfigReader::help(const char* bin) const {
             << "max distance between nodes in component, in meters\n"
             << std::setw(40) << "  --sample-dist arg (=5)"
             << "sample length for map construction, in pseudometers\n"
+            << std::setw(40) << "  --collapse-iters arg (=50)"
+            << "max iterations of each shared segment collapse pass\n"
             << std::setw(40) << "  --max-length-dev arg (=500)"
             << "maximum distance deviation for turn restrictions infer\n"
             << std::setw(40) << "  --turn-restr-full-turn-angle arg (=0)"
@@ -67,7 +72,66 @@ void ConfigReader::help(const char* bin) const {
             << std::setw(40) << "  --smooth (=0)"
             << "smooth output graph edge geometries\n"
             << std::setw(40) << "  --aggr-stats"
-            << "aggregate stats with existing from input\n";
+            << "aggregate stats with existing from input\n"
+            << std::setw(40) << "  --format arg (=json)"
+            << "output format, either json, topojson or bin\n"
+            << std::setw(40) << "  --compress arg (=none)"
+            << "compress the output, either none, gzip or zstd\n"
+            << std::setw(40) << "  --stage-cache-dir arg"
+            << "reuse the output of identical runs from this dir\n"
+            << std::setw(40) << "  --comp-cache-dir arg"
+            << "reuse the results of unchanged components from\n"
+            << std::setw(40) << " "
+            << " this dir\n"
+            << std::setw(40) << "  --trace arg"
+            << "write a Chrome trace of the run to this file\n"
+            << std::setw(40) << "  --metrics-out arg"
+            << "write per-phase resource usage to this JSON file\n"
+            << std::setw(40) << "  --progress-fd arg"
+            << "write progress as JSON lines to this file\n"
+            << std::setw(40) << " "
+            << " descriptor\n"
+            << std::setw(40) << "  --deadline arg (=0)"
+            << "stop collapsing shared segments after this\n"
+            << std::setw(40) << " "
+            << " many seconds, 0 for none\n"
+            << std::setw(40) << "  -t [ --threads ] arg (=1)"
+            << "number of components processed in parallel,\n"
+            << std::setw(40) << " "
+            << "  also caps all other threads\n"
+            << std::setw(40) << "  --max-in-flight-edges arg (=0)"
+            << "max total edges of components processed at the\n"
+            << std::setw(40) << " "
+            << "  same time, caps memory usage (0 = no limit)\n"
+            << std::setw(40) << "  --tile-size arg (=0)"
+            << "process components larger than this in overlapping\n"
+            << std::setw(40) << " "
+            << "  square tiles of this size (0 = no tiling)\n"
+            << std::setw(40) << "  --tile-overlap arg (=500)"
+            << "width of the band around each tile which is\n"
+            << std::setw(40) << " "
+            << "  processed with it, but not kept\n"
+            << std::setw(40) << "  --incr-collapse"
+            << "only re-collapse changed parts of the graph in\n"
+            << std::setw(40) << " "
+            << "  later segment collapse iterations\n"
+            << std::setw(40) << "  --sparse-collapse"
+            << "only densify edge parts near other edges for\n"
+            << std::setw(40) << " "
+            << "  segment collapsing, found with a segment index\n"
+            << std::setw(40) << "  --snap-index arg (=rtree)"
+            << "node index for segment collapsing, rtree or grid\n"
+            << std::setw(40) << "  --par-stat-ins"
+            << "search station insertion candidates in parallel\n\n"
+            << "Extraction:\n"
+            << std::setw(40) << "  --extract"
+            << "cut the subgraph of some lines out of an already\n"
+            << std::setw(40) << " "
+            << "  topologized input graph, no map construction\n"
+            << std::setw(40) << "  --extract-lines arg"
+            << "only lines with these comma sep. IDs or labels\n"
+            << std::setw(40) << "  --extract-stops arg"
+            << "only lines served at these comma sep. stop IDs\n";
 }
 
 // _____________________________________________________________________________
@@ -91,12 +155,32 @@ void ConfigReader::read(TopoConfig* cfg, int argc, char** argv) const {
       {"smooth", required_argument, 0, 11},
       {"turn-restr-full-turn-angle", required_argument, 0, 12},
       {"aggr-stats", no_argument, 0, 13},
+      {"format", required_argument, 0, 14},
+      {"threads", required_argument, 0, 't'},
+      {"max-in-flight-edges", required_argument, 0, 15},
+      {"incr-collapse", no_argument, 0, 16},
+      {"snap-index", required_argument, 0, 17},
+      {"par-stat-ins", no_argument, 0, 18},
+      {"extract", no_argument, 0, 19},
+      {"extract-lines", required_argument, 0, 20},
+      {"extract-stops", required_argument, 0, 21},
+      {"stage-cache-dir", required_argument, 0, 22},
+      {"trace", required_argument, 0, 23},
+      {"metrics-out", required_argument, 0, 24},
+      {"sparse-collapse", no_argument, 0, 25},
+      {"tile-size", required_argument, 0, 26},
+      {"tile-overlap", required_argument, 0, 27},
+      {"progress-fd", required_argument, 0, 28},
+      {"deadline", required_argument, 0, 29},
+      {"compress", required_argument, 0, 30},
+      {"collapse-iters", required_argument, 0, 31},
+      {"comp-cache-dir", required_argument, 0, 32},
       {0, 0, 0, 0}};
 
   double turnRestrDiff = -1;
 
   int c;
-  while ((c = getopt_long(argc, argv, ":hvd:", ops, 0)) != -1) {
+  while ((c = getopt_long(argc, argv, ":hvd:t:", ops, 0)) != -1) {
     switch (c) {
       case 'h':
         help(argv[0]);
@@ -146,6 +230,75 @@ void ConfigReader::read(TopoConfig* cfg, int argc, char** argv) const {
       case 13:
         cfg->aggregateStats = true;
         break;
+      case 14:
+        cfg->outputFormat = optarg;
+        break;
+      case 't':
+        cfg->threads = atoi(optarg);
+        cfg->threadBudget = cfg->threads;
+        break;
+      case 15:
+        cfg->maxInFlightEdgs = atol(optarg);
+        break;
+      case 16:
+        cfg->incrCollapse = true;
+        break;
+      case 17:
+        cfg->snapIndex = optarg;
+        break;
+      case 18:
+        cfg->parStatIns = true;
+        break;
+      case 19:
+        cfg->extract = true;
+        break;
+      case 20:
+        for (const auto& id : util::split(optarg, ',')) {
+          cfg->extractLines.insert(id);
+        }
+        break;
+      case 21:
+        for (const auto& id : util::split(optarg, ',')) {
+          cfg->extractStops.insert(id);
+        }
+        break;
+      case 22:
+        cfg->stageCacheDir = optarg;
+        break;
+      case 23:
+        cfg->tracePath = optarg;
+        break;
+      case 24:
+        cfg->metricsPath = optarg;
+        break;
+      case 25:
+        cfg->sparseCollapse = true;
+        break;
+      case 26:
+        cfg->tileSize = atof(optarg);
+        break;
+      case 27:
+        cfg->tileOverlap = atof(optarg);
+        break;
+      case 28:
+        cfg->progressFd = atoi(optarg);
+        break;
+      case 29:
+        cfg->deadline = atof(optarg);
+        break;
+      case 30:
+        if (!shared::io::parseCodec(optarg, &cfg->compress)) {
+          std::cerr << "Unknown compression " << optarg
+                    << ", must be one of {none, gzip, zstd}" << std::endl;
+          exit(1);
+        }
+        break;
+      case 31:
+        cfg->collapseIters = std::max(1, atoi(optarg));
+        break;
+      case 32:
+        cfg->compCacheDir = optarg;
+        break;
       case ':':
         std::cerr << argv[optind - 1];
         std::cerr << " requires an argument" << std::endl;
@@ -162,6 +315,35 @@ void ConfigReader::read(TopoConfig* cfg, int argc, char** argv) const {
     }
   }
 
+  if (cfg->outputFormat != "json" && cfg->outputFormat != "topojson" &&
+      cfg->outputFormat != "bin") {
+    std::cerr << "Unknown output format " << cfg->outputFormat << std::endl;
+    exit(1);
+  }
+
+  if (!shared::io::hasCodec(cfg->compress)) {
+    std::cerr << shared::io::codecName(cfg->compress)
+              << " compression was not compiled in" << std::endl;
+    exit(1);
+  }
+
+  if (cfg->snapIndex != "rtree" && cfg->snapIndex != "grid") {
+    std::cerr << "Unknown snap index " << cfg->snapIndex << std::endl;
+    exit(1);
+  }
+
+  if (cfg->threads < 1) {
+    std::cerr << "Number of threads must be at least 1" << std::endl;
+    exit(1);
+  }
+
+  if (!cfg->extract &&
+      (cfg->extractLines.size() || cfg->extractStops.size())) {
+    std::cerr << "--extract-lines and --extract-stops require --extract"
+              << std::endl;
+    exit(1);
+  }
+
   if (turnRestrDiff >= 0)
     cfg->maxTurnRestrCheckDist = turnRestrDiff;
   else
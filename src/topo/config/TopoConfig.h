@@ -5,8 +5,12 @@
 #ifndef TOPO_CONFIG_TOPOCONFIG_H_
 #define TOPO_CONFIG_TOPOCONFIG_H_
 
+#include <cstddef>
+#include <set>
 #include <string>
 
+#include "shared/io/CompressedStream.h"
+
 namespace topo {
 namespace config {
 
@@ -17,6 +21,9 @@ struct TopoConfig {
   double turnInferFullTurnPen = 0;
   double fullTurnAngle = 0;
   double segmentLength = 5;
+
+  // max iterations of each shared segment collapsing pass
+  size_t collapseIters = 50;
   bool outputStats = false;
   bool noInferRestrs = false;
   bool writeComponents = false;
@@ -25,6 +32,47 @@ struct TopoConfig {
   double connectedCompDist = 10000;
   double smooth = 0;
   std::string componentsPath = "";
+  std::string outputFormat = "json";
+  // compression of the output, the input is decompressed if needed
+  shared::io::Codec compress = shared::io::CODEC_NONE;
+  size_t threads = 1;
+
+  // thread budget of the whole run if given with -t, 0 otherwise
+  size_t threadBudget = 0;
+  size_t maxInFlightEdgs = 0;
+
+  // side length of the tiles large components are cut into, 0 if disabled
+  double tileSize = 0;
+  double tileOverlap = 500;
+
+  bool incrCollapse = false;
+  bool sparseCollapse = false;
+  std::string snapIndex = "rtree";
+  bool parStatIns = false;
+
+  // directory of the stage output cache, empty if disabled
+  std::string stageCacheDir = "";
+
+  // directory of the per-component result cache, empty if disabled
+  std::string compCacheDir = "";
+
+  // write a Chrome trace of the run to this file, empty if disabled
+  std::string tracePath = "";
+
+  // write per-phase resource usage as JSON to this file, empty if disabled
+  std::string metricsPath = "";
+
+  // write the progress as JSON lines to this file descriptor, -1 if disabled
+  int progressFd = -1;
+
+  // seconds from the start after which the collapsing of shared segments is
+  // cut short, 0 for none
+  double deadline = 0;
+
+  // extract the subgraph of these lines from an already topologized graph
+  bool extract = false;
+  std::set<std::string> extractLines;
+  std::set<std::string> extractStops;
 };
 
 }  // namespace config
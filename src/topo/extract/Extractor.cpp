@@ -0,0 +1,62 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <set>
+#include <string>
+
+#include "topo/extract/Extractor.h"
+#include "topo/mapconstructor/MapConstructor.h"
+
+using shared::linegraph::LineGraph;
+using topo::Extractor;
+using topo::config::TopoConfig;
+
+// _____________________________________________________________________________
+Extractor::Extractor(const TopoConfig* cfg, LineGraph* g) : _cfg(cfg), _g(g) {}
+
+// _____________________________________________________________________________
+std::set<const shared::linegraph::Line*> Extractor::selectLines(
+    const std::set<std::string>& lines,
+    const std::set<std::string>& stops) const {
+  std::set<const shared::linegraph::Line*> atStops;
+  for (auto nd : _g->getNds()) {
+    bool wanted = false;
+    for (const auto& st : nd->pl().stops()) {
+      if (stops.count(st.id)) wanted = true;
+    }
+    if (!wanted) continue;
+
+    for (auto e : nd->getAdjList()) {
+      for (const auto& lo : e->pl().getLines()) {
+        if (nd->pl().lineServed(lo.line)) atStops.insert(lo.line);
+      }
+    }
+  }
+
+  std::set<const shared::linegraph::Line*> ret;
+  for (auto nd : _g->getNds()) {
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      for (const auto& lo : e->pl().getLines()) {
+        if (lines.size() && !lines.count(lo.line->id()) &&
+            !lines.count(lo.line->label())) {
+          continue;
+        }
+        if (stops.size() && !atStops.count(lo.line)) continue;
+        ret.insert(lo.line);
+      }
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void Extractor::extract(const std::set<const shared::linegraph::Line*>& lines) {
+  _g->keepLines(lines);
+
+  // contract the nodes only needed by dropped lines
+  MapConstructor mc(_cfg, _g);
+  mc.removeNodeArtifacts(true);
+}
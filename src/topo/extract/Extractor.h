@@ -0,0 +1,41 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TOPO_EXTRACT_EXTRACTOR_H_
+#define TOPO_EXTRACT_EXTRACTOR_H_
+
+#include <set>
+#include <string>
+
+#include "shared/linegraph/Line.h"
+#include "shared/linegraph/LineGraph.h"
+#include "topo/config/TopoConfig.h"
+
+namespace topo {
+
+// Cuts the subgraph induced by a set of lines out of an already
+// topologized line graph, without re-running the map construction. All
+// other lines are dropped, edges left without lines and unconnected nodes
+// are removed, and non-station nodes of degree 2 are contracted. The shared
+// segments of the remaining lines are kept as they are.
+class Extractor {
+ public:
+  Extractor(const config::TopoConfig* cfg, shared::linegraph::LineGraph* g);
+
+  // lines whose ID or label is in lines and which are served at one of the
+  // stops, an empty set matches every line
+  std::set<const shared::linegraph::Line*> selectLines(
+      const std::set<std::string>& lines,
+      const std::set<std::string>& stops) const;
+
+  void extract(const std::set<const shared::linegraph::Line*>& lines);
+
+ private:
+  const config::TopoConfig* _cfg;
+  shared::linegraph::LineGraph* _g;
+};
+
+}  // namespace topo
+
+#endif  // TOPO_EXTRACT_EXTRACTOR_H_
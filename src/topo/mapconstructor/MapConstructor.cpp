@@ -2,17 +2,24 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
 #include <cassert>
 #include <climits>
+#include <deque>
+#include <iterator>
+#include <unordered_set>
 
 #include "shared/linegraph/LineGraph.h"
+#include "shared/threads/Cancel.h"
 #include "topo/mapconstructor/MapConstructor.h"
+#include "topo/mapconstructor/PolyKernels.h"
 #include "util/geo/Geo.h"
 #include "util/geo/Grid.h"
 #include "util/geo/output/GeoGraphJsonOutput.h"
 #include "util/log/Log.h"
 
 using topo::MapConstructor;
+using topo::NodeGeoIdx;
 using topo::ShrdSegWrap;
 using topo::config::TopoConfig;
 
@@ -36,6 +43,29 @@ using shared::linegraph::Station;
 
 const static double MAX_COLLAPSED_SEG_LENGTH = 500;
 
+namespace {
+// FIFO of nodes to check, every node is queued at most once
+class NodeQueue {
+ public:
+  void push(LineNode* n) {
+    if (_queued.insert(n).second) _q.push_back(n);
+  }
+
+  LineNode* pop() {
+    LineNode* n = _q.front();
+    _q.pop_front();
+    _queued.erase(n);
+    return n;
+  }
+
+  bool empty() const { return _q.empty(); }
+
+ private:
+  std::deque<LineNode*> _q;
+  std::unordered_set<LineNode*> _queued;
+};
+}  // namespace
+
 // _____________________________________________________________________________
 MapConstructor::MapConstructor(const TopoConfig* cfg, LineGraph* g)
     : _cfg(cfg), _g(g) {}
@@ -83,24 +113,31 @@ LineNode* MapConstructor::ndCollapseCand(
 
   geoIdx.get(point, dCut, &neighbors);
 
+  // all distances are compared squared, the cheap checks come first
+  auto dist2 = [&point](const LineNode* nd) {
+    double dx = nd->pl().getGeom()->getX() - point.getX();
+    double dy = nd->pl().getGeom()->getY() - point.getY();
+    return dx * dx + dy * dy;
+  };
+
   double dBest = std::numeric_limits<double>::infinity();
 
   double dSpanA = std::numeric_limits<double>::infinity();
   double dSpanB = std::numeric_limits<double>::infinity();
 
-  if (spanA)
-    dSpanA = util::geo::dist(point, *spanA->pl().getGeom()) / sqrt(2.0);
-  if (spanB)
-    dSpanB = util::geo::dist(point, *spanB->pl().getGeom()) / sqrt(2.0);
+  // (dist / sqrt(2))^2
+  if (spanA) dSpanA = dist2(spanA) / 2.0;
+  if (spanB) dSpanB = dist2(spanB) / 2.0;
 
   for (auto* ndTest : neighbors) {
     if (ndTest->getDeg() == 0) continue;
-    double d = util::geo::dist(point, *ndTest->pl().getGeom());
+    double d = dist2(ndTest);
+
+    if (!(d < dSpanA && d < dSpanB && d < dBest)) continue;
 
     double dMax = maxD(numLines, ndTest, dCut);
 
-    if (d < dSpanA && d < dSpanB && d < dMax && d < dBest &&
-        notFrom.count(ndTest) == 0) {
+    if (d < dMax * dMax && notFrom.count(ndTest) == 0) {
       dBest = d;
       ndMin = ndTest;
     }
@@ -197,16 +234,27 @@ int MapConstructor::collapseShrdSegs(double dCut) {
 // _____________________________________________________________________________
 int MapConstructor::collapseShrdSegs(double dCut, size_t MAX_ITERS,
                                      double SEGL) {
+  // in incremental mode, edges which did not change in the last iteration
+  // and have no changed edge nearby are carried over as they are
+  std::set<const LineEdge*> stable;
+
   size_t ITER = 0;
   for (; ITER < MAX_ITERS; ITER++) {
+    // every iteration yields a valid graph, a cancelled run stops after the
+    // first one
+    if (ITER > 0 && shared::threads::cancelled()) break;
+
     shared::linegraph::LineGraph tgNew;
 
     // new grid per iteration
-    NodeGeoIdx geoIdx;
+    NodeGeoIdx geoIdx = nodeGeoIdx(dCut);
 
     std::unordered_map<LineNode*, LineNode*> imgNds;
     std::set<LineNode*> imgNdsSet;
 
+    // edges in tgNew carried over from _g
+    std::set<const LineEdge*> carried;
+
     std::vector<std::pair<double, LineEdge*>> sortedEdges;
     for (auto n : _g->getNds()) {
       for (auto e : n->getAdjList()) {
@@ -217,9 +265,75 @@ int MapConstructor::collapseShrdSegs(double dCut, size_t MAX_ITERS,
 
     std::sort(sortedEdges.rbegin(), sortedEdges.rend());
 
+    // the geometry of an edge from its from node to its to node, simplified
+    auto simplGeom = [](const LineEdge* e) {
+      util::geo::DLine pl;
+      pl.reserve(e->pl().getGeom()->size() + 2);
+
+      pl.push_back(*e->getFrom()->pl().getGeom());
+      pl.insert(pl.end(), e->pl().getGeom()->begin(),
+                e->pl().getGeom()->end());
+      pl.push_back(*e->getTo()->pl().getGeom());
+      return simplifyLine(pl, 0.5);
+    };
+
+    // for sparse collapsing, all edge segments are indexed. Only segments
+    // near another segment are densified, the others cannot share a
+    // segment with anything
+    std::unordered_map<const LineEdge*, util::geo::DLine> simpl;
+    std::vector<std::pair<const LineEdge*, size_t>> segs;
+    util::geo::RTree<size_t, util::geo::Line, double> segIdx;
+
+    if (_cfg->sparseCollapse) {
+      for (const auto& ep : sortedEdges) {
+        const auto& l = simpl[ep.second] = simplGeom(ep.second);
+        for (size_t i = 0; i + 1 < l.size(); i++) {
+          segIdx.add(util::geo::DLine{l[i], l[i + 1]}, segs.size());
+          segs.push_back({ep.second, i});
+        }
+      }
+    }
+
+    auto densifyNear = [&](const LineEdge* e, const util::geo::DLine& l) {
+      if (l.size() < 2) return l;
+
+      util::geo::DLine ret{l.front()};
+      std::vector<size_t> near;
+
+      for (size_t i = 0; i + 1 < l.size(); i++) {
+        near.clear();
+        segIdx.get(util::geo::DLine{l[i], l[i + 1]}, dCut, &near);
+
+        // adjacent segments of the edge itself do not count
+        bool dense = false;
+        for (auto s : near) {
+          if (segs[s].first != e || segs[s].second + 1 < i ||
+              segs[s].second > i + 1) {
+            dense = true;
+            break;
+          }
+        }
+
+        if (dense) {
+          const auto& part = densifyLine({l[i], l[i + 1]}, SEGL);
+          ret.insert(ret.end(), part.begin() + 1, part.end());
+        } else {
+          ret.push_back(l[i + 1]);
+        }
+      }
+
+      return ret;
+    };
+
     for (const auto& ep : sortedEdges) {
       auto e = ep.second;
 
+      if (stable.count(e)) {
+        auto newE = carryEdg(e, &imgNds, &imgNdsSet, &geoIdx, &tgNew);
+        if (newE) carried.insert(newE);
+        continue;
+      }
+
       LineNode* last = 0;
 
       std::set<LineNode*> myNds;
@@ -232,15 +346,9 @@ int MapConstructor::collapseShrdSegs(double dCut, size_t MAX_ITERS,
       bool imgFromCovered = false;
       bool imgToCovered = false;
 
-      util::geo::DLine pl;
-      pl.reserve(e->pl().getGeom()->size() + 2);
-
-      pl.push_back(*e->getFrom()->pl().getGeom());
-      pl.insert(pl.end(), e->pl().getGeom()->begin(), e->pl().getGeom()->end());
-      pl.push_back(*e->getTo()->pl().getGeom());
-
-      const auto& plDense =
-          util::geo::densify(util::geo::simplify(pl, 0.5), SEGL);
+      const auto& plDense = _cfg->sparseCollapse
+                                ? densifyNear(e, simpl[e])
+                                : densifyLine(simplGeom(e), SEGL);
 
       for (const auto& point : plDense) {
         if (i == plDense.size() - 1) back = 0;
@@ -368,6 +476,8 @@ int MapConstructor::collapseShrdSegs(double dCut, size_t MAX_ITERS,
     for (auto from : ndsA) {
       for (auto e : from->getAdjList()) {
         if (e->getFrom() != from) continue;
+        // carried edges are not part of a dense chain
+        if (carried.count(e)) continue;
         auto to = e->getTo();
         if ((from->getDeg() == 2 || to->getDeg() == 2)) continue;
         if (combineNodes(from, to, &tgNew)) break;
@@ -379,6 +489,15 @@ int MapConstructor::collapseShrdSegs(double dCut, size_t MAX_ITERS,
       for (auto e : n->getAdjList()) {
         if (e->getFrom() != n) continue;
 
+        if (carried.count(e) && e->pl().getGeom()->size() > 1) {
+          // keep the geometry of carried edges, only follow their nodes
+          auto geom = *e->pl().getGeom();
+          geom.front() = *e->getFrom()->pl().getGeom();
+          geom.back() = *e->getTo()->pl().getGeom();
+          e->pl().setGeom(geom);
+          continue;
+        }
+
         e->pl().setGeom(
             {*e->getFrom()->pl().getGeom(), *e->getTo()->pl().getGeom()});
       }
@@ -503,10 +622,12 @@ int MapConstructor::collapseShrdSegs(double dCut, size_t MAX_ITERS,
     for (auto n : tgNew.getNds()) {
       for (auto e : n->getAdjList()) {
         if (e->getFrom() != n) continue;
+        // carried edges have already been smoothed
+        if (carried.count(e)) continue;
         auto& pl = e->pl().getPolyline();
         pl.smoothenOutliers(50);
         pl.simplify(1);
-        pl = PolyLine<double>(util::geo::densify(pl.getLine(), 5));
+        pl = PolyLine<double>(densifyLine(pl.getLine(), 5));
         pl.applyChaikinSmooth(1);
         pl.simplify(1);
       }
@@ -531,19 +652,150 @@ int MapConstructor::collapseShrdSegs(double dCut, size_t MAX_ITERS,
       }
     }
 
+    double LEN_CHANGED = LEN_NEW;
+    if (_cfg->incrCollapse) {
+      LEN_CHANGED = stableEdgs(*_g, tgNew, dCut, SEGL / 2, &stable);
+    }
+
     *_g = std::move(tgNew);
 
     LOGTO(DEBUG, std::cerr)
-        << "iter " << ITER << ", distance gap: " << (1 - LEN_NEW / LEN_OLD);
+        << "iter " << ITER << ", distance gap: " << (1 - LEN_NEW / LEN_OLD)
+        << ", changed: " << (LEN_CHANGED / LEN_NEW) << ", carried "
+        << carried.size() << " edges";
     if (fabs(1 - LEN_NEW / LEN_OLD) < THRESHOLD) break;
+    if (LEN_CHANGED < THRESHOLD * LEN_NEW) break;
   }
 
   return ITER + 1;
 }
 
+// _____________________________________________________________________________
+NodeGeoIdx MapConstructor::nodeGeoIdx(double d) const {
+  if (_cfg->snapIndex == "grid") return NodeGeoIdx(std::max(d, 1.0));
+  return NodeGeoIdx();
+}
+
+// _____________________________________________________________________________
+LineEdge* MapConstructor::carryEdg(
+    LineEdge* e, std::unordered_map<LineNode*, LineNode*>* imgNds,
+    std::set<LineNode*>* imgNdsSet, NodeGeoIdx* geoIdx, LineGraph* g) {
+  for (auto nd : {e->getFrom(), e->getTo()}) {
+    if (imgNds->count(nd)) continue;
+    auto img = g->addNd(*nd->pl().getGeom());
+    geoIdx->add(*img->pl().getGeom(), img);
+    (*imgNds)[nd] = img;
+    imgNdsSet->insert(img);
+  }
+
+  auto from = imgNds->find(e->getFrom())->second;
+  auto to = imgNds->find(e->getTo())->second;
+
+  // both ends have been collapsed into the same node
+  if (from == to) return 0;
+
+  auto newE = g->getEdg(from, to);
+  LineEdge* ret = 0;
+
+  if (!newE) {
+    newE = g->addEdg(from, to);
+    newE->pl().setGeom(*e->pl().getGeom());
+    ret = newE;
+  }
+
+  combContEdgs(newE, e);
+  if (newE->getFrom() == from) {
+    mergeLines(newE, e, from, to);
+  } else {
+    mergeLines(newE, e, to, from);
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+double MapConstructor::stableEdgs(const LineGraph& old, const LineGraph& g,
+                                  double dCut, double eps,
+                                  std::set<const LineEdge*>* stable) const {
+  stable->clear();
+
+  NodeGeoIdx oldIdx = nodeGeoIdx(eps);
+  for (auto n : old.getNds()) oldIdx.add(*n->pl().getGeom(), n);
+
+  // the old node at (almost) the same position
+  auto oldNd = [&oldIdx, eps](const LineNode* n) {
+    std::vector<LineNode*> cands;
+    oldIdx.get(*n->pl().getGeom(), eps, &cands);
+
+    LineNode* ret = 0;
+    double dBest = eps;
+    for (auto cand : cands) {
+      double d = util::geo::dist(*cand->pl().getGeom(), *n->pl().getGeom());
+      if (d <= dBest) {
+        dBest = d;
+        ret = cand;
+      }
+    }
+    return ret;
+  };
+
+  std::vector<const LineEdge*> unchanged;
+  shared::linegraph::EdgeGrid changedIdx;
+  double changedLen = 0;
+
+  for (auto n : g.getNds()) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+
+      double len = e->pl().getPolyline().getLength();
+      auto oldFrom = oldNd(e->getFrom());
+      auto oldTo = oldNd(e->getTo());
+      const LineEdge* oldE = 0;
+      if (oldFrom && oldTo) {
+        for (auto oe : oldFrom->getAdjList()) {
+          if (oe->getOtherNd(oldFrom) == oldTo) oldE = oe;
+        }
+      }
+
+      bool same = oldE && fabs(oldE->pl().getPolyline().getLength() - len) <=
+                              eps &&
+                  oldE->pl().getLines().size() == e->pl().getLines().size();
+
+      for (size_t i = 0; same && i < e->pl().getLines().size(); i++) {
+        same = oldE->pl().hasLine(e->pl().getLines()[i].line);
+      }
+
+      if (same) {
+        unchanged.push_back(e);
+      } else {
+        changedLen += len;
+        changedIdx.add(*e->pl().getGeom(), e);
+      }
+    }
+  }
+
+  // edges near a changed edge may be collapsed into it
+  for (auto e : unchanged) {
+    std::vector<LineEdge*> near;
+    changedIdx.get(*e->pl().getGeom(), dCut, &near);
+    if (near.empty()) stable->insert(e);
+  }
+
+  return changedLen;
+}
+
 // _____________________________________________________________________________
 void MapConstructor::averageNodePositions() {
-  for (auto n : _g->getNds()) {
+  // the positions only depend on the edge geometries, compute them in
+  // parallel and set them afterwards
+  std::vector<LineNode*> nds(_g->getNds().begin(), _g->getNds().end());
+  std::vector<DPoint> pos(nds.size());
+  std::vector<char> has(nds.size(), 0);
+
+#pragma omp parallel for schedule(dynamic, 256) num_threads(_cfg->threads) \
+    if (nds.size() > 1024)
+  for (size_t i = 0; i < nds.size(); i++) {
+    auto n = nds[i];
     double x = 0, y = 0;
     size_t c = 0;
 
@@ -558,68 +810,88 @@ void MapConstructor::averageNodePositions() {
       c++;
     }
 
-    if (c > 0)
-      n->pl().setGeom(
-          DPoint(x / static_cast<double>(c), y / static_cast<double>(c)));
+    if (c > 0) {
+      pos[i] = DPoint(x / static_cast<double>(c), y / static_cast<double>(c));
+      has[i] = 1;
+    }
+  }
+
+  for (size_t i = 0; i < nds.size(); i++) {
+    if (has[i]) nds[i]->pl().setGeom(pos[i]);
   }
 }
 
 // _____________________________________________________________________________
 void MapConstructor::removeEdgeArtifacts() {
-  while (contractNodes()) {
-  };
+  // contracting a node only changes the node it was contracted into and the
+  // neighbours of that node, only they are checked again
+  NodeQueue q;
+  for (auto n : _g->getNds()) q.push(n);
+
+  while (!q.empty()) {
+    LineNode* to = contractNodes(q.pop());
+    if (!to) continue;
+    q.push(to);
+    for (auto e : to->getAdjList()) q.push(e->getOtherNd(to));
+  }
 }
 
 // _____________________________________________________________________________
 void MapConstructor::removeNodeArtifacts(bool keepStations) {
-  while (contractEdges(keepStations)) {
-  };
+  // contracting a node only changes its two neighbours, only they are
+  // checked again
+  NodeQueue q;
+  for (auto n : _g->getNds()) q.push(n);
+
+  while (!q.empty()) {
+    LineNode* n = q.pop();
+    std::vector<LineNode*> nbs;
+    for (auto e : n->getAdjList()) nbs.push_back(e->getOtherNd(n));
+    if (!contractEdges(n, keepStations)) continue;
+    for (auto nb : nbs) q.push(nb);
+  }
 }
 
 // _____________________________________________________________________________
-bool MapConstructor::contractNodes() {
-  for (auto n : _g->getNds()) {
-    for (auto e : n->getAdjList()) {
-      if (e->getFrom() != n) continue;
-      // contract edges below minimum length
-      if (e->pl().getPolyline().shorterThan(_cfg->maxAggrDistance)) {
-        auto from = e->getFrom();
-        auto to = e->getTo();
-
-        bool dontContract = false;
-
-        // check if we would fold edges with vastly different geoms
-        for (auto* oldE : from->getAdjList()) {
-          if (e == oldE) continue;
-
-          auto* newE = _g->getEdg(to, oldE->getTo());
-
-          if (newE && fabs(util::geo::len(*newE->pl().getGeom()) -
-                           util::geo::len(*oldE->pl().getGeom())) >
-                          _cfg->maxAggrDistance * 2) {
-            dontContract = true;
-          }
+LineNode* MapConstructor::contractNodes(LineNode* n) {
+  for (auto e : n->getAdjList()) {
+    if (e->getFrom() != n) continue;
+    // contract edges below minimum length
+    if (e->pl().getPolyline().shorterThan(_cfg->maxAggrDistance)) {
+      auto from = e->getFrom();
+      auto to = e->getTo();
+
+      bool dontContract = false;
+
+      // check if we would fold edges with vastly different geoms
+      for (auto* oldE : from->getAdjList()) {
+        if (e == oldE) continue;
+
+        auto* newE = _g->getEdg(to, oldE->getTo());
+
+        if (newE && fabs(util::geo::len(*newE->pl().getGeom()) -
+                         util::geo::len(*oldE->pl().getGeom())) >
+                        _cfg->maxAggrDistance * 2) {
+          dontContract = true;
         }
-
-        if (!dontContract && combineNodes(from, to, _g)) return true;
       }
+
+      if (!dontContract && combineNodes(from, to, _g)) return to;
     }
   }
-  return false;
+  return 0;
 }
 
 // _____________________________________________________________________________
-bool MapConstructor::contractEdges(bool keepStations) {
-  for (auto n : _g->getNds()) {
-    if (keepStations && n->pl().stops().size()) continue;
-    std::vector<LineEdge*> edges;
-    edges.insert(edges.end(), n->getAdjList().begin(), n->getAdjList().end());
-    if (edges.size() == 2) {
-      if (!_g->getEdg(edges[0]->getOtherNd(n), edges[1]->getOtherNd(n))) {
-        if (lineEq(edges[0], edges[1])) {
-          combineEdges(edges[0], edges[1], n, _g);
-          return true;
-        }
+bool MapConstructor::contractEdges(LineNode* n, bool keepStations) {
+  if (keepStations && n->pl().stops().size()) return false;
+  std::vector<LineEdge*> edges;
+  edges.insert(edges.end(), n->getAdjList().begin(), n->getAdjList().end());
+  if (edges.size() == 2) {
+    if (!_g->getEdg(edges[0]->getOtherNd(n), edges[1]->getOtherNd(n))) {
+      if (lineEq(edges[0], edges[1])) {
+        combineEdges(edges[0], edges[1], n, _g);
+        return true;
       }
     }
   }
@@ -720,7 +992,7 @@ size_t MapConstructor::freeze() {
   for (auto nd : _g->getNds()) {
     for (auto* edg : nd->getAdjList()) {
       if (edg->getFrom() != nd) continue;
-      _origEdgs.back()[edg].insert(edg);
+      _origEdgs.back()[edg].push_back(edg);
     }
   }
 
@@ -729,7 +1001,24 @@ size_t MapConstructor::freeze() {
 
 // _____________________________________________________________________________
 void MapConstructor::combContEdgs(const LineEdge* a, const LineEdge* b) {
-  for (auto& oe : _origEdgs) oe[a].insert(oe[b].begin(), oe[b].end());
+  std::vector<const LineEdge*> merged;
+
+  for (auto& oe : _origEdgs) {
+    auto& cont = oe[a];
+    const auto& add = oe[b];
+
+    if (add.empty()) continue;
+    if (cont.empty()) {
+      cont = add;
+      continue;
+    }
+
+    merged.clear();
+    merged.reserve(cont.size() + add.size());
+    std::set_union(cont.begin(), cont.end(), add.begin(), add.end(),
+                   std::back_inserter(merged));
+    cont.assign(merged.begin(), merged.end());
+  }
 }
 
 // _____________________________________________________________________________
@@ -858,9 +1147,7 @@ PolyLine<double> MapConstructor::geomAvg(const LineEdgePL& geomA, double startA,
       1.0 * geomA.getLines().size() * geomA.getLines().size(),
       1.0 * geomB.getLines().size() * geomB.getLines().size()};
 
-  PolyLine<double> ret = PolyLine<double>::average({&a, &b});
-  ret.simplify(0.5);
-  return ret;
+  return PolyLine<double>(simplifyLine(averageLines(a, b).getLine(), 0.5));
 }
 
 // _____________________________________________________________________________
@@ -988,21 +1275,30 @@ void MapConstructor::mergeLines(LineEdge* newE, LineEdge* oldE,
 
 // _____________________________________________________________________________
 bool MapConstructor::cleanUpGeoms() {
+  // every edge is cut independently, the cut geometries are computed in
+  // parallel and set afterwards
+  std::vector<LineEdge*> edgs;
   for (auto n : _g->getNds()) {
     for (auto e : n->getAdjList()) {
-      if (e->getFrom() != n) continue;
-      e->pl().setPolyline(e->pl().getPolyline().getSegment(
-          e->pl()
-              .getPolyline()
-              .projectOn(*e->getFrom()->pl().getGeom())
-              .totalPos,
-          e->pl()
-              .getPolyline()
-              .projectOn(*e->getTo()->pl().getGeom())
-              .totalPos));
+      if (e->getFrom() == n) edgs.push_back(e);
     }
   }
 
+  std::vector<PolyLine<double>> geoms(edgs.size());
+
+#pragma omp parallel for schedule(dynamic, 64) num_threads(_cfg->threads) \
+    if (edgs.size() > 256)
+  for (size_t i = 0; i < edgs.size(); i++) {
+    auto e = edgs[i];
+    geoms[i] = e->pl().getPolyline().getSegment(
+        e->pl().getPolyline().projectOn(*e->getFrom()->pl().getGeom()).totalPos,
+        e->pl().getPolyline().projectOn(*e->getTo()->pl().getGeom()).totalPos);
+  }
+
+  for (size_t i = 0; i < edgs.size(); i++) {
+    edgs[i]->pl().setPolyline(std::move(geoms[i]));
+  }
+
   // TODO: edges which continue to each other should be re-connected here
 
   return true;
@@ -9,6 +9,7 @@
 #include <unordered_map>
 #include "shared/linegraph/LineGraph.h"
 #include "topo/config/TopoConfig.h"
+#include "topo/mapconstructor/NodeGeoIdx.h"
 #include "topo/restr/RestrGraph.h"
 #include "util/geo/Geo.h"
 #include "util/geo/Grid.h"
@@ -37,10 +38,9 @@ using shared::linegraph::LineNode;
 using shared::linegraph::LineNodePL;
 using shared::linegraph::Station;
 
-// typedef Grid<LineNode*, Point, double> NodeGeoIdx;
-typedef RTree<LineNode*, Point, double> NodeGeoIdx;
-
-typedef std::unordered_map<const LineEdge*, std::set<const LineEdge*>> OrigEdgs;
+// original edges contained in an edge, as a sorted vector
+typedef std::unordered_map<const LineEdge*, std::vector<const LineEdge*>>
+    OrigEdgs;
 
 namespace topo {
 
@@ -109,7 +109,24 @@ class MapConstructor {
 
   void densifyEdg(LineEdge* e, LineGraph* g, double SEGL);
 
-  bool contractNodes();
+  // empty node index for snapping with query radius d
+  NodeGeoIdx nodeGeoIdx(double d) const;
+
+  // add a copy of e to g, between the images of its nodes, returns the new
+  // edge or 0 if no new edge was added
+  LineEdge* carryEdg(LineEdge* e,
+                     std::unordered_map<LineNode*, LineNode*>* imgNds,
+                     std::set<LineNode*>* imgNdsSet, NodeGeoIdx* geoIdx,
+                     LineGraph* g);
+
+  // collect the edges of g which are unchanged compared to old (up to eps)
+  // and have no changed edge within dCut, returns the changed edge length
+  double stableEdgs(const LineGraph& old, const LineGraph& g, double dCut,
+                    double eps, std::set<const LineEdge*>* stable) const;
+
+  // contract n into a neighbour it is connected to by a very short edge,
+  // returns that neighbour, or 0 if n was not contracted
+  LineNode* contractNodes(LineNode* n);
 
   void combContEdgs(const LineEdge* a, const LineEdge* b);
   void delOrigEdgsFor(const LineEdge* a);
@@ -117,7 +134,9 @@ class MapConstructor {
 
   bool lineEq(const LineEdge* a, const LineEdge* b);
 
-  bool contractEdges(bool keepStations);
+  // combine the two edges of a degree 2 node n which carry the same lines,
+  // true if n was contracted
+  bool contractEdges(LineNode* n, bool keepStations);
 
   bool foldEdges(LineEdge* a, LineEdge* b);
 
@@ -0,0 +1,81 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cmath>
+#include "topo/mapconstructor/NodeGeoIdx.h"
+
+using shared::linegraph::LineNode;
+using topo::NodeGeoIdx;
+using util::geo::DPoint;
+
+// _____________________________________________________________________________
+int32_t NodeGeoIdx::cellCoord(double c) const {
+  return static_cast<int32_t>(std::floor(c / _cellSize));
+}
+
+// _____________________________________________________________________________
+uint64_t NodeGeoIdx::cellKey(int32_t x, int32_t y) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+         static_cast<uint32_t>(y);
+}
+
+// _____________________________________________________________________________
+void NodeGeoIdx::add(const DPoint& p, LineNode* nd) {
+  if (_cellSize <= 0) {
+    _rtree.add(p, nd);
+    return;
+  }
+
+  uint64_t key = cellKey(cellCoord(p.getX()), cellCoord(p.getY()));
+  _cells[key].push_back({p, nd});
+  _ndCells[nd] = key;
+}
+
+// _____________________________________________________________________________
+void NodeGeoIdx::remove(LineNode* nd) {
+  if (_cellSize <= 0) {
+    _rtree.remove(nd);
+    return;
+  }
+
+  auto it = _ndCells.find(nd);
+  if (it == _ndCells.end()) return;
+
+  auto& cell = _cells[it->second];
+  for (size_t i = 0; i < cell.size(); i++) {
+    if (cell[i].second != nd) continue;
+    cell[i] = cell.back();
+    cell.pop_back();
+    break;
+  }
+
+  _ndCells.erase(it);
+}
+
+// _____________________________________________________________________________
+void NodeGeoIdx::get(const DPoint& p, double d,
+                     std::vector<LineNode*>* ret) const {
+  if (_cellSize <= 0) {
+    _rtree.get(p, d, ret);
+    return;
+  }
+
+  int32_t xFrom = cellCoord(p.getX() - d);
+  int32_t xTo = cellCoord(p.getX() + d);
+  int32_t yFrom = cellCoord(p.getY() - d);
+  int32_t yTo = cellCoord(p.getY() + d);
+
+  for (int32_t x = xFrom; x <= xTo; x++) {
+    for (int32_t y = yFrom; y <= yTo; y++) {
+      auto it = _cells.find(cellKey(x, y));
+      if (it == _cells.end()) continue;
+      for (const auto& e : it->second) {
+        if (std::fabs(e.first.getX() - p.getX()) > d ||
+            std::fabs(e.first.getY() - p.getY()) > d)
+          continue;
+        ret->push_back(e.second);
+      }
+    }
+  }
+}
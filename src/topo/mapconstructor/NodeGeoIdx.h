@@ -0,0 +1,55 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TOPO_MAPCONSTRUCTOR_NODEGEOIDX_H_
+#define TOPO_MAPCONSTRUCTOR_NODEGEOIDX_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "shared/linegraph/LineGraph.h"
+#include "util/geo/Geo.h"
+#include "util/geo/RTree.h"
+
+namespace topo {
+
+// Spatial index of line graph nodes used for snapping during map
+// construction. Either backed by an RTree, or by a uniform hash grid with
+// flat per-cell vectors, which is much cheaper for the many small inserts,
+// removals and radius queries of the snapping phase. The cell size should
+// be the typical query radius.
+class NodeGeoIdx {
+ public:
+  // RTree backed index
+  NodeGeoIdx() : _cellSize(0) {}
+
+  // grid backed index if cellSize > 0
+  explicit NodeGeoIdx(double cellSize) : _cellSize(cellSize) {}
+
+  void add(const util::geo::DPoint& p, shared::linegraph::LineNode* nd);
+  void remove(shared::linegraph::LineNode* nd);
+
+  // nodes within (at least) distance d of p
+  void get(const util::geo::DPoint& p, double d,
+           std::vector<shared::linegraph::LineNode*>* ret) const;
+
+ private:
+  typedef std::pair<util::geo::DPoint, shared::linegraph::LineNode*> Entry;
+
+  double _cellSize;
+
+  util::geo::RTree<shared::linegraph::LineNode*, util::geo::Point, double>
+      _rtree;
+
+  std::unordered_map<uint64_t, std::vector<Entry>> _cells;
+  std::unordered_map<const shared::linegraph::LineNode*, uint64_t> _ndCells;
+
+  int32_t cellCoord(double c) const;
+  static uint64_t cellKey(int32_t x, int32_t y);
+};
+
+}  // namespace topo
+
+#endif  // TOPO_MAPCONSTRUCTOR_NODEGEOIDX_H_
@@ -0,0 +1,235 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cfloat>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "topo/mapconstructor/PolyKernels.h"
+
+using topo::SoaLine;
+using util::geo::DLine;
+using util::geo::DPoint;
+using util::geo::PolyLine;
+
+namespace {
+// sampling step of the averaging, as in util::geo::PolyLine::average()
+const double AVG_STEP = 20;
+
+// _____________________________________________________________________________
+inline double dst(double ax, double ay, double bx, double by) {
+  double dx = ax - bx;
+  double dy = ay - by;
+  return sqrt(dx * dx + dy * dy);
+}
+
+// _____________________________________________________________________________
+inline double dstToSeg(double lax, double lay, double lbx, double lby,
+                       double px, double py) {
+  double d = dst(lax, lay, lbx, lby) * dst(lax, lay, lbx, lby);
+  if (d == 0) return dst(px, py, lax, lay);
+
+  double t = ((px - lax) * (lbx - lax) + (py - lay) * (lby - lay)) / d;
+
+  if (t < 0) return dst(px, py, lax, lay);
+  if (t > 1) return dst(px, py, lbx, lby);
+  return dst(px, py, lax + t * (lbx - lax), lay + t * (lby - lay));
+}
+
+// a line prepared for sampling at increasing distances
+struct Sampler {
+  explicit Sampler(const SoaLine& l)
+      : l(l), seg(l.size(), 0), cum(l.size(), 0) {
+    for (size_t i = 1; i < l.size(); i++) {
+      seg[i] = dst(l.x[i - 1], l.y[i - 1], l.x[i], l.y[i]);
+      cum[i] = cum[i - 1] + seg[i];
+    }
+  }
+
+  double length() const { return cum.size() ? cum.back() : 0; }
+
+  // the point at fraction t of the length, t must not decrease between
+  // calls
+  DPoint at(double t) {
+    double len = length();
+    double atDist = t * len;
+    if (atDist > len) atDist = len;
+    if (atDist < 0) atDist = 0;
+
+    if (l.size() == 1) return DPoint(l.x[0], l.y[0]);
+
+    while (cur < l.size() && !(cum[cur] > atDist)) cur++;
+    if (cur == l.size()) return DPoint(l.x.back(), l.y.back());
+
+    double d = seg[cur] - (cum[cur] - atDist);
+    double n1 = l.x[cur] - l.x[cur - 1];
+    double n2 = l.y[cur] - l.y[cur - 1];
+    double n = sqrt(n1 * n1 + n2 * n2);
+    return DPoint(l.x[cur - 1] + (n1 / n) * d, l.y[cur - 1] + (n2 / n) * d);
+  }
+
+  const SoaLine& l;
+  std::vector<double> seg, cum;
+  size_t cur = 1;
+};
+}  // namespace
+
+// _____________________________________________________________________________
+SoaLine::SoaLine(const DLine& l) {
+  reserve(l.size());
+  for (const auto& p : l) push_back(p.getX(), p.getY());
+}
+
+// _____________________________________________________________________________
+void SoaLine::reserve(size_t n) {
+  x.reserve(n);
+  y.reserve(n);
+}
+
+// _____________________________________________________________________________
+void SoaLine::push_back(double px, double py) {
+  x.push_back(px);
+  y.push_back(py);
+}
+
+// _____________________________________________________________________________
+DLine SoaLine::toLine() const {
+  DLine ret;
+  ret.reserve(size());
+  for (size_t i = 0; i < size(); i++) ret.push_back(DPoint(x[i], y[i]));
+  return ret;
+}
+
+// _____________________________________________________________________________
+DLine topo::densifyLine(const DLine& line, double d) {
+  if (!line.size()) return line;
+
+  SoaLine l(line);
+  SoaLine ret;
+  ret.reserve(l.size());
+  ret.push_back(l.x[0], l.y[0]);
+
+  // the offsets are accumulated like in util::geo::densify(), only the
+  // points are computed in the vectorized loop
+  std::vector<double> offs;
+
+  for (size_t i = 1; i < l.size(); i++) {
+    double segd = dst(l.x[i - 1], l.y[i - 1], l.x[i], l.y[i]);
+    double dx = (l.x[i] - l.x[i - 1]) / segd;
+    double dy = (l.y[i] - l.y[i - 1]) / segd;
+
+    offs.clear();
+    for (double curd = d; curd < segd; curd += d) offs.push_back(curd);
+
+    size_t n = ret.size();
+    ret.x.resize(n + offs.size());
+    ret.y.resize(n + offs.size());
+
+    double ax = l.x[i - 1];
+    double ay = l.y[i - 1];
+    double* rx = ret.x.data() + n;
+    double* ry = ret.y.data() + n;
+    const double* o = offs.data();
+
+#pragma omp simd
+    for (size_t j = 0; j < offs.size(); j++) {
+      rx[j] = ax + dx * o[j];
+      ry[j] = ay + dy * o[j];
+    }
+
+    ret.push_back(l.x[i], l.y[i]);
+  }
+
+  return ret.toLine();
+}
+
+// _____________________________________________________________________________
+DLine topo::simplifyLine(const DLine& line, double d) {
+  if (line.size() < 3) return line;
+
+  SoaLine l(line);
+  std::vector<char> keep(l.size(), 0);
+  std::vector<double> dists(l.size(), 0);
+  keep.front() = keep.back() = 1;
+
+  // ranges [s, e] still to simplify, processed in the order of the
+  // recursion of util::geo::simplify()
+  std::vector<std::pair<size_t, size_t>> stack{{0, l.size() - 1}};
+
+  while (stack.size()) {
+    size_t s = stack.back().first;
+    size_t e = stack.back().second;
+    stack.pop_back();
+
+    if (e - s < 2) continue;
+
+    double lax = l.x[s], lay = l.y[s], lbx = l.x[e], lby = l.y[e];
+    const double* px = l.x.data();
+    const double* py = l.y.data();
+    double* ds = dists.data();
+
+#pragma omp simd
+    for (size_t i = s + 1; i < e; i++) {
+      ds[i] = dstToSeg(lax, lay, lbx, lby, px[i], py[i]);
+    }
+
+    // the first point at maximum distance, as in util::geo::simplify()
+    double maxd = 0;
+    size_t maxi = 0;
+    for (size_t i = s + 1; i < e; i++) {
+      if (ds[i] > maxd) {
+        maxi = i;
+        maxd = ds[i];
+      }
+    }
+
+    if (maxd > d) {
+      keep[maxi] = 1;
+      stack.push_back({maxi, e});
+      stack.push_back({s, maxi});
+    }
+  }
+
+  DLine ret;
+  for (size_t i = 0; i < l.size(); i++) {
+    if (keep[i]) ret.push_back(line[i]);
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+PolyLine<double> topo::averageLines(const PolyLine<double>& a,
+                                    const PolyLine<double>& b) {
+  if (a.getLine().empty() || b.getLine().empty()) return PolyLine<double>();
+
+  SoaLine la(a.getLine());
+  SoaLine lb(b.getLine());
+
+  // both lines are sampled with a forward cursor, instead of walking them
+  // from their start for each sample
+  Sampler sa(la);
+  Sampler sb(lb);
+
+  double longest = DBL_MIN;
+  if (sa.length() > longest) longest = sa.length();
+  if (sb.length() > longest) longest = sb.length();
+
+  double stepSize = AVG_STEP / longest;
+
+  DLine ret;
+  bool end = false;
+  for (double t = 0; !end; t += stepSize) {
+    if (t > 1) {
+      t = 1;
+      end = true;
+    }
+
+    DPoint pa = sa.at(t);
+    DPoint pb = sb.at(t);
+    ret.push_back(
+        DPoint((pa.getX() + pb.getX()) / 2, (pa.getY() + pb.getY()) / 2));
+  }
+
+  return PolyLine<double>(simplifyLine(ret, 0));
+}
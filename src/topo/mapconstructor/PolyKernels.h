@@ -0,0 +1,48 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TOPO_MAPCONSTRUCTOR_POLYKERNELS_H_
+#define TOPO_MAPCONSTRUCTOR_POLYKERNELS_H_
+
+#include <vector>
+#include "util/geo/Geo.h"
+#include "util/geo/PolyLine.h"
+
+namespace topo {
+
+// Polyline kernels for the geometry work of the map construction. They
+// give the same results as util::geo::densify(), util::geo::simplify() and
+// util::geo::PolyLine::average(), but work on separate coordinate buffers,
+// so that their inner loops can be vectorized.
+
+// the coordinates of a line, as separate buffers
+struct SoaLine {
+  std::vector<double> x, y;
+
+  SoaLine() {}
+  explicit SoaLine(const util::geo::DLine& l);
+
+  size_t size() const { return x.size(); }
+  void reserve(size_t n);
+  void push_back(double px, double py);
+
+  util::geo::DLine toLine() const;
+};
+
+// points inserted into l at every d along each segment, as
+// util::geo::densify()
+util::geo::DLine densifyLine(const util::geo::DLine& l, double d);
+
+// Douglas-Peucker simplification of l with tolerance d, as
+// util::geo::simplify()
+util::geo::DLine simplifyLine(const util::geo::DLine& l, double d);
+
+// the average of two polylines, as util::geo::PolyLine::average() with two
+// unweighted lines
+util::geo::PolyLine<double> averageLines(const util::geo::PolyLine<double>& a,
+                                         const util::geo::PolyLine<double>& b);
+
+}  // namespace topo
+
+#endif  // TOPO_MAPCONSTRUCTOR_POLYKERNELS_H_
@@ -12,6 +12,7 @@
 #include "topo/restr/RestrInferrer.h"
 #include "util/geo/output/GeoGraphJsonOutput.h"
 #include "util/graph/Dijkstra.h"
+#include "util/Misc.h"
 #include "util/log/Log.h"
 
 using topo::restr::RestrInferrer;
@@ -81,33 +82,20 @@ size_t RestrInferrer::infer(const OrigEdgs& origEdgs) {
 
   size_t ret = 0;
 
-  for (auto nd : _tg->getNds()) {
-    for (auto edg1 : nd->getAdjList()) {
-      // check every other edge
-      for (auto edg2 : nd->getAdjList()) {
-        if (edg1 == edg2) continue;
-
-        for (auto ro1 : edg1->pl().getLines()) {
-          if (!edg2->pl().hasLine(ro1.line)) continue;
-
-          const auto& ro2 = edg2->pl().lineOcc(ro1.line);
-
-          if (ro1.direction != 0 && ro2.direction != 0 &&
-              ro1.direction == ro2.direction)
-            continue;
+  // the checks only read the restriction graph, so the nodes can be
+  // checked in parallel. The exceptions are added afterwards, in node order.
+  std::vector<LineNode*> nds(_tg->getNds().begin(), _tg->getNds().end());
+  std::vector<std::vector<ConnExc>> excs(nds.size());
 
-          if (ro1.direction != 0 && ro2.direction != 0 &&
-              edg1->getOtherNd(ro1.direction) ==
-                  edg2->getOtherNd(ro2.direction)) {
-            continue;
-          }
+  T_START(checks);
+#pragma omp parallel for schedule(dynamic, 16) num_threads(_cfg->threads)
+  for (size_t i = 0; i < nds.size(); i++) inferExcs(nds[i], &excs[i]);
+  _checkT = T_STOP(checks);
 
-          if (!check(ro1.line, edg1, edg2) && !check(ro1.line, edg2, edg1)) {
-            nd->pl().addConnExc(ro1.line, edg1, edg2);
-            ret++;
-          }
-        }
-      }
+  for (size_t i = 0; i < nds.size(); i++) {
+    for (const auto& ex : excs[i]) {
+      nds[i]->pl().addConnExc(ex.line, ex.from, ex.to);
+      ret++;
     }
   }
 
@@ -146,6 +134,43 @@ size_t RestrInferrer::infer(const OrigEdgs& origEdgs) {
   return ret;
 }
 
+// _____________________________________________________________________________
+void RestrInferrer::inferExcs(const LineNode* nd,
+                              std::vector<ConnExc>* excs) const {
+  // line pairs on the same edge pair share their handle edges, and every
+  // check is done in both directions of an edge pair
+  HndlEdgCache hndlCache;
+  CheckCache checkCache;
+
+  for (auto edg1 : nd->getAdjList()) {
+    // check every other edge
+    for (auto edg2 : nd->getAdjList()) {
+      if (edg1 == edg2) continue;
+
+      for (auto ro1 : edg1->pl().getLines()) {
+        if (!edg2->pl().hasLine(ro1.line)) continue;
+
+        const auto& ro2 = edg2->pl().lineOcc(ro1.line);
+
+        if (ro1.direction != 0 && ro2.direction != 0 &&
+            ro1.direction == ro2.direction)
+          continue;
+
+        if (ro1.direction != 0 && ro2.direction != 0 &&
+            edg1->getOtherNd(ro1.direction) ==
+                edg2->getOtherNd(ro2.direction)) {
+          continue;
+        }
+
+        if (!check(ro1.line, edg1, edg2, &hndlCache, &checkCache) &&
+            !check(ro1.line, edg2, edg1, &hndlCache, &checkCache)) {
+          excs->push_back({ro1.line, edg1, edg2});
+        }
+      }
+    }
+  }
+}
+
 // _____________________________________________________________________________
 void RestrInferrer::addHndls(const OrigEdgs& origEdgs) {
   std::map<RestrEdge*, HndlLst> handles;
@@ -309,42 +334,39 @@ void RestrInferrer::addHndls(const LineEdge* e, const OrigEdgs& origEdgs,
   }
 }
 
+// _____________________________________________________________________________
+const std::set<RestrEdge*>& RestrInferrer::hndlEdgs(
+    const LineEdge* e, const LineNode* n, HndlEdgCache* cache) const {
+  auto it = cache->find({e, n});
+  if (it != cache->end()) return it->second;
+
+  auto& ret = (*cache)[{e, n}];
+  const auto& hndls = n == e->getFrom() ? _handlesA : _handlesB;
+
+  auto hIt = hndls.find(e);
+  if (hIt != hndls.end()) {
+    for (auto nd : hIt->second) {
+      ret.insert(nd->getAdjListIn().begin(), nd->getAdjListIn().end());
+    }
+  }
+
+  return ret;
+}
+
 // _____________________________________________________________________________
 bool RestrInferrer::check(const Line* r, const LineEdge* edg1,
-                          const LineEdge* edg2) const {
-  std::set<RestrEdge*> from, to;
+                          const LineEdge* edg2, HndlEdgCache* hndlCache,
+                          CheckCache* checkCache) const {
+  auto cIt = checkCache->find({r, {edg1, edg2}});
+  if (cIt != checkCache->end()) return cIt->second;
+
   auto shrdNd = shared::linegraph::LineGraph::sharedNode(edg1, edg2);
 
   double curD = edg1->pl().getPolyline().getLength() * 0.33 +
                 edg2->pl().getPolyline().getLength() * 0.33;
 
-  if (shrdNd == edg1->getFrom()) {
-    if (_handlesA.count(edg1)) {
-      for (auto nd : _handlesA.find(edg1)->second) {
-        from.insert(nd->getAdjListIn().begin(), nd->getAdjListIn().end());
-      }
-    }
-  } else {
-    if (_handlesB.count(edg1)) {
-      for (auto nd : _handlesB.find(edg1)->second) {
-        from.insert(nd->getAdjListIn().begin(), nd->getAdjListIn().end());
-      }
-    }
-  }
-
-  if (shrdNd == edg2->getFrom()) {
-    if (_handlesA.count(edg2)) {
-      for (auto nd : _handlesA.find(edg2)->second) {
-        to.insert(nd->getAdjListIn().begin(), nd->getAdjListIn().end());
-      }
-    }
-  } else {
-    if (_handlesB.count(edg2)) {
-      for (auto nd : _handlesB.find(edg2)->second) {
-        to.insert(nd->getAdjListIn().begin(), nd->getAdjListIn().end());
-      }
-    }
-  }
+  const auto& from = hndlEdgs(edg1, shrdNd, hndlCache);
+  const auto& to = hndlEdgs(edg2, shrdNd, hndlCache);
 
   // curdist + maxL is the inf. We do not have to check any further as we
   // only return true below if cost - curD < maxL <=> cost < curD + maxL
@@ -353,5 +375,9 @@ bool RestrInferrer::check(const Line* r, const LineEdge* edg1,
   CostFunc cFunc(r, curD + _cfg->maxLengthDev + eps, _cfg->turnInferFullTurnPen,
                  _cfg->fullTurnAngle);
 
-  return EDijkstra::shortestPath(from, to, cFunc) - curD < _cfg->maxLengthDev;
+  bool ret =
+      EDijkstra::shortestPath(from, to, cFunc) - curD < _cfg->maxLengthDev;
+  (*checkCache)[{r, {edg1, edg2}}] = ret;
+
+  return ret;
 }
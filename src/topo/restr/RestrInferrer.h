@@ -29,7 +29,9 @@ using util::graph::EDijkstra;
 namespace topo {
 namespace restr {
 
-typedef std::unordered_map<const LineEdge*, std::set<const LineEdge*>> OrigEdgs;
+// original edges contained in an edge, as a sorted vector
+typedef std::unordered_map<const LineEdge*, std::vector<const LineEdge*>>
+    OrigEdgs;
 typedef std::pair<RestrNode*, double> Hndl;
 typedef std::vector<Hndl> HndlLst;
 
@@ -78,6 +80,23 @@ struct CostFunc : public EDijkstra::CostFunc<RestrNodePL, RestrEdgePL, double> {
   double _fullTurnAngle;
 };
 
+// handle edges of line edges at one of their nodes
+typedef std::map<std::pair<const LineEdge*, const LineNode*>,
+                 std::set<RestrEdge*>>
+    HndlEdgCache;
+
+// results of connection checks, by line, from edge and to edge
+typedef std::map<std::pair<const Line*, std::pair<const LineEdge*,
+                                                   const LineEdge*>>,
+                 bool>
+    CheckCache;
+
+struct ConnExc {
+  const Line* line;
+  const LineEdge* from;
+  const LineEdge* to;
+};
+
 struct HndlCmp {
   bool operator()(const Hndl& a, const Hndl& b) const {
     return a.second < b.second;
@@ -91,6 +110,9 @@ class RestrInferrer {
   void init();
   size_t infer(const OrigEdgs& origEdgs);
 
+  // time spent in the connection checks of the last infer() call, in ms
+  double getCheckTime() const { return _checkT; }
+
  private:
   const TopoConfig* _cfg;
 
@@ -108,8 +130,17 @@ class RestrInferrer {
   // graph representation
   std::unordered_map<const LineNode*, RestrNode*> _nMap;
 
+  double _checkT = 0;
+
   // check whether a connection ocurred in the original graph
-  bool check(const Line* r, const LineEdge* edg1, const LineEdge* edg2) const;
+  bool check(const Line* r, const LineEdge* edg1, const LineEdge* edg2,
+             HndlEdgCache* hndlCache, CheckCache* checkCache) const;
+
+  const std::set<RestrEdge*>& hndlEdgs(const LineEdge* e, const LineNode* n,
+                                       HndlEdgCache* cache) const;
+
+  // collect the connection exceptions at a single node
+  void inferExcs(const LineNode* nd, std::vector<ConnExc>* excs) const;
 
   void addHndls(const OrigEdgs& origEdgs);
   void addHndls(const LineEdge* e, const OrigEdgs& origEdgs,
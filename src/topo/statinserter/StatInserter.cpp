@@ -2,6 +2,7 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
 #include <cassert>
 #include <climits>
 
@@ -80,6 +81,10 @@ void StatInserter::init() {
         auto& ex = _statClusters[exI->second];
         ex.edges.insert(nd->getAdjList().begin(), nd->getAdjList().end());
         ex.stations.push_back(stop);
+        // a trip stops at one of the merged nodes, the routes may overlap
+        ex.stations.front().trips += stop.trips;
+        ex.stations.front().routes =
+            std::max(ex.stations.front().routes, stop.routes);
         ex.geom.push_back(stop.pos);
         for (auto e : nd->getAdjList()) {
           for (const auto& lo : e->pl().getLines()) {
@@ -217,15 +222,39 @@ double StatInserter::candScore(const StationCand& c) {
   return score;
 }
 
+// _____________________________________________________________________________
+DBox StatInserter::candBox(const StationOcc& occ) const {
+  return util::geo::pad(util::geo::getBoundingBox(occ.stations.front().pos),
+                        4 * _cfg->maxAggrDistance);
+}
+
+// _____________________________________________________________________________
+bool StatInserter::candsValid(const std::vector<StationCand>& cands,
+                              const StationOcc& occ,
+                              const std::vector<DBox>& chgBoxes,
+                              const std::set<const LineNode*>& chgNds) const {
+  // edges are only replaced by edges inside their own bounding box, so
+  // if no changed edge was near the station, the same edges are found again
+  auto box = candBox(occ);
+  for (const auto& chg : chgBoxes) {
+    if (util::geo::intersects(box, chg)) return false;
+  }
+
+  // node candidates may be far away, their adjacent edges might have changed
+  for (const auto& cand : cands) {
+    if (cand.nd && chgNds.count(cand.nd)) return false;
+  }
+
+  return true;
+}
+
 // _____________________________________________________________________________
 std::vector<StationCand> StatInserter::candidates(const StationOcc& occ,
                                                   const EdgeGeoIdx& idx,
                                                   const OrigEdgs& origEdgs) {
   std::vector<StationCand> ret;
   std::set<LineEdge*> neighbors;
-  idx.get(util::geo::pad(util::geo::getBoundingBox(occ.stations.front().pos),
-                         4 * _cfg->maxAggrDistance),
-          &neighbors);
+  idx.get(candBox(occ), &neighbors);
 
   LOGTO(VDEBUG, std::cerr) << "Got " << neighbors.size() << " candidates...";
 
@@ -299,14 +328,37 @@ bool StatInserter::insertStations(const OrigEdgs& origEdgs) {
   std::unordered_map<LineNode*, std::vector<std::pair<double, Station>>>
       newStats;
 
-  for (auto curOcc : _statClusters) {
+  // finding the first candidates of each station only reads the graph, so
+  // they can be searched for in parallel beforehand. Insertions are still
+  // done one after the other in the original order, candidates invalidated
+  // by an earlier insertion are searched for again.
+  std::vector<std::vector<StationCand>> preCands;
+  std::vector<DBox> chgBoxes;
+  std::set<const LineNode*> chgNds;
+
+  if (_cfg->parStatIns) {
+    preCands.resize(_statClusters.size());
+#pragma omp parallel for schedule(dynamic, 16) num_threads(_cfg->threads)
+    for (size_t j = 0; j < _statClusters.size(); j++) {
+      preCands[j] = candidates(_statClusters[j], idx, modOrigEdgs);
+    }
+  }
+
+  for (size_t j = 0; j < _statClusters.size(); j++) {
+    auto curOcc = _statClusters[j];
     LOGTO(DEBUG, std::cerr) << "Inserting " << curOcc.stations.front().name;
 
     int MAX_INSERTS = 3;
     int i = 0;
 
     while (i++ < MAX_INSERTS) {
-      auto cands = candidates(curOcc, idx, modOrigEdgs);
+      std::vector<StationCand> cands;
+      if (i == 1 && _cfg->parStatIns &&
+          candsValid(preCands[j], curOcc, chgBoxes, chgNds)) {
+        cands = std::move(preCands[j]);
+      } else {
+        cands = candidates(curOcc, idx, modOrigEdgs);
+      }
 
       if (cands.size() == 0) {
         LOGTO(DEBUG, std::cerr) << "  (No insertion candidate found.)";
@@ -361,6 +413,13 @@ bool StatInserter::insertStations(const OrigEdgs& origEdgs) {
         edgeRpl(e->getFrom(), e, spl.first);
         edgeRpl(e->getTo(), e, spl.second);
 
+        if (_cfg->parStatIns) {
+          chgBoxes.push_back(
+              util::geo::getBoundingBox(e->pl().getPolyline().getLine()));
+          chgNds.insert(e->getFrom());
+          chgNds.insert(e->getTo());
+        }
+
         _g->delEdg(e->getFrom(), e->getTo());
         idx.remove(e);
       } else {
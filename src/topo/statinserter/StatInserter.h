@@ -39,7 +39,9 @@ using shared::linegraph::Station;
 
 typedef RTree<LineEdge*, Line, double> EdgeGeoIdx;
 
-typedef std::unordered_map<const LineEdge*, std::set<const LineEdge*>> OrigEdgs;
+// original edges contained in an edge, as a sorted vector
+typedef std::unordered_map<const LineEdge*, std::vector<const LineEdge*>>
+    OrigEdgs;
 
 namespace topo {
 
@@ -84,6 +86,12 @@ class StatInserter {
                                       const EdgeGeoIdx& idx,
                                       const OrigEdgs& origEdgs);
 
+  DBox candBox(const StationOcc& occ) const;
+
+  bool candsValid(const std::vector<StationCand>& cands,
+                  const StationOcc& occ, const std::vector<DBox>& chgBoxes,
+                  const std::set<const LineNode*>& chgNds) const;
+
   DBox bbox() const;
   EdgeGeoIdx geoIndex();
 
@@ -0,0 +1,69 @@
+// Copyright 2023
+// Author: Patrick Brosi
+
+#include <cassert>
+#include <set>
+#include <string>
+
+#include "shared/linegraph/LineGraph.h"
+#include "topo/config/TopoConfig.h"
+#include "topo/extract/Extractor.h"
+#include "topo/tests/ExtractTest.h"
+#include "topo/tests/TopoTestUtil.h"
+#include "util/Misc.h"
+
+// _____________________________________________________________________________
+void ExtractTest::run() {
+  // ___________________________________________________________________________
+  {
+    //  1, 2      1
+    // a ---- b ---- c
+    //        |
+    //        | 2
+    //        d
+    shared::linegraph::LineGraph tg;
+    auto a = tg.addNd({{0.0, 0.0}});
+    auto b = tg.addNd({{100.0, 0.0}});
+    auto c = tg.addNd({{200.0, 0.0}});
+    auto d = tg.addNd({{100.0, -100.0}});
+
+    a->pl().addStop(shared::linegraph::Station("a", "a", *a->pl().getGeom()));
+    c->pl().addStop(shared::linegraph::Station("c", "c", *c->pl().getGeom()));
+    d->pl().addStop(shared::linegraph::Station("d", "d", *d->pl().getGeom()));
+
+    auto ab = tg.addEdg(a, b, {{{0.0, 0.0}, {100.0, 0.0}}});
+    auto bc = tg.addEdg(b, c, {{{100.0, 0.0}, {200.0, 0.0}}});
+    auto bd = tg.addEdg(b, d, {{{100.0, 0.0}, {100.0, -100.0}}});
+
+    shared::linegraph::Line l1("1", "S1", "red");
+    shared::linegraph::Line l2("2", "S2", "green");
+
+    ab->pl().addLine(&l1, 0);
+    ab->pl().addLine(&l2, 0);
+    bc->pl().addLine(&l1, 0);
+    bd->pl().addLine(&l2, 0);
+
+    b->pl().addConnExc(&l2, ab, bd);
+
+    topo::config::TopoConfig cfg;
+    topo::Extractor ex(&cfg, &tg);
+
+    TEST(ex.selectLines({}, {}).size(), ==, 2);
+    TEST(ex.selectLines({"1"}, {}).size(), ==, 1);
+    TEST(ex.selectLines({"S2"}, {}).count(&l2), ==, 1);
+    TEST(ex.selectLines({}, {"d"}).size(), ==, 1);
+    TEST(ex.selectLines({}, {"d"}).count(&l2), ==, 1);
+    TEST(ex.selectLines({"1"}, {"d"}).size(), ==, 0);
+
+    ex.extract({&l1});
+
+    // the branch of line 2 is gone, b is contracted
+    TEST(tg.numNds(), ==, 2);
+    TEST(tg.numEdgs(), ==, 1);
+    TEST(a->getDeg(), ==, 1);
+    TEST(c->getDeg(), ==, 1);
+    TEST(tg.getEdg(a, c)->pl().getLines().size(), ==, 1);
+    TEST(tg.getEdg(a, c)->pl().hasLine(&l1));
+    TEST(validExceptions(&tg));
+  }
+}
@@ -0,0 +1,12 @@
+// Copyright 2023
+// Author: Patrick Brosi
+
+#ifndef TOPO_TEST_EXTRACTTEST_H_
+#define TOPO_TEST_EXTRACTTEST_H_
+
+class ExtractTest {
+  public:
+    void run();
+};
+
+#endif
@@ -0,0 +1,66 @@
+// Copyright 2023
+// Author: Patrick Brosi
+
+#include <cassert>
+#include <vector>
+
+#include "topo/mapconstructor/PolyKernels.h"
+#include "topo/tests/PolyKernelsTest.h"
+#include "util/Misc.h"
+#include "util/geo/Geo.h"
+#include "util/geo/PolyLine.h"
+
+using util::approx;
+using util::geo::DLine;
+using util::geo::PolyLine;
+
+namespace {
+// _____________________________________________________________________________
+bool sameLine(const DLine& a, const DLine& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (!(a[i].getX() == approx(b[i].getX()))) return false;
+    if (!(a[i].getY() == approx(b[i].getY()))) return false;
+  }
+  return true;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+void PolyKernelsTest::run() {
+  std::vector<DLine> lines{
+      {},
+      {{0, 0}},
+      {{0, 0}, {0, 0}},
+      {{0, 0}, {100, 0}},
+      {{0, 0}, {33, 4}, {50, -1}, {51, 60}, {120, 61}, {121, 61.2}},
+      {{0, 0}, {10, 0.1}, {20, -0.2}, {30, 0.3}, {40, 0}, {40, 30}},
+      {{5, 5}, {5, 5}, {17, 29}, {17, 29}, {-3, 12}}};
+
+  // ___________________________________________________________________________
+  for (const auto& l : lines) {
+    for (double d : {0.5, 5.0, 50.0}) {
+      TEST(sameLine(topo::densifyLine(l, d), util::geo::densify(l, d)));
+    }
+  }
+
+  // ___________________________________________________________________________
+  for (const auto& l : lines) {
+    for (double d : {0.0, 0.5, 1.0, 10.0}) {
+      TEST(sameLine(topo::simplifyLine(l, d), util::geo::simplify(l, d)));
+    }
+  }
+
+  // ___________________________________________________________________________
+  {
+    PolyLine<double> a({0, 0}, {100, 0});
+    PolyLine<double> b({0, 10}, {100, 10});
+    auto avg = topo::averageLines(a, b);
+
+    TEST(avg.getLine().size(), ==, 2);
+    TEST(avg.getLine().front().getX(), ==, approx(0));
+    TEST(avg.getLine().front().getY(), ==, approx(5));
+    TEST(avg.getLine().back().getX(), ==, approx(100));
+    TEST(avg.getLine().back().getY(), ==, approx(5));
+  }
+}
@@ -0,0 +1,12 @@
+// Copyright 2023
+// Author: Patrick Brosi
+
+#ifndef TOPO_TEST_POLYKERNELSTEST_H_
+#define TOPO_TEST_POLYKERNELSTEST_H_
+
+class PolyKernelsTest {
+  public:
+    void run();
+};
+
+#endif
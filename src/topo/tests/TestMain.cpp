@@ -3,6 +3,8 @@
 
 #include "topo/tests/ContractTest.h"
 #include "topo/tests/ContractTest2.h"
+#include "topo/tests/ExtractTest.h"
+#include "topo/tests/PolyKernelsTest.h"
 #include "topo/tests/TopologicalTest.h"
 #include "topo/tests/RestrInfTest.h"
 
@@ -16,9 +18,13 @@ int main(int argc, char** argv) {
   ContractTest ct;
   TopologicalTest tt;
   RestrInfTest rt;
+  ExtractTest et;
+  PolyKernelsTest pt;
 
   rt.run();
   ct2.run();
   ct.run();
   tt.run();
+  et.run();
+  pt.run();
 }
@@ -1136,4 +1136,104 @@ void TopologicalTest::run() {
       TEST(e->pl().getLines().begin()->direction, ==, 0);
     }
   }
+
+  // ___________________________________________________________________________
+  {
+    // incremental collapsing
+    //     1
+    // a ------> b
+    // c ------> d
+    //     2
+    //
+    //     3
+    // e ------> f
+    shared::linegraph::LineGraph tg;
+    auto a = tg.addNd({{0.0, 5.0}});
+    auto b = tg.addNd({{50.0, 5.0}});
+    auto c = tg.addNd({{0.0, 0.0}});
+    auto d = tg.addNd({{50.0, 0.0}});
+    auto e = tg.addNd({{0.0, -500.0}});
+    auto f = tg.addNd({{50.0, -500.0}});
+
+    auto ab = tg.addEdg(a, b, {{{0.0, 5.0}, {50.0, 5.0}}});
+    auto cd = tg.addEdg(c, d, {{{0.0, 0.0}, {50.0, 0.0}}});
+    auto ef = tg.addEdg(e, f, {{{0.0, -500.0}, {50.0, -500.0}}});
+
+    shared::linegraph::Line l1("1", "1", "red");
+    shared::linegraph::Line l2("2", "2", "blue");
+    shared::linegraph::Line l3("3", "3", "green");
+
+    ab->pl().addLine(&l1, 0);
+    cd->pl().addLine(&l2, 0);
+    ef->pl().addLine(&l3, f);
+
+    topo::config::TopoConfig cfg;
+    cfg.maxAggrDistance = 10;
+    cfg.incrCollapse = true;
+
+    topo::MapConstructor mc(&cfg, &tg);
+    mc.collapseShrdSegs();
+
+    //     1, 2
+    // a ------> b
+    //
+    //     3
+    // e ------> f
+
+    TEST(tg.getNds().size(), ==, 4);
+
+    size_t twoLines = 0;
+    size_t oneLine = 0;
+    for (auto nd : tg.getNds()) {
+      TEST(nd->getDeg(), ==, 1);
+      auto edg = nd->getAdjList().front();
+      if (edg->getFrom() != nd) continue;
+      if (edg->pl().getLines().size() == 2) twoLines++;
+      if (edg->pl().getLines().size() == 1) {
+        oneLine++;
+        TEST(edg->pl().hasLine(&l3));
+        TEST(edg->pl().lineOcc(&l3).direction, !=, 0);
+      }
+    }
+
+    TEST(twoLines, ==, 1);
+    TEST(oneLine, ==, 1);
+  }
+
+  // ___________________________________________________________________________
+  {
+    // grid snapping index
+    //     1
+    // a ------> b
+    // c ------> d
+    //     2
+    shared::linegraph::LineGraph tg;
+    auto a = tg.addNd({{0.0, 5.0}});
+    auto b = tg.addNd({{50.0, 5.0}});
+    auto c = tg.addNd({{0.0, 0.0}});
+    auto d = tg.addNd({{50.0, 0.0}});
+
+    auto ab = tg.addEdg(a, b, {{{0.0, 5.0}, {50.0, 5.0}}});
+    auto cd = tg.addEdg(c, d, {{{0.0, 0.0}, {50.0, 0.0}}});
+
+    shared::linegraph::Line l1("1", "1", "red");
+    shared::linegraph::Line l2("2", "2", "blue");
+
+    ab->pl().addLine(&l1, 0);
+    cd->pl().addLine(&l2, 0);
+
+    topo::config::TopoConfig cfg;
+    cfg.maxAggrDistance = 10;
+    cfg.snapIndex = "grid";
+
+    topo::MapConstructor mc(&cfg, &tg);
+    mc.collapseShrdSegs();
+
+    //     1, 2
+    // a ------> b
+
+    TEST(tg.getNds().size(), ==, 2);
+    TEST((*tg.getNds().begin())->getAdjList().front()->pl().getLines().size(),
+         ==, 2);
+  }
 }
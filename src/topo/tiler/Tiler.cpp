@@ -0,0 +1,289 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cmath>
+#include <limits>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "topo/tiler/Tiler.h"
+#include "util/geo/RTree.h"
+
+using shared::linegraph::Line;
+using shared::linegraph::LineEdge;
+using shared::linegraph::LineGraph;
+using shared::linegraph::LineNode;
+using topo::Tile;
+using topo::Tiler;
+using topo::config::TopoConfig;
+using util::geo::DBox;
+using util::geo::DPoint;
+
+namespace {
+// _____________________________________________________________________________
+void delForeignConnExcs(LineNode* n) {
+  std::unordered_set<const LineEdge*> adj(n->getAdjList().begin(),
+                                          n->getAdjList().end());
+
+  std::vector<std::tuple<const Line*, const LineEdge*, const LineEdge*>> del;
+  for (const auto& l : n->pl().getConnExc()) {
+    for (const auto& fr : l.second) {
+      for (auto to : fr.second) {
+        if (adj.count(fr.first) && adj.count(to)) continue;
+        del.push_back(std::make_tuple(l.first, fr.first, to));
+      }
+    }
+  }
+
+  for (const auto& ex : del) {
+    n->pl().delConnExc(std::get<0>(ex), std::get<1>(ex), std::get<2>(ex));
+  }
+}
+}  // namespace
+
+// _____________________________________________________________________________
+Tiler::Tiler(const TopoConfig* cfg, const LineGraph* g)
+    : _cfg(cfg), _g(g), _origin(g->getBBox().getLowerLeft()) {
+  for (auto nd : _g->getNds()) {
+    if (nd->getDeg() == 0) {
+      auto t = tileOf(*nd->pl().getGeom());
+      _tileNds[{t.second, t.first}].push_back(nd);
+    }
+
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      if (e->pl().getLines().size() == 0) continue;
+
+      // every tile the bounding box of e comes within the overlap of
+      auto box = util::geo::pad(util::geo::getBoundingBox(*e->pl().getGeom()),
+                                _cfg->tileOverlap);
+      auto ll = tileOf(box.getLowerLeft());
+      auto ur = tileOf(box.getUpperRight());
+      for (int64_t y = ll.second; y <= ur.second; y++) {
+        for (int64_t x = ll.first; x <= ur.first; x++) {
+          _tileEdgs[{y, x}].push_back(e);
+        }
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+std::pair<int64_t, int64_t> Tiler::tileOf(const DPoint& p) const {
+  return {static_cast<int64_t>(
+              std::floor((p.getX() - _origin.getX()) / _cfg->tileSize)),
+          static_cast<int64_t>(
+              std::floor((p.getY() - _origin.getY()) / _cfg->tileSize))};
+}
+
+// _____________________________________________________________________________
+DBox Tiler::coreBox(int64_t x, int64_t y) const {
+  double s = _cfg->tileSize;
+  return DBox(
+      DPoint(_origin.getX() + x * s, _origin.getY() + y * s),
+      DPoint(_origin.getX() + (x + 1) * s, _origin.getY() + (y + 1) * s));
+}
+
+// _____________________________________________________________________________
+std::vector<Tile> Tiler::tiles() const {
+  // the keys are (y, x), so the tiles are ordered by row
+  std::set<std::pair<int64_t, int64_t>> keys;
+  for (const auto& t : _tileEdgs) keys.insert(t.first);
+  for (const auto& t : _tileNds) keys.insert(t.first);
+
+  std::vector<Tile> ret;
+  for (const auto& yx : keys) {
+    ret.push_back({yx.second, yx.first, coreBox(yx.second, yx.first)});
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+size_t Tiler::numEdgs(const Tile& t) const {
+  auto it = _tileEdgs.find({t.y, t.x});
+  if (it == _tileEdgs.end()) return 0;
+  return it->second.size();
+}
+
+// _____________________________________________________________________________
+void Tiler::cut(const Tile& t, LineGraph* tg) const {
+  std::unordered_map<const LineNode*, LineNode*> nm;
+
+  auto img = [&](const LineNode* nd) {
+    auto it = nm.find(nd);
+    if (it != nm.end()) return it->second;
+    auto* ret = tg->addNd(nd->pl());
+    tg->expandBBox(*nd->pl().getGeom());
+    nm[nd] = ret;
+    return ret;
+  };
+
+  auto nds = _tileNds.find({t.y, t.x});
+  if (nds != _tileNds.end()) {
+    for (auto nd : nds->second) img(nd);
+  }
+
+  auto edgs = _tileEdgs.find({t.y, t.x});
+  if (edgs != _tileEdgs.end()) {
+    for (auto edg : edgs->second) {
+      auto* fr = img(edg->getFrom());
+      auto* to = img(edg->getTo());
+
+      auto* newE = tg->addEdg(fr, to, edg->pl());
+      tg->expandBBox(edg->pl().getGeom()->front());
+      tg->expandBBox(edg->pl().getGeom()->back());
+
+      tg->edgeRpl(fr, edg, newE);
+      tg->edgeRpl(to, edg, newE);
+      tg->nodeRpl(newE, edg->getTo(), to);
+      tg->nodeRpl(newE, edg->getFrom(), fr);
+    }
+  }
+
+  // turn restrictions with an edge outside the tile still point into the
+  // input graph
+  for (auto nd : tg->getNds()) delForeignConnExcs(nd);
+}
+
+// _____________________________________________________________________________
+std::vector<LineNode*> Tiler::clip(const Tile& t, LineGraph* tg) const {
+  auto tl = std::make_pair(t.x, t.y);
+
+  // an edge is owned by the tile its midpoint lies in
+  std::vector<LineEdge*> drop;
+  for (auto nd : tg->getNds()) {
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      if (tileOf(e->pl().getPolyline().getPointAt(0.5).p) != tl) {
+        drop.push_back(e);
+      }
+    }
+  }
+
+  std::set<LineNode*> touched;
+  for (auto e : drop) {
+    touched.insert(e->getFrom());
+    touched.insert(e->getTo());
+    tg->delEdg(e->getFrom(), e->getTo());
+  }
+
+  std::vector<LineNode*> del;
+  for (auto nd : tg->getNds()) {
+    if (nd->getDeg() != 0) continue;
+    // stations which lost all their edges are kept by the other tile
+    if (touched.count(nd) || tileOf(*nd->pl().getGeom()) != tl) {
+      del.push_back(nd);
+    }
+  }
+
+  for (auto nd : del) {
+    touched.erase(nd);
+    tg->delNd(nd);
+  }
+
+  std::vector<LineNode*> ret;
+  for (auto nd : touched) {
+    delForeignConnExcs(nd);
+    ret.push_back(nd);
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void Tiler::stitch(std::vector<LineGraph>* tgs,
+                   const std::vector<std::vector<LineNode*>>& seams,
+                   LineGraph* ret) const {
+  for (auto& tg : *tgs) ret->absorb(&tg);
+
+  util::geo::RTree<size_t, util::geo::Point, double> idx;
+  std::vector<std::pair<LineNode*, size_t>> cands;
+
+  for (size_t i = 0; i < seams.size(); i++) {
+    for (auto nd : seams[i]) {
+      idx.add(*nd->pl().getGeom(), cands.size());
+      cands.push_back({nd, i});
+    }
+  }
+
+  std::vector<char> gone(cands.size(), 0);
+
+  for (size_t i = 0; i < cands.size(); i++) {
+    std::set<size_t> near;
+    idx.get(*cands[i].first->pl().getGeom(), _cfg->maxAggrDistance, &near);
+
+    size_t best = i;
+    double bestD = std::numeric_limits<double>::infinity();
+    for (size_t j : near) {
+      if (gone[j] || cands[j].second == cands[i].second) continue;
+      double d = util::geo::dist(*cands[i].first->pl().getGeom(),
+                                 *cands[j].first->pl().getGeom());
+      if (d < bestD) {
+        best = j;
+        bestD = d;
+      }
+    }
+
+    if (best == i) continue;
+
+    merge(cands[i].first, cands[best].first, ret);
+    gone[i] = 1;
+  }
+}
+
+// _____________________________________________________________________________
+void Tiler::merge(LineNode* a, LineNode* b, LineGraph* g) {
+  std::unordered_map<const LineEdge*, LineEdge*> rpl;
+  std::vector<LineEdge*> adj(a->getAdjList().begin(), a->getAdjList().end());
+
+  for (auto e : adj) {
+    auto* other = e->getOtherNd(a);
+    if (other == b) continue;
+
+    auto* ex = g->getEdg(b, other);
+    if (ex) {
+      for (auto lo : e->pl().getLines()) {
+        if (lo.direction == a) lo.direction = b;
+        if (!ex->pl().hasLine(lo.line)) ex->pl().addLine(lo.line, lo.direction);
+      }
+      rpl[e] = ex;
+    } else {
+      // the edge now ends at b
+      auto pl = e->pl();
+      auto geom = *pl.getGeom();
+      if (e->getFrom() == a)
+        geom.front() = *b->pl().getGeom();
+      else
+        geom.back() = *b->pl().getGeom();
+      pl.setGeom(geom);
+
+      auto* newE = e->getFrom() == a ? g->addEdg(b, other, pl)
+                                     : g->addEdg(other, b, pl);
+      LineGraph::nodeRpl(newE, a, b);
+      rpl[e] = newE;
+    }
+
+    LineGraph::edgeRpl(other, e, rpl[e]);
+  }
+
+  for (const auto& l : a->pl().getConnExc()) {
+    for (const auto& fr : l.second) {
+      for (auto to : fr.second) {
+        if (!rpl.count(fr.first) || !rpl.count(to)) continue;
+        b->pl().addConnExc(l.first, rpl[fr.first], rpl[to]);
+      }
+    }
+  }
+
+  if (a->pl().stops().size()) {
+    for (const auto& st : a->pl().stops()) b->pl().addStop(st);
+    for (auto l : a->pl().getLinesNotServed()) b->pl().addLineNotServed(l);
+  }
+
+  g->delNd(a);
+}
@@ -0,0 +1,83 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TOPO_TILER_TILER_H_
+#define TOPO_TILER_TILER_H_
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "shared/linegraph/LineGraph.h"
+#include "topo/config/TopoConfig.h"
+#include "util/geo/Geo.h"
+
+namespace topo {
+
+// a square tile of the grid laid over a graph
+struct Tile {
+  int64_t x, y;
+  util::geo::DBox core;
+};
+
+// Cuts a large graph into square tiles which can be topologized
+// independently. Each tile is processed together with all input edges
+// within an overlap band around it, but only keeps the result edges whose
+// midpoint lies in the tile itself. The tile results are then stitched at
+// the nodes which lost edges to a neighbouring tile.
+class Tiler {
+ public:
+  Tiler(const config::TopoConfig* cfg, const shared::linegraph::LineGraph* g);
+
+  // the tiles of the graph, row by row, tiles without any input edge in
+  // their overlap are skipped
+  std::vector<Tile> tiles() const;
+
+  // the number of input edges cut() copies into tile t
+  size_t numEdgs(const Tile& t) const;
+
+  // copy all input edges which come within the overlap of tile t and their
+  // nodes into the empty graph tg
+  void cut(const Tile& t, shared::linegraph::LineGraph* tg) const;
+
+  // remove all edges from the processed tile graph tg which are not owned
+  // by t, returns the remaining nodes which lost an edge
+  std::vector<shared::linegraph::LineNode*> clip(
+      const Tile& t, shared::linegraph::LineGraph* tg) const;
+
+  // move the processed and clipped tile graphs into ret, and merge each seam
+  // node into the nearest seam node of another tile within the max
+  // aggregation distance
+  void stitch(std::vector<shared::linegraph::LineGraph>* tgs,
+              const std::vector<std::vector<shared::linegraph::LineNode*>>&
+                  seams,
+              shared::linegraph::LineGraph* ret) const;
+
+ private:
+  const config::TopoConfig* _cfg;
+  const shared::linegraph::LineGraph* _g;
+  util::geo::DPoint _origin;
+
+  // the input edges within the overlap of each tile, and the unconnected
+  // nodes in each tile, by row
+  std::map<std::pair<int64_t, int64_t>,
+           std::vector<const shared::linegraph::LineEdge*>>
+      _tileEdgs;
+  std::map<std::pair<int64_t, int64_t>,
+           std::vector<const shared::linegraph::LineNode*>>
+      _tileNds;
+
+  std::pair<int64_t, int64_t> tileOf(const util::geo::DPoint& p) const;
+  util::geo::DBox coreBox(int64_t x, int64_t y) const;
+
+  // move all edges of a onto b and delete a
+  static void merge(shared::linegraph::LineNode* a,
+                    shared::linegraph::LineNode* b,
+                    shared::linegraph::LineGraph* g);
+};
+
+}  // namespace topo
+
+#endif  // TOPO_TILER_TILER_H_
@@ -7,6 +7,7 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <set>
 #include <string>
 #include "shared/linegraph/LineGraph.h"
@@ -16,6 +17,13 @@
 #include "util/graph/EDijkstra.h"
 #include "util/log/Log.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_num_procs() 1
+#define omp_set_num_threads(x) (void)(x)
+#endif
+
 std::vector<shared::linegraph::LineNode*> gtNds;
 std::vector<std::string> gtStations;
 
@@ -25,6 +33,19 @@ util::geo::Grid<topoeval::DirLineNode*, Point, double> gtGrid;
 std::unordered_map<std::string, std::set<topoeval::DirLineNode*>> stationsGt;
 std::unordered_map<std::string, std::set<topoeval::DirLineNode*>> stationsTest;
 
+// the globals above are only read during sampling, which runs in parallel
+
+// _____________________________________________________________________________
+const std::set<topoeval::DirLineNode*>& getStatNds(
+    const std::unordered_map<std::string, std::set<topoeval::DirLineNode*>>&
+        stations,
+    const std::string& stat) {
+  static const std::set<topoeval::DirLineNode*> empty;
+  auto it = stations.find(stat);
+  if (it == stations.end()) return empty;
+  return it->second;
+}
+
 struct CostFunc
     : public util::graph::EDijkstra::CostFunc<topoeval::DirLineNodePL,
                                               topoeval::DirLineEdgePL, double> {
@@ -165,19 +186,19 @@ std::pair<std::pair<std::set<topoeval::DirLineNode*>,
                     std::set<topoeval::DirLineNode*>>,
           std::pair<std::set<topoeval::DirLineNode*>,
                     std::set<topoeval::DirLineNode*>>>
-getFromToCandsStat() {
+getFromToCandsStat(std::mt19937* rng) {
   std::pair<std::pair<std::set<topoeval::DirLineNode*>,
                       std::set<topoeval::DirLineNode*>>,
             std::pair<std::set<topoeval::DirLineNode*>,
                       std::set<topoeval::DirLineNode*>>>
       ret;
-  auto fromStat = gtStations[rand() % gtStations.size()];
-  auto toStat = gtStations[rand() % gtStations.size()];
+  const auto& fromStat = gtStations[(*rng)() % gtStations.size()];
+  const auto& toStat = gtStations[(*rng)() % gtStations.size()];
 
-  ret.first.first = stationsGt[fromStat];
-  ret.first.second = stationsGt[toStat];
-  ret.second.first = stationsTest[fromStat];
-  ret.second.second = stationsTest[toStat];
+  ret.first.first = getStatNds(stationsGt, fromStat);
+  ret.first.second = getStatNds(stationsGt, toStat);
+  ret.second.first = getStatNds(stationsTest, fromStat);
+  ret.second.second = getStatNds(stationsTest, toStat);
 
   return ret;
 }
@@ -187,14 +208,14 @@ std::pair<std::pair<std::set<topoeval::DirLineNode*>,
                     std::set<topoeval::DirLineNode*>>,
           std::pair<std::set<topoeval::DirLineNode*>,
                     std::set<topoeval::DirLineNode*>>>
-getFromToCands(double d) {
+getFromToCands(double d, std::mt19937* rng) {
   std::pair<std::pair<std::set<topoeval::DirLineNode*>,
                       std::set<topoeval::DirLineNode*>>,
             std::pair<std::set<topoeval::DirLineNode*>,
                       std::set<topoeval::DirLineNode*>>>
       ret;
-  auto from = gtNds[rand() % gtNds.size()];
-  auto to = gtNds[rand() % gtNds.size()];
+  auto from = gtNds[(*rng)() % gtNds.size()];
+  auto to = gtNds[(*rng)() % gtNds.size()];
 
   std::set<topoeval::DirLineNode*> testNeighsFr;
   std::set<topoeval::DirLineNode*> testNeighsTo;
@@ -256,6 +277,8 @@ int main(int argc, char** argv) {
 
   double d = 150;
   size_t SAMPLES = 10000;
+  size_t threads = omp_get_num_procs();
+  unsigned seed = rand();
 
   bool fromStations = false;
 
@@ -266,6 +289,7 @@ int main(int argc, char** argv) {
     if (cur == "-h" || cur == "--help") {
       std::cerr << "Usage: " << argv[0]
                 << "[-d <maxdist=150>] [-s <numsamples=10000>] "
+                   "[-t <threads>] [--seed <seed>] "
                    "[--sample-stations] <ground truth "
                    "graph> <test graph>"
                 << std::endl;
@@ -284,6 +308,18 @@ int main(int argc, char** argv) {
         exit(1);
       }
       SAMPLES = atoi(argv[i]);
+    } else if (cur == "-t") {
+      if (++i >= argc) {
+        LOG(ERROR) << "Missing argument for threads (-t).";
+        exit(1);
+      }
+      threads = std::max(1, atoi(argv[i]));
+    } else if (cur == "--seed") {
+      if (++i >= argc) {
+        LOG(ERROR) << "Missing argument for seed (--seed).";
+        exit(1);
+      }
+      seed = atoi(argv[i]);
     } else {
       if (gtPath.empty())
         gtPath = cur;
@@ -347,14 +383,15 @@ int main(int argc, char** argv) {
     }
   }
 
+  // cells of the candidate search radius, a query touches at most 4 cells
   testGrid = util::geo::Grid<topoeval::DirLineNode*, Point, double>(
-      120, 120, testGraph.getBBox());
+      d, d, testGraph.getBBox());
   for (auto nd : testDirGraph.getNds()) {
     testGrid.add(*nd->pl().getGeom(), nd);
   }
 
   gtGrid = util::geo::Grid<topoeval::DirLineNode*, Point, double>(
-      120, 120, gtGraph.getBBox());
+      d, d, gtGraph.getBBox());
   for (auto nd : gtDirGraph.getNds()) {
     gtGrid.add(*nd->pl().getGeom(), nd);
   }
@@ -391,7 +428,15 @@ int main(int argc, char** argv) {
   double maxFrech = 0;
   double frechAvg = 0;
 
+  omp_set_num_threads(threads);
+
+  // samples are independent, each draws from its own generator so the result
+  // for a fixed seed does not depend on the number of threads
+#pragma omp parallel for schedule(dynamic) reduction(+ : match, unmatch, \
+                                                     frechAvg)            \
+    reduction(min : minFrech) reduction(max : maxFrech)
   for (size_t i = 0; i < SAMPLES; i++) {
+    std::mt19937 rng(seed + i);
     std::vector<const shared::linegraph::Line*> lines;
     std::set<const shared::linegraph::Line*> linesSet;
 
@@ -402,9 +447,9 @@ int main(int argc, char** argv) {
         cands;
 
     if (fromStations)
-      cands = getFromToCandsStat();
+      cands = getFromToCandsStat(&rng);
     else
-      cands = getFromToCands(d);
+      cands = getFromToCands(d, &rng);
 
     auto gtFr = cands.first.first;
     auto gtTo = cands.first.second;
@@ -432,7 +477,7 @@ int main(int argc, char** argv) {
       }
     }
 
-    auto gtLine = lines[rand() % lines.size()];
+    auto gtLine = lines[rng() % lines.size()];
     CostFunc cFuncGt(gtLine);
 
     util::graph::EList<topoeval::DirLineNodePL, topoeval::DirLineEdgePL>*
@@ -448,12 +493,13 @@ int main(int argc, char** argv) {
     auto cGt = util::graph::EDijkstra::shortestPath(gtFr, gtTo, cFuncGt,
                                                     resEdges, &resNodesGt);
 
-    if (!lineMap[gtLine]) {
+    auto testLine = lineMap.find(gtLine)->second;
+    if (!testLine) {
       LOG(ERROR) << "Input line " << gtLine->id() << " (" << gtLine->label()
                  << ") not found in test data";
       exit(1);
     }
-    CostFunc cFuncTest(lineMap[gtLine]);
+    CostFunc cFuncTest(testLine);
     auto cTest = util::graph::EDijkstra::shortestPath(
         testFr, testTo, cFuncTest, &resEdgesTest, &resNodesTest);
 
@@ -474,6 +520,7 @@ int main(int argc, char** argv) {
     }
 
     double frechetDist = util::geo::frechetDist(lineTest, lineGt, 15);
+#pragma omp critical(log)
     LOG(DEBUG) << " for line " << gtLine->label() << " : " << cGt << " vs "
                << cTest << ": fr " << frechetDist;
 
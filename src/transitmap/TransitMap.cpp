@@ -0,0 +1,601 @@
+// Copyright 2016
+// University of Freiburg - Chair of Algorithms and Datastructures
+// Author: Patrick Brosi
+
+#include <getopt.h>
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "shared/io/CompressedStream.h"
+#include "shared/linegraph/BinGraph.h"
+#include "shared/rendergraph/Penalties.h"
+#include "shared/rendergraph/RenderGraph.h"
+#include "shared/threads/ThreadBudget.h"
+#include "shared/trace/Metrics.h"
+#include "shared/trace/Trace.h"
+#include "transitmap/TransitMap.h"
+#include "transitmap/config/BatchManifest.h"
+#include "transitmap/config/ConfigReader.h"
+#include "transitmap/config/TransitMapConfig.h"
+#include "transitmap/graph/GraphBuilder.h"
+#include "transitmap/label/Labeller.h"
+#include "transitmap/output/DisplayList.h"
+#include "transitmap/output/FgbRenderer.h"
+#include "transitmap/output/MvtRenderer.h"
+#include "transitmap/output/PngRenderer.h"
+#include "transitmap/output/SvgRenderer.h"
+#include "util/Misc.h"
+#include "util/log/Log.h"
+
+using shared::linegraph::Line;
+using shared::linegraph::LineGraph;
+using shared::rendergraph::RenderGraph;
+using transitmapper::config::BatchMap;
+using transitmapper::config::Config;
+using transitmapper::graph::GraphBuilder;
+using transitmapper::label::Labeller;
+using transitmapper::output::DisplayListParams;
+
+namespace {
+// _____________________________________________________________________________
+void renderMvt(const transitmapper::config::Config* cfg, const LineGraph& lg) {
+#ifdef PROTOBUF_FOUND
+  std::unique_ptr<transitmapper::output::PmTilesWriter> archive;
+  if (!cfg->mvtArchivePath.empty()) {
+    archive.reset(
+        new transitmapper::output::PmTilesWriter(cfg->mvtArchivePath));
+  }
+
+  TRACE_PHASE("render mvt");
+
+  // zoom levels are written to distinct tiles and only read the shared
+  // line graph
+#pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < cfg->mvtZooms.size(); i++) {
+    TRACE_ZONE("render mvt zoom");
+    size_t z = cfg->mvtZooms[i];
+    double lWidth = cfg->lineWidth;
+    double lSpacing = cfg->lineSpacing;
+    double lOutlineWidth = cfg->outlineWidth;
+
+    lWidth *= 156543.0 / (1 << z);
+    lSpacing *= 156543.0 / (1 << z);
+    lOutlineWidth *= 156543.0 / (1 << z);
+
+    RenderGraph g(lg, lWidth, lOutlineWidth, lSpacing);
+
+    // the builder caches per-graph state
+    GraphBuilder zb(cfg);
+
+    zb.writeNodeFronts(&g);
+    zb.expandOverlappinFronts(&g);
+
+    g.createMetaNodes();
+
+    // avoid overlapping stations
+    if (true) {
+      zb.dropOverlappingStations(&g);
+      g.contractStrayNds();
+      zb.expandOverlappinFronts(&g);
+      g.createMetaNodes();
+    }
+
+    LOGTO(DEBUG, std::cerr) << "Outputting zoom " << z << " to MVT ...";
+    transitmapper::output::MvtRenderer mvtOut(cfg, z, archive.get());
+    mvtOut.print(g);
+  }
+
+  if (archive) {
+    LOGTO(DEBUG, std::cerr) << "Writing " << archive->numTiles() << " tiles ("
+                            << archive->numContents() << " distinct) to "
+                            << cfg->mvtArchivePath;
+    archive->finish(
+        "{\"vector_layers\":["
+        "{\"id\":\"inner-connections\",\"fields\":{}},"
+        "{\"id\":\"lines\",\"fields\":{}},"
+        "{\"id\":\"stations\",\"fields\":{}}]}");
+  }
+#else
+  UNUSED(lg);
+  LOG(ERROR) << "transitmap was not compiled with protocol buffers support, "
+                "cannot use render method mvt";
+  exit(1);
+#endif
+}
+
+// _____________________________________________________________________________
+void prepareRenderGraph(const transitmapper::config::Config* cfg,
+                        RenderGraph* g) {
+  TRACE_PHASE("prepare render graph");
+  GraphBuilder b(cfg);
+
+  b.writeNodeFronts(g);
+  b.expandOverlappinFronts(g);
+  g->createMetaNodes();
+
+  if (true) {
+    b.dropOverlappingStations(g);
+    g->contractStrayNds();
+    b.expandOverlappinFronts(g);
+    g->createMetaNodes();
+  }
+}
+
+// _____________________________________________________________________________
+bool readDisplayList(const transitmapper::config::Config* cfg,
+                     const std::string& path, RenderGraph* g,
+                     Labeller* labeller) {
+  // true is returned if the stored labels can be used for this config
+  TRACE_PHASE("read display list");
+  std::ifstream f(path, std::ios::binary);
+  if (!f.good()) {
+    LOG(ERROR) << "Could not open " << path;
+    exit(1);
+  }
+
+  DisplayListParams stored;
+  try {
+    transitmapper::output::readDisplayList(&f, g, labeller, &stored);
+  } catch (const std::runtime_error& e) {
+    LOG(ERROR) << e.what();
+    exit(1);
+  }
+
+  DisplayListParams params(cfg, true);
+
+  if (!stored.sameGeom(params)) {
+    LOG(ERROR) << "Display list " << path
+               << " was computed with a different line width, line spacing, "
+                  "outline width, smoothing or station expansion, it has to "
+                  "be written again";
+    exit(1);
+  }
+
+  return stored.sameLabels(params);
+}
+
+// _____________________________________________________________________________
+void writeDisplayList(const transitmapper::config::Config* cfg,
+                      const RenderGraph& g, const Labeller* labeller) {
+  TRACE_PHASE("write display list");
+  std::ofstream f(cfg->displayListOutPath, std::ios::binary);
+  if (!f.good()) {
+    LOG(ERROR) << "Could not open " << cfg->displayListOutPath;
+    exit(1);
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Writing display list to "
+                          << cfg->displayListOutPath << " ...";
+  transitmapper::output::writeDisplayList(g, labeller,
+                                          DisplayListParams(cfg, labeller != 0),
+                                          &f);
+}
+
+// _____________________________________________________________________________
+void renderSvg(const transitmapper::config::Config* cfg, const RenderGraph& g,
+               const Labeller& labeller, const RenderGraph* backdrop,
+               std::ostream* outStr) {
+  TRACE_PHASE("render svg");
+  std::ofstream f;
+  if (!cfg->svgPath.empty()) {
+    f.open(cfg->svgPath);
+    if (!f.good()) {
+      LOG(ERROR) << "Could not open " << cfg->svgPath;
+      exit(1);
+    }
+    outStr = &f;
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Outputting to SVG ...";
+  transitmapper::output::SvgRenderer svgOut(outStr, cfg);
+  svgOut.print(g, labeller, backdrop);
+}
+
+// _____________________________________________________________________________
+void renderPng(const transitmapper::config::Config* cfg, const RenderGraph& g,
+               std::ostream* outStr) {
+  TRACE_PHASE("render png");
+  std::ofstream f;
+  if (!cfg->pngPath.empty()) {
+    f.open(cfg->pngPath, std::ios::binary);
+    if (!f.good()) {
+      LOG(ERROR) << "Could not open " << cfg->pngPath;
+      exit(1);
+    }
+    outStr = &f;
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Outputting to PNG ...";
+  transitmapper::output::PngRenderer pngOut(outStr, cfg);
+  pngOut.print(g);
+}
+
+// _____________________________________________________________________________
+void renderFgb(const transitmapper::config::Config* cfg, const RenderGraph& g,
+               std::ostream* outStr) {
+  TRACE_PHASE("render fgb");
+  std::ofstream f;
+  if (!cfg->fgbPath.empty()) {
+    f.open(cfg->fgbPath, std::ios::binary);
+    if (!f.good()) {
+      LOG(ERROR) << "Could not open " << cfg->fgbPath;
+      exit(1);
+    }
+    outStr = &f;
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Outputting to FlatGeobuf ...";
+  transitmapper::output::FgbRenderer fgbOut(outStr, cfg);
+  fgbOut.print(g);
+}
+
+// _____________________________________________________________________________
+bool hasMethod(const Config& cfg, const std::string& method) {
+  for (const auto& m : cfg.renderMethods) {
+    if (m == method) return true;
+  }
+  return false;
+}
+
+// _____________________________________________________________________________
+void readInput(const Config* cfg, std::istream* in, RenderGraph* g) {
+  TRACE_PHASE("read");
+  if (cfg->fromDot)
+    g->readFromDot(in);
+  else if (shared::linegraph::isBinGraph(in))
+    g->readFromBin(in);
+  else
+    g->readFromJson(in);
+}
+
+// _____________________________________________________________________________
+void clipInput(const Config* cfg, RenderGraph* g) {
+  if (!cfg->clip) return;
+  TRACE_PHASE("clip");
+
+  // the margin keeps the node fronts and labels near the border of the
+  // viewport as they would be in the full graph
+  double m = cfg->clipMargin /
+             util::geo::webMercDistFactor(util::geo::centroid(cfg->clipBox));
+  g->clip(util::geo::pad(cfg->clipBox, m));
+
+  LOGTO(DEBUG, std::cerr) << "Clipped graph to " << g->numNds()
+                          << " nodes and " << g->numEdgs() << " edges";
+}
+
+// _____________________________________________________________________________
+void smoothInput(const Config* cfg, RenderGraph* g) {
+  TRACE_PHASE("smooth");
+
+  // snap orphan stations
+  g->snapOrphanStations();
+
+  // contraction and smoothing do not depend on the line widths, do them
+  // once for all render methods and zoom levels
+  g->contractStrayNds();
+  g->smooth(cfg->inputSmoothing);
+}
+
+// _____________________________________________________________________________
+// true if the maps of a and b can be rendered from the same prepared graph
+bool sameGraph(const BatchMap& a, const Config& aCfg, const BatchMap& b,
+               const Config& bCfg) {
+  const auto& aBox = aCfg.clipBox;
+  const auto& bBox = bCfg.clipBox;
+  bool sameClip =
+      aCfg.clip == bCfg.clip &&
+      (!aCfg.clip ||
+       (aCfg.clipMargin == bCfg.clipMargin &&
+        aBox.getLowerLeft().getX() == bBox.getLowerLeft().getX() &&
+        aBox.getLowerLeft().getY() == bBox.getLowerLeft().getY() &&
+        aBox.getUpperRight().getX() == bBox.getUpperRight().getX() &&
+        aBox.getUpperRight().getY() == bBox.getUpperRight().getY()));
+
+  return a.input == b.input && a.lines == b.lines && a.band == b.band &&
+         sameClip &&
+         aCfg.fromDot == bCfg.fromDot &&
+         aCfg.randomColors == bCfg.randomColors &&
+         DisplayListParams(&aCfg, false)
+             .sameGeom(DisplayListParams(&bCfg, false));
+}
+
+// _____________________________________________________________________________
+int runBatch(const Config& base, int argc, char** argv, std::istream* inStr,
+             std::ostream* outStr) {
+  T_START(TIMER);
+
+  std::vector<BatchMap> maps;
+  {
+    std::ifstream f(base.batchPath);
+    if (!f.good()) {
+      LOG(ERROR) << "Could not open " << base.batchPath;
+      exit(1);
+    }
+    try {
+      maps = transitmapper::config::readBatchManifest(&f);
+    } catch (const std::runtime_error& e) {
+      LOG(ERROR) << e.what();
+      exit(1);
+    }
+  }
+
+  // each map is configured by the command line arguments of the run followed
+  // by its own, getopt has global state, so this is done up front
+  std::vector<Config> cfgs(maps.size());
+  transitmapper::config::ConfigReader cr;
+  for (size_t i = 0; i < maps.size(); i++) {
+    std::vector<std::string> strs(argv, argv + argc);
+    std::stringstream ss(maps[i].args);
+    std::string arg;
+    while (ss >> arg) strs.push_back(arg);
+    if (!maps[i].svgPath.empty())
+      strs.insert(strs.end(), {"--svg-path", maps[i].svgPath});
+    if (!maps[i].pngPath.empty())
+      strs.insert(strs.end(), {"--png-path", maps[i].pngPath});
+    if (!maps[i].fgbPath.empty())
+      strs.insert(strs.end(), {"--fgb-path", maps[i].fgbPath});
+
+    std::vector<char*> args;
+    for (auto& str : strs) args.push_back(&str[0]);
+    args.push_back(0);
+
+    optind = 0;
+    cr.read(&cfgs[i], args.size() - 1, args.data());
+
+    if (hasMethod(cfgs[i], "mvt")) {
+      LOG(ERROR) << "Map " << i << " of " << base.batchPath
+                 << ": render method mvt cannot be used in batches";
+      exit(1);
+    }
+
+    if ((hasMethod(cfgs[i], "svg") && cfgs[i].svgPath.empty()) ||
+        (hasMethod(cfgs[i], "png") && cfgs[i].pngPath.empty()) ||
+        (hasMethod(cfgs[i], "fgb") && cfgs[i].fgbPath.empty())) {
+      LOG(ERROR) << "Map " << i << " of " << base.batchPath
+                 << " has no output path for each of its render methods";
+      exit(1);
+    }
+  }
+
+  // every input is read once, the maps parse their graph from memory
+  std::map<std::string, std::string> inputs;
+  for (const auto& m : maps) {
+    if (inputs.count(m.input)) continue;
+    std::stringstream buf;
+    if (m.input.empty()) {
+      buf << inStr->rdbuf();
+    } else {
+      std::ifstream f(m.input, std::ios::binary);
+      if (!f.good()) {
+        LOG(ERROR) << "Could not open " << m.input;
+        exit(1);
+      }
+      buf << f.rdbuf();
+    }
+    inputs[m.input] = buf.str();
+  }
+
+  // backdrops are read once for all maps drawing them
+  std::vector<std::pair<size_t, std::unique_ptr<RenderGraph>>> backdrops;
+  std::vector<const RenderGraph*> mapBackdrop(maps.size(), 0);
+  for (size_t i = 0; i < maps.size(); i++) {
+    const auto& cfg = cfgs[i];
+    if (cfg.backdropPath.empty() || !hasMethod(cfg, "svg")) continue;
+
+    for (const auto& bd : backdrops) {
+      const auto& bdCfg = cfgs[bd.first];
+      if (bdCfg.backdropPath == cfg.backdropPath &&
+          DisplayListParams(&bdCfg, false)
+              .sameGeom(DisplayListParams(&cfg, false))) {
+        mapBackdrop[i] = bd.second.get();
+        break;
+      }
+    }
+    if (mapBackdrop[i]) continue;
+
+    backdrops.emplace_back(
+        i, new RenderGraph(cfg.lineWidth, cfg.outlineWidth, cfg.lineSpacing));
+    Labeller unused(&cfg);
+    readDisplayList(&cfg, cfg.backdropPath, backdrops.back().second.get(),
+                    &unused);
+    mapBackdrop[i] = backdrops.back().second.get();
+  }
+
+  // maps of the same lines with the same geometry share a prepared graph
+  std::vector<std::vector<size_t>> groups;
+  for (size_t i = 0; i < maps.size(); i++) {
+    bool found = false;
+    for (auto& grp : groups) {
+      if (sameGraph(maps[grp.front()], cfgs[grp.front()], maps[i], cfgs[i])) {
+        grp.push_back(i);
+        found = true;
+        break;
+      }
+    }
+    if (!found) groups.push_back({i});
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Rendering " << maps.size() << " maps from "
+                          << groups.size() << " prepared graphs...";
+
+#pragma omp parallel for schedule(dynamic)
+  for (size_t gi = 0; gi < groups.size(); gi++) {
+    TRACE_ZONE("batch graph");
+    const auto& grp = groups[gi];
+    const auto& m = maps[grp.front()];
+    const auto* cfg = &cfgs[grp.front()];
+
+    RenderGraph g(cfg->lineWidth, cfg->outlineWidth, cfg->lineSpacing);
+    std::istringstream in(inputs.at(m.input));
+    readInput(cfg, &in, &g);
+
+    if (m.lines.size() || m.band.size()) {
+      std::set<const Line*> lines;
+      for (auto nd : g.getNds()) {
+        for (auto e : nd->getAdjList()) {
+          for (const auto& lo : e->pl().getLines()) {
+            if (m.lines.size() && !m.lines.count(lo.line->id()) &&
+                !m.lines.count(lo.line->label())) {
+              continue;
+            }
+            if (m.band.size()) {
+              auto b = lo.line->bands().find(m.band);
+              if (b == lo.line->bands().end() || b->second == 0) continue;
+            }
+            lines.insert(lo.line);
+          }
+        }
+      }
+      if (lines.empty()) {
+        LOG(WARN) << "None of the lines of map " << grp.front() << " of "
+                  << base.batchPath << " are in the input";
+      }
+      g.keepLines(lines);
+    }
+
+    clipInput(cfg, &g);
+
+    if (cfg->randomColors) g.fillMissingColors();
+
+    smoothInput(cfg, &g);
+    prepareRenderGraph(cfg, &g);
+
+    for (size_t i : grp) {
+      const auto* mCfg = &cfgs[i];
+      Labeller labeller(mCfg);
+      if (mCfg->renderLabels && hasMethod(*mCfg, "svg")) {
+        TRACE_PHASE("label");
+        labeller.label(g, mCfg->dontLabelDeg2);
+      }
+
+      for (const auto& method : mCfg->renderMethods) {
+        if (method == "svg")
+          renderSvg(mCfg, g, labeller, mapBackdrop[i], outStr);
+        if (method == "png") renderPng(mCfg, g, outStr);
+        if (method == "fgb") renderFgb(mCfg, g, outStr);
+      }
+
+      LOGTO(DEBUG, std::cerr) << "Rendered map " << i << ".";
+    }
+  }
+
+  double took = T_STOP(TIMER);
+
+  if (base.writeStats) {
+    util::json::Writer wr(outStr);
+    wr.obj();
+    wr.keyVal("time", took);
+    wr.closeAll();
+  }
+
+  return 0;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+int transitmapper::run(int argc, char** argv, std::istream* inStr,
+                       std::ostream* outStr) {
+  transitmapper::config::Config cfg;
+
+  transitmapper::config::ConfigReader cr;
+  cr.read(&cfg, argc, argv);
+
+  shared::threads::setBudget(cfg.threadBudget);
+
+  shared::trace::Trace::open(cfg.tracePath, "transitmap");
+  shared::trace::Metrics::open(cfg.metricsPath, "transitmap");
+
+  shared::io::CompressedIn zIn(&inStr);
+  shared::io::CompressedOut zOut(cfg.compress, cfg.threadBudget, &outStr);
+
+  if (!cfg.batchPath.empty()) return runBatch(cfg, argc, argv, inStr, outStr);
+
+  T_START(TIMER);
+
+  bool svg = false, png = false, fgb = false;
+  for (const auto& method : cfg.renderMethods) {
+    if (method == "svg") svg = true;
+    if (method == "png") png = true;
+    if (method == "fgb") fgb = true;
+  }
+
+  // the graph is read and prepared once for all render methods
+  RenderGraph g(cfg.lineWidth, cfg.outlineWidth, cfg.lineSpacing);
+  Labeller labeller(&cfg);
+  bool labelled = false;
+
+  if (!cfg.displayListInPath.empty()) {
+    // the display list holds an already prepared graph
+    LOGTO(DEBUG, std::cerr) << "Reading display list...";
+    labelled = readDisplayList(&cfg, cfg.displayListInPath, &g, &labeller);
+  } else {
+    LOGTO(DEBUG, std::cerr) << "Reading graph...";
+    readInput(&cfg, inStr, &g);
+
+    shared::trace::Metrics::count("nodes", g.numNds());
+    shared::trace::Metrics::count("edges", g.numEdgs());
+    shared::trace::Metrics::count("lines", g.numLines());
+
+    clipInput(&cfg, &g);
+
+    if (cfg.randomColors) g.fillMissingColors();
+
+    smoothInput(&cfg, &g);
+
+    // the MVT zoom levels work on copies, the SVG, PNG and FlatGeobuf
+    // outputs share a prepared graph which modifies g, so they come last
+    for (const auto& method : cfg.renderMethods) {
+      if (method == "mvt") renderMvt(&cfg, g);
+    }
+
+    if (svg || png || fgb || !cfg.displayListOutPath.empty())
+      prepareRenderGraph(&cfg, &g);
+  }
+
+  // labels are only written to SVG, but stored in display lists
+  if (cfg.renderLabels && !labelled &&
+      (svg || !cfg.displayListOutPath.empty())) {
+    TRACE_PHASE("label");
+    LOGTO(DEBUG, std::cerr) << "Rendering labels...";
+    labeller.label(g, cfg.dontLabelDeg2);
+    labelled = true;
+  }
+
+  if (!cfg.displayListOutPath.empty())
+    writeDisplayList(&cfg, g, labelled ? &labeller : 0);
+
+  // the backdrop was prepared once for many maps, its labels are not drawn
+  std::unique_ptr<RenderGraph> backdrop;
+  if (svg && !cfg.backdropPath.empty()) {
+    LOGTO(DEBUG, std::cerr) << "Reading backdrop...";
+    backdrop.reset(
+        new RenderGraph(cfg.lineWidth, cfg.outlineWidth, cfg.lineSpacing));
+    Labeller unused(&cfg);
+    readDisplayList(&cfg, cfg.backdropPath, backdrop.get(), &unused);
+  }
+
+  for (const auto& method : cfg.renderMethods) {
+    if (method == "svg") renderSvg(&cfg, g, labeller, backdrop.get(), outStr);
+    if (method == "png") renderPng(&cfg, g, outStr);
+    if (method == "fgb") renderFgb(&cfg, g, outStr);
+  }
+
+  double took = T_STOP(TIMER);
+
+  if (cfg.writeStats) {
+    util::json::Writer wr(outStr);
+    wr.obj();
+    wr.keyVal("time", took);
+    wr.closeAll();
+  }
+
+  return (0);
+}
@@ -0,0 +1,18 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_TRANSITMAP_H_
+#define TRANSITMAP_TRANSITMAP_H_
+
+#include <iostream>
+
+namespace transitmapper {
+
+// Run transitmap with the given command line arguments. The input line
+// graph is read from inStr, the SVG map is written to outStr.
+int run(int argc, char** argv, std::istream* inStr, std::ostream* outStr);
+
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_TRANSITMAP_H_
@@ -0,0 +1,78 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "3rdparty/json.hpp"
+#include "transitmap/config/BatchManifest.h"
+
+using transitmapper::config::BatchMap;
+
+namespace {
+// _____________________________________________________________________________
+std::string getStr(const nlohmann::json& obj, const std::string& key,
+                   const std::string& def) {
+  auto it = obj.find(key);
+  if (it == obj.end()) return def;
+  if (!it->is_string()) {
+    throw std::runtime_error("Batch manifest: \"" + key +
+                             "\" is not a string");
+  }
+  return it->get<std::string>();
+}
+}  // namespace
+
+// _____________________________________________________________________________
+std::vector<BatchMap> transitmapper::config::readBatchManifest(
+    std::istream* s) {
+  nlohmann::json man;
+  try {
+    man = nlohmann::json::parse(*s);
+  } catch (const nlohmann::json::exception& e) {
+    throw std::runtime_error(std::string("Batch manifest: ") + e.what());
+  }
+
+  if (!man.is_object() || !man["maps"].is_array()) {
+    throw std::runtime_error("Batch manifest: no \"maps\" array");
+  }
+
+  std::string input = getStr(man, "input", "");
+
+  std::vector<BatchMap> ret;
+  for (const auto& m : man["maps"]) {
+    if (!m.is_object()) {
+      throw std::runtime_error("Batch manifest: map " +
+                               std::to_string(ret.size()) +
+                               " is not an object");
+    }
+
+    BatchMap bm;
+    bm.input = getStr(m, "input", input);
+    bm.svgPath = getStr(m, "svg", "");
+    bm.pngPath = getStr(m, "png", "");
+    bm.fgbPath = getStr(m, "fgb", "");
+    bm.args = getStr(m, "args", "");
+    bm.band = getStr(m, "band", "");
+
+    auto lines = m.find("lines");
+    if (lines != m.end()) {
+      if (!lines->is_array()) {
+        throw std::runtime_error("Batch manifest: \"lines\" is not an array");
+      }
+      for (const auto& l : *lines) {
+        if (!l.is_string()) {
+          throw std::runtime_error("Batch manifest: line " + l.dump() +
+                                   " is not a string");
+        }
+        bm.lines.insert(l.get<std::string>());
+      }
+    }
+
+    ret.push_back(bm);
+  }
+
+  return ret;
+}
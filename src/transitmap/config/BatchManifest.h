@@ -0,0 +1,57 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_CONFIG_BATCHMANIFEST_H_
+#define TRANSITMAP_CONFIG_BATCHMANIFEST_H_
+
+#include <istream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace transitmapper {
+namespace config {
+
+// A batch manifest lists maps rendered by a single transitmap run:
+//
+//   {
+//     "input": "graph.json",
+//     "maps": [
+//       {"lines": ["1", "2"], "svg": "1-2.svg"},
+//       {"lines": ["1"], "svg": "1-kn.svg", "args": "--svg-lang kn"},
+//       {"input": "other.json", "png": "other.png"},
+//       {"fgb": "all.fgb", "args": "--render-engine fgb"},
+//       {"band": "am", "svg": "am.svg"}
+//     ]
+//   }
+//
+// The top-level input is the default of all maps, without any input the
+// graph is read from the input stream. The args of a map are added to the
+// command line arguments of the run. A map with a band only draws the lines
+// with trips in this time band (see gtfs2graph --bands).
+struct BatchMap {
+  // empty for the input stream
+  std::string input;
+
+  // IDs or labels of the lines to render, empty for all lines
+  std::set<std::string> lines;
+
+  // time band of the lines to render, empty for all lines
+  std::string band;
+
+  std::string svgPath;
+  std::string pngPath;
+  std::string fgbPath;
+
+  // space separated transitmap arguments
+  std::string args;
+};
+
+// read a batch manifest, throws std::runtime_error on invalid input
+std::vector<BatchMap> readBatchManifest(std::istream* s);
+
+}  // namespace config
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_CONFIG_BATCHMANIFEST_H_
@@ -5,10 +5,12 @@
 #include <float.h>
 #include <getopt.h>
 
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <string>
 
+#include "shared/io/CompressedStream.h"
 #include "transitmap/_config.h"
 #include "transitmap/config/ConfigReader.h"
 #include "util/String.h"
@@ -40,12 +42,26 @@ void ConfigReader::help(const char* bin) const {
             << "show this help message\n"
             << std::setw(37) << "  --render-engine arg (=svg)"
 #ifdef PROTOBUF_FOUND
-            << "Render engine, either 'svg' or 'mvt'\n"
+            << "Render engines, 'svg', 'png', 'fgb', 'mvt', comma sep.\n"
 #else
-            << "Render engine, only 'svg' supported\n"
+            << "Render engines, 'svg', 'png', 'fgb', comma sep.\n"
 #endif
             << std::setw(37) << "  --line-width arg (=20)"
             << "width of a single transit line\n"
+            << std::setw(37) << "  --svg-path arg"
+            << "write the SVG to this file, not to stdout\n"
+            << std::setw(37) << "  --svg-compact"
+            << "write styles, shapes and paths compactly\n"
+            << std::setw(37) << "  --svg-layers"
+            << "group the SVG into named Inkscape layers\n"
+            << std::setw(37) << "  --svg-lang arg"
+            << "xml:lang of the SVG and station labels\n"
+            << std::setw(37) << "  --png-path arg"
+            << "write the PNG to this file, not to stdout\n"
+            << std::setw(37) << "  --png-dpi arg (=96)"
+            << "PNG resolution, 96 is one pixel per SVG pixel\n"
+            << std::setw(37) << "  --fgb-path arg"
+            << "write the FlatGeobuf to this file, not to stdout\n"
             << std::setw(37) << "  --line-spacing arg (=10)"
             << "spacing between transit lines\n"
             << std::setw(37) << "  --outline-width arg (=1)"
@@ -54,6 +70,14 @@ void ConfigReader::help(const char* bin) const {
             << "render line direction markers\n"
             << std::setw(37) << "  -l [ --labels ]"
             << "render labels\n"
+            << std::setw(37) << "  --no-labels"
+            << "don't render labels, overrides -l\n"
+            << std::setw(37) << "  --station-label-font arg"
+            << "station label font family (=Ubuntu Condensed)\n"
+            << std::setw(37) << "  --line-label-font arg (=Ubuntu)"
+            << "line label font family\n"
+            << std::setw(37) << "  --label-text-scale arg (=1)"
+            << "scale written label font sizes\n"
             << std::setw(37) << "  --line-label-textsize arg (=40)"
             << "textsize for line labels\n"
             << std::setw(37) << "  --station-label-textsize arg (=60)"
@@ -62,11 +86,23 @@ void ConfigReader::help(const char* bin) const {
             << "no labels for deg-2 stations\n"
             << std::setw(37) << "  --no-deg3-labels"
             << "no labels for deg-3 stations\n"
+            << std::setw(37) << "  --focus-stations arg"
+            << "label tiers around these station IDs, comma sep.\n"
+            << std::setw(37) << "  --tier-distances arg"
+            << "tier 1-3 focus station distances (=500,1500,3000)\n"
+            << std::setw(37) << "  --tier-min-routes arg (=3,5)"
+            << "min routes of tier 2, 3 stations\n"
+            << std::setw(37) << "  --tier-label-scales arg"
+            << "tier 1-3 label size scales (=1,0.85,0.7)\n"
 #ifdef PROTOBUF_FOUND
             << std::setw(37) << "  -z [ --zoom ] (=14)"
             << "zoom level to write for MVT tiles, comma separated or range\n"
             << std::setw(37) << "  --mvt-path (=.)"
-            << "path for MVT tiles\n\n"
+            << "path for MVT tiles\n"
+            << std::setw(37) << "  --max-data-zoom arg (=-1)"
+            << "no MVT tiles above this zoom, clients overzoom\n"
+            << std::setw(37) << "  --mvt-pmtiles arg"
+            << "write MVT tiles into a single PMTiles archive\n\n"
 #endif
             << "Misc:\n"
             << std::setw(37) << "  -D [ --from-dot ]"
@@ -75,6 +111,24 @@ void ConfigReader::help(const char* bin) const {
             << "padding, -1 for auto\n"
             << std::setw(37) << "  --smoothing arg (=1)"
             << "input line smoothing\n"
+            << std::setw(37) << "  --emit-display-list arg"
+            << "also write geometry and labels to this file\n"
+            << std::setw(37) << "  --from-display-list arg"
+            << "restyle a display list instead of reading input\n"
+            << std::setw(37) << "  --backdrop arg"
+            << "draw this display list under the SVG output\n"
+            << std::setw(37) << "  --backdrop-opacity arg (=0.15)"
+            << "opacity of the backdrop\n"
+            << std::setw(37) << "  --batch arg"
+            << "render all maps of this JSON manifest\n"
+            << std::setw(37) << "  --bbox arg"
+            << "only render minlng,minlat,maxlng,maxlat\n"
+            << std::setw(37) << "  --center arg"
+            << "only render lng,lat with --radius\n"
+            << std::setw(37) << "  --radius arg"
+            << "radius around --center in meters\n"
+            << std::setw(37) << "  --clip-margin arg (=250)"
+            << "also prepare the graph this many meters around\n"
             << std::setw(37) << "  --random-colors"
             << "fill missing colors with random colors\n"
             << std::setw(37) << "  --no-render-stations"
@@ -87,8 +141,18 @@ void ConfigReader::help(const char* bin) const {
             << "don't render inner node connections\n"
             << std::setw(37) << "  --render-node-fronts"
             << "render node fronts\n"
+            << std::setw(37) << "  --svg-spill-size arg (=256)"
+            << "max edge geometry MB kept in memory, 0 = no limit\n"
             << std::setw(37) << "  --print-stats"
-            << "write stats to stdout\n";
+            << "write stats to stdout\n"
+            << std::setw(37) << "  --compress arg (=none)"
+            << "compress stdout output, either none, gzip or zstd\n"
+            << std::setw(37) << "  --trace arg"
+            << "write a Chrome trace of the run to this file\n"
+            << std::setw(37) << "  --metrics-out arg"
+            << "write per-phase resource usage to this JSON file\n"
+            << std::setw(37) << "  -t [ --threads ] arg (=0)"
+            << "max threads used, 0 means all cores\n";
 }
 
 // _____________________________________________________________________________
@@ -117,12 +181,46 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
                          {"mvt-path", required_argument, 0, 17},
                          {"random-colors", no_argument, 0, 18},
                          {"print-stats", no_argument, 0, 19},
+                         {"svg-spill-size", required_argument, 0, 21},
+                         {"mvt-pmtiles", required_argument, 0, 22},
+                         {"svg-path", required_argument, 0, 23},
+                         {"png-path", required_argument, 0, 24},
+                         {"png-dpi", required_argument, 0, 25},
+                         {"svg-compact", no_argument, 0, 26},
+                         {"station-label-font", required_argument, 0, 27},
+                         {"line-label-font", required_argument, 0, 28},
+                         {"svg-lang", required_argument, 0, 29},
+                         {"label-text-scale", required_argument, 0, 30},
+                         {"svg-layers", no_argument, 0, 31},
+                         {"trace", required_argument, 0, 32},
+                         {"metrics-out", required_argument, 0, 33},
+                         {"threads", required_argument, 0, 't'},
+                         {"max-data-zoom", required_argument, 0, 34},
+                         {"emit-display-list", required_argument, 0, 35},
+                         {"from-display-list", required_argument, 0, 36},
+                         {"backdrop", required_argument, 0, 37},
+                         {"backdrop-opacity", required_argument, 0, 38},
+                         {"batch", required_argument, 0, 39},
+                         {"focus-stations", required_argument, 0, 40},
+                         {"tier-distances", required_argument, 0, 41},
+                         {"tier-min-routes", required_argument, 0, 42},
+                         {"tier-label-scales", required_argument, 0, 43},
+                         {"bbox", required_argument, 0, 44},
+                         {"center", required_argument, 0, 45},
+                         {"radius", required_argument, 0, 46},
+                         {"clip-margin", required_argument, 0, 47},
+                         {"compress", required_argument, 0, 48},
+                         {"fgb-path", required_argument, 0, 49},
+                         {"no-labels", no_argument, 0, 50},
                          {0, 0, 0, 0}};
 
   std::string zoom;
+  bool noLabels = false;
+  std::string bbox, center;
+  double radius = -1;
 
   int c;
-  while ((c = getopt_long(argc, argv, ":hvlDz:", ops, 0)) != -1) {
+  while ((c = getopt_long(argc, argv, ":hvlDz:t:", ops, 0)) != -1) {
     switch (c) {
       case 'h':
         help(argv[0]);
@@ -131,7 +229,19 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
         std::cout << "transitmap - (LOOM " << VERSION_FULL << ")" << std::endl;
         exit(0);
       case 1:
-        cfg->renderMethod = optarg;
+        cfg->renderMethods.clear();
+        for (const auto& method : util::split(optarg, ',')) {
+          if (method != "svg" && method != "png" && method != "fgb" &&
+              method != "mvt") {
+            std::cerr << "Error: unknown render engine " << method
+                      << std::endl;
+            exit(1);
+          }
+          if (std::find(cfg->renderMethods.begin(), cfg->renderMethods.end(),
+                        method) == cfg->renderMethods.end()) {
+            cfg->renderMethods.push_back(method);
+          }
+        }
         break;
       case 2:
         cfg->lineWidth = atof(optarg);
@@ -190,12 +300,118 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
       case 19:
         cfg->writeStats = true;
         break;
+      case 21:
+        cfg->svgSpillSize = atol(optarg);
+        break;
+      case 22:
+        cfg->mvtArchivePath = optarg;
+        break;
+      case 23:
+        cfg->svgPath = optarg;
+        break;
+      case 24:
+        cfg->pngPath = optarg;
+        break;
+      case 25:
+        cfg->pngDpi = atof(optarg);
+        break;
+      case 26:
+        cfg->svgCompact = true;
+        break;
+      case 27:
+        cfg->stationLabelFont = optarg;
+        break;
+      case 28:
+        cfg->lineLabelFont = optarg;
+        break;
+      case 29:
+        cfg->svgLang = optarg;
+        break;
+      case 30:
+        cfg->labelTextScale = atof(optarg);
+        break;
+      case 31:
+        cfg->svgLayers = true;
+        break;
+      case 32:
+        cfg->tracePath = optarg;
+        break;
+      case 33:
+        cfg->metricsPath = optarg;
+        break;
+      case 34:
+        cfg->mvtMaxDataZoom = atoi(optarg);
+        break;
+      case 35:
+        cfg->displayListOutPath = optarg;
+        break;
+      case 36:
+        cfg->displayListInPath = optarg;
+        break;
+      case 37:
+        cfg->backdropPath = optarg;
+        break;
+      case 38:
+        cfg->backdropOpacity = atof(optarg);
+        break;
+      case 39:
+        cfg->batchPath = optarg;
+        break;
+      case 40:
+        cfg->focusStations = util::split(optarg, ',');
+        break;
+      case 41:
+        cfg->tierDistances.clear();
+        for (const auto& d : util::split(optarg, ',')) {
+          cfg->tierDistances.push_back(atof(d.c_str()));
+        }
+        break;
+      case 42:
+        cfg->tierMinRoutes.clear();
+        for (const auto& r : util::split(optarg, ',')) {
+          cfg->tierMinRoutes.push_back(std::max(0, atoi(r.c_str())));
+        }
+        break;
+      case 43:
+        cfg->tierLabelScales.clear();
+        for (const auto& s : util::split(optarg, ',')) {
+          cfg->tierLabelScales.push_back(atof(s.c_str()));
+        }
+        break;
+      case 44:
+        bbox = optarg;
+        break;
+      case 45:
+        center = optarg;
+        break;
+      case 46:
+        radius = atof(optarg);
+        break;
+      case 47:
+        cfg->clipMargin = atof(optarg);
+        break;
+      case 48:
+        if (!shared::io::parseCodec(optarg, &cfg->compress)) {
+          std::cerr << "Unknown compression " << optarg
+                    << ", must be one of {none, gzip, zstd}" << std::endl;
+          exit(1);
+        }
+        break;
+      case 49:
+        cfg->fgbPath = optarg;
+        break;
+      case 50:
+        noLabels = true;
+        break;
       case 'D':
         cfg->fromDot = true;
         break;
       case 'z':
         zoom = optarg;
         break;
+      case 't':
+        cfg->threadBudget = std::max(0, atoi(optarg));
+        break;
       case ':':
         std::cerr << argv[optind - 1];
         std::cerr << " requires an argument" << std::endl;
@@ -212,6 +428,51 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
     }
   }
 
+  if (!shared::io::hasCodec(cfg->compress)) {
+    std::cerr << shared::io::codecName(cfg->compress)
+              << " compression was not compiled in" << std::endl;
+    exit(1);
+  }
+
+  if (noLabels) cfg->renderLabels = false;
+
+  if (cfg->renderMethods.empty()) {
+    std::cerr << "Error: no render engine given" << std::endl;
+    exit(1);
+  }
+
+  bool svg = std::find(cfg->renderMethods.begin(), cfg->renderMethods.end(),
+                       "svg") != cfg->renderMethods.end();
+  bool png = std::find(cfg->renderMethods.begin(), cfg->renderMethods.end(),
+                       "png") != cfg->renderMethods.end();
+  bool fgb = std::find(cfg->renderMethods.begin(), cfg->renderMethods.end(),
+                       "fgb") != cfg->renderMethods.end();
+
+  // batch outputs are given per map
+  size_t toStdout = (svg && cfg->svgPath.empty()) +
+                    (png && cfg->pngPath.empty()) +
+                    (fgb && cfg->fgbPath.empty());
+  if (toStdout > 1 && cfg->batchPath.empty()) {
+    std::cerr << "Error: only one of SVG, PNG and FlatGeobuf can be written "
+                 "to stdout, use --svg-path, --png-path or --fgb-path"
+              << std::endl;
+    exit(1);
+  }
+
+  if (cfg->tierDistances.size() != 3 || cfg->tierMinRoutes.size() != 2 ||
+      cfg->tierLabelScales.size() != 3) {
+    std::cerr << "Error: expected 3 tier distances, 2 tier min routes and 3 "
+                 "tier label scales"
+              << std::endl;
+    exit(1);
+  }
+
+  if (cfg->pngDpi <= 0) {
+    std::cerr << "Error: PNG resolution " << cfg->pngDpi << " is not positive!"
+              << std::endl;
+    exit(1);
+  }
+
   if (cfg->lineWidth < 0) {
     std::cerr << "Error: line width " << cfg->lineWidth << " is negative!"
               << std::endl;
@@ -254,6 +515,107 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
 
   if (cfg->mvtZooms.size() == 0) cfg->mvtZooms.push_back(14);
 
+  if (cfg->mvtMaxDataZoom > 25) {
+    std::cerr << "Error: max data zoom " << cfg->mvtMaxDataZoom
+              << " is above 25!" << std::endl;
+    exit(1);
+  }
+
+  if (cfg->mvtMaxDataZoom >= 0) {
+    // zooms above the max data zoom are overzoomed from it by clients
+    std::vector<size_t> zooms;
+    bool over = false;
+    for (auto z : cfg->mvtZooms) {
+      if (z > static_cast<size_t>(cfg->mvtMaxDataZoom))
+        over = true;
+      else
+        zooms.push_back(z);
+    }
+    if (over) zooms.push_back(cfg->mvtMaxDataZoom);
+
+    std::sort(zooms.begin(), zooms.end());
+    zooms.erase(std::unique(zooms.begin(), zooms.end()), zooms.end());
+    cfg->mvtZooms = zooms;
+  }
+
+  if (!cfg->displayListInPath.empty()) {
+    // MVT tiles are prepared per zoom level from the unprepared graph
+    for (const auto& method : cfg->renderMethods) {
+      if (method == "mvt") {
+        std::cerr << "Error: render method mvt cannot be used with "
+                     "--from-display-list!"
+                  << std::endl;
+        exit(1);
+      }
+    }
+
+    if (!cfg->displayListOutPath.empty()) {
+      std::cerr << "Error: --emit-display-list and --from-display-list "
+                   "cannot be combined!"
+                << std::endl;
+      exit(1);
+    }
+  }
+
+  if (!cfg->batchPath.empty() && (!cfg->displayListInPath.empty() ||
+                                  !cfg->displayListOutPath.empty())) {
+    std::cerr << "Error: --batch cannot be combined with display lists!"
+              << std::endl;
+    exit(1);
+  }
+
+  if (!bbox.empty() && !center.empty()) {
+    std::cerr << "Error: --bbox and --center cannot be combined!" << std::endl;
+    exit(1);
+  }
+
+  if (!bbox.empty()) {
+    auto crds = util::split(bbox, ',');
+    if (crds.size() != 4) {
+      std::cerr << "Error: --bbox requires minlng,minlat,maxlng,maxlat"
+                << std::endl;
+      exit(1);
+    }
+    cfg->clip = true;
+    cfg->clipBox = util::geo::DBox(
+        util::geo::latLngToWebMerc(util::geo::DPoint(atof(crds[0].c_str()),
+                                                     atof(crds[1].c_str()))),
+        util::geo::latLngToWebMerc(util::geo::DPoint(atof(crds[2].c_str()),
+                                                     atof(crds[3].c_str()))));
+  }
+
+  if (!center.empty()) {
+    auto crds = util::split(center, ',');
+    if (crds.size() != 2 || radius <= 0) {
+      std::cerr << "Error: --center requires lng,lat and a positive --radius"
+                << std::endl;
+      exit(1);
+    }
+    auto c = util::geo::latLngToWebMerc(
+        util::geo::DPoint(atof(crds[0].c_str()), atof(crds[1].c_str())));
+    double r = radius / util::geo::webMercDistFactor(c);
+    cfg->clip = true;
+    cfg->clipBox =
+        util::geo::DBox(util::geo::DPoint(c.getX() - r, c.getY() - r),
+                        util::geo::DPoint(c.getX() + r, c.getY() + r));
+  } else if (radius >= 0) {
+    std::cerr << "Error: --radius requires --center" << std::endl;
+    exit(1);
+  }
+
+  if (cfg->clip && cfg->clipMargin < 0) {
+    std::cerr << "Error: clip margin " << cfg->clipMargin << " is negative!"
+              << std::endl;
+    exit(1);
+  }
+
+  if (cfg->clip && !cfg->displayListInPath.empty()) {
+    std::cerr << "Error: --bbox and --center cannot be used with "
+                 "--from-display-list!"
+              << std::endl;
+    exit(1);
+  }
+
   if (cfg->outputPadding < 0) {
     cfg->outputPadding = (cfg->lineWidth + cfg->lineSpacing);
   }
@@ -6,6 +6,9 @@
 #define TRANSITMAP_CONFIG_TRANSITMAPCONFIG_H_
 
 #include <string>
+#include <vector>
+#include "shared/io/CompressedStream.h"
+#include "util/geo/Geo.h"
 
 namespace transitmapper {
 namespace config {
@@ -17,12 +20,63 @@ struct Config {
   double lineLabelSize = 40;
   double stationLabelSize = 60;
 
-  std::string renderMethod = "svg";
+  // outputs, in the order given
+  std::vector<std::string> renderMethods = {"svg"};
+
+  // if set, the SVG is written to this file instead of the output stream
+  std::string svgPath;
+
+  // write line styles to a style block, repeated station shapes as symbols
+  // and paths with relative commands
+  bool svgCompact = false;
+
+  // label font families, may be fallback stacks like
+  // "Noto Sans Kannada, Noto Sans, sans-serif"
+  std::string stationLabelFont = "Ubuntu Condensed";
+  std::string lineLabelFont = "Ubuntu";
+
+  // if set, the xml:lang of the SVG and of the station labels
+  std::string svgLang;
+
+  // written label font sizes are scaled by this, label placement is not
+  double labelTextScale = 1;
+
+  // group the SVG into named (Inkscape) layers
+  bool svgLayers = false;
+
+  // if set, the PNG is written to this file instead of the output stream
+  std::string pngPath;
+
+  // PNG resolution, at 96 dpi one PNG pixel is one SVG pixel
+  double pngDpi = 96;
+
+  // if set, the FlatGeobuf is written to this file instead of the output
+  // stream
+  std::string fgbPath;
 
   std::string mvtPath = ".";
 
+  // if set, MVT tiles are written into this PMTiles archive
+  std::string mvtArchivePath;
+
   bool writeStats = false;
 
+  // write a Chrome trace of the run to this file, empty if disabled
+  std::string tracePath;
+
+  // write per-phase resource usage as JSON to this file, empty if disabled
+  std::string metricsPath;
+
+  // thread budget of the whole run if given with -t, 0 otherwise
+  size_t threadBudget = 0;
+
+  // compression of the output written to stdout, the input is
+  // decompressed if needed
+  shared::io::Codec compress = shared::io::CODEC_NONE;
+
+  // in MB, 0 for no limit
+  size_t svgSpillSize = 256;
+
   double outputResolution = 0.1;
   double inputSmoothing = 1;
   double innerGeometryPrecision = 3;
@@ -39,6 +93,18 @@ struct Config {
   bool renderLabels = false;
   bool dontLabelDeg2 = false;
   bool dontLabelDeg3 = false;
+
+  // if focus station IDs are given, stations get label tiers as in
+  // stop_importance.assign_tiers(): tier 1 within the first distance (in
+  // meters) of the nearest focus station, tiers 2 and 3 within the next
+  // distances if at least the given number of routes stop there, and tier 4
+  // otherwise. Termini are always tier 1. Tier 4 stations are not labelled,
+  // the others are labelled in tier order with the label size scaled per
+  // tier.
+  std::vector<std::string> focusStations;
+  std::vector<double> tierDistances = {500, 1500, 3000};
+  std::vector<size_t> tierMinRoutes = {3, 5};
+  std::vector<double> tierLabelScales = {1, 0.85, 0.7};
   bool fromDot = false;
 
   bool randomColors = false;
@@ -48,8 +114,34 @@ struct Config {
 
   std::vector<size_t> mvtZooms;
 
+  // no MVT tiles are written above this zoom, clients overzoom the highest
+  // written zoom. -1 for no limit
+  int mvtMaxDataZoom = -1;
+
   bool renderDirMarkers = false;
   std::string worldFilePath;
+
+  // write the prepared render graph and label placements to this file
+  std::string displayListOutPath;
+
+  // render from a display list written by a previous run instead of
+  // reading and preparing an input graph
+  std::string displayListInPath;
+
+  // display list of a backdrop graph which is drawn under the graph at
+  // backdropOpacity, only the parts within the SVG viewport are written
+  std::string backdropPath;
+  double backdropOpacity = 0.15;
+
+  // render all maps of this batch manifest, see BatchManifest.h
+  std::string batchPath;
+
+  // if set, the input graph is clipped to clipBox (web mercator) padded by
+  // clipMargin meters before it is prepared, and clipBox is the SVG and PNG
+  // viewport
+  bool clip = false;
+  util::geo::DBox clipBox;
+  double clipMargin = 250;
 };
 
 }  // namespace config
@@ -34,7 +34,15 @@ GraphBuilder::GraphBuilder(const config::Config* cfg) : _cfg(cfg) {}
 
 // _____________________________________________________________________________
 void GraphBuilder::writeNodeFronts(RenderGraph* graph) {
-  for (auto n : graph->getNds()) {
+  std::vector<LineNode*> nds(graph->getNds().begin(), graph->getNds().end());
+
+  // the fronts of a node only depend on the geometries of its adjacent
+  // edges, they are computed in parallel and added afterwards
+  std::vector<std::vector<NodeFront>> fronts(nds.size());
+
+#pragma omp parallel for schedule(dynamic, 16) if (nds.size() > 64)
+  for (size_t i = 0; i < nds.size(); i++) {
+    auto n = nds[i];
     std::set<LineEdge*> eSet;
     eSet.insert(n->getAdjList().begin(), n->getAdjList().end());
 
@@ -56,9 +64,13 @@ void GraphBuilder::writeNodeFronts(RenderGraph* graph) {
 
       f.setInitialGeom(pl);
 
-      n->pl().addFront(f);
+      fronts[i].push_back(f);
     }
   }
+
+  for (size_t i = 0; i < nds.size(); i++) {
+    for (const auto& f : fronts[i]) nds[i]->pl().addFront(f);
+  }
 }
 
 // _____________________________________________________________________________
@@ -115,12 +127,27 @@ void GraphBuilder::expandOverlappinFronts(RenderGraph* g) {
   double step =
       (g->getWidth(0) + g->getSpacing(0) + 2 * g->getOutlineWidth(0)) / 10;
 
-  while (true) {
-    bool stillFree = false;
-    for (auto n : g->getNds()) {
+  // the overlaps at a node only depend on its own fronts and on the lengths
+  // of its adjacent edges, so a node only has to be checked again if one of
+  // its fronts moved, or if the edge to a neighbor was shortened. Dirty
+  // nodes are processed in the same order as in a full pass over all nodes,
+  // neighbors later in this order are still checked in the current pass.
+  std::set<LineNode*> dirty(g->getNds().begin(), g->getNds().end());
+
+  while (!dirty.empty()) {
+    std::set<LineNode*> nextDirty;
+    for (auto it = dirty.begin(); it != dirty.end(); it++) {
+      auto n = *it;
       std::set<NodeFront*> overlaps = nodeGetOverlappingFronts(g, n);
       for (auto f : overlaps) {
-        stillFree = true;
+        for (auto m : {f->edge->getFrom(), f->edge->getTo()}) {
+          if (dirty.key_comp()(n, m)) {
+            dirty.insert(m);
+          } else {
+            nextDirty.insert(m);
+          }
+        }
+
         double len = util::geo::len(*f->edge->pl().getGeom());
 
         if (f->edge->getTo() == n) {
@@ -145,7 +172,7 @@ void GraphBuilder::expandOverlappinFronts(RenderGraph* g) {
         }
       }
     }
-    if (!stillFree) break;
+    dirty.swap(nextDirty);
   }
 
   // for (auto n : g->getNds()) {
@@ -189,6 +216,10 @@ std::set<NodeFront*> GraphBuilder::nodeGetOverlappingFronts(
     const RenderGraph* g, const LineNode* n) const {
   std::set<NodeFront*> ret;
 
+  // independent of the front pair
+  double maxNdFrontWidth = g->getMaxNdFrontWidth(n);
+  bool station = n->pl().stops().size() && !g->notCompletelyServed(n);
+
   // TODO: why are nodefronts accessed via index?
   for (size_t i = 0; i < n->pl().fronts().size(); ++i) {
     const NodeFront& fa = n->pl().fronts()[i];
@@ -200,10 +231,10 @@ std::set<NodeFront*> GraphBuilder::nodeGetOverlappingFronts(
 
       bool overlap = false;
 
-      double maxNfDist = 2 * g->getMaxNdFrontWidth(n);
+      double maxNfDist = 2 * maxNdFrontWidth;
 
-      if (n->pl().stops().size() && !g->notCompletelyServed(n)) {
-        maxNfDist = .5 * g->getMaxNdFrontWidth(n);
+      if (station) {
+        maxNfDist = .5 * maxNdFrontWidth;
         double fac = 0;
         if (_cfg->tightStations)
           maxNfDist =
@@ -2,10 +2,20 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 #include "shared/rendergraph/RenderGraph.h"
 #include "transitmap/label/Labeller.h"
+#include "util/Misc.h"
 #include "util/geo/Geo.h"
 
+using shared::linegraph::LineGraph;
+using shared::linegraph::LineNode;
 using shared::rendergraph::RenderGraph;
 using transitmapper::label::Labeller;
 using transitmapper::label::LineLabel;
@@ -15,23 +25,47 @@ using transitmapper::label::StationLabel;
 using util::geo::MultiLine;
 using util::geo::PolyLine;
 
+// maximum number of stations scored in parallel
+const static size_t LABEL_BLOCK_SIZE = 64;
+
 // _____________________________________________________________________________
-Labeller::Labeller(const config::Config* cfg) : _cfg(cfg) {}
+Labeller::Labeller(const config::Config* cfg) : _maxStatRad(0), _cfg(cfg) {}
 
 // _____________________________________________________________________________
 void Labeller::label(const RenderGraph& g, bool notDeg2) {
+  indexStations(g);
   labelStations(g, notDeg2);
   labelLines(g);
 }
 
+// _____________________________________________________________________________
+void Labeller::setLabels(const std::vector<LineLabel>& lineLabels,
+                         const std::vector<StationLabel>& stationLabels) {
+  _lineLabels = lineLabels;
+  _stationLabels = stationLabels;
+}
+
+// _____________________________________________________________________________
+void Labeller::indexStations(const RenderGraph& g) {
+  for (auto n : g.getNds()) {
+    if (n->pl().stops().size() == 0) continue;
+
+    // TODO: the hull padding should be the same as in the renderer
+    auto statHull = g.getStopGeoms(n, _cfg->tightStations, 4);
+    double rad = util::geo::getEnclosingRadius(*n->pl().getGeom(), statHull);
+
+    _statRads[n] = rad;
+    _maxStatRad = std::max(_maxStatRad, rad);
+    _statIdx.add(*n->pl().getGeom(), n);
+  }
+}
+
 // _____________________________________________________________________________
 util::geo::MultiLine<double> Labeller::getStationLblBand(
     const shared::linegraph::LineNode* n, double fontSize, uint8_t offset,
-    const RenderGraph& g) {
-  // TODO: the hull padding should be the same as in the renderer
-  auto statHull = g.getStopGeoms(n, _cfg->tightStations, 4);
-
-  double rad = util::geo::getEnclosingRadius(*n->pl().getGeom(), statHull);
+    const RenderGraph& g) const {
+  UNUSED(g);
+  double rad = _statRads.at(n);
 
   // TODO: determine the label width based on the real font width. This is
   // nontrivial, as it requires the fonts to be rendered for non-monospaced
@@ -78,46 +112,143 @@ util::geo::MultiLine<double> Labeller::getStationLblBand(
   return band;
 }
 
+// _____________________________________________________________________________
+double Labeller::getStationLblReach(const shared::linegraph::LineNode* n,
+                                    double fontSize) const {
+  // upper bound for the distance of any label band point to the station,
+  // see getStationLblBand()
+  double labelW = (n->pl().stops().front().name.size() + 1) * fontSize / 2.1;
+  double h = fontSize * 0.75;
+
+  return _statRads.at(n) + labelW + (_cfg->lineSpacing + _cfg->lineWidth) +
+         2 * h;
+}
+
+// _____________________________________________________________________________
+size_t Labeller::getStationTier(const LineNode* n,
+                                const std::vector<const LineNode*>& focus,
+                                const RenderGraph& g) const {
+  if (focus.empty() || g.isTerminus(n)) return 1;
+
+  double d = std::numeric_limits<double>::infinity();
+  for (auto f : focus) {
+    d = std::min(d, util::geo::webMercMeterDist(*n->pl().getGeom(),
+                                                *f->pl().getGeom()));
+  }
+
+  // graphs without station counts fall back to the lines served
+  const auto& st = n->pl().stops().front();
+  size_t routes = st.trips ? st.routes : LineGraph::servedLines(n).size();
+
+  if (d <= _cfg->tierDistances[0]) return 1;
+  if (d <= _cfg->tierDistances[1] && routes >= _cfg->tierMinRoutes[0]) return 2;
+  if (d <= _cfg->tierDistances[2] && routes >= _cfg->tierMinRoutes[1]) return 3;
+  return 4;
+}
+
+// _____________________________________________________________________________
+std::vector<StationLabel> Labeller::getStationCands(
+    const LineNode* n, size_t tier, const RenderGraph& g) const {
+  double fontSize = _cfg->stationLabelSize * _cfg->tierLabelScales[tier - 1];
+
+  std::vector<StationLabel> cands;
+
+  for (uint8_t offset = 0; offset < 3; offset++) {
+    for (size_t deg = 0; deg < 8; deg++) {
+      auto band = getStationLblBand(n, fontSize, offset, g);
+      band = util::geo::rotate(band, 45 * deg, *n->pl().getGeom());
+
+      auto overlaps = getOverlaps(band, n, g);
+
+      if (overlaps.lineOverlaps + overlaps.statLabelOverlaps +
+              overlaps.statOverlaps >
+          0)
+        continue;
+      cands.push_back({PolyLine<double>(band[0]), band, fontSize,
+                       g.isTerminus(n), deg, offset, overlaps,
+                       n->pl().stops().front(), tier});
+    }
+  }
+
+  std::sort(cands.begin(), cands.end());
+  return cands;
+}
+
 // _____________________________________________________________________________
 void Labeller::labelStations(const RenderGraph& g, bool notdeg2) {
-  std::vector<const shared::linegraph::LineNode*> orderedNds;
+  std::vector<const LineNode*> focus;
+  if (_cfg->focusStations.size()) {
+    std::set<std::string> ids(_cfg->focusStations.begin(),
+                              _cfg->focusStations.end());
+    for (auto n : g.getNds()) {
+      for (const auto& st : n->pl().stops()) {
+        if (ids.count(st.id)) {
+          focus.push_back(n);
+          break;
+        }
+      }
+    }
+  }
+
+  // tier 4 stations are dropped before any candidate is generated
+  std::unordered_map<const LineNode*, size_t> tiers;
+  std::vector<const LineNode*> orderedNds;
   for (auto n : g.getNds()) {
-    if (n->pl().stops().size() == 0 || 
-        (notdeg2 && n->getDeg() == 2) || 
+    if (n->pl().stops().size() == 0 ||
+        (notdeg2 && n->getDeg() == 2) ||
         (_cfg->dontLabelDeg3 && n->getDeg() == 3)) continue;
+    size_t tier = getStationTier(n, focus, g);
+    if (tier > 3) continue;
+    tiers[n] = tier;
     orderedNds.push_back(n);
   }
 
-  std::sort(orderedNds.begin(), orderedNds.end(), statNdCmp);
+  std::sort(orderedNds.begin(), orderedNds.end(),
+            [&tiers](const LineNode* a, const LineNode* b) {
+              size_t ta = tiers.at(a);
+              size_t tb = tiers.at(b);
+              return ta < tb || (ta == tb && statNdCmp(a, b));
+            });
+
+  std::vector<double> reach(orderedNds.size());
+  for (size_t i = 0; i < orderedNds.size(); i++) {
+    auto n = orderedNds[i];
+    reach[i] = getStationLblReach(
+        n, _cfg->stationLabelSize * _cfg->tierLabelScales[tiers.at(n) - 1]);
+  }
 
-  for (auto n : orderedNds) {
-    double fontSize = _cfg->stationLabelSize;
+  // the candidates of a station only depend on the labels placed before
+  // within its label reach. Consecutive stations whose reaches do not
+  // overlap are scored in parallel and then placed in order, which gives
+  // the same labels as placing them one by one.
+  for (size_t i = 0; i < orderedNds.size();) {
+    size_t j = i + 1;
+    for (; j < orderedNds.size() && j - i < LABEL_BLOCK_SIZE; j++) {
+      bool indep = true;
+      for (size_t k = i; k < j && indep; k++) {
+        indep = util::geo::dist(*orderedNds[k]->pl().getGeom(),
+                                *orderedNds[j]->pl().getGeom()) >
+                reach[k] + reach[j] + 1;
+      }
+      if (!indep) break;
+    }
 
-    std::vector<StationLabel> cands;
+    std::vector<std::vector<StationLabel>> cands(j - i);
 
-    for (uint8_t offset = 0; offset < 3; offset++) {
-      for (size_t deg = 0; deg < 8; deg++) {
-        auto band = getStationLblBand(n, fontSize, offset, g);
-        band = util::geo::rotate(band, 45 * deg, *n->pl().getGeom());
+#pragma omp parallel for schedule(dynamic)
+    for (size_t k = i; k < j; k++) {
+      cands[k - i] =
+          getStationCands(orderedNds[k], tiers.at(orderedNds[k]), g);
+    }
 
-        auto overlaps = getOverlaps(band, n, g);
+    for (size_t k = i; k < j; k++) {
+      if (cands[k - i].size() == 0) continue;
 
-        if (overlaps.lineOverlaps + overlaps.statLabelOverlaps +
-                overlaps.statOverlaps >
-            0)
-          continue;
-        cands.push_back({PolyLine<double>(band[0]), band, fontSize,
-                         g.isTerminus(n), deg, offset, overlaps,
-                         n->pl().stops().front()});
-      }
+      _stationLabels.push_back(cands[k - i].front());
+      _statLblIdx.add(_stationLabels.back().band, _stationLabels.size() - 1);
     }
 
-    std::sort(cands.begin(), cands.end());
-    if (cands.size() == 0) continue;
-
-    auto cand = cands.front();
-    _stationLabels.push_back(cand);
-    _statLblIdx.add(cand.band, _stationLabels.size() - 1);
+    i = j;
   }
 }
 
@@ -129,8 +260,6 @@ Overlaps Labeller::getOverlaps(const util::geo::MultiLine<double>& band,
 
   Overlaps ret{0, 0, 0, 0};
 
-  std::set<const shared::linegraph::LineNode*> procedNds{forNd};
-
   for (auto line : band) {
     auto neighs = g.getNeighborEdges(
         line, g.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing));
@@ -142,25 +271,18 @@ Overlaps Labeller::getOverlaps(const util::geo::MultiLine<double>& band,
         ret.lineOverlaps++;
       }
       proced.insert(neigh);
+    }
+  }
 
-      std::vector<const shared::linegraph::LineNode*> nds = {neigh->getTo(),
-                                                             neigh->getFrom()};
-
-      for (auto nd : nds) {
-        if (nd->pl().stops().size() && !procedNds.count(nd)) {
-          procedNds.insert(nd);
-
-          auto statHull = g.getStopGeoms(nd, _cfg->tightStations, 4);
-
-          double rad =
-              util::geo::getEnclosingRadius(*nd->pl().getGeom(), statHull);
+  std::set<const shared::linegraph::LineNode*> statNeighs;
+  _statIdx.get(band, _maxStatRad + (_cfg->lineWidth + _cfg->lineSpacing) / 2,
+               &statNeighs);
 
-          if (util::geo::dist(*nd->pl().getGeom(), band) <
-              rad + (_cfg->lineWidth + _cfg->lineSpacing) / 2) {
-            ret.statOverlaps++;
-          }
-        }
-      }
+  for (auto nd : statNeighs) {
+    if (nd == forNd) continue;
+    if (util::geo::dist(*nd->pl().getGeom(), band) <
+        _statRads.at(nd) + (_cfg->lineWidth + _cfg->lineSpacing) / 2) {
+      ret.statOverlaps++;
     }
   }
 
@@ -170,7 +292,7 @@ Overlaps Labeller::getOverlaps(const util::geo::MultiLine<double>& band,
                   &labelNeighs);
 
   for (auto id : labelNeighs) {
-    auto labelNeigh = _stationLabels[id];
+    const auto& labelNeigh = _stationLabels[id];
     if (util::geo::dist(labelNeigh.band, band) < 1) ret.statLabelOverlaps++;
   }
 
@@ -180,6 +302,8 @@ Overlaps Labeller::getOverlaps(const util::geo::MultiLine<double>& band,
 // _____________________________________________________________________________
 void Labeller::labelLines(const RenderGraph& g) {
   LineLblIdx labelIdx = LineLblIdx();
+  double lineLblDist = 20 * (_cfg->lineWidth + _cfg->lineSpacing);
+
   for (auto n : g.getNds()) {
     for (auto e : n->getAdjList()) {
       if (e->getFrom() != n) continue;
@@ -190,85 +314,95 @@ void Labeller::labelLines(const RenderGraph& g) {
 
       double labelW = ((fontSize / 3) * (e->pl().getLines().size() - 1));
 
+      std::vector<const shared::linegraph::Line*> lines;
       for (auto lo : e->pl().getLines()) {
         labelW += lo.line->label().size() * (fontSize);
+        lines.push_back(lo.line);
       }
 
-      // try out positions
+      // candidates are pieces of the edge of length labelW
+      if (labelW < 5) continue;
+
+      // try out positions, the candidate closest to the edge center which is
+      // not blocked is placed, so they are checked in this order and only
+      // until the first one fits
       double step = fontSize;
 
-      std::vector<LineLabel> cands;
+      std::vector<std::tuple<double, int, double>> cands;
 
       for (int dir = -1; dir < 2; dir += 2) {
-        double start = 0;
-        while (start + labelW <= geomLen) {
-          PolyLine<double> cand(util::geo::segment(
-              *e->pl().getGeom(), start / geomLen, (start + labelW) / geomLen));
-          if (cand.getLength() < 5) break;
-          cand.offsetPerp(dir * (g.getTotalWidth(e) / 2 +
-                                 (_cfg->lineSpacing + _cfg->lineWidth)));
-
-          bool block = false;
-
-          for (auto neigh : g.getNeighborEdges(
-                   cand.getLine(),
-                   g.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing) +
-                       fontSize * 4)) {
-            if (neigh == e) continue;
-            if (util::geo::dist(cand.getLine(), *neigh->pl().getGeom()) <
-                (g.getTotalWidth(neigh) / 2) + (fontSize)) {
-              block = true;
-              break;
-            }
-          }
+        for (double start = 0; start + labelW <= geomLen; start += step) {
+          cands.push_back(std::make_tuple(
+              fabs((geomLen / 2) - (start + (labelW / 2))), dir, start));
+        }
+      }
 
-          std::set<size_t> labelNeighs;
-          _statLblIdx.get(
-              MultiLine<double>{cand.getLine()},
-              g.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing),
-              &labelNeighs);
-
-          for (auto neighId : labelNeighs) {
-            auto neigh = _stationLabels[neighId];
-            if (util::geo::dist(cand.getLine(), neigh.band) < (fontSize)) {
-              block = true;
-              break;
-            }
-          }
+      std::sort(cands.begin(), cands.end());
 
-          if (dir < 0) cand.reverse();
+      double offset = g.getTotalWidth(e) / 2 +
+                      (_cfg->lineSpacing + _cfg->lineWidth);
 
-          std::set<size_t> lineLabelNeighs;
-          labelIdx.get(cand.getLine(),
-                       20 * (_cfg->lineWidth + _cfg->lineSpacing),
-                       &lineLabelNeighs);
+      for (const auto& c : cands) {
+        int dir = std::get<1>(c);
+        double start = std::get<2>(c);
 
-          std::vector<const shared::linegraph::Line*> lines;
-          for (auto lo : e->pl().getLines()) {
-            lines.push_back(lo.line);
+        PolyLine<double> cand(util::geo::segment(
+            *e->pl().getGeom(), start / geomLen, (start + labelW) / geomLen));
+        cand.offsetPerp(dir * offset);
+        if (dir < 0) cand.reverse();
+
+        // cheapest check first: the same lines are not labelled again nearby
+        bool block = false;
+
+        std::set<size_t> lineLabelNeighs;
+        labelIdx.get(cand.getLine(), lineLblDist, &lineLabelNeighs);
+
+        for (auto neighLabelId : lineLabelNeighs) {
+          const auto& neighLabel = _lineLabels[neighLabelId];
+          if (neighLabel.lines == lines &&
+              util::geo::dist(cand.getLine(), neighLabel.geom.getLine()) <
+                  lineLblDist) {
+            block = true;
+            break;
           }
+        }
 
-          for (auto neighLabelId : lineLabelNeighs) {
-            auto neighLabel = _lineLabels[neighLabelId];
-            if (neighLabel.lines == lines &&
-                util::geo::dist(cand.getLine(), neighLabel.geom.getLine()) <
-                    20 * (_cfg->lineWidth + _cfg->lineSpacing)) {
-              block = true;
-              break;
-            }
+        if (block) continue;
+
+        std::set<size_t> labelNeighs;
+        _statLblIdx.get(
+            MultiLine<double>{cand.getLine()},
+            g.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing),
+            &labelNeighs);
+
+        for (auto neighId : labelNeighs) {
+          const auto& neigh = _stationLabels[neighId];
+          if (util::geo::dist(cand.getLine(), neigh.band) < (fontSize)) {
+            block = true;
+            break;
           }
+        }
 
-          if (!block)
-            cands.push_back({cand, fabs((geomLen / 2) - (start + (labelW / 2))),
-                             fontSize, lines});
-          start += step;
+        if (block) continue;
+
+        for (auto neigh : g.getNeighborEdges(
+                 cand.getLine(),
+                 g.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing) +
+                     fontSize * 4)) {
+          if (neigh == e) continue;
+          if (util::geo::dist(cand.getLine(), *neigh->pl().getGeom()) <
+              (g.getTotalWidth(neigh) / 2) + (fontSize)) {
+            block = true;
+            break;
+          }
         }
-      }
 
-      std::sort(cands.begin(), cands.end());
-      if (cands.size() == 0) continue;
-      _lineLabels.push_back(cands.front());
-      labelIdx.add(cands.front().geom.getLine(), _lineLabels.size() - 1);
+        if (block) continue;
+
+        _lineLabels.push_back({cand, std::get<0>(c), fontSize, lines});
+        labelIdx.add(cand.getLine(), _lineLabels.size() - 1);
+        break;
+      }
     }
   }
 }
@@ -5,6 +5,7 @@
 #ifndef TRANSITMAP_LABEL_LABELLER_H_
 #define TRANSITMAP_LABEL_LABELLER_H_
 
+#include <unordered_map>
 #include "shared/linegraph/Line.h"
 #include "shared/rendergraph/RenderGraph.h"
 #include "transitmap/config/TransitMapConfig.h"
@@ -60,6 +61,9 @@ struct StationLabel {
 
   shared::linegraph::Station s;
 
+  // label tier of the station, see config::Config::focusStations
+  size_t tier;
+
   double getPen() const {
     double score = overlaps.lineOverlaps * 15 + overlaps.statOverlaps * 20 +
                    overlaps.statLabelOverlaps * 20 +
@@ -80,6 +84,9 @@ inline bool operator<(const StationLabel& a, const StationLabel& b) {
 // typedef util::geo::Grid<size_t, util::geo::Line, double> LineLblIdx;
 typedef util::geo::RTree<size_t, util::geo::MultiLine, double> StatLblIdx;
 typedef util::geo::RTree<size_t, util::geo::Line, double> LineLblIdx;
+typedef util::geo::RTree<const shared::linegraph::LineNode*,
+                         util::geo::Point, double>
+    StatIdx;
 
 class Labeller {
  public:
@@ -87,6 +94,10 @@ class Labeller {
 
   void label(const shared::rendergraph::RenderGraph& g, bool notdeg2);
 
+  // use previously computed labels, e.g. read from a display list
+  void setLabels(const std::vector<LineLabel>& lineLabels,
+                 const std::vector<StationLabel>& stationLabels);
+
   const std::vector<LineLabel>& getLineLabels() const;
   const std::vector<StationLabel>& getStationLabels() const;
 
@@ -98,8 +109,14 @@ class Labeller {
 
   StatLblIdx _statLblIdx;
 
+  // station nodes and the radius of their enclosing circle
+  StatIdx _statIdx;
+  std::unordered_map<const shared::linegraph::LineNode*, double> _statRads;
+  double _maxStatRad;
+
   const config::Config* _cfg;
 
+  void indexStations(const shared::rendergraph::RenderGraph& g);
   void labelStations(const shared::rendergraph::RenderGraph& g, bool notdeg2);
   void labelLines(const shared::rendergraph::RenderGraph& g);
 
@@ -109,7 +126,21 @@ class Labeller {
 
   util::geo::MultiLine<double> getStationLblBand(
       const shared::linegraph::LineNode* n, double fontSize, uint8_t offset,
-      const shared::rendergraph::RenderGraph& g);
+      const shared::rendergraph::RenderGraph& g) const;
+
+  double getStationLblReach(const shared::linegraph::LineNode* n,
+                            double fontSize) const;
+
+  // label tier of n given the nodes of the focus stations
+  size_t getStationTier(
+      const shared::linegraph::LineNode* n,
+      const std::vector<const shared::linegraph::LineNode*>& focus,
+      const shared::rendergraph::RenderGraph& g) const;
+
+  // label candidates of n without any overlaps, best first
+  std::vector<StationLabel> getStationCands(
+      const shared::linegraph::LineNode* n, size_t tier,
+      const shared::rendergraph::RenderGraph& g) const;
 };
 }  // namespace label
 }  // namespace transitmapper
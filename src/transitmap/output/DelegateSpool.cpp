@@ -0,0 +1,147 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <string>
+#include "transitmap/output/DelegateSpool.h"
+#include "util/geo/PolyLine.h"
+#include "util/log/Log.h"
+
+using transitmapper::output::DelegateSpool;
+using transitmapper::output::OutlinePrintPair;
+using transitmapper::output::Params;
+using transitmapper::output::PrintDelegate;
+
+namespace {
+// _____________________________________________________________________________
+void writeStr(std::FILE* f, const std::string& s) {
+  size_t len = s.size();
+  std::fwrite(&len, sizeof(len), 1, f);
+  std::fwrite(s.data(), 1, len, f);
+}
+
+// _____________________________________________________________________________
+std::string readStr(std::FILE* f) {
+  size_t len = 0;
+  if (std::fread(&len, sizeof(len), 1, f) != 1) return "";
+  std::string ret(len, 0);
+  if (len && std::fread(&ret[0], 1, len, f) != len) return "";
+  return ret;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+DelegateSpool::DelegateSpool(size_t maxSize)
+    : _maxSize(maxSize), _size(0), _bufBytes(0), _spill(0) {}
+
+// _____________________________________________________________________________
+DelegateSpool::~DelegateSpool() {
+  if (_spill) std::fclose(_spill);
+}
+
+// _____________________________________________________________________________
+void DelegateSpool::push(const OutlinePrintPair& pp) {
+  _buf.push_back(pp);
+  _bufBytes += bytes(pp.front) + bytes(pp.back);
+  _size++;
+
+  if (_maxSize && _bufBytes > _maxSize) spill();
+}
+
+// _____________________________________________________________________________
+void DelegateSpool::spill() {
+  if (!_spill) {
+    _spill = std::tmpfile();
+    if (!_spill) {
+      LOGTO(WARN, std::cerr)
+          << "Could not create spill file, keeping edge geometries in memory";
+      _maxSize = 0;
+      return;
+    }
+  }
+
+  std::fseek(_spill, 0, SEEK_END);
+  _blocks.push_back({std::ftell(_spill), _buf.size()});
+
+  for (const auto& pp : _buf) {
+    write(_spill, pp.front);
+    write(_spill, pp.back);
+  }
+
+  _buf.clear();
+  _buf.shrink_to_fit();
+  _bufBytes = 0;
+}
+
+// _____________________________________________________________________________
+void DelegateSpool::forEachReversed(
+    const std::function<void(const OutlinePrintPair&)>& f) {
+  for (auto it = _buf.rbegin(); it != _buf.rend(); it++) f(*it);
+
+  std::vector<OutlinePrintPair> block;
+
+  for (auto it = _blocks.rbegin(); it != _blocks.rend(); it++) {
+    std::fseek(_spill, it->first, SEEK_SET);
+
+    block.clear();
+    block.reserve(it->second);
+    for (size_t i = 0; i < it->second; i++) {
+      PrintDelegate front = read(_spill);
+      PrintDelegate back = read(_spill);
+      block.push_back(OutlinePrintPair(front, back));
+    }
+
+    for (auto jt = block.rbegin(); jt != block.rend(); jt++) f(*jt);
+  }
+}
+
+// _____________________________________________________________________________
+size_t DelegateSpool::bytes(const PrintDelegate& pd) {
+  size_t ret = sizeof(PrintDelegate);
+  for (const auto& kv : pd.first) ret += kv.first.size() + kv.second.size();
+  return ret + pd.second.getLine().size() * sizeof(util::geo::DPoint);
+}
+
+// _____________________________________________________________________________
+void DelegateSpool::write(std::FILE* f, const PrintDelegate& pd) {
+  size_t numParams = pd.first.size();
+  std::fwrite(&numParams, sizeof(numParams), 1, f);
+  for (const auto& kv : pd.first) {
+    writeStr(f, kv.first);
+    writeStr(f, kv.second);
+  }
+
+  const auto& line = pd.second.getLine();
+  size_t numPoints = line.size();
+  std::fwrite(&numPoints, sizeof(numPoints), 1, f);
+  for (const auto& p : line) {
+    double x = p.getX(), y = p.getY();
+    std::fwrite(&x, sizeof(x), 1, f);
+    std::fwrite(&y, sizeof(y), 1, f);
+  }
+}
+
+// _____________________________________________________________________________
+PrintDelegate DelegateSpool::read(std::FILE* f) {
+  PrintDelegate ret;
+
+  size_t numParams = 0;
+  if (std::fread(&numParams, sizeof(numParams), 1, f) != 1) return ret;
+  for (size_t i = 0; i < numParams; i++) {
+    std::string key = readStr(f);
+    ret.first[key] = readStr(f);
+  }
+
+  size_t numPoints = 0;
+  if (std::fread(&numPoints, sizeof(numPoints), 1, f) != 1) return ret;
+  util::geo::Line<double> line(numPoints);
+  for (size_t i = 0; i < numPoints; i++) {
+    double x = 0, y = 0;
+    if (std::fread(&x, sizeof(x), 1, f) != 1) break;
+    if (std::fread(&y, sizeof(y), 1, f) != 1) break;
+    line[i] = util::geo::DPoint(x, y);
+  }
+
+  ret.second = util::geo::PolyLine<double>(line);
+  return ret;
+}
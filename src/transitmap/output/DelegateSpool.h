@@ -0,0 +1,58 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_DELEGATESPOOL_H_
+#define TRANSITMAP_OUTPUT_DELEGATESPOOL_H_
+
+#include <cstdio>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "transitmap/output/Renderer.h"
+
+namespace transitmapper {
+namespace output {
+
+// Append-only store of outline print pairs, which are read back in reverse
+// insertion order. Once the buffered pairs exceed maxSize bytes, they are
+// spilled as a block to a temporary file. Blocks are read back one at a
+// time, so memory use stays bounded by about maxSize. A maxSize of 0 keeps
+// everything in memory.
+class DelegateSpool {
+ public:
+  explicit DelegateSpool(size_t maxSize);
+  ~DelegateSpool();
+
+  DelegateSpool(const DelegateSpool&) = delete;
+  DelegateSpool& operator=(const DelegateSpool&) = delete;
+
+  void push(const OutlinePrintPair& pp);
+
+  size_t size() const { return _size; }
+
+  // call f for each pair, last pushed first
+  void forEachReversed(const std::function<void(const OutlinePrintPair&)>& f);
+
+ private:
+  size_t _maxSize;
+  size_t _size;
+
+  std::vector<OutlinePrintPair> _buf;
+  size_t _bufBytes;
+
+  std::FILE* _spill;
+
+  // (file offset, number of pairs) of each spilled block
+  std::vector<std::pair<long, size_t>> _blocks;
+
+  void spill();
+
+  static size_t bytes(const PrintDelegate& pd);
+  static void write(std::FILE* f, const PrintDelegate& pd);
+  static PrintDelegate read(std::FILE* f);
+};
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_DELEGATESPOOL_H_
@@ -0,0 +1,371 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shared/linegraph/BinGraph.h"
+#include "transitmap/output/DisplayList.h"
+
+using shared::linegraph::BinGraphWriter;
+using shared::linegraph::LineEdge;
+using shared::linegraph::LineNode;
+using shared::linegraph::NodeFront;
+using shared::linegraph::Station;
+using shared::rendergraph::RenderGraph;
+using transitmapper::label::Labeller;
+using transitmapper::label::LineLabel;
+using transitmapper::label::StationLabel;
+using transitmapper::output::DisplayListParams;
+using util::geo::DLine;
+using util::geo::DPoint;
+using util::geo::PolyLine;
+
+namespace {
+
+// node front and label geometries are the result of offsetting and
+// intersecting, they are stored as raw doubles (in host byte order) to render
+// exactly as in the original run
+
+// _____________________________________________________________________________
+void putVarint(std::string* buf, uint64_t v) {
+  while (v >= 0x80) {
+    buf->push_back(static_cast<char>((v & 0x7F) | 0x80));
+    v >>= 7;
+  }
+  buf->push_back(static_cast<char>(v));
+}
+
+// _____________________________________________________________________________
+void putDbl(std::string* buf, double v) {
+  char raw[sizeof(double)];
+  std::memcpy(raw, &v, sizeof(double));
+  buf->append(raw, sizeof(double));
+}
+
+// _____________________________________________________________________________
+void putStr(std::string* buf, const std::string& s) {
+  putVarint(buf, s.size());
+  buf->append(s);
+}
+
+// _____________________________________________________________________________
+void putPoint(std::string* buf, const DPoint& p) {
+  putDbl(buf, p.getX());
+  putDbl(buf, p.getY());
+}
+
+// _____________________________________________________________________________
+void putLine(std::string* buf, const DLine& l) {
+  putVarint(buf, l.size());
+  for (const auto& p : l) putPoint(buf, p);
+}
+
+// _____________________________________________________________________________
+class Dec {
+ public:
+  Dec(const std::string& buf) : _p(buf.data()), _end(buf.data() + buf.size()) {}
+
+  uint64_t varint() {
+    uint64_t ret = 0;
+    int shift = 0;
+    while (true) {
+      if (_p == _end || shift > 63) err();
+      uint8_t b = static_cast<uint8_t>(*_p++);
+      ret |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if (!(b & 0x80)) break;
+      shift += 7;
+    }
+    return ret;
+  }
+
+  double dbl() {
+    double ret;
+    raw(reinterpret_cast<char*>(&ret), sizeof(double));
+    return ret;
+  }
+
+  std::string str() {
+    uint64_t len = varint();
+    if (static_cast<uint64_t>(_end - _p) < len) err();
+    std::string ret(_p, len);
+    _p += len;
+    return ret;
+  }
+
+  void raw(char* out, size_t len) {
+    if (static_cast<size_t>(_end - _p) < len) err();
+    std::copy(_p, _p + len, out);
+    _p += len;
+  }
+
+  DPoint point() {
+    double x = dbl();
+    return DPoint(x, dbl());
+  }
+
+  DLine line() {
+    DLine ret(count(2 * sizeof(double)));
+    for (auto& p : ret) p = point();
+    return ret;
+  }
+
+  // guard against absurd sizes from corrupted input before allocating
+  size_t count(size_t minBytesPerEntry) {
+    uint64_t n = varint();
+    if (n * minBytesPerEntry > static_cast<uint64_t>(_end - _p)) err();
+    return n;
+  }
+
+  bool done() const { return _p == _end; }
+
+  [[noreturn]] void err() const {
+    throw(std::runtime_error("Corrupted display list input."));
+  }
+
+ private:
+  const char* _p;
+  const char* _end;
+};
+
+// _____________________________________________________________________________
+void putParams(std::string* buf, const DisplayListParams& p) {
+  putDbl(buf, p.lineWidth);
+  putDbl(buf, p.lineSpacing);
+  putDbl(buf, p.outlineWidth);
+  putDbl(buf, p.inputSmoothing);
+  buf->push_back(p.tightStations);
+  buf->push_back(p.labels);
+  putDbl(buf, p.lineLabelSize);
+  putDbl(buf, p.stationLabelSize);
+  buf->push_back(p.dontLabelDeg2);
+  buf->push_back(p.dontLabelDeg3);
+}
+
+// _____________________________________________________________________________
+void getParams(Dec* d, DisplayListParams* p) {
+  char flag;
+  p->lineWidth = d->dbl();
+  p->lineSpacing = d->dbl();
+  p->outlineWidth = d->dbl();
+  p->inputSmoothing = d->dbl();
+  d->raw(&flag, 1);
+  p->tightStations = flag;
+  d->raw(&flag, 1);
+  p->labels = flag;
+  p->lineLabelSize = d->dbl();
+  p->stationLabelSize = d->dbl();
+  d->raw(&flag, 1);
+  p->dontLabelDeg2 = flag;
+  d->raw(&flag, 1);
+  p->dontLabelDeg3 = flag;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+DisplayListParams::DisplayListParams(const config::Config* cfg, bool labels)
+    : lineWidth(cfg->lineWidth),
+      lineSpacing(cfg->lineSpacing),
+      outlineWidth(cfg->outlineWidth),
+      inputSmoothing(cfg->inputSmoothing),
+      tightStations(cfg->tightStations),
+      labels(labels),
+      lineLabelSize(cfg->lineLabelSize),
+      stationLabelSize(cfg->stationLabelSize),
+      dontLabelDeg2(cfg->dontLabelDeg2),
+      dontLabelDeg3(cfg->dontLabelDeg3) {}
+
+// _____________________________________________________________________________
+bool DisplayListParams::sameGeom(const DisplayListParams& o) const {
+  return lineWidth == o.lineWidth && lineSpacing == o.lineSpacing &&
+         outlineWidth == o.outlineWidth && inputSmoothing == o.inputSmoothing &&
+         tightStations == o.tightStations;
+}
+
+// _____________________________________________________________________________
+bool DisplayListParams::sameLabels(const DisplayListParams& o) const {
+  return labels && o.labels && lineLabelSize == o.lineLabelSize &&
+         stationLabelSize == o.stationLabelSize &&
+         dontLabelDeg2 == o.dontLabelDeg2 && dontLabelDeg3 == o.dontLabelDeg3;
+}
+
+// _____________________________________________________________________________
+void transitmapper::output::writeDisplayList(const RenderGraph& g,
+                                             const Labeller* labeller,
+                                             const DisplayListParams& params,
+                                             std::ostream* s) {
+  std::string buf;
+
+  DisplayListParams p = params;
+  p.labels = labeller != 0;
+
+  buf.append(DISPLAY_LIST_MAGIC, 4);
+  putVarint(&buf, DISPLAY_LIST_VERSION);
+  putParams(&buf, p);
+
+  // the graph, length-prefixed because binary graphs are read to the end
+  std::stringstream graph;
+  BinGraphWriter wr(&graph);
+  wr.add(g);
+  wr.flush();
+  putStr(&buf, graph.str());
+
+  putPoint(&buf, g.getBBox().getLowerLeft());
+  putPoint(&buf, g.getBBox().getUpperRight());
+
+  // edges are indexed in the order the binary graph writer writes them
+  std::unordered_map<const LineEdge*, size_t> edgIdx;
+  for (auto nd : g.getNds()) {
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      edgIdx.insert({e, edgIdx.size()});
+    }
+  }
+
+  // node fronts, per node in the order of the binary graph
+  for (auto nd : g.getNds()) {
+    putVarint(&buf, nd->pl().fronts().size());
+    for (const auto& nf : nd->pl().fronts()) {
+      putVarint(&buf, edgIdx.at(nf.edge));
+      putLine(&buf, nf.geom.getLine());
+      putLine(&buf, nf.origGeom.getLine());
+      putDbl(&buf, nf.refEtgLengthBefExp);
+    }
+  }
+
+  if (labeller) {
+    putVarint(&buf, labeller->getLineLabels().size());
+    for (const auto& lbl : labeller->getLineLabels()) {
+      putLine(&buf, lbl.geom.getLine());
+      putDbl(&buf, lbl.centerDist);
+      putDbl(&buf, lbl.fontSize);
+      putVarint(&buf, lbl.lines.size());
+      for (auto l : lbl.lines) putStr(&buf, l->id());
+    }
+
+    putVarint(&buf, labeller->getStationLabels().size());
+    for (const auto& lbl : labeller->getStationLabels()) {
+      putLine(&buf, lbl.geom.getLine());
+      putVarint(&buf, lbl.band.size());
+      for (const auto& l : lbl.band) putLine(&buf, l);
+      putDbl(&buf, lbl.fontSize);
+      buf.push_back(lbl.bold);
+      putVarint(&buf, lbl.deg);
+      putVarint(&buf, lbl.pos);
+      putVarint(&buf, lbl.tier);
+      putVarint(&buf, lbl.overlaps.lineOverlaps);
+      putVarint(&buf, lbl.overlaps.lineLabelOverlaps);
+      putVarint(&buf, lbl.overlaps.statLabelOverlaps);
+      putVarint(&buf, lbl.overlaps.statOverlaps);
+      putStr(&buf, lbl.s.id);
+      putStr(&buf, lbl.s.name);
+      putPoint(&buf, lbl.s.pos);
+    }
+  }
+
+  s->write(buf.data(), buf.size());
+  s->flush();
+}
+
+// _____________________________________________________________________________
+void transitmapper::output::readDisplayList(std::istream* s, RenderGraph* g,
+                                            Labeller* labeller,
+                                            DisplayListParams* params) {
+  std::string buf((std::istreambuf_iterator<char>(*s)),
+                  std::istreambuf_iterator<char>());
+  Dec d(buf);
+
+  char magic[4];
+  d.raw(magic, 4);
+  if (!std::equal(magic, magic + 4, DISPLAY_LIST_MAGIC)) {
+    throw(std::runtime_error("Input is not a display list."));
+  }
+
+  uint64_t version = d.varint();
+  if (version != DISPLAY_LIST_VERSION) {
+    throw(std::runtime_error("Unsupported display list version " +
+                             std::to_string(version)));
+  }
+
+  getParams(&d, params);
+
+  std::vector<LineNode*> nds;
+  std::vector<LineEdge*> edgs;
+  std::stringstream graph(d.str());
+  g->readFromBin(&graph, &nds, &edgs);
+
+  DPoint ll = d.point();
+  DPoint ur = d.point();
+  g->setBBox(util::geo::DBox(ll, ur));
+
+  for (auto nd : nds) {
+    size_t numFronts = d.count(3 + sizeof(double));
+    for (size_t i = 0; i < numFronts; i++) {
+      uint64_t eIdx = d.varint();
+      if (eIdx >= edgs.size()) d.err();
+
+      NodeFront nf(nd, edgs[eIdx]);
+      nf.geom = PolyLine<double>(d.line());
+      nf.origGeom = PolyLine<double>(d.line());
+      nf.refEtgLengthBefExp = d.dbl();
+
+      // fronts of edges dropped while reading the graph
+      if (!nf.edge) continue;
+      nd->pl().addFront(nf);
+    }
+  }
+
+  if (!params->labels) {
+    if (!d.done()) d.err();
+    return;
+  }
+
+  std::vector<LineLabel> lineLabels(d.count(1 + 2 * sizeof(double) + 1));
+  for (auto& lbl : lineLabels) {
+    lbl.geom = PolyLine<double>(d.line());
+    lbl.centerDist = d.dbl();
+    lbl.fontSize = d.dbl();
+    lbl.lines.resize(d.count(1));
+    for (auto& l : lbl.lines) {
+      l = g->getLine(d.str());
+      if (!l) d.err();
+    }
+  }
+
+  std::vector<StationLabel> stationLabels;
+  size_t numStationLabels = d.count(2 + sizeof(double));
+  stationLabels.reserve(numStationLabels);
+  for (size_t i = 0; i < numStationLabels; i++) {
+    PolyLine<double> geom(d.line());
+    util::geo::MultiLine<double> band(d.count(1));
+    for (auto& l : band) l = d.line();
+    double fontSize = d.dbl();
+    char bold;
+    d.raw(&bold, 1);
+    size_t deg = d.varint();
+    size_t pos = d.varint();
+    size_t tier = d.varint();
+    if (deg >= label::DEG_PENS.size()) d.err();
+    label::Overlaps overlaps;
+    overlaps.lineOverlaps = d.varint();
+    overlaps.lineLabelOverlaps = d.varint();
+    overlaps.statLabelOverlaps = d.varint();
+    overlaps.statOverlaps = d.varint();
+    std::string id = d.str();
+    std::string name = d.str();
+    Station st(id, name, d.point());
+
+    stationLabels.push_back(StationLabel{geom, band, fontSize, bold != 0, deg,
+                                         pos, overlaps, st, tier});
+  }
+
+  if (!d.done()) d.err();
+
+  labeller->setLabels(lineLabels, stationLabels);
+}
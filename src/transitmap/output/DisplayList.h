@@ -0,0 +1,67 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_DISPLAYLIST_H_
+#define TRANSITMAP_OUTPUT_DISPLAYLIST_H_
+
+#include <istream>
+#include <ostream>
+
+#include "shared/rendergraph/RenderGraph.h"
+#include "transitmap/config/TransitMapConfig.h"
+#include "transitmap/label/Labeller.h"
+
+namespace transitmapper {
+namespace output {
+
+// A display list holds everything the SVG and PNG renderers need which is
+// expensive to compute: the prepared render graph (as an embedded binary line
+// graph), its node fronts and the placed labels. Styles are taken from the
+// graph and the config at render time, so a display list can be re-rendered
+// with different colors, fonts or CSS without preparing the graph again.
+
+static const char DISPLAY_LIST_MAGIC[4] = {'T', 'M', 'D', 'L'};
+static const uint64_t DISPLAY_LIST_VERSION = 2;
+
+// the parameters a display list was computed with
+struct DisplayListParams {
+  // geometry of the prepared graph
+  double lineWidth = 0;
+  double lineSpacing = 0;
+  double outlineWidth = 0;
+  double inputSmoothing = 0;
+  bool tightStations = false;
+
+  // label placement, only meaningful if labels were stored
+  bool labels = false;
+  double lineLabelSize = 0;
+  double stationLabelSize = 0;
+  bool dontLabelDeg2 = false;
+  bool dontLabelDeg3 = false;
+
+  DisplayListParams() {}
+  DisplayListParams(const config::Config* cfg, bool labels);
+
+  // true if the stored graph geometry can be rendered with the other params
+  bool sameGeom(const DisplayListParams& o) const;
+
+  // true if the stored labels are placed as the other params would place them
+  bool sameLabels(const DisplayListParams& o) const;
+};
+
+// write a prepared render graph and, if labeller is not 0, its labels
+void writeDisplayList(const shared::rendergraph::RenderGraph& g,
+                      const label::Labeller* labeller,
+                      const DisplayListParams& params, std::ostream* s);
+
+// read a display list into an empty render graph and the labeller (labels are
+// only set if params->labels is true afterwards), throws std::runtime_error on
+// invalid input
+void readDisplayList(std::istream* s, shared::rendergraph::RenderGraph* g,
+                     label::Labeller* labeller, DisplayListParams* params);
+
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_DISPLAYLIST_H_
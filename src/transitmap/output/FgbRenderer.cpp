@@ -0,0 +1,143 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "shared/linegraph/Line.h"
+#include "shared/rendergraph/RenderGraph.h"
+#include "transitmap/config/TransitMapConfig.h"
+#include "transitmap/output/FgbRenderer.h"
+#include "transitmap/output/FgbWriter.h"
+#include "transitmap/output/InnerCliques.h"
+#include "transitmap/output/LineParts.h"
+#include "util/geo/PolyLine.h"
+#include "util/log/Log.h"
+
+using shared::linegraph::Line;
+using shared::linegraph::LineNode;
+using shared::rendergraph::RenderGraph;
+using transitmapper::output::FgbColumn;
+using transitmapper::output::FgbProps;
+using transitmapper::output::FgbRenderer;
+using transitmapper::output::FgbWriter;
+using transitmapper::output::getCliqueGeoms;
+using transitmapper::output::getEdgeLineParts;
+using transitmapper::output::getEdgeOrder;
+using transitmapper::output::getInnerCliques;
+using util::geo::DLine;
+using util::geo::PolyLine;
+
+namespace {
+// column indices, in the order of COLUMNS
+enum FgbCol : uint16_t {
+  COL_LAYER = 0,
+  COL_LINE_ID,
+  COL_LINE,
+  COL_COLOR,
+  COL_STATION_ID,
+  COL_STATION_LABEL
+};
+
+const std::vector<FgbColumn> COLUMNS = {
+    {"layer", transitmapper::output::FGB_COL_STRING},
+    {"line_id", transitmapper::output::FGB_COL_STRING},
+    {"line", transitmapper::output::FGB_COL_STRING},
+    {"color", transitmapper::output::FGB_COL_STRING},
+    {"station_id", transitmapper::output::FGB_COL_STRING},
+    {"station_label", transitmapper::output::FGB_COL_STRING}};
+
+// _____________________________________________________________________________
+DLine toLatLng(const DLine& l) {
+  DLine ret;
+  ret.reserve(l.size());
+  for (const auto& p : l) {
+    ret.push_back(util::geo::webMercToLatLng<double>(p.getX(), p.getY()));
+  }
+  return ret;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+FgbRenderer::FgbRenderer(std::ostream* o, const config::Config* cfg)
+    : _o(o), _cfg(cfg) {}
+
+// _____________________________________________________________________________
+void FgbRenderer::print(const RenderGraph& outG) {
+  FgbWriter w("transitmap", COLUMNS);
+
+  LOGTO(DEBUG, std::cerr) << "Writing edges...";
+  if (_cfg->renderEdges) outputEdges(outG, &w);
+
+  LOGTO(DEBUG, std::cerr) << "Writing nodes...";
+  if (_cfg->renderNodeConnections) {
+    for (auto n : outG.getNds()) renderNodeConnections(outG, n, &w);
+  }
+
+  outputNodes(outG, &w);
+
+  LOGTO(DEBUG, std::cerr) << "Writing " << w.numFeatures()
+                          << " FlatGeobuf features...";
+  w.write(_o);
+}
+
+// _____________________________________________________________________________
+void FgbRenderer::addLine(const PolyLine<double>& geom,
+                          const std::string& layer, const Line* l,
+                          FgbWriter* w) const {
+  FgbProps props;
+  props.add(COL_LAYER, layer);
+  props.add(COL_LINE_ID, l->id());
+  props.add(COL_LINE, l->label());
+  props.add(COL_COLOR, l->color());
+  w->add(transitmapper::output::FGB_LINESTRING, toLatLng(geom.getLine()),
+         props);
+}
+
+// _____________________________________________________________________________
+void FgbRenderer::outputEdges(const RenderGraph& outG, FgbWriter* w) const {
+  // same edge order as in the SvgRenderer
+  for (const auto* e : getEdgeOrder(outG)) {
+    for (const auto& part : getEdgeLineParts(outG, e, _cfg->lineWidth,
+                                             _cfg->outlineWidth,
+                                             _cfg->lineSpacing)) {
+      addLine(part.geom, "lines", e->pl().lineOccAtPos(part.pos).line, w);
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void FgbRenderer::renderNodeConnections(const RenderGraph& outG,
+                                        const LineNode* n,
+                                        FgbWriter* w) const {
+  auto geoms = outG.innerGeoms(n, _cfg->innerGeometryPrecision);
+
+  for (const auto& clique : getInnerCliques(n, geoms, 9999)) {
+    for (const auto& ig : getCliqueGeoms(clique, n, _cfg->lineWidth,
+                                         _cfg->outlineWidth,
+                                         _cfg->lineSpacing)) {
+      addLine(ig.geom, "inner-connections", ig.from.line, w);
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void FgbRenderer::outputNodes(const RenderGraph& outG, FgbWriter* w) const {
+  if (!_cfg->renderStations) return;
+
+  for (auto n : outG.getNds()) {
+    if (n->pl().stops().size() == 0 || n->pl().fronts().size() == 0) continue;
+
+    FgbProps props;
+    props.add(COL_LAYER, std::string("stations"));
+    props.add(COL_STATION_ID, n->pl().stops().front().id);
+    props.add(COL_STATION_LABEL, n->pl().stops().front().name);
+
+    for (const auto& geom : outG.getStopGeoms(n, _cfg->tightStations, 32)) {
+      w->add(transitmapper::output::FGB_POLYGON, toLatLng(geom.getOuter()),
+             props);
+    }
+  }
+}
@@ -0,0 +1,50 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_FGBRENDERER_H_
+#define TRANSITMAP_OUTPUT_FGBRENDERER_H_
+
+#include <ostream>
+#include <string>
+
+#include "Renderer.h"
+#include "shared/rendergraph/RenderGraph.h"
+#include "transitmap/config/TransitMapConfig.h"
+#include "transitmap/output/FgbWriter.h"
+#include "util/geo/PolyLine.h"
+
+namespace transitmapper {
+namespace output {
+
+// Writes the render geometry - the offset line parts, the node connections
+// and the station polygons - into a single FlatGeobuf file, for web viewers
+// which only fetch the features in view.
+class FgbRenderer : public Renderer {
+ public:
+  FgbRenderer(std::ostream* o, const config::Config* cfg);
+  virtual ~FgbRenderer(){};
+
+  virtual void print(const shared::rendergraph::RenderGraph& outputGraph);
+
+ private:
+  std::ostream* _o;
+  const config::Config* _cfg;
+
+  void outputNodes(const shared::rendergraph::RenderGraph& outG,
+                   FgbWriter* w) const;
+  void outputEdges(const shared::rendergraph::RenderGraph& outG,
+                   FgbWriter* w) const;
+  void renderNodeConnections(const shared::rendergraph::RenderGraph& outG,
+                             const shared::linegraph::LineNode* n,
+                             FgbWriter* w) const;
+
+  void addLine(const util::geo::PolyLine<double>& geom,
+               const std::string& layer, const shared::linegraph::Line* l,
+               FgbWriter* w) const;
+};
+
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_FGBRENDERER_H_
@@ -0,0 +1,445 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "transitmap/output/FgbWriter.h"
+
+using transitmapper::output::FgbColumn;
+using transitmapper::output::FgbGeomType;
+using transitmapper::output::FgbProps;
+using transitmapper::output::FgbWriter;
+using util::geo::DBox;
+using util::geo::DLine;
+
+namespace {
+
+const static uint32_t HILBERT_MAX = (1 << 16) - 1;
+
+// _____________________________________________________________________________
+template <typename T>
+void putLe(std::string* buf, T v) {
+  uint64_t u = 0;
+  std::memcpy(&u, &v, sizeof(T));
+  for (size_t i = 0; i < sizeof(T); i++) {
+    buf->push_back(static_cast<char>(u >> (8 * i)));
+  }
+}
+
+// Minimal FlatBuffers encoder. Objects are appended behind the tables
+// referencing them, so all offsets point forward as the format requires.
+// Alignment is relative to the start of the buffer, which is the size prefix
+// of a size-prefixed buffer.
+class FbBuf {
+ public:
+  FbBuf() {
+    // size prefix and root offset
+    putLe<uint32_t>(&buf, 0);
+    putLe<uint32_t>(&buf, 0);
+  }
+
+  std::string buf;
+
+  void pad(size_t align) {
+    while (buf.size() % align) buf.push_back(0);
+  }
+
+  // point the offset at position at to position target
+  void patch(size_t at, size_t target) {
+    uint32_t v = target - at;
+    for (size_t i = 0; i < 4; i++) {
+      buf[at + i] = static_cast<char>(v >> (8 * i));
+    }
+  }
+
+  void setRoot(size_t table) { patch(4, table); }
+
+  // the finished buffer, with its size prefix
+  std::string finish() {
+    uint32_t size = buf.size() - 4;
+    for (size_t i = 0; i < 4; i++) buf[i] = static_cast<char>(size >> (8 * i));
+    return buf;
+  }
+
+  size_t str(const std::string& s) {
+    pad(4);
+    size_t ret = buf.size();
+    putLe<uint32_t>(&buf, s.size());
+    buf += s;
+    buf.push_back(0);
+    return ret;
+  }
+
+  // vector of n elements of size elSize, the elements are aligned to their
+  // size, the data is little endian already
+  size_t vec(const char* data, size_t n, size_t elSize) {
+    pad(4);
+    while ((buf.size() + 4) % std::max<size_t>(elSize, 4)) {
+      putLe<uint32_t>(&buf, 0);
+    }
+    size_t ret = buf.size();
+    putLe<uint32_t>(&buf, n);
+    buf.append(data, n * elSize);
+    return ret;
+  }
+
+  size_t vec(const std::vector<double>& v) {
+    std::string d;
+    for (double x : v) putLe(&d, x);
+    return vec(d.data(), v.size(), 8);
+  }
+
+  // vector of n table offsets, the positions of the slots are returned
+  size_t vecOffs(size_t n, std::vector<size_t>* slots) {
+    pad(4);
+    size_t ret = buf.size();
+    putLe<uint32_t>(&buf, n);
+    for (size_t i = 0; i < n; i++) {
+      slots->push_back(buf.size());
+      putLe<uint32_t>(&buf, 0);
+    }
+    return ret;
+  }
+};
+
+// a table with scalar fields and offset fields, the latter are patched once
+// the referenced objects are written
+class FbTable {
+ public:
+  template <typename T>
+  void scalar(uint16_t id, T v) {
+    std::string bytes;
+    putLe(&bytes, v);
+    _fields.push_back({id, bytes});
+  }
+
+  void ref(uint16_t id) { _fields.push_back({id, std::string(4, 0)}); }
+
+  // write the vtable and the table, slots holds the position of each field
+  size_t write(FbBuf* b, std::vector<size_t>* slots) {
+    // wider fields first, so no padding is needed between them
+    std::stable_sort(_fields.begin(), _fields.end(),
+                     [](const Field& x, const Field& y) {
+                       return x.bytes.size() > y.bytes.size();
+                     });
+
+    uint16_t numIds = 0;
+    for (const auto& f : _fields) numIds = std::max<uint16_t>(numIds, f.id + 1);
+
+    std::vector<uint16_t> offs(numIds, 0);
+    size_t off = 4;
+    for (const auto& f : _fields) {
+      while (off % f.bytes.size()) off++;
+      offs[f.id] = off;
+      off += f.bytes.size();
+    }
+
+    b->pad(2);
+    size_t vt = b->buf.size();
+    putLe<uint16_t>(&b->buf, 4 + 2 * numIds);
+    putLe<uint16_t>(&b->buf, off);
+    for (auto o : offs) putLe<uint16_t>(&b->buf, o);
+
+    // the table start is aligned for 8 byte fields
+    b->pad(8);
+    size_t t = b->buf.size();
+    putLe<int32_t>(&b->buf, t - vt);
+    b->buf.resize(t + off, 0);
+    for (const auto& f : _fields) {
+      std::memcpy(&b->buf[t + offs[f.id]], f.bytes.data(), f.bytes.size());
+    }
+
+    slots->assign(numIds, 0);
+    for (uint16_t i = 0; i < numIds; i++) {
+      if (offs[i]) (*slots)[i] = t + offs[i];
+    }
+    return t;
+  }
+
+ private:
+  struct Field {
+    uint16_t id;
+    std::string bytes;
+  };
+  std::vector<Field> _fields;
+};
+
+// _____________________________________________________________________________
+uint32_t interleave(uint32_t x) {
+  x = (x | (x << 8)) & 0x00FF00FF;
+  x = (x | (x << 4)) & 0x0F0F0F0F;
+  x = (x | (x << 2)) & 0x33333333;
+  x = (x | (x << 1)) & 0x55555555;
+  return x;
+}
+
+struct IndexNode {
+  double minX, minY, maxX, maxY;
+  uint64_t offset;
+
+  void expand(const IndexNode& o) {
+    minX = std::min(minX, o.minX);
+    minY = std::min(minY, o.minY);
+    maxX = std::max(maxX, o.maxX);
+    maxY = std::max(maxY, o.maxY);
+  }
+};
+
+}  // namespace
+
+// _____________________________________________________________________________
+void FgbProps::add(uint16_t col, const std::string& val) {
+  putLe(&_buf, col);
+  putLe<uint32_t>(&_buf, val.size());
+  _buf += val;
+}
+
+// _____________________________________________________________________________
+void FgbProps::add(uint16_t col, double val) {
+  putLe(&_buf, col);
+  putLe(&_buf, val);
+}
+
+// _____________________________________________________________________________
+void FgbProps::add(uint16_t col, int32_t val) {
+  putLe(&_buf, col);
+  putLe(&_buf, val);
+}
+
+// _____________________________________________________________________________
+FgbWriter::FgbWriter(const std::string& name,
+                     const std::vector<FgbColumn>& cols)
+    : _name(name), _cols(cols) {}
+
+// _____________________________________________________________________________
+void FgbWriter::add(FgbGeomType type, const DLine& geom,
+                    const FgbProps& props) {
+  if (geom.empty()) return;
+
+  std::vector<double> xy;
+  xy.reserve(geom.size() * 2 + 2);
+  for (const auto& p : geom) {
+    xy.push_back(p.getX());
+    xy.push_back(p.getY());
+  }
+
+  if (type == FGB_POLYGON && (geom.front().getX() != geom.back().getX() ||
+                              geom.front().getY() != geom.back().getY())) {
+    xy.push_back(geom.front().getX());
+    xy.push_back(geom.front().getY());
+  }
+
+  FbBuf b;
+
+  FbTable feat;
+  feat.ref(0);
+  if (props.buf().size()) feat.ref(1);
+  std::vector<size_t> featSlots;
+  b.setRoot(feat.write(&b, &featSlots));
+
+  FbTable g;
+  g.ref(1);
+  g.scalar<uint8_t>(6, type);
+  std::vector<size_t> geomSlots;
+  b.patch(featSlots[0], g.write(&b, &geomSlots));
+  b.patch(geomSlots[1], b.vec(xy));
+
+  if (props.buf().size()) {
+    b.patch(featSlots[1],
+            b.vec(props.buf().data(), props.buf().size(), 1));
+  }
+
+  DBox box = util::geo::getBoundingBox(geom);
+  _box = util::geo::extendBox(box, _box);
+  _feats.push_back({box, b.finish()});
+}
+
+// _____________________________________________________________________________
+std::string FgbWriter::header() const {
+  FbBuf b;
+
+  FbTable h;
+  h.ref(0);
+  h.ref(1);
+  h.ref(7);
+  h.scalar<uint64_t>(8, _feats.size());
+  h.scalar<uint16_t>(9, _feats.size() ? FGB_INDEX_NODE_SIZE : 0);
+  h.ref(10);
+  std::vector<size_t> slots;
+  b.setRoot(h.write(&b, &slots));
+
+  b.patch(slots[0], b.str(_name));
+
+  std::vector<double> env = {0, 0, 0, 0};
+  if (_feats.size()) {
+    env = {_box.getLowerLeft().getX(), _box.getLowerLeft().getY(),
+           _box.getUpperRight().getX(), _box.getUpperRight().getY()};
+  }
+  b.patch(slots[1], b.vec(env));
+
+  std::vector<size_t> colSlots;
+  b.patch(slots[7], b.vecOffs(_cols.size(), &colSlots));
+  for (size_t i = 0; i < _cols.size(); i++) {
+    FbTable col;
+    col.ref(0);
+    col.scalar<uint8_t>(1, _cols[i].type);
+    std::vector<size_t> s;
+    b.patch(colSlots[i], col.write(&b, &s));
+    b.patch(s[0], b.str(_cols[i].name));
+  }
+
+  FbTable crs;
+  crs.ref(0);
+  crs.scalar<int32_t>(1, 4326);
+  std::vector<size_t> crsSlots;
+  b.patch(slots[10], crs.write(&b, &crsSlots));
+  b.patch(crsSlots[0], b.str("EPSG"));
+
+  return b.finish();
+}
+
+// _____________________________________________________________________________
+void FgbWriter::write(std::ostream* out) const {
+  out->write(FGB_MAGIC, 8);
+  std::string h = header();
+  out->write(h.data(), h.size());
+
+  size_t n = _feats.size();
+  if (n == 0) {
+    out->flush();
+    return;
+  }
+
+  // Hilbert order of the bounding box centers
+  double w = _box.getUpperRight().getX() - _box.getLowerLeft().getX();
+  double hgt = _box.getUpperRight().getY() - _box.getLowerLeft().getY();
+  std::vector<std::pair<uint32_t, size_t>> order(n);
+  for (size_t i = 0; i < n; i++) {
+    const auto& b = _feats[i].box;
+    double cx = (b.getLowerLeft().getX() + b.getUpperRight().getX()) / 2;
+    double cy = (b.getLowerLeft().getY() + b.getUpperRight().getY()) / 2;
+    uint32_t x = w > 0 ? std::floor(HILBERT_MAX *
+                                    (cx - _box.getLowerLeft().getX()) / w)
+                       : 0;
+    uint32_t y = hgt > 0 ? std::floor(HILBERT_MAX *
+                                      (cy - _box.getLowerLeft().getY()) / hgt)
+                         : 0;
+    order[i] = {hilbert(x, y), i};
+  }
+  std::sort(order.begin(), order.end());
+
+  // level bounds of the packed tree, the leaves are stored last
+  std::vector<size_t> levelNodes = {n};
+  size_t numNodes = n;
+  size_t k = n;
+  do {
+    k = (k + FGB_INDEX_NODE_SIZE - 1) / FGB_INDEX_NODE_SIZE;
+    numNodes += k;
+    levelNodes.push_back(k);
+  } while (k != 1);
+
+  std::vector<std::pair<size_t, size_t>> levels;
+  size_t end = numNodes;
+  for (size_t cnt : levelNodes) {
+    levels.push_back({end - cnt, end});
+    end -= cnt;
+  }
+
+  std::vector<IndexNode> nodes(numNodes);
+  uint64_t off = 0;
+  for (size_t i = 0; i < n; i++) {
+    const auto& f = _feats[order[i].second];
+    nodes[levels[0].first + i] = {
+        f.box.getLowerLeft().getX(), f.box.getLowerLeft().getY(),
+        f.box.getUpperRight().getX(), f.box.getUpperRight().getY(), off};
+    off += f.buf.size();
+  }
+
+  // inner nodes point to the index of their first child
+  for (size_t i = 0; i + 1 < levels.size(); i++) {
+    size_t pos = levels[i].first;
+    size_t newPos = levels[i + 1].first;
+    while (pos < levels[i].second) {
+      IndexNode nd = {std::numeric_limits<double>::infinity(),
+                      std::numeric_limits<double>::infinity(),
+                      -std::numeric_limits<double>::infinity(),
+                      -std::numeric_limits<double>::infinity(), pos};
+      for (size_t j = 0; j < FGB_INDEX_NODE_SIZE && pos < levels[i].second;
+           j++) {
+        nd.expand(nodes[pos++]);
+      }
+      nodes[newPos++] = nd;
+    }
+  }
+
+  std::string idx;
+  idx.reserve(numNodes * 40);
+  for (const auto& nd : nodes) {
+    putLe(&idx, nd.minX);
+    putLe(&idx, nd.minY);
+    putLe(&idx, nd.maxX);
+    putLe(&idx, nd.maxY);
+    putLe(&idx, nd.offset);
+  }
+  out->write(idx.data(), idx.size());
+
+  for (const auto& o : order) {
+    const auto& f = _feats[o.second];
+    out->write(f.buf.data(), f.buf.size());
+  }
+  out->flush();
+}
+
+// _____________________________________________________________________________
+uint32_t FgbWriter::hilbert(uint32_t x, uint32_t y) {
+  // Hilbert curve index of 16 bit coordinates, after
+  // http://threadlocalmutex.com/?p=126
+  uint32_t a = x ^ y;
+  uint32_t b = 0xFFFF ^ a;
+  uint32_t c = 0xFFFF ^ (x | y);
+  uint32_t d = x & (y ^ 0xFFFF);
+
+  uint32_t A = a | (b >> 1);
+  uint32_t B = (a >> 1) ^ a;
+  uint32_t C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+  uint32_t D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = ((a & (a >> 2)) ^ (b & (b >> 2)));
+  B = ((a & (b >> 2)) ^ (b & ((a ^ b) >> 2)));
+  C ^= ((a & (c >> 2)) ^ (b & (d >> 2)));
+  D ^= ((b & (c >> 2)) ^ ((a ^ b) & (d >> 2)));
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = ((a & (a >> 4)) ^ (b & (b >> 4)));
+  B = ((a & (b >> 4)) ^ (b & ((a ^ b) >> 4)));
+  C ^= ((a & (c >> 4)) ^ (b & (d >> 4)));
+  D ^= ((b & (c >> 4)) ^ ((a ^ b) & (d >> 4)));
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  C ^= ((a & (c >> 8)) ^ (b & (d >> 8)));
+  D ^= ((b & (c >> 8)) ^ ((a ^ b) & (d >> 8)));
+
+  a = C ^ (C >> 1);
+  b = D ^ (D >> 1);
+
+  uint32_t i0 = x ^ y;
+  uint32_t i1 = b | (0xFFFF ^ (i0 | a));
+
+  return (interleave(i1) << 1) | interleave(i0);
+}
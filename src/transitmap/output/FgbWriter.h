@@ -0,0 +1,92 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_FGBWRITER_H_
+#define TRANSITMAP_OUTPUT_FGBWRITER_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "util/geo/Geo.h"
+
+namespace transitmapper {
+namespace output {
+
+// Writer for FlatGeobuf (v3) files with a packed Hilbert R-tree index.
+//
+// Features are encoded as they are added and kept in memory, write() sorts
+// them along a Hilbert curve of their bounding box centers and writes the
+// header, the index and the features. The FlatBuffers tables of the format
+// are encoded by hand, only the fields used here are written. Coordinates
+// are WGS84 longitudes and latitudes.
+
+static const char FGB_MAGIC[8] = {'f', 'g', 'b', 3, 'f', 'g', 'b', 0};
+static const uint16_t FGB_INDEX_NODE_SIZE = 16;
+
+enum FgbGeomType : uint8_t {
+  FGB_UNKNOWN = 0,
+  FGB_POINT = 1,
+  FGB_LINESTRING = 2,
+  FGB_POLYGON = 3
+};
+
+enum FgbColType : uint8_t {
+  FGB_COL_INT = 5,
+  FGB_COL_DOUBLE = 10,
+  FGB_COL_STRING = 11
+};
+
+struct FgbColumn {
+  std::string name;
+  FgbColType type;
+};
+
+// properties of a single feature, by column index. Each column should be
+// given at most once, in the type of the column
+class FgbProps {
+ public:
+  void add(uint16_t col, const std::string& val);
+  void add(uint16_t col, double val);
+  void add(uint16_t col, int32_t val);
+
+  const std::string& buf() const { return _buf; }
+
+ private:
+  std::string _buf;
+};
+
+class FgbWriter {
+ public:
+  FgbWriter(const std::string& name, const std::vector<FgbColumn>& cols);
+
+  // polygons are given by their outer ring, which is closed if needed
+  void add(FgbGeomType type, const util::geo::DLine& geom,
+           const FgbProps& props);
+
+  size_t numFeatures() const { return _feats.size(); }
+
+  void write(std::ostream* out) const;
+
+  static uint32_t hilbert(uint32_t x, uint32_t y);
+
+ private:
+  struct Feature {
+    util::geo::DBox box;
+    std::string buf;
+  };
+
+  std::string _name;
+  std::vector<FgbColumn> _cols;
+  std::vector<Feature> _feats;
+  util::geo::DBox _box;
+
+  std::string header() const;
+};
+
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_FGBWRITER_H_
@@ -0,0 +1,187 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+#include "shared/rendergraph/RenderGraph.h"
+#include "transitmap/output/InnerCliques.h"
+
+using shared::linegraph::LineEdge;
+using shared::linegraph::LineNode;
+using shared::rendergraph::InnerGeom;
+using shared::rendergraph::RenderGraph;
+using transitmapper::output::InnerClique;
+
+namespace {
+
+// _____________________________________________________________________________
+size_t find(std::vector<size_t>* parent, size_t i) {
+  while ((*parent)[i] != i) {
+    (*parent)[i] = (*parent)[(*parent)[i]];
+    i = (*parent)[i];
+  }
+  return i;
+}
+
+// _____________________________________________________________________________
+void unite(std::vector<size_t>* parent, size_t a, size_t b) {
+  a = find(parent, a);
+  b = find(parent, b);
+
+  // the smallest pool index is the root, it starts the clique
+  if (a < b) (*parent)[b] = a;
+  if (b < a) (*parent)[a] = b;
+}
+
+// _____________________________________________________________________________
+int normSlot(const LineEdge* e, size_t slot, const LineNode* nd) {
+  if (e->getTo() != nd) return slot;
+  return e->pl().getLines().size() - 1 - slot;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________
+std::multiset<InnerClique> transitmapper::output::getInnerCliques(
+    const LineNode* n, const std::vector<InnerGeom>& pool, size_t level) {
+  std::vector<size_t> parent(pool.size());
+  std::iota(parent.begin(), parent.end(), 0);
+
+  // geometries next to each other connect the same two edges. With slots
+  // normalized to the shared node and the edge pair ordered, their slot sums
+  // are equal and their first slots differ by one
+  std::vector<std::tuple<const LineEdge*, const LineEdge*, int, int, size_t>>
+      nexts;
+
+  for (size_t i = 0; i < pool.size(); i++) {
+    const auto& g = pool[i];
+    if (!g.from.edge || !g.to.edge) continue;
+    auto nd = RenderGraph::sharedNode(g.from.edge, g.to.edge);
+    int sFrom = normSlot(g.from.edge, g.slotFrom, nd);
+    int sTo = normSlot(g.to.edge, g.slotTo, nd);
+
+    // for a loop edge, both slots may be the first one
+    if (g.from.edge <= g.to.edge) {
+      nexts.push_back({g.from.edge, g.to.edge, sFrom + sTo, sFrom, i});
+    }
+    if (g.to.edge <= g.from.edge) {
+      nexts.push_back({g.to.edge, g.from.edge, sFrom + sTo, sTo, i});
+    }
+  }
+
+  std::sort(nexts.begin(), nexts.end());
+
+  for (size_t a = 0; a < nexts.size(); a++) {
+    const auto& ka = nexts[a];
+    for (size_t b = a + 1; b < nexts.size(); b++) {
+      const auto& kb = nexts[b];
+      if (std::get<0>(kb) != std::get<0>(ka) ||
+          std::get<1>(kb) != std::get<1>(ka) ||
+          std::get<2>(kb) != std::get<2>(ka) ||
+          std::get<3>(kb) > std::get<3>(ka) + 1)
+        break;
+      if (std::get<3>(kb) != std::get<3>(ka) + 1) continue;
+
+      const auto& ga = pool[std::get<4>(ka)];
+      const auto& gb = pool[std::get<4>(kb)];
+      if (isNextTo(ga, gb) || isNextTo(gb, ga))
+        unite(&parent, std::get<4>(ka), std::get<4>(kb));
+    }
+  }
+
+  if (level > 1) {
+    // geometries with the same origin share an edge slot, only geometries
+    // in the same (edge, slot) bucket are tested
+    std::vector<std::tuple<const LineEdge*, size_t, size_t>> slots;
+    for (size_t i = 0; i < pool.size(); i++) {
+      slots.push_back({pool[i].from.edge, pool[i].slotFrom, i});
+      slots.push_back({pool[i].to.edge, pool[i].slotTo, i});
+    }
+
+    std::sort(slots.begin(), slots.end());
+
+    for (size_t a = 0; a < slots.size(); a++) {
+      for (size_t b = a + 1; b < slots.size(); b++) {
+        if (std::get<0>(slots[b]) != std::get<0>(slots[a]) ||
+            std::get<1>(slots[b]) != std::get<1>(slots[a]))
+          break;
+
+        size_t ia = std::get<2>(slots[a]);
+        size_t ib = std::get<2>(slots[b]);
+        if (ia == ib || find(&parent, ia) == find(&parent, ib)) continue;
+        if (hasSameOrigin(pool[ia], pool[ib]) ||
+            hasSameOrigin(pool[ib], pool[ia]))
+          unite(&parent, ia, ib);
+      }
+    }
+  }
+
+  // cliques are started in pool order, their geometries keep it
+  std::vector<InnerClique> cliques;
+  std::vector<size_t> cliqueOf(pool.size());
+  for (size_t i = 0; i < pool.size(); i++) {
+    size_t root = find(&parent, i);
+    if (root == i) {
+      cliqueOf[i] = cliques.size();
+      cliques.push_back(InnerClique(n, pool[i]));
+    } else {
+      cliques[cliqueOf[root]].geoms.push_back(pool[i]);
+    }
+  }
+
+  return std::multiset<InnerClique>(cliques.begin(), cliques.end());
+}
+
+// _____________________________________________________________________________
+bool transitmapper::output::isNextTo(const InnerGeom& a, const InnerGeom& b) {
+  if (!a.from.edge) return false;
+  if (!b.from.edge) return false;
+  if (!a.to.edge) return false;
+  if (!b.to.edge) return false;
+
+  auto nd = RenderGraph::sharedNode(a.from.edge, a.to.edge);
+
+  int aSlotFrom = normSlot(a.from.edge, a.slotFrom, nd);
+  int aSlotTo = normSlot(a.to.edge, a.slotTo, nd);
+  int bSlotFrom = normSlot(b.from.edge, b.slotFrom, nd);
+  int bSlotTo = normSlot(b.to.edge, b.slotTo, nd);
+
+  if (a.from.edge == b.from.edge && a.to.edge == b.to.edge) {
+    if ((aSlotFrom - bSlotFrom == 1 && bSlotTo - aSlotTo == 1) ||
+        (bSlotFrom - aSlotFrom == 1 && aSlotTo - bSlotTo == 1)) {
+      return true;
+    }
+  }
+
+  if (a.to.edge == b.from.edge && a.from.edge == b.to.edge) {
+    if ((aSlotFrom - bSlotTo == 1 && bSlotFrom - aSlotTo == 1) ||
+        (bSlotTo - aSlotFrom == 1 && aSlotTo - bSlotFrom == 1)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// _____________________________________________________________________________
+bool transitmapper::output::hasSameOrigin(const InnerGeom& a,
+                                          const InnerGeom& b) {
+  if (a.from.edge == b.from.edge) {
+    return a.slotFrom == b.slotFrom;
+  }
+  if (a.to.edge == b.from.edge) {
+    return a.slotTo == b.slotFrom;
+  }
+  if (a.to.edge == b.to.edge) {
+    return a.slotTo == b.slotTo;
+  }
+  if (a.from.edge == b.to.edge) {
+    return a.slotFrom == b.slotTo;
+  }
+
+  return false;
+}
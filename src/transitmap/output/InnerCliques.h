@@ -0,0 +1,38 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_INNERCLIQUES_H_
+#define TRANSITMAP_OUTPUT_INNERCLIQUES_H_
+
+#include <set>
+#include <vector>
+
+#include "shared/linegraph/LineGraph.h"
+#include "shared/rendergraph/RenderGraph.h"
+#include "transitmap/output/Renderer.h"
+
+namespace transitmapper {
+namespace output {
+
+// Group the inner geometries of node n into cliques of neighboring
+// connections. Two geometries are in the same clique if they are connected
+// by a chain of geometries next to each other and, for level > 1, of
+// geometries with the same origin slot. Candidates are found by sorting,
+// not by testing all pairs.
+std::multiset<InnerClique> getInnerCliques(
+    const shared::linegraph::LineNode* n,
+    const std::vector<shared::rendergraph::InnerGeom>& pool, size_t level);
+
+// true if a and b connect the same edges in neighboring slots
+bool isNextTo(const shared::rendergraph::InnerGeom& a,
+              const shared::rendergraph::InnerGeom& b);
+
+// true if a and b start or end in the same slot of an edge
+bool hasSameOrigin(const shared::rendergraph::InnerGeom& a,
+                   const shared::rendergraph::InnerGeom& b);
+
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_INNERCLIQUES_H_
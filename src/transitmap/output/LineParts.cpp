@@ -0,0 +1,162 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cassert>
+#include <set>
+#include <vector>
+
+#include "shared/rendergraph/RenderGraph.h"
+#include "transitmap/output/InnerCliques.h"
+#include "transitmap/output/LineParts.h"
+
+using shared::linegraph::LineEdge;
+using shared::linegraph::LineNode;
+using shared::linegraph::NodeFront;
+using shared::rendergraph::InnerGeom;
+using shared::rendergraph::RenderGraph;
+using transitmapper::output::EdgeLinePart;
+using transitmapper::output::InnerClique;
+using util::geo::LinePoint;
+using util::geo::LinePointCmp;
+using util::geo::PolyLine;
+
+// _____________________________________________________________________________
+std::vector<const LineEdge*> transitmapper::output::getEdgeOrder(
+    const RenderGraph& g) {
+  struct cmp {
+    bool operator()(const LineNode* lhs, const LineNode* rhs) const {
+      return lhs->getAdjList().size() > rhs->getAdjList().size() ||
+             (lhs->getAdjList().size() == rhs->getAdjList().size() &&
+              RenderGraph::getConnCardinality(lhs) >
+                  RenderGraph::getConnCardinality(rhs)) ||
+             (lhs->getAdjList().size() == rhs->getAdjList().size() &&
+              lhs > rhs);
+    }
+  };
+
+  struct cmpEdge {
+    bool operator()(const LineEdge* lhs, const LineEdge* rhs) const {
+      return lhs->pl().getLines().size() < rhs->pl().getLines().size() ||
+             (lhs->pl().getLines().size() == rhs->pl().getLines().size() &&
+              lhs < rhs);
+    }
+  };
+
+  std::set<const LineNode*, cmp> nodesOrdered;
+  std::set<const LineEdge*, cmpEdge> edgesOrdered;
+  for (auto nd : g.getNds()) nodesOrdered.insert(nd);
+
+  std::set<const LineEdge*> rendered;
+  std::vector<const LineEdge*> ret;
+
+  for (const auto n : nodesOrdered) {
+    edgesOrdered.insert(n->getAdjList().begin(), n->getAdjList().end());
+
+    for (const auto* e : edgesOrdered) {
+      if (rendered.insert(e).second) ret.push_back(e);
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<EdgeLinePart> transitmapper::output::getEdgeLineParts(
+    const RenderGraph& g, const LineEdge* e, double lineW, double outlineW,
+    double lineSpc) {
+  const NodeFront* nfTo = e->getTo()->pl().frontFor(e);
+  const NodeFront* nfFrom = e->getFrom()->pl().frontFor(e);
+
+  assert(nfTo);
+  assert(nfFrom);
+
+  std::vector<EdgeLinePart> ret;
+
+  PolyLine<double> center(*e->pl().getGeom());
+  if (center.getLength() < 0.01) return ret;
+
+  double offsetStep = lineW + 2.0 * outlineW + lineSpc;
+  double oo = g.getTotalWidth(e);
+
+  double o = oo;
+
+  for (size_t i = 0; i < e->pl().getLines().size(); i++) {
+    PolyLine<double> p = center;
+
+    double offset = -(o - oo / 2.0 - (2.0 * outlineW + lineW) / 2.0);
+
+    p.offsetPerp(offset);
+
+    auto iSects = nfTo->geom.getIntersections(p);
+    if (iSects.size() > 0) {
+      p = p.getSegment(0, iSects.begin()->totalPos);
+    } else {
+      p << nfTo->geom.projectOn(p.back()).p;
+    }
+
+    auto iSects2 = nfFrom->geom.getIntersections(p);
+    if (iSects2.size() > 0) {
+      p = p.getSegment(iSects2.begin()->totalPos, 1);
+    } else {
+      p >> nfFrom->geom.projectOn(p.front()).p;
+    }
+
+    ret.push_back({p, i});
+
+    o -= offsetStep;
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<InnerGeom> transitmapper::output::getCliqueGeoms(
+    const InnerClique& cc, const LineNode* n, double lineW, double outlineW,
+    double lineSpc) {
+  std::vector<InnerGeom> ret;
+
+  for (const auto& c : getInnerCliques(n, cc.geoms, 0)) {
+    // the longest geom will be the ref geom
+    InnerGeom ref = c.geoms[0];
+    for (size_t i = 1; i < c.geoms.size(); i++) {
+      if (c.geoms[i].geom.getLength() > ref.geom.getLength()) ref = c.geoms[i];
+    }
+
+    for (size_t i = 0; i < c.geoms.size(); i++) {
+      ret.push_back(c.geoms[i]);
+      PolyLine<double>& pl = ret.back().geom;
+
+      if (ref.geom.getLength() > (lineW + 2 * outlineW + lineSpc) * 4) {
+        double off = -(lineW + lineSpc + 2 * outlineW) *
+                     (static_cast<int>(c.geoms[i].slotFrom) -
+                      static_cast<int>(ref.slotFrom));
+
+        if (ref.from.edge->getTo() == n) off = -off;
+
+        pl = ref.geom.offsetted(off);
+
+        if (pl.getLength() / c.geoms[i].geom.getLength() > 1.5)
+          pl = c.geoms[i].geom;
+
+        std::set<LinePoint<double>, LinePointCmp<double>> a;
+        std::set<LinePoint<double>, LinePointCmp<double>> b;
+
+        if (ref.from.edge)
+          a = n->pl().frontFor(ref.from.edge)->geom.getIntersections(pl);
+        if (ref.to.edge)
+          b = n->pl().frontFor(ref.to.edge)->geom.getIntersections(pl);
+
+        if (a.size() > 0 && b.size() > 0) {
+          pl = pl.getSegment(a.begin()->totalPos, b.begin()->totalPos);
+        } else if (a.size() > 0) {
+          pl = pl.getSegment(a.begin()->totalPos, 1);
+        } else if (b.size() > 0) {
+          pl = pl.getSegment(0, b.begin()->totalPos);
+        }
+      }
+    }
+  }
+
+  return ret;
+}
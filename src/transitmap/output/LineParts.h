@@ -0,0 +1,49 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_LINEPARTS_H_
+#define TRANSITMAP_OUTPUT_LINEPARTS_H_
+
+#include <vector>
+
+#include "shared/linegraph/LineGraph.h"
+#include "shared/rendergraph/RenderGraph.h"
+#include "transitmap/output/Renderer.h"
+#include "util/geo/PolyLine.h"
+
+// Backend-independent geometry of rendered lines. The SVG, PNG and MVT
+// renderers only encode and style these geometries. All widths are given in
+// the units of the render graph.
+
+namespace transitmapper {
+namespace output {
+
+// the geometry of the line at position pos of an edge, offset to its slot
+// and cropped to the node fronts
+struct EdgeLinePart {
+  util::geo::PolyLine<double> geom;
+  size_t pos;
+};
+
+// edges in rendering order: edges at nodes with higher degree and more
+// connections first, thinner edges first at each node
+std::vector<const shared::linegraph::LineEdge*> getEdgeOrder(
+    const shared::rendergraph::RenderGraph& g);
+
+std::vector<EdgeLinePart> getEdgeLineParts(
+    const shared::rendergraph::RenderGraph& g,
+    const shared::linegraph::LineEdge* e, double lineW, double outlineW,
+    double lineSpc);
+
+// the inner geometries of clique cc at node n in rendering order. Geometries
+// of a long enough clique are offset from its longest geometry, so parallel
+// connections stay parallel, and cropped to the node fronts
+std::vector<shared::rendergraph::InnerGeom> getCliqueGeoms(
+    const InnerClique& cc, const shared::linegraph::LineNode* n, double lineW,
+    double outlineW, double lineSpc);
+
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_LINEPARTS_H_
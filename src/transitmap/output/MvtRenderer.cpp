@@ -8,12 +8,15 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <fstream>
 #include <ostream>
 
 #include "shared/linegraph/Line.h"
 #include "shared/rendergraph/RenderGraph.h"
 #include "transitmap/config/TransitMapConfig.h"
+#include "transitmap/output/InnerCliques.h"
+#include "transitmap/output/LineParts.h"
 #include "transitmap/output/MvtRenderer.h"
 #include "transitmap/output/protobuf/vector_tile.pb.h"
 #include "util/String.h"
@@ -26,7 +29,18 @@ using shared::rendergraph::InnerGeom;
 using shared::rendergraph::RenderGraph;
 using transitmapper::label::Labeller;
 using transitmapper::output::InnerClique;
+using transitmapper::output::getCliqueGeoms;
+using transitmapper::output::getEdgeLineParts;
+using transitmapper::output::getEdgeOrder;
+using transitmapper::output::getInnerCliques;
+using transitmapper::output::MVT_INNER;
+using transitmapper::output::MVT_LINES;
+using transitmapper::output::MVT_NUM_LAYERS;
+using transitmapper::output::MVT_STATIONS;
+using transitmapper::output::MvtLayer;
+using transitmapper::output::MvtLineFeature;
 using transitmapper::output::MvtRenderer;
+using transitmapper::output::MvtTileDict;
 using util::geo::Box;
 using util::geo::DPoint;
 using util::geo::DPolygon;
@@ -55,12 +69,12 @@ const static double GRID2_W =
 
 // _____________________________________________________________________________
 MvtRenderer::MvtRenderer(const config::Config* cfg, size_t zoom)
-    : _cfg(cfg), _zoom(zoom) {
-  _grid = new size_t[GRID_SIZE * GRID_SIZE];
-  for (size_t i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-    _grid[i] = std::numeric_limits<uint32_t>::max();
-  }
+    : MvtRenderer(cfg, zoom, 0) {}
 
+// _____________________________________________________________________________
+MvtRenderer::MvtRenderer(const config::Config* cfg, size_t zoom,
+                         PmTilesWriter* archive)
+    : _cfg(cfg), _zoom(zoom), _archive(archive) {
   _grid2 = new size_t[GRID2_SIZE * GRID2_SIZE];
   for (size_t i = 0; i < GRID2_SIZE * GRID2_SIZE; i++) {
     _grid2[i] = std::numeric_limits<uint32_t>::max();
@@ -114,7 +128,7 @@ void MvtRenderer::outputNodes(const RenderGraph& outG) {
         params["component"] = util::toString(n->pl().getComponent());
 
       for (const auto& geom : outG.getStopGeoms(n, _cfg->tightStations, 32)) {
-        addFeature({geom.getOuter(), "stations", params});
+        addFeature(geom.getOuter(), MVT_STATIONS, params);
       }
     }
   }
@@ -132,51 +146,19 @@ void MvtRenderer::renderNodeFronts(const RenderGraph& outG) {
       params["lineCap"] = "round";
       params["width"] = "2";
 
-      addFeature({p.getLine(), "lines", params});
+      addFeature(p.getLine(), MVT_LINES, params);
 
       DPoint a = p.getPointAt(.5).p;
 
-      addFeature(
-          {PolyLine<double>(*n->pl().getGeom(), a).getLine(), "lines", params});
+      addFeature(PolyLine<double>(*n->pl().getGeom(), a).getLine(), MVT_LINES,
+                 params);
     }
   }
 }
 
 // _____________________________________________________________________________
 void MvtRenderer::outputEdges(const RenderGraph& outG) {
-  struct cmp {
-    bool operator()(const LineNode* lhs, const LineNode* rhs) const {
-      return lhs->getAdjList().size() > rhs->getAdjList().size() ||
-             (lhs->getAdjList().size() == rhs->getAdjList().size() &&
-              RenderGraph::getConnCardinality(lhs) >
-                  RenderGraph::getConnCardinality(rhs)) ||
-             (lhs->getAdjList().size() == rhs->getAdjList().size() &&
-              lhs > rhs);
-    }
-  };
-
-  struct cmpEdge {
-    bool operator()(const shared::linegraph::LineEdge* lhs,
-                    const shared::linegraph::LineEdge* rhs) const {
-      return lhs->pl().getLines().size() < rhs->pl().getLines().size() ||
-             (lhs->pl().getLines().size() == rhs->pl().getLines().size() &&
-              lhs < rhs);
-    }
-  };
-
-  std::set<const LineNode*, cmp> nodesOrdered;
-  std::set<const shared::linegraph::LineEdge*, cmpEdge> edgesOrdered;
-  for (auto nd : outG.getNds()) nodesOrdered.insert(nd);
-
-  std::set<const shared::linegraph::LineEdge*> rendered;
-
-  for (const auto n : nodesOrdered) {
-    edgesOrdered.insert(n->getAdjList().begin(), n->getAdjList().end());
-
-    for (const auto* e : edgesOrdered) {
-      if (rendered.insert(e).second) renderEdgeTripGeom(outG, e);
-    }
-  }
+  for (const auto* e : getEdgeOrder(outG)) renderEdgeTripGeom(outG, e);
 }
 
 // _____________________________________________________________________________
@@ -187,243 +169,54 @@ void MvtRenderer::renderNodeConnections(const RenderGraph& outG,
   for (auto& clique : getInnerCliques(n, geoms, 9999)) renderClique(clique, n);
 }
 
-// _____________________________________________________________________________
-std::multiset<InnerClique> MvtRenderer::getInnerCliques(
-    const shared::linegraph::LineNode* n, std::vector<InnerGeom> pool,
-    size_t level) const {
-  std::multiset<InnerClique> ret;
-
-  // start with the first geom in pool
-  while (!pool.empty()) {
-    InnerClique cur(n, pool.front());
-    pool.erase(pool.begin());
-
-    size_t p;
-    while ((p = getNextPartner(cur, pool, level)) < pool.size()) {
-      cur.geoms.push_back(pool[p]);
-      pool.erase(pool.begin() + p);
-    }
-
-    ret.insert(cur);
-  }
-
-  return ret;
-}
-
-// _____________________________________________________________________________
-size_t MvtRenderer::getNextPartner(const InnerClique& forClique,
-                                   const std::vector<InnerGeom>& pool,
-                                   size_t level) const {
-  for (size_t i = 0; i < pool.size(); i++) {
-    const auto& ic = pool[i];
-    for (auto& ciq : forClique.geoms) {
-      if (isNextTo(ic, ciq) || (level > 1 && hasSameOrigin(ic, ciq))) {
-        return i;
-      }
-    }
-  }
-
-  return pool.size();
-}
-
-// _____________________________________________________________________________
-bool MvtRenderer::isNextTo(const InnerGeom& a, const InnerGeom& b) const {
-  double THRESHOLD = 0.5 * M_PI + 0.1;
-
-  if (!a.from.edge) return false;
-  if (!b.from.edge) return false;
-  if (!a.to.edge) return false;
-  if (!b.to.edge) return false;
-
-  auto nd = RenderGraph::sharedNode(a.from.edge, a.to.edge);
-
-  assert(a.from.edge);
-  assert(b.from.edge);
-  assert(a.to.edge);
-  assert(b.to.edge);
-
-  bool aFromInv = a.from.edge->getTo() == nd;
-  bool bFromInv = b.from.edge->getTo() == nd;
-  bool aToInv = a.to.edge->getTo() == nd;
-  bool bToInv = b.to.edge->getTo() == nd;
-
-  int aSlotFrom = !aFromInv
-                      ? a.slotFrom
-                      : (a.from.edge->pl().getLines().size() - 1 - a.slotFrom);
-  int aSlotTo =
-      !aToInv ? a.slotTo : (a.to.edge->pl().getLines().size() - 1 - a.slotTo);
-  int bSlotFrom = !bFromInv
-                      ? b.slotFrom
-                      : (b.from.edge->pl().getLines().size() - 1 - b.slotFrom);
-  int bSlotTo =
-      !bToInv ? b.slotTo : (b.to.edge->pl().getLines().size() - 1 - b.slotTo);
-
-  if (a.from.edge == b.from.edge && a.to.edge == b.to.edge) {
-    if ((aSlotFrom - bSlotFrom == 1 && bSlotTo - aSlotTo == 1) ||
-        (bSlotFrom - aSlotFrom == 1 && aSlotTo - bSlotTo == 1)) {
-      return true;
-      double ang1 = fabs(util::geo::angBetween(a.geom.front(), a.geom.back()));
-      double ang2 = fabs(util::geo::angBetween(b.geom.front(), b.geom.back()));
-
-      return ang1 > THRESHOLD && ang2 > THRESHOLD;
-    }
-  }
-
-  if (a.to.edge == b.from.edge && a.from.edge == b.to.edge) {
-    if ((aSlotFrom - bSlotTo == 1 && bSlotFrom - aSlotTo == 1) ||
-        (bSlotTo - aSlotFrom == 1 && aSlotTo - bSlotFrom == 1)) {
-      return true;
-      double ang1 = fabs(util::geo::angBetween(a.geom.front(), a.geom.back()));
-      double ang2 = fabs(util::geo::angBetween(b.geom.front(), b.geom.back()));
-
-      return ang1 > THRESHOLD && ang2 > THRESHOLD;
-    }
-  }
-
-  return false;
-}
-
-// _____________________________________________________________________________
-bool MvtRenderer::hasSameOrigin(const InnerGeom& a, const InnerGeom& b) const {
-  if (a.from.edge == b.from.edge) {
-    return a.slotFrom == b.slotFrom;
-  }
-  if (a.to.edge == b.from.edge) {
-    return a.slotTo == b.slotFrom;
-  }
-  if (a.to.edge == b.to.edge) {
-    return a.slotTo == b.slotTo;
-  }
-  if (a.from.edge == b.to.edge) {
-    return a.slotFrom == b.slotTo;
-  }
-
-  return false;
-}
-
 // _____________________________________________________________________________
 void MvtRenderer::renderClique(const InnerClique& cc, const LineNode* n) {
-  std::multiset<InnerClique> renderCliques = getInnerCliques(n, cc.geoms, 0);
-  for (const auto& c : renderCliques) {
-    // the longest geom will be the ref geom
-    InnerGeom ref = c.geoms[0];
-    for (size_t i = 1; i < c.geoms.size(); i++) {
-      if (c.geoms[i].geom.getLength() > ref.geom.getLength()) ref = c.geoms[i];
-    }
-
-    for (size_t i = 0; i < c.geoms.size(); i++) {
-      PolyLine<double> pl(c.geoms[i].geom);
-
-      if (ref.geom.getLength() >
-          (_cfg->lineWidth + 2 * _cfg->outlineWidth + _cfg->lineSpacing) *
-              _res * 4) {
-        double off =
-            -(_cfg->lineWidth + _cfg->lineSpacing + 2 * _cfg->outlineWidth) *
-            _res *
-            (static_cast<int>(c.geoms[i].slotFrom) -
-             static_cast<int>(ref.slotFrom));
-
-        if (ref.from.edge->getTo() == n) off = -off;
-
-        pl = ref.geom.offsetted(off);
-
-        if (pl.getLength() / c.geoms[i].geom.getLength() > 1.5)
-          pl = c.geoms[i].geom;
+  for (const auto& ig : getCliqueGeoms(cc, n, _cfg->lineWidth * _res,
+                                       _cfg->outlineWidth * _res,
+                                       _cfg->lineSpacing * _res)) {
+    const Line* line = ig.from.line;
 
-        std::set<LinePoint<double>, LinePointCmp<double>> a;
-        std::set<LinePoint<double>, LinePointCmp<double>> b;
-
-        if (ref.from.edge)
-          a = n->pl().frontFor(ref.from.edge)->geom.getIntersections(pl);
-        if (ref.to.edge)
-          b = n->pl().frontFor(ref.to.edge)->geom.getIntersections(pl);
-
-        if (a.size() > 0 && b.size() > 0) {
-          pl = pl.getSegment(a.begin()->totalPos, b.begin()->totalPos);
-        } else if (a.size() > 0) {
-          pl = pl.getSegment(a.begin()->totalPos, 1);
-        } else if (b.size() > 0) {
-          pl = pl.getSegment(0, b.begin()->totalPos);
-        }
-      }
-
-      if (_cfg->outlineWidth > 0) {
-        Params paramsOut;
-        paramsOut["color"] = "000000";
-        paramsOut["line-color"] = c.geoms[i].from.line->color();
-        paramsOut["line"] = c.geoms[i].from.line->label();
-        paramsOut["lineCap"] = "butt";
-        paramsOut["class"] = getLineClass(c.geoms[i].from.line->id());
-        paramsOut["width"] =
-            util::toString((2.0 * _cfg->outlineWidth + _cfg->lineWidth));
+    if (_cfg->outlineWidth > 0) {
+      Params paramsOut;
+      paramsOut["color"] = "000000";
+      paramsOut["line-color"] = line->color();
+      paramsOut["line"] = line->label();
+      paramsOut["lineCap"] = "butt";
+      paramsOut["class"] = getLineClass(line->id());
+      paramsOut["width"] =
+          util::toString((2.0 * _cfg->outlineWidth + _cfg->lineWidth));
 
-        if (n->pl().getComponent() != std::numeric_limits<uint32_t>::max())
-          paramsOut["component"] = util::toString(n->pl().getComponent());
+      if (n->pl().getComponent() != std::numeric_limits<uint32_t>::max())
+        paramsOut["component"] = util::toString(n->pl().getComponent());
 
-        addFeature({pl.getLine(), "inner-connections", paramsOut});
-      }
+      addFeature(ig.geom.getLine(), MVT_INNER, paramsOut);
+    }
 
-      Params params;
-      params["color"] = c.geoms[i].from.line->color();
-      params["line-color"] = c.geoms[i].from.line->color();
-      params["line"] = c.geoms[i].from.line->label();
-      params["lineCap"] = "round";
-      params["class"] = getLineClass(c.geoms[i].from.line->id());
-      params["width"] = util::toString(_cfg->lineWidth);
+    Params params;
+    params["color"] = line->color();
+    params["line-color"] = line->color();
+    params["line"] = line->label();
+    params["lineCap"] = "round";
+    params["class"] = getLineClass(line->id());
+    params["width"] = util::toString(_cfg->lineWidth);
 
-      if (n->pl().getComponent() != std::numeric_limits<uint32_t>::max())
-        params["component"] = util::toString(n->pl().getComponent());
+    if (n->pl().getComponent() != std::numeric_limits<uint32_t>::max())
+      params["component"] = util::toString(n->pl().getComponent());
 
-      addFeature({pl.getLine(), "inner-connections", params});
-    }
+    addFeature(ig.geom.getLine(), MVT_INNER, params);
   }
 }
 
 // _____________________________________________________________________________
 void MvtRenderer::renderEdgeTripGeom(const RenderGraph& outG,
                                      const shared::linegraph::LineEdge* e) {
-  const shared::linegraph::NodeFront* nfTo = e->getTo()->pl().frontFor(e);
-  const shared::linegraph::NodeFront* nfFrom = e->getFrom()->pl().frontFor(e);
-
-  assert(nfTo);
-  assert(nfFrom);
-
-  PolyLine<double> center(*e->pl().getGeom());
-
-  double lineW = _cfg->lineWidth;
-  double outlineW = _cfg->outlineWidth;
-  double lineSpc = _cfg->lineSpacing;
-  double offsetStep = (lineW + 2 * outlineW + lineSpc) * _res;
-  double oo = outG.getTotalWidth(e);
-
-  double o = oo;
-
-  for (size_t i = 0; i < e->pl().getLines().size(); i++) {
-    const auto& lo = e->pl().lineOccAtPos(i);
+  for (const auto& part : getEdgeLineParts(
+           outG, e, _cfg->lineWidth * _res, _cfg->outlineWidth * _res,
+           _cfg->lineSpacing * _res)) {
+    const auto& lo = e->pl().lineOccAtPos(part.pos);
 
     const Line* line = lo.line;
-    PolyLine<double> p = center;
-
-    if (p.getLength() < 0.01) continue;
-
-    double offset =
-        -(o - oo / 2.0 - ((2 * outlineW + _cfg->lineWidth) * _res) / 2.0);
-
-    p.offsetPerp(offset);
-
-    auto iSects = nfTo->geom.getIntersections(p);
-    if (iSects.size() > 0) {
-      p = p.getSegment(0, iSects.begin()->totalPos);
-    } else {
-      p << nfTo->geom.projectOn(p.back()).p;
-    }
-
-    auto iSects2 = nfFrom->geom.getIntersections(p);
-    if (iSects2.size() > 0) {
-      p = p.getSegment(iSects2.begin()->totalPos, 1);
-    } else {
-      p >> nfFrom->geom.projectOn(p.front()).p;
-    }
+    const PolyLine<double>& p = part.geom;
 
     std::string css, oCss;
 
@@ -445,7 +238,7 @@ void MvtRenderer::renderEdgeTripGeom(const RenderGraph& outG,
       if (e->pl().getComponent() != std::numeric_limits<uint32_t>::max())
         paramsOut["component"] = util::toString(e->pl().getComponent());
 
-      addFeature({p.getLine(), "lines", paramsOut});
+      addFeature(p.getLine(), MVT_LINES, paramsOut);
     }
 
     Params params;
@@ -459,14 +252,29 @@ void MvtRenderer::renderEdgeTripGeom(const RenderGraph& outG,
     if (e->pl().getComponent() != std::numeric_limits<uint32_t>::max())
       params["component"] = util::toString(e->pl().getComponent());
 
-    addFeature({p.getLine(), "lines", params});
-
-    o -= offsetStep;
+    addFeature(p.getLine(), MVT_LINES, params);
   }
 }
 
 // _____________________________________________________________________________
-void MvtRenderer::addFeature(const MvtLineFeature& feature) {
+void MvtRenderer::addFeature(const util::geo::Line<double>& line,
+                             MvtLayer layer, const Params& params) {
+  // zero-width geometries are never printed
+  if (layer != MVT_STATIONS) {
+    auto wit = params.find("width");
+    if (wit != params.end() && wit->second == "0") return;
+  }
+
+  // geometries are generalized once for the zoom of this renderer, not per
+  // tile, to 2 tile pixels
+  double px = (WEB_MERC_EXT * 2.0) / static_cast<double>(1 << _zoom) / TILE_RES;
+  MvtLineFeature feature{util::geo::simplify(line, 2 * px), layer, {}};
+  feature.tags.reserve(params.size() * 2);
+  for (const auto& kv : params) {
+    feature.tags.push_back(intern(kv.first, &_keyIds, &_keys));
+    feature.tags.push_back(intern(kv.second, &_valIds, &_vals));
+  }
+
   double w =
       (_cfg->lineWidth + _cfg->lineSpacing + 2 * _cfg->outlineWidth) * _res;
   const auto& box = util::geo::pad(util::geo::getBoundingBox(feature.line), w);
@@ -486,12 +294,12 @@ void MvtRenderer::addFeature(const MvtLineFeature& feature) {
   for (size_t x = swX; x <= neX && x < GRID_SIZE; x++) {
     for (size_t y = swY; y <= neY && y < GRID_SIZE; y++) {
       if (util::geo::intersects(feature.line, getBox(GRID_ZOOM, x, y))) {
-        if (_grid[x * GRID_SIZE + y] == std::numeric_limits<uint32_t>::max()) {
-          _grid[x * GRID_SIZE + y] = _lines.size();
+        auto ins = _grid.insert({x * GRID_SIZE + y, _lines.size()});
+        if (ins.second) {
           _cells.push_back({x, y});
           _lines.push_back({});
         }
-        _lines[_grid[x * GRID_SIZE + y]].push_back(_lineFeatures.size());
+        _lines[ins.first->second].push_back(_lineFeatures.size());
       }
     }
   }
@@ -517,7 +325,32 @@ void MvtRenderer::addFeature(const MvtLineFeature& feature) {
     }
   }
 
-  _lineFeatures.push_back(feature);
+  _lineFeatures.push_back(std::move(feature));
+}
+
+// _____________________________________________________________________________
+uint32_t MvtRenderer::intern(const std::string& s,
+                             std::unordered_map<std::string, uint32_t>* ids,
+                             std::vector<std::string>* strs) {
+  auto ins = ids->insert({s, strs->size()});
+  if (ins.second) strs->push_back(s);
+  return ins.first->second;
+}
+
+// _____________________________________________________________________________
+void MvtTileDict::init(size_t numKeys, size_t numVals) {
+  keys.assign(numKeys, std::numeric_limits<uint32_t>::max());
+  vals.assign(numVals, std::numeric_limits<uint32_t>::max());
+  usedKeys.clear();
+  usedVals.clear();
+}
+
+// _____________________________________________________________________________
+void MvtTileDict::reset() {
+  for (auto k : usedKeys) keys[k] = std::numeric_limits<uint32_t>::max();
+  for (auto v : usedVals) vals[v] = std::numeric_limits<uint32_t>::max();
+  usedKeys.clear();
+  usedVals.clear();
 }
 
 // _____________________________________________________________________________
@@ -535,22 +368,17 @@ Box<double> MvtRenderer::getBox(size_t z, size_t x, size_t y) const {
 }
 
 // _____________________________________________________________________________
-void MvtRenderer::printFeature(const util::geo::Line<double>& l, size_t z,
-                               size_t x, size_t y,
-                               vector_tile::Tile_Layer* layer, Params params,
-                               std::map<std::string, size_t>& keys,
-                               std::map<std::string, size_t>& vals) {
+void MvtRenderer::printFeature(const MvtLineFeature& f, size_t z, size_t x,
+                               size_t y, vector_tile::Tile_Layer* layer,
+                               MvtTileDict* dict) const {
+  const auto& l = f.line;
   if (l.size() < 2) return;
 
-  // skip zero-width geometries
-  if ((layer->name() == "lines" || layer->name() == "inner-connections") &&
-      params.count("width") && params.find("width")->second == "0")
-    return;
-
   double tw = (WEB_MERC_EXT * 2.0) / static_cast<double>(1 << z);
 
   double ox = static_cast<double>(x) * tw - WEB_MERC_EXT;
   double oy = static_cast<double>(y) * tw - WEB_MERC_EXT;
+  double scale = TILE_RES / tw;
 
   // crop
   std::vector<util::geo::Line<double>> croppedLines;
@@ -558,18 +386,40 @@ void MvtRenderer::printFeature(const util::geo::Line<double>& l, size_t z,
   // pad!
   auto box = util::geo::pad(getBox(z, x, y), 50 * (tw / TILE_RES));
 
-  if (layer->name() == "stations") {
+  if (f.layer == MVT_STATIONS) {
     croppedLines.push_back(l);
   } else {
     croppedLines.push_back({});
 
+    // Cohen-Sutherland outcodes, each point is classified once. Segments
+    // with an endpoint inside the box are accepted and segments with both
+    // endpoints beyond the same box side are rejected without an exact test
+    double minX = box.getLowerLeft().getX(), minY = box.getLowerLeft().getY();
+    double maxX = box.getUpperRight().getX();
+    double maxY = box.getUpperRight().getY();
+    auto outcode = [&](const DPoint& p) {
+      return (p.getX() < minX) | ((p.getX() > maxX) << 1) |
+             ((p.getY() < minY) << 2) | ((p.getY() > maxY) << 3);
+    };
+
+    int prevC = outcode(l[0]);
+
     for (size_t i = 1; i < l.size(); i++) {
       const auto& curP = l[i];
       const auto& prevP = l[i - 1];
+      int curC = outcode(curP);
+
+      bool isect = false;
+      if (!prevC || !curC) {
+        isect = true;
+      } else if (!(prevC & curC)) {
+        isect = util::geo::intersects(
+            util::geo::LineSegment<double>{curP, prevP}, box);
+      }
+      prevC = curC;
 
-      if (util::geo::intersects(util::geo::LineSegment<double>{curP, prevP},
-                                box)) {
-        croppedLines.back().push_back(prevP);
+      if (isect) {
+        if (croppedLines.back().empty()) croppedLines.back().push_back(prevP);
         croppedLines.back().push_back(curP);
       } else if (croppedLines.back().size() > 0) {
         croppedLines.push_back({});
@@ -577,44 +427,38 @@ void MvtRenderer::printFeature(const util::geo::Line<double>& l, size_t z,
     }
   }
 
-  for (const auto& ll : croppedLines) {
-    // skip point-like geometries
-    if (ll.size() < 2) continue;
-
-    auto l = util::geo::simplify(ll, 2 * tw / TILE_RES);
-
+  for (const auto& l : croppedLines) {
     // skip point-like geometries
-    if (ll.size() < 2) continue;
+    if (l.size() < 2) continue;
     if (l.size() == 2 && util::geo::dist(l[0], l[1]) < tw / TILE_RES) continue;
 
     auto feature = layer->add_features();
+    feature->mutable_tags()->Reserve(f.tags.size());
+    feature->mutable_geometry()->Reserve(2 * l.size() + 3);
 
-    for (const auto& kv : params) {
-      auto kit = keys.find(kv.first);
-      auto vit = vals.find(kv.second);
-
-      if (kit != keys.end()) {
-        feature->add_tags(kit->second);
-      } else {
-        auto k = layer->add_keys();
-        *k = kv.first;
-        feature->add_tags(layer->keys_size() - 1);
-        keys[kv.first] = layer->keys_size() - 1;
+    for (size_t i = 0; i < f.tags.size(); i += 2) {
+      uint32_t kid = f.tags[i];
+      uint32_t vid = f.tags[i + 1];
+
+      if (dict->keys[kid] == std::numeric_limits<uint32_t>::max()) {
+        *layer->add_keys() = _keys[kid];
+        dict->keys[kid] = layer->keys_size() - 1;
+        dict->usedKeys.push_back(kid);
       }
 
-      if (vit != vals.end()) {
-        feature->add_tags(vit->second);
-      } else {
-        auto k = layer->add_values();
-        k->set_string_value(kv.second);
-        feature->add_tags(layer->values_size() - 1);
-        vals[kv.second] = layer->values_size() - 1;
+      if (dict->vals[vid] == std::numeric_limits<uint32_t>::max()) {
+        layer->add_values()->set_string_value(_vals[vid]);
+        dict->vals[vid] = layer->values_size() - 1;
+        dict->usedVals.push_back(vid);
       }
+
+      feature->add_tags(dict->keys[kid]);
+      feature->add_tags(dict->vals[vid]);
     }
 
     feature->set_id(1);
 
-    if (layer->name() == "stations") {
+    if (f.layer == MVT_STATIONS) {
       feature->set_type(vector_tile::Tile_GeomType_POLYGON);
     } else {
       feature->set_type(vector_tile::Tile_GeomType_LINESTRING);
@@ -622,8 +466,8 @@ void MvtRenderer::printFeature(const util::geo::Line<double>& l, size_t z,
 
     // MoveTo, 1x
     feature->add_geometry((1 & 0x7) | (1 << 3));
-    int px = (l[0].getX() - ox) * (TILE_RES / tw);
-    int py = TILE_RES - (l[0].getY() - oy) * (TILE_RES / tw);
+    int px = (l[0].getX() - ox) * scale;
+    int py = TILE_RES - (l[0].getY() - oy) * scale;
     feature->add_geometry((px << 1) ^ (px >> 31));
     feature->add_geometry((py << 1) ^ (py >> 31));
 
@@ -631,8 +475,8 @@ void MvtRenderer::printFeature(const util::geo::Line<double>& l, size_t z,
     feature->add_geometry((2 & 0x7) | ((l.size() - 1) << 3));
 
     for (size_t i = 1; i < l.size(); i++) {
-      int dx = ((l[i].getX() - ox) * (TILE_RES / tw)) - px;
-      int dy = (TILE_RES - (l[i].getY() - oy) * (TILE_RES / tw)) - py;
+      int dx = ((l[i].getX() - ox) * scale) - px;
+      int dy = (TILE_RES - (l[i].getY() - oy) * scale) - py;
 
       px += dx;
       py += dy;
@@ -641,7 +485,7 @@ void MvtRenderer::printFeature(const util::geo::Line<double>& l, size_t z,
       feature->add_geometry((dy << 1) ^ (dy >> 31));
     }
 
-    if (layer->name() == "stations") {
+    if (f.layer == MVT_STATIONS) {
       // close path
       feature->add_geometry((7 & 0x7) | (1 << 3));
     }
@@ -660,6 +504,13 @@ std::string MvtRenderer::getLineClass(const std::string& id) const {
 // _____________________________________________________________________________
 void MvtRenderer::serializeTile(size_t x, size_t y, size_t z,
                                 vector_tile::Tile* tile) {
+  if (_archive) {
+    std::string a;
+    tile->SerializeToString(&a);
+    _archive->addTile(z, x, (1 << z) - 1 - y, a);
+    return;
+  }
+
   std::stringstream ss;
 
   ss << _cfg->mvtPath << "/";
@@ -700,6 +551,9 @@ void MvtRenderer::serializeTile(size_t x, size_t y, size_t z,
 
 // _____________________________________________________________________________
 void MvtRenderer::writeTiles(size_t z) {
+  // tiles to write
+  std::vector<std::pair<size_t, size_t>> tiles;
+
   if (z >= GRID_ZOOM) {
     for (auto cell : _cells) {
       auto cx = cell.first;
@@ -709,43 +563,7 @@ void MvtRenderer::writeTiles(size_t z) {
            ccx < ((cx + 1) << (z - GRID_ZOOM)); ccx++) {
         for (size_t ccy = (cy << (z - GRID_ZOOM));
              ccy < ((cy + 1) << (z - GRID_ZOOM)); ccy++) {
-          vector_tile::Tile tile;
-
-          auto layerInner = tile.add_layers();
-          layerInner->set_version(2);
-          layerInner->set_name("inner-connections");
-          layerInner->set_extent(TILE_RES);
-          std::map<std::string, size_t> keysInner, valsInner;
-
-          auto layerLines = tile.add_layers();
-          layerLines->set_version(2);
-          layerLines->set_name("lines");
-          layerLines->set_extent(TILE_RES);
-          std::map<std::string, size_t> keysLines, valsLines;
-
-          auto layerStations = tile.add_layers();
-          layerStations->set_version(2);
-          layerStations->set_name("stations");
-          layerStations->set_extent(TILE_RES);
-          std::map<std::string, size_t> keysStations, valsStations;
-
-          for (const size_t lid : _lines[_grid[cx * GRID_SIZE + cy]]) {
-            const auto& l = _lineFeatures[lid];
-            if (z == GRID_ZOOM ||
-                util::geo::intersects(l.line, getBox(z, ccx, ccy))) {
-              if (l.layer == "lines")
-                printFeature(l.line, z, ccx, ccy, layerLines, l.params,
-                             keysLines, valsLines);
-              if (l.layer == "inner-connections")
-                printFeature(l.line, z, ccx, ccy, layerInner, l.params,
-                             keysInner, valsInner);
-              if (l.layer == "stations")
-                printFeature(l.line, z, ccx, ccy, layerStations, l.params,
-                             keysStations, valsStations);
-            }
-          }
-
-          serializeTile(ccx, ccy, z, &tile);
+          tiles.push_back({ccx, ccy});
         }
       }
     }
@@ -758,112 +576,124 @@ void MvtRenderer::writeTiles(size_t z) {
            ccx < ((cx + 1) << (z - GRID2_ZOOM)); ccx++) {
         for (size_t ccy = (cy << (z - GRID2_ZOOM));
              ccy < ((cy + 1) << (z - GRID2_ZOOM)); ccy++) {
-          vector_tile::Tile tile;
-
-          auto layerInner = tile.add_layers();
-          layerInner->set_version(2);
-          layerInner->set_name("inner-connections");
-          layerInner->set_extent(TILE_RES);
-          std::map<std::string, size_t> keysInner, valsInner;
-
-          auto layerLines = tile.add_layers();
-          layerLines->set_version(2);
-          layerLines->set_name("lines");
-          layerLines->set_extent(TILE_RES);
-          std::map<std::string, size_t> keysLines, valsLines;
-
-          auto layerStations = tile.add_layers();
-          layerStations->set_version(2);
-          layerStations->set_name("stations");
-          layerStations->set_extent(TILE_RES);
-          std::map<std::string, size_t> keysStations, valsStations;
-
-          for (const size_t lid : _lines2[_grid2[cx * GRID2_SIZE + cy]]) {
-            const auto& l = _lineFeatures[lid];
-            if (z == GRID2_ZOOM ||
-                util::geo::intersects(l.line, getBox(z, ccx, ccy))) {
-              if (l.layer == "lines")
-                printFeature(l.line, z, ccx, ccy, layerLines, l.params,
-                             keysLines, valsLines);
-              if (l.layer == "inner-connections")
-                printFeature(l.line, z, ccx, ccy, layerInner, l.params,
-                             keysInner, valsInner);
-              if (l.layer == "stations")
-                printFeature(l.line, z, ccx, ccy, layerStations, l.params,
-                             keysStations, valsStations);
-            }
-          }
-
-          serializeTile(ccx, ccy, z, &tile);
+          tiles.push_back({ccx, ccy});
         }
       }
     }
   } else {
-    for (size_t cx = 0; cx < static_cast<size_t>(1 << z); cx++) {
-      for (size_t cy = 0; cy < static_cast<size_t>(1 << z); cy++) {
-        vector_tile::Tile tile;
-
-        auto layerInner = tile.add_layers();
-        layerInner->set_version(2);
-        layerInner->set_name("inner-connections");
-        layerInner->set_extent(TILE_RES);
-        std::map<std::string, size_t> keysInner, valsInner;
-
-        auto layerLines = tile.add_layers();
-        layerLines->set_version(2);
-        layerLines->set_name("lines");
-        layerLines->set_extent(TILE_RES);
-        std::map<std::string, size_t> keysLines, valsLines;
-
-        auto layerStations = tile.add_layers();
-        layerStations->set_version(2);
-        layerStations->set_name("stations");
-        layerStations->set_extent(TILE_RES);
-        std::map<std::string, size_t> keysStations, valsStations;
-
-        std::vector<size_t> objects;
-
-        if (z == 0) {
-          for (size_t i = 0; i < _lineFeatures.size(); i++) {
-            objects.push_back(i);
-          }
-        } else {
-          for (size_t ccx = (cx << (GRID2_ZOOM - z));
-               ccx < ((cx + 1) << (GRID2_ZOOM - z)); ccx++) {
-            for (size_t ccy = (cy << (GRID2_ZOOM - z));
-                 ccy < ((cy + 1) << (GRID2_ZOOM - z)); ccy++) {
-              if (_grid2[ccx * GRID2_SIZE + ccy] ==
-                  std::numeric_limits<uint32_t>::max())
-                continue;
-
-              const auto& lines = _lines2[_grid2[ccx * GRID2_SIZE + ccy]];
-              objects.insert(objects.end(), lines.begin(), lines.end());
-            }
-          }
-
-          std::sort(objects.begin(), objects.end());
-        }
+    // only tiles covering an occupied coarse cell, instead of the whole world
+    for (auto cell : _cells2) {
+      tiles.push_back(
+          {cell.first >> (GRID2_ZOOM - z), cell.second >> (GRID2_ZOOM - z)});
+    }
+    std::sort(tiles.begin(), tiles.end());
+    tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+  }
 
-        for (size_t i = 0; i < objects.size(); i++) {
-          if (i > 0 && objects[i] == objects[i - 1]) continue;
+  // tiles only read the line features, so they are built in parallel. The
+  // tile and the object list are per-thread scratch space.
+  std::string err;
 
-          const auto& l = _lineFeatures[objects[i]];
+#pragma omp parallel
+  {
+    vector_tile::Tile tile;
+    std::vector<size_t> objects;
+    MvtTileDict dicts[MVT_NUM_LAYERS];
+    for (auto& dict : dicts) dict.init(_keys.size(), _vals.size());
 
-          if (l.layer == "lines")
-            printFeature(l.line, z, cx, cy, layerLines, l.params, keysLines,
-                         valsLines);
-          if (l.layer == "inner-connections")
-            printFeature(l.line, z, cx, cy, layerInner, l.params, keysInner,
-                         valsInner);
-          if (l.layer == "stations")
-            printFeature(l.line, z, cx, cy, layerStations, l.params,
-                         keysStations, valsStations);
-        }
+#pragma omp for schedule(dynamic, 16)
+    for (size_t i = 0; i < tiles.size(); i++) {
+      size_t x = tiles[i].first;
+      size_t y = tiles[i].second;
+
+      getTileObjects(z, x, y, &objects);
+
+      // empty tiles are not written at all
+      if (objects.empty()) continue;
 
-        serializeTile(cx, cy, z, &tile);
+      buildTile(z, x, y, objects, &tile, dicts);
+
+      try {
+        serializeTile(x, y, z, &tile);
+      } catch (const std::runtime_error& e) {
+#pragma omp critical(mvtTileErr)
+        err = e.what();
       }
     }
   }
+
+  if (!err.empty()) throw std::runtime_error(err);
+}
+
+// _____________________________________________________________________________
+void MvtRenderer::getTileObjects(size_t z, size_t x, size_t y,
+                                 std::vector<size_t>* objects) const {
+  objects->clear();
+
+  if (z >= GRID_ZOOM) {
+    size_t cx = x >> (z - GRID_ZOOM);
+    size_t cy = y >> (z - GRID_ZOOM);
+
+    auto cell = _grid.find(cx * GRID_SIZE + cy);
+    if (cell == _grid.end()) return;
+
+    for (const size_t lid : _lines[cell->second]) {
+      if (z == GRID_ZOOM ||
+          util::geo::intersects(_lineFeatures[lid].line, getBox(z, x, y)))
+        objects->push_back(lid);
+    }
+  } else if (z >= GRID2_ZOOM) {
+    size_t cx = x >> (z - GRID2_ZOOM);
+    size_t cy = y >> (z - GRID2_ZOOM);
+
+    for (const size_t lid : _lines2[_grid2[cx * GRID2_SIZE + cy]]) {
+      if (z == GRID2_ZOOM ||
+          util::geo::intersects(_lineFeatures[lid].line, getBox(z, x, y)))
+        objects->push_back(lid);
+    }
+  } else if (z == 0) {
+    for (size_t i = 0; i < _lineFeatures.size(); i++) objects->push_back(i);
+  } else {
+    for (size_t ccx = (x << (GRID2_ZOOM - z));
+         ccx < ((x + 1) << (GRID2_ZOOM - z)); ccx++) {
+      for (size_t ccy = (y << (GRID2_ZOOM - z));
+           ccy < ((y + 1) << (GRID2_ZOOM - z)); ccy++) {
+        if (_grid2[ccx * GRID2_SIZE + ccy] ==
+            std::numeric_limits<uint32_t>::max())
+          continue;
+
+        const auto& lines = _lines2[_grid2[ccx * GRID2_SIZE + ccy]];
+        objects->insert(objects->end(), lines.begin(), lines.end());
+      }
+    }
+
+    std::sort(objects->begin(), objects->end());
+    objects->erase(std::unique(objects->begin(), objects->end()),
+                   objects->end());
+  }
+}
+
+// _____________________________________________________________________________
+void MvtRenderer::buildTile(size_t z, size_t x, size_t y,
+                            const std::vector<size_t>& objects,
+                            vector_tile::Tile* tile, MvtTileDict* dicts) const {
+  static const char* NAMES[MVT_NUM_LAYERS] = {"inner-connections", "lines",
+                                              "stations"};
+  tile->Clear();
+
+  vector_tile::Tile_Layer* layers[MVT_NUM_LAYERS];
+  for (size_t i = 0; i < MVT_NUM_LAYERS; i++) {
+    layers[i] = tile->add_layers();
+    layers[i]->set_version(2);
+    layers[i]->set_name(NAMES[i]);
+    layers[i]->set_extent(TILE_RES);
+    dicts[i].reset();
+  }
+
+  for (const size_t lid : objects) {
+    const auto& l = _lineFeatures[lid];
+    printFeature(l, z, x, y, layers[l.layer], &dicts[l.layer]);
+  }
 }
 
 #endif
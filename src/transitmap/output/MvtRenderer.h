@@ -10,6 +10,7 @@
 #include <ostream>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Renderer.h"
@@ -17,6 +18,7 @@
 #include "shared/rendergraph/RenderGraph.h"
 #include "transitmap/config/TransitMapConfig.h"
 #include "transitmap/label/Labeller.h"
+#include "transitmap/output/PmTilesWriter.h"
 #include "transitmap/output/protobuf/vector_tile.pb.h"
 #include "util/geo/Geo.h"
 #include "util/geo/PolyLine.h"
@@ -27,19 +29,34 @@ using util::Nullable;
 namespace transitmapper {
 namespace output {
 
+enum MvtLayer { MVT_INNER = 0, MVT_LINES = 1, MVT_STATIONS = 2 };
+
+static const size_t MVT_NUM_LAYERS = 3;
+
 struct MvtLineFeature {
   util::geo::Line<double> line;
-  std::string layer;
-  Params params;
+  MvtLayer layer;
+  // alternating global key and value ids, in the key order of the params
+  std::vector<uint32_t> tags;
+};
+
+// per-layer mapping of global key and value ids to the ids of a single tile
+// layer, only the used entries are reset between tiles
+struct MvtTileDict {
+  std::vector<uint32_t> keys, vals;
+  std::vector<uint32_t> usedKeys, usedVals;
+
+  void init(size_t numKeys, size_t numVals);
+  void reset();
 };
 
 class MvtRenderer : public Renderer {
  public:
   MvtRenderer(const config::Config* cfg, size_t zoom);
-  virtual ~MvtRenderer() {
-    delete[] _grid;
-    delete[] _grid2;
-  };
+
+  // tiles are written into archive instead of single files
+  MvtRenderer(const config::Config* cfg, size_t zoom, PmTilesWriter* archive);
+  virtual ~MvtRenderer() { delete[] _grid2; };
 
   virtual void print(const shared::rendergraph::RenderGraph& outputGraph);
 
@@ -47,22 +64,27 @@ class MvtRenderer : public Renderer {
 
   void serializeTile(size_t x, size_t y, size_t z, vector_tile::Tile* l);
 
-  void printFeature(const util::geo::Line<double>& l, size_t z, size_t x,
-                    size_t y, vector_tile::Tile_Layer* layer, Params params,
-                    std::map<std::string, size_t>& keys,
-                    std::map<std::string, size_t>& vals);
+  void printFeature(const MvtLineFeature& f, size_t z, size_t x, size_t y,
+                    vector_tile::Tile_Layer* layer, MvtTileDict* dict) const;
 
  private:
   const config::Config* _cfg;
   size_t _zoom;
   double _res;
 
-  // tile grid
-  uint64_t* _grid;
+  PmTilesWriter* _archive;
+
+  // tile grid, only the occupied cells of the fine grid are stored, keyed by
+  // x * GRID_SIZE + y. The coarse grid is small enough to be dense
+  std::unordered_map<uint64_t, size_t> _grid;
   uint64_t* _grid2;
 
   std::vector<MvtLineFeature> _lineFeatures;
 
+  // interned attribute keys and values of all features
+  std::vector<std::string> _keys, _vals;
+  std::unordered_map<std::string, uint32_t> _keyIds, _valIds;
+
   std::vector<std::vector<size_t>> _lines;
   std::vector<std::pair<uint32_t, uint32_t>> _cells;
 
@@ -73,8 +95,23 @@ class MvtRenderer : public Renderer {
   mutable int lineClassId = 0;
 
   util::geo::Box<double> getBox(size_t z, size_t x, size_t y) const;
+
+  // ids of the line features to be considered for tile (x, y) on zoom z
+  void getTileObjects(size_t z, size_t x, size_t y,
+                      std::vector<size_t>* objects) const;
+
+  // fill tile with the features in objects, the tile is cleared first. dicts
+  // holds one dictionary per layer
+  void buildTile(size_t z, size_t x, size_t y,
+                 const std::vector<size_t>& objects, vector_tile::Tile* tile,
+                 MvtTileDict* dicts) const;
   uint32_t gridC(double c) const;
-  void addFeature(const MvtLineFeature& featuer);
+  void addFeature(const util::geo::Line<double>& line, MvtLayer layer,
+                  const Params& params);
+
+  static uint32_t intern(const std::string& s,
+                         std::unordered_map<std::string, uint32_t>* ids,
+                         std::vector<std::string>* strs);
 
   void outputNodes(const shared::rendergraph::RenderGraph& outputGraph);
   void outputEdges(const shared::rendergraph::RenderGraph& outputGraph);
@@ -98,22 +135,9 @@ class MvtRenderer : public Renderer {
 
   void renderNodeFronts(const shared::rendergraph::RenderGraph& outG);
 
-  std::multiset<InnerClique> getInnerCliques(
-      const shared::linegraph::LineNode* n,
-      std::vector<shared::rendergraph::InnerGeom> geoms, size_t level) const;
-
   void renderClique(const InnerClique& c,
                     const shared::linegraph::LineNode* node);
 
-  bool isNextTo(const shared::rendergraph::InnerGeom& a,
-                const shared::rendergraph::InnerGeom& b) const;
-  bool hasSameOrigin(const shared::rendergraph::InnerGeom& a,
-                     const shared::rendergraph::InnerGeom& b) const;
-
-  size_t getNextPartner(const InnerClique& forGeom,
-                        const std::vector<shared::rendergraph::InnerGeom>& pool,
-                        size_t level) const;
-
   std::string getLineClass(const std::string& id) const;
 
   std::string getMarkerPathMale(double w) const;
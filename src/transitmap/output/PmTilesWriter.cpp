@@ -0,0 +1,327 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include "transitmap/output/PmTilesWriter.h"
+
+using transitmapper::output::PmTilesWriter;
+
+// the header and the root directory have to fit into the first 16 KiB
+const static size_t HEADER_SIZE = 127;
+const static size_t ROOT_MAX_SIZE = 16384 - HEADER_SIZE;
+
+// number of entries per leaf directory to start with
+const static size_t LEAF_SIZE = 4096;
+
+namespace {
+// _____________________________________________________________________________
+uint64_t fnv1a(const std::string& s) {
+  uint64_t h = 14695981039346656037ull;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+// _____________________________________________________________________________
+void writeVarint(std::string* s, uint64_t v) {
+  while (v >= 0x80) {
+    s->push_back(static_cast<char>((v & 0x7f) | 0x80));
+    v >>= 7;
+  }
+  s->push_back(static_cast<char>(v));
+}
+
+// _____________________________________________________________________________
+void writeLe(std::string* s, uint64_t v, size_t bytes) {
+  for (size_t i = 0; i < bytes; i++) {
+    s->push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+  }
+}
+
+// _____________________________________________________________________________
+void writeE7(std::string* s, double deg) {
+  writeLe(s, static_cast<uint32_t>(static_cast<int32_t>(std::round(deg * 1e7))),
+          4);
+}
+
+// _____________________________________________________________________________
+double tileLon(size_t z, size_t x) {
+  return static_cast<double>(x) / static_cast<double>(1 << z) * 360.0 - 180.0;
+}
+
+// _____________________________________________________________________________
+double tileLat(size_t z, size_t y) {
+  double n = M_PI * (1.0 - 2.0 * static_cast<double>(y) /
+                               static_cast<double>(1 << z));
+  return std::atan(std::sinh(n)) * 180.0 / M_PI;
+}
+}  // namespace
+
+// _____________________________________________________________________________
+PmTilesWriter::PmTilesWriter(const std::string& path)
+    : _path(path),
+      _tmpPath(path + ".tmp"),
+      _tmpSize(0),
+      _minZoom(std::numeric_limits<size_t>::max()),
+      _maxZoom(0),
+      _minLon(180),
+      _minLat(90),
+      _maxLon(-180),
+      _maxLat(-90) {
+  _tmp.open(_tmpPath, std::ios::in | std::ios::out | std::ios::trunc |
+                          std::ios::binary);
+  if (!_tmp.is_open()) {
+    throw std::runtime_error("Could not open " + _tmpPath);
+  }
+}
+
+// _____________________________________________________________________________
+PmTilesWriter::~PmTilesWriter() {
+  if (_tmp.is_open()) {
+    _tmp.close();
+    std::remove(_tmpPath.c_str());
+  }
+}
+
+// _____________________________________________________________________________
+uint64_t PmTilesWriter::tileId(size_t z, size_t x, size_t y) {
+  // ids of all tiles on lower zoom levels
+  uint64_t ret = ((1ull << (2 * z)) - 1) / 3;
+
+  // position on the Hilbert curve of zoom level z
+  uint64_t n = 1ull << z;
+  uint64_t tx = x, ty = y;
+  for (uint64_t s = n / 2; s > 0; s /= 2) {
+    uint64_t rx = (tx & s) > 0;
+    uint64_t ry = (ty & s) > 0;
+    ret += s * s * ((3 * rx) ^ ry);
+
+    if (ry == 0) {
+      if (rx == 1) {
+        tx = n - 1 - tx;
+        ty = n - 1 - ty;
+      }
+      std::swap(tx, ty);
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+bool PmTilesWriter::sameContent(size_t content, const std::string& data) {
+  const auto& c = _contents[content];
+  if (c.length != data.size()) return false;
+
+  std::string buf(c.length, 0);
+  _tmp.seekg(c.offset);
+  _tmp.read(&buf[0], c.length);
+  return _tmp.good() && buf == data;
+}
+
+// _____________________________________________________________________________
+void PmTilesWriter::addTile(size_t z, size_t x, size_t y,
+                            const std::string& data) {
+  uint64_t h = fnv1a(data);
+  uint64_t id = tileId(z, x, y);
+  bool err = false;
+
+#pragma omp critical(pmTilesWriter)
+  {
+    size_t content = std::numeric_limits<size_t>::max();
+
+    auto& cands = _hashes[h];
+    for (size_t c : cands) {
+      if (sameContent(c, data)) {
+        content = c;
+        break;
+      }
+    }
+
+    if (content == std::numeric_limits<size_t>::max()) {
+      _tmp.seekp(_tmpSize);
+      _tmp.write(data.data(), data.size());
+      content = _contents.size();
+      _contents.push_back({_tmpSize, data.size()});
+      _tmpSize += data.size();
+      cands.push_back(content);
+    }
+
+    err = !_tmp.good();
+
+    _entries.push_back({id, content});
+
+    _minZoom = std::min(_minZoom, z);
+    _maxZoom = std::max(_maxZoom, z);
+    _minLon = std::min(_minLon, tileLon(z, x));
+    _maxLon = std::max(_maxLon, tileLon(z, x + 1));
+    _minLat = std::min(_minLat, tileLat(z, y + 1));
+    _maxLat = std::max(_maxLat, tileLat(z, y));
+  }
+
+  if (err) throw std::runtime_error("Could not write to " + _tmpPath);
+}
+
+// _____________________________________________________________________________
+std::string PmTilesWriter::serializeDir(const std::vector<DirEntry>& dir) {
+  std::string ret;
+
+  writeVarint(&ret, dir.size());
+
+  uint64_t lastId = 0;
+  for (const auto& e : dir) {
+    writeVarint(&ret, e.tileId - lastId);
+    lastId = e.tileId;
+  }
+
+  for (const auto& e : dir) writeVarint(&ret, e.runLength);
+  for (const auto& e : dir) writeVarint(&ret, e.length);
+
+  for (size_t i = 0; i < dir.size(); i++) {
+    // 0 means directly after the previous entry
+    if (i > 0 && dir[i].offset == dir[i - 1].offset + dir[i - 1].length) {
+      writeVarint(&ret, 0);
+    } else {
+      writeVarint(&ret, dir[i].offset + 1);
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void PmTilesWriter::finish(const std::string& metadata) {
+  // if a tile was added twice, the last version wins
+  std::stable_sort(_entries.begin(), _entries.end(),
+                   [](const Entry& a, const Entry& b) {
+                     return a.tileId < b.tileId;
+                   });
+
+  std::vector<Entry> entries;
+  for (const auto& e : _entries) {
+    if (!entries.empty() && entries.back().tileId == e.tileId) {
+      entries.back() = e;
+    } else {
+      entries.push_back(e);
+    }
+  }
+
+  // place the tile data in tile id order, identical tiles point to the
+  // first occurrence
+  const uint64_t NONE = std::numeric_limits<uint64_t>::max();
+  std::vector<uint64_t> offsets(_contents.size(), NONE);
+  std::vector<size_t> order;
+  uint64_t dataLength = 0;
+
+  std::vector<DirEntry> dir;
+
+  for (const auto& e : entries) {
+    if (offsets[e.content] == NONE) {
+      offsets[e.content] = dataLength;
+      dataLength += _contents[e.content].length;
+      order.push_back(e.content);
+    }
+
+    uint64_t off = offsets[e.content];
+    uint64_t len = _contents[e.content].length;
+
+    if (!dir.empty() && dir.back().tileId + dir.back().runLength == e.tileId &&
+        dir.back().offset == off) {
+      dir.back().runLength++;
+    } else {
+      dir.push_back({e.tileId, off, len, 1});
+    }
+  }
+
+  std::string root = serializeDir(dir);
+  std::string leaves;
+
+  if (root.size() > ROOT_MAX_SIZE) {
+    for (size_t leafSize = LEAF_SIZE;; leafSize *= 2) {
+      std::vector<DirEntry> rootDir;
+      leaves.clear();
+
+      for (size_t i = 0; i < dir.size(); i += leafSize) {
+        std::vector<DirEntry> leaf(
+            dir.begin() + i, dir.begin() + std::min(i + leafSize, dir.size()));
+        std::string s = serializeDir(leaf);
+        rootDir.push_back({leaf.front().tileId, leaves.size(), s.size(), 0});
+        leaves += s;
+      }
+
+      root = serializeDir(rootDir);
+      if (root.size() <= ROOT_MAX_SIZE) break;
+    }
+  }
+
+  uint64_t rootOff = HEADER_SIZE;
+  uint64_t metaOff = rootOff + root.size();
+  uint64_t leavesOff = metaOff + metadata.size();
+  uint64_t dataOff = leavesOff + leaves.size();
+
+  if (entries.empty()) {
+    _minZoom = _maxZoom = 0;
+    _minLon = _minLat = _maxLon = _maxLat = 0;
+  }
+
+  std::string header("PMTiles");
+  writeLe(&header, 3, 1);
+  writeLe(&header, rootOff, 8);
+  writeLe(&header, root.size(), 8);
+  writeLe(&header, metaOff, 8);
+  writeLe(&header, metadata.size(), 8);
+  writeLe(&header, leavesOff, 8);
+  writeLe(&header, leaves.size(), 8);
+  writeLe(&header, dataOff, 8);
+  writeLe(&header, dataLength, 8);
+  writeLe(&header, entries.size(), 8);
+  writeLe(&header, dir.size(), 8);
+  writeLe(&header, order.size(), 8);
+
+  // clustered
+  writeLe(&header, 1, 1);
+
+  // no internal and no tile compression
+  writeLe(&header, 1, 1);
+  writeLe(&header, 1, 1);
+
+  // tile type MVT
+  writeLe(&header, 1, 1);
+
+  writeLe(&header, _minZoom, 1);
+  writeLe(&header, _maxZoom, 1);
+  writeE7(&header, _minLon);
+  writeE7(&header, _minLat);
+  writeE7(&header, _maxLon);
+  writeE7(&header, _maxLat);
+  writeLe(&header, _minZoom, 1);
+  writeE7(&header, (_minLon + _maxLon) / 2);
+  writeE7(&header, (_minLat + _maxLat) / 2);
+
+  std::ofstream fo(_path, std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!fo.is_open()) throw std::runtime_error("Could not open " + _path);
+
+  fo << header << root << metadata << leaves;
+
+  std::string buf;
+  for (size_t c : order) {
+    buf.resize(_contents[c].length);
+    _tmp.seekg(_contents[c].offset);
+    _tmp.read(&buf[0], buf.size());
+    fo.write(buf.data(), buf.size());
+  }
+
+  if (!_tmp.good() || !fo.good()) {
+    throw std::runtime_error("Could not write " + _path);
+  }
+
+  _tmp.close();
+  std::remove(_tmpPath.c_str());
+}
@@ -0,0 +1,82 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_PMTILESWRITER_H_
+#define TRANSITMAP_OUTPUT_PMTILESWRITER_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace transitmapper {
+namespace output {
+
+// Writer for single-file PMTiles (v3) tile archives.
+//
+// Tiles are appended to a temporary data file next to the archive as
+// they arrive, in any order and from any thread. Identical tiles are
+// stored only once. finish() writes the archive: header, directories and
+// metadata, then the tile data in tile id order (a "clustered" archive).
+// Directories are not compressed. Tiles are stored as they are passed
+// in, as uncompressed MVT.
+class PmTilesWriter {
+ public:
+  explicit PmTilesWriter(const std::string& path);
+  ~PmTilesWriter();
+
+  PmTilesWriter(const PmTilesWriter&) = delete;
+  PmTilesWriter& operator=(const PmTilesWriter&) = delete;
+
+  // y counted from the top (XYZ scheme), thread safe
+  void addTile(size_t z, size_t x, size_t y, const std::string& data);
+
+  // write the archive, metadata is a JSON object
+  void finish(const std::string& metadata);
+
+  size_t numTiles() const { return _entries.size(); }
+  size_t numContents() const { return _contents.size(); }
+
+  static uint64_t tileId(size_t z, size_t x, size_t y);
+
+ private:
+  struct Entry {
+    uint64_t tileId;
+    size_t content;
+  };
+
+  struct Content {
+    uint64_t offset;
+    uint64_t length;
+  };
+
+  struct DirEntry {
+    uint64_t tileId;
+    uint64_t offset;
+    uint64_t length;
+    uint64_t runLength;
+  };
+
+  std::string _path, _tmpPath;
+  std::fstream _tmp;
+  uint64_t _tmpSize;
+
+  std::vector<Entry> _entries;
+  std::vector<Content> _contents;
+
+  // content hash -> contents with this hash
+  std::unordered_map<uint64_t, std::vector<size_t>> _hashes;
+
+  size_t _minZoom, _maxZoom;
+  double _minLon, _minLat, _maxLon, _maxLat;
+
+  bool sameContent(size_t content, const std::string& data);
+
+  static std::string serializeDir(const std::vector<DirEntry>& dir);
+};
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_PMTILESWRITER_H_
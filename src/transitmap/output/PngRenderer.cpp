@@ -0,0 +1,194 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+#include "shared/linegraph/Line.h"
+#include "shared/rendergraph/RenderGraph.h"
+#include "transitmap/config/TransitMapConfig.h"
+#include "transitmap/output/InnerCliques.h"
+#include "transitmap/output/LineParts.h"
+#include "transitmap/output/PngRenderer.h"
+#include "transitmap/output/PngWriter.h"
+#include "util/geo/PolyLine.h"
+#include "util/log/Log.h"
+
+using shared::linegraph::Line;
+using shared::linegraph::LineNode;
+using shared::rendergraph::InnerGeom;
+using shared::rendergraph::RenderGraph;
+using transitmapper::output::InnerClique;
+using transitmapper::output::getCliqueGeoms;
+using transitmapper::output::getEdgeLineParts;
+using transitmapper::output::getEdgeOrder;
+using transitmapper::output::getInnerCliques;
+using transitmapper::output::PngRenderer;
+using transitmapper::output::RasterColor;
+using transitmapper::output::Rasterizer;
+using util::geo::DLine;
+using util::geo::DPoint;
+using util::geo::LinePoint;
+using util::geo::LinePointCmp;
+using util::geo::PolyLine;
+
+// _____________________________________________________________________________
+PngRenderer::PngRenderer(std::ostream* o, const config::Config* cfg)
+    : _o(o), _cfg(cfg), _res(cfg->outputResolution * cfg->pngDpi / 96.0) {}
+
+// _____________________________________________________________________________
+void PngRenderer::print(const RenderGraph& outG) {
+  auto box = outG.getBBox();
+
+  box = util::geo::pad(
+      box, outG.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing));
+
+  // a clipped graph is only drawn within its viewport
+  if (_cfg->clip) box = _cfg->clipBox;
+
+  box = util::geo::pad(box, _cfg->outputPadding);
+
+  _rparams.xOff = box.getLowerLeft().getX();
+  _rparams.yOff = box.getLowerLeft().getY();
+
+  _rparams.width =
+      ceil((box.getUpperRight().getX() - _rparams.xOff) * _res);
+  _rparams.height =
+      ceil((box.getUpperRight().getY() - _rparams.yOff) * _res);
+
+  if (_rparams.width < 1 || _rparams.height < 1) {
+    throw RendererException("Empty PNG output");
+  }
+
+  if (_cfg->renderLabels) {
+    LOGTO(WARN, std::cerr) << "Labels are not rendered to PNG";
+  }
+
+  _r.reset(new Rasterizer(_rparams.width, _rparams.height));
+
+  LOGTO(DEBUG, std::cerr) << "Rendering edges...";
+  if (_cfg->renderEdges) {
+    outputEdges(outG);
+
+    // line parts were rendered in reverse drawing order
+    for (auto it = _lineParts.rbegin(); it != _lineParts.rend(); it++) {
+      if (_cfg->outlineWidth > 0) {
+        renderLine(it->geom, _cfg->lineWidth + _cfg->outlineWidth, true,
+                   RasterColor(0, 0, 0, 255));
+      }
+      renderLine(it->geom, _cfg->lineWidth, true, it->color);
+    }
+    _lineParts.clear();
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Rendering nodes...";
+  if (_cfg->renderNodeConnections) {
+    for (auto n : outG.getNds()) renderNodeConnections(outG, n);
+  }
+
+  outputNodes(outG);
+
+  LOGTO(DEBUG, std::cerr) << "Rasterizing " << _rparams.width << "x"
+                          << _rparams.height << " pixels...";
+  std::vector<uint8_t> rgba;
+  _r->render(&rgba);
+  _r.reset();
+
+  PngWriter::write(_o, _rparams.width, _rparams.height, rgba);
+}
+
+// _____________________________________________________________________________
+std::vector<DPoint> PngRenderer::toPx(const DLine& l) const {
+  std::vector<DPoint> ret;
+  ret.reserve(l.size());
+  for (const auto& p : l) {
+    ret.push_back({(p.getX() - _rparams.xOff) * _res,
+                   _rparams.height - (p.getY() - _rparams.yOff) * _res});
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+void PngRenderer::renderLine(const PolyLine<double>& p, double width,
+                             bool roundCaps, const RasterColor& c) {
+  // vertices deviating less than half a pixel are not visible
+  _r->addStroke(toPx(util::geo::simplify(p.getLine(), 0.5 / _res)),
+                width * _res, roundCaps, c);
+}
+
+// _____________________________________________________________________________
+void PngRenderer::outputNodes(const RenderGraph& outG) {
+  if (!_cfg->renderStations) return;
+
+  for (auto n : outG.getNds()) {
+    if (n->pl().stops().size() == 0 || n->pl().fronts().size() == 0) continue;
+
+    for (const auto& geom : outG.getStopGeoms(n, _cfg->tightStations, 32)) {
+      auto ring = toPx(geom.getOuter());
+      _r->addPolygon(ring, RasterColor(255, 255, 255, 255));
+
+      // closed outline
+      if (!ring.empty()) ring.push_back(ring.front());
+      _r->addStroke(ring, (_cfg->lineWidth / 2) * _res, false,
+                    RasterColor(0, 0, 0, 255));
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void PngRenderer::outputEdges(const RenderGraph& outG) {
+  // same edge order as in the SvgRenderer
+  for (const auto* e : getEdgeOrder(outG)) renderEdgeTripGeom(outG, e);
+}
+
+// _____________________________________________________________________________
+void PngRenderer::renderEdgeTripGeom(const RenderGraph& outG,
+                                     const shared::linegraph::LineEdge* e) {
+  for (const auto& part : getEdgeLineParts(outG, e, _cfg->lineWidth,
+                                           _cfg->outlineWidth,
+                                           _cfg->lineSpacing)) {
+    const auto& lo = e->pl().lineOccAtPos(part.pos);
+    _lineParts.push_back(
+        PngLinePart(part.geom, RasterColor::fromHex(lo.line->color())));
+  }
+}
+
+// _____________________________________________________________________________
+void PngRenderer::renderNodeConnections(const RenderGraph& outG,
+                                        const LineNode* n) {
+  // don't sample inner geometries finer than a single pixel
+  double prec = _cfg->innerGeometryPrecision;
+  if (prec > 0) prec = std::max(prec, 1.0 / _res);
+
+  auto geoms = outG.innerGeoms(n, prec);
+
+  for (auto& clique : getInnerCliques(n, geoms, 9999)) renderClique(clique, n);
+}
+
+// _____________________________________________________________________________
+void PngRenderer::renderClique(const InnerClique& cc, const LineNode* n) {
+  // per line, the outlines are drawn below the line geometries, as in the
+  // SvgRenderer
+  std::map<uintptr_t, std::vector<PngLinePart>> parts;
+
+  for (const auto& ig : getCliqueGeoms(cc, n, _cfg->lineWidth,
+                                       _cfg->outlineWidth,
+                                       _cfg->lineSpacing)) {
+    parts[(uintptr_t)ig.from.line].push_back(
+        PngLinePart(ig.geom, RasterColor::fromHex(ig.from.line->color())));
+  }
+
+  for (const auto& lp : parts) {
+    if (_cfg->outlineWidth > 0) {
+      for (const auto& part : lp.second) {
+        renderLine(part.geom, _cfg->lineWidth + _cfg->outlineWidth, false,
+                   RasterColor(0, 0, 0, 255));
+      }
+    }
+    for (const auto& part : lp.second) {
+      renderLine(part.geom, _cfg->lineWidth, true, part.color);
+    }
+  }
+}
@@ -0,0 +1,72 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_PNGRENDERER_H_
+#define TRANSITMAP_OUTPUT_PNGRENDERER_H_
+
+#include <memory>
+#include <ostream>
+#include <set>
+#include <vector>
+#include "Renderer.h"
+#include "shared/linegraph/Line.h"
+#include "shared/rendergraph/RenderGraph.h"
+#include "transitmap/config/TransitMapConfig.h"
+#include "transitmap/output/Rasterizer.h"
+#include "util/geo/Geo.h"
+#include "util/geo/PolyLine.h"
+
+namespace transitmapper {
+namespace output {
+
+struct PngLinePart {
+  PngLinePart(const util::geo::PolyLine<double>& geom, const RasterColor& c)
+      : geom(geom), color(c) {}
+  util::geo::PolyLine<double> geom;
+  RasterColor color;
+};
+
+// Renders the same geometry as the SvgRenderer directly into a PNG image,
+// without the XML step. Image pixels are SVG pixels scaled by pngDpi / 96.
+class PngRenderer : public Renderer {
+ public:
+  PngRenderer(std::ostream* o, const config::Config* cfg);
+  virtual ~PngRenderer(){};
+
+  virtual void print(const shared::rendergraph::RenderGraph& outputGraph);
+
+ private:
+  std::ostream* _o;
+  const config::Config* _cfg;
+
+  // pixels per map unit
+  double _res;
+  RenderParams _rparams;
+
+  std::unique_ptr<Rasterizer> _r;
+
+  std::vector<PngLinePart> _lineParts;
+
+  std::vector<util::geo::DPoint> toPx(const util::geo::DLine& l) const;
+
+  void outputNodes(const shared::rendergraph::RenderGraph& outputGraph);
+  void outputEdges(const shared::rendergraph::RenderGraph& outputGraph);
+
+  void renderEdgeTripGeom(const shared::rendergraph::RenderGraph& outG,
+                          const shared::linegraph::LineEdge* e);
+
+  void renderNodeConnections(const shared::rendergraph::RenderGraph& outG,
+                             const shared::linegraph::LineNode* n);
+
+  // width in map units
+  void renderLine(const util::geo::PolyLine<double>& p, double width,
+                  bool roundCaps, const RasterColor& c);
+
+  void renderClique(const InnerClique& c,
+                    const shared::linegraph::LineNode* node);
+};
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_PNGRENDERER_H_
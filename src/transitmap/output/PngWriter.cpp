@@ -0,0 +1,158 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifdef ZLIB_FOUND
+#include <zlib.h>
+#endif
+
+#include "transitmap/output/PngWriter.h"
+#include "transitmap/output/Renderer.h"
+
+using transitmapper::output::PngWriter;
+using transitmapper::output::RendererException;
+
+// IDAT chunks are written once this many compressed bytes are buffered
+static const size_t IDAT_SIZE = 1 << 20;
+
+// _____________________________________________________________________________
+void PngWriter::write(std::ostream* o, size_t width, size_t height,
+                      const std::vector<uint8_t>& rgba) {
+  o->write("\x89PNG\r\n\x1a\n", 8);
+
+  std::string ihdr;
+  put32(&ihdr, width);
+  put32(&ihdr, height);
+  // 8 bit depth, RGBA, deflate, adaptive filtering, no interlace
+  ihdr += std::string("\x08\x06\x00\x00\x00", 5);
+  writeChunk(o, "IHDR", ihdr);
+
+  size_t rowLen = width * 4 + 1;
+  std::string row(rowLen, 0);
+  std::string idat;
+
+#ifdef ZLIB_FOUND
+  z_stream zs;
+  zs.zalloc = Z_NULL;
+  zs.zfree = Z_NULL;
+  zs.opaque = Z_NULL;
+  if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) {
+    throw RendererException("Could not initialize zlib");
+  }
+
+  char out[64 * 1024];
+#else
+  // uncompressed deflate: zlib header, stored blocks of at most 65535 bytes,
+  // Adler-32 of the raw data
+  idat += std::string("\x78\x01", 2);
+  std::string block;
+  uint32_t adlerA = 1, adlerB = 0;
+#endif
+
+  for (size_t y = 0; y < height; y++) {
+    const uint8_t* src = rgba.data() + y * width * 4;
+
+    // "sub" filter
+    row[0] = 1;
+    for (size_t i = 0; i < width * 4; i++) {
+      row[i + 1] = src[i] - (i < 4 ? 0 : src[i - 4]);
+    }
+
+#ifdef ZLIB_FOUND
+    zs.next_in = reinterpret_cast<Bytef*>(&row[0]);
+    zs.avail_in = rowLen;
+    do {
+      zs.next_out = reinterpret_cast<Bytef*>(out);
+      zs.avail_out = sizeof(out);
+      deflate(&zs, Z_NO_FLUSH);
+      idat.append(out, sizeof(out) - zs.avail_out);
+    } while (zs.avail_out == 0);
+#else
+    for (char c : row) {
+      adlerA = (adlerA + static_cast<uint8_t>(c)) % 65521;
+      adlerB = (adlerB + adlerA) % 65521;
+    }
+
+    block += row;
+    while (block.size() >= 65535) {
+      storedBlock(&idat, block.substr(0, 65535), false);
+      block.erase(0, 65535);
+    }
+#endif
+
+    if (idat.size() >= IDAT_SIZE) {
+      writeChunk(o, "IDAT", idat);
+      idat.clear();
+    }
+  }
+
+#ifdef ZLIB_FOUND
+  int ret;
+  do {
+    zs.next_out = reinterpret_cast<Bytef*>(out);
+    zs.avail_out = sizeof(out);
+    ret = deflate(&zs, Z_FINISH);
+    idat.append(out, sizeof(out) - zs.avail_out);
+  } while (ret == Z_OK);
+  deflateEnd(&zs);
+#else
+  storedBlock(&idat, block, true);
+  put32(&idat, (adlerB << 16) | adlerA);
+#endif
+
+  if (!idat.empty()) writeChunk(o, "IDAT", idat);
+  writeChunk(o, "IEND", "");
+}
+
+// _____________________________________________________________________________
+void PngWriter::writeChunk(std::ostream* o, const char* type,
+                           const std::string& data) {
+  std::string chunk;
+  put32(&chunk, data.size());
+  chunk += type;
+  chunk += data;
+
+  // the CRC covers the chunk type and data
+  put32(&chunk, crc32(0, chunk.substr(4)));
+
+  o->write(chunk.data(), chunk.size());
+}
+
+// _____________________________________________________________________________
+void PngWriter::storedBlock(std::string* s, const std::string& data,
+                            bool final) {
+  size_t len = data.size();
+  *s += static_cast<char>(final ? 1 : 0);
+  *s += static_cast<char>(len & 0xff);
+  *s += static_cast<char>(len >> 8);
+  *s += static_cast<char>(~len & 0xff);
+  *s += static_cast<char>((~len >> 8) & 0xff);
+  *s += data;
+}
+
+// _____________________________________________________________________________
+void PngWriter::put32(std::string* s, uint32_t v) {
+  *s += static_cast<char>(v >> 24);
+  *s += static_cast<char>((v >> 16) & 0xff);
+  *s += static_cast<char>((v >> 8) & 0xff);
+  *s += static_cast<char>(v & 0xff);
+}
+
+// _____________________________________________________________________________
+uint32_t PngWriter::crc32(uint32_t crc, const std::string& data) {
+  static const std::vector<uint32_t> table = [] {
+    std::vector<uint32_t> t(256);
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (size_t k = 0; k < 8; k++) c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+      t[i] = c;
+    }
+    return t;
+  }();
+
+  crc = ~crc;
+  for (char c : data) {
+    crc = table[(crc ^ static_cast<uint8_t>(c)) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
@@ -0,0 +1,37 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_PNGWRITER_H_
+#define TRANSITMAP_OUTPUT_PNGWRITER_H_
+
+#include <stdint.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace transitmapper {
+namespace output {
+
+// Writer for 8 bit RGBA PNG images. Rows are written with the "sub" filter.
+// The image data is deflated with zlib if transitmap was built with it,
+// otherwise it is written as uncompressed deflate blocks.
+class PngWriter {
+ public:
+  // rgba is non-premultiplied, 4 bytes per pixel, row by row
+  static void write(std::ostream* o, size_t width, size_t height,
+                    const std::vector<uint8_t>& rgba);
+
+ private:
+  static void writeChunk(std::ostream* o, const char* type,
+                         const std::string& data);
+  static void storedBlock(std::string* s, const std::string& data,
+                          bool final);
+  static void put32(std::string* s, uint32_t v);
+  static uint32_t crc32(uint32_t crc, const std::string& data);
+};
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_PNGWRITER_H_
@@ -0,0 +1,313 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "transitmap/output/Rasterizer.h"
+
+using transitmapper::output::RasterColor;
+using transitmapper::output::Rasterizer;
+using util::geo::DPoint;
+
+// below this many pixels, a gap at a stroke join is not visible
+static const double JOIN_TOLERANCE = 0.1;
+
+// _____________________________________________________________________________
+RasterColor RasterColor::fromHex(const std::string& hex) {
+  std::string h = hex;
+  if (!h.empty() && h[0] == '#') h = h.substr(1);
+  if (h.size() == 3) h = {h[0], h[0], h[1], h[1], h[2], h[2]};
+  if (h.size() < 6) return RasterColor();
+
+  return RasterColor(strtol(h.substr(0, 2).c_str(), 0, 16),
+                     strtol(h.substr(2, 2).c_str(), 0, 16),
+                     strtol(h.substr(4, 2).c_str(), 0, 16), 255);
+}
+
+// _____________________________________________________________________________
+Rasterizer::Rasterizer(size_t width, size_t height)
+    : _width(width), _height(height) {}
+
+// _____________________________________________________________________________
+void Rasterizer::addStroke(const std::vector<DPoint>& line, double width,
+                           bool roundCaps, const RasterColor& c) {
+  if (line.empty() || width <= 0) return;
+
+  size_t from = _edges.size();
+  double h = width / 2;
+
+  bool closed = line.size() > 2 && util::geo::dist(line.front(), line.back()) <
+                                       JOIN_TOLERANCE / 100;
+
+  // the previous segment direction, to skip joins of collinear segments
+  double pdx = 0, pdy = 0;
+
+  for (size_t i = 1; i < line.size(); i++) {
+    const auto& p = line[i - 1];
+    const auto& q = line[i];
+    double dx = q.getX() - p.getX();
+    double dy = q.getY() - p.getY();
+    double len = sqrt(dx * dx + dy * dy);
+    if (len < 1e-9) continue;
+    dx /= len;
+    dy /= len;
+
+    double nx = -dy * h;
+    double ny = dx * h;
+
+    addRing({{p.getX() + nx, p.getY() + ny},
+             {q.getX() + nx, q.getY() + ny},
+             {q.getX() - nx, q.getY() - ny},
+             {p.getX() - nx, p.getY() - ny}},
+            true);
+
+    // round join with the previous segment, the outer gap of a join with
+    // angle a is about h * a wide
+    if (pdx != 0 || pdy != 0) {
+      double cross = fabs(pdx * dy - pdy * dx);
+      double dot = pdx * dx + pdy * dy;
+      if (dot < 0 || h * cross > JOIN_TOLERANCE) addCircle(p, h);
+    }
+
+    pdx = dx;
+    pdy = dy;
+  }
+
+  if (closed) {
+    addCircle(line.front(), h);
+  } else if (roundCaps) {
+    addCircle(line.front(), h);
+    addCircle(line.back(), h);
+  }
+
+  endShape(from, c);
+}
+
+// _____________________________________________________________________________
+void Rasterizer::addPolygon(const std::vector<DPoint>& ring,
+                            const RasterColor& c) {
+  size_t from = _edges.size();
+  addRing(ring, false);
+  endShape(from, c);
+}
+
+// _____________________________________________________________________________
+void Rasterizer::addCircle(const DPoint& c, double r) {
+  // keep the maximum deviation from the true circle below JOIN_TOLERANCE
+  size_t n = 8;
+  if (r > JOIN_TOLERANCE) {
+    n = std::max<size_t>(n, ceil(M_PI / acos(1 - JOIN_TOLERANCE / r)));
+  }
+  n = std::min<size_t>(n, 256);
+
+  std::vector<DPoint> ring;
+  ring.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    double a = 2 * M_PI * i / n;
+    ring.push_back({c.getX() + r * cos(a), c.getY() + r * sin(a)});
+  }
+
+  addRing(ring, true);
+}
+
+// _____________________________________________________________________________
+void Rasterizer::addRing(const std::vector<DPoint>& ring, bool normalize) {
+  if (ring.size() < 3) return;
+
+  // rings of a single stroke must have the same orientation, otherwise
+  // overlaps cancel out under non-zero winding
+  bool rev = false;
+  if (normalize) {
+    double area = 0;
+    for (size_t i = 0; i < ring.size(); i++) {
+      const auto& a = ring[i];
+      const auto& b = ring[(i + 1) % ring.size()];
+      area += a.getX() * b.getY() - b.getX() * a.getY();
+    }
+    rev = area < 0;
+  }
+
+  for (size_t i = 0; i < ring.size(); i++) {
+    const auto* a = &ring[i];
+    const auto* b = &ring[(i + 1) % ring.size()];
+    if (rev) std::swap(a, b);
+    if (a->getY() == b->getY()) continue;
+
+    if (a->getY() < b->getY()) {
+      _edges.push_back({a->getX(), a->getY(), b->getX(), b->getY(), 1});
+    } else {
+      _edges.push_back({b->getX(), b->getY(), a->getX(), a->getY(), -1});
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void Rasterizer::endShape(size_t from, const RasterColor& c) {
+  if (_edges.size() == from) return;
+
+  std::sort(_edges.begin() + from, _edges.end(),
+            [](const Edge& a, const Edge& b) { return a.y0 < b.y0; });
+
+  Shape s{from, _edges.size(), c, HUGE_VAL, HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+
+  for (size_t i = from; i < _edges.size(); i++) {
+    const auto& e = _edges[i];
+    s.minX = std::min(s.minX, std::min(e.x0, e.x1));
+    s.maxX = std::max(s.maxX, std::max(e.x0, e.x1));
+    s.minY = std::min(s.minY, e.y0);
+    s.maxY = std::max(s.maxY, e.y1);
+  }
+
+  _shapes.push_back(s);
+}
+
+// _____________________________________________________________________________
+void Rasterizer::render(std::vector<uint8_t>* rgba) const {
+  size_t numTiles = (_height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+
+  // shapes intersecting each tile, in drawing order
+  std::vector<std::vector<size_t>> tileShapes(numTiles);
+
+  for (size_t i = 0; i < _shapes.size(); i++) {
+    const auto& s = _shapes[i];
+    if (s.maxY < 0 || s.minY >= _height || s.maxX < 0 || s.minX >= _width)
+      continue;
+
+    size_t t0 = std::max(0.0, floor(s.minY)) / TILE_HEIGHT;
+    size_t t1 = std::min<double>(_height - 1, floor(s.maxY)) / TILE_HEIGHT;
+
+    for (size_t t = t0; t <= t1; t++) tileShapes[t].push_back(i);
+  }
+
+  rgba->assign(_width * _height * 4, 0);
+
+  // tiles cover distinct rows of the output
+#pragma omp parallel for schedule(dynamic)
+  for (size_t t = 0; t < numTiles; t++) {
+    std::vector<float> buf;
+    renderTile(t, tileShapes[t], &buf);
+
+    uint8_t* out = rgba->data() + t * TILE_HEIGHT * _width * 4;
+
+    for (size_t i = 0; i < buf.size() / 4; i++) {
+      float a = buf[i * 4 + 3];
+      if (a <= 0) continue;
+
+      // buffer is premultiplied
+      for (size_t j = 0; j < 3; j++) {
+        out[i * 4 + j] = std::min(255.0f, buf[i * 4 + j] / a * 255 + 0.5f);
+      }
+      out[i * 4 + 3] = std::min(255.0f, a * 255 + 0.5f);
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void Rasterizer::renderTile(size_t tile, const std::vector<size_t>& shapes,
+                            std::vector<float>* buf) const {
+  size_t row0 = tile * TILE_HEIGHT;
+  size_t row1 = std::min(_height, row0 + TILE_HEIGHT);
+
+  buf->assign((row1 - row0) * _width * 4, 0);
+
+  // coverage of the current row, always reset to 0 after compositing
+  std::vector<float> cov(_width + 1, 0);
+
+  for (size_t i : shapes) {
+    const auto& s = _shapes[i];
+    size_t r0 = std::max<double>(row0, floor(s.minY));
+    size_t r1 = std::min<double>(row1, floor(s.maxY) + 1);
+    if (r0 >= r1) continue;
+    renderShapeRows(s, r0, r1, row0, &cov, buf);
+  }
+}
+
+// _____________________________________________________________________________
+void Rasterizer::renderShapeRows(const Shape& s, size_t row0, size_t row1,
+                                 size_t tileRow0, std::vector<float>* cov,
+                                 std::vector<float>* buf) const {
+  size_t cx0 = std::max(0.0, floor(s.minX));
+  size_t cx1 = std::min<double>(_width, floor(s.maxX) + 1);
+  if (cx0 >= cx1) return;
+
+  float alpha = s.c.a / 255.0f;
+  float col[3] = {s.c.r / 255.0f, s.c.g / 255.0f, s.c.b / 255.0f};
+  float wgt = 1.0f / SUB_SAMPLES;
+
+  std::vector<const Edge*> active;
+  std::vector<std::pair<double, int>> xs;
+  size_t next = s.from;
+
+  for (size_t row = row0; row < row1; row++) {
+    bool any = false;
+
+    for (size_t k = 0; k < SUB_SAMPLES; k++) {
+      double y = row + (k + 0.5) / SUB_SAMPLES;
+
+      while (next < s.to && _edges[next].y0 <= y) {
+        if (_edges[next].y1 > y) active.push_back(&_edges[next]);
+        next++;
+      }
+
+      active.erase(std::remove_if(active.begin(), active.end(),
+                                  [y](const Edge* e) { return e->y1 <= y; }),
+                   active.end());
+
+      if (active.size() < 2) continue;
+
+      xs.clear();
+      for (const auto* e : active) {
+        xs.push_back(
+            {e->x0 + (y - e->y0) * (e->x1 - e->x0) / (e->y1 - e->y0), e->dir});
+      }
+
+      std::sort(xs.begin(), xs.end());
+
+      int wind = 0;
+      double start = 0;
+      for (const auto& x : xs) {
+        int prev = wind;
+        wind += x.second;
+        if (prev == 0 && wind != 0) {
+          start = x.first;
+        } else if (prev != 0 && wind == 0) {
+          // add the span [start, x.first) to the row coverage
+          double xa = std::max<double>(start, cx0);
+          double xb = std::min<double>(x.first, cx1);
+          if (xb <= xa) continue;
+          any = true;
+
+          size_t ia = xa;
+          size_t ib = xb;
+          if (ia == ib) {
+            (*cov)[ia] += (xb - xa) * wgt;
+          } else {
+            (*cov)[ia] += (ia + 1 - xa) * wgt;
+            for (size_t j = ia + 1; j < ib; j++) (*cov)[j] += wgt;
+            (*cov)[ib] += (xb - ib) * wgt;
+          }
+        }
+      }
+    }
+
+    if (!any) continue;
+
+    float* out = buf->data() + (row - tileRow0) * _width * 4;
+
+    for (size_t x = cx0; x < cx1; x++) {
+      float c = (*cov)[x];
+      (*cov)[x] = 0;
+      if (c <= 0) continue;
+
+      float a = std::min(1.0f, c) * alpha;
+      for (size_t j = 0; j < 3; j++) {
+        out[x * 4 + j] = col[j] * a + out[x * 4 + j] * (1 - a);
+      }
+      out[x * 4 + 3] = a + out[x * 4 + 3] * (1 - a);
+    }
+    (*cov)[cx1] = 0;
+  }
+}
@@ -0,0 +1,86 @@
+// Copyright 2023, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_RASTERIZER_H_
+#define TRANSITMAP_OUTPUT_RASTERIZER_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "util/geo/Geo.h"
+
+namespace transitmapper {
+namespace output {
+
+struct RasterColor {
+  RasterColor() : r(0), g(0), b(0), a(255) {}
+  RasterColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+      : r(r), g(g), b(b), a(a) {}
+
+  // parse a hex color like "ff0000", an optional leading '#' is skipped
+  static RasterColor fromHex(const std::string& hex);
+
+  uint8_t r, g, b, a;
+};
+
+// Anti-aliased scanline rasterizer. Shapes are collected first and later
+// drawn in the order they were added. Each shape is filled with non-zero
+// winding, so overlapping parts of a single stroke do not blend twice.
+// Coverage is exact along a scanline and sampled on SUB_SAMPLES sub-scanlines
+// per pixel row. The image is rendered in horizontal tiles in parallel.
+class Rasterizer {
+ public:
+  static const size_t SUB_SAMPLES = 5;
+  static const size_t TILE_HEIGHT = 64;
+
+  Rasterizer(size_t width, size_t height);
+
+  // all coordinates are in pixels, y pointing down
+  void addStroke(const std::vector<util::geo::DPoint>& line, double width,
+                 bool roundCaps, const RasterColor& c);
+  void addPolygon(const std::vector<util::geo::DPoint>& ring,
+                  const RasterColor& c);
+
+  size_t getWidth() const { return _width; }
+  size_t getHeight() const { return _height; }
+
+  // non-premultiplied RGBA, 4 bytes per pixel, row by row
+  void render(std::vector<uint8_t>* rgba) const;
+
+ private:
+  // y0 < y1, dir is the winding direction of the original edge
+  struct Edge {
+    double x0, y0, x1, y1;
+    int dir;
+  };
+
+  struct Shape {
+    // edges are sorted by y0
+    size_t from, to;
+    RasterColor c;
+    double minX, minY, maxX, maxY;
+  };
+
+  size_t _width, _height;
+
+  std::vector<Edge> _edges;
+  std::vector<Shape> _shapes;
+
+  void addRing(const std::vector<util::geo::DPoint>& ring, bool normalize);
+  void addCircle(const util::geo::DPoint& c, double r);
+  void endShape(size_t from, const RasterColor& c);
+
+  void renderTile(size_t tile, const std::vector<size_t>& shapes,
+                  std::vector<float>* buf) const;
+  void renderShapeRows(const Shape& s, size_t row0, size_t row1,
+                       size_t tileRow0, std::vector<float>* cov,
+                       std::vector<float>* buf) const;
+};
+
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_RASTERIZER_H_
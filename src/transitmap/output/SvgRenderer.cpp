@@ -4,6 +4,8 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <ostream>
 
@@ -11,6 +13,8 @@
 #include "shared/rendergraph/RenderGraph.h"
 #include "transitmap/config/TransitMapConfig.h"
 #include "transitmap/label/Labeller.h"
+#include "transitmap/output/InnerCliques.h"
+#include "transitmap/output/LineParts.h"
 #include "transitmap/output/SvgRenderer.h"
 #include "util/String.h"
 #include "util/geo/PolyLine.h"
@@ -22,6 +26,10 @@ using shared::rendergraph::InnerGeom;
 using shared::rendergraph::RenderGraph;
 using transitmapper::label::Labeller;
 using transitmapper::output::InnerClique;
+using transitmapper::output::getCliqueGeoms;
+using transitmapper::output::getEdgeLineParts;
+using transitmapper::output::getEdgeOrder;
+using transitmapper::output::getInnerCliques;
 using transitmapper::output::SvgRenderer;
 using util::geo::DPoint;
 using util::geo::DPolygon;
@@ -32,10 +40,32 @@ using util::geo::PolyLine;
 
 // _____________________________________________________________________________
 SvgRenderer::SvgRenderer(std::ostream* o, const config::Config* cfg)
-    : _o(o), _w(o, true), _cfg(cfg) {}
+    : _o(o),
+      _w(o, true),
+      _cfg(cfg),
+      _delegates(cfg->svgSpillSize * 1024 * 1024),
+      _backdropDelegates(cfg->svgSpillSize * 1024 * 1024),
+      _spool(&_delegates) {}
 
 // _____________________________________________________________________________
 void SvgRenderer::print(const RenderGraph& outG) {
+  Labeller labeller(_cfg);
+  if (_cfg->renderLabels) {
+    LOGTO(DEBUG, std::cerr) << "Rendering labels...";
+    labeller.label(outG, _cfg->dontLabelDeg2);
+  }
+
+  print(outG, labeller);
+}
+
+// _____________________________________________________________________________
+void SvgRenderer::print(const RenderGraph& outG, const Labeller& labeller) {
+  print(outG, labeller, 0);
+}
+
+// _____________________________________________________________________________
+void SvgRenderer::print(const RenderGraph& outG, const Labeller& labeller,
+                        const RenderGraph* backdrop) {
   std::map<std::string, std::string> params;
   RenderParams rparams;
 
@@ -44,13 +74,13 @@ void SvgRenderer::print(const RenderGraph& outG) {
   box = util::geo::pad(
       box, outG.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing));
 
-  Labeller labeller(_cfg);
   if (_cfg->renderLabels) {
-    LOGTO(DEBUG, std::cerr) << "Rendering labels...";
-    labeller.label(outG, _cfg->dontLabelDeg2);
     box = util::geo::extendBox(labeller.getBBox(), box);
   }
 
+  // a clipped graph is only drawn within its viewport
+  if (_cfg->clip) box = _cfg->clipBox;
+
   double p = _cfg->outputPadding;
 
   box = util::geo::pad(box, p);
@@ -94,6 +124,10 @@ void SvgRenderer::print(const RenderGraph& outG) {
                       std::to_string(rparams.height);
   params["xmlns"] = "http://www.w3.org/2000/svg";
   params["xmlns:xlink"] = "http://www.w3.org/1999/xlink";
+  if (_cfg->svgLayers) {
+    params["xmlns:inkscape"] = "http://www.inkscape.org/namespaces/inkscape";
+  }
+  if (!_cfg->svgLang.empty()) params["xml:lang"] = _cfg->svgLang;
 
   *_o << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
   *_o << "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" "
@@ -102,11 +136,18 @@ void SvgRenderer::print(const RenderGraph& outG) {
   LOGTO(DEBUG, std::cerr) << "Rendering edges...";
   if (_cfg->renderEdges) {
     outputEdges(outG, rparams);
+    if (backdrop) outputBackdropEdges(*backdrop, box, rparams);
   }
   _w.openTag("svg", params);
 
   _w.openTag("defs");
 
+  if (_cfg->svgCompact) {
+    _w.openTag("style");
+    _w.writeText(getStyleBlock(outG, backdrop));
+    _w.closeTag();
+  }
+
   LOGTO(DEBUG, std::cerr) << "Rendering markers...";
   for (auto const& m : _markers) {
     params.clear();
@@ -132,16 +173,26 @@ void SvgRenderer::print(const RenderGraph& outG) {
 
   _w.closeTag();
 
-  LOGTO(DEBUG, std::cerr) << "Rendering nodes...";
-  for (auto n : outG.getNds()) {
-    if (_cfg->renderNodeConnections) {
-      renderNodeConnections(outG, n, rparams);
-    }
+  if (backdrop) {
+    LOGTO(DEBUG, std::cerr) << "Writing backdrop...";
+    renderBackdrop(*backdrop, box, rparams);
   }
 
   LOGTO(DEBUG, std::cerr) << "Writing edges...";
   renderDelegates(outG, rparams);
 
+  // inner node connections are written directly after they were rendered,
+  // so only the connections of a single node are held in memory
+  LOGTO(DEBUG, std::cerr) << "Rendering nodes...";
+  if (_cfg->renderNodeConnections) {
+    if (_cfg->svgLayers) openLayer("connections", "Node Connections");
+    for (auto n : outG.getNds()) {
+      renderNodeConnections(outG, n, rparams);
+      renderInnerDelegates(rparams);
+    }
+    if (_cfg->svgLayers) _w.closeTag();
+  }
+
   LOGTO(DEBUG, std::cerr) << "Writing nodes...";
   outputNodes(outG, rparams);
   if (_cfg->renderNodeFronts) {
@@ -160,7 +211,12 @@ void SvgRenderer::print(const RenderGraph& outG) {
 // _____________________________________________________________________________
 void SvgRenderer::outputNodes(const RenderGraph& outG,
                               const RenderParams& rparams) {
-  _w.openTag("g");
+  if (_cfg->svgCompact) {
+    outputNodesCompact(outG, rparams);
+    return;
+  }
+
+  openLayer("stations", "Stations");
   for (auto n : outG.getNds()) {
     std::map<std::string, std::string> params;
 
@@ -179,6 +235,143 @@ void SvgRenderer::outputNodes(const RenderGraph& outG,
   _w.closeTag();
 }
 
+// _____________________________________________________________________________
+void SvgRenderer::outputNodesCompact(const RenderGraph& outG,
+                                     const RenderParams& rparams) {
+  if (!_cfg->renderStations) return;
+
+  struct StationShape {
+    int64_t x, y;
+    std::string path;
+  };
+
+  std::vector<StationShape> shapes;
+  std::map<std::string, size_t> counts;
+
+  for (auto n : outG.getNds()) {
+    if (n->pl().stops().size() == 0 || n->pl().fronts().size() == 0) continue;
+
+    for (const auto& geom : outG.getStopGeoms(n, _cfg->tightStations, 32)) {
+      StationShape s;
+      s.path = getRelPath(geom.getOuter(), true, &s.x, &s.y, rparams);
+      counts[s.path]++;
+      shapes.push_back(s);
+    }
+  }
+
+  openLayer("stations", "Stations");
+
+  // station shapes which occur more than once are defined once as a symbol
+  std::map<std::string, std::string> symbols;
+  _w.openTag("defs");
+  for (const auto& c : counts) {
+    if (c.second < 2) continue;
+    std::string id = "st" + std::to_string(symbols.size());
+    symbols[c.first] = id;
+    _w.openTag("symbol", {{"id", id}, {"overflow", "visible"}});
+    _w.openTag("path", {{"d", "M0,0" + c.first}});
+    _w.closeTag();
+    _w.closeTag();
+  }
+  _w.closeTag();
+
+  for (const auto& s : shapes) {
+    auto i = symbols.find(s.path);
+    if (i == symbols.end()) {
+      _w.openTag("path",
+                 {{"class", "station-poly"},
+                  {"d", "M" + fmtTenths(s.x) + "," + fmtTenths(s.y) + s.path}});
+    } else {
+      _w.openTag("use", {{"class", "station-poly"},
+                         {"xlink:href", "#" + i->second},
+                         {"x", fmtTenths(s.x)},
+                         {"y", fmtTenths(s.y)}});
+    }
+    _w.closeTag();
+  }
+
+  _w.closeTag();
+}
+
+// _____________________________________________________________________________
+std::string SvgRenderer::getStyleBlock(const RenderGraph& outG,
+                                       const RenderGraph* backdrop) const {
+  double w = _cfg->lineWidth * _cfg->outputResolution;
+  double ow = (_cfg->lineWidth + _cfg->outlineWidth) * _cfg->outputResolution;
+
+  std::stringstream ret;
+  ret << ".transit-edge,.inner-geom{fill:none;stroke-linecap:round;"
+      << "stroke-width:" << w << "}"
+      << ".transit-edge-outline{fill:none;stroke:#000000;"
+      << "stroke-linecap:round;stroke-width:" << ow << "}"
+      << ".inner-geom-outline{fill:none;stroke:#000000;"
+      << "stroke-linecap:butt;stroke-width:" << ow << "}"
+      << ".station-poly{fill:white;stroke:black;stroke-width:"
+      << (_cfg->lineWidth / 2) * _cfg->outputResolution << "}";
+
+  std::map<std::string, std::string> colors;
+  for (auto g : {&outG, backdrop}) {
+    if (!g) continue;
+    for (auto n : g->getNds()) {
+      for (auto e : n->getAdjList()) {
+        for (const auto& lo : e->pl().getLines()) {
+          colors[getLineClass(lo.line->id())] = lo.line->color();
+        }
+      }
+    }
+  }
+
+  for (const auto& c : colors) {
+    ret << ".transit-edge." << c.first << ",.inner-geom." << c.first
+        << "{stroke:#" << c.second << "}";
+  }
+
+  return ret.str();
+}
+
+// _____________________________________________________________________________
+std::string SvgRenderer::getRelPath(const util::geo::DLine& l, bool close,
+                                    int64_t* x0, int64_t* y0,
+                                    const RenderParams& rparams) const {
+  std::stringstream ret;
+  int64_t px = 0, py = 0;
+
+  for (size_t i = 0; i < l.size(); i++) {
+    // tenths of output pixels, deltas are taken between rounded points so
+    // that rounding errors do not add up
+    int64_t x = llround((l[i].getX() - rparams.xOff) *
+                        _cfg->outputResolution * 10);
+    int64_t y = llround((rparams.height - (l[i].getY() - rparams.yOff) *
+                                              _cfg->outputResolution) *
+                        10);
+
+    if (i == 0) {
+      *x0 = x;
+      *y0 = y;
+    } else {
+      if (x == px && y == py) continue;
+      ret << (ret.tellp() > 0 ? " " : "l") << fmtTenths(x - px) << ","
+          << fmtTenths(y - py);
+    }
+
+    px = x;
+    py = y;
+  }
+
+  if (close) ret << "z";
+
+  return ret.str();
+}
+
+// _____________________________________________________________________________
+std::string SvgRenderer::fmtTenths(int64_t v) {
+  std::string ret = v < 0 ? "-" : "";
+  uint64_t a = v < 0 ? -v : v;
+  ret += std::to_string(a / 10);
+  if (a % 10) ret += "." + std::to_string(a % 10);
+  return ret;
+}
+
 // _____________________________________________________________________________
 void SvgRenderer::renderNodeFronts(const RenderGraph& outG,
                                    const RenderParams& rparams) {
@@ -212,237 +405,123 @@ void SvgRenderer::renderNodeFronts(const RenderGraph& outG,
 // _____________________________________________________________________________
 void SvgRenderer::outputEdges(const RenderGraph& outG,
                               const RenderParams& rparams) {
-  struct cmp {
-    bool operator()(const LineNode* lhs, const LineNode* rhs) const {
-      return lhs->getAdjList().size() > rhs->getAdjList().size() ||
-             (lhs->getAdjList().size() == rhs->getAdjList().size() &&
-              RenderGraph::getConnCardinality(lhs) >
-                  RenderGraph::getConnCardinality(rhs)) ||
-             (lhs->getAdjList().size() == rhs->getAdjList().size() &&
-              lhs > rhs);
-    }
-  };
-
-  struct cmpEdge {
-    bool operator()(const shared::linegraph::LineEdge* lhs,
-                    const shared::linegraph::LineEdge* rhs) const {
-      return lhs->pl().getLines().size() < rhs->pl().getLines().size() ||
-             (lhs->pl().getLines().size() == rhs->pl().getLines().size() &&
-              lhs < rhs);
-    }
-  };
-
-  std::set<const LineNode*, cmp> nodesOrdered;
-  std::set<const shared::linegraph::LineEdge*, cmpEdge> edgesOrdered;
-  for (auto nd : outG.getNds()) nodesOrdered.insert(nd);
-
-  std::set<const shared::linegraph::LineEdge*> rendered;
-
-  for (const auto n : nodesOrdered) {
-    edgesOrdered.insert(n->getAdjList().begin(), n->getAdjList().end());
-
-    for (const auto* e : edgesOrdered) {
-      if (rendered.insert(e).second) renderEdgeTripGeom(outG, e, rparams);
-    }
-  }
-}
-
-// _____________________________________________________________________________
-void SvgRenderer::renderNodeConnections(const RenderGraph& outG,
-                                        const LineNode* n,
-                                        const RenderParams& rparams) {
-  UNUSED(rparams);
-  auto geoms = outG.innerGeoms(n, _cfg->innerGeometryPrecision);
-
-  for (auto& clique : getInnerCliques(n, geoms, 9999)) renderClique(clique, n);
+  for (const auto* e : getEdgeOrder(outG)) renderEdgeTripGeom(outG, e, rparams);
 }
 
 // _____________________________________________________________________________
-std::multiset<InnerClique> SvgRenderer::getInnerCliques(
-    const shared::linegraph::LineNode* n, std::vector<InnerGeom> pool,
-    size_t level) const {
-  std::multiset<InnerClique> ret;
-
-  // start with the first geom in pool
-  while (!pool.empty()) {
-    InnerClique cur(n, pool.front());
-    pool.erase(pool.begin());
-
-    size_t p;
-    while ((p = getNextPartner(cur, pool, level)) < pool.size()) {
-      cur.geoms.push_back(pool[p]);
-      pool.erase(pool.begin() + p);
-    }
-
-    ret.insert(cur);
+void SvgRenderer::outputBackdropEdges(const RenderGraph& backdrop,
+                                      const util::geo::DBox& box,
+                                      const RenderParams& rparams) {
+  // the line bundles are wider than the edge geometries
+  auto clip = util::geo::pad(
+      box, backdrop.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing));
+
+  _spool = &_backdropDelegates;
+  for (const auto* e : getEdgeOrder(backdrop)) {
+    if (!util::geo::intersects(*e->pl().getGeom(), clip)) continue;
+    renderEdgeTripGeom(backdrop, e, rparams);
   }
-
-  return ret;
+  _spool = &_delegates;
 }
 
 // _____________________________________________________________________________
-size_t SvgRenderer::getNextPartner(const InnerClique& forClique,
-                                   const std::vector<InnerGeom>& pool,
-                                   size_t level) const {
-  for (size_t i = 0; i < pool.size(); i++) {
-    const auto& ic = pool[i];
-    for (auto& ciq : forClique.geoms) {
-      if (isNextTo(ic, ciq) || (level > 1 && hasSameOrigin(ic, ciq))) {
-        return i;
-      }
-    }
+void SvgRenderer::renderBackdrop(const RenderGraph& backdrop,
+                                 const util::geo::DBox& box,
+                                 const RenderParams& rparams) {
+  auto clip = util::geo::pad(
+      box, backdrop.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing));
+
+  // the layer is always named, so it can be found in post-processing
+  Params params{{"id", "layer-backdrop"},
+                {"opacity", util::toString(_cfg->backdropOpacity)}};
+  if (_cfg->svgLayers) {
+    params["inkscape:groupmode"] = "layer";
+    params["inkscape:label"] = "Backdrop";
   }
+  _w.openTag("g", params);
 
-  return pool.size();
-}
-
-// _____________________________________________________________________________
-bool SvgRenderer::isNextTo(const InnerGeom& a, const InnerGeom& b) const {
-  double THRESHOLD = 0.5 * M_PI + 0.1;
-
-  if (!a.from.edge) return false;
-  if (!b.from.edge) return false;
-  if (!a.to.edge) return false;
-  if (!b.to.edge) return false;
+  printDelegates(&_backdropDelegates, rparams);
 
-  auto nd = RenderGraph::sharedNode(a.from.edge, a.to.edge);
-
-  assert(a.from.edge);
-  assert(b.from.edge);
-  assert(a.to.edge);
-  assert(b.to.edge);
-
-  bool aFromInv = a.from.edge->getTo() == nd;
-  bool bFromInv = b.from.edge->getTo() == nd;
-  bool aToInv = a.to.edge->getTo() == nd;
-  bool bToInv = b.to.edge->getTo() == nd;
-
-  int aSlotFrom = !aFromInv
-                      ? a.slotFrom
-                      : (a.from.edge->pl().getLines().size() - 1 - a.slotFrom);
-  int aSlotTo =
-      !aToInv ? a.slotTo : (a.to.edge->pl().getLines().size() - 1 - a.slotTo);
-  int bSlotFrom = !bFromInv
-                      ? b.slotFrom
-                      : (b.from.edge->pl().getLines().size() - 1 - b.slotFrom);
-  int bSlotTo =
-      !bToInv ? b.slotTo : (b.to.edge->pl().getLines().size() - 1 - b.slotTo);
-
-  if (a.from.edge == b.from.edge && a.to.edge == b.to.edge) {
-    if ((aSlotFrom - bSlotFrom == 1 && bSlotTo - aSlotTo == 1) ||
-        (bSlotFrom - aSlotFrom == 1 && aSlotTo - bSlotTo == 1)) {
-      return true;
-      double ang1 = fabs(util::geo::angBetween(a.geom.front(), a.geom.back()));
-      double ang2 = fabs(util::geo::angBetween(b.geom.front(), b.geom.back()));
-
-      return ang1 > THRESHOLD && ang2 > THRESHOLD;
+  if (_cfg->renderNodeConnections) {
+    for (auto n : backdrop.getNds()) {
+      if (!util::geo::contains(*n->pl().getGeom(), clip)) continue;
+      renderNodeConnections(backdrop, n, rparams);
+      renderInnerDelegates(rparams);
     }
   }
 
-  if (a.to.edge == b.from.edge && a.from.edge == b.to.edge) {
-    if ((aSlotFrom - bSlotTo == 1 && bSlotFrom - aSlotTo == 1) ||
-        (bSlotTo - aSlotFrom == 1 && aSlotTo - bSlotFrom == 1)) {
-      return true;
-      double ang1 = fabs(util::geo::angBetween(a.geom.front(), a.geom.back()));
-      double ang2 = fabs(util::geo::angBetween(b.geom.front(), b.geom.back()));
-
-      return ang1 > THRESHOLD && ang2 > THRESHOLD;
+  if (_cfg->renderStations) {
+    Params st{{"stroke", "black"},
+              {"stroke-width", util::toString((_cfg->lineWidth / 2) *
+                                              _cfg->outputResolution)},
+              {"fill", "white"}};
+    for (auto n : backdrop.getNds()) {
+      if (n->pl().stops().size() == 0 || n->pl().fronts().size() == 0) continue;
+      if (!util::geo::contains(*n->pl().getGeom(), clip)) continue;
+      for (const auto& geom :
+           backdrop.getStopGeoms(n, _cfg->tightStations, 32)) {
+        printPolygon(geom, st, rparams);
+      }
     }
   }
 
-  return false;
+  _w.closeTag();
 }
 
 // _____________________________________________________________________________
-bool SvgRenderer::hasSameOrigin(const InnerGeom& a, const InnerGeom& b) const {
-  if (a.from.edge == b.from.edge) {
-    return a.slotFrom == b.slotFrom;
-  }
-  if (a.to.edge == b.from.edge) {
-    return a.slotTo == b.slotFrom;
-  }
-  if (a.to.edge == b.to.edge) {
-    return a.slotTo == b.slotTo;
-  }
-  if (a.from.edge == b.to.edge) {
-    return a.slotFrom == b.slotTo;
-  }
+void SvgRenderer::renderNodeConnections(const RenderGraph& outG,
+                                        const LineNode* n,
+                                        const RenderParams& rparams) {
+  UNUSED(rparams);
+  // don't sample inner geometries finer than a single output unit
+  double prec = _cfg->innerGeometryPrecision;
+  if (prec > 0) prec = std::max(prec, 1.0 / _cfg->outputResolution);
 
-  return false;
+  auto geoms = outG.innerGeoms(n, prec);
+
+  for (auto& clique : getInnerCliques(n, geoms, 9999)) renderClique(clique, n);
 }
 
 // _____________________________________________________________________________
 void SvgRenderer::renderClique(const InnerClique& cc, const LineNode* n) {
   _innerDelegates.push_back(
       std::map<uintptr_t, std::vector<OutlinePrintPair>>());
-  std::multiset<InnerClique> renderCliques = getInnerCliques(n, cc.geoms, 0);
-  for (const auto& c : renderCliques) {
-    // the longest geom will be the ref geom
-    InnerGeom ref = c.geoms[0];
-    for (size_t i = 1; i < c.geoms.size(); i++) {
-      if (c.geoms[i].geom.getLength() > ref.geom.getLength()) ref = c.geoms[i];
-    }
+  for (const auto& ig : getCliqueGeoms(cc, n, _cfg->lineWidth,
+                                       _cfg->outlineWidth,
+                                       _cfg->lineSpacing)) {
+    PolyLine<double> pl = ig.geom;
 
-    for (size_t i = 0; i < c.geoms.size(); i++) {
-      PolyLine<double> pl = c.geoms[i].geom;
+    Params paramsOutlineCropped;
+    paramsOutlineCropped["class"] += " inner-geom-outline";
+    paramsOutlineCropped["class"] += " " + getLineClass(ig.from.line->id());
 
-      if (ref.geom.getLength() >
-          (_cfg->lineWidth + 2 * _cfg->outlineWidth + _cfg->lineSpacing) * 4) {
-        double off =
-            -(_cfg->lineWidth + _cfg->lineSpacing + 2 * _cfg->outlineWidth) *
-            (static_cast<int>(c.geoms[i].slotFrom) -
-             static_cast<int>(ref.slotFrom));
-
-        if (ref.from.edge->getTo() == n) off = -off;
-
-        pl = ref.geom.offsetted(off);
-
-        if (pl.getLength() / c.geoms[i].geom.getLength() > 1.5)
-          pl = c.geoms[i].geom;
-
-        std::set<LinePoint<double>, LinePointCmp<double>> a;
-        std::set<LinePoint<double>, LinePointCmp<double>> b;
-
-        if (ref.from.edge)
-          a = n->pl().frontFor(ref.from.edge)->geom.getIntersections(pl);
-        if (ref.to.edge)
-          b = n->pl().frontFor(ref.to.edge)->geom.getIntersections(pl);
-
-        if (a.size() > 0 && b.size() > 0) {
-          pl = pl.getSegment(a.begin()->totalPos, b.begin()->totalPos);
-        } else if (a.size() > 0) {
-          pl = pl.getSegment(a.begin()->totalPos, 1);
-        } else if (b.size() > 0) {
-          pl = pl.getSegment(0, b.begin()->totalPos);
-        }
-      }
+    Params params;
+    params["class"] += " inner-geom ";
+    params["class"] += " " + getLineClass(ig.from.line->id());
 
+    // in compact output, widths and colors are given by the style block
+    if (!_cfg->svgCompact) {
       std::stringstream styleOutlineCropped;
       styleOutlineCropped << "fill:none;stroke:#000000";
 
       styleOutlineCropped << ";stroke-linecap:butt;stroke-width:"
                           << (_cfg->lineWidth + _cfg->outlineWidth) *
                                  _cfg->outputResolution;
-      Params paramsOutlineCropped;
       paramsOutlineCropped["style"] = styleOutlineCropped.str();
-      paramsOutlineCropped["class"] += " inner-geom-outline";
-      paramsOutlineCropped["class"] +=
-          " " + getLineClass(c.geoms[i].from.line->id());
 
       std::stringstream styleStr;
-      styleStr << "fill:none;stroke:#" << c.geoms[i].from.line->color();
+      styleStr << "fill:none;stroke:#" << ig.from.line->color();
 
       styleStr << ";stroke-linecap:round;stroke-opacity:1;stroke-width:"
                << _cfg->lineWidth * _cfg->outputResolution;
-      Params params;
       params["style"] = styleStr.str();
-      params["class"] += " inner-geom ";
-      params["class"] += " " + getLineClass(c.geoms[i].from.line->id());
-
-      _innerDelegates.back()[(uintptr_t)c.geoms[i].from.line].push_back(
-          OutlinePrintPair(PrintDelegate(params, pl),
-                           PrintDelegate(paramsOutlineCropped, pl)));
     }
+
+    pl.simplify(0.5 / _cfg->outputResolution);
+
+    _innerDelegates.back()[(uintptr_t)ig.from.line].push_back(
+        OutlinePrintPair(PrintDelegate(params, pl),
+                         PrintDelegate(paramsOutlineCropped, pl)));
   }
 }
 
@@ -458,13 +537,36 @@ void SvgRenderer::renderLinePart(const PolyLine<double> p, double width,
                                  const Line& line, const std::string& css,
                                  const std::string& oCss,
                                  const std::string& endMarker) {
+  // vertices deviating less than half an output pixel are not visible
+  PolyLine<double> pl = p;
+  pl.simplify(0.5 / _cfg->outputResolution);
+
+  Params paramsOutline;
+  paramsOutline["class"] = "transit-edge-outline " + getLineClass(line.id());
+  Params params;
+  params["class"] = "transit-edge " + getLineClass(line.id());
+
+  if (_cfg->svgCompact) {
+    // widths and colors are given by the style block
+    if (!oCss.empty()) paramsOutline["style"] = oCss;
+
+    std::string style = css;
+    if (!endMarker.empty()) {
+      if (!style.empty()) style += ";";
+      style += "marker-end:url(#" + endMarker + ")";
+    }
+    if (!style.empty()) params["style"] = style;
+
+    _spool->push(OutlinePrintPair(PrintDelegate(params, pl),
+                                     PrintDelegate(paramsOutline, pl)));
+    return;
+  }
+
   std::stringstream styleOutline;
   styleOutline << "fill:none;stroke:#000000;stroke-linecap:round;stroke-width:"
                << (width + _cfg->outlineWidth) * _cfg->outputResolution << ";"
                << oCss;
-  Params paramsOutline;
   paramsOutline["style"] = styleOutline.str();
-  paramsOutline["class"] = "transit-edge-outline " + getLineClass(line.id());
 
   std::stringstream styleStr;
   styleStr << "fill:none;stroke:#" << line.color() << ";" << css;
@@ -475,13 +577,10 @@ void SvgRenderer::renderLinePart(const PolyLine<double> p, double width,
 
   styleStr << ";stroke-linecap:round;stroke-opacity:1;stroke-width:"
            << width * _cfg->outputResolution;
-  Params params;
   params["style"] = styleStr.str();
-  params["class"] = "transit-edge " + getLineClass(line.id());
 
-  _delegates[0].insert(_delegates[0].begin(),
-                       OutlinePrintPair(PrintDelegate(params, p),
-                                        PrintDelegate(paramsOutline, p)));
+  _spool->push(OutlinePrintPair(PrintDelegate(params, pl),
+                                   PrintDelegate(paramsOutline, pl)));
 }
 
 // _____________________________________________________________________________
@@ -489,47 +588,17 @@ void SvgRenderer::renderEdgeTripGeom(const RenderGraph& outG,
                                      const shared::linegraph::LineEdge* e,
                                      const RenderParams& rparams) {
   UNUSED(rparams);
-  const shared::linegraph::NodeFront* nfTo = e->getTo()->pl().frontFor(e);
-  const shared::linegraph::NodeFront* nfFrom = e->getFrom()->pl().frontFor(e);
-
-  assert(nfTo);
-  assert(nfFrom);
-
   PolyLine<double> center(*e->pl().getGeom());
 
   double lineW = _cfg->lineWidth;
-  double outlineW = _cfg->outlineWidth;
-  double lineSpc = _cfg->lineSpacing;
-  double offsetStep = lineW + 2.0 * outlineW + lineSpc;
-  double oo = outG.getTotalWidth(e);
 
-  double o = oo;
-
-  for (size_t i = 0; i < e->pl().getLines().size(); i++) {
+  for (auto& part : getEdgeLineParts(outG, e, lineW, _cfg->outlineWidth,
+                                     _cfg->lineSpacing)) {
+    size_t i = part.pos;
     const auto& lo = e->pl().lineOccAtPos(i);
 
     const Line* line = lo.line;
-    PolyLine<double> p = center;
-
-    if (p.getLength() < 0.01) continue;
-
-    double offset = -(o - oo / 2.0 - (2.0 * outlineW + _cfg->lineWidth) / 2.0);
-
-    p.offsetPerp(offset);
-
-    auto iSects = nfTo->geom.getIntersections(p);
-    if (iSects.size() > 0) {
-      p = p.getSegment(0, iSects.begin()->totalPos);
-    } else {
-      p << nfTo->geom.projectOn(p.back()).p;
-    }
-
-    auto iSects2 = nfFrom->geom.getIntersections(p);
-    if (iSects2.size() > 0) {
-      p = p.getSegment(iSects2.begin()->totalPos, 1);
-    } else {
-      p >> nfFrom->geom.projectOn(p.front()).p;
-    }
+    PolyLine<double>& p = part.geom;
 
     double arrowLength = (_cfg->lineWidth * 2.5);
 
@@ -545,11 +614,14 @@ void SvgRenderer::renderEdgeTripGeom(const RenderGraph& outG,
       std::stringstream markerName;
       markerName << e << ":" << line << ":" << i;
 
+      // all markers look the same, compact output only defines one
+      if (_cfg->svgCompact) markerName.str("dir");
+
       std::string markerPathMale = getMarkerPathMale(lineW);
       EndMarker emm(markerName.str() + "_m", "white", markerPathMale, lineW,
                     lineW);
 
-      _markers.push_back(emm);
+      if (!_cfg->svgCompact || _markers.empty()) _markers.push_back(emm);
 
       PolyLine<double> firstPart = p.getSegmentAtDist(0, p.getLength() / 2);
       PolyLine<double> secondPart =
@@ -567,8 +639,6 @@ void SvgRenderer::renderEdgeTripGeom(const RenderGraph& outG,
     } else {
       renderLinePart(p, lineW, *line, css, oCss);
     }
-
-    o -= offsetStep;
   }
 }
 
@@ -582,17 +652,27 @@ std::string SvgRenderer::getMarkerPathMale(double w) const {
 void SvgRenderer::renderDelegates(const RenderGraph& outG,
                                   const RenderParams& rparams) {
   UNUSED(outG);
-  for (auto& a : _delegates) {
-    _w.openTag("g");
-    for (auto& pd : a.second) {
-      if (_cfg->outlineWidth > 0) {
-        printLine(pd.back.second, pd.back.first, rparams);
-      }
-      printLine(pd.front.second, pd.front.first, rparams);
+  if (_delegates.size() == 0) return;
+
+  openLayer("edges", "Edges");
+  printDelegates(&_delegates, rparams);
+  _w.closeTag();
+}
+
+// _____________________________________________________________________________
+void SvgRenderer::printDelegates(DelegateSpool* spool,
+                                 const RenderParams& rparams) {
+  // line parts were rendered in reverse drawing order
+  spool->forEachReversed([&](const OutlinePrintPair& pd) {
+    if (_cfg->outlineWidth > 0) {
+      printLine(pd.back.second, pd.back.first, rparams);
     }
-    _w.closeTag();
-  }
+    printLine(pd.front.second, pd.front.first, rparams);
+  });
+}
 
+// _____________________________________________________________________________
+void SvgRenderer::renderInnerDelegates(const RenderParams& rparams) {
   for (auto& a : _innerDelegates) {
     _w.openTag("g");
     for (auto& b : a) {
@@ -607,6 +687,8 @@ void SvgRenderer::renderDelegates(const RenderGraph& outG,
     }
     _w.closeTag();
   }
+
+  _innerDelegates.clear();
 }
 
 // _____________________________________________________________________________
@@ -636,6 +718,16 @@ void SvgRenderer::printLine(const PolyLine<double>& l,
                             const std::map<std::string, std::string>& ps,
                             const RenderParams& rparams) {
   std::map<std::string, std::string> params = ps;
+
+  if (_cfg->svgCompact) {
+    int64_t x, y;
+    auto rel = getRelPath(l.getLine(), false, &x, &y, rparams);
+    params["d"] = "M" + fmtTenths(x) + "," + fmtTenths(y) + rel;
+    _w.openTag("path", params);
+    _w.closeTag();
+    return;
+  }
+
   std::stringstream points;
 
   for (auto& p : l.getLine()) {
@@ -712,7 +804,15 @@ size_t InnerClique::getNumBranchesIn(
 // _____________________________________________________________________________
 void SvgRenderer::renderStationLabels(const Labeller& labeller,
                                       const RenderParams& rparams) {
-  _w.openTag("g");
+  openLayer("station-labels", "Station Labels");
+
+  // labels carry their tier if tiers were assigned, also when restyling a
+  // display list
+  bool tiered = !_cfg->focusStations.empty();
+  for (const auto& label : labeller.getStationLabels()) {
+    if (label.tier != 1) tiered = true;
+  }
+
   size_t id = 0;
   for (auto label : labeller.getStationLabels()) {
     std::string shift = "0em";
@@ -758,10 +858,12 @@ void SvgRenderer::renderStationLabels(const Labeller& labeller,
     std::map<std::string, std::string> params;
     params["class"] = "station-label";
     params["font-weight"] = label.bold ? "bold" : "normal";
-    params["font-family"] = "Ubuntu Condensed";
+    params["font-family"] = _cfg->stationLabelFont;
     params["dy"] = shift;
-    params["font-size"] =
-        util::toString(label.fontSize * _cfg->outputResolution);
+    params["font-size"] = util::toString(
+        label.fontSize * _cfg->labelTextScale * _cfg->outputResolution);
+    if (!_cfg->svgLang.empty()) params["xml:lang"] = _cfg->svgLang;
+    if (tiered) params["data-tier"] = util::toString(label.tier);
 
     _w.openTag("text", params);
     _w.openTag("textPath", {{"dy", shift},
@@ -779,7 +881,7 @@ void SvgRenderer::renderStationLabels(const Labeller& labeller,
 // _____________________________________________________________________________
 void SvgRenderer::renderLineLabels(const Labeller& labeller,
                                    const RenderParams& rparams) {
-  _w.openTag("g");
+  openLayer("line-labels", "Line Labels");
   size_t id = 0;
   for (auto label : labeller.getLineLabels()) {
     std::string shift = "0em";
@@ -821,10 +923,10 @@ void SvgRenderer::renderLineLabels(const Labeller& labeller,
     std::map<std::string, std::string> params;
     params["class"] = "line-label";
     params["font-weight"] = "bold";
-    params["font-family"] = "Ubuntu";
+    params["font-family"] = _cfg->lineLabelFont;
     params["dy"] = shift;
-    params["font-size"] =
-        util::toString(label.fontSize * _cfg->outputResolution);
+    params["font-size"] = util::toString(
+        label.fontSize * _cfg->labelTextScale * _cfg->outputResolution);
 
     _w.openTag("text", params);
     _w.openTag("textPath", {{"dy", shift},
@@ -836,7 +938,8 @@ void SvgRenderer::renderLineLabels(const Labeller& labeller,
     for (auto line : label.lines) {
       _w.openTag("tspan",
                  {{"fill", "#" + line->color()}, {"dx", util::toString(dy)}});
-      dy = (label.fontSize * _cfg->outputResolution) / 3;
+      dy = (label.fontSize * _cfg->labelTextScale * _cfg->outputResolution) /
+           3;
       _w.writeText(line->label());
       _w.closeTag();
     }
@@ -864,6 +967,18 @@ double InnerClique::getZWeight() const {
   return ret;
 }
 
+// _____________________________________________________________________________
+void SvgRenderer::openLayer(const std::string& id, const std::string& label) {
+  if (!_cfg->svgLayers) {
+    _w.openTag("g");
+    return;
+  }
+
+  _w.openTag("g", {{"id", "layer-" + id},
+                   {"inkscape:groupmode", "layer"},
+                   {"inkscape:label", label}});
+}
+
 // _____________________________________________________________________________
 std::string SvgRenderer::getLineClass(const std::string& id) const {
   auto i = lineClassIds.find(id);
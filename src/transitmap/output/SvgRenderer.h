@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 #include "Renderer.h"
+#include "transitmap/output/DelegateSpool.h"
 #include "shared/linegraph/Line.h"
 #include "shared/rendergraph/RenderGraph.h"
 #include "transitmap/config/TransitMapConfig.h"
@@ -40,6 +41,17 @@ class SvgRenderer : public Renderer {
 
   virtual void print(const shared::rendergraph::RenderGraph& outputGraph);
 
+  // render with already placed labels, they are only written if renderLabels
+  // is set
+  void print(const shared::rendergraph::RenderGraph& outputGraph,
+             const label::Labeller& labeller);
+
+  // as above, with the parts of the backdrop graph within the viewport of
+  // outputGraph drawn under it, if backdrop is not 0
+  void print(const shared::rendergraph::RenderGraph& outputGraph,
+             const label::Labeller& labeller,
+             const shared::rendergraph::RenderGraph* backdrop);
+
   void printLine(const util::geo::PolyLine<double>& l,
                  const std::map<std::string, std::string>& ps,
                  const RenderParams& params);
@@ -62,7 +74,12 @@ class SvgRenderer : public Renderer {
 
   const config::Config* _cfg;
 
-  std::map<uintptr_t, std::vector<OutlinePrintPair>> _delegates;
+  DelegateSpool _delegates;
+  DelegateSpool _backdropDelegates;
+
+  // the spool line parts are currently rendered to
+  DelegateSpool* _spool;
+
   std::vector<std::map<uintptr_t, std::vector<OutlinePrintPair>>>
       _innerDelegates;
   std::vector<EndMarker> _markers;
@@ -74,6 +91,32 @@ class SvgRenderer : public Renderer {
   void outputEdges(const shared::rendergraph::RenderGraph& outputGraph,
                    const RenderParams& params);
 
+  // render the backdrop edges intersecting box to the backdrop spool
+  void outputBackdropEdges(const shared::rendergraph::RenderGraph& backdrop,
+                           const util::geo::DBox& box,
+                           const RenderParams& params);
+
+  // write the backdrop edges, and the node connections and stations within
+  // box, to a translucent layer
+  void renderBackdrop(const shared::rendergraph::RenderGraph& backdrop,
+                      const util::geo::DBox& box, const RenderParams& params);
+
+  // stations for compact output, repeated shapes are written as symbols
+  void outputNodesCompact(const shared::rendergraph::RenderGraph& outputGraph,
+                          const RenderParams& params);
+
+  // CSS for compact output: widths of all classes and colors per line
+  std::string getStyleBlock(
+      const shared::rendergraph::RenderGraph& outputGraph,
+      const shared::rendergraph::RenderGraph* backdrop) const;
+
+  // relative path commands after the first point, which is returned in
+  // (x0, y0), in tenths of output pixels
+  std::string getRelPath(const util::geo::DLine& l, bool close, int64_t* x0,
+                         int64_t* y0, const RenderParams& params) const;
+
+  static std::string fmtTenths(int64_t v);
+
   void renderEdgeTripGeom(const shared::rendergraph::RenderGraph& outG,
                           const shared::linegraph::LineEdge* e,
                           const RenderParams& params);
@@ -96,6 +139,11 @@ class SvgRenderer : public Renderer {
   void renderDelegates(const shared::rendergraph::RenderGraph& outG,
                        const RenderParams& params);
 
+  // print the pairs of spool in drawing order
+  void printDelegates(DelegateSpool* spool, const RenderParams& params);
+
+  void renderInnerDelegates(const RenderParams& params);
+
   void renderNodeFronts(const shared::rendergraph::RenderGraph& outG,
                         const RenderParams& params);
 
@@ -105,24 +153,14 @@ class SvgRenderer : public Renderer {
   void renderStationLabels(const label::Labeller& lbler,
                            const RenderParams& params);
 
-  std::multiset<InnerClique> getInnerCliques(
-      const shared::linegraph::LineNode* n,
-      std::vector<shared::rendergraph::InnerGeom> geoms, size_t level) const;
-
   void renderClique(const InnerClique& c,
                     const shared::linegraph::LineNode* node);
 
-  bool isNextTo(const shared::rendergraph::InnerGeom& a,
-                const shared::rendergraph::InnerGeom& b) const;
-  bool hasSameOrigin(const shared::rendergraph::InnerGeom& a,
-                     const shared::rendergraph::InnerGeom& b) const;
-
-  size_t getNextPartner(const InnerClique& forGeom,
-                        const std::vector<shared::rendergraph::InnerGeom>& pool,
-                        size_t level) const;
-
   std::string getLineClass(const std::string& id) const;
 
+  // open a group, a named Inkscape layer if svgLayers is set
+  void openLayer(const std::string& id, const std::string& label);
+
   std::string getMarkerPathMale(double w) const;
   std::string getMarkerPathFemale(double w) const;
 };
@@ -102,6 +102,7 @@ def add_svg_layers(
     reorganizes them into named layers that designers can toggle in Inkscape/Illustrator.
 
     Layers created:
+      - "HF Corridor Backdrop" — kept as is, if transitmap drew a backdrop
       - "Route Outlines" — black outline strokes behind routes
       - "Routes" — colored transit line polylines
       - "Node Connections" — junction inner geometry (outlines + colored)
@@ -109,7 +110,8 @@ def add_svg_layers(
       - "Line Labels" — route number labels along curves
       - "Station Labels (All)" — all station name labels (if no tier_data)
 
-    With tier_data (dict mapping station_name → tier int):
+    With tier_data (dict mapping station_name → tier int), or if transitmap
+    marked the labels with their tier (``data-tier``, which takes precedence):
       - "Station Labels - Tier 1 (Nearby)" — closest stops, always visible
       - "Station Labels - Tier 2 (Important)" — mid-distance important stops
       - "Station Labels - Tier 3 (Junctions)" — distant major junctions
@@ -127,6 +129,8 @@ def add_svg_layers(
     tree = ET.parse(str(input_svg))
     root = tree.getroot()
 
+    native_tiers = any(el.get("data-tier") for el in root.iter())
+
     # Collect all defs from anywhere in the tree
     all_defs = ET.Element(f"{{{SVG_NS}}}defs")
     for defs_elem in root.iter(f"{{{SVG_NS}}}defs"):
@@ -145,7 +149,7 @@ def add_svg_layers(
     layer_line_labels = _make_layer("layer-line-labels", "Line Labels")
 
     # Station label layers depend on tier_data
-    if tier_data:
+    if tier_data or native_tiers:
         label_layers = {
             1: _make_layer("layer-station-labels-tier1", "Station Labels - Tier 1 (Nearby)"),
             2: _make_layer("layer-station-labels-tier2", "Station Labels - Tier 2 (Important)"),
@@ -163,7 +167,16 @@ def add_svg_layers(
     ns_g = f"{{{SVG_NS}}}g"
     top_groups = [child for child in root if child.tag in (ns_g, "g")]
 
+    # a backdrop composited by transitmap (--backdrop) is kept as it is
+    backdrop_layer = None
+
     for group in top_groups:
+        if group.get("id") == "layer-backdrop":
+            backdrop_layer = group
+            backdrop_layer.set(f"{{{INKSCAPE_NS}}}label", "HF Corridor Backdrop")
+            backdrop_layer.set(f"{{{INKSCAPE_NS}}}groupmode", "layer")
+            continue
+
         role = _classify_group(group)
 
         if role in ("route-outline", "route"):
@@ -204,7 +217,11 @@ def add_svg_layers(
                     pending_defs.extend(list(child))
                 elif tag == "text":
                     name = _extract_station_name(child)
-                    if tier_data:
+                    if child.get("data-tier"):
+                        target = label_layers.get(
+                            int(child.get("data-tier")), label_layers[4]
+                        )
+                    elif tier_data:
                         tier = _get_tier_for_name(
                             name, tier_data, default_tier=default_unmatched_station_tier
                         )
@@ -225,6 +242,8 @@ def add_svg_layers(
     root.append(all_defs)
 
     # Add layers in rendering order (back to front)
+    if backdrop_layer is not None:
+        root.append(backdrop_layer)
     root.append(layer_route_outlines)
     root.append(layer_routes)
     root.append(layer_conn)
@@ -0,0 +1,27 @@
+"""Per-job thread budgets of the batch drivers."""
+
+from thread_budget import job_threads, stage_threads, thread_env, threads_flag
+
+
+def test_job_threads_splits_cores():
+    assert job_threads(4, 16) == 4
+    assert job_threads(3, 8) == 2
+    assert job_threads(16, 4) == 1
+    assert job_threads(1, 0) >= 1
+
+
+def test_thread_env_round_trip(monkeypatch):
+    env = thread_env(3, {"PATH": "/bin"})
+    assert env["PATH"] == "/bin"
+    assert env["OMP_NUM_THREADS"] == "3"
+    monkeypatch.setenv("MAGGA_THREADS", env["MAGGA_THREADS"])
+    assert stage_threads() == 3
+    assert threads_flag(stage_threads()) == "-t 3"
+
+
+def test_no_budget(monkeypatch):
+    monkeypatch.delenv("MAGGA_THREADS", raising=False)
+    assert stage_threads() == 0
+    assert threads_flag(0) == ""
+    monkeypatch.setenv("MAGGA_THREADS", "x")
+    assert stage_threads() == 0
@@ -0,0 +1,80 @@
+"""Shared-directory job queue of the distributed batch runs."""
+
+import os
+import time
+
+import work_queue as wq
+
+
+def test_claim_complete(tmp_path):
+    wq.submit(tmp_path, [("a", {"n": 1}), ("b", {"n": 2})])
+    assert wq.status(tmp_path)["pending"] == 2
+
+    lease, job = wq.claim(tmp_path, "w1")
+    assert job["id"] == "a" and job["payload"] == {"n": 1}
+    assert wq.status(tmp_path)["running"] == 1
+
+    assert wq.complete(tmp_path, lease, job, True, {"seconds": 1}) == "done"
+    assert not lease.exists()
+    assert wq.status(tmp_path) == {"pending": 1, "running": 0, "done": 1,
+                                   "failed": 0}
+
+
+def test_retry_then_fail(tmp_path):
+    wq.submit(tmp_path, [("a", {})], max_attempts=2)
+
+    lease, job = wq.claim(tmp_path, "w1")
+    assert wq.complete(tmp_path, lease, job, False) == "pending"
+
+    lease, job = wq.claim(tmp_path, "w2")
+    assert job["attempts"] == 1
+    assert wq.complete(tmp_path, lease, job, False, {"error": "x"}) == "failed"
+    assert wq.claim(tmp_path, "w3") is None
+    assert wq.status(tmp_path)["failed"] == 1
+
+
+def test_expired_lease_is_requeued(tmp_path):
+    wq.submit(tmp_path, [("a", {})])
+    lease, _ = wq.claim(tmp_path, "w1")
+
+    assert wq.requeue_expired(tmp_path, lease_sec=60) == []
+    old = time.time() - 120
+    os.utime(lease, (old, old))
+    assert wq.requeue_expired(tmp_path, lease_sec=60) == ["a"]
+    assert not wq.renew(lease)
+
+    _, job = wq.claim(tmp_path, "w2")
+    assert job["attempts"] == 1
+
+
+def test_first_result_wins(tmp_path):
+    wq.submit(tmp_path, [("a", {})])
+    lease1, job = wq.claim(tmp_path, "w1")
+
+    # a re-dispatched copy of the straggler
+    assert wq._dispatch_copy(tmp_path, job)
+    lease2, copy = wq.claim(tmp_path, "w2")
+
+    # the failing copy leaves the job to the still running original
+    assert wq.complete(tmp_path, lease2, copy, False) == "running"
+    assert wq.complete(tmp_path, lease1, job, True) == "done"
+    assert wq.status(tmp_path)["pending"] == 0
+
+
+def test_worker_and_wait(tmp_path):
+    ids = wq.submit(tmp_path, [(str(i), {"n": i}) for i in range(4)])
+
+    def handler(payload):
+        if payload["n"] == 3:
+            raise RuntimeError("boom")
+        return True, {"twice": payload["n"] * 2}
+
+    n = wq.run_worker(tmp_path, handler, idle_sec=0.01, poll_sec=0.01)
+    assert n == 4 + 2  # the failing job is run MAX_ATTEMPTS times
+
+    seen = []
+    res = wq.wait(tmp_path, ids, on_result=lambda i, r: seen.append(i),
+                  poll_sec=0.01)
+    assert sorted(seen) == ids
+    assert res["1"]["ok"] and res["1"]["twice"] == 2
+    assert not res["3"]["ok"] and res["3"]["error"] == "boom"
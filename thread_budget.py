@@ -0,0 +1,64 @@
+"""
+CPU budget for the batch drivers.
+
+Every C++ tool takes ``-t N`` as its thread budget: it caps the tool's own
+parallel loops, the OpenMP loops without an explicit thread count and the
+ILP solver threads. A batch running J jobs at once hands each job
+``cores // J`` threads, so the jobs together stay within the core budget
+instead of each using every core.
+
+The per-job budget is passed to child processes in ``MAGGA_THREADS`` (and
+``OMP_NUM_THREADS`` for anything else using OpenMP), pipelines read it with
+:func:`stage_threads`.
+
+Part of the Magga (ಮಗ್ಗ/मग्ग) project: https://github.com/pvnkmrksk/magga
+License: GPL-3.0 — see LICENSE file.
+"""
+
+from __future__ import annotations
+
+import os
+from typing import Mapping, Optional
+
+ENV_VAR = "MAGGA_THREADS"
+
+
+def available_cores() -> int:
+    """Cores this process may run on."""
+    try:
+        return max(1, len(os.sched_getaffinity(0)))
+    except AttributeError:
+        return max(1, os.cpu_count() or 1)
+
+
+def job_threads(jobs: int, cores: Optional[int] = None) -> int:
+    """Threads for each of ``jobs`` concurrent jobs sharing ``cores`` cores.
+
+    ``cores`` defaults to :func:`available_cores`. Every job gets at least
+    one thread.
+    """
+    if not cores or cores < 1:
+        cores = available_cores()
+    return max(1, cores // max(1, jobs))
+
+
+def thread_env(threads: int, env: Optional[Mapping[str, str]] = None) -> dict:
+    """A copy of ``env`` (default: ``os.environ``) handing ``threads`` to
+    child pipelines."""
+    ret = dict(os.environ if env is None else env)
+    ret[ENV_VAR] = str(threads)
+    ret["OMP_NUM_THREADS"] = str(threads)
+    return ret
+
+
+def stage_threads() -> int:
+    """The thread budget handed down by a batch scheduler, 0 if none."""
+    try:
+        return max(0, int(os.environ.get(ENV_VAR, "0")))
+    except ValueError:
+        return 0
+
+
+def threads_flag(threads: int) -> str:
+    """The ``-t`` flag for a C++ tool, empty without a budget."""
+    return f"-t {threads}" if threads > 0 else ""
@@ -0,0 +1,306 @@
+"""
+Shared-directory job queue for distributing batch runs over several machines.
+
+A coordinator (``generate_all_stops.py --queue DIR``) writes its jobs into a
+queue directory on storage all nodes mount (NFS, SMB, ...), workers on any
+number of nodes (``generate_all_stops.py --queue-worker DIR``) claim and run
+them. There is no server: every state change is a ``rename`` inside the
+queue, which is atomic on a shared POSIX file system::
+
+    DIR/pending/<id>.json            waiting to be claimed
+    DIR/running/<id>@<token>.json    claimed by the worker <token>, the file
+                                     mtime is the lease heartbeat
+    DIR/done/<id>.json               result of the first finished run
+    DIR/failed/<id>.json             out of attempts
+
+A worker renews its lease while the job runs. Leases of dead workers expire
+after ``lease_sec`` and their jobs go back to ``pending``, failed jobs are
+retried until they run out of attempts. Once nothing is left to claim, the
+coordinator re-dispatches stragglers - jobs running much longer than the
+typical job - to a second worker, the first result wins. Jobs have to be
+idempotent for this, which the map jobs are (same inputs, same outputs).
+
+Part of the Magga (ಮಗ್ಗ/मग्ग) project: https://github.com/pvnkmrksk/magga
+License: GPL-3.0 — see LICENSE file.
+"""
+
+from __future__ import annotations
+
+import json
+import os
+import socket
+import statistics
+import threading
+import time
+import uuid
+from pathlib import Path
+from typing import Callable, Dict, Iterable, List, Optional, Tuple
+
+PENDING = "pending"
+RUNNING = "running"
+DONE = "done"
+FAILED = "failed"
+
+LEASE_SEC = 120.0
+POLL_SEC = 2.0
+MAX_ATTEMPTS = 3
+
+# a running job is a straggler once it runs this many times longer than the
+# median finished job, judged after MIN_SAMPLES jobs finished
+STRAGGLER_FACTOR = 3.0
+MIN_SAMPLES = 5
+
+
+def worker_token() -> str:
+    """A token unique to this process, across nodes."""
+    return f"{socket.gethostname()}-{os.getpid()}-{uuid.uuid4().hex[:8]}"
+
+
+def _dir(queue: Path, state: str) -> Path:
+    d = Path(queue) / state
+    d.mkdir(parents=True, exist_ok=True)
+    return d
+
+
+def _write_json(path: Path, data: dict) -> None:
+    """Write atomically, readers never see partial files."""
+    tmp = path.with_name(f".{path.name}.{worker_token()}.tmp")
+    tmp.write_text(json.dumps(data), encoding="utf-8")
+    os.replace(tmp, path)
+
+
+def _read_json(path: Path) -> Optional[dict]:
+    try:
+        return json.loads(path.read_text(encoding="utf-8"))
+    except (OSError, ValueError):
+        return None
+
+
+def _job_id(path: Path) -> str:
+    return path.stem.split("@", 1)[0]
+
+
+def _running(queue: Path, job_id: Optional[str] = None) -> List[Path]:
+    pat = f"{job_id}@*.json" if job_id else "[!.]*@*.json"
+    return sorted(_dir(queue, RUNNING).glob(pat))
+
+
+def submit(queue: Path, jobs: Iterable[Tuple[str, dict]], *,
+           max_attempts: int = MAX_ATTEMPTS) -> List[str]:
+    """Queue ``(id, payload)`` jobs, results of earlier runs with the same ids
+    are dropped. Returns the ids."""
+    ids = []
+    for job_id, payload in jobs:
+        for state in (DONE, FAILED):
+            (_dir(queue, state) / f"{job_id}.json").unlink(missing_ok=True)
+        _write_json(_dir(queue, PENDING) / f"{job_id}.json", {
+            "id": job_id,
+            "payload": payload,
+            "attempts": 0,
+            "max_attempts": max(1, max_attempts),
+        })
+        ids.append(job_id)
+    return ids
+
+
+def claim(queue: Path, token: str) -> Optional[Tuple[Path, dict]]:
+    """Claim a pending job for the worker ``token``, None if there is none.
+    Returns the lease file and the job."""
+    for p in sorted(_dir(queue, PENDING).glob("[!.]*.json")):
+        lease = _dir(queue, RUNNING) / f"{p.stem}@{token}.json"
+        try:
+            os.rename(p, lease)
+        except FileNotFoundError:
+            continue  # claimed by another worker
+        job = _read_json(lease)
+        if job is None or (_dir(queue, DONE) / f"{p.stem}.json").exists():
+            # malformed, or a re-dispatched copy of a finished job
+            lease.unlink(missing_ok=True)
+            continue
+        job["claimed_at"] = time.time()
+        _write_json(lease, job)
+        return lease, job
+    return None
+
+
+def renew(lease: Path) -> bool:
+    """Extend a lease, False if it expired and was taken away."""
+    try:
+        os.utime(lease)
+        return True
+    except FileNotFoundError:
+        return False
+
+
+def complete(queue: Path, lease: Path, job: dict, ok: bool,
+             result: Optional[dict] = None) -> str:
+    """Record the outcome of a claimed job. Failed jobs go back to pending
+    while they have attempts left. Returns the new state of the job."""
+    job_id = job["id"]
+    done = _dir(queue, DONE) / f"{job_id}.json"
+    lease.unlink(missing_ok=True)
+
+    if done.exists():
+        return DONE
+    if ok:
+        _write_json(done, {"id": job_id, "ok": True, **(result or {})})
+        return DONE
+    if _running(queue, job_id):
+        # another copy of the job is still running
+        return RUNNING
+
+    job = dict(job, attempts=job.get("attempts", 0) + 1)
+    if job["attempts"] < job.get("max_attempts", MAX_ATTEMPTS):
+        _write_json(_dir(queue, PENDING) / f"{job_id}.json", job)
+        return PENDING
+    _write_json(_dir(queue, FAILED) / f"{job_id}.json",
+                {"id": job_id, "ok": False, **(result or {})})
+    return FAILED
+
+
+def requeue_expired(queue: Path, lease_sec: float = LEASE_SEC) -> List[str]:
+    """Put the jobs of expired leases back into pending, counting an attempt.
+    Returns their ids."""
+    ret = []
+    now = time.time()
+    for lease in _running(queue):
+        try:
+            if now - lease.stat().st_mtime < lease_sec:
+                continue
+            # take the lease over, so only one process requeues it
+            expired = lease.with_name(f".{lease.name}.{worker_token()}")
+            os.rename(lease, expired)
+        except FileNotFoundError:
+            continue
+        job = _read_json(expired)
+        if job is None:
+            expired.unlink(missing_ok=True)
+            continue
+        if complete(queue, expired, job, False,
+                    {"error": "lease expired"}) == PENDING:
+            ret.append(job["id"])
+    return ret
+
+
+def _dispatch_copy(queue: Path, job: Optional[dict]) -> bool:
+    if job is None:
+        return False
+    pending = _dir(queue, PENDING) / f"{job['id']}.json"
+    if pending.exists():
+        return False
+    _write_json(pending, dict(job, copy=True))
+    return True
+
+
+def run_worker(queue: Path, handler: Callable[[dict], Tuple[bool, dict]], *,
+               idle_sec: float = 300.0, lease_sec: float = LEASE_SEC,
+               poll_sec: float = POLL_SEC, token: Optional[str] = None,
+               log: Callable[[str], None] = lambda s: None) -> int:
+    """Claim and run jobs until the queue has been empty for ``idle_sec``
+    seconds (forever if 0). ``handler(payload)`` returns ``(ok, result)``,
+    exceptions count as failures. Returns the number of jobs run."""
+    token = token or worker_token()
+    n = 0
+    idle_since = time.time()
+
+    while True:
+        requeue_expired(queue, lease_sec)
+        claimed = claim(queue, token)
+        if claimed is None:
+            if idle_sec > 0 and time.time() - idle_since > idle_sec:
+                return n
+            time.sleep(poll_sec)
+            continue
+
+        lease, job = claimed
+        stop = threading.Event()
+
+        def beat() -> None:
+            while not stop.wait(lease_sec / 4) and renew(lease):
+                pass
+
+        hb = threading.Thread(target=beat, daemon=True)
+        hb.start()
+
+        start = time.time()
+        try:
+            ok, result = handler(job["payload"])
+        except Exception as e:  # noqa: BLE001 - any job error is a failure
+            ok, result = False, {"error": str(e)}
+        finally:
+            stop.set()
+            hb.join()
+
+        result = dict(result or {}, worker=token,
+                      seconds=round(time.time() - start, 3))
+        state = complete(queue, lease, job, ok, result)
+        log(f"{job['id']}: {state}")
+        n += 1
+        idle_since = time.time()
+
+
+def wait(queue: Path, ids: List[str], *,
+         on_result: Callable[[str, dict], None] = lambda i, r: None,
+         lease_sec: float = LEASE_SEC, poll_sec: float = POLL_SEC,
+         straggler_factor: float = STRAGGLER_FACTOR) -> Dict[str, dict]:
+    """Wait for the results of the jobs ``ids``, calling ``on_result(id,
+    result)`` for each as it arrives. Expired leases are requeued and, once
+    no job is pending, stragglers are dispatched to a second worker (once
+    per job, 0 disables). Returns the results by id."""
+    results: Dict[str, dict] = {}
+    copied = set()
+    left = set(ids)
+
+    while left:
+        for state in (DONE, FAILED):
+            for job_id in sorted(left):
+                r = _read_json(_dir(queue, state) / f"{job_id}.json")
+                if r is None:
+                    continue
+                results[job_id] = r
+                left.discard(job_id)
+                on_result(job_id, r)
+        if not left:
+            break
+
+        requeue_expired(queue, lease_sec)
+
+        times = [r["seconds"] for r in results.values() if "seconds" in r]
+        has_pending = any(
+            (_dir(queue, PENDING) / f"{i}.json").exists() for i in left)
+        if (straggler_factor > 0 and len(times) >= MIN_SAMPLES
+                and not has_pending):
+            limit = straggler_factor * statistics.median(times)
+            now = time.time()
+            for lease in _running(queue):
+                job_id = _job_id(lease)
+                if job_id not in left or job_id in copied:
+                    continue
+                job = _read_json(lease)
+                started = (job or {}).get("claimed_at", now)
+                if now - started > limit and _dispatch_copy(queue, job):
+                    copied.add(job_id)
+
+        time.sleep(poll_sec)
+
+    return results
+
+
+def status(queue: Path) -> Dict[str, int]:
+    """Number of jobs in each state."""
+    return {
+        PENDING: sum(1 for _ in _dir(queue, PENDING).glob("[!.]*.json")),
+        RUNNING: len(_running(queue)),
+        DONE: sum(1 for _ in _dir(queue, DONE).glob("[!.]*.json")),
+        FAILED: sum(1 for _ in _dir(queue, FAILED).glob("[!.]*.json")),
+    }
+
+
+if __name__ == "__main__":
+    import sys
+
+    if len(sys.argv) != 2:
+        print(f"Usage: {sys.argv[0]} QUEUE_DIR  (print the job counts)",
+              file=sys.stderr)
+        sys.exit(1)
+    print("  ".join(f"{k}: {v}" for k, v in status(Path(sys.argv[1])).items()))